@@ -0,0 +1,121 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+/*
+ * kcoro_xdp.h - AF_XDP packet rings as a zero-copy channel backend (Linux)
+ * ------------------------------------------------------------------------
+ * Reference adapter for the zcopy backend vtable (kcoro_zcopy.h). One
+ * kc_xdp_t is an AF_XDP socket bound to a NIC queue, with its UMEM (the
+ * packet buffer area) allocated as a kcoro region. A channel bound to it
+ * with kc_xdp_bind_chan moves packets, not elements:
+ *
+ * - kc_chan_recv_desc returns the next received frame as a kc_zdesc_t whose
+ *   addr points into UMEM, with region_id (the UMEM region's export ID) and
+ *   offset filled in. The frame is the caller's until kc_xdp_release hands it
+ *   back to the fill ring, or until it is sent.
+ * - kc_chan_send_desc posts a frame in UMEM (from kc_xdp_frame_alloc, or a
+ *   received one being forwarded) to the TX ring. The adapter takes it back
+ *   once the completion ring reports it sent.
+ *
+ * Neither direction copies payload or makes a syscall per packet. The kernel
+ * is woken only when its ring says it needs a wakeup (XDP_USE_NEED_WAKEUP):
+ * an empty RX ring waits in kc_await_readable, and TX kicks with sendto.
+ * Copy mode (drivers without AF_XDP zero-copy) still copies in the kernel,
+ * and its TX ring wants a kick on every send.
+ *
+ * Packets only reach the socket through an XDP program that redirects them
+ * to it via an XSKMAP. KC_XDP_F_REDIRECT installs a built-in one that sends
+ * every packet on the bound queue to the socket. Without it, put
+ * kc_xdp_fd() into your own program's XSKMAP.
+ *
+ * Needs CAP_NET_RAW (and CAP_BPF/CAP_NET_ADMIN for KC_XDP_F_REDIRECT).
+ * Functions return 0 or a negative errno / KC_* code like the rest of kcoro.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../../../include/kcoro.h"
+#include "../../../include/kcoro_zcopy.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct kc_xdp kc_xdp_t;
+
+/* kc_xdp_opts_t flags */
+#define KC_XDP_F_COPY      (1u<<0)  /* force copy mode */
+#define KC_XDP_F_ZEROCOPY  (1u<<1)  /* require zero-copy; otherwise it is tried first */
+#define KC_XDP_F_REDIRECT  (1u<<2)  /* install the built-in redirect program */
+#define KC_XDP_F_SKB       (1u<<3)  /* attach that program in generic (SKB) mode */
+#define KC_XDP_F_HUGEPAGE  (1u<<4)  /* back UMEM with huge pages (KC_REGION_F_HUGEPAGE) */
+
+typedef struct kc_xdp_opts {
+    const char *ifname;     /* interface to bind */
+    uint32_t queue;         /* its RX/TX queue */
+    uint32_t frames;        /* UMEM frames, at least 2 * ring_size (0: 4096) */
+    uint32_t frame_size;    /* power of two, 2048 up to the page size (0: 2048) */
+    uint32_t ring_size;     /* entries in each of the four rings, power of two (0: 2048) */
+    uint32_t flags;         /* KC_XDP_F_* */
+} kc_xdp_opts_t;
+
+/**
+ * Create the socket and UMEM and bind them to opts->ifname / opts->queue
+ *
+ * Half the frames (ring_size of them) go to the fill ring for the kernel to
+ * receive into; the rest wait for kc_xdp_frame_alloc.
+ *
+ * @return 0, -EINVAL, -ENODEV (no such interface), -ENOMEM, or the errno of
+ *         the socket, setsockopt, mmap, bind or bpf call that failed
+ */
+int kc_xdp_open(const kc_xdp_opts_t *opts, kc_xdp_t **out);
+
+/** Unbind and free everything; -EBUSY while channels are still bound. */
+int kc_xdp_close(kc_xdp_t *x);
+
+/** The AF_XDP socket, for an XSKMAP entry of your own XDP program. */
+int kc_xdp_fd(const kc_xdp_t *x);
+
+/** The UMEM region (frames are frame_size apart from its start). */
+kc_region_t *kc_xdp_region(const kc_xdp_t *x);
+size_t kc_xdp_frame_size(const kc_xdp_t *x);
+
+/** 1 when the kernel bound in zero-copy mode, 0 in copy mode. */
+int kc_xdp_is_zerocopy(const kc_xdp_t *x);
+
+/**
+ * Make ch carry packets through x (kc_chan_enable_zero_copy_backend with
+ * the "af_xdp" backend). Channel kind and capacity do not matter; the
+ * rings do the queueing. Closing ch fails its waiting receives with
+ * KC_EPIPE; destroying it unbinds it.
+ */
+int kc_xdp_bind_chan(kc_xdp_t *x, kc_chan_t *ch);
+
+/** A free frame to build a packet in, or NULL when every frame is out. */
+void *kc_xdp_frame_alloc(kc_xdp_t *x);
+
+/**
+ * Hand a frame back: a received one that will not be forwarded, or an
+ * allocated one that will not be sent. ptr may point anywhere inside the
+ * frame. -EINVAL when it is outside UMEM. Releasing a frame twice is not
+ * detected.
+ */
+int kc_xdp_release(kc_xdp_t *x, void *ptr);
+
+typedef struct kc_xdp_stats {
+    unsigned long rx_packets, rx_bytes;
+    unsigned long tx_packets, tx_bytes;  /* posted to the TX ring */
+    unsigned long tx_completed;          /* reported sent by the kernel */
+    unsigned long rx_kicks, tx_kicks;    /* wakeup syscalls */
+    unsigned long rx_waits, tx_waits;    /* parks on an empty RX / full TX ring */
+    unsigned long frames_free;           /* in the allocation pool now */
+    /* Kernel counters (XDP_STATISTICS); 0 where the kernel lacks them */
+    unsigned long rx_dropped, rx_invalid_descs, tx_invalid_descs;
+    unsigned long rx_ring_full, rx_fill_ring_empty, tx_ring_empty;
+} kc_xdp_stats_t;
+
+void kc_xdp_get_stats(kc_xdp_t *x, kc_xdp_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,585 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/*
+ * AF_XDP zero-copy backend
+ * ------------------------
+ *
+ * One socket, one UMEM, four single-producer/single-consumer rings shared
+ * with the kernel:
+ *
+ *   fill        we produce free frame offsets, the kernel receives into them
+ *   rx          the kernel produces (offset, len) of received packets
+ *   tx          we produce (offset, len) of packets to send
+ *   completion  the kernel produces offsets of frames it has sent
+ *
+ * Each ring keeps a cached copy of the other side's index, refreshed with an
+ * acquire load only when the cached view runs out, and publishes its own
+ * index with a release store, so a packet costs no syscall and no atomic
+ * read-modify-write. rx_mu serialises receivers, tx_mu senders and the
+ * completion ring, pool_mu the fill ring and the free stack (frames that are
+ * neither the kernel's nor handed out). tx_mu is taken before pool_mu.
+ *
+ * A frame coming back (released, or reported sent) goes to the fill ring
+ * while it has room, else onto the free stack for kc_xdp_frame_alloc. The
+ * fill ring starts full, so every packet the kernel takes from it comes back
+ * the same way.
+ */
+#define _GNU_SOURCE 1 /* if_nametoindex, MAP_POPULATE */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <net/if.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <linux/if_link.h>
+#include <linux/if_xdp.h>
+#include <linux/bpf.h>
+
+#include "../include/kcoro_xdp.h"
+#include "../../../include/kcoro_sched.h"
+#include "../../../include/kcoro_config.h"
+#include "../../../include/kcoro_port.h"
+
+#ifndef SOL_XDP
+#define SOL_XDP 283
+#endif
+#ifndef AF_XDP
+#define AF_XDP 44
+#endif
+
+#define XDP_BACKEND "af_xdp"
+#define REAP_BATCH  64
+
+struct xsk_ring {
+    uint32_t *producer;
+    uint32_t *consumer;
+    uint32_t *flags;
+    void     *desc;         /* uint64_t (fill, completion) or struct xdp_desc */
+    uint32_t  mask;
+    uint32_t  cached_prod;  /* producer rings: ours; consumer rings: last seen */
+    uint32_t  cached_cons;  /* consumer rings: ours; producer rings: last seen */
+    void     *map;
+    size_t    map_len;
+};
+
+struct kc_xdp {
+    int fd;
+    int ifindex;
+    uint32_t queue;
+    uint32_t frames, frame_size, ring_size;
+    int zerocopy;
+
+    kc_region_t *reg;
+    uint8_t *umem;
+    size_t umem_len;
+    uint64_t region_id;
+
+    pthread_mutex_t rx_mu;    /* rx ring */
+    pthread_mutex_t tx_mu;    /* tx and completion rings */
+    pthread_mutex_t pool_mu;  /* fill ring, free stack */
+    struct xsk_ring fill, comp, rx, tx;
+    uint64_t *free_stack;
+    uint32_t nfree;
+
+    int map_fd, prog_fd, link_fd;  /* KC_XDP_F_REDIRECT, else -1 */
+    _Atomic int bound;             /* channels attached */
+
+    _Atomic(unsigned long) rx_packets, rx_bytes, tx_packets, tx_bytes, tx_completed;
+    _Atomic(unsigned long) rx_kicks, tx_kicks, rx_waits, tx_waits;
+};
+
+#define STAT_ADD(x, f, n) atomic_fetch_add_explicit(&(x)->f, (n), memory_order_relaxed)
+
+/* ----------------------------- rings ----------------------------- */
+
+static inline uint32_t ring_load(const uint32_t *p)
+{
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static inline void ring_store(uint32_t *p, uint32_t v)
+{
+    __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+/* Producer side: free slots, up to want, refreshing the consumer index only
+ * when the cached view is short. */
+static uint32_t prod_free(struct xsk_ring *r, uint32_t want)
+{
+    uint32_t size = r->mask + 1;
+    uint32_t n = size - (r->cached_prod - r->cached_cons);
+    if (n >= want) return n;
+    r->cached_cons = ring_load(r->consumer);
+    return size - (r->cached_prod - r->cached_cons);
+}
+
+/* Consumer side: entries ready, refreshing the producer index likewise. */
+static uint32_t cons_avail(struct xsk_ring *r, uint32_t want)
+{
+    uint32_t n = r->cached_prod - r->cached_cons;
+    if (n >= want) return n;
+    r->cached_prod = ring_load(r->producer);
+    return r->cached_prod - r->cached_cons;
+}
+
+static inline int needs_wakeup(const struct xsk_ring *r)
+{
+    return (__atomic_load_n(r->flags, __ATOMIC_RELAXED) & XDP_RING_NEED_WAKEUP) != 0;
+}
+
+static int ring_map(int fd, struct xsk_ring *r, const struct xdp_ring_offset *off,
+                    uint32_t n, size_t elem, off_t pgoff)
+{
+    r->map_len = off->desc + (size_t)n * elem;
+    r->map = mmap(NULL, r->map_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, pgoff);
+    if (r->map == MAP_FAILED) { r->map = NULL; return -errno; }
+    uint8_t *base = (uint8_t*)r->map;
+    r->producer = (uint32_t*)(base + off->producer);
+    r->consumer = (uint32_t*)(base + off->consumer);
+    r->flags = (uint32_t*)(base + off->flags);
+    r->desc = base + off->desc;
+    r->mask = n - 1;
+    r->cached_prod = *r->producer;
+    r->cached_cons = *r->consumer;
+    return 0;
+}
+
+static void ring_unmap(struct xsk_ring *r)
+{
+    if (r->map) munmap(r->map, r->map_len);
+    r->map = NULL;
+}
+
+/* ----------------------------- frames ----------------------------- */
+
+/* Hand frames at these UMEM offsets back: fill ring first, then the free
+ * stack. Takes pool_mu. */
+static void frames_return(kc_xdp_t *x, const uint64_t *off, uint32_t n)
+{
+    pthread_mutex_lock(&x->pool_mu);
+    uint32_t room = prod_free(&x->fill, n);
+    uint32_t k = room < n ? room : n;
+    uint64_t *fdesc = (uint64_t*)x->fill.desc;
+    for (uint32_t i = 0; i < k; i++)
+        fdesc[(x->fill.cached_prod + i) & x->fill.mask] = off[i];
+    if (k) {
+        x->fill.cached_prod += k;
+        ring_store(x->fill.producer, x->fill.cached_prod);
+    }
+    for (uint32_t i = k; i < n; i++) x->free_stack[x->nfree++] = off[i];
+    pthread_mutex_unlock(&x->pool_mu);
+}
+
+/* Frames the kernel has finished sending; tx_mu held. */
+static void reap_completions_locked(kc_xdp_t *x)
+{
+    uint64_t off[REAP_BATCH];
+    uint32_t n;
+    while ((n = cons_avail(&x->comp, REAP_BATCH)) > 0) {
+        if (n > REAP_BATCH) n = REAP_BATCH;
+        const uint64_t *cdesc = (const uint64_t*)x->comp.desc;
+        for (uint32_t i = 0; i < n; i++)
+            off[i] = cdesc[(x->comp.cached_cons + i) & x->comp.mask] & ~((uint64_t)x->frame_size - 1);
+        x->comp.cached_cons += n;
+        ring_store(x->comp.consumer, x->comp.cached_cons);
+        STAT_ADD(x, tx_completed, n);
+        frames_return(x, off, n);
+    }
+}
+
+static int frame_offset(const kc_xdp_t *x, const void *ptr, uint64_t *out)
+{
+    const uint8_t *p = (const uint8_t*)ptr;
+    if (p < x->umem || p >= x->umem + x->umem_len) return -EINVAL;
+    *out = (uint64_t)(p - x->umem);
+    return 0;
+}
+
+void *kc_xdp_frame_alloc(kc_xdp_t *x)
+{
+    if (!x) return NULL;
+    pthread_mutex_lock(&x->tx_mu);
+    reap_completions_locked(x);
+    pthread_mutex_unlock(&x->tx_mu);
+    void *p = NULL;
+    pthread_mutex_lock(&x->pool_mu);
+    if (x->nfree) p = x->umem + x->free_stack[--x->nfree];
+    pthread_mutex_unlock(&x->pool_mu);
+    return p;
+}
+
+int kc_xdp_release(kc_xdp_t *x, void *ptr)
+{
+    if (!x) return -EINVAL;
+    uint64_t off;
+    if (frame_offset(x, ptr, &off) != 0) return -EINVAL;
+    off &= ~((uint64_t)x->frame_size - 1);
+    frames_return(x, &off, 1);
+    return 0;
+}
+
+/* ----------------------------- backend ----------------------------- */
+
+static long now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long)ts.tv_sec * 1000L + ts.tv_nsec / 1000000L;
+}
+
+/* Park on fd for the next slice of the caller's timeout. Slices keep a closed
+ * channel from going unnoticed; the socket itself never learns about close. */
+static int wait_slice(int fd, int writable, long tmo_ms, long deadline)
+{
+    long slice = KCORO_CANCEL_SLICE_MS;
+    if (tmo_ms > 0) {
+        long left = deadline - now_ms();
+        if (left <= 0) return KC_ETIME;
+        if (left < slice) slice = left;
+    }
+    int rc = writable ? kc_await_writable(fd, slice) : kc_await_readable(fd, slice);
+    return rc == KC_ETIME ? 0 : rc;
+}
+
+static int xdp_attach(kc_chan_t *ch, const void *opts)
+{
+    kc_xdp_t *x = (kc_xdp_t*)(uintptr_t)opts;
+    if (!x) return -EINVAL;
+    kc_chan_zcopy_set_priv(ch, x);
+    atomic_fetch_add(&x->bound, 1);
+    return 0;
+}
+
+static void xdp_detach(kc_chan_t *ch)
+{
+    kc_xdp_t *x = (kc_xdp_t*)kc_chan_zcopy_priv(ch);
+    if (!x) return;
+    kc_chan_zcopy_set_priv(ch, NULL);
+    atomic_fetch_sub(&x->bound, 1);
+}
+
+static int xdp_send(kc_chan_t *ch, const kc_zdesc_t *d, long tmo_ms)
+{
+    kc_xdp_t *x = (kc_xdp_t*)kc_chan_zcopy_priv(ch);
+    if (!x) return -ENOTSUP;
+    if (d->flags & KC_ZDESC_F_IOV) return -ENOTSUP;
+    uint64_t off;
+    if (d->len == 0 || frame_offset(x, d->addr, &off) != 0) return -EINVAL;
+    uint64_t in_frame = off & ((uint64_t)x->frame_size - 1);
+    if (d->len > x->frame_size - in_frame) return -EINVAL;
+    if (kc_chan_zcopy_closed(ch)) return KC_EPIPE;
+
+    long deadline = tmo_ms > 0 ? now_ms() + tmo_ms : 0;
+    for (;;) {
+        pthread_mutex_lock(&x->tx_mu);
+        reap_completions_locked(x);
+        if (prod_free(&x->tx, 1) > 0) {
+            struct xdp_desc *td = (struct xdp_desc*)x->tx.desc;
+            struct xdp_desc *slot = &td[x->tx.cached_prod & x->tx.mask];
+            slot->addr = off;
+            slot->len = (uint32_t)d->len;
+            slot->options = 0;
+            ring_store(x->tx.producer, ++x->tx.cached_prod);
+            if (needs_wakeup(&x->tx)) {
+                (void)sendto(x->fd, NULL, 0, MSG_DONTWAIT, NULL, 0);
+                STAT_ADD(x, tx_kicks, 1);
+            }
+            pthread_mutex_unlock(&x->tx_mu);
+            STAT_ADD(x, tx_packets, 1);
+            STAT_ADD(x, tx_bytes, d->len);
+            kc_chan_zcopy_account(ch, 1, d->len);
+            return 0;
+        }
+        /* Full: the kernel may be waiting for a kick to drain it */
+        (void)sendto(x->fd, NULL, 0, MSG_DONTWAIT, NULL, 0);
+        pthread_mutex_unlock(&x->tx_mu);
+        STAT_ADD(x, tx_kicks, 1);
+        if (tmo_ms == 0) return KC_EAGAIN;
+        if (kc_chan_zcopy_closed(ch)) return KC_EPIPE;
+        STAT_ADD(x, tx_waits, 1);
+        int rc = wait_slice(x->fd, 1, tmo_ms, deadline);
+        if (rc != 0) return rc;
+    }
+}
+
+static int xdp_recv(kc_chan_t *ch, kc_zdesc_t *d, long tmo_ms)
+{
+    kc_xdp_t *x = (kc_xdp_t*)kc_chan_zcopy_priv(ch);
+    if (!x) return -ENOTSUP;
+
+    long deadline = tmo_ms > 0 ? now_ms() + tmo_ms : 0;
+    for (;;) {
+        pthread_mutex_lock(&x->rx_mu);
+        if (cons_avail(&x->rx, 1) > 0) {
+            const struct xdp_desc *rd = (const struct xdp_desc*)x->rx.desc;
+            struct xdp_desc in = rd[x->rx.cached_cons & x->rx.mask];
+            ring_store(x->rx.consumer, ++x->rx.cached_cons);
+            pthread_mutex_unlock(&x->rx_mu);
+            d->addr = x->umem + in.addr;
+            d->len = in.len;
+            d->region_id = x->region_id;
+            d->offset = in.addr;
+            d->flags = 0;
+            STAT_ADD(x, rx_packets, 1);
+            STAT_ADD(x, rx_bytes, in.len);
+            kc_chan_zcopy_account(ch, 0, in.len);
+            return 0;
+        }
+        pthread_mutex_unlock(&x->rx_mu);
+        if (kc_chan_zcopy_closed(ch)) return KC_EPIPE;
+        if (tmo_ms == 0) return KC_EAGAIN;
+        if (needs_wakeup(&x->fill)) {
+            (void)recvfrom(x->fd, NULL, 0, MSG_DONTWAIT, NULL, NULL);
+            STAT_ADD(x, rx_kicks, 1);
+        }
+        STAT_ADD(x, rx_waits, 1);
+        int rc = wait_slice(x->fd, 0, tmo_ms, deadline);
+        if (rc != 0) return rc;
+    }
+}
+
+static const kc_zcopy_backend_ops_t g_xdp_ops = {
+    .attach = xdp_attach, .detach = xdp_detach,
+    .send = xdp_send, .recv = xdp_recv,
+    .send_c = NULL, .recv_c = NULL,
+};
+
+int kc_xdp_bind_chan(kc_xdp_t *x, kc_chan_t *ch)
+{
+    if (!x || !ch) return -EINVAL;
+    kc_zcopy_backend_id id = kc_zcopy_register(XDP_BACKEND, &g_xdp_ops, KC_CHAN_CAP_ZERO_COPY);
+    if (id < 0) return id;
+    return kc_chan_enable_zero_copy_backend(ch, id, x);
+}
+
+/* ----------------------------- redirect program ----------------------------- */
+
+static long sys_bpf(int cmd, union bpf_attr *attr)
+{
+    return syscall(__NR_bpf, cmd, attr, sizeof(*attr));
+}
+
+/* XSKMAP with map[queue] = our socket, and a program that redirects every
+ * packet to the entry for the queue it arrived on, passing it to the stack
+ * when there is none:
+ *
+ *     return bpf_redirect_map(&xsks, ctx->rx_queue_index, XDP_PASS);
+ *
+ * Attached through a BPF link, so closing link_fd detaches it. */
+static int redirect_install(kc_xdp_t *x, uint32_t flags)
+{
+    union bpf_attr a;
+    memset(&a, 0, sizeof(a));
+    a.map_type = BPF_MAP_TYPE_XSKMAP;
+    a.key_size = sizeof(uint32_t);
+    a.value_size = sizeof(uint32_t);
+    a.max_entries = x->queue + 1;
+    x->map_fd = (int)sys_bpf(BPF_MAP_CREATE, &a);
+    if (x->map_fd < 0) return -errno;
+
+    uint32_t key = x->queue, val = (uint32_t)x->fd;
+    memset(&a, 0, sizeof(a));
+    a.map_fd = (uint32_t)x->map_fd;
+    a.key = (uint64_t)(uintptr_t)&key;
+    a.value = (uint64_t)(uintptr_t)&val;
+    a.flags = BPF_ANY;
+    if (sys_bpf(BPF_MAP_UPDATE_ELEM, &a) < 0) return -errno;
+
+    struct bpf_insn prog[] = {
+        /* r2 = ctx->rx_queue_index */
+        { .code = BPF_LDX | BPF_MEM | BPF_W, .dst_reg = 2, .src_reg = 1,
+          .off = offsetof(struct xdp_md, rx_queue_index) },
+        /* r1 = the map */
+        { .code = BPF_LD | BPF_DW | BPF_IMM, .dst_reg = 1, .src_reg = BPF_PSEUDO_MAP_FD,
+          .imm = x->map_fd },
+        { 0 },
+        /* r3 = XDP_PASS; r0 = bpf_redirect_map(r1, r2, r3); return r0 */
+        { .code = BPF_ALU64 | BPF_MOV | BPF_K, .dst_reg = 3, .imm = XDP_PASS },
+        { .code = BPF_JMP | BPF_CALL, .imm = BPF_FUNC_redirect_map },
+        { .code = BPF_JMP | BPF_EXIT },
+    };
+    static const char license[] = "Dual BSD/GPL";
+    memset(&a, 0, sizeof(a));
+    a.prog_type = BPF_PROG_TYPE_XDP;
+    a.insn_cnt = sizeof(prog) / sizeof(prog[0]);
+    a.insns = (uint64_t)(uintptr_t)prog;
+    a.license = (uint64_t)(uintptr_t)license;
+    a.expected_attach_type = BPF_XDP;
+    x->prog_fd = (int)sys_bpf(BPF_PROG_LOAD, &a);
+    if (x->prog_fd < 0) return -errno;
+
+    memset(&a, 0, sizeof(a));
+    a.link_create.prog_fd = (uint32_t)x->prog_fd;
+    a.link_create.target_ifindex = (uint32_t)x->ifindex;
+    a.link_create.attach_type = BPF_XDP;
+    a.link_create.flags = (flags & KC_XDP_F_SKB) ? XDP_FLAGS_SKB_MODE : XDP_FLAGS_DRV_MODE;
+    x->link_fd = (int)sys_bpf(BPF_LINK_CREATE, &a);
+    if (x->link_fd < 0) return -errno;
+    return 0;
+}
+
+/* ----------------------------- lifecycle ----------------------------- */
+
+static int is_pow2(uint32_t v) { return v && (v & (v - 1)) == 0; }
+
+static void xdp_free(kc_xdp_t *x)
+{
+    if (x->link_fd >= 0) close(x->link_fd);
+    if (x->prog_fd >= 0) close(x->prog_fd);
+    if (x->map_fd >= 0) close(x->map_fd);
+    ring_unmap(&x->fill);
+    ring_unmap(&x->comp);
+    ring_unmap(&x->rx);
+    ring_unmap(&x->tx);
+    if (x->fd >= 0) close(x->fd);
+    if (x->reg) kc_region_deregister(x->reg);
+    free(x->free_stack);
+    pthread_mutex_destroy(&x->rx_mu);
+    pthread_mutex_destroy(&x->tx_mu);
+    pthread_mutex_destroy(&x->pool_mu);
+    free(x);
+}
+
+int kc_xdp_open(const kc_xdp_opts_t *opts, kc_xdp_t **out)
+{
+    if (!opts || !opts->ifname || !out) return -EINVAL;
+    if ((opts->flags & KC_XDP_F_COPY) && (opts->flags & KC_XDP_F_ZEROCOPY)) return -EINVAL;
+    uint32_t frames = opts->frames ? opts->frames : 4096;
+    uint32_t fsize = opts->frame_size ? opts->frame_size : 2048;
+    uint32_t rsize = opts->ring_size ? opts->ring_size : 2048;
+    long page = sysconf(_SC_PAGESIZE);
+    if (!is_pow2(fsize) || fsize < 2048 || (long)fsize > page) return -EINVAL;
+    if (!is_pow2(rsize) || frames / 2 < rsize) return -EINVAL;
+    unsigned ifindex = if_nametoindex(opts->ifname);
+    if (!ifindex) return -ENODEV;
+
+    kc_xdp_t *x = (kc_xdp_t*)calloc(1, sizeof(*x));
+    if (!x) return -ENOMEM;
+    x->fd = x->map_fd = x->prog_fd = x->link_fd = -1;
+    x->ifindex = (int)ifindex;
+    x->queue = opts->queue;
+    x->frames = frames;
+    x->frame_size = fsize;
+    x->ring_size = rsize;
+    pthread_mutex_init(&x->rx_mu, NULL);
+    pthread_mutex_init(&x->tx_mu, NULL);
+    pthread_mutex_init(&x->pool_mu, NULL);
+
+    int rc;
+    x->free_stack = (uint64_t*)malloc((size_t)frames * sizeof(uint64_t));
+    if (!x->free_stack) { rc = -ENOMEM; goto fail; }
+    rc = kc_region_alloc(&x->reg, (size_t)frames * fsize,
+                         (opts->flags & KC_XDP_F_HUGEPAGE) ? KC_REGION_F_HUGEPAGE : KC_REGION_F_NONE);
+    if (rc != 0) { x->reg = NULL; goto fail; }
+    x->umem = (uint8_t*)kc_region_addr(x->reg, &x->umem_len);
+    unsigned long rid = 0;
+    kc_region_export_id(x->reg, &rid);
+    x->region_id = rid;
+
+    x->fd = socket(AF_XDP, SOCK_RAW | SOCK_CLOEXEC, 0);
+    if (x->fd < 0) { rc = -errno; goto fail; }
+
+    struct xdp_umem_reg ureg;
+    memset(&ureg, 0, sizeof(ureg));
+    ureg.addr = (uint64_t)(uintptr_t)x->umem;
+    ureg.len = (uint64_t)frames * fsize;
+    ureg.chunk_size = fsize;
+    if (setsockopt(x->fd, SOL_XDP, XDP_UMEM_REG, &ureg, sizeof(ureg)) != 0 ||
+        setsockopt(x->fd, SOL_XDP, XDP_UMEM_FILL_RING, &rsize, sizeof(rsize)) != 0 ||
+        setsockopt(x->fd, SOL_XDP, XDP_UMEM_COMPLETION_RING, &rsize, sizeof(rsize)) != 0 ||
+        setsockopt(x->fd, SOL_XDP, XDP_RX_RING, &rsize, sizeof(rsize)) != 0 ||
+        setsockopt(x->fd, SOL_XDP, XDP_TX_RING, &rsize, sizeof(rsize)) != 0) {
+        rc = -errno; goto fail;
+    }
+    struct xdp_mmap_offsets mo;
+    socklen_t mlen = sizeof(mo);
+    if (getsockopt(x->fd, SOL_XDP, XDP_MMAP_OFFSETS, &mo, &mlen) != 0) { rc = -errno; goto fail; }
+    if ((rc = ring_map(x->fd, &x->fill, &mo.fr, rsize, sizeof(uint64_t), XDP_UMEM_PGOFF_FILL_RING)) != 0 ||
+        (rc = ring_map(x->fd, &x->comp, &mo.cr, rsize, sizeof(uint64_t), XDP_UMEM_PGOFF_COMPLETION_RING)) != 0 ||
+        (rc = ring_map(x->fd, &x->rx, &mo.rx, rsize, sizeof(struct xdp_desc), XDP_PGOFF_RX_RING)) != 0 ||
+        (rc = ring_map(x->fd, &x->tx, &mo.tx, rsize, sizeof(struct xdp_desc), XDP_PGOFF_TX_RING)) != 0)
+        goto fail;
+
+    /* The first ring_size frames go to the kernel, the rest to the pool */
+    uint64_t *fdesc = (uint64_t*)x->fill.desc;
+    for (uint32_t i = 0; i < rsize; i++)
+        fdesc[(x->fill.cached_prod + i) & x->fill.mask] = (uint64_t)i * fsize;
+    x->fill.cached_prod += rsize;
+    ring_store(x->fill.producer, x->fill.cached_prod);
+    for (uint32_t i = frames; i > rsize; i--)
+        x->free_stack[x->nfree++] = (uint64_t)(i - 1) * fsize;
+
+    /* Neither mode flag: the kernel tries zero-copy and falls back to copy */
+    struct sockaddr_xdp sxdp;
+    memset(&sxdp, 0, sizeof(sxdp));
+    sxdp.sxdp_family = AF_XDP;
+    sxdp.sxdp_ifindex = ifindex;
+    sxdp.sxdp_queue_id = opts->queue;
+    sxdp.sxdp_flags = XDP_USE_NEED_WAKEUP;
+    if (opts->flags & KC_XDP_F_COPY) sxdp.sxdp_flags |= XDP_COPY;
+    if (opts->flags & KC_XDP_F_ZEROCOPY) sxdp.sxdp_flags |= XDP_ZEROCOPY;
+    if (bind(x->fd, (struct sockaddr*)&sxdp, sizeof(sxdp)) != 0) { rc = -errno; goto fail; }
+
+    struct xdp_options xo;
+    socklen_t olen = sizeof(xo);
+    memset(&xo, 0, sizeof(xo));
+    if (getsockopt(x->fd, SOL_XDP, XDP_OPTIONS, &xo, &olen) == 0)
+        x->zerocopy = (xo.flags & XDP_OPTIONS_ZEROCOPY) != 0;
+
+    if ((opts->flags & KC_XDP_F_REDIRECT) && (rc = redirect_install(x, opts->flags)) != 0) goto fail;
+
+    *out = x;
+    return 0;
+fail:
+    xdp_free(x);
+    return rc;
+}
+
+int kc_xdp_close(kc_xdp_t *x)
+{
+    if (!x) return -EINVAL;
+    if (atomic_load(&x->bound) > 0) return -EBUSY;
+    xdp_free(x);
+    return 0;
+}
+
+int kc_xdp_fd(const kc_xdp_t *x) { return x ? x->fd : -1; }
+kc_region_t *kc_xdp_region(const kc_xdp_t *x) { return x ? x->reg : NULL; }
+size_t kc_xdp_frame_size(const kc_xdp_t *x) { return x ? x->frame_size : 0; }
+int kc_xdp_is_zerocopy(const kc_xdp_t *x) { return x ? x->zerocopy : 0; }
+
+void kc_xdp_get_stats(kc_xdp_t *x, kc_xdp_stats_t *out)
+{
+    if (!out) return;
+    memset(out, 0, sizeof(*out));
+    if (!x) return;
+    out->rx_packets = atomic_load_explicit(&x->rx_packets, memory_order_relaxed);
+    out->rx_bytes = atomic_load_explicit(&x->rx_bytes, memory_order_relaxed);
+    out->tx_packets = atomic_load_explicit(&x->tx_packets, memory_order_relaxed);
+    out->tx_bytes = atomic_load_explicit(&x->tx_bytes, memory_order_relaxed);
+    out->tx_completed = atomic_load_explicit(&x->tx_completed, memory_order_relaxed);
+    out->rx_kicks = atomic_load_explicit(&x->rx_kicks, memory_order_relaxed);
+    out->tx_kicks = atomic_load_explicit(&x->tx_kicks, memory_order_relaxed);
+    out->rx_waits = atomic_load_explicit(&x->rx_waits, memory_order_relaxed);
+    out->tx_waits = atomic_load_explicit(&x->tx_waits, memory_order_relaxed);
+    pthread_mutex_lock(&x->pool_mu);
+    out->frames_free = x->nfree;
+    pthread_mutex_unlock(&x->pool_mu);
+
+    struct xdp_statistics ks;
+    socklen_t klen = sizeof(ks);
+    memset(&ks, 0, sizeof(ks));
+    if (getsockopt(x->fd, SOL_XDP, XDP_STATISTICS, &ks, &klen) == 0) {
+        out->rx_dropped = (unsigned long)ks.rx_dropped;
+        out->rx_invalid_descs = (unsigned long)ks.rx_invalid_descs;
+        out->tx_invalid_descs = (unsigned long)ks.tx_invalid_descs;
+        out->rx_ring_full = (unsigned long)ks.rx_ring_full;
+        out->rx_fill_ring_empty = (unsigned long)ks.rx_fill_ring_empty_descs;
+        out->tx_ring_empty = (unsigned long)ks.tx_ring_empty_descs;
+    }
+}
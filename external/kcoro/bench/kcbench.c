@@ -0,0 +1,777 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/*
+ * kcbench — kcoro benchmark driver
+ * --------------------------------
+ *
+ * One binary for the microbenchmarks that used to live in separate tools:
+ * context switch, sched yield and spawn, rendezvous pingpong, buffered and
+ * MPMC-ring channels at several producer/consumer counts, copy vs zref by
+ * payload size, select fan-in, timer sleeps and an IPC round trip.
+ *
+ * Each case runs warmup + reps repetitions of a fixed op count and reports
+ * ns/op per repetition with mean, median, stddev and a 95% confidence
+ * interval (Student t). Results are written as JSON (schema
+ * "kcoro-bench-1", shared with kcoro_cpp_bench) and can be compared against
+ * a stored baseline: a case regresses when its median is more than the
+ * threshold slower and the confidence intervals do not overlap.
+ *
+ * With -p, perf counters (kc_bench_perf_*) are read over the measured
+ * repetitions of each case and reported per op next to the timings.
+ *
+ *   kcbench [-r reps] [-w warmup] [-s scale] [-f filter] [-o out.json]
+ *           [-b baseline.json] [-t threshold_pct] [-p] [-l]
+ *   kcbench -c baseline.json current.json [-t threshold_pct]
+ */
+#define _GNU_SOURCE 1
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/utsname.h>
+
+#include "../include/kcoro.h"
+#include "../include/kcoro_core.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_bench.h"
+#include "../ipc/posix/include/kcoro_ipc_posix.h"
+#include "kcbench_stats.h"
+
+#define KCBENCH_TIMEOUT_NS (60L * 1000000000L)
+
+static long now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+struct bench_case;
+/* Runs ops operations and returns the elapsed ns, or a negative errno. */
+typedef long (*bench_fn)(const struct bench_case *bc, long ops);
+
+struct bench_case {
+    const char *name;
+    const char *desc;
+    bench_fn fn;
+    long ops;          /* per repetition at scale 1 */
+    int p, c;          /* producers / consumers where it applies */
+    size_t size;       /* payload bytes where it applies */
+};
+
+/* ---- Completion tracking ----
+ * Workers count down `left`; the last one stamps t_end, so the main
+ * thread's polling does not add to the measured time. */
+struct run {
+    _Atomic long left;
+    _Atomic long t_end;
+    _Atomic int  bad;
+};
+
+static void run_init(struct run *r, long workers)
+{
+    atomic_store(&r->left, workers);
+    atomic_store(&r->t_end, 0);
+    atomic_store(&r->bad, 0);
+}
+
+static void run_done(struct run *r)
+{
+    if (atomic_fetch_sub_explicit(&r->left, 1, memory_order_acq_rel) == 1)
+        atomic_store_explicit(&r->t_end, now_ns(), memory_order_release);
+}
+
+static long run_wait(struct run *r, long t0)
+{
+    while (atomic_load_explicit(&r->left, memory_order_acquire) > 0) {
+        if (now_ns() - t0 > KCBENCH_TIMEOUT_NS) return -ETIMEDOUT;
+        usleep(50);
+    }
+    while (!atomic_load_explicit(&r->t_end, memory_order_acquire)) {}
+    if (atomic_load(&r->bad)) return -EIO;
+    return atomic_load(&r->t_end) - t0;
+}
+
+static int spawn(kcoro_fn_t fn, void *arg)
+{
+    return kc_spawn_co(kc_sched_default(), fn, arg, 0, NULL) == 0 ? 0 : -ENOMEM;
+}
+
+/* ---- switch.resume_yield: raw kcoro_resume/kcoro_yield, no scheduler ---- */
+
+struct sw_ctx { long ops; long elapsed; volatile int stop; };
+
+static void sw_co(void *arg)
+{
+    struct sw_ctx *s = (struct sw_ctx*)arg;
+    while (!s->stop) kcoro_yield();
+}
+
+static void *sw_thread(void *arg)
+{
+    struct sw_ctx *s = (struct sw_ctx*)arg;
+    kcoro_create_main();
+    kcoro_t *co = kcoro_create(sw_co, s, 0);
+    if (!co) { s->elapsed = -ENOMEM; return NULL; }
+    kcoro_resume(co);
+    long t0 = now_ns();
+    for (long i = 0; i < s->ops; i++) kcoro_resume(co);
+    s->elapsed = now_ns() - t0;
+    s->stop = 1;
+    kcoro_resume(co);
+    kcoro_destroy(co);
+    return NULL;
+}
+
+static long bench_switch(const struct bench_case *bc, long ops)
+{
+    (void)bc;
+    struct sw_ctx s = { ops, 0, 0 };
+    pthread_t th;
+    if (pthread_create(&th, NULL, sw_thread, &s) != 0) return -EAGAIN;
+    pthread_join(th, NULL);
+    return s.elapsed;
+}
+
+/* ---- sched.yield / sched.spawn ---- */
+
+struct yield_ctx { struct run r; long ops; };
+
+static void yield_co(void *arg)
+{
+    struct yield_ctx *y = (struct yield_ctx*)arg;
+    for (long i = 0; i < y->ops; i++) kc_yield();
+    run_done(&y->r);
+}
+
+static long bench_yield(const struct bench_case *bc, long ops)
+{
+    (void)bc;
+    struct yield_ctx y = { .ops = ops };
+    run_init(&y.r, 1);
+    long t0 = now_ns();
+    if (spawn(yield_co, &y) != 0) return -ENOMEM;
+    return run_wait(&y.r, t0);
+}
+
+static void spawn_co(void *arg)
+{
+    run_done((struct run*)arg);
+}
+
+static long bench_spawn(const struct bench_case *bc, long ops)
+{
+    (void)bc;
+    struct run r;
+    run_init(&r, ops);
+    long t0 = now_ns();
+    for (long i = 0; i < ops; i++)
+        if (spawn(spawn_co, &r) != 0) return -ENOMEM;
+    return run_wait(&r, t0);
+}
+
+/* ---- chan.rv_pingpong ---- */
+
+struct pp_ctx { struct run r; kc_chan_t *ping, *pong; long ops; };
+
+static void pp_pinger(void *arg)
+{
+    struct pp_ctx *p = (struct pp_ctx*)arg;
+    for (long i = 0; i < p->ops; i++) {
+        long v = i;
+        if (kc_chan_send(p->ping, &v, -1) != 0 || kc_chan_recv(p->pong, &v, -1) != 0 || v != i + 1)
+            atomic_store(&p->r.bad, 1);
+    }
+    run_done(&p->r);
+}
+
+static void pp_ponger(void *arg)
+{
+    struct pp_ctx *p = (struct pp_ctx*)arg;
+    for (long i = 0; i < p->ops; i++) {
+        long v = 0;
+        if (kc_chan_recv(p->ping, &v, -1) != 0) atomic_store(&p->r.bad, 1);
+        v++;
+        if (kc_chan_send(p->pong, &v, -1) != 0) atomic_store(&p->r.bad, 1);
+    }
+    run_done(&p->r);
+}
+
+static long bench_pingpong(const struct bench_case *bc, long ops)
+{
+    (void)bc;
+    struct pp_ctx p = { .ops = ops };
+    if (kc_chan_make(&p.ping, KC_RENDEZVOUS, sizeof(long), 0) != 0) return -ENOMEM;
+    if (kc_chan_make(&p.pong, KC_RENDEZVOUS, sizeof(long), 0) != 0) { kc_chan_destroy(p.ping); return -ENOMEM; }
+    run_init(&p.r, 2);
+    long t0 = now_ns();
+    long rc = spawn(pp_ponger, &p) == 0 && spawn(pp_pinger, &p) == 0 ? run_wait(&p.r, t0) : -ENOMEM;
+    kc_chan_destroy(p.ping);
+    kc_chan_destroy(p.pong);
+    return rc;
+}
+
+/* ---- chan.buffered.PxC / chan.mpmc_ring.PxC / chan.copy.N / chan.zref.N ---- */
+
+struct mq_ctx {
+    struct run r;
+    kc_chan_t *ch;
+    long per_prod, per_cons;
+    size_t size;
+    int zref;
+    unsigned char **pool;   /* zref payloads, 2x the channel capacity */
+};
+
+#define MQ_CAP 1024
+#define MQ_PAYLOAD_CAP 64
+
+static void mq_producer(void *arg)
+{
+    struct mq_ctx *m = (struct mq_ctx*)arg;
+    if (m->zref) {
+        for (long i = 0; i < m->per_prod; i++) {
+            unsigned char *p = m->pool[i % (2 * MQ_PAYLOAD_CAP)];
+            if (kc_chan_send_zref(m->ch, p, m->size, -1) != 0) atomic_store(&m->r.bad, 1);
+        }
+    } else if (m->size) {
+        unsigned char *buf = (unsigned char*)malloc(m->size);
+        if (!buf) { atomic_store(&m->r.bad, 1); run_done(&m->r); return; }
+        memset(buf, 0x5a, m->size);
+        for (long i = 0; i < m->per_prod; i++)
+            if (kc_chan_send(m->ch, buf, -1) != 0) atomic_store(&m->r.bad, 1);
+        free(buf);
+    } else {
+        for (long i = 0; i < m->per_prod; i++) {
+            int v = (int)i;
+            if (kc_chan_send(m->ch, &v, -1) != 0) atomic_store(&m->r.bad, 1);
+        }
+    }
+    run_done(&m->r);
+}
+
+static void mq_consumer(void *arg)
+{
+    struct mq_ctx *m = (struct mq_ctx*)arg;
+    unsigned sink = 0;
+    if (m->zref) {
+        for (long i = 0; i < m->per_cons; i++) {
+            void *p = NULL; size_t len = 0;
+            if (kc_chan_recv_zref(m->ch, &p, &len, -1) != 0 || len != m->size) { atomic_store(&m->r.bad, 1); continue; }
+            sink += ((unsigned char*)p)[len - 1];
+        }
+    } else if (m->size) {
+        unsigned char *buf = (unsigned char*)malloc(m->size);
+        if (!buf) { atomic_store(&m->r.bad, 1); run_done(&m->r); return; }
+        for (long i = 0; i < m->per_cons; i++) {
+            if (kc_chan_recv(m->ch, buf, -1) != 0) atomic_store(&m->r.bad, 1);
+            sink += buf[m->size - 1];
+        }
+        free(buf);
+    } else {
+        for (long i = 0; i < m->per_cons; i++) {
+            int v;
+            if (kc_chan_recv(m->ch, &v, -1) != 0) atomic_store(&m->r.bad, 1);
+        }
+    }
+    __asm__ volatile("" :: "r"(sink));
+    run_done(&m->r);
+}
+
+static long mq_run(struct mq_ctx *m, int p, int c, long ops)
+{
+    m->per_prod = ops / p;
+    m->per_cons = ops / c;
+    run_init(&m->r, p + c);
+    long t0 = now_ns();
+    for (int i = 0; i < c; i++) if (spawn(mq_consumer, m) != 0) return -ENOMEM;
+    for (int i = 0; i < p; i++) if (spawn(mq_producer, m) != 0) return -ENOMEM;
+    long rc = run_wait(&m->r, t0);
+    kc_chan_destroy(m->ch);
+    return rc;
+}
+
+/* ops must split evenly over producers and consumers */
+static long mq_ops(const struct bench_case *bc, long ops)
+{
+    long q = (long)bc->p * bc->c;
+    return ops / q * q;
+}
+
+static long bench_buffered(const struct bench_case *bc, long ops)
+{
+    struct mq_ctx m = {0};
+    if (kc_chan_make(&m.ch, KC_BUFFERED, sizeof(int), MQ_CAP) != 0) return -ENOMEM;
+    return mq_run(&m, bc->p, bc->c, mq_ops(bc, ops));
+}
+
+static long bench_mpmc_ring(const struct bench_case *bc, long ops)
+{
+    struct mq_ctx m = {0};
+    if (kc_chan_make_mpmc(&m.ch, sizeof(int), MQ_CAP) != 0) return -ENOMEM;
+    return mq_run(&m, bc->p, bc->c, mq_ops(bc, ops));
+}
+
+static long bench_copy(const struct bench_case *bc, long ops)
+{
+    struct mq_ctx m = { .size = bc->size };
+    if (kc_chan_make(&m.ch, KC_BUFFERED, bc->size, MQ_PAYLOAD_CAP) != 0) return -ENOMEM;
+    return mq_run(&m, 1, 1, ops);
+}
+
+static long bench_zref(const struct bench_case *bc, long ops)
+{
+    struct mq_ctx m = { .size = bc->size, .zref = 1 };
+    unsigned char *pool[2 * MQ_PAYLOAD_CAP];
+    unsigned char *slab = (unsigned char*)malloc(bc->size * 2 * MQ_PAYLOAD_CAP);
+    if (!slab) return -ENOMEM;
+    memset(slab, 0x5a, bc->size * 2 * MQ_PAYLOAD_CAP);
+    for (int i = 0; i < 2 * MQ_PAYLOAD_CAP; i++) pool[i] = slab + (size_t)i * bc->size;
+    m.pool = pool;
+    long rc = -ENOMEM;
+    if (kc_chan_make_ptr(&m.ch, KC_BUFFERED, MQ_PAYLOAD_CAP) == 0) {
+        if (kc_chan_enable_zero_copy(m.ch) == 0) rc = mq_run(&m, 1, 1, ops);
+        else { kc_chan_destroy(m.ch); rc = -ENOTSUP; }
+    }
+    free(slab);
+    return rc;
+}
+
+/* ---- select.fan_in.N ---- */
+
+#define FANIN_MAX 8
+
+struct fan_ctx { struct run r; kc_chan_t *ch[FANIN_MAX]; int n; long per_prod, total; _Atomic int next; };
+
+static void fan_producer(void *arg)
+{
+    struct fan_ctx *f = (struct fan_ctx*)arg;
+    kc_chan_t *ch = f->ch[atomic_fetch_add(&f->next, 1)];
+    for (long i = 0; i < f->per_prod; i++) {
+        int v = (int)i;
+        if (kc_chan_send(ch, &v, -1) != 0) atomic_store(&f->r.bad, 1);
+    }
+    run_done(&f->r);
+}
+
+static void fan_consumer(void *arg)
+{
+    struct fan_ctx *f = (struct fan_ctx*)arg;
+    kc_select_t *sel = NULL;
+    int vals[FANIN_MAX];
+    if (kc_select_create(&sel, NULL) != 0) { atomic_store(&f->r.bad, 1); run_done(&f->r); return; }
+    for (long i = 0; i < f->total; i++) {
+        int idx = -1, res = 0;
+        kc_select_reset(sel);
+        for (int k = 0; k < f->n; k++) kc_select_add_recv(sel, f->ch[k], &vals[k]);
+        if (kc_select_wait(sel, -1, &idx, &res) != 0 || res != 0) atomic_store(&f->r.bad, 1);
+    }
+    kc_select_destroy(sel);
+    run_done(&f->r);
+}
+
+static long bench_fan_in(const struct bench_case *bc, long ops)
+{
+    struct fan_ctx f = { .n = bc->p };
+    f.per_prod = ops / bc->p;
+    f.total = f.per_prod * bc->p;
+    for (int k = 0; k < f.n; k++)
+        if (kc_chan_make(&f.ch[k], KC_BUFFERED, sizeof(int), MQ_PAYLOAD_CAP) != 0) return -ENOMEM;
+    run_init(&f.r, f.n + 1);
+    long t0 = now_ns();
+    long rc = spawn(fan_consumer, &f);
+    for (int k = 0; rc == 0 && k < f.n; k++) rc = spawn(fan_producer, &f);
+    if (rc == 0) rc = run_wait(&f.r, t0);
+    for (int k = 0; k < f.n; k++) kc_chan_destroy(f.ch[k]);
+    return rc;
+}
+
+/* ---- timer.sleep_1ms: p sleepers, ops sleeps each; ns/op is per sleep ---- */
+
+struct sleep_ctx { struct run r; long ops; };
+
+static void sleep_co(void *arg)
+{
+    struct sleep_ctx *s = (struct sleep_ctx*)arg;
+    for (long i = 0; i < s->ops; i++) kc_sleep_ms(1);
+    run_done(&s->r);
+}
+
+static long bench_sleep(const struct bench_case *bc, long ops)
+{
+    struct sleep_ctx s = { .ops = ops };
+    run_init(&s.r, bc->p);
+    long t0 = now_ns();
+    for (int i = 0; i < bc->p; i++) if (spawn(sleep_co, &s) != 0) return -ENOMEM;
+    return run_wait(&s.r, t0);
+}
+
+/* ---- ipc.roundtrip: echo over a Unix socket link (shm rings when offered) ---- */
+
+struct ipc_ctx { kc_ipc_server_t *srv; size_t size; int rc; };
+
+static void *ipc_echo_thread(void *arg)
+{
+    struct ipc_ctx *x = (struct ipc_ctx*)arg;
+    kc_ipc_conn_t *c = NULL;
+    uint32_t maj, min;
+    if (kc_ipc_srv_accept(x->srv, &c) != 0 || kc_ipc_hs_srv(c, &maj, &min) != 0) {
+        x->rc = -EPROTO;
+        if (c) kc_ipc_conn_close(c);
+        return NULL;
+    }
+    unsigned char *buf = (unsigned char*)malloc(x->size);
+    uint16_t cmd;
+    size_t len;
+    while (buf && kc_ipc_recv_into(c, &cmd, buf, x->size, &len) == 0)
+        if (kc_ipc_send(c, cmd, buf, len) != 0) break;
+    free(buf);
+    kc_ipc_conn_close(c);
+    return NULL;
+}
+
+static long bench_ipc(const struct bench_case *bc, long ops)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/kcbench.%d.sock", (int)getpid());
+    unlink(path);
+    struct ipc_ctx x = { .size = bc->size };
+    if (kc_ipc_srv_listen(path, &x.srv) != 0) return -EADDRNOTAVAIL;
+    pthread_t th;
+    if (pthread_create(&th, NULL, ipc_echo_thread, &x) != 0) { kc_ipc_srv_close(x.srv); return -EAGAIN; }
+    kc_ipc_conn_t *c = NULL;
+    uint32_t maj, min;
+    long rc = -EPROTO;
+    unsigned char *out = (unsigned char*)calloc(1, bc->size), *in = (unsigned char*)malloc(bc->size);
+    if (out && in && kc_ipc_connect(path, &c) == 0 && kc_ipc_hs_cli(c, &maj, &min) == 0) {
+        long t0 = now_ns();
+        uint16_t cmd;
+        size_t len;
+        for (long i = 0; i < ops; i++) {
+            if (kc_ipc_send(c, KCORO_CMD_GET_INFO, out, bc->size) != 0 ||
+                kc_ipc_recv_into(c, &cmd, in, bc->size, &len) != 0 || len != bc->size) { t0 = -1; break; }
+        }
+        rc = t0 < 0 ? -EIO : now_ns() - t0;
+    }
+    if (c) kc_ipc_conn_shutdown(c);
+    pthread_join(th, NULL);
+    if (c) kc_ipc_conn_close(c);
+    kc_ipc_srv_close(x.srv);
+    unlink(path);
+    free(out);
+    free(in);
+    return x.rc ? x.rc : rc;
+}
+
+/* ---- Case table ---- */
+
+static const struct bench_case g_cases[] = {
+    { "switch.resume_yield", "kcoro_resume + kcoro_yield round trip, no scheduler", bench_switch, 2000000, 0, 0, 0 },
+    { "sched.yield", "kc_yield of a lone coroutine through its worker", bench_yield, 1000000, 0, 0, 0 },
+    { "sched.spawn", "kc_spawn_co of an empty coroutine, to completion", bench_spawn, 100000, 0, 0, 0 },
+    { "chan.rv_pingpong", "rendezvous send/recv round trip between two coroutines", bench_pingpong, 200000, 1, 1, 0 },
+    { "chan.buffered.1x1", "KC_BUFFERED int, 1 producer x 1 consumer", bench_buffered, 1000000, 1, 1, 0 },
+    { "chan.buffered.4x4", "KC_BUFFERED int, 4 producers x 4 consumers", bench_buffered, 1000000, 4, 4, 0 },
+    { "chan.buffered.8x8", "KC_BUFFERED int, 8 producers x 8 consumers", bench_buffered, 1000000, 8, 8, 0 },
+    { "chan.mpmc_ring.1x1", "lock-free MPMC ring int, 1 producer x 1 consumer", bench_mpmc_ring, 1000000, 1, 1, 0 },
+    { "chan.mpmc_ring.4x4", "lock-free MPMC ring int, 4 producers x 4 consumers", bench_mpmc_ring, 1000000, 4, 4, 0 },
+    { "chan.mpmc_ring.8x8", "lock-free MPMC ring int, 8 producers x 8 consumers", bench_mpmc_ring, 1000000, 8, 8, 0 },
+    { "chan.copy.64", "buffered copy of a 64 B element", bench_copy, 500000, 1, 1, 64 },
+    { "chan.zref.64", "buffered zref of a 64 B payload", bench_zref, 500000, 1, 1, 64 },
+    { "chan.copy.4096", "buffered copy of a 4 KiB element", bench_copy, 200000, 1, 1, 4096 },
+    { "chan.zref.4096", "buffered zref of a 4 KiB payload", bench_zref, 200000, 1, 1, 4096 },
+    { "chan.copy.65536", "buffered copy of a 64 KiB element", bench_copy, 20000, 1, 1, 65536 },
+    { "chan.zref.65536", "buffered zref of a 64 KiB payload", bench_zref, 20000, 1, 1, 65536 },
+    { "select.fan_in.4", "kc_select over 4 buffered channels, 1 producer each", bench_fan_in, 400000, 4, 1, 0 },
+    { "timer.sleep_1ms", "kc_sleep_ms(1) latency, 16 concurrent sleepers", bench_sleep, 100, 16, 0, 0 },
+    { "ipc.roundtrip.64", "64 B request/echo over a Unix socket link", bench_ipc, 20000, 1, 1, 64 },
+};
+#define NCASES (int)(sizeof(g_cases) / sizeof(g_cases[0]))
+
+/* ---- Statistics ---- */
+
+/* ---- Baseline comparison ----
+ * Reads the results back from kcoro-bench-1 JSON: one result object per
+ * line, as written by write_json (and kcoro_cpp_bench). */
+
+struct base_row { char name[64]; double median, ci_lo, ci_hi; };
+
+static int json_num(const char *obj, const char *key, double *out)
+{
+    char pat[32];
+    snprintf(pat, sizeof(pat), "\"%s\": ", key);
+    const char *p = strstr(obj, pat);
+    if (!p) return -1;
+    *out = strtod(p + strlen(pat), NULL);
+    return 0;
+}
+
+static int load_results(const char *path, struct base_row **out)
+{
+    FILE *f = fopen(path, "r");
+    if (!f) return -errno;
+    char line[16384];
+    int n = 0, cap = 0, schema = 0;
+    struct base_row *rows = NULL;
+    while (fgets(line, sizeof(line), f)) {
+        if (strstr(line, "\"schema\": \"" KCBENCH_SCHEMA "\"")) schema = 1;
+        const char *p = strstr(line, "{\"name\": \"");
+        if (!p) continue;
+        p += 10;
+        const char *e = strchr(p, '"');
+        if (!e || e - p >= 64) continue;
+        if (n == cap) {
+            cap = cap ? cap * 2 : 32;
+            struct base_row *nr = (struct base_row*)realloc(rows, (size_t)cap * sizeof(*rows));
+            if (!nr) break;
+            rows = nr;
+        }
+        struct base_row *r = &rows[n];
+        memcpy(r->name, p, (size_t)(e - p));
+        r->name[e - p] = '\0';
+        if (json_num(e, "median", &r->median) || json_num(e, "ci95_lo", &r->ci_lo) || json_num(e, "ci95_hi", &r->ci_hi))
+            continue;
+        n++;
+    }
+    fclose(f);
+    if (!schema) { free(rows); return -EPROTO; }
+    *out = rows;
+    return n;
+}
+
+/* Prints one line per case and returns the number of regressions. */
+static int compare(const struct base_row *base, int nb, const struct base_row *cur, int nc, double thr_pct)
+{
+    int regress = 0;
+    printf("\n%-22s %12s %12s %8s  %s\n", "case", "base ns/op", "cur ns/op", "delta", "verdict");
+    for (int i = 0; i < nc; i++) {
+        const struct base_row *b = NULL;
+        for (int j = 0; j < nb && !b; j++) if (strcmp(base[j].name, cur[i].name) == 0) b = &base[j];
+        if (!b) { printf("%-22s %12s %12.1f %8s  new\n", cur[i].name, "-", cur[i].median, "-"); continue; }
+        double d = b->median > 0 ? (cur[i].median - b->median) / b->median * 100.0 : 0.0;
+        const char *v = "same";
+        if (d > thr_pct && cur[i].ci_lo > b->ci_hi) { v = "REGRESSION"; regress++; }
+        else if (d < -thr_pct && cur[i].ci_hi < b->ci_lo) v = "improved";
+        else if (fabs(d) > thr_pct) v = "noise";
+        printf("%-22s %12.1f %12.1f %+7.1f%%  %s\n", cur[i].name, b->median, cur[i].median, d, v);
+    }
+    for (int j = 0; j < nb; j++) {
+        int found = 0;
+        for (int i = 0; i < nc && !found; i++) found = strcmp(base[j].name, cur[i].name) == 0;
+        if (!found) printf("%-22s %12.1f %12s %8s  missing\n", base[j].name, base[j].median, "-", "-");
+    }
+    printf("%d regression(s) at %.1f%%\n", regress, thr_pct);
+    return regress;
+}
+
+/* ---- Output ---- */
+
+struct bench_result {
+    const struct bench_case *bc;
+    long ops;
+    int reps;
+    double *samples;
+    struct bench_stats st;
+    kc_bench_perf_sample_t perf;   /* over the measured reps; valid 0 without -p */
+    int err;
+};
+
+static double perf_per_op(const struct bench_result *r, int c)
+{
+    return (double)r->perf.value[c] / ((double)r->ops * r->reps);
+}
+
+static void print_perf(const struct bench_result *r)
+{
+    if (!r->perf.valid) return;
+    printf("%-22s", "  per op:");
+    for (int c = 0; c < KC_BENCH_PERF_COUNT; c++)
+        if (r->perf.valid & (1u << c)) printf(" %s %.2f", kc_bench_perf_name(c), perf_per_op(r, c));
+    unsigned ipc = (1u << KC_BENCH_PERF_CYCLES) | (1u << KC_BENCH_PERF_INSTRUCTIONS);
+    if ((r->perf.valid & ipc) == ipc && r->perf.value[KC_BENCH_PERF_CYCLES])
+        printf(" ipc %.2f", (double)r->perf.value[KC_BENCH_PERF_INSTRUCTIONS] / (double)r->perf.value[KC_BENCH_PERF_CYCLES]);
+    printf("\n");
+}
+
+static void write_json(FILE *f, const struct bench_result *res, int n, int reps, int warmup, double scale)
+{
+    struct utsname u;
+    char ts[32];
+    time_t t = time(NULL);
+    strftime(ts, sizeof(ts), "%Y-%m-%dT%H:%M:%SZ", gmtime(&t));
+    if (uname(&u) != 0) strcpy(u.machine, "unknown");
+    fprintf(f, "{\n  \"schema\": \"%s\",\n  \"tool\": \"kcbench\",\n", KCBENCH_SCHEMA);
+    fprintf(f, "  \"machine\": \"%s\",\n  \"cpus\": %ld,\n  \"timestamp\": \"%s\",\n", u.machine, sysconf(_SC_NPROCESSORS_ONLN), ts);
+    fprintf(f, "  \"reps\": %d,\n  \"warmup\": %d,\n  \"scale\": %g,\n  \"results\": [\n", reps, warmup, scale);
+    int first = 1;
+    for (int i = 0; i < n; i++) {
+        const struct bench_result *r = &res[i];
+        if (r->err) continue;
+        fprintf(f, "%s    {\"name\": \"%s\", \"unit\": \"ns/op\", \"ops\": %ld, \"reps\": %d, "
+                   "\"mean\": %.3f, \"median\": %.3f, \"stddev\": %.3f, \"ci95_lo\": %.3f, \"ci95_hi\": %.3f, "
+                   "\"min\": %.3f, \"max\": %.3f, ",
+                first ? "" : ",\n", r->bc->name, r->ops, r->reps, r->st.mean, r->st.median, r->st.stddev,
+                r->st.ci_lo, r->st.ci_hi, r->st.min, r->st.max);
+        if (r->perf.valid) {
+            fprintf(f, "\"perf_per_op\": {");
+            int sep = 0;
+            for (int c = 0; c < KC_BENCH_PERF_COUNT; c++)
+                if (r->perf.valid & (1u << c)) {
+                    fprintf(f, "%s\"%s\": %.4f", sep ? ", " : "", kc_bench_perf_name(c), perf_per_op(r, c));
+                    sep = 1;
+                }
+            fprintf(f, "}, ");
+        }
+        fprintf(f, "\"samples\": [");
+        for (int k = 0; k < r->reps; k++) fprintf(f, "%s%.3f", k ? ", " : "", r->samples[k]);
+        fprintf(f, "]}");
+        first = 0;
+    }
+    fprintf(f, "\n  ]\n}\n");
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [-r reps] [-w warmup] [-s scale] [-f filter] [-o out.json] [-b baseline.json] [-t pct] [-p] [-l]\n"
+            "       %s -c baseline.json current.json [-t pct]\n"
+            "  -r  measured repetitions per case (default 5)\n"
+            "  -w  warmup repetitions, not recorded (default 1)\n"
+            "  -s  scale every case's op count (e.g. 0.1 for a quick run)\n"
+            "  -f  run only cases whose name contains this substring (repeatable)\n"
+            "  -o  write results as JSON\n"
+            "  -b  compare against a baseline after running; exit 1 on regression\n"
+            "  -c  compare two result files without running anything\n"
+            "  -t  regression threshold in percent of the median (default 5)\n"
+            "  -p  read perf counters (cycles, instructions, cache/branch misses,\n"
+            "      context switches) and report them per op\n"
+            "  -l  list cases\n",
+            prog, prog);
+}
+
+#define MAX_FILTERS 16
+
+static int selected(const char *name, char **filters, int nf)
+{
+    if (!nf) return 1;
+    for (int i = 0; i < nf; i++) if (strstr(name, filters[i])) return 1;
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    int reps = 5, warmup = 1, list = 0, nf = 0, want_perf = 0;
+    double scale = 1.0, thr = 5.0;
+    const char *out_path = NULL, *base_path = NULL, *cmp_path = NULL;
+    char *filters[MAX_FILTERS];
+    int opt;
+    while ((opt = getopt(argc, argv, "r:w:s:f:o:b:c:t:plh")) != -1) {
+        switch (opt) {
+        case 'r': reps = atoi(optarg); break;
+        case 'w': warmup = atoi(optarg); break;
+        case 's': scale = atof(optarg); break;
+        case 'f': if (nf < MAX_FILTERS) filters[nf++] = optarg; break;
+        case 'o': out_path = optarg; break;
+        case 'b': base_path = optarg; break;
+        case 'c': cmp_path = optarg; break;
+        case 't': thr = atof(optarg); break;
+        case 'p': want_perf = 1; break;
+        case 'l': list = 1; break;
+        case 'h': default: usage(argv[0]); return 2;
+        }
+    }
+    if (list) {
+        for (int i = 0; i < NCASES; i++) printf("%-22s %s\n", g_cases[i].name, g_cases[i].desc);
+        return 0;
+    }
+    if (cmp_path) {
+        if (optind >= argc) { usage(argv[0]); return 2; }
+        struct base_row *b = NULL, *c = NULL;
+        int nb = load_results(cmp_path, &b), nc = load_results(argv[optind], &c);
+        if (nb < 0 || nc < 0) {
+            fprintf(stderr, "kcbench: cannot read %s: %s\n", nb < 0 ? cmp_path : argv[optind], strerror(nb < 0 ? -nb : -nc));
+            return 2;
+        }
+        int regress = compare(b, nb, c, nc, thr);
+        free(b);
+        free(c);
+        return regress ? 1 : 0;
+    }
+    if (reps < 1 || warmup < 0 || scale <= 0) { usage(argv[0]); return 2; }
+
+    kc_bench_perf_t *perf = NULL;
+    if (want_perf) {
+        (void)kc_sched_default();   /* counters attach to the threads alive now */
+        int prc = kc_bench_perf_open(&perf);
+        if (prc != 0) fprintf(stderr, "kcbench: perf counters unavailable (%s), timing only\n", strerror(-prc));
+    }
+
+    struct bench_result *res = (struct bench_result*)calloc(NCASES, sizeof(*res));
+    int n = 0;
+    printf("%-22s %10s %12s %12s %12s %12s\n", "case", "ops", "median", "mean", "ci95 +/-", "Mops/s");
+    for (int i = 0; i < NCASES; i++) {
+        const struct bench_case *bc = &g_cases[i];
+        if (!selected(bc->name, filters, nf)) continue;
+        struct bench_result *r = &res[n++];
+        r->bc = bc;
+        r->ops = (long)(bc->ops * scale);
+        if (r->ops < 1) r->ops = 1;
+        if (bc->fn == bench_buffered || bc->fn == bench_mpmc_ring) {
+            r->ops = mq_ops(bc, r->ops);
+            if (r->ops < 1) r->ops = (long)bc->p * bc->c;
+        }
+        r->reps = reps;
+        r->samples = (double*)calloc((size_t)reps, sizeof(double));
+        for (int k = -warmup; k < reps && !r->err; k++) {
+            if (k == 0 && perf) kc_bench_perf_start(perf);
+            long ns = bc->fn(bc, r->ops);
+            if (ns < 0) { r->err = (int)-ns; break; }
+            if (k >= 0) r->samples[k] = (double)ns / (double)r->ops;
+        }
+        if (r->err) { printf("%-22s failed: %s\n", bc->name, strerror(r->err)); continue; }
+        if (perf) kc_bench_perf_read(perf, &r->perf);
+        compute_stats(r->samples, reps, &r->st);
+        printf("%-22s %10ld %12.1f %12.1f %12.1f %12.3f\n", bc->name, r->ops, r->st.median, r->st.mean,
+               (r->st.ci_hi - r->st.ci_lo) / 2, r->st.median > 0 ? 1e3 / r->st.median : 0.0);
+        print_perf(r);
+        fflush(stdout);
+    }
+
+    kc_bench_perf_close(perf);
+    int failed = 0;
+    for (int i = 0; i < n; i++) failed += res[i].err != 0;
+    if (out_path) {
+        FILE *f = strcmp(out_path, "-") == 0 ? stdout : fopen(out_path, "w");
+        if (!f) { fprintf(stderr, "kcbench: %s: %s\n", out_path, strerror(errno)); return 2; }
+        write_json(f, res, n, reps, warmup, scale);
+        if (f != stdout) fclose(f);
+    }
+    int regress = 0;
+    if (base_path) {
+        struct base_row *b = NULL;
+        int nb = load_results(base_path, &b);
+        if (nb < 0) { fprintf(stderr, "kcbench: cannot read %s: %s\n", base_path, strerror(-nb)); return 2; }
+        struct base_row *c = (struct base_row*)calloc((size_t)n + 1, sizeof(*c));
+        int nc = 0;
+        for (int i = 0; i < n; i++) {
+            if (res[i].err) continue;
+            snprintf(c[nc].name, sizeof(c[nc].name), "%s", res[i].bc->name);
+            c[nc].median = res[i].st.median;
+            c[nc].ci_lo = res[i].st.ci_lo;
+            c[nc].ci_hi = res[i].st.ci_hi;
+            nc++;
+        }
+        /* Cases filtered out of this run are not "missing" */
+        int kept = 0;
+        for (int j = 0; j < nb; j++) if (selected(b[j].name, filters, nf)) b[kept++] = b[j];
+        regress = compare(b, kept, c, nc, thr);
+        free(b);
+        free(c);
+    }
+    for (int i = 0; i < n; i++) free(res[i].samples);
+    free(res);
+    return failed ? 2 : regress ? 1 : 0;
+}
@@ -0,0 +1,51 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+/* Repetition statistics shared by kcbench and kcipcload: mean, median,
+ * stddev and a Student-t 95% interval on the mean, as written to
+ * kcoro-bench-1 result objects. */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define KCBENCH_SCHEMA "kcoro-bench-1"
+
+struct bench_stats {
+    double mean, median, stddev, ci_lo, ci_hi, min, max;
+};
+
+/* Two-sided 95% Student t for df 1..30; 1.96 beyond */
+static inline double t95(int df)
+{
+    static const double t[] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042,
+    };
+    return df >= 1 && df <= 30 ? t[df - 1] : 1.96;
+}
+
+static inline int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static inline void compute_stats(const double *v, int n, struct bench_stats *st)
+{
+    double *s = (double*)malloc((size_t)n * sizeof(double));
+    memcpy(s, v, (size_t)n * sizeof(double));
+    qsort(s, (size_t)n, sizeof(double), cmp_double);
+    double sum = 0, sq = 0;
+    for (int i = 0; i < n; i++) sum += s[i];
+    st->mean = sum / n;
+    for (int i = 0; i < n; i++) sq += (s[i] - st->mean) * (s[i] - st->mean);
+    st->stddev = n > 1 ? sqrt(sq / (n - 1)) : 0.0;
+    st->median = n % 2 ? s[n / 2] : (s[n / 2 - 1] + s[n / 2]) / 2;
+    double half = n > 1 ? t95(n - 1) * st->stddev / sqrt((double)n) : 0.0;
+    st->ci_lo = st->mean - half;
+    st->ci_hi = st->mean + half;
+    st->min = s[0];
+    st->max = s[n - 1];
+    free(s);
+}
@@ -0,0 +1,479 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/*
+ * kcipcload — IPC load generator and latency benchmark
+ * ----------------------------------------------------
+ *
+ * Drives N clients over M multiplexed connections (kc_ipc_pool) against a
+ * kcoro IPC server, in-process by default or any kc_ipc_server_serve
+ * server given with -a. Each client owns one remote channel. A producer
+ * coroutine sends into it through one handle and a consumer coroutine
+ * receives from it through another, so every element makes two trips over
+ * the link, whatever the channel kind.
+ *
+ * Open loop (-R ops/s): each producer sends on a fixed schedule, spread
+ * evenly across clients, and stamps every element with the time it was
+ * due. Latency is counted from that due time, so a stall that holds back
+ * later sends is charged to every element it delayed (the coordinated
+ * omission correction). Service time, counted from the actual send, is
+ * reported alongside. Closed loop (no -R): producers send back to back and
+ * both measures coincide.
+ *
+ * Each repetition runs for -d seconds and yields ns/op (elapsed over
+ * elements received) and latency percentiles. Results go out as
+ * kcoro-bench-1 JSON, one object per measure, so kcbench -c compares two
+ * runs.
+ *
+ *   kcipcload [-c clients] [-m conns] [-k kind] [-s elem_sz] [-C capacity]
+ *             [-W window] [-R rate] [-d seconds] [-r reps] [-w warmup]
+ *             [-a unix:PATH|tcp:HOST:PORT [-S]] [-n name] [-o out.json]
+ */
+#define _GNU_SOURCE 1
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/utsname.h>
+
+#include "../include/kcoro.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_port.h"
+#include "../ipc/posix/include/kcoro_ipc_posix.h"
+#include "../ipc/posix/include/kcoro_ipc_server.h"
+#include "../ipc/posix/include/kcoro_ipc_chan.h"
+#include "../ipc/posix/include/kcoro_ipc_pool.h"
+#include "kcbench_stats.h"
+
+#define KCIPCLOAD_TIMEOUT_NS (60L * 1000000000L)
+#define STAMP_BYTES (2 * sizeof(long))   /* due time, then send time */
+
+static long now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+struct opts {
+    int clients, conns, kind, reps, warmup, serve;
+    size_t elem_sz, capacity, window;
+    double rate, secs;              /* rate 0: closed loop */
+    const char *addr, *name, *out;
+};
+
+static const struct { const char *name; int kind; } g_kinds[] = {
+    { "buffered", KC_BUFFERED }, { "rendezvous", KC_RENDEZVOUS }, { "unlimited", KC_UNLIMITED },
+};
+
+static const char *kind_name(int kind)
+{
+    for (size_t i = 0; i < sizeof(g_kinds) / sizeof(g_kinds[0]); i++)
+        if (g_kinds[i].kind == kind) return g_kinds[i].name;
+    return "?";
+}
+
+/* ---- Histograms: kc_hist buckets, filled by one consumer each ---- */
+
+static void hist_add(struct kc_hist *h, long ns)
+{
+    unsigned long v = ns > 0 ? (unsigned long)ns : 0;
+    if (!h->count || v < h->min_ns) h->min_ns = v;
+    if (v > h->max_ns) h->max_ns = v;
+    h->count++;
+    h->sum_ns += v;
+    h->buckets[kc_hist_bucket(v)]++;
+}
+
+static void hist_merge(struct kc_hist *dst, const struct kc_hist *src)
+{
+    if (!src->count) return;
+    if (!dst->count || src->min_ns < dst->min_ns) dst->min_ns = src->min_ns;
+    if (src->max_ns > dst->max_ns) dst->max_ns = src->max_ns;
+    dst->count += src->count;
+    dst->sum_ns += src->sum_ns;
+    for (int i = 0; i < KC_HIST_BUCKETS; i++) dst->buckets[i] += src->buckets[i];
+}
+
+/* ---- One repetition ---- */
+
+struct load;
+
+struct client {
+    struct load *ld;
+    int idx;
+    kc_ipc_chan_t *tx, *rx;
+    struct kc_hist lat, svc;        /* from due time / from actual send */
+    long sent, got;
+};
+
+struct load {
+    const struct opts *o;
+    kc_ipc_pool_t *pool;
+    struct client *cl;
+    _Atomic int ready, left, bad;
+    _Atomic long t0;                /* 0 until the clients may start */
+    long t_stop, interval_ns;
+    _Atomic long t_end;
+};
+
+static void load_done(struct load *ld)
+{
+    if (atomic_fetch_sub_explicit(&ld->left, 1, memory_order_acq_rel) == 1)
+        atomic_store_explicit(&ld->t_end, now_ns(), memory_order_release);
+}
+
+static void consumer(void *arg)
+{
+    struct client *c = (struct client*)arg;
+    unsigned char *buf = (unsigned char*)malloc(c->ld->o->elem_sz);
+    for (;;) {
+        int rc = buf ? kc_ipc_chan_recv(c->rx, buf, -1) : -ENOMEM;
+        if (rc == KC_EPIPE) break;
+        if (rc != 0) { atomic_fetch_add(&c->ld->bad, 1); break; }
+        long t = now_ns(), due, sent;
+        memcpy(&due, buf, sizeof(due));
+        memcpy(&sent, buf + sizeof(due), sizeof(sent));
+        hist_add(&c->lat, t - due);
+        hist_add(&c->svc, t - sent);
+        c->got++;
+    }
+    free(buf);
+    kc_ipc_chan_destroy(c->rx);
+    c->rx = NULL;
+    load_done(c->ld);
+}
+
+/* Sleep in whole milliseconds, waking a millisecond early for timer slack,
+ * then yield the rest. */
+static void wait_until(long due)
+{
+    for (long t = now_ns(); t < due; t = now_ns()) {
+        if (due - t >= 2000000L) kc_sleep_ms((int)((due - t) / 1000000L) - 1);
+        else kc_yield();
+    }
+}
+
+static void producer(void *arg)
+{
+    struct client *c = (struct client*)arg;
+    struct load *ld = c->ld;
+    const struct opts *o = ld->o;
+    unsigned char *buf = (unsigned char*)calloc(1, o->elem_sz);
+    int rc = buf ? kc_ipc_pool_chan_make(ld->pool, o->kind, o->elem_sz, o->capacity, &c->tx) : -ENOMEM;
+    if (rc == 0) rc = kc_ipc_pool_chan_open(ld->pool, kc_ipc_chan_id(c->tx), o->kind, o->elem_sz, &c->rx);
+    if (rc == 0) rc = kc_spawn_co(kc_sched_default(), consumer, c, 0, NULL) == 0 ? 0 : -ENOMEM;
+    if (rc != 0) {
+        if (c->rx) { kc_ipc_chan_destroy(c->rx); c->rx = NULL; }
+        atomic_fetch_add(&ld->bad, 1);
+        load_done(ld);              /* for the consumer that never ran */
+    }
+    atomic_fetch_add(&ld->ready, 1);
+    long t0;
+    while (!(t0 = atomic_load_explicit(&ld->t0, memory_order_acquire))) kc_sleep_ms(1);
+
+    /* Open loop: client i's sends are due at t0 + (i / N + k) * interval */
+    long due = t0 + (long)((double)ld->interval_ns * c->idx / o->clients);
+    while (rc == 0) {
+        if (ld->interval_ns) {
+            if (due >= ld->t_stop) break;
+            wait_until(due);
+        } else if ((due = now_ns()) >= ld->t_stop) {
+            break;
+        }
+        long sent = now_ns();
+        memcpy(buf, &due, sizeof(due));
+        memcpy(buf + sizeof(due), &sent, sizeof(sent));
+        if ((rc = kc_ipc_chan_send(c->tx, buf, -1)) != 0) { atomic_fetch_add(&ld->bad, 1); break; }
+        c->sent++;
+        due += ld->interval_ns;
+    }
+    if (c->tx) {
+        (void)kc_ipc_chan_close(c->tx);   /* the consumer drains, then sees KC_EPIPE */
+        kc_ipc_chan_destroy(c->tx);
+        c->tx = NULL;
+    }
+    free(buf);
+    load_done(ld);
+}
+
+struct rep_result {
+    double ns_per_op;
+    long got, sent;
+    struct kc_hist lat, svc;
+};
+
+static int run_rep(const struct opts *o, kc_ipc_pool_t *pool, struct rep_result *out)
+{
+    struct load *ld = (struct load*)calloc(1, sizeof(*ld));
+    if (ld) ld->cl = (struct client*)calloc((size_t)o->clients, sizeof(*ld->cl));
+    if (!ld || !ld->cl) { free(ld); return -ENOMEM; }
+    ld->o = o;
+    ld->pool = pool;
+    ld->interval_ns = o->rate > 0 ? (long)(1e9 * o->clients / o->rate) : 0;
+    if (o->rate > 0 && ld->interval_ns < 1) ld->interval_ns = 1;
+    atomic_store(&ld->left, 2 * o->clients);
+    int rc = 0, spawned = 0;
+    for (; spawned < o->clients; spawned++) {
+        ld->cl[spawned] = (struct client){ .ld = ld, .idx = spawned };
+        if (kc_spawn_co(kc_sched_default(), producer, &ld->cl[spawned], 0, NULL) != 0) { rc = -ENOMEM; break; }
+    }
+    if (rc != 0) atomic_fetch_sub(&ld->left, 2 * (o->clients - spawned));
+    long t_setup = now_ns();
+    while (atomic_load(&ld->ready) < spawned && now_ns() - t_setup < KCIPCLOAD_TIMEOUT_NS) usleep(1000);
+    long t0 = now_ns();
+    ld->t_stop = t0 + (long)(o->secs * 1e9);
+    atomic_store_explicit(&ld->t0, t0, memory_order_release);
+    while (atomic_load_explicit(&ld->left, memory_order_acquire) > 0) {
+        /* Clients still reference ld: leak it rather than free it under them */
+        if (now_ns() - t0 > (long)(o->secs * 1e9) + KCIPCLOAD_TIMEOUT_NS) return -ETIMEDOUT;
+        usleep(1000);
+    }
+    while (!atomic_load_explicit(&ld->t_end, memory_order_acquire)) {}
+    memset(out, 0, sizeof(*out));
+    for (int i = 0; i < o->clients; i++) {
+        out->got += ld->cl[i].got;
+        out->sent += ld->cl[i].sent;
+        hist_merge(&out->lat, &ld->cl[i].lat);
+        hist_merge(&out->svc, &ld->cl[i].svc);
+    }
+    long elapsed = atomic_load(&ld->t_end) - t0;
+    out->ns_per_op = out->got ? (double)elapsed / (double)out->got : 0.0;
+    if (!rc && atomic_load(&ld->bad)) rc = -EIO;
+    if (!rc && !out->got) rc = -ENODATA;
+    free(ld->cl);
+    free(ld);
+    return rc;
+}
+
+/* ---- Output ---- */
+
+/* Measures written per run: name suffix, unit, value of one repetition */
+enum { M_NS_PER_OP, M_P50, M_P99, M_P999, M_MAX, M_SVC_P50, M_SVC_P99, M_COUNT };
+static const char *const g_measure[M_COUNT][2] = {
+    { "ns_per_op", "ns/op" }, { "lat_p50", "ns" }, { "lat_p99", "ns" }, { "lat_p999", "ns" },
+    { "lat_max", "ns" }, { "svc_p50", "ns" }, { "svc_p99", "ns" },
+};
+
+static double measure(const struct rep_result *r, int m)
+{
+    switch (m) {
+    case M_NS_PER_OP: return r->ns_per_op;
+    case M_P50: return (double)kc_hist_quantile(&r->lat, 0.50);
+    case M_P99: return (double)kc_hist_quantile(&r->lat, 0.99);
+    case M_P999: return (double)kc_hist_quantile(&r->lat, 0.999);
+    case M_MAX: return (double)r->lat.max_ns;
+    case M_SVC_P50: return (double)kc_hist_quantile(&r->svc, 0.50);
+    default: return (double)kc_hist_quantile(&r->svc, 0.99);
+    }
+}
+
+static int write_json(FILE *f, const struct opts *o, const char *transport, const char *name,
+                       const struct rep_result *res, int reps)
+{
+    struct utsname u;
+    char ts[32];
+    time_t t = time(NULL);
+    strftime(ts, sizeof(ts), "%Y-%m-%dT%H:%M:%SZ", gmtime(&t));
+    if (uname(&u) != 0) strcpy(u.machine, "unknown");
+    long ops = 0;
+    for (int k = 0; k < reps; k++) ops += res[k].got;
+    fprintf(f, "{\n  \"schema\": \"%s\",\n  \"tool\": \"kcipcload\",\n", KCBENCH_SCHEMA);
+    fprintf(f, "  \"machine\": \"%s\",\n  \"cpus\": %ld,\n  \"timestamp\": \"%s\",\n", u.machine, sysconf(_SC_NPROCESSORS_ONLN), ts);
+    fprintf(f, "  \"reps\": %d,\n  \"warmup\": %d,\n  \"scale\": 1,\n", reps, o->warmup);
+    fprintf(f, "  \"config\": {\"transport\": \"%s\", \"server\": \"%s\", \"clients\": %d, \"conns\": %d, "
+               "\"kind\": \"%s\", \"elem_sz\": %zu, \"capacity\": %zu, \"window\": %zu, \"rate\": %.0f, \"seconds\": %g},\n",
+            transport, o->addr && !o->serve ? "external" : "in-process", o->clients, o->conns,
+            kind_name(o->kind), o->elem_sz, o->capacity, o->window, o->rate, o->secs);
+    fprintf(f, "  \"results\": [\n");
+    double *v = (double*)malloc((size_t)reps * sizeof(double));
+    if (!v) return -ENOMEM;
+    for (int m = 0; m < M_COUNT; m++) {
+        struct bench_stats st;
+        for (int k = 0; k < reps; k++) v[k] = measure(&res[k], m);
+        compute_stats(v, reps, &st);
+        fprintf(f, "%s    {\"name\": \"%s.%s\", \"unit\": \"%s\", \"ops\": %ld, \"reps\": %d, "
+                   "\"mean\": %.3f, \"median\": %.3f, \"stddev\": %.3f, \"ci95_lo\": %.3f, \"ci95_hi\": %.3f, "
+                   "\"min\": %.3f, \"max\": %.3f, \"samples\": [",
+                m ? ",\n" : "", name, g_measure[m][0], g_measure[m][1], ops, reps, st.mean, st.median,
+                st.stddev, st.ci_lo, st.ci_hi, st.min, st.max);
+        for (int k = 0; k < reps; k++) fprintf(f, "%s%.3f", k ? ", " : "", v[k]);
+        fprintf(f, "]}");
+    }
+    fprintf(f, "\n  ]\n}\n");
+    free(v);
+    return 0;
+}
+
+static void print_rep(const char *tag, const struct rep_result *r, double secs)
+{
+    printf("%-8s %10ld %12.0f %10.1f %10lu %10lu %10lu %10lu %10lu\n", tag, r->got, r->got / secs, r->ns_per_op,
+           kc_hist_quantile(&r->lat, 0.50), kc_hist_quantile(&r->lat, 0.99), kc_hist_quantile(&r->lat, 0.999),
+           r->lat.max_ns, kc_hist_quantile(&r->svc, 0.99));
+}
+
+/* ---- Setup ---- */
+
+/* "unix:PATH" or "tcp:HOST:PORT" */
+static int parse_addr(const char *addr, char *host, size_t hn, const char **port_or_path)
+{
+    if (strncmp(addr, "unix:", 5) == 0) { *port_or_path = addr + 5; host[0] = '\0'; return 0; }
+    if (strncmp(addr, "tcp:", 4) != 0) return -EINVAL;
+    const char *colon = strrchr(addr + 4, ':');
+    if (!colon || (size_t)(colon - (addr + 4)) >= hn) return -EINVAL;
+    memcpy(host, addr + 4, (size_t)(colon - (addr + 4)));
+    host[colon - (addr + 4)] = '\0';
+    *port_or_path = colon + 1;
+    return 1;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [-c clients] [-m conns] [-k kind] [-s elem_sz] [-C capacity] [-W window]\n"
+            "          [-R rate] [-d seconds] [-r reps] [-w warmup] [-a addr [-S]] [-n name] [-o out.json]\n"
+            "  -c  client producer/consumer pairs, one channel each (default 16)\n"
+            "  -m  connections, shared by the clients (default 4)\n"
+            "  -k  channel kind: buffered, rendezvous or unlimited (default buffered)\n"
+            "  -s  element bytes, at least %zu (default 64)\n"
+            "  -C  channel capacity (default 64)\n"
+            "  -W  requests in flight per connection (default KCORO_IPC_WINDOW)\n"
+            "  -R  open loop at this many elements per second in total; 0 = closed loop\n"
+            "  -d  seconds per repetition (default 2)\n"
+            "  -r  measured repetitions (default 3)\n"
+            "  -w  warmup repetitions, not recorded (default 1)\n"
+            "  -a  server address, unix:PATH or tcp:HOST:PORT (default: in-process, Unix socket)\n"
+            "  -S  serve -a in-process instead of connecting to an external server\n"
+            "  -n  result name prefix (default ipc.load.<kind>.<elem_sz>.<clients>x<conns>[.r<rate>])\n"
+            "  -o  write results as kcoro-bench-1 JSON\n",
+            prog, STAMP_BYTES);
+}
+
+int main(int argc, char **argv)
+{
+    struct opts o = { .clients = 16, .conns = 4, .kind = KC_BUFFERED, .reps = 3, .warmup = 1,
+                      .elem_sz = 64, .capacity = 64, .secs = 2.0 };
+    int opt, kind_ok = 1;
+    while ((opt = getopt(argc, argv, "c:m:k:s:C:W:R:d:r:w:a:Sn:o:h")) != -1) {
+        switch (opt) {
+        case 'c': o.clients = atoi(optarg); break;
+        case 'm': o.conns = atoi(optarg); break;
+        case 'k': {
+            kind_ok = 0;
+            for (size_t i = 0; i < sizeof(g_kinds) / sizeof(g_kinds[0]); i++)
+                if (strcmp(optarg, g_kinds[i].name) == 0) { o.kind = g_kinds[i].kind; kind_ok = 1; }
+            break;
+        }
+        case 's': o.elem_sz = (size_t)strtoul(optarg, NULL, 10); break;
+        case 'C': o.capacity = (size_t)strtoul(optarg, NULL, 10); break;
+        case 'W': o.window = (size_t)strtoul(optarg, NULL, 10); break;
+        case 'R': o.rate = atof(optarg); break;
+        case 'd': o.secs = atof(optarg); break;
+        case 'r': o.reps = atoi(optarg); break;
+        case 'w': o.warmup = atoi(optarg); break;
+        case 'a': o.addr = optarg; break;
+        case 'S': o.serve = 1; break;
+        case 'n': o.name = optarg; break;
+        case 'o': o.out = optarg; break;
+        case 'h': default: usage(argv[0]); return 2;
+        }
+    }
+    if (o.clients < 1 || o.conns < 1 || !kind_ok || o.elem_sz < STAMP_BYTES || o.rate < 0 ||
+        o.secs <= 0 || o.reps < 1 || o.warmup < 0 || (o.serve && !o.addr)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    char host[256], path[108];
+    const char *where = NULL;
+    int tcp = 0;
+    if (o.addr) {
+        if ((tcp = parse_addr(o.addr, host, sizeof(host), &where)) < 0) { usage(argv[0]); return 2; }
+    } else {
+        snprintf(path, sizeof(path), "/tmp/kcipcload.%ld.sock", (long)getpid());
+        where = path;
+        o.serve = 1;
+    }
+
+    kc_ipc_server_t *lis = NULL;
+    kc_ipc_server_ctx_t *ctx = NULL;
+    kc_ipc_acceptor_t *acc = NULL;
+    if (o.serve) {
+        if (!tcp) unlink(where);
+        int rc = tcp ? kc_ipc_srv_listen_tcp(host, where, &lis) : kc_ipc_srv_listen(where, &lis);
+        if (rc == 0 && !(ctx = kc_ipc_server_ctx_create())) rc = -ENOMEM;
+        if (rc == 0) rc = kc_ipc_server_start(ctx, &lis, 1, NULL, &acc);
+        if (rc != 0) { fprintf(stderr, "kcipcload: cannot serve %s: %s\n", where, strerror(-rc)); return 2; }
+    }
+
+    kc_ipc_conn_t **conns = (kc_ipc_conn_t**)calloc((size_t)o.conns, sizeof(*conns));
+    kc_ipc_pool_t *pool = NULL;
+    int rc = conns ? 0 : -ENOMEM;
+    for (int i = 0; i < o.conns && rc == 0; i++) {
+        uint32_t maj, min;
+        rc = tcp ? kc_ipc_connect_tcp(host, where, &conns[i]) : kc_ipc_connect(where, &conns[i]);
+        if (rc == 0) rc = kc_ipc_hs_cli(conns[i], &maj, &min);
+    }
+    if (rc == 0) rc = kc_ipc_pool_create(conns, (size_t)o.conns, NULL, o.window, &pool);
+    if (rc != 0) {
+        fprintf(stderr, "kcipcload: cannot connect to %s: %s\n", where, strerror(-rc));
+        for (int i = 0; conns && i < o.conns; i++) if (conns[i]) kc_ipc_conn_close(conns[i]);
+        return 2;
+    }
+
+    char name[64];
+    if (o.name) snprintf(name, sizeof(name), "%s", o.name);
+    else if (o.rate > 0) snprintf(name, sizeof(name), "ipc.load.%s.%zu.%dx%d.r%.0f", kind_name(o.kind), o.elem_sz, o.clients, o.conns, o.rate);
+    else snprintf(name, sizeof(name), "ipc.load.%s.%zu.%dx%d", kind_name(o.kind), o.elem_sz, o.clients, o.conns);
+
+    printf("%s: %s %s, %d clients over %d connections, %s loop", name, tcp ? "tcp" : "unix", where,
+           o.clients, o.conns, o.rate > 0 ? "open" : "closed");
+    if (o.rate > 0) printf(" at %.0f/s", o.rate);
+    printf("\n%-8s %10s %12s %10s %10s %10s %10s %10s %10s\n", "rep", "elements", "per sec", "ns/op",
+           "lat p50", "lat p99", "lat p999", "lat max", "svc p99");
+
+    struct rep_result *res = (struct rep_result*)calloc((size_t)o.reps, sizeof(*res));
+    struct rep_result all = { 0 };
+    int failed = res ? 0 : ENOMEM;
+    for (int k = -o.warmup; k < o.reps && !failed; k++) {
+        struct rep_result r;
+        int rrc = run_rep(&o, pool, &r);
+        if (rrc != 0) { fprintf(stderr, "kcipcload: repetition failed: %s\n", strerror(-rrc)); failed = -rrc; break; }
+        char tag[16];
+        snprintf(tag, sizeof(tag), k < 0 ? "warmup" : "%d", k);
+        print_rep(tag, &r, o.secs);
+        if (o.rate > 0 && r.sent < (long)(0.9 * o.rate * o.secs))
+            printf("         sent only %ld of %.0f scheduled: the generator fell behind\n", r.sent, o.rate * o.secs);
+        if (k < 0) continue;
+        res[k] = r;
+        all.got += r.got;
+        hist_merge(&all.lat, &r.lat);
+        hist_merge(&all.svc, &r.svc);
+    }
+    if (!failed) {
+        double ns = 0;
+        for (int k = 0; k < o.reps; k++) ns += res[k].ns_per_op;
+        all.ns_per_op = ns / o.reps;
+        print_rep("all", &all, o.secs * o.reps);
+        if (o.out) {
+            FILE *f = strcmp(o.out, "-") == 0 ? stdout : fopen(o.out, "w");
+            if (!f) { fprintf(stderr, "kcipcload: %s: %s\n", o.out, strerror(errno)); failed = errno; }
+            else {
+                if (write_json(f, &o, tcp ? "tcp" : "unix", name, res, o.reps) != 0) failed = ENOMEM;
+                if (f != stdout) fclose(f);
+            }
+        }
+    }
+
+    if (failed != ETIMEDOUT) kc_ipc_pool_destroy(pool);   /* timed-out clients may still hold handles */
+    free(conns);
+    free(res);
+    if (acc) {
+        kc_ipc_server_stop(acc);
+        kc_ipc_srv_close(lis);
+        if (!tcp) unlink(where);
+        /* ctx stays: served connections may still be winding down */
+    }
+    return failed ? 2 : 0;
+}
@@ -0,0 +1,559 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/*
+ * kcreplay — replay recorded channel traffic
+ * ------------------------------------------
+ *
+ * Plays a kc_chan_rec_start file back against fresh channels and a
+ * scheduler of your choosing, so a runtime change can be judged on the
+ * arrival process a real service produced rather than a synthetic one.
+ *
+ * Every recorded coroutine (and every plain thread, which replays as a
+ * coroutine) becomes one player that issues its ops in recorded order, each
+ * at its recorded offset from the start divided by -x. Ops keep their kind,
+ * element count and size: a try stays a try, a batch stays a batch, an op
+ * that timed out gets its recorded wait as timeout, and closes happen where
+ * they happened. Channels are rebuilt from their descriptors (kind,
+ * capacity, element size, ring or pointer flavour) unless -k, -C or -s
+ * override them. A player that falls behind issues at once, so the lateness
+ * stays visible instead of thinning the load.
+ *
+ * Latency counts from the op's due time (the coordinated omission
+ * correction, as in kcipcload); service time from the actual issue. Once
+ * the recorded span plus -t has passed, every channel is closed so players
+ * blocked on traffic the replay did not reproduce finish with KC_EPIPE.
+ * An op that ends differently from its recording counts as failed.
+ *
+ *   kcreplay -i rec.bin [-k kind] [-C capacity] [-s elem_sz] [-W workers]
+ *            [-T slice_us] [-x speed] [-t grace_ms] [-r reps] [-w warmup]
+ *            [-n name] [-o out.json]
+ */
+#define _GNU_SOURCE 1
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/utsname.h>
+
+#include "../include/kcoro.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_port.h"
+#include "kcbench_stats.h"
+
+#define KCREPLAY_TIMEOUT_NS (60L * 1000000000L)
+#define KIND_RECORDED INT32_MIN   /* -k not given */
+#define KIND_MPMC (INT32_MIN + 1)
+
+static long now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+struct opts {
+    int kind, workers, slice_us, reps, warmup;
+    size_t capacity, elem_sz;       /* 0: as recorded */
+    double speed;                   /* 0: back to back */
+    long grace_ms;
+    const char *in, *name, *out;
+};
+
+static const struct { const char *name; int kind; } g_kinds[] = {
+    { "recorded", KIND_RECORDED }, { "buffered", KC_BUFFERED }, { "rendezvous", KC_RENDEZVOUS },
+    { "unlimited", KC_UNLIMITED }, { "conflated", KC_CONFLATED }, { "mpmc", KIND_MPMC },
+};
+
+static const char *kind_name(int kind)
+{
+    for (size_t i = 0; i < sizeof(g_kinds) / sizeof(g_kinds[0]); i++)
+        if (g_kinds[i].kind == kind) return g_kinds[i].name;
+    return "?";
+}
+
+/* ---- Histograms: kc_hist buckets, filled by one player each ---- */
+
+static void hist_add(struct kc_hist *h, long ns)
+{
+    unsigned long v = ns > 0 ? (unsigned long)ns : 0;
+    if (!h->count || v < h->min_ns) h->min_ns = v;
+    if (v > h->max_ns) h->max_ns = v;
+    h->count++;
+    h->sum_ns += v;
+    h->buckets[kc_hist_bucket(v)]++;
+}
+
+static void hist_merge(struct kc_hist *dst, const struct kc_hist *src)
+{
+    if (!src->count) return;
+    if (!dst->count || src->min_ns < dst->min_ns) dst->min_ns = src->min_ns;
+    if (src->max_ns > dst->max_ns) dst->max_ns = src->max_ns;
+    dst->count += src->count;
+    dst->sum_ns += src->sum_ns;
+    for (int i = 0; i < KC_HIST_BUCKETS; i++) dst->buckets[i] += src->buckets[i];
+}
+
+/* ---- The recording ---- */
+
+struct trace {
+    struct kc_chan_rec *chans;      /* descriptor by channel number; op 0 when none */
+    uint32_t nchans;                /* highest channel number + 1 */
+    struct kc_chan_rec *ops;        /* sorted by player, then issue time */
+    size_t nops;
+    struct stream { size_t first, n; } *streams;
+    size_t nstreams;
+    uint64_t span_ns;               /* last issue time */
+    size_t max_bytes;               /* largest op payload */
+    struct kc_hist rec_svc;         /* recorded issue-to-return */
+};
+
+/* Player key: the coroutine, or the thread for ops made outside one */
+static uint64_t op_player(const struct kc_chan_rec *r)
+{
+    return r->co ? r->co : (1ull << 32) | r->thread;
+}
+
+static int op_cmp(const void *a, const void *b)
+{
+    const struct kc_chan_rec *x = (const struct kc_chan_rec*)a, *y = (const struct kc_chan_rec*)b;
+    uint64_t px = op_player(x), py = op_player(y);
+    if (px != py) return px < py ? -1 : 1;
+    return x->t_ns < y->t_ns ? -1 : x->t_ns > y->t_ns;
+}
+
+static int trace_load(const char *path, struct trace *t)
+{
+    memset(t, 0, sizeof(*t));
+    FILE *f = fopen(path, "rb");
+    if (!f) return -errno;
+    struct kc_chan_rec_header h;
+    int rc = 0;
+    if (fread(&h, sizeof(h), 1, f) != 1 || memcmp(h.magic, KC_CHAN_REC_MAGIC, sizeof(KC_CHAN_REC_MAGIC)) != 0 ||
+        h.version != KC_CHAN_REC_VERSION || h.rec_size != sizeof(struct kc_chan_rec))
+        rc = -EPROTO;
+    size_t cap = 0;
+    struct kc_chan_rec r;
+    while (rc == 0 && fread(&r, sizeof(r), 1, f) == 1) {
+        if (r.op == KC_CHAN_REC_THREAD) continue;
+        if (r.op == KC_CHAN_REC_CHAN) {
+            if (r.chan >= t->nchans) {
+                uint32_t n = r.chan + 1 > 2 * t->nchans ? r.chan + 1 : 2 * t->nchans;
+                struct kc_chan_rec *c = (struct kc_chan_rec*)realloc(t->chans, n * sizeof(*c));
+                if (!c) { rc = -ENOMEM; break; }
+                memset(c + t->nchans, 0, (n - t->nchans) * sizeof(*c));
+                t->chans = c;
+                t->nchans = n;
+            }
+            t->chans[r.chan] = r;
+            continue;
+        }
+        if (r.op < KC_CHAN_REC_SEND || r.op > KC_CHAN_REC_CLOSE) continue;
+        if (t->nops == cap) {
+            cap = cap ? 2 * cap : 4096;
+            struct kc_chan_rec *o = (struct kc_chan_rec*)realloc(t->ops, cap * sizeof(*o));
+            if (!o) { rc = -ENOMEM; break; }
+            t->ops = o;
+        }
+        t->ops[t->nops++] = r;
+    }
+    fclose(f);
+    if (rc != 0) return rc;
+    /* Ops whose descriptor is missing (a write error cut the file) are dropped */
+    size_t k = 0;
+    for (size_t i = 0; i < t->nops; i++) {
+        const struct kc_chan_rec *o = &t->ops[i];
+        if (o->chan >= t->nchans || !t->chans[o->chan].op) continue;
+        t->ops[k++] = *o;
+        if (o->t_ns > t->span_ns) t->span_ns = o->t_ns;
+        if (o->bytes > t->max_bytes) t->max_bytes = o->bytes;
+        if (o->op != KC_CHAN_REC_CLOSE) hist_add(&t->rec_svc, (long)o->dur_ns);
+    }
+    t->nops = k;
+    qsort(t->ops, t->nops, sizeof(t->ops[0]), op_cmp);
+    for (size_t i = 0; i < t->nops; i++)
+        if (i == 0 || op_player(&t->ops[i]) != op_player(&t->ops[i - 1])) t->nstreams++;
+    t->streams = (struct stream*)calloc(t->nstreams ? t->nstreams : 1, sizeof(*t->streams));
+    if (!t->streams) return -ENOMEM;
+    for (size_t i = 0, s = 0; i < t->nops; i++) {
+        if (i && op_player(&t->ops[i]) != op_player(&t->ops[i - 1])) s++;
+        if (!t->streams[s].n) t->streams[s].first = i;
+        t->streams[s].n++;
+    }
+    return t->nops ? 0 : -ENODATA;
+}
+
+static void trace_free(struct trace *t)
+{
+    free(t->chans);
+    free(t->ops);
+    free(t->streams);
+}
+
+/* ---- One repetition ---- */
+
+struct replay;
+
+struct player {
+    struct replay *rp;
+    const struct stream *st;
+    struct kc_hist lag, lat, svc;   /* issue - due, return - due, return - issue */
+    long ok, failed;
+};
+
+struct replay {
+    const struct opts *o;
+    const struct trace *t;
+    kc_chan_t **chans;              /* by channel number */
+    size_t *elem_sz;                /* as built */
+    struct player *pl;
+    _Atomic int ready, left;
+    _Atomic long t0;                /* 0 until the players may start */
+    _Atomic long t_end;
+};
+
+static void replay_done(struct replay *rp)
+{
+    if (atomic_fetch_sub_explicit(&rp->left, 1, memory_order_acq_rel) == 1)
+        atomic_store_explicit(&rp->t_end, now_ns(), memory_order_release);
+}
+
+/* Sleep in whole milliseconds, waking a millisecond early for timer slack,
+ * then yield the rest. */
+static void wait_until(long due)
+{
+    for (long t = now_ns(); t < due; t = now_ns()) {
+        if (due - t >= 2000000L) kc_sleep_ms((int)((due - t) / 1000000L) - 1);
+        else kc_yield();
+    }
+}
+
+/* The wait a recorded op was allowed: none for a try or an op that found
+ * nothing to do, its duration for one that timed out, else unbounded. */
+static long op_timeout(const struct kc_chan_rec *r)
+{
+    if (r->op == KC_CHAN_REC_TRY_SEND || r->op == KC_CHAN_REC_TRY_RECV || r->rc == KC_EAGAIN) return 0;
+    if (r->rc == KC_ETIME) return r->dur_ns >= 1000000u ? (long)(r->dur_ns / 1000000u) : 1;
+    return -1;
+}
+
+static int op_issue(struct replay *rp, const struct kc_chan_rec *r, unsigned char *buf)
+{
+    kc_chan_t *c = rp->chans[r->chan];
+    size_t n = r->count ? r->count : 1, got = 0;
+    long tmo = op_timeout(r);
+    void *p;
+    switch (r->op) {
+    case KC_CHAN_REC_SEND: case KC_CHAN_REC_TRY_SEND: return kc_chan_send(c, buf, tmo);
+    case KC_CHAN_REC_RECV: case KC_CHAN_REC_TRY_RECV: return kc_chan_recv(c, buf, tmo);
+    case KC_CHAN_REC_SEND_MANY: return kc_chan_send_many(c, buf, n, tmo, &got);
+    case KC_CHAN_REC_RECV_MANY: return kc_chan_recv_many(c, buf, n, tmo, &got);
+    case KC_CHAN_REC_SEND_PTR: return kc_chan_send_ptr(c, buf, r->bytes, tmo);
+    case KC_CHAN_REC_RECV_PTR: return kc_chan_recv_ptr(c, &p, &got, tmo);
+    default: kc_chan_close(c); return 0;
+    }
+}
+
+static void player(void *arg)
+{
+    struct player *pl = (struct player*)arg;
+    struct replay *rp = pl->rp;
+    const struct trace *t = rp->t;
+    /* Pointer sends carry their recorded length; copies move count elements
+     * of the channel's (possibly overridden) size */
+    size_t need = t->max_bytes;
+    for (size_t i = 0; i < pl->st->n; i++) {
+        const struct kc_chan_rec *r = &t->ops[pl->st->first + i];
+        size_t b = (size_t)(r->count ? r->count : 1) * rp->elem_sz[r->chan];
+        if (b > need) need = b;
+    }
+    unsigned char *buf = (unsigned char*)calloc(1, need ? need : 1);
+    atomic_fetch_add(&rp->ready, 1);
+    long t0;
+    while (!(t0 = atomic_load_explicit(&rp->t0, memory_order_acquire))) kc_sleep_ms(1);
+    double speed = rp->o->speed;
+    for (size_t i = 0; buf && i < pl->st->n; i++) {
+        const struct kc_chan_rec *r = &t->ops[pl->st->first + i];
+        long due;
+        if (speed > 0) {
+            due = t0 + (long)((double)r->t_ns / speed);
+            wait_until(due);
+        } else {
+            due = now_ns();
+        }
+        long issued = now_ns();
+        int rc = op_issue(rp, r, buf);
+        long done = now_ns();
+        hist_add(&pl->lag, issued - due);
+        hist_add(&pl->lat, done - due);
+        hist_add(&pl->svc, done - issued);
+        if (rc == 0 || rc == r->rc) pl->ok++;   /* a try that found nothing, as recorded */
+        else pl->failed++;
+    }
+    if (!buf) pl->failed += (long)pl->st->n;
+    free(buf);
+    replay_done(rp);
+}
+
+/* Channel for descriptor d under the -k/-C/-s overrides. */
+static int chan_build(const struct opts *o, const struct kc_chan_rec *d, kc_chan_t **out, size_t *esz)
+{
+    int kind = o->kind == KIND_RECORDED ? d->rc : o->kind;
+    size_t cap = o->capacity ? o->capacity : d->count;
+    *esz = o->elem_sz ? o->elem_sz : d->bytes;
+    if (d->co & KC_CHAN_CAP_PTR) {
+        *esz = sizeof(struct kc_chan_ptrmsg);
+        return kc_chan_make_ptr(out, kind == KIND_MPMC ? KC_BUFFERED : kind, cap);
+    }
+    if (o->kind == KIND_RECORDED && (d->co & KC_CHAN_CAP_STRIPED))
+        return kc_chan_make_striped(out, *esz, cap, d->dur_ns);
+    if (o->kind == KIND_RECORDED && (d->co & KC_CHAN_CAP_SPSC)) return kc_chan_make_spsc(out, *esz, cap);
+    if (kind == KIND_MPMC || (o->kind == KIND_RECORDED && (d->co & KC_CHAN_CAP_MPMC)))
+        return kc_chan_make_mpmc(out, *esz, cap);
+    if (kind == KC_BUFFERED && cap == 0) cap = 64;
+    return kc_chan_make(out, kind, *esz, cap);
+}
+
+struct rep_result {
+    double ns_per_op, elapsed_ms;
+    long ok, failed;
+    struct kc_hist lag, lat, svc;
+};
+
+static int run_rep(const struct opts *o, const struct trace *t, kc_sched_t *s, struct rep_result *out)
+{
+    struct replay *rp = (struct replay*)calloc(1, sizeof(*rp));
+    if (rp) {
+        rp->chans = (kc_chan_t**)calloc(t->nchans, sizeof(*rp->chans));
+        rp->elem_sz = (size_t*)calloc(t->nchans, sizeof(*rp->elem_sz));
+        rp->pl = (struct player*)calloc(t->nstreams, sizeof(*rp->pl));
+    }
+    if (!rp || !rp->chans || !rp->elem_sz || !rp->pl) return -ENOMEM;   /* leaks on OOM, exits anyway */
+    rp->o = o;
+    rp->t = t;
+    int rc = 0;
+    for (uint32_t i = 0; i < t->nchans && rc == 0; i++)
+        if (t->chans[i].op) rc = chan_build(o, &t->chans[i], &rp->chans[i], &rp->elem_sz[i]);
+    if (rc != 0) {
+        fprintf(stderr, "kcreplay: cannot build a channel: %s\n", strerror(-rc));
+        return rc;
+    }
+    atomic_store(&rp->left, (int)t->nstreams);
+    size_t spawned = 0;
+    for (; spawned < t->nstreams; spawned++) {
+        rp->pl[spawned] = (struct player){ .rp = rp, .st = &t->streams[spawned] };
+        if (kc_spawn_co(s, player, &rp->pl[spawned], 0, NULL) != 0) { rc = -ENOMEM; break; }
+    }
+    if (rc != 0) atomic_fetch_sub(&rp->left, (int)(t->nstreams - spawned));
+    long t_setup = now_ns();
+    while ((size_t)atomic_load(&rp->ready) < spawned && now_ns() - t_setup < KCREPLAY_TIMEOUT_NS) usleep(1000);
+    long t0 = now_ns();
+    atomic_store_explicit(&rp->t0, t0, memory_order_release);
+    long span = o->speed > 0 ? (long)((double)t->span_ns / o->speed) : 0;
+    int closed = 0;
+    while (atomic_load_explicit(&rp->left, memory_order_acquire) > 0) {
+        long el = now_ns() - t0;
+        if (!closed && el > span + o->grace_ms * 1000000L) {
+            /* Unblock players waiting on traffic that never came */
+            for (uint32_t i = 0; i < t->nchans; i++) if (rp->chans[i]) kc_chan_close(rp->chans[i]);
+            closed = 1;
+        }
+        /* Players still reference rp: leak it rather than free it under them */
+        if (el > span + o->grace_ms * 1000000L + KCREPLAY_TIMEOUT_NS) return -ETIMEDOUT;
+        usleep(1000);
+    }
+    while (!atomic_load_explicit(&rp->t_end, memory_order_acquire)) {}
+    memset(out, 0, sizeof(*out));
+    for (size_t i = 0; i < t->nstreams; i++) {
+        out->ok += rp->pl[i].ok;
+        out->failed += rp->pl[i].failed;
+        hist_merge(&out->lag, &rp->pl[i].lag);
+        hist_merge(&out->lat, &rp->pl[i].lat);
+        hist_merge(&out->svc, &rp->pl[i].svc);
+    }
+    long elapsed = atomic_load(&rp->t_end) - t0;
+    out->elapsed_ms = (double)elapsed / 1e6;
+    out->ns_per_op = out->ok ? (double)elapsed / (double)out->ok : 0.0;
+    for (uint32_t i = 0; i < t->nchans; i++) if (rp->chans[i]) kc_chan_destroy(rp->chans[i]);
+    free(rp->chans);
+    free(rp->elem_sz);
+    free(rp->pl);
+    free(rp);
+    if (!rc && !out->ok) rc = -ENODATA;
+    return rc;
+}
+
+/* ---- Output ---- */
+
+/* Measures written per run: name suffix, unit, value of one repetition */
+enum { M_NS_PER_OP, M_ELAPSED, M_P50, M_P99, M_P999, M_MAX, M_SVC_P50, M_SVC_P99, M_LAG_P99, M_COUNT };
+static const char *const g_measure[M_COUNT][2] = {
+    { "ns_per_op", "ns/op" }, { "elapsed", "ms" }, { "lat_p50", "ns" }, { "lat_p99", "ns" },
+    { "lat_p999", "ns" }, { "lat_max", "ns" }, { "svc_p50", "ns" }, { "svc_p99", "ns" }, { "lag_p99", "ns" },
+};
+
+static double measure(const struct rep_result *r, int m)
+{
+    switch (m) {
+    case M_NS_PER_OP: return r->ns_per_op;
+    case M_ELAPSED: return r->elapsed_ms;
+    case M_P50: return (double)kc_hist_quantile(&r->lat, 0.50);
+    case M_P99: return (double)kc_hist_quantile(&r->lat, 0.99);
+    case M_P999: return (double)kc_hist_quantile(&r->lat, 0.999);
+    case M_MAX: return (double)r->lat.max_ns;
+    case M_SVC_P50: return (double)kc_hist_quantile(&r->svc, 0.50);
+    case M_SVC_P99: return (double)kc_hist_quantile(&r->svc, 0.99);
+    default: return (double)kc_hist_quantile(&r->lag, 0.99);
+    }
+}
+
+static int write_json(FILE *f, const struct opts *o, const struct trace *t, const char *name,
+                      const struct rep_result *res, int reps)
+{
+    struct utsname u;
+    char ts[32];
+    time_t now = time(NULL);
+    strftime(ts, sizeof(ts), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+    if (uname(&u) != 0) strcpy(u.machine, "unknown");
+    long ops = 0;
+    for (int k = 0; k < reps; k++) ops += res[k].ok;
+    fprintf(f, "{\n  \"schema\": \"%s\",\n  \"tool\": \"kcreplay\",\n", KCBENCH_SCHEMA);
+    fprintf(f, "  \"machine\": \"%s\",\n  \"cpus\": %ld,\n  \"timestamp\": \"%s\",\n", u.machine, sysconf(_SC_NPROCESSORS_ONLN), ts);
+    fprintf(f, "  \"reps\": %d,\n  \"warmup\": %d,\n  \"scale\": 1,\n", reps, o->warmup);
+    fprintf(f, "  \"config\": {\"input\": \"%s\", \"kind\": \"%s\", \"capacity\": %zu, \"elem_sz\": %zu, "
+               "\"workers\": %d, \"slice_us\": %d, \"speed\": %g, \"players\": %zu, \"ops\": %zu, \"span_ms\": %.3f},\n",
+            o->in, kind_name(o->kind), o->capacity, o->elem_sz, o->workers, o->slice_us, o->speed,
+            t->nstreams, t->nops, (double)t->span_ns / 1e6);
+    fprintf(f, "  \"results\": [\n");
+    double *v = (double*)malloc((size_t)reps * sizeof(double));
+    if (!v) return -ENOMEM;
+    for (int m = 0; m < M_COUNT; m++) {
+        struct bench_stats st;
+        for (int k = 0; k < reps; k++) v[k] = measure(&res[k], m);
+        compute_stats(v, reps, &st);
+        fprintf(f, "%s    {\"name\": \"%s.%s\", \"unit\": \"%s\", \"ops\": %ld, \"reps\": %d, "
+                   "\"mean\": %.3f, \"median\": %.3f, \"stddev\": %.3f, \"ci95_lo\": %.3f, \"ci95_hi\": %.3f, "
+                   "\"min\": %.3f, \"max\": %.3f, \"samples\": [",
+                m ? ",\n" : "", name, g_measure[m][0], g_measure[m][1], ops, reps, st.mean, st.median,
+                st.stddev, st.ci_lo, st.ci_hi, st.min, st.max);
+        for (int k = 0; k < reps; k++) fprintf(f, "%s%.3f", k ? ", " : "", v[k]);
+        fprintf(f, "]}");
+    }
+    fprintf(f, "\n  ]\n}\n");
+    free(v);
+    return 0;
+}
+
+static void print_rep(const char *tag, const struct rep_result *r)
+{
+    printf("%-8s %10ld %8ld %10.1f %10.1f %10lu %10lu %10lu %10lu %10lu %10lu\n", tag, r->ok, r->failed,
+           r->elapsed_ms, r->ns_per_op, kc_hist_quantile(&r->lat, 0.50), kc_hist_quantile(&r->lat, 0.99),
+           kc_hist_quantile(&r->lat, 0.999), r->lat.max_ns, kc_hist_quantile(&r->svc, 0.99),
+           kc_hist_quantile(&r->lag, 0.99));
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s -i rec.bin [-k kind] [-C capacity] [-s elem_sz] [-W workers] [-T slice_us]\n"
+            "          [-x speed] [-t grace_ms] [-r reps] [-w warmup] [-n name] [-o out.json]\n"
+            "  -i  recording from kc_chan_rec_start\n"
+            "  -k  build every channel as recorded, buffered, rendezvous, unlimited, conflated\n"
+            "      or mpmc (default recorded)\n"
+            "  -C  channel capacity (default: as recorded)\n"
+            "  -s  element bytes of copy channels (default: as recorded)\n"
+            "  -W  scheduler workers (default: the default scheduler)\n"
+            "  -T  coroutine time slice in us for -W (default: runtime config)\n"
+            "  -x  replay at this multiple of recorded speed; 0 = back to back (default 1)\n"
+            "  -t  ms past the recorded span before channels are closed (default 1000)\n"
+            "  -r  measured repetitions (default 3)\n"
+            "  -w  warmup repetitions, not recorded (default 1)\n"
+            "  -n  result name prefix (default replay.<kind>[.x<speed>])\n"
+            "  -o  write results as kcoro-bench-1 JSON\n",
+            prog);
+}
+
+int main(int argc, char **argv)
+{
+    struct opts o = { .kind = KIND_RECORDED, .reps = 3, .warmup = 1, .speed = 1.0, .grace_ms = 1000 };
+    int opt, kind_ok = 1;
+    while ((opt = getopt(argc, argv, "i:k:C:s:W:T:x:t:r:w:n:o:h")) != -1) {
+        switch (opt) {
+        case 'i': o.in = optarg; break;
+        case 'k': {
+            kind_ok = 0;
+            for (size_t i = 0; i < sizeof(g_kinds) / sizeof(g_kinds[0]); i++)
+                if (strcmp(optarg, g_kinds[i].name) == 0) { o.kind = g_kinds[i].kind; kind_ok = 1; }
+            break;
+        }
+        case 'C': o.capacity = (size_t)strtoul(optarg, NULL, 10); break;
+        case 's': o.elem_sz = (size_t)strtoul(optarg, NULL, 10); break;
+        case 'W': o.workers = atoi(optarg); break;
+        case 'T': o.slice_us = atoi(optarg); break;
+        case 'x': o.speed = atof(optarg); break;
+        case 't': o.grace_ms = atol(optarg); break;
+        case 'r': o.reps = atoi(optarg); break;
+        case 'w': o.warmup = atoi(optarg); break;
+        case 'n': o.name = optarg; break;
+        case 'o': o.out = optarg; break;
+        case 'h': default: usage(argv[0]); return 2;
+        }
+    }
+    if (!o.in || !kind_ok || o.workers < 0 || o.speed < 0 || o.grace_ms < 0 || o.reps < 1 || o.warmup < 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    struct trace t;
+    int rc = trace_load(o.in, &t);
+    if (rc != 0) {
+        fprintf(stderr, "kcreplay: %s: %s\n", o.in, rc == -EPROTO ? "not a channel recording" : strerror(-rc));
+        trace_free(&t);
+        return 2;
+    }
+
+    kc_sched_t *s = kc_sched_default();
+    if (o.workers) {
+        kc_sched_opts_t so = { .workers = o.workers, .slice_us = o.slice_us };
+        if (!(s = kc_sched_init(&so))) { fprintf(stderr, "kcreplay: cannot start %d workers\n", o.workers); return 2; }
+    }
+
+    char name[64];
+    if (o.name) snprintf(name, sizeof(name), "%s", o.name);
+    else if (o.speed != 1.0) snprintf(name, sizeof(name), "replay.%s.x%g", kind_name(o.kind), o.speed);
+    else snprintf(name, sizeof(name), "replay.%s", kind_name(o.kind));
+
+    uint32_t nchans = 0;
+    for (uint32_t i = 0; i < t.nchans; i++) nchans += t.chans[i].op != 0;
+    printf("%s: %s, %zu ops by %zu players on %u channels over %.1f ms; recorded svc p50 %lu p99 %lu\n",
+           name, o.in, t.nops, t.nstreams, nchans, (double)t.span_ns / 1e6,
+           kc_hist_quantile(&t.rec_svc, 0.50), kc_hist_quantile(&t.rec_svc, 0.99));
+    printf("%-8s %10s %8s %10s %10s %10s %10s %10s %10s %10s %10s\n", "rep", "ops", "failed", "ms", "ns/op",
+           "lat p50", "lat p99", "lat p999", "lat max", "svc p99", "lag p99");
+
+    struct rep_result *res = (struct rep_result*)calloc((size_t)o.reps, sizeof(*res));
+    int failed = res ? 0 : ENOMEM;
+    for (int k = -o.warmup; k < o.reps && !failed; k++) {
+        struct rep_result r;
+        int rrc = run_rep(&o, &t, s, &r);
+        if (rrc != 0) { fprintf(stderr, "kcreplay: repetition failed: %s\n", strerror(-rrc)); failed = -rrc; break; }
+        char tag[16];
+        snprintf(tag, sizeof(tag), k < 0 ? "warmup" : "%d", k);
+        print_rep(tag, &r);
+        if (k >= 0) res[k] = r;
+    }
+    if (!failed && o.out) {
+        FILE *f = strcmp(o.out, "-") == 0 ? stdout : fopen(o.out, "w");
+        if (!f) { fprintf(stderr, "kcreplay: %s: %s\n", o.out, strerror(errno)); failed = errno; }
+        else {
+            if (write_json(f, &o, &t, name, res, o.reps) != 0) failed = ENOMEM;
+            if (f != stdout) fclose(f);
+        }
+    }
+    if (o.workers && failed != ETIMEDOUT) kc_sched_shutdown(s);
+    free(res);
+    if (failed != ETIMEDOUT) trace_free(&t);   /* timed-out players may still read it */
+    return failed ? 2 : 0;
+}
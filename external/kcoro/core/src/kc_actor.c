@@ -1,19 +1,75 @@
 // SPDX-License-Identifier: BSD-3-Clause
+/*
+ * kc_actor.c — mailbox-driven actors
+ *
+ * An idle actor parks: it drains its mailbox without blocking, then waits in
+ * a select over the mailbox and a private control channel. Stop, and a
+ * trigger of the actor's cancel token (through a kc_cancel_watch), close
+ * the control channel, which wakes the select; the loop then sees the flag
+ * or the token and exits. Nothing polls, so a parked actor costs no CPU.
+ *
+ * Mailboxes in zero-copy mode refuse select registration; for those the
+ * actor falls back to timed receives of KCORO_CANCEL_SLICE_MS.
+ *
+ * A turn drains up to batch_max messages through kc_chan_recv_many (or
+ * until batch_us has passed) before yielding, so a deep mailbox costs one
+ * trip through the ready queue per batch rather than per message.
+ *
+ * Asks (kc_actor_ask, actors with an ask handler) travel on a private
+ * unlimited channel whose elements are an envelope: the reply slot pointer
+ * followed by the message. The slot is pooled per thread and keeps its
+ * envelope buffer, and the asker waits on a kc_deferred the handler's
+ * answer settles, so an ask costs one enqueue and one wake. The slot's
+ * spin flag orders the reply copy against an asker that gives up: a copy
+ * only lands while the asker still waits, and the deferred is settled
+ * under the flag, so an asker that finds it pending can abandon the slot.
+ * Asks left queued when the actor exits fail with KC_EPIPE.
+ */
 #include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
 #include <errno.h>
 #include <pthread.h>
 #include <stdatomic.h>
 
+#include <string.h>
+#include <sched.h>
+#include <stddef.h>
+
 #include "../../include/kcoro.h"
+#include "../../include/kc_deferred.h"
 #include "../../include/kcoro_port.h"
 #include "../../include/kcoro_sched.h"
+#include "../../include/kcoro_config.h"
+#include "kc_clock_internal.h"
+
+/* Envelope header on the ask channel; the message follows, aligned. */
+#define KC_ACTOR_ASK_HDR (sizeof(max_align_t))
 
+struct kc_actor_reply {
+    struct kc_actor_reply *next; /* free cache link */
+    _Atomic int refs;            /* the asker's and the envelope's */
+    atomic_flag lock;
+    int abandoned;               /* asker gave up: under lock */
+    int replied;                 /* under lock */
+    int code;                    /* the ask's result, set before settling */
+    void *buf;                   /* asker's reply buffer */
+    size_t size;                 /* reply_size */
+    kc_deferred_t *done;         /* settled once answered */
+    unsigned char *env;          /* envelope buffer, kept across reuse */
+    size_t env_cap;
+};
 struct kc_actor_state {
     kc_actor_ctx_t ctx;
-    void *buf;
+    void *buf;                 /* room for batch_max messages */
+    int many;                  /* mailbox takes kc_chan_recv_many */
     /* coroutine & scheduler */
     kcoro_t *co;
     kc_sched_t *sched;
+    /* parking: mailbox + control channel, closed to wake the actor */
+    kc_select_t *sel;
+    kc_chan_t *ctl;
+    char ctl_buf;
     /* lifecycle */
     atomic_int stop;
     int done;
@@ -22,33 +78,223 @@ struct kc_actor_state {
     const kc_cancel_t *cancel; /* optional */
     void (*on_done)(void *arg);
     void *on_done_arg;
+    /* asks: envelopes of KC_ACTOR_ASK_HDR + msg_size bytes (ctx.ask only) */
+    kc_chan_t *asks;
+    unsigned char *ask_env;
 };
 
+/* Per-thread cache of free reply slots, linked through `next`. */
+struct reply_cache { kc_actor_reply_t *head; unsigned count; };
+static __thread struct reply_cache tls_replies;
+static pthread_key_t reply_key;
+static pthread_once_t reply_once = PTHREAD_ONCE_INIT;
+
+static void reply_cache_drop(void *arg)
+{
+    (void)arg;
+    kc_actor_reply_t *r = tls_replies.head;
+    while (r) { kc_actor_reply_t *n = r->next; free(r->env); free(r); r = n; }
+    tls_replies.head = NULL;
+    tls_replies.count = 0;
+}
+
+static void reply_key_init(void)
+{
+    (void)pthread_key_create(&reply_key, reply_cache_drop);
+}
+
+static kc_actor_reply_t *reply_alloc(size_t env_size)
+{
+    kc_actor_reply_t *r = tls_replies.head;
+    if (r) {
+        tls_replies.head = r->next;
+        tls_replies.count--;
+    } else if (!(r = (kc_actor_reply_t*)calloc(1, sizeof(*r)))) {
+        return NULL;
+    }
+    if (r->env_cap < env_size) {
+        unsigned char *env = (unsigned char*)realloc(r->env, env_size);
+        if (!env) { free(r->env); free(r); return NULL; }
+        r->env = env;
+        r->env_cap = env_size;
+    }
+    if (kc_deferred_create(&r->done) != 0) { free(r->env); free(r); return NULL; }
+    atomic_init(&r->refs, 2);
+    atomic_flag_clear(&r->lock);
+    r->abandoned = 0;
+    r->replied = 0;
+    r->code = 0;
+    return r;
+}
+
+static void reply_release(kc_actor_reply_t *r)
+{
+    if (atomic_fetch_sub_explicit(&r->refs, 1, memory_order_acq_rel) != 1) return;
+    kc_deferred_release(r->done);
+    r->done = NULL;
+    if (tls_replies.count >= KCORO_ACTOR_REPLY_CACHE_PER_THREAD) { free(r->env); free(r); return; }
+    if (!tls_replies.head) {
+        /* First slot cached on this thread: free the cache at exit. */
+        pthread_once(&reply_once, reply_key_init);
+        (void)pthread_setspecific(reply_key, &tls_replies);
+    }
+    r->next = tls_replies.head;
+    tls_replies.head = r;
+    tls_replies.count++;
+}
+
+static void reply_lock(kc_actor_reply_t *r)
+{
+    while (atomic_flag_test_and_set_explicit(&r->lock, memory_order_acquire)) sched_yield();
+}
+
+static void reply_unlock(kc_actor_reply_t *r)
+{
+    atomic_flag_clear_explicit(&r->lock, memory_order_release);
+}
+
+int kc_actor_reply(kc_actor_reply_t *r, const void *data)
+{
+    if (!r || (r->size && !data)) return -EINVAL;
+    reply_lock(r);
+    if (r->replied) { reply_unlock(r); return -EALREADY; }
+    r->replied = 1;
+    if (!r->abandoned && r->buf && r->size) memcpy(r->buf, data, r->size);
+    reply_unlock(r);
+    return 0;
+}
+
+/* Settle an ask and drop the envelope's reference. */
+static void reply_finish(kc_actor_reply_t *r, int rc)
+{
+    reply_lock(r);
+    r->code = rc < 0 ? rc : (r->replied ? 0 : -ENOMSG);
+    (void)kc_deferred_complete(r->done, NULL);
+    reply_unlock(r);
+    reply_release(r);
+}
+
+static kc_actor_reply_t *ask_slot(const unsigned char *env)
+{
+    kc_actor_reply_t *r;
+    memcpy(&r, env, sizeof(r));
+    return r;
+}
+
+/* Run the handler on the envelope in st->ask_env. */
+static void kc_actor_serve(struct kc_actor_state *st)
+{
+    kc_actor_reply_t *r = ask_slot(st->ask_env);
+    int rc = st->ctx.ask(st->ask_env + KC_ACTOR_ASK_HDR, r, st->ctx.user);
+    reply_finish(r, rc);
+}
+
+/* Serve one queued ask without blocking; 1 if there was one. */
+static int kc_actor_take_ask(struct kc_actor_state *st)
+{
+    if (!st->asks || kc_chan_recv(st->asks, st->ask_env, 0) != 0) return 0;
+    kc_actor_serve(st);
+    return 1;
+}
+
+static void kc_actor_wake(void *arg)
+{
+    struct kc_actor_state *st = (struct kc_actor_state*)arg;
+    kc_chan_close(st->ctl);
+}
+
+static int kc_actor_should_exit(struct kc_actor_state *st)
+{
+    return atomic_load(&st->stop) || (st->cancel && kc_cancel_is_set(st->cancel));
+}
+
+static long kc_actor_now_ns(void)
+{
+    return (long)kc_clock_ns();
+}
+
+static void kc_actor_deliver(struct kc_actor_state *st, size_t n)
+{
+    if (st->ctx.process_batch) {
+        st->ctx.process_batch(st->buf, n, st->ctx.user);
+        return;
+    }
+    if (!st->ctx.process) return;
+    const unsigned char *m = (const unsigned char*)st->buf;
+    for (size_t i = 0; i < n; i++) st->ctx.process(m + i * st->ctx.msg_size, st->ctx.user);
+}
+
+/* Up to max messages into buf without blocking. */
+static int kc_actor_take(struct kc_actor_state *st, size_t max, size_t *got)
+{
+    *got = 0;
+    if (max > 1 && st->many) {
+        int rc = kc_chan_recv_many(st->ctx.chan, st->buf, max, 0, got);
+        if (rc != -EINVAL) return rc;
+        st->many = 0; /* pointer/zero-copy mailbox: one at a time */
+    }
+    int rc = kc_chan_recv(st->ctx.chan, st->buf, 0);
+    if (rc == 0) *got = 1;
+    return rc;
+}
+
 static void kc_actor_coro(void *arg)
 {
     struct kc_actor_state *st = (struct kc_actor_state*)arg;
+    size_t cap = st->ctx.batch_max ? st->ctx.batch_max : 1;
+    long budget_ns = st->ctx.batch_us > 0 ? st->ctx.batch_us * 1000L : 0;
+    int parkable = 1;
     for (;;) {
-        if (atomic_load(&st->stop)) break;
-        if (st->cancel && kc_cancel_is_set(st->cancel)) break;
+        if (kc_actor_should_exit(st)) break;
 
-        /* Non-blocking receive loop with cooperative yield */
+        /* One turn: drain up to the batch budget without blocking */
+        size_t done = 0;
+        long t0 = budget_ns ? kc_actor_now_ns() : 0;
         int rc = 0;
-        if (st->cancel)
-            rc = kc_chan_recv_c(st->ctx.chan, st->buf, 0, st->cancel);
-        else
-            rc = kc_chan_recv(st->ctx.chan, st->buf, 0);
-
-        if (rc == 0) {
-            if (st->ctx.process) st->ctx.process(st->buf, st->ctx.user);
+        while (done < cap) {
+            size_t got = 0;
+            rc = kc_actor_take(st, cap - done, &got);
+            if (rc == 0) {
+                kc_actor_deliver(st, got);
+                done += got;
+            }
+            int asked = kc_actor_take_ask(st);
+            done += (size_t)asked;
+            if (rc != 0 && !asked) break;
+            if (kc_actor_should_exit(st)) break;
+            if (budget_ns && kc_actor_now_ns() - t0 >= budget_ns) break;
+        }
+        if (done) {
             /* Yield to let others run */
             kcoro_yield();
             continue;
         }
-        if (rc == KC_EPIPE || rc == KC_ECANCELED) {
-            break;
+
+        if (rc == KC_EAGAIN) {
+            if (parkable) {
+                /* Park until a message, close, stop or cancel */
+                int idx = -1, op = 0;
+                (void)kc_select_wait(st->sel, -1, &idx, &op);
+                if (idx == 1) continue;       /* woken through ctl */
+                if (idx == 2) {               /* an ask */
+                    if (op == 0) kc_actor_serve(st);
+                    continue;
+                }
+                if (idx == 0 && op == -ENOTSUP) { parkable = 0; continue; }
+                rc = (idx == 0) ? op : KC_EAGAIN;
+            } else {
+                rc = kc_chan_recv(st->ctx.chan, st->buf, KCORO_CANCEL_SLICE_MS);
+            }
+            /* The waking message opens the next turn */
+            if (rc == 0) { kc_actor_deliver(st, 1); continue; }
         }
-        /* EAGAIN or ETIME: yield and retry */
-        kcoro_yield();
+        if (rc == KC_EPIPE || rc == KC_ECANCELED) break;
+        /* EAGAIN or ETIME: check the flags and retry */
+    }
+    if (st->asks) {
+        /* Later asks see KC_EPIPE from the channel; fail the queued ones. */
+        kc_chan_close(st->asks);
+        while (kc_chan_recv(st->asks, st->ask_env, 0) == 0) reply_finish(ask_slot(st->ask_env), KC_EPIPE);
     }
     KC_MUTEX_LOCK(&st->mu);
     st->done = 1;
@@ -61,12 +307,25 @@ static void kc_actor_coro(void *arg)
     if (cb) cb(cb_arg);
 }
 
-kc_actor_t kc_actor_start(const kc_actor_ctx_t *ctx)
+static void kc_actor_free(struct kc_actor_state *st)
+{
+    if (st->cancel) kc_cancel_unwatch((kc_cancel_t*)st->cancel, kc_actor_wake, st);
+    if (st->sel) kc_select_destroy(st->sel);
+    if (st->ctl) kc_chan_destroy(st->ctl);
+    if (st->asks) kc_chan_destroy(st->asks);
+    free(st->ask_env);
+    free(st->buf);
+    KC_COND_DESTROY(&st->cv);
+    KC_MUTEX_DESTROY(&st->mu);
+    free(st);
+}
+
+static kc_actor_t kc_actor_spawn(const kc_actor_ctx_t *ctx, const kc_cancel_t *cancel)
 {
     if (!ctx || !ctx->chan || !ctx->msg_size) return NULL;
     struct kc_actor_state *st = calloc(1, sizeof(*st));
     if (!st) return NULL;
-    
+
     st->ctx = *ctx;
     atomic_store(&st->stop, 0);
     st->cancel = NULL;
@@ -76,27 +335,51 @@ kc_actor_t kc_actor_start(const kc_actor_ctx_t *ctx)
     st->sched = kc_sched_default();
     if (KC_MUTEX_INIT(&st->mu) != 0) { free(st); return NULL; }
     if (KC_COND_INIT(&st->cv) != 0) { KC_MUTEX_DESTROY(&st->mu); free(st); return NULL; }
-    
-    st->buf = malloc(ctx->msg_size);
-    if (!st->buf) { KC_COND_DESTROY(&st->cv); KC_MUTEX_DESTROY(&st->mu); free(st); return NULL; }
+
+    size_t cap = ctx->batch_max ? ctx->batch_max : 1;
+    if (cap > SIZE_MAX / ctx->msg_size) { KC_COND_DESTROY(&st->cv); KC_MUTEX_DESTROY(&st->mu); free(st); return NULL; }
+    st->many = 1;
+    st->buf = malloc(cap * ctx->msg_size);
+    if (!st->buf ||
+        kc_chan_make(&st->ctl, KC_BUFFERED, 1, 1) != 0 ||
+        kc_select_create(&st->sel, NULL) != 0 ||
+        kc_select_add_recv(st->sel, ctx->chan, st->buf) != 0 ||
+        kc_select_add_recv(st->sel, st->ctl, &st->ctl_buf) != 0) {
+        kc_actor_free(st);
+        return NULL;
+    }
+    if (ctx->ask) {
+        size_t env = KC_ACTOR_ASK_HDR + ctx->msg_size;
+        if (!(st->ask_env = malloc(env)) ||
+            kc_chan_make(&st->asks, KC_UNLIMITED, env, 0) != 0 ||
+            kc_select_add_recv(st->sel, st->asks, st->ask_env) != 0) {
+            kc_actor_free(st);
+            return NULL;
+        }
+    }
+    /* Watch before spawning so a trigger can never fall between the two */
+    if (cancel) {
+        if (kc_cancel_watch((kc_cancel_t*)cancel, kc_actor_wake, st) != 0) { kc_actor_free(st); return NULL; }
+        st->cancel = cancel;
+    }
 
     if (kc_spawn_co(st->sched, kc_actor_coro, st, 0, &st->co) != 0) {
-        free(st->buf);
-        KC_COND_DESTROY(&st->cv);
-        KC_MUTEX_DESTROY(&st->mu);
-        free(st);
+        kc_actor_free(st);
         return NULL;
     }
     return (kc_actor_t)st;
 }
 
-void kc_actor_stop(kc_actor_t actor)
+kc_actor_t kc_actor_start(const kc_actor_ctx_t *ctx)
 {
-    struct kc_actor_state *st = (struct kc_actor_state*)actor;
-    if (!st) return;
+    return kc_actor_spawn(ctx, NULL);
+}
 
+/* Wake the actor, wait for it to finish, run a pending on_done, free. */
+static void kc_actor_join(struct kc_actor_state *st)
+{
     atomic_store(&st->stop, 1);
-    /* Wait for coroutine to finish */
+    kc_actor_wake(st);
     KC_MUTEX_LOCK(&st->mu);
     while (!st->done) { KC_COND_WAIT(&st->cv, &st->mu); }
     void (*cb)(void*) = st->on_done;
@@ -105,21 +388,20 @@ void kc_actor_stop(kc_actor_t actor)
     st->on_done_arg = NULL;
     KC_MUTEX_UNLOCK(&st->mu);
     if (cb) cb(cb_arg);
+    kc_actor_free(st);
+}
 
-    free(st->buf);
-    KC_COND_DESTROY(&st->cv);
-    KC_MUTEX_DESTROY(&st->mu);
-    free(st);
+void kc_actor_stop(kc_actor_t actor)
+{
+    struct kc_actor_state *st = (struct kc_actor_state*)actor;
+    if (!st) return;
+    kc_actor_join(st);
 }
 
 kc_actor_t kc_actor_start_ex(const kc_actor_ctx_ex_t *ctx)
 {
     if (!ctx) return NULL;
-    kc_actor_t a = kc_actor_start(&ctx->base);
-    if (!a) return NULL;
-    struct kc_actor_state *st = (struct kc_actor_state*)a;
-    st->cancel = ctx->cancel;
-    return a;
+    return kc_actor_spawn(&ctx->base, ctx->cancel);
 }
 
 void kc_actor_cancel(kc_actor_t actor)
@@ -127,19 +409,7 @@ void kc_actor_cancel(kc_actor_t actor)
     struct kc_actor_state *st = (struct kc_actor_state*)actor;
     if (!st) return;
     if (st->cancel) kc_cancel_trigger((kc_cancel_t*)st->cancel);
-    atomic_store(&st->stop, 1);
-    KC_MUTEX_LOCK(&st->mu);
-    while (!st->done) { KC_COND_WAIT(&st->cv, &st->mu); }
-    void (*cb)(void*) = st->on_done;
-    void *cb_arg = st->on_done_arg;
-    st->on_done = NULL;
-    st->on_done_arg = NULL;
-    KC_MUTEX_UNLOCK(&st->mu);
-    if (cb) cb(cb_arg);
-    free(st->buf);
-    KC_COND_DESTROY(&st->cv);
-    KC_MUTEX_DESTROY(&st->mu);
-    free(st);
+    kc_actor_join(st);
 }
 
 void kc_actor_on_done(kc_actor_t actor, void (*cb)(void *), void *arg)
@@ -157,3 +427,38 @@ void kc_actor_on_done(kc_actor_t actor, void (*cb)(void *), void *arg)
     st->on_done_arg = arg;
     KC_MUTEX_UNLOCK(&st->mu);
 }
+
+int kc_actor_ask(kc_actor_t actor, const void *msg, void *reply_buf, long timeout_ms)
+{
+    struct kc_actor_state *st = (struct kc_actor_state*)actor;
+    if (!st || !msg) return -EINVAL;
+    if (!st->asks) return -ENOTSUP;
+    if (st->ctx.reply_size && !reply_buf) return -EINVAL;
+    kc_actor_reply_t *r = reply_alloc(KC_ACTOR_ASK_HDR + st->ctx.msg_size);
+    if (!r) return -ENOMEM;
+    r->buf = reply_buf;
+    r->size = st->ctx.reply_size;
+    memcpy(r->env, &r, sizeof(r));
+    memcpy(r->env + KC_ACTOR_ASK_HDR, msg, st->ctx.msg_size);
+    /* Unlimited: never waits, from a thread or a coroutine. */
+    int rc = kc_chan_send(st->asks, r->env, 0);
+    if (rc != 0) {
+        reply_release(r); /* the envelope's, never queued */
+        reply_release(r);
+        return rc;
+    }
+    rc = kc_await(r->done, timeout_ms, NULL);
+    if (rc != 0) {
+        reply_lock(r);
+        if (kc_deferred_state(r->done) == KC_DEFERRED_PENDING) {
+            r->abandoned = 1; /* any later reply is dropped */
+            reply_unlock(r);
+            reply_release(r);
+            return KC_ETIME;
+        }
+        reply_unlock(r); /* answered just now */
+    }
+    rc = r->code;
+    reply_release(r);
+    return rc;
+}
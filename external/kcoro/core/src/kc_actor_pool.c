@@ -0,0 +1,170 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/*
+ * kc_actor_pool.c — n identical actors behind one address
+ *
+ * Each member owns a KC_BUFFERED mailbox, so senders to different members
+ * never meet on a lock, and runs as a kc_scope_actor of a scope the pool
+ * creates: the scope's token (a child of ctx->cancel) stops them all and
+ * kc_scope_destroy waits for them.
+ *
+ * Routers
+ * - round robin: a shared cursor.
+ * - least loaded: the shortest mailbox by kc_chan_len, scanning from the
+ *   round-robin cursor so ties spread out.
+ * - hash: jump consistent hash (Lamping & Veach) of the key, so a key
+ *   keeps its member and resizing a pool moves only 1/n of the keys.
+ *
+ * The user's callbacks are wrapped to count processed messages per member;
+ * routed counts successful sends. Counters sit on their member's own cache
+ * line.
+ */
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+#include <stdatomic.h>
+
+#include "../../include/kcoro.h"
+
+#define POOL_DEFAULT_CAPACITY 64
+
+struct kc_actor_pool_member {
+    kc_chan_t *mbox;
+    kc_actor_fn process;
+    kc_actor_batch_fn process_batch;
+    void *user;
+    _Atomic unsigned long routed;
+    _Atomic unsigned long processed;
+} __attribute__((aligned(64)));
+
+struct kc_actor_pool {
+    kc_scope_t *scope;
+    size_t n;
+    int router;
+    _Atomic size_t cursor;
+    struct kc_actor_pool_member *m;
+};
+
+static int pool_process(const void *msg, void *user)
+{
+    struct kc_actor_pool_member *m = (struct kc_actor_pool_member*)user;
+    atomic_fetch_add_explicit(&m->processed, 1, memory_order_relaxed);
+    return m->process(msg, m->user);
+}
+
+static int pool_process_batch(const void *msgs, size_t n, void *user)
+{
+    struct kc_actor_pool_member *m = (struct kc_actor_pool_member*)user;
+    atomic_fetch_add_explicit(&m->processed, n, memory_order_relaxed);
+    return m->process_batch(msgs, n, m->user);
+}
+
+/* Bucket in [0, buckets) for key; a key only moves when its bucket is
+ * added or removed. */
+static size_t jump_hash(uint64_t key, size_t buckets)
+{
+    int64_t b = -1, j = 0;
+    while (j < (int64_t)buckets) {
+        b = j;
+        key = key * 2862933555777941757ULL + 1;
+        j = (int64_t)((double)(b + 1) * ((double)(1LL << 31) / (double)((key >> 33) + 1)));
+    }
+    return (size_t)b;
+}
+
+kc_actor_pool_t* kc_actor_pool_start(const kc_actor_pool_ctx_t *ctx, size_t n, int router)
+{
+    if (!ctx || n == 0 || !ctx->base.msg_size) return NULL;
+    if (router < KC_ACTOR_ROUTE_ROUND_ROBIN || router > KC_ACTOR_ROUTE_HASH) return NULL;
+    kc_actor_pool_t *p = calloc(1, sizeof(*p));
+    if (!p) return NULL;
+    p->m = aligned_alloc(64, n * sizeof(*p->m));
+    if (!p->m || kc_scope_init(&p->scope, ctx->cancel) != 0) {
+        free(p->m);
+        free(p);
+        return NULL;
+    }
+    p->router = router;
+    size_t cap = ctx->capacity ? ctx->capacity : POOL_DEFAULT_CAPACITY;
+    for (size_t i = 0; i < n; i++) {
+        struct kc_actor_pool_member *m = &p->m[i];
+        m->process = ctx->base.process;
+        m->process_batch = ctx->base.process_batch;
+        m->user = ctx->base.user;
+        atomic_init(&m->routed, 0);
+        atomic_init(&m->processed, 0);
+        m->mbox = NULL;
+        if (kc_chan_make(&m->mbox, KC_BUFFERED, ctx->base.msg_size, cap) != 0) break;
+        kc_actor_ctx_t mc = ctx->base;
+        mc.chan = m->mbox;
+        mc.user = m;
+        mc.process = m->process ? pool_process : NULL;
+        mc.process_batch = m->process_batch ? pool_process_batch : NULL;
+        if (!kc_scope_actor(p->scope, &mc)) {
+            kc_chan_destroy(m->mbox);
+            break;
+        }
+        p->n = i + 1;
+    }
+    if (p->n != n) {
+        kc_actor_pool_stop(p);
+        return NULL;
+    }
+    return p;
+}
+
+void kc_actor_pool_stop(kc_actor_pool_t *p)
+{
+    if (!p) return;
+    kc_scope_destroy(p->scope);
+    for (size_t i = 0; i < p->n; i++) kc_chan_destroy(p->m[i].mbox);
+    free(p->m);
+    free(p);
+}
+
+int kc_actor_pool_route(kc_actor_pool_t *p, unsigned long key)
+{
+    if (!p) return -EINVAL;
+    if (p->router == KC_ACTOR_ROUTE_HASH) return (int)jump_hash(key, p->n);
+    size_t start = atomic_fetch_add_explicit(&p->cursor, 1, memory_order_relaxed) % p->n;
+    if (p->router == KC_ACTOR_ROUTE_ROUND_ROBIN) return (int)start;
+    size_t best = start;
+    unsigned best_len = kc_chan_len(p->m[start].mbox);
+    for (size_t k = 1; k < p->n && best_len; k++) {
+        size_t i = (start + k) % p->n;
+        unsigned len = kc_chan_len(p->m[i].mbox);
+        if (len < best_len) { best = i; best_len = len; }
+    }
+    return (int)best;
+}
+
+int kc_actor_pool_send(kc_actor_pool_t *p, unsigned long key, const void *msg, long timeout_ms)
+{
+    int i = kc_actor_pool_route(p, key);
+    if (i < 0) return i;
+    struct kc_actor_pool_member *m = &p->m[i];
+    int rc = kc_chan_send(m->mbox, msg, timeout_ms);
+    if (rc == 0) atomic_fetch_add_explicit(&m->routed, 1, memory_order_relaxed);
+    return rc;
+}
+
+size_t kc_actor_pool_size(const kc_actor_pool_t *p)
+{
+    return p ? p->n : 0;
+}
+
+kc_chan_t* kc_actor_pool_mailbox(kc_actor_pool_t *p, size_t member)
+{
+    return (p && member < p->n) ? p->m[member].mbox : NULL;
+}
+
+size_t kc_actor_pool_snapshot(kc_actor_pool_t *p, struct kc_actor_pool_member_stats *out, size_t max)
+{
+    if (!p || !out) return 0;
+    size_t k = max < p->n ? max : p->n;
+    for (size_t i = 0; i < k; i++) {
+        out[i].routed = atomic_load_explicit(&p->m[i].routed, memory_order_relaxed);
+        out[i].processed = atomic_load_explicit(&p->m[i].processed, memory_order_relaxed);
+        out[i].queued = kc_chan_len(p->m[i].mbox);
+    }
+    return k;
+}
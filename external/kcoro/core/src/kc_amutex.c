@@ -0,0 +1,200 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/*
+ * kc_amutex.c — adaptive KC_MUTEX_T (make ADAPTIVE_MUTEX=1)
+ * ---------------------------------------------------------
+ *
+ * Lock word (port/posix.h): 0 free, 1 held, 2 held and a thread may be
+ * asleep on it. Uncontended, lock is one CAS and unlock one exchange; a
+ * lock that finds the word taken spins KCORO_AMUTEX_SPIN
+ * rounds, reading the word and retrying the CAS when it reads 0, with a
+ * pause hint between reads: channel and run-queue critical sections are
+ * tens of nanoseconds, so the holder is usually gone before the spin is.
+ * With one CPU online the holder cannot run while we spin, so we do not.
+ * Then it marks the word 2 and sleeps in the kernel until it can swap 0
+ * for 2 itself; an unlock that swaps out a 2 wakes one sleeper.
+ *
+ * The condvar is a sequence word on the same wait primitive: a waiter
+ * notes seq under the mutex, unlocks and sleeps while seq is unchanged;
+ * signal bumps seq and wakes only when a waiter is registered. A woken
+ * waiter relocks with 2, as other threads may still be asleep on it.
+ *
+ * Contended acquisitions are counted process-wide for kcoro_lockprof.h.
+ */
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "../../include/kcoro_config.h"
+#include "../../include/kcoro_port.h"
+#include "../../include/kcoro_lockprof.h"
+#include "../../include/kcoro_sched.h"
+
+#if defined(KC_PORT_ADAPTIVE_MUTEX)
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+/* 1 when abs (CLOCK_MONOTONIC, the bitset op's default clock) passed. */
+static int amx_wait(_Atomic uint32_t *addr, uint32_t val, const struct timespec *abs)
+{
+    long rc = abs ? syscall(SYS_futex, (uint32_t *)addr, FUTEX_WAIT_BITSET_PRIVATE, val, abs,
+                            NULL, FUTEX_BITSET_MATCH_ANY)
+                  : syscall(SYS_futex, (uint32_t *)addr, FUTEX_WAIT_PRIVATE, val, NULL, NULL, 0);
+    return rc == -1 && errno == ETIMEDOUT;
+}
+
+static void amx_wake(_Atomic uint32_t *addr, int all)
+{
+    (void)syscall(SYS_futex, (uint32_t *)addr, FUTEX_WAKE_PRIVATE, all ? INT_MAX : 1, NULL, NULL, 0);
+}
+
+#else /* __APPLE__ */
+/* libsystem_kernel's compare-and-wait, as used by os_unfair_lock. */
+extern int __ulock_wait(uint32_t operation, void *addr, uint64_t value, uint32_t timeout_us);
+extern int __ulock_wake(uint32_t operation, void *addr, uint64_t wake_value);
+#define KC_UL_COMPARE_AND_WAIT 1u
+#define KC_ULF_WAKE_ALL        0x00000100u
+#define KC_ULF_NO_ERRNO        0x01000000u
+
+static int amx_wait(_Atomic uint32_t *addr, uint32_t val, const struct timespec *abs)
+{
+    uint32_t us = 0;   /* 0: no timeout */
+    if (abs) {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        long long left = (long long)(abs->tv_sec - now.tv_sec) * 1000000LL +
+                         (abs->tv_nsec - now.tv_nsec) / 1000;
+        if (left <= 0) return 1;
+        us = left > UINT32_MAX ? UINT32_MAX : (uint32_t)left;
+    }
+    int rc = __ulock_wait(KC_UL_COMPARE_AND_WAIT | KC_ULF_NO_ERRNO, (void *)addr, val, us);
+    return rc == -ETIMEDOUT;
+}
+
+static void amx_wake(_Atomic uint32_t *addr, int all)
+{
+    (void)__ulock_wake(KC_UL_COMPARE_AND_WAIT | KC_ULF_NO_ERRNO | (all ? KC_ULF_WAKE_ALL : 0),
+                       (void *)addr, 0);
+}
+#endif
+
+static inline void amx_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield" ::: "memory");
+#endif
+}
+
+static struct {
+    _Atomic uint64_t contended, spin_acquired, sleeps, wakes;
+} g_amx;
+
+/* KCORO_AMUTEX_SPIN, or 0 with a CPU budget of one; -1 until first contention. */
+static _Atomic int g_amx_spin = -1;
+
+static unsigned amx_spin_budget(void)
+{
+    int n = atomic_load_explicit(&g_amx_spin, memory_order_relaxed);
+    if (n < 0) {
+        n = kc_cpu_budget() > 1 ? KCORO_AMUTEX_SPIN : 0;
+        atomic_store_explicit(&g_amx_spin, n, memory_order_relaxed);
+    }
+    return (unsigned)n;
+}
+
+#define AMX_COUNT(f) atomic_fetch_add_explicit(&g_amx.f, 1, memory_order_relaxed)
+
+/* Take m as 2 (a sleeper may follow), sleeping until it is free. */
+static void amx_lock_contended(kc_amutex_t *m)
+{
+    while (atomic_exchange_explicit(&m->state, 2, memory_order_acquire) != 0) {
+        AMX_COUNT(sleeps);
+        (void)amx_wait(&m->state, 2, NULL);
+    }
+}
+
+int kc_amutex_trylock(kc_amutex_t *m)
+{
+    uint32_t s = 0;
+    return atomic_compare_exchange_strong_explicit(&m->state, &s, 1, memory_order_acquire,
+                                                   memory_order_relaxed) ? 0 : EBUSY;
+}
+
+int kc_amutex_lock(kc_amutex_t *m)
+{
+    if (kc_amutex_trylock(m) == 0) return 0;
+    AMX_COUNT(contended);
+    for (unsigned i = 0, n = amx_spin_budget(); i < n; i++) {
+        uint32_t s = atomic_load_explicit(&m->state, memory_order_relaxed);
+        if (s == 0 && atomic_compare_exchange_weak_explicit(&m->state, &s, 1, memory_order_acquire,
+                                                            memory_order_relaxed)) {
+            AMX_COUNT(spin_acquired);
+            return 0;
+        }
+        amx_relax();
+    }
+    amx_lock_contended(m);
+    return 0;
+}
+
+int kc_amutex_unlock(kc_amutex_t *m)
+{
+    if (atomic_exchange_explicit(&m->state, 0, memory_order_release) == 2) {
+        AMX_COUNT(wakes);
+        amx_wake(&m->state, 0);
+    }
+    return 0;
+}
+
+int kc_acond_wait(kc_acond_t *c, kc_amutex_t *m, const struct timespec *abs)
+{
+    atomic_fetch_add_explicit(&c->waiters, 1, memory_order_seq_cst);
+    uint32_t seq = atomic_load_explicit(&c->seq, memory_order_seq_cst);
+    kc_amutex_unlock(m);
+    int timed_out = amx_wait(&c->seq, seq, abs);
+    atomic_fetch_sub_explicit(&c->waiters, 1, memory_order_relaxed);
+    amx_lock_contended(m);
+    return timed_out ? ETIMEDOUT : 0;
+}
+
+void kc_acond_wake(kc_acond_t *c, int all)
+{
+    amx_wake(&c->seq, all);
+}
+
+int kc_lockprof_adaptive(kc_lockprof_adaptive_t *out)
+{
+    if (!out) return -EINVAL;
+    out->contended = atomic_load_explicit(&g_amx.contended, memory_order_relaxed);
+    out->spin_acquired = atomic_load_explicit(&g_amx.spin_acquired, memory_order_relaxed);
+    out->sleeps = atomic_load_explicit(&g_amx.sleeps, memory_order_relaxed);
+    out->wakes = atomic_load_explicit(&g_amx.wakes, memory_order_relaxed);
+    return 0;
+}
+
+int kc_lockprof_adaptive_reset(void)
+{
+    atomic_store_explicit(&g_amx.contended, 0, memory_order_relaxed);
+    atomic_store_explicit(&g_amx.spin_acquired, 0, memory_order_relaxed);
+    atomic_store_explicit(&g_amx.sleeps, 0, memory_order_relaxed);
+    atomic_store_explicit(&g_amx.wakes, 0, memory_order_relaxed);
+    return 0;
+}
+
+#else /* pthread locks */
+
+int kc_lockprof_adaptive(kc_lockprof_adaptive_t *out)
+{
+    if (!out) return -EINVAL;
+    memset(out, 0, sizeof(*out));
+    return -ENOTSUP;
+}
+
+int kc_lockprof_adaptive_reset(void) { return -ENOTSUP; }
+
+#endif
@@ -0,0 +1,198 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/*
+ * kc_arena.c — bump allocation (kcoro_arena.h)
+ * --------------------------------------------
+ *
+ * Chunks are linked newest first. Allocations above a quarter of the chunk
+ * size get a chunk of their own on a second list, so a mark records the
+ * head of both and a rewind frees whatever is newer on either. Reset keeps
+ * the oldest regular chunk, which is the one a short-lived arena (per
+ * request, per scope) usually never outgrows.
+ */
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "../../include/kcoro_arena.h"
+#include "../../include/kcoro_config.h"
+#include "../../include/kcoro_port.h"
+
+#define ARENA_ALIGN 16
+
+struct kc_arena_chunk {
+    struct kc_arena_chunk *prev;   /* older chunk */
+    size_t size, used;
+    _Alignas(ARENA_ALIGN) unsigned char data[];
+};
+
+struct kc_arena {
+    struct kc_arena_chunk *head;   /* current regular chunk */
+    struct kc_arena_chunk *big;    /* oversized allocations */
+    size_t chunk_size;
+    size_t total;
+    unsigned flags;
+    KC_MUTEX_T mu;                 /* KC_ARENA_F_SHARED */
+};
+
+static void arena_lock(kc_arena_t *a) { if (a->flags & KC_ARENA_F_SHARED) KC_MUTEX_LOCK(&a->mu); }
+static void arena_unlock(kc_arena_t *a) { if (a->flags & KC_ARENA_F_SHARED) KC_MUTEX_UNLOCK(&a->mu); }
+
+static struct kc_arena_chunk *chunk_new(size_t size, struct kc_arena_chunk *prev)
+{
+    struct kc_arena_chunk *c = (struct kc_arena_chunk*)malloc(sizeof(*c) + size);
+    if (!c) return NULL;
+    c->prev = prev;
+    c->size = size;
+    c->used = 0;
+    return c;
+}
+
+/* Free chunks from c back to (not including) stop. */
+static void chunk_free_until(struct kc_arena_chunk *c, struct kc_arena_chunk *stop)
+{
+    while (c && c != stop) {
+        struct kc_arena_chunk *prev = c->prev;
+        free(c);
+        c = prev;
+    }
+}
+
+int kc_arena_create(kc_arena_t **out, size_t chunk_size, unsigned flags)
+{
+    if (!out || (flags & ~KC_ARENA_F_SHARED)) return -EINVAL;
+    *out = NULL;
+    if (chunk_size == 0) chunk_size = KCORO_ARENA_CHUNK;
+    chunk_size = (chunk_size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    kc_arena_t *a = (kc_arena_t*)calloc(1, sizeof(*a));
+    if (!a) return -ENOMEM;
+    a->chunk_size = chunk_size;
+    a->flags = flags;
+    if ((flags & KC_ARENA_F_SHARED) && KC_MUTEX_INIT(&a->mu) != 0) { free(a); return -ENOMEM; }
+    *out = a;
+    return 0;
+}
+
+void kc_arena_destroy(kc_arena_t *a)
+{
+    if (!a) return;
+    chunk_free_until(a->head, NULL);
+    chunk_free_until(a->big, NULL);
+    if (a->flags & KC_ARENA_F_SHARED) KC_MUTEX_DESTROY(&a->mu);
+    free(a);
+}
+
+void *kc_arena_alloc(kc_arena_t *a, size_t len)
+{
+    if (!a || len > SIZE_MAX / 2) return NULL;
+    len = len ? (len + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1) : ARENA_ALIGN;
+    void *p = NULL;
+    arena_lock(a);
+    struct kc_arena_chunk *c = a->head;
+    if (c && c->size - c->used >= len) {
+        p = c->data + c->used;
+        c->used += len;
+    } else if (len > a->chunk_size / 4) {
+        if ((c = chunk_new(len, a->big)) != NULL) {
+            a->big = c;
+            c->used = len;
+            p = c->data;
+        }
+    } else if ((c = chunk_new(a->chunk_size, a->head)) != NULL) {
+        a->head = c;
+        c->used = len;
+        p = c->data;
+    }
+    if (p) a->total += len;
+    arena_unlock(a);
+    return p;
+}
+
+void *kc_arena_calloc(kc_arena_t *a, size_t n, size_t size)
+{
+    if (size && n > SIZE_MAX / size) return NULL;
+    void *p = kc_arena_alloc(a, n * size);
+    if (p) memset(p, 0, n * size);
+    return p;
+}
+
+void kc_arena_reset(kc_arena_t *a)
+{
+    if (!a) return;
+    arena_lock(a);
+    struct kc_arena_chunk *first = a->head;
+    while (first && first->prev) first = first->prev;
+    chunk_free_until(a->head, first);
+    chunk_free_until(a->big, NULL);
+    a->head = first;
+    a->big = NULL;
+    if (first) first->used = 0;
+    a->total = 0;
+    arena_unlock(a);
+}
+
+kc_arena_mark_t kc_arena_mark(kc_arena_t *a)
+{
+    kc_arena_mark_t m = { 0 };
+    if (!a) return m;
+    arena_lock(a);
+    m.chunk = a->head;
+    m.big = a->big;
+    m.used = a->head ? a->head->used : 0;
+    m.total = a->total;
+    arena_unlock(a);
+    return m;
+}
+
+void kc_arena_rewind(kc_arena_t *a, kc_arena_mark_t m)
+{
+    if (!a) return;
+    arena_lock(a);
+    struct kc_arena_chunk *keep = (struct kc_arena_chunk*)m.chunk;
+    if (!keep) {
+        /* Marked while empty: keep the oldest chunk, as reset does. */
+        keep = a->head;
+        while (keep && keep->prev) keep = keep->prev;
+    }
+    chunk_free_until(a->head, keep);
+    chunk_free_until(a->big, (struct kc_arena_chunk*)m.big);
+    a->head = keep;
+    a->big = (struct kc_arena_chunk*)m.big;
+    if (keep) keep->used = m.chunk ? m.used : 0;
+    a->total = m.total;
+    arena_unlock(a);
+}
+
+size_t kc_arena_used(kc_arena_t *a)
+{
+    if (!a) return 0;
+    arena_lock(a);
+    size_t n = a->total;
+    arena_unlock(a);
+    return n;
+}
+
+static __thread kc_arena_t *tls_arena;
+static pthread_key_t arena_key;
+static pthread_once_t arena_once = PTHREAD_ONCE_INIT;
+
+static void arena_local_drop(void *arg)
+{
+    kc_arena_destroy((kc_arena_t*)arg);
+}
+
+static void arena_key_init(void)
+{
+    (void)pthread_key_create(&arena_key, arena_local_drop);
+}
+
+kc_arena_t *kc_arena_local(void)
+{
+    if (tls_arena) return tls_arena;
+    pthread_once(&arena_once, arena_key_init);
+    kc_arena_t *a = NULL;
+    if (kc_arena_create(&a, 0, 0) != 0) return NULL;
+    (void)pthread_setspecific(arena_key, a);
+    tls_arena = a;
+    return a;
+}
@@ -0,0 +1,335 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Broadcast channels: one ring, one write per message, a cursor per
+ * subscriber.
+ *
+ * Message seq lives in slot seq % cap while seq >= head - cap. A subscriber
+ * reads from its cursor; DROP subscribers that fell more than cap behind and
+ * CONFLATE subscribers catch up lazily at their next recv, so a send never
+ * walks the subscriber list. Only SUSPEND subscribers hold senders back:
+ * `tail` is a lower bound of their cursors (cursors only grow), refreshed by
+ * a scan only when the ring looks full.
+ *
+ * Everything runs under b->mu. Waiters park with it held and drop it in the
+ * park_release hook, so a waker that finds one on a list knows it switched
+ * out and may enqueue it right away. */
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "../../include/kcoro.h"
+#include "../../include/kcoro_zcopy.h"
+#include "../../include/kcoro_port.h"
+#include "../../include/kcoro_core.h"
+#include "../../include/kcoro_sched.h"
+#include "kc_chan_internal.h"
+#include "kc_wake_batch_internal.h"
+#include "kcoro_share_internal.h"
+
+/* Also the park record: the release hook takes the waiter itself. */
+struct kc_bcast_waiter {
+    kcoro_t *co;
+    kc_sched_t *sched;
+    struct kc_bcast_waiter *next;
+    struct kc_bcast *b;
+    long deadline_ns;
+    kc_timer_handle_t timer;
+};
+
+struct kc_bcast_sub {
+    struct kc_bcast *b;
+    struct kc_bcast_sub *prev, *next;  /* b->subs */
+    int policy;                        /* enum kc_bcast_overflow */
+    unsigned long cursor;              /* seq of the next message to read */
+    struct kc_bcast_waiter park;       /* on b->parked while park.co */
+    unsigned long received, dropped, conflated;
+};
+
+struct kc_bcast {
+    KC_MUTEX_T mu;
+    size_t elem_sz, cap;
+    unsigned char *buf;
+    unsigned long head;                /* seq of the next message */
+    unsigned long tail;                /* <= every SUSPEND cursor */
+    int nsuspend;
+    int closed;
+    struct kc_bcast_sub *subs;
+    struct kc_bcast_waiter *parked;    /* subscribers in recv (via sub->park) */
+    struct kc_bcast_waiter *senders;   /* senders waiting for room */
+    kc_bufpool_t *pool;                /* elements are buffer pointers */
+};
+
+int kc_bcast_make(kc_bcast_t **out, size_t elem_sz, size_t capacity)
+{
+    if (!out || elem_sz == 0 || capacity == 0) return -EINVAL;
+    struct kc_bcast *b = calloc(1, sizeof(*b));
+    if (!b) return -ENOMEM;
+    b->buf = malloc(elem_sz * capacity);
+    if (!b->buf) { free(b); return -ENOMEM; }
+    KC_MUTEX_INIT(&b->mu);
+    b->elem_sz = elem_sz;
+    b->cap = capacity;
+    *out = b;
+    return 0;
+}
+
+static inline unsigned char *kc_bcast_slot(struct kc_bcast *b, unsigned long seq)
+{
+    return b->buf + (size_t)(seq % b->cap) * b->elem_sz;
+}
+
+static inline unsigned long kc_bcast_oldest(const struct kc_bcast *b)
+{
+    return b->head > b->cap ? b->head - b->cap : 0;
+}
+
+/* The ring's reference on the buffer in seq's slot (pool mode). */
+static void kc_bcast_drop_slot(struct kc_bcast *b, unsigned long seq)
+{
+    void *p = NULL;
+    memcpy(&p, kc_bcast_slot(b, seq), sizeof(p));
+    if (p) (void)kc_bufpool_release(b->pool, p);
+}
+
+/* Enqueue every waiter on *list, in batches, and empty it (b->mu held;
+ * each one is switched out, see the file comment). */
+static void kc_bcast_wake_all_locked(struct kc_bcast_waiter **list)
+{
+    struct kc_bcast_waiter *w = *list;
+    *list = NULL;
+    struct kc_wake_batch wakes;
+    kc_wake_batch_init(&wakes, 0);
+    while (w) {
+        struct kc_bcast_waiter *next = w->next;
+        kcoro_t *co = w->co;
+        kc_sched_t *s = w->sched;
+        w->co = NULL;
+        w->next = NULL;
+        kc_wake_batch_add(&wakes, s ? s : kc_sched_default(), co, KC_LANE_INHERIT);
+        w = next;
+    }
+    kc_wake_batch_flush(&wakes);
+}
+
+/* Drop w from list if a waker did not take it (timer or stray wake). */
+static void kc_bcast_unlink_locked(struct kc_bcast_waiter **list, struct kc_bcast_waiter *w)
+{
+    for (struct kc_bcast_waiter **pp = list; *pp; pp = &(*pp)->next) {
+        if (*pp != w) continue;
+        *pp = w->next;
+        break;
+    }
+    w->co = NULL;
+    w->next = NULL;
+}
+
+/* Runs on the worker after the waiting coroutine switched out; a waker
+ * clears w->co and w->next, never the timer. */
+static void kc_bcast_park_release(void *arg)
+{
+    struct kc_bcast_waiter *w = (struct kc_bcast_waiter*)arg;
+    if (w->deadline_ns > 0)
+        w->timer = kc_sched_timer_wake_at(w->sched, w->co, (unsigned long long)w->deadline_ns);
+    KC_MUTEX_UNLOCK(&w->b->mu);
+}
+
+/* Wait on list through w (off a shared stack: wakers reach it) until woken
+ * or the deadline; b->mu held on entry and return. 0 after a park, -EINVAL
+ * when the caller cannot park. */
+static int kc_bcast_park_locked(struct kc_bcast *b, struct kc_bcast_waiter **list,
+                                struct kc_bcast_waiter *w, long deadline_ns)
+{
+    kcoro_t *co = kcoro_current();
+    if (!co) return -EINVAL;
+    kc_sched_t *sched = kc_sched_current();
+    w->co = co;
+    w->sched = sched;
+    w->b = b;
+    w->deadline_ns = deadline_ns;
+    w->timer = (kc_timer_handle_t){0};
+    w->next = *list;
+    *list = w;
+    if (!sched || kc_sched_park_release(kc_bcast_park_release, w) != 0) {
+        /* Not on a worker: cooperative retry. */
+        kc_bcast_unlink_locked(list, w);
+        KC_MUTEX_UNLOCK(&b->mu);
+        kcoro_yield();
+        KC_MUTEX_LOCK(&b->mu);
+        return 0;
+    }
+    (void)kc_sched_timer_cancel(sched, w->timer);
+    KC_MUTEX_LOCK(&b->mu);
+    if (w->co) kc_bcast_unlink_locked(list, w);
+    return 0;
+}
+
+/* Slowest SUSPEND cursor, or head without any (b->mu held). */
+static unsigned long kc_bcast_min_suspend_locked(struct kc_bcast *b)
+{
+    unsigned long min = b->head;
+    for (struct kc_bcast_sub *s = b->subs; s; s = s->next)
+        if (s->policy == KC_BCAST_SUSPEND && s->cursor < min) min = s->cursor;
+    return min;
+}
+
+int kc_bcast_send(kc_bcast_t *b, const void *msg, long timeout_ms)
+{
+    if (!b || !msg) return -EINVAL;
+    long deadline_ns = timeout_ms > 0 ? kc_now_ns() + timeout_ms * 1000000L : 0;
+    KC_MUTEX_LOCK(&b->mu);
+    for (;;) {
+        if (b->closed) { KC_MUTEX_UNLOCK(&b->mu); return KC_EPIPE; }
+        if (b->nsuspend && b->head - b->tail >= b->cap) b->tail = kc_bcast_min_suspend_locked(b);
+        if (!b->nsuspend || b->head - b->tail < b->cap) break;
+        if (timeout_ms == 0) { KC_MUTEX_UNLOCK(&b->mu); return KC_EAGAIN; }
+        if (deadline_ns > 0 && kc_now_ns() >= deadline_ns) { KC_MUTEX_UNLOCK(&b->mu); return KC_ETIME; }
+        struct kc_bcast_waiter local = { 0 };
+        struct kc_bcast_waiter *w = kcoro_park_record(kcoro_current(), &local, sizeof(local));
+        int rc = w ? kc_bcast_park_locked(b, &b->senders, w, deadline_ns) : -ENOMEM;
+        kcoro_park_record_free(w, &local);
+        if (rc != 0) { KC_MUTEX_UNLOCK(&b->mu); return rc; }
+    }
+    /* The slot's previous message (seq head - cap) is gone for everyone */
+    if (b->pool && b->head >= b->cap) kc_bcast_drop_slot(b, b->head - b->cap);
+    memcpy(kc_bcast_slot(b, b->head), msg, b->elem_sz);
+    b->head++;
+    if (b->parked) kc_bcast_wake_all_locked(&b->parked);
+    KC_MUTEX_UNLOCK(&b->mu);
+    return 0;
+}
+
+int kc_bcast_subscribe(kc_bcast_t *b, kc_bcast_sub_t **out, enum kc_bcast_overflow policy)
+{
+    if (!b || !out || policy < KC_BCAST_SUSPEND || policy > KC_BCAST_CONFLATE) return -EINVAL;
+    struct kc_bcast_sub *s = calloc(1, sizeof(*s));
+    if (!s) return -ENOMEM;
+    s->b = b;
+    s->policy = policy;
+    KC_MUTEX_LOCK(&b->mu);
+    if (b->closed) { KC_MUTEX_UNLOCK(&b->mu); free(s); return KC_EPIPE; }
+    s->cursor = b->head;
+    if (policy == KC_BCAST_SUSPEND && b->nsuspend++ == 0) b->tail = b->head;
+    s->next = b->subs;
+    if (b->subs) b->subs->prev = s;
+    b->subs = s;
+    KC_MUTEX_UNLOCK(&b->mu);
+    *out = s;
+    return 0;
+}
+
+/* b->mu held */
+static void kc_bcast_sub_unlink_locked(struct kc_bcast *b, struct kc_bcast_sub *s)
+{
+    if (s->prev) s->prev->next = s->next; else b->subs = s->next;
+    if (s->next) s->next->prev = s->prev;
+    if (s->policy == KC_BCAST_SUSPEND) b->nsuspend--;
+}
+
+void kc_bcast_unsubscribe(kc_bcast_sub_t *s)
+{
+    if (!s) return;
+    struct kc_bcast *b = s->b;
+    KC_MUTEX_LOCK(&b->mu);
+    kc_bcast_sub_unlink_locked(b, s);
+    /* It may have been the one holding senders back */
+    if (s->policy == KC_BCAST_SUSPEND && b->senders) kc_bcast_wake_all_locked(&b->senders);
+    KC_MUTEX_UNLOCK(&b->mu);
+    free(s);
+}
+
+/* Move a lagging cursor to what the policy lets it see (b->mu held). */
+static void kc_bcast_catch_up_locked(struct kc_bcast *b, struct kc_bcast_sub *s)
+{
+    if (s->policy == KC_BCAST_CONFLATE) {
+        if (s->cursor + 1 < b->head) {
+            s->conflated += b->head - 1 - s->cursor;
+            s->cursor = b->head - 1;
+        }
+        return;
+    }
+    unsigned long oldest = kc_bcast_oldest(b);
+    if (s->cursor < oldest) {
+        s->dropped += oldest - s->cursor;
+        s->cursor = oldest;
+    }
+}
+
+int kc_bcast_recv(kc_bcast_sub_t *s, void *out, long timeout_ms)
+{
+    if (!s || !out) return -EINVAL;
+    struct kc_bcast *b = s->b;
+    long deadline_ns = timeout_ms > 0 ? kc_now_ns() + timeout_ms * 1000000L : 0;
+    KC_MUTEX_LOCK(&b->mu);
+    for (;;) {
+        kc_bcast_catch_up_locked(b, s);
+        if (s->cursor < b->head) break;
+        if (b->closed) { KC_MUTEX_UNLOCK(&b->mu); return KC_EPIPE; }
+        if (timeout_ms == 0) { KC_MUTEX_UNLOCK(&b->mu); return KC_EAGAIN; }
+        if (deadline_ns > 0 && kc_now_ns() >= deadline_ns) { KC_MUTEX_UNLOCK(&b->mu); return KC_ETIME; }
+        int rc = kc_bcast_park_locked(b, &b->parked, &s->park, deadline_ns);
+        if (rc != 0) { KC_MUTEX_UNLOCK(&b->mu); return rc; }
+    }
+    memcpy(out, kc_bcast_slot(b, s->cursor), b->elem_sz);
+    if (b->pool) {
+        /* The subscriber's own reference; the ring keeps its one */
+        void *p = NULL;
+        memcpy(&p, out, sizeof(p));
+        if (p) (void)kc_bufpool_retain(b->pool, p);
+    }
+    int was_tail = s->policy == KC_BCAST_SUSPEND && s->cursor == b->tail;
+    s->cursor++;
+    s->received++;
+    if (was_tail && b->senders) kc_bcast_wake_all_locked(&b->senders);
+    KC_MUTEX_UNLOCK(&b->mu);
+    return 0;
+}
+
+void kc_bcast_close(kc_bcast_t *b)
+{
+    if (!b) return;
+    KC_MUTEX_LOCK(&b->mu);
+    b->closed = 1;
+    kc_bcast_wake_all_locked(&b->parked);
+    kc_bcast_wake_all_locked(&b->senders);
+    KC_MUTEX_UNLOCK(&b->mu);
+}
+
+void kc_bcast_destroy(kc_bcast_t *b)
+{
+    if (!b) return;
+    while (b->subs) {
+        struct kc_bcast_sub *s = b->subs;
+        kc_bcast_sub_unlink_locked(b, s);
+        free(s);
+    }
+    if (b->pool)
+        for (unsigned long seq = kc_bcast_oldest(b); seq < b->head; seq++) kc_bcast_drop_slot(b, seq);
+    KC_MUTEX_DESTROY(&b->mu);
+    free(b->buf);
+    free(b);
+}
+
+int kc_bcast_sub_get_stats(const kc_bcast_sub_t *sub, struct kc_bcast_sub_stats *out)
+{
+    if (!sub || !out) return -EINVAL;
+    struct kc_bcast_sub *s = (struct kc_bcast_sub*)sub;
+    struct kc_bcast *b = s->b;
+    KC_MUTEX_LOCK(&b->mu);
+    unsigned long from = s->cursor;
+    if (s->policy != KC_BCAST_CONFLATE && from < kc_bcast_oldest(b)) from = kc_bcast_oldest(b);
+    out->received = s->received;
+    out->dropped = s->dropped;
+    out->conflated = s->conflated;
+    out->lag = b->head - from;
+    KC_MUTEX_UNLOCK(&b->mu);
+    return 0;
+}
+
+int kc_bcast_set_bufpool(kc_bcast_t *b, kc_bufpool_t *pool)
+{
+    if (!b || !pool || b->elem_sz != sizeof(void*)) return -EINVAL;
+    KC_MUTEX_LOCK(&b->mu);
+    if (b->head != 0 || b->pool) { KC_MUTEX_UNLOCK(&b->mu); return -EBUSY; }
+    b->pool = pool;
+    KC_MUTEX_UNLOCK(&b->mu);
+    return 0;
+}
@@ -1,13 +1,30 @@
 // SPDX-License-Identifier: BSD-3-Clause
+#include <errno.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdatomic.h>
 #include <assert.h>
+#if defined(__linux__)
+#include <dirent.h>
+#include <unistd.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
 #include "../../include/kcoro_bench.h"
 #include "../../include/kcoro_sched.h"
 #include "../../include/kcoro_port.h"
 #include "../../include/kcoro_core.h"
 #include "../../include/kcoro_config.h"
+#include "kc_chan_internal.h"
+#include "kc_hist_internal.h"
+
+/* Open loop, pointer mode: packets a producer cycles through. Each carries
+ * its send stamp, so the pool must outlast the packets still queued or
+ * being read; it is at least capacity plus one per consumer, plus slack. */
+#ifndef KC_BENCH_OPEN_POOL_MIN
+#define KC_BENCH_OPEN_POOL_MIN 1024
+#endif
 
 struct kc_bench_handle {
     kc_chan_t   *ch;
@@ -19,10 +36,17 @@ struct kc_bench_handle {
     /* arrays retained until stop() */
     int *sent_counts;
     int *per_counts;
+    /* Open loop (params.rate > 0) */
+    uint64_t t0;                  /* schedule origin */
+    uint64_t period_ns;           /* per producer, fixed point << 16 */
+    unsigned char *pool;          /* producers * pool_n packets of pool_sz */
+    size_t pool_n, pool_sz;
+    struct kc_hist_shard *lat;    /* one per consumer */
+    int nlat;
 };
 
 typedef struct prod_arg { struct kc_bench_handle *h; int id; } prod_arg_t;
-typedef struct cons_arg { struct kc_bench_handle *h; } cons_arg_t;
+typedef struct cons_arg { struct kc_bench_handle *h; int id; } cons_arg_t;
 
 static void co_producer_ptr(void *arg)
 {
@@ -61,11 +85,11 @@ static void co_producer_int(void *arg)
         for (int i = 0; i < h->params.packets_per_cycle; ++i) {
             int v = (pa->id << 24) | i;
             for (;;) {
-                int rc = kc_chan_send(h->ch, &v, 0);
+                int rc = kc_chan_try_send(h->ch, &v);
                 if (rc == 0) { sent++; if (h->sent_counts) h->sent_counts[pa->id] = sent; break; }
                 if (rc == KC_EPIPE) goto out;
                 for (int k = 0; k < h->params.spin_iters; ++k) {
-                    rc = kc_chan_send(h->ch, &v, 0);
+                    rc = kc_chan_try_send(h->ch, &v);
                     if (rc == 0) { sent++; if (h->sent_counts) h->sent_counts[pa->id] = sent; goto next; }
                     if (rc == KC_EPIPE) goto out;
                 }
@@ -108,12 +132,12 @@ static void co_consumer_int(void *arg)
     atomic_fetch_add(&h->active_cons, 1);
     int v;
     while (!atomic_load(&h->shutdown)) {
-        int rc = kc_chan_recv(h->ch, &v, 0);
+        int rc = kc_chan_try_recv(h->ch, &v);
         if (rc == 0) { if (h->per_counts) h->per_counts[0]++; }
         else if (rc == KC_EPIPE) break;
         else if (rc == KC_EAGAIN) {
             for (int k = 0; k < h->params.spin_iters; ++k) {
-                rc = kc_chan_recv(h->ch, &v, 0);
+                rc = kc_chan_try_recv(h->ch, &v);
                 if (rc == 0) { if (h->per_counts) h->per_counts[0]++; goto next; }
                 if (rc == KC_EPIPE) goto out;
             }
@@ -125,12 +149,113 @@ out:
     atomic_fetch_sub(&h->active_cons, 1);
 }
 
+/* ---- Open loop ----
+ * Producer i sends message k at t0 + (k + i / producers) * period and stamps
+ * it with that scheduled time, not the time it got out: a producer held up
+ * by a full channel sends its backlog at once, and the wait shows up as
+ * latency instead of as a lower offered rate. Between due times it parks on
+ * a scheduler timer, so a burst covers what fell due within one timer tick. */
+
+static void bench_sleep_until(uint64_t due)
+{
+    kc_sched_t *s = kc_sched_current();
+    kcoro_t *co = kcoro_current();
+    while ((uint64_t)kc_now_ns() < due) {
+        kc_timer_handle_t t = kc_sched_timer_wake_at(s, co, due);
+        kcoro_park();
+        (void)kc_sched_timer_cancel(s, t);
+    }
+}
+
+static void co_producer_open(void *arg)
+{
+    prod_arg_t *pa = (prod_arg_t*)arg;
+    struct kc_bench_handle *h = pa->h;
+    unsigned char *pool = h->pool ? h->pool + (size_t)pa->id * h->pool_n * h->pool_sz : NULL;
+    uint64_t k = 0;
+    uint64_t phase = h->period_ns * (uint64_t)pa->id / (uint64_t)h->params.producers;
+    int sent = 0; atomic_fetch_add(&h->active_prod, 1);
+    while (!atomic_load_explicit(&h->shutdown, memory_order_relaxed)) {
+        uint64_t due = h->t0 + ((k * h->period_ns + phase) >> 16);
+        if ((uint64_t)kc_now_ns() < due) { bench_sleep_until(due); continue; }
+        int rc;
+        if (pool) {
+            unsigned char *pkt = pool + (size_t)(k % h->pool_n) * h->pool_sz;
+            memcpy(pkt, &due, sizeof(due));
+            rc = kc_chan_send_ptr(h->ch, pkt, h->pool_sz, -1);
+        } else {
+            rc = kc_chan_send(h->ch, &due, -1);
+        }
+        if (rc != 0) break;
+        k++;
+        sent++; if (h->sent_counts) h->sent_counts[pa->id] = sent;
+    }
+    atomic_fetch_sub(&h->active_prod, 1);
+}
+
+static void co_consumer_open(void *arg)
+{
+    cons_arg_t *ca = (cons_arg_t*)arg; struct kc_bench_handle *h = ca->h;
+    struct kc_hist_shard *lat = &h->lat[ca->id];
+    atomic_fetch_add(&h->active_cons, 1);
+    for (;;) {
+        uint64_t stamp;
+        int rc;
+        if (h->params.pointer_mode) {
+            void *ptr = NULL; size_t len = 0;
+            rc = kc_chan_recv_ptr(h->ch, &ptr, &len, -1);
+            if (rc == 0) memcpy(&stamp, ptr, sizeof(stamp));
+        } else {
+            rc = kc_chan_recv(h->ch, &stamp, -1);
+        }
+        if (rc != 0) break;
+        uint64_t now = (uint64_t)kc_now_ns();
+        kc_hist_record(lat, now > stamp ? (unsigned long)(now - stamp) : 0);
+        if (h->per_counts) h->per_counts[0]++;
+    }
+    atomic_fetch_sub(&h->active_cons, 1);
+}
+
+static int bench_open_init(struct kc_bench_handle *h)
+{
+    const kc_bench_params_t *p = &h->params;
+    double period = 1e9 * (double)p->producers / p->rate * 65536.0;
+    if (!(period >= 1.0) || period > 1e18) return -EINVAL;
+    h->period_ns = (uint64_t)period;
+    h->nlat = p->consumers;
+    h->lat = aligned_alloc(_Alignof(struct kc_hist_shard), (size_t)h->nlat * sizeof(*h->lat));
+    if (!h->lat) return -ENOMEM;
+    kc_hist_shard_init(h->lat, (size_t)h->nlat);
+    if (p->pointer_mode) {
+        h->pool_sz = p->packet_size > sizeof(uint64_t) ? p->packet_size : sizeof(uint64_t);
+        h->pool_sz = (h->pool_sz + 63) & ~(size_t)63;
+        h->pool_n = p->capacity + (size_t)p->consumers + KC_BENCH_OPEN_POOL_MIN;
+        h->pool = aligned_alloc(64, (size_t)p->producers * h->pool_n * h->pool_sz);
+        if (!h->pool) return -ENOMEM;
+    }
+    h->t0 = kc_now_ns();
+    return 0;
+}
+
+int kc_bench_chan_latency(kc_bench_handle_t *h, struct kc_hist *out, int reset)
+{
+    if (!h || !out) return -EINVAL;
+    memset(out, 0, sizeof(*out));
+    if (!h->lat) return -ENOENT;
+    kc_hist_merge(h->lat, (size_t)h->nlat, out, reset);
+    return 0;
+}
+
 int kc_bench_chan_start(const kc_bench_params_t *p,
                         kc_bench_handle_t **out_handle,
                         kc_chan_t **out_chan)
 {
     if (!p || !out_handle) return -EINVAL;
     if (p->producers <= 0 || p->consumers <= 0 || p->packets_per_cycle <= 0) return -EINVAL;
+    if (p->spsc && (p->producers != 1 || p->consumers != 1)) return -EINVAL;
+    if (p->rate < 0) return -EINVAL;
+    /* Open-loop copy channels carry the 64-bit send stamp as the element */
+    size_t esz = p->rate > 0 ? sizeof(uint64_t) : sizeof(int);
 
     struct kc_bench_handle *h = calloc(1, sizeof(*h));
     if (!h) return -ENOMEM;
@@ -139,7 +264,13 @@ int kc_bench_chan_start(const kc_bench_params_t *p,
 
     /* Create channel */
     int rc;
-    if (p->pointer_mode) {
+    if (p->mpmc) {
+        h->params.pointer_mode = 0;
+        rc = kc_chan_make_mpmc(&h->ch, esz, p->capacity);
+    } else if (p->spsc) {
+        h->params.pointer_mode = 0;
+        rc = kc_chan_make_spsc(&h->ch, esz, p->capacity);
+    } else if (p->pointer_mode) {
         rc = kc_chan_make_ptr(&h->ch, p->kind, p->capacity);
         if (rc == 0) {
             int zrc = kc_chan_enable_zero_copy(h->ch);
@@ -150,21 +281,29 @@ int kc_bench_chan_start(const kc_bench_params_t *p,
             }
         }
     } else {
-        rc = kc_chan_make(&h->ch, p->kind, sizeof(int), p->capacity);
+        rc = kc_chan_make(&h->ch, p->kind, esz, p->capacity);
     }
     if (rc != 0) { free(h); return rc; }
 
     h->sent_counts = calloc((size_t)p->producers, sizeof(int));
     h->per_counts  = calloc((size_t)p->producers, sizeof(int));
+    if (p->rate > 0 && (rc = bench_open_init(h)) != 0) {
+        kc_chan_destroy(h->ch);
+        free(h->sent_counts); free(h->per_counts); free(h->lat); free(h->pool);
+        free(h);
+        return rc;
+    }
+    kcoro_fn_t prod_fn = p->rate > 0 ? co_producer_open : h->params.pointer_mode ? co_producer_ptr : co_producer_int;
+    kcoro_fn_t cons_fn = p->rate > 0 ? co_consumer_open : h->params.pointer_mode ? co_consumer_ptr : co_consumer_int;
 
     /* Spawn */
     for (int i = 0; i < p->consumers; ++i) {
-        cons_arg_t *ca = malloc(sizeof(*ca)); if (!ca) return -ENOMEM; ca->h = h;
-        kc_spawn_co(h->sched, p->pointer_mode ? co_consumer_ptr : co_consumer_int, ca, 0, NULL);
+        cons_arg_t *ca = malloc(sizeof(*ca)); if (!ca) return -ENOMEM; ca->h = h; ca->id = i;
+        kc_spawn_co(h->sched, cons_fn, ca, 0, NULL);
     }
     for (int i = 0; i < p->producers; ++i) {
         prod_arg_t *pa = malloc(sizeof(*pa)); if (!pa) return -ENOMEM; pa->h = h; pa->id = i;
-        kc_spawn_co(h->sched, p->pointer_mode ? co_producer_ptr : co_producer_int, pa, 0, NULL);
+        kc_spawn_co(h->sched, prod_fn, pa, 0, NULL);
     }
 
     if (out_chan) *out_chan = h->ch;
@@ -178,11 +317,199 @@ void kc_bench_chan_stop(kc_bench_handle_t *h)
     atomic_store(&h->shutdown, 1);
     kc_chan_close(h->ch);
     /* Wait for producers/consumers */
-    for (int i = 0; i < 1000; ++i) { /* up to ~100ms */
+    for (int i = 0; i < 1000; ++i) { /* up to ~1s */
         if (atomic_load(&h->active_prod) == 0 && atomic_load(&h->active_cons) == 0) break;
-        kcoro_yield();
+        kc_sleep_ms(1);
     }
     kc_chan_destroy(h->ch);
     free(h->sent_counts); free(h->per_counts);
+    free(h->lat); free(h->pool);
     free(h);
 }
+
+/* ---- perf counters ----
+ * One fd per (thread, counter), each read with its enabled/running times:
+ * a delta is scaled by its own running fraction before the threads are
+ * summed, so multiplexed counters stay comparable. */
+
+static const char *const g_perf_names[KC_BENCH_PERF_COUNT] = {
+    "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses", "ctx_switches",
+};
+
+const char *kc_bench_perf_name(int counter)
+{
+    return counter >= 0 && counter < KC_BENCH_PERF_COUNT ? g_perf_names[counter] : NULL;
+}
+
+#if defined(__linux__)
+
+struct perf_reading { uint64_t value, enabled, running; };
+
+struct kc_bench_perf {
+    int nfds;
+    int *fd;                      /* nthreads * KC_BENCH_PERF_COUNT, -1 if not open */
+    struct perf_reading *base;    /* per fd, at kc_bench_perf_start */
+    unsigned valid;
+};
+
+static const struct { uint32_t type; uint64_t config; } g_perf_events[KC_BENCH_PERF_COUNT] = {
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                          (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+    { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES },
+};
+
+/* Kernel and user first; user only if perf_event_paranoid refuses that. */
+static int perf_open_one(int counter, pid_t tid)
+{
+    struct perf_event_attr a;
+    memset(&a, 0, sizeof(a));
+    a.size = sizeof(a);
+    a.type = g_perf_events[counter].type;
+    a.config = g_perf_events[counter].config;
+    a.inherit = 1;
+    a.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    int fd = (int)syscall(SYS_perf_event_open, &a, tid, -1, -1, PERF_FLAG_FD_CLOEXEC);
+    if (fd < 0 && (errno == EACCES || errno == EPERM)) {
+        a.exclude_kernel = 1;
+        a.exclude_hv = 1;
+        fd = (int)syscall(SYS_perf_event_open, &a, tid, -1, -1, PERF_FLAG_FD_CLOEXEC);
+    }
+    return fd < 0 ? -errno : fd;
+}
+
+static int perf_read_fd(int fd, struct perf_reading *r)
+{
+    uint64_t v[3];
+    if (read(fd, v, sizeof(v)) != (ssize_t)sizeof(v)) return -EIO;
+    r->value = v[0];
+    r->enabled = v[1];
+    r->running = v[2];
+    return 0;
+}
+
+int kc_bench_perf_open(kc_bench_perf_t **out)
+{
+    if (!out) return -EINVAL;
+    *out = NULL;
+    DIR *d = opendir("/proc/self/task");
+    if (!d) return -errno;
+    int cap = 16, n = 0;
+    pid_t *tids = malloc((size_t)cap * sizeof(pid_t));
+    struct dirent *e;
+    while (tids && (e = readdir(d)) != NULL) {
+        if (e->d_name[0] < '0' || e->d_name[0] > '9') continue;
+        if (n == cap) {
+            pid_t *nt = realloc(tids, (size_t)(cap *= 2) * sizeof(pid_t));
+            if (!nt) { free(tids); tids = NULL; break; }
+            tids = nt;
+        }
+        tids[n++] = (pid_t)atoi(e->d_name);
+    }
+    closedir(d);
+    if (!tids) return -ENOMEM;
+
+    struct kc_bench_perf *p = calloc(1, sizeof(*p));
+    if (p) {
+        p->nfds = n * KC_BENCH_PERF_COUNT;
+        p->fd = malloc((size_t)p->nfds * sizeof(int));
+        p->base = calloc((size_t)p->nfds, sizeof(*p->base));
+    }
+    if (!p || !p->fd || !p->base) {
+        if (p) { free(p->fd); free(p->base); free(p); }
+        free(tids);
+        return -ENOMEM;
+    }
+    /* A counter counts only if it opened on every thread; a partial sum
+     * would look like a real number. ESRCH: the thread exited meanwhile. */
+    int first_err = 0;
+    for (int c = 0; c < KC_BENCH_PERF_COUNT; c++) {
+        int opened = 0, failed = 0;
+        for (int t = 0; t < n; t++) {
+            int fd = perf_open_one(c, tids[t]);
+            p->fd[t * KC_BENCH_PERF_COUNT + c] = fd < 0 ? -1 : fd;
+            if (fd >= 0) opened++;
+            else if (fd != -ESRCH) { failed++; if (!first_err) first_err = fd; }
+        }
+        if (opened && !failed) { p->valid |= 1u << c; continue; }
+        for (int t = 0; t < n; t++) {
+            int *fd = &p->fd[t * KC_BENCH_PERF_COUNT + c];
+            if (*fd >= 0) { close(*fd); *fd = -1; }
+        }
+    }
+    free(tids);
+    if (!p->valid) {
+        kc_bench_perf_close(p);
+        return first_err == -EACCES || first_err == -EPERM ? -EACCES : -ENOTSUP;
+    }
+    *out = p;
+    return kc_bench_perf_start(p);
+}
+
+int kc_bench_perf_start(kc_bench_perf_t *p)
+{
+    if (!p) return -EINVAL;
+    for (int i = 0; i < p->nfds; i++) {
+        if (p->fd[i] >= 0 && perf_read_fd(p->fd[i], &p->base[i]) != 0) return -EIO;
+    }
+    return 0;
+}
+
+int kc_bench_perf_read(kc_bench_perf_t *p, kc_bench_perf_sample_t *out)
+{
+    if (!p || !out) return -EINVAL;
+    double sum[KC_BENCH_PERF_COUNT] = {0};
+    for (int i = 0; i < p->nfds; i++) {
+        struct perf_reading r;
+        if (p->fd[i] < 0 || perf_read_fd(p->fd[i], &r) != 0) continue;
+        uint64_t dv = r.value - p->base[i].value;
+        uint64_t de = r.enabled - p->base[i].enabled;
+        uint64_t dr = r.running - p->base[i].running;
+        double v = (double)dv;
+        if (dr && dr < de) v *= (double)de / (double)dr;
+        sum[i % KC_BENCH_PERF_COUNT] += v;
+    }
+    for (int c = 0; c < KC_BENCH_PERF_COUNT; c++) out->value[c] = (uint64_t)(sum[c] + 0.5);
+    out->valid = p->valid;
+    return 0;
+}
+
+void kc_bench_perf_close(kc_bench_perf_t *p)
+{
+    if (!p) return;
+    for (int i = 0; i < p->nfds; i++) if (p->fd[i] >= 0) close(p->fd[i]);
+    free(p->fd);
+    free(p->base);
+    free(p);
+}
+
+#else /* !__linux__: no perf_event_open (macOS has no unprivileged equivalent) */
+
+int kc_bench_perf_open(kc_bench_perf_t **out)
+{
+    if (out) *out = NULL;
+    return -ENOTSUP;
+}
+
+int kc_bench_perf_start(kc_bench_perf_t *p)
+{
+    (void)p;
+    return -ENOTSUP;
+}
+
+int kc_bench_perf_read(kc_bench_perf_t *p, kc_bench_perf_sample_t *out)
+{
+    (void)p;
+    if (out) memset(out, 0, sizeof(*out));
+    return -ENOTSUP;
+}
+
+void kc_bench_perf_close(kc_bench_perf_t *p)
+{
+    (void)p;
+}
+
+#endif
@@ -0,0 +1,280 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Elastic blocking pool: threads for calls that block their thread. See
+ * kc_blocking_internal.h for the design. */
+#define _GNU_SOURCE 1
+#include <pthread.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <time.h>
+#include <sched.h>
+
+#include "kcoro_sched.h"
+#include "kcoro_config.h"
+#include "kc_blocking_internal.h"
+#include "kcoro_stack_internal.h"
+#include "kcoro_port.h"
+#include "kc_clock_internal.h"
+
+typedef struct kc_blocking_job {
+    struct kc_blocking_job *next;
+    kc_task_fn fn;       /* task job */
+    void *arg;
+    kcoro_t *co;         /* coroutine job: resume co, then hand it back */
+    kc_sched_t *home;
+    int in_caller;       /* block_begin owns (and frees) this job */
+    int failed;          /* block_begin fallback: resumed on its worker */
+} kc_blocking_job_t;
+
+static struct {
+    pthread_mutex_t mu;
+    pthread_cond_t cv;
+    kc_blocking_job_t *head, *tail;
+    int queued, threads, idle, peak, max_threads;
+    int cv_monotonic;    /* cv re-made on CLOCK_MONOTONIC before the first thread */
+    unsigned long tasks, migrations, spawn_failures;
+#ifdef __linux__
+    int has_affinity;
+    cpu_set_t affinity;
+#endif
+} g_pool = {
+    .mu = PTHREAD_MUTEX_INITIALIZER,
+    .cv = PTHREAD_COND_INITIALIZER,
+    .max_threads = KCORO_BLOCKING_MAX_THREADS,
+};
+
+/* Pool-thread state. A migrated coroutine reads these from whichever thread
+ * it is on, so the accesses stay out of line (see kcoro_core.c). */
+static __thread kcoro_t *tls_pool_main; /* created on the first coroutine job */
+static __thread kcoro_t *tls_pool_co;   /* coroutine this pool thread resumed */
+static __thread int tls_block_end;      /* tls_pool_co left via block_end */
+
+__attribute__((noinline)) static kcoro_t* tls_get_pool_co(void)
+{ __asm__ __volatile__("" ::: "memory"); return tls_pool_co; }
+__attribute__((noinline)) static void tls_mark_block_end(void)
+{ __asm__ __volatile__("" ::: "memory"); tls_block_end = 1; }
+
+static void pool_run_co(kcoro_t *co, kc_sched_t *home)
+{
+    if (!home) home = kc_sched_default();
+    int expected = 0;
+    if (!atomic_compare_exchange_strong_explicit(&co->running_flag, &expected, 1,
+                                                 memory_order_acq_rel, memory_order_relaxed)) {
+        /* A stray wake got it onto a worker first; it blocks there instead. */
+        kcoro_release(co);
+        return;
+    }
+    if (!tls_pool_main && !(tls_pool_main = kcoro_create_main())) {
+        atomic_store_explicit(&co->running_flag, 0, memory_order_release);
+        if (home) kc_sched_enqueue_ready(home, co);
+        kcoro_release(co);
+        return;
+    }
+    kcoro_set_thread_main(tls_pool_main);
+    co->main_co = tls_pool_main;
+    tls_pool_co = co;
+    tls_block_end = 0;
+    kcoro_resume(co);
+    tls_pool_co = NULL;
+    if (co->state == KCORO_FINISHED) {
+        kcoro_stack_reclaim(co);
+        atomic_store_explicit(&co->running_flag, 0, memory_order_release);
+        kcoro_release(co);
+        return;
+    }
+    atomic_store_explicit(&co->running_flag, 0, memory_order_release);
+    if (home && (tls_block_end || co->state == KCORO_READY || co->state == KCORO_SUSPENDED))
+        kc_sched_enqueue_ready(home, co);
+    kcoro_release(co);
+}
+
+static void* pool_main(void *arg)
+{
+    (void)arg;
+    pthread_mutex_lock(&g_pool.mu);
+    for (;;) {
+        while (!g_pool.head && g_pool.threads <= g_pool.max_threads) {
+            struct timespec ts;
+            kc_clock_abstime_ms(&ts, KC_PORT_PTHREAD_COND_CLOCK, KCORO_BLOCKING_IDLE_MS);
+            g_pool.idle++;
+            int rc = pthread_cond_timedwait(&g_pool.cv, &g_pool.mu, &ts);
+            g_pool.idle--;
+            if (rc == ETIMEDOUT && !g_pool.head) goto out;
+        }
+        if (!g_pool.head) break; /* over a lowered cap */
+        kc_blocking_job_t *job = g_pool.head;
+        g_pool.head = job->next;
+        if (!g_pool.head) g_pool.tail = NULL;
+        g_pool.queued--;
+        if (job->co) g_pool.migrations++; else g_pool.tasks++;
+        pthread_mutex_unlock(&g_pool.mu);
+
+        if (job->co) {
+            kcoro_t *co = job->co;
+            kc_sched_t *home = job->home;
+            /* An in-caller job may be freed as soon as co runs. */
+            if (!job->in_caller) free(job);
+            pool_run_co(co, home);
+        } else {
+            job->fn(job->arg);
+            free(job);
+        }
+        pthread_mutex_lock(&g_pool.mu);
+    }
+out:
+    g_pool.threads--;
+    pthread_mutex_unlock(&g_pool.mu);
+    if (tls_pool_main) { kcoro_destroy(tls_pool_main); tls_pool_main = NULL; }
+    return NULL;
+}
+
+static int pool_start_locked(void)
+{
+    pthread_attr_t attr;
+    pthread_t thr;
+    if (!g_pool.cv_monotonic) {
+        /* No pool thread yet, so nothing waits on the static one. */
+        pthread_cond_destroy(&g_pool.cv);
+        if (kc_posix_cond_init_monotonic(&g_pool.cv) != 0) return -1;
+        g_pool.cv_monotonic = 1;
+    }
+    if (pthread_attr_init(&attr) != 0) return -1;
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+#ifdef __linux__
+    if (g_pool.has_affinity) pthread_attr_setaffinity_np(&attr, sizeof(g_pool.affinity), &g_pool.affinity);
+#endif
+    int rc = pthread_create(&thr, &attr, pool_main, NULL);
+    pthread_attr_destroy(&attr);
+    if (rc != 0) { g_pool.spawn_failures++; return -1; }
+    if (++g_pool.threads > g_pool.peak) g_pool.peak = g_pool.threads;
+    return 0;
+}
+
+static int pool_submit(kc_blocking_job_t *job)
+{
+    pthread_mutex_lock(&g_pool.mu);
+    if (g_pool.queued + 1 > g_pool.idle && g_pool.threads < g_pool.max_threads &&
+        pool_start_locked() != 0 && g_pool.threads == 0) {
+        pthread_mutex_unlock(&g_pool.mu);
+        return -1;
+    }
+    job->next = NULL;
+    if (g_pool.tail) g_pool.tail->next = job; else g_pool.head = job;
+    g_pool.tail = job;
+    g_pool.queued++;
+    pthread_cond_signal(&g_pool.cv);
+    pthread_mutex_unlock(&g_pool.mu);
+    return 0;
+}
+
+int kc_blocking_spawn(kc_task_fn fn, void *arg)
+{
+    if (!fn) return -1;
+    kc_blocking_job_t *job = (kc_blocking_job_t*)calloc(1, sizeof(*job));
+    if (!job) return -1;
+    job->fn = fn;
+    job->arg = arg;
+    if (pool_submit(job) != 0) { free(job); return -1; }
+    return 0;
+}
+
+int kc_blocking_submit_co(kcoro_t *co, kc_sched_t *home)
+{
+    if (!co) return -1;
+    kc_blocking_job_t *job = (kc_blocking_job_t*)calloc(1, sizeof(*job));
+    if (!job) return -1;
+    job->co = co;
+    job->home = home;
+    if (pool_submit(job) != 0) { free(job); return -1; }
+    return 0;
+}
+
+int kc_blocking_set_limits(int max_threads, const int *cpus, int ncpus)
+{
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int i = 0; cpus && i < ncpus; i++) {
+        if (cpus[i] < 0 || cpus[i] >= CPU_SETSIZE) return -EINVAL;
+        CPU_SET(cpus[i], &set);
+    }
+#else
+    (void)cpus; (void)ncpus;
+#endif
+    pthread_mutex_lock(&g_pool.mu);
+    if (max_threads > 0) g_pool.max_threads = max_threads;
+#ifdef __linux__
+    g_pool.has_affinity = cpus && ncpus > 0;
+    g_pool.affinity = set;
+#endif
+    pthread_cond_broadcast(&g_pool.cv); /* idle threads over the cap exit */
+    pthread_mutex_unlock(&g_pool.mu);
+    return 0;
+}
+
+/* Runs on the worker once the coroutine has switched out. */
+static void block_handoff(void *arg)
+{
+    kc_blocking_job_t *job = (kc_blocking_job_t*)arg;
+    kcoro_t *co = job->co;
+    kc_sched_t *home = job->home;
+    if (pool_submit(job) == 0) return;
+    /* No pool thread: back onto the scheduler, blocking in place. */
+    job->failed = 1;
+    kc_sched_enqueue_ready(home, co);
+    kcoro_release(co);
+}
+
+int kc_sched_block_begin(void)
+{
+    kcoro_t *co = kcoro_current();
+    kc_sched_t *s = kc_sched_current();
+    if (!co || !s) return -1;
+    kc_blocking_job_t *job = (kc_blocking_job_t*)calloc(1, sizeof(*job));
+    if (!job) return -1;
+    job->co = co;
+    job->home = s;
+    job->in_caller = 1;
+    kcoro_retain(co); /* the pool's hold */
+    if (kc_sched_park_release(block_handoff, job) != 0) {
+        kcoro_release(co);
+        free(job);
+        return -1;
+    }
+    int rc = job->failed ? -1 : 0;
+    free(job);
+    return rc;
+}
+
+void kc_sched_block_end(void)
+{
+    kcoro_t *co = kcoro_current();
+    if (!co || tls_get_pool_co() != co) return;
+    tls_mark_block_end();
+    kcoro_park();
+}
+
+int kc_run_blocking(kc_task_fn fn, void *arg)
+{
+    if (!fn) return -1;
+    if (kc_sched_block_begin() == 0) {
+        fn(arg);
+        kc_sched_block_end();
+    } else {
+        fn(arg);
+    }
+    return 0;
+}
+
+void kc_blocking_get_stats(kc_blocking_stats_t *out)
+{
+    if (!out) return;
+    pthread_mutex_lock(&g_pool.mu);
+    out->threads = (unsigned long)g_pool.threads;
+    out->idle = (unsigned long)g_pool.idle;
+    out->peak = (unsigned long)g_pool.peak;
+    out->tasks = g_pool.tasks;
+    out->migrations = g_pool.migrations;
+    out->spawn_failures = g_pool.spawn_failures;
+    pthread_mutex_unlock(&g_pool.mu);
+}
@@ -0,0 +1,31 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include "../../include/kcoro_core.h"
+#include "../../include/kcoro_sched.h"
+
+/* Elastic blocking pool. Internal to kc_blocking.c / kc_dispatch.c; the
+ * public surface (kc_sched_block_begin/end, kc_run_blocking,
+ * kc_blocking_spawn) is declared in kcoro_sched.h.
+ *
+ * - One process-wide pool of detached threads behind a mutex-protected FIFO.
+ *   A submit starts a thread whenever queued work would outnumber idle
+ *   threads (up to max_threads); a thread idle for KCORO_BLOCKING_IDLE_MS, or
+ *   over the cap after it was lowered, exits.
+ * - Coroutine hand-off goes through kc_sched_park_release: the hook runs on
+ *   the worker after the coroutine has fully switched out (running_flag
+ *   dropped, shared stack saved), and only then queues it here, so a pool
+ *   thread never resumes it while the worker still is on its stack.
+ * - A pool thread resumes a coroutine the way a worker does (running_flag,
+ *   its own main context, shared-stack settle on switch-out). When it comes
+ *   back through kc_sched_block_end, or yields, it is requeued on its home
+ *   scheduler; a coroutine parked by anything else is left to its waker. */
+
+/* Resume a claimed, retained coroutine on a pool thread, then requeue it on
+ * `home` (or the default scheduler) when it leaves the pool. The hold
+ * transfers to the pool. 0, or -1 when no pool thread can be started. */
+int kc_blocking_submit_co(kcoro_t *co, kc_sched_t *home);
+
+/* Thread cap (<= 0 keeps the current one) and the CPU set new pool threads
+ * are confined to (NULL/0 => no affinity). 0, or -EINVAL for a bad CPU. */
+int kc_blocking_set_limits(int max_threads, const int *cpus, int ncpus);
@@ -0,0 +1,238 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/*
+ * kc_bufpool.c — fixed-size zero-copy buffers carved out of a region
+ * -------------------------------------------------------------------
+ *
+ * Layout
+ * - A pool splits one registered region into `count` buffers of `stride`
+ *   bytes (the requested size rounded up to a cache line). Buffer i is at
+ *   base + i * stride; its reference count lives in a side array, so the
+ *   whole buffer is payload.
+ *
+ * Caches
+ * - Free buffers sit in a depot (a mutex-guarded index stack) and in
+ *   KCORO_BUFPOOL_CACHES small per-thread caches. Each thread is given a
+ *   cache slot the first time it touches any pool, so scheduler workers
+ *   land on distinct slots and their cache locks stay uncontended; threads
+ *   beyond the slot count share. An empty cache refills half its capacity
+ *   from the depot (or, with the depot empty, from another cache) and a full
+ *   one spills half back, so a producer/consumer pair on two workers moves
+ *   buffers in batches rather than one by one.
+ *
+ * Lifetime
+ * - kc_bufpool_get hands out a buffer with one reference; kc_bufpool_retain
+ *   adds one per extra consumer (fan-out) and the last kc_bufpool_release
+ *   puts it back in the releasing thread's cache. The pool holds a
+ *   reference on its region, so kc_region_deregister waits for
+ *   kc_bufpool_destroy.
+ */
+#include <errno.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include "../../include/kcoro.h"
+#include "../../include/kcoro_zcopy.h"
+#include "../../include/kcoro_config.h"
+
+#define BUFPOOL_ALIGN 64
+/* Buffers moved per refill from, or spill to, the depot. */
+#define BUFPOOL_BATCH (KCORO_BUFPOOL_CACHE > 1 ? KCORO_BUFPOOL_CACHE / 2 : 1)
+
+struct kc_bufpool_cache {
+    atomic_flag lock;
+    unsigned n;
+    uint32_t idx[KCORO_BUFPOOL_CACHE];
+    unsigned long hits, misses, empty;
+} __attribute__((aligned(64)));
+
+struct kc_bufpool {
+    kc_region_t *reg;
+    unsigned char *base;
+    size_t stride;
+    uint32_t count;
+    _Atomic(uint32_t) *refs;
+    /* depot: free indices beyond the caches */
+    pthread_mutex_t mu;
+    uint32_t *depot;
+    uint32_t depot_n;
+    _Atomic(uint32_t) in_use;
+    struct kc_bufpool_cache cache[KCORO_BUFPOOL_CACHES];
+};
+
+static _Atomic unsigned g_slot_next;
+static __thread unsigned tls_slot = UINT32_MAX;
+
+static struct kc_bufpool_cache *cache_lock(kc_bufpool_t *p)
+{
+    if (tls_slot == UINT32_MAX)
+        tls_slot = atomic_fetch_add_explicit(&g_slot_next, 1, memory_order_relaxed) % KCORO_BUFPOOL_CACHES;
+    struct kc_bufpool_cache *c = &p->cache[tls_slot];
+    /* Held for a few loads and stores; only a preempted holder makes us wait. */
+    while (atomic_flag_test_and_set_explicit(&c->lock, memory_order_acquire)) sched_yield();
+    return c;
+}
+
+static void cache_unlock(struct kc_bufpool_cache *c)
+{
+    atomic_flag_clear_explicit(&c->lock, memory_order_release);
+}
+
+/* Depot empty: take half of another thread's cache. Only try-locks, since
+ * the caller already holds its own cache. Returns how many moved. */
+static unsigned cache_steal(kc_bufpool_t *p, struct kc_bufpool_cache *c)
+{
+    for (int k = 0; k < KCORO_BUFPOOL_CACHES; k++) {
+        struct kc_bufpool_cache *v = &p->cache[k];
+        if (v == c || atomic_flag_test_and_set_explicit(&v->lock, memory_order_acquire)) continue;
+        unsigned take = (v->n + 1) / 2;
+        while (take--) c->idx[c->n++] = v->idx[--v->n];
+        cache_unlock(v);
+        if (c->n) return c->n;
+    }
+    return 0;
+}
+
+int kc_bufpool_create(kc_bufpool_t **out, kc_region_t *reg, size_t buf_size)
+{
+    if (!out || !reg || buf_size == 0 || buf_size > SIZE_MAX - BUFPOOL_ALIGN) return -EINVAL;
+    *out = NULL;
+    unsigned long id = 0;
+    size_t len = 0;
+    (void)kc_region_export_id(reg, &id);
+    unsigned char *base = (unsigned char*)kc_region_addr(reg, &len);
+    size_t stride = (buf_size + BUFPOOL_ALIGN - 1) & ~(size_t)(BUFPOOL_ALIGN - 1);
+    size_t count = len / stride;
+    if (count == 0 || count > UINT32_MAX) return -EINVAL;
+    /* Held until destroy: the buffers must outlive the pool. */
+    if (kc_region_get(id) != reg) return -ENOENT;
+    kc_bufpool_t *p = (kc_bufpool_t*)aligned_alloc(64, (sizeof(*p) + 63) & ~(size_t)63);
+    uint32_t *depot = (uint32_t*)malloc(count * sizeof(uint32_t));
+    _Atomic(uint32_t) *refs = (_Atomic(uint32_t)*)calloc(count, sizeof(*refs));
+    if (!p || !depot || !refs) {
+        free(p); free(depot); free(refs);
+        kc_region_put(reg);
+        return -ENOMEM;
+    }
+    memset(p, 0, sizeof(*p));
+    p->reg = reg;
+    p->base = base;
+    p->stride = stride;
+    p->count = (uint32_t)count;
+    p->refs = refs;
+    p->depot = depot;
+    /* Lowest addresses on top, so a lightly used pool stays compact. */
+    for (uint32_t i = 0; i < p->count; i++) depot[i] = p->count - 1 - i;
+    p->depot_n = p->count;
+    pthread_mutex_init(&p->mu, NULL);
+    for (int i = 0; i < KCORO_BUFPOOL_CACHES; i++) atomic_flag_clear(&p->cache[i].lock);
+    *out = p;
+    return 0;
+}
+
+int kc_bufpool_destroy(kc_bufpool_t *p)
+{
+    if (!p) return -EINVAL;
+    if (atomic_load(&p->in_use) != 0) return -EBUSY;
+    pthread_mutex_destroy(&p->mu);
+    kc_region_put(p->reg);
+    free(p->depot);
+    free((void*)p->refs);
+    free(p);
+    return 0;
+}
+
+void *kc_bufpool_get(kc_bufpool_t *p)
+{
+    if (!p) return NULL;
+    struct kc_bufpool_cache *c = cache_lock(p);
+    if (c->n) {
+        c->hits++;
+    } else {
+        c->misses++;
+        pthread_mutex_lock(&p->mu);
+        while (c->n < BUFPOOL_BATCH && p->depot_n) c->idx[c->n++] = p->depot[--p->depot_n];
+        pthread_mutex_unlock(&p->mu);
+        if (!c->n && !cache_steal(p, c)) {
+            c->empty++;
+            cache_unlock(c);
+            return NULL;
+        }
+    }
+    uint32_t i = c->idx[--c->n];
+    cache_unlock(c);
+    atomic_store_explicit(&p->refs[i], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&p->in_use, 1, memory_order_relaxed);
+    return p->base + (size_t)i * p->stride;
+}
+
+/* Index of the buffer holding ptr, or -1. */
+static long buf_index(const kc_bufpool_t *p, const void *ptr)
+{
+    uintptr_t a = (uintptr_t)ptr, lo = (uintptr_t)p->base;
+    if (a < lo || a - lo >= (uintptr_t)p->count * p->stride) return -1;
+    return (long)((a - lo) / p->stride);
+}
+
+int kc_bufpool_retain(kc_bufpool_t *p, void *buf)
+{
+    long i = p ? buf_index(p, buf) : -1;
+    if (i < 0) return -EINVAL;
+    uint32_t old = atomic_load_explicit(&p->refs[i], memory_order_relaxed);
+    do {
+        if (old == 0 || old == UINT32_MAX) return -EINVAL; /* free, or saturated */
+    } while (!atomic_compare_exchange_weak_explicit(&p->refs[i], &old, old + 1,
+                                                    memory_order_relaxed, memory_order_relaxed));
+    return 0;
+}
+
+int kc_bufpool_release(kc_bufpool_t *p, void *buf)
+{
+    long i = p ? buf_index(p, buf) : -1;
+    if (i < 0) return -EINVAL;
+    uint32_t old = atomic_load_explicit(&p->refs[i], memory_order_relaxed);
+    do {
+        if (old == 0) return -EINVAL; /* already back in the pool */
+    } while (!atomic_compare_exchange_weak_explicit(&p->refs[i], &old, old - 1,
+                                                    memory_order_acq_rel, memory_order_relaxed));
+    if (old > 1) return 0;
+    atomic_fetch_sub_explicit(&p->in_use, 1, memory_order_relaxed);
+    struct kc_bufpool_cache *c = cache_lock(p);
+    if (c->n == KCORO_BUFPOOL_CACHE) {
+        pthread_mutex_lock(&p->mu);
+        for (unsigned k = 0; k < BUFPOOL_BATCH; k++) p->depot[p->depot_n++] = c->idx[--c->n];
+        pthread_mutex_unlock(&p->mu);
+    }
+    c->idx[c->n++] = (uint32_t)i;
+    cache_unlock(c);
+    return 0;
+}
+
+size_t kc_bufpool_buf_size(const kc_bufpool_t *p)
+{
+    return p ? p->stride : 0;
+}
+
+kc_region_t *kc_bufpool_region(const kc_bufpool_t *p)
+{
+    return p ? p->reg : NULL;
+}
+
+int kc_bufpool_get_stats(kc_bufpool_t *p, struct kc_bufpool_stats *out)
+{
+    if (!p || !out) return -EINVAL;
+    memset(out, 0, sizeof(*out));
+    for (int i = 0; i < KCORO_BUFPOOL_CACHES; i++) {
+        struct kc_bufpool_cache *c = &p->cache[i];
+        while (atomic_flag_test_and_set_explicit(&c->lock, memory_order_acquire)) sched_yield();
+        out->hits += c->hits;
+        out->misses += c->misses;
+        out->empty += c->empty;
+        cache_unlock(c);
+    }
+    out->capacity = p->count;
+    out->in_use = atomic_load_explicit(&p->in_use, memory_order_relaxed);
+    return 0;
+}
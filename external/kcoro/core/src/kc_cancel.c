@@ -4,14 +4,20 @@
 
 #include "../../include/kcoro_port.h"
 #include "../../include/kcoro.h"
+#include "kc_cancel_internal.h"
+#include "kc_wake_batch_internal.h"
+#include "kc_clock_internal.h"
 
 struct kc_cancel_child { struct kc_cancel *child; struct kc_cancel_child *next; };
+struct kc_cancel_watch { void (*fn)(void *arg); void *arg; struct kc_cancel_watch *next; };
 
 struct kc_cancel {
     atomic_int  state;  /* 0 = active, 1 = cancelled */
     KC_MUTEX_T  mu;
     KC_COND_T   cv;
     struct kc_cancel_child *children; /* linked children for propagation */
+    struct kc_cancel_watch *watches;  /* run once on trigger, under mu */
+    struct kc_cancel_wait  *waiters, *waiters_tail; /* coroutines in a _c op, oldest first */
 };
 
 int kc_cancel_init(kc_cancel_t **out)
@@ -20,30 +26,157 @@ int kc_cancel_init(kc_cancel_t **out)
     struct kc_cancel *t = KC_ALLOC(sizeof(*t));
     if (!t) return -ENOMEM;
     atomic_store(&t->state, 0);
+    t->children = NULL;
+    t->watches = NULL;
+    t->waiters = t->waiters_tail = NULL;
     KC_MUTEX_INIT(&t->mu);
     KC_COND_INIT(&t->cv);
     *out = (kc_cancel_t*)t;
     return 0;
 }
 
+/* Re-enqueue a registered coroutine through wakes. One that is not parked
+ * yet (ARMED is set by the park hook after switch-out) sees FIRED itself. */
+static void kc_cancel_wake(struct kc_cancel_wait *w, struct kc_wake_batch *wakes)
+{
+    if (atomic_exchange(&w->state, KC_CANCEL_WAIT_FIRED) != KC_CANCEL_WAIT_ARMED) return;
+    kc_wake_batch_add(wakes, w->sched ? w->sched : kc_sched_default(), w->co, KC_LANE_INHERIT);
+}
+
+/* State already flipped to 1 by the caller: wake waiters, run watches and
+ * cascade to children. Watches run under mu so kc_cancel_unwatch can wait
+ * for one in flight; parked coroutines are enqueued under mu so
+ * kc_cancel_wait_end can free its record once it got the lock. */
+static void kc_cancel_fire(struct kc_cancel *t)
+{
+    KC_MUTEX_LOCK(&t->mu);
+    KC_COND_BROADCAST(&t->cv);
+    struct kc_cancel_wait *cw = t->waiters;
+    t->waiters = t->waiters_tail = NULL;
+    struct kc_wake_batch wakes;
+    kc_wake_batch_init(&wakes, 0);
+    while (cw) {
+        struct kc_cancel_wait *n = cw->next;
+        cw->prev = cw->next = NULL;
+        cw->linked = 0;
+        kc_cancel_wake(cw, &wakes);
+        cw = n;
+    }
+    kc_wake_batch_flush(&wakes);
+    struct kc_cancel_watch *w = t->watches;
+    t->watches = NULL;
+    while (w) {
+        struct kc_cancel_watch *n = w->next;
+        w->fn(w->arg);
+        KC_FREE(w);
+        w = n;
+    }
+    /* propagate to children (and through them, to their children) */
+    for (struct kc_cancel_child *ln = t->children; ln; ln = ln->next) {
+        int expected = 0;
+        if (atomic_compare_exchange_strong(&ln->child->state, &expected, 1))
+            kc_cancel_fire(ln->child);
+    }
+    KC_MUTEX_UNLOCK(&t->mu);
+}
+
 void kc_cancel_trigger(kc_cancel_t *h)
 {
     if (!h) return;
     struct kc_cancel *t = (struct kc_cancel*)h;
     int expected = 0;
-    if (atomic_compare_exchange_strong(&t->state, &expected, 1)) {
-        KC_MUTEX_LOCK(&t->mu);
-        KC_COND_BROADCAST(&t->cv);
-        /* propagate to children */
-        for (struct kc_cancel_child *ln = t->children; ln; ln = ln->next) {
-            atomic_store(&ln->child->state, 1);
-            /* cascade broadcast to wake any waiters on the child */
-            KC_MUTEX_LOCK(&ln->child->mu);
-            KC_COND_BROADCAST(&ln->child->cv);
-            KC_MUTEX_UNLOCK(&ln->child->mu);
+    if (atomic_compare_exchange_strong(&t->state, &expected, 1))
+        kc_cancel_fire(t);
+}
+
+int kc_cancel_watch(kc_cancel_t *h, void (*fn)(void *arg), void *arg)
+{
+    if (!h || !fn) return -EINVAL;
+    struct kc_cancel *t = (struct kc_cancel*)h;
+    struct kc_cancel_watch *w = KC_ALLOC(sizeof(*w));
+    if (!w) return -ENOMEM;
+    w->fn = fn; w->arg = arg;
+    KC_MUTEX_LOCK(&t->mu);
+    if (atomic_load(&t->state) != 0) {
+        /* Already fired (or firing on another thread, which holds mu
+         * until its watches ran): run it here instead. */
+        KC_MUTEX_UNLOCK(&t->mu);
+        KC_FREE(w);
+        fn(arg);
+        return 0;
+    }
+    w->next = t->watches;
+    t->watches = w;
+    KC_MUTEX_UNLOCK(&t->mu);
+    return 0;
+}
+
+void kc_cancel_unwatch(kc_cancel_t *h, void (*fn)(void *arg), void *arg)
+{
+    if (!h || !fn) return;
+    struct kc_cancel *t = (struct kc_cancel*)h;
+    KC_MUTEX_LOCK(&t->mu);
+    for (struct kc_cancel_watch **pp = &t->watches; *pp; pp = &(*pp)->next) {
+        if ((*pp)->fn == fn && (*pp)->arg == arg) {
+            struct kc_cancel_watch *dead = *pp;
+            *pp = dead->next;
+            KC_FREE(dead);
+            break;
         }
+    }
+    KC_MUTEX_UNLOCK(&t->mu);
+}
+
+struct kc_cancel_wait *kc_cancel_wait_begin(struct kc_cancel_wait *local, const kc_cancel_t *h,
+                                            int *cancelled)
+{
+    *cancelled = 0;
+    kcoro_t *co = kcoro_current();
+    if (!h || !co) return NULL;
+    struct kc_cancel *t = (struct kc_cancel*)h;
+    /* A shared stack is overwritten while the coroutine is parked, and the
+     * trigger reads the record exactly then. */
+    struct kc_cancel_wait *w = co->share ? KC_ALLOC(sizeof(*w)) : local;
+    if (!w) return NULL;
+    w->next = NULL;
+    w->tok = t;
+    w->outer = co->cancel_wait;
+    w->co = co;
+    w->sched = kc_sched_current();
+    atomic_store(&w->state, KC_CANCEL_WAIT_IDLE);
+    w->heap = (w != local);
+    KC_MUTEX_LOCK(&t->mu);
+    if (atomic_load(&t->state) != 0) {
         KC_MUTEX_UNLOCK(&t->mu);
+        if (w->heap) KC_FREE(w);
+        *cancelled = 1;
+        return NULL;
+    }
+    /* Oldest first: wakes then come in roughly the order the coroutines
+     * queued on their channels, so each finds its channel waiter at the
+     * head of the list when it drops it. */
+    w->prev = t->waiters_tail;
+    if (t->waiters_tail) t->waiters_tail->next = w; else t->waiters = w;
+    t->waiters_tail = w;
+    w->linked = 1;
+    KC_MUTEX_UNLOCK(&t->mu);
+    co->cancel_wait = w;
+    return w;
+}
+
+void kc_cancel_wait_end(struct kc_cancel_wait *w)
+{
+    if (!w) return;
+    struct kc_cancel *t = w->tok;
+    KC_MUTEX_LOCK(&t->mu);
+    if (w->linked) {
+        if (w->prev) w->prev->next = w->next; else t->waiters = w->next;
+        if (w->next) w->next->prev = w->prev; else t->waiters_tail = w->prev;
+        w->linked = 0;
     }
+    KC_MUTEX_UNLOCK(&t->mu);
+    w->co->cancel_wait = w->outer;
+    if (w->heap) KC_FREE(w);
 }
 
 int kc_cancel_is_set(const kc_cancel_t *h)
@@ -73,21 +206,8 @@ int kc_cancel_wait(const kc_cancel_t *h, long timeout_ms)
             KC_COND_WAIT(&t->cv, &t->mu);
         }
     } else {
-        /* Timed wait: use MONOTONIC when available to match cond attr */
         struct timespec ts;
-#ifdef CLOCK_MONOTONIC
-        clock_gettime(CLOCK_MONOTONIC, &ts);
-#else
-        clock_gettime(CLOCK_REALTIME, &ts);
-#endif
-        long sec = timeout_ms / 1000;
-        long nsec = (timeout_ms % 1000) * 1000000L;
-        ts.tv_sec += sec;
-        ts.tv_nsec += nsec;
-        if (ts.tv_nsec >= 1000000000L) { 
-            ts.tv_sec++; 
-            ts.tv_nsec -= 1000000000L; 
-        }
+        kc_clock_abstime_ms(&ts, KC_COND_CLOCK, timeout_ms);
         
         while (atomic_load(&t->state) == 0) {
             int wait_rc = KC_COND_TIMEDWAIT_ABS(&t->cv, &t->mu, &ts);
@@ -110,8 +230,11 @@ void kc_cancel_destroy(kc_cancel_t *h)
     KC_MUTEX_LOCK(&t->mu);
     struct kc_cancel_child *p = t->children;
     t->children = NULL;
+    struct kc_cancel_watch *w = t->watches;
+    t->watches = NULL;
     KC_MUTEX_UNLOCK(&t->mu);
     while (p) { struct kc_cancel_child *n = p->next; KC_FREE(p); p = n; }
+    while (w) { struct kc_cancel_watch *n = w->next; KC_FREE(w); w = n; }
     KC_MUTEX_DESTROY(&t->mu);
     KC_COND_DESTROY(&t->cv);
     KC_FREE(t);
@@ -122,16 +245,21 @@ static int kc_cancel_link_child(struct kc_cancel *parent, struct kc_cancel *chil
     if (!parent || !child) return -EINVAL;
     /* If parent is already cancelled, just cancel child now (no link). */
     if (atomic_load(&parent->state) != 0) {
-        atomic_store(&child->state, 1);
-        KC_MUTEX_LOCK(&child->mu);
-        KC_COND_BROADCAST(&child->cv);
-        KC_MUTEX_UNLOCK(&child->mu);
+        kc_cancel_trigger((kc_cancel_t*)child);
         return 0;
     }
     struct kc_cancel_child *ln = KC_ALLOC(sizeof(*ln));
     if (!ln) return -ENOMEM;
     ln->child = child; ln->next = NULL;
     KC_MUTEX_LOCK(&parent->mu);
+    /* Recheck under mu: once state is set the trigger may already have
+     * walked the list; while it is clear, the trigger will see this link. */
+    if (atomic_load(&parent->state) != 0) {
+        KC_MUTEX_UNLOCK(&parent->mu);
+        KC_FREE(ln);
+        kc_cancel_trigger((kc_cancel_t*)child);
+        return 0;
+    }
     ln->next = parent->children;
     parent->children = ln;
     KC_MUTEX_UNLOCK(&parent->mu);
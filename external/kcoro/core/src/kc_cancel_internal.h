@@ -0,0 +1,68 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+/* Cancel wakeups for coroutines parked in a _c channel op.
+ *
+ * The _c wrappers register the calling coroutine on its token for the
+ * length of the op (kc_cancel_wait_begin/_end); kc_cancel_trigger then
+ * re-enqueues every registered coroutine that is parked instead of leaving
+ * it to notice at the next slice. The park sites bracket each park:
+ *
+ * - kc_cancel_wait_arm in the park_release hook (after switch-out), so the
+ *   trigger only ever enqueues a coroutine that is fully switched out. 1
+ *   means the trigger already ran: the hook must wake the coroutine itself.
+ * - kc_cancel_wait_disarm once resumed; 1 when the token fired.
+ *
+ * Registration and the trigger's walk both hold the token's mutex, so a
+ * record is never touched after kc_cancel_wait_end returns. */
+
+#include <stdatomic.h>
+
+#include "../../include/kcoro.h"
+#include "../../include/kcoro_core.h"
+#include "../../include/kcoro_sched.h"
+
+enum { KC_CANCEL_WAIT_IDLE = 0, KC_CANCEL_WAIT_ARMED = 1, KC_CANCEL_WAIT_FIRED = 2 };
+
+struct kc_cancel_wait {
+    struct kc_cancel_wait *prev, *next; /* token's list (linked != 0) */
+    struct kc_cancel     *tok;
+    struct kc_cancel_wait *outer;       /* record of an enclosing _c op */
+    kcoro_t              *co;
+    kc_sched_t           *sched;
+    atomic_int            state;        /* KC_CANCEL_WAIT_* */
+    int                   linked;
+    int                   heap;         /* copied off a shared stack */
+};
+
+/* Register the current coroutine on t. Returns the live record (local, or a
+ * heap copy when the coroutine runs on a shared stack) installed as
+ * co->cancel_wait, or NULL when there is nothing to register: t already
+ * set (*cancelled = 1), no current coroutine or out of memory (the op then
+ * relies on the slice checks alone). */
+struct kc_cancel_wait *kc_cancel_wait_begin(struct kc_cancel_wait *local, const kc_cancel_t *t,
+                                            int *cancelled);
+void kc_cancel_wait_end(struct kc_cancel_wait *w);
+
+static inline int kc_cancel_wait_arm(kcoro_t *co)
+{
+    struct kc_cancel_wait *w = co ? co->cancel_wait : NULL;
+    if (!w) return 0;
+    int expected = KC_CANCEL_WAIT_IDLE;
+    return !atomic_compare_exchange_strong(&w->state, &expected, KC_CANCEL_WAIT_ARMED);
+}
+
+static inline int kc_cancel_wait_disarm(kcoro_t *co)
+{
+    struct kc_cancel_wait *w = co ? co->cancel_wait : NULL;
+    if (!w) return 0;
+    int expected = KC_CANCEL_WAIT_ARMED;
+    if (atomic_compare_exchange_strong(&w->state, &expected, KC_CANCEL_WAIT_IDLE)) return 0;
+    return expected == KC_CANCEL_WAIT_FIRED;
+}
+
+static inline int kc_cancel_wait_fired(const kcoro_t *co)
+{
+    const struct kc_cancel_wait *w = co ? co->cancel_wait : NULL;
+    return w && atomic_load(&w->state) == KC_CANCEL_WAIT_FIRED;
+}
@@ -7,6 +7,10 @@
 #include <stdio.h>
 #include <stdarg.h>
 #include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
 /*
  * kc_chan.c — Channel kinds and operations
  * ----------------------------------------
@@ -27,8 +31,15 @@
 #include "../../include/kcoro_core.h"
 #include "../../include/kcoro_sched.h"
 #include "../../include/kcoro_zcopy.h"
+#include "../../include/kc_mem.h"
 #include "kc_select_internal.h"
 #include "kc_chan_internal.h" /* single definition of struct kc_chan + helpers */
+#include "kc_clock_internal.h" /* kc_clock_coarse_ns, kc_clock_abstime */
+#include "kc_cancel_internal.h"  /* cancel wakes for _c ops */
+#include "kc_hist_internal.h"
+#include "kc_trace_internal.h"
+#include "kc_chan_rec_internal.h"
+#include "kc_wake_batch_internal.h"
 #include "../../include/kcoro_config_runtime.h"
 
 /* No compile-time debug macros; use runtime logging via kc_dbg()/KCORO_DEBUG. */
@@ -37,16 +48,37 @@
 
 /* kc_now_ns is provided inline in kc_chan_internal.h */
 
-/* Update throughput statistics - called with mutex held (only on sampled ops) */
-void kc_chan_emit_metrics_if_needed(struct kc_chan *ch, long now)
+/* -----------------------------------------------------------------------
+ * Metrics sampler
+ * -----------------------------------------------------------------------
+ * Channels with a metrics pipe are linked into a registry. One coroutine on
+ * the default scheduler wakes every channel.metrics.sample_ms, walks it and
+ * publishes an event per channel whose emit policy is met, so the data path
+ * only counts and a slow metrics consumer never delays a send or recv. The
+ * sampler exits when the registry empties and is respawned on the next
+ * kc_chan_enable_metrics_pipe. Lock order: g_metrics_mu, then ch->mu, then
+ * the pipe's lock.
+ * ----------------------------------------------------------------------- */
+
+static void kc_chan_ring_fold_stats_locked(struct kc_chan *ch);
+static void kc_chan_latest_fold_stats_locked(struct kc_chan *ch);
+
+static pthread_mutex_t g_metrics_mu = PTHREAD_MUTEX_INITIALIZER;
+static struct kc_chan *g_metrics_head;
+static int g_metrics_running;
+/* Set while a pipe is made, so auto_enable does not give the pipe a pipe. */
+static __thread int tls_making_metrics_pipe;
+
+/* Publish one event if the policy is met (g_metrics_mu held). */
+static void kc_chan_metrics_sample(struct kc_chan *ch, long now, unsigned long min_ops, long min_ns)
 {
-    if (!ch->metrics_pipe) return;
-    const struct kc_runtime_config *cfg = kc_runtime_config_get();
-    unsigned long min_ops = cfg ? cfg->chan_metrics_emit_min_ops : 1024UL;
-    long min_ns = (cfg ? cfg->chan_metrics_emit_min_ms : 50) * 1000000L;
+    KC_MUTEX_LOCK(&ch->mu);
+    if (!ch->metrics_pipe) { KC_MUTEX_UNLOCK(&ch->mu); return; }
+    if (ch->ring) kc_chan_ring_fold_stats_locked(ch);
+    else if (ch->latest) kc_chan_latest_fold_stats_locked(ch);
     unsigned long delta_ops = (ch->total_sends - ch->last_emit_sends) + (ch->total_recvs - ch->last_emit_recvs);
     long since_ns = now - ch->last_emit_time_ns;
-    if (delta_ops < min_ops && since_ns < min_ns) return;
+    if (delta_ops == 0 || (delta_ops < min_ops && since_ns < min_ns)) { KC_MUTEX_UNLOCK(&ch->mu); return; }
     struct kc_chan_metrics_event ev;
     ev.chan = ch;
     ev.total_sends = ch->total_sends;
@@ -58,8 +90,9 @@ void kc_chan_emit_metrics_if_needed(struct kc_chan *ch, long now)
     ev.delta_bytes_sent = ch->total_bytes_sent - ch->last_emit_bytes_sent;
     ev.delta_bytes_recv = ch->total_bytes_recv - ch->last_emit_bytes_recv;
     ev.first_op_time_ns = ch->first_op_time_ns;
-    ev.last_op_time_ns = ch->last_op_time_ns;
+    ev.last_op_time_ns = kc_chan_last_op_ns(ch);
     ev.emit_time_ns = now;
+    /* A full pipe drops the event; the next one carries the whole delta. */
     if (kc_chan_try_send((kc_chan_t*)ch->metrics_pipe, &ev) == 0) {
         ch->last_emit_sends = ch->total_sends;
         ch->last_emit_recvs = ch->total_recvs;
@@ -67,57 +100,148 @@ void kc_chan_emit_metrics_if_needed(struct kc_chan *ch, long now)
         ch->last_emit_bytes_recv = ch->total_bytes_recv;
         ch->last_emit_time_ns = now;
     }
+    KC_MUTEX_UNLOCK(&ch->mu);
+}
+
+static void kc_chan_metrics_sampler(void *arg)
+{
+    (void)arg;
+    for (;;) {
+        const struct kc_runtime_config *cfg = kc_runtime_config_get();
+        long sample_ms = cfg ? cfg->chan_metrics_sample_ms : 10;
+        unsigned long min_ops = cfg ? cfg->chan_metrics_emit_min_ops : 1024UL;
+        long min_ns = (cfg ? cfg->chan_metrics_emit_min_ms : 50) * 1000000L;
+        kc_sleep_ms(sample_ms > 0 ? (int)sample_ms : 1);
+        pthread_mutex_lock(&g_metrics_mu);
+        if (!g_metrics_head) {
+            g_metrics_running = 0;
+            pthread_mutex_unlock(&g_metrics_mu);
+            return;
+        }
+        long now = kc_now_ns();
+        for (struct kc_chan *ch = g_metrics_head; ch; ch = ch->metrics_next)
+            kc_chan_metrics_sample(ch, now, min_ops, min_ns);
+        pthread_mutex_unlock(&g_metrics_mu);
+    }
+}
+
+static void kc_chan_metrics_link(struct kc_chan *ch)
+{
+    int spawn = 0;
+    pthread_mutex_lock(&g_metrics_mu);
+    if (!ch->metrics_linked) {
+        ch->metrics_linked = 1;
+        ch->metrics_prev = NULL;
+        ch->metrics_next = g_metrics_head;
+        if (g_metrics_head) g_metrics_head->metrics_prev = ch;
+        g_metrics_head = ch;
+    }
+    if (!g_metrics_running) g_metrics_running = spawn = 1;
+    pthread_mutex_unlock(&g_metrics_mu);
+    if (spawn && kc_spawn_co(kc_sched_default(), kc_chan_metrics_sampler, NULL, 0, NULL) != 0) {
+        pthread_mutex_lock(&g_metrics_mu);
+        g_metrics_running = 0;
+        pthread_mutex_unlock(&g_metrics_mu);
+    }
+}
+
+static void kc_chan_metrics_unlink(struct kc_chan *ch)
+{
+    pthread_mutex_lock(&g_metrics_mu);
+    if (ch->metrics_linked) {
+        if (ch->metrics_prev) ch->metrics_prev->metrics_next = ch->metrics_next;
+        else g_metrics_head = ch->metrics_next;
+        if (ch->metrics_next) ch->metrics_next->metrics_prev = ch->metrics_prev;
+        ch->metrics_next = ch->metrics_prev = NULL;
+        ch->metrics_linked = 0;
+    }
+    pthread_mutex_unlock(&g_metrics_mu);
+}
+
+/* Per-side stats seqlock (struct kc_chan): the writer holds ch->mu, so
+ * there is one per side at a time and it never waits; readers retry. */
+static inline void kc_chan_stats_write_begin(_Atomic unsigned *seq)
+{
+    atomic_store_explicit(seq, atomic_load_explicit(seq, memory_order_relaxed) + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+static inline void kc_chan_stats_write_end(_Atomic unsigned *seq)
+{
+    atomic_store_explicit(seq, atomic_load_explicit(seq, memory_order_relaxed) + 1, memory_order_release);
+}
+
+/* One side's ops / bytes / last-op time as a set one writer left. */
+static void kc_chan_stats_read_side(struct kc_chan *ch, int is_send, unsigned long *ops,
+                                    unsigned long *bytes, long *last)
+{
+    _Atomic unsigned *seq = is_send ? &ch->send_seq : &ch->recv_seq;
+    for (unsigned spins = 0;; spins++) {
+        unsigned s0 = atomic_load_explicit(seq, memory_order_acquire);
+        if (!(s0 & 1)) {
+            *ops   = __atomic_load_n(is_send ? &ch->total_sends : &ch->total_recvs, __ATOMIC_RELAXED);
+            *bytes = __atomic_load_n(is_send ? &ch->total_bytes_sent : &ch->total_bytes_recv, __ATOMIC_RELAXED);
+            *last  = __atomic_load_n(is_send ? &ch->last_send_ns : &ch->last_recv_ns, __ATOMIC_RELAXED);
+            atomic_thread_fence(memory_order_acquire);
+            if (atomic_load_explicit(seq, memory_order_relaxed) == s0) return;
+        }
+        /* The writer was preempted inside its few stores. */
+        if (spins >= 64) sched_yield();
+    }
+}
+
+/* Timestamps (ch->mu held); FULL stats level only. */
+static inline void kc_chan_stats_time_locked(struct kc_chan *ch, long *last)
+{
+    if (ch->stats_level < KC_CHAN_STATS_FULL) return;
+    long now = kc_clock_coarse_ns();
+    if (ch->first_op_time_ns == 0) ch->first_op_time_ns = now;
+    *last = now;
 }
 
 static inline void kc_chan_update_send_stats_locked(struct kc_chan *ch)
 {
+    kc_chan_set_note_locked(ch, KC_CHAN_SET_RECV);
+    if (ch->stats_level == KC_CHAN_STATS_OFF) return;
+    kc_chan_stats_write_begin(&ch->send_seq);
     ch->total_sends++;
     ch->total_bytes_sent += ch->elem_sz;
-    /* Always record timing for every operation so duration becomes
-     * non-zero immediately (previously gated by emit_check). */
-    long now = kc_now_ns();
-    if (ch->first_op_time_ns == 0) ch->first_op_time_ns = now;
-    ch->last_op_time_ns = now;
-    if ((++ch->ops_since_emit_check & ch->emit_check_mask) == 0) {
-        kc_chan_emit_metrics_if_needed(ch, now);
-    }
+    kc_chan_stats_time_locked(ch, &ch->last_send_ns);
+    kc_chan_stats_write_end(&ch->send_seq);
 }
 
 static inline void kc_chan_update_recv_stats_locked(struct kc_chan *ch)
 {
+    kc_chan_set_note_locked(ch, KC_CHAN_SET_SEND);
+    if (ch->stats_level == KC_CHAN_STATS_OFF) return;
+    kc_chan_stats_write_begin(&ch->recv_seq);
     ch->total_recvs++;
     ch->total_bytes_recv += ch->elem_sz;
-    long now = kc_now_ns();
-    if (ch->first_op_time_ns == 0) ch->first_op_time_ns = now;
-    ch->last_op_time_ns = now;
-    if ((++ch->ops_since_emit_check & ch->emit_check_mask) == 0) {
-        kc_chan_emit_metrics_if_needed(ch, now);
-    }
+    kc_chan_stats_time_locked(ch, &ch->last_recv_ns);
+    kc_chan_stats_write_end(&ch->recv_seq);
 }
 
 /* Variant for zero-copy where the logical payload length may differ from elem_sz. */
 void kc_chan_update_send_stats_len_locked(struct kc_chan *ch, size_t len)
 {
+    kc_chan_set_note_locked(ch, KC_CHAN_SET_RECV);
+    if (ch->stats_level == KC_CHAN_STATS_OFF) return;
+    kc_chan_stats_write_begin(&ch->send_seq);
     ch->total_sends++;
     ch->total_bytes_sent += len;
-    long now = kc_now_ns();
-    if (ch->first_op_time_ns == 0) ch->first_op_time_ns = now;
-    ch->last_op_time_ns = now;
-    if ((++ch->ops_since_emit_check & ch->emit_check_mask) == 0) {
-        kc_chan_emit_metrics_if_needed(ch, now);
-    }
+    kc_chan_stats_time_locked(ch, &ch->last_send_ns);
+    kc_chan_stats_write_end(&ch->send_seq);
 }
 
 void kc_chan_update_recv_stats_len_locked(struct kc_chan *ch, size_t len)
 {
+    kc_chan_set_note_locked(ch, KC_CHAN_SET_SEND);
+    if (ch->stats_level == KC_CHAN_STATS_OFF) return;
+    kc_chan_stats_write_begin(&ch->recv_seq);
     ch->total_recvs++;
     ch->total_bytes_recv += len;
-    long now = kc_now_ns();
-    if (ch->first_op_time_ns == 0) ch->first_op_time_ns = now;
-    ch->last_op_time_ns = now;
-    if ((++ch->ops_since_emit_check & ch->emit_check_mask) == 0) {
-        kc_chan_emit_metrics_if_needed(ch, now);
-    }
+    kc_chan_stats_time_locked(ch, &ch->last_recv_ns);
+    kc_chan_stats_write_end(&ch->recv_seq);
 }
 
 /* Lightweight debug helper (enabled via KCORO_DEBUG env var). */
@@ -145,26 +269,78 @@ static void kc_dbg(const char *fmt, ...)
 static int __attribute__((unused)) timespec_from_ms(struct timespec *ts, long timeout_ms)
 {
     if (timeout_ms < 0) return -1; /* infinite */
-    struct timespec now;
-    /* Use CLOCK_MONOTONIC to match condition variables configured in port */
-#ifdef CLOCK_MONOTONIC
-    clock_gettime(CLOCK_MONOTONIC, &now);
-#else
-    clock_gettime(CLOCK_REALTIME, &now);
-#endif
-    
-    long sec = timeout_ms / 1000;
-    long nsec = (timeout_ms % 1000) * 1000000L;
-    ts->tv_sec = now.tv_sec + sec;
-    ts->tv_nsec = now.tv_nsec + nsec;
-    if (ts->tv_nsec >= 1000000000L) { 
-        ts->tv_sec++; 
-        ts->tv_nsec -= 1000000000L; 
-    }
+    kc_clock_abstime_ms(ts, KC_COND_CLOCK, timeout_ms);
     return 0;
 }
 
 /* Round up to next power-of-two (minimum 1). */
+/* ---- Waiter pool ----
+ * Every blocking op or select clause queues a waiter, so they are recycled
+ * through a bounded per-thread LIFO instead of malloc/free. A coroutine may
+ * own several queued waiters at once (select clauses, re-queued retries), so
+ * they are not embedded in kcoro_t. A pthread key destructor frees a
+ * thread's cache when it exits. The accessors stay out of line so the TLS
+ * address is never cached across a coroutine switch. */
+#ifndef KC_WAITER_CACHE_MAX
+#define KC_WAITER_CACHE_MAX 64
+#endif
+
+struct kc_waiter_cache {
+    struct kc_waiter *head;
+    unsigned count;
+    int registered;
+};
+
+static __thread struct kc_waiter_cache tls_waiter_cache;
+static pthread_key_t waiter_cache_key;
+static pthread_once_t waiter_cache_once = PTHREAD_ONCE_INIT;
+
+static void kc_waiter_cache_drain(void *arg)
+{
+    struct kc_waiter_cache *c = (struct kc_waiter_cache*)arg;
+    while (c->head) {
+        struct kc_waiter *w = c->head;
+        c->head = w->next;
+        free(w);
+        kc_mem_uncharge(KC_MEM_WAITERS, sizeof(*w));
+    }
+    c->count = 0;
+}
+
+static void kc_waiter_cache_key_init(void)
+{
+    (void)pthread_key_create(&waiter_cache_key, kc_waiter_cache_drain);
+}
+
+__attribute__((noinline)) struct kc_waiter* kc_waiter_alloc(void)
+{
+    struct kc_waiter_cache *c = &tls_waiter_cache;
+    struct kc_waiter *w = c->head;
+    if (w) {
+        c->head = w->next;
+        c->count--;
+        return w;
+    }
+    if (kc_mem_charge(KC_MEM_WAITERS, sizeof(*w)) != 0) return NULL;
+    w = (struct kc_waiter*)malloc(sizeof(*w));
+    if (!w) kc_mem_uncharge(KC_MEM_WAITERS, sizeof(*w));
+    return w;
+}
+
+__attribute__((noinline)) void kc_waiter_free(struct kc_waiter *w)
+{
+    struct kc_waiter_cache *c = &tls_waiter_cache;
+    if (c->count >= KC_WAITER_CACHE_MAX) { free(w); kc_mem_uncharge(KC_MEM_WAITERS, sizeof(*w)); return; }
+    if (!c->registered) {
+        pthread_once(&waiter_cache_once, kc_waiter_cache_key_init);
+        (void)pthread_setspecific(waiter_cache_key, c);
+        c->registered = 1;
+    }
+    w->next = c->head;
+    c->head = w;
+    c->count++;
+}
+
 static size_t kc_next_pow2(size_t x)
 {
     if (x < 2) return 1;
@@ -178,26 +354,298 @@ static size_t kc_next_pow2(size_t x)
 /* Compute ring index with optional mask fast-path. */
 /* kc_ring_idx is provided inline in kc_chan_internal.h */
 
-struct kc_wake {
-    kcoro_t *co;
-    kc_select_t *sel;
+/* Ring storage of buffered channels. Large rings are mmap'd so only the
+ * pages the tail has reached are resident; *mapped gets the mapping length
+ * (0 for malloc). */
+static unsigned char *kc_chan_buf_alloc(size_t bytes, size_t *mapped)
+{
+    *mapped = 0;
+    if (KCORO_CHAN_LAZY_RING_BYTES && bytes >= KCORO_CHAN_LAZY_RING_BYTES) {
+        void *p = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (p != MAP_FAILED) { *mapped = bytes; return (unsigned char*)p; }
+    }
+    return (unsigned char*)malloc(bytes);
+}
+
+static void kc_chan_buf_release(unsigned char *buf, size_t mapped)
+{
+    if (mapped) munmap(buf, mapped);
+    else free(buf);
+}
+
+void kc_chan_buf_trim_locked(struct kc_chan *ch)
+{
+    long now = kc_clock_coarse_ns();
+    if (now - ch->buf_trim_ns < KCORO_CHAN_RING_TRIM_MS * 1000000L) return;
+    ch->buf_trim_ns = now;
+    static size_t page;
+    if (!page) { long ps = sysconf(_SC_PAGESIZE); page = ps > 0 ? (size_t)ps : 4096; }
+    /* Keep the page under head: the next put lands there. */
+    uintptr_t base = (uintptr_t)ch->buf, end = base + ch->buf_map;
+    uintptr_t hot = (base + ch->head * ch->elem_sz) & ~(uintptr_t)(page - 1);
+#ifdef MADV_FREE
+    const int advice = MADV_FREE;
+#else
+    const int advice = MADV_DONTNEED;
+#endif
+    if (hot > base) (void)madvise((void*)base, hot - base, advice);
+    if (hot + page < end) (void)madvise((void*)(hot + page), end - hot - page, advice);
+}
+
+/* KC_UNLIMITED segment list (ch->mu held). */
+
+/* Swap the full tail segment for a stub and write its payload to the spill
+ * file; returns what now sits at that place in the list. Left resident when
+ * there is no stub memory or the write fails. */
+static struct kc_chan_seg *kc_chan_seg_spill_tail_locked(struct kc_chan *ch)
+{
+    struct kc_chan_seg *s = ch->seg_tail, *stub = malloc(sizeof(*stub));
+    size_t bytes = ch->seg_elems * ch->elem_sz;
+    if (!stub) return s;
+    if (kc_chan_spill_write(&ch->spill, s->data, bytes, &stub->spill_off) != 0) {
+        free(stub);
+        return s;
+    }
+    stub->next = NULL;
+    ch->seg_before_tail->next = stub;
+    ch->seg_tail = stub;
+    kc_chan_spill_resident_sub(bytes);
+    free(s);
+    kc_mem_uncharge(KC_MEM_CHAN, sizeof(*s) + bytes);
+    return stub;
+}
+
+/* 0, -ENOMEM, or KC_EAGAIN when the KC_MEM_CHAN budget refuses a segment. */
+static int kc_chan_seg_link_locked(struct kc_chan *ch)
+{
+    size_t bytes = ch->seg_elems * ch->elem_sz;
+    /* The tail is full and, unless it is also the head, will be read last:
+     * under pressure it goes to disk rather than costing more memory. */
+    if (ch->seg_tail && ch->seg_tail->spill_off < 0 && ch->seg_before_tail &&
+        kc_chan_spill_pressure(bytes))
+        (void)kc_chan_seg_spill_tail_locked(ch);
+    struct kc_chan_seg *s = ch->seg_cache;
+    if (s) {
+        ch->seg_cache = s->next;
+        ch->seg_cached--;
+    } else {
+        if (kc_mem_charge(KC_MEM_CHAN, sizeof(*s) + bytes) != 0) return KC_EAGAIN;
+        s = malloc(sizeof(*s) + bytes);
+        if (!s) {
+            kc_mem_uncharge(KC_MEM_CHAN, sizeof(*s) + bytes);
+            kc_dbg("chan%p segment ENOMEM", (void*)ch);
+            return -ENOMEM;
+        }
+    }
+    s->next = NULL;
+    s->spill_off = -1;
+    if (ch->seg_tail) ch->seg_tail->next = s; else ch->seg_head = s;
+    ch->seg_before_tail = ch->seg_tail;
+    ch->seg_tail = s;
+    ch->tail = 0;
+    ch->capacity += ch->seg_elems;
+    kc_chan_spill_resident_add(bytes);
+    return 0;
+}
+
+/* Unlink the drained head segment; cache it or give it back to malloc. A
+ * spilled successor is read back into it instead, so reloading never
+ * allocates. */
+static void kc_chan_seg_retire_locked(struct kc_chan *ch)
+{
+    struct kc_chan_seg *s = ch->seg_head;
+    size_t bytes = ch->seg_elems * ch->elem_sz;
+    ch->seg_head = s->next;
+    if (!ch->seg_head) ch->seg_tail = NULL;
+    if (ch->seg_before_tail == s) ch->seg_before_tail = NULL;
+    ch->head = 0;
+    ch->capacity -= ch->seg_elems;
+    struct kc_chan_seg *stub = ch->seg_head;
+    if (stub && stub->spill_off >= 0) {
+        kc_chan_spill_read(ch->spill, s->data, bytes, stub->spill_off);
+        s->next = stub->next;
+        s->spill_off = -1;
+        if (ch->seg_before_tail == stub) ch->seg_before_tail = s;
+        if (ch->seg_tail == stub) ch->seg_tail = s;
+        ch->seg_head = s;
+        free(stub);
+        return;
+    }
+    kc_chan_spill_resident_sub(bytes);
+    if (ch->seg_cached < KCORO_UNLIMITED_SEG_CACHE) {
+        s->next = ch->seg_cache;
+        ch->seg_cache = s;
+        ch->seg_cached++;
+    } else {
+        free(s);
+        kc_mem_uncharge(KC_MEM_CHAN, sizeof(*s) + bytes);
+    }
+}
+
+/* After a take: an empty queue rewinds into its one segment, otherwise a
+ * fully consumed head segment is retired (it cannot also be the tail). */
+static void kc_chan_seg_advance_locked(struct kc_chan *ch)
+{
+    if (ch->count == 0) ch->head = ch->tail = 0;
+    else if (ch->head == ch->seg_elems) kc_chan_seg_retire_locked(ch);
+}
+
+/* Stubs of spilled segments are not charged; resident says whether the
+ * segments still count toward kc_chan_spill_resident (not the cache's). */
+static void kc_chan_seg_free_all(struct kc_chan_seg *s, size_t bytes, int resident)
+{
+    while (s) {
+        struct kc_chan_seg *next = s->next;
+        if (s->spill_off < 0) {
+            if (resident) kc_chan_spill_resident_sub(bytes);
+            kc_mem_uncharge(KC_MEM_CHAN, sizeof(*s) + bytes);
+        }
+        free(s);
+        s = next;
+    }
+}
+
+int kc_chan_seg_put_locked(struct kc_chan *ch, const void *src)
+{
+    if (!ch->seg_tail || ch->tail == ch->seg_elems) {
+        int rc = kc_chan_seg_link_locked(ch);
+        if (rc) return rc;
+    }
+    if (ch->wal) {
+        size_t logged;
+        int rc = kc_chan_wal_append(ch->wal, src, 1, &logged);
+        if (rc) return rc;
+    }
+    if (src) kc_chan_elem_copy(ch->seg_tail->data + (ch->tail * ch->elem_sz), src, ch->elem_sz);
+    ch->tail++;
+    ch->count++;
+    return 0;
+}
+
+void kc_chan_seg_take_locked(struct kc_chan *ch, void *dst)
+{
+    if (dst) kc_chan_elem_copy(dst, ch->seg_head->data + (ch->head * ch->elem_sz), ch->elem_sz);
+    ch->head++;
+    ch->count--;
+    kc_chan_seg_advance_locked(ch);
+}
+
+/* Latency recording (kc_chan_set_latency). Park samples go straight to the
+ * shards; queue latency needs the enqueue time of each element, kept in a
+ * FIFO of stamps beside the buffer. The FIFO always describes the newest
+ * lat->n of the ch->count queued elements, so a take records only while the
+ * two agree (lat->n == count): elements queued before enabling, or while a
+ * KC_UNLIMITED stamp could not be stored, pass through unmeasured. */
+struct kc_chan_lat {
+    _Atomic int on;
+    long   *ts;                 /* enqueue stamps, ring of cap (under mu) */
+    size_t  cap, head, n;
+    struct kc_hist_shard queue[KCORO_LAT_SHARDS];
+    struct kc_hist_shard send_park[KCORO_LAT_SHARDS];
+    struct kc_hist_shard recv_park[KCORO_LAT_SHARDS];
 };
 
+static int kc_chan_lat_grow_locked(struct kc_chan_lat *l, size_t want)
+{
+    size_t cap = l->cap ? l->cap : 16;
+    while (cap < want) cap *= 2;
+    long *ts = (long*)malloc(cap * sizeof(*ts));
+    if (!ts) return -ENOMEM;
+    for (size_t i = 0; i < l->n; i++) ts[i] = l->ts[(l->head + i) % l->cap];
+    free(l->ts);
+    l->ts = ts;
+    l->cap = cap;
+    l->head = 0;
+    return 0;
+}
+
+void kc_chan_lat_put_locked(struct kc_chan *ch, size_t n)
+{
+    struct kc_chan_lat *l = atomic_load_explicit(&ch->lat, memory_order_relaxed);
+    if (!atomic_load_explicit(&l->on, memory_order_relaxed)) return;
+    if (l->n + n > l->cap && kc_chan_lat_grow_locked(l, l->n + n) != 0) { l->n = 0; return; }
+    long now = kc_now_ns();
+    for (size_t i = 0; i < n; i++) l->ts[(l->head + l->n++) % l->cap] = now;
+}
+
+void kc_chan_lat_take_locked(struct kc_chan *ch, size_t n)
+{
+    struct kc_chan_lat *l = atomic_load_explicit(&ch->lat, memory_order_relaxed);
+    /* Untracked elements sit ahead of the tracked ones: skip past them */
+    size_t untracked = ch->count - l->n;
+    if (n <= untracked || !atomic_load_explicit(&l->on, memory_order_relaxed)) return;
+    struct kc_hist_shard *h = &l->queue[kc_hist_shard_for(KCORO_LAT_SHARDS)];
+    long now = kc_now_ns();
+    for (size_t i = untracked; i < n; i++) {
+        long d = now - l->ts[l->head];
+        kc_hist_record(h, d > 0 ? (unsigned long)d : 0);
+        l->head = (l->head + 1) % l->cap;
+        l->n--;
+    }
+}
+
+/* Wait timing (and the CHAN_BLOCK trace point, hit on every block): the
+ * first time an op blocks it counts itself in waiters_send/recv and stamps
+ * *t0 (-1 while latency is off); once the op returns it leaves the count
+ * and the whole wait is one sample. The blocking ops are a _body taking the
+ * stamp and a wrapper that records it. */
+static inline void kc_chan_lat_wait_begin(struct kc_chan *ch, enum kc_select_clause_kind clause, long *t0)
+{
+    KC_TRACE(KC_TRACE_CHAN_BLOCK, kcoro_current(), (uintptr_t)ch);
+    if (*t0) return;
+    __atomic_fetch_add(clause == KC_SELECT_CLAUSE_SEND ? &ch->waiters_send : &ch->waiters_recv,
+                       1u, __ATOMIC_RELAXED);
+    struct kc_chan_lat *l = atomic_load_explicit(&ch->lat, memory_order_acquire);
+    *t0 = l && atomic_load_explicit(&l->on, memory_order_relaxed) ? kc_now_ns() : -1;
+}
+
+static void kc_chan_lat_wait_end(struct kc_chan *ch, enum kc_select_clause_kind clause, long t0)
+{
+    if (!t0) return;
+    __atomic_fetch_sub(clause == KC_SELECT_CLAUSE_SEND ? &ch->waiters_send : &ch->waiters_recv,
+                       1u, __ATOMIC_RELAXED);
+    if (t0 < 0) return;
+    struct kc_chan_lat *l = atomic_load_explicit(&ch->lat, memory_order_acquire);
+    struct kc_hist_shard *h = clause == KC_SELECT_CLAUSE_SEND ? l->send_park : l->recv_park;
+    long d = kc_now_ns() - t0;
+    kc_hist_record(&h[kc_hist_shard_for(KCORO_LAT_SHARDS)], d > 0 ? (unsigned long)d : 0);
+}
+
+/* Whether ch sends a woken waiter of `clause` home rather than to the waker's
+ * worker: FOLLOW_PRODUCER for senders only (their consumer comes to them),
+ * HOME for both sides. */
+static inline int kc_chan_wake_home(const struct kc_chan *ch, int clause)
+{
+    return ch->affinity == KC_AFFINITY_HOME ||
+           (ch->affinity == KC_AFFINITY_FOLLOW_PRODUCER && clause == KC_SELECT_CLAUSE_SEND);
+}
+
+/* Wakes hand the coroutine back to the scheduler it last ran on (from
+ * another scheduler's worker that is a remote wake into its inbox, and
+ * kc_sched_drain on it must see the wake); coroutines that never ran on one
+ * go to the waker's scheduler. */
+static kc_sched_t *kc_chan_wake_sched(kcoro_t *co)
+{
+    kc_sched_t *s = co ? (kc_sched_t*)co->scheduler : NULL;
+    if (!s) s = kc_sched_current();
+    return s ? s : kc_sched_default();
+}
+
 static void kc_chan_schedule_wake(struct kc_wake wake)
 {
     if (!wake.co) return;
     kcoro_t *co = wake.co;
-    kc_sched_t *current = kc_sched_current();
     int was_parked = kcoro_is_parked(co);
+    kc_sched_t *s = kc_chan_wake_sched(co);
+    /* Queue on the channel's lane (or its home worker) before kcoro_unpark
+     * would use the coroutine's own lane here; the second enqueue is then a
+     * no-op. */
+    if (wake.home) kc_sched_enqueue_ready_home(s, co, (kc_lane_t)wake.lane);
+    else if (wake.lane != KC_LANE_INHERIT) kc_sched_enqueue_ready_lane(s, co, (kc_lane_t)wake.lane);
     if (was_parked) {
         kcoro_unpark(co);
     }
-    if (!current) {
-        kc_sched_t *s = kc_sched_default();
-        kc_sched_enqueue_ready(s, co);
-    } else {
-        kc_sched_enqueue_ready(current, co);
-    }
+    kc_sched_enqueue_ready(s, co);
     kcoro_release(co);
 }
 
@@ -212,43 +660,325 @@ static void kc_wake_list_append(struct kc_wake_list *list, struct kc_wake wake)
     if (list->count < (int)(sizeof(list->items) / sizeof(list->items[0]))) {
         list->items[list->count++] = wake;
     } else {
-        kcoro_release(wake.co);
+        /* Full: wake it now, under ch->mu. Safe, a parked waiter is switched
+         * out before its hook drops the lock; dropping it would strand it. */
+        kc_chan_schedule_wake(wake);
     }
 }
 
+/* One wake keeps kc_chan_schedule_wake (it takes the waker's runnext slot);
+ * several go to the scheduler as one batch, bar those sent home. */
 static void kc_wake_list_schedule(struct kc_wake_list *list)
 {
-    for (int i = 0; i < list->count; ++i) {
-        kc_chan_schedule_wake(list->items[i]);
+    if (list->count == 1) {
+        kc_chan_schedule_wake(list->items[0]);
+    } else if (list->count > 1) {
+        struct kc_wake_batch b;
+        kc_wake_batch_init(&b, 1);
+        for (int i = 0; i < list->count; ++i) {
+            if (list->items[i].home) { kc_chan_schedule_wake(list->items[i]); continue; }
+            kc_wake_batch_add(&b, kc_chan_wake_sched(list->items[i].co), list->items[i].co,
+                              (kc_lane_t)list->items[i].lane);
+        }
+        kc_wake_batch_flush(&b);
     }
     list->count = 0;
 }
 
-static int kc_waiter_token_ensure_enqueued(struct kc_waiter_token *token,
-                                           struct kc_chan *ch,
-                                           enum kc_select_clause_kind clause)
+/* Ring channels: recompute the waiter hints after the lists changed
+ * (ch->mu held). */
+static inline void kc_chan_ring_sync_locked(struct kc_chan *ch)
+{
+    /* A readiness set counts as a waiter on both sides: the lock-free paths
+     * then take the lock to notify it. */
+    int sets = ch->set_members != NULL;
+    atomic_store_explicit(&ch->ring->recv_waiting, sets || ch->wq_recv_head != NULL, memory_order_relaxed);
+    atomic_store_explicit(&ch->ring->send_waiting, sets || ch->wq_send_head != NULL, memory_order_relaxed);
+}
+
+/* Conflated channels: senders never wait, so only the receive hint. */
+static inline void kc_chan_latest_sync_locked(struct kc_chan *ch)
+{
+    atomic_store_explicit(&ch->latest->recv_waiting, ch->set_members != NULL || ch->wq_recv_head != NULL,
+                          memory_order_relaxed);
+}
+
+/* A receiver is about to re-check and park; pairs with the fence in
+ * kc_chan_latest_wake_recv(). */
+static inline void kc_chan_latest_announce_locked(struct kc_chan *ch)
+{
+    atomic_store(&ch->latest->recv_waiting, 1);
+    atomic_thread_fence(memory_order_seq_cst);
+}
+
+/* Recompute whichever lock-free hints the channel has (ch->mu held). */
+static inline void kc_chan_hints_sync_locked(struct kc_chan *ch)
+{
+    if (ch->ring) kc_chan_ring_sync_locked(ch);
+    else if (ch->latest) kc_chan_latest_sync_locked(ch);
+}
+
+static struct kc_wake kc_chan_wake_recv_locked(struct kc_chan *ch);
+static struct kc_wake kc_chan_wake_send_locked(struct kc_chan *ch);
+
+/* Runs on the worker after the waiting coroutine switched out; arg is its
+ * waiter. */
+static void kc_chan_timed_park_release(void *arg)
+{
+    struct kc_waiter *w = (struct kc_waiter*)arg;
+    struct kc_chan_timed_park *tp = &w->park;
+    struct kc_wake wake = tp->wake;
+    kc_sched_t *s = tp->sched;
+    kcoro_t *co = w->co;
+    if (tp->deadline_ns > 0)
+        tp->timer = kc_sched_timer_wake_at(s, co, (unsigned long long)tp->deadline_ns);
+    int cancelled = kc_cancel_wait_arm(co);
+    KC_MUTEX_UNLOCK(&tp->ch->mu); /* w may be gone once a waker resumes the coroutine */
+    kc_chan_schedule_wake(wake);
+    if (cancelled) kc_sched_enqueue_ready(s, co); /* token fired before we parked */
+}
+
+/* Timed wait: queue a waiter and park until a peer pops it, the channel
+ * closes, deadline_ns passes or the token of the enclosing _c op fires;
+ * whichever comes first cancels the others (deadline_ns <= 0 parks without a
+ * timer). Entered with ch->mu held, returns with it released; `wake` is
+ * scheduled after the unlock. Returns 1 when cancelled (the caller returns
+ * KC_ECANCELED), else 0 and the caller re-checks channel state (and the
+ * deadline). Stamps the op's wait start in *wait_t0 (kc_chan_lat_wait_begin).
+ * A handoff receiver passes its buffer as dst: a sender that fills it sets
+ * *done, which takes precedence over the return value. */
+static int kc_chan_park_handoff_locked(struct kc_chan *ch, enum kc_select_clause_kind clause,
+                                       long deadline_ns, struct kc_wake wake, long *wait_t0,
+                                       void *dst, int *done)
 {
-    if (kc_waiter_token_is_enqueued(token)) {
+    int is_send = (clause == KC_SELECT_CLAUSE_SEND);
+    struct kc_waiter **head = is_send ? &ch->wq_send_head : &ch->wq_recv_head;
+    struct kc_waiter **tail = is_send ? &ch->wq_send_tail : &ch->wq_recv_tail;
+    kc_sched_t *s = kc_sched_current();
+    if (kc_cancel_wait_fired(kcoro_current())) {
+        KC_MUTEX_UNLOCK(&ch->mu);
+        kc_chan_schedule_wake(wake);
+        return 1;
+    }
+    struct kc_waiter *w = s ? kc_waiter_new_coro(clause) : NULL;
+    if (!w) {
+        /* Not on a worker (or OOM): fall back to a cooperative retry. */
+        KC_MUTEX_UNLOCK(&ch->mu);
+        kc_chan_schedule_wake(wake);
+        kcoro_yield();
         return 0;
     }
+    w->park = (struct kc_chan_timed_park){ .ch = ch, .sched = s, .deadline_ns = deadline_ns,
+                                           .timer = {0}, .wake = wake };
+    w->handoff_dst = dst;
+    w->handoff_done = dst ? done : NULL;
+    w->owned = 1; /* ours to free, popped or not: no flag on this stack */
+    kc_waiter_append(head, tail, w);
+    /* A receiver parks only on an empty channel: whatever a coalescing
+     * window counted has been taken. */
+    if (!is_send) ch->coalesce_pending = 0;
+    kc_chan_lat_wait_begin(ch, clause, wait_t0);
+    if (kc_sched_park_release(kc_chan_timed_park_release, w) != 0) {
+        KC_MUTEX_UNLOCK(&ch->mu);
+        kc_chan_schedule_wake(wake);
+        kcoro_yield();
+    }
+    int cancelled = kc_cancel_wait_disarm(w->co);
+    KC_MUTEX_LOCK(&ch->mu);
+    /* Under mu: a coalescing sender may have replaced the timer. */
+    (void)kc_sched_timer_cancel(s, w->park.timer);
+    /* Still queued when the wait expired or something other than a peer
+     * woke us. O(1): with many waits timing out at once none walks the list. */
+    kc_waiter_unlink(w);
+    struct kc_wake next = {0};
+    if (cancelled && !is_send && ch->coalesce_pending) {
+        /* We may have held a window's wake: pass it on. */
+        ch->coalesce_pending = 0;
+        next = kc_chan_wake_recv_locked(ch);
+    }
+    kc_chan_hints_sync_locked(ch);
+    KC_MUTEX_UNLOCK(&ch->mu);
+    kc_waiter_destroy(w);
+    kc_chan_schedule_wake(next);
+    return cancelled;
+}
+
+static int kc_chan_park_until_locked(struct kc_chan *ch, enum kc_select_clause_kind clause,
+                                     long deadline_ns, struct kc_wake wake, long *wait_t0)
+{
+    return kc_chan_park_handoff_locked(ch, clause, deadline_ns, wake, wait_t0, NULL, NULL);
+}
+
+/* Untimed cooperative wait: queue a waiter so a peer sees this side
+ * waiting (then take `wake_peer`'s parked peer, if asked), yield once and
+ * unlink the waiter again if no peer popped it. Each retry queues a fresh
+ * one, so none is left behind for a later peer to deliver to once this op
+ * has returned. The waiter is owned (a peer that pops it leaves it to us):
+ * no flag on this stack, which a shared-stack coroutine swaps out. Entered
+ * with ch->mu held, returns with it released: 0 (the caller re-checks
+ * channel state) or -ENOMEM. */
+static int kc_chan_yield_waiting_locked(struct kc_chan *ch, enum kc_select_clause_kind clause,
+                                        int wake_peer, long *wait_t0)
+{
+    int is_send = (clause == KC_SELECT_CLAUSE_SEND);
     struct kc_waiter *w = kc_waiter_new_coro(clause);
-    if (!w) {
-        return -ENOMEM;
+    if (!w) { KC_MUTEX_UNLOCK(&ch->mu); return -ENOMEM; }
+    w->owned = 1;
+    if (is_send) kc_waiter_append(&ch->wq_send_head, &ch->wq_send_tail, w);
+    else kc_waiter_append(&ch->wq_recv_head, &ch->wq_recv_tail, w);
+    struct kc_wake wake = {0};
+    if (wake_peer) wake = is_send ? kc_chan_wake_recv_locked(ch) : kc_chan_wake_send_locked(ch);
+    kc_chan_lat_wait_begin(ch, clause, wait_t0);
+    KC_MUTEX_UNLOCK(&ch->mu);
+    kc_chan_schedule_wake(wake);
+    kcoro_yield();
+    KC_MUTEX_LOCK(&ch->mu);
+    kc_waiter_unlink(w);
+    KC_MUTEX_UNLOCK(&ch->mu);
+    kc_waiter_destroy(w);
+    return 0;
+}
+
+/* Wake coalescing (kc_chan_set_coalesce), after n elements were queued
+ * (ch->mu held). Returns 1 when the head receiver's wake is held back: its
+ * park timer is pulled in to the end of the window instead, so it wakes once
+ * for the whole run. Returns 0 (wake it now) once the window has counted
+ * coalesce_max puts or run out, or when the head receiver cannot be held: a
+ * select or thread, or a coroutine not parked by
+ * kc_chan_park_handoff_locked. */
+static int kc_chan_coalesce_hold_locked(struct kc_chan *ch, size_t n)
+{
+    if (!ch->coalesce_max || ch->set_members) return 0;
+    struct kc_waiter *w = ch->wq_recv_head;
+    if (!w) { ch->coalesce_pending = 0; return 0; }
+    long now = kc_now_ns();
+    if (ch->coalesce_pending == 0) ch->coalesce_first_ns = now;
+    ch->coalesce_pending += n;
+    long due = ch->coalesce_first_ns + ch->coalesce_delay_ns;
+    if (ch->coalesce_pending >= ch->coalesce_max || now >= due || w->kind != KC_WAITER_CORO || !w->park.sched) {
+        ch->coalesce_pending = 0;
+        ch->coalesce_flushes++;
+        return 0;
     }
-    if (clause == KC_SELECT_CLAUSE_SEND) {
-        kc_waiter_append(&ch->wq_send_head, &ch->wq_send_tail, w);
-    } else {
-        kc_waiter_append(&ch->wq_recv_head, &ch->wq_recv_tail, w);
+    struct kc_chan_timed_park *tp = &w->park;
+    if (tp->deadline_ns <= 0 || tp->deadline_ns > due) {
+        (void)kc_sched_timer_cancel(tp->sched, tp->timer);
+        tp->deadline_ns = due;
+        tp->timer = kc_sched_timer_wake_at(tp->sched, w->co, (unsigned long long)due);
+    }
+    ch->coalesce_held++;
+    return 1;
+}
+
+/* A handoff sender just filled co's buffer: run co now on this worker,
+ * else (not on a worker, or co already queued) wake it as usual. Consumes
+ * the caller's reference on co. */
+static void kc_chan_handoff_wake(struct kc_chan *ch, kcoro_t *co)
+{
+    if (kc_sched_handoff(co) == 0) { kcoro_release(co); return; }
+    kc_chan_schedule_wake((struct kc_wake){ .co = co, .lane = ch->wake_lane });
+}
+
+/* Whether the calling receiver may park with its buffer for a handoff. A
+ * sender fills that buffer and the done flag while the receiver is
+ * switched out, so neither may be on a shared stack, which then holds
+ * another coroutine's frames: such a receiver waits the plain way. */
+static inline int kc_chan_handoff_recv_ok(const struct kc_chan *ch)
+{
+    kcoro_t *co = kcoro_current();
+    return ch->handoff && co && !co->share;
+}
+
+/* Pointer channels park blocked send_ptr / recv_ptr calls on tickets
+ * (kc_ticket.c) queued in tq_send / tq_recv instead of on kc_waiters: a
+ * peer completes the ticket with one CAS, no waiter is allocated and the
+ * descriptor travels in the ticket payload. Completion status 0 is such a
+ * handoff, KC_EAGAIN asks the parked op to re-check the channel (a select
+ * or batch op changed it) and KC_EPIPE reports close. All helpers run
+ * under ch->mu. */
+
+/* Give msg to the oldest parked receiver; 1 when one took it. */
+static int kc_chan_ptr_give_locked(struct kc_chan *ch, const struct kc_chan_ptrmsg *msg)
+{
+    kc_ticket_t t;
+    while ((t = kc_ticket_queue_pop(&ch->tq_recv)) != 0) {
+        kc_ticket_payload_t p = { .ptr = msg->ptr, .len = msg->len, .status = 0, .data = 0 };
+        if (kc_ticket_complete_lane(t, &p, ch->wake_lane) == 0) return 1;
+    }
+    return 0;
+}
+
+/* Take the descriptor of the oldest parked sender; 1 when there was one. */
+static int kc_chan_ptr_take_locked(struct kc_chan *ch, struct kc_chan_ptrmsg *out)
+{
+    kc_ticket_t t;
+    while ((t = kc_ticket_queue_pop(&ch->tq_send)) != 0) {
+        kc_ticket_payload_t p = { .ptr = NULL, .len = 0, .status = 0, .data = 0 };
+        if (kc_ticket_complete_lane(t, &p, ch->wake_lane) == 0) {
+            out->ptr = p.ptr;
+            out->len = p.len;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Complete the oldest live ticket on q with status (KC_EAGAIN: re-check);
+ * 1 when there was one. */
+static int kc_chan_ptr_signal_locked(struct kc_chan *ch, struct kc_ticket_queue *q, int status)
+{
+    kc_ticket_t t;
+    while ((t = kc_ticket_queue_pop(q)) != 0) {
+        kc_ticket_payload_t p = { .ptr = NULL, .len = 0, .status = status, .data = 0 };
+        if (kc_ticket_complete_lane(t, &p, ch->wake_lane) == 0) return 1;
     }
-    token->status = KC_WAITER_TOKEN_ENQUEUED;
     return 0;
 }
 
+/* Park the calling op on a ticket queued on q, publishing msg for the peer
+ * that takes it. Entered with ch->mu held, returns with it released; `wake`
+ * is scheduled after the unlock. Returns the completion status with the
+ * peer's descriptor in *out, KC_ETIME once deadline_ns (> 0) passes,
+ * KC_ECANCELED when the token of the enclosing _c op fires, or -ENOMEM
+ * when the ticket table is full. */
+static int kc_chan_ptr_park_locked(struct kc_chan *ch, enum kc_select_clause_kind clause,
+                                   const struct kc_chan_ptrmsg *msg, long deadline_ns,
+                                   struct kc_wake wake, long *wait_t0, struct kc_chan_ptrmsg *out)
+{
+    int is_send = (clause == KC_SELECT_CLAUSE_SEND);
+    struct kc_ticket_queue *q = is_send ? &ch->tq_send : &ch->tq_recv;
+    kc_ticket_payload_t p = { .ptr = msg ? msg->ptr : NULL, .len = msg ? msg->len : 0, .status = 0, .data = 0 };
+    kc_ticket_t t = kc_ticket_publish(&p);
+    if (!t) {
+        KC_MUTEX_UNLOCK(&ch->mu);
+        kc_chan_schedule_wake(wake);
+        return -ENOMEM;
+    }
+    kc_ticket_queue_push(q, t);
+    kc_chan_lat_wait_begin(ch, clause, wait_t0);
+    KC_MUTEX_UNLOCK(&ch->mu);
+    kc_chan_schedule_wake(wake);
+    int rc = kc_ticket_wait_until(t, deadline_ns, &p);
+    if (rc == KC_ETIME || rc == KC_ECANCELED) {
+        /* Unlink before the slot can be reused; a peer that popped it
+         * already has had its completion refused. */
+        KC_MUTEX_LOCK(&ch->mu);
+        (void)kc_ticket_queue_remove(q, t);
+        if (rc == KC_ETIME) {
+            if (is_send) ch->send_etime++; else ch->recv_etime++;
+        }
+        KC_MUTEX_UNLOCK(&ch->mu);
+    }
+    kc_ticket_release(t);
+    if (rc == 0 && out) { out->ptr = p.ptr; out->len = p.len; }
+    return rc;
+}
+
 /* use kc_waiter_new_coro from kc_chan_internal.h */
 
 static struct kc_waiter* kc_waiter_new_select(kc_select_t *sel, int clause_index, enum kc_select_clause_kind kind)
 {
-    struct kc_waiter *w = (struct kc_waiter*)malloc(sizeof(*w));
+    struct kc_waiter *w = kc_waiter_alloc();
     if (!w) return NULL;
     w->kind = KC_WAITER_SELECT;
     w->co = kc_select_waiter(sel);
@@ -257,8 +987,17 @@ static struct kc_waiter* kc_waiter_new_select(kc_select_t *sel, int clause_index
     w->clause_index = clause_index;
     w->clause_kind = kind;
     w->is_zref = 0;
-    w->next = NULL;
-    w->magic = 0xCAFEBABEUL;
+    w->next = w->prev = NULL;
+    w->q_head = w->q_tail = NULL;
+    w->owned = 0;
+    w->park.sched = NULL;
+#if KCORO_DEBUG_BUILD
+    w->magic = KC_WAITER_MAGIC;
+    w->freed = 0;
+#endif
+    w->recv_ptr_slot = NULL;
+    w->recv_len_slot = NULL;
+    sel->clauses[clause_index].waiter = w;
     return w;
 }
 
@@ -268,56 +1007,640 @@ static struct kc_waiter* kc_waiter_new_select(kc_select_t *sel, int clause_index
 
 /* zref queue scanning lives in zcopy backend */
 
-static struct kc_wake kc_chan_wake_recv_locked(struct kc_chan *ch);
-static struct kc_wake kc_chan_wake_send_locked(struct kc_chan *ch);
 
 /* zref invariants now asserted inside kc_zcopy.c */
 
-int kc_chan_make(kc_chan_t **out, int kind, size_t elem_sz, size_t capacity)
+/* ---- Lock-free rings (kc_chan_make_mpmc / kc_chan_make_spsc) ------------ */
+
+static inline struct kc_mpmc_cell *kc_mpmc_cell_at(const struct kc_mpmc_ring *r, size_t pos)
 {
-    if (!out || elem_sz == 0)
-        return -EINVAL;
-    struct kc_chan *ch = calloc(1, sizeof(*ch));
-    if (!ch) return -ENOMEM;
-    KC_MUTEX_INIT(&ch->mu);
-    KC_COND_INIT(&ch->cv_send);
-    KC_COND_INIT(&ch->cv_recv);
-    ch->wq_send_head = ch->wq_send_tail = NULL;
-    ch->wq_recv_head = ch->wq_recv_tail = NULL;
-    ch->kind = kind;
-    ch->elem_sz = elem_sz;
-    if (kind == KC_CONFLATED) {
-        ch->slot = malloc(elem_sz);
-        if (!ch->slot) { free(ch); return -ENOMEM; }
-        ch->has_value = 0;
-    } else if (kind == KC_RENDEZVOUS) {
-        ch->slot = malloc(elem_sz);
-        if (!ch->slot) { free(ch); return -ENOMEM; }
-        ch->has_value = 0;
-    } else {
-        ch->capacity = capacity ? capacity : (kind > 0 ? (size_t)kind : 64);
-        /* Prefer power-of-two capacity for fast ring math (non-unlimited). */
-        if (kind != KC_UNLIMITED) {
-            size_t pow2 = kc_next_pow2(ch->capacity);
-            ch->capacity = pow2;
-        }
-        ch->mask = (ch->capacity && ( (ch->capacity & (ch->capacity - 1)) == 0)) ? (ch->capacity - 1) : 0;
-        ch->buf = malloc(ch->capacity * elem_sz);
-        if (!ch->buf) { free(ch); return -ENOMEM; }
-    }
-    *out = ch;
+    return (struct kc_mpmc_cell*)(r->cells + (pos & r->mask) * r->stride);
+}
+
+/* Returns 1 when msg was enqueued, 0 when the ring is full. NULL msg stores zeros. */
+static int kc_mpmc_try_push(struct kc_mpmc_ring *r, const void *msg, size_t elem_sz)
+{
+    size_t pos = atomic_load_explicit(&r->enqueue_pos, memory_order_relaxed);
+    for (;;) {
+        struct kc_mpmc_cell *cell = kc_mpmc_cell_at(r, pos);
+        size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+        if (dif == 0) {
+            if (atomic_compare_exchange_weak_explicit(&r->enqueue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                if (msg) kc_chan_elem_copy(cell->data, msg, elem_sz); else memset(cell->data, 0, elem_sz);
+                atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+                if (pos == 0) atomic_store_explicit(&r->first_op_ns, kc_now_ns(), memory_order_relaxed);
+                return 1;
+            }
+        } else if (dif < 0) {
+            return 0;
+        } else {
+            pos = atomic_load_explicit(&r->enqueue_pos, memory_order_relaxed);
+        }
+    }
+}
+
+/* Returns 1 when an element was dequeued into out, 0 when the ring is empty. */
+static int kc_mpmc_try_pop(struct kc_mpmc_ring *r, void *out, size_t elem_sz)
+{
+    size_t pos = atomic_load_explicit(&r->dequeue_pos, memory_order_relaxed);
+    for (;;) {
+        struct kc_mpmc_cell *cell = kc_mpmc_cell_at(r, pos);
+        size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        intptr_t dif = (intptr_t)seq - (intptr_t)(pos + 1);
+        if (dif == 0) {
+            if (atomic_compare_exchange_weak_explicit(&r->dequeue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                kc_chan_elem_copy(out, cell->data, elem_sz);
+                atomic_store_explicit(&cell->seq, pos + r->mask + 1, memory_order_release);
+                return 1;
+            }
+        } else if (dif < 0) {
+            return 0;
+        } else {
+            pos = atomic_load_explicit(&r->dequeue_pos, memory_order_relaxed);
+        }
+    }
+}
+
+/* SPSC ring: the producer alone advances enqueue_pos, the consumer alone
+ * dequeue_pos; the peer's cursor is re-read only when the cached copy says
+ * full (resp. empty). */
+static int kc_spsc_try_push(struct kc_mpmc_ring *r, const void *msg, size_t elem_sz)
+{
+    size_t pos = atomic_load_explicit(&r->enqueue_pos, memory_order_relaxed);
+    if (pos - r->cached_dequeue > r->mask) {
+        r->cached_dequeue = atomic_load_explicit(&r->dequeue_pos, memory_order_acquire);
+        if (pos - r->cached_dequeue > r->mask) return 0;
+    }
+    unsigned char *slot = r->cells + (pos & r->mask) * r->stride;
+    if (msg) kc_chan_elem_copy(slot, msg, elem_sz); else memset(slot, 0, elem_sz);
+    atomic_store_explicit(&r->enqueue_pos, pos + 1, memory_order_release);
+    if (pos == 0) atomic_store_explicit(&r->first_op_ns, kc_now_ns(), memory_order_relaxed);
+    return 1;
+}
+
+static int kc_spsc_try_pop(struct kc_mpmc_ring *r, void *out, size_t elem_sz)
+{
+    size_t pos = atomic_load_explicit(&r->dequeue_pos, memory_order_relaxed);
+    if (pos == r->cached_enqueue) {
+        r->cached_enqueue = atomic_load_explicit(&r->enqueue_pos, memory_order_acquire);
+        if (pos == r->cached_enqueue) return 0;
+    }
+    kc_chan_elem_copy(out, r->cells + (pos & r->mask) * r->stride, elem_sz);
+    atomic_store_explicit(&r->dequeue_pos, pos + 1, memory_order_release);
+    return 1;
+}
+
+static inline int kc_ring_try_push(struct kc_mpmc_ring *r, const void *msg, size_t elem_sz)
+{
+    return r->spsc ? kc_spsc_try_push(r, msg, elem_sz) : kc_mpmc_try_push(r, msg, elem_sz);
+}
+
+static inline int kc_ring_try_pop(struct kc_mpmc_ring *r, void *out, size_t elem_sz)
+{
+    return r->spsc ? kc_spsc_try_pop(r, out, elem_sz) : kc_mpmc_try_pop(r, out, elem_sz);
+}
+
+/* Two-phase ops (kc_chan_reserve / kc_chan_recv_peek): claim up to max
+ * consecutive cells without copying, on the producer side (free cells from
+ * enqueue_pos) or the consumer side (published ones from dequeue_pos).
+ * Returns the count claimed, 0 when the ring is full (resp. empty); *pos
+ * gets the first position. The other side sees the cells only once
+ * kc_ring_publish (resp. kc_ring_release) hands them over. */
+static size_t kc_mpmc_try_claim(struct kc_mpmc_ring *r, int take, size_t max, size_t *pos_out)
+{
+    _Atomic size_t *cursor = take ? &r->dequeue_pos : &r->enqueue_pos;
+    size_t pos = atomic_load_explicit(cursor, memory_order_relaxed);
+    for (;;) {
+        size_t want = take ? pos + 1 : pos;
+        size_t seq = atomic_load_explicit(&kc_mpmc_cell_at(r, pos)->seq, memory_order_acquire);
+        intptr_t dif = (intptr_t)seq - (intptr_t)want;
+        if (dif == 0) {
+            /* A cell ready for this side stays ready until its position is
+             * claimed, so the run counted here is still whole if the CAS wins. */
+            size_t k = 1;
+            while (k < max && atomic_load_explicit(&kc_mpmc_cell_at(r, pos + k)->seq,
+                                                   memory_order_acquire) == want + k)
+                k++;
+            if (atomic_compare_exchange_weak_explicit(cursor, &pos, pos + k,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                *pos_out = pos;
+                return k;
+            }
+        } else if (dif < 0) {
+            return 0;
+        } else {
+            pos = atomic_load_explicit(cursor, memory_order_relaxed);
+        }
+    }
+}
+
+static size_t kc_spsc_try_claim(struct kc_mpmc_ring *r, int take, size_t max, size_t *pos_out)
+{
+    size_t pos, avail;
+    if (take) {
+        pos = atomic_load_explicit(&r->dequeue_pos, memory_order_relaxed);
+        if (r->cached_enqueue - pos < max)
+            r->cached_enqueue = atomic_load_explicit(&r->enqueue_pos, memory_order_acquire);
+        avail = r->cached_enqueue - pos;
+    } else {
+        pos = atomic_load_explicit(&r->enqueue_pos, memory_order_relaxed);
+        if (pos - r->cached_dequeue + max > r->mask + 1)
+            r->cached_dequeue = atomic_load_explicit(&r->dequeue_pos, memory_order_acquire);
+        avail = r->mask + 1 - (pos - r->cached_dequeue);
+    }
+    *pos_out = pos;
+    return avail < max ? avail : max;
+}
+
+static inline unsigned char *kc_ring_cell_data(struct kc_mpmc_ring *r, size_t pos)
+{
+    return r->spsc ? r->cells + (pos & r->mask) * r->stride : kc_mpmc_cell_at(r, pos)->data;
+}
+
+static void kc_ring_publish(struct kc_mpmc_ring *r, size_t pos, size_t n)
+{
+    if (r->spsc) atomic_store_explicit(&r->enqueue_pos, pos + n, memory_order_release);
+    else for (size_t i = 0; i < n; i++)
+        atomic_store_explicit(&kc_mpmc_cell_at(r, pos + i)->seq, pos + i + 1, memory_order_release);
+    if (pos == 0) atomic_store_explicit(&r->first_op_ns, kc_now_ns(), memory_order_relaxed);
+}
+
+static void kc_ring_release(struct kc_mpmc_ring *r, size_t pos, size_t n)
+{
+    if (r->spsc) atomic_store_explicit(&r->dequeue_pos, pos + n, memory_order_release);
+    else for (size_t i = 0; i < n; i++)
+        atomic_store_explicit(&kc_mpmc_cell_at(r, pos + i)->seq, pos + i + r->mask + 1,
+                              memory_order_release);
+}
+
+/* Approximate depth; dequeue_pos is read first so the result never underflows. */
+static size_t kc_mpmc_len(struct kc_mpmc_ring *r)
+{
+    size_t d = atomic_load_explicit(&r->dequeue_pos, memory_order_acquire);
+    size_t e = atomic_load_explicit(&r->enqueue_pos, memory_order_acquire);
+    size_t n = e - d;
+    return n > r->mask + 1 ? r->mask + 1 : n;
+}
+
+/* Striped channels (kc_chan_make_striped): ch->ring is an array of
+ * ring_stripes MPMC rings (a power of two). Each thread has a home stripe;
+ * a push tries it first and then the others in order, a pop the same, so
+ * "full" and "empty" mean every stripe looked full (empty). ring[0] carries
+ * the channel-wide fields (closed, waiter hints, failure counters). */
+static __thread unsigned tls_ring_stripe = UINT_MAX;
+static _Atomic unsigned g_ring_stripe_next;
+
+static inline unsigned kc_chan_ring_home(void)
+{
+    if (tls_ring_stripe == UINT_MAX)
+        tls_ring_stripe = atomic_fetch_add_explicit(&g_ring_stripe_next, 1, memory_order_relaxed);
+    return tls_ring_stripe;
+}
+
+static inline int kc_chan_ring_push(struct kc_chan *ch, const void *msg)
+{
+    unsigned n = ch->ring_stripes;
+    if (n <= 1) return kc_ring_try_push(ch->ring, msg, ch->elem_sz);
+    unsigned h = kc_chan_ring_home();
+    for (unsigned i = 0; i < n; i++)
+        if (kc_mpmc_try_push(&ch->ring[(h + i) & (n - 1)], msg, ch->elem_sz)) return 1;
+    return 0;
+}
+
+static inline int kc_chan_ring_pop(struct kc_chan *ch, void *out)
+{
+    unsigned n = ch->ring_stripes;
+    if (n <= 1) return kc_ring_try_pop(ch->ring, out, ch->elem_sz);
+    unsigned h = kc_chan_ring_home();
+    for (unsigned i = 0; i < n; i++)
+        if (kc_mpmc_try_pop(&ch->ring[(h + i) & (n - 1)], out, ch->elem_sz)) return 1;
+    return 0;
+}
+
+/* Claim cells on the home stripe first, like kc_chan_ring_push / _pop;
+ * a batch never spans stripes. */
+static size_t kc_chan_ring_claim(struct kc_chan *ch, int take, size_t max, kc_chan_slot_t *slot)
+{
+    unsigned n = ch->ring_stripes ? ch->ring_stripes : 1;
+    unsigned h = n > 1 ? kc_chan_ring_home() : 0;
+    for (unsigned i = 0; i < n; i++) {
+        unsigned k = (h + i) & (n - 1);
+        struct kc_mpmc_ring *r = &ch->ring[k];
+        size_t pos;
+        size_t got = r->spsc ? kc_spsc_try_claim(r, take, max, &pos)
+                             : kc_mpmc_try_claim(r, take, max, &pos);
+        if (got) {
+            slot->data = kc_ring_cell_data(r, pos);
+            slot->pos = pos;
+            slot->n = got;
+            slot->stripe = k;
+            return got;
+        }
+    }
+    return 0;
+}
+
+static size_t kc_chan_ring_len(struct kc_chan *ch)
+{
+    size_t n = 0;
+    for (unsigned i = 0; i < (ch->ring_stripes ? ch->ring_stripes : 1); i++) n += kc_mpmc_len(&ch->ring[i]);
+    return n;
+}
+
+/* Sum of the stripes' cursors; first is the earliest first push (0 if none). */
+static void kc_chan_ring_totals(struct kc_chan *ch, size_t *sends, size_t *recvs, long *first, memory_order mo)
+{
+    *sends = *recvs = 0;
+    *first = 0;
+    for (unsigned i = 0; i < (ch->ring_stripes ? ch->ring_stripes : 1); i++) {
+        struct kc_mpmc_ring *r = &ch->ring[i];
+        *recvs += atomic_load_explicit(&r->dequeue_pos, mo);
+        *sends += atomic_load_explicit(&r->enqueue_pos, mo);
+        long f = atomic_load_explicit(&r->first_op_ns, memory_order_relaxed);
+        if (f && (!*first || f < *first)) *first = f;
+    }
+}
+
+/* Announce a waiter before the final re-check of the ring (ch->mu held);
+ * pairs with the fence in kc_chan_ring_wake_peer(). */
+static inline void kc_chan_ring_announce_locked(struct kc_chan *ch, enum kc_select_clause_kind clause)
+{
+    if (clause == KC_SELECT_CLAUSE_SEND) atomic_store(&ch->ring->send_waiting, 1);
+    else atomic_store(&ch->ring->recv_waiting, 1);
+    atomic_thread_fence(memory_order_seq_cst);
+}
+
+/* After a lock-free push (clause RECV: wake a receiver) or pop (SEND: wake a
+ * sender), take ch->mu only when a peer may be queued. */
+static void kc_chan_ring_wake_peer(struct kc_chan *ch, enum kc_select_clause_kind clause)
+{
+    struct kc_mpmc_ring *r = ch->ring;
+    atomic_thread_fence(memory_order_seq_cst);
+    _Atomic int *hint = clause == KC_SELECT_CLAUSE_RECV ? &r->recv_waiting : &r->send_waiting;
+    if (!atomic_load_explicit(hint, memory_order_relaxed)) return;
+    KC_MUTEX_LOCK(&ch->mu);
+    if (clause == KC_SELECT_CLAUSE_RECV && kc_chan_coalesce_hold_locked(ch, 1)) {
+        KC_MUTEX_UNLOCK(&ch->mu);
+        return;
+    }
+    struct kc_wake wake = clause == KC_SELECT_CLAUSE_RECV ? kc_chan_wake_recv_locked(ch)
+                                                          : kc_chan_wake_send_locked(ch);
+    kc_chan_ring_sync_locked(ch);
+    KC_MUTEX_UNLOCK(&ch->mu);
+    kc_chan_schedule_wake(wake);
+}
+
+/* ---- Conflated cells (copy-mode KC_CONFLATED, struct kc_chan_latest) ----
+ * put and take never lock; the paths that hold ch->mu (select, readiness)
+ * use them too. CLOSED is set under ch->mu by kc_chan_close. */
+
+static inline void kc_chan_latest_count_send(struct kc_chan_latest *l)
+{
+    if (atomic_fetch_add_explicit(&l->sends, 1, memory_order_relaxed) == 0)
+        atomic_store_explicit(&l->first_op_ns, kc_now_ns(), memory_order_relaxed);
+}
+
+/* Publish src (NULL stores zeros): 0, or KC_EPIPE once closed. A sender
+ * that meets another one mid-publish is superseded by it and returns 0;
+ * its value is never seen. */
+static int kc_chan_latest_put(struct kc_chan *ch, const void *src)
+{
+    struct kc_chan_latest *l = ch->latest;
+    uint64_t s = atomic_load_explicit(&l->state, memory_order_relaxed);
+    do {
+        if (s & KC_LATEST_CLOSED) return KC_EPIPE;
+        if (s & KC_LATEST_BUSY) { kc_chan_latest_count_send(l); return 0; }
+    } while (!atomic_compare_exchange_weak_explicit(&l->state, &s, s | KC_LATEST_BUSY,
+                                                    memory_order_relaxed, memory_order_relaxed));
+    /* A reader that sees any byte stored below also sees BUSY (pairs with
+     * the fence in kc_chan_latest_take). */
+    atomic_thread_fence(memory_order_release);
+    uint64_t ver = (s >> KC_LATEST_VER_SHIFT) + 1;
+    unsigned char *dst = l->buf + (ver & 1) * ch->elem_sz;
+    if (src) kc_chan_elem_copy(dst, src, ch->elem_sz); else memset(dst, 0, ch->elem_sz);
+    /* Receivers may clear FULL and close may set CLOSED meanwhile; a send
+     * that claimed the buffer before the close still lands. */
+    uint64_t cur = s | KC_LATEST_BUSY;
+    while (!atomic_compare_exchange_weak_explicit(&l->state, &cur,
+                                                  (ver << KC_LATEST_VER_SHIFT) | KC_LATEST_FULL |
+                                                      (cur & KC_LATEST_CLOSED),
+                                                  memory_order_release, memory_order_relaxed)) {}
+    kc_chan_latest_count_send(l);
+    return 0;
+}
+
+/* Move the current value to dst: 1 when one was taken, 0 when empty. */
+static int kc_chan_latest_take(struct kc_chan *ch, void *dst)
+{
+    struct kc_chan_latest *l = ch->latest;
+    uint64_t s = atomic_load_explicit(&l->state, memory_order_acquire);
+    for (;;) {
+        if (!(s & KC_LATEST_FULL)) {
+            /* Closed while a send is landing: its value comes before EPIPE. */
+            if ((s & (KC_LATEST_CLOSED | KC_LATEST_BUSY)) != (KC_LATEST_CLOSED | KC_LATEST_BUSY)) return 0;
+            sched_yield();
+            s = atomic_load_explicit(&l->state, memory_order_acquire);
+            continue;
+        }
+        kc_chan_elem_copy(dst, l->buf + ((s >> KC_LATEST_VER_SHIFT) & 1) * ch->elem_sz, ch->elem_sz);
+        atomic_thread_fence(memory_order_acquire);
+        /* Fails when anything was published since s: the copy may be torn. */
+        if (atomic_compare_exchange_weak_explicit(&l->state, &s, s & ~(uint64_t)KC_LATEST_FULL,
+                                                  memory_order_acquire, memory_order_acquire))
+            break;
+    }
+    atomic_fetch_add_explicit(&l->recvs, 1, memory_order_relaxed);
+    return 1;
+}
+
+static inline int kc_chan_latest_full(const struct kc_chan *ch)
+{
+    return (atomic_load_explicit(&ch->latest->state, memory_order_acquire) & KC_LATEST_FULL) != 0;
+}
+
+/* After a lock-free put: take ch->mu only when a receiver may be parked. */
+static void kc_chan_latest_wake_recv(struct kc_chan *ch)
+{
+    atomic_thread_fence(memory_order_seq_cst);
+    if (!atomic_load_explicit(&ch->latest->recv_waiting, memory_order_relaxed)) return;
+    KC_MUTEX_LOCK(&ch->mu);
+    struct kc_wake wake = kc_chan_wake_recv_locked(ch);
+    kc_chan_latest_sync_locked(ch);
+    KC_MUTEX_UNLOCK(&ch->mu);
+    kc_chan_schedule_wake(wake);
+}
+
+/* Like the rings, no per-op counters under ch->mu (ch->mu held). */
+static void kc_chan_latest_fold_stats_locked(struct kc_chan *ch)
+{
+    struct kc_chan_latest *l = ch->latest;
+    kc_chan_stats_write_begin(&ch->send_seq);
+    kc_chan_stats_write_begin(&ch->recv_seq);
+    ch->total_sends = atomic_load_explicit(&l->sends, memory_order_relaxed);
+    ch->total_recvs = atomic_load_explicit(&l->recvs, memory_order_relaxed);
+    ch->total_bytes_sent = ch->total_sends * ch->elem_sz;
+    ch->total_bytes_recv = ch->total_recvs * ch->elem_sz;
+    ch->first_op_time_ns = atomic_load_explicit(&l->first_op_ns, memory_order_relaxed);
+    if (ch->total_sends) ch->last_send_ns = ch->last_recv_ns = kc_now_ns();
+    kc_chan_stats_write_end(&ch->recv_seq);
+    kc_chan_stats_write_end(&ch->send_seq);
+}
+
+unsigned kc_chan_ready_events_locked(struct kc_chan *ch)
+{
+    if (ch->closed) return KC_CHAN_SET_RECV | KC_CHAN_SET_SEND | KC_CHAN_SET_CLOSED;
+    unsigned ev = 0;
+    if (ch->ring) {
+        size_t n = kc_chan_ring_len(ch);
+        if (n > 0) ev |= KC_CHAN_SET_RECV;
+        if (n < ch->capacity) ev |= KC_CHAN_SET_SEND;
+    } else if (ch->kind == KC_CONFLATED) {
+        int full = ch->latest ? kc_chan_latest_full(ch) : ch->has_value;
+        ev = KC_CHAN_SET_SEND | (full ? KC_CHAN_SET_RECV : 0);
+    } else if (ch->delay) {
+        ev = KC_CHAN_SET_SEND;
+        if (ch->count > 0 && kc_chan_delay_next(ch->delay) <= kc_now_ns()) ev |= KC_CHAN_SET_RECV;
+    } else {
+        if (ch->count > 0) ev |= KC_CHAN_SET_RECV;
+        if (ch->kind == KC_UNLIMITED || ch->count < ch->capacity) ev |= KC_CHAN_SET_SEND;
+    }
+    return ev;
+}
+
+void kc_chan_set_members_changed_locked(struct kc_chan *ch)
+{
+    kc_chan_hints_sync_locked(ch);
+}
+
+/* Zeroed and cache-line aligned, as the section layout of struct kc_chan needs. */
+static struct kc_chan *kc_chan_alloc(void)
+{
+    struct kc_chan *ch = NULL;
+    if (posix_memalign((void**)&ch, KC_CHAN_CACHELINE, sizeof(*ch)) != 0) return NULL;
+    memset(ch, 0, sizeof(*ch));
+    return ch;
+}
+
+static struct kc_chan_latest *kc_chan_latest_new(size_t elem_sz)
+{
+    struct kc_chan_latest *l = NULL;
+    if (posix_memalign((void**)&l, KC_CHAN_CACHELINE, sizeof(*l)) != 0) return NULL;
+    memset(l, 0, sizeof(*l));
+    l->buf = malloc(2 * elem_sz);
+    if (!l->buf) { free(l); return NULL; }
+    return l;
+}
+
+static void kc_chan_latest_free(struct kc_chan_latest *l)
+{
+    if (!l) return;
+    free(l->buf);
+    free(l);
+}
+
+/* ptr_mode: pointer channels keep conflated values in ch->slot. */
+static int kc_chan_make_mode(kc_chan_t **out, int kind, size_t elem_sz, size_t capacity, int ptr_mode)
+{
+    if (!out || elem_sz == 0)
+        return -EINVAL;
+    struct kc_chan *ch = kc_chan_alloc();
+    if (!ch) return -ENOMEM;
+    KC_MUTEX_INIT(&ch->mu);
+    KC_COND_INIT(&ch->cv_send);
+    KC_COND_INIT(&ch->cv_recv);
+    ch->wq_send_head = ch->wq_send_tail = NULL;
+    ch->wq_recv_head = ch->wq_recv_tail = NULL;
+    ch->kind = kind;
+    ch->elem_sz = elem_sz;
+    ch->wake_lane = KC_LANE_INHERIT;
+    if (kind == KC_CONFLATED && !ptr_mode) {
+        ch->latest = kc_chan_latest_new(elem_sz);
+        if (!ch->latest) { free(ch); return -ENOMEM; }
+    } else if (kind == KC_CONFLATED) {
+        ch->slot = malloc(elem_sz);
+        if (!ch->slot) { free(ch); return -ENOMEM; }
+        ch->has_value = 0;
+    } else if (kind == KC_RENDEZVOUS) {
+        ch->slot = malloc(elem_sz);
+        if (!ch->slot) { free(ch); return -ENOMEM; }
+        ch->has_value = 0;
+    } else if (kind == KC_UNLIMITED) {
+        /* Segments are linked on first send; capacity tracks linked slots. */
+        ch->seg_elems = capacity ? capacity : KCORO_UNLIMITED_INIT_CAP;
+    } else if (kind == KC_DELAYED) {
+        /* capacity only sizes the initial heap; it grows on demand. */
+        if (kc_chan_delay_create(&ch->delay, elem_sz, capacity) != 0) { free(ch); return -ENOMEM; }
+        ch->capabilities = KC_CHAN_CAP_DELAYED;
+    } else if (kind == KC_PRIORITY) {
+        /* Levels share one slot pool; no ring, so no power-of-two rounding. */
+        ch->capacity = capacity ? capacity : 64;
+        int rc = kc_chan_prio_create(&ch->prio, elem_sz, ch->capacity);
+        if (rc != 0) { free(ch); return rc; }
+        ch->capabilities = KC_CHAN_CAP_PRIORITY;
+    } else {
+        ch->capacity = capacity ? capacity : (kind > 0 ? (size_t)kind : 64);
+        /* Prefer power-of-two capacity for fast ring math. */
+        ch->capacity = kc_next_pow2(ch->capacity);
+        ch->mask = ch->capacity - 1;
+        if (kc_mem_charge(KC_MEM_CHAN, ch->capacity * elem_sz) != 0) { free(ch); return -ENOMEM; }
+        ch->buf = kc_chan_buf_alloc(ch->capacity * elem_sz, &ch->buf_map);
+        if (!ch->buf) { kc_mem_uncharge(KC_MEM_CHAN, ch->capacity * elem_sz); free(ch); return -ENOMEM; }
+        ch->buf_trim_ns = kc_clock_coarse_ns();
+    }
+    *out = ch;
     kc_dbg("chan%p make kind=%d elem_sz=%zu cap=%zu", (void*)ch, kind, elem_sz,
            (kind == KC_BUFFERED || kind > 0) ? ch->capacity : 0);
     const struct kc_runtime_config *cfg_aut = kc_runtime_config_get();
-    if (cfg_aut && cfg_aut->chan_metrics_auto_enable) {
+    ch->stats_level = cfg_aut ? cfg_aut->chan_stats_level : KC_CHAN_STATS_FULL;
+    if (cfg_aut && cfg_aut->chan_metrics_auto_enable && !tls_making_metrics_pipe) {
         kc_chan_t *pipe_tmp = NULL;
         kc_chan_enable_metrics_pipe((kc_chan_t*)ch, &pipe_tmp, cfg_aut->chan_metrics_pipe_capacity);
     }
-    ch->emit_check_mask = 0x3FFUL; /* default: every 1024 ops */
-    ch->ops_since_emit_check = 0;
     return 0;
 }
 
+int kc_chan_make(kc_chan_t **out, int kind, size_t elem_sz, size_t capacity)
+{
+    return kc_chan_make_mode(out, kind, elem_sz, capacity, 0);
+}
+
+static void kc_chan_rings_free(struct kc_mpmc_ring *r, unsigned n)
+{
+    for (unsigned i = 0; i < n; i++) {
+        if (!r[i].cells) continue;
+        kc_mem_uncharge(KC_MEM_CHAN, (r[i].mask + 1) * r[i].stride);
+        free(r[i].cells);
+    }
+    free(r);
+}
+
+/* Shared constructor for the lock-free ring channels: stripes rings of
+ * capacity/stripes cells each (both rounded up to powers of two). */
+static int kc_chan_make_ring(kc_chan_t **out, size_t elem_sz, size_t capacity, int spsc, unsigned stripes)
+{
+    if (!out || elem_sz == 0) return -EINVAL;
+    size_t cap = kc_next_pow2(capacity ? (capacity + stripes - 1) / stripes : 64);
+    if (cap < 2) cap = 2;
+    struct kc_mpmc_ring *r = NULL;
+    if (posix_memalign((void**)&r, KC_CHAN_CACHELINE, stripes * sizeof(*r)) != 0) return -ENOMEM;
+    memset(r, 0, stripes * sizeof(*r));
+    for (unsigned k = 0; k < stripes; k++) {
+        struct kc_mpmc_ring *rk = &r[k];
+        rk->mask = cap - 1;
+        rk->spsc = spsc;
+        rk->stride = spsc ? elem_sz
+                          : (sizeof(struct kc_mpmc_cell) + elem_sz + sizeof(size_t) - 1) & ~(sizeof(size_t) - 1);
+        if (kc_mem_charge(KC_MEM_CHAN, cap * rk->stride) != 0) { kc_chan_rings_free(r, stripes); return -ENOMEM; }
+        if (posix_memalign((void**)&rk->cells, KC_CHAN_CACHELINE, cap * rk->stride) != 0) {
+            kc_mem_uncharge(KC_MEM_CHAN, cap * rk->stride);
+            kc_chan_rings_free(r, stripes);
+            return -ENOMEM;
+        }
+        if (!spsc) {
+            for (size_t i = 0; i < cap; ++i)
+                atomic_init(&kc_mpmc_cell_at(rk, i)->seq, i);
+        }
+    }
+
+    struct kc_chan *ch = kc_chan_alloc();
+    if (!ch) { kc_chan_rings_free(r, stripes); return -ENOMEM; }
+    KC_MUTEX_INIT(&ch->mu);
+    KC_COND_INIT(&ch->cv_send);
+    KC_COND_INIT(&ch->cv_recv);
+    ch->kind = KC_BUFFERED;
+    ch->elem_sz = elem_sz;
+    ch->wake_lane = KC_LANE_INHERIT;
+    ch->capacity = cap * stripes;
+    ch->mask = ch->capacity - 1;
+    ch->ring = r;
+    ch->ring_stripes = stripes;
+    ch->capabilities = spsc ? KC_CHAN_CAP_SPSC : KC_CHAN_CAP_MPMC;
+    if (stripes > 1) ch->capabilities |= KC_CHAN_CAP_STRIPED;
+    const struct kc_runtime_config *cfg = kc_runtime_config_get();
+    ch->stats_level = cfg ? cfg->chan_stats_level : KC_CHAN_STATS_FULL;
+    *out = ch;
+    kc_dbg("chan%p make %s elem_sz=%zu cap=%zu stripes=%u", (void*)ch, spsc ? "spsc" : "mpmc", elem_sz, cap, stripes);
+    return 0;
+}
+
+int kc_chan_make_mpmc(kc_chan_t **out, size_t elem_sz, size_t capacity)
+{
+    return kc_chan_make_ring(out, elem_sz, capacity, 0, 1);
+}
+
+int kc_chan_make_spsc(kc_chan_t **out, size_t elem_sz, size_t capacity)
+{
+    return kc_chan_make_ring(out, elem_sz, capacity, 1, 1);
+}
+
+int kc_chan_make_striped(kc_chan_t **out, size_t elem_sz, size_t capacity, unsigned stripes)
+{
+    if (stripes == 0) {
+        stripes = (unsigned)kc_cpu_budget();
+    }
+    if (stripes > KC_CHAN_MAX_STRIPES) stripes = KC_CHAN_MAX_STRIPES;
+    return kc_chan_make_ring(out, elem_sz, capacity, 0, (unsigned)kc_next_pow2(stripes));
+}
+
+/* Log replay target: queue a recovered element without logging it again. */
+static int kc_chan_durable_replay(void *arg, const void *elem)
+{
+    return kc_chan_seg_put_locked((struct kc_chan*)arg, elem);
+}
+
+int kc_chan_make_durable(kc_chan_t **out, const char *dir, size_t elem_sz,
+                         const kc_chan_durable_opts_t *opts)
+{
+    if (!out || !dir || !*dir || elem_sz == 0) return -EINVAL;
+    kc_chan_t *c = NULL;
+    int rc = kc_chan_make(&c, KC_UNLIMITED, elem_sz, 0);
+    if (rc) return rc;
+    struct kc_chan *ch = (struct kc_chan*)c;
+    struct kc_chan_wal *wal = NULL;
+    KC_MUTEX_LOCK(&ch->mu);
+    rc = kc_chan_wal_open(&wal, dir, elem_sz, opts, kc_chan_durable_replay, ch);
+    if (rc == 0) {
+        ch->wal = wal;
+        ch->capabilities |= KC_CHAN_CAP_DURABLE;
+    }
+    KC_MUTEX_UNLOCK(&ch->mu);
+    if (rc) { kc_chan_destroy(c); return rc; }
+    *out = c;
+    kc_dbg("chan%p make durable dir=%s elem_sz=%zu backlog=%zu", (void*)ch, dir, elem_sz, ch->count);
+    return 0;
+}
+
+int kc_chan_ack(kc_chan_t *c, size_t n)
+{
+    struct kc_chan *ch = (struct kc_chan*)c;
+    if (!ch || !ch->wal) return -EINVAL;
+    KC_MUTEX_LOCK(&ch->mu);
+    /* Everything older than the queued backlog has been received. */
+    int rc = kc_chan_wal_ack(ch->wal, n, kc_chan_wal_last(ch->wal) - ch->count);
+    KC_MUTEX_UNLOCK(&ch->mu);
+    return rc;
+}
+
+int kc_chan_sync(kc_chan_t *c)
+{
+    struct kc_chan *ch = (struct kc_chan*)c;
+    if (!ch || !ch->wal) return -EINVAL;
+    return kc_chan_wal_sync(ch->wal);
+}
+
+/* kc_chan_post elements never moved into the buffer */
+static void kc_chan_inbox_free(struct kc_chan_inbox_node *n)
+{
+    while (n) {
+        struct kc_chan_inbox_node *next = n->next;
+        free(n);
+        n = next;
+    }
+}
+
 void kc_chan_destroy(kc_chan_t *c)
 {
     if (!c) return;
@@ -328,9 +1651,28 @@ void kc_chan_destroy(kc_chan_t *c)
     if (!ch->closed) {
         kc_chan_close(c);
     }
+    kc_zref_chan_drop(ch);
+    kc_chan_metrics_unlink(ch);
+    KC_MUTEX_LOCK(&ch->mu);
+    kc_chan_set_detach_locked(ch);
+    if (ch->zc_ops && ch->zc_ops->detach) ch->zc_ops->detach(c);
+    KC_MUTEX_UNLOCK(&ch->mu);
     
-    free(ch->buf);
+    if (ch->buf) kc_mem_uncharge(KC_MEM_CHAN, ch->capacity * ch->elem_sz);
+    if (ch->buf) kc_chan_buf_release(ch->buf, ch->buf_map);
     free(ch->slot);
+    kc_chan_latest_free(ch->latest);
+    kc_chan_seg_free_all(ch->seg_head, ch->seg_elems * ch->elem_sz, 1);
+    kc_chan_seg_free_all(ch->seg_cache, ch->seg_elems * ch->elem_sz, 0);
+    kc_chan_spill_close(ch->spill);
+    kc_chan_wal_close(ch->wal);
+    kc_chan_delay_destroy(ch->delay);
+    kc_chan_prio_destroy(ch->prio);
+    kc_chan_inbox_free(ch->inbox_head);
+    kc_chan_inbox_free(atomic_load(&ch->inbox));
+    struct kc_chan_lat *lat = atomic_load(&ch->lat);
+    if (lat) { free(lat->ts); free(lat); }
+    if (ch->ring) kc_chan_rings_free(ch->ring, ch->ring_stripes);
     /* Destroy sync primitives (port-provided). */
     KC_MUTEX_DESTROY(&ch->mu);
     KC_COND_DESTROY(&ch->cv_send);
@@ -339,6 +1681,25 @@ void kc_chan_destroy(kc_chan_t *c)
     free(ch);
 }
 
+/* Claim the select for clause w: 0 when another clause (or the deadline)
+ * won meanwhile. The waiter reads the result and the clause buffer only
+ * after kc_select_cancel_all has taken ch->mu, so work done here after the
+ * claim, under ch->mu, is seen. */
+static int kc_chan_select_claim_locked(struct kc_waiter *w, int rc, int *schedule_out)
+{
+    kc_select_t *sel = w->sel;
+    if (!kc_select_try_complete(sel, w->clause_index, rc)) return 0;
+    /* Only schedule if waiter is parked; if we're in its own context (immediate path),
+     * it will continue after registration without needing scheduling. */
+    kcoro_t *co = kc_select_waiter(sel);
+    if (co && kcoro_is_parked(co) && schedule_out) *schedule_out = 1;
+    return 1;
+}
+
+/* Elements kept under ch->mu move only once the clause has won, so a select
+ * that another channel completes at the same moment leaves them for the
+ * next receiver. Lock-free rings and latest slots can only be taken, not
+ * peeked: a ring element the clause then loses is pushed back. */
 static int kc_chan_select_deliver_recv_locked(struct kc_chan *ch, struct kc_waiter *w, int *schedule_out, int *consumed_out)
 {
     if (schedule_out) *schedule_out = 0;
@@ -351,25 +1712,37 @@ static int kc_chan_select_deliver_recv_locked(struct kc_chan *ch, struct kc_wait
     if (!dst) {
         rc = KC_ECANCELED;
         if (ch->kind == KC_RENDEZVOUS) ch->rv_cancels++;
-    } else if (ch->kind == KC_CONFLATED) {
-        if (ch->has_value) {
-            memcpy(dst, ch->slot, ch->elem_sz);
-            ch->has_value = 0;
-            kc_chan_update_recv_stats_locked(ch);
-            KC_COND_SIGNAL(&ch->cv_send);
+    } else if (ch->latest) {
+        if (kc_chan_latest_take(ch, dst)) {
             if (consumed_out) *consumed_out = 1;
         } else if (ch->closed) {
             rc = KC_EPIPE;
         } else {
             rc = KC_EAGAIN;
         }
-    } else if (ch->kind == KC_RENDEZVOUS) {
+    } else if (ch->ring) {
+        if (kc_chan_ring_pop(ch, dst)) {
+            if (kc_chan_select_claim_locked(w, 0, schedule_out)) {
+                if (consumed_out) *consumed_out = 1;
+            } else {
+                (void)kc_chan_ring_push(ch, dst);
+            }
+            return 0;
+        } else if (ch->closed) {
+            rc = KC_EPIPE;
+        } else {
+            rc = KC_EAGAIN;
+        }
+    } else if (ch->kind == KC_CONFLATED || ch->kind == KC_RENDEZVOUS) {
         if (ch->has_value) {
+            if (!kc_chan_select_claim_locked(w, 0, schedule_out)) return 0;
             memcpy(dst, ch->slot, ch->elem_sz);
             ch->has_value = 0;
-            ch->rv_matches++;
+            if (ch->kind == KC_RENDEZVOUS) ch->rv_matches++;
             kc_chan_update_recv_stats_locked(ch);
+            if (ch->kind == KC_CONFLATED) KC_COND_SIGNAL(&ch->cv_send);
             if (consumed_out) *consumed_out = 1;
+            return 0;
         } else if (ch->closed) {
             rc = KC_EPIPE;
         } else {
@@ -377,14 +1750,12 @@ static int kc_chan_select_deliver_recv_locked(struct kc_chan *ch, struct kc_wait
         }
     } else {
         if (ch->count > 0) {
-            size_t h = kc_ring_idx(ch, ch->head);
-            memcpy(dst, ch->buf + (h * ch->elem_sz), ch->elem_sz);
-            size_t n2 = ch->head + 1;
-            ch->head = ch->mask ? (n2 & ch->mask) : (n2 % ch->capacity);
-            ch->count--;
+            if (!kc_chan_select_claim_locked(w, 0, schedule_out)) return 0;
+            kc_chan_buf_take_locked(ch, dst);
             kc_chan_update_recv_stats_locked(ch);
             KC_COND_SIGNAL(&ch->cv_send);
             if (consumed_out) *consumed_out = 1;
+            return 0;
         } else if (ch->closed) {
             rc = KC_EPIPE;
         } else {
@@ -395,17 +1766,13 @@ static int kc_chan_select_deliver_recv_locked(struct kc_chan *ch, struct kc_wait
     if (rc == KC_EAGAIN)
         return rc;
 
-    if (kc_select_try_complete(sel, w->clause_index, rc)) {
-        /* Only schedule if waiter is parked; if we're in its own context (immediate path),
-         * it will continue after registration without needing scheduling. */
-        kcoro_t *co = kc_select_waiter(sel);
-        if (co && kcoro_is_parked(co) && schedule_out) {
-            *schedule_out = 1;
-        }
-    }
+    (void)kc_chan_select_claim_locked(w, rc, schedule_out);
     return rc;
 }
 
+/* As above: the element goes in only for a clause that won, so a select
+ * that lost the race sends nothing. A lock-free ring is the exception, as
+ * its room cannot be held while claiming. */
 static int kc_chan_select_deliver_send_locked(struct kc_chan *ch, struct kc_waiter *w, int *schedule_out)
 {
     if (schedule_out) *schedule_out = 0;
@@ -415,101 +1782,74 @@ static int kc_chan_select_deliver_send_locked(struct kc_chan *ch, struct kc_wait
     int rc = 0;
     const void *src = kc_select_send_buffer(sel, w->clause_index);
 
-    if (ch->kind == KC_CONFLATED) {
+    if (ch->latest) {
+        if (!kc_chan_select_claim_locked(w, 0, schedule_out)) return 0;
+        rc = kc_chan_latest_put(ch, src);
+        if (rc != 0) kc_select_set_result(sel, rc);
+        return rc;
+    }
+
+    if (ch->kind == KC_CONFLATED || ch->kind == KC_RENDEZVOUS) {
+        if (!kc_chan_select_claim_locked(w, 0, schedule_out)) return 0;
         if (src) memcpy(ch->slot, src, ch->elem_sz);
         ch->has_value = 1;
         kc_chan_update_send_stats_locked(ch);
-        KC_COND_SIGNAL(&ch->cv_recv);
-    if (kc_select_try_complete(sel, w->clause_index, 0)) {
-        kcoro_t *co = kc_select_waiter(sel);
-        if (co && kcoro_is_parked(co) && schedule_out) {
-            *schedule_out = 1;
-        }
+        if (ch->kind == KC_CONFLATED) KC_COND_SIGNAL(&ch->cv_recv);
+        return 0;
     }
+
+    if (ch->ring) {
+        if (!kc_chan_ring_push(ch, src)) return KC_EAGAIN;
+        (void)kc_chan_select_claim_locked(w, 0, schedule_out);
         return 0;
     }
 
-    if (ch->kind == KC_RENDEZVOUS) {
-        if (src) memcpy(ch->slot, src, ch->elem_sz);
-        ch->has_value = 1;
+    if (ch->count == ch->capacity && ch->kind != KC_UNLIMITED)
+        return KC_EAGAIN;
+    if (!kc_chan_select_claim_locked(w, 0, schedule_out)) return 0;
+    rc = kc_chan_buf_put_locked(ch, src);
+    if (rc == 0) {
         kc_chan_update_send_stats_locked(ch);
-    if (kc_select_try_complete(sel, w->clause_index, 0)) {
-        kcoro_t *co = kc_select_waiter(sel);
-        if (co && kcoro_is_parked(co) && schedule_out) {
-            *schedule_out = 1;
-        }
-    }
-        return 0;
-    }
-
-    if (ch->count == ch->capacity && ch->kind != KC_UNLIMITED) {
-        rc = KC_EAGAIN;
+        KC_COND_SIGNAL(&ch->cv_recv);
     } else {
-        if (ch->count == ch->capacity && ch->kind == KC_UNLIMITED) {
-            size_t newcap = ch->capacity ? ch->capacity * 2 : KCORO_UNLIMITED_INIT_CAP;
-            unsigned char *nbuf = malloc(newcap * ch->elem_sz);
-            if (!nbuf) rc = -ENOMEM;
-            else {
-                size_t old_cap = ch->capacity; size_t old_mask = ch->mask;
-                for (size_t i = 0; i < ch->count; ++i) {
-                    size_t idx = old_mask ? ((ch->head + i) & old_mask) : ((ch->head + i) % old_cap);
-                    memcpy(nbuf + (i * ch->elem_sz), ch->buf + (idx * ch->elem_sz), ch->elem_sz);
-                }
-                free(ch->buf);
-                ch->buf = nbuf;
-                ch->capacity = newcap;
-                ch->mask = newcap - 1;
-                ch->head = 0;
-                ch->tail = ch->count;
-            }
-        }
-        if (rc == 0) {
-            size_t t = kc_ring_idx(ch, ch->tail);
-            if (src) memcpy(ch->buf + (t * ch->elem_sz), src, ch->elem_sz);
-            size_t next = ch->tail + 1;
-            ch->tail = ch->mask ? (next & ch->mask) : (next % ch->capacity);
-            ch->count++;
-            kc_chan_update_send_stats_locked(ch);
-            KC_COND_SIGNAL(&ch->cv_recv);
-        }
-    if (kc_select_try_complete(sel, w->clause_index, rc)) {
-            kcoro_t *co = kc_select_waiter(sel);
-            if (co && kcoro_is_parked(co) && schedule_out) {
-                *schedule_out = 1;
-            }
-        }
-        return rc;
-    }
-
-    if (kc_select_try_complete(sel, w->clause_index, rc)) {
-        kcoro_t *co = kc_select_waiter(sel);
-        if (co && kcoro_is_parked(co) && schedule_out) {
-            *schedule_out = 1;
-        }
+        kc_select_set_result(sel, rc);
     }
     return rc;
 }
 
 static struct kc_wake kc_chan_wake_recv_locked(struct kc_chan *ch)
 {
-    struct kc_wake wake = {0};
+    struct kc_wake wake = { .lane = ch->wake_lane, .home = kc_chan_wake_home(ch, KC_SELECT_CLAUSE_RECV) };
+    /* Lock-free puts keep no stats under ch->mu: this is their notify point. */
+    if (ch->ring || ch->latest) kc_chan_set_note_locked(ch, KC_CHAN_SET_RECV);
     for (;;) {
         struct kc_waiter *w = kc_waiter_pop(&ch->wq_recv_head, &ch->wq_recv_tail);
-        if (!w) return wake;
+        if (!w) {
+            if (!kc_ticket_queue_empty(&ch->tq_recv)) (void)kc_chan_ptr_signal_locked(ch, &ch->tq_recv, KC_EAGAIN);
+            return wake;
+        }
         if (w->kind == KC_WAITER_CORO) {
             wake.co = w->co;
-            if (wake.co) kcoro_retain(wake.co);
+            if (wake.co) { kcoro_retain(wake.co); KC_TRACE(KC_TRACE_CHAN_WAKE, wake.co, (uintptr_t)ch); }
             kc_waiter_dispose(w);
             return wake;
         }
+        if (w->kind == KC_WAITER_THREAD) {
+            kc_waiter_dispose(w);   /* signals the blocked thread */
+            return wake;
+        }
         int schedule = 0;
         int consumed = 0;
         kc_select_t *sel = w->sel;
-        kc_chan_select_deliver_recv_locked(ch, w, &schedule, &consumed);
+        if (kc_chan_select_deliver_recv_locked(ch, w, &schedule, &consumed) == KC_EAGAIN) {
+            /* Nothing to hand over (a lock-free receiver got there first): keep waiting. */
+            kc_waiter_push_front(&ch->wq_recv_head, &ch->wq_recv_tail, w);
+            return wake;
+        }
         kc_waiter_dispose(w);
         if (schedule) {
             wake.co = kc_select_waiter(sel);
-            if (wake.co) kcoro_retain(wake.co);
+            if (wake.co) { kcoro_retain(wake.co); KC_TRACE(KC_TRACE_CHAN_WAKE, wake.co, (uintptr_t)ch); }
             wake.sel = sel;
             return wake;
         }
@@ -519,23 +1859,35 @@ static struct kc_wake kc_chan_wake_recv_locked(struct kc_chan *ch)
 
 static struct kc_wake kc_chan_wake_send_locked(struct kc_chan *ch)
 {
-    struct kc_wake wake = {0};
+    struct kc_wake wake = { .lane = ch->wake_lane, .home = kc_chan_wake_home(ch, KC_SELECT_CLAUSE_SEND) };
+    if (ch->ring) kc_chan_set_note_locked(ch, KC_CHAN_SET_SEND);
     for (;;) {
         struct kc_waiter *w = kc_waiter_pop(&ch->wq_send_head, &ch->wq_send_tail);
-        if (!w) return wake;
+        if (!w) {
+            if (!kc_ticket_queue_empty(&ch->tq_send)) (void)kc_chan_ptr_signal_locked(ch, &ch->tq_send, KC_EAGAIN);
+            return wake;
+        }
         if (w->kind == KC_WAITER_CORO) {
             wake.co = w->co;
-            if (wake.co) kcoro_retain(wake.co);
+            if (wake.co) { kcoro_retain(wake.co); KC_TRACE(KC_TRACE_CHAN_WAKE, wake.co, (uintptr_t)ch); }
             kc_waiter_dispose(w);
             return wake;
         }
+        if (w->kind == KC_WAITER_THREAD) {
+            kc_waiter_dispose(w);   /* signals the blocked thread */
+            return wake;
+        }
         int schedule = 0;
         kc_select_t *sel = w->sel;
-        kc_chan_select_deliver_send_locked(ch, w, &schedule);
+        if (kc_chan_select_deliver_send_locked(ch, w, &schedule) == KC_EAGAIN) {
+            /* No room (a lock-free sender got there first): keep waiting. */
+            kc_waiter_push_front(&ch->wq_send_head, &ch->wq_send_tail, w);
+            return wake;
+        }
         kc_waiter_dispose(w);
         if (schedule) {
             wake.co = kc_select_waiter(sel);
-            if (wake.co) kcoro_retain(wake.co);
+            if (wake.co) { kcoro_retain(wake.co); KC_TRACE(KC_TRACE_CHAN_WAKE, wake.co, (uintptr_t)ch); }
             wake.sel = sel;
             return wake;
         }
@@ -548,24 +1900,53 @@ int kc_chan_select_register_recv(kc_chan_t *c, kc_select_t *sel, int clause_inde
     if (!c || !sel) return -EINVAL;
     struct kc_chan *ch = (struct kc_chan*)c;
     /* Disallow registering selects once zero-copy mode engaged to avoid mixing semantics */
-    if (ch->zref_mode) return -ENOTSUP;
+    if (ch->zref_mode || ch->delay) return -ENOTSUP;
     struct kc_wake_list wakes = {0};
     KC_MUTEX_LOCK(&ch->mu);
 
-    if (ch->kind == KC_CONFLATED) {
+    if (ch->latest) {
+        kc_chan_latest_announce_locked(ch);
+        void *dst = kc_select_recv_buffer(sel, clause_index);
+        int got = dst ? kc_chan_latest_take(ch, dst) : 0;
+        if (got || (!dst && kc_chan_latest_full(ch))) {
+            if (got && kc_select_try_complete(sel, clause_index, 0)) {
+                kcoro_t *co = kc_select_waiter(sel);
+                if (co && kcoro_is_parked(co)) {
+                    kcoro_retain(co);
+                    struct kc_wake wake = { .co = co, .sel = sel, .lane = ch->wake_lane,
+                                             .home = kc_chan_wake_home(ch, KC_SELECT_CLAUSE_SEND) };
+                    kc_wake_list_append(&wakes, wake);
+                }
+            }
+            kc_chan_latest_sync_locked(ch);
+            KC_MUTEX_UNLOCK(&ch->mu);
+            kc_wake_list_schedule(&wakes);
+            return got ? 0 : KC_ECANCELED;
+        }
+        if (ch->closed) {
+            kc_chan_latest_sync_locked(ch);
+            KC_MUTEX_UNLOCK(&ch->mu);
+            return KC_EPIPE;
+        }
+    } else if (ch->kind == KC_CONFLATED) {
         if (ch->has_value) {
             void *dst = kc_select_recv_buffer(sel, clause_index);
             int result = 0;
             if (dst) {
+                if (!kc_select_try_complete(sel, clause_index, 0)) {
+                    KC_MUTEX_UNLOCK(&ch->mu);
+                    return KC_ECANCELED; /* another clause won meanwhile */
+                }
                 memcpy(dst, ch->slot, ch->elem_sz);
                 ch->has_value = 0;
                 KC_COND_SIGNAL(&ch->cv_send);
-                /* Immediate success: complete select and schedule waiter */
-                if (kc_select_try_complete(sel, clause_index, 0)) {
+                /* Immediate success: schedule the waiter */
+                {
                     kcoro_t *co = kc_select_waiter(sel);
                     if (co && kcoro_is_parked(co)) {
                         kcoro_retain(co);
-                        struct kc_wake wake = { .co = co, .sel = sel };
+                        struct kc_wake wake = { .co = co, .sel = sel, .lane = ch->wake_lane,
+                                             .home = kc_chan_wake_home(ch, KC_SELECT_CLAUSE_SEND) };
                         kc_wake_list_append(&wakes, wake);
                     }
                 }
@@ -586,15 +1967,19 @@ int kc_chan_select_register_recv(kc_chan_t *c, kc_select_t *sel, int clause_inde
             void *dst = kc_select_recv_buffer(sel, clause_index);
             int result = 0;
             if (dst) {
+                if (!kc_select_try_complete(sel, clause_index, 0)) {
+                    KC_MUTEX_UNLOCK(&ch->mu);
+                    return KC_ECANCELED; /* another clause won meanwhile */
+                }
                 memcpy(dst, ch->slot, ch->elem_sz);
                 ch->has_value = 0;
                 ch->rv_matches++;
-                /* Complete select for immediate rendezvous value */
-                if (kc_select_try_complete(sel, clause_index, 0)) {
+                {
                     kcoro_t *co = kc_select_waiter(sel);
                     if (co && kcoro_is_parked(co)) {
                         kcoro_retain(co);
-                        struct kc_wake wake = { .co = co, .sel = sel };
+                        struct kc_wake wake = { .co = co, .sel = sel, .lane = ch->wake_lane,
+                                             .home = kc_chan_wake_home(ch, KC_SELECT_CLAUSE_SEND) };
                         kc_wake_list_append(&wakes, wake);
                     }
                 }
@@ -608,29 +1993,77 @@ int kc_chan_select_register_recv(kc_chan_t *c, kc_select_t *sel, int clause_inde
             kc_wake_list_schedule(&wakes);
             return result;
         }
+        /* Pointer channels: match a send_ptr parked on a ticket. */
+        void *dst = kc_ticket_queue_empty(&ch->tq_send) ? NULL : kc_select_recv_buffer(sel, clause_index);
+        struct kc_chan_ptrmsg m;
+        if (dst && kc_chan_ptr_take_locked(ch, &m)) {
+            memcpy(dst, &m, sizeof(m));
+            ch->rv_matches++;
+            kc_chan_update_send_stats_len_locked(ch, m.len);
+            if (kc_select_try_complete(sel, clause_index, 0)) {
+                kcoro_t *co = kc_select_waiter(sel);
+                if (co && kcoro_is_parked(co)) {
+                    kcoro_retain(co);
+                    struct kc_wake wake = { .co = co, .sel = sel, .lane = ch->wake_lane,
+                                             .home = kc_chan_wake_home(ch, KC_SELECT_CLAUSE_SEND) };
+                    kc_wake_list_append(&wakes, wake);
+                }
+            }
+            KC_MUTEX_UNLOCK(&ch->mu);
+            kc_wake_list_schedule(&wakes);
+            return 0;
+        }
         if (ch->closed) {
             KC_MUTEX_UNLOCK(&ch->mu);
             kc_wake_list_schedule(&wakes);
             return KC_EPIPE;
         }
+    } else if (ch->ring) {
+        kc_chan_ring_announce_locked(ch, KC_SELECT_CLAUSE_RECV);
+        void *dst = kc_select_recv_buffer(sel, clause_index);
+        int got = dst ? kc_chan_ring_pop(ch, dst) : 0;
+        if (got || (!dst && kc_chan_ring_len(ch) > 0)) {
+            int result = got ? 0 : KC_ECANCELED;
+            if (got) {
+                struct kc_wake send_wake = kc_chan_wake_send_locked(ch);
+                kc_wake_list_append(&wakes, send_wake);
+                if (kc_select_try_complete(sel, clause_index, 0)) {
+                    kcoro_t *co = kc_select_waiter(sel);
+                    if (co && kcoro_is_parked(co)) {
+                        kcoro_retain(co);
+                        struct kc_wake wake = { .co = co, .sel = sel, .lane = ch->wake_lane,
+                                             .home = kc_chan_wake_home(ch, KC_SELECT_CLAUSE_SEND) };
+                        kc_wake_list_append(&wakes, wake);
+                    }
+                }
+            }
+            kc_chan_ring_sync_locked(ch);
+            KC_MUTEX_UNLOCK(&ch->mu);
+            kc_wake_list_schedule(&wakes);
+            return result;
+        }
+        if (ch->closed) {
+            kc_chan_ring_sync_locked(ch);
+            KC_MUTEX_UNLOCK(&ch->mu);
+            return KC_EPIPE;
+        }
     } else { /* buffered/unlimited */
         if (ch->count > 0) {
-            size_t h = kc_ring_idx(ch, ch->head);
             void *dst = kc_select_recv_buffer(sel, clause_index);
             int result = 0;
-            if (dst) {
-                memcpy(dst, ch->buf + (h * ch->elem_sz), ch->elem_sz);
-                size_t n2 = ch->head + 1;
-                ch->head = ch->mask ? (n2 & ch->mask) : (n2 % ch->capacity);
-                ch->count--;
+            if (dst && !kc_select_try_complete(sel, clause_index, 0)) {
+                result = KC_ECANCELED; /* another clause won meanwhile */
+            } else if (dst) {
+                kc_chan_buf_take_locked(ch, dst);
                 KC_COND_SIGNAL(&ch->cv_send);
                 struct kc_wake send_wake = kc_chan_wake_send_locked(ch);
                 kc_wake_list_append(&wakes, send_wake);
-                if (kc_select_try_complete(sel, clause_index, 0)) {
+                {
                     kcoro_t *co = kc_select_waiter(sel);
                     if (co && kcoro_is_parked(co)) {
                         kcoro_retain(co);
-                        struct kc_wake wake = { .co = co, .sel = sel };
+                        struct kc_wake wake = { .co = co, .sel = sel, .lane = ch->wake_lane,
+                                             .home = kc_chan_wake_home(ch, KC_SELECT_CLAUSE_SEND) };
                         kc_wake_list_append(&wakes, wake);
                     }
                 }
@@ -662,7 +2095,7 @@ int kc_chan_select_register_send(kc_chan_t *c, kc_select_t *sel, int clause_inde
 {
     if (!c || !sel) return -EINVAL;
     struct kc_chan *ch = (struct kc_chan*)c;
-    if (ch->zref_mode) return -ENOTSUP;
+    if (ch->zref_mode || ch->delay) return -ENOTSUP;
     struct kc_wake_list wakes = {0};
     const void *src = kc_select_send_buffer(sel, clause_index);
     if (!src) src = NULL;
@@ -675,19 +2108,26 @@ int kc_chan_select_register_send(kc_chan_t *c, kc_select_t *sel, int clause_inde
     }
 
     if (ch->kind == KC_CONFLATED) {
-        if (src) memcpy(ch->slot, src, ch->elem_sz);
-        ch->has_value = 1;
-        KC_COND_SIGNAL(&ch->cv_recv);
+        if (!kc_select_try_complete(sel, clause_index, 0)) {
+            KC_MUTEX_UNLOCK(&ch->mu);
+            return KC_ECANCELED; /* another clause won meanwhile */
+        }
+        if (ch->latest) {
+            (void)kc_chan_latest_put(ch, src);   /* not closed: close takes ch->mu */
+        } else {
+            if (src) memcpy(ch->slot, src, ch->elem_sz);
+            ch->has_value = 1;
+            KC_COND_SIGNAL(&ch->cv_recv);
+        }
         /* Deliver immediately to any waiting select recv waiter */
         struct kc_wake recv_wake = kc_chan_wake_recv_locked(ch);
         kc_wake_list_append(&wakes, recv_wake);
-        if (kc_select_try_complete(sel, clause_index, 0)) {
-            kcoro_t *co = kc_select_waiter(sel);
-            if (co && kcoro_is_parked(co)) {
-                kcoro_retain(co);
-                struct kc_wake wake = { .co = co, .sel = sel };
-                kc_wake_list_append(&wakes, wake);
-            }
+        kcoro_t *co = kc_select_waiter(sel);
+        if (co && kcoro_is_parked(co)) {
+            kcoro_retain(co);
+            struct kc_wake wake = { .co = co, .sel = sel, .lane = ch->wake_lane,
+                                             .home = kc_chan_wake_home(ch, KC_SELECT_CLAUSE_RECV) };
+            kc_wake_list_append(&wakes, wake);
         }
         KC_MUTEX_UNLOCK(&ch->mu);
         kc_wake_list_schedule(&wakes);
@@ -705,37 +2145,67 @@ int kc_chan_select_register_send(kc_chan_t *c, kc_select_t *sel, int clause_inde
             kc_wake_list_schedule(&wakes);
             return 0;
         }
+        /* Pointer channels: hand to a recv_ptr parked on a ticket. */
+        if (src && !kc_ticket_queue_empty(&ch->tq_recv)) {
+            struct kc_chan_ptrmsg m;
+            memcpy(&m, src, sizeof(m));
+            if (kc_chan_ptr_give_locked(ch, &m)) {
+                ch->rv_matches++;
+                kc_chan_update_recv_stats_len_locked(ch, m.len);
+                if (kc_select_try_complete(sel, clause_index, 0)) {
+                    kcoro_t *co = kc_select_waiter(sel);
+                    if (co && kcoro_is_parked(co)) {
+                        kcoro_retain(co);
+                        struct kc_wake wake = { .co = co, .sel = sel, .lane = ch->wake_lane,
+                                             .home = kc_chan_wake_home(ch, KC_SELECT_CLAUSE_RECV) };
+                        kc_wake_list_append(&wakes, wake);
+                    }
+                }
+                KC_MUTEX_UNLOCK(&ch->mu);
+                kc_wake_list_schedule(&wakes);
+                return 0;
+            }
+        }
+    } else if (ch->ring) {
+        kc_chan_ring_announce_locked(ch, KC_SELECT_CLAUSE_SEND);
+        if (kc_chan_ring_push(ch, src)) {
+            struct kc_wake recv_wake = kc_chan_wake_recv_locked(ch);
+            kc_wake_list_append(&wakes, recv_wake);
+            if (kc_select_try_complete(sel, clause_index, 0)) {
+                kcoro_t *co = kc_select_waiter(sel);
+                if (co && kcoro_is_parked(co)) {
+                    kcoro_retain(co);
+                    struct kc_wake wake = { .co = co, .sel = sel, .lane = ch->wake_lane,
+                                             .home = kc_chan_wake_home(ch, KC_SELECT_CLAUSE_RECV) };
+                    kc_wake_list_append(&wakes, wake);
+                }
+            }
+            kc_chan_ring_sync_locked(ch);
+            KC_MUTEX_UNLOCK(&ch->mu);
+            kc_wake_list_schedule(&wakes);
+            return 0;
+        }
     } else { /* buffered/unlimited */
         if (ch->count < ch->capacity || ch->kind == KC_UNLIMITED) {
-            if (ch->count == ch->capacity && ch->kind == KC_UNLIMITED) {
-                size_t newcap = ch->capacity ? ch->capacity * 2 : KCORO_UNLIMITED_INIT_CAP;
-                unsigned char *nbuf = malloc(newcap * ch->elem_sz);
-                if (!nbuf) { KC_MUTEX_UNLOCK(&ch->mu); return -ENOMEM; }
-                size_t old_cap = ch->capacity; size_t old_mask = ch->mask;
-                for (size_t i = 0; i < ch->count; ++i) {
-                    size_t idx = old_mask ? ((ch->head + i) & old_mask) : ((ch->head + i) % old_cap);
-                    memcpy(nbuf + (i * ch->elem_sz), ch->buf + (idx * ch->elem_sz), ch->elem_sz);
-                }
-                free(ch->buf);
-                ch->buf = nbuf;
-                ch->capacity = newcap;
-                ch->mask = newcap - 1;
-                ch->head = 0;
-                ch->tail = ch->count;
+            /* Claim the select before the put so a clause that lost to a
+             * concurrent completion leaves the buffer alone. An unlimited
+             * put can fail (allocation), so there it goes first. */
+            int claimed = ch->kind != KC_UNLIMITED && kc_select_try_complete(sel, clause_index, 0);
+            if (ch->kind != KC_UNLIMITED && !claimed) {
+                KC_MUTEX_UNLOCK(&ch->mu);
+                return KC_ECANCELED;
             }
-            size_t t = kc_ring_idx(ch, ch->tail);
-            if (src) memcpy(ch->buf + (t * ch->elem_sz), src, ch->elem_sz);
-            size_t next = ch->tail + 1;
-            ch->tail = ch->mask ? (next & ch->mask) : (next % ch->capacity);
-            ch->count++;
+            int put_rc = kc_chan_buf_put_locked(ch, src);
+            if (put_rc != 0) { KC_MUTEX_UNLOCK(&ch->mu); return put_rc; }
             KC_COND_SIGNAL(&ch->cv_recv);
             struct kc_wake recv_wake = kc_chan_wake_recv_locked(ch);
             kc_wake_list_append(&wakes, recv_wake);
-            if (kc_select_try_complete(sel, clause_index, 0)) {
+            if (claimed || kc_select_try_complete(sel, clause_index, 0)) {
                 kcoro_t *co = kc_select_waiter(sel);
                 if (co && kcoro_is_parked(co)) {
                     kcoro_retain(co);
-                    struct kc_wake wake = { .co = co, .sel = sel };
+                    struct kc_wake wake = { .co = co, .sel = sel, .lane = ch->wake_lane,
+                                             .home = kc_chan_wake_home(ch, KC_SELECT_CLAUSE_RECV) };
                     kc_wake_list_append(&wakes, wake);
                 }
             }
@@ -761,29 +2231,19 @@ void kc_chan_select_cancel(kc_chan_t *c, kc_select_t *sel, int clause_index, enu
     struct kc_chan *ch = (struct kc_chan*)c;
     KC_MUTEX_LOCK(&ch->mu);
 
-    struct kc_waiter **lists_head[] = { &ch->wq_recv_head, &ch->wq_send_head };
-    struct kc_waiter **lists_tail[] = { &ch->wq_recv_tail, &ch->wq_send_tail };
-
-    for (int i = 0; i < 2; ++i) {
-        struct kc_waiter **head = lists_head[i];
-        struct kc_waiter **tail = lists_tail[i];
-        struct kc_waiter *prev = NULL;
-        struct kc_waiter *cur = *head;
-        while (cur) {
-            int match = (cur->kind == KC_WAITER_SELECT && cur->sel == sel && cur->clause_index == clause_index && cur->clause_kind == kind);
-            if (match) {
-                struct kc_waiter *dead = cur;
-                if (prev) prev->next = cur->next; else *head = cur->next;
-                cur = cur->next;
-                if (dead == *tail) *tail = prev;
-                kc_waiter_dispose(dead);
-                if (ch->kind == KC_RENDEZVOUS) ch->rv_cancels++;
-            } else {
-                prev = cur;
-                cur = cur->next;
-            }
+    /* The clause's own registration, still queued or already popped by a
+     * peer (delivered to, or skipped as lost): reaped here either way. The
+     * lock is still taken to wait out a delivery in progress. */
+    struct kc_waiter *w = sel->clauses[clause_index].waiter;
+    sel->clauses[clause_index].waiter = NULL;
+    if (w && w->clause_kind == kind) {
+        if (w->q_head) {
+            kc_waiter_unlink(w);
+            if (ch->kind == KC_RENDEZVOUS) ch->rv_cancels++;
         }
+        kc_waiter_destroy(w);
     }
+    kc_chan_hints_sync_locked(ch);
 
     KC_MUTEX_UNLOCK(&ch->mu);
 }
@@ -791,8 +2251,11 @@ void kc_chan_select_cancel(kc_chan_t *c, kc_select_t *sel, int clause_index, enu
 void kc_chan_close(kc_chan_t *c)
 {
     struct kc_chan *ch = (struct kc_chan*)c;
+    long rec_t0 = KC_CHAN_REC_T0();
     KC_MUTEX_LOCK(&ch->mu);
     ch->closed = 1;
+    if (ch->ring) atomic_store_explicit(&ch->ring->closed, 1, memory_order_release);
+    if (ch->latest) atomic_fetch_or_explicit(&ch->latest->state, KC_LATEST_CLOSED, memory_order_release);
     ch->zref_sender_waiter_expected = 0; /* clear to avoid invariant trips after close */
     /* Close policy for zero-copy staged pointer:
      * If a pointer is already published (zref_ready=1) at the moment of close, we DO NOT
@@ -803,20 +2266,21 @@ void kc_chan_close(kc_chan_t *c)
     kc_dbg("chan%p close", (void*)ch);
     KC_COND_BROADCAST(&ch->cv_send);
     KC_COND_BROADCAST(&ch->cv_recv);
-    struct kc_wake_list wakes = {0};
+    /* Every parked waiter goes at once: coalesce them into batched wakes
+     * (full batches are handed over under ch->mu, like a full wake list). */
+    struct kc_wake_batch wakes;
+    kc_wake_batch_init(&wakes, 1);
 
     struct kc_waiter *w;
     while ((w = kc_waiter_pop(&ch->wq_send_head, &ch->wq_send_tail)) != NULL) {
         if (w->kind == KC_WAITER_CORO) {
             if (w->co) kcoro_retain(w->co);
-            struct kc_wake wake = { .co = w->co };
-            kc_wake_list_append(&wakes, wake);
+            kc_wake_batch_add(&wakes, kc_chan_wake_sched(w->co), w->co, (kc_lane_t)ch->wake_lane);
         } else if (w->sel) {
             if (kc_select_try_complete(w->sel, w->clause_index, KC_EPIPE)) {
                 kcoro_t *co = kc_select_waiter(w->sel);
                 if (co) kcoro_retain(co);
-                struct kc_wake wake = { .co = co, .sel = w->sel };
-                kc_wake_list_append(&wakes, wake);
+                kc_wake_batch_add(&wakes, kc_chan_wake_sched(co), co, (kc_lane_t)ch->wake_lane);
             }
         }
         if (ch->kind == KC_RENDEZVOUS) ch->rv_cancels++;
@@ -825,213 +2289,596 @@ void kc_chan_close(kc_chan_t *c)
     while ((w = kc_waiter_pop(&ch->wq_recv_head, &ch->wq_recv_tail)) != NULL) {
         if (w->kind == KC_WAITER_CORO) {
             if (w->co) kcoro_retain(w->co);
-            struct kc_wake wake = { .co = w->co };
-            kc_wake_list_append(&wakes, wake);
+            kc_wake_batch_add(&wakes, kc_chan_wake_sched(w->co), w->co, (kc_lane_t)ch->wake_lane);
         } else if (w->sel) {
             if (kc_select_try_complete(w->sel, w->clause_index, KC_EPIPE)) {
                 kcoro_t *co = kc_select_waiter(w->sel);
                 if (co) kcoro_retain(co);
-                struct kc_wake wake = { .co = co, .sel = w->sel };
-                kc_wake_list_append(&wakes, wake);
+                kc_wake_batch_add(&wakes, kc_chan_wake_sched(co), co, (kc_lane_t)ch->wake_lane);
             }
         }
         if (ch->kind == KC_RENDEZVOUS) ch->rv_cancels++;
         kc_waiter_dispose(w);
     }
+    while (kc_chan_ptr_signal_locked(ch, &ch->tq_send, KC_EPIPE)) {
+        if (ch->kind == KC_RENDEZVOUS) ch->rv_cancels++;
+    }
+    while (kc_chan_ptr_signal_locked(ch, &ch->tq_recv, KC_EPIPE)) {
+        if (ch->kind == KC_RENDEZVOUS) ch->rv_cancels++;
+    }
+    kc_chan_set_note_locked(ch, KC_CHAN_SET_RECV | KC_CHAN_SET_SEND | KC_CHAN_SET_CLOSED);
+    kc_chan_hints_sync_locked(ch);
     KC_MUTEX_UNLOCK(&ch->mu);
-    kc_wake_list_schedule(&wakes);
+    kc_wake_batch_flush(&wakes);
+    KC_CHAN_REC(ch, KC_CHAN_REC_CLOSE, rec_t0, 0, 0, 0);
 }
 
 unsigned kc_chan_len(kc_chan_t *c)
 {
     struct kc_chan *ch = (struct kc_chan*)c;
-    KC_MUTEX_LOCK(&ch->mu);
-    unsigned v = 0;
-    if (ch->kind == KC_CONFLATED)
-        v = ch->has_value ? 1 : 0;
-    else
-        v = (unsigned)ch->count;
-    KC_MUTEX_UNLOCK(&ch->mu);
-    return v;
+    if (ch->ring) return (unsigned)kc_chan_ring_len(ch);
+    if (ch->latest) return (unsigned)kc_chan_latest_full(ch);
+    /* Relaxed, no ch->mu: a value some op left, stale by the time it returns anyway. */
+    if (ch->kind == KC_CONFLATED) return __atomic_load_n(&ch->has_value, __ATOMIC_RELAXED) ? 1u : 0u;
+    return (unsigned)__atomic_load_n(&ch->count, __ATOMIC_RELAXED);
 }
 
-int kc_chan_send(kc_chan_t *c, const void *msg, long timeout_ms)
+/* ---- Spin-before-park ----------------------------------------------------
+ * A blocking op that finds nothing to do probes the channel for up to the
+ * channel's spin budget before it queues a waiter: a peer a few hundred ns
+ * away then costs no park/unpark round trip. The budget follows the waits
+ * that spins won (see KCORO_CHAN_SPIN_NS). */
+
+static inline void kc_chan_relax(void)
 {
-    struct kc_chan *ch = (struct kc_chan*)c;
-    if (!ch || !msg) return -EINVAL;
-    if (ch->zref_mode) return -EINVAL; /* disallow mixing modes */
-    /* Require coroutine context (no thread-blocking). */
-    assert(kcoro_current() != NULL);
-    long deadline_ns = 0; int timed = (timeout_ms > 0);
-    if (timed) deadline_ns = kc_now_ns() + timeout_ms * 1000000L;
-again_send:
-    KC_MUTEX_LOCK(&ch->mu);
-    kc_dbg("chan%p send kind=%d tmo=%ld cnt=%zu cap=%zu", (void*)ch, ch->kind,
-           timeout_ms, ch->count, ch->capacity);
-    if (ch->closed) { ch->send_epipe++; KC_MUTEX_UNLOCK(&ch->mu); return KC_EPIPE; }
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield" ::: "memory");
+#endif
+}
 
-    struct kc_wake wake_recv = {0};
+/* KCORO_CHAN_SPIN_NS, or 0 with a CPU budget of one; -1 until first asked. */
+static _Atomic long g_chan_spin_cap = -1;
 
-    if (ch->kind == KC_CONFLATED) {
-        memcpy(ch->slot, msg, ch->elem_sz);
-        ch->has_value = 1;
-        kc_chan_update_send_stats_locked(ch);
-        KC_COND_SIGNAL(&ch->cv_recv);
-        wake_recv = kc_chan_wake_recv_locked(ch);
-        KC_MUTEX_UNLOCK(&ch->mu);
-        kc_chan_schedule_wake(wake_recv);
-        kc_dbg("chan%p send conflated set", (void*)ch);
-        return 0;
+static long kc_chan_spin_cap(void)
+{
+    long cap = atomic_load_explicit(&g_chan_spin_cap, memory_order_relaxed);
+    if (cap < 0) {
+        cap = kc_cpu_budget() > 1 ? KCORO_CHAN_SPIN_NS : 0;
+        atomic_store_explicit(&g_chan_spin_cap, cap, memory_order_relaxed);
     }
+    return cap;
+}
 
-    if (ch->kind == KC_RENDEZVOUS) {
-        if (ch->wq_recv_head == NULL || ch->has_value) {
-            if (timeout_ms == 0) { ch->send_eagain++; KC_MUTEX_UNLOCK(&ch->mu); return KC_EAGAIN; }
-            if (timed) {
-                KC_MUTEX_UNLOCK(&ch->mu);
-                if (kc_now_ns() >= deadline_ns) return KC_ETIME;
-                kcoro_yield();
-                goto again_send;
-            }
-            struct kc_waiter *w = kc_waiter_new_coro(KC_SELECT_CLAUSE_SEND);
-            if (!w) { KC_MUTEX_UNLOCK(&ch->mu); return -ENOMEM; }
-            kc_waiter_append(&ch->wq_send_head, &ch->wq_send_tail, w);
+/* Probe: 1 done (ready, or the op itself succeeded), 0 keep spinning, -1
+ * stop (closed). */
+typedef int (*kc_chan_spin_probe_fn)(struct kc_chan *ch, void *arg);
+
+/* Spin with ch->mu not held. 1 when the probe succeeded in time. */
+static int kc_chan_spin(struct kc_chan *ch, kc_chan_spin_probe_fn probe, void *arg)
+{
+    long cap = kc_chan_spin_cap();
+    if (cap <= 0) return 0;
+    long budget = __atomic_load_n(&ch->spin_ns, __ATOMIC_RELAXED);
+    if (budget <= 0) budget = cap;
+    long t0 = kc_now_ns(), now = t0;
+    int rc;
+    do {
+        for (int i = 0; i < 8; i++) kc_chan_relax();
+        if ((rc = probe(ch, arg)) != 0) break;
+        now = kc_now_ns();
+    } while (now - t0 < budget);
+    if (rc < 0) return 0;
+    long next, floor = cap / 16 ? cap / 16 : 1;
+    if (rc > 0) {
+        long target = 4 * (now - t0);
+        if (target > cap) target = cap;
+        next = budget + (target - budget) / 4;
+        __atomic_fetch_add(&ch->spin_wins, 1, __ATOMIC_RELAXED);
+    } else {
+        next = budget - budget / 8;
+        __atomic_fetch_add(&ch->spin_parks, 1, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&ch->spin_ns, next < floor ? floor : next, __ATOMIC_RELAXED);
+    return rc > 0;
+}
+
+/* Mutex kinds: wait for the state that lets the op through; it re-checks
+ * under ch->mu. */
+static int kc_chan_spin_probe_recv(struct kc_chan *ch, void *arg)
+{
+    (void)arg;
+    if (__atomic_load_n(&ch->closed, __ATOMIC_RELAXED)) return -1;
+    return __atomic_load_n(&ch->count, __ATOMIC_RELAXED) != 0;
+}
+
+static int kc_chan_spin_probe_send(struct kc_chan *ch, void *arg)
+{
+    (void)arg;
+    if (__atomic_load_n(&ch->closed, __ATOMIC_RELAXED)) return -1;
+    return __atomic_load_n(&ch->count, __ATOMIC_RELAXED) < __atomic_load_n(&ch->capacity, __ATOMIC_RELAXED);
+}
+
+/* Rings: the probe is the op itself. */
+static int kc_chan_spin_probe_push(struct kc_chan *ch, void *msg)
+{
+    if (atomic_load_explicit(&ch->ring->closed, memory_order_relaxed)) return -1;
+    return kc_chan_ring_push(ch, msg);
+}
+
+static int kc_chan_spin_probe_pop(struct kc_chan *ch, void *out)
+{
+    if (atomic_load_explicit(&ch->ring->closed, memory_order_relaxed)) return -1;
+    return kc_chan_ring_pop(ch, out);
+}
+
+/* Ring send: lock-free while there is room; ch->mu only to park.
+ * Unlike the mutex kinds, untimed waits park too (no yield polling): the
+ * waiter hints guarantee a pusher/popper sees every announced waiter. */
+static int kc_chan_ring_send(struct kc_chan *ch, const void *msg, long timeout_ms, long *wait_t0)
+{
+    struct kc_mpmc_ring *r = ch->ring;
+    long deadline_ns = timeout_ms > 0 ? kc_now_ns() + timeout_ms * 1000000L : 0;
+    int spun = 0;
+    for (;;) {
+        if (atomic_load_explicit(&r->closed, memory_order_acquire)) {
+            KC_MUTEX_LOCK(&ch->mu); ch->send_epipe++; KC_MUTEX_UNLOCK(&ch->mu);
+            return KC_EPIPE;
+        }
+        if (kc_chan_ring_push(ch, msg)) {
+            kc_chan_ring_wake_peer(ch, KC_SELECT_CLAUSE_RECV);
+            return 0;
+        }
+        if (timeout_ms == 0) {
+            atomic_fetch_add_explicit(&r->send_eagain, 1, memory_order_relaxed);
+            return KC_EAGAIN;
+        }
+        if (!spun++ && kc_chan_spin(ch, kc_chan_spin_probe_push, (void*)msg)) {
+            kc_chan_ring_wake_peer(ch, KC_SELECT_CLAUSE_RECV);
+            return 0;
+        }
+        KC_MUTEX_LOCK(&ch->mu);
+        if (ch->closed) { ch->send_epipe++; KC_MUTEX_UNLOCK(&ch->mu); return KC_EPIPE; }
+        kc_chan_ring_announce_locked(ch, KC_SELECT_CLAUSE_SEND);
+        if (kc_chan_ring_push(ch, msg)) {
+            struct kc_wake wake = kc_chan_wake_recv_locked(ch);
+            kc_chan_ring_sync_locked(ch);
             KC_MUTEX_UNLOCK(&ch->mu);
-            kcoro_yield();
-            goto again_send;
+            kc_chan_schedule_wake(wake);
+            return 0;
         }
-        memcpy(ch->slot, msg, ch->elem_sz);
-        ch->has_value = 1;
-        kc_chan_update_send_stats_locked(ch);
-        KC_COND_SIGNAL(&ch->cv_recv);
-        wake_recv = kc_chan_wake_recv_locked(ch);
-        KC_MUTEX_UNLOCK(&ch->mu);
-        kc_chan_schedule_wake(wake_recv);
-        return 0;
+        if (timeout_ms > 0 && kc_now_ns() >= deadline_ns) {
+            ch->send_etime++;
+            kc_chan_ring_sync_locked(ch);
+            KC_MUTEX_UNLOCK(&ch->mu);
+            return KC_ETIME;
+        }
+        if (kc_chan_park_until_locked(ch, KC_SELECT_CLAUSE_SEND, deadline_ns, (struct kc_wake){0}, wait_t0)) return KC_ECANCELED;
     }
+}
 
-    /* buffered/unlimited */
-    int rc = 0;
-    if (timeout_ms == 0) {
-        if (ch->count == ch->capacity) {
-            if (ch->kind == KC_UNLIMITED) {
-                size_t newcap = ch->capacity ? ch->capacity * 2 : KCORO_UNLIMITED_INIT_CAP;
-                unsigned char *nbuf = malloc(newcap * ch->elem_sz);
-                if (!nbuf) { KC_MUTEX_UNLOCK(&ch->mu); kc_dbg("chan%p grow ENOMEM", (void*)ch); return -ENOMEM; }
-                size_t old_cap = ch->capacity; size_t old_mask = ch->mask;
-                for (size_t i = 0; i < ch->count; ++i) {
-                    size_t idx = old_mask ? ((ch->head + i) & old_mask) : ((ch->head + i) % old_cap);
-                    memcpy(nbuf + (i * ch->elem_sz), ch->buf + (idx * ch->elem_sz), ch->elem_sz);
-                }
-                free(ch->buf); ch->buf = nbuf; ch->capacity = newcap; ch->mask = newcap - 1; ch->head = 0; ch->tail = ch->count;
-            } else { ch->send_eagain++; KC_MUTEX_UNLOCK(&ch->mu); kc_dbg("chan%p send EAGAIN (full)", (void*)ch); return KC_EAGAIN; }
+/* Two-phase ops on a ring: kc_chan_ring_send (take: kc_chan_ring_recv)
+ * with a claim in place of the copy. Claiming wakes nobody; the peer's
+ * wake waits for kc_chan_commit (kc_chan_recv_release). */
+static int kc_chan_ring_claim_wait(struct kc_chan *ch, int take, size_t max, kc_chan_slot_t *slot,
+                                   long timeout_ms, long *wait_t0)
+{
+    struct kc_mpmc_ring *r = ch->ring;
+    int clause = take ? KC_SELECT_CLAUSE_RECV : KC_SELECT_CLAUSE_SEND;
+    long deadline_ns = timeout_ms > 0 ? kc_now_ns() + timeout_ms * 1000000L : 0;
+    for (;;) {
+        if (!take && atomic_load_explicit(&r->closed, memory_order_acquire)) {
+            KC_MUTEX_LOCK(&ch->mu); ch->send_epipe++; KC_MUTEX_UNLOCK(&ch->mu);
+            return KC_EPIPE;
         }
-    } else if (timeout_ms < 0) {
-        if (ch->count == ch->capacity && ch->kind != KC_UNLIMITED) {
-            /* Park cooperatively */
-            struct kc_waiter *w = kc_waiter_new_coro(KC_SELECT_CLAUSE_SEND);
-            if (!w) { KC_MUTEX_UNLOCK(&ch->mu); return -ENOMEM; }
-            kc_waiter_append(&ch->wq_send_head, &ch->wq_send_tail, w);
+        if (kc_chan_ring_claim(ch, take, max, slot)) return 0;
+        if (timeout_ms == 0 && !atomic_load_explicit(&r->closed, memory_order_acquire)) {
+            atomic_fetch_add_explicit(take ? &r->recv_eagain : &r->send_eagain, 1, memory_order_relaxed);
+            return KC_EAGAIN;
+        }
+        KC_MUTEX_LOCK(&ch->mu);
+        if (!take && ch->closed) { ch->send_epipe++; KC_MUTEX_UNLOCK(&ch->mu); return KC_EPIPE; }
+        kc_chan_ring_announce_locked(ch, clause);
+        if (kc_chan_ring_claim(ch, take, max, slot)) {
+            kc_chan_ring_sync_locked(ch);
             KC_MUTEX_UNLOCK(&ch->mu);
-            kcoro_yield();
-            goto again_send;
+            return 0;
         }
-    } else {
-        /* Timed waits: cooperative yield-retry until deadline */
-        if (ch->count == ch->capacity && ch->kind != KC_UNLIMITED) {
+        if (ch->closed) { /* take only: drained */
+            ch->recv_epipe++;
+            kc_chan_ring_sync_locked(ch);
             KC_MUTEX_UNLOCK(&ch->mu);
-            if (kc_now_ns() >= deadline_ns) { ch->send_etime++; return KC_ETIME; }
-            kcoro_yield();
-            goto again_send;
+            return KC_EPIPE;
         }
+        if (timeout_ms > 0 && kc_now_ns() >= deadline_ns) {
+            if (take) ch->recv_etime++; else ch->send_etime++;
+            kc_chan_ring_sync_locked(ch);
+            KC_MUTEX_UNLOCK(&ch->mu);
+            return KC_ETIME;
+        }
+        if (kc_chan_park_until_locked(ch, clause, deadline_ns, (struct kc_wake){0}, wait_t0)) return KC_ECANCELED;
     }
-    if (rc == 0 && !ch->closed) {
-        size_t t = kc_ring_idx(ch, ch->tail);
-        memcpy(ch->buf + (t * ch->elem_sz), msg, ch->elem_sz);
-        size_t next = ch->tail + 1; ch->tail = ch->mask ? (next & ch->mask) : (next % ch->capacity);
-        ch->count++;
-        kc_chan_update_send_stats_locked(ch);
-        KC_COND_SIGNAL(&ch->cv_recv);
-        wake_recv = kc_chan_wake_recv_locked(ch);
-        kc_dbg("chan%p send ok cnt=%zu", (void*)ch, ch->count);
-    }
-    KC_MUTEX_UNLOCK(&ch->mu);
-    kc_chan_schedule_wake(wake_recv);
-    return rc;
 }
 
-int kc_chan_recv(kc_chan_t *c, void *out, long timeout_ms)
+/* Ring recv: lock-free while data is queued; drains before EPIPE. */
+static int kc_chan_ring_recv(struct kc_chan *ch, void *out, long timeout_ms, long *wait_t0)
 {
-    struct kc_chan *ch = (struct kc_chan*)c;
-    if (!ch || !out) return -EINVAL;
-    if (ch->ptr_mode) return -EINVAL; /* pointer descriptor channels use kc_chan_recv_ptr */
-    if (ch->zref_mode) return -EINVAL; /* disallow mixing modes */
-    assert(kcoro_current() != NULL);
-    long deadline_ns = 0; int timed = (timeout_ms > 0);
-    if (timed) deadline_ns = kc_now_ns() + timeout_ms * 1000000L;
-again_recv:
-    KC_MUTEX_LOCK(&ch->mu);
-    kc_dbg("chan%p recv kind=%d tmo=%ld cnt=%zu", (void*)ch, ch->kind, timeout_ms, ch->count);
-    struct kc_wake wake_send = {0};
-    if (ch->kind == KC_CONFLATED) {
-        int rc = 0;
-        if (timeout_ms == 0) {
-            if (!ch->has_value) rc = KC_EAGAIN;
-        } else if (timeout_ms < 0) {
-            if (!ch->has_value && !ch->closed) {
-                struct kc_waiter *w = kc_waiter_new_coro(KC_SELECT_CLAUSE_RECV);
-                if (!w) { KC_MUTEX_UNLOCK(&ch->mu); return -ENOMEM; }
-                kc_waiter_append(&ch->wq_recv_head, &ch->wq_recv_tail, w);
-                KC_MUTEX_UNLOCK(&ch->mu);
-                kcoro_yield();
-                goto again_recv;
-            }
+    struct kc_mpmc_ring *r = ch->ring;
+    long deadline_ns = timeout_ms > 0 ? kc_now_ns() + timeout_ms * 1000000L : 0;
+    int spun = 0;
+    for (;;) {
+        if (kc_chan_ring_pop(ch, out)) {
+            kc_chan_ring_wake_peer(ch, KC_SELECT_CLAUSE_SEND);
+            return 0;
+        }
+        if (timeout_ms == 0 && !atomic_load_explicit(&r->closed, memory_order_acquire)) {
+            atomic_fetch_add_explicit(&r->recv_eagain, 1, memory_order_relaxed);
+            return KC_EAGAIN;
+        }
+        if (timeout_ms != 0 && !__atomic_load_n(&ch->coalesce_max, __ATOMIC_RELAXED) && !spun++ &&
+            kc_chan_spin(ch, kc_chan_spin_probe_pop, out)) {
+            kc_chan_ring_wake_peer(ch, KC_SELECT_CLAUSE_SEND);
+            return 0;
+        }
+        KC_MUTEX_LOCK(&ch->mu);
+        kc_chan_ring_announce_locked(ch, KC_SELECT_CLAUSE_RECV);
+        if (kc_chan_ring_pop(ch, out)) {
+            struct kc_wake wake = kc_chan_wake_send_locked(ch);
+            kc_chan_ring_sync_locked(ch);
+            KC_MUTEX_UNLOCK(&ch->mu);
+            kc_chan_schedule_wake(wake);
+            return 0;
+        }
+        if (ch->closed) {
+            ch->recv_epipe++;
+            kc_chan_ring_sync_locked(ch);
+            KC_MUTEX_UNLOCK(&ch->mu);
+            return KC_EPIPE;
+        }
+        if (timeout_ms > 0 && kc_now_ns() >= deadline_ns) {
+            ch->recv_etime++;
+            kc_chan_ring_sync_locked(ch);
+            KC_MUTEX_UNLOCK(&ch->mu);
+            return KC_ETIME;
+        }
+        if (kc_chan_park_until_locked(ch, KC_SELECT_CLAUSE_RECV, deadline_ns, (struct kc_wake){0}, wait_t0)) return KC_ECANCELED;
+    }
+}
+
+/* Conflated send: lock-free, never waits; ch->mu only to wake a parked
+ * receiver. */
+static int kc_chan_latest_send(struct kc_chan *ch, const void *msg)
+{
+    if (kc_chan_latest_put(ch, msg) != 0) {
+        KC_MUTEX_LOCK(&ch->mu); ch->send_epipe++; KC_MUTEX_UNLOCK(&ch->mu);
+        return KC_EPIPE;
+    }
+    kc_chan_latest_wake_recv(ch);
+    return 0;
+}
+
+/* Conflated recv: lock-free while a value is there, else parks (untimed
+ * waits too, as for the rings). Nobody waits to send, so a take wakes no
+ * one. */
+static int kc_chan_latest_recv(struct kc_chan *ch, void *out, long timeout_ms, long *wait_t0)
+{
+    long deadline_ns = timeout_ms > 0 ? kc_now_ns() + timeout_ms * 1000000L : 0;
+    for (;;) {
+        if (kc_chan_latest_take(ch, out)) return 0;
+        if (timeout_ms == 0 &&
+            !(atomic_load_explicit(&ch->latest->state, memory_order_acquire) & KC_LATEST_CLOSED))
+            return KC_EAGAIN;
+        KC_MUTEX_LOCK(&ch->mu);
+        kc_chan_latest_announce_locked(ch);
+        if (kc_chan_latest_take(ch, out)) {
+            kc_chan_latest_sync_locked(ch);
+            KC_MUTEX_UNLOCK(&ch->mu);
+            return 0;
+        }
+        if (ch->closed) {
+            ch->recv_epipe++;
+            kc_chan_latest_sync_locked(ch);
+            KC_MUTEX_UNLOCK(&ch->mu);
+            return KC_EPIPE;
+        }
+        if (timeout_ms > 0 && kc_now_ns() >= deadline_ns) {
+            ch->recv_etime++;
+            kc_chan_latest_sync_locked(ch);
+            KC_MUTEX_UNLOCK(&ch->mu);
+            return KC_ETIME;
+        }
+        if (kc_chan_park_until_locked(ch, KC_SELECT_CLAUSE_RECV, deadline_ns, (struct kc_wake){0}, wait_t0)) return KC_ECANCELED;
+    }
+}
+
+/* ---- Delayed channels (KC_DELAYED) --------------------------------------
+ * Elements wait in ch->delay ordered by due time; ch->count tracks them.
+ * A receiver that finds nothing due parks. The first one to see a due time
+ * earlier than ch->delay_armed_ns takes it over and parks with that
+ * deadline on the scheduler's timer wheel; the others park on their own
+ * timeout only, so one timer covers the earliest element however many are
+ * pending. A send that moves the earliest due time forward (or finds no
+ * timer armed) wakes one receiver to re-arm, and a receiver that leaves
+ * while elements remain and nobody holds the timer wakes the next one. */
+
+/* Wake the next receiver when someone should hold the timer (or take a due
+ * element) but nobody does. Once closed and drained, each receiver leaving
+ * with KC_EPIPE wakes the next one still parked from before the close. */
+static struct kc_wake kc_chan_delay_pass_locked(struct kc_chan *ch, long now)
+{
+    if (ch->count == 0) return ch->closed ? kc_chan_wake_recv_locked(ch) : (struct kc_wake){0};
+    if (ch->delay_armed_ns && kc_chan_delay_next(ch->delay) > now) return (struct kc_wake){0};
+    return kc_chan_wake_recv_locked(ch);
+}
+
+static int kc_chan_delay_send(struct kc_chan *ch, const void *msg, long due_ns)
+{
+    KC_MUTEX_LOCK(&ch->mu);
+    if (ch->closed) { ch->send_epipe++; KC_MUTEX_UNLOCK(&ch->mu); return KC_EPIPE; }
+    if (kc_chan_delay_push(ch->delay, msg, due_ns) != 0) { KC_MUTEX_UNLOCK(&ch->mu); return -ENOMEM; }
+    ch->count++;
+    kc_chan_update_send_stats_locked(ch);
+    struct kc_wake wake = {0};
+    if (!ch->delay_armed_ns || due_ns < ch->delay_armed_ns) {
+        KC_COND_SIGNAL(&ch->cv_recv);
+        wake = kc_chan_wake_recv_locked(ch);
+    }
+    KC_MUTEX_UNLOCK(&ch->mu);
+    kc_chan_schedule_wake(wake);
+    return 0;
+}
+
+static int kc_chan_delay_recv(struct kc_chan *ch, void *out, long timeout_ms, long *wait_t0)
+{
+    long deadline_ns = timeout_ms > 0 ? kc_now_ns() + timeout_ms * 1000000L : 0;
+    long armed = 0;   /* due time this receiver last parked with a timer for */
+    for (;;) {
+        KC_MUTEX_LOCK(&ch->mu);
+        if (armed && ch->delay_armed_ns == armed) ch->delay_armed_ns = 0;
+        armed = 0;
+        long now = kc_now_ns();
+        int rc;
+        if (kc_chan_delay_pop_due(ch->delay, out, now)) {
+            ch->count--;
+            kc_chan_update_recv_stats_locked(ch);
+            rc = 0;
+        } else if (ch->closed && ch->count == 0) {
+            ch->recv_epipe++;
+            rc = KC_EPIPE;
+        } else if (timeout_ms == 0) {
+            ch->recv_eagain++;
+            rc = KC_EAGAIN;
+        } else if (deadline_ns && now >= deadline_ns) {
+            ch->recv_etime++;
+            rc = KC_ETIME;
         } else {
-            if (!ch->has_value && !ch->closed) {
+            long until = deadline_ns;
+            long due = kc_chan_delay_next(ch->delay);
+            if (due && (!ch->delay_armed_ns || due < ch->delay_armed_ns)) {
+                ch->delay_armed_ns = armed = due;
+                if (!until || due < until) until = due;
+            }
+            if (kc_chan_park_until_locked(ch, KC_SELECT_CLAUSE_RECV, until, (struct kc_wake){0}, wait_t0)) {
+                KC_MUTEX_LOCK(&ch->mu);
+                if (armed && ch->delay_armed_ns == armed) ch->delay_armed_ns = 0;
+                struct kc_wake wake = kc_chan_delay_pass_locked(ch, kc_now_ns());
                 KC_MUTEX_UNLOCK(&ch->mu);
-                if (kc_now_ns() >= deadline_ns) return KC_ETIME;
-                kcoro_yield();
-                goto again_recv;
+                kc_chan_schedule_wake(wake);
+                return KC_ECANCELED;
             }
+            continue;
         }
-        if (rc == 0 && ch->has_value) {
-            memcpy(out, ch->slot, ch->elem_sz);
-            ch->has_value = 0;
+        struct kc_wake wake = kc_chan_delay_pass_locked(ch, now);
+        KC_MUTEX_UNLOCK(&ch->mu);
+        kc_chan_schedule_wake(wake);
+        return rc;
+    }
+}
+
+int kc_chan_send_at(kc_chan_t *c, const void *msg, long deadline_ns)
+{
+    struct kc_chan *ch = (struct kc_chan*)c;
+    if (!ch || !msg || !ch->delay) return -EINVAL;
+    return kc_chan_delay_send(ch, msg, deadline_ns);
+}
+
+/* prio: level for KC_PRIORITY channels (0 elsewhere). */
+static int kc_chan_send_body(kc_chan_t *c, const void *msg, long timeout_ms, long *wait_t0, int prio)
+{
+    struct kc_chan *ch = (struct kc_chan*)c;
+    if (!ch || !msg) return -EINVAL;
+    if (ch->ptr_mode) return -EINVAL; /* pointer descriptor channels use kc_chan_send_ptr */
+    if (ch->zref_mode) return -EINVAL; /* disallow mixing modes */
+    if (ch->delay) return kc_chan_delay_send(ch, msg, kc_now_ns());   /* never waits */
+    /* Waiting needs a coroutine; threads use kc_chan_send_thread. */
+    assert(timeout_ms == 0 || kcoro_current() != NULL);
+    if (ch->ring) return kc_chan_ring_send(ch, msg, timeout_ms, wait_t0);
+    if (ch->latest) return kc_chan_latest_send(ch, msg);
+    long deadline_ns = 0; int timed = (timeout_ms > 0);
+    if (timed) deadline_ns = kc_now_ns() + timeout_ms * 1000000L;
+    int spun = 0;
+again_send:
+    KC_MUTEX_LOCK(&ch->mu);
+    kc_dbg("chan%p send kind=%d tmo=%ld cnt=%zu cap=%zu", (void*)ch, ch->kind,
+           timeout_ms, ch->count, ch->capacity);
+    if (ch->closed) { ch->send_epipe++; KC_MUTEX_UNLOCK(&ch->mu); return KC_EPIPE; }
+
+    struct kc_wake wake_recv = {0};
+
+    if (ch->kind == KC_RENDEZVOUS) {
+        struct kc_waiter *hw = ch->handoff && !ch->has_value ? ch->wq_recv_head : NULL;
+        if (hw && hw->kind == KC_WAITER_CORO && hw->handoff_dst) {
+            /* Handoff: straight into the parked receiver's buffer. */
+            (void)kc_waiter_pop(&ch->wq_recv_head, &ch->wq_recv_tail);
+            kc_chan_elem_copy(hw->handoff_dst, msg, ch->elem_sz);
+            *hw->handoff_done = 1;
+            ch->rv_matches++;
+            kc_chan_update_send_stats_locked(ch);
             kc_chan_update_recv_stats_locked(ch);
-            KC_COND_SIGNAL(&ch->cv_send);
-            wake_send = kc_chan_wake_send_locked(ch);
-            kc_dbg("chan%p recv conflated ok", (void*)ch);
-        } else if (rc == 0 && ch->closed && !ch->has_value) {
-            rc = KC_EPIPE;
+            kcoro_t *co = hw->co;
+            kcoro_retain(co);
+            KC_TRACE(KC_TRACE_CHAN_WAKE, co, (uintptr_t)ch);
+            kc_waiter_dispose(hw);
+            KC_MUTEX_UNLOCK(&ch->mu);
+            kc_chan_handoff_wake(ch, co);
+            return 0;
+        }
+        if (ch->wq_recv_head == NULL || ch->has_value) {
+            if (timeout_ms == 0) { ch->send_eagain++; KC_MUTEX_UNLOCK(&ch->mu); return KC_EAGAIN; }
+            if (timed) {
+                if (kc_now_ns() >= deadline_ns) { ch->send_etime++; KC_MUTEX_UNLOCK(&ch->mu); return KC_ETIME; }
+                if (kc_chan_park_until_locked(ch, KC_SELECT_CLAUSE_SEND, deadline_ns, (struct kc_wake){0}, wait_t0)) return KC_ECANCELED;
+                goto again_send;
+            }
+            if (kc_chan_yield_waiting_locked(ch, KC_SELECT_CLAUSE_SEND, 0, wait_t0)) return -ENOMEM;
+            goto again_send;
         }
+        kc_chan_elem_copy(ch->slot, msg, ch->elem_sz);
+        ch->has_value = 1;
+        kc_chan_update_send_stats_locked(ch);
+        KC_COND_SIGNAL(&ch->cv_recv);
+        wake_recv = kc_chan_wake_recv_locked(ch);
         KC_MUTEX_UNLOCK(&ch->mu);
-        kc_chan_schedule_wake(wake_send);
-        return rc;
+        kc_chan_schedule_wake(wake_recv);
+        return 0;
+    }
+
+    /* buffered/unlimited */
+    int rc = 0;
+    if (timeout_ms != 0 && ch->count == ch->capacity && ch->kind != KC_UNLIMITED && !spun++) {
+        KC_MUTEX_UNLOCK(&ch->mu);
+        (void)kc_chan_spin(ch, kc_chan_spin_probe_send, NULL);
+        goto again_send;
+    }
+    if (timeout_ms == 0) {
+        if (ch->count == ch->capacity && ch->kind != KC_UNLIMITED) {
+            ch->send_eagain++; KC_MUTEX_UNLOCK(&ch->mu); kc_dbg("chan%p send EAGAIN (full)", (void*)ch); return KC_EAGAIN;
+        }
+    } else if (timeout_ms < 0) {
+        if (ch->count == ch->capacity && ch->kind != KC_UNLIMITED) {
+            /* Park cooperatively */
+            if (kc_chan_yield_waiting_locked(ch, KC_SELECT_CLAUSE_SEND, 0, wait_t0)) return -ENOMEM;
+            goto again_send;
+        }
+    } else {
+        /* Timed waits: park with a deadline timer */
+        if (ch->count == ch->capacity && ch->kind != KC_UNLIMITED) {
+            if (kc_now_ns() >= deadline_ns) { ch->send_etime++; KC_MUTEX_UNLOCK(&ch->mu); return KC_ETIME; }
+            if (kc_chan_park_until_locked(ch, KC_SELECT_CLAUSE_SEND, deadline_ns, (struct kc_wake){0}, wait_t0)) return KC_ECANCELED;
+            goto again_send;
+        }
+    }
+    if (rc == 0 && !ch->closed) {
+        if ((rc = kc_chan_buf_put_prio_locked(ch, msg, prio)) == KC_EAGAIN) {
+            /* KC_MEM_CHAN refused a segment: backpressure until receives
+             * retire one or the deadline passes. */
+            if (timeout_ms == 0) { ch->send_eagain++; KC_MUTEX_UNLOCK(&ch->mu); return KC_EAGAIN; }
+            if (timed && kc_now_ns() >= deadline_ns) { ch->send_etime++; KC_MUTEX_UNLOCK(&ch->mu); return KC_ETIME; }
+            KC_MUTEX_UNLOCK(&ch->mu);
+            kc_sleep_ms(1);
+            goto again_send;
+        }
+        if (rc != 0) { KC_MUTEX_UNLOCK(&ch->mu); return rc; }
+        kc_chan_update_send_stats_locked(ch);
+        KC_COND_SIGNAL(&ch->cv_recv);
+        if (!kc_chan_coalesce_hold_locked(ch, 1)) wake_recv = kc_chan_wake_recv_locked(ch);
+        kc_dbg("chan%p send ok cnt=%zu", (void*)ch, ch->count);
     }
+    KC_MUTEX_UNLOCK(&ch->mu);
+    kc_chan_schedule_wake(wake_recv);
+    return rc;
+}
+
+/* One recorded single-element op: a try when it could not wait. */
+static void kc_chan_rec_one(struct kc_chan *ch, int is_send, long timeout_ms, long rec_t0, int rc)
+{
+    enum kc_chan_rec_op op = is_send ? (timeout_ms ? KC_CHAN_REC_SEND : KC_CHAN_REC_TRY_SEND)
+                                     : (timeout_ms ? KC_CHAN_REC_RECV : KC_CHAN_REC_TRY_RECV);
+    KC_CHAN_REC(ch, op, rec_t0, rc == 0, rc == 0 ? ch->elem_sz : 0, rc);
+}
+
+int kc_chan_send(kc_chan_t *c, const void *msg, long timeout_ms)
+{
+    (void)kc_yield_if_needed();   /* slice safepoint */
+    long rec_t0 = KC_CHAN_REC_T0();
+    long wait_t0 = 0;
+    int rc = kc_chan_send_body(c, msg, timeout_ms, &wait_t0, 0);
+    kc_chan_lat_wait_end((struct kc_chan*)c, KC_SELECT_CLAUSE_SEND, wait_t0);
+    kc_chan_rec_one((struct kc_chan*)c, 1, timeout_ms, rec_t0, rc);
+    return rc;
+}
 
+int kc_chan_send_prio(kc_chan_t *c, const void *msg, int prio, long timeout_ms)
+{
+    struct kc_chan *ch = (struct kc_chan*)c;
+    if (!ch || !ch->prio || prio < 0 || prio >= KC_CHAN_PRIO_LEVELS) return -EINVAL;
+    (void)kc_yield_if_needed();   /* slice safepoint */
+    long rec_t0 = KC_CHAN_REC_T0();
+    long wait_t0 = 0;
+    int rc = kc_chan_send_body(c, msg, timeout_ms, &wait_t0, prio);
+    kc_chan_lat_wait_end(ch, KC_SELECT_CLAUSE_SEND, wait_t0);
+    kc_chan_rec_one(ch, 1, timeout_ms, rec_t0, rc);
+    return rc;
+}
+
+static int kc_chan_recv_body(kc_chan_t *c, void *out, long timeout_ms, long *wait_t0)
+{
+    struct kc_chan *ch = (struct kc_chan*)c;
+    if (!ch || !out) return -EINVAL;
+    if (ch->ptr_mode) return -EINVAL; /* pointer descriptor channels use kc_chan_recv_ptr */
+    if (ch->zref_mode) return -EINVAL; /* disallow mixing modes */
+    assert(timeout_ms == 0 || kcoro_current() != NULL);
+    if (ch->ring) return kc_chan_ring_recv(ch, out, timeout_ms, wait_t0);
+    if (ch->latest) return kc_chan_latest_recv(ch, out, timeout_ms, wait_t0);
+    if (ch->delay) return kc_chan_delay_recv(ch, out, timeout_ms, wait_t0);
+    long deadline_ns = 0; int timed = (timeout_ms > 0);
+    if (timed) deadline_ns = kc_now_ns() + timeout_ms * 1000000L;
+    int spun = 0;
+again_recv:
+    KC_MUTEX_LOCK(&ch->mu);
+    kc_dbg("chan%p recv kind=%d tmo=%ld cnt=%zu", (void*)ch, ch->kind, timeout_ms, ch->count);
+    struct kc_wake wake_send = {0};
     if (ch->kind == KC_RENDEZVOUS) {
         int rc = 0;
         if (timeout_ms == 0) {
             if (!ch->has_value) rc = KC_EAGAIN;
         } else if (timeout_ms < 0) {
+            if (!ch->has_value && !ch->closed && kc_chan_handoff_recv_ok(ch)) {
+                /* Park for real with our buffer; a sender may fill it. */
+                struct kc_wake wake_sender = kc_chan_wake_send_locked(ch);
+                int done = 0;
+                int cancelled = kc_chan_park_handoff_locked(ch, KC_SELECT_CLAUSE_RECV, 0, wake_sender,
+                                                            wait_t0, out, &done);
+                if (done) return 0;
+                if (cancelled) return KC_ECANCELED;
+                goto again_recv;
+            }
             if (!ch->has_value && !ch->closed) {
-                struct kc_waiter *w = kc_waiter_new_coro(KC_SELECT_CLAUSE_RECV);
-                if (!w) { KC_MUTEX_UNLOCK(&ch->mu); return -ENOMEM; }
-                kc_waiter_append(&ch->wq_recv_head, &ch->wq_recv_tail, w);
-                KC_MUTEX_UNLOCK(&ch->mu);
-                kcoro_yield();
+                /* A sender may be parked waiting for a receiver to show up. */
+                if (kc_chan_yield_waiting_locked(ch, KC_SELECT_CLAUSE_RECV, 1, wait_t0)) return -ENOMEM;
                 goto again_recv;
             }
         } else {
             if (!ch->has_value && !ch->closed) {
-                KC_MUTEX_UNLOCK(&ch->mu);
-                if (kc_now_ns() >= deadline_ns) return KC_ETIME;
-                kcoro_yield();
+                if (kc_now_ns() >= deadline_ns) { ch->recv_etime++; KC_MUTEX_UNLOCK(&ch->mu); return KC_ETIME; }
+                /* Wake a parked sender first; a select sender may deliver right here. */
+                struct kc_wake wake_sender = kc_chan_wake_send_locked(ch);
+                if (ch->has_value) {
+                    KC_MUTEX_UNLOCK(&ch->mu);
+                    kc_chan_schedule_wake(wake_sender);
+                    goto again_recv;
+                }
+                int done = 0;
+                int cancelled = kc_chan_park_handoff_locked(ch, KC_SELECT_CLAUSE_RECV, deadline_ns, wake_sender,
+                                                            wait_t0, kc_chan_handoff_recv_ok(ch) ? out : NULL, &done);
+                if (done) return 0;
+                if (cancelled) return KC_ECANCELED;
                 goto again_recv;
             }
         }
         if (rc == 0 && ch->has_value) {
-            memcpy(out, ch->slot, ch->elem_sz);
+            kc_chan_elem_copy(out, ch->slot, ch->elem_sz);
             ch->has_value = 0;
             ch->rv_matches++;
             kc_chan_update_recv_stats_locked(ch);
@@ -1048,6 +2895,12 @@ again_recv:
 
     /* buffered/unlimited */
     int rc = 0;
+    /* Coalescing receivers wait for the window, not the first put. */
+    if (timeout_ms != 0 && ch->count == 0 && !ch->closed && !ch->coalesce_max && !spun++) {
+        KC_MUTEX_UNLOCK(&ch->mu);
+        (void)kc_chan_spin(ch, kc_chan_spin_probe_recv, NULL);
+        goto again_recv;
+    }
     if (timeout_ms == 0) {
         if (ch->count == 0) {
             int rc_local = ch->closed ? KC_EPIPE : KC_EAGAIN;
@@ -1057,27 +2910,25 @@ again_recv:
             return rc_local;
         }
     } else if (timeout_ms < 0) {
+        if (ch->count == 0 && !ch->closed && ch->coalesce_max) {
+            /* Coalescing holds wakes: park for real so the window's timer
+             * is what resumes us. */
+            if (kc_chan_park_until_locked(ch, KC_SELECT_CLAUSE_RECV, 0, (struct kc_wake){0}, wait_t0)) return KC_ECANCELED;
+            goto again_recv;
+        }
         if (ch->count == 0 && !ch->closed) {
-            struct kc_waiter *w = kc_waiter_new_coro(KC_SELECT_CLAUSE_RECV);
-            if (!w) { KC_MUTEX_UNLOCK(&ch->mu); return -ENOMEM; }
-            kc_waiter_append(&ch->wq_recv_head, &ch->wq_recv_tail, w);
-            KC_MUTEX_UNLOCK(&ch->mu);
-            kcoro_yield();
+            if (kc_chan_yield_waiting_locked(ch, KC_SELECT_CLAUSE_RECV, 0, wait_t0)) return -ENOMEM;
             goto again_recv;
         }
     } else {
         if (ch->count == 0 && !ch->closed) {
-            KC_MUTEX_UNLOCK(&ch->mu);
-            if (kc_now_ns() >= deadline_ns) { ch->recv_etime++; return KC_ETIME; }
-            kcoro_yield();
+            if (kc_now_ns() >= deadline_ns) { ch->recv_etime++; KC_MUTEX_UNLOCK(&ch->mu); return KC_ETIME; }
+            if (kc_chan_park_until_locked(ch, KC_SELECT_CLAUSE_RECV, deadline_ns, (struct kc_wake){0}, wait_t0)) return KC_ECANCELED;
             goto again_recv;
         }
     }
     if (rc == 0 && ch->count > 0) {
-        size_t h = kc_ring_idx(ch, ch->head);
-        memcpy(out, ch->buf + (h * ch->elem_sz), ch->elem_sz);
-        size_t n2 = ch->head + 1; ch->head = ch->mask ? (n2 & ch->mask) : (n2 % ch->capacity);
-        ch->count--;
+        kc_chan_buf_take_locked(ch, out);
         kc_chan_update_recv_stats_locked(ch);
         KC_COND_SIGNAL(&ch->cv_send);
         wake_send = kc_chan_wake_send_locked(ch);
@@ -1091,81 +2942,359 @@ again_recv:
     return rc;
 }
 
-/* Cancellable wrappers: slice blocking waits to check cancel token periodically */
-static long kc_min_long(long a, long b) { return a < b ? a : b; }
-
-int kc_chan_send_c(kc_chan_t* ch, const void* msg, long timeout_ms, const kc_cancel_t* cancel)
+int kc_chan_recv(kc_chan_t *c, void *out, long timeout_ms)
 {
-    if (!cancel) return kc_chan_send(ch, msg, timeout_ms);
-    if (kc_cancel_is_set(cancel)) return KC_ECANCELED;
-    if (timeout_ms == 0) return kc_chan_send(ch, msg, 0);
-    const long SLICE_MS = KCORO_CANCEL_SLICE_MS; /* coarse */
-    if (timeout_ms < 0) {
-        for (;;) {
-            if (kc_cancel_is_set(cancel)) return KC_ECANCELED;
-            int rc = kc_chan_send(ch, msg, SLICE_MS);
-            if (rc == 0) return 0;
-            if (rc != KC_ETIME && rc != KC_EAGAIN) return rc;
-        }
-    } else {
-        long remain = timeout_ms;
-        while (remain >= 0) {
-            if (kc_cancel_is_set(cancel)) return KC_ECANCELED;
-            long slice = kc_min_long(SLICE_MS, remain);
-            int rc = kc_chan_send(ch, msg, slice);
-            if (rc == 0) return 0;
-            if (rc != KC_ETIME && rc != KC_EAGAIN) return rc;
-            remain -= slice;
-            if (remain <= 0) return KC_ETIME;
-        }
-        return KC_ETIME;
-    }
+    (void)kc_yield_if_needed();   /* slice safepoint */
+    long rec_t0 = KC_CHAN_REC_T0();
+    long wait_t0 = 0;
+    int rc = kc_chan_recv_body(c, out, timeout_ms, &wait_t0);
+    kc_chan_lat_wait_end((struct kc_chan*)c, KC_SELECT_CLAUSE_RECV, wait_t0);
+    kc_chan_rec_one((struct kc_chan*)c, 0, timeout_ms, rec_t0, rc);
+    return rc;
 }
 
-int kc_chan_recv_c(kc_chan_t* ch, void* out, long timeout_ms, const kc_cancel_t* cancel)
+/* Rings are never pointer or zero-copy channels and a timeout of 0 never
+ * parks, so the try ops skip the mode checks and wait bookkeeping. */
+int kc_chan_try_send(kc_chan_t *c, const void *msg)
 {
-    if (!cancel) return kc_chan_recv(ch, out, timeout_ms);
-    if (kc_cancel_is_set(cancel)) return KC_ECANCELED;
-    if (timeout_ms == 0) return kc_chan_recv(ch, out, 0);
-    const long SLICE_MS = KCORO_CANCEL_SLICE_MS;
-    if (timeout_ms < 0) {
-        for (;;) {
-            if (kc_cancel_is_set(cancel)) return KC_ECANCELED;
-            int rc = kc_chan_recv(ch, out, SLICE_MS);
-            if (rc == 0) return 0;
-            if (rc == KC_EPIPE) return KC_EPIPE;
-            if (rc != KC_ETIME && rc != KC_EAGAIN) return rc;
-        }
-    } else {
-        long remain = timeout_ms;
-        while (remain >= 0) {
-            if (kc_cancel_is_set(cancel)) return KC_ECANCELED;
-            long slice = kc_min_long(SLICE_MS, remain);
-            int rc = kc_chan_recv(ch, out, slice);
-            if (rc == 0) return 0;
-            if (rc == KC_EPIPE) return KC_EPIPE;
-            if (rc != KC_ETIME && rc != KC_EAGAIN) return rc;
-            remain -= slice;
-            if (remain <= 0) return KC_ETIME;
-        }
-        return KC_ETIME;
-    }
+    struct kc_chan *ch = (struct kc_chan*)c;
+    if (!ch || !msg || !ch->ring) return kc_chan_send(c, msg, 0);
+    (void)kc_yield_if_needed();   /* slice safepoint */
+    long rec_t0 = KC_CHAN_REC_T0();
+    long wait_t0 = 0;
+    int rc = kc_chan_ring_send(ch, msg, 0, &wait_t0);
+    kc_chan_rec_one(ch, 1, 0, rec_t0, rc);
+    return rc;
 }
 
-/* ===================== Zero-Copy (zref) Implementation ===================== */
-
-unsigned kc_chan_capabilities(kc_chan_t *c) {
+int kc_chan_try_recv(kc_chan_t *c, void *out)
+{
     struct kc_chan *ch = (struct kc_chan*)c;
-    if (!ch) return 0;
-    KC_MUTEX_LOCK(&ch->mu);
-    unsigned caps = ch->capabilities;
-    KC_MUTEX_UNLOCK(&ch->mu);
-    return caps;
+    if (!ch || !out || !ch->ring) return kc_chan_recv(c, out, 0);
+    (void)kc_yield_if_needed();   /* slice safepoint */
+    long rec_t0 = KC_CHAN_REC_T0();
+    long wait_t0 = 0;
+    int rc = kc_chan_ring_recv(ch, out, 0, &wait_t0);
+    kc_chan_rec_one(ch, 0, 0, rec_t0, rc);
+    return rc;
 }
 
-int kc_chan_enable_zero_copy(kc_chan_t *c) {
+static int kc_chan_claim(kc_chan_t *c, int take, kc_chan_slot_t *slot, size_t max, long timeout_ms)
+{
+    struct kc_chan *ch = (struct kc_chan*)c;
+    if (!ch || !slot || max == 0) return -EINVAL;
+    if (!ch->ring) return -ENOTSUP;
+    /* Waiting needs a coroutine, as in kc_chan_send / kc_chan_recv. */
+    assert(timeout_ms == 0 || kcoro_current() != NULL);
+    (void)kc_yield_if_needed();   /* slice safepoint */
+    long wait_t0 = 0;
+    int rc = kc_chan_ring_claim_wait(ch, take, max, slot, timeout_ms, &wait_t0);
+    kc_chan_lat_wait_end(ch, take ? KC_SELECT_CLAUSE_RECV : KC_SELECT_CLAUSE_SEND, wait_t0);
+    return rc;
+}
+
+static int kc_chan_slot_ok(struct kc_chan *ch, const kc_chan_slot_t *slot)
+{
+    return ch && slot && ch->ring && slot->n > 0 && slot->n <= ch->ring->mask + 1 &&
+           slot->stripe < (ch->ring_stripes ? ch->ring_stripes : 1u);
+}
+
+int kc_chan_reserve(kc_chan_t *c, kc_chan_slot_t *slot, long timeout_ms)
+{
+    return kc_chan_claim(c, 0, slot, 1, timeout_ms);
+}
+
+int kc_chan_reserve_many(kc_chan_t *c, kc_chan_slot_t *slot, size_t max, long timeout_ms)
+{
+    return kc_chan_claim(c, 0, slot, max, timeout_ms);
+}
+
+int kc_chan_commit(kc_chan_t *c, const kc_chan_slot_t *slot)
+{
+    struct kc_chan *ch = (struct kc_chan*)c;
+    if (!kc_chan_slot_ok(ch, slot)) return -EINVAL;
+    kc_ring_publish(&ch->ring[slot->stripe], slot->pos, slot->n);
+    kc_chan_ring_wake_peer(ch, KC_SELECT_CLAUSE_RECV);
+    return 0;
+}
+
+int kc_chan_recv_peek(kc_chan_t *c, kc_chan_slot_t *slot, long timeout_ms)
+{
+    return kc_chan_claim(c, 1, slot, 1, timeout_ms);
+}
+
+int kc_chan_recv_peek_many(kc_chan_t *c, kc_chan_slot_t *slot, size_t max, long timeout_ms)
+{
+    return kc_chan_claim(c, 1, slot, max, timeout_ms);
+}
+
+int kc_chan_recv_release(kc_chan_t *c, const kc_chan_slot_t *slot)
+{
+    struct kc_chan *ch = (struct kc_chan*)c;
+    if (!kc_chan_slot_ok(ch, slot)) return -EINVAL;
+    kc_ring_release(&ch->ring[slot->stripe], slot->pos, slot->n);
+    kc_chan_ring_wake_peer(ch, KC_SELECT_CLAUSE_SEND);
+    return 0;
+}
+
+void *kc_chan_slot_elem(kc_chan_t *c, const kc_chan_slot_t *slot, size_t i)
+{
+    struct kc_chan *ch = (struct kc_chan*)c;
+    if (!kc_chan_slot_ok(ch, slot) || i >= slot->n) return NULL;
+    return kc_ring_cell_data(&ch->ring[slot->stripe], slot->pos + i);
+}
+
+/* ---- Threads outside the scheduler ------------------------------------
+ * kc_chan_send_thread / kc_chan_recv_thread retry the op with timeout 0 and,
+ * while it would block, queue a KC_WAITER_THREAD on the channel's waiter
+ * list and sleep on a condvar of their own (waited with ch->mu). Peers pop
+ * it like any waiter; disposing it signals the thread, which retries. */
+
+/* 1 while the op of this side cannot complete (ch->mu held). */
+static int kc_chan_thread_blocked_locked(struct kc_chan *ch, int is_send)
+{
+    if (ch->closed) return 0;
+    if (ch->kind == KC_RENDEZVOUS && !ch->ring)
+        return is_send ? (ch->wq_recv_head == NULL || ch->has_value) : !ch->has_value;
+    return !(kc_chan_ready_events_locked(ch) & (is_send ? KC_CHAN_SET_SEND : KC_CHAN_SET_RECV));
+}
+
+static int kc_chan_thread_op(struct kc_chan *ch, void *buf, long timeout_ms, int is_send)
+{
+    const enum kc_select_clause_kind clause = is_send ? KC_SELECT_CLAUSE_SEND : KC_SELECT_CLAUSE_RECV;
+    long rec_t0 = KC_CHAN_REC_T0();
+    long deadline_ns = timeout_ms > 0 ? kc_now_ns() + timeout_ms * 1000000L : 0;
+    long wait_t0 = 0;
+    KC_COND_T cv;
+    KC_COND_INIT(&cv);
+    int rc;
+    for (;;) {
+        rc = is_send ? kc_chan_send_body((kc_chan_t*)ch, buf, 0, &wait_t0, 0)
+                     : kc_chan_recv_body((kc_chan_t*)ch, buf, 0, &wait_t0);
+        if (rc != KC_EAGAIN || timeout_ms == 0) break;
+        KC_MUTEX_LOCK(&ch->mu);
+        /* Lock-free kinds: advertise first so a peer takes ch->mu to wake us. */
+        if (ch->ring) kc_chan_ring_announce_locked(ch, clause);
+        else if (ch->latest && !is_send) kc_chan_latest_announce_locked(ch);
+        if (!kc_chan_thread_blocked_locked(ch, is_send)) {
+            kc_chan_hints_sync_locked(ch);
+            KC_MUTEX_UNLOCK(&ch->mu);
+            continue;
+        }
+        if (timeout_ms > 0 && kc_now_ns() >= deadline_ns) {
+            if (is_send) ch->send_etime++; else ch->recv_etime++;
+            kc_chan_hints_sync_locked(ch);
+            KC_MUTEX_UNLOCK(&ch->mu);
+            rc = KC_ETIME;
+            break;
+        }
+        int taken = 0;
+        struct kc_waiter w = { .kind = KC_WAITER_THREAD, .clause_index = -1, .clause_kind = clause,
+                               .handoff_done = &taken, .thread_cv = &cv };
+        struct kc_waiter **head = is_send ? &ch->wq_send_head : &ch->wq_recv_head;
+        struct kc_waiter **tail = is_send ? &ch->wq_send_tail : &ch->wq_recv_tail;
+        kc_waiter_append(head, tail, &w);
+        kc_chan_hints_sync_locked(ch);
+        kc_chan_lat_wait_begin(ch, clause, &wait_t0);
+        /* A rendezvous sender may be parked waiting for a receiver to show up. */
+        if (!is_send && ch->kind == KC_RENDEZVOUS) kc_chan_schedule_wake(kc_chan_wake_send_locked(ch));
+        /* A delayed receiver also wakes when the earliest element comes due. */
+        long until = deadline_ns;
+        if (!is_send && ch->delay && ch->count > 0) {
+            long due = kc_chan_delay_next(ch->delay);
+            if (!until || due < until) until = due;
+        }
+        while (!taken) {
+            if (!until) { KC_COND_WAIT(&cv, &ch->mu); continue; }
+            long now = kc_now_ns();
+            if (now >= until) break;
+            struct timespec ts;
+            kc_clock_abstime(&ts, KC_COND_CLOCK, (uint64_t)until);
+            (void)KC_COND_TIMEDWAIT_ABS(&cv, &ch->mu, &ts);
+        }
+        if (!taken) {
+            kc_waiter_unlink(&w);
+            kc_chan_hints_sync_locked(ch);
+        }
+        KC_MUTEX_UNLOCK(&ch->mu);
+    }
+    kc_chan_lat_wait_end(ch, clause, wait_t0);
+    KC_COND_DESTROY(&cv);
+    kc_chan_rec_one(ch, is_send, timeout_ms, rec_t0, rc);
+    return rc;
+}
+
+int kc_chan_send_thread(kc_chan_t *c, const void *msg, long timeout_ms)
+{
+    struct kc_chan *ch = (struct kc_chan*)c;
+    if (!ch || !msg || ch->ptr_mode || ch->zref_mode) return -EINVAL;
+    if (kcoro_current()) return kc_chan_send(c, msg, timeout_ms);
+    return kc_chan_thread_op(ch, (void*)msg, timeout_ms, 1);
+}
+
+int kc_chan_recv_thread(kc_chan_t *c, void *out, long timeout_ms)
+{
+    struct kc_chan *ch = (struct kc_chan*)c;
+    if (!ch || !out || ch->ptr_mode || ch->zref_mode) return -EINVAL;
+    if (kcoro_current()) return kc_chan_recv(c, out, timeout_ms);
+    return kc_chan_thread_op(ch, out, timeout_ms, 0);
+}
+
+/* Cancellable wrappers. The op registers on the token (kc_cancel_internal.h)
+ * so a trigger wakes it out of its park, and then only needs long slices
+ * (every timed park goes through kc_chan_park_until_locked). Without a
+ * registration (OOM, zref routing) it checks the token every
+ * KCORO_CANCEL_SLICE_MS. */
+#define KC_CHAN_CANCEL_WOKEN_SLICE_MS (60L * 1000L)
+static long kc_min_long(long a, long b) { return a < b ? a : b; }
+
+static int kc_chan_send_c_sliced(kc_chan_t* ch, const void* msg, long timeout_ms, const kc_cancel_t* cancel, long slice_ms)
+{
+    if (!cancel) return kc_chan_send(ch, msg, timeout_ms);
+    if (kc_cancel_is_set(cancel)) return KC_ECANCELED;
+    if (timeout_ms == 0) return kc_chan_send(ch, msg, 0);
+    const long SLICE_MS = slice_ms;
+    if (timeout_ms < 0) {
+        for (;;) {
+            if (kc_cancel_is_set(cancel)) return KC_ECANCELED;
+            int rc = kc_chan_send(ch, msg, SLICE_MS);
+            if (rc == 0) return 0;
+            if (rc != KC_ETIME && rc != KC_EAGAIN) return rc;
+        }
+    } else {
+        long remain = timeout_ms;
+        while (remain >= 0) {
+            if (kc_cancel_is_set(cancel)) return KC_ECANCELED;
+            long slice = kc_min_long(SLICE_MS, remain);
+            int rc = kc_chan_send(ch, msg, slice);
+            if (rc == 0) return 0;
+            if (rc != KC_ETIME && rc != KC_EAGAIN) return rc;
+            remain -= slice;
+            if (remain <= 0) return KC_ETIME;
+        }
+        return KC_ETIME;
+    }
+}
+
+int kc_chan_send_c(kc_chan_t* ch, const void* msg, long timeout_ms, const kc_cancel_t* cancel)
+{
+    if (!cancel || timeout_ms == 0) return kc_chan_send_c_sliced(ch, msg, timeout_ms, cancel, KCORO_CANCEL_SLICE_MS);
+    struct kc_cancel_wait local;
+    int cancelled;
+    struct kc_cancel_wait *cw = kc_cancel_wait_begin(&local, cancel, &cancelled);
+    if (cancelled) return KC_ECANCELED;
+    long slice_ms = cw ? KC_CHAN_CANCEL_WOKEN_SLICE_MS : KCORO_CANCEL_SLICE_MS;
+    int rc = kc_chan_send_c_sliced(ch, msg, timeout_ms, cancel, slice_ms);
+    kc_cancel_wait_end(cw);
+    return rc;
+}
+
+static int kc_chan_recv_c_sliced(kc_chan_t* ch, void* out, long timeout_ms, const kc_cancel_t* cancel, long slice_ms)
+{
+    if (!cancel) return kc_chan_recv(ch, out, timeout_ms);
+    if (kc_cancel_is_set(cancel)) return KC_ECANCELED;
+    if (timeout_ms == 0) return kc_chan_recv(ch, out, 0);
+    const long SLICE_MS = slice_ms;
+    if (timeout_ms < 0) {
+        for (;;) {
+            if (kc_cancel_is_set(cancel)) return KC_ECANCELED;
+            int rc = kc_chan_recv(ch, out, SLICE_MS);
+            if (rc == 0) return 0;
+            if (rc == KC_EPIPE) return KC_EPIPE;
+            if (rc != KC_ETIME && rc != KC_EAGAIN) return rc;
+        }
+    } else {
+        long remain = timeout_ms;
+        while (remain >= 0) {
+            if (kc_cancel_is_set(cancel)) return KC_ECANCELED;
+            long slice = kc_min_long(SLICE_MS, remain);
+            int rc = kc_chan_recv(ch, out, slice);
+            if (rc == 0) return 0;
+            if (rc == KC_EPIPE) return KC_EPIPE;
+            if (rc != KC_ETIME && rc != KC_EAGAIN) return rc;
+            remain -= slice;
+            if (remain <= 0) return KC_ETIME;
+        }
+        return KC_ETIME;
+    }
+}
+
+int kc_chan_recv_c(kc_chan_t* ch, void* out, long timeout_ms, const kc_cancel_t* cancel)
+{
+    if (!cancel || timeout_ms == 0) return kc_chan_recv_c_sliced(ch, out, timeout_ms, cancel, KCORO_CANCEL_SLICE_MS);
+    struct kc_cancel_wait local;
+    int cancelled;
+    struct kc_cancel_wait *cw = kc_cancel_wait_begin(&local, cancel, &cancelled);
+    if (cancelled) return KC_ECANCELED;
+    long slice_ms = cw ? KC_CHAN_CANCEL_WOKEN_SLICE_MS : KCORO_CANCEL_SLICE_MS;
+    int rc = kc_chan_recv_c_sliced(ch, out, timeout_ms, cancel, slice_ms);
+    kc_cancel_wait_end(cw);
+    return rc;
+}
+
+/* ===================== Zero-Copy (zref) Implementation ===================== */
+
+unsigned kc_chan_capabilities(kc_chan_t *c) {
+    struct kc_chan *ch = (struct kc_chan*)c;
+    if (!ch) return 0;
+    KC_MUTEX_LOCK(&ch->mu);
+    unsigned caps = ch->capabilities;
+    KC_MUTEX_UNLOCK(&ch->mu);
+    return caps;
+}
+
+int kc_chan_set_wake_lane(kc_chan_t *c, int lane) {
+    struct kc_chan *ch = (struct kc_chan*)c;
+    if (!ch || lane < KC_LANE_INHERIT || lane >= KC_LANE_COUNT) return -EINVAL;
+    KC_MUTEX_LOCK(&ch->mu);
+    ch->wake_lane = lane;
+    KC_MUTEX_UNLOCK(&ch->mu);
+    return 0;
+}
+
+int kc_chan_set_affinity(kc_chan_t *c, int mode) {
+    struct kc_chan *ch = (struct kc_chan*)c;
+    if (!ch || mode < KC_AFFINITY_WAKER || mode > KC_AFFINITY_HOME) return -EINVAL;
+    KC_MUTEX_LOCK(&ch->mu);
+    ch->affinity = mode;
+    KC_MUTEX_UNLOCK(&ch->mu);
+    return 0;
+}
+
+int kc_chan_set_handoff(kc_chan_t *c, int on) {
+    struct kc_chan *ch = (struct kc_chan*)c;
+    if (!ch || ch->kind != KC_RENDEZVOUS || ch->ptr_mode) return -EINVAL;
+    KC_MUTEX_LOCK(&ch->mu);
+    int rc = ch->zref_mode ? -EINVAL : 0;
+    if (!rc) ch->handoff = on ? 1 : 0;
+    KC_MUTEX_UNLOCK(&ch->mu);
+    return rc;
+}
+
+int kc_chan_set_coalesce(kc_chan_t *c, unsigned max_batch, long max_delay_us) {
+    struct kc_chan *ch = (struct kc_chan*)c;
+    if (!ch || ch->kind == KC_RENDEZVOUS || ch->kind == KC_CONFLATED || ch->delay || ch->ptr_mode)
+        return -EINVAL;
+    int off = max_batch <= 1 || max_delay_us <= 0;
+    struct kc_wake wake = {0};
+    KC_MUTEX_LOCK(&ch->mu);
+    ch->coalesce_max = off ? 0 : max_batch;
+    ch->coalesce_delay_ns = off ? 0 : max_delay_us * 1000L;
+    if (ch->coalesce_pending) {
+        /* Release the wake the old window held. */
+        ch->coalesce_pending = 0;
+        wake = kc_chan_wake_recv_locked(ch);
+        kc_chan_hints_sync_locked(ch);
+    }
+    KC_MUTEX_UNLOCK(&ch->mu);
+    kc_chan_schedule_wake(wake);
+    return 0;
+}
+
+int kc_chan_enable_zero_copy(kc_chan_t *c) {
     struct kc_chan *ch = (struct kc_chan*)c;
     if (!ch) return -EINVAL;
+    if (ch->ring || ch->latest || ch->delay || ch->prio) return -ENOTSUP;
     KC_MUTEX_LOCK(&ch->mu);
     ch->capabilities |= KC_CHAN_CAP_ZERO_COPY;
     KC_MUTEX_UNLOCK(&ch->mu);
@@ -1189,45 +3318,121 @@ int kc_chan_get_zstats(kc_chan_t *c, struct kc_chan_zstats *out) {
     out->zref_fallback_capacity = ch->zref_fallback_capacity;
     out->zref_canceled = ch->zref_canceled;
     out->zref_aborted_close = ch->zref_aborted_close;
+    struct kc_bufpool *pool = ch->zc_pool;
     KC_MUTEX_UNLOCK(&ch->mu);
+    struct kc_bufpool_stats ps = { 0 };
+    if (pool) (void)kc_bufpool_get_stats(pool, &ps);
+    out->pool_hits = ps.hits;
+    out->pool_misses = ps.misses;
+    out->pool_empty = ps.empty;
     return 0;
 }
 
-int kc_chan_get_stats(kc_chan_t *c, struct kc_chan_stats *out) {
+int kc_chan_set_bufpool(kc_chan_t *c, kc_bufpool_t *pool)
+{
     struct kc_chan *ch = (struct kc_chan*)c;
-    if (!ch || !out) return -EINVAL;
-    
+    if (!ch) return -EINVAL;
     KC_MUTEX_LOCK(&ch->mu);
-    out->total_sends = ch->total_sends;
-    out->total_recvs = ch->total_recvs;
-    out->total_bytes_sent = ch->total_bytes_sent;
-    out->total_bytes_recv = ch->total_bytes_recv;
-    out->first_op_time_ns = ch->first_op_time_ns;
-    out->last_op_time_ns = ch->last_op_time_ns;
-    
-    /* Compute rates */
-    out->duration_sec = 0.0;
-    out->send_rate_ops_sec = 0.0;
-    out->recv_rate_ops_sec = 0.0;
-    out->send_rate_bytes_sec = 0.0;
-    out->recv_rate_bytes_sec = 0.0;
-    
-    if (ch->first_op_time_ns > 0 && ch->last_op_time_ns > ch->first_op_time_ns) {
-        long duration_ns = ch->last_op_time_ns - ch->first_op_time_ns;
-        out->duration_sec = (double)duration_ns / 1000000000.0;
-        
-        if (out->duration_sec > 0.0) {
-            out->send_rate_ops_sec = (double)ch->total_sends / out->duration_sec;
-            out->recv_rate_ops_sec = (double)ch->total_recvs / out->duration_sec;
-            out->send_rate_bytes_sec = (double)ch->total_bytes_sent / out->duration_sec;
-            out->recv_rate_bytes_sec = (double)ch->total_bytes_recv / out->duration_sec;
+    ch->zc_pool = pool;
+    KC_MUTEX_UNLOCK(&ch->mu);
+    return 0;
+}
+
+int kc_chan_set_stats_level(kc_chan_t *c, int level)
+{
+    struct kc_chan *ch = (struct kc_chan*)c;
+    if (!ch || level < KC_CHAN_STATS_OFF || level > KC_CHAN_STATS_FULL) return -EINVAL;
+    KC_MUTEX_LOCK(&ch->mu);
+    ch->stats_level = level;
+    KC_MUTEX_UNLOCK(&ch->mu);
+    return 0;
+}
+
+int kc_chan_set_latency(kc_chan_t *c, int on)
+{
+    struct kc_chan *ch = (struct kc_chan*)c;
+    if (!ch) return -EINVAL;
+    KC_MUTEX_LOCK(&ch->mu);
+    struct kc_chan_lat *l = atomic_load_explicit(&ch->lat, memory_order_relaxed);
+    if (on && !l) {
+        l = (struct kc_chan_lat*)aligned_alloc(_Alignof(struct kc_chan_lat), sizeof(*l));
+        if (!l) { KC_MUTEX_UNLOCK(&ch->mu); return -ENOMEM; }
+        atomic_init(&l->on, 0);
+        l->ts = NULL;
+        l->cap = l->head = l->n = 0;
+        kc_hist_shard_init(l->queue, KCORO_LAT_SHARDS);
+        kc_hist_shard_init(l->send_park, KCORO_LAT_SHARDS);
+        kc_hist_shard_init(l->recv_park, KCORO_LAT_SHARDS);
+        /* A bounded buffer never holds more stamps than elements */
+        if (ch->kind > 0 && !ch->ring && kc_chan_lat_grow_locked(l, ch->capacity) != 0) {
+            free(l);
+            KC_MUTEX_UNLOCK(&ch->mu);
+            return -ENOMEM;
         }
+        atomic_store_explicit(&ch->lat, l, memory_order_release);
+    }
+    if (l) {
+        /* Stamps of elements queued across an off period would be stale */
+        if (!on) l->n = 0;
+        atomic_store_explicit(&l->on, on ? 1 : 0, memory_order_relaxed);
     }
-    
     KC_MUTEX_UNLOCK(&ch->mu);
     return 0;
 }
 
+int kc_chan_get_latency(kc_chan_t *c, struct kc_chan_latency *out, int reset)
+{
+    struct kc_chan *ch = (struct kc_chan*)c;
+    if (!ch || !out) return -EINVAL;
+    memset(out, 0, sizeof(*out));
+    struct kc_chan_lat *l = atomic_load_explicit(&ch->lat, memory_order_acquire);
+    if (!l) return -ENOENT;
+    kc_hist_merge(l->queue, KCORO_LAT_SHARDS, &out->queue, reset);
+    kc_hist_merge(l->send_park, KCORO_LAT_SHARDS, &out->send_park, reset);
+    kc_hist_merge(l->recv_park, KCORO_LAT_SHARDS, &out->recv_park, reset);
+    return 0;
+}
+
+/* Ring channels keep no per-op counters: successful sends/recvs are the ring
+ * cursors and the last-op time is "now" once anything moved (ch->mu held). */
+static void kc_chan_ring_fold_stats_locked(struct kc_chan *ch)
+{
+    size_t sends, recvs;
+    kc_chan_ring_totals(ch, &sends, &recvs, &ch->first_op_time_ns, memory_order_acquire);
+    kc_chan_stats_write_begin(&ch->send_seq);
+    kc_chan_stats_write_begin(&ch->recv_seq);
+    ch->total_recvs = recvs;
+    ch->total_sends = sends;
+    ch->total_bytes_sent = ch->total_sends * ch->elem_sz;
+    ch->total_bytes_recv = ch->total_recvs * ch->elem_sz;
+    if (ch->total_sends) ch->last_send_ns = ch->last_recv_ns = kc_now_ns();
+    kc_chan_stats_write_end(&ch->recv_seq);
+    kc_chan_stats_write_end(&ch->send_seq);
+}
+
+/* Lock-free, from the snapshot. */
+int kc_chan_get_stats(kc_chan_t *c, struct kc_chan_stats *out) {
+    struct kc_chan *ch = (struct kc_chan*)c;
+    if (!ch || !out) return -EINVAL;
+    struct kc_chan_snapshot s;
+    kc_chan_peek_snapshot(ch, &s);
+    memset(out, 0, sizeof(*out));
+    out->total_sends = s.total_sends;
+    out->total_recvs = s.total_recvs;
+    out->total_bytes_sent = s.total_bytes_sent;
+    out->total_bytes_recv = s.total_bytes_recv;
+    out->first_op_time_ns = s.first_op_time_ns;
+    out->last_op_time_ns = s.last_op_time_ns;
+    out->duration_sec = s.duration_sec;
+    if (out->duration_sec > 0.0) {
+        out->send_rate_ops_sec = (double)out->total_sends / out->duration_sec;
+        out->recv_rate_ops_sec = (double)out->total_recvs / out->duration_sec;
+        out->send_rate_bytes_sec = (double)out->total_bytes_sent / out->duration_sec;
+        out->recv_rate_bytes_sec = (double)out->total_bytes_recv / out->duration_sec;
+    }
+    return 0;
+}
+
 int kc_chan_enable_metrics_pipe(kc_chan_t *c, kc_chan_t **out_pipe, size_t capacity) {
     struct kc_chan *ch = (struct kc_chan*)c;
     if (!ch) return -EINVAL;
@@ -1235,9 +3440,13 @@ int kc_chan_enable_metrics_pipe(kc_chan_t *c, kc_chan_t **out_pipe, size_t capac
     if (!ch->metrics_pipe) {
         kc_chan_t *pipe = NULL;
         size_t cap = capacity ? capacity : 64;
+        tls_making_metrics_pipe = 1;
         int rc = kc_chan_make(&pipe, (int)cap, sizeof(struct kc_chan_metrics_event), cap);
+        tls_making_metrics_pipe = 0;
         if (rc != 0) { KC_MUTEX_UNLOCK(&ch->mu); return rc; }
         ch->metrics_pipe = (struct kc_chan*)pipe;
+        if (ch->ring) kc_chan_ring_fold_stats_locked(ch);
+        else if (ch->latest) kc_chan_latest_fold_stats_locked(ch);
         ch->last_emit_sends = ch->total_sends;
         ch->last_emit_recvs = ch->total_recvs;
         ch->last_emit_bytes_sent = ch->total_bytes_sent;
@@ -1246,6 +3455,7 @@ int kc_chan_enable_metrics_pipe(kc_chan_t *c, kc_chan_t **out_pipe, size_t capac
     }
     if (out_pipe) *out_pipe = (kc_chan_t*)ch->metrics_pipe;
     KC_MUTEX_UNLOCK(&ch->mu);
+    kc_chan_metrics_link(ch);
     return 0;
 }
 
@@ -1255,6 +3465,7 @@ int kc_chan_disable_metrics_pipe(kc_chan_t *c) {
     KC_MUTEX_LOCK(&ch->mu);
     ch->metrics_pipe = NULL; /* caller retains previous pipe channel pointer */
     KC_MUTEX_UNLOCK(&ch->mu);
+    kc_chan_metrics_unlink(ch);
     return 0;
 }
 
@@ -1270,42 +3481,83 @@ kc_chan_t *kc_chan_metrics_pipe(kc_chan_t *c) {
 int kc_chan_snapshot(kc_chan_t *c, struct kc_chan_snapshot *out) {
     struct kc_chan *ch = (struct kc_chan*)c;
     if (!ch || !out) return -EINVAL;
-    KC_MUTEX_LOCK(&ch->mu);
+    kc_chan_peek_snapshot(ch, out);
+    return 0;
+}
+
+/* Counters straight off the channel fields with no ch->mu, so sampling
+ * never stalls the data path. Each side's throughput counters come as one
+ * set through its seqlock, the receive side first, so total_sends is never
+ * behind total_recvs. The rest are relaxed loads: each value is one its
+ * writer stored, but they are not a consistent cut and may trail in-flight
+ * ops. Ring and conflated cells read their atomics rather than folding. */
+#define KC_PEEK(field) __atomic_load_n(&(field), __ATOMIC_RELAXED)
+void kc_chan_peek_snapshot(struct kc_chan *ch, struct kc_chan_snapshot *out)
+{
     memset(out, 0, sizeof(*out));
     out->chan = ch;
     out->kind = ch->kind;
     out->elem_sz = ch->elem_sz;
-    out->capacity = ch->capacity;
-    if (ch->kind == KC_CONFLATED) out->count = ch->has_value ? 1 : 0; else out->count = ch->count;
+    out->capacity = KC_PEEK(ch->capacity);
     out->capabilities = ch->capabilities;
-    out->closed = ch->closed;
-    out->zref_mode = ch->zref_mode;
+    out->closed = KC_PEEK(ch->closed);
+    out->zref_mode = KC_PEEK(ch->zref_mode);
     out->ptr_mode = ch->ptr_mode;
-    out->total_sends = ch->total_sends;
-    out->total_recvs = ch->total_recvs;
-    out->total_bytes_sent = ch->total_bytes_sent;
-    out->total_bytes_recv = ch->total_bytes_recv;
-    out->first_op_time_ns = ch->first_op_time_ns;
-    out->last_op_time_ns = ch->last_op_time_ns;
-    out->send_eagain = ch->send_eagain;
-    out->send_etime  = ch->send_etime;
-    out->send_epipe  = ch->send_epipe;
-    out->recv_eagain = ch->recv_eagain;
-    out->recv_etime  = ch->recv_etime;
-    out->recv_epipe  = ch->recv_epipe;
-    out->zref_sent = ch->zref_sent;
-    out->zref_received = ch->zref_received;
-    out->zref_aborted_close = ch->zref_aborted_close;
-    out->rv_matches = ch->rv_matches;
-    out->rv_cancels = ch->rv_cancels;
-    out->rv_zdesc_matches = ch->rv_zdesc_matches;
-    if (ch->first_op_time_ns && ch->last_op_time_ns > ch->first_op_time_ns) {
-        long dur = ch->last_op_time_ns - ch->first_op_time_ns;
-        out->duration_sec = (double)dur / 1e9;
+    out->stats_level = KC_PEEK(ch->stats_level);
+    out->send_eagain = KC_PEEK(ch->send_eagain);
+    out->send_etime  = KC_PEEK(ch->send_etime);
+    out->send_epipe  = KC_PEEK(ch->send_epipe);
+    out->recv_eagain = KC_PEEK(ch->recv_eagain);
+    out->recv_etime  = KC_PEEK(ch->recv_etime);
+    out->recv_epipe  = KC_PEEK(ch->recv_epipe);
+    long ring_first = 0, ls = 0, lr = 0;
+    if (ch->ring) {
+        struct kc_mpmc_ring *r = ch->ring;
+        size_t sends, recvs;
+        kc_chan_ring_totals(ch, &sends, &recvs, &ring_first, memory_order_relaxed);
+        out->total_recvs = recvs;
+        out->total_sends = sends;
+        out->total_bytes_sent = out->total_sends * ch->elem_sz;
+        out->total_bytes_recv = out->total_recvs * ch->elem_sz;
+        out->count = out->total_sends > out->total_recvs ? out->total_sends - out->total_recvs : 0;
+        out->send_eagain += atomic_load_explicit(&r->send_eagain, memory_order_relaxed);
+        out->recv_eagain += atomic_load_explicit(&r->recv_eagain, memory_order_relaxed);
+    } else if (ch->latest) {
+        struct kc_chan_latest *l = ch->latest;
+        out->total_sends = atomic_load_explicit(&l->sends, memory_order_relaxed);
+        out->total_recvs = atomic_load_explicit(&l->recvs, memory_order_relaxed);
+        out->total_bytes_sent = out->total_sends * ch->elem_sz;
+        out->total_bytes_recv = out->total_recvs * ch->elem_sz;
+        out->count = (size_t)kc_chan_latest_full(ch);
+        ring_first = atomic_load_explicit(&l->first_op_ns, memory_order_relaxed);
+    } else {
+        kc_chan_stats_read_side(ch, 0, &out->total_recvs, &out->total_bytes_recv, &lr);
+        kc_chan_stats_read_side(ch, 1, &out->total_sends, &out->total_bytes_sent, &ls);
+        out->count = ch->kind == KC_CONFLATED ? (size_t)KC_PEEK(ch->has_value) : KC_PEEK(ch->count);
     }
-    KC_MUTEX_UNLOCK(&ch->mu);
-    return 0;
+    /* As the fold under ch->mu: lock-free kinds keep no op times. */
+    if ((ch->ring || ch->latest) && out->total_sends) ls = lr = kc_now_ns();
+    out->zref_sent = KC_PEEK(ch->zref_sent);
+    out->zref_received = KC_PEEK(ch->zref_received);
+    out->zref_aborted_close = KC_PEEK(ch->zref_aborted_close);
+    out->rv_matches = KC_PEEK(ch->rv_matches);
+    out->rv_cancels = KC_PEEK(ch->rv_cancels);
+    out->rv_zdesc_matches = KC_PEEK(ch->rv_zdesc_matches);
+    out->send_waiters = KC_PEEK(ch->waiters_send);
+    out->recv_waiters = KC_PEEK(ch->waiters_recv);
+    out->first_op_time_ns = (ch->ring || ch->latest) ? ring_first : KC_PEEK(ch->first_op_time_ns);
+    out->last_op_time_ns = ls > lr ? ls : lr;
+    kc_chan_spill_stats(__atomic_load_n(&ch->spill, __ATOMIC_ACQUIRE),
+                        &out->spilled_bytes, &out->spill_writes, &out->spill_reads);
+    if (ch->prio) kc_chan_prio_depths(ch->prio, out->prio_depth);
+    out->coalesce_held = KC_PEEK(ch->coalesce_held);
+    out->coalesce_flushes = KC_PEEK(ch->coalesce_flushes);
+    out->spin_wins = KC_PEEK(ch->spin_wins);
+    out->spin_parks = KC_PEEK(ch->spin_parks);
+    if (out->first_op_time_ns && out->last_op_time_ns > out->first_op_time_ns)
+        out->duration_sec = (double)(out->last_op_time_ns - out->first_op_time_ns) / 1e9;
 }
+#undef KC_PEEK
 
 int kc_chan_compute_rate(const struct kc_chan_snapshot *prev,
                          const struct kc_chan_snapshot *curr,
@@ -1374,8 +3626,8 @@ int kc_chan_compute_rate(const struct kc_chan_snapshot *prev,
  */
 int kc_chan_make_ptr(kc_chan_t **out, int kind, size_t capacity)
 {
-    if (!out) return -EINVAL;
-    int rc = kc_chan_make(out, kind, sizeof(struct kc_chan_ptrmsg), capacity);
+    if (!out || kind == KC_DELAYED) return -EINVAL;
+    int rc = kc_chan_make_mode(out, kind, sizeof(struct kc_chan_ptrmsg), capacity, 1);
     if (rc != 0) return rc;
     struct kc_chan *ch = (struct kc_chan*)(*out);
     ch->ptr_mode = 1;
@@ -1388,7 +3640,7 @@ int kc_chan_make_ptr(kc_chan_t **out, int kind, size_t capacity)
  * Send a pointer‑descriptor. length must be > 0.
  * Routes to zref backend when bound; otherwise uses the classic queued path.
  */
-int kc_chan_send_ptr(kc_chan_t *c, void *ptr, size_t len, long timeout_ms)
+static int kc_chan_send_ptr_body(kc_chan_t *c, void *ptr, size_t len, long timeout_ms, long *wait_t0)
 {
     struct kc_chan *ch = (struct kc_chan*)c;
     if (!ch || !ptr || len == 0) return -EINVAL;
@@ -1405,15 +3657,23 @@ int kc_chan_send_ptr(kc_chan_t *c, void *ptr, size_t len, long timeout_ms)
     const struct kc_chan_ptrmsg msg = { .ptr = ptr, .len = len };
     long deadline_ns = 0; const int timed = (timeout_ms > 0);
     if (timed) deadline_ns = kc_now_ns() + timeout_ms * 1000000L;
-
-    struct kc_waiter_token send_token;
-    kc_waiter_token_reset(&send_token);
+    int rc;
 
 again_send_ptr:
     KC_MUTEX_LOCK(&ch->mu);
     if (ch->closed) { ch->send_epipe++; KC_MUTEX_UNLOCK(&ch->mu); return KC_EPIPE; }
     struct kc_wake wake_recv = {0};
 
+    /* A receiver parked on a ticket takes the descriptor directly (it only
+     * parks on an empty channel, so this keeps FIFO order). */
+    if (!ch->has_value && ch->count == 0 && kc_chan_ptr_give_locked(ch, &msg)) {
+        if (ch->kind == KC_RENDEZVOUS) ch->rv_matches++;
+        kc_chan_update_send_stats_len_locked(ch, len);
+        kc_chan_update_recv_stats_len_locked(ch, len);
+        KC_MUTEX_UNLOCK(&ch->mu);
+        return 0;
+    }
+
     /* Conflated: keep only the latest descriptor */
     if (ch->kind == KC_CONFLATED) {
         memcpy(ch->slot, &msg, sizeof(msg));
@@ -1423,29 +3683,33 @@ again_send_ptr:
         wake_recv = kc_chan_wake_recv_locked(ch);
         KC_MUTEX_UNLOCK(&ch->mu);
         kc_chan_schedule_wake(wake_recv);
-        kc_waiter_token_reset(&send_token);
         return 0;
     }
 
-    /* Rendezvous: publish into slot when a receiver is available */
+    /* Rendezvous: a select receiver reads the slot, anyone else takes the
+     * ticket we park on. */
     if (ch->kind == KC_RENDEZVOUS) {
-        if (ch->wq_recv_head == NULL || ch->has_value) {
+        if (ch->wq_recv_head != NULL && !ch->has_value) {
+            memcpy(ch->slot, &msg, sizeof(msg));
+            ch->has_value = 1;
+            kc_chan_update_send_stats_len_locked(ch, len);
+            KC_COND_SIGNAL(&ch->cv_recv);
+            wake_recv = kc_chan_wake_recv_locked(ch);
+            KC_MUTEX_UNLOCK(&ch->mu);
+            kc_chan_schedule_wake(wake_recv);
+            return 0;
+        }
+    } else if (ch->count < ch->capacity || ch->kind == KC_UNLIMITED) {
+        /* Buffered / Unlimited: enqueue */
+        if ((rc = kc_chan_buf_put_locked(ch, &msg)) == KC_EAGAIN) {
+            /* KC_MEM_CHAN backpressure, as in kc_chan_send */
             if (timeout_ms == 0) { ch->send_eagain++; KC_MUTEX_UNLOCK(&ch->mu); return KC_EAGAIN; }
-            if (timeout_ms < 0) {
-                int ensure_rc = kc_waiter_token_ensure_enqueued(&send_token, ch, KC_SELECT_CLAUSE_SEND);
-                if (ensure_rc != 0) { KC_MUTEX_UNLOCK(&ch->mu); return ensure_rc; }
-                KC_MUTEX_UNLOCK(&ch->mu);
-                kcoro_park();
-                kc_waiter_token_reset(&send_token);
-                goto again_send_ptr;
-            }
+            if (timed && kc_now_ns() >= deadline_ns) { ch->send_etime++; KC_MUTEX_UNLOCK(&ch->mu); return KC_ETIME; }
             KC_MUTEX_UNLOCK(&ch->mu);
-            if (kc_now_ns() >= deadline_ns) { ch->send_etime++; return KC_ETIME; }
-            kcoro_yield();
+            kc_sleep_ms(1);
             goto again_send_ptr;
         }
-        memcpy(ch->slot, &msg, sizeof(msg));
-        ch->has_value = 1;
+        if (rc != 0) { KC_MUTEX_UNLOCK(&ch->mu); return -ENOMEM; }
         kc_chan_update_send_stats_len_locked(ch, len);
         KC_COND_SIGNAL(&ch->cv_recv);
         wake_recv = kc_chan_wake_recv_locked(ch);
@@ -1454,59 +3718,30 @@ again_send_ptr:
         return 0;
     }
 
-    /* Buffered / Unlimited */
-    if (timeout_ms == 0) {
-        if (ch->count == ch->capacity) {
-            if (ch->kind == KC_UNLIMITED) {
-                size_t newcap = ch->capacity ? ch->capacity * 2 : KCORO_UNLIMITED_INIT_CAP;
-                unsigned char *nbuf = malloc(newcap * ch->elem_sz);
-                if (!nbuf) { KC_MUTEX_UNLOCK(&ch->mu); return -ENOMEM; }
-                size_t old_cap = ch->capacity; size_t old_mask = ch->mask;
-                for (size_t i = 0; i < ch->count; ++i) {
-                    size_t idx = old_mask ? ((ch->head + i) & old_mask) : ((ch->head + i) % old_cap);
-                    memcpy(nbuf + (i * ch->elem_sz), ch->buf + (idx * ch->elem_sz), ch->elem_sz);
-                }
-                free(ch->buf);
-                ch->buf = nbuf; ch->capacity = newcap; ch->mask = newcap - 1; ch->head = 0; ch->tail = ch->count;
-            } else { ch->send_eagain++; KC_MUTEX_UNLOCK(&ch->mu); return KC_EAGAIN; }
-        }
-    } else if (timeout_ms < 0) {
-        if (ch->count == ch->capacity && ch->kind != KC_UNLIMITED) {
-            struct kc_waiter *w = kc_waiter_new_coro(KC_SELECT_CLAUSE_SEND);
-            if (!w) { KC_MUTEX_UNLOCK(&ch->mu); return -ENOMEM; }
-            kc_waiter_append(&ch->wq_send_head, &ch->wq_send_tail, w);
-            KC_MUTEX_UNLOCK(&ch->mu);
-            kcoro_yield();
-            goto again_send_ptr;
-        }
-    } else {
-        if (ch->count == ch->capacity && ch->kind != KC_UNLIMITED) {
-            KC_MUTEX_UNLOCK(&ch->mu);
-            if (kc_now_ns() >= deadline_ns) { ch->send_etime++; return KC_ETIME; }
-            kcoro_yield();
-            goto again_send_ptr;
-        }
-    }
-
-    /* enqueue */
-    size_t t = kc_ring_idx(ch, ch->tail);
-    memcpy(ch->buf + (t * ch->elem_sz), &msg, sizeof(msg));
-    size_t next = ch->tail + 1; ch->tail = ch->mask ? (next & ch->mask) : (next % ch->capacity);
-    ch->count++;
-    kc_chan_update_send_stats_len_locked(ch, len);
-    KC_COND_SIGNAL(&ch->cv_recv);
-    wake_recv = kc_chan_wake_recv_locked(ch);
-    KC_MUTEX_UNLOCK(&ch->mu);
-    kc_chan_schedule_wake(wake_recv);
-    kc_waiter_token_reset(&send_token);
-    return 0;
+    /* No receiver / full: park until one takes msg (a buffered receiver
+     * moves it into the slot it freed). */
+    if (timeout_ms == 0) { ch->send_eagain++; KC_MUTEX_UNLOCK(&ch->mu); return KC_EAGAIN; }
+    if (timed && kc_now_ns() >= deadline_ns) { ch->send_etime++; KC_MUTEX_UNLOCK(&ch->mu); return KC_ETIME; }
+    rc = kc_chan_ptr_park_locked(ch, KC_SELECT_CLAUSE_SEND, &msg, deadline_ns, (struct kc_wake){0}, wait_t0, NULL);
+    if (rc == KC_EAGAIN || rc == KC_EPIPE) goto again_send_ptr;
+    return rc;
+}
+
+int kc_chan_send_ptr(kc_chan_t *c, void *ptr, size_t len, long timeout_ms)
+{
+    long rec_t0 = KC_CHAN_REC_T0();
+    long wait_t0 = 0;
+    int rc = kc_chan_send_ptr_body(c, ptr, len, timeout_ms, &wait_t0);
+    kc_chan_lat_wait_end((struct kc_chan*)c, KC_SELECT_CLAUSE_SEND, wait_t0);
+    KC_CHAN_REC((struct kc_chan*)c, KC_CHAN_REC_SEND_PTR, rec_t0, rc == 0, rc == 0 ? len : 0, rc);
+    return rc;
 }
 
 /**
  * Receive a pointer‑descriptor. Returns the pointer and length.
  * Routes to zref backend when bound; otherwise uses the classic queued path.
  */
-int kc_chan_recv_ptr(kc_chan_t *c, void **out_ptr, size_t *out_len, long timeout_ms)
+static int kc_chan_recv_ptr_body(kc_chan_t *c, void **out_ptr, size_t *out_len, long timeout_ms, long *wait_t0)
 {
     struct kc_chan *ch = (struct kc_chan*)c;
     if (!ch || !out_ptr || !out_len) return -EINVAL;
@@ -1524,167 +3759,116 @@ int kc_chan_recv_ptr(kc_chan_t *c, void **out_ptr, size_t *out_len, long timeout
 
     long deadline_ns = 0; const int timed = (timeout_ms > 0);
     if (timed) deadline_ns = kc_now_ns() + timeout_ms * 1000000L;
-
-    struct kc_waiter_token recv_token;
-    kc_waiter_token_reset(&recv_token);
+    struct kc_chan_ptrmsg tmp;
+    int rc;
 
 again_recv_ptr:
     KC_MUTEX_LOCK(&ch->mu);
     struct kc_wake wake_send = {0};
 
     if (ch->kind == KC_CONFLATED) {
-        int rc = 0;
-        if (!ch->has_value) {
-            if (timeout_ms == 0) {
-                ch->recv_eagain++;
-                KC_MUTEX_UNLOCK(&ch->mu);
-                return KC_EAGAIN;
-            } else if (timeout_ms < 0) {
-                if (!ch->closed) {
-                    struct kc_waiter *w = kc_waiter_new_coro(KC_SELECT_CLAUSE_RECV);
-                    if (!w) { KC_MUTEX_UNLOCK(&ch->mu); return -ENOMEM; }
-                    kc_waiter_append(&ch->wq_recv_head, &ch->wq_recv_tail, w);
-                    KC_MUTEX_UNLOCK(&ch->mu);
-                    kcoro_yield();
-                    goto again_recv_ptr;
-                }
-            } else {
-                KC_MUTEX_UNLOCK(&ch->mu);
-                if (kc_now_ns() >= deadline_ns) { ch->recv_etime++; return KC_ETIME; }
-                kcoro_yield();
-                goto again_recv_ptr;
-            }
-        }
-        if (rc == 0 && ch->has_value) {
-            struct kc_chan_ptrmsg tmp; memcpy(&tmp, ch->slot, sizeof(tmp)); ch->has_value = 0;
+        if (ch->has_value) {
+            memcpy(&tmp, ch->slot, sizeof(tmp)); ch->has_value = 0;
             *out_ptr = tmp.ptr; *out_len = tmp.len;
             kc_chan_update_recv_stats_len_locked(ch, tmp.len);
             KC_COND_SIGNAL(&ch->cv_send);
             wake_send = kc_chan_wake_send_locked(ch);
-        } else if (rc == 0 && ch->closed && !ch->has_value) {
-            rc = KC_EPIPE;
+            KC_MUTEX_UNLOCK(&ch->mu);
+            kc_chan_schedule_wake(wake_send);
+            return 0;
         }
-        KC_MUTEX_UNLOCK(&ch->mu);
-        kc_chan_schedule_wake(wake_send);
-        return rc;
-    }
-
-    /* Rendezvous: consume from slot when present */
-    if (ch->kind == KC_RENDEZVOUS) {
-        for (;;) {
+        if (ch->closed) { KC_MUTEX_UNLOCK(&ch->mu); return KC_EPIPE; }
+    } else if (ch->kind == KC_RENDEZVOUS) {
+        /* A select sender's value in the slot, else a parked sender's ticket */
+        if (ch->has_value) {
+            memcpy(&tmp, ch->slot, sizeof(tmp));
+            ch->has_value = 0;
+            *out_ptr = tmp.ptr;
+            *out_len = tmp.len;
+            ch->rv_matches++;
+            kc_chan_update_recv_stats_len_locked(ch, tmp.len);
+            KC_COND_SIGNAL(&ch->cv_send);
+            wake_send = kc_chan_wake_send_locked(ch);
+            KC_MUTEX_UNLOCK(&ch->mu);
+            kc_chan_schedule_wake(wake_send);
+            return 0;
+        }
+        if (kc_chan_ptr_take_locked(ch, &tmp)) {
+            *out_ptr = tmp.ptr;
+            *out_len = tmp.len;
+            ch->rv_matches++;
+            kc_chan_update_send_stats_len_locked(ch, tmp.len);
+            kc_chan_update_recv_stats_len_locked(ch, tmp.len);
+            KC_MUTEX_UNLOCK(&ch->mu);
+            return 0;
+        }
+        if (ch->closed) { KC_MUTEX_UNLOCK(&ch->mu); return KC_EPIPE; }
+        if (ch->wq_send_head != NULL) {
+            /* A select sender delivers into the slot. */
+            wake_send = kc_chan_wake_send_locked(ch);
             if (ch->has_value) {
-                struct kc_chan_ptrmsg tmp;
-                memcpy(&tmp, ch->slot, sizeof(tmp));
-                ch->has_value = 0;
-                *out_ptr = tmp.ptr;
-                *out_len = tmp.len;
-                ch->rv_matches++;
-                kc_chan_update_recv_stats_len_locked(ch, tmp.len);
-                KC_COND_SIGNAL(&ch->cv_send);
-                wake_send = kc_chan_wake_send_locked(ch);
                 KC_MUTEX_UNLOCK(&ch->mu);
                 kc_chan_schedule_wake(wake_send);
-                kc_waiter_token_reset(&recv_token);
-                return 0;
-            }
-            if (ch->closed) {
-                KC_MUTEX_UNLOCK(&ch->mu);
-                kc_waiter_token_reset(&recv_token);
-                return KC_EPIPE;
-            }
-            if (timeout_ms == 0) {
-                if (ch->wq_send_head != NULL) {
-                    struct kc_wake wake_sender = kc_chan_wake_send_locked(ch);
-                    KC_MUTEX_UNLOCK(&ch->mu);
-                    kc_chan_schedule_wake(wake_sender);
-                    goto again_recv_ptr;
-                }
-                ch->recv_eagain++;
-                KC_MUTEX_UNLOCK(&ch->mu);
-                kc_waiter_token_reset(&recv_token);
-                return KC_EAGAIN;
-            }
-            if (timeout_ms < 0) {
-                int ensure_rc = kc_waiter_token_ensure_enqueued(&recv_token, ch, KC_SELECT_CLAUSE_RECV);
-                if (ensure_rc != 0) {
-                    KC_MUTEX_UNLOCK(&ch->mu);
-                    return ensure_rc;
-                }
-                struct kc_wake wake_sender = {0};
-                if (ch->wq_send_head != NULL) {
-                    wake_sender = kc_chan_wake_send_locked(ch);
-                }
-                KC_MUTEX_UNLOCK(&ch->mu);
-                kc_chan_schedule_wake(wake_sender);
-                kcoro_park();
-                kc_waiter_token_reset(&recv_token);
                 goto again_recv_ptr;
             }
-            /* timeout_ms > 0 */
-            struct kc_wake wake_sender = {0};
-            if (ch->wq_send_head != NULL) {
-                wake_sender = kc_chan_wake_send_locked(ch);
-            }
-            KC_MUTEX_UNLOCK(&ch->mu);
-            kc_chan_schedule_wake(wake_sender);
-            if (kc_now_ns() >= deadline_ns) { ch->recv_etime++; kc_waiter_token_reset(&recv_token); return KC_ETIME; }
-            kcoro_yield();
-            goto again_recv_ptr;
         }
+    } else if (ch->count > 0) {
+        /* Buffered/unlimited: take the head, refill from a parked sender. */
+        kc_chan_buf_take_locked(ch, &tmp);
+        *out_ptr = tmp.ptr; *out_len = tmp.len;
+        kc_chan_update_recv_stats_len_locked(ch, tmp.len);
+        struct kc_chan_ptrmsg next;
+        if (kc_chan_ptr_take_locked(ch, &next)) {
+            (void)kc_chan_buf_put_locked(ch, &next);   /* reuses the slot just freed */
+            kc_chan_update_send_stats_len_locked(ch, next.len);
+        } else {
+            KC_COND_SIGNAL(&ch->cv_send);
+            wake_send = kc_chan_wake_send_locked(ch);
+        }
+        KC_MUTEX_UNLOCK(&ch->mu);
+        kc_chan_schedule_wake(wake_send);
+        return 0;
+    } else if (ch->closed) {
+        if (timeout_ms == 0) ch->recv_epipe++;
+        KC_MUTEX_UNLOCK(&ch->mu);
+        return KC_EPIPE;
     }
 
-    /* Buffered/unlimited */
+    /* Nothing to take: park until a sender hands a descriptor over */
     if (timeout_ms == 0) {
-        if (ch->count == 0) {
-            int rcl = ch->closed ? KC_EPIPE : KC_EAGAIN;
-            if (rcl == KC_EAGAIN) ch->recv_eagain++; else ch->recv_epipe++;
-            KC_MUTEX_UNLOCK(&ch->mu);
-            return rcl;
-        }
-    } else if (timeout_ms < 0) {
-        if (ch->count == 0 && !ch->closed) {
-            struct kc_waiter *w = kc_waiter_new_coro(KC_SELECT_CLAUSE_RECV);
-            if (!w) { KC_MUTEX_UNLOCK(&ch->mu); return -ENOMEM; }
-            kc_waiter_append(&ch->wq_recv_head, &ch->wq_recv_tail, w);
-            KC_MUTEX_UNLOCK(&ch->mu);
-            kcoro_yield();
-            goto again_recv_ptr;
-        }
-    } else {
-        if (ch->count == 0 && !ch->closed) {
-            KC_MUTEX_UNLOCK(&ch->mu);
-            if (kc_now_ns() >= deadline_ns) { ch->recv_etime++; return KC_ETIME; }
-            kcoro_yield();
-            goto again_recv_ptr;
-        }
+        ch->recv_eagain++;
+        KC_MUTEX_UNLOCK(&ch->mu);
+        kc_chan_schedule_wake(wake_send);
+        return KC_EAGAIN;
     }
-
-    if (ch->count > 0) {
-        size_t h = kc_ring_idx(ch, ch->head);
-        struct kc_chan_ptrmsg tmp;
-        memcpy(&tmp, ch->buf + (h * ch->elem_sz), sizeof(tmp));
-        size_t n2 = ch->head + 1;
-        ch->head = ch->mask ? (n2 & ch->mask) : (n2 % ch->capacity);
-        ch->count--;
-        *out_ptr = tmp.ptr; *out_len = tmp.len;
-        kc_chan_update_recv_stats_len_locked(ch, tmp.len);
-        KC_COND_SIGNAL(&ch->cv_send);
-        wake_send = kc_chan_wake_send_locked(ch);
+    if (timed && kc_now_ns() >= deadline_ns) {
+        ch->recv_etime++;
         KC_MUTEX_UNLOCK(&ch->mu);
         kc_chan_schedule_wake(wake_send);
-        return 0;
+        return KC_ETIME;
     }
+    rc = kc_chan_ptr_park_locked(ch, KC_SELECT_CLAUSE_RECV, NULL, deadline_ns, wake_send, wait_t0, &tmp);
+    if (rc == 0) { *out_ptr = tmp.ptr; *out_len = tmp.len; return 0; }
+    if (rc == KC_EAGAIN || rc == KC_EPIPE) goto again_recv_ptr;
+    return rc;
+}
 
-    if (ch->closed && ch->count == 0) { KC_MUTEX_UNLOCK(&ch->mu); return KC_EPIPE; }
-    KC_MUTEX_UNLOCK(&ch->mu);
-    return KC_EAGAIN;
+int kc_chan_recv_ptr(kc_chan_t *c, void **out_ptr, size_t *out_len, long timeout_ms)
+{
+    long rec_t0 = KC_CHAN_REC_T0();
+    long wait_t0 = 0;
+    int rc = kc_chan_recv_ptr_body(c, out_ptr, out_len, timeout_ms, &wait_t0);
+    kc_chan_lat_wait_end((struct kc_chan*)c, KC_SELECT_CLAUSE_RECV, wait_t0);
+    KC_CHAN_REC((struct kc_chan*)c, KC_CHAN_REC_RECV_PTR, rec_t0, rc == 0,
+                rc == 0 && out_len ? *out_len : 0, rc);
+    return rc;
 }
 
-int kc_chan_send_ptr_c(kc_chan_t *ch, void *ptr, size_t len, long timeout_ms, const kc_cancel_t *cancel)
+static int kc_chan_send_ptr_c_sliced(kc_chan_t *ch, void *ptr, size_t len, long timeout_ms, const kc_cancel_t *cancel, long slice_ms)
 {
     if (!cancel) return kc_chan_send_ptr(ch, ptr, len, timeout_ms);
     if (kc_cancel_is_set(cancel)) return KC_ECANCELED;
-    const long SLICE_MS = KCORO_CANCEL_SLICE_MS;
+    const long SLICE_MS = slice_ms;
     if (timeout_ms == 0) return kc_chan_send_ptr(ch, ptr, len, 0);
     if (timeout_ms < 0) {
         for (;;) {
@@ -1708,11 +3892,26 @@ int kc_chan_send_ptr_c(kc_chan_t *ch, void *ptr, size_t len, long timeout_ms, co
     }
 }
 
-int kc_chan_recv_ptr_c(kc_chan_t *ch, void **out_ptr, size_t *out_len, long timeout_ms, const kc_cancel_t *cancel)
+int kc_chan_send_ptr_c(kc_chan_t *ch, void *ptr, size_t len, long timeout_ms, const kc_cancel_t *cancel)
+{
+    /* zref routing parks elsewhere: plain slices */
+    if (!cancel || timeout_ms == 0 || (ch && ((struct kc_chan*)ch)->zc_ops))
+        return kc_chan_send_ptr_c_sliced(ch, ptr, len, timeout_ms, cancel, KCORO_CANCEL_SLICE_MS);
+    struct kc_cancel_wait local;
+    int cancelled;
+    struct kc_cancel_wait *cw = kc_cancel_wait_begin(&local, cancel, &cancelled);
+    if (cancelled) return KC_ECANCELED;
+    long slice_ms = cw ? KC_CHAN_CANCEL_WOKEN_SLICE_MS : KCORO_CANCEL_SLICE_MS;
+    int rc = kc_chan_send_ptr_c_sliced(ch, ptr, len, timeout_ms, cancel, slice_ms);
+    kc_cancel_wait_end(cw);
+    return rc;
+}
+
+static int kc_chan_recv_ptr_c_sliced(kc_chan_t *ch, void **out_ptr, size_t *out_len, long timeout_ms, const kc_cancel_t *cancel, long slice_ms)
 {
     if (!cancel) return kc_chan_recv_ptr(ch, out_ptr, out_len, timeout_ms);
     if (kc_cancel_is_set(cancel)) return KC_ECANCELED;
-    const long SLICE_MS = KCORO_CANCEL_SLICE_MS;
+    const long SLICE_MS = slice_ms;
     if (timeout_ms == 0) return kc_chan_recv_ptr(ch, out_ptr, out_len, 0);
     if (timeout_ms < 0) {
         for (;;) {
@@ -1737,3 +3936,519 @@ int kc_chan_recv_ptr_c(kc_chan_t *ch, void **out_ptr, size_t *out_len, long time
         return KC_ETIME;
     }
 }
+
+int kc_chan_recv_ptr_c(kc_chan_t *ch, void **out_ptr, size_t *out_len, long timeout_ms, const kc_cancel_t *cancel)
+{
+    /* zref routing parks elsewhere: plain slices */
+    if (!cancel || timeout_ms == 0 || (ch && ((struct kc_chan*)ch)->zc_ops))
+        return kc_chan_recv_ptr_c_sliced(ch, out_ptr, out_len, timeout_ms, cancel, KCORO_CANCEL_SLICE_MS);
+    struct kc_cancel_wait local;
+    int cancelled;
+    struct kc_cancel_wait *cw = kc_cancel_wait_begin(&local, cancel, &cancelled);
+    if (cancelled) return KC_ECANCELED;
+    long slice_ms = cw ? KC_CHAN_CANCEL_WOKEN_SLICE_MS : KCORO_CANCEL_SLICE_MS;
+    int rc = kc_chan_recv_ptr_c_sliced(ch, out_ptr, out_len, timeout_ms, cancel, slice_ms);
+    kc_cancel_wait_end(cw);
+    return rc;
+}
+
+/* =======================================================================
+ * Batch API
+ * -----------------------------------------------------------------------
+ * Buffered/unlimited mutex channels move a whole run per lock acquisition:
+ * one or two memcpy calls across the ring wrap, one stats update and one
+ * wake pass (up to one waiter per element moved, bounded by kc_wake_list).
+ * Other kinds (rendezvous, conflated, lock-free rings, zref-bound pointer
+ * channels) have no contiguous storage to batch into and loop over the
+ * single-element calls under the same deadline.
+ * ======================================================================= */
+
+static void kc_chan_update_stats_batch_locked(struct kc_chan *ch, int is_send, size_t n, size_t bytes)
+{
+    kc_chan_set_note_locked(ch, is_send ? KC_CHAN_SET_RECV : KC_CHAN_SET_SEND);
+    if (ch->stats_level == KC_CHAN_STATS_OFF) return;
+    if (is_send) {
+        kc_chan_stats_write_begin(&ch->send_seq);
+        ch->total_sends += n; ch->total_bytes_sent += bytes;
+        kc_chan_stats_time_locked(ch, &ch->last_send_ns);
+        kc_chan_stats_write_end(&ch->send_seq);
+    } else {
+        kc_chan_stats_write_begin(&ch->recv_seq);
+        ch->total_recvs += n; ch->total_bytes_recv += bytes;
+        kc_chan_stats_time_locked(ch, &ch->last_recv_ns);
+        kc_chan_stats_write_end(&ch->recv_seq);
+    }
+}
+
+/* Wake up to n waiters of one side after a batch (ch->mu held). */
+static void kc_chan_wake_many_locked(struct kc_chan *ch, enum kc_select_clause_kind clause,
+                                     size_t n, struct kc_wake_list *wakes)
+{
+    size_t room = sizeof(wakes->items) / sizeof(wakes->items[0]) - (size_t)wakes->count;
+    if (n > room) n = room;
+    while (n--) {
+        struct kc_wake w = clause == KC_SELECT_CLAUSE_RECV ? kc_chan_wake_recv_locked(ch)
+                                                           : kc_chan_wake_send_locked(ch);
+        /* No coroutine to schedule: a blocked thread was signalled instead,
+         * unless the list ran dry. */
+        if (!w.co && !(clause == KC_SELECT_CLAUSE_RECV ? ch->wq_recv_head : ch->wq_send_head)) break;
+        kc_wake_list_append(wakes, w);
+    }
+}
+
+/* Copy n elements into (out of) the ring at tail (head); at most two runs. */
+static void kc_chan_ring_put_locked(struct kc_chan *ch, const unsigned char *src, size_t n)
+{
+    size_t first = ch->capacity - ch->tail;
+    if (first > n) first = n;
+    memcpy(ch->buf + ch->tail * ch->elem_sz, src, first * ch->elem_sz);
+    if (n > first) memcpy(ch->buf, src + first * ch->elem_sz, (n - first) * ch->elem_sz);
+    ch->tail = kc_ring_idx(ch, ch->tail + n);
+    ch->count += n;
+}
+
+static void kc_chan_ring_take_locked(struct kc_chan *ch, unsigned char *dst, size_t n)
+{
+    size_t first = ch->capacity - ch->head;
+    if (first > n) first = n;
+    memcpy(dst, ch->buf + ch->head * ch->elem_sz, first * ch->elem_sz);
+    if (n > first) memcpy(dst + first * ch->elem_sz, ch->buf, (n - first) * ch->elem_sz);
+    ch->head = kc_ring_idx(ch, ch->head + n);
+    ch->count -= n;
+    if (ch->count == 0 && ch->buf_map) kc_chan_buf_trim_locked(ch);
+}
+
+/* KC_UNLIMITED runs: one memcpy per segment touched. put links segments as
+ * needed and returns how many elements fit before an allocation (or, durable,
+ * a log append) failed; *err receives that failure. */
+static size_t kc_chan_seg_put_many_locked(struct kc_chan *ch, const unsigned char *src, size_t n, int *err)
+{
+    size_t done = 0;
+    *err = 0;
+    while (done < n) {
+        if ((!ch->seg_tail || ch->tail == ch->seg_elems) && (*err = kc_chan_seg_link_locked(ch)) != 0) break;
+        size_t k = ch->seg_elems - ch->tail;
+        if (k > n - done) k = n - done;
+        if (ch->wal) {
+            size_t logged;
+            *err = kc_chan_wal_append(ch->wal, src + done * ch->elem_sz, k, &logged);
+            k = logged;
+        }
+        memcpy(ch->seg_tail->data + ch->tail * ch->elem_sz, src + done * ch->elem_sz, k * ch->elem_sz);
+        ch->tail += k;
+        ch->count += k;
+        done += k;
+        if (*err) break;
+    }
+    return done;
+}
+
+static void kc_chan_seg_take_many_locked(struct kc_chan *ch, unsigned char *dst, size_t n)
+{
+    while (n) {
+        size_t end = ch->seg_head == ch->seg_tail ? ch->tail : ch->seg_elems;
+        size_t k = end - ch->head;
+        if (k > n) k = n;
+        memcpy(dst, ch->seg_head->data + ch->head * ch->elem_sz, k * ch->elem_sz);
+        ch->head += k;
+        ch->count -= k;
+        kc_chan_seg_advance_locked(ch);
+        dst += k * ch->elem_sz;
+        n -= k;
+    }
+}
+
+static size_t kc_chan_batch_bytes(const struct kc_chan *ch, const unsigned char *elems, size_t n)
+{
+    if (!ch->ptr_mode) return n * ch->elem_sz;
+    size_t bytes = 0;
+    const struct kc_chan_ptrmsg *m = (const struct kc_chan_ptrmsg*)(const void*)elems;
+    for (size_t i = 0; i < n; ++i) bytes += m[i].len & ZREF_LEN_MASK;
+    return bytes;
+}
+
+/* kc_chan_put_run/take_run traffic on a zref-bound channel. Once a
+ * descriptor holding a region reference is queued, copy ops and select stay
+ * off the queue: only the zref backend gives that reference back. */
+static void kc_chan_zref_note_locked(struct kc_chan *ch, int is_send, const unsigned char *elems, size_t n)
+{
+    if (!ch->zc_ops || !ch->ptr_mode) return;
+    if (!is_send) { ch->zref_received += n; return; }
+    ch->zref_sent += n;
+    const struct kc_chan_ptrmsg *m = (const struct kc_chan_ptrmsg*)(const void*)elems;
+    for (size_t i = 0; i < n && !ch->zref_mode; ++i)
+        if (m[i].len & ZREF_HELD) ch->zref_mode = 1;
+}
+
+static int kc_chan_batchable(const struct kc_chan *ch)
+{
+    return !ch->ring && !ch->delay && !ch->prio && !ch->zc_ops && !ch->zref_mode &&
+           ch->kind != KC_RENDEZVOUS && ch->kind != KC_CONFLATED;
+}
+
+/* Remaining budget for a per-element fallback call; KC_ETIME once spent. */
+static int kc_chan_batch_slice(long timeout_ms, long deadline_ns, long *slice_ms)
+{
+    if (timeout_ms <= 0) { *slice_ms = timeout_ms; return 0; }
+    long left = deadline_ns - kc_now_ns();
+    if (left <= 0) return KC_ETIME;
+    *slice_ms = (left + 999999L) / 1000000L;
+    return 0;
+}
+
+static int kc_chan_send_many_locked_path_body(struct kc_chan *ch, const unsigned char *src, size_t n,
+                                              long timeout_ms, size_t *sent, long *wait_t0)
+{
+    long deadline_ns = timeout_ms > 0 ? kc_now_ns() + timeout_ms * 1000000L : 0;
+    size_t done = 0;
+    int rc = 0;
+    while (done < n) {
+        KC_MUTEX_LOCK(&ch->mu);
+        if (ch->closed) { ch->send_epipe++; KC_MUTEX_UNLOCK(&ch->mu); rc = KC_EPIPE; break; }
+        const unsigned char *run = src + done * ch->elem_sz;
+        size_t k;
+        if (ch->kind == KC_UNLIMITED) {
+            int err;
+            k = kc_chan_seg_put_many_locked(ch, run, n - done, &err);
+            if (k == 0 && err != KC_EAGAIN) { KC_MUTEX_UNLOCK(&ch->mu); rc = err; break; }
+        } else {
+            k = ch->capacity - ch->count;
+            if (k > n - done) k = n - done;
+            if (k) kc_chan_ring_put_locked(ch, run, k);
+        }
+        if (k) kc_chan_lat_note_put_locked(ch, k);
+        if (k == 0) {
+            if (timeout_ms == 0) { ch->send_eagain++; KC_MUTEX_UNLOCK(&ch->mu); rc = KC_EAGAIN; break; }
+            if (timeout_ms > 0 && kc_now_ns() >= deadline_ns) {
+                ch->send_etime++; KC_MUTEX_UNLOCK(&ch->mu); rc = KC_ETIME; break;
+            }
+            if (ch->kind == KC_UNLIMITED) {   /* KC_MEM_CHAN backpressure */
+                KC_MUTEX_UNLOCK(&ch->mu);
+                kc_sleep_ms(1);
+                continue;
+            }
+            if (kc_chan_park_until_locked(ch, KC_SELECT_CLAUSE_SEND, deadline_ns, (struct kc_wake){0}, wait_t0)) { rc = KC_ECANCELED; break; }
+            continue;
+        }
+        kc_chan_update_stats_batch_locked(ch, 1, k, kc_chan_batch_bytes(ch, run, k));
+        kc_chan_zref_note_locked(ch, 1, run, k);
+        KC_COND_BROADCAST(&ch->cv_recv);
+        struct kc_wake_list wakes = {0};
+        if (!kc_chan_coalesce_hold_locked(ch, k)) kc_chan_wake_many_locked(ch, KC_SELECT_CLAUSE_RECV, k, &wakes);
+        kc_dbg("chan%p send_many +%zu cnt=%zu", (void*)ch, k, ch->count);
+        KC_MUTEX_UNLOCK(&ch->mu);
+        kc_wake_list_schedule(&wakes);
+        done += k;
+    }
+    *sent = done;
+    return rc;
+}
+
+static int kc_chan_send_many_locked_path(struct kc_chan *ch, const unsigned char *src, size_t n,
+                                         long timeout_ms, size_t *sent)
+{
+    long wait_t0 = 0;
+    int rc = kc_chan_send_many_locked_path_body(ch, src, n, timeout_ms, sent, &wait_t0);
+    kc_chan_lat_wait_end(ch, KC_SELECT_CLAUSE_SEND, wait_t0);
+    return rc;
+}
+
+static int kc_chan_recv_many_locked_path_body(struct kc_chan *ch, unsigned char *dst, size_t max,
+                                              long timeout_ms, size_t *got, long *wait_t0)
+{
+    long deadline_ns = timeout_ms > 0 ? kc_now_ns() + timeout_ms * 1000000L : 0;
+    int spun = 0;
+    for (;;) {
+        KC_MUTEX_LOCK(&ch->mu);
+        if (ch->count > 0) {
+            size_t k = ch->count < max ? ch->count : max;
+            kc_chan_lat_note_take_locked(ch, k);
+            if (ch->kind == KC_UNLIMITED) kc_chan_seg_take_many_locked(ch, dst, k);
+            else kc_chan_ring_take_locked(ch, dst, k);
+            if (ch->inbox_head) (void)kc_chan_inbox_fill_locked(ch);
+            kc_chan_update_stats_batch_locked(ch, 0, k, kc_chan_batch_bytes(ch, dst, k));
+            kc_chan_zref_note_locked(ch, 0, dst, k);
+            KC_COND_BROADCAST(&ch->cv_send);
+            struct kc_wake_list wakes = {0};
+            kc_chan_wake_many_locked(ch, KC_SELECT_CLAUSE_SEND, k, &wakes);
+            kc_dbg("chan%p recv_many -%zu cnt=%zu", (void*)ch, k, ch->count);
+            KC_MUTEX_UNLOCK(&ch->mu);
+            kc_wake_list_schedule(&wakes);
+            *got = k;
+            return 0;
+        }
+        if (ch->closed) { ch->recv_epipe++; KC_MUTEX_UNLOCK(&ch->mu); return KC_EPIPE; }
+        if (timeout_ms == 0) { ch->recv_eagain++; KC_MUTEX_UNLOCK(&ch->mu); return KC_EAGAIN; }
+        if (timeout_ms > 0 && kc_now_ns() >= deadline_ns) {
+            ch->recv_etime++; KC_MUTEX_UNLOCK(&ch->mu); return KC_ETIME;
+        }
+        if (!ch->coalesce_max && !spun++) {
+            KC_MUTEX_UNLOCK(&ch->mu);
+            (void)kc_chan_spin(ch, kc_chan_spin_probe_recv, NULL);
+            continue;
+        }
+        if (kc_chan_park_until_locked(ch, KC_SELECT_CLAUSE_RECV, deadline_ns, (struct kc_wake){0}, wait_t0)) return KC_ECANCELED;
+    }
+}
+
+static int kc_chan_recv_many_locked_path(struct kc_chan *ch, unsigned char *dst, size_t max,
+                                         long timeout_ms, size_t *got)
+{
+    long wait_t0 = 0;
+    int rc = kc_chan_recv_many_locked_path_body(ch, dst, max, timeout_ms, got, &wait_t0);
+    kc_chan_lat_wait_end(ch, KC_SELECT_CLAUSE_RECV, wait_t0);
+    return rc;
+}
+
+int kc_chan_put_run(struct kc_chan *ch, const void *elems, size_t n, long timeout_ms, size_t *done)
+{
+    *done = 0;
+    if (n == 0) return 0;
+    return kc_chan_send_many_locked_path(ch, elems, n, timeout_ms, done);
+}
+
+int kc_chan_take_run(struct kc_chan *ch, void *out, size_t max, long timeout_ms, size_t *got)
+{
+    *got = 0;
+    return kc_chan_recv_many_locked_path(ch, out, max, timeout_ms, got);
+}
+
+int kc_chan_send_many(kc_chan_t *c, const void *msgs, size_t n, long timeout_ms, size_t *sent)
+{
+    struct kc_chan *ch = (struct kc_chan*)c;
+    size_t done = 0;
+    if (sent) *sent = 0;
+    if (!ch || (!msgs && n)) return -EINVAL;
+    if (ch->zref_mode) return -EINVAL;
+    if (n == 0) return 0;
+    assert(kcoro_current() != NULL);
+    (void)kc_yield_if_needed();   /* slice safepoint */
+    int rc = 0;
+    if (kc_chan_batchable(ch)) {
+        long rec_t0 = KC_CHAN_REC_T0();
+        rc = kc_chan_send_many_locked_path(ch, msgs, n, timeout_ms, &done);
+        KC_CHAN_REC(ch, KC_CHAN_REC_SEND_MANY, rec_t0, done, done * ch->elem_sz, rc);
+    } else {
+        long deadline_ns = timeout_ms > 0 ? kc_now_ns() + timeout_ms * 1000000L : 0;
+        const unsigned char *src = msgs;
+        while (done < n) {
+            long slice;
+            if ((rc = kc_chan_batch_slice(timeout_ms, deadline_ns, &slice)) != 0) break;
+            if ((rc = kc_chan_send(c, src + done * ch->elem_sz, slice)) != 0) break;
+            done++;
+        }
+    }
+    if (sent) *sent = done;
+    return rc;
+}
+
+int kc_chan_recv_many(kc_chan_t *c, void *out, size_t max, long timeout_ms, size_t *got)
+{
+    struct kc_chan *ch = (struct kc_chan*)c;
+    size_t n = 0;
+    if (got) *got = 0;
+    if (!ch || !out || max == 0) return -EINVAL;
+    if (ch->ptr_mode) return -EINVAL; /* pointer descriptor channels use kc_chan_recv_ptr_many */
+    if (ch->zref_mode) return -EINVAL;
+    assert(kcoro_current() != NULL);
+    (void)kc_yield_if_needed();   /* slice safepoint */
+    int rc;
+    if (kc_chan_batchable(ch)) {
+        long rec_t0 = KC_CHAN_REC_T0();
+        rc = kc_chan_recv_many_locked_path(ch, out, max, timeout_ms, &n);
+        KC_CHAN_REC(ch, KC_CHAN_REC_RECV_MANY, rec_t0, n, n * ch->elem_sz, rc);
+    } else {
+        unsigned char *dst = out;
+        rc = kc_chan_recv(c, dst, timeout_ms);
+        if (rc == 0) {
+            n = 1;
+            while (n < max && kc_chan_recv(c, dst + n * ch->elem_sz, 0) == 0) n++;
+        }
+    }
+    if (got) *got = n;
+    return rc;
+}
+
+/* Batches from threads outside the scheduler: runs go in under one lock
+ * acquisition without waiting, and only a stalled batch sleeps, one element
+ * at a time on the thread waiter path, before batching again. */
+int kc_chan_send_many_thread(kc_chan_t *c, const void *msgs, size_t n, long timeout_ms, size_t *sent)
+{
+    struct kc_chan *ch = (struct kc_chan*)c;
+    size_t done = 0;
+    if (sent) *sent = 0;
+    if (!ch || (!msgs && n) || ch->ptr_mode || ch->zref_mode) return -EINVAL;
+    if (kcoro_current()) return kc_chan_send_many(c, msgs, n, timeout_ms, sent);
+    long deadline_ns = timeout_ms > 0 ? kc_now_ns() + timeout_ms * 1000000L : 0;
+    const unsigned char *src = msgs;
+    int rc = 0;
+    while (done < n) {
+        if (kc_chan_batchable(ch)) {
+            size_t k = 0;
+            long rec_t0 = KC_CHAN_REC_T0();
+            rc = kc_chan_send_many_locked_path(ch, src + done * ch->elem_sz, n - done, 0, &k);
+            KC_CHAN_REC(ch, KC_CHAN_REC_SEND_MANY, rec_t0, k, k * ch->elem_sz, rc);
+            done += k;
+            if (rc != KC_EAGAIN) break;
+        }
+        long slice;
+        if ((rc = kc_chan_batch_slice(timeout_ms, deadline_ns, &slice)) != 0) break;
+        if ((rc = kc_chan_thread_op(ch, (void*)(src + done * ch->elem_sz), slice, 1)) != 0) break;
+        done++;
+    }
+    if (sent) *sent = done;
+    return rc;
+}
+
+int kc_chan_recv_many_thread(kc_chan_t *c, void *out, size_t max, long timeout_ms, size_t *got)
+{
+    struct kc_chan *ch = (struct kc_chan*)c;
+    if (got) *got = 0;
+    if (!ch || !out || max == 0 || ch->ptr_mode || ch->zref_mode) return -EINVAL;
+    if (kcoro_current()) return kc_chan_recv_many(c, out, max, timeout_ms, got);
+    unsigned char *dst = out;
+    size_t n = 0;
+    int rc = KC_EAGAIN;
+    if (kc_chan_batchable(ch)) {
+        long rec_t0 = KC_CHAN_REC_T0();
+        rc = kc_chan_recv_many_locked_path(ch, dst, max, 0, &n);
+        KC_CHAN_REC(ch, KC_CHAN_REC_RECV_MANY, rec_t0, n, n * ch->elem_sz, rc);
+    }
+    if (rc == KC_EAGAIN && timeout_ms != 0) {
+        rc = kc_chan_thread_op(ch, dst, timeout_ms, 0);
+        if (rc == 0) n = 1;
+    }
+    /* Whatever else is already there, without waiting again */
+    if (rc == 0 && n < max) {
+        if (kc_chan_batchable(ch)) {
+            size_t k = 0;
+            long rec_t0 = KC_CHAN_REC_T0();
+            int more = kc_chan_recv_many_locked_path(ch, dst + n * ch->elem_sz, max - n, 0, &k);
+            KC_CHAN_REC(ch, KC_CHAN_REC_RECV_MANY, rec_t0, k, k * ch->elem_sz, more);
+            if (more == 0) n += k;
+        } else {
+            while (n < max && kc_chan_thread_op(ch, dst + n * ch->elem_sz, 0, 0) == 0) n++;
+        }
+    }
+    if (got) *got = n;
+    return rc;
+}
+
+int kc_chan_send_ptr_many(kc_chan_t *c, const struct kc_chan_ptrmsg *msgs, size_t n,
+                          long timeout_ms, size_t *sent)
+{
+    struct kc_chan *ch = (struct kc_chan*)c;
+    size_t done = 0;
+    if (sent) *sent = 0;
+    if (!ch || (!msgs && n)) return -EINVAL;
+    if (!ch->ptr_mode) return -EINVAL;
+    for (size_t i = 0; i < n; ++i)
+        if (!msgs[i].ptr || msgs[i].len == 0) return -EINVAL;
+    if (n == 0) return 0;
+    assert(kcoro_current() != NULL);
+    int rc = 0;
+    if (kc_chan_batchable(ch)) {
+        rc = kc_chan_send_many_locked_path(ch, (const unsigned char*)msgs, n, timeout_ms, &done);
+    } else {
+        long deadline_ns = timeout_ms > 0 ? kc_now_ns() + timeout_ms * 1000000L : 0;
+        while (done < n) {
+            long slice;
+            if ((rc = kc_chan_batch_slice(timeout_ms, deadline_ns, &slice)) != 0) break;
+            if ((rc = kc_chan_send_ptr(c, msgs[done].ptr, msgs[done].len, slice)) != 0) break;
+            done++;
+        }
+    }
+    if (sent) *sent = done;
+    return rc;
+}
+
+int kc_chan_recv_ptr_many(kc_chan_t *c, struct kc_chan_ptrmsg *out, size_t max,
+                          long timeout_ms, size_t *got)
+{
+    struct kc_chan *ch = (struct kc_chan*)c;
+    size_t n = 0;
+    if (got) *got = 0;
+    if (!ch || !out || max == 0) return -EINVAL;
+    if (!ch->ptr_mode) return -EINVAL;
+    assert(kcoro_current() != NULL);
+    int rc;
+    if (kc_chan_batchable(ch)) {
+        rc = kc_chan_recv_many_locked_path(ch, (unsigned char*)out, max, timeout_ms, &n);
+    } else {
+        rc = kc_chan_recv_ptr(c, &out[0].ptr, &out[0].len, timeout_ms);
+        if (rc == 0) {
+            n = 1;
+            while (n < max && kc_chan_recv_ptr(c, &out[n].ptr, &out[n].len, 0) == 0) n++;
+        }
+    }
+    if (got) *got = n;
+    return rc;
+}
+
+/* ---- Posted sends (kc_chan_post) ----------------------------------------
+ * A post pushes a node onto ch->inbox with one CAS. Only the poster that
+ * finds the inbox empty takes ch->mu: it moves everything pushed so far onto
+ * the inbox_head FIFO (taking the list under ch->mu keeps batches in order)
+ * and from there into the buffer, waking receivers. Elements that find the
+ * buffer full stay on inbox_head until a receive makes room. */
+
+size_t kc_chan_inbox_fill_locked(struct kc_chan *ch)
+{
+    size_t moved = 0;
+    struct kc_chan_inbox_node *n;
+    while ((n = ch->inbox_head) != NULL) {
+        if (ch->kind != KC_UNLIMITED && ch->count >= ch->capacity) break;
+        if (kc_chan_buf_put_locked(ch, n->data) != 0) break;   /* -ENOMEM: keep it */
+        kc_chan_update_send_stats_locked(ch);
+        ch->inbox_head = n->next;
+        if (!ch->inbox_head) ch->inbox_tail = NULL;
+        free(n);
+        moved++;
+    }
+    return moved;
+}
+
+int kc_chan_post(kc_chan_t *c, const void *msg)
+{
+    struct kc_chan *ch = (struct kc_chan*)c;
+    if (!ch || !msg || ch->ptr_mode || ch->zref_mode || ch->ring || ch->delay) return -EINVAL;
+    if (ch->kind == KC_RENDEZVOUS || ch->kind == KC_CONFLATED) return -EINVAL;
+    if (__atomic_load_n(&ch->closed, __ATOMIC_RELAXED)) return KC_EPIPE;
+    struct kc_chan_inbox_node *n = malloc(sizeof(*n) + ch->elem_sz);
+    if (!n) return -ENOMEM;
+    memcpy(n->data, msg, ch->elem_sz);
+    struct kc_chan_inbox_node *old = atomic_load_explicit(&ch->inbox, memory_order_relaxed);
+    do {
+        n->next = old;
+    } while (!atomic_compare_exchange_weak_explicit(&ch->inbox, &old, n,
+                                                    memory_order_release, memory_order_relaxed));
+    if (old) return 0;   /* the poster that found it empty moves it in */
+
+    KC_MUTEX_LOCK(&ch->mu);
+    struct kc_chan_inbox_node *lifo = atomic_exchange_explicit(&ch->inbox, NULL, memory_order_acquire);
+    if (ch->closed) {
+        /* Raced kc_chan_close: dropped, like a send that finds it closed. */
+        for (struct kc_chan_inbox_node *i = lifo; i; i = i->next) ch->send_epipe++;
+        KC_MUTEX_UNLOCK(&ch->mu);
+        kc_chan_inbox_free(lifo);
+        return 0;
+    }
+    struct kc_chan_inbox_node *fifo = NULL, *last = lifo;
+    while (lifo) {
+        struct kc_chan_inbox_node *next = lifo->next;
+        lifo->next = fifo;
+        fifo = lifo;
+        lifo = next;
+    }
+    if (ch->inbox_tail) ch->inbox_tail->next = fifo; else ch->inbox_head = fifo;
+    ch->inbox_tail = last;
+    size_t k = kc_chan_inbox_fill_locked(ch);
+    struct kc_wake_list wakes = {0};
+    if (k) {
+        KC_COND_BROADCAST(&ch->cv_recv);
+        if (!kc_chan_coalesce_hold_locked(ch, k)) kc_chan_wake_many_locked(ch, KC_SELECT_CLAUSE_RECV, k, &wakes);
+    }
+    KC_MUTEX_UNLOCK(&ch->mu);
+    kc_wake_list_schedule(&wakes);
+    return 0;
+}
@@ -0,0 +1,135 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/*
+ * kc_chan_delay.c — deadline-ordered store for KC_DELAYED channels (kcoro.h)
+ * --------------------------------------------------------------------------
+ *
+ * Layout
+ * - One flat array of fixed-stride entries, each a (due_ns, seq) key
+ *   followed by the payload copy, kept as a binary min-heap on the key.
+ *   Pushes and pops sift with a hole: the moving entry waits in a scratch
+ *   slot while the others shift, so each level costs one entry copy.
+ *
+ * Timing
+ * - The store only orders; it never arms timers. kc_chan.c asks for the
+ *   earliest due time and lets one parked receiver sleep until then on the
+ *   scheduler's timer wheel (kc_chan_park_until_locked), so a channel with
+ *   thousands of pending elements still holds at most one timer.
+ */
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "kc_chan_delay_internal.h"
+#include "../../include/kc_mem.h"
+
+#define KC_CHAN_DELAY_INIT_CAP 16
+
+struct kc_chan_delay_key {
+    long          due_ns;
+    unsigned long seq;
+};
+
+struct kc_chan_delay {
+    unsigned char *slots;     /* cap entries of stride bytes */
+    unsigned char *scratch;   /* one entry: the element being sifted */
+    size_t         stride;
+    size_t         elem_sz;
+    size_t         len, cap;
+    unsigned long  next_seq;
+};
+
+static inline unsigned char *kc_delay_at(const struct kc_chan_delay *d, size_t i)
+{
+    return d->slots + i * d->stride;
+}
+
+static inline int kc_delay_before(const unsigned char *a, const unsigned char *b)
+{
+    const struct kc_chan_delay_key *ka = (const struct kc_chan_delay_key*)(const void*)a;
+    const struct kc_chan_delay_key *kb = (const struct kc_chan_delay_key*)(const void*)b;
+    return ka->due_ns < kb->due_ns || (ka->due_ns == kb->due_ns && ka->seq < kb->seq);
+}
+
+int kc_chan_delay_create(struct kc_chan_delay **out, size_t elem_sz, size_t cap_hint)
+{
+    struct kc_chan_delay *d = calloc(1, sizeof(*d));
+    if (!d) return -ENOMEM;
+    d->elem_sz = elem_sz;
+    d->stride = (sizeof(struct kc_chan_delay_key) + elem_sz + sizeof(long) - 1) & ~(sizeof(long) - 1);
+    d->cap = cap_hint ? cap_hint : KC_CHAN_DELAY_INIT_CAP;
+    if (kc_mem_charge(KC_MEM_CHAN, (d->cap + 1) * d->stride) != 0) { free(d); return -ENOMEM; }
+    d->slots = malloc(d->cap * d->stride);
+    d->scratch = malloc(d->stride);
+    if (!d->slots || !d->scratch) {
+        kc_mem_uncharge(KC_MEM_CHAN, (d->cap + 1) * d->stride);
+        free(d->slots);
+        free(d->scratch);
+        free(d);
+        return -ENOMEM;
+    }
+    *out = d;
+    return 0;
+}
+
+void kc_chan_delay_destroy(struct kc_chan_delay *d)
+{
+    if (!d) return;
+    kc_mem_uncharge(KC_MEM_CHAN, (d->cap + 1) * d->stride);
+    free(d->slots);
+    free(d->scratch);
+    free(d);
+}
+
+static int kc_delay_grow(struct kc_chan_delay *d)
+{
+    size_t cap = d->cap * 2;
+    if (kc_mem_charge(KC_MEM_CHAN, (cap - d->cap) * d->stride) != 0) return -ENOMEM;
+    unsigned char *s = realloc(d->slots, cap * d->stride);
+    if (!s) { kc_mem_uncharge(KC_MEM_CHAN, (cap - d->cap) * d->stride); return -ENOMEM; }
+    d->slots = s;
+    d->cap = cap;
+    return 0;
+}
+
+int kc_chan_delay_push(struct kc_chan_delay *d, const void *elem, long due_ns)
+{
+    if (d->len == d->cap && kc_delay_grow(d) != 0) return -ENOMEM;
+    struct kc_chan_delay_key key = { .due_ns = due_ns > 0 ? due_ns : 1, .seq = d->next_seq++ };
+    memcpy(d->scratch, &key, sizeof(key));
+    memcpy(d->scratch + sizeof(key), elem, d->elem_sz);
+    size_t i = d->len++;
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (!kc_delay_before(d->scratch, kc_delay_at(d, parent))) break;
+        memcpy(kc_delay_at(d, i), kc_delay_at(d, parent), d->stride);
+        i = parent;
+    }
+    memcpy(kc_delay_at(d, i), d->scratch, d->stride);
+    return 0;
+}
+
+long kc_chan_delay_next(const struct kc_chan_delay *d)
+{
+    return d->len ? ((const struct kc_chan_delay_key*)(const void*)d->slots)->due_ns : 0;
+}
+
+int kc_chan_delay_pop_due(struct kc_chan_delay *d, void *out, long now_ns)
+{
+    long due = kc_chan_delay_next(d);
+    if (!due || due > now_ns) return 0;
+    memcpy(out, d->slots + sizeof(struct kc_chan_delay_key), d->elem_sz);
+    if (--d->len == 0) return 1;
+    /* Sift the last entry down from the root. */
+    memcpy(d->scratch, kc_delay_at(d, d->len), d->stride);
+    size_t i = 0;
+    for (;;) {
+        size_t child = 2 * i + 1;
+        if (child >= d->len) break;
+        if (child + 1 < d->len && kc_delay_before(kc_delay_at(d, child + 1), kc_delay_at(d, child))) child++;
+        if (!kc_delay_before(kc_delay_at(d, child), d->scratch)) break;
+        memcpy(kc_delay_at(d, i), kc_delay_at(d, child), d->stride);
+        i = child;
+    }
+    memcpy(kc_delay_at(d, i), d->scratch, d->stride);
+    return 1;
+}
@@ -0,0 +1,24 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+/* Deadline-ordered store behind KC_DELAYED channels (kc_chan_delay.c).
+ *
+ * A binary min-heap of (due_ns, seq, payload) entries; seq breaks ties so
+ * elements due at the same time leave in send order. kc_chan.c keeps
+ * ch->count equal to the number stored and calls everything under the
+ * owning ch->mu. Storage grows by doubling and is charged to KC_MEM_CHAN. */
+
+#include <stddef.h>
+
+struct kc_chan_delay;
+
+/* Room for cap_hint elements up front (0: a small default). 0 or -ENOMEM. */
+int  kc_chan_delay_create(struct kc_chan_delay **out, size_t elem_sz, size_t cap_hint);
+void kc_chan_delay_destroy(struct kc_chan_delay *d);
+
+/* Queue a copy of elem due at due_ns (kc_now_ns clock). 0 or -ENOMEM. */
+int  kc_chan_delay_push(struct kc_chan_delay *d, const void *elem, long due_ns);
+/* Due time of the earliest element; 0 when empty. */
+long kc_chan_delay_next(const struct kc_chan_delay *d);
+/* Move the earliest element to out if it is due at now_ns; 1 when taken. */
+int  kc_chan_delay_pop_due(struct kc_chan_delay *d, void *out, long now_ns);
@@ -7,15 +7,64 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdatomic.h>
 #include "../../include/kcoro_port.h"
 #include "../../include/kcoro.h"
+#include "../../include/kcoro_sched.h"
+#include "kc_ticket_internal.h"
+#include "kc_chan_spill_internal.h"
+#include "kc_chan_wal_internal.h"
+#include "kc_chan_delay_internal.h"
+#include "kc_chan_prio_internal.h"
+#include "kc_clock_internal.h"
 /* forward decl to avoid including kcoro_zcopy.h here */
 struct kc_zcopy_backend_ops;
+/* Latency histograms and enqueue stamps (kc_chan.c) */
+struct kc_chan_lat;
 
 /* Internal channel structure and helpers shared between kc_chan.c and kc_zcopy.c.
  * Not part of the public API surface. */
 
-enum kc_waiter_kind { KC_WAITER_CORO=0, KC_WAITER_SELECT=1 };
+/* Waiter lifetime checks (magic/double-dispose) exist only in debug builds;
+ * `make DEBUG=1` defines KCORO_DEBUG_BUILD. */
+#ifndef KCORO_DEBUG_BUILD
+#define KCORO_DEBUG_BUILD 0
+#endif
+
+/* KC_WAITER_THREAD: a kc_chan_send_thread / kc_chan_recv_thread caller
+ * blocked on its own condvar. The waiter lives on that thread's stack;
+ * disposing it (whoever pops it) sets *handoff_done and signals thread_cv
+ * instead of freeing it.
+ *
+ * Wait queues are intrusive and doubly linked, and a queued waiter records
+ * the list it is on (q_head/q_tail, NULL once popped), so registering and
+ * unlinking one are O(1) under ch->mu whatever the queue length. A
+ * KC_WAITER_SELECT waiter belongs to its clause (clause->waiter): a peer
+ * that pops it, or skips it because the select already resolved, only
+ * unlinks it, and kc_chan_select_cancel reaps it with the select's other
+ * registrations. */
+enum kc_waiter_kind { KC_WAITER_CORO=0, KC_WAITER_SELECT=1, KC_WAITER_THREAD=2 };
+
+/* A peer to wake once ch->mu is dropped (kc_chan.c). */
+struct kc_wake {
+    kcoro_t *co;
+    kc_select_t *sel;
+    int lane;              /* ch->wake_lane of the waking channel */
+    int home;              /* send it to its last worker (kc_chan_set_affinity) */
+};
+
+/* Timed park of a coroutine waiter (kc_chan.c). It is kept in the waiter,
+ * not on the coroutine's stack: the release hook reads it once the
+ * coroutine has switched out and wake coalescing rewrites its timer while
+ * it is parked, when a shared stack holds another coroutine's frames.
+ * sched is NULL unless the waiter is parked this way. */
+struct kc_chan_timed_park {
+    struct kc_chan *ch;
+    kc_sched_t *sched;
+    long deadline_ns;
+    kc_timer_handle_t timer;
+    struct kc_wake wake;   /* peer to wake once the lock is dropped */
+};
 struct kc_waiter {
     enum kc_waiter_kind kind;
     kcoro_t *co;
@@ -23,64 +72,205 @@ struct kc_waiter {
     int clause_index;
     enum kc_select_clause_kind clause_kind;
     int is_zref;
-    struct kc_waiter *next;
+    struct kc_waiter *next, *prev;
+    struct kc_waiter **q_head, **q_tail; /* the queue it is on; NULL when off */
+    /* Freed by the coroutine that queued it (kc_chan.c's parked and
+     * untimed waits), not by the peer that pops it: that peer only unlinks
+     * it, so the coroutine finds it intact whatever woke it. */
+    int owned;
+    /* Parked coroutine's timed-park record: wake coalescing pulls its
+     * timer in under ch->mu instead of popping it. */
+    struct kc_chan_timed_park park;
+#if KCORO_DEBUG_BUILD
     unsigned long magic;
     int freed;
+#endif
     void **recv_ptr_slot;
     size_t *recv_len_slot;
+    /* Handoff rendezvous receiver (parked): a sender copies straight into
+     * handoff_dst, sets *handoff_done and switches to it. */
+    void *handoff_dst;
+    int *handoff_done;
+    KC_COND_T *thread_cv;
 };
 
-enum kc_waiter_token_status {
-    KC_WAITER_TOKEN_INIT = 0,
-    KC_WAITER_TOKEN_ENQUEUED = 1,
+/* Lock-free bounded MPMC ring behind kc_chan_make_mpmc() (Vyukov-style).
+ * Cell seq == pos: free for the producer claiming pos; seq == pos + 1:
+ * filled for the consumer claiming pos. Producers and consumers only contend
+ * on their own cursor; ch->mu and the waiter lists are taken only to park or
+ * to wake a parked peer, which the *_waiting hints advertise. The hints are
+ * set under ch->mu before a waiter is queued and recomputed under ch->mu, so
+ * they may be stale-high but never stale-low.
+ *
+ * kc_chan_make_spsc() uses the same struct with spsc=1: the cells carry no
+ * seq (stride == elem_sz), enqueue_pos/dequeue_pos are plain tail/head
+ * published with release stores, and each side keeps a private copy of the
+ * other's cursor (cached_*) so it touches the peer's cache line only when
+ * the ring looks full or empty. Pushes done under ch->mu on behalf of a
+ * parked select waiter are safe because that waiter is the only producer
+ * (resp. consumer) and cannot touch the ring until it takes ch->mu to
+ * cancel its registrations. */
+#define KC_CHAN_CACHELINE 64
+
+struct kc_mpmc_cell {
+    _Atomic size_t  seq;
+    unsigned char   data[];
 };
 
-struct kc_waiter_token {
-    enum kc_waiter_token_status status;
+struct kc_mpmc_ring {
+    _Alignas(KC_CHAN_CACHELINE) _Atomic size_t enqueue_pos;
+    size_t          cached_dequeue; /* SPSC: producer's last view of dequeue_pos */
+    _Alignas(KC_CHAN_CACHELINE) _Atomic size_t dequeue_pos;
+    size_t          cached_enqueue; /* SPSC: consumer's last view of enqueue_pos */
+    /* read-mostly */
+    _Alignas(KC_CHAN_CACHELINE) size_t mask;
+    size_t          stride;       /* bytes per cell (seq + payload, padded; SPSC: payload) */
+    unsigned char  *cells;
+    int             spsc;         /* single producer / single consumer layout */
+    _Atomic int     closed;       /* mirrors ch->closed for the lock-free paths */
+    _Atomic int     recv_waiting;
+    _Atomic int     send_waiting;
+    _Atomic long    first_op_ns;
+    /* failure counters bumped without ch->mu, one line per side */
+    _Alignas(KC_CHAN_CACHELINE) _Atomic unsigned long send_eagain;
+    _Alignas(KC_CHAN_CACHELINE) _Atomic unsigned long recv_eagain;
 };
 
-static inline void kc_waiter_token_reset(struct kc_waiter_token *token)
-{
-    if (token) token->status = KC_WAITER_TOKEN_INIT;
-}
+/* Copy-mode KC_CONFLATED storage (ch->latest): a seqlock over two value
+ * buffers. state is version << KC_LATEST_VER_SHIFT plus the flags below;
+ * the current value lives in buf[version & 1]. A sender claims BUSY with a
+ * CAS, fills the other buffer and publishes version + 1 with FULL, so it
+ * never tears the value readers are copying. A sender that finds another
+ * one BUSY is superseded by it and returns at once: senders never wait.
+ * A receiver copies the current buffer and takes the value by clearing
+ * FULL with a CAS on the state it read; a publish in between changes the
+ * version and the copy is retried. ch->mu and the waiter lists serve only
+ * parked receivers, advertised through recv_waiting like the ring hints.
+ * Pointer channels keep ch->slot: zref sends need the displaced descriptor
+ * back to drop its hold. */
+#define KC_LATEST_BUSY      1u   /* a sender is filling the spare buffer */
+#define KC_LATEST_FULL      2u   /* buf[version & 1] holds an untaken value */
+#define KC_LATEST_CLOSED    4u   /* mirrors ch->closed: new sends fail */
+#define KC_LATEST_VER_SHIFT 3
 
-static inline int kc_waiter_token_is_enqueued(const struct kc_waiter_token *token)
-{
-    return token && token->status == KC_WAITER_TOKEN_ENQUEUED;
-}
+struct kc_chan_latest {
+    _Alignas(KC_CHAN_CACHELINE) _Atomic uint64_t state;
+    _Atomic int     recv_waiting;
+    _Atomic long    first_op_ns;
+    unsigned char  *buf;          /* 2 * elem_sz */
+    /* successful ops, bumped without ch->mu, one line per side */
+    _Alignas(KC_CHAN_CACHELINE) _Atomic unsigned long sends;
+    _Alignas(KC_CHAN_CACHELINE) _Atomic unsigned long recvs;
+};
 
-struct kc_chan {
-    KC_MUTEX_T mu;
-    KC_COND_T  cv_send;
-    KC_COND_T  cv_recv;
-    int             closed;
+/* KC_UNLIMITED storage: a FIFO of fixed-size segments. Growth links one
+ * more segment (O(1), nothing is copied); a drained head segment goes to a
+ * small per-channel cache (KCORO_UNLIMITED_SEG_CACHE) or back to malloc, so
+ * memory follows the backlog down after a burst. Under spill pressure
+ * (kc_chan_spill_internal.h) a full middle segment is replaced by a stub
+ * without data[] whose payload sits at spill_off in the channel's spill
+ * file; head and tail are always resident. */
+struct kc_chan_seg {
+    struct kc_chan_seg *next;
+    off_t               spill_off; /* -1: resident */
+    unsigned char       data[];
+};
+
+/* kc_chan_post: one posted element. Posters push onto ch->inbox (LIFO);
+ * under ch->mu the list is reversed onto the inbox_head FIFO, from which
+ * elements move into the buffer while it has room. */
+struct kc_chan_inbox_node {
+    struct kc_chan_inbox_node *next;
+    unsigned char              data[];
+};
 
+/* Laid out in cache-line sections so the two sides of a channel do not
+ * write each other's lines: read-mostly config (also read by the lock-free
+ * ring paths), the lock and state both sides touch, then producer-only and
+ * consumer-only fields with their counters. kc_chan_get_stats and
+ * kc_chan_snapshot combine the per-side values without ch->mu: each side's
+ * throughput counters sit behind a seqlock of their own (send_seq,
+ * recv_seq), bumped by the writer, who holds ch->mu anyway. Allocate with
+ * posix_memalign(KC_CHAN_CACHELINE). */
+struct kc_chan {
+    /* read-mostly: set at creation or when a backend/pipe is bound */
+    _Alignas(KC_CHAN_CACHELINE)
     int             kind;      /* enum kc_kind or >0 => buffered capacity */
+    int             ptr_mode;  /* 1 when elements are kc_chan_ptrmsg */
     size_t          elem_sz;
-    size_t          capacity;  /* elements */
     size_t          mask;      /* capacity-1 when capacity is power-of-two, else 0 */
-
-    /* ring buffer */
     unsigned char  *buf;       /* capacity * elem_sz */
-    size_t          head;      /* read index */
-    size_t          tail;      /* write index */
-    size_t          count;     /* elements in buffer */
+    size_t          buf_map;   /* bytes mmap'd for buf (large rings), 0 when malloc'd */
+    size_t          seg_elems; /* KC_UNLIMITED: elements per segment */
+    unsigned char  *slot;      /* rendezvous, pointer conflated: elem_sz */
+    /* Lock-free ring (kc_chan_make_mpmc/_spsc); NULL for mutex-protected channels.
+     * When set, elements live in the ring and buf/head/tail/count are unused. */
+    struct kc_mpmc_ring *ring;
+    unsigned        ring_stripes;   /* rings at ch->ring (kc_chan_make_striped), else 1 */
+    struct kc_chan_latest *latest;  /* copy-mode KC_CONFLATED; slot/has_value unused */
+    int             wake_lane;      /* kc_lane_t for coroutines this channel wakes */
+    int             handoff;        /* rendezvous: senders switch straight to parked receivers */
+    int             affinity;       /* KC_AFFINITY_*: where the coroutines it wakes resume */
+    unsigned        capabilities;   /* KC_CHAN_CAP_* bitmask */
+    int             zref_mode;      /* zero-copy engaged: copy ops and select refused */
+    /* Zero-copy backend binding (factory). When non-NULL, kc_chan routes
+     * zero-copy calls via these ops. The classic copy path remains when ops==NULL. */
+    const struct kc_zcopy_backend_ops *zc_ops; /* vtable */
+    void           *zc_priv;    /* backend per-channel state */
+    int             zc_backend_id; /* registry id */
+    struct kc_bufpool *zc_pool;    /* reported in kc_chan_get_zstats */
+    /* Metrics pipe */
+    struct kc_chan *metrics_pipe;
+    int             stats_level;      /* enum kc_chan_stats_level */
+    long            first_op_time_ns; /* written once */
+    /* kc_chan_set_latency: set once under mu, freed by kc_chan_destroy */
+    struct kc_chan_lat *_Atomic lat;
+    /* kc_chan_rec: recording generation << 32 | channel number in it */
+    _Atomic uint64_t rec_tag;
 
-    /* conflated */
-    unsigned char  *slot;      /* elem_sz */
-    int             has_value;
+    /* shared: the lock and what both sides change under it */
+    _Alignas(KC_CHAN_CACHELINE)
+    KC_MUTEX_T mu;
+    KC_COND_T  cv_send;
+    KC_COND_T  cv_recv;
+    int             closed;
+    int             has_value;  /* rendezvous, pointer conflated */
+    size_t          capacity;   /* elements; KC_UNLIMITED grows it */
+    size_t          count;      /* elements in buffer */
+    long            buf_trim_ns;    /* buf_map: when idle pages were last released */
+    struct kc_chan_seg *seg_cache;  /* drained segments kept for reuse */
+    unsigned        seg_cached;
+    struct kc_chan_seg *seg_before_tail; /* seg_tail's predecessor, NULL if tail is head */
+    struct kc_chan_spill *spill;    /* spill file, created on first spill */
+    struct kc_chan_wal *wal;        /* kc_chan_make_durable: log every put first */
+    struct kc_chan_delay *delay;    /* KC_DELAYED: deadline heap (kc_chan_delay.c) */
+    long            delay_armed_ns; /* due time a parked receiver has a timer for; 0: none */
+    struct kc_chan_prio *prio;      /* KC_PRIORITY: level lists over the slot pool */
+    /* kc_chan_post elements already taken off ch->inbox, waiting for room */
+    struct kc_chan_inbox_node *inbox_head, *inbox_tail;
+    /* kc_chan_set_coalesce: hold receiver wakes until coalesce_max puts or
+     * coalesce_delay_ns after the first (coalesce_first_ns) */
+    unsigned        coalesce_max;       /* 0: off */
+    long            coalesce_delay_ns;
+    size_t          coalesce_pending;   /* puts since the window opened */
+    long            coalesce_first_ns;
+    unsigned long   coalesce_held, coalesce_flushes;
+    /* Spin-before-park (KCORO_CHAN_SPIN_NS): this channel's budget (0 until
+     * first used) and outcomes; atomic builtins, ring ops spin without mu */
+    long            spin_ns;
+    unsigned long   spin_wins, spin_parks;
 
-    /* waiter counters (best-effort hints) */
+    /* ops blocked right now (kc_chan_lat_wait_begin/end, atomic builtins) */
     unsigned        waiters_send;
     unsigned        waiters_recv;
-
     /* Cooperative wait queues (used by select or park) */
     struct kc_waiter *wq_send_head, *wq_send_tail;
     struct kc_waiter *wq_recv_head, *wq_recv_tail;
+    /* Pointer channels: send_ptr / recv_ptr calls parked on tickets */
+    struct kc_ticket_queue tq_send, tq_recv;
+    /* Readiness sets watching this channel (kc_chan_set.c) */
+    struct kc_chan_set_member *set_members;
 
-    /* Capabilities */
-    unsigned        capabilities;   /* KC_CHAN_CAP_* bitmask */
-    int             zref_mode;      /* rendezvous zero-copy engaged */
     /* rendezvous zref scratch */
     void           *zref_ptr;
     size_t          zref_len;
@@ -91,49 +281,53 @@ struct kc_chan {
     /* zref counters */
     unsigned long   zref_sent, zref_received, zref_fallback_small, zref_fallback_capacity,
                     zref_canceled, zref_aborted_close;
+    /* Rendezvous metrics */
+    unsigned long   rv_matches;
+    unsigned long   rv_cancels;
+    unsigned long   rv_zdesc_matches;
 
-    /* Throughput statistics */
-    unsigned long   total_sends, total_recvs;
-    unsigned long   total_bytes_sent, total_bytes_recv;
-    long            first_op_time_ns, last_op_time_ns;
+    /* producer side */
+    _Alignas(KC_CHAN_CACHELINE)
+    size_t          tail;      /* write index; KC_UNLIMITED: into seg_tail */
+    struct kc_chan_seg *seg_tail;
+    _Atomic unsigned send_seq;  /* odd while total_sends..last_send_ns change */
+    unsigned long   total_sends, total_bytes_sent;
+    long            last_send_ns;
+    unsigned long   send_eagain, send_etime, send_epipe;
+    /* kc_chan_post pushes, lock-free */
+    struct kc_chan_inbox_node *_Atomic inbox;
 
-    /* Metrics pipe */
-    struct kc_chan *metrics_pipe;
+    /* consumer side */
+    _Alignas(KC_CHAN_CACHELINE)
+    size_t          head;      /* read index; KC_UNLIMITED: into seg_head */
+    struct kc_chan_seg *seg_head;
+    _Atomic unsigned recv_seq;  /* odd while total_recvs..last_recv_ns change */
+    unsigned long   total_recvs, total_bytes_recv;
+    long            last_recv_ns;
+    unsigned long   recv_eagain, recv_etime, recv_epipe;
+
+    /* metrics sampler state (g_metrics_mu for the links, ch->mu for the rest) */
+    _Alignas(KC_CHAN_CACHELINE)
+    struct kc_chan *metrics_next, *metrics_prev;
+    int             metrics_linked;
     unsigned long   last_emit_sends, last_emit_recvs;
     unsigned long   last_emit_bytes_sent, last_emit_bytes_recv;
     long            last_emit_time_ns;
+};
 
-    /* Failure counters */
-    unsigned long   send_eagain, send_etime, send_epipe;
-    unsigned long   recv_eagain, recv_etime, recv_epipe;
-
-    /* Emission cost control */
-    unsigned long   ops_since_emit_check, emit_check_mask;
-
-    /* Pointer-descriptor channel mode */
-    int             ptr_mode;  /* 1 when elements are kc_chan_ptrmsg */
-
-    /* Zero-copy backend binding (factory). When non-NULL, kc_chan routes
-     * zero-copy calls via these ops. The classic copy path remains when ops==NULL. */
-    const struct kc_zcopy_backend_ops *zc_ops; /* vtable */
-    void           *zc_priv;    /* backend per-channel state */
-    int             zc_backend_id; /* registry id */
+/* kc_chan_snapshot for a channel already in hand (kc_metrics.c scrapers):
+ * never takes ch->mu, so it never waits on the data path. */
+void kc_chan_peek_snapshot(struct kc_chan *ch, struct kc_chan_snapshot *out);
 
-    /* Rendezvous metrics */
-    unsigned long   rv_matches;
-    unsigned long   rv_cancels;
-    unsigned long   rv_zdesc_matches;
-};
+/* Time of the latest send or recv (ch->mu held). */
+static inline long kc_chan_last_op_ns(const struct kc_chan *ch)
+{
+    return ch->last_send_ns > ch->last_recv_ns ? ch->last_send_ns : ch->last_recv_ns;
+}
 
 static inline long kc_now_ns(void)
 {
-    struct timespec ts;
-#ifdef CLOCK_MONOTONIC
-    clock_gettime(CLOCK_MONOTONIC, &ts);
-#else
-    clock_gettime(CLOCK_REALTIME, &ts);
-#endif
-    return (long)ts.tv_sec * 1000000000L + ts.tv_nsec;
+    return (long)kc_clock_ns();
 }
 
 static inline size_t kc_ring_idx(const struct kc_chan *ch, size_t i)
@@ -141,15 +335,137 @@ static inline size_t kc_ring_idx(const struct kc_chan *ch, size_t i)
     return ch->mask ? (i & ch->mask) : (i % ch->capacity);
 }
 
+/* Element storage for buffered/unlimited channels (ch->mu held). Callers
+ * check fullness first; put returns -ENOMEM only when KC_UNLIMITED cannot
+ * allocate a segment. A NULL src leaves the slot unwritten, a NULL dst drops
+ * the element. Segment variants are defined in kc_chan.c. */
+int  kc_chan_seg_put_locked(struct kc_chan *ch, const void *src);
+void kc_chan_seg_take_locked(struct kc_chan *ch, void *dst);
+
+/* Queue-latency stamps for n elements just stored / about to be taken
+ * (ch->mu held, ch->lat set); the inline checks keep the off path a load. */
+void kc_chan_lat_put_locked(struct kc_chan *ch, size_t n);
+void kc_chan_lat_take_locked(struct kc_chan *ch, size_t n);
+static inline void kc_chan_lat_note_put_locked(struct kc_chan *ch, size_t n)
+{
+    if (atomic_load_explicit(&ch->lat, memory_order_relaxed)) kc_chan_lat_put_locked(ch, n);
+}
+static inline void kc_chan_lat_note_take_locked(struct kc_chan *ch, size_t n)
+{
+    if (atomic_load_explicit(&ch->lat, memory_order_relaxed)) kc_chan_lat_take_locked(ch, n);
+}
+
+/* prio: level on KC_PRIORITY channels, ignored by the other kinds. */
+/* Copy one element. 4, 8 and 16 bytes, most channels' payloads, get a
+ * fixed-size copy the compiler turns into a move or two; the rest call
+ * memcpy. */
+static inline void kc_chan_elem_copy(void *dst, const void *src, size_t elem_sz)
+{
+    switch (elem_sz) {
+    case 4:  memcpy(dst, src, 4); break;
+    case 8:  memcpy(dst, src, 8); break;
+    case 16: memcpy(dst, src, 16); break;
+    default: memcpy(dst, src, elem_sz); break;
+    }
+}
+
+static inline int kc_chan_buf_put_prio_locked(struct kc_chan *ch, const void *src, int prio)
+{
+    if (ch->kind == KC_UNLIMITED) {
+        int rc = kc_chan_seg_put_locked(ch, src);
+        if (rc == 0) kc_chan_lat_note_put_locked(ch, 1);
+        return rc;
+    }
+    if (ch->prio) {
+        kc_chan_prio_put(ch->prio, src, prio);
+    } else {
+        if (src) kc_chan_elem_copy(ch->buf + (ch->tail * ch->elem_sz), src, ch->elem_sz);
+        ch->tail = kc_ring_idx(ch, ch->tail + 1);
+    }
+    ch->count++;
+    kc_chan_lat_note_put_locked(ch, 1);
+    return 0;
+}
+
+static inline int kc_chan_buf_put_locked(struct kc_chan *ch, const void *src)
+{
+    return kc_chan_buf_put_prio_locked(ch, src, 0);
+}
+
+/* Move posted elements waiting in inbox_head into the room the buffer has
+ * (ch->mu held); returns how many moved. Defined in kc_chan.c. */
+size_t kc_chan_inbox_fill_locked(struct kc_chan *ch);
+/* A mapped ring just emptied: hand its pages back to the kernel, at most
+ * once per KCORO_CHAN_RING_TRIM_MS (ch->mu held). Defined in kc_chan.c. */
+void kc_chan_buf_trim_locked(struct kc_chan *ch);
+
+static inline void kc_chan_buf_take_locked(struct kc_chan *ch, void *dst)
+{
+    kc_chan_lat_note_take_locked(ch, 1);
+    if (ch->kind == KC_UNLIMITED) kc_chan_seg_take_locked(ch, dst);
+    else if (ch->prio) {
+        kc_chan_prio_take(ch->prio, dst);
+        ch->count--;
+    } else {
+        if (dst) kc_chan_elem_copy(dst, ch->buf + (ch->head * ch->elem_sz), ch->elem_sz);
+        ch->head = kc_ring_idx(ch, ch->head + 1);
+        if (--ch->count == 0 && ch->buf_map) kc_chan_buf_trim_locked(ch);
+    }
+    if (ch->inbox_head) (void)kc_chan_inbox_fill_locked(ch);
+}
+
 /* Stats helpers (defined in kc_chan.c) */
-void kc_chan_emit_metrics_if_needed(struct kc_chan *ch, long now);
+/* Readiness sets (kc_chan_set.c), all with ch->mu held. notify queues the
+ * channel on every set watching one of `events` (KC_CHAN_SET_*); detach
+ * drops the memberships of a channel being destroyed. The rest live in
+ * kc_chan.c: the events the channel is ready for now, and the hook run when
+ * its membership list changed. */
+void     kc_chan_set_notify_locked(struct kc_chan *ch, unsigned events);
+void     kc_chan_set_detach_locked(struct kc_chan *ch);
+unsigned kc_chan_ready_events_locked(struct kc_chan *ch);
+void     kc_chan_set_members_changed_locked(struct kc_chan *ch);
+static inline void kc_chan_set_note_locked(struct kc_chan *ch, unsigned events)
+{
+    if (ch->set_members) kc_chan_set_notify_locked(ch, events);
+}
+
 void kc_chan_update_send_stats_len_locked(struct kc_chan *ch, size_t len);
 void kc_chan_update_recv_stats_len_locked(struct kc_chan *ch, size_t len);
 
+/* kc_chan_destroy: drop the region references of zref descriptors still
+ * queued (kc_zcopy.c). */
+void kc_zref_chan_drop(struct kc_chan *ch);
+
+/* Queued zref descriptors (struct kc_chan_ptrmsg) whose payload holds a
+ * region reference carry this bit in len until a receiver drops it. */
+#define ZREF_HELD ((size_t)1 << (sizeof(size_t) * 8 - 1))
+/* ptr is a kc_ziov_t and len the total of its segments; with ZREF_HELD the
+ * references are the ones kc_ziov_t::held records. */
+#define ZREF_IOV  ((size_t)1 << (sizeof(size_t) * 8 - 2))
+/* The payload byte count of a stored len. */
+#define ZREF_LEN_MASK (~(ZREF_HELD | ZREF_IOV))
+
+/* Buffered/unlimited batch moves (kc_chan.c) for the zref backend's queued
+ * descriptors: the kc_chan_send_many/recv_many paths without their
+ * copy-mode checks, parking on full/empty like them. put stores up to n
+ * elements (*done of them before an error); take returns as soon as it
+ * took any. Counted as zref traffic; a ZREF_HELD element sets zref_mode. */
+int kc_chan_put_run(struct kc_chan *ch, const void *elems, size_t n, long timeout_ms, size_t *done);
+int kc_chan_take_run(struct kc_chan *ch, void *out, size_t max, long timeout_ms, size_t *got);
+
+/* Waiter storage: per-thread freelists (defined in kc_chan.c). Waiters are
+ * recycled on whichever thread disposes them; each cache is bounded and
+ * released when its thread exits. */
+struct kc_waiter* kc_waiter_alloc(void);
+void kc_waiter_free(struct kc_waiter *w);
+
+#define KC_WAITER_MAGIC      0xCAFEBABEUL
+#define KC_WAITER_MAGIC_DEAD 0xDEADDEADUL
+
 /* Waiter helpers (shared by core and zcopy backends) */
 static inline struct kc_waiter* kc_waiter_new_coro(enum kc_select_clause_kind kind)
 {
-    struct kc_waiter *w = (struct kc_waiter*)malloc(sizeof(*w));
+    struct kc_waiter *w = kc_waiter_alloc();
     if (!w) return NULL;
     w->kind = KC_WAITER_CORO;
     w->co = kcoro_current();
@@ -158,54 +474,95 @@ static inline struct kc_waiter* kc_waiter_new_coro(enum kc_select_clause_kind ki
     w->clause_index = -1;
     w->clause_kind = kind;
     w->is_zref = 0;
-    w->next = NULL;
-    w->magic = 0xCAFEBABEUL;
+    w->next = w->prev = NULL;
+    w->q_head = w->q_tail = NULL;
+    w->owned = 0;
+    w->park.sched = NULL;
+#if KCORO_DEBUG_BUILD
+    w->magic = KC_WAITER_MAGIC;
     w->freed = 0;
+#endif
     w->recv_ptr_slot = NULL;
     w->recv_len_slot = NULL;
+    w->handoff_dst = NULL;
+    w->handoff_done = NULL;
+    w->thread_cv = NULL;
     return w;
 }
 
 static inline void kc_waiter_append(struct kc_waiter **head, struct kc_waiter **tail, struct kc_waiter *w)
 {
+    w->next = NULL;
+    w->prev = *tail;
     if (*tail) (*tail)->next = w; else *head = w;
     *tail = w;
+    w->q_head = head;
+    w->q_tail = tail;
+}
+
+static inline void kc_waiter_push_front(struct kc_waiter **head, struct kc_waiter **tail, struct kc_waiter *w)
+{
+    w->prev = NULL;
+    w->next = *head;
+    if (*head) (*head)->prev = w; else *tail = w;
+    *head = w;
+    w->q_head = head;
+    w->q_tail = tail;
+}
+
+/* Take w off the queue it is on, if any (ch->mu held). O(1). */
+static inline void kc_waiter_unlink(struct kc_waiter *w)
+{
+    if (!w->q_head) return;
+    if (w->prev) w->prev->next = w->next; else *w->q_head = w->next;
+    if (w->next) w->next->prev = w->prev; else *w->q_tail = w->prev;
+    w->next = w->prev = NULL;
+    w->q_head = w->q_tail = NULL;
 }
 
 static inline struct kc_waiter* kc_waiter_pop(struct kc_waiter **head, struct kc_waiter **tail)
 {
+    (void)tail;
     struct kc_waiter *w = *head;
-    if (!w) return NULL;
-    *head = w->next;
-    if (!*head) *tail = NULL;
-    w->next = NULL;
+    if (w) kc_waiter_unlink(w);
     return w;
 }
 
-/* Dispose a waiter exactly once; logs if double-disposed in dev runs. */
-static inline void kc_waiter_dispose(struct kc_waiter *w)
+/* Free a waiter; debug builds log double-dispose and bad magic. */
+static inline void kc_waiter_destroy(struct kc_waiter *w)
 {
-    if (!w) return;
+#if KCORO_DEBUG_BUILD
     if (w->freed) {
-        const char *dbg = getenv("KCORO_DEBUG");
-        if (dbg && *dbg && dbg[0] != '0') {
-            fprintf(stderr, "[kcoro][waiter] double-dispose w=%p kind=%d clause=%d magic=%lx\n",
-                    (void*)w, w->kind, w->clause_kind, w->magic);
-        }
+        fprintf(stderr, "[kcoro][waiter] double-dispose w=%p kind=%d clause=%d magic=%lx\n",
+                (void*)w, w->kind, w->clause_kind, w->magic);
         return;
     }
-    if (w->magic != 0xCAFEBABEUL) {
-        const char *dbg = getenv("KCORO_DEBUG");
-        if (dbg && *dbg && dbg[0] != '0') {
-            fprintf(stderr, "[kcoro][waiter] bad magic before free w=%p magic=%lx\n",
-                    (void*)w, w->magic);
-        }
+    if (w->magic != KC_WAITER_MAGIC) {
+        fprintf(stderr, "[kcoro][waiter] bad magic before free w=%p magic=%lx\n",
+                (void*)w, w->magic);
     }
+    w->freed = 1;
+    w->magic = KC_WAITER_MAGIC_DEAD;
+#endif
     if (w->co) {
         kcoro_release(w->co);
         w->co = NULL;
     }
-    w->freed = 1;
-    w->magic = 0xDEADDEADUL;
-    free(w);
+    kc_waiter_free(w);
+}
+
+/* Done with a popped waiter, exactly once: signals a blocked thread, leaves
+ * a select waiter to its clause and an owned one to its coroutine, frees the
+ * rest. */
+static inline void kc_waiter_dispose(struct kc_waiter *w)
+{
+    if (!w) return;
+    if (w->kind == KC_WAITER_THREAD) {
+        *w->handoff_done = 1;
+        KC_COND_SIGNAL(w->thread_cv);
+        return;
+    }
+    if (w->kind == KC_WAITER_SELECT) return; /* reaped by kc_chan_select_cancel */
+    if (w->owned) return;
+    kc_waiter_destroy(w);
 }
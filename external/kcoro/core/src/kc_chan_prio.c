@@ -0,0 +1,110 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/*
+ * kc_chan_prio.c — bucketed store for KC_PRIORITY channels (kcoro.h)
+ * ------------------------------------------------------------------
+ *
+ * Layout
+ * - One slot array sized to the channel capacity and a parallel array of
+ *   next-slot links. Free slots form a stack; each level is a FIFO of slot
+ *   indices with its own head, tail and depth. Levels share the pool, so a
+ *   burst at one level can use all of it and no level reserves room.
+ *
+ * Lookup
+ * - Bit L of `nonempty` is set while level L holds elements: the highest
+ *   level is one count-leading-zeros away, independent of depth.
+ */
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../include/kcoro.h"
+#include "../../include/kc_mem.h"
+#include "kc_chan_prio_internal.h"
+
+#define KC_PRIO_NIL UINT32_MAX
+
+struct kc_chan_prio {
+    unsigned char *slots;
+    uint32_t      *next;
+    size_t         elem_sz;
+    size_t         capacity;
+    uint32_t       free_head;
+    unsigned       nonempty;
+    uint32_t       head[KC_CHAN_PRIO_LEVELS];
+    uint32_t       tail[KC_CHAN_PRIO_LEVELS];
+    size_t         depth[KC_CHAN_PRIO_LEVELS];
+};
+
+_Static_assert(KC_CHAN_PRIO_LEVELS <= 32, "level bitmap is an unsigned");
+
+static size_t kc_prio_bytes(size_t elem_sz, size_t capacity)
+{
+    return capacity * (elem_sz + sizeof(uint32_t));
+}
+
+int kc_chan_prio_create(struct kc_chan_prio **out, size_t elem_sz, size_t capacity)
+{
+    if (capacity >= KC_PRIO_NIL) return -EINVAL;
+    struct kc_chan_prio *p = calloc(1, sizeof(*p));
+    if (!p) return -ENOMEM;
+    if (kc_mem_charge(KC_MEM_CHAN, kc_prio_bytes(elem_sz, capacity)) != 0) { free(p); return -ENOMEM; }
+    p->slots = malloc(capacity * elem_sz);
+    p->next = malloc(capacity * sizeof(uint32_t));
+    if (!p->slots || !p->next) {
+        kc_mem_uncharge(KC_MEM_CHAN, kc_prio_bytes(elem_sz, capacity));
+        free(p->slots);
+        free(p->next);
+        free(p);
+        return -ENOMEM;
+    }
+    p->elem_sz = elem_sz;
+    p->capacity = capacity;
+    for (size_t i = 0; i < capacity; i++) p->next[i] = i + 1 < capacity ? (uint32_t)(i + 1) : KC_PRIO_NIL;
+    p->free_head = capacity ? 0 : KC_PRIO_NIL;
+    for (int l = 0; l < KC_CHAN_PRIO_LEVELS; l++) p->head[l] = p->tail[l] = KC_PRIO_NIL;
+    *out = p;
+    return 0;
+}
+
+void kc_chan_prio_destroy(struct kc_chan_prio *p)
+{
+    if (!p) return;
+    kc_mem_uncharge(KC_MEM_CHAN, kc_prio_bytes(p->elem_sz, p->capacity));
+    free(p->slots);
+    free(p->next);
+    free(p);
+}
+
+void kc_chan_prio_put(struct kc_chan_prio *p, const void *src, int level)
+{
+    uint32_t s = p->free_head;
+    p->free_head = p->next[s];
+    if (src) memcpy(p->slots + (size_t)s * p->elem_sz, src, p->elem_sz);
+    p->next[s] = KC_PRIO_NIL;
+    if (p->tail[level] == KC_PRIO_NIL) p->head[level] = s;
+    else p->next[p->tail[level]] = s;
+    p->tail[level] = s;
+    p->depth[level]++;
+    p->nonempty |= 1u << level;
+}
+
+void kc_chan_prio_take(struct kc_chan_prio *p, void *dst)
+{
+    int level = 31 - __builtin_clz(p->nonempty);
+    uint32_t s = p->head[level];
+    if (dst) memcpy(dst, p->slots + (size_t)s * p->elem_sz, p->elem_sz);
+    p->head[level] = p->next[s];
+    if (p->head[level] == KC_PRIO_NIL) {
+        p->tail[level] = KC_PRIO_NIL;
+        p->nonempty &= ~(1u << level);
+    }
+    p->depth[level]--;
+    p->next[s] = p->free_head;
+    p->free_head = s;
+}
+
+void kc_chan_prio_depths(const struct kc_chan_prio *p, size_t *out)
+{
+    for (int l = 0; l < KC_CHAN_PRIO_LEVELS; l++) out[l] = __atomic_load_n(&p->depth[l], __ATOMIC_RELAXED);
+}
@@ -0,0 +1,29 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+/* Bucketed store behind KC_PRIORITY channels (kc_chan_prio.c).
+ *
+ * KC_CHAN_PRIO_LEVELS FIFO lists threaded through one pool of capacity
+ * slots, plus a bitmap of the non-empty levels, so put and take are O(1)
+ * and the highest level wins. kc_chan.c keeps ch->count / ch->capacity as
+ * for KC_BUFFERED (the caller checks room and emptiness) and calls
+ * everything under the owning ch->mu. */
+
+#include <stddef.h>
+
+struct kc_chan_prio;
+
+/* Pool of capacity slots of elem_sz, charged to KC_MEM_CHAN. 0, -EINVAL
+ * (capacity past the slot index range) or -ENOMEM. */
+int  kc_chan_prio_create(struct kc_chan_prio **out, size_t elem_sz, size_t capacity);
+void kc_chan_prio_destroy(struct kc_chan_prio *p);
+
+/* Append a copy of src (NULL: leave the slot as is) to level; a slot must
+ * be free. */
+void kc_chan_prio_put(struct kc_chan_prio *p, const void *src, int level);
+/* Move the oldest element of the highest non-empty level to dst (NULL:
+ * drop it); the store must not be empty. */
+void kc_chan_prio_take(struct kc_chan_prio *p, void *dst);
+/* Queued elements per level (KC_CHAN_PRIO_LEVELS entries). Safe without
+ * ch->mu (relaxed loads); the levels need not add up to ch->count. */
+void kc_chan_prio_depths(const struct kc_chan_prio *p, size_t *out);
@@ -0,0 +1,330 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/*
+ * kc_chan_rec.c — channel traffic recorder
+ * ---------------------------------------
+ *
+ * Recording
+ * - Every thread that finishes a channel op while recording is on gets a
+ *   buffer of 32-byte kc_chan_rec records, allocated on its first op and
+ *   registered in a global list. Only the owner writes it: fill slot
+ *   head & mask, then publish head + 1 with a release store.
+ * - Unlike a kc_trace ring, a full buffer is never overwritten: the owner
+ *   takes g_mu and appends the unwritten records to the file before it
+ *   reuses their slots. kc_chan_rec_stop does the same for every buffer.
+ *   The file therefore holds each thread's records in order, with threads
+ *   interleaved in chunks; readers sort by time.
+ * - A channel gets its number and a KC_CHAN_REC_CHAN descriptor from the
+ *   first op that sees its rec_tag from an older recording (one CAS wins).
+ *
+ * Lifetime
+ * - kc_chan_rec_start bumps the generation; an owner that finds its buffer
+ *   from an older recording abandons it and attaches a fresh one. Abandoned
+ *   buffers and buffers of exited threads (written out first) are marked
+ *   dead and freed by the next start.
+ */
+#define _GNU_SOURCE 1
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "kcoro_config.h"
+#include "kcoro_core.h"
+#include "kc_chan_internal.h"
+#include "kc_chan_rec_internal.h"
+#include "kc_hist_internal.h" /* kc_sched_self_index */
+
+#define REC_MAX_EVENTS (1u << 24)
+
+struct kc_chan_rec_buf {
+    _Atomic uint64_t head;     /* records written in this buffer's recording */
+    _Atomic uint64_t flushed;  /* of those, written out or discarded (g_mu) */
+    uint64_t mask;
+    long t0_ns;                /* start of the recording */
+    unsigned gen;              /* recording this buffer belongs to */
+    uint16_t thread;
+    _Atomic int dead;          /* owner gone or moved on; freed by next start */
+    struct kc_chan_rec_buf *next;
+    struct kc_chan_rec recs[];
+};
+
+_Atomic int kc_chan_rec_on;
+
+static pthread_mutex_t g_mu = PTHREAD_MUTEX_INITIALIZER;
+static struct kc_chan_rec_buf *g_bufs;     /* g_mu */
+static _Atomic unsigned g_gen;
+static size_t g_events;                    /* g_mu */
+static int g_fd = -1;                      /* g_mu; -1 once stopped */
+static int g_err;                          /* g_mu: first write error */
+static long g_t0_ns;                       /* g_mu */
+static unsigned g_threads;                 /* g_mu */
+static unsigned long g_written, g_dropped; /* g_mu */
+static _Atomic uint32_t g_next_chan;
+static _Atomic unsigned long g_chans;
+static pthread_once_t g_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t g_key;
+
+static __thread struct kc_chan_rec_buf *tls_buf;
+static __thread unsigned tls_failed_gen;   /* allocation failed for this recording */
+
+static int rec_write(int fd, const void *p, size_t n)
+{
+    const char *c = (const char*)p;
+    while (n) {
+        ssize_t w = write(fd, c, n);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return errno;
+        }
+        if (w == 0) return EIO;
+        c += w;
+        n -= (size_t)w;
+    }
+    return 0;
+}
+
+/* Append b's unwritten records to the file; records of an older recording,
+ * or arriving after stop, are discarded. Caller holds g_mu. */
+static void rec_flush_locked(struct kc_chan_rec_buf *b)
+{
+    uint64_t head = atomic_load_explicit(&b->head, memory_order_acquire);
+    uint64_t f = atomic_load_explicit(&b->flushed, memory_order_relaxed);
+    if (f == head) return;
+    if (g_fd >= 0 && b->gen == atomic_load_explicit(&g_gen, memory_order_relaxed)) {
+        while (f < head && !g_err) {
+            uint64_t i = f & b->mask;
+            uint64_t n = head - f < b->mask + 1 - i ? head - f : b->mask + 1 - i;
+            g_err = rec_write(g_fd, &b->recs[i], (size_t)n * sizeof(b->recs[0]));
+            if (g_err) break;
+            f += n;
+            g_written += n;
+        }
+        g_dropped += head - f;
+    }
+    atomic_store_explicit(&b->flushed, head, memory_order_release);
+}
+
+static void rec_thread_exit(void *p)
+{
+    struct kc_chan_rec_buf *b = (struct kc_chan_rec_buf*)p;
+    pthread_mutex_lock(&g_mu);
+    rec_flush_locked(b);
+    pthread_mutex_unlock(&g_mu);
+    atomic_store_explicit(&b->dead, 1, memory_order_release);
+}
+
+static void rec_key_init(void)
+{
+    (void)pthread_key_create(&g_key, rec_thread_exit);
+}
+
+/* Next free slot of the owner's buffer, writing the buffer out when full. */
+static struct kc_chan_rec *rec_slot(struct kc_chan_rec_buf *b)
+{
+    uint64_t h = atomic_load_explicit(&b->head, memory_order_relaxed);
+    if (h - atomic_load_explicit(&b->flushed, memory_order_acquire) > b->mask) {
+        pthread_mutex_lock(&g_mu);
+        rec_flush_locked(b);
+        pthread_mutex_unlock(&g_mu);
+    }
+    struct kc_chan_rec *r = &b->recs[h & b->mask];
+    memset(r, 0, sizeof(*r));
+    r->thread = b->thread;
+    return r;
+}
+
+static void rec_publish(struct kc_chan_rec_buf *b)
+{
+    atomic_store_explicit(&b->head, atomic_load_explicit(&b->head, memory_order_relaxed) + 1,
+                          memory_order_release);
+}
+
+static uint64_t rec_offset(const struct kc_chan_rec_buf *b, long t)
+{
+    return t > b->t0_ns ? (uint64_t)(t - b->t0_ns) : 0;
+}
+
+static uint32_t rec_clamp32(size_t v)
+{
+    return v > UINT32_MAX ? UINT32_MAX : (uint32_t)v;
+}
+
+/* Slow path of kc_chan_rec_emit: give the calling thread a buffer in the
+ * current recording, or NULL when recording stopped or allocation failed. */
+static struct kc_chan_rec_buf *rec_attach(void)
+{
+    if (tls_failed_gen == atomic_load_explicit(&g_gen, memory_order_relaxed)) return NULL;
+    pthread_once(&g_key_once, rec_key_init);
+    pthread_mutex_lock(&g_mu);
+    unsigned gen = atomic_load_explicit(&g_gen, memory_order_relaxed);
+    struct kc_chan_rec_buf *old = tls_buf, *b = NULL;
+    if (old && old->gen == gen) { pthread_mutex_unlock(&g_mu); return old; }
+    if (atomic_load_explicit(&kc_chan_rec_on, memory_order_relaxed) && tls_failed_gen != gen) {
+        b = (struct kc_chan_rec_buf*)malloc(sizeof(*b) + g_events * sizeof(b->recs[0]));
+        if (b) {
+            atomic_init(&b->head, 0);
+            atomic_init(&b->flushed, 0);
+            b->mask = g_events - 1;
+            b->t0_ns = g_t0_ns;
+            b->gen = gen;
+            b->thread = (uint16_t)++g_threads;
+            atomic_init(&b->dead, 0);
+            b->next = g_bufs;
+            g_bufs = b;
+        } else {
+            tls_failed_gen = gen;
+        }
+    }
+    if (old) atomic_store_explicit(&old->dead, 1, memory_order_release);
+    tls_buf = b;
+    (void)pthread_setspecific(g_key, b);
+    pthread_mutex_unlock(&g_mu);
+    if (b) {
+        struct kc_chan_rec *r = rec_slot(b);
+        r->t_ns = rec_offset(b, kc_now_ns());
+        r->op = KC_CHAN_REC_THREAD;
+        r->count = (uint32_t)(kc_sched_self_index() + 1);
+        rec_publish(b);
+    }
+    return b;
+}
+
+/* ch's number in the current recording, recording its descriptor first
+ * when this op is the first to see it. */
+static uint32_t rec_chan(struct kc_chan_rec_buf *b, struct kc_chan *ch, long t0)
+{
+    uint64_t tag = atomic_load_explicit(&ch->rec_tag, memory_order_acquire);
+    while ((unsigned)(tag >> 32) != b->gen) {
+        uint32_t id = atomic_fetch_add_explicit(&g_next_chan, 1, memory_order_relaxed) + 1;
+        uint64_t mine = (uint64_t)b->gen << 32 | id;
+        if (!atomic_compare_exchange_strong_explicit(&ch->rec_tag, &tag, mine,
+                                                     memory_order_acq_rel, memory_order_acquire))
+            continue;
+        atomic_fetch_add_explicit(&g_chans, 1, memory_order_relaxed);
+        struct kc_chan_rec *r = rec_slot(b);
+        r->t_ns = rec_offset(b, t0);
+        r->chan = id;
+        r->count = rec_clamp32(ch->capacity);
+        r->bytes = rec_clamp32(ch->elem_sz);
+        r->co = ch->capabilities;
+        r->dur_ns = ch->ring_stripes;
+        r->op = KC_CHAN_REC_CHAN;
+        r->rc = (int8_t)ch->kind;
+        rec_publish(b);
+        return id;
+    }
+    return (uint32_t)tag;
+}
+
+void kc_chan_rec_emit(struct kc_chan *ch, enum kc_chan_rec_op op, long t0,
+                      size_t count, size_t bytes, int rc)
+{
+    if (!ch) return;
+    long t1 = kc_now_ns();
+    struct kc_chan_rec_buf *b = tls_buf;
+    if (__builtin_expect(!b || b->gen != atomic_load_explicit(&g_gen, memory_order_relaxed), 0)
+        && !(b = rec_attach()))
+        return;
+    uint32_t id = rec_chan(b, ch, t0);
+    kcoro_t *co = kcoro_current();
+    struct kc_chan_rec *r = rec_slot(b);
+    r->t_ns = rec_offset(b, t0);
+    r->dur_ns = rec_clamp32(t1 > t0 ? (size_t)(t1 - t0) : 0);
+    r->chan = id;
+    r->co = co ? (uint32_t)co->id : 0;
+    r->count = rec_clamp32(count);
+    r->bytes = rec_clamp32(bytes);
+    r->op = (uint8_t)op;
+    r->rc = (int8_t)(rc < INT8_MIN ? INT8_MIN : rc);
+    rec_publish(b);
+}
+
+int kc_chan_rec_start(const char *path, size_t events_per_thread)
+{
+    if (!path) return -EINVAL;
+    if (events_per_thread == 0) events_per_thread = KCORO_CHAN_REC_EVENTS;
+    if (events_per_thread > REC_MAX_EVENTS) return -EINVAL;
+    size_t cap = 16;
+    while (cap < events_per_thread) cap <<= 1;
+    pthread_mutex_lock(&g_mu);
+    if (atomic_load_explicit(&kc_chan_rec_on, memory_order_relaxed)) {
+        pthread_mutex_unlock(&g_mu);
+        return -EBUSY;
+    }
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        int err = errno;
+        pthread_mutex_unlock(&g_mu);
+        return -err;
+    }
+    long t0 = kc_now_ns();
+    struct kc_chan_rec_header hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, KC_CHAN_REC_MAGIC, sizeof(KC_CHAN_REC_MAGIC));
+    hdr.version = KC_CHAN_REC_VERSION;
+    hdr.rec_size = sizeof(struct kc_chan_rec);
+    hdr.start_ns = (uint64_t)t0;
+    int err = rec_write(fd, &hdr, sizeof(hdr));
+    if (err) {
+        close(fd);
+        pthread_mutex_unlock(&g_mu);
+        return -err;
+    }
+    struct kc_chan_rec_buf **pp = &g_bufs;
+    while (*pp) {
+        struct kc_chan_rec_buf *b = *pp;
+        if (atomic_load_explicit(&b->dead, memory_order_acquire)) { *pp = b->next; free(b); }
+        else pp = &b->next;
+    }
+    g_fd = fd;
+    g_err = 0;
+    g_events = cap;
+    g_t0_ns = t0;
+    g_threads = 0;
+    g_written = g_dropped = 0;
+    atomic_store_explicit(&g_next_chan, 0, memory_order_relaxed);
+    atomic_store_explicit(&g_chans, 0, memory_order_relaxed);
+    atomic_fetch_add_explicit(&g_gen, 1, memory_order_relaxed);
+    atomic_store_explicit(&kc_chan_rec_on, 1, memory_order_release);
+    pthread_mutex_unlock(&g_mu);
+    return 0;
+}
+
+int kc_chan_rec_stop(void)
+{
+    int rc = 0;
+    pthread_mutex_lock(&g_mu);
+    if (atomic_exchange_explicit(&kc_chan_rec_on, 0, memory_order_acq_rel)) {
+        unsigned gen = atomic_load_explicit(&g_gen, memory_order_relaxed);
+        for (struct kc_chan_rec_buf *b = g_bufs; b; b = b->next)
+            if (b->gen == gen) rec_flush_locked(b);
+        if (close(g_fd) != 0 && !g_err) g_err = errno;
+        g_fd = -1;
+        rc = g_err ? -g_err : 0;
+    }
+    pthread_mutex_unlock(&g_mu);
+    return rc;
+}
+
+int kc_chan_rec_active(void)
+{
+    return atomic_load_explicit(&kc_chan_rec_on, memory_order_relaxed);
+}
+
+void kc_chan_rec_get_stats(kc_chan_rec_stats_t *out)
+{
+    if (!out) return;
+    memset(out, 0, sizeof(*out));
+    pthread_mutex_lock(&g_mu);
+    unsigned gen = atomic_load_explicit(&g_gen, memory_order_relaxed);
+    for (struct kc_chan_rec_buf *b = g_bufs; b; b = b->next) {
+        if (b->gen != gen) continue;
+        out->events += atomic_load_explicit(&b->head, memory_order_acquire);
+        out->threads++;
+    }
+    out->written = g_written;
+    out->dropped = g_dropped;
+    out->channels = atomic_load_explicit(&g_chans, memory_order_relaxed);
+    pthread_mutex_unlock(&g_mu);
+}
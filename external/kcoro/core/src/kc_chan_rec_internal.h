@@ -0,0 +1,29 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <stddef.h>
+#include <stdatomic.h>
+#include "../../include/kcoro.h"
+
+/* Channel traffic recording (kc_chan_rec.c). An op takes its issue time
+ * with KC_CHAN_REC_T0, which is 0 while no recording runs (one relaxed
+ * load and a predicted branch), and passes it to KC_CHAN_REC on return;
+ * only ops that started during a recording are logged. Wrappers that end
+ * in another recorded entry point record nothing themselves. Needs
+ * kc_now_ns (kc_chan_internal.h). */
+struct kc_chan;
+
+extern _Atomic int kc_chan_rec_on;
+
+void kc_chan_rec_emit(struct kc_chan *ch, enum kc_chan_rec_op op, long t0,
+                      size_t count, size_t bytes, int rc);
+
+#define KC_CHAN_REC_T0()                                                        \
+    (__builtin_expect(atomic_load_explicit(&kc_chan_rec_on, memory_order_relaxed), 0) \
+         ? kc_now_ns() : 0L)
+
+#define KC_CHAN_REC(ch, op, t0, count, bytes, rc)                               \
+    do {                                                                        \
+        if (__builtin_expect((t0) != 0, 0))                                     \
+            kc_chan_rec_emit((ch), (op), (t0), (size_t)(count), (size_t)(bytes), (rc)); \
+    } while (0)
@@ -0,0 +1,347 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Readiness sets: many channels, one waiter.
+ *
+ * Each membership is linked twice: on its channel's set_members list
+ * (ch->mu) so a state change can find the sets watching it, and on the set's
+ * member list (set->mu). A state change queues the membership on the set's
+ * ready list unless it already is (the queued flag, so a busy channel costs
+ * one atomic load per op) and wakes a parked waiter. kc_chan_set_wait
+ * detaches the ready list, re-checks each channel and reports the ready
+ * ones; level-triggered memberships still ready go back on the list for the
+ * next wait.
+ *
+ * Lock order: ch->mu, then set->mu. The waiter parks with set->mu held and
+ * drops it in the park_release hook, so a notifier that finds it in
+ * set->waiter knows it is switched out. */
+#include <stdlib.h>
+#include <errno.h>
+#include <stdatomic.h>
+
+#include "../../include/kcoro.h"
+#include "../../include/kcoro_port.h"
+#include "../../include/kcoro_config.h"
+#include "../../include/kcoro_core.h"
+#include "../../include/kcoro_sched.h"
+#include "kc_chan_internal.h"
+#include "kc_cancel_internal.h"
+#include "kcoro_share_internal.h"
+
+struct kc_chan_set_member {
+    struct kc_chan_set *set;
+    struct kc_chan     *ch;        /* NULL once the channel was destroyed (set->mu) */
+    void               *user;
+    unsigned            events;    /* interest, | KC_CHAN_SET_EDGE */
+    atomic_int          queued;    /* on the ready list (written under set->mu) */
+    struct kc_chan_set_member *ch_next;              /* ch->set_members */
+    struct kc_chan_set_member *ready_next;           /* set->ready_head */
+    struct kc_chan_set_member *all_prev, *all_next;  /* set->all */
+};
+
+struct kc_chan_set {
+    KC_MUTEX_T mu;
+    struct kc_chan_set_member *ready_head, *ready_tail;
+    struct kc_chan_set_member *all;
+    kcoro_t            *waiter;   /* parked in kc_chan_set_wait */
+    kc_sched_t         *waiter_sched;
+    const kc_cancel_t  *cancel;
+};
+
+int kc_chan_set_create(kc_chan_set_t **out, const kc_cancel_t *cancel)
+{
+    if (!out) return -EINVAL;
+    struct kc_chan_set *set = calloc(1, sizeof(*set));
+    if (!set) return -ENOMEM;
+    KC_MUTEX_INIT(&set->mu);
+    set->cancel = cancel;
+    *out = set;
+    return 0;
+}
+
+/* set->mu held */
+static void kc_chan_set_queue_locked(struct kc_chan_set *set, struct kc_chan_set_member *m)
+{
+    if (atomic_load_explicit(&m->queued, memory_order_relaxed)) return;
+    atomic_store_explicit(&m->queued, 1, memory_order_relaxed);
+    m->ready_next = NULL;
+    if (set->ready_tail) set->ready_tail->ready_next = m; else set->ready_head = m;
+    set->ready_tail = m;
+}
+
+/* set->mu held; O(ready), only on remove */
+static void kc_chan_set_unqueue_locked(struct kc_chan_set *set, struct kc_chan_set_member *m)
+{
+    if (!atomic_load_explicit(&m->queued, memory_order_relaxed)) return;
+    struct kc_chan_set_member *prev = NULL;
+    for (struct kc_chan_set_member *cur = set->ready_head; cur; prev = cur, cur = cur->ready_next) {
+        if (cur != m) continue;
+        if (prev) prev->ready_next = m->ready_next; else set->ready_head = m->ready_next;
+        if (set->ready_tail == m) set->ready_tail = prev;
+        break;
+    }
+    atomic_store_explicit(&m->queued, 0, memory_order_relaxed);
+}
+
+/* Queue m and hand back the parked waiter to wake, if any (set->mu held). */
+static kcoro_t *kc_chan_set_signal_locked(struct kc_chan_set *set, struct kc_chan_set_member *m,
+                                          kc_sched_t **sched)
+{
+    kc_chan_set_queue_locked(set, m);
+    kcoro_t *co = set->waiter;
+    set->waiter = NULL;
+    *sched = set->waiter_sched;
+    return co;
+}
+
+static void kc_chan_set_wake(kcoro_t *co, kc_sched_t *s)
+{
+    if (!co) return;
+    kc_sched_enqueue_ready(s ? s : kc_sched_default(), co);
+}
+
+void kc_chan_set_notify_locked(struct kc_chan *ch, unsigned events)
+{
+    for (struct kc_chan_set_member *m = ch->set_members; m; m = m->ch_next) {
+        if (!(m->events & events) && !(events & KC_CHAN_SET_CLOSED)) continue;
+        if (atomic_load_explicit(&m->queued, memory_order_relaxed)) continue;
+        struct kc_chan_set *set = m->set;
+        kc_sched_t *s = NULL;
+        KC_MUTEX_LOCK(&set->mu);
+        kcoro_t *co = kc_chan_set_signal_locked(set, m, &s);
+        KC_MUTEX_UNLOCK(&set->mu);
+        kc_chan_set_wake(co, s);
+    }
+}
+
+void kc_chan_set_detach_locked(struct kc_chan *ch)
+{
+    struct kc_chan_set_member *m = ch->set_members;
+    ch->set_members = NULL;
+    while (m) {
+        struct kc_chan_set_member *next = m->ch_next;
+        KC_MUTEX_LOCK(&m->set->mu);
+        kc_chan_set_unqueue_locked(m->set, m);
+        m->ch = NULL;
+        m->ch_next = NULL;
+        KC_MUTEX_UNLOCK(&m->set->mu);
+        m = next;
+    }
+}
+
+int kc_chan_set_add(kc_chan_set_t *set, kc_chan_t *c, unsigned events, void *user)
+{
+    struct kc_chan *ch = (struct kc_chan*)c;
+    if (!set || !ch) return -EINVAL;
+    events &= KC_CHAN_SET_RECV | KC_CHAN_SET_SEND | KC_CHAN_SET_EDGE;
+    if (!(events & (KC_CHAN_SET_RECV | KC_CHAN_SET_SEND))) return -EINVAL;
+    if (ch->kind == KC_RENDEZVOUS || ch->delay || ch->zref_mode || ch->zc_ops) return -ENOTSUP;
+    struct kc_chan_set_member *m = calloc(1, sizeof(*m));
+    if (!m) return -ENOMEM;
+    m->set = set;
+    m->ch = ch;
+    m->user = user;
+    m->events = events;
+
+    KC_MUTEX_LOCK(&ch->mu);
+    for (struct kc_chan_set_member *o = ch->set_members; o; o = o->ch_next) {
+        if (o->set == set) { KC_MUTEX_UNLOCK(&ch->mu); free(m); return -EEXIST; }
+    }
+    m->ch_next = ch->set_members;
+    ch->set_members = m;
+    kc_chan_set_members_changed_locked(ch);
+    unsigned ready = kc_chan_ready_events_locked(ch);
+    kc_sched_t *s = NULL;
+    kcoro_t *co = NULL;
+    KC_MUTEX_LOCK(&set->mu);
+    m->all_next = set->all;
+    if (set->all) set->all->all_prev = m;
+    set->all = m;
+    if (ready & (events | KC_CHAN_SET_CLOSED)) co = kc_chan_set_signal_locked(set, m, &s);
+    KC_MUTEX_UNLOCK(&set->mu);
+    KC_MUTEX_UNLOCK(&ch->mu);
+    kc_chan_set_wake(co, s);
+    return 0;
+}
+
+/* Off the set's lists and free (set->mu held; the channel side is done). */
+static void kc_chan_set_drop_locked(struct kc_chan_set *set, struct kc_chan_set_member *m)
+{
+    kc_chan_set_unqueue_locked(set, m);
+    if (m->all_prev) m->all_prev->all_next = m->all_next; else set->all = m->all_next;
+    if (m->all_next) m->all_next->all_prev = m->all_prev;
+    free(m);
+}
+
+/* Unlink m from its channel's list (ch->mu held). */
+static void kc_chan_set_unlink_chan_locked(struct kc_chan *ch, struct kc_chan_set_member *m)
+{
+    for (struct kc_chan_set_member **pp = &ch->set_members; *pp; pp = &(*pp)->ch_next) {
+        if (*pp != m) continue;
+        *pp = m->ch_next;
+        break;
+    }
+    kc_chan_set_members_changed_locked(ch);
+}
+
+int kc_chan_set_remove(kc_chan_set_t *set, kc_chan_t *c)
+{
+    struct kc_chan *ch = (struct kc_chan*)c;
+    if (!set || !ch) return -EINVAL;
+    KC_MUTEX_LOCK(&ch->mu);
+    struct kc_chan_set_member *m = ch->set_members;
+    while (m && m->set != set) m = m->ch_next;
+    if (!m) { KC_MUTEX_UNLOCK(&ch->mu); return -ENOENT; }
+    kc_chan_set_unlink_chan_locked(ch, m);
+    KC_MUTEX_LOCK(&set->mu);
+    kc_chan_set_drop_locked(set, m);
+    KC_MUTEX_UNLOCK(&set->mu);
+    KC_MUTEX_UNLOCK(&ch->mu);
+    return 0;
+}
+
+void kc_chan_set_destroy(kc_chan_set_t *set)
+{
+    if (!set) return;
+    for (;;) {
+        KC_MUTEX_LOCK(&set->mu);
+        struct kc_chan_set_member *m = set->all;
+        struct kc_chan *ch = m ? m->ch : NULL;
+        KC_MUTEX_UNLOCK(&set->mu);
+        if (!m) break;
+        if (ch) KC_MUTEX_LOCK(&ch->mu);
+        /* kc_chan_destroy may have detached it meanwhile */
+        if (ch && m->ch == ch) kc_chan_set_unlink_chan_locked(ch, m);
+        KC_MUTEX_LOCK(&set->mu);
+        kc_chan_set_drop_locked(set, m);
+        KC_MUTEX_UNLOCK(&set->mu);
+        if (ch) KC_MUTEX_UNLOCK(&ch->mu);
+    }
+    KC_MUTEX_DESTROY(&set->mu);
+    free(set);
+}
+
+/* Report up to max ready memberships; the rest stay queued. Detached
+ * members keep queued set until visited, so a notify cannot relink one
+ * while the walk still needs its ready_next. */
+static int kc_chan_set_collect(struct kc_chan_set *set, struct kc_chan_set_event *out, int max)
+{
+    KC_MUTEX_LOCK(&set->mu);
+    struct kc_chan_set_member *m = set->ready_head;
+    set->ready_head = set->ready_tail = NULL;
+    KC_MUTEX_UNLOCK(&set->mu);
+
+    int n = 0;
+    while (m && n < max) {
+        KC_MUTEX_LOCK(&set->mu);
+        struct kc_chan_set_member *next = m->ready_next;
+        atomic_store_explicit(&m->queued, 0, memory_order_relaxed);
+        KC_MUTEX_UNLOCK(&set->mu);
+        struct kc_chan *ch = m->ch;
+        unsigned ev = 0;
+        if (ch) {
+            KC_MUTEX_LOCK(&ch->mu);
+            ev = kc_chan_ready_events_locked(ch) & (m->events | KC_CHAN_SET_CLOSED);
+            KC_MUTEX_UNLOCK(&ch->mu);
+        }
+        if (ev) {
+            out[n++] = (struct kc_chan_set_event){ .ch = (kc_chan_t*)ch, .user = m->user, .events = ev };
+            if (!(m->events & KC_CHAN_SET_EDGE)) {
+                KC_MUTEX_LOCK(&set->mu);
+                kc_chan_set_queue_locked(set, m);
+                KC_MUTEX_UNLOCK(&set->mu);
+            }
+        }
+        m = next;
+    }
+    if (m) {
+        /* Out of room: the unvisited rest go back ahead of anything queued */
+        KC_MUTEX_LOCK(&set->mu);
+        struct kc_chan_set_member *last = m;
+        while (last->ready_next) last = last->ready_next;
+        last->ready_next = set->ready_head;
+        if (!set->ready_head) set->ready_tail = last;
+        set->ready_head = m;
+        KC_MUTEX_UNLOCK(&set->mu);
+    }
+    return n;
+}
+
+struct kc_chan_set_park {
+    struct kc_chan_set *set;
+    kc_sched_t *sched;
+    kcoro_t *co;
+    long deadline_ns;
+    kc_timer_handle_t timer;
+};
+
+/* Runs on the worker after the waiting coroutine switched out. */
+static void kc_chan_set_park_release(void *arg)
+{
+    struct kc_chan_set_park *sp = (struct kc_chan_set_park*)arg;
+    kc_sched_t *s = sp->sched;
+    kcoro_t *co = sp->co;
+    if (sp->deadline_ns > 0)
+        sp->timer = kc_sched_timer_wake_at(s, co, (unsigned long long)sp->deadline_ns);
+    int cancelled = kc_cancel_wait_arm(co);
+    KC_MUTEX_UNLOCK(&sp->set->mu);
+    if (cancelled) kc_sched_enqueue_ready(s, co);
+}
+
+int kc_chan_set_wait(kc_chan_set_t *set, struct kc_chan_set_event *out, int max, long timeout_ms)
+{
+    if (!set || !out || max <= 0) return -EINVAL;
+    if (set->cancel && kc_cancel_is_set(set->cancel)) return KC_ECANCELED;
+    int n = kc_chan_set_collect(set, out, max);
+    if (n > 0) return n;
+    if (timeout_ms == 0) return KC_EAGAIN;
+    kcoro_t *co = kcoro_current();
+    if (!co) return -EINVAL;
+
+    long deadline_ns = timeout_ms > 0 ? kc_now_ns() + timeout_ms * 1000000L : 0;
+    struct kc_cancel_wait local;
+    int cancelled = 0;
+    struct kc_cancel_wait *cw = set->cancel ? kc_cancel_wait_begin(&local, set->cancel, &cancelled) : NULL;
+    int rc;
+    for (;;) {
+        if (cancelled || kc_cancel_wait_fired(co) || (set->cancel && kc_cancel_is_set(set->cancel))) {
+            rc = KC_ECANCELED;
+            break;
+        }
+        n = kc_chan_set_collect(set, out, max);
+        if (n > 0) { rc = n; break; }
+        long now = (deadline_ns > 0 || (set->cancel && !cw)) ? kc_now_ns() : 0;
+        if (deadline_ns > 0 && now >= deadline_ns) { rc = KC_ETIME; break; }
+
+        struct kc_chan_set_park sp_local = { .set = set, .sched = kc_sched_current(), .co = co,
+                                             .deadline_ns = deadline_ns, .timer = {0} };
+        if (set->cancel && !cw) {
+            /* Token without a registration: poll it */
+            long slice_ns = now + KCORO_CANCEL_SLICE_MS * 1000000L;
+            if (sp_local.deadline_ns <= 0 || slice_ns < sp_local.deadline_ns) sp_local.deadline_ns = slice_ns;
+        }
+        struct kc_chan_set_park *sp = sp_local.sched ? kcoro_park_record(co, &sp_local, sizeof(sp_local)) : NULL;
+        KC_MUTEX_LOCK(&set->mu);
+        if (set->ready_head) {
+            KC_MUTEX_UNLOCK(&set->mu);
+            kcoro_park_record_free(sp, &sp_local);
+            continue;
+        }
+        set->waiter = co;
+        set->waiter_sched = sp_local.sched;
+        if (!sp || kc_sched_park_release(kc_chan_set_park_release, sp) != 0) {
+            /* Not on a worker (or no memory for the record): cooperative retry. */
+            set->waiter = NULL;
+            KC_MUTEX_UNLOCK(&set->mu);
+            kcoro_park_record_free(sp, &sp_local);
+            kcoro_yield();
+            continue;
+        }
+        if (kc_cancel_wait_disarm(co)) cancelled = 1;
+        (void)kc_sched_timer_cancel(sp->sched, sp->timer);
+        kcoro_park_record_free(sp, &sp_local);
+        KC_MUTEX_LOCK(&set->mu);
+        if (set->waiter == co) set->waiter = NULL; /* timer, token or stray wake */
+        KC_MUTEX_UNLOCK(&set->mu);
+    }
+    kc_cancel_wait_end(cw);
+    return rc;
+}
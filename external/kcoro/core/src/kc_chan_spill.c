@@ -0,0 +1,172 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/*
+ * kc_chan_spill.c — spill files for KC_UNLIMITED backlogs (kcoro.h)
+ * -----------------------------------------------------------------
+ *
+ * Pressure
+ * - One process-wide counter of resident segment bytes, moved by kc_chan.c
+ *   as unlimited channels link, retire, spill and reload segments. Once
+ *   kc_chan_set_spill sets a limit, a segment link that would pass it makes
+ *   the channel spill its coldest resident segment instead of growing RAM.
+ *
+ * Files
+ * - Each channel that spills gets one file, created on first use in the
+ *   spill directory and unlinked at once (O_TMPFILE where available), so
+ *   nothing outlives the process. Payloads are appended with pwrite and
+ *   read back with pread: a spilled segment costs a few bytes of stub and
+ *   no address space, and the page cache decides what actually reaches the
+ *   disk. Segments come back in FIFO order, so the file is an append log:
+ *   each read punches its range out (Linux), and the log restarts at
+ *   offset 0 whenever nothing is left on it.
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "../../include/kcoro.h"
+#include "kc_chan_spill_internal.h"
+
+struct kc_chan_spill {
+    int           fd;
+    off_t         end;      /* append position */
+    size_t        bytes;    /* payload on the file now */
+    unsigned long writes, reads;
+};
+
+static _Atomic size_t g_resident;
+static _Atomic size_t g_limit;   /* 0: off */
+static pthread_mutex_t g_dir_mu = PTHREAD_MUTEX_INITIALIZER;
+static char g_dir[PATH_MAX];     /* empty: $TMPDIR, else /tmp */
+
+int kc_chan_set_spill(size_t resident_bytes, const char *dir)
+{
+    if (dir && (!*dir || strlen(dir) >= sizeof(g_dir))) return -EINVAL;
+    pthread_mutex_lock(&g_dir_mu);
+    if (dir) strcpy(g_dir, dir);
+    else g_dir[0] = '\0';
+    pthread_mutex_unlock(&g_dir_mu);
+    atomic_store_explicit(&g_limit, resident_bytes, memory_order_relaxed);
+    return 0;
+}
+
+size_t kc_chan_spill_resident(void)
+{
+    return atomic_load_explicit(&g_resident, memory_order_relaxed);
+}
+
+void kc_chan_spill_resident_add(size_t bytes)
+{
+    atomic_fetch_add_explicit(&g_resident, bytes, memory_order_relaxed);
+}
+
+void kc_chan_spill_resident_sub(size_t bytes)
+{
+    atomic_fetch_sub_explicit(&g_resident, bytes, memory_order_relaxed);
+}
+
+int kc_chan_spill_pressure(size_t bytes)
+{
+    size_t limit = atomic_load_explicit(&g_limit, memory_order_relaxed);
+    return limit && atomic_load_explicit(&g_resident, memory_order_relaxed) + bytes > limit;
+}
+
+static int spill_open(void)
+{
+    char dir[PATH_MAX];
+    pthread_mutex_lock(&g_dir_mu);
+    strcpy(dir, g_dir);
+    pthread_mutex_unlock(&g_dir_mu);
+    if (!dir[0]) {
+        const char *t = getenv("TMPDIR");
+        snprintf(dir, sizeof(dir), "%s", t && *t ? t : "/tmp");
+    }
+    int fd = -1;
+#ifdef O_TMPFILE
+    fd = open(dir, O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+#endif
+    if (fd < 0) {
+        char path[PATH_MAX];
+        if (snprintf(path, sizeof(path), "%s/kcoro-spill-XXXXXX", dir) >= (int)sizeof(path)) return -ENAMETOOLONG;
+        fd = mkstemp(path);
+        if (fd < 0) return -errno;
+        (void)unlink(path);
+        (void)fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+    return fd;
+}
+
+int kc_chan_spill_write(struct kc_chan_spill **spp, const void *data, size_t len, off_t *off)
+{
+    struct kc_chan_spill *sp = *spp;
+    if (!sp) {
+        sp = (struct kc_chan_spill*)calloc(1, sizeof(*sp));
+        if (!sp) return -ENOMEM;
+        sp->fd = spill_open();
+        if (sp->fd < 0) {
+            int rc = sp->fd;
+            free(sp);
+            return rc;
+        }
+        __atomic_store_n(spp, sp, __ATOMIC_RELEASE); /* kc_chan_snapshot reads it unlocked */
+    }
+    const unsigned char *p = (const unsigned char*)data;
+    size_t done = 0;
+    while (done < len) {
+        ssize_t n = pwrite(sp->fd, p + done, len - done, sp->end + (off_t)done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return n < 0 ? -errno : -ENOSPC;
+        done += (size_t)n;
+    }
+    *off = sp->end;
+    sp->end += (off_t)len;
+    sp->bytes += len;
+    sp->writes++;
+    return 0;
+}
+
+void kc_chan_spill_read(struct kc_chan_spill *sp, void *data, size_t len, off_t off)
+{
+    unsigned char *p = (unsigned char*)data;
+    size_t done = 0;
+    while (done < len) {
+        ssize_t n = pread(sp->fd, p + done, len - done, off + (off_t)done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            fprintf(stderr, "kcoro: spill read failed at %lld (%s)\n",
+                    (long long)off, n < 0 ? strerror(errno) : "short file");
+            abort();
+        }
+        done += (size_t)n;
+    }
+    sp->bytes -= len;
+    sp->reads++;
+    if (sp->bytes == 0) {
+        (void)ftruncate(sp->fd, 0);
+        sp->end = 0;
+    }
+#if defined(__linux__) && defined(FALLOC_FL_PUNCH_HOLE)
+    else {
+        (void)fallocate(sp->fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, off, (off_t)len);
+    }
+#endif
+}
+
+void kc_chan_spill_close(struct kc_chan_spill *sp)
+{
+    if (!sp) return;
+    close(sp->fd);
+    free(sp);
+}
+
+void kc_chan_spill_stats(const struct kc_chan_spill *sp, size_t *bytes,
+                         unsigned long *writes, unsigned long *reads)
+{
+    *bytes = sp ? __atomic_load_n(&sp->bytes, __ATOMIC_RELAXED) : 0;
+    *writes = sp ? __atomic_load_n(&sp->writes, __ATOMIC_RELAXED) : 0;
+    *reads = sp ? __atomic_load_n(&sp->reads, __ATOMIC_RELAXED) : 0;
+}
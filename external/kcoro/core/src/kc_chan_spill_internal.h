@@ -0,0 +1,35 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+/* Spill store behind KC_UNLIMITED channels (kc_chan_spill.c, kc_chan_set_spill).
+ *
+ * Segments of unlimited channels count as resident queued bytes while their
+ * payload is in memory. Past the configured limit, kc_chan.c swaps a cold
+ * segment (full, neither head nor tail) for a stub and writes its payload to
+ * the channel's spill file; the payload comes back when the stub reaches the
+ * head. Every call except the counters runs under the owning ch->mu. */
+
+#include <stddef.h>
+#include <sys/types.h>
+
+struct kc_chan_spill;   /* per-channel spill file and its counters */
+
+/* Resident segment bytes across all unlimited channels (relaxed). */
+void kc_chan_spill_resident_add(size_t bytes);
+void kc_chan_spill_resident_sub(size_t bytes);
+/* 1 when linking `bytes` more would pass the limit (0 when spilling is off). */
+int  kc_chan_spill_pressure(size_t bytes);
+
+/* Append len bytes to *sp's file, creating it on first use; *off receives
+ * their position. 0, or -errno with nothing written (the caller keeps the
+ * segment resident). */
+int  kc_chan_spill_write(struct kc_chan_spill **sp, const void *data, size_t len, off_t *off);
+/* Read back a spilled run and release its space in the file. Aborts on a
+ * failed read: the payload would otherwise be lost. */
+void kc_chan_spill_read(struct kc_chan_spill *sp, void *data, size_t len, off_t off);
+void kc_chan_spill_close(struct kc_chan_spill *sp);
+
+/* Bytes on file now, and writes / reads so far (kc_chan_snapshot). Safe
+ * without ch->mu: relaxed loads, each value one the owner stored. */
+void kc_chan_spill_stats(const struct kc_chan_spill *sp, size_t *bytes,
+                         unsigned long *writes, unsigned long *reads);
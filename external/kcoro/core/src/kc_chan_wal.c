@@ -0,0 +1,535 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/*
+ * kc_chan_wal.c — write-ahead log for durable channels (kcoro.h)
+ * ---------------------------------------------------------------
+ *
+ * Layout (one directory per channel)
+ * - Segment files named by their first LSN (%016llx.log), preallocated to
+ *   full size and mapped MAP_SHARED: an append is a memcpy into the tail
+ *   map, and a full disk fails the fallocate, not a later store. A file is
+ *   a 64-byte header (magic, element size, first LSN, record count) and
+ *   fixed-size records: { lsn, crc32(lsn, payload), len } + payload padded
+ *   to 8 bytes.
+ * - consumer.off holds the acknowledged LSN in two alternating 16-byte slots
+ *   (sequence + CRC), so a torn update leaves the other slot valid. flock on
+ *   it keeps a second process out of the directory.
+ *
+ * Group commit
+ * - Appends only touch memory. The commit thread wakes on the first append
+ *   after a commit, waits out the commit window so more appends join, then
+ *   fdatasyncs every segment with unsynced records, the directory when files
+ *   came or went, and the offset file when acknowledgements moved. Segments
+ *   wholly at or below the persisted offset are then unlinked. One commit
+ *   runs at a time (commit_mu); kc_chan_sync runs one inline.
+ *
+ * Recovery
+ * - Segments are scanned in LSN order; a record counts only with the
+ *   expected LSN and a matching CRC. The first bad record is the torn tail:
+ *   the rest of that file is zeroed and later files are removed, so stale
+ *   records can never reappear after the next crash.
+ */
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "../../include/kcoro.h"
+#include "../../include/kcoro_config.h"
+#include "../../include/kcoro_sched.h"
+#include "../../include/kcoro_port.h"
+#include "kc_chan_wal_internal.h"
+#include "kc_clock_internal.h"
+
+#define WAL_MAGIC     "KCWAL01"
+#define WAL_HDR_SZ    64
+#define WAL_OFF_FILE  "consumer.off"
+#define WAL_OFF_SLOT  512
+
+struct wal_file_hdr {
+    char     magic[8];
+    uint32_t elem_sz;
+    uint32_t rec_sz;
+    uint64_t first;
+    uint64_t recs;
+    uint32_t crc;
+};
+
+struct wal_rec {
+    uint64_t lsn;
+    uint32_t crc;
+    uint32_t len;
+};
+
+struct wal_off_slot {
+    uint64_t acked;
+    uint32_t seq;
+    uint32_t crc;
+};
+
+struct wal_seg {
+    struct wal_seg *next;
+    uint64_t first;   /* LSN of record 0 */
+    uint64_t end;     /* one past the newest record */
+    uint64_t synced;  /* one past the newest record known to be on disk */
+    size_t   recs;    /* records the file holds */
+    int      fd;
+};
+
+struct kc_chan_wal {
+    pthread_mutex_t mu;          /* everything below; appends also hold ch->mu */
+    pthread_cond_t  cv;
+    pthread_mutex_t commit_mu;   /* one commit at a time; only commits free segments */
+    int             dirfd, offfd;
+    size_t          elem_sz, rec_sz, seg_recs;
+    struct wal_seg *head, *tail;
+    unsigned char  *map;         /* tail file, NULL until the next append maps one */
+    size_t          map_len;
+    uint64_t        next;        /* LSN of the next append */
+    uint64_t        acked;       /* newest acknowledged LSN */
+    uint64_t        acked_synced;
+    uint32_t        off_seq;
+    int             dirty, dir_dirty, stop, err;
+    long            window_ms;
+    int             has_thread;
+    pthread_t       thread;
+};
+
+/* ---- CRC-32 (IEEE, reflected) ---- */
+
+static uint32_t g_crc_table[256];
+static pthread_once_t g_crc_once = PTHREAD_ONCE_INIT;
+
+static void crc_init(void)
+{
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        g_crc_table[i] = c;
+    }
+}
+
+static uint32_t crc_update(uint32_t crc, const void *data, size_t len)
+{
+    const unsigned char *p = (const unsigned char*)data;
+    crc = ~crc;
+    while (len--) crc = g_crc_table[(crc ^ *p++) & 0xff] ^ (crc >> 8);
+    return ~crc;
+}
+
+static uint32_t rec_crc(uint64_t lsn, const void *payload, size_t len)
+{
+    return crc_update(crc_update(0, &lsn, sizeof(lsn)), payload, len);
+}
+
+/* ---- segment files ---- */
+
+static void seg_name(char *buf, size_t len, uint64_t first)
+{
+    snprintf(buf, len, "%016" PRIx64 ".log", first);
+}
+
+static int map_file(int fd, size_t len, unsigned char **out)
+{
+    void *p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) return -errno;
+    *out = (unsigned char*)p;
+    return 0;
+}
+
+/* Create, preallocate and map a segment starting at w->next (w->mu held). */
+static int seg_create(struct kc_chan_wal *w)
+{
+    char name[32];
+    seg_name(name, sizeof(name), w->next);
+    struct wal_seg *s = (struct wal_seg*)calloc(1, sizeof(*s));
+    if (!s) return -ENOMEM;
+    size_t len = WAL_HDR_SZ + w->seg_recs * w->rec_sz;
+    int fd = openat(w->dirfd, name, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) { free(s); return -errno; }
+    int rc = posix_fallocate(fd, 0, (off_t)len);
+    unsigned char *map = NULL;
+    if (rc == 0) rc = -map_file(fd, len, &map);
+    if (rc != 0) {
+        close(fd);
+        (void)unlinkat(w->dirfd, name, 0);
+        free(s);
+        return -rc;
+    }
+    struct wal_file_hdr h = { .elem_sz = (uint32_t)w->elem_sz, .rec_sz = (uint32_t)w->rec_sz,
+                              .first = w->next, .recs = w->seg_recs };
+    memcpy(h.magic, WAL_MAGIC, sizeof(h.magic));
+    h.crc = crc_update(0, &h, offsetof(struct wal_file_hdr, crc));
+    memcpy(map, &h, sizeof(h));
+
+    s->first = s->end = s->synced = w->next;
+    s->recs = w->seg_recs;
+    s->fd = fd;
+    if (w->tail) w->tail->next = s; else w->head = s;
+    w->tail = s;
+    w->map = map;
+    w->map_len = len;
+    w->dir_dirty = 1;
+    return 0;
+}
+
+static void seg_drop(struct kc_chan_wal *w, struct wal_seg *s)
+{
+    char name[32];
+    seg_name(name, sizeof(name), s->first);
+    (void)unlinkat(w->dirfd, name, 0);
+    close(s->fd);
+    free(s);
+}
+
+/* ---- appends and acknowledgements ---- */
+
+int kc_chan_wal_append(struct kc_chan_wal *w, const void *src, size_t n, size_t *done)
+{
+    const unsigned char *p = (const unsigned char*)src;
+    size_t i = 0;
+    int rc = 0;
+    pthread_mutex_lock(&w->mu);
+    for (; i < n; i++) {
+        struct wal_seg *s = w->tail;
+        if (!w->map || s->end - s->first == s->recs) {
+            if (w->map) { munmap(w->map, w->map_len); w->map = NULL; }
+            if ((rc = seg_create(w)) != 0) break;
+            s = w->tail;
+        }
+        unsigned char *rec = w->map + WAL_HDR_SZ + (s->end - s->first) * w->rec_sz;
+        unsigned char *payload = rec + sizeof(struct wal_rec);
+        if (p) memcpy(payload, p + i * w->elem_sz, w->elem_sz);
+        else memset(payload, 0, w->elem_sz);
+        struct wal_rec r = { .lsn = w->next, .len = (uint32_t)w->elem_sz };
+        r.crc = rec_crc(r.lsn, payload, w->elem_sz);
+        memcpy(rec, &r, sizeof(r));
+        w->next++;
+        s->end++;
+    }
+    if (i && !w->dirty) {
+        w->dirty = 1;
+        pthread_cond_signal(&w->cv);
+    }
+    pthread_mutex_unlock(&w->mu);
+    *done = i;
+    return rc;
+}
+
+uint64_t kc_chan_wal_last(const struct kc_chan_wal *w)
+{
+    return w->next - 1;
+}
+
+int kc_chan_wal_ack(struct kc_chan_wal *w, size_t n, uint64_t received)
+{
+    pthread_mutex_lock(&w->mu);
+    if (n > received - w->acked) { pthread_mutex_unlock(&w->mu); return -ERANGE; }
+    w->acked += n;
+    if (n && !w->dirty) {
+        w->dirty = 1;
+        pthread_cond_signal(&w->cv);
+    }
+    pthread_mutex_unlock(&w->mu);
+    return 0;
+}
+
+/* ---- commit ---- */
+
+static int off_write(struct kc_chan_wal *w, uint64_t acked)
+{
+    struct wal_off_slot slot = { .acked = acked, .seq = ++w->off_seq };
+    slot.crc = crc_update(0, &slot, offsetof(struct wal_off_slot, crc));
+    off_t at = (slot.seq & 1) ? WAL_OFF_SLOT : 0;
+    if (pwrite(w->offfd, &slot, sizeof(slot), at) != (ssize_t)sizeof(slot)) return -errno;
+    return fdatasync(w->offfd) == 0 ? 0 : -errno;
+}
+
+static int wal_commit(struct kc_chan_wal *w)
+{
+    int rc = 0;
+    pthread_mutex_lock(&w->commit_mu);
+    pthread_mutex_lock(&w->mu);
+    w->dirty = 0;
+    for (struct wal_seg *s = w->head; s; s = s->next) {
+        if (s->synced >= s->end) continue;
+        uint64_t end = s->end;
+        int fd = s->fd;
+        pthread_mutex_unlock(&w->mu);
+        int r = fdatasync(fd) == 0 ? 0 : -errno;   /* s stays: only commits free segments */
+        pthread_mutex_lock(&w->mu);
+        if (r == 0) s->synced = end;
+        else if (!rc) rc = r;
+    }
+    int dir_dirty = w->dir_dirty;
+    uint64_t acked = w->acked;
+    w->dir_dirty = 0;
+    pthread_mutex_unlock(&w->mu);
+
+    if (dir_dirty && fsync(w->dirfd) != 0 && !rc) rc = -errno;
+    if (acked != w->acked_synced) {
+        int r = off_write(w, acked);
+        if (r == 0) w->acked_synced = acked;
+        else if (!rc) rc = r;
+    }
+
+    pthread_mutex_lock(&w->mu);
+    while (w->head && w->head != w->tail && w->head->end - 1 <= w->acked_synced) {
+        struct wal_seg *s = w->head;
+        w->head = s->next;
+        seg_drop(w, s);
+        w->dir_dirty = 1;
+    }
+    if (rc && !w->err) w->err = rc;
+    pthread_mutex_unlock(&w->mu);
+    pthread_mutex_unlock(&w->commit_mu);
+    return rc;
+}
+
+static void *wal_thread(void *arg)
+{
+    struct kc_chan_wal *w = (struct kc_chan_wal*)arg;
+    pthread_mutex_lock(&w->mu);
+    while (!w->stop) {
+        if (!w->dirty) { pthread_cond_wait(&w->cv, &w->mu); continue; }
+        /* Let the window fill before paying for the sync. */
+        struct timespec ts;
+        kc_clock_abstime_ms(&ts, KC_PORT_PTHREAD_COND_CLOCK, (long)w->window_ms);
+        while (!w->stop && pthread_cond_timedwait(&w->cv, &w->mu, &ts) != ETIMEDOUT) { }
+        pthread_mutex_unlock(&w->mu);
+        (void)wal_commit(w);
+        pthread_mutex_lock(&w->mu);
+    }
+    pthread_mutex_unlock(&w->mu);
+    return NULL;
+}
+
+int kc_chan_wal_sync(struct kc_chan_wal *w)
+{
+    /* fdatasync blocks the thread: take a worker coroutine off its worker. */
+    int moved = kc_sched_block_begin() == 0;
+    int rc = wal_commit(w);
+    if (moved) kc_sched_block_end();
+    return rc;
+}
+
+/* ---- open / recovery ---- */
+
+static uint64_t off_read(int fd, uint32_t *seq)
+{
+    uint64_t acked = 0;
+    *seq = 0;
+    for (int i = 0; i < 2; i++) {
+        struct wal_off_slot slot;
+        if (pread(fd, &slot, sizeof(slot), i ? WAL_OFF_SLOT : 0) != (ssize_t)sizeof(slot)) continue;
+        if (slot.crc != crc_update(0, &slot, offsetof(struct wal_off_slot, crc))) continue;
+        if (slot.seq > *seq) { *seq = slot.seq; acked = slot.acked; }
+    }
+    return acked;   /* 0 for a new (or unreadable) offset file */
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+/* First LSNs of the segment files in dir, sorted. */
+static int list_segments(int dirfd, uint64_t **out, size_t *count)
+{
+    int fd = dup(dirfd);
+    if (fd < 0) return -errno;
+    DIR *d = fdopendir(fd);
+    if (!d) { int rc = -errno; close(fd); return rc; }
+    rewinddir(d);
+    uint64_t *v = NULL;
+    size_t n = 0, cap = 0;
+    struct dirent *e;
+    while ((e = readdir(d)) != NULL) {
+        char *endp = NULL;
+        if (strlen(e->d_name) != 20 || strcmp(e->d_name + 16, ".log") != 0) continue;
+        uint64_t first = strtoull(e->d_name, &endp, 16);
+        if (endp != e->d_name + 16) continue;
+        if (n == cap) {
+            size_t ncap = cap ? cap * 2 : 16;
+            uint64_t *nv = (uint64_t*)realloc(v, ncap * sizeof(*v));
+            if (!nv) { free(v); closedir(d); return -ENOMEM; }
+            v = nv; cap = ncap;
+        }
+        v[n++] = first;
+    }
+    closedir(d);
+    qsort(v, n, sizeof(*v), cmp_u64);
+    *out = v;
+    *count = n;
+    return 0;
+}
+
+/* Scan one segment; replays live records and links it as the new tail.
+ * Returns 1 when it ended early (torn tail), 0 when full, -errno on error,
+ * -ENOENT when the file is not a usable segment. */
+static int seg_recover(struct kc_chan_wal *w, uint64_t first, uint64_t expect,
+                       kc_chan_wal_replay_fn replay, void *arg)
+{
+    char name[32];
+    seg_name(name, sizeof(name), first);
+    int fd = openat(w->dirfd, name, O_RDWR | O_CLOEXEC);
+    if (fd < 0) return -errno;
+    struct stat st;
+    struct wal_file_hdr h;
+    if (fstat(fd, &st) != 0 || pread(fd, &h, sizeof(h), 0) != (ssize_t)sizeof(h) ||
+        memcmp(h.magic, WAL_MAGIC, sizeof(h.magic)) != 0 ||
+        h.crc != crc_update(0, &h, offsetof(struct wal_file_hdr, crc)) ||
+        h.first != first || (expect && first != expect) || h.recs == 0 ||
+        (uint64_t)st.st_size < WAL_HDR_SZ + h.recs * h.rec_sz) {
+        close(fd);
+        return -ENOENT;
+    }
+    if (h.elem_sz != w->elem_sz || h.rec_sz != w->rec_sz) { close(fd); return -EINVAL; }
+    size_t len = WAL_HDR_SZ + (size_t)h.recs * w->rec_sz;
+    unsigned char *map = NULL;
+    int rc = map_file(fd, len, &map);
+    if (rc) { close(fd); return rc; }
+
+    size_t i = 0;
+    for (; i < h.recs; i++) {
+        unsigned char *rec = map + WAL_HDR_SZ + i * w->rec_sz;
+        struct wal_rec r;
+        memcpy(&r, rec, sizeof(r));
+        const unsigned char *payload = rec + sizeof(r);
+        if (r.lsn != first + i || r.len != w->elem_sz ||
+            r.crc != rec_crc(r.lsn, payload, w->elem_sz)) break;
+        if (r.lsn > w->acked && (rc = replay(arg, payload)) != 0) {
+            munmap(map, len); close(fd); return rc;
+        }
+    }
+    struct wal_seg *s = (struct wal_seg*)calloc(1, sizeof(*s));
+    if (!s) { munmap(map, len); close(fd); return -ENOMEM; }
+    s->first = first;
+    s->end = s->synced = first + i;
+    s->recs = h.recs;
+    s->fd = fd;
+    if (w->tail) w->tail->next = s; else w->head = s;
+    w->tail = s;
+    if (w->map) munmap(w->map, w->map_len);
+    w->map = map;
+    w->map_len = len;
+    if (i < h.recs) {
+        /* Clear what lies past the last good record, torn or stale. */
+        unsigned char *from = map + WAL_HDR_SZ + i * w->rec_sz;
+        memset(from, 0, len - (size_t)(from - map));
+        if (fdatasync(fd) != 0) return -errno;
+        return 1;
+    }
+    return 0;
+}
+
+static void wal_free(struct kc_chan_wal *w)
+{
+    if (w->map) munmap(w->map, w->map_len);
+    while (w->head) {
+        struct wal_seg *s = w->head;
+        w->head = s->next;
+        close(s->fd);
+        free(s);
+    }
+    if (w->offfd >= 0) close(w->offfd);
+    if (w->dirfd >= 0) close(w->dirfd);
+    pthread_mutex_destroy(&w->mu);
+    pthread_mutex_destroy(&w->commit_mu);
+    pthread_cond_destroy(&w->cv);
+    free(w);
+}
+
+int kc_chan_wal_open(struct kc_chan_wal **out, const char *dir, size_t elem_sz,
+                     const kc_chan_durable_opts_t *opts,
+                     kc_chan_wal_replay_fn replay, void *arg)
+{
+    pthread_once(&g_crc_once, crc_init);
+    if (mkdir(dir, 0700) != 0 && errno != EEXIST) return -errno;
+    struct kc_chan_wal *w = (struct kc_chan_wal*)calloc(1, sizeof(*w));
+    if (!w) return -ENOMEM;
+    pthread_mutex_init(&w->mu, NULL);
+    pthread_mutex_init(&w->commit_mu, NULL);
+    kc_posix_cond_init_monotonic(&w->cv);
+    w->offfd = -1;
+    w->elem_sz = elem_sz;
+    w->rec_sz = (sizeof(struct wal_rec) + elem_sz + 7) & ~(size_t)7;
+    size_t seg_bytes = opts && opts->segment_bytes ? opts->segment_bytes : KCORO_DURABLE_SEGMENT_BYTES;
+    w->seg_recs = seg_bytes > WAL_HDR_SZ + w->rec_sz ? (seg_bytes - WAL_HDR_SZ) / w->rec_sz : 1;
+    w->window_ms = opts && opts->commit_window_ms ? opts->commit_window_ms : KCORO_DURABLE_COMMIT_MS;
+
+    int rc = 0;
+    w->dirfd = open(dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (w->dirfd < 0) { rc = -errno; goto fail; }
+    w->offfd = openat(w->dirfd, WAL_OFF_FILE, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (w->offfd < 0) { rc = -errno; goto fail; }
+    if (flock(w->offfd, LOCK_EX | LOCK_NB) != 0) { rc = errno == EWOULDBLOCK ? -EBUSY : -errno; goto fail; }
+    w->acked = w->acked_synced = off_read(w->offfd, &w->off_seq);
+
+    uint64_t *firsts = NULL;
+    size_t nfirst = 0;
+    if ((rc = list_segments(w->dirfd, &firsts, &nfirst)) != 0) goto fail;
+    uint64_t expect = 0;
+    int torn = 0;
+    for (size_t i = 0; i < nfirst; i++) {
+        int r = torn ? -ENOENT : seg_recover(w, firsts[i], expect, replay, arg);
+        if (r == -ENOENT) {
+            char name[32];
+            seg_name(name, sizeof(name), firsts[i]);
+            (void)unlinkat(w->dirfd, name, 0);
+            w->dir_dirty = 1;
+            continue;
+        }
+        if (r < 0) { rc = r; free(firsts); goto fail; }
+        torn = r;
+        expect = w->tail->end;
+    }
+    free(firsts);
+    w->next = w->tail ? w->tail->end : w->acked + 1;
+    if (w->next <= w->acked) {
+        /* The offset is ahead of the log (log lost): restart numbering past it. */
+        w->next = w->acked + 1;
+        if (w->map) { munmap(w->map, w->map_len); w->map = NULL; }
+    }
+    /* Recovery may leave acknowledged files at the front. */
+    while (w->head && w->head != w->tail && w->head->end - 1 <= w->acked) {
+        struct wal_seg *s = w->head;
+        w->head = s->next;
+        seg_drop(w, s);
+        w->dir_dirty = 1;
+    }
+    if (w->dir_dirty && fsync(w->dirfd) != 0) { rc = -errno; goto fail; }
+    w->dir_dirty = 0;
+
+    if (w->window_ms >= 0) {
+        if (pthread_create(&w->thread, NULL, wal_thread, w) != 0) { rc = -EAGAIN; goto fail; }
+        w->has_thread = 1;
+    }
+    *out = w;
+    return 0;
+fail:
+    wal_free(w);
+    return rc;
+}
+
+void kc_chan_wal_close(struct kc_chan_wal *w)
+{
+    if (!w) return;
+    if (w->has_thread) {
+        pthread_mutex_lock(&w->mu);
+        w->stop = 1;
+        pthread_cond_signal(&w->cv);
+        pthread_mutex_unlock(&w->mu);
+        pthread_join(w->thread, NULL);
+    }
+    (void)wal_commit(w);
+    wal_free(w);
+}
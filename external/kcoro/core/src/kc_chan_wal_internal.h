@@ -0,0 +1,38 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+/* Write-ahead log behind durable channels (kc_chan_wal.c, kc_chan_make_durable).
+ *
+ * Every element stored in a durable KC_UNLIMITED channel is first appended
+ * to the log under ch->mu with a log sequence number (LSN, 1-based, one per
+ * element). A commit thread fdatasyncs the appended range at most once per
+ * commit window; kc_chan_ack advances the consumer offset, which the next
+ * commit persists before unlinking fully acknowledged segment files. */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../../include/kcoro.h"
+
+struct kc_chan_wal;
+
+/* Called for each unacknowledged record, in LSN order, while the log is
+ * opened; nonzero stops the open with that error. */
+typedef int (*kc_chan_wal_replay_fn)(void *arg, const void *elem);
+
+/* Open (or create) the log in dir, replay what is left over, and start the
+ * commit thread. 0, -EINVAL (elem_sz differs from the log's), -EBUSY (dir in
+ * use by another open log) or -errno. */
+int  kc_chan_wal_open(struct kc_chan_wal **out, const char *dir, size_t elem_sz,
+                      const kc_chan_durable_opts_t *opts,
+                      kc_chan_wal_replay_fn replay, void *arg);
+/* Log n elements (src NULL: zeros); *done receives how many made it.
+ * ch->mu held. 0 or -errno for the first one that did not. */
+int  kc_chan_wal_append(struct kc_chan_wal *w, const void *src, size_t n, size_t *done);
+/* LSN of the newest record (0: none yet); ch->mu held. */
+uint64_t kc_chan_wal_last(const struct kc_chan_wal *w);
+/* Acknowledge n more records, never past LSN `received`. 0 or -ERANGE. */
+int  kc_chan_wal_ack(struct kc_chan_wal *w, size_t n, uint64_t received);
+/* Commit now: appended records and acknowledgements are on disk when 0. */
+int  kc_chan_wal_sync(struct kc_chan_wal *w);
+/* Stop the commit thread, commit once more and release everything. */
+void kc_chan_wal_close(struct kc_chan_wal *w);
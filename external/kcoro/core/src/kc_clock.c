@@ -0,0 +1,250 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/*
+ * kc_clock.c - the runtime clock: CLOCK_MONOTONIC nanoseconds from the CPU
+ * counter where one is usable, calibrated once and re-anchored every
+ * KCORO_CLOCK_RESYNC_MS; the per-thread coarse clock; timed-wait deadlines.
+ * See kc_clock_internal.h for the design.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#if defined(__x86_64__)
+#include <cpuid.h>
+#endif
+
+#include "kc_clock_internal.h"
+#include "../../include/kcoro_config.h"
+
+enum { CLK_INIT, CLK_CALIB, CLK_COUNTER, CLK_MONO };
+
+struct kc_clock_cal kc_clock_cal;
+__thread struct kc_clock_coarse kc_tls_clock;
+
+static _Atomic int g_state;                /* CLK_* */
+static pthread_mutex_t g_mu = PTHREAD_MUTEX_INITIALIZER;
+static uint64_t g_base_tick, g_base_ns;    /* g_mu: first (tick, ns) pair, the rate baseline */
+static uint64_t g_rate;                    /* g_mu: measured ns per tick, 32.32 */
+
+#define CLK_NS_PER_MS 1000000ull
+/* Further behind CLOCK_MONOTONIC than this at a re-anchor (the counter
+ * stopped, say), step forward instead of slewing. */
+#define CLK_STEP_NS   (10 * CLK_NS_PER_MS)
+
+uint64_t kc_clock_mono_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+#if KC_CLOCK_COUNTER
+/* A (tick, ns) pair read as close together as three tries allow. */
+static void clk_pair(uint64_t *tick, uint64_t *ns)
+{
+    uint64_t best = UINT64_MAX;
+    *tick = *ns = 0;
+    for (int i = 0; i < 3; i++) {
+        uint64_t a = kc_clock_ticks();
+        uint64_t n = kc_clock_mono_ns();
+        uint64_t b = kc_clock_ticks();
+        if (b - a < best) { best = b - a; *tick = a + (b - a) / 2; *ns = n; }
+    }
+}
+
+static uint64_t clk_div(uint64_t ns, uint64_t ticks)
+{
+    return ticks ? (uint64_t)(((unsigned __int128)ns << 32) / ticks) : 0;
+}
+
+/* Ticks that ns take at mult. */
+static uint64_t clk_ticks_for(uint64_t ns, uint64_t mult)
+{
+    return (uint64_t)(((unsigned __int128)ns << 32) / mult);
+}
+
+static int clk_counter_usable(void)
+{
+#if defined(__x86_64__)
+    unsigned a, b, c, d;
+    if (!__get_cpuid(0x80000000u, &a, &b, &c, &d) || a < 0x80000007u) return 0;
+    __get_cpuid(0x80000007u, &a, &b, &c, &d);
+    if (!(d & (1u << 8))) return 0;            /* invariant TSC */
+#ifdef __linux__
+    /* The kernel drops the TSC as its clocksource when it finds it
+     * unsynchronised across CPUs or unstable; follow its lead. */
+    FILE *f = fopen("/sys/devices/system/clocksource/clocksource0/current_clocksource", "r");
+    if (f) {
+        char name[32] = {0};
+        int ok = fgets(name, sizeof name, f) && strncmp(name, "tsc", 3) == 0;
+        fclose(f);
+        if (!ok) return 0;
+    }
+#endif
+    return 1;
+#else
+    return 1;
+#endif
+}
+
+static uint64_t clk_counter_hz(void)
+{
+#if defined(__aarch64__)
+    uint64_t v;
+    __asm__ __volatile__("mrs %0, cntfrq_el0" : "=r"(v));
+    return v;
+#else
+    return 0;                                   /* TSC: calibrate */
+#endif
+}
+
+/* Publish a new line (g_mu held). */
+static void clk_publish(uint64_t tick0, uint64_t ns0, uint64_t mult)
+{
+    struct kc_clock_cal *c = &kc_clock_cal;
+    uint32_t s = atomic_load_explicit(&c->seq, memory_order_relaxed);
+    atomic_store_explicit(&c->seq, s + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&c->tick0, tick0, memory_order_relaxed);
+    atomic_store_explicit(&c->ns0, ns0, memory_order_relaxed);
+    atomic_store_explicit(&c->mult, mult, memory_order_relaxed);
+    atomic_store_explicit(&c->span, clk_ticks_for(KCORO_CLOCK_RESYNC_MS * CLK_NS_PER_MS, mult),
+                          memory_order_relaxed);
+    atomic_store_explicit(&c->seq, s + 2, memory_order_release);
+}
+
+/* The published line at tick, past its span or not. */
+static uint64_t clk_extrapolate(uint64_t tick)
+{
+    struct kc_clock_cal *c = &kc_clock_cal;
+    for (;;) {
+        uint32_t s = atomic_load_explicit(&c->seq, memory_order_acquire);
+        uint64_t mult = atomic_load_explicit(&c->mult, memory_order_relaxed);
+        uint64_t t0 = atomic_load_explicit(&c->tick0, memory_order_relaxed);
+        uint64_t ns0 = atomic_load_explicit(&c->ns0, memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire);
+        if ((s & 1u) || atomic_load_explicit(&c->seq, memory_order_relaxed) != s) continue;
+        if (tick <= t0) return ns0;
+        return ns0 + (uint64_t)(((unsigned __int128)(tick - t0) * mult) >> 32);
+    }
+}
+
+/* Re-anchor (g_mu held): continue the current line from now and aim it at
+ * CLOCK_MONOTONIC one resync period ahead. */
+static uint64_t clk_resync(void)
+{
+    uint64_t t, m;
+    clk_pair(&t, &m);
+    if (t <= g_base_tick) return clk_extrapolate(t);
+    uint64_t cur = clk_extrapolate(t);
+    if (m > g_base_ns) {
+        uint64_t rate = clk_div(m - g_base_ns, t - g_base_tick);
+        if (rate) g_rate = rate;
+    }
+    uint64_t ns0 = m > cur + CLK_STEP_NS ? m : cur;
+    uint64_t period = KCORO_CLOCK_RESYNC_MS * CLK_NS_PER_MS;
+    uint64_t span = clk_ticks_for(period, g_rate);
+    uint64_t target = m + period;
+    uint64_t mult = target > ns0 ? clk_div(target - ns0, span) : 0;
+    if (mult < g_rate / 2) mult = g_rate / 2;
+    if (mult > g_rate * 2) mult = g_rate * 2;
+    clk_publish(t, ns0, mult);
+    return ns0;
+}
+
+static void clk_init_locked(void)
+{
+    if (atomic_load_explicit(&g_state, memory_order_relaxed) != CLK_INIT) return;
+    if (!clk_counter_usable()) {
+        atomic_store_explicit(&g_state, CLK_MONO, memory_order_release);
+        return;
+    }
+    clk_pair(&g_base_tick, &g_base_ns);
+    uint64_t hz = clk_counter_hz();
+    if (hz) {
+        g_rate = clk_div(1000000000ull, hz);
+        clk_publish(g_base_tick, g_base_ns, g_rate);
+        atomic_store_explicit(&g_state, CLK_COUNTER, memory_order_release);
+    } else {
+        atomic_store_explicit(&g_state, CLK_CALIB, memory_order_release);
+    }
+}
+#endif
+
+uint64_t kc_clock_slow(void)
+{
+#if KC_CLOCK_COUNTER
+    int st = atomic_load_explicit(&g_state, memory_order_acquire);
+    if (st == CLK_INIT) {
+        pthread_mutex_lock(&g_mu);
+        clk_init_locked();
+        pthread_mutex_unlock(&g_mu);
+        st = atomic_load_explicit(&g_state, memory_order_acquire);
+    }
+    if (st == CLK_MONO) return kc_clock_mono_ns();
+    if (st == CLK_CALIB) {
+        uint64_t now = kc_clock_mono_ns();
+        if (now - g_base_ns < KCORO_CLOCK_CALIB_MS * CLK_NS_PER_MS) return now;
+        if (pthread_mutex_trylock(&g_mu) != 0) return now;
+        if (atomic_load_explicit(&g_state, memory_order_relaxed) == CLK_CALIB) {
+            uint64_t t, m;
+            clk_pair(&t, &m);
+            g_rate = t > g_base_tick ? clk_div(m - g_base_ns, t - g_base_tick) : 0;
+            if (g_rate) {
+                clk_publish(t, m, g_rate);
+                atomic_store_explicit(&g_state, CLK_COUNTER, memory_order_release);
+            } else {
+                atomic_store_explicit(&g_state, CLK_MONO, memory_order_release);
+            }
+            now = m;
+        }
+        pthread_mutex_unlock(&g_mu);
+        return now;
+    }
+    /* Counter clock past its span: one reader re-anchors, the rest extend
+     * the current line meanwhile. */
+    if (pthread_mutex_trylock(&g_mu) != 0) return clk_extrapolate(kc_clock_ticks());
+    uint64_t now = clk_resync();
+    pthread_mutex_unlock(&g_mu);
+    return now;
+#else
+    return kc_clock_mono_ns();
+#endif
+}
+
+const char *kc_clock_source(void)
+{
+    (void)kc_clock_ns();
+    if (atomic_load_explicit(&g_state, memory_order_acquire) != CLK_COUNTER) return "monotonic";
+#if defined(__x86_64__)
+    return "tsc";
+#else
+    return "cntvct";
+#endif
+}
+
+void kc_clock_abstime(struct timespec *ts, clockid_t clk, uint64_t deadline_ns)
+{
+    uint64_t now = kc_clock_ns();
+    uint64_t left = deadline_ns > now ? deadline_ns - now : 0;
+    clock_gettime(clk, ts);
+    ts->tv_sec += (time_t)(left / 1000000000ull);
+    ts->tv_nsec += (long)(left % 1000000000ull);
+    if (ts->tv_nsec >= 1000000000L) { ts->tv_sec++; ts->tv_nsec -= 1000000000L; }
+}
+
+void kc_clock_abstime_ms(struct timespec *ts, clockid_t clk, long timeout_ms)
+{
+    clock_gettime(clk, ts);
+    if (timeout_ms <= 0) return;
+    ts->tv_sec += (time_t)(timeout_ms / 1000);
+    ts->tv_nsec += (timeout_ms % 1000) * 1000000L;
+    if (ts->tv_nsec >= 1000000000L) { ts->tv_sec++; ts->tv_nsec -= 1000000000L; }
+}
+
+long kc_clock_coarse_refresh(void)
+{
+    struct kc_clock_coarse *c = &kc_tls_clock;
+    c->now = (long)kc_clock_ns();
+    c->left = c->worker ? KCORO_COARSE_CLOCK_READS - 1 : 0;
+    return c->now;
+}
@@ -0,0 +1,136 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include <time.h>
+
+/* Runtime clock (kc_clock.c). Internal; not part of the public API.
+ *
+ * kc_clock_ns() is CLOCK_MONOTONIC time in ns, and every timestamp, timeout
+ * and deadline in the core reads it. Where the CPU has a usable counter it
+ * costs a counter read and a multiply instead of a clock_gettime:
+ *
+ * - x86-64: the TSC, when CPUID reports it invariant (and, on Linux, the
+ *   kernel still trusts it as its clocksource). Its rate is timed against
+ *   CLOCK_MONOTONIC over KCORO_CLOCK_CALIB_MS; reads until then fall back.
+ * - arm64: cntvct_el0, at the rate cntfrq_el0 reports.
+ * - Anything else: clock_gettime(CLOCK_MONOTONIC).
+ *
+ * The conversion {tick0, ns0, mult} is published under a sequence count.
+ * Once a read lands KCORO_CLOCK_RESYNC_MS past tick0 it re-anchors: ns0
+ * continues from the old line, so the clock never steps back, and mult is
+ * set to close any gap to CLOCK_MONOTONIC by the next resync. Readers that
+ * fetched a tick before a concurrent re-anchor get ns0 rather than less.
+ *
+ * Timed waits: kc_clock_abstime turns a kc_clock_ns deadline into the
+ * timespec a condvar on the given clock wants (KC_COND_CLOCK for KC_COND,
+ * KC_PORT_PTHREAD_COND_CLOCK for pthread condvars made with
+ * kc_posix_cond_init_monotonic). It goes through the time left, so a
+ * counter clock a few microseconds off CLOCK_MONOTONIC cannot make a wait
+ * return early or spin. */
+
+#if (defined(__x86_64__) || defined(__aarch64__)) && defined(__SIZEOF_INT128__)
+#define KC_CLOCK_COUNTER 1
+#else
+#define KC_CLOCK_COUNTER 0
+#endif
+
+struct kc_clock_cal {
+    _Atomic uint32_t seq;     /* odd while a re-anchor is publishing */
+    _Atomic uint64_t tick0;   /* counter at the anchor */
+    _Atomic uint64_t ns0;     /* clock at the anchor */
+    _Atomic uint64_t mult;    /* ns per tick, 32.32 fixed point; 0: no counter */
+    _Atomic uint64_t span;    /* ticks past tick0 that trigger a re-anchor */
+};
+extern struct kc_clock_cal kc_clock_cal;
+
+/* Everything but the counter fast path: first use, calibration, re-anchoring
+ * and the clock_gettime fallback. */
+uint64_t kc_clock_slow(void);
+
+/* clock_gettime(CLOCK_MONOTONIC) in ns. */
+uint64_t kc_clock_mono_ns(void);
+
+/* "tsc", "cntvct" or "monotonic": what kc_clock_ns reads right now. */
+const char *kc_clock_source(void);
+
+/* Deadline in kc_clock_ns terms to an absolute timespec on clk. */
+void kc_clock_abstime(struct timespec *ts, clockid_t clk, uint64_t deadline_ns);
+
+/* timeout_ms (>= 0) from now as an absolute timespec on clk. */
+void kc_clock_abstime_ms(struct timespec *ts, clockid_t clk, long timeout_ms);
+
+static inline uint64_t kc_clock_ticks(void)
+{
+#if defined(__x86_64__)
+    unsigned lo, hi;
+    __asm__ __volatile__("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((uint64_t)hi << 32) | lo;
+#elif defined(__aarch64__)
+    uint64_t v;
+    __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(v));
+    return v;
+#else
+    return kc_clock_mono_ns();
+#endif
+}
+
+static inline uint64_t kc_clock_ns(void)
+{
+#if KC_CLOCK_COUNTER
+    struct kc_clock_cal *c = &kc_clock_cal;
+    for (;;) {
+        uint32_t s = atomic_load_explicit(&c->seq, memory_order_acquire);
+        uint64_t mult = atomic_load_explicit(&c->mult, memory_order_relaxed);
+        uint64_t t0 = atomic_load_explicit(&c->tick0, memory_order_relaxed);
+        uint64_t ns0 = atomic_load_explicit(&c->ns0, memory_order_relaxed);
+        uint64_t span = atomic_load_explicit(&c->span, memory_order_relaxed);
+        uint64_t t = kc_clock_ticks();
+        atomic_thread_fence(memory_order_acquire);
+        if ((s & 1u) || atomic_load_explicit(&c->seq, memory_order_relaxed) != s) continue;
+        if (!mult) return kc_clock_slow();
+        if (t <= t0) return ns0;
+        uint64_t d = t - t0;
+        if (d >= span) return kc_clock_slow();
+        return ns0 + (uint64_t)(((unsigned __int128)d * mult) >> 32);
+    }
+#else
+    return kc_clock_mono_ns();
+#endif
+}
+
+/* Coarse clock for channel stats: kc_clock_ns, cached per thread.
+ * Scheduler workers mark it stale (kc_clock_coarse_expire) before each
+ * coroutine or task they run, so a resumed coroutine never sees time from
+ * before it parked; within a run one refresh serves
+ * KCORO_COARSE_CLOCK_READS reads. Other threads cannot be told when they
+ * slept and read the clock every time. */
+struct kc_clock_coarse {
+    long     now;
+    unsigned left;    /* reads until the next refresh */
+    int      worker;
+};
+extern __thread struct kc_clock_coarse kc_tls_clock;
+
+long kc_clock_coarse_refresh(void);
+
+static inline long kc_clock_coarse_ns(void)
+{
+    struct kc_clock_coarse *c = &kc_tls_clock;
+    if (c->left == 0) return kc_clock_coarse_refresh();
+    c->left--;
+    return c->now;
+}
+
+static inline void kc_clock_coarse_expire(void)
+{
+    kc_tls_clock.left = 0;
+}
+
+/* Called once on a worker thread: from here on the scheduler expires it. */
+static inline void kc_clock_coarse_worker(void)
+{
+    kc_tls_clock.worker = 1;
+    kc_tls_clock.left = 0;
+}
@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/*
+ * kc_cls.c — coroutine-local storage
+ * ----------------------------------
+ *
+ * Keys are indices handed out by one atomic counter; the destructor table is
+ * written before a key is returned and never changes, so readers take it
+ * with a relaxed load. Slots [0, KCORO_CLS_INLINE) sit in kcoro_t, the rest
+ * in co->cls_ext (KCORO_CLS_KEYS - KCORO_CLS_INLINE entries, zeroed on the
+ * first set of such a key). Only the coroutine itself (or the releasing
+ * thread once nothing runs it) touches its slots, so they need no locking.
+ * co->cls_used marks a coroutine that ever set a value, so finishing one
+ * that never did costs a single byte test.
+ */
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#include "../../include/kc_cls.h"
+#include "kc_cls_internal.h"
+
+static _Atomic(unsigned) g_cls_next;
+static _Atomic(kc_cls_dtor_fn) g_cls_dtor[KCORO_CLS_KEYS];
+
+int kc_cls_key_create(kc_cls_key_t *out, kc_cls_dtor_fn dtor)
+{
+    if (!out) return -EINVAL;
+    unsigned k = atomic_load_explicit(&g_cls_next, memory_order_relaxed);
+    do {
+        if (k >= KCORO_CLS_KEYS) return -EAGAIN;
+    } while (!atomic_compare_exchange_weak_explicit(&g_cls_next, &k, k + 1,
+                                                    memory_order_relaxed, memory_order_relaxed));
+    atomic_store_explicit(&g_cls_dtor[k], dtor, memory_order_relaxed);
+    *out = k;
+    return 0;
+}
+
+static inline void **cls_slot(kcoro_t *co, kc_cls_key_t key)
+{
+    if (key < KCORO_CLS_INLINE) return &co->cls[key];
+    return co->cls_ext ? &co->cls_ext[key - KCORO_CLS_INLINE] : NULL;
+}
+
+void *kc_cls_get(kc_cls_key_t key)
+{
+    kcoro_t *co = kcoro_current();
+    if (!co || key >= KCORO_CLS_KEYS) return NULL;
+    void **slot = cls_slot(co, key);
+    return slot ? *slot : NULL;
+}
+
+int kc_cls_set(kc_cls_key_t key, void *value)
+{
+    if (key >= atomic_load_explicit(&g_cls_next, memory_order_relaxed)) return -EINVAL;
+    kcoro_t *co = kcoro_current();
+    if (!co) return -ESRCH;
+    void **slot = cls_slot(co, key);
+    if (!slot) {
+        if (!value) return 0;
+        co->cls_ext = (void**)calloc(KCORO_CLS_KEYS - KCORO_CLS_INLINE, sizeof(void*));
+        if (!co->cls_ext) return -ENOMEM;
+        slot = &co->cls_ext[key - KCORO_CLS_INLINE];
+    }
+    *slot = value;
+    if (value) co->cls_used = 1;
+    return 0;
+}
+
+void kc_cls_finish(kcoro_t *co)
+{
+    if (!co->cls_used) return;
+    unsigned nkeys = atomic_load_explicit(&g_cls_next, memory_order_relaxed);
+    if (nkeys > KCORO_CLS_KEYS) nkeys = KCORO_CLS_KEYS;
+    for (int pass = 0; pass < KCORO_CLS_DTOR_PASSES; pass++) {
+        int again = 0;
+        for (unsigned k = 0; k < nkeys; k++) {
+            void **slot = cls_slot(co, k);
+            if (!slot || !*slot) continue;
+            void *v = *slot;
+            *slot = NULL;
+            kc_cls_dtor_fn dtor = atomic_load_explicit(&g_cls_dtor[k], memory_order_relaxed);
+            if (dtor) { dtor(v); again = 1; }
+        }
+        if (!again) break;
+    }
+    free(co->cls_ext);
+    co->cls_ext = NULL;
+    co->cls_used = 0;
+}
@@ -0,0 +1,9 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include "../../include/kcoro_core.h"
+
+/* Run the destructors of co's coroutine-local values and drop its overflow
+ * table (kcoro_core.c: on finish and in kcoro_free). No-op for a coroutine
+ * that never set a value. */
+void kc_cls_finish(kcoro_t *co);
@@ -0,0 +1,158 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/*
+ * kc_cpu.c — CPU budget of the process
+ * ------------------------------------
+ *
+ * The budget is what the default scheduler sizes itself to: the CPUs in
+ * the calling thread's affinity mask, lowered to a cgroup CPU quota when
+ * one is set, and never below 1.
+ *
+ * cgroup v2: the "0::<path>" line of /proc/self/cgroup names our group
+ *   under the unified mount; cpu.max there holds "<quota> <period>" or
+ *   "max <period>". Limits of ancestor groups apply too, so every level up
+ *   to the mount is read and the smallest wins.
+ * cgroup v1: the line whose controller list has "cpu" names the group under
+ *   the cpu hierarchy (mounted as cpu,cpuacct, cpuacct,cpu or cpu);
+ *   cpu.cfs_quota_us (-1 => none) over cpu.cfs_period_us, per level as
+ *   above.
+ * A quota becomes CPUs rounded up: 1.5 CPUs of quota keep two workers
+ * busy for the whole period before throttling starts. Inside a cgroup
+ * namespace the group is "/" and the mount is the group itself, which the
+ * walk covers as its last level.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sched.h>
+
+#include "kcoro_sched.h"
+#include "kc_cpu_internal.h"
+
+#define KC_CPU_PATH_MAX 512
+
+/* Read one line of path into buf; 0 or -1. */
+static int cpu_read_line(const char *path, char *buf, size_t n)
+{
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+    char *ok = fgets(buf, (int)n, f);
+    fclose(f);
+    return ok ? 0 : -1;
+}
+
+/* CPUs (rounded up) of quota over period; 0 for no limit or bad values. */
+static int cpu_quota_cpus(long long quota, long long period)
+{
+    if (quota <= 0 || period <= 0) return 0;
+    long long n = (quota + period - 1) / period;
+    return n > INT_MAX ? INT_MAX : (int)n;
+}
+
+/* Limit in dir: cgroup v2 cpu.max or v1 cfs files; 0 when none. */
+static int cpu_dir_limit(const char *dir, int v2)
+{
+    char path[KC_CPU_PATH_MAX], line[128];
+    if (v2) {
+        if (snprintf(path, sizeof path, "%s/cpu.max", dir) >= (int)sizeof path) return 0;
+        if (cpu_read_line(path, line, sizeof line) != 0 || strncmp(line, "max", 3) == 0) return 0;
+        long long quota = 0, period = 0;
+        if (sscanf(line, "%lld %lld", &quota, &period) != 2) return 0;
+        return cpu_quota_cpus(quota, period);
+    }
+    long long quota = 0, period = 0;
+    if (snprintf(path, sizeof path, "%s/cpu.cfs_quota_us", dir) >= (int)sizeof path) return 0;
+    if (cpu_read_line(path, line, sizeof line) != 0 || sscanf(line, "%lld", &quota) != 1) return 0;
+    if (snprintf(path, sizeof path, "%s/cpu.cfs_period_us", dir) >= (int)sizeof path) return 0;
+    if (cpu_read_line(path, line, sizeof line) != 0 || sscanf(line, "%lld", &period) != 1) return 0;
+    return cpu_quota_cpus(quota, period);
+}
+
+/* Smallest limit from mount/group up to mount; 0 when none is set. */
+static int cpu_walk_limit(const char *mount, const char *group, int v2)
+{
+    char dir[KC_CPU_PATH_MAX];
+    if (snprintf(dir, sizeof dir, "%s%s", mount, strcmp(group, "/") == 0 ? "" : group) >= (int)sizeof dir)
+        return 0;
+    size_t root_len = strlen(mount);
+    int best = 0;
+    for (;;) {
+        int n = cpu_dir_limit(dir, v2);
+        if (n > 0 && (best == 0 || n < best)) best = n;
+        char *slash = strrchr(dir, '/');
+        if (strlen(dir) <= root_len || !slash || (size_t)(slash - dir) < root_len) break;
+        *slash = '\0';
+    }
+    return best;
+}
+
+/* 1 if the comma-separated controller list names "cpu". */
+static int cpu_has_controller(const char *list, size_t len)
+{
+    while (len) {
+        const char *comma = memchr(list, ',', len);
+        size_t n = comma ? (size_t)(comma - list) : len;
+        if (n == 3 && memcmp(list, "cpu", 3) == 0) return 1;
+        if (!comma) break;
+        len -= n + 1;
+        list = comma + 1;
+    }
+    return 0;
+}
+
+int kc_cpu_cgroup_limit(const char *proc_cgroup, const char *root)
+{
+    FILE *f = fopen(proc_cgroup, "r");
+    if (!f) return 0;
+    char line[KC_CPU_PATH_MAX], mount[KC_CPU_PATH_MAX];
+    int best = 0;
+    while (fgets(line, sizeof line, f)) {
+        line[strcspn(line, "\n")] = '\0';
+        /* hierarchy-id:controllers:path */
+        char *c1 = strchr(line, ':');
+        char *c2 = c1 ? strchr(c1 + 1, ':') : NULL;
+        if (!c2 || c2[1] != '/') continue;
+        const char *group = c2 + 1;
+        int n = 0;
+        if (strncmp(line, "0::", 3) == 0) {
+            n = cpu_walk_limit(root, group, 1);
+        } else if (cpu_has_controller(c1 + 1, (size_t)(c2 - c1 - 1))) {
+            static const char *const dirs[] = { "cpu,cpuacct", "cpuacct,cpu", "cpu" };
+            for (size_t i = 0; i < sizeof dirs / sizeof dirs[0] && !n; i++) {
+                if (snprintf(mount, sizeof mount, "%s/%s", root, dirs[i]) >= (int)sizeof mount) continue;
+                if (access(mount, R_OK) == 0) n = cpu_walk_limit(mount, group, 0);
+            }
+        }
+        if (n > 0 && (best == 0 || n < best)) best = n;
+    }
+    fclose(f);
+    return best;
+}
+
+/* CPUs the calling thread may run on. */
+static int cpu_affinity_count(void)
+{
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof set, &set) == 0) {
+        int n = CPU_COUNT(&set);
+        if (n > 0) return n;
+    }
+#endif
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n < 1) n = sysconf(_SC_NPROCESSORS_CONF);
+    if (n < 1) n = 1;
+    return n > INT_MAX ? INT_MAX : (int)n;
+}
+
+int kc_cpu_budget(void)
+{
+    int n = cpu_affinity_count();
+#ifdef __linux__
+    int quota = kc_cpu_cgroup_limit("/proc/self/cgroup", "/sys/fs/cgroup");
+    if (quota > 0 && quota < n) n = quota;
+#endif
+    return n < 1 ? 1 : n;
+}
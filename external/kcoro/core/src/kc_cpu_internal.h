@@ -0,0 +1,10 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+/* CPU budget internals (kc_cpu.c), split out so tests can point them at a
+ * fake cgroup tree. */
+
+/* Smallest cgroup CPU quota, in whole CPUs rounded up, over the groups that
+ * proc_cgroup (a /proc/<pid>/cgroup file) lists for the v2 mount at root or
+ * the v1 cpu mount under it, ancestors included; 0 when none is set. */
+int kc_cpu_cgroup_limit(const char *proc_cgroup, const char *root);
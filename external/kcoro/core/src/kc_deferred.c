@@ -0,0 +1,420 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/*
+ * kc_deferred.c — deferred values (kc_async / kc_await)
+ * -----------------------------------------------------
+ *
+ * State
+ * - `state` goes PENDING -> COMPLETED | FAILED | CANCELLED once, under the
+ *   deferred's spin flag: the settler writes value/code first and publishes
+ *   the state with release, so an awaiter that loads a settled state
+ *   (acquire) reads the result without taking the lock. A settled await is
+ *   one atomic load.
+ *
+ * Waiting
+ * - A deferred has one waiter slot, not a list: the common shape is one
+ *   awaiter per result, and the slot keeps both sides to a pointer store.
+ *   The record lives on the awaiter's stack (heap on a shared stack) and is
+ *   installed and removed under the flag; the settler fires it under the
+ *   flag too, so once the awaiter has taken its record back out of every
+ *   deferred nothing can touch it again. kc_await_any installs the same
+ *   record in each deferred it watches.
+ * - A coroutine parks through kc_sched_park_release. The hook flips the
+ *   record IDLE -> ARMED after switch-out; firing swaps in FIRED and only
+ *   enqueues the coroutine if it saw ARMED, so a settle that lands while
+ *   the awaiter is still running leaves the wake to the hook (the
+ *   kc_cancel_wait handshake, kc_cancel_internal.h). Deadlines ride the
+ *   scheduler timer as in kc_select_wait.
+ * - A plain thread waits on a condvar in its own record; _c tokens are
+ *   polled every KCORO_CANCEL_SLICE_MS there.
+ *
+ * kc_async
+ * - The body runs through kc_job_launch, so it is a child of the caller's
+ *   job and kc_deferred_cancel reaches it through the job token. Blocks are
+ *   recycled through a per-thread cache (KCORO_DEFERRED_CACHE_PER_THREAD).
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <time.h>
+
+#include "../../include/kc_deferred.h"
+#include "../../include/kcoro.h"
+#include "../../include/kcoro_core.h"
+#include "../../include/kcoro_sched.h"
+#include "../../include/kcoro_port.h"
+#include "../../include/kcoro_config.h"
+#include "kc_cancel_internal.h"
+#include "kc_clock_internal.h"
+#include "kcoro_share_internal.h"
+
+enum { DFR_WAIT_IDLE = 0, DFR_WAIT_ARMED = 1, DFR_WAIT_FIRED = 2 };
+
+struct dfr_waiter {
+    kcoro_t *co;             /* parked coroutine, or NULL for a thread */
+    kc_sched_t *sched;
+    atomic_int state;        /* coroutines: DFR_WAIT_* */
+    int woke;                /* threads: under m */
+    long long deadline_ns;   /* coroutines: this park's wake, set by the hook */
+    kc_timer_handle_t timer;
+    KC_MUTEX_T m;
+    KC_COND_T cv;
+};
+
+struct kc_deferred {
+    _Atomic int state;       /* kc_deferred_state_t */
+    _Atomic int refs;
+    atomic_flag lock;
+    int code;                /* FAILED: the failure code */
+    void *value;             /* COMPLETED: the value */
+    struct dfr_waiter *waiter; /* under lock */
+    kc_job_t *job;           /* kc_async: the body's job (a reference) */
+    kc_async_fn fn;
+    void *arg;
+    struct kc_deferred *next; /* free cache link */
+};
+
+/* Per-thread cache of free deferred blocks, linked through `next`. */
+struct dfr_cache { kc_deferred_t *head; unsigned count; };
+static __thread struct dfr_cache tls_dfrs;
+static pthread_key_t dfr_key;
+static pthread_once_t dfr_once = PTHREAD_ONCE_INIT;
+
+static void dfr_cache_drop(void *arg)
+{
+    (void)arg;
+    kc_deferred_t *d = tls_dfrs.head;
+    while (d) { kc_deferred_t *n = d->next; free(d); d = n; }
+    tls_dfrs.head = NULL;
+    tls_dfrs.count = 0;
+}
+
+static void dfr_key_init(void)
+{
+    (void)pthread_key_create(&dfr_key, dfr_cache_drop);
+}
+
+static kc_deferred_t *dfr_alloc(int refs)
+{
+    kc_deferred_t *d = tls_dfrs.head;
+    if (d) {
+        tls_dfrs.head = d->next;
+        tls_dfrs.count--;
+    } else if (!(d = (kc_deferred_t*)malloc(sizeof(*d)))) {
+        return NULL;
+    }
+    memset(d, 0, sizeof(*d));
+    atomic_flag_clear(&d->lock);
+    atomic_init(&d->state, KC_DEFERRED_PENDING);
+    atomic_init(&d->refs, refs);
+    return d;
+}
+
+static void dfr_free(kc_deferred_t *d)
+{
+    if (d->job) kc_job_release(d->job);
+    if (tls_dfrs.count >= KCORO_DEFERRED_CACHE_PER_THREAD) { free(d); return; }
+    if (!tls_dfrs.head) {
+        /* First block cached on this thread: free the cache at exit. */
+        pthread_once(&dfr_once, dfr_key_init);
+        (void)pthread_setspecific(dfr_key, &tls_dfrs);
+    }
+    d->next = tls_dfrs.head;
+    tls_dfrs.head = d;
+    tls_dfrs.count++;
+}
+
+static void dfr_lock(kc_deferred_t *d)
+{
+    while (atomic_flag_test_and_set_explicit(&d->lock, memory_order_acquire)) sched_yield();
+}
+
+static void dfr_unlock(kc_deferred_t *d)
+{
+    atomic_flag_clear_explicit(&d->lock, memory_order_release);
+}
+
+static int dfr_settled(const kc_deferred_t *d)
+{
+    return atomic_load_explicit(&((kc_deferred_t*)d)->state, memory_order_acquire) != KC_DEFERRED_PENDING;
+}
+
+/* Under the lock of the deferred that settled. Idempotent: kc_await_any's
+ * record can be fired by several deferreds before it is taken back. */
+static void dfr_fire(struct dfr_waiter *w)
+{
+    if (w->co) {
+        if (atomic_exchange(&w->state, DFR_WAIT_FIRED) == DFR_WAIT_ARMED)
+            kc_sched_enqueue_ready(w->sched, w->co);
+        return;
+    }
+    KC_MUTEX_LOCK(&w->m);
+    w->woke = 1;
+    KC_COND_SIGNAL(&w->cv);
+    KC_MUTEX_UNLOCK(&w->m);
+}
+
+static int dfr_settle(kc_deferred_t *d, int state, void *value, int code)
+{
+    dfr_lock(d);
+    if (atomic_load(&d->state) != KC_DEFERRED_PENDING) { dfr_unlock(d); return -EALREADY; }
+    d->value = value;
+    d->code = code;
+    atomic_store_explicit(&d->state, state, memory_order_release);
+    struct dfr_waiter *w = d->waiter;
+    d->waiter = NULL;
+    if (w) dfr_fire(w);
+    dfr_unlock(d);
+    return 0;
+}
+
+int kc_deferred_create(kc_deferred_t **out)
+{
+    if (!out) return -EINVAL;
+    *out = dfr_alloc(1);
+    return *out ? 0 : -ENOMEM;
+}
+
+static void dfr_entry(void *arg)
+{
+    kc_deferred_t *d = (kc_deferred_t*)arg;
+    void *value = NULL;
+    int rc = d->fn(d->arg, &value);
+    if (rc == KC_ECANCELED) (void)dfr_settle(d, KC_DEFERRED_CANCELLED, NULL, 0);
+    else if (rc < 0) (void)dfr_settle(d, KC_DEFERRED_FAILED, NULL, rc);
+    else (void)dfr_settle(d, KC_DEFERRED_COMPLETED, value, 0);
+    kc_deferred_release(d); /* the body's reference */
+}
+
+int kc_async(kc_async_fn fn, void *arg, kc_deferred_t **out)
+{
+    if (!out) return -EINVAL;
+    *out = NULL;
+    if (!fn) return -EINVAL;
+    kc_deferred_t *d = dfr_alloc(2); /* the caller's and the body's */
+    if (!d) return -ENOMEM;
+    d->fn = fn;
+    d->arg = arg;
+    kc_job_t *job = NULL;
+    int rc = kc_job_launch(NULL, NULL, dfr_entry, d, 0, &job);
+    if (rc != 0) { dfr_free(d); return rc; } /* the body never ran */
+    /* The caller's reference keeps d alive until it has seen *out. */
+    d->job = job;
+    *out = d;
+    return 0;
+}
+
+int kc_deferred_complete(kc_deferred_t *d, void *value)
+{
+    if (!d) return -EINVAL;
+    return dfr_settle(d, KC_DEFERRED_COMPLETED, value, 0);
+}
+
+int kc_deferred_fail(kc_deferred_t *d, int code)
+{
+    if (!d || code >= 0) return -EINVAL;
+    return dfr_settle(d, KC_DEFERRED_FAILED, NULL, code);
+}
+
+int kc_deferred_cancel(kc_deferred_t *d)
+{
+    if (!d) return -EINVAL;
+    int rc = dfr_settle(d, KC_DEFERRED_CANCELLED, NULL, 0);
+    if (rc == 0 && d->job) (void)kc_job_cancel(d->job, KC_ECANCELED);
+    return rc;
+}
+
+kc_deferred_state_t kc_deferred_state(const kc_deferred_t *d)
+{
+    if (!d) return KC_DEFERRED_FAILED;
+    return (kc_deferred_state_t)atomic_load_explicit(&((kc_deferred_t*)d)->state, memory_order_acquire);
+}
+
+void kc_deferred_release(kc_deferred_t *d)
+{
+    if (d && atomic_fetch_sub_explicit(&d->refs, 1, memory_order_acq_rel) == 1) dfr_free(d);
+}
+
+/* Result of a settled deferred. */
+static int dfr_result(const kc_deferred_t *d, void **result)
+{
+    switch (kc_deferred_state(d)) {
+    case KC_DEFERRED_COMPLETED:
+        if (result) *result = d->value;
+        return 0;
+    case KC_DEFERRED_FAILED:
+        if (result) *result = NULL;
+        return d->code;
+    default:
+        if (result) *result = NULL;
+        return KC_ECANCELED;
+    }
+}
+
+static long long dfr_now_ns(void)
+{
+    return (long long)kc_clock_ns();
+}
+
+static int dfr_scan(kc_deferred_t *const *ds, size_t n, size_t *index)
+{
+    for (size_t i = 0; i < n; i++)
+        if (dfr_settled(ds[i])) { *index = i; return 1; }
+    return 0;
+}
+
+/* Runs on the worker after the awaiter switched out. A settle (or a token)
+ * that fired while it was still running saw nothing to wake: the wake is
+ * ours. */
+static void dfr_park_release(void *arg)
+{
+    struct dfr_waiter *w = (struct dfr_waiter*)arg;
+    if (w->deadline_ns > 0)
+        w->timer = kc_sched_timer_wake_at(w->sched, w->co, (unsigned long long)w->deadline_ns);
+    int expected = DFR_WAIT_IDLE;
+    int fired = !atomic_compare_exchange_strong(&w->state, &expected, DFR_WAIT_ARMED);
+    int cancelled = kc_cancel_wait_arm(w->co);
+    if (fired || cancelled) kc_sched_enqueue_ready(w->sched, w->co);
+}
+
+/* Wait until one of ds settles (0, *index set), the deadline passes
+ * (KC_ETIME) or cancel fires (KC_ECANCELED). */
+static int dfr_wait(kc_deferred_t *const *ds, size_t n, long timeout_ms, const kc_cancel_t *cancel,
+                    size_t *index)
+{
+    for (size_t i = 0; i < n; i++) if (!ds[i]) return -EINVAL;
+    if (dfr_scan(ds, n, index)) return 0;
+    if (cancel && kc_cancel_is_set(cancel)) return KC_ECANCELED;
+    if (timeout_ms == 0) return KC_EAGAIN;
+
+    kcoro_t *co = kcoro_current();
+    kc_sched_t *s = kc_sched_current();
+    int as_co = co && s;
+    struct dfr_waiter local = { .co = as_co ? co : NULL, .sched = s };
+    atomic_init(&local.state, DFR_WAIT_IDLE);
+    struct dfr_waiter *w = as_co ? kcoro_park_record(co, &local, sizeof(local)) : &local;
+    if (!w) return -ENOMEM;
+    if (!as_co) {
+        KC_MUTEX_INIT(&w->m);
+        KC_COND_INIT(&w->cv);
+    }
+
+    int rc = 0;
+    size_t installed = 0;
+    for (; installed < n; installed++) {
+        kc_deferred_t *d = ds[installed];
+        dfr_lock(d);
+        if (d->waiter && d->waiter != w) { dfr_unlock(d); rc = -EBUSY; break; }
+        d->waiter = w;
+        dfr_unlock(d);
+    }
+
+    long long deadline_ns = timeout_ms > 0 ? dfr_now_ns() + (long long)timeout_ms * 1000000LL : -1;
+    struct kc_cancel_wait cw_local;
+    struct kc_cancel_wait *cw = NULL;
+    int cancelled = 0;
+    if (rc == 0 && cancel && as_co) cw = kc_cancel_wait_begin(&cw_local, cancel, &cancelled);
+    while (rc == 0) {
+        if (dfr_scan(ds, n, index)) break;
+        if (cancelled || (as_co && kc_cancel_wait_fired(co)) || (cancel && kc_cancel_is_set(cancel))) {
+            rc = KC_ECANCELED;
+            break;
+        }
+        long long now = (deadline_ns > 0 || (cancel && !cw)) ? dfr_now_ns() : 0;
+        if (deadline_ns > 0 && now >= deadline_ns) { rc = KC_ETIME; break; }
+        long long until = deadline_ns;
+        if (cancel && !cw) {
+            long long slice_ns = now + (long long)KCORO_CANCEL_SLICE_MS * 1000000LL;
+            if (until <= 0 || slice_ns < until) until = slice_ns;
+        }
+        if (as_co) {
+            if (atomic_load(&w->state) == DFR_WAIT_FIRED) continue;
+            w->deadline_ns = until;
+            w->timer = (kc_timer_handle_t){0};
+            if (kc_sched_park_release(dfr_park_release, w) != 0) {
+                /* Not on a worker after all: cooperative retry. */
+                kcoro_yield();
+                continue;
+            }
+            if (kc_cancel_wait_disarm(co)) cancelled = 1;
+            (void)kc_sched_timer_cancel(s, w->timer);
+            int armed = DFR_WAIT_ARMED;
+            (void)atomic_compare_exchange_strong(&w->state, &armed, DFR_WAIT_IDLE);
+        } else {
+            KC_MUTEX_LOCK(&w->m);
+            if (!w->woke) {
+                if (until <= 0) {
+                    KC_COND_WAIT(&w->cv, &w->m);
+                } else {
+                    struct timespec ts;
+                    kc_clock_abstime(&ts, KC_COND_CLOCK, (uint64_t)until);
+                    (void)KC_COND_TIMEDWAIT_ABS(&w->cv, &w->m, &ts);
+                }
+            }
+            KC_MUTEX_UNLOCK(&w->m);
+        }
+    }
+    kc_cancel_wait_end(cw);
+
+    /* Take the record back; a settler fires it under the same lock. */
+    for (size_t i = 0; i < installed; i++) {
+        kc_deferred_t *d = ds[i];
+        dfr_lock(d);
+        if (d->waiter == w) d->waiter = NULL;
+        dfr_unlock(d);
+    }
+    if (!as_co) {
+        KC_COND_DESTROY(&w->cv);
+        KC_MUTEX_DESTROY(&w->m);
+    }
+    kcoro_park_record_free(w, &local);
+    return rc;
+}
+
+int kc_await_c(kc_deferred_t *d, long timeout_ms, const kc_cancel_t *cancel, void **result)
+{
+    if (!d) return -EINVAL;
+    size_t i = 0;
+    if (!dfr_settled(d)) {
+        int rc = dfr_wait(&d, 1, timeout_ms, cancel, &i);
+        if (rc) { if (result) *result = NULL; return rc; }
+    }
+    return dfr_result(d, result);
+}
+
+int kc_await(kc_deferred_t *d, long timeout_ms, void **result)
+{
+    return kc_await_c(d, timeout_ms, NULL, result);
+}
+
+int kc_await_all(kc_deferred_t *const *ds, size_t n, long timeout_ms, void **results)
+{
+    if (!ds && n) return -EINVAL;
+    if (results) for (size_t i = 0; i < n; i++) results[i] = NULL;
+    long long deadline_ns = timeout_ms > 0 ? dfr_now_ns() + (long long)timeout_ms * 1000000LL : -1;
+    int first = 0;
+    for (size_t i = 0; i < n; i++) {
+        long left = timeout_ms;
+        if (deadline_ns > 0) {
+            long long ns = deadline_ns - dfr_now_ns();
+            /* Out of time: still collect whatever has settled. */
+            left = ns > 0 ? (long)((ns + 999999LL) / 1000000LL) : 0;
+        }
+        int rc = kc_await(ds[i], left, results ? &results[i] : NULL);
+        if (rc == KC_EAGAIN || rc == KC_ETIME) return timeout_ms == 0 ? KC_EAGAIN : KC_ETIME;
+        if (rc && !first) first = rc;
+    }
+    return first;
+}
+
+int kc_await_any(kc_deferred_t *const *ds, size_t n, long timeout_ms, size_t *index, void **result)
+{
+    if (!ds || n == 0) return -EINVAL;
+    size_t i = 0;
+    int rc = dfr_wait(ds, n, timeout_ms, NULL, &i);
+    if (rc) { if (result) *result = NULL; return rc; }
+    if (index) *index = i;
+    return dfr_result(ds[i], result);
+}
@@ -1,17 +1,19 @@
 // SPDX-License-Identifier: BSD-3-Clause
 
 #include "kcoro_dispatch.h"
+#include "kcoro_config.h"
+#include "kc_blocking_internal.h"
 
 #include <stdlib.h>
 #include <pthread.h>
 #include <stdatomic.h>
-#include <unistd.h>
-#include <limits.h>
+#include <errno.h>
 
 struct kc_dispatcher {
     kc_sched_t* sched;
     _Atomic int refcount;
     int owns_sched;
+    int blocking; /* kc_dispatcher_io: work runs on the elastic blocking pool */
 };
 
 typedef struct kc_dispatcher kc_dispatcher_impl_t;
@@ -28,15 +30,20 @@ static kc_dispatcher_impl_t* kc_dispatcher_alloc(kc_sched_t* sched, int owns_sch
     disp->sched = sched;
     atomic_init(&disp->refcount, 1);
     disp->owns_sched = owns_sched;
+    disp->blocking = 0;
     return disp;
 }
 
+kc_dispatcher_t* kc_dispatcher_new_opts(const kc_sched_opts_t* opts) {
+    kc_sched_t* sched = kc_sched_init(opts);
+    if (!sched) return NULL;
+    return kc_dispatcher_alloc(sched, 1);
+}
+
 kc_dispatcher_t* kc_dispatcher_new(int workers) {
     kc_sched_opts_t opts = {0};
     opts.workers = workers;
-    kc_sched_t* sched = kc_sched_init(&opts);
-    if (!sched) return NULL;
-    return kc_dispatcher_alloc(sched, 1);
+    return kc_dispatcher_new_opts(&opts);
 }
 
 kc_dispatcher_t* kc_dispatcher_retain(kc_dispatcher_t* dispatcher) {
@@ -55,17 +62,20 @@ void kc_dispatcher_release(kc_dispatcher_t* dispatcher) {
     }
 }
 
-static long kc_suggest_ncpu(void) {
-    long n = sysconf(_SC_NPROCESSORS_ONLN);
-    if (n < 1) n = sysconf(_SC_NPROCESSORS_CONF);
-    if (n < 1) n = 1;
-    if (n > INT_MAX) n = INT_MAX;
-    return n;
-}
-
 static pthread_mutex_t g_dispatch_mu = PTHREAD_MUTEX_INITIALIZER;
 static kc_dispatcher_impl_t* g_default_dispatcher = NULL;
 static kc_dispatcher_impl_t* g_io_dispatcher = NULL;
+int kc_dispatcher_set_io_opts(const kc_sched_opts_t* opts) {
+    pthread_mutex_lock(&g_dispatch_mu);
+    if (g_io_dispatcher) {
+        pthread_mutex_unlock(&g_dispatch_mu);
+        return -EBUSY;
+    }
+    int rc = opts ? kc_blocking_set_limits(opts->workers, opts->cpus, opts->ncpus)
+                  : kc_blocking_set_limits(KCORO_BLOCKING_MAX_THREADS, NULL, 0);
+    pthread_mutex_unlock(&g_dispatch_mu);
+    return rc;
+}
 
 kc_dispatcher_t* kc_dispatcher_default(void) {
     pthread_mutex_lock(&g_dispatch_mu);
@@ -81,12 +91,10 @@ kc_dispatcher_t* kc_dispatcher_default(void) {
 kc_dispatcher_t* kc_dispatcher_io(void) {
     pthread_mutex_lock(&g_dispatch_mu);
     if (!g_io_dispatcher) {
-        long ncpu = kc_suggest_ncpu();
-        int workers = (int)ncpu;
-        if (workers < 1) workers = 1;
-        if (workers < 64) workers = 64;
-        kc_dispatcher_t* disp = kc_dispatcher_new(workers);
-        g_io_dispatcher = disp;
+        /* No scheduler of its own: coroutines leaving the pool (yield or
+         * kc_sched_block_end) continue on the default scheduler. */
+        g_io_dispatcher = kc_dispatcher_alloc(kc_sched_default(), 0);
+        if (g_io_dispatcher) g_io_dispatcher->blocking = 1;
     }
     kc_dispatcher_t* result = kc_dispatcher_retain(g_io_dispatcher);
     pthread_mutex_unlock(&g_dispatch_mu);
@@ -100,6 +108,7 @@ kc_sched_t* kc_dispatcher_scheduler(kc_dispatcher_t* dispatcher) {
 
 int kc_dispatcher_spawn(kc_dispatcher_t* dispatcher, kc_task_fn fn, void* arg) {
     if (!dispatcher || !fn) return -1;
+    if (dispatcher->blocking) return kc_blocking_spawn(fn, arg);
     return kc_spawn(dispatcher->sched, fn, arg);
 }
 
@@ -109,5 +118,18 @@ int kc_dispatcher_spawn_co(kc_dispatcher_t* dispatcher,
                            size_t stack_size,
                            kcoro_t** out_co) {
     if (!dispatcher || !fn) return -1;
+    if (dispatcher->blocking) {
+        kcoro_t* co = kcoro_create(fn, arg, stack_size);
+        if (!co) return -1;
+        co->scheduler = (kcoro_sched_t*)dispatcher->sched;
+        kcoro_retain(co); /* the pool's hold */
+        if (kc_blocking_submit_co(co, dispatcher->sched) != 0) {
+            kcoro_release(co);
+            kcoro_release(co);
+            return -1;
+        }
+        if (out_co) *out_co = co;
+        return 0;
+    }
     return kc_spawn_co(dispatcher->sched, fn, arg, stack_size, out_co);
 }
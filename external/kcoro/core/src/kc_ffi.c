@@ -0,0 +1,316 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/*
+ * kc_ffi.c — batch channel calls and polled ops for foreign bindings
+ * ------------------------------------------------------------------
+ *
+ * Synchronous calls
+ * - Thin: the _many_thread batch calls, with the count folded into the
+ *   result so a binding needs no out-parameter.
+ *
+ * Ops
+ * - An op is a heap record and a coroutine on the default scheduler. The
+ *   body moves whatever is ready as one batch (timeout 0), and when stalled
+ *   waits for a single element on the cancellable call, then batches again,
+ *   so cancellation is prompt and a waiting op costs a parked coroutine.
+ * - state holds KC_EAGAIN until the body stores its result; poll is that
+ *   one load. The mutex and condvar are only for kc_ffi_op_wait / _free,
+ *   and the body touches the op for the last time under the mutex, so a
+ *   waiter may free it as soon as it sees the result.
+ * - Pointer descriptors travel as kc_chan_ptrmsg; the parallel arrays are
+ *   packed into and unpacked from stack chunks of FFI_PTR_CHUNK.
+ */
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include "../../include/kcoro.h"
+#include "../../include/kcoro_ffi.h"
+#include "../../include/kcoro_port.h"
+#include "../../include/kcoro_core.h"
+#include "../../include/kcoro_sched.h"
+#include "kc_chan_internal.h"
+#include "kc_clock_internal.h"
+
+#define FFI_PTR_CHUNK 64
+
+enum { FFI_SEND, FFI_RECV, FFI_SEND_PTRS, FFI_RECV_PTRS };
+
+struct kc_ffi_op {
+    int kind;
+    kc_chan_t *ch;
+    void *buf;
+    void **ptrs;
+    size_t *lens;
+    size_t n;
+    long timeout_ms;
+    kc_cancel_t *cancel;
+    atomic_int state;
+    _Atomic long count;
+    pthread_mutex_t mu;
+    pthread_cond_t cv;
+};
+
+kc_chan_t *kc_ffi_chan_new(int kind, size_t elem_sz, size_t capacity)
+{
+    kc_chan_t *ch = NULL;
+    return kc_chan_make(&ch, kind, elem_sz, capacity) == 0 ? ch : NULL;
+}
+
+kc_chan_t *kc_ffi_chan_new_ptr(int kind, size_t capacity)
+{
+    kc_chan_t *ch = NULL;
+    return kc_chan_make_ptr(&ch, kind, capacity) == 0 ? ch : NULL;
+}
+
+void kc_ffi_chan_close(kc_chan_t *ch) { if (ch) kc_chan_close(ch); }
+void kc_ffi_chan_free(kc_chan_t *ch) { if (ch) kc_chan_destroy(ch); }
+long kc_ffi_chan_len(kc_chan_t *ch) { return ch ? (long)kc_chan_len(ch) : -EINVAL; }
+
+size_t kc_ffi_chan_elem_size(const kc_chan_t *c)
+{
+    const struct kc_chan *ch = (const struct kc_chan*)c;
+    return ch && !ch->ptr_mode ? ch->elem_sz : 0;
+}
+
+static long ffi_result(int rc, size_t moved)
+{
+    return moved || rc == 0 ? (long)moved : (long)rc;
+}
+
+long kc_ffi_send(kc_chan_t *ch, const void *src, size_t n, long timeout_ms)
+{
+    size_t sent = 0;
+    int rc = kc_chan_send_many_thread(ch, src, n, timeout_ms, &sent);
+    return ffi_result(rc, sent);
+}
+
+long kc_ffi_recv(kc_chan_t *ch, void *dst, size_t max, long timeout_ms)
+{
+    size_t got = 0;
+    int rc = kc_chan_recv_many_thread(ch, dst, max, timeout_ms, &got);
+    return ffi_result(rc, got);
+}
+
+#define KC_FFI_TYPED(suffix, type)                                                          \
+    long kc_ffi_send_##suffix(kc_chan_t *ch, const type *src, size_t n, long timeout_ms)   \
+    {                                                                                       \
+        if (kc_ffi_chan_elem_size(ch) != sizeof(type)) return -EINVAL;                      \
+        return kc_ffi_send(ch, src, n, timeout_ms);                                         \
+    }                                                                                       \
+    long kc_ffi_recv_##suffix(kc_chan_t *ch, type *dst, size_t max, long timeout_ms)       \
+    {                                                                                       \
+        if (kc_ffi_chan_elem_size(ch) != sizeof(type)) return -EINVAL;                      \
+        return kc_ffi_recv(ch, dst, max, timeout_ms);                                       \
+    }
+
+KC_FFI_TYPED(f32, float)
+KC_FFI_TYPED(f64, double)
+KC_FFI_TYPED(i32, int32_t)
+KC_FFI_TYPED(i64, int64_t)
+KC_FFI_TYPED(u8, uint8_t)
+
+/* ----------------------------------------------------------------- ops */
+
+/* Time left for one stalled wait; KC_ETIME once the op's budget is spent. */
+static int ffi_slice(const kc_ffi_op_t *op, long deadline_ns, long *slice_ms)
+{
+    if (op->timeout_ms <= 0) { *slice_ms = op->timeout_ms; return 0; }
+    long left = deadline_ns - kc_now_ns();
+    if (left <= 0) return KC_ETIME;
+    *slice_ms = (left + 999999L) / 1000000L;
+    return 0;
+}
+
+static int ffi_send_body(kc_ffi_op_t *op, long deadline_ns)
+{
+    const unsigned char *src = op->buf;
+    size_t sz = ((struct kc_chan*)op->ch)->elem_sz, done = 0;
+    int rc = 0;
+    while (done < op->n) {
+        size_t k = 0;
+        rc = kc_chan_send_many(op->ch, src + done * sz, op->n - done, 0, &k);
+        done += k;
+        atomic_store_explicit(&op->count, (long)done, memory_order_relaxed);
+        if (rc != KC_EAGAIN) break;
+        long slice;
+        if ((rc = ffi_slice(op, deadline_ns, &slice)) != 0 ||
+            (rc = kc_chan_send_c(op->ch, src + done * sz, slice, op->cancel)) != 0)
+            break;
+        atomic_store_explicit(&op->count, (long)++done, memory_order_relaxed);
+    }
+    return rc;
+}
+
+static int ffi_recv_body(kc_ffi_op_t *op)
+{
+    unsigned char *dst = op->buf;
+    size_t sz = ((struct kc_chan*)op->ch)->elem_sz, got = 0;
+    int rc = kc_chan_recv_many(op->ch, dst, op->n, 0, &got);
+    if (rc == KC_EAGAIN && op->timeout_ms != 0 &&
+        (rc = kc_chan_recv_c(op->ch, dst, op->timeout_ms, op->cancel)) == 0) {
+        size_t k = 0;
+        got = 1;
+        if (got < op->n && kc_chan_recv_many(op->ch, dst + sz, op->n - 1, 0, &k) == 0) got += k;
+    }
+    atomic_store_explicit(&op->count, (long)got, memory_order_relaxed);
+    return rc;
+}
+
+static int ffi_send_ptrs_body(kc_ffi_op_t *op, long deadline_ns)
+{
+    struct kc_chan_ptrmsg m[FFI_PTR_CHUNK];
+    size_t done = 0;
+    int rc = 0;
+    while (done < op->n) {
+        size_t c = op->n - done < FFI_PTR_CHUNK ? op->n - done : FFI_PTR_CHUNK, k = 0;
+        for (size_t i = 0; i < c; i++) { m[i].ptr = op->ptrs[done + i]; m[i].len = op->lens[done + i]; }
+        rc = kc_chan_send_ptr_many(op->ch, m, c, 0, &k);
+        done += k;
+        atomic_store_explicit(&op->count, (long)done, memory_order_relaxed);
+        if (rc == 0) continue;
+        if (rc != KC_EAGAIN) break;
+        long slice;
+        if ((rc = ffi_slice(op, deadline_ns, &slice)) != 0 ||
+            (rc = kc_chan_send_ptr_c(op->ch, op->ptrs[done], op->lens[done], slice, op->cancel)) != 0)
+            break;
+        atomic_store_explicit(&op->count, (long)++done, memory_order_relaxed);
+    }
+    return rc;
+}
+
+static int ffi_recv_ptrs_body(kc_ffi_op_t *op)
+{
+    struct kc_chan_ptrmsg m[FFI_PTR_CHUNK];
+    size_t got = 0;
+    int rc = KC_EAGAIN;
+    if (op->timeout_ms != 0) {
+        /* Wait for the first one, then batch whatever else is there */
+        rc = kc_chan_recv_ptr_c(op->ch, &op->ptrs[0], &op->lens[0], op->timeout_ms, op->cancel);
+        if (rc != 0) return rc;
+        got = 1;
+    }
+    while (got < op->n) {
+        size_t c = op->n - got < FFI_PTR_CHUNK ? op->n - got : FFI_PTR_CHUNK, k = 0;
+        int r = kc_chan_recv_ptr_many(op->ch, m, c, 0, &k);
+        for (size_t i = 0; i < k; i++) { op->ptrs[got + i] = m[i].ptr; op->lens[got + i] = m[i].len; }
+        got += k;
+        if (r != 0) { if (!got) rc = r; break; }
+        rc = 0;
+        if (k < c) break;
+    }
+    atomic_store_explicit(&op->count, (long)got, memory_order_relaxed);
+    return got ? 0 : rc;
+}
+
+static void ffi_op_co(void *arg)
+{
+    kc_ffi_op_t *op = arg;
+    long deadline_ns = op->timeout_ms > 0 ? kc_now_ns() + op->timeout_ms * 1000000L : 0;
+    int rc;
+    switch (op->kind) {
+    case FFI_SEND:      rc = ffi_send_body(op, deadline_ns); break;
+    case FFI_RECV:      rc = ffi_recv_body(op); break;
+    case FFI_SEND_PTRS: rc = ffi_send_ptrs_body(op, deadline_ns); break;
+    default:            rc = ffi_recv_ptrs_body(op); break;
+    }
+    pthread_mutex_lock(&op->mu);
+    atomic_store_explicit(&op->state, rc, memory_order_release);
+    pthread_cond_broadcast(&op->cv);
+    pthread_mutex_unlock(&op->mu);
+}
+
+static kc_ffi_op_t *ffi_op_start(int kind, kc_chan_t *ch, void *buf, void **ptrs, size_t *lens,
+                                 size_t n, long timeout_ms)
+{
+    struct kc_chan *c = (struct kc_chan*)ch;
+    int ptr = kind == FFI_SEND_PTRS || kind == FFI_RECV_PTRS;
+    if (!c || c->zref_mode || !c->ptr_mode != !ptr) return NULL;
+    if (ptr ? (n && (!ptrs || !lens)) : (n && !buf)) return NULL;
+    if ((kind == FFI_RECV || kind == FFI_RECV_PTRS) && n == 0) return NULL;
+    kc_ffi_op_t *op = calloc(1, sizeof(*op));
+    if (!op) return NULL;
+    *op = (kc_ffi_op_t){ .kind = kind, .ch = ch, .buf = buf, .ptrs = ptrs, .lens = lens,
+                         .n = n, .timeout_ms = timeout_ms };
+    atomic_init(&op->state, KC_EAGAIN);
+    pthread_mutex_init(&op->mu, NULL);
+    kc_posix_cond_init_monotonic(&op->cv);
+    if (kc_cancel_init(&op->cancel) != 0) goto fail;
+    if (kc_spawn_co(kc_sched_default(), ffi_op_co, op, 0, NULL) != 0) goto fail;
+    return op;
+fail:
+    if (op->cancel) kc_cancel_destroy(op->cancel);
+    pthread_cond_destroy(&op->cv);
+    pthread_mutex_destroy(&op->mu);
+    free(op);
+    return NULL;
+}
+
+kc_ffi_op_t *kc_ffi_send_async(kc_chan_t *ch, const void *src, size_t n, long timeout_ms)
+{
+    return ffi_op_start(FFI_SEND, ch, (void*)src, NULL, NULL, n, timeout_ms);
+}
+
+kc_ffi_op_t *kc_ffi_recv_async(kc_chan_t *ch, void *dst, size_t max, long timeout_ms)
+{
+    return ffi_op_start(FFI_RECV, ch, dst, NULL, NULL, max, timeout_ms);
+}
+
+kc_ffi_op_t *kc_ffi_send_ptrs_async(kc_chan_t *ch, void *const *ptrs, const size_t *lens, size_t n, long timeout_ms)
+{
+    return ffi_op_start(FFI_SEND_PTRS, ch, NULL, (void**)ptrs, (size_t*)lens, n, timeout_ms);
+}
+
+kc_ffi_op_t *kc_ffi_recv_ptrs_async(kc_chan_t *ch, void **ptrs, size_t *lens, size_t max, long timeout_ms)
+{
+    return ffi_op_start(FFI_RECV_PTRS, ch, NULL, ptrs, lens, max, timeout_ms);
+}
+
+int kc_ffi_op_poll(kc_ffi_op_t *op)
+{
+    return op ? atomic_load_explicit(&op->state, memory_order_acquire) : -EINVAL;
+}
+
+long kc_ffi_op_count(kc_ffi_op_t *op)
+{
+    return op ? atomic_load_explicit(&op->count, memory_order_relaxed) : -EINVAL;
+}
+
+int kc_ffi_op_wait(kc_ffi_op_t *op, long timeout_ms)
+{
+    if (!op) return -EINVAL;
+    int rc = kc_ffi_op_poll(op);
+    if (rc != KC_EAGAIN || timeout_ms == 0) return rc;
+    struct timespec ts;
+    if (timeout_ms > 0) kc_clock_abstime_ms(&ts, KC_PORT_PTHREAD_COND_CLOCK, timeout_ms);
+    pthread_mutex_lock(&op->mu);
+    while ((rc = atomic_load_explicit(&op->state, memory_order_acquire)) == KC_EAGAIN) {
+        if (timeout_ms < 0) pthread_cond_wait(&op->cv, &op->mu);
+        else if (pthread_cond_timedwait(&op->cv, &op->mu, &ts) == ETIMEDOUT) break;
+    }
+    pthread_mutex_unlock(&op->mu);
+    return rc;
+}
+
+void kc_ffi_op_cancel(kc_ffi_op_t *op)
+{
+    if (op) kc_cancel_trigger(op->cancel);
+}
+
+void kc_ffi_op_free(kc_ffi_op_t *op)
+{
+    if (!op) return;
+    if (kc_ffi_op_poll(op) == KC_EAGAIN) {
+        /* The token stays set: a wait the body has yet to enter ends at once */
+        kc_ffi_op_cancel(op);
+        (void)kc_ffi_op_wait(op, -1);
+    }
+    /* The body's last touch was under mu */
+    pthread_mutex_lock(&op->mu);
+    pthread_mutex_unlock(&op->mu);
+    kc_cancel_destroy(op->cancel);
+    pthread_cond_destroy(&op->cv);
+    pthread_mutex_destroy(&op->mu);
+    free(op);
+}
@@ -0,0 +1,503 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Flows: pipelines of fused stages.
+ *
+ * A flow is a list of segments, each run by `width` coroutines of the
+ * flow's scope. A segment takes `batch` elements at a time (KCORO_FLOW_BATCH
+ * or the runtime config's channel.flow_batch, read as it starts) from
+ * its input channel and pushes each through its stages by plain calls;
+ * what comes out the last stage collects in an output run that goes on with
+ * one kc_chan_send_many. Segments are split only where the width changes,
+ * so building map/filter/map costs no channel at all.
+ *
+ * Channels between segments are links: the coroutines writing one count
+ * down as they finish and the last closes it, which ends the segments
+ * reading it in turn. Stage counters are per-coroutine locals added to the
+ * stage's atomics once per input batch. */
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdatomic.h>
+
+#include "../../include/kcoro.h"
+#include "../../include/kcoro_port.h"
+#include "../../include/kcoro_config.h"
+#include "../../include/kcoro_config_runtime.h"
+#include "../../include/kcoro_sched.h"
+#include "kc_chan_internal.h"
+
+enum kc_flow_op_kind {
+    KC_FLOW_OP_MAP,
+    KC_FLOW_OP_FILTER,
+    KC_FLOW_OP_BATCH,
+    KC_FLOW_OP_EACH
+};
+
+struct kc_flow_op {
+    enum kc_flow_op_kind kind;
+    kc_transform_fn map;
+    kc_flow_pred_fn pred;
+    kc_flow_each_fn each;
+    void *user;
+    size_t in_sz, out_sz;
+    size_t batch_n;
+    _Atomic unsigned long in, out;
+    _Atomic long first_ns, last_ns;
+};
+
+struct kc_flow_link {
+    kc_chan_t *ch;
+    _Atomic int writers;   /* coroutines still sending; the last closes ch */
+    int owned;             /* created by the flow (freed with it) */
+    struct kc_flow_link *next;
+};
+
+struct kc_flow_seg {
+    struct kc_flow *flow;
+    kc_chan_t *in;             /* source or a link's channel */
+    int in_link;               /* in belongs to the flow */
+    size_t in_sz;
+    int width;
+    int first_op, nops;        /* flow->ops[first_op, first_op + nops) */
+    struct kc_flow_link *out;  /* NULL: results are not forwarded */
+    size_t out_sz;
+};
+
+struct kc_flow {
+    kc_scope_t *scope;
+    size_t cur_sz;                 /* element size after the last stage */
+    struct kc_flow_op *ops;
+    int nops, cap_ops;
+    struct kc_flow_seg *segs;
+    int nsegs, cap_segs;
+    struct kc_flow_link *links;    /* every link a segment of this flow reads */
+    struct kc_flow **inputs;       /* kc_flow_merge */
+    int ninputs;
+    struct kc_flow *root;          /* merged into / launched as part of */
+    int launched;
+    _Atomic int running;           /* coroutines of the whole tree (root only) */
+};
+
+int kc_flow_create(kc_flow_t **out, kc_scope_t *scope, kc_chan_t *src, size_t elem_sz)
+{
+    if (!out || !scope || !src || elem_sz == 0) return -EINVAL;
+    struct kc_flow *f = calloc(1, sizeof(*f));
+    if (!f) return -ENOMEM;
+    f->segs = calloc(4, sizeof(*f->segs));
+    if (!f->segs) { free(f); return -ENOMEM; }
+    f->cap_segs = 4;
+    f->nsegs = 1;
+    f->segs[0] = (struct kc_flow_seg){ .flow = f, .in = src, .in_sz = elem_sz, .width = 1,
+                                      .out_sz = elem_sz };
+    f->scope = scope;
+    f->cur_sz = elem_sz;
+    f->root = f;
+    *out = f;
+    return 0;
+}
+
+/* The flow a tree of merges launches as (it holds the running count). */
+static struct kc_flow *kc_flow_root(struct kc_flow *f)
+{
+    while (f->root != f) f = f->root;
+    return f;
+}
+
+static struct kc_flow_seg *kc_flow_tail(struct kc_flow *f)
+{
+    return &f->segs[f->nsegs - 1];
+}
+
+static int kc_flow_buildable(const struct kc_flow *f)
+{
+    if (f->launched || f->root != f) return -EBUSY;
+    const struct kc_flow_seg *t = &f->segs[f->nsegs - 1];
+    /* Nothing follows a terminal stage */
+    if (t->nops && f->ops[t->first_op + t->nops - 1].kind == KC_FLOW_OP_EACH) return -EINVAL;
+    return 0;
+}
+
+static size_t kc_flow_chan_cap(void)
+{
+    int cap = kc_runtime_config_get()->chan_flow_capacity;
+    return cap > 0 ? (size_t)cap : KCORO_FLOW_CHAN_CAP;
+}
+
+static struct kc_flow_link *kc_flow_link_new(struct kc_flow *f, size_t elem_sz)
+{
+    struct kc_flow_link *l = calloc(1, sizeof(*l));
+    if (!l) return NULL;
+    if (kc_chan_make(&l->ch, KC_BUFFERED, elem_sz, kc_flow_chan_cap()) != 0) { free(l); return NULL; }
+    l->owned = 1;
+    l->next = f->links;
+    f->links = l;
+    return l;
+}
+
+/* Start a segment of the given width fed by the current tail through a new
+ * link. */
+static int kc_flow_split(struct kc_flow *f, int width)
+{
+    if (f->nsegs == f->cap_segs) {
+        struct kc_flow_seg *ns = realloc(f->segs, (size_t)f->cap_segs * 2 * sizeof(*ns));
+        if (!ns) return -ENOMEM;
+        f->segs = ns;
+        f->cap_segs *= 2;
+    }
+    struct kc_flow_link *l = kc_flow_link_new(f, f->cur_sz);
+    if (!l) return -ENOMEM;
+    kc_flow_tail(f)->out = l;
+    f->segs[f->nsegs++] = (struct kc_flow_seg){ .flow = f, .in = l->ch, .in_link = 1, .in_sz = f->cur_sz,
+                                               .width = width, .first_op = f->nops,
+                                               .out_sz = f->cur_sz };
+    return 0;
+}
+
+/* Append a stage to the tail segment; returns its index. */
+static int kc_flow_push_op(struct kc_flow *f, const struct kc_flow_op *op)
+{
+    if (f->nops == f->cap_ops) {
+        int cap = f->cap_ops ? f->cap_ops * 2 : 8;
+        struct kc_flow_op *no = realloc(f->ops, (size_t)cap * sizeof(*no));
+        if (!no) return -ENOMEM;
+        f->ops = no;
+        f->cap_ops = cap;
+    }
+    int i = f->nops++;
+    f->ops[i] = *op;
+    f->ops[i].in_sz = f->cur_sz;
+    f->cur_sz = op->out_sz;
+    struct kc_flow_seg *t = kc_flow_tail(f);
+    t->nops++;
+    t->out_sz = f->cur_sz;
+    return i;
+}
+
+int kc_flow_map(kc_flow_t *f, kc_transform_fn fn, size_t out_sz, void *user)
+{
+    if (!f || !fn || out_sz == 0) return -EINVAL;
+    int rc = kc_flow_buildable(f);
+    if (rc != 0) return rc;
+    return kc_flow_push_op(f, &(struct kc_flow_op){ .kind = KC_FLOW_OP_MAP, .map = fn, .user = user,
+                                                   .out_sz = out_sz });
+}
+
+int kc_flow_filter(kc_flow_t *f, kc_flow_pred_fn fn, void *user)
+{
+    if (!f || !fn) return -EINVAL;
+    int rc = kc_flow_buildable(f);
+    if (rc != 0) return rc;
+    return kc_flow_push_op(f, &(struct kc_flow_op){ .kind = KC_FLOW_OP_FILTER, .pred = fn, .user = user,
+                                                   .out_sz = f->cur_sz });
+}
+
+int kc_flow_batch(kc_flow_t *f, size_t n)
+{
+    if (!f || n == 0) return -EINVAL;
+    int rc = kc_flow_buildable(f);
+    if (rc != 0) return rc;
+    /* A chunk collects consecutive elements: one coroutine only */
+    if (kc_flow_tail(f)->width > 1 && (rc = kc_flow_split(f, 1)) != 0) return rc;
+    return kc_flow_push_op(f, &(struct kc_flow_op){ .kind = KC_FLOW_OP_BATCH, .batch_n = n,
+                                                   .out_sz = KC_FLOW_CHUNK_SIZE(n, f->cur_sz) });
+}
+
+int kc_flow_parallel_map(kc_flow_t *f, int n, kc_transform_fn fn, size_t out_sz, void *user)
+{
+    if (!f || n <= 0 || !fn || out_sz == 0) return -EINVAL;
+    int rc = kc_flow_buildable(f);
+    if (rc != 0) return rc;
+    struct kc_flow_seg *t = kc_flow_tail(f);
+    if (n != t->width) {
+        /* A segment with no stages yet just reads its input n-wide */
+        if (t->nops == 0) t->width = n;
+        else if ((rc = kc_flow_split(f, n)) != 0) return rc;
+    }
+    return kc_flow_push_op(f, &(struct kc_flow_op){ .kind = KC_FLOW_OP_MAP, .map = fn, .user = user,
+                                                   .out_sz = out_sz });
+}
+
+int kc_flow_each(kc_flow_t *f, kc_flow_each_fn fn, void *user)
+{
+    if (!f || !fn) return -EINVAL;
+    int rc = kc_flow_buildable(f);
+    if (rc != 0) return rc;
+    return kc_flow_push_op(f, &(struct kc_flow_op){ .kind = KC_FLOW_OP_EACH, .each = fn, .user = user,
+                                                   .out_sz = f->cur_sz });
+}
+
+int kc_flow_merge(kc_flow_t **out, kc_flow_t *const *flows, int n)
+{
+    if (!out || !flows || n <= 0 || !flows[0]) return -EINVAL;
+    size_t sz = flows[0]->cur_sz;
+    for (int i = 0; i < n; i++) {
+        if (!flows[i] || flows[i]->cur_sz != sz || flows[i]->scope != flows[0]->scope) return -EINVAL;
+        int rc = kc_flow_buildable(flows[i]);
+        if (rc != 0) return rc;
+        for (int j = 0; j < i; j++) if (flows[j] == flows[i]) return -EINVAL;
+    }
+    struct kc_flow *m = calloc(1, sizeof(*m));
+    if (!m) return -ENOMEM;
+    m->segs = calloc(4, sizeof(*m->segs));
+    m->inputs = malloc((size_t)n * sizeof(*m->inputs));
+    struct kc_flow_link *l = (m->segs && m->inputs) ? kc_flow_link_new(m, sz) : NULL;
+    if (!l) { free(m->segs); free(m->inputs); free(m); return -ENOMEM; }
+    m->cap_segs = 4;
+    m->nsegs = 1;
+    m->segs[0] = (struct kc_flow_seg){ .flow = m, .in = l->ch, .in_link = 1, .in_sz = sz, .width = 1,
+                                      .out_sz = sz };
+    m->scope = flows[0]->scope;
+    m->cur_sz = sz;
+    m->root = m;
+    for (int i = 0; i < n; i++) {
+        m->inputs[i] = flows[i];
+        flows[i]->root = m;
+        kc_flow_tail(flows[i])->out = l;
+    }
+    m->ninputs = n;
+    *out = m;
+    return 0;
+}
+
+/* Per-coroutine state of one segment. */
+struct kc_flow_run {
+    struct kc_flow_seg *seg;
+    struct kc_flow_op *ops;
+    const kc_cancel_t *tok;
+    unsigned char **scratch;   /* per stage: map output or batch chunk */
+    unsigned long *in, *out;   /* per stage, since the last flush */
+    unsigned char *obuf;       /* output run */
+    size_t on, batch;          /* elements in / per output run */
+    int failed;                /* downstream gone or cancelled */
+};
+
+/* Send n elements, parking (cancellably) only when the channel is full. */
+static int kc_flow_send(kc_chan_t *ch, const unsigned char *buf, size_t n, size_t sz, const kc_cancel_t *tok)
+{
+    size_t sent = 0;
+    int rc = kc_chan_send_many(ch, buf, n, 0, &sent);
+    while (rc == KC_EAGAIN && sent < n) {
+        rc = kc_chan_send_c(ch, buf + sent * sz, -1, tok);
+        if (rc != 0) break;
+        sent++;
+        size_t more = 0;
+        rc = sent < n ? kc_chan_send_many(ch, buf + sent * sz, n - sent, 0, &more) : 0;
+        sent += more;
+    }
+    return rc;
+}
+
+static int kc_flow_recv(kc_chan_t *ch, unsigned char *buf, size_t max, size_t sz,
+                        const kc_cancel_t *tok, size_t *got)
+{
+    int rc = kc_chan_recv_many(ch, buf, max, 0, got);
+    if (rc != KC_EAGAIN) return rc;
+    rc = kc_chan_recv_c(ch, buf, -1, tok);
+    if (rc != 0) return rc;
+    size_t more = 0;
+    if (max > 1 && kc_chan_recv_many(ch, buf + sz, max - 1, 0, &more) != 0) more = 0;
+    *got = 1 + more;
+    return 0;
+}
+
+static void kc_flow_flush_out(struct kc_flow_run *r)
+{
+    struct kc_flow_seg *seg = r->seg;
+    if (!r->on) return;
+    if (!r->failed && kc_flow_send(seg->out->ch, r->obuf, r->on, seg->out_sz, r->tok) != 0) r->failed = 1;
+    r->on = 0;
+}
+
+/* Run elem through stages [i, end) of the segment. */
+static void kc_flow_push(struct kc_flow_run *r, int i, const void *elem)
+{
+    struct kc_flow_seg *seg = r->seg;
+    for (; i < seg->nops; i++) {
+        struct kc_flow_op *op = &r->ops[i];
+        r->in[i]++;
+        switch (op->kind) {
+        case KC_FLOW_OP_MAP:
+            if (op->map(elem, r->scratch[i], op->user) != 0) return;
+            elem = r->scratch[i];
+            break;
+        case KC_FLOW_OP_FILTER:
+            if (!op->pred(elem, op->user)) return;
+            break;
+        case KC_FLOW_OP_BATCH: {
+            kc_flow_chunk_t *c = (kc_flow_chunk_t*)r->scratch[i];
+            memcpy(c->items + c->count * op->in_sz, elem, op->in_sz);
+            if (++c->count < op->batch_n) return;
+            r->out[i]++;
+            kc_flow_push(r, i + 1, c);
+            c->count = 0;
+            return;
+        }
+        case KC_FLOW_OP_EACH:
+            op->each(elem, op->user);
+            r->out[i]++;
+            return;
+        }
+        r->out[i]++;
+    }
+    if (!seg->out) return;
+    memcpy(r->obuf + r->on * seg->out_sz, elem, seg->out_sz);
+    if (++r->on == r->batch) kc_flow_flush_out(r);
+}
+
+static void kc_flow_flush_stats(struct kc_flow_run *r)
+{
+    long now = kc_now_ns();
+    for (int i = 0; i < r->seg->nops; i++) {
+        struct kc_flow_op *op = &r->ops[i];
+        if (!r->in[i] && !r->out[i]) continue;
+        atomic_fetch_add_explicit(&op->in, r->in[i], memory_order_relaxed);
+        atomic_fetch_add_explicit(&op->out, r->out[i], memory_order_relaxed);
+        long zero = 0;
+        (void)atomic_compare_exchange_strong_explicit(&op->first_ns, &zero, now,
+                                                      memory_order_relaxed, memory_order_relaxed);
+        atomic_store_explicit(&op->last_ns, now, memory_order_relaxed);
+        r->in[i] = r->out[i] = 0;
+    }
+}
+
+static void kc_flow_writer_done(struct kc_flow_link *l)
+{
+    if (l && atomic_fetch_sub(&l->writers, 1) == 1) kc_chan_close(l->ch);
+}
+
+static void kc_flow_seg_entry(void *arg)
+{
+    struct kc_flow_seg *seg = (struct kc_flow_seg*)arg;
+    struct kc_flow *f = seg->flow;
+    int n = seg->nops;
+    struct kc_flow_run r = { .seg = seg, .ops = f->ops + seg->first_op, .tok = kc_scope_token(f->scope) };
+    int cfg_batch = kc_runtime_config_get()->chan_flow_batch;
+    r.batch = cfg_batch > 0 ? (size_t)cfg_batch : KCORO_FLOW_BATCH;
+    unsigned char *ibuf = malloc(r.batch * seg->in_sz);
+    r.obuf = seg->out ? malloc(r.batch * seg->out_sz) : NULL;
+    r.scratch = calloc((size_t)n + 1, sizeof(*r.scratch));
+    r.in = calloc((size_t)n + 1, sizeof(*r.in));
+    r.out = calloc((size_t)n + 1, sizeof(*r.out));
+    int ok = ibuf && (!seg->out || r.obuf) && r.scratch && r.in && r.out;
+    for (int i = 0; ok && i < n; i++) {
+        if (r.ops[i].kind != KC_FLOW_OP_MAP && r.ops[i].kind != KC_FLOW_OP_BATCH) continue;
+        if (!(r.scratch[i] = calloc(1, r.ops[i].out_sz))) ok = 0;
+    }
+    while (ok && !r.failed) {
+        size_t got = 0;
+        if (kc_flow_recv(seg->in, ibuf, r.batch, seg->in_sz, r.tok, &got) != 0) break;
+        for (size_t j = 0; j < got; j++) kc_flow_push(&r, 0, ibuf + j * seg->in_sz);
+        kc_flow_flush_stats(&r);
+        kc_flow_flush_out(&r);
+    }
+    /* End of input: partial chunks go on, in stage order */
+    for (int i = 0; ok && i < n; i++) {
+        if (r.ops[i].kind != KC_FLOW_OP_BATCH) continue;
+        kc_flow_chunk_t *c = (kc_flow_chunk_t*)r.scratch[i];
+        if (!c->count) continue;
+        r.out[i]++;
+        kc_flow_push(&r, i + 1, c);
+        c->count = 0;
+    }
+    if (ok) { kc_flow_flush_stats(&r); kc_flow_flush_out(&r); }
+    /* Nobody reads on: let the segments feeding this one end as well */
+    if ((r.failed || !ok) && seg->in_link) kc_chan_close(seg->in);
+    if (r.scratch) for (int i = 0; i < n; i++) free(r.scratch[i]);
+    free(r.scratch); free(r.in); free(r.out); free(r.obuf); free(ibuf);
+    kc_flow_writer_done(seg->out);
+    atomic_fetch_sub(&kc_flow_root(f)->running, 1);
+}
+
+/* Writers per link and coroutines per tree, before anything runs. */
+static void kc_flow_count(struct kc_flow *f, int *total)
+{
+    for (int i = 0; i < f->ninputs; i++) kc_flow_count(f->inputs[i], total);
+    for (int i = 0; i < f->nsegs; i++) {
+        struct kc_flow_seg *s = &f->segs[i];
+        if (s->out) atomic_fetch_add(&s->out->writers, s->width);
+        *total += s->width;
+    }
+}
+
+static int kc_flow_spawn(struct kc_flow *f, int rc)
+{
+    for (int i = 0; i < f->ninputs; i++) rc = kc_flow_spawn(f->inputs[i], rc);
+    f->launched = 1;
+    for (int i = 0; i < f->nsegs; i++) {
+        struct kc_flow_seg *s = &f->segs[i];
+        for (int k = 0; k < s->width; k++) {
+            if (rc == 0) rc = kc_scope_launch(f->scope, kc_flow_seg_entry, s, 0, NULL);
+            if (rc == 0) continue;
+            /* Stand in for the coroutine that did not start */
+            kc_flow_writer_done(s->out);
+            atomic_fetch_sub(&kc_flow_root(f)->running, 1);
+        }
+    }
+    return rc;
+}
+
+int kc_flow_launch(kc_flow_t *f, size_t capacity, kc_chan_t **out)
+{
+    if (!f) return -EINVAL;
+    if (f->launched || f->root != f) return -EBUSY;
+    struct kc_flow_link *ol = NULL;
+    if (out) {
+        ol = calloc(1, sizeof(*ol));
+        if (!ol) return -ENOMEM;
+        if (kc_chan_make(&ol->ch, KC_BUFFERED, f->cur_sz, capacity ? capacity : kc_flow_chan_cap()) != 0) {
+            free(ol);
+            return -ENOMEM;
+        }
+        ol->next = f->links;   /* freed with the flow; the channel is the caller's */
+        f->links = ol;
+        kc_flow_tail(f)->out = ol;
+    }
+    int total = 0;
+    kc_flow_count(f, &total);
+    atomic_store(&f->running, total);
+    if (out) *out = ol->ch;
+    return kc_flow_spawn(f, 0);
+}
+
+int kc_flow_stage_snapshot(kc_flow_t *f, int stage, struct kc_chan_snapshot *out)
+{
+    if (!f || !out || stage < 0 || stage >= f->nops) return -EINVAL;
+    struct kc_flow_op *op = &f->ops[stage];
+    memset(out, 0, sizeof(*out));
+    out->chan = op;
+    out->kind = KC_BUFFERED;
+    out->elem_sz = op->out_sz;
+    out->total_recvs = atomic_load_explicit(&op->in, memory_order_relaxed);
+    out->total_sends = atomic_load_explicit(&op->out, memory_order_relaxed);
+    out->total_bytes_recv = out->total_recvs * op->in_sz;
+    out->total_bytes_sent = out->total_sends * op->out_sz;
+    out->first_op_time_ns = atomic_load_explicit(&op->first_ns, memory_order_relaxed);
+    out->last_op_time_ns = atomic_load_explicit(&op->last_ns, memory_order_relaxed);
+    struct kc_flow *root = kc_flow_root(f);
+    out->closed = root->launched && atomic_load(&root->running) == 0;
+    if (out->first_op_time_ns > 0 && out->last_op_time_ns > out->first_op_time_ns)
+        out->duration_sec = (double)(out->last_op_time_ns - out->first_op_time_ns) / 1e9;
+    return 0;
+}
+
+static void kc_flow_free(struct kc_flow *f)
+{
+    for (int i = 0; i < f->ninputs; i++) kc_flow_free(f->inputs[i]);
+    while (f->links) {
+        struct kc_flow_link *l = f->links;
+        f->links = l->next;
+        if (l->owned) kc_chan_destroy(l->ch);
+        free(l);
+    }
+    free(f->inputs);
+    free(f->ops);
+    free(f->segs);
+    free(f);
+}
+
+void kc_flow_destroy(kc_flow_t *f)
+{
+    if (!f || f->root != f) return;
+    /* Parks a coroutine, sleeps a thread */
+    while (f->launched && atomic_load(&f->running) > 0) kc_sleep_ms(1);
+    kc_flow_free(f);
+}
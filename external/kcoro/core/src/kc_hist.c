@@ -0,0 +1,137 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/*
+ * kc_hist.c — log-linear latency histograms
+ * -----------------------------------------
+ *
+ * Buckets
+ * - Values 0..15 map to buckets 0..15. A larger value with its top bit at
+ *   position m (4 <= m < 40) maps to 16 + (m - 4) * 8 + its next three bits,
+ *   so every power of two is split into 8 equal buckets and a bucket never
+ *   spans more than 1/8 of its lower bound (HdrHistogram with 3 sub-bucket
+ *   bits). Values of 2^40 and above share the last bucket.
+ *
+ * Recording
+ * - A sample is a handful of relaxed atomic adds on one shard; min/max use
+ *   a CAS only when they move. Shards are cache-line aligned and chosen per
+ *   worker, so workers do not share lines while recording.
+ */
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+#include "kc_hist_internal.h"
+
+#define HIST_SUB_BITS 3
+#define HIST_SUB (1 << HIST_SUB_BITS)
+#define HIST_LINEAR (2 * HIST_SUB)   /* values below get one bucket each */
+#define HIST_MAX_BIT 40
+
+int kc_hist_bucket(unsigned long ns)
+{
+    if (ns < HIST_LINEAR) return (int)ns;
+    int msb = 63 - __builtin_clzll((unsigned long long)ns);
+    if (msb >= HIST_MAX_BIT) return KC_HIST_BUCKETS - 1;
+    int shift = msb - HIST_SUB_BITS;
+    return HIST_LINEAR + (msb - HIST_SUB_BITS - 1) * HIST_SUB + (int)((ns >> shift) - HIST_SUB);
+}
+
+unsigned long kc_hist_bucket_lo(int i)
+{
+    if (i < 0) return 0;
+    if (i < HIST_LINEAR) return (unsigned long)i;
+    if (i >= KC_HIST_BUCKETS) i = KC_HIST_BUCKETS - 1;
+    int j = i - HIST_LINEAR;
+    int shift = j / HIST_SUB + 1;
+    return (unsigned long)(HIST_SUB + j % HIST_SUB) << shift;
+}
+
+unsigned long kc_hist_bucket_hi(int i)
+{
+    if (i < HIST_LINEAR) return i < 0 ? 0 : (unsigned long)i;
+    if (i >= KC_HIST_BUCKETS - 1) return ULONG_MAX;
+    int shift = (i - HIST_LINEAR) / HIST_SUB + 1;
+    return kc_hist_bucket_lo(i) + (1UL << shift) - 1;
+}
+
+unsigned long kc_hist_quantile(const struct kc_hist *h, double q)
+{
+    if (!h || h->count == 0) return 0;
+    if (q < 0.0) q = 0.0;
+    if (q > 1.0) q = 1.0;
+    /* Rank of the sample at q (1-based, rounded up) */
+    unsigned long rank = (unsigned long)(q * (double)h->count);
+    if ((double)rank < q * (double)h->count) rank++;
+    if (rank == 0) rank = 1;
+    unsigned long seen = 0;
+    for (int i = 0; i < KC_HIST_BUCKETS; i++) {
+        seen += h->buckets[i];
+        if (seen >= rank) {
+            unsigned long hi = kc_hist_bucket_hi(i);
+            return hi < h->max_ns ? hi : h->max_ns;
+        }
+    }
+    return h->max_ns;
+}
+
+double kc_hist_mean(const struct kc_hist *h)
+{
+    return (h && h->count) ? (double)h->sum_ns / (double)h->count : 0.0;
+}
+
+void kc_hist_shard_init(struct kc_hist_shard *h, size_t n)
+{
+    for (size_t s = 0; s < n; s++) {
+        atomic_init(&h[s].sum_ns, 0);
+        atomic_init(&h[s].min_ns, ULONG_MAX);
+        atomic_init(&h[s].max_ns, 0);
+        for (int i = 0; i < KC_HIST_BUCKETS; i++) atomic_init(&h[s].buckets[i], 0);
+    }
+}
+
+/* The bucket add comes first: the count a reader derives from the buckets
+ * never includes a sample whose bucket it missed. */
+void kc_hist_record(struct kc_hist_shard *h, unsigned long ns)
+{
+    atomic_fetch_add_explicit(&h->buckets[kc_hist_bucket(ns)], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&h->sum_ns, ns, memory_order_relaxed);
+    unsigned long cur = atomic_load_explicit(&h->max_ns, memory_order_relaxed);
+    while (ns > cur && !atomic_compare_exchange_weak_explicit(&h->max_ns, &cur, ns,
+                                                              memory_order_relaxed, memory_order_relaxed)) {}
+    cur = atomic_load_explicit(&h->min_ns, memory_order_relaxed);
+    while (ns < cur && !atomic_compare_exchange_weak_explicit(&h->min_ns, &cur, ns,
+                                                              memory_order_relaxed, memory_order_relaxed)) {}
+}
+
+static inline unsigned long hist_take(_Atomic unsigned long *v, int reset, unsigned long fresh)
+{
+    return reset ? atomic_exchange_explicit(v, fresh, memory_order_relaxed)
+                 : atomic_load_explicit(v, memory_order_relaxed);
+}
+
+void kc_hist_merge(struct kc_hist_shard *h, size_t n, struct kc_hist *out, int reset)
+{
+    for (size_t s = 0; s < n; s++) {
+        unsigned long count = 0;
+        for (int i = 0; i < KC_HIST_BUCKETS; i++) {
+            unsigned long b = hist_take(&h[s].buckets[i], reset, 0);
+            out->buckets[i] += b;
+            count += b;
+        }
+        unsigned long mn = hist_take(&h[s].min_ns, reset, ULONG_MAX);
+        unsigned long mx = hist_take(&h[s].max_ns, reset, 0);
+        out->sum_ns += hist_take(&h[s].sum_ns, reset, 0);
+        if (!count) continue;
+        if (out->count == 0 || (mn != ULONG_MAX && mn < out->min_ns)) out->min_ns = mn == ULONG_MAX ? 0 : mn;
+        if (mx > out->max_ns) out->max_ns = mx;
+        out->count += count;
+    }
+}
+
+size_t kc_hist_shard_for(size_t n)
+{
+    static _Atomic unsigned next_thread;
+    static __thread unsigned tls_pick; /* 1-based; 0 until first use */
+    int w = kc_sched_self_index();
+    if (w >= 0) return (size_t)w % n;
+    if (!tls_pick) tls_pick = atomic_fetch_add_explicit(&next_thread, 1, memory_order_relaxed) + 1;
+    return (size_t)(tls_pick - 1) % n;
+}
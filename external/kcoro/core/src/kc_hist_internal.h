@@ -0,0 +1,30 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <stdatomic.h>
+#include "../../include/kcoro.h"
+
+/* Recording side of struct kc_hist (kc_hist.c). A shard is written with
+ * relaxed atomic adds, so any thread may record into any shard; callers
+ * spread writers over shards (kc_hist_shard_for) to keep lines private.
+ * Reading merges shards; a resetting read exchanges every counter with 0,
+ * so a concurrent sample is counted in exactly one read; the merged count
+ * is the sum of the buckets. */
+struct kc_hist_shard {
+    _Alignas(64) _Atomic unsigned long sum_ns;
+    _Atomic unsigned long min_ns;   /* ULONG_MAX when empty */
+    _Atomic unsigned long max_ns;
+    _Atomic unsigned long buckets[KC_HIST_BUCKETS];
+};
+
+void kc_hist_shard_init(struct kc_hist_shard *h, size_t n);
+void kc_hist_record(struct kc_hist_shard *h, unsigned long ns);
+/* Adds n shards into out (which the caller zeroed or already filled). */
+void kc_hist_merge(struct kc_hist_shard *h, size_t n, struct kc_hist *out, int reset);
+
+/* Calling thread's shard among n: worker index on a scheduler worker, else
+ * a per-thread pick. */
+size_t kc_hist_shard_for(size_t n);
+
+/* Index of the calling thread among its scheduler's workers, or -1 (kc_sched.c). */
+int kc_sched_self_index(void);
@@ -0,0 +1,405 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/*
+ * kc_job.c — structured concurrency jobs
+ * --------------------------------------
+ *
+ * Accounting
+ * - `pending` counts what a job still waits for: its own part (the launched
+ *   body, or the creator until the first join) and each attached child that
+ *   is not yet terminal. The decrement to zero finalizes the job: it picks
+ *   the terminal state, wakes joiners, and reports to its parent, whose
+ *   pending it then drops in turn. Children sit on an intrusive doubly linked
+ *   list in the parent (for cancellation), so attaching and detaching one is
+ *   a few pointer writes under the parent's lock.
+ * - The lock is a per-job spin flag: every critical section is a handful of
+ *   stores, bar cancellation, which walks the children under it (nesting
+ *   parent before child; finalize never holds a child while taking its
+ *   parent, so the order is consistent).
+ *
+ * Lifetime
+ * - refs counts handles plus one "life" reference that finalize drops. A
+ *   child never outlives its attachment to a non-terminal parent, so it
+ *   holds no reference of its own on the parent.
+ * - Job blocks are recycled through a per-thread cache
+ *   (KCORO_JOB_CACHE_PER_THREAD), so fan-out of many short children costs
+ *   no malloc in steady state.
+ *
+ * Joining
+ * - Joiners push a waiter record onto the job under its lock. A coroutine
+ *   parks through kc_sched_park_release, which drops the lock only once it
+ *   has switched out, so the finalizer cannot wake it early; a plain thread
+ *   waits on a condvar in its own record.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+
+#include "../../include/kc_job.h"
+#include "../../include/kcoro.h"
+#include "../../include/kcoro_core.h"
+#include "../../include/kcoro_sched.h"
+#include "../../include/kcoro_port.h"
+#include "../../include/kcoro_config.h"
+#include "kcoro_share_internal.h"
+
+#define JOB_F_OWN_OPEN (1u << 16) /* kc_job_create: the creator's part */
+
+struct kc_job_waiter {
+    struct kc_job_waiter *next;
+    kcoro_t *co;             /* parked coroutine, or NULL for a thread */
+    kc_sched_t *sched;
+    int woke;                /* thread waiters: under m */
+    pthread_mutex_t m;
+    pthread_cond_t cv;
+};
+
+struct kc_job {
+    _Atomic int state;       /* kc_job_state_t */
+    _Atomic int refs;
+    atomic_flag lock;
+    unsigned flags;
+    int pending;             /* under lock */
+    _Atomic int failure;     /* first kc_job_fail code, 0 if none */
+    _Atomic int reason;      /* cancel reason */
+    _Atomic int own_open;    /* kc_job_create's part not yet released */
+    struct kc_job *parent;   /* NULL for roots and detached jobs */
+    struct kc_job *prev, *next;
+    struct kc_job *children;
+    struct kc_job_waiter *waiters;
+    kc_cancel_t *token;      /* kc_job_token, created on demand */
+    kcoro_fn_t fn;           /* kc_job_launch body */
+    void *arg;
+};
+
+/* Per-thread cache of free job blocks, linked through `next`. */
+struct job_cache { kc_job_t *head; unsigned count; };
+static __thread struct job_cache tls_jobs;
+static pthread_key_t job_key;
+static pthread_once_t job_once = PTHREAD_ONCE_INIT;
+
+static void job_cache_drop(void *arg)
+{
+    (void)arg;
+    kc_job_t *j = tls_jobs.head;
+    while (j) { kc_job_t *n = j->next; free(j); j = n; }
+    tls_jobs.head = NULL;
+    tls_jobs.count = 0;
+}
+
+static void job_key_init(void)
+{
+    (void)pthread_key_create(&job_key, job_cache_drop);
+}
+
+static kc_job_t *job_alloc(void)
+{
+    kc_job_t *j = tls_jobs.head;
+    if (j) {
+        tls_jobs.head = j->next;
+        tls_jobs.count--;
+    } else if (!(j = (kc_job_t*)malloc(sizeof(*j)))) {
+        return NULL;
+    }
+    memset(j, 0, sizeof(*j));
+    atomic_flag_clear(&j->lock);
+    return j;
+}
+
+static void job_free(kc_job_t *j)
+{
+    if (j->token) kc_cancel_destroy(j->token);
+    if (tls_jobs.count >= KCORO_JOB_CACHE_PER_THREAD) { free(j); return; }
+    if (!tls_jobs.head) {
+        /* First block cached on this thread: free the cache at exit. */
+        pthread_once(&job_once, job_key_init);
+        (void)pthread_setspecific(job_key, &tls_jobs);
+    }
+    j->next = tls_jobs.head;
+    tls_jobs.head = j;
+    tls_jobs.count++;
+}
+
+static void job_lock(kc_job_t *j)
+{
+    while (atomic_flag_test_and_set_explicit(&j->lock, memory_order_acquire)) sched_yield();
+}
+
+static void job_unlock(kc_job_t *j)
+{
+    atomic_flag_clear_explicit(&j->lock, memory_order_release);
+}
+
+static void job_unlock_hook(void *arg)
+{
+    job_unlock((kc_job_t*)arg);
+}
+
+static int job_terminal(int s)
+{
+    return s == KC_JOB_CANCELLED || s == KC_JOB_COMPLETED || s == KC_JOB_FAILED;
+}
+
+/* Under the lock of j: flip ACTIVE to CANCELLING and cascade to attached
+ * children. Returns 1 if this call did the flip. */
+static int job_cancel_locked(kc_job_t *j, int reason)
+{
+    int s = KC_JOB_ACTIVE;
+    if (!atomic_compare_exchange_strong(&j->state, &s, KC_JOB_CANCELLING)) return 0;
+    atomic_store(&j->reason, reason ? reason : KC_ECANCELED);
+    if (j->token) kc_cancel_trigger(j->token);
+    for (kc_job_t *c = j->children; c; c = c->next) {
+        job_lock(c);
+        (void)job_cancel_locked(c, reason);
+        job_unlock(c);
+    }
+    return 1;
+}
+
+static void job_wake(struct kc_job_waiter *w)
+{
+    while (w) {
+        /* The record lives on the waiter's stack: read it before the wake. */
+        struct kc_job_waiter *n = w->next;
+        if (w->co) {
+            kc_sched_enqueue_ready(w->sched, w->co);
+        } else {
+            pthread_mutex_lock(&w->m);
+            w->woke = 1;
+            pthread_cond_signal(&w->cv);
+            pthread_mutex_unlock(&w->m);
+        }
+        w = n;
+    }
+}
+
+static void job_pending_drop(kc_job_t *j);
+
+/* pending reached zero: settle the state, wake joiners, tell the parent. */
+static void job_finalize(kc_job_t *j)
+{
+    int fail = atomic_load(&j->failure);
+    int s = atomic_load(&j->state);
+    int final = fail ? KC_JOB_FAILED : (s == KC_JOB_CANCELLING ? KC_JOB_CANCELLED : KC_JOB_COMPLETED);
+    job_lock(j);
+    atomic_store_explicit(&j->state, final, memory_order_release);
+    struct kc_job_waiter *w = j->waiters;
+    j->waiters = NULL;
+    job_unlock(j);
+    job_wake(w);
+
+    kc_job_t *p = j->parent;
+    if (p) {
+        job_lock(p);
+        if (j->prev) j->prev->next = j->next;
+        else p->children = j->next;
+        if (j->next) j->next->prev = j->prev;
+        job_unlock(p);
+        if (final == KC_JOB_FAILED && !(p->flags & KC_JOB_F_SUPERVISOR))
+            (void)kc_job_fail(p, fail);
+        job_pending_drop(p);
+    }
+    kc_job_release(j); /* the life reference */
+}
+
+static void job_pending_drop(kc_job_t *j)
+{
+    job_lock(j);
+    int left = --j->pending;
+    job_unlock(j);
+    if (left == 0) job_finalize(j);
+}
+
+/* New job with its own part open, attached to parent unless detached. */
+static int job_new(kc_job_t **out, kc_job_t *parent, unsigned flags)
+{
+    kc_job_t *j = job_alloc();
+    if (!j) return -ENOMEM;
+    j->flags = flags;
+    j->pending = 1;
+    atomic_init(&j->state, KC_JOB_ACTIVE);
+    atomic_init(&j->refs, 1); /* life */
+    if (parent && !(flags & KC_JOB_F_DETACHED)) {
+        job_lock(parent);
+        if (parent->pending == 0) {
+            job_unlock(parent);
+            job_free(j);
+            return KC_ECANCELED;
+        }
+        parent->pending++;
+        j->parent = parent;
+        j->next = parent->children;
+        if (j->next) j->next->prev = j;
+        parent->children = j;
+        /* Born into a cancelling parent: cancelled from the start. */
+        if (atomic_load(&parent->state) != KC_JOB_ACTIVE)
+            (void)job_cancel_locked(j, atomic_load(&parent->reason));
+        job_unlock(parent);
+    }
+    *out = j;
+    return 0;
+}
+
+int kc_job_create(kc_job_t **out, kc_job_t *parent, unsigned flags)
+{
+    if (!out) return -EINVAL;
+    *out = NULL;
+    kc_job_t *j = NULL;
+    int rc = job_new(&j, parent, flags & (KC_JOB_F_SUPERVISOR | KC_JOB_F_DETACHED | KC_JOB_F_TIMEOUT_WRP));
+    if (rc) return rc;
+    j->flags |= JOB_F_OWN_OPEN;
+    atomic_store(&j->own_open, 1);
+    atomic_fetch_add(&j->refs, 1); /* the caller's handle */
+    *out = j;
+    return 0;
+}
+
+kc_job_t* kc_job_retain(kc_job_t *j)
+{
+    if (j) atomic_fetch_add_explicit(&j->refs, 1, memory_order_relaxed);
+    return j;
+}
+
+void kc_job_release(kc_job_t *j)
+{
+    if (j && atomic_fetch_sub_explicit(&j->refs, 1, memory_order_acq_rel) == 1) job_free(j);
+}
+
+kc_job_t* kc_job_current(void)
+{
+    kcoro_t *co = kcoro_current();
+    return co ? co->job : NULL;
+}
+
+int kc_job_cancel(kc_job_t *j, int reason)
+{
+    if (!j) return -EINVAL;
+    job_lock(j);
+    int did = job_cancel_locked(j, reason ? reason : KC_ECANCELED);
+    job_unlock(j);
+    return did ? 0 : -EALREADY;
+}
+
+int kc_job_fail(kc_job_t *j, int code)
+{
+    if (!j || code >= 0) return -EINVAL;
+    int none = 0;
+    (void)atomic_compare_exchange_strong(&j->failure, &none, code);
+    (void)kc_job_cancel(j, code);
+    return 0;
+}
+
+int kc_job_is_cancelled(const kc_job_t *j)
+{
+    if (!j) return 0;
+    int s = atomic_load(&((kc_job_t*)j)->state);
+    return s == KC_JOB_CANCELLING || s == KC_JOB_CANCELLED || s == KC_JOB_FAILED;
+}
+
+const kc_cancel_t* kc_job_token(kc_job_t *j)
+{
+    if (!j) return NULL;
+    job_lock(j);
+    if (!j->token && kc_cancel_init(&j->token) == 0 && atomic_load(&j->state) != KC_JOB_ACTIVE)
+        kc_cancel_trigger(j->token);
+    kc_cancel_t *t = j->token;
+    job_unlock(j);
+    return t;
+}
+
+kc_job_state_t kc_job_state(const kc_job_t *j)
+{
+    if (!j) return KC_JOB_FAILED;
+    return (kc_job_state_t)atomic_load_explicit(&((kc_job_t*)j)->state, memory_order_acquire);
+}
+
+int kc_job_result_code(const kc_job_t *j)
+{
+    if (!j) return -EINVAL;
+    int s = kc_job_state(j);
+    if (s == KC_JOB_FAILED) return atomic_load(&((kc_job_t*)j)->failure);
+    if (s == KC_JOB_CANCELLED) return atomic_load(&((kc_job_t*)j)->reason);
+    return 0;
+}
+
+int kc_job_join(kc_job_t *j, int *out_result_code)
+{
+    if (!j) return -EINVAL;
+    /* The creator joining is done adding children. */
+    if ((j->flags & JOB_F_OWN_OPEN) && atomic_exchange(&j->own_open, 0))
+        job_pending_drop(j);
+
+    kcoro_t *co = kcoro_current();
+    kc_sched_t *s = kc_sched_current();
+    struct kc_job_waiter local = { 0 };
+    struct kc_job_waiter *w = co && s ? kcoro_park_record(co, &local, sizeof(local)) : &local;
+    if (!w) return -ENOMEM;
+    while (!job_terminal(atomic_load_explicit(&j->state, memory_order_acquire))) {
+        job_lock(j);
+        if (job_terminal(atomic_load(&j->state))) { job_unlock(j); break; }
+        w->next = j->waiters;
+        j->waiters = w;
+        if (co && s) {
+            w->co = co;
+            w->sched = s;
+            if (kc_sched_park_release(job_unlock_hook, j) == 0) continue;
+            /* Not on a worker after all: wait as a thread. */
+        }
+        w->co = NULL;
+        w->woke = 0;
+        pthread_mutex_init(&w->m, NULL);
+        pthread_cond_init(&w->cv, NULL);
+        job_unlock(j);
+        pthread_mutex_lock(&w->m);
+        while (!w->woke) pthread_cond_wait(&w->cv, &w->m);
+        pthread_mutex_unlock(&w->m);
+        pthread_cond_destroy(&w->cv);
+        pthread_mutex_destroy(&w->m);
+    }
+    kcoro_park_record_free(w, &local);
+
+    int code = kc_job_result_code(j);
+    if (out_result_code) *out_result_code = code;
+    switch (kc_job_state(j)) {
+    case KC_JOB_COMPLETED: return 0;
+    case KC_JOB_FAILED:    return code;
+    default:               return KC_ECANCELED;
+    }
+}
+
+static void job_entry(void *arg)
+{
+    kc_job_t *j = (kc_job_t*)arg;
+    kcoro_t *co = kcoro_current();
+    co->job = j;
+    j->fn(j->arg);
+    co->job = NULL;
+    job_pending_drop(j);
+}
+
+int kc_job_launch(kc_job_t *parent, struct kc_context *ctx, kcoro_fn_t fn, void *arg,
+                  size_t stack_size, kc_job_t **out_job)
+{
+    if (out_job) *out_job = NULL;
+    if (!fn) return -EINVAL;
+    if (ctx) return -ENOTSUP;
+    if (!parent) parent = kc_job_current();
+    kc_job_t *j = NULL;
+    int rc = job_new(&j, parent, 0);
+    if (rc) return rc;
+    j->fn = fn;
+    j->arg = arg;
+    if (out_job) atomic_fetch_add(&j->refs, 1);
+    rc = kc_spawn_co(kc_sched_default(), job_entry, j, stack_size, NULL);
+    if (rc != 0) {
+        /* Never ran: finish it as cancelled, which the parent ignores. */
+        (void)kc_job_cancel(j, rc < 0 ? rc : -ENOMEM);
+        if (out_job) kc_job_release(j);
+        job_pending_drop(j);
+        return rc < 0 ? rc : -ENOMEM;
+    }
+    if (out_job) *out_job = j;
+    return 0;
+}
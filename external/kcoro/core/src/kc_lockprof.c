@@ -0,0 +1,217 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/*
+ * kc_lockprof.c — KC_MUTEX contention profile
+ * -------------------------------------------
+ *
+ * With KCORO_LOCK_PROF=1 port/posix.h maps KC_MUTEX_T to kc_prof_mutex_t (around
+ * the port's own lock: pthreads, or kc_amutex with ADAPTIVE_MUTEX=1) and
+ * gives every KC_MUTEX_LOCK call site a static kc_lock_site_t. Lock first
+ * tries the mutex; only when that fails does it read the clock, block, and
+ * charge the wait to the site. The holder records its site and the acquire
+ * time in the mutex (both under the lock), and unlock charges the hold.
+ * Condition waits end the hold before sleeping and restart it on wakeup, so
+ * time parked on a condvar is not counted as holding the lock.
+ *
+ * Sites link themselves into a lock-free list on first acquisition; the list
+ * only grows, as the records are static.
+ */
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "../../include/kcoro_config.h"
+#include "../../include/kcoro_port.h"
+#include "../../include/kcoro_lockprof.h"
+#include "kc_clock_internal.h"
+
+#if defined(KCORO_LOCK_PROF) && KCORO_LOCK_PROF
+
+static kc_lock_site_t *_Atomic g_sites;
+
+static inline uint64_t lp_now_ns(void)
+{
+    return kc_clock_ns();
+}
+
+static inline void lp_max(_Atomic(uint64_t) *slot, uint64_t v)
+{
+    uint64_t cur = atomic_load_explicit(slot, memory_order_relaxed);
+    while (v > cur && !atomic_compare_exchange_weak_explicit(slot, &cur, v, memory_order_relaxed,
+                                                             memory_order_relaxed)) { }
+}
+
+static void lp_register(kc_lock_site_t *s)
+{
+    int expected = 0;
+    if (!atomic_compare_exchange_strong(&s->registered, &expected, 1)) return;
+    kc_lock_site_t *head = atomic_load_explicit(&g_sites, memory_order_relaxed);
+    do { s->next = head; }
+    while (!atomic_compare_exchange_weak_explicit(&g_sites, &head, s, memory_order_release,
+                                                  memory_order_relaxed));
+}
+
+int kc_lockprof_mutex_init(kc_prof_mutex_t *m)
+{
+    m->site = NULL;
+    m->acquired_ns = 0;
+    return KC_PORT_MUTEX_INIT(&m->m);
+}
+
+int kc_lockprof_lock(kc_prof_mutex_t *m, kc_lock_site_t *site)
+{
+    if (!atomic_load_explicit(&site->registered, memory_order_relaxed)) lp_register(site);
+    int rc = KC_PORT_MUTEX_TRYLOCK(&m->m);
+    uint64_t now;
+    if (rc == EBUSY) {
+        uint64_t t0 = lp_now_ns();
+        rc = KC_PORT_MUTEX_LOCK(&m->m);
+        if (rc != 0) return rc;
+        now = lp_now_ns();
+        atomic_fetch_add_explicit(&site->contended, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&site->wait_ns, now - t0, memory_order_relaxed);
+        lp_max(&site->max_wait_ns, now - t0);
+    } else if (rc == 0) {
+        now = lp_now_ns();
+    } else {
+        return rc;
+    }
+    atomic_fetch_add_explicit(&site->acquisitions, 1, memory_order_relaxed);
+    m->site = site;
+    m->acquired_ns = now;
+    return 0;
+}
+
+static void lp_end_hold(kc_prof_mutex_t *m)
+{
+    kc_lock_site_t *s = m->site;
+    if (!s) return;
+    uint64_t held = lp_now_ns() - m->acquired_ns;
+    atomic_fetch_add_explicit(&s->hold_ns, held, memory_order_relaxed);
+    lp_max(&s->max_hold_ns, held);
+}
+
+int kc_lockprof_unlock(kc_prof_mutex_t *m)
+{
+    lp_end_hold(m);
+    m->site = NULL;
+    return KC_PORT_MUTEX_UNLOCK(&m->m);
+}
+
+int kc_lockprof_cond_wait(KC_PORT_COND_T *c, kc_prof_mutex_t *m)
+{
+    kc_lock_site_t *s = m->site;
+    lp_end_hold(m);
+    int rc = KC_PORT_COND_WAIT(c, &m->m);
+    m->site = s;
+    m->acquired_ns = lp_now_ns();
+    return rc;
+}
+
+int kc_lockprof_cond_timedwait(KC_PORT_COND_T *c, kc_prof_mutex_t *m, const struct timespec *ts)
+{
+    kc_lock_site_t *s = m->site;
+    lp_end_hold(m);
+    int rc = KC_PORT_COND_TIMEDWAIT_ABS(c, &m->m, ts);
+    m->site = s;
+    m->acquired_ns = lp_now_ns();
+    return rc;
+}
+
+int kc_lockprof_enabled(void) { return 1; }
+
+static int lp_cmp(const void *a, const void *b)
+{
+    const kc_lockprof_site_t *x = (const kc_lockprof_site_t *)a, *y = (const kc_lockprof_site_t *)b;
+    if (x->wait_ns != y->wait_ns) return x->wait_ns < y->wait_ns ? 1 : -1;
+    if (x->acquisitions != y->acquisitions) return x->acquisitions < y->acquisitions ? 1 : -1;
+    return 0;
+}
+
+/* Every site with at least one acquisition, sorted; *out is malloc'd. */
+static int lp_collect(kc_lockprof_site_t **out)
+{
+    size_t cap = 0;
+    kc_lock_site_t *head = atomic_load_explicit(&g_sites, memory_order_acquire);
+    for (kc_lock_site_t *s = head; s; s = s->next) cap++;
+    kc_lockprof_site_t *v = (kc_lockprof_site_t *)malloc((cap ? cap : 1) * sizeof(*v));
+    if (!v) return -ENOMEM;
+    size_t n = 0;
+    for (kc_lock_site_t *s = head; s && n < cap; s = s->next) {
+        uint64_t acq = atomic_load_explicit(&s->acquisitions, memory_order_relaxed);
+        if (acq == 0) continue;
+        kc_lockprof_site_t *o = &v[n++];
+        o->file = s->file;
+        o->line = s->line;
+        o->lock = s->lock;
+        o->acquisitions = acq;
+        o->contended = atomic_load_explicit(&s->contended, memory_order_relaxed);
+        o->wait_ns = atomic_load_explicit(&s->wait_ns, memory_order_relaxed);
+        o->max_wait_ns = atomic_load_explicit(&s->max_wait_ns, memory_order_relaxed);
+        o->hold_ns = atomic_load_explicit(&s->hold_ns, memory_order_relaxed);
+        o->max_hold_ns = atomic_load_explicit(&s->max_hold_ns, memory_order_relaxed);
+    }
+    qsort(v, n, sizeof(*v), lp_cmp);
+    *out = v;
+    return (int)n;
+}
+
+int kc_lockprof_snapshot(kc_lockprof_site_t *out, size_t n)
+{
+    if (!out && n) return -EINVAL;
+    kc_lockprof_site_t *v = NULL;
+    int got = lp_collect(&v);
+    if (got < 0) return got;
+    if ((size_t)got > n) got = (int)n;
+    if (got) memcpy(out, v, (size_t)got * sizeof(*v));
+    free(v);
+    return got;
+}
+
+int kc_lockprof_reset(void)
+{
+    for (kc_lock_site_t *s = atomic_load_explicit(&g_sites, memory_order_acquire); s; s = s->next) {
+        atomic_store_explicit(&s->acquisitions, 0, memory_order_relaxed);
+        atomic_store_explicit(&s->contended, 0, memory_order_relaxed);
+        atomic_store_explicit(&s->wait_ns, 0, memory_order_relaxed);
+        atomic_store_explicit(&s->max_wait_ns, 0, memory_order_relaxed);
+        atomic_store_explicit(&s->hold_ns, 0, memory_order_relaxed);
+        atomic_store_explicit(&s->max_hold_ns, 0, memory_order_relaxed);
+    }
+    return 0;
+}
+
+int kc_lockprof_dump(int fd, size_t n)
+{
+    kc_lockprof_site_t *v = NULL;
+    int got = lp_collect(&v);
+    if (got < 0) return got;
+    if (n && (size_t)got > n) got = (int)n;
+    int rc = dprintf(fd, "%-32s %-20s %12s %10s %7s %12s %10s %12s %10s\n",
+                     "site", "lock", "acquired", "contended", "cont%", "wait_ms", "max_wt_us",
+                     "hold_ms", "max_hd_us") < 0 ? -errno : 0;
+    for (int i = 0; i < got && rc == 0; i++) {
+        const kc_lockprof_site_t *s = &v[i];
+        const char *base = strrchr(s->file, '/');
+        char where[64];
+        snprintf(where, sizeof(where), "%s:%d", base ? base + 1 : s->file, s->line);
+        if (dprintf(fd, "%-32.32s %-20.20s %12llu %10llu %7.2f %12.3f %10.1f %12.3f %10.1f\n",
+                    where, s->lock, (unsigned long long)s->acquisitions,
+                    (unsigned long long)s->contended,
+                    100.0 * (double)s->contended / (double)s->acquisitions,
+                    (double)s->wait_ns / 1e6, (double)s->max_wait_ns / 1e3,
+                    (double)s->hold_ns / 1e6, (double)s->max_hold_ns / 1e3) < 0)
+            rc = -errno;
+    }
+    free(v);
+    return rc;
+}
+
+#else /* !KCORO_LOCK_PROF */
+
+int kc_lockprof_enabled(void) { return 0; }
+int kc_lockprof_snapshot(kc_lockprof_site_t *out, size_t n) { (void)out; (void)n; return -ENOTSUP; }
+int kc_lockprof_reset(void) { return -ENOTSUP; }
+int kc_lockprof_dump(int fd, size_t n) { (void)fd; (void)n; return -ENOTSUP; }
+
+#endif
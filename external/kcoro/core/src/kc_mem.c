@@ -0,0 +1,80 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Runtime memory accounting (kc_mem.h). A charge adds first and backs out
+ * when it lands past a limit, so concurrent charges near a limit may both be
+ * refused where one would have fit; limits are soft by design. */
+#include <errno.h>
+#include <stdatomic.h>
+#include <string.h>
+
+#include "../../include/kc_mem.h"
+
+struct kc_mem_gauge {
+    _Alignas(64) _Atomic(size_t) bytes;
+    _Atomic(size_t) peak;
+    _Atomic(size_t) limit;
+    _Atomic(unsigned long) denied;
+};
+
+static struct kc_mem_gauge g_cat[KC_MEM_CAT_COUNT];
+static _Alignas(64) _Atomic(size_t) g_total;
+static _Atomic(size_t) g_total_limit;
+
+static const char *const g_names[KC_MEM_CAT_COUNT] = { "stacks", "chan", "waiters", "timers", "ipc" };
+
+int kc_mem_set_limit(kc_mem_cat_t cat, size_t bytes)
+{
+    if ((unsigned)cat >= KC_MEM_CAT_COUNT) return -EINVAL;
+    atomic_store_explicit(&g_cat[cat].limit, bytes, memory_order_relaxed);
+    return 0;
+}
+
+void kc_mem_set_total_limit(size_t bytes)
+{
+    atomic_store_explicit(&g_total_limit, bytes, memory_order_relaxed);
+}
+
+const char *kc_mem_cat_name(kc_mem_cat_t cat)
+{
+    return (unsigned)cat < KC_MEM_CAT_COUNT ? g_names[cat] : NULL;
+}
+
+int kc_mem_charge(kc_mem_cat_t cat, size_t bytes)
+{
+    if ((unsigned)cat >= KC_MEM_CAT_COUNT) return -EINVAL;
+    struct kc_mem_gauge *g = &g_cat[cat];
+    size_t limit = atomic_load_explicit(&g->limit, memory_order_relaxed);
+    size_t total_limit = atomic_load_explicit(&g_total_limit, memory_order_relaxed);
+    size_t now = atomic_fetch_add_explicit(&g->bytes, bytes, memory_order_relaxed) + bytes;
+    size_t total = atomic_fetch_add_explicit(&g_total, bytes, memory_order_relaxed) + bytes;
+    if ((limit && now > limit) || (total_limit && total > total_limit)) {
+        atomic_fetch_sub_explicit(&g->bytes, bytes, memory_order_relaxed);
+        atomic_fetch_sub_explicit(&g_total, bytes, memory_order_relaxed);
+        atomic_fetch_add_explicit(&g->denied, 1, memory_order_relaxed);
+        return -ENOMEM;
+    }
+    size_t peak = atomic_load_explicit(&g->peak, memory_order_relaxed);
+    while (now > peak && !atomic_compare_exchange_weak_explicit(&g->peak, &peak, now,
+                                                                memory_order_relaxed, memory_order_relaxed)) {}
+    return 0;
+}
+
+void kc_mem_uncharge(kc_mem_cat_t cat, size_t bytes)
+{
+    if ((unsigned)cat >= KC_MEM_CAT_COUNT || !bytes) return;
+    atomic_fetch_sub_explicit(&g_cat[cat].bytes, bytes, memory_order_relaxed);
+    atomic_fetch_sub_explicit(&g_total, bytes, memory_order_relaxed);
+}
+
+void kc_mem_get_stats(kc_mem_stats_t *out)
+{
+    if (!out) return;
+    memset(out, 0, sizeof(*out));
+    for (int c = 0; c < KC_MEM_CAT_COUNT; c++) {
+        out->bytes[c] = atomic_load_explicit(&g_cat[c].bytes, memory_order_relaxed);
+        out->peak[c] = atomic_load_explicit(&g_cat[c].peak, memory_order_relaxed);
+        out->limit[c] = atomic_load_explicit(&g_cat[c].limit, memory_order_relaxed);
+        out->denied[c] = atomic_load_explicit(&g_cat[c].denied, memory_order_relaxed);
+        out->total += out->bytes[c];
+    }
+    out->total_limit = atomic_load_explicit(&g_total_limit, memory_order_relaxed);
+}
@@ -0,0 +1,563 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/*
+ * kc_metrics.c — metrics registry and OpenMetrics exporter
+ * -------------------------------------------------------
+ *
+ * Registry
+ * - A fixed array of KCORO_METRICS_MAX slots. Register/unregister serialize
+ *   on g_reg_mu; scrapes never take it. A reader enters a LIVE slot by
+ *   bumping its reader count and re-checking the state; unregister flips
+ *   the slot to BUSY and waits for the count to drain before the caller may
+ *   destroy the object (both sides seq_cst, the usual Dekker handshake).
+ *
+ * Collection
+ * - Channels: kc_chan_peek_snapshot (relaxed loads, no ch->mu).
+ *   Schedulers: kc_sched_get_stats (atomics only). I/O: kc_io_get_stats.
+ *   Memory: kc_mem_get_stats (process-wide gauges, no registration).
+ *   A render first copies every live entry, then writes one metric family
+ *   at a time, since OpenMetrics wants a family's samples together.
+ *
+ * Exporter
+ * - One coroutine per server parks in kc_await_readable on the listening
+ *   socket (with a short timeout, to notice kc_metrics_server_stop) and
+ *   answers each connection inline with HTTP/1.0 and Connection: close.
+ */
+#define _GNU_SOURCE 1
+#include <errno.h>
+#include <netdb.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include "../../include/kcoro_config.h"
+#include "../../include/kcoro_core.h"
+#include "../../include/kcoro_io.h"
+#include "../../include/kcoro_metrics.h"
+#include "../../include/kc_mem.h"
+#include "kc_chan_internal.h"
+
+enum { SLOT_FREE = 0, SLOT_BUSY, SLOT_LIVE };
+enum { OBJ_CHAN = 1, OBJ_SCHED };
+
+#define METRICS_LABEL_MAX 128   /* escaped name; 63 raw bytes at worst doubled */
+_Static_assert(sizeof(((kc_metrics_chan_t*)0)->name) == METRICS_LABEL_MAX, "kc_metrics_chan_t name");
+
+struct kc_metrics_slot {
+    _Atomic int state;
+    _Atomic int readers;
+    int kind;
+    void *obj;
+    char label[METRICS_LABEL_MAX];
+    /* kc_metrics_push deltas (g_push_mu) */
+    unsigned long push_sends, push_recvs, push_bytes_sent, push_bytes_recv;
+};
+
+static struct kc_metrics_slot g_slots[KCORO_METRICS_MAX];
+static pthread_mutex_t g_reg_mu = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t g_push_mu = PTHREAD_MUTEX_INITIALIZER;
+
+/* ---- Registry ---- */
+
+/* Label value escaping per the exposition format: backslash, quote, newline. */
+static void metrics_escape(char *dst, const char *src)
+{
+    size_t n = 0;
+    for (size_t i = 0; src[i] && i < 63; i++) {
+        char c = src[i];
+        if (c == '\\' || c == '"') { dst[n++] = '\\'; dst[n++] = c; }
+        else if (c == '\n') { dst[n++] = '\\'; dst[n++] = 'n'; }
+        else dst[n++] = c;
+    }
+    dst[n] = '\0';
+}
+
+static struct kc_metrics_slot *metrics_find_locked(int kind, const void *obj)
+{
+    for (int i = 0; i < KCORO_METRICS_MAX; i++) {
+        struct kc_metrics_slot *sl = &g_slots[i];
+        if (atomic_load_explicit(&sl->state, memory_order_relaxed) == SLOT_LIVE &&
+            sl->kind == kind && sl->obj == obj)
+            return sl;
+    }
+    return NULL;
+}
+
+static int metrics_register(int kind, void *obj, const char *name)
+{
+    if (!obj || !name) return -EINVAL;
+    pthread_mutex_lock(&g_reg_mu);
+    if (metrics_find_locked(kind, obj)) { pthread_mutex_unlock(&g_reg_mu); return -EEXIST; }
+    for (int i = 0; i < KCORO_METRICS_MAX; i++) {
+        struct kc_metrics_slot *sl = &g_slots[i];
+        if (atomic_load_explicit(&sl->state, memory_order_relaxed) != SLOT_FREE) continue;
+        sl->kind = kind;
+        sl->obj = obj;
+        metrics_escape(sl->label, name);
+        sl->push_sends = sl->push_recvs = sl->push_bytes_sent = sl->push_bytes_recv = 0;
+        atomic_store_explicit(&sl->state, SLOT_LIVE, memory_order_release);
+        pthread_mutex_unlock(&g_reg_mu);
+        return 0;
+    }
+    pthread_mutex_unlock(&g_reg_mu);
+    return -ENOSPC;
+}
+
+static int metrics_unregister(int kind, void *obj)
+{
+    if (!obj) return -EINVAL;
+    pthread_mutex_lock(&g_reg_mu);
+    struct kc_metrics_slot *sl = metrics_find_locked(kind, obj);
+    if (!sl) { pthread_mutex_unlock(&g_reg_mu); return -ENOENT; }
+    atomic_store(&sl->state, SLOT_BUSY);
+    while (atomic_load(&sl->readers)) sched_yield();
+    pthread_mutex_lock(&g_push_mu);   /* a pusher may still hold the slot's deltas */
+    sl->obj = NULL;
+    pthread_mutex_unlock(&g_push_mu);
+    atomic_store_explicit(&sl->state, SLOT_FREE, memory_order_release);
+    pthread_mutex_unlock(&g_reg_mu);
+    return 0;
+}
+
+int kc_metrics_register_chan(kc_chan_t *ch, const char *name) { return metrics_register(OBJ_CHAN, ch, name); }
+int kc_metrics_unregister_chan(kc_chan_t *ch) { return metrics_unregister(OBJ_CHAN, ch); }
+int kc_metrics_register_sched(kc_sched_t *s, const char *name) { return metrics_register(OBJ_SCHED, s, name); }
+int kc_metrics_unregister_sched(kc_sched_t *s) { return metrics_unregister(OBJ_SCHED, s); }
+
+static int slot_enter(struct kc_metrics_slot *sl, int kind)
+{
+    if (atomic_load_explicit(&sl->state, memory_order_acquire) != SLOT_LIVE || sl->kind != kind) return 0;
+    atomic_fetch_add(&sl->readers, 1);
+    if (atomic_load(&sl->state) == SLOT_LIVE) return 1;
+    atomic_fetch_sub_explicit(&sl->readers, 1, memory_order_release);
+    return 0;
+}
+
+static void slot_exit(struct kc_metrics_slot *sl)
+{
+    atomic_fetch_sub_explicit(&sl->readers, 1, memory_order_release);
+}
+
+/* ---- Rendering ---- */
+
+struct metrics_out {
+    char *buf;
+    size_t cap;
+    size_t len;     /* may run past cap: the length the full text needs */
+};
+
+static void out_printf(struct metrics_out *o, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+static void out_printf(struct metrics_out *o, const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    int n = o->len < o->cap ? vsnprintf(o->buf + o->len, o->cap - o->len, fmt, ap)
+                            : vsnprintf(NULL, 0, fmt, ap);
+    va_end(ap);
+    if (n > 0) o->len += (size_t)n;
+}
+
+static void out_family(struct metrics_out *o, const char *name, const char *type, const char *help)
+{
+    out_printf(o, "# TYPE %s %s\n# HELP %s %s\n", name, type, name, help);
+}
+
+struct chan_row { char label[METRICS_LABEL_MAX]; struct kc_chan_snapshot s; };
+struct sched_row { char label[METRICS_LABEL_MAX]; kc_sched_stats_t s; };
+
+enum chan_metric {
+    CM_SENDS, CM_RECVS, CM_BYTES_SENT, CM_BYTES_RECV, CM_DEPTH, CM_CAPACITY, CM_CLOSED,
+    CM_ZREF_SENT, CM_ZREF_RECV, CM_RV_MATCHES, CM_RV_CANCELS,
+};
+
+static const struct {
+    enum chan_metric m;
+    const char *name, *type, *help;
+} chan_families[] = {
+    { CM_SENDS, "kcoro_chan_sends", "counter", "Elements sent." },
+    { CM_RECVS, "kcoro_chan_recvs", "counter", "Elements received." },
+    { CM_BYTES_SENT, "kcoro_chan_sent_bytes", "counter", "Payload bytes sent." },
+    { CM_BYTES_RECV, "kcoro_chan_received_bytes", "counter", "Payload bytes received." },
+    { CM_DEPTH, "kcoro_chan_depth", "gauge", "Elements queued." },
+    { CM_CAPACITY, "kcoro_chan_capacity", "gauge", "Capacity in elements (0 for rendezvous and conflated)." },
+    { CM_CLOSED, "kcoro_chan_closed", "gauge", "1 once the channel is closed." },
+    { CM_ZREF_SENT, "kcoro_chan_zref_sends", "counter", "Zero-copy descriptors sent." },
+    { CM_ZREF_RECV, "kcoro_chan_zref_recvs", "counter", "Zero-copy descriptors received." },
+    { CM_RV_MATCHES, "kcoro_chan_rendezvous_matches", "counter", "Rendezvous sender/receiver pairings." },
+    { CM_RV_CANCELS, "kcoro_chan_rendezvous_cancels", "counter", "Rendezvous waiters cancelled by close." },
+};
+
+static unsigned long chan_value(const struct kc_chan_snapshot *s, enum chan_metric m)
+{
+    switch (m) {
+    case CM_SENDS: return s->total_sends;
+    case CM_RECVS: return s->total_recvs;
+    case CM_BYTES_SENT: return s->total_bytes_sent;
+    case CM_BYTES_RECV: return s->total_bytes_recv;
+    case CM_DEPTH: return s->count;
+    case CM_CAPACITY: return s->capacity;
+    case CM_CLOSED: return (unsigned long)s->closed;
+    case CM_ZREF_SENT: return s->zref_sent;
+    case CM_ZREF_RECV: return s->zref_received;
+    case CM_RV_MATCHES: return s->rv_matches;
+    case CM_RV_CANCELS: return s->rv_cancels;
+    }
+    return 0;
+}
+
+static void render_chans(struct metrics_out *o, const struct chan_row *rows, int n)
+{
+    if (!n) return;
+    for (size_t f = 0; f < sizeof(chan_families) / sizeof(chan_families[0]); f++) {
+        int counter = chan_families[f].type[0] == 'c';
+        out_family(o, chan_families[f].name, chan_families[f].type, chan_families[f].help);
+        for (int i = 0; i < n; i++)
+            out_printf(o, "%s%s{chan=\"%s\"} %lu\n", chan_families[f].name, counter ? "_total" : "",
+                       rows[i].label, chan_value(&rows[i].s, chan_families[f].m));
+    }
+    static const char *reasons[] = { "eagain", "etime", "epipe" };
+    out_family(o, "kcoro_chan_send_failures", "counter", "Sends that returned an error, by reason.");
+    for (int i = 0; i < n; i++) {
+        unsigned long v[] = { rows[i].s.send_eagain, rows[i].s.send_etime, rows[i].s.send_epipe };
+        for (int r = 0; r < 3; r++)
+            out_printf(o, "kcoro_chan_send_failures_total{chan=\"%s\",reason=\"%s\"} %lu\n", rows[i].label, reasons[r], v[r]);
+    }
+    out_family(o, "kcoro_chan_recv_failures", "counter", "Receives that returned an error, by reason.");
+    for (int i = 0; i < n; i++) {
+        unsigned long v[] = { rows[i].s.recv_eagain, rows[i].s.recv_etime, rows[i].s.recv_epipe };
+        for (int r = 0; r < 3; r++)
+            out_printf(o, "kcoro_chan_recv_failures_total{chan=\"%s\",reason=\"%s\"} %lu\n", rows[i].label, reasons[r], v[r]);
+    }
+}
+
+static const struct {
+    const char *name, *type, *help;
+    size_t off;
+} sched_families[] = {
+#define SF(n, t, h, f) { n, t, h, offsetof(kc_sched_stats_t, f) }
+    SF("kcoro_sched_tasks_submitted", "counter", "Tasks submitted.", tasks_submitted),
+    SF("kcoro_sched_tasks_completed", "counter", "Tasks completed.", tasks_completed),
+    SF("kcoro_sched_steal_probes", "counter", "Victim deques probed by thieves.", steals_probes),
+    SF("kcoro_sched_steals", "counter", "Tasks stolen from another worker.", steals_succeeded),
+    SF("kcoro_sched_steals_remote", "counter", "Steals from a worker on another NUMA node.", steals_remote),
+    SF("kcoro_sched_inject_pulls", "counter", "Items taken from the global inject queue.", inject_pulls),
+    SF("kcoro_sched_ready_local", "counter", "Coroutine wakes kept on the waking worker.", ready_local),
+    SF("kcoro_sched_ready_global", "counter", "Coroutine wakes through the global list.", ready_global),
+    SF("kcoro_sched_runnext_hits", "counter", "Resumes taken from a runnext slot.", runnext_hits),
+    SF("kcoro_sched_worker_parks", "counter", "Times a worker went to sleep.", park_events),
+    SF("kcoro_sched_worker_unparks", "counter", "Targeted wakes of a sleeping worker.", unpark_events),
+    SF("kcoro_sched_scale_ups", "counter", "Dormant workers started.", scale_ups),
+    SF("kcoro_sched_scale_downs", "counter", "Idle workers retired.", scale_downs),
+    SF("kcoro_sched_workers_active", "gauge", "Worker slots with a running thread.", workers_active),
+#undef SF
+};
+
+static void render_scheds(struct metrics_out *o, const struct sched_row *rows, int n)
+{
+    if (!n) return;
+    for (size_t f = 0; f < sizeof(sched_families) / sizeof(sched_families[0]); f++) {
+        int counter = sched_families[f].type[0] == 'c';
+        out_family(o, sched_families[f].name, sched_families[f].type, sched_families[f].help);
+        for (int i = 0; i < n; i++) {
+            unsigned long v;
+            memcpy(&v, (const char*)&rows[i].s + sched_families[f].off, sizeof(v));
+            out_printf(o, "%s%s{sched=\"%s\"} %lu\n", sched_families[f].name, counter ? "_total" : "", rows[i].label, v);
+        }
+    }
+    static const char *lanes[KC_LANE_COUNT] = { "interactive", "bulk" };
+    out_family(o, "kcoro_sched_lane_submitted", "counter", "Tasks spawned and coroutines made ready, by lane.");
+    for (int i = 0; i < n; i++)
+        for (int l = 0; l < KC_LANE_COUNT; l++)
+            out_printf(o, "kcoro_sched_lane_submitted_total{sched=\"%s\",lane=\"%s\"} %lu\n", rows[i].label, lanes[l], rows[i].s.lane_submitted[l]);
+    out_family(o, "kcoro_sched_lane_run", "counter", "Tasks run and coroutine resumes, by lane.");
+    for (int i = 0; i < n; i++)
+        for (int l = 0; l < KC_LANE_COUNT; l++)
+            out_printf(o, "kcoro_sched_lane_run_total{sched=\"%s\",lane=\"%s\"} %lu\n", rows[i].label, lanes[l], rows[i].s.lane_run[l]);
+}
+
+static void render_mem(struct metrics_out *o)
+{
+    kc_mem_stats_t m;
+    kc_mem_get_stats(&m);
+    const struct { const char *name, *type, *help; const void *v; int ul; } fam[] = {
+        { "kcoro_mem_bytes", "gauge", "Bytes charged to each runtime memory category.", m.bytes, 0 },
+        { "kcoro_mem_peak_bytes", "gauge", "Highest bytes charged to each category.", m.peak, 0 },
+        { "kcoro_mem_limit_bytes", "gauge", "Soft limit of each category (0 = none).", m.limit, 0 },
+        { "kcoro_mem_denied", "counter", "Charges refused by a soft limit.", m.denied, 1 },
+    };
+    for (size_t f = 0; f < sizeof(fam) / sizeof(fam[0]); f++) {
+        out_family(o, fam[f].name, fam[f].type, fam[f].help);
+        for (int c = 0; c < KC_MEM_CAT_COUNT; c++) {
+            unsigned long v = fam[f].ul ? ((const unsigned long*)fam[f].v)[c]
+                                        : (unsigned long)((const size_t*)fam[f].v)[c];
+            out_printf(o, "%s%s{cat=\"%s\"} %lu\n", fam[f].name, fam[f].ul ? "_total" : "",
+                       kc_mem_cat_name((kc_mem_cat_t)c), v);
+        }
+    }
+    out_family(o, "kcoro_mem_total_bytes", "gauge", "Bytes charged over all categories.");
+    out_printf(o, "kcoro_mem_total_bytes %zu\n", m.total);
+    out_family(o, "kcoro_mem_total_limit_bytes", "gauge", "Soft limit over all categories (0 = none).");
+    out_printf(o, "kcoro_mem_total_limit_bytes %zu\n", m.total_limit);
+}
+
+static void render_io(struct metrics_out *o)
+{
+    kc_io_stats_t io;
+    kc_io_get_stats(&io);
+    const struct { const char *name, *help; unsigned long v; } fam[] = {
+        { "kcoro_io_submitted", "io_uring SQEs handed to the kernel.", io.submitted },
+        { "kcoro_io_completed", "io_uring CQEs reaped.", io.completed },
+        { "kcoro_io_enters", "io_uring_enter submit calls.", io.enters },
+        { "kcoro_io_fixed", "Fixed-buffer reads and writes.", io.fixed },
+        { "kcoro_io_fallbacks", "I/O calls served by the plain syscall path.", io.fallbacks },
+    };
+    for (size_t f = 0; f < sizeof(fam) / sizeof(fam[0]); f++) {
+        out_family(o, fam[f].name, "counter", fam[f].help);
+        out_printf(o, "%s_total %lu\n", fam[f].name, fam[f].v);
+    }
+}
+
+long kc_metrics_render(char *buf, size_t cap)
+{
+    if (!buf && cap) return -EINVAL;
+    struct chan_row *chans = (struct chan_row*)malloc(KCORO_METRICS_MAX * sizeof(*chans));
+    struct sched_row *scheds = (struct sched_row*)malloc(KCORO_METRICS_MAX * sizeof(*scheds));
+    if (!chans || !scheds) { free(chans); free(scheds); return -ENOMEM; }
+    int nc = 0, ns = 0;
+    for (int i = 0; i < KCORO_METRICS_MAX; i++) {
+        struct kc_metrics_slot *sl = &g_slots[i];
+        if (slot_enter(sl, OBJ_CHAN)) {
+            memcpy(chans[nc].label, sl->label, sizeof(sl->label));
+            kc_chan_peek_snapshot((struct kc_chan*)sl->obj, &chans[nc].s);
+            slot_exit(sl);
+            nc++;
+        } else if (slot_enter(sl, OBJ_SCHED)) {
+            memcpy(scheds[ns].label, sl->label, sizeof(sl->label));
+            kc_sched_get_stats((kc_sched_t*)sl->obj, &scheds[ns].s);
+            slot_exit(sl);
+            ns++;
+        }
+    }
+    struct metrics_out o = { buf, cap, 0 };
+    if (cap) buf[0] = '\0';
+    render_chans(&o, chans, nc);
+    render_scheds(&o, scheds, ns);
+    render_mem(&o);
+    render_io(&o);
+    out_printf(&o, "# EOF\n");
+    free(chans);
+    free(scheds);
+    return (long)o.len;
+}
+
+int kc_metrics_chans(kc_metrics_chan_t *out, int n)
+{
+    if (!out || n < 0) return -EINVAL;
+    int got = 0;
+    for (int i = 0; i < KCORO_METRICS_MAX && got < n; i++) {
+        struct kc_metrics_slot *sl = &g_slots[i];
+        if (!slot_enter(sl, OBJ_CHAN)) continue;
+        memcpy(out[got].name, sl->label, sizeof(out[got].name));
+        kc_chan_peek_snapshot((struct kc_chan*)sl->obj, &out[got].s);
+        slot_exit(sl);
+        got++;
+    }
+    return got;
+}
+
+/* ---- Push ---- */
+
+int kc_metrics_push(kc_chan_t *pipe)
+{
+    if (!pipe) return -EINVAL;
+    int sent = 0;
+    long now = kc_now_ns();
+    pthread_mutex_lock(&g_push_mu);
+    for (int i = 0; i < KCORO_METRICS_MAX; i++) {
+        struct kc_metrics_slot *sl = &g_slots[i];
+        if (!slot_enter(sl, OBJ_CHAN)) continue;
+        struct kc_chan_snapshot s;
+        kc_chan_peek_snapshot((struct kc_chan*)sl->obj, &s);
+        struct kc_chan_metrics_event ev = {
+            .chan = sl->obj,
+            .total_sends = s.total_sends,
+            .total_recvs = s.total_recvs,
+            .total_bytes_sent = s.total_bytes_sent,
+            .total_bytes_recv = s.total_bytes_recv,
+            .delta_sends = s.total_sends - sl->push_sends,
+            .delta_recvs = s.total_recvs - sl->push_recvs,
+            .delta_bytes_sent = s.total_bytes_sent - sl->push_bytes_sent,
+            .delta_bytes_recv = s.total_bytes_recv - sl->push_bytes_recv,
+            .first_op_time_ns = s.first_op_time_ns,
+            .last_op_time_ns = s.last_op_time_ns,
+            .emit_time_ns = now,
+        };
+        if ((ev.delta_sends || ev.delta_recvs) && kc_chan_try_send(pipe, &ev) == 0) {
+            sl->push_sends = s.total_sends;
+            sl->push_recvs = s.total_recvs;
+            sl->push_bytes_sent = s.total_bytes_sent;
+            sl->push_bytes_recv = s.total_bytes_recv;
+            sent++;
+        }
+        slot_exit(sl);
+    }
+    pthread_mutex_unlock(&g_push_mu);
+    return sent;
+}
+
+/* ---- HTTP exporter ---- */
+
+struct kc_metrics_server {
+    int fd;
+    int port;
+    _Atomic int stop;
+    _Atomic int done;
+};
+
+#define METRICS_IO_TIMEOUT_MS 2000
+#define METRICS_POLL_MS 100
+
+/* Write all of len, waiting on the reactor when the socket is full. */
+static int metrics_write_all(int fd, const char *p, size_t len)
+{
+    while (len) {
+        ssize_t w = write(fd, p, len);
+        if (w > 0) { p += w; len -= (size_t)w; continue; }
+        if (w < 0 && errno == EINTR) continue;
+        if (w < 0 && errno == EAGAIN) {
+            if (kc_await_writable(fd, METRICS_IO_TIMEOUT_MS) != 0) return -ETIMEDOUT;
+            continue;
+        }
+        return -errno;
+    }
+    return 0;
+}
+
+static void metrics_serve_conn(int fd, char **body, size_t *cap)
+{
+    char req[2048];
+    size_t n = 0;
+    while (n < sizeof(req) - 1) {
+        ssize_t r = read(fd, req + n, sizeof(req) - 1 - n);
+        if (r > 0) {
+            n += (size_t)r;
+            req[n] = '\0';
+            if (strstr(req, "\r\n\r\n") || strstr(req, "\n\n")) break;
+            continue;
+        }
+        if (r < 0 && errno == EINTR) continue;
+        if (r < 0 && errno == EAGAIN && kc_await_readable(fd, METRICS_IO_TIMEOUT_MS) == 0) continue;
+        return;
+    }
+    req[n] = '\0';
+    char head[256];
+    if (strncmp(req, "GET ", 4) != 0) {
+        static const char bad[] = "HTTP/1.0 405 Method Not Allowed\r\nAllow: GET\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+        (void)metrics_write_all(fd, bad, sizeof(bad) - 1);
+        return;
+    }
+    const char *path = req + 4;
+    if (strncmp(path, "/metrics", 8) != 0 && strncmp(path, "/ ", 2) != 0) {
+        static const char nf[] = "HTTP/1.0 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+        (void)metrics_write_all(fd, nf, sizeof(nf) - 1);
+        return;
+    }
+    long len;
+    while ((len = kc_metrics_render(*body, *cap)) >= (long)*cap) {
+        char *nb = (char*)realloc(*body, (size_t)len + 1);
+        if (!nb) return;
+        *body = nb;
+        *cap = (size_t)len + 1;
+    }
+    if (len < 0) return;
+    int hl = snprintf(head, sizeof(head),
+                      "HTTP/1.0 200 OK\r\n"
+                      "Content-Type: application/openmetrics-text; version=1.0.0; charset=utf-8\r\n"
+                      "Content-Length: %ld\r\nConnection: close\r\n\r\n", len);
+    if (metrics_write_all(fd, head, (size_t)hl) == 0) (void)metrics_write_all(fd, *body, (size_t)len);
+}
+
+static void metrics_server_co(void *arg)
+{
+    struct kc_metrics_server *srv = (struct kc_metrics_server*)arg;
+    size_t cap = 16384;
+    char *body = (char*)malloc(cap);
+    while (body && !atomic_load_explicit(&srv->stop, memory_order_acquire)) {
+        if (kc_await_readable(srv->fd, METRICS_POLL_MS) != 0) continue;
+        int c = accept4(srv->fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (c < 0) continue;
+        metrics_serve_conn(c, &body, &cap);
+        close(c);
+    }
+    free(body);
+    atomic_store_explicit(&srv->done, 1, memory_order_release);
+}
+
+int kc_metrics_serve(kc_sched_t *s, const char *host, int port, kc_metrics_server_t **out)
+{
+    if (!out || port < 0 || port > 65535) return -EINVAL;
+    *out = NULL;
+    if (!s) s = kc_sched_default();
+    char service[8];
+    snprintf(service, sizeof(service), "%d", port);
+    struct addrinfo hints = { .ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM, .ai_flags = AI_PASSIVE };
+    struct addrinfo *res = NULL;
+    int gai = getaddrinfo(host, service, &hints, &res);
+    if (gai != 0) return gai == EAI_SYSTEM ? -errno : -EADDRNOTAVAIL;
+    int fd = -1, err = EADDRNOTAVAIL;
+    for (struct addrinfo *ai = res; ai; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, ai->ai_protocol);
+        if (fd < 0) { err = errno; continue; }
+        int one = 1;
+        (void)setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (bind(fd, ai->ai_addr, ai->ai_addrlen) == 0 && listen(fd, 64) == 0) break;
+        err = errno;
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(res);
+    if (fd < 0) return -err;
+
+    struct sockaddr_storage ss;
+    socklen_t sl = sizeof(ss);
+    struct kc_metrics_server *srv = (struct kc_metrics_server*)calloc(1, sizeof(*srv));
+    if (!srv || getsockname(fd, (struct sockaddr*)&ss, &sl) != 0) {
+        err = srv ? errno : ENOMEM;
+        free(srv);
+        close(fd);
+        return -err;
+    }
+    srv->fd = fd;
+    srv->port = ss.ss_family == AF_INET6 ? ntohs(((struct sockaddr_in6*)&ss)->sin6_port)
+                                         : ntohs(((struct sockaddr_in*)&ss)->sin_port);
+    if (kc_spawn_co(s, metrics_server_co, srv, 0, NULL) != 0) {
+        close(fd);
+        free(srv);
+        return -ENOMEM;
+    }
+    *out = srv;
+    return 0;
+}
+
+int kc_metrics_server_port(const kc_metrics_server_t *srv)
+{
+    return srv ? srv->port : -EINVAL;
+}
+
+int kc_metrics_server_stop(kc_metrics_server_t *srv)
+{
+    if (!srv) return -EINVAL;
+    atomic_store_explicit(&srv->stop, 1, memory_order_release);
+    int in_co = kcoro_current() && kc_sched_current();
+    while (!atomic_load_explicit(&srv->done, memory_order_acquire)) {
+        if (in_co) kc_sleep_ms(1);
+        else usleep(1000);
+    }
+    close(srv->fd);
+    free(srv);
+    return 0;
+}
@@ -0,0 +1,296 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/*
+ * kc_mstream.c — zero-copy record streams over memory-mapped files
+ * ----------------------------------------------------------------
+ *
+ * Layout
+ * - The file is mapped read-only and registered as a region that owns the
+ *   mapping and the descriptor (kc_region_adopt_file), kept out of the
+ *   io_uring fixed-buffer tables so nothing pins the whole file.
+ * - Descriptors are handed out in file order. The ones still out sit in a
+ *   FIFO of window entries; a release marks its entry and pops the done
+ *   ones off the front, so the front is the oldest byte a consumer may
+ *   still read (the low mark).
+ *
+ * Residency
+ * - Readahead: each next tops the MADV_WILLNEED range up to `readahead`
+ *   bytes past the stream position once less than half of it is left, so
+ *   one madvise covers readahead/2 bytes of records.
+ * - Drop behind: when the low mark moves, whole pages more than
+ *   keep_behind bytes below it go with MADV_DONTNEED; later touches would
+ *   fault them back in from the page cache.
+ * - Window: next takes a credit from a buffered channel of `window` tokens
+ *   and entries leaving the front of the FIFO give theirs back, so a
+ *   producer coroutine parks (and a thread sleeps) rather than spins while
+ *   consumers hold the window. A descriptor released out of order keeps
+ *   its credit until the ones before it are back.
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "../../include/kcoro.h"
+#include "../../include/kcoro_zcopy.h"
+#include "../../include/kcoro_config.h"
+#include "../../include/kcoro_port.h"
+#include "kc_region_internal.h"
+
+struct mstream_out {
+    uint64_t off, end;
+    int done;
+};
+
+struct kc_mstream {
+    kc_mstream_opts_t o;
+    kc_region_t *reg;
+    unsigned long region_id;
+    const unsigned char *base;
+    uint64_t size;
+    size_t page;
+    kc_chan_t *credits;
+    pthread_mutex_t mu;
+    uint64_t pos;           /* next record */
+    uint64_t ra;            /* advised MADV_WILLNEED up to here */
+    uint64_t dropped;       /* pages below this are dropped */
+    struct mstream_out *out;
+    unsigned head, count;   /* FIFO of descriptors out */
+    struct kc_mstream_stats st;
+};
+
+static uint64_t page_down(const kc_mstream_t *s, uint64_t off) { return off & ~(uint64_t)(s->page - 1); }
+
+/* End of the record at off: 0 past the end of the file, UINT64_MAX when
+ * the file cuts it short. */
+static uint64_t record_end(const kc_mstream_t *s, uint64_t off)
+{
+    if (off >= s->size) return 0;
+    uint64_t left = s->size - off;
+    switch (s->o.framing) {
+    case KC_MSTREAM_FIXED:
+        return left >= s->o.record_size ? off + s->o.record_size : UINT64_MAX;
+    case KC_MSTREAM_DELIM: {
+        const unsigned char *p = memchr(s->base + off, s->o.delim, (size_t)left);
+        return p ? (uint64_t)(p - s->base) + 1 : s->size;
+    }
+    default: {
+        if (left < 4) return UINT64_MAX;
+        const unsigned char *h = s->base + off;
+        uint64_t n = (uint64_t)h[0] | (uint64_t)h[1] << 8 | (uint64_t)h[2] << 16 | (uint64_t)h[3] << 24;
+        return n <= left - 4 ? off + 4 + n : UINT64_MAX;
+    }
+    }
+}
+
+/* Called with s->mu held. */
+static void mstream_readahead(kc_mstream_t *s)
+{
+    uint64_t want = s->pos + s->o.readahead;
+    if (want > s->size) want = s->size;
+    if (s->ra >= s->size || s->ra >= s->pos + s->o.readahead / 2) return;
+    uint64_t from = page_down(s, s->ra > s->pos ? s->ra : s->pos);
+    if (want > from) {
+        (void)madvise((void*)(s->base + from), (size_t)(want - from), MADV_WILLNEED);
+        s->st.willneed += want - from;
+    }
+    s->ra = want;
+}
+
+/* Called with s->mu held. */
+static void mstream_drop_behind(kc_mstream_t *s)
+{
+    uint64_t low = s->count ? s->out[s->head].off : s->pos;
+    if (low <= s->o.keep_behind) return;
+    uint64_t to = page_down(s, low - s->o.keep_behind);
+    if (to <= s->dropped) return;
+    (void)madvise((void*)(s->base + s->dropped), (size_t)(to - s->dropped), MADV_DONTNEED);
+    s->st.dropped += to - s->dropped;
+    s->dropped = to;
+}
+
+static void mstream_credit(kc_mstream_t *s)
+{
+    unsigned char tok = 0;
+    (void)kc_chan_send_thread(s->credits, &tok, 0);
+}
+
+int kc_mstream_open(kc_mstream_t **out, const char *path, const kc_mstream_opts_t *opts)
+{
+    if (!out || !path || !opts) return -EINVAL;
+    *out = NULL;
+    if ((opts->framing == KC_MSTREAM_FIXED && !opts->record_size) ||
+        (opts->framing == KC_MSTREAM_DELIM && (opts->delim < 0 || opts->delim > 255)) ||
+        (unsigned)opts->framing > KC_MSTREAM_LEN32)
+        return -EINVAL;
+    kc_mstream_t *s = calloc(1, sizeof(*s));
+    if (!s) return -ENOMEM;
+    s->o = *opts;
+    pthread_mutex_init(&s->mu, NULL);
+    if (!s->o.readahead) s->o.readahead = KCORO_MSTREAM_READAHEAD;
+    if (!s->o.window) s->o.window = KCORO_MSTREAM_WINDOW;
+    long ps = sysconf(_SC_PAGESIZE);
+    s->page = ps > 0 ? (size_t)ps : 4096;
+    int rc;
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) { rc = -errno; goto fail; }
+    struct stat st;
+    if (fstat(fd, &st) != 0) { rc = -errno; close(fd); goto fail; }
+    if (!S_ISREG(st.st_mode) || st.st_size <= 0) { rc = -EINVAL; close(fd); goto fail; }
+    s->size = (uint64_t)st.st_size;
+    void *base = mmap(NULL, (size_t)s->size, PROT_READ, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) { rc = -errno; close(fd); goto fail; }
+    if ((rc = kc_region_adopt_file(&s->reg, base, (size_t)s->size, fd)) != 0) {
+        munmap(base, (size_t)s->size);
+        close(fd);
+        goto fail;
+    }
+    s->base = base;
+    (void)kc_region_export_id(s->reg, &s->region_id);
+    (void)madvise(base, (size_t)s->size, MADV_SEQUENTIAL);
+    s->out = calloc(s->o.window, sizeof(*s->out));
+    if (!s->out) { rc = -ENOMEM; goto fail; }
+    if ((rc = kc_chan_make(&s->credits, KC_BUFFERED, 1, s->o.window)) != 0) goto fail;
+    for (unsigned i = 0; i < s->o.window; i++) mstream_credit(s);
+    mstream_readahead(s);
+    *out = s;
+    return 0;
+fail:
+    if (s->credits) kc_chan_destroy(s->credits);
+    if (s->reg) (void)kc_region_deregister(s->reg);
+    pthread_mutex_destroy(&s->mu);
+    free(s->out);
+    free(s);
+    return rc;
+}
+
+int kc_mstream_next(kc_mstream_t *s, kc_zdesc_t *d, long timeout_ms)
+{
+    if (!s || !d) return -EINVAL;
+    unsigned char tok;
+    int rc = kc_chan_recv_thread(s->credits, &tok, 0);
+    if (rc == KC_EAGAIN) {
+        pthread_mutex_lock(&s->mu);
+        s->st.window_waits++;
+        pthread_mutex_unlock(&s->mu);
+        if (timeout_ms != 0) rc = kc_chan_recv_thread(s->credits, &tok, timeout_ms);
+    }
+    if (rc != 0) return rc;
+    pthread_mutex_lock(&s->mu);
+    uint64_t off = s->pos, end = record_end(s, off);
+    if (end == 0 || end == UINT64_MAX) {
+        pthread_mutex_unlock(&s->mu);
+        mstream_credit(s);
+        return end == 0 ? KC_EPIPE : -EBADMSG;
+    }
+    /* Whole records up to batch_bytes; a bad one waits for the next call */
+    unsigned long recs = 1;
+    for (uint64_t e; end < s->size && (e = record_end(s, end)) != UINT64_MAX && e - off <= s->o.batch_bytes; recs++)
+        end = e;
+    struct mstream_out *o = &s->out[(s->head + s->count) % s->o.window];
+    o->off = off;
+    o->end = end;
+    o->done = 0;
+    s->count++;
+    s->pos = end;
+    s->st.records += recs;
+    s->st.descs++;
+    s->st.bytes += end - off;
+    mstream_readahead(s);
+    pthread_mutex_unlock(&s->mu);
+    d->addr = (void*)(s->base + off);
+    d->len = (size_t)(end - off);
+    d->region_id = s->region_id;
+    d->offset = off;
+    d->flags = 0;
+    return 0;
+}
+
+/* Take back the descriptor next handed out last, which a send refused, so
+ * the next call hands it out again. */
+static void mstream_unnext(kc_mstream_t *s, const kc_zdesc_t *d)
+{
+    pthread_mutex_lock(&s->mu);
+    struct mstream_out *o = s->count ? &s->out[(s->head + s->count - 1) % s->o.window] : NULL;
+    int last = o && o->off == d->offset && o->end == s->pos;
+    if (last) {
+        s->count--;
+        s->pos = o->off;
+        s->st.descs--;
+        s->st.bytes -= o->end - o->off;
+    }
+    pthread_mutex_unlock(&s->mu);
+    if (last) mstream_credit(s);
+}
+
+int kc_mstream_pump(kc_mstream_t *s, kc_chan_t *ch, long timeout_ms)
+{
+    if (!s || !ch) return -EINVAL;
+    for (;;) {
+        kc_zdesc_t d;
+        int rc = kc_mstream_next(s, &d, timeout_ms);
+        if (rc == KC_EPIPE) return 0;
+        if (rc != 0) return rc;
+        if ((rc = kc_chan_send_desc(ch, &d, timeout_ms)) != 0) {
+            mstream_unnext(s, &d);
+            return rc;
+        }
+    }
+}
+
+int kc_mstream_release(kc_mstream_t *s, const kc_zdesc_t *d)
+{
+    if (!s || !d || !d->addr) return -EINVAL;
+    const unsigned char *p = d->addr;
+    if (p < s->base || p >= s->base + s->size) return -EINVAL;
+    uint64_t off = (uint64_t)(p - s->base);
+    pthread_mutex_lock(&s->mu);
+    struct mstream_out *hit = NULL;
+    for (unsigned i = 0; i < s->count && !hit; i++) {
+        struct mstream_out *o = &s->out[(s->head + i) % s->o.window];
+        if (o->off == off && !o->done) hit = o;
+    }
+    if (!hit) { pthread_mutex_unlock(&s->mu); return -EINVAL; }
+    hit->done = 1;
+    unsigned popped = 0;
+    while (s->count && s->out[s->head].done) {
+        s->head = (s->head + 1) % s->o.window;
+        s->count--;
+        popped++;
+    }
+    if (popped) mstream_drop_behind(s);
+    pthread_mutex_unlock(&s->mu);
+    while (popped--) mstream_credit(s);
+    return 0;
+}
+
+kc_region_t *kc_mstream_region(const kc_mstream_t *s) { return s ? s->reg : NULL; }
+size_t kc_mstream_size(const kc_mstream_t *s) { return s ? (size_t)s->size : 0; }
+
+int kc_mstream_get_stats(kc_mstream_t *s, struct kc_mstream_stats *out)
+{
+    if (!s || !out) return -EINVAL;
+    pthread_mutex_lock(&s->mu);
+    *out = s->st;
+    out->inflight = s->count;
+    pthread_mutex_unlock(&s->mu);
+    return 0;
+}
+
+int kc_mstream_close(kc_mstream_t *s)
+{
+    if (!s) return -EINVAL;
+    pthread_mutex_lock(&s->mu);
+    unsigned out = s->count;
+    pthread_mutex_unlock(&s->mu);
+    if (out) return -EBUSY;
+    kc_chan_destroy(s->credits);
+    (void)kc_region_deregister(s->reg);
+    pthread_mutex_destroy(&s->mu);
+    free(s->out);
+    free(s);
+    return 0;
+}
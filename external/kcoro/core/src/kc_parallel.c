@@ -0,0 +1,171 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/*
+ * kc_parallel.c — kc_parallel_for / kc_parallel_reduce
+ * ----------------------------------------------------
+ *
+ * Lazy binary splitting
+ * - A range task runs its range grain iterations at a time. Before each
+ *   chunk it checks its worker's deque; only when that is empty (nobody has
+ *   a queued half of ours left to steal) does it fork the upper half of
+ *   what remains through kc_spawn, which lands on that same deque. An
+ *   unstolen half is popped back and run by the join, so a loop nobody
+ *   steals from costs one fork in flight at a time, and a thief that takes
+ *   a half splits it again the same way.
+ * - Single-worker schedulers never fork.
+ *
+ * Completion
+ * - `left` counts iterations not yet run; each range task subtracts what it
+ *   ran as its last act, so the job (on the caller's stack) is done and may
+ *   go once it reads 0. A joiner that is a worker of s runs queued tasks
+ *   meanwhile (kc_sched_help). Any other caller queues the whole range and
+ *   sleeps on cv; for it the task that reaches 0 sets `done` under mu.
+ * - Reduce: every range task folds into its own accumulator, seeded from
+ *   identity, and combines it into *out under mu before it subtracts.
+ */
+#include <errno.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../include/kcoro_sched.h"
+#include "../../include/kcoro_port.h"
+#include "../../include/kcoro_config.h"
+#include "kc_parallel_internal.h"
+
+struct pfor_job {
+    kc_sched_t *s;
+    kc_range_fn fn;           /* kc_parallel_for, else reduce: */
+    kc_reduce_fn rfn;
+    kc_combine_fn combine;
+    void *ctx;
+    const void *identity;
+    size_t acc_size;
+    void *out;                /* under mu */
+    size_t grain;
+    int split;                /* more than one worker: forking can pay */
+    int external;             /* joiner sleeps on cv */
+    _Atomic size_t left;      /* iterations not yet run */
+    KC_MUTEX_T mu;
+    KC_COND_T cv;
+    int done;                 /* under mu, external joins only */
+};
+
+struct pfor_range {
+    struct pfor_job *job;
+    size_t begin, end;
+    max_align_t acc[];        /* job->acc_size bytes */
+};
+
+static struct pfor_range *range_new(struct pfor_job *j, size_t begin, size_t end)
+{
+    struct pfor_range *r = (struct pfor_range *)malloc(sizeof(*r) + j->acc_size);
+    if (!r) return NULL;
+    r->job = j;
+    r->begin = begin;
+    r->end = end;
+    if (j->acc_size) memcpy(r->acc, j->identity, j->acc_size);
+    return r;
+}
+
+static void range_run(void *arg)
+{
+    struct pfor_range *r = (struct pfor_range *)arg;
+    struct pfor_job *j = r->job;
+    size_t b = r->begin, e = r->end, ran = 0;
+    while (b < e) {
+        if (j->split && e - b > j->grain && kc_sched_local_depth(j->s) == 0) {
+            size_t mid = b + (e - b) / 2;
+            struct pfor_range *half = range_new(j, mid, e);
+            if (half && kc_spawn(j->s, range_run, half) == 0) { e = mid; continue; }
+            free(half);   /* no memory: run it here */
+        }
+        size_t c = e - b < j->grain ? e - b : j->grain;
+        if (j->rfn) j->rfn(j->ctx, b, b + c, r->acc);
+        else j->fn(j->ctx, b, b + c);
+        b += c;
+        ran += c;
+    }
+    if (j->rfn) {
+        KC_MUTEX_LOCK(&j->mu);
+        j->combine(j->ctx, j->out, r->acc);
+        KC_MUTEX_UNLOCK(&j->mu);
+    }
+    int external = j->external;
+    free(r);
+    if (atomic_fetch_sub_explicit(&j->left, ran, memory_order_acq_rel) != ran || !external) return;
+    KC_MUTEX_LOCK(&j->mu);
+    j->done = 1;
+    KC_COND_SIGNAL(&j->cv);
+    KC_MUTEX_UNLOCK(&j->mu);
+}
+
+static inline void pfor_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield" ::: "memory");
+#endif
+}
+
+static void pfor_join(struct pfor_job *j)
+{
+    if (j->external) {
+        KC_MUTEX_LOCK(&j->mu);
+        while (!j->done) KC_COND_WAIT(&j->cv, &j->mu);
+        KC_MUTEX_UNLOCK(&j->mu);
+        return;
+    }
+    unsigned idle = 0;
+    while (atomic_load_explicit(&j->left, memory_order_acquire) != 0) {
+        if (kc_sched_help(j->s) > 0) { idle = 0; continue; }
+        if (++idle < KCORO_PARALLEL_JOIN_SPIN) { pfor_relax(); continue; }
+        idle = 0;
+        kc_yield();   /* a thief is still on one of our halves */
+    }
+}
+
+static int pfor_run(struct pfor_job *j, size_t begin, size_t end, size_t grain)
+{
+    if (begin == end) return 0;
+    int workers = kc_sched_worker_count(j->s);
+    if (workers < 1) return -EINVAL;
+    size_t n = end - begin;
+    if (grain == KC_PARALLEL_GRAIN_AUTO) {
+        grain = n / ((size_t)workers * KCORO_PARALLEL_AUTO_CHUNKS);
+        if (grain == 0) grain = 1;
+    }
+    j->grain = grain;
+    j->split = workers > 1;
+    j->external = kc_sched_local_depth(j->s) < 0;
+    j->done = 0;
+    atomic_init(&j->left, n);
+    struct pfor_range *root = range_new(j, begin, end);
+    if (!root) return -ENOMEM;
+    KC_MUTEX_INIT(&j->mu);
+    KC_COND_INIT(&j->cv);
+    if (!j->external) range_run(root);
+    else if (kc_spawn(j->s, range_run, root) != 0) { j->external = 0; range_run(root); }
+    pfor_join(j);
+    KC_COND_DESTROY(&j->cv);
+    KC_MUTEX_DESTROY(&j->mu);
+    return 0;
+}
+
+int kc_parallel_for(kc_sched_t *s, size_t begin, size_t end, size_t grain, kc_range_fn fn, void *ctx)
+{
+    if (!s || !fn || end < begin) return -EINVAL;
+    struct pfor_job j = { .s = s, .fn = fn, .ctx = ctx };
+    return pfor_run(&j, begin, end, grain);
+}
+
+int kc_parallel_reduce(kc_sched_t *s, size_t begin, size_t end, size_t grain, const void *identity,
+                       size_t acc_size, kc_reduce_fn fn, kc_combine_fn combine, void *ctx, void *out)
+{
+    if (!s || !fn || !combine || !identity || !acc_size || !out || end < begin) return -EINVAL;
+    memcpy(out, identity, acc_size);
+    struct pfor_job j = { .s = s, .rfn = fn, .combine = combine, .ctx = ctx,
+                          .identity = identity, .acc_size = acc_size, .out = out };
+    return pfor_run(&j, begin, end, grain);
+}
@@ -0,0 +1,16 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include "../../include/kcoro_sched.h"
+
+/* Scheduler hooks for the fork-join helpers, kc_parallel.c and
+ * kc_task_group.c (implemented in kc_sched.c). */
+
+/* Length of the calling worker's own deque, or -1 when the caller is not a
+ * worker of s. Lazy splitting forks only while this is 0. */
+int kc_sched_local_depth(kc_sched_t *s);
+
+/* Run one queued task on behalf of a worker of s waiting on a join: its own
+ * newest first, else one stolen. Inside a coroutine, coroutine resumes are
+ * left queued. 1 if a task ran, 0 if none, -1 when not on a worker of s. */
+int kc_sched_help(kc_sched_t *s);
@@ -0,0 +1,314 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/*
+ * kc_prof.c — coroutine-aware SIGPROF sampler
+ * -------------------------------------------
+ *
+ * Handler (async-signal-safe)
+ * - Claims a slot of the preallocated buffer with one fetch_add; past the
+ *   end it only counts a drop.
+ * - Reads pc and frame pointer from the ucontext and the running kcoro_t
+ *   from TLS. The frame-pointer chain ([fp] = caller fp, [fp + 8] = return
+ *   address on both x86_64 and aarch64) is followed only while fp stays
+ *   inside the coroutine's own stack and moves towards its top, so a chain
+ *   that crosses kcoro_switch or a register that was never a frame pointer
+ *   ends the walk instead of faulting. Outside a coroutine only the pc is
+ *   kept.
+ * - Marks the slot done last; the writer skips slots a late signal left
+ *   half-filled.
+ *
+ * Writer
+ * - Runs after stop: symbolizes each sample with dladdr into one collapsed
+ *   line, sorts the lines and emits each distinct one with its count.
+ */
+#define _GNU_SOURCE 1
+#include <dlfcn.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ucontext.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include "../../include/kcoro_core.h"
+#include "../../include/kcoro_prof.h"
+#include "kcoro_share_internal.h"
+#include "kc_prof_internal.h"
+
+#define PROF_DEFAULT_HZ       99
+#define PROF_DEFAULT_SAMPLES  16384
+
+struct prof_sample {
+    _Atomic int done;
+    uint8_t in_co;
+    uint16_t n;                   /* pc[0] is the interrupted pc */
+    uint64_t id;
+    char name[KC_PROF_NAME_MAX];
+    uintptr_t pc[KC_PROF_DEPTH];
+};
+
+static struct prof_sample *g_buf;
+static size_t g_cap;
+static _Atomic size_t g_next;
+static _Atomic int g_on;
+static _Atomic uint64_t g_samples, g_in_co, g_dropped, g_truncated;
+static struct sigaction g_old_sa;
+static struct itimerval g_old_it;
+
+static int prof_regs(const void *ucv, uintptr_t *pc, uintptr_t *fp)
+{
+    const ucontext_t *uc = (const ucontext_t*)ucv;
+#if defined(__x86_64__)
+    *pc = (uintptr_t)uc->uc_mcontext.gregs[REG_RIP];
+    *fp = (uintptr_t)uc->uc_mcontext.gregs[REG_RBP];
+    return 1;
+#elif defined(__aarch64__) && defined(__linux__)
+    *pc = (uintptr_t)uc->uc_mcontext.pc;
+    *fp = (uintptr_t)uc->uc_mcontext.regs[29];
+    return 1;
+#elif defined(__aarch64__) && defined(__APPLE__)
+    *pc = (uintptr_t)uc->uc_mcontext->__ss.__pc;
+    *fp = (uintptr_t)uc->uc_mcontext->__ss.__fp;
+    return 1;
+#else
+    (void)uc; *pc = 0; *fp = 0;
+    return 0;
+#endif
+}
+
+static int prof_co_bounds(const kcoro_t *co, uintptr_t *lo, uintptr_t *hi)
+{
+    if (!co || !co->fn) return 0;     /* a thread's main context */
+    if (co->stack_ptr && co->stack_size) {
+        *lo = (uintptr_t)co->stack_ptr;
+        *hi = *lo + co->stack_size;
+        return 1;
+    }
+    return kcoro_share_bounds(co, lo, hi);
+}
+
+int kc_prof_walk(const void *ucv, uintptr_t *pc, int max, int *in_co)
+{
+    uintptr_t fp, lo, hi;
+    *in_co = 0;
+    if (max <= 0 || !prof_regs(ucv, &pc[0], &fp)) return 0;
+    int n = 1;
+    if (!prof_co_bounds(kcoro_current(), &lo, &hi)) return n;
+    *in_co = 1;
+    while (n < max && fp >= lo && fp <= hi - 2 * sizeof(uintptr_t) &&
+           (fp & (sizeof(uintptr_t) - 1)) == 0) {
+        const uintptr_t *f = (const uintptr_t*)fp;
+        uintptr_t next = f[0], ret = f[1];
+        if (!ret) break;
+        pc[n++] = ret;
+        if (next <= fp) break;
+        fp = next;
+    }
+    return n;
+}
+
+static void prof_handler(int sig, siginfo_t *si, void *ucv)
+{
+    (void)sig; (void)si;
+    int saved_errno = errno;
+    if (!atomic_load_explicit(&g_on, memory_order_acquire)) goto out;
+    size_t i = atomic_fetch_add_explicit(&g_next, 1, memory_order_relaxed);
+    if (i >= g_cap) { atomic_fetch_add_explicit(&g_dropped, 1, memory_order_relaxed); goto out; }
+    struct prof_sample *sm = &g_buf[i];
+    int in_co;
+    int n = kc_prof_walk(ucv, sm->pc, KC_PROF_DEPTH, &in_co);
+    if (!n) goto out;
+    sm->in_co = (uint8_t)in_co;
+    sm->id = 0;
+    sm->name[0] = '\0';
+    if (in_co) {
+        kcoro_t *co = kcoro_current();
+        sm->id = co->id;
+        if (co->name) {
+            size_t k = 0;
+            for (; k < KC_PROF_NAME_MAX - 1 && co->name[k]; k++) sm->name[k] = co->name[k];
+            sm->name[k] = '\0';
+        }
+        if (n == KC_PROF_DEPTH) atomic_fetch_add_explicit(&g_truncated, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&g_in_co, 1, memory_order_relaxed);
+    }
+    sm->n = (uint16_t)n;
+    atomic_store_explicit(&sm->done, 1, memory_order_release);
+    atomic_fetch_add_explicit(&g_samples, 1, memory_order_relaxed);
+out:
+    errno = saved_errno;
+}
+
+int kc_prof_start(int hz, size_t max_samples)
+{
+    if (atomic_load(&g_on)) return -EBUSY;
+    if (hz <= 0) hz = PROF_DEFAULT_HZ;
+    if (hz > 1000000) return -EINVAL;
+    if (!max_samples) max_samples = PROF_DEFAULT_SAMPLES;
+    struct prof_sample *buf = (struct prof_sample*)calloc(max_samples, sizeof(*buf));
+    if (!buf) return -ENOMEM;
+    free(g_buf);
+    g_buf = buf;
+    g_cap = max_samples;
+    atomic_store(&g_next, 0);
+    atomic_store(&g_samples, 0);
+    atomic_store(&g_in_co, 0);
+    atomic_store(&g_dropped, 0);
+    atomic_store(&g_truncated, 0);
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_sigaction = prof_handler;
+    sa.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    if (sigaction(SIGPROF, &sa, &g_old_sa) != 0) return -errno;
+    atomic_store_explicit(&g_on, 1, memory_order_release);
+    long us = 1000000L / hz;
+    struct itimerval it = { { us / 1000000L, us % 1000000L }, { us / 1000000L, us % 1000000L } };
+    if (it.it_interval.tv_sec == 0 && it.it_interval.tv_usec == 0) it.it_interval.tv_usec = it.it_value.tv_usec = 1;
+    if (setitimer(ITIMER_PROF, &it, &g_old_it) != 0) {
+        int rc = -errno;
+        atomic_store(&g_on, 0);
+        sigaction(SIGPROF, &g_old_sa, NULL);
+        return rc;
+    }
+    return 0;
+}
+
+int kc_prof_stop(void)
+{
+    if (!atomic_load(&g_on)) return -EINVAL;
+    setitimer(ITIMER_PROF, &g_old_it, NULL);
+    atomic_store_explicit(&g_on, 0, memory_order_release);
+    /* A signal already pending on another thread finds g_on clear (or a
+     * done slot the writer can use): keep our handler until then. */
+    sigaction(SIGPROF, &g_old_sa, NULL);
+    return 0;
+}
+
+int kc_prof_get_stats(kc_prof_stats_t *out)
+{
+    if (!out) return -EINVAL;
+    out->samples = atomic_load_explicit(&g_samples, memory_order_relaxed);
+    out->in_coroutine = atomic_load_explicit(&g_in_co, memory_order_relaxed);
+    out->dropped = atomic_load_explicit(&g_dropped, memory_order_relaxed);
+    out->truncated = atomic_load_explicit(&g_truncated, memory_order_relaxed);
+    return 0;
+}
+
+/* ---- Collapsed output ---- */
+
+struct prof_line { char *s; size_t len, cap; };
+
+static int line_put(struct prof_line *l, const char *s, size_t n)
+{
+    if (l->len + n + 1 > l->cap) {
+        size_t cap = l->cap ? l->cap * 2 : 256;
+        while (cap < l->len + n + 1) cap *= 2;
+        char *p = (char*)realloc(l->s, cap);
+        if (!p) return -ENOMEM;
+        l->s = p;
+        l->cap = cap;
+    }
+    memcpy(l->s + l->len, s, n);
+    l->len += n;
+    l->s[l->len] = '\0';
+    return 0;
+}
+
+/* Frame names must not contain the separators of the format. */
+static int line_put_clean(struct prof_line *l, const char *s)
+{
+    size_t start = l->len;
+    int rc = line_put(l, s, strlen(s));
+    for (size_t i = start; rc == 0 && i < l->len; i++)
+        if (l->s[i] == ';' || l->s[i] == ' ' || l->s[i] == '\n') l->s[i] = '_';
+    return rc;
+}
+
+static int line_put_frame(struct prof_line *l, uintptr_t pc, int is_return)
+{
+    char tmp[64];
+    Dl_info di;
+    uintptr_t at = is_return ? pc - 1 : pc;       /* the call, not the next insn */
+    int found = dladdr((void*)at, &di) != 0;   /* di is unset when it fails */
+    if (found && di.dli_sname) return line_put_clean(l, di.dli_sname);
+    if (found && di.dli_fname && di.dli_fname[0]) {
+        const char *base = strrchr(di.dli_fname, '/');
+        int rc = line_put_clean(l, base ? base + 1 : di.dli_fname);
+        snprintf(tmp, sizeof(tmp), "+0x%lx", (unsigned long)(at - (uintptr_t)di.dli_fbase));
+        return rc ? rc : line_put(l, tmp, strlen(tmp));
+    }
+    snprintf(tmp, sizeof(tmp), "0x%lx", (unsigned long)at);
+    return line_put(l, tmp, strlen(tmp));
+}
+
+static int prof_build_line(const struct prof_sample *sm, unsigned flags, struct prof_line *l)
+{
+    char tmp[48];
+    int rc;
+    if (!sm->in_co) rc = line_put(l, "[thread]", 8);
+    else rc = line_put_clean(l, sm->name[0] ? sm->name : "co");
+    if (rc == 0 && sm->in_co && (flags & KC_PROF_BY_ID)) {
+        snprintf(tmp, sizeof(tmp), "#%llu", (unsigned long long)sm->id);
+        rc = line_put(l, tmp, strlen(tmp));
+    }
+    for (int k = sm->n - 1; rc == 0 && k >= 0; k--) {
+        rc = line_put(l, ";", 1);
+        if (rc == 0) rc = line_put_frame(l, sm->pc[k], k > 0);
+    }
+    return rc;
+}
+
+static int prof_str_cmp(const void *a, const void *b)
+{
+    return strcmp(*(char *const*)a, *(char *const*)b);
+}
+
+static int prof_write_all(int fd, const char *p, size_t len)
+{
+    while (len) {
+        ssize_t w = write(fd, p, len);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return -errno;
+        }
+        p += w;
+        len -= (size_t)w;
+    }
+    return 0;
+}
+
+long kc_prof_write_collapsed(int fd, unsigned flags)
+{
+    if (atomic_load(&g_on)) return -EBUSY;
+    size_t n = atomic_load(&g_next);
+    if (n > g_cap) n = g_cap;
+    char **lines = n ? (char**)calloc(n, sizeof(*lines)) : NULL;
+    if (n && !lines) return -ENOMEM;
+    size_t m = 0;
+    int rc = 0;
+    for (size_t i = 0; i < n && rc == 0; i++) {
+        if (!atomic_load_explicit(&g_buf[i].done, memory_order_acquire)) continue;
+        struct prof_line l = { NULL, 0, 0 };
+        rc = prof_build_line(&g_buf[i], flags, &l);
+        if (rc == 0) lines[m++] = l.s;
+        else free(l.s);
+    }
+    qsort(lines, m, sizeof(*lines), prof_str_cmp);
+    long out = 0;
+    for (size_t i = 0; i < m && rc == 0;) {
+        size_t j = i + 1;
+        while (j < m && strcmp(lines[j], lines[i]) == 0) j++;
+        char cnt[32];
+        int cn = snprintf(cnt, sizeof(cnt), " %zu\n", j - i);
+        rc = prof_write_all(fd, lines[i], strlen(lines[i]));
+        if (rc == 0) rc = prof_write_all(fd, cnt, (size_t)cn);
+        out++;
+        i = j;
+    }
+    for (size_t i = 0; i < m; i++) free(lines[i]);
+    free(lines);
+    return rc ? rc : out;
+}
@@ -0,0 +1,11 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <stdint.h>
+
+/* Stack walk of the interrupted context, for signal handlers (kc_prof.c).
+ * Async-signal-safe. pc[0] is the interrupted pc; the frames after it are
+ * return addresses found on the running coroutine's own stack, as the
+ * profiler takes them. Returns the frames written (0 on a platform without
+ * a register map), at most max; *in_co is set when a coroutine ran. */
+int kc_prof_walk(const void *ucv, uintptr_t *pc, int max, int *in_co);
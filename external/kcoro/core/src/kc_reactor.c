@@ -0,0 +1,450 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* I/O reactor: park coroutines until a descriptor is readable or writable.
+ *
+ * - One process-wide poller thread (started on the first wait) blocks in
+ *   epoll_wait (Linux) or kevent (BSD/macOS). Descriptors are registered
+ *   one-shot, so a readiness edge is delivered once and re-armed only while
+ *   waiters remain.
+ * - Waiters live on the waiting coroutine's stack (on the heap for
+ *   shared-stack coroutines) and hang off a per-fd slot
+ *   (one list per direction) under g_rx.mu. The coroutine queues itself from
+ *   a kc_sched_park_release hook, i.e. after it has switched out, so the
+ *   poller can never requeue it before the park.
+ * - Whoever moves a waiter out of WAITING owns its coroutine hold: the poller
+ *   on readiness, the coroutine itself on timeout. The poller cancels the
+ *   timeout timer before it requeues; when the cancel loses, the timer already
+ *   woke the coroutine, which then reads READY.
+ * - Outside a worker coroutine the waits fall back to poll(2) on the calling
+ *   thread. */
+#define _GNU_SOURCE 1
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#if defined(__linux__)
+#include <sys/epoll.h>
+#define KC_REACTOR_EPOLL 1
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || \
+      defined(__OpenBSD__) || defined(__DragonFly__)
+#include <sys/types.h>
+#include <sys/event.h>
+#define KC_REACTOR_KQUEUE 1
+#endif
+
+#include "kcoro.h"
+#include "kcoro_sched.h"
+#include "kcoro_config.h"
+#include "kcoro_port.h"
+#include "kc_reactor_internal.h"
+#include "kc_clock_internal.h"
+#include "kcoro_share_internal.h"
+
+enum { IO_READ = 0, IO_WRITE = 1 };
+enum { IO_WAITING = 0, IO_READY, IO_TIMEDOUT, IO_FAILED };
+
+typedef struct kc_io_waiter {
+    struct kc_io_waiter *next;
+    kcoro_t *co;
+    kc_sched_t *sched;
+    kc_timer_handle_t timer;
+    uint64_t deadline_ns;  /* 0 = no timeout */
+    int fd, dir;
+    int state;             /* IO_*, under g_rx.mu */
+    int err;               /* IO_FAILED: negative errno */
+    int linked;
+} kc_io_waiter_t;
+
+typedef struct kc_io_slot {
+    kc_io_waiter_t *head[2]; /* IO_READ / IO_WRITE waiters */
+    int registered;          /* known to the backend (epoll ADD done) */
+    void (*watch_fn)(void *arg); /* kc_reactor_watch callback, if any */
+    void *watch_arg;
+    int watch_busy;          /* callback running: not armed for it meanwhile */
+} kc_io_slot_t;
+
+typedef struct kc_io_wake {
+    kcoro_t *co;
+    kc_sched_t *sched;
+    kc_timer_handle_t timer;
+} kc_io_wake_t;
+
+typedef struct kc_io_event { int fd, rd, wr; } kc_io_event_t;
+
+static struct {
+    pthread_mutex_t mu;
+    int pfd;                 /* epoll / kqueue descriptor, -1 until started */
+    int start_err;           /* sticky start failure */
+    kc_io_slot_t *slot;
+    int nslot;
+    unsigned long waits, wakeups, timeouts, polls;
+} g_rx = {
+    .mu = PTHREAD_MUTEX_INITIALIZER,
+    .pfd = -1,
+};
+
+static inline uint64_t io_now_ns(void)
+{
+    return kc_clock_ns();
+}
+
+/* ---- Backend ---- */
+
+#if KC_REACTOR_EPOLL
+static int backend_open(void) { return epoll_create1(EPOLL_CLOEXEC); }
+
+/* Arm fd one-shot for the directions that still have waiters. */
+static int backend_arm(kc_io_slot_t *sl, int fd, int rd, int wr)
+{
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLONESHOT | EPOLLRDHUP | (rd ? EPOLLIN : 0u) | (wr ? EPOLLOUT : 0u);
+    ev.data.fd = fd;
+    int op = sl->registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+    if (epoll_ctl(g_rx.pfd, op, fd, &ev) == 0) { sl->registered = 1; return 0; }
+    /* A stale registration (fd closed and reused) or one we did not track. */
+    if (errno == ENOENT || errno == EEXIST) {
+        op = (errno == ENOENT) ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
+        if (epoll_ctl(g_rx.pfd, op, fd, &ev) == 0) { sl->registered = 1; return 0; }
+    }
+    return -errno;
+}
+
+static int backend_wait(kc_io_event_t *out, int max)
+{
+    struct epoll_event ev[KCORO_REACTOR_EVENTS];
+    if (max > KCORO_REACTOR_EVENTS) max = KCORO_REACTOR_EVENTS;
+    int n = epoll_wait(g_rx.pfd, ev, max, -1);
+    for (int i = 0; i < n; i++) {
+        uint32_t e = ev[i].events;
+        out[i].fd = ev[i].data.fd;
+        out[i].rd = (e & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) != 0;
+        out[i].wr = (e & (EPOLLOUT | EPOLLHUP | EPOLLERR)) != 0;
+    }
+    return n;
+}
+#elif KC_REACTOR_KQUEUE
+static int backend_open(void)
+{
+    int kq = kqueue();
+    if (kq >= 0) (void)fcntl(kq, F_SETFD, FD_CLOEXEC);
+    return kq;
+}
+
+static int backend_arm(kc_io_slot_t *sl, int fd, int rd, int wr)
+{
+    struct kevent ch[2];
+    int n = 0;
+    if (rd) { EV_SET(&ch[n], (uintptr_t)fd, EVFILT_READ, EV_ADD | EV_ONESHOT, 0, 0, NULL); n++; }
+    if (wr) { EV_SET(&ch[n], (uintptr_t)fd, EVFILT_WRITE, EV_ADD | EV_ONESHOT, 0, 0, NULL); n++; }
+    if (n && kevent(g_rx.pfd, ch, n, NULL, 0, NULL) < 0) return -errno;
+    sl->registered = 1;
+    return 0;
+}
+
+static int backend_wait(kc_io_event_t *out, int max)
+{
+    struct kevent ev[KCORO_REACTOR_EVENTS];
+    if (max > KCORO_REACTOR_EVENTS) max = KCORO_REACTOR_EVENTS;
+    int n = kevent(g_rx.pfd, NULL, 0, ev, max, NULL);
+    for (int i = 0; i < n; i++) {
+        out[i].fd = (int)ev[i].ident;
+        out[i].rd = ev[i].filter == EVFILT_READ;
+        out[i].wr = ev[i].filter == EVFILT_WRITE;
+        if (ev[i].flags & EV_ERROR) out[i].rd = out[i].wr = 1;
+    }
+    return n;
+}
+#else
+static int backend_open(void) { errno = ENOSYS; return -1; }
+static int backend_arm(kc_io_slot_t *sl, int fd, int rd, int wr)
+{ (void)sl; (void)fd; (void)rd; (void)wr; return -ENOSYS; }
+static int backend_wait(kc_io_event_t *out, int max) { (void)out; (void)max; errno = ENOSYS; return -1; }
+#endif
+
+/* ---- Poller ---- */
+
+static void slot_rearm_locked(int fd)
+{
+    kc_io_slot_t *sl = &g_rx.slot[fd];
+    int rd = sl->head[IO_READ] != NULL || (sl->watch_fn && !sl->watch_busy);
+    if (rd || sl->head[IO_WRITE])
+        (void)backend_arm(sl, fd, rd, sl->head[IO_WRITE] != NULL);
+}
+
+static void waiter_unlink_locked(kc_io_waiter_t *w)
+{
+    kc_io_waiter_t **pp = &g_rx.slot[w->fd].head[w->dir];
+    while (*pp && *pp != w) pp = &(*pp)->next;
+    if (*pp) *pp = w->next;
+    w->next = NULL;
+    w->linked = 0;
+}
+
+static void io_wake(kc_io_wake_t *k)
+{
+    /* A lost cancel means the timeout already woke the coroutine. */
+    if (k->timer.id == 0 || kc_sched_timer_cancel(k->sched, k->timer))
+        kc_sched_enqueue_ready(k->sched, k->co);
+    kcoro_release(k->co);
+}
+
+static void* poller_main(void *arg)
+{
+    (void)arg;
+    kc_io_event_t ev[KCORO_REACTOR_EVENTS];
+    struct { int fd; void (*fn)(void *arg); void *arg; } watched[KCORO_REACTOR_EVENTS];
+    kc_io_wake_t *wake = NULL;
+    size_t wake_cap = 0;
+    for (;;) {
+        int n = backend_wait(ev, KCORO_REACTOR_EVENTS);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        size_t nw = 0;
+        int nwatch = 0;
+        pthread_mutex_lock(&g_rx.mu);
+        for (int i = 0; i < n; i++) {
+            int fd = ev[i].fd;
+            if (fd < 0 || fd >= g_rx.nslot) continue;
+            kc_io_slot_t *sl = &g_rx.slot[fd];
+            if (ev[i].rd && sl->watch_fn && !sl->watch_busy) {
+                sl->watch_busy = 1;
+                watched[nwatch].fd = fd;
+                watched[nwatch].fn = sl->watch_fn;
+                watched[nwatch].arg = sl->watch_arg;
+                nwatch++;
+            }
+            for (int dir = IO_READ; dir <= IO_WRITE; dir++) {
+                if (!(dir == IO_READ ? ev[i].rd : ev[i].wr)) continue;
+                while (sl->head[dir]) {
+                    kc_io_waiter_t *w = sl->head[dir];
+                    if (nw == wake_cap) {
+                        size_t cap = wake_cap ? wake_cap * 2 : 64;
+                        kc_io_wake_t *nb = (kc_io_wake_t*)realloc(wake, cap * sizeof(*nb));
+                        if (!nb) break; /* stays queued; the re-arm below retries it */
+                        wake = nb; wake_cap = cap;
+                    }
+                    sl->head[dir] = w->next;
+                    w->next = NULL;
+                    w->linked = 0;
+                    w->state = IO_READY;
+                    wake[nw].co = w->co;
+                    wake[nw].sched = w->sched;
+                    wake[nw].timer = w->timer;
+                    nw++;
+                }
+            }
+            slot_rearm_locked(fd);
+        }
+        g_rx.wakeups += nw;
+        pthread_mutex_unlock(&g_rx.mu);
+        for (size_t i = 0; i < nw; i++) io_wake(&wake[i]);
+        if (nwatch == 0) continue;
+        /* Watches are permanent: run each callback, then arm it again. */
+        for (int i = 0; i < nwatch; i++) watched[i].fn(watched[i].arg);
+        pthread_mutex_lock(&g_rx.mu);
+        for (int i = 0; i < nwatch; i++) {
+            g_rx.slot[watched[i].fd].watch_busy = 0;
+            slot_rearm_locked(watched[i].fd);
+        }
+        pthread_mutex_unlock(&g_rx.mu);
+    }
+    free(wake);
+    return NULL;
+}
+
+static int reactor_start_locked(void)
+{
+    if (g_rx.pfd >= 0) return 0;
+    if (g_rx.start_err) return g_rx.start_err;
+    int pfd = backend_open();
+    if (pfd < 0) return g_rx.start_err = -errno;
+    g_rx.pfd = pfd;
+    pthread_attr_t attr;
+    pthread_t thr;
+    int rc = pthread_attr_init(&attr);
+    if (rc == 0) {
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        rc = pthread_create(&thr, &attr, poller_main, NULL);
+        pthread_attr_destroy(&attr);
+    }
+    if (rc != 0) {
+        close(pfd);
+        g_rx.pfd = -1;
+        return -rc; /* not sticky: thread creation may succeed later */
+    }
+    return 0;
+}
+
+static int slot_reserve_locked(int fd)
+{
+    if (fd < g_rx.nslot) return 0;
+    int n = g_rx.nslot ? g_rx.nslot : 64;
+    while (n <= fd) n *= 2;
+    kc_io_slot_t *ns = (kc_io_slot_t*)realloc(g_rx.slot, (size_t)n * sizeof(*ns));
+    if (!ns) return -ENOMEM;
+    memset(ns + g_rx.nslot, 0, (size_t)(n - g_rx.nslot) * sizeof(*ns));
+    g_rx.slot = ns;
+    g_rx.nslot = n;
+    return 0;
+}
+
+/* ---- Waits ---- */
+
+static int io_poll(int fd, int dir, long timeout_ms)
+{
+    struct pollfd p = { .fd = fd, .events = (short)(dir == IO_READ ? POLLIN : POLLOUT), .revents = 0 };
+    uint64_t deadline = timeout_ms > 0 ? io_now_ns() + (uint64_t)timeout_ms * 1000000ull : 0;
+    pthread_mutex_lock(&g_rx.mu);
+    g_rx.polls++;
+    pthread_mutex_unlock(&g_rx.mu);
+    for (;;) {
+        int ms = -1;
+        if (timeout_ms == 0) ms = 0;
+        else if (deadline) {
+            uint64_t now = io_now_ns();
+            ms = now >= deadline ? 0 : (int)((deadline - now + 999999ull) / 1000000ull);
+        }
+        int n = poll(&p, 1, ms);
+        if (n > 0) return (p.revents & POLLNVAL) ? -EBADF : 0;
+        if (n == 0) return KC_ETIME;
+        if (errno != EINTR) return -errno;
+    }
+}
+
+/* Runs on the worker after the waiter switched out; entered with g_rx.mu
+ * held. The first park queues the waiter and arms the fd; every park
+ * (re)arms the timeout. */
+static void io_park_release(void *arg)
+{
+    kc_io_waiter_t *w = (kc_io_waiter_t*)arg;
+    if (!w->linked) {
+        kc_io_slot_t *sl = &g_rx.slot[w->fd];
+        w->next = sl->head[w->dir];
+        sl->head[w->dir] = w;
+        w->linked = 1;
+        int rc = backend_arm(sl, w->fd, sl->head[IO_READ] != NULL, sl->head[IO_WRITE] != NULL);
+        if (rc != 0) {
+            kc_io_wake_t k = { .co = w->co, .sched = w->sched, .timer = {0} };
+            waiter_unlink_locked(w);
+            /* epoll refuses regular files: they are always ready. */
+            w->state = rc == -EPERM ? IO_READY : IO_FAILED;
+            w->err = rc;
+            pthread_mutex_unlock(&g_rx.mu);
+            io_wake(&k);
+            return;
+        }
+    }
+    if (w->deadline_ns) {
+        (void)kc_sched_timer_cancel(w->sched, w->timer);
+        w->timer = kc_sched_timer_wake_at(w->sched, w->co, (unsigned long long)w->deadline_ns);
+    }
+    pthread_mutex_unlock(&g_rx.mu);
+}
+
+static void io_park_unlock(void *arg)
+{
+    (void)arg;
+    pthread_mutex_unlock(&g_rx.mu);
+}
+
+static int io_await(int fd, int dir, long timeout_ms)
+{
+    if (fd < 0) return -EBADF;
+    kcoro_t *co = kcoro_current();
+    kc_sched_t *s = kc_sched_current();
+    if (timeout_ms == 0 || !co || !s) return io_poll(fd, dir, timeout_ms);
+
+    /* The poller reads the waiter while its coroutine is switched out. */
+    kc_io_waiter_t local = { 0 };
+    kc_io_waiter_t *w = kcoro_park_record(co, &local, sizeof(local));
+    if (!w) return -ENOMEM;
+    w->co = co;
+    w->sched = s;
+    w->fd = fd;
+    w->dir = dir;
+    w->state = IO_WAITING;
+    if (timeout_ms > 0) w->deadline_ns = io_now_ns() + (uint64_t)timeout_ms * 1000000ull;
+
+    pthread_mutex_lock(&g_rx.mu);
+    int rc = reactor_start_locked();
+    if (rc == 0) rc = slot_reserve_locked(fd);
+    if (rc != 0) {
+        pthread_mutex_unlock(&g_rx.mu);
+        kcoro_park_record_free(w, &local);
+        return rc == -ENOSYS ? io_poll(fd, dir, timeout_ms) : rc;
+    }
+    g_rx.waits++;
+    kcoro_retain(co); /* the waiter's hold; see the header comment */
+    if (kc_sched_park_release(io_park_release, w) != 0) {
+        pthread_mutex_unlock(&g_rx.mu);
+        kcoro_release(co);
+        kcoro_park_record_free(w, &local);
+        return io_poll(fd, dir, timeout_ms);
+    }
+    pthread_mutex_lock(&g_rx.mu);
+    /* A stray wake (or a timer tick ahead of the deadline) parks again. */
+    while (w->state == IO_WAITING && (!w->deadline_ns || io_now_ns() < w->deadline_ns)) {
+        if (kc_sched_park_release(w->deadline_ns ? io_park_release : io_park_unlock, w) != 0) break;
+        pthread_mutex_lock(&g_rx.mu);
+    }
+    if (w->state == IO_WAITING) {
+        waiter_unlink_locked(w);
+        slot_rearm_locked(fd);
+        w->state = IO_TIMEDOUT;
+        g_rx.timeouts++;
+        pthread_mutex_unlock(&g_rx.mu);
+        (void)kc_sched_timer_cancel(s, w->timer);
+        kcoro_release(co);
+        rc = KC_ETIME;
+    } else {
+        pthread_mutex_unlock(&g_rx.mu);
+        rc = w->state == IO_READY ? 0 : w->err;
+    }
+    kcoro_park_record_free(w, &local);
+    return rc;
+}
+
+int kc_reactor_watch(int fd, void (*fn)(void *arg), void *arg)
+{
+    if (fd < 0 || !fn) return -EINVAL;
+    pthread_mutex_lock(&g_rx.mu);
+    int rc = reactor_start_locked();
+    if (rc == 0) rc = slot_reserve_locked(fd);
+    if (rc == 0 && g_rx.slot[fd].watch_fn) rc = -EBUSY;
+    if (rc == 0) {
+        kc_io_slot_t *sl = &g_rx.slot[fd];
+        sl->watch_fn = fn;
+        sl->watch_arg = arg;
+        rc = backend_arm(sl, fd, 1, sl->head[IO_WRITE] != NULL);
+        if (rc != 0) sl->watch_fn = NULL;
+    }
+    pthread_mutex_unlock(&g_rx.mu);
+    return rc;
+}
+
+int kc_await_readable(int fd, long timeout_ms)
+{
+    return io_await(fd, IO_READ, timeout_ms);
+}
+
+int kc_await_writable(int fd, long timeout_ms)
+{
+    return io_await(fd, IO_WRITE, timeout_ms);
+}
+
+void kc_reactor_get_stats(kc_reactor_stats_t *out)
+{
+    if (!out) return;
+    pthread_mutex_lock(&g_rx.mu);
+    out->waits = g_rx.waits;
+    out->wakeups = g_rx.wakeups;
+    out->timeouts = g_rx.timeouts;
+    out->polls = g_rx.polls;
+    pthread_mutex_unlock(&g_rx.mu);
+}
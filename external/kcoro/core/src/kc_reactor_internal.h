@@ -0,0 +1,11 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+/* Internal hooks into the I/O reactor (kc_reactor.c); the coroutine waits
+ * (kc_await_readable/writable) are declared in kcoro_sched.h. */
+
+/* Call fn(arg) on the poller thread each time fd turns readable, for the life
+ * of the process (fd must stay open). The watch is re-armed after fn returns,
+ * so fn should drain whatever made fd readable. 0, -EBUSY when fd already has
+ * a watch, or a negative errno from the backend. */
+int kc_reactor_watch(int fd, void (*fn)(void *arg), void *arg);
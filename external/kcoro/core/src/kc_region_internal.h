@@ -0,0 +1,36 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/uio.h>
+
+#include "../../include/kcoro.h"
+
+/* Region registry internals (kc_zcopy.c), for users that mirror the table
+ * into a kernel registration (io_uring fixed buffers in kc_uring.c). */
+
+/* Bumped by every register/deregister; 0 until the first region. */
+uint64_t kc_region_generation(void);
+
+/* Copy the live regions into iov[] (slot_of[i] = registry slot), at most
+ * max; *gen gets the generation the copy reflects. Returns the count. */
+int kc_region_snapshot(struct iovec *iov, int *slot_of, int max, uint64_t *gen);
+
+/* Register a read-only file mapping of len bytes at addr, which the region
+ * then owns with fd: teardown unmaps it and closes fd. Such regions stay
+ * out of kc_region_snapshot, since a fixed-buffer table would pin the
+ * whole file (kc_mstream.c drops pages behind its readers). 0, -EINVAL,
+ * -EEXIST or -ENOSPC; on failure both stay the caller's. */
+int kc_region_adopt_file(kc_region_t **out, void *addr, size_t len, int fd);
+
+/* The live region holding [addr, addr+len), with an in-flight reference that
+ * keeps kc_region_deregister waiting; *slot gets its registry slot. NULL when
+ * no region holds the range. */
+kc_region_t* kc_region_acquire(const void *addr, size_t len, int *slot);
+void kc_region_release(kc_region_t *reg);
+
+/* Apply the KC_REGION_F_HUGEPAGE / KC_REGION_F_NUMA hints in flags to the
+ * whole pages of [addr, addr+len); move migrates pages already resident.
+ * Returns the hints that took effect. Shared with the stack pool. */
+unsigned kc_mem_hint(void *addr, size_t len, unsigned flags, int move);
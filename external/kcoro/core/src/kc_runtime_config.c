@@ -5,19 +5,75 @@
 #include <string.h>
 #include <errno.h>
 #include <ctype.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <sys/stat.h>
 
+#include "../../include/kcoro_config.h"
 #include "../../include/kcoro_config_runtime.h"
+#include "../../include/kcoro_core.h"
+
+/* g_cfg is written only with g_cfg_mu held, which also guards the watch list
+ * and runs the watchers; g_cfg_loaded publishes the first load. */
+struct kc_cfg_watch {
+    kc_runtime_config_watch_fn fn;
+    void *arg;
+    struct kc_cfg_watch *next;
+};
 
 static struct kc_runtime_config g_cfg;
-static int g_cfg_loaded = 0;
-static int g_cfg_loading = 0; /* guard recursive */
+static _Atomic(int) g_cfg_loaded = 0;
+static pthread_mutex_t g_cfg_mu = PTHREAD_MUTEX_INITIALIZER;
+static struct kc_cfg_watch *g_cfg_watch;
+static int g_cfg_stack_applied;          /* the last load set stack limits */
+static __thread int g_cfg_in_load;       /* guard recursive (from a watcher) */
 
 static void kc_cfg_set_defaults(struct kc_runtime_config *c) {
+    c->chan_metrics_sample_ms = 10;
     c->chan_metrics_emit_min_ops = 1024UL;
     c->chan_metrics_emit_min_ms = 50; /* ms */
     c->chan_metrics_auto_enable = 0;
     c->chan_metrics_pipe_capacity = 64;
+    c->chan_stats_level = 2; /* KC_CHAN_STATS_FULL */
+    c->sched_min_workers = 0;
+    c->sched_max_workers = 0;
+    c->sched_scale_up_backlog = 0;
+    c->sched_scale_up_ms = 0;
+    c->sched_scale_down_ms = 0;
+    c->sched_park_spin = 0;
+    c->sched_steal_scan = 0;
+    c->sched_bulk_share = 0;
+    c->sched_slice_us = 0;
+    c->chan_flow_batch = 0;
+    c->chan_flow_capacity = 0;
+    c->stack_cache_per_thread = -1;
+    c->stack_depot_max = -1;
+    c->stack_default_size = -1;
+    c->stack_autotune = -1;
+    c->generation = 0;
+}
+
+/* "scheduler" keys map to int fields; values must be >= 0. */
+static int* kc_cfg_sched_field(struct kc_runtime_config *c, const char *key) {
+    if (strcmp(key, "min_workers") == 0) return &c->sched_min_workers;
+    if (strcmp(key, "max_workers") == 0) return &c->sched_max_workers;
+    if (strcmp(key, "scale_up_backlog") == 0) return &c->sched_scale_up_backlog;
+    if (strcmp(key, "scale_up_ms") == 0) return &c->sched_scale_up_ms;
+    if (strcmp(key, "scale_down_ms") == 0) return &c->sched_scale_down_ms;
+    if (strcmp(key, "park_spin") == 0) return &c->sched_park_spin;
+    if (strcmp(key, "steal_scan") == 0) return &c->sched_steal_scan;
+    if (strcmp(key, "bulk_share") == 0) return &c->sched_bulk_share;
+    if (strcmp(key, "slice_us") == 0) return &c->sched_slice_us;
+    return NULL;
+}
+
+/* "stack" keys map to long fields; values must be >= 0. */
+static long* kc_cfg_stack_field(struct kc_runtime_config *c, const char *key) {
+    if (strcmp(key, "cache_per_thread") == 0) return &c->stack_cache_per_thread;
+    if (strcmp(key, "depot_max") == 0) return &c->stack_depot_max;
+    if (strcmp(key, "default_size") == 0) return &c->stack_default_size;
+    if (strcmp(key, "autotune") == 0) return &c->stack_autotune;
+    return NULL;
 }
 
 #define KC_CFG_MAX_FILE_SIZE (1 << 20) /* 1MB */
@@ -148,7 +204,9 @@ static void kc_cfg_parse(struct kc_runtime_config *c, const char *json) {
                         if (*p != ':') break;
                         ++p;
                         p = skip_ws(p);
-                        if (strcmp(k3, "emit_min_ops") == 0) {
+                        if (strcmp(k3, "sample_ms") == 0) {
+                            long v; if (!parse_number(&p, NULL, &v)) break; if (v >= 1) c->chan_metrics_sample_ms = v;
+                        } else if (strcmp(k3, "emit_min_ops") == 0) {
                             unsigned long v; if (!parse_number(&p, &v, NULL)) break; if (v >= 1) c->chan_metrics_emit_min_ops = v;
                         } else if (strcmp(k3, "emit_min_ms") == 0) {
                             long v; if (!parse_number(&p, NULL, &v)) break; if (v >= 0) c->chan_metrics_emit_min_ms = v;
@@ -168,6 +226,16 @@ static void kc_cfg_parse(struct kc_runtime_config *c, const char *json) {
                         if (*p == ',') { ++p; continue; }
                         if (*p == '}') { ++p; break; }
                     }
+                } else if (strcmp(k2, "stats_level") == 0) {
+                    char v[16];
+                    if (!parse_string_key(&p, v, sizeof(v))) break;
+                    if (strcmp(v, "off") == 0) c->chan_stats_level = 0;
+                    else if (strcmp(v, "counters") == 0) c->chan_stats_level = 1;
+                    else if (strcmp(v, "full") == 0) c->chan_stats_level = 2;
+                } else if (strcmp(k2, "flow_batch") == 0) {
+                    long v; if (!parse_number(&p, NULL, &v)) break; if (v >= 0 && v <= 1000000L) c->chan_flow_batch = (int)v;
+                } else if (strcmp(k2, "flow_capacity") == 0) {
+                    long v; if (!parse_number(&p, NULL, &v)) break; if (v >= 0 && v <= 1000000L) c->chan_flow_capacity = (int)v;
                 } else {
                     /* skip unknown object */
                     if (*p == '{') {
@@ -181,6 +249,60 @@ static void kc_cfg_parse(struct kc_runtime_config *c, const char *json) {
                 if (*p == ',') { ++p; continue; }
                 if (*p == '}') { ++p; break; }
             }
+        } else if (strcmp(key, "scheduler") == 0) {
+            if (*p != '{') break;
+            ++p;
+            for (;;) {
+                p = skip_ws(p);
+                if (*p == '}') { ++p; break; }
+                char k2[64];
+                if (!parse_string_key(&p, k2, sizeof(k2))) break;
+                p = skip_ws(p);
+                if (*p != ':') break;
+                ++p;
+                p = skip_ws(p);
+                int *field = kc_cfg_sched_field(c, k2);
+                if (field) {
+                    long v; if (!parse_number(&p, NULL, &v)) break; if (v >= 0 && v <= 1000000000L) *field = (int)v;
+                } else {
+                    /* skip unknown scalar */
+                    if (*p == '"') {
+                        char tmp[64]; if (!parse_string_key(&p, tmp, sizeof(tmp))) break;
+                    } else {
+                        unsigned long vx; long lx; if (!parse_number(&p, &vx, &lx)) { int b; if (!parse_bool(&p, &b)) break; }
+                    }
+                }
+                p = skip_ws(p);
+                if (*p == ',') { ++p; continue; }
+                if (*p == '}') { ++p; break; }
+            }
+        } else if (strcmp(key, "stack") == 0) {
+            if (*p != '{') break;
+            ++p;
+            for (;;) {
+                p = skip_ws(p);
+                if (*p == '}') { ++p; break; }
+                char k2[64];
+                if (!parse_string_key(&p, k2, sizeof(k2))) break;
+                p = skip_ws(p);
+                if (*p != ':') break;
+                ++p;
+                p = skip_ws(p);
+                long *field = kc_cfg_stack_field(c, k2);
+                if (field) {
+                    long v; if (!parse_number(&p, NULL, &v)) break; if (v >= 0 && v <= (1L << 30)) *field = v;
+                } else {
+                    /* skip unknown scalar */
+                    if (*p == '"') {
+                        char tmp[64]; if (!parse_string_key(&p, tmp, sizeof(tmp))) break;
+                    } else {
+                        unsigned long vx; long lx; if (!parse_number(&p, &vx, &lx)) { int b; if (!parse_bool(&p, &b)) break; }
+                    }
+                }
+                p = skip_ws(p);
+                if (*p == ',') { ++p; continue; }
+                if (*p == '}') { ++p; break; }
+            }
         } else {
             /* skip unknown top-level value */
             if (*p == '{') {
@@ -196,7 +318,24 @@ static void kc_cfg_parse(struct kc_runtime_config *c, const char *json) {
     }
 }
 
-static int kc_runtime_config_load(const char *path) {
+/* Stack limits from the file; a load that drops them puts the build
+ * defaults back, a file that never had them leaves the pool alone. */
+static void kc_cfg_apply_stack(const struct kc_runtime_config *c) {
+    int set = c->stack_cache_per_thread >= 0 || c->stack_depot_max >= 0 || c->stack_default_size >= 0 ||
+              c->stack_autotune >= 0;
+    if (set || g_cfg_stack_applied) {
+        kcoro_stack_pool_set_limits(
+            (unsigned)(c->stack_cache_per_thread >= 0 ? c->stack_cache_per_thread : KCORO_STACK_CACHE_PER_THREAD),
+            (unsigned)(c->stack_depot_max >= 0 ? c->stack_depot_max : KCORO_STACK_DEPOT_MAX));
+        kcoro_stack_set_default_size(c->stack_default_size > 0 ? (size_t)c->stack_default_size : 0);
+        kcoro_stack_autotune(c->stack_autotune > 0);
+    }
+    g_cfg_stack_applied = set;
+}
+
+/* Parse outside the lock, then publish and notify under it. force: replace
+ * a config that is already loaded (reload). */
+static int kc_runtime_config_load(const char *path, int force) {
     struct kc_runtime_config tmp; kc_cfg_set_defaults(&tmp);
     const char *use_path = path;
     if (!use_path || !*use_path) {
@@ -204,26 +343,74 @@ static int kc_runtime_config_load(const char *path) {
         if (!use_path || !*use_path) use_path = "kcoro_config.json";
     }
     size_t len=0; char *buf = kc_read_file(use_path, &len);
-    if (!buf) { /* keep defaults if missing */ g_cfg = tmp; g_cfg_loaded = 1; return 0; }
-    kc_cfg_parse(&tmp, buf);
-    free(buf);
-    g_cfg = tmp; g_cfg_loaded = 1; return 0;
+    if (buf) { /* keep defaults if missing */
+        kc_cfg_parse(&tmp, buf);
+        free(buf);
+    }
+    pthread_mutex_lock(&g_cfg_mu);
+    if (!force && atomic_load_explicit(&g_cfg_loaded, memory_order_relaxed)) {
+        pthread_mutex_unlock(&g_cfg_mu);
+        return 0;
+    }
+    tmp.generation = g_cfg.generation + 1;
+    g_cfg = tmp;
+    atomic_store_explicit(&g_cfg_loaded, 1, memory_order_release);
+    kc_cfg_apply_stack(&g_cfg);
+    g_cfg_in_load = 1;
+    for (struct kc_cfg_watch *w = g_cfg_watch; w; w = w->next) w->fn(w->arg, &g_cfg);
+    g_cfg_in_load = 0;
+    pthread_mutex_unlock(&g_cfg_mu);
+    return 0;
 }
 
 int kc_runtime_config_init(const char *path) {
-    if (g_cfg_loaded) return 0;
-    if (g_cfg_loading) return -EALREADY;
-    g_cfg_loading = 1;
-    int rc = kc_runtime_config_load(path);
-    g_cfg_loading = 0;
-    return rc;
+    if (atomic_load_explicit(&g_cfg_loaded, memory_order_acquire)) return 0;
+    if (g_cfg_in_load) return -EALREADY;
+    return kc_runtime_config_load(path, 0);
 }
 
 int kc_runtime_config_reload(const char *path) {
-    g_cfg_loaded = 0; return kc_runtime_config_init(path);
+    if (g_cfg_in_load) return -EALREADY;
+    return kc_runtime_config_load(path, 1);
 }
 
 const struct kc_runtime_config* kc_runtime_config_get(void) {
-    if (!g_cfg_loaded) kc_runtime_config_init(NULL);
+    if (!atomic_load_explicit(&g_cfg_loaded, memory_order_acquire)) kc_runtime_config_init(NULL);
     return &g_cfg;
 }
+
+void kc_runtime_config_snapshot(struct kc_runtime_config *out) {
+    if (!out) return;
+    if (!atomic_load_explicit(&g_cfg_loaded, memory_order_acquire)) kc_runtime_config_init(NULL);
+    if (g_cfg_in_load) { *out = g_cfg; return; }
+    pthread_mutex_lock(&g_cfg_mu);
+    *out = g_cfg;
+    pthread_mutex_unlock(&g_cfg_mu);
+}
+
+int kc_runtime_config_watch(kc_runtime_config_watch_fn fn, void *arg) {
+    if (!fn) return -EINVAL;
+    struct kc_cfg_watch *w = malloc(sizeof(*w));
+    if (!w) return -ENOMEM;
+    w->fn = fn;
+    w->arg = arg;
+    pthread_mutex_lock(&g_cfg_mu);
+    w->next = g_cfg_watch;
+    g_cfg_watch = w;
+    pthread_mutex_unlock(&g_cfg_mu);
+    return 0;
+}
+
+int kc_runtime_config_unwatch(kc_runtime_config_watch_fn fn, void *arg) {
+    pthread_mutex_lock(&g_cfg_mu);
+    for (struct kc_cfg_watch **pp = &g_cfg_watch; *pp; pp = &(*pp)->next) {
+        struct kc_cfg_watch *w = *pp;
+        if (w->fn != fn || w->arg != arg) continue;
+        *pp = w->next;
+        pthread_mutex_unlock(&g_cfg_mu);
+        free(w);
+        return 0;
+    }
+    pthread_mutex_unlock(&g_cfg_mu);
+    return -ENOENT;
+}
@@ -9,30 +9,31 @@
 #include <string.h>
 #include <unistd.h>
 #ifdef __linux__
-#include <sys/sysinfo.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
 #endif
 #include <stdatomic.h>
 #include <errno.h>
 #include <time.h>
 #include <sched.h>
 #include <stdbool.h>
+#include <dirent.h>
+#include <dlfcn.h>
+#include <signal.h>
 
 #include "kcoro_sched.h"
-
-#ifndef __linux__
-static int kc_get_nprocs(void)
-{
-    long n = sysconf(_SC_NPROCESSORS_ONLN);
-    if (n < 1) n = sysconf(_SC_NPROCESSORS_CONF);
-    if (n < 1) n = 1;
-    if (n > INT_MAX) n = INT_MAX;
-    return (int)n;
-}
-#else
-#define kc_get_nprocs get_nprocs
-#endif
+#include "kcoro_port.h"
+#include "kcoro_config_runtime.h"
 
 #include "kcoro_core.h"
+#include "kc_timer_internal.h"
+#include "kc_uring_internal.h"
+#include "kcoro_stack_internal.h"
+#include "kcoro_share_internal.h"
+#include "kc_hist_internal.h"
+#include "kc_parallel_internal.h"
+#include "kc_trace_internal.h"
+#include "kc_prof_internal.h"
 
 static int kc_sched_debug_enabled(void)
 {
@@ -54,401 +55,2352 @@ static int kc_sched_debug_enabled(void)
 /* Debug logging: production code uses runtime logging (KCORO_DEBUG env) if needed.
  * No compile-time debug split macros. */
 
-/* ---- Timers (ported from C++ scheduler concept) ---- */
-
-typedef struct kc_timer_item {
-    uint64_t id;                /* timer id */
-    uint64_t when_ns;           /* absolute deadline (CLOCK_MONOTONIC) */
-    kcoro_t* co;                /* coroutine to wake */
-    int cancelled;              /* best-effort cancellation flag */
-    struct kc_timer_item* next; /* singly-linked list, sorted by when_ns */
-} kc_timer_item_t;
+/* ---- Timers ----
+ * Each worker owns a hierarchical timing wheel (kc_timer.c). Timers armed on
+ * a worker fire on that worker, so the woken coroutine lands in its runnext
+ * slot; timers armed from other threads go to a round-robin worker's wheel. */
 
 static inline uint64_t kc_now_ns(void)
 {
-    struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
-    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+    return kc_clock_ns();
 }
 
-static void kc_timer_ensure_started(struct kc_sched *s);
-static void* kc_timer_main(void *arg);
-
 /* ---- Internal Types ---- */
 
 typedef void (*sched_task_fn)(void *arg); /* internal task fn */
 
 typedef struct sched_task { sched_task_fn fn; void *arg; } sched_task_t;
 
+/* Chase-Lev work-stealing deque (Le, Pop, Cohen, Zappa Nardelli, PPoPP'13).
+ * The owning worker pushes/pops at `bottom` without any atomic RMW except
+ * when racing a thief for the last element; thieves CAS `top`. Growth swaps
+ * in a doubled circular array; retired arrays stay alive until destroy
+ * because a thief may still be reading a slot from the old one. */
+typedef struct kc_deque_slot {
+    _Atomic(sched_task_fn) fn;
+    _Atomic(void*) arg;
+} kc_deque_slot_t;
+
+typedef struct kc_deque_array {
+    int64_t cap; /* power of two */
+    struct kc_deque_array *retired; /* previous (smaller) array */
+    kc_deque_slot_t slot[];
+} kc_deque_array_t;
+
 typedef struct kc_deque {
-    pthread_mutex_t mu;
-    sched_task_t *buf;
-    uint32_t cap;
-    uint32_t head; /* steal from head */
-    uint32_t tail; /* owner push/pop tail */
-    _Atomic(uint32_t) len; /* approximate length */
+    _Alignas(64) _Atomic(int64_t) top;    /* thieves steal here (CAS) */
+    _Alignas(64) _Atomic(int64_t) bottom; /* owner push/pop here */
+    _Atomic(kc_deque_array_t*) arr;
 } kc_deque_t;
 
+enum { KC_DEQUE_EMPTY = 0, KC_DEQUE_OK = 1, KC_DEQUE_ABORT = -1 };
+
+static kc_deque_array_t* deque_array_new(int64_t cap)
+{
+    kc_deque_array_t *a = (kc_deque_array_t*)calloc(1, sizeof(*a) + (size_t)cap * sizeof(kc_deque_slot_t));
+    if (a) a->cap = cap;
+    return a;
+}
+
 static int deque_init(kc_deque_t *d, uint32_t cap) {
     memset(d, 0, sizeof(*d));
     if (cap==0) cap = 1024;
-    d->buf = (sched_task_t*)calloc(cap, sizeof(sched_task_t));
-    if (!d->buf) return -1;
-    d->cap = cap; atomic_store(&d->len, 0); pthread_mutex_init(&d->mu, NULL); return 0;
+    int64_t c = 1; while (c < (int64_t)cap) c <<= 1;
+    kc_deque_array_t *a = deque_array_new(c);
+    if (!a) return -1;
+    atomic_store(&d->top, 0); atomic_store(&d->bottom, 0); atomic_store(&d->arr, a);
+    return 0;
 }
-static void deque_destroy(kc_deque_t *d){ if(!d) return; free(d->buf); pthread_mutex_destroy(&d->mu);} 
+static void deque_destroy(kc_deque_t *d){
+    if(!d) return;
+    kc_deque_array_t *a = atomic_load(&d->arr);
+    while (a) { kc_deque_array_t *r = a->retired; free(a); a = r; }
+    atomic_store(&d->arr, NULL);
+}
+/* Approximate length; used for donation and idle heuristics only. */
+static inline uint32_t deque_len(kc_deque_t *d){
+    int64_t b = atomic_load_explicit(&d->bottom, memory_order_relaxed);
+    int64_t t = atomic_load_explicit(&d->top, memory_order_relaxed);
+    return b > t ? (uint32_t)(b - t) : 0;
+}
+static kc_deque_array_t* deque_grow(kc_deque_t *d, kc_deque_array_t *a, int64_t b, int64_t t){
+    kc_deque_array_t *na = deque_array_new(a->cap * 2);
+    if (!na) return NULL;
+    for (int64_t i = t; i < b; i++) {
+        kc_deque_slot_t *src = &a->slot[i & (a->cap - 1)], *dst = &na->slot[i & (na->cap - 1)];
+        atomic_store_explicit(&dst->fn, atomic_load_explicit(&src->fn, memory_order_relaxed), memory_order_relaxed);
+        atomic_store_explicit(&dst->arg, atomic_load_explicit(&src->arg, memory_order_relaxed), memory_order_relaxed);
+    }
+    na->retired = a;
+    atomic_store_explicit(&d->arr, na, memory_order_release);
+    return na;
+}
+/* Owner only. */
 static int deque_push(kc_deque_t *d, sched_task_fn fn, void *arg){
-    pthread_mutex_lock(&d->mu);
-    uint32_t next=(d->tail+1)%d->cap;
-    if(next==d->head){
-    uint32_t ncap=d->cap*2; sched_task_t *nbuf=(sched_task_t*)calloc(ncap,sizeof(sched_task_t));
-        if(!nbuf){pthread_mutex_unlock(&d->mu);return -1;}
-        uint32_t i=0,h=d->head; while(h!=d->tail){ nbuf[i++]=d->buf[h]; h=(h+1)%d->cap; }
-        d->head=0; d->tail=i; free(d->buf); d->buf=nbuf; d->cap=ncap; next=(d->tail+1)%d->cap;
+    int64_t b = atomic_load_explicit(&d->bottom, memory_order_relaxed);
+    int64_t t = atomic_load_explicit(&d->top, memory_order_acquire);
+    kc_deque_array_t *a = atomic_load_explicit(&d->arr, memory_order_relaxed);
+    if (b - t > a->cap - 1) { a = deque_grow(d, a, b, t); if (!a) return -1; }
+    kc_deque_slot_t *sl = &a->slot[b & (a->cap - 1)];
+    atomic_store_explicit(&sl->fn, fn, memory_order_relaxed);
+    atomic_store_explicit(&sl->arg, arg, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+    return 0;
+}
+/* Owner only. Make room for `n` more pushes up front (deque_push_many
+ * cannot fail after this). */
+static int deque_reserve(kc_deque_t *d, size_t n){
+    int64_t b = atomic_load_explicit(&d->bottom, memory_order_relaxed);
+    int64_t t = atomic_load_explicit(&d->top, memory_order_acquire);
+    kc_deque_array_t *a = atomic_load_explicit(&d->arr, memory_order_relaxed);
+    while (b - t + (int64_t)n > a->cap - 1) { a = deque_grow(d, a, b, t); if (!a) return -1; }
+    return 0;
+}
+/* Owner only, after deque_reserve(n): fill n slots, then publish them with a
+ * single bottom store. fns == NULL pushes `fn` for every element. */
+static void deque_push_many(kc_deque_t *d, sched_task_fn fn, const sched_task_fn *fns, void *const *args, size_t n){
+    int64_t b = atomic_load_explicit(&d->bottom, memory_order_relaxed);
+    kc_deque_array_t *a = atomic_load_explicit(&d->arr, memory_order_relaxed);
+    for (size_t i = 0; i < n; i++) {
+        kc_deque_slot_t *sl = &a->slot[(b + (int64_t)i) & (a->cap - 1)];
+        atomic_store_explicit(&sl->fn, fns ? fns[i] : fn, memory_order_relaxed);
+        atomic_store_explicit(&sl->arg, args[i], memory_order_relaxed);
     }
-    d->buf[d->tail].fn=fn; d->buf[d->tail].arg=arg; d->tail=next; atomic_fetch_add(&d->len,1); pthread_mutex_unlock(&d->mu); return 0;
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&d->bottom, b + (int64_t)n, memory_order_relaxed);
 }
-static int deque_pop_owner(kc_deque_t *d, sched_task_t *out){ pthread_mutex_lock(&d->mu); if(d->head==d->tail){ pthread_mutex_unlock(&d->mu); return 0;} uint32_t new_tail=(d->tail + d->cap -1)%d->cap; *out=d->buf[new_tail]; d->tail=new_tail; atomic_fetch_sub(&d->len,1); pthread_mutex_unlock(&d->mu); return 1; }
-static int deque_steal(kc_deque_t *d, sched_task_t *out){ pthread_mutex_lock(&d->mu); if(d->head==d->tail){ pthread_mutex_unlock(&d->mu); return 0;} *out=d->buf[d->head]; d->head=(d->head+1)%d->cap; atomic_fetch_sub(&d->len,1); pthread_mutex_unlock(&d->mu); return 1; }
+/* Owner only. LIFO end. */
+static int deque_pop_owner(kc_deque_t *d, sched_task_t *out){
+    int64_t b = atomic_load_explicit(&d->bottom, memory_order_relaxed) - 1;
+    kc_deque_array_t *a = atomic_load_explicit(&d->arr, memory_order_relaxed);
+    atomic_store_explicit(&d->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t t = atomic_load_explicit(&d->top, memory_order_relaxed);
+    if (t > b) { atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed); return 0; }
+    kc_deque_slot_t *sl = &a->slot[b & (a->cap - 1)];
+    out->fn = atomic_load_explicit(&sl->fn, memory_order_relaxed);
+    out->arg = atomic_load_explicit(&sl->arg, memory_order_relaxed);
+    if (t == b) {
+        /* Last element: race thieves for it. */
+        int won = atomic_compare_exchange_strong_explicit(&d->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed);
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+        return won ? 1 : 0;
+    }
+    return 1;
+}
+/* Any thread. FIFO end. Returns KC_DEQUE_OK, KC_DEQUE_EMPTY, or KC_DEQUE_ABORT
+ * when the CAS on top lost to the owner or another thief. */
+static int deque_steal(kc_deque_t *d, sched_task_t *out){
+    int64_t t = atomic_load_explicit(&d->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t b = atomic_load_explicit(&d->bottom, memory_order_acquire);
+    if (t >= b) return KC_DEQUE_EMPTY;
+    kc_deque_array_t *a = atomic_load_explicit(&d->arr, memory_order_acquire);
+    kc_deque_slot_t *sl = &a->slot[t & (a->cap - 1)];
+    sched_task_t v;
+    v.fn = atomic_load_explicit(&sl->fn, memory_order_relaxed);
+    v.arg = atomic_load_explicit(&sl->arg, memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&d->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed))
+        return KC_DEQUE_ABORT;
+    *out = v;
+    return KC_DEQUE_OK;
+}
+
+/* ---- Worker parking ----
+ * Each worker owns a wake token. An idle worker advertises itself in the
+ * scheduler's idle mask, re-checks for work, then sleeps on its token (futex
+ * on Linux, mutex/condvar elsewhere) with no timeout. A producer publishes
+ * work, then claims exactly one idle bit with a CAS and sets that worker's
+ * token; the idle_workers/idle-mask store and the producer's load are both
+ * seq_cst, so a wake cannot slip between the re-check and the sleep. */
+
+typedef struct kc_parker {
+    _Atomic(uint32_t) token; /* 0 = sleep, 1 = wake pending */
+#ifndef __linux__
+    pthread_mutex_t mu;
+    pthread_cond_t cv;
+#endif
+} kc_parker_t;
+
+static inline void kc_cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield" ::: "memory");
+#else
+    atomic_signal_fence(memory_order_seq_cst);
+#endif
+}
+
+static void parker_init(kc_parker_t *p)
+{
+    atomic_store(&p->token, 0);
+#ifndef __linux__
+    pthread_mutex_init(&p->mu, NULL);
+    kc_posix_cond_init_monotonic(&p->cv);
+#endif
+}
+
+static void parker_destroy(kc_parker_t *p)
+{
+#ifndef __linux__
+    pthread_mutex_destroy(&p->mu);
+    pthread_cond_destroy(&p->cv);
+#else
+    (void)p;
+#endif
+}
+
+/* Sleep until the token is set; consumes it. */
+static void parker_wait(kc_parker_t *p)
+{
+#ifdef __linux__
+    while (atomic_load_explicit(&p->token, memory_order_acquire) == 0) {
+        syscall(SYS_futex, &p->token, FUTEX_WAIT_PRIVATE, 0, NULL, NULL, 0);
+    }
+#else
+    pthread_mutex_lock(&p->mu);
+    while (atomic_load_explicit(&p->token, memory_order_acquire) == 0) pthread_cond_wait(&p->cv, &p->mu);
+    pthread_mutex_unlock(&p->mu);
+#endif
+    atomic_store_explicit(&p->token, 0, memory_order_relaxed);
+}
+
+/* Like parker_wait, but gives up once CLOCK_MONOTONIC reaches deadline_ns. */
+static void parker_wait_until(kc_parker_t *p, uint64_t deadline_ns)
+{
+#ifdef __linux__
+    while (atomic_load_explicit(&p->token, memory_order_acquire) == 0) {
+        uint64_t now = kc_now_ns();
+        if (now >= deadline_ns) break;
+        uint64_t d = deadline_ns - now;
+        struct timespec rel = { (time_t)(d / 1000000000ull), (long)(d % 1000000000ull) };
+        syscall(SYS_futex, &p->token, FUTEX_WAIT_PRIVATE, 0, &rel, NULL, 0);
+    }
+#else
+    pthread_mutex_lock(&p->mu);
+    while (atomic_load_explicit(&p->token, memory_order_acquire) == 0) {
+        uint64_t now = kc_now_ns();
+        if (now >= deadline_ns) break;
+        struct timespec ts;
+        kc_clock_abstime(&ts, KC_PORT_PTHREAD_COND_CLOCK, deadline_ns);
+        pthread_cond_timedwait(&p->cv, &p->mu, &ts);
+    }
+    pthread_mutex_unlock(&p->mu);
+#endif
+    atomic_store_explicit(&p->token, 0, memory_order_relaxed);
+}
+
+static void parker_unpark(kc_parker_t *p)
+{
+    if (atomic_exchange_explicit(&p->token, 1, memory_order_release) != 0) return;
+#ifdef __linux__
+    syscall(SYS_futex, &p->token, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+#else
+    pthread_mutex_lock(&p->mu);
+    pthread_cond_signal(&p->cv);
+    pthread_mutex_unlock(&p->mu);
+#endif
+}
+
+#define KC_SCHED_MAX_WORKERS 256
+#define KC_SCHED_IDLE_WORDS (KC_SCHED_MAX_WORKERS / 64)
+#ifndef KC_SCHED_BULK_SHARE_DEFAULT
+#define KC_SCHED_BULK_SHARE_DEFAULT 16 /* worker turns per guaranteed bulk item */
+#endif
+#ifndef KC_SCHED_PARK_SPIN_DEFAULT
+#define KC_SCHED_PARK_SPIN_DEFAULT 64
+#endif
+/* Slice monitor sampling floor, and its poll period while no slice is set. */
+#ifndef KC_SCHED_MONITOR_MIN_US
+#define KC_SCHED_MONITOR_MIN_US 50
+#endif
+#ifndef KC_SCHED_MONITOR_IDLE_MS
+#define KC_SCHED_MONITOR_IDLE_MS 10
+#endif
+/* kc_sched_opts_t knobs the caller set; sched_tune leaves these alone. */
+enum {
+    SCHED_PIN_MIN = 1u << 0, SCHED_PIN_MAX = 1u << 1, SCHED_PIN_BACKLOG = 1u << 2,
+    SCHED_PIN_UP = 1u << 3, SCHED_PIN_DOWN = 1u << 4, SCHED_PIN_SPIN = 1u << 5,
+    SCHED_PIN_BULK = 1u << 6, SCHED_PIN_STEAL = 1u << 7, SCHED_PIN_SLICE = 1u << 8
+};
+/* Elastic sizing (only when max_workers/min_workers differ from workers). */
+#ifndef KC_SCHED_SCALE_UP_BACKLOG_DEFAULT
+#define KC_SCHED_SCALE_UP_BACKLOG_DEFAULT 64 /* queued shared tasks that count as backlog */
+#endif
+#ifndef KC_SCHED_SCALE_UP_MS_DEFAULT
+#define KC_SCHED_SCALE_UP_MS_DEFAULT 10      /* backlog this long adds one worker */
+#endif
+#ifndef KC_SCHED_SCALE_DOWN_MS_DEFAULT
+#define KC_SCHED_SCALE_DOWN_MS_DEFAULT 1000  /* a worker idle this long retires */
+#endif
+/* Initial inject/bulk ring capacity under KC_SCHED_START_LAZY (else 2048). */
+#ifndef KC_SCHED_LAZY_RING_CAP
+#define KC_SCHED_LAZY_RING_CAP 64
+#endif
+
+/* KC_SCHED_START_WARM: write one byte per page so the range is resident. */
+static void sched_prefault(void *p, size_t n)
+{
+    size_t ps = (size_t)sysconf(_SC_PAGESIZE);
+    volatile unsigned char *b = (volatile unsigned char*)p;
+    for (size_t off = 0; off < n; off += ps) b[off] = b[off];
+    if (n) b[n - 1] = b[n - 1];
+}
+
+/* One-task handoff from non-worker threads into a worker (kc_spawn's fast
+ * path), stored inline so spawning never allocates. A producer claims the slot
+ * EMPTY -> BUSY, writes fn/arg, then publishes FULL; only the owning worker
+ * takes it (FULL -> EMPTY). A BUSY slot reads as empty: the producer wakes
+ * the worker after publishing. */
+enum { KC_SLOT_EMPTY = 0, KC_SLOT_BUSY = 1, KC_SLOT_FULL = 2 };
+typedef struct kc_task_slot {
+    _Atomic(uint32_t) state;
+    sched_task_fn fn;
+    void *arg;
+} kc_task_slot_t;
+
+static int slot_offer(kc_task_slot_t *sl, sched_task_fn fn, void *arg)
+{
+    uint32_t expected = KC_SLOT_EMPTY;
+    if (atomic_load_explicit(&sl->state, memory_order_relaxed) != KC_SLOT_EMPTY ||
+        !atomic_compare_exchange_strong_explicit(&sl->state, &expected, KC_SLOT_BUSY,
+                                                 memory_order_acquire, memory_order_relaxed))
+        return 0;
+    sl->fn = fn;
+    sl->arg = arg;
+    atomic_store_explicit(&sl->state, KC_SLOT_FULL, memory_order_release);
+    return 1;
+}
+
+/* Owner only. */
+static int slot_take(kc_task_slot_t *sl, sched_task_t *out)
+{
+    if (atomic_load_explicit(&sl->state, memory_order_acquire) != KC_SLOT_FULL) return 0;
+    out->fn = sl->fn;
+    out->arg = sl->arg;
+    atomic_store_explicit(&sl->state, KC_SLOT_EMPTY, memory_order_release);
+    return 1;
+}
+
+typedef struct kc_task_ring {
+    KC_MUTEX_T mu; sched_task_t *buf; uint32_t cap, head, tail;
+    _Atomic(uint32_t) len; /* approximate, for lock-free idle checks */
+} kc_task_ring_t;
+
+/* Event counters reported by kc_sched_get_stats. Each worker slot has its
+ * own block, bumped with owner-only stores; other threads (external spawns
+ * and wakes, the blocking pool) RMW a shared block. Nothing on the hot path
+ * writes a line another core writes too. */
+#define SCHED_COUNTERS(X) \
+    X(tasks_submitted) X(tasks_completed) \
+    X(steals_probes) X(steals_succeeded) X(steals_failures) X(steals_cas_failures) \
+    X(steals_remote) X(steals_batched) \
+    X(fastpath_hits) X(fastpath_misses) X(inject_pulls) X(donations) \
+    X(ready_local) X(ready_global) X(runnext_hits) X(park_events) X(unpark_events) \
+    X(bulk_forced) X(deadline_run) X(deadline_steals) X(deadline_misses) X(handoffs) \
+    X(remote_wakes) X(remote_doorbells) X(home_wakes) X(guest_runs)
+
+typedef struct __attribute__((aligned(64))) sched_counters {
+#define SCHED_COUNTER_FIELD(f) _Atomic(unsigned long) f;
+    SCHED_COUNTERS(SCHED_COUNTER_FIELD)
+#undef SCHED_COUNTER_FIELD
+    _Atomic(unsigned long) lane_submitted[KC_LANE_COUNT];
+} sched_counters_t;
 
 typedef struct sched_worker {
-    pthread_t thr; int id; struct kc_sched *sched; kc_deque_t dq; _Atomic(sched_task_t*) last_task; kcoro_t *main_co;
+    pthread_t thr; int id; struct kc_sched *sched; kc_deque_t dq; kc_task_slot_t last_task; kcoro_t *main_co;
+    _Atomic(kcoro_t*) runnext; /* LIFO slot for the coroutine this worker woke most recently */
+    _Atomic(kcoro_t*) inbox;   /* remote wakes: Treiber stack through co->next, newest first */
+    kcoro_t *handoff;          /* owner only: claimed target of kc_sched_handoff, run next */
+    uint32_t tick;             /* loop counter; periodically favours the global queue */
+    kc_parker_t park;          /* per-worker wake token */
+    kc_timer_wheel_t wheel;    /* timers armed on (or routed to) this worker */
+    void (*park_release)(void *arg); /* kc_sched_park_release hook, run after switch-out */
+    void *park_release_arg;
+    int node;                  /* NUMA node (0 unless placed with KC_SCHED_PLACE_NUMA) */
+    int *victims;              /* steal order: [0, nnear) same node, [nnear, nvictims) remote */
+    int nnear, nvictims;
+    uint32_t rng;              /* ws_rand state: steal victims, kc_sched_rand */
+    int start_rc;              /* worker-side init result, read by kc_sched_init */
+    _Atomic(unsigned long) lane_run[KC_LANE_COUNT]; /* owner-written, summed by kc_sched_get_stats */
+    _Atomic(unsigned long) parks, steals; /* owner-written, kc_sched_get_worker_stats */
+    _Atomic(int) steal_depth;  /* owner-written: current adaptive scan depth (0: not set yet) */
+    /* Time-slice budget (sched_monitor_main): run_seq is owner-written and odd
+     * while a coroutine runs; the monitor stamps run_since when it first sees
+     * a run and raises preempt once that run outlasts slice_ns. */
+    _Atomic(uint32_t) run_seq;
+    _Atomic(int) preempt;
+    _Atomic(uint64_t) run_since;
+    _Atomic(unsigned long) preempt_yields; /* owner-written: safepoint yields taken */
+    /* Stall watchdog: the coroutine of the current run, published before
+     * run_seq turns odd; wd_req hands a stack sample request to the worker's
+     * signal handler (WD_REQ_*), which fills wd_pc for run wd_seq. */
+    _Atomic(uint64_t) run_id;
+    _Atomic(const char*) run_name;
+    _Atomic(int) wd_req;
+    uint32_t wd_seq;
+    int wd_npc;
+    uintptr_t wd_pc[KC_STALL_DEPTH];
+    uint32_t steal_calls, steal_hits; /* sched_steal calls / successes in the current window */
+    /* Deadline class (kc_spawn_co_deadline): ready coroutines with a deadline
+     * in a binary min-heap on deadline_ns. Wakers and thieves lock dl_mu;
+     * dl_min mirrors the root for lock-free peeks (0 => empty). */
+    KC_MUTEX_T dl_mu;
+    kcoro_t **dl_heap;
+    uint32_t dl_len, dl_cap;
+    _Atomic(uint64_t) dl_min;
+    _Atomic(uint64_t) parked_ns;          /* owner-written: time asleep in the parker */
+    _Atomic(uint64_t) park_t0;            /* start of the current sleep, 0 while awake */
+    sched_counters_t ctr;      /* owner-written event counters */
+    _Atomic(int) on;           /* a thread runs this slot (0: dormant, revived on demand) */
+    int joinable;              /* thr holds a thread not yet joined (under scale_mu) */
+    /* Poll workers only: time since start and inside runs, empty turns (owner-written) */
+    _Atomic(uint64_t) poll_t0, poll_busy_ns;
+    _Atomic(unsigned long) poll_spins;
+    int poll_cpu;              /* -1 => unpinned */
+#ifdef __linux__
+    int has_affinity;
+    cpu_set_t affinity;
+#endif
 } sched_worker_t;
 
 struct kc_sched { /* unified */
     int workers; sched_worker_t *w; _Atomic(int) stop;
-    _Atomic(unsigned long) tasks_submitted, tasks_completed;
-    _Atomic(unsigned long) steals_probes, steals_succeeded, steals_failures;
-    _Atomic(unsigned long) fastpath_hits, fastpath_misses, inject_pulls, donations;
-    pthread_mutex_t park_mu; pthread_cond_t park_cv; _Atomic(int) idle_workers;
-    pthread_mutex_t inject_mu; sched_task_t *inject_buf; uint32_t inject_cap, inject_head, inject_tail;
-    pthread_mutex_t rq_mu; kcoro_t *rq_head, *rq_tail;
-    /* Timer subsystem */
-    pthread_mutex_t timer_mu; pthread_cond_t timer_cv;
-    kc_timer_item_t* timer_head;
-    pthread_t timer_thr;
-    _Atomic(int) timer_started;
-    _Atomic(uint64_t) next_timer_id;
+    int npoll;               /* busy-poll workers, in w[workers .. workers + npoll) */
+    _Atomic(int) idle_workers;
+    _Atomic(uint64_t) idle_mask[KC_SCHED_IDLE_WORDS]; /* bit set => worker parked (or about to) */
+    _Atomic(int) park_spin;  /* idle loop rounds before parking */
+    kc_task_ring_t inject;   /* external submissions and donations */
+    kc_task_ring_t bulk;     /* KC_LANE_BULK tasks and ready coroutines */
+    _Atomic(uint32_t) bulk_share; /* a worker takes a bulk item at least every bulk_share turns */
+    _Atomic(int) steal_scan; /* random victims probed per steal attempt */
+    _Atomic(uint64_t) slice_ns;  /* coroutine time-slice budget, 0 => off */
+    _Atomic(unsigned long) preempt_flags; /* overruns the monitor flagged */
+    _Atomic(unsigned long) dl_queued;     /* coroutines in any worker's deadline heap */
+    pthread_t mon_thr; int mon_started;   /* slice monitor (under scale_mu) */
+    /* Stall watchdog (kc_sched_set_watchdog), run by the slice monitor;
+     * wd_fn / wd_arg under wd_mu. */
+    _Atomic(uint64_t) wd_ns;              /* 0 => off */
+    _Atomic(unsigned) wd_flags;
+    pthread_mutex_t wd_mu; kc_sched_stall_fn wd_fn; void *wd_arg;
+    _Atomic(unsigned long) stalls_run, stalls_queue;
+    /* Guest runtime (kc_sched_set_guest): the copy workers call, the ring
+     * its notify sets, and callers inside it (set_guest waits them out). */
+    kc_sched_guest_t *_Atomic guest;
+    _Atomic(int) guest_bell, guest_calls;
+    KC_MUTEX_T rq_mu; kcoro_t *_Atomic rq_head; kcoro_t *rq_tail;
+    int *victim_buf;         /* backing store for every worker's victims[] */
+    pthread_mutex_t start_mu; pthread_cond_t start_cv; int started; /* startup handshake */
+    /* Elastic sizing: `workers` slots exist, `active` of them have a thread. */
+    _Atomic(int) active;
+    int base_workers;        /* threads started by kc_sched_init */
+    _Atomic(int) lazy_left;  /* KC_SCHED_START_LAZY: slots still to start on demand */
+    int warm;                /* KC_SCHED_START_WARM: workers pre-fault at startup */
+    _Atomic(int) min_workers, max_active;
+    _Atomic(uint32_t) scale_up_backlog;
+    _Atomic(uint64_t) scale_up_ns, scale_down_ns;
+    /* Knobs set in kc_sched_opts_t (SCHED_PIN_*); the rest follow
+     * kc_runtime_config_reload through sched_config_changed. */
+    unsigned pinned;
+    int cfg_watched;
+    _Atomic(uint64_t) backlog_since; /* first publish that saw the current backlog, 0 => none */
+    _Atomic(unsigned long) scale_ups, scale_downs;
+    /* Defaulted size (no workers or cpus in opts): growth stops at the CPU
+     * budget, re-read at most every KC_SCHED_CPU_RECHECK_MS. */
+    int cpu_auto;
+    _Atomic(int) cpu_budget;
+    _Atomic(uint64_t) cpu_checked_ns;
+    pthread_mutex_t scale_mu; int scale_closed; /* serializes thread starts vs. shutdown */
+    /* Wake-to-resume latency: one shard per worker slot, allocated on first
+     * enable and kept until shutdown so recorders never see it go away. */
+    _Atomic(int) wake_lat_on;
+    struct kc_hist_shard *_Atomic wake_hist;
+    /* Steal matrix, workers x workers (row: thief, column: victim), each row
+     * written by its thief only; allocated on first enable like wake_hist. */
+    _Atomic(int) steal_mx_on;
+    _Atomic(unsigned long) *_Atomic steal_mx;
+    /* Outstanding work (kc_sched_drain): tasks queued or running plus
+     * coroutines claimed for a run. Raised before the work can be seen by a
+     * worker, dropped when a task returns or a run ends without queueing
+     * the coroutine again; drain waiters sleep on drain_cv until it is 0. */
+    _Alignas(64) _Atomic(long) outstanding;
+    _Atomic(int) drain_waiters;
+    KC_MUTEX_T drain_mu; KC_COND_T drain_cv;
+    sched_counters_t ext_ctr; /* counters bumped off this scheduler's workers */
 };
 
 static __thread struct kc_sched *tls_current_sched = NULL;
+static __thread sched_worker_t *tls_current_worker = NULL; /* deque owner identity */
+
+/* Owner-only counter bump (no RMW); kc_sched_get_stats sums the workers. */
+static inline void sched_owner_add(_Atomic(unsigned long) *c, unsigned long n)
+{
+    atomic_store_explicit(c, atomic_load_explicit(c, memory_order_relaxed) + n, memory_order_relaxed);
+}
+
+/* Bump counter f of s by n from any thread (see sched_counters_t). */
+#define SCHED_COUNT(s, f, n) do { \
+        sched_worker_t *cw_ = tls_current_worker; \
+        if (cw_ && cw_->sched == (s)) sched_owner_add(&cw_->ctr.f, (n)); \
+        else atomic_fetch_add_explicit(&(s)->ext_ctr.f, (n), memory_order_relaxed); \
+    } while (0)
+/* Bump counter f of worker w from w's own thread. */
+#define SCHED_WCOUNT(w, f, n) sched_owner_add(&(w)->ctr.f, (n))
+
+/* The calling thread's worker when it is one of s's general workers. Poll
+ * workers run their own coroutines only, so what they hand to s goes the
+ * way a foreign thread's would. */
+static inline sched_worker_t *sched_self(struct kc_sched *s)
+{
+    sched_worker_t *w = tls_current_worker;
+    return w && w->sched == s && w->id < s->workers ? w : NULL;
+}
+
+int kc_sched_self_index(void)
+{
+    return tls_current_worker ? tls_current_worker->id : -1;
+}
+
+/* Ready queue helpers
+ * Runnable coroutines normally live on the waking worker's own structures:
+ * the `runnext` slot, spilling into its Chase-Lev deque as resume tasks (so
+ * idle workers can steal them). The global intrusive list below is only the
+ * overflow/inject path for wakes from non-worker threads and for coroutines
+ * that yielded (FIFO so a yield-spinning coroutine cannot starve its peers). */
+
+static inline void sched_work_add(struct kc_sched *s, long n)
+{
+    atomic_fetch_add_explicit(&s->outstanding, n, memory_order_relaxed);
+}
+
+/* seq_cst against kc_sched_drain's waiter count: either it sees zero or we
+ * see it waiting. */
+static void sched_work_done(struct kc_sched *s, long n)
+{
+    if (atomic_fetch_sub_explicit(&s->outstanding, n, memory_order_seq_cst) != n) return;
+    if (!atomic_load_explicit(&s->drain_waiters, memory_order_seq_cst)) return;
+    KC_MUTEX_LOCK(&s->drain_mu);
+    KC_COND_BROADCAST(&s->drain_cv);
+    KC_MUTEX_UNLOCK(&s->drain_mu);
+}
+
+/* Claim the right to enqueue `co`; exactly one concurrent waker wins. */
+static inline int sched_claim_ready(kcoro_t *co)
+{
+    bool expected = false;
+    return atomic_compare_exchange_strong_explicit(&co->ready_enqueued, &expected, true,
+                                                   memory_order_acq_rel, memory_order_relaxed);
+}
+
+static void rq_push_locked(struct kc_sched *s, kcoro_t *co)
+{
+    if (!co) return;
+    if (co->next) {
+        KC_SCHED_DEBUG("enqueue co=%p while next=%p -- clearing", (void*)co, (void*)co->next);
+    }
+    co->next = NULL;
+    kcoro_t *tail = s->rq_tail;
+    KC_SCHED_DEBUG("push co=%p prev_tail=%p head=%p", (void*)co, (void*)tail, (void*)s->rq_head);
+    if (tail) tail->next = co; else s->rq_head = co;
+    s->rq_tail = co;
+}
+
+static kcoro_t* rq_pop_locked(struct kc_sched *s)
+{
+    kcoro_t *co = s->rq_head;
+    if (co) {
+        kcoro_t *next = co->next;
+        KC_SCHED_DEBUG("pop co=%p next=%p head=%p tail=%p", (void*)co, (void*)next, (void*)s->rq_head, (void*)s->rq_tail);
+        s->rq_head = next;
+        if (!s->rq_head) s->rq_tail = NULL;
+        co->next = NULL;
+    }
+    return co;
+}
+
+/* Push a claimed (ready_enqueued == true), retained coroutine on the global list. */
+static void rq_push_global(struct kc_sched *s, kcoro_t *co)
+{
+    KC_MUTEX_LOCK(&s->rq_mu);
+    rq_push_locked(s, co);
+    KC_MUTEX_UNLOCK(&s->rq_mu);
+    SCHED_COUNT(s, ready_global, 1);
+}
+
+/* Append a chain of claimed, retained coroutines (linked through next,
+ * n of them) to the global list in one lock hold. */
+static void rq_splice_global(struct kc_sched *s, kcoro_t *head, kcoro_t *tail, size_t n)
+{
+    if (!head) return;
+    KC_MUTEX_LOCK(&s->rq_mu);
+    if (s->rq_tail) s->rq_tail->next = head; else s->rq_head = head;
+    s->rq_tail = tail;
+    KC_MUTEX_UNLOCK(&s->rq_mu);
+    SCHED_COUNT(s, ready_global, n);
+}
+
+/* Push n claimed, retained coroutines on the global list in one lock hold. */
+static void rq_push_global_many(struct kc_sched *s, kcoro_t *const *cos, size_t n)
+{
+    if (!n) return;
+    KC_MUTEX_LOCK(&s->rq_mu);
+    for (size_t i = 0; i < n; i++) rq_push_locked(s, cos[i]);
+    KC_MUTEX_UNLOCK(&s->rq_mu);
+    SCHED_COUNT(s, ready_global, n);
+}
+
+static kcoro_t* rq_pop_global(struct kc_sched *s)
+{
+    if (!atomic_load_explicit(&s->rq_head, memory_order_relaxed)) return NULL;
+    KC_MUTEX_LOCK(&s->rq_mu);
+    kcoro_t *co = rq_pop_locked(s);
+    KC_MUTEX_UNLOCK(&s->rq_mu);
+    return co;
+}
+
+static int sched_revive(struct kc_sched *s, sched_worker_t *w);
+static int sched_revive_slot(struct kc_sched *s, sched_worker_t *w);
+static inline uint32_t ring_len(kc_task_ring_t *r);
+
+/* The CPU budget of a defaulted scheduler, re-read once per recheck period
+ * by whichever caller wins the timestamp CAS. */
+static int sched_cpu_budget(struct kc_sched *s, uint64_t now)
+{
+    uint64_t last = atomic_load_explicit(&s->cpu_checked_ns, memory_order_relaxed);
+    if (now - last >= (uint64_t)KC_SCHED_CPU_RECHECK_MS * 1000000ull &&
+        atomic_compare_exchange_strong(&s->cpu_checked_ns, &last, now))
+        atomic_store_explicit(&s->cpu_budget, kc_cpu_budget(), memory_order_relaxed);
+    return atomic_load_explicit(&s->cpu_budget, memory_order_relaxed);
+}
+
+/* No worker is idle: add one if the shared queues have stayed deep for
+ * scale_up_ns. At most one worker per period; cheap when sizing is fixed. */
+static void sched_maybe_grow(struct kc_sched *s)
+{
+    if (atomic_load_explicit(&s->active, memory_order_relaxed) >=
+        atomic_load_explicit(&s->max_active, memory_order_relaxed)) return;
+    /* Lazy startup: the first `workers` slots start on demand, no backlog needed. */
+    if (atomic_load_explicit(&s->lazy_left, memory_order_relaxed) > 0) {
+        for (int i = 0; i < s->workers; i++) {
+            if (sched_revive_slot(s, &s->w[i])) { atomic_fetch_sub(&s->lazy_left, 1); return; }
+        }
+        return;
+    }
+    uint32_t backlog = ring_len(&s->inject) + ring_len(&s->bulk);
+    uint64_t since = atomic_load_explicit(&s->backlog_since, memory_order_relaxed);
+    if (backlog < atomic_load_explicit(&s->scale_up_backlog, memory_order_relaxed)) {
+        if (since) atomic_store_explicit(&s->backlog_since, 0, memory_order_relaxed);
+        return;
+    }
+    uint64_t now = kc_now_ns();
+    if (since == 0) {
+        atomic_compare_exchange_strong(&s->backlog_since, &since, now);
+        return;
+    }
+    if (now - since < atomic_load_explicit(&s->scale_up_ns, memory_order_relaxed)) return;
+    if (s->cpu_auto && atomic_load_explicit(&s->active, memory_order_relaxed) >= sched_cpu_budget(s, now)) return;
+    if (!atomic_compare_exchange_strong(&s->backlog_since, &since, now)) return;
+    for (int i = 0; i < s->workers; i++) if (sched_revive(s, &s->w[i])) return;
+}
+
+/* Wake exactly one parked worker, if any. Call after publishing work. */
+static void sched_wake_one(struct kc_sched *s)
+{
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&s->idle_workers, memory_order_relaxed) <= 0) { sched_maybe_grow(s); return; }
+    for (int i = 0; i < KC_SCHED_IDLE_WORDS; i++) {
+        uint64_t m = atomic_load_explicit(&s->idle_mask[i], memory_order_relaxed);
+        while (m) {
+            uint64_t bit = m & (~m + 1);
+            if (atomic_compare_exchange_weak_explicit(&s->idle_mask[i], &m, m & ~bit,
+                                                      memory_order_acq_rel, memory_order_relaxed)) {
+                int id = i * 64 + __builtin_ctzll(bit);
+                SCHED_COUNT(s, unpark_events, 1);
+                parker_unpark(&s->w[id].park);
+                return;
+            }
+        }
+    }
+}
+
+/* Wake up to n parked workers: one CAS per idle-mask word claims several bits
+ * at once. Call after publishing n units of work. */
+static void sched_wake_many(struct kc_sched *s, size_t n)
+{
+    atomic_thread_fence(memory_order_seq_cst);
+    if (n == 0) return;
+    if (atomic_load_explicit(&s->idle_workers, memory_order_relaxed) <= 0) { sched_maybe_grow(s); return; }
+    for (int i = 0; i < KC_SCHED_IDLE_WORDS && n; i++) {
+        uint64_t m = atomic_load_explicit(&s->idle_mask[i], memory_order_relaxed);
+        uint64_t take;
+        do {
+            take = 0;
+            uint64_t rest = m;
+            for (size_t k = 0; k < n && rest; k++) { uint64_t bit = rest & (~rest + 1); take |= bit; rest &= ~bit; }
+        } while (take && !atomic_compare_exchange_weak_explicit(&s->idle_mask[i], &m, m & ~take,
+                                                                memory_order_acq_rel, memory_order_relaxed));
+        while (take) {
+            uint64_t bit = take & (~take + 1);
+            take &= ~bit;
+            n--;
+            SCHED_COUNT(s, unpark_events, 1);
+            parker_unpark(&s->w[i * 64 + __builtin_ctzll(bit)].park);
+        }
+    }
+}
+
+/* Wake a specific worker (work was placed somewhere only it consumes); a
+ * dormant one gets a thread again. 1 if this call woke or started it. */
+static int sched_wake_worker(struct kc_sched *s, sched_worker_t *w)
+{
+    atomic_thread_fence(memory_order_seq_cst);
+    const uint64_t bit = 1ull << (w->id % 64);
+    if (atomic_fetch_and(&s->idle_mask[w->id / 64], ~bit) & bit) {
+        SCHED_COUNT(s, unpark_events, 1);
+        parker_unpark(&w->park);
+        return 1;
+    }
+    if (!atomic_load(&w->on)) return sched_revive(s, w);
+    return 0;
+}
+
+/* Claim one parked worker (its idle bit cleared, so no other waker spends a
+ * token on it), or NULL when none is parked. The caller unparks it. */
+static sched_worker_t *sched_claim_idle(struct kc_sched *s)
+{
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&s->idle_workers, memory_order_relaxed) <= 0) return NULL;
+    for (int i = 0; i < KC_SCHED_IDLE_WORDS; i++) {
+        uint64_t m = atomic_load_explicit(&s->idle_mask[i], memory_order_relaxed);
+        while (m) {
+            uint64_t bit = m & (~m + 1);
+            if (atomic_compare_exchange_weak_explicit(&s->idle_mask[i], &m, m & ~bit,
+                                                      memory_order_acq_rel, memory_order_relaxed))
+                return &s->w[i * 64 + __builtin_ctzll(bit)];
+        }
+    }
+    return NULL;
+}
+
+/* Task rings: mutex-protected FIFOs that grow by doubling. One is the inject
+ * queue for external submissions and donations; the bulk lane uses another
+ * for its tasks and ready coroutines (as resume tasks). */
+static int ring_init(kc_task_ring_t *r, uint32_t cap){ if(cap==0) cap=2048; r->buf=(sched_task_t*)calloc(cap,sizeof(sched_task_t)); if(!r->buf) return -1; r->cap=cap; r->head=r->tail=0; atomic_store(&r->len,0); KC_MUTEX_INIT(&r->mu); return 0; }
+static void ring_destroy(kc_task_ring_t *r){ if(r->buf) free(r->buf); r->buf=NULL; KC_MUTEX_DESTROY(&r->mu);} 
+static int ring_push(kc_task_ring_t *r, sched_task_fn fn, void *arg){ KC_MUTEX_LOCK(&r->mu); uint32_t next=(r->tail+1)%r->cap; if(next==r->head){ uint32_t ncap=r->cap*2; sched_task_t *nbuf=(sched_task_t*)calloc(ncap,sizeof(sched_task_t)); if(!nbuf){ KC_MUTEX_UNLOCK(&r->mu); return -1;} uint32_t i=0,h=r->head; while(h!=r->tail){ nbuf[i++]=r->buf[h]; h=(h+1)%r->cap;} r->head=0; r->tail=i; free(r->buf); r->buf=nbuf; r->cap=ncap; next=(r->tail+1)%r->cap;} r->buf[r->tail].fn=fn; r->buf[r->tail].arg=arg; r->tail=next; atomic_fetch_add_explicit(&r->len,1,memory_order_relaxed); KC_MUTEX_UNLOCK(&r->mu); return 0; }
+/* Append n tasks in one lock hold, growing once to fit; fns == NULL runs
+ * `fn` on every arg. Nothing is queued when growth fails. */
+static int ring_push_many(kc_task_ring_t *r, sched_task_fn fn, const sched_task_fn *fns, void *const *args, size_t n){
+    if (!n) return 0;
+    KC_MUTEX_LOCK(&r->mu);
+    uint32_t len = (r->tail + r->cap - r->head) % r->cap;
+    if ((size_t)len + n >= r->cap) {
+        size_t ncap = r->cap;
+        while ((size_t)len + n >= ncap) ncap *= 2;
+        sched_task_t *nbuf = ncap <= UINT32_MAX ? (sched_task_t*)calloc(ncap, sizeof(sched_task_t)) : NULL;
+        if (!nbuf) { KC_MUTEX_UNLOCK(&r->mu); return -1; }
+        uint32_t i = 0, h = r->head;
+        while (h != r->tail) { nbuf[i++] = r->buf[h]; h = (h + 1) % r->cap; }
+        free(r->buf);
+        r->buf = nbuf; r->cap = (uint32_t)ncap; r->head = 0; r->tail = i;
+    }
+    for (size_t i = 0; i < n; i++) {
+        r->buf[r->tail].fn = fns ? fns[i] : fn;
+        r->buf[r->tail].arg = args[i];
+        r->tail = (r->tail + 1) % r->cap;
+    }
+    atomic_fetch_add_explicit(&r->len, (uint32_t)n, memory_order_relaxed);
+    KC_MUTEX_UNLOCK(&r->mu);
+    return 0;
+}
+static int ring_pop(kc_task_ring_t *r, sched_task_t *out){ if(atomic_load_explicit(&r->len,memory_order_relaxed)==0) return 0; KC_MUTEX_LOCK(&r->mu); if(r->head==r->tail){ KC_MUTEX_UNLOCK(&r->mu); return 0;} *out=r->buf[r->head]; r->head=(r->head+1)%r->cap; atomic_fetch_sub_explicit(&r->len,1,memory_order_relaxed); KC_MUTEX_UNLOCK(&r->mu); return 1; }
+static inline uint32_t ring_len(kc_task_ring_t *r){ return atomic_load_explicit(&r->len, memory_order_relaxed); }
+
+/* PRNG */
+static inline uint32_t ws_rand(uint32_t *state){ uint32_t x=*state; x^=x<<13; x^=x>>17; x^=x<<5; return *state = x?x:0x12345678u; }
+
+/* Worker for a hand-off from a thread that is not one of s's workers: a
+ * per-thread cursor (randomly seeded, so threads spread out) instead of a
+ * shared counter every external caller would bounce. Prefers running slots;
+ * returns the cursor's slot when none is running. */
+static sched_worker_t *sched_ext_worker(struct kc_sched *s)
+{
+    static __thread uint32_t tls_ext_rr;
+    if (!tls_ext_rr) tls_ext_rr = kc_sched_rand() | 1u;
+    unsigned base = tls_ext_rr++;
+    sched_worker_t *w = &s->w[base % (unsigned)s->workers];
+    for (int k = 1; k < s->workers && !atomic_load_explicit(&w->on, memory_order_relaxed); k++)
+        w = &s->w[(base + (unsigned)k) % (unsigned)s->workers];
+    return w;
+}
+
+static void sched_resume_task(void *arg);
+
+/* ---- Remote-wake inboxes ----
+ * A coroutine woken from a thread that is not one of s's workers (a plain
+ * thread, a reactor, another scheduler's worker) goes to one worker's
+ * inbox instead of the global list: an intrusive Treiber stack linked
+ * through co->next, which a claimed coroutine leaves free. Wakers prepend
+ * with one CAS; the owner, or an idle thief, takes the whole stack with one
+ * exchange, so consumers never contend on a node. A parked worker is
+ * preferred as the target; otherwise the token of the chosen one is rung
+ * only when its inbox goes from empty to non-empty. A burst of remote wakes
+ * then costs one CAS each and a single unpark, not an rq_mu round trip and
+ * a wake per coroutine. */
+
+/* Soft affinity: every coroutine remembers the worker slot it last ran on
+ * (co->last_worker). kc_sched_enqueue_ready_home sends it back there,
+ * through the inbox, so it resumes next to the cache lines it left. When
+ * that inbox already holds a backlog an idle worker is woken as well, to
+ * steal it, so an overloaded worker does not hold on to its coroutines. */
+
+/* The general worker of s co last ran on while its thread is up, else NULL. */
+static inline sched_worker_t *sched_home(struct kc_sched *s, kcoro_t *co)
+{
+    uint32_t h = co->last_worker;
+    if (!h || h > (uint32_t)s->workers) return NULL;
+    sched_worker_t *w = &s->w[h - 1];
+    return atomic_load_explicit(&w->on, memory_order_relaxed) ? w : NULL;
+}
+
+/* Queue a chain of claimed, retained coroutines (head newest, linked through
+ * next, n of them) on an inbox of s: the inbox of `to` when given (their
+ * home, from any thread), else, from outside the workers, a parked or
+ * round-robin worker's. */
+static void sched_remote_push(struct kc_sched *s, sched_worker_t *to, kcoro_t *head, kcoro_t *tail, size_t n)
+{
+    sched_worker_t *w = to ? to : sched_claim_idle(s);
+    int claimed = !to && w != NULL;
+    if (!w) w = sched_ext_worker(s);
+    if (to) SCHED_COUNT(s, home_wakes, n);
+    kcoro_t *top = atomic_load_explicit(&w->inbox, memory_order_relaxed);
+    do {
+        tail->next = top;
+    } while (!atomic_compare_exchange_weak_explicit(&w->inbox, &top, head,
+                                                    memory_order_release, memory_order_relaxed));
+    SCHED_COUNT(s, remote_wakes, n);
+    if (claimed) {
+        SCHED_COUNT(s, unpark_events, 1);
+        SCHED_COUNT(s, remote_doorbells, 1);
+        parker_unpark(&w->park);
+    } else if (!top && sched_wake_worker(s, w)) {
+        /* The fence in sched_wake_worker pairs with sched_park's re-check. */
+        SCHED_COUNT(s, remote_doorbells, 1);
+    } else if (to && top) {
+        sched_wake_one(s);
+    }
+}
+
+/* Move the inbox of `from` onto w's deque (w's own, or a victim's when w is
+ * idle). Pushed newest first, so w's LIFO pops resume the oldest wake
+ * first. Returns the number moved. */
+static size_t sched_inbox_drain(sched_worker_t *w, sched_worker_t *from)
+{
+    kcoro_t *co = atomic_exchange_explicit(&from->inbox, NULL, memory_order_acquire);
+    size_t n = 0;
+    while (co) {
+        kcoro_t *next = co->next;
+        co->next = NULL;
+        if (deque_push(&w->dq, sched_resume_task, co) != 0) rq_push_global(w->sched, co);
+        co = next;
+        n++;
+    }
+    return n;
+}
+
+/* ---- Poll workers ----
+ * Slots past `workers` belong to busy-poll workers (kc_spawn_co_poll). Every
+ * ready entry of a coroutine homed on one goes to that worker's inbox, from
+ * the worker itself too, and it keeps a private FIFO it refills from there,
+ * so yielding poll coroutines take turns. Nothing rings a doorbell: the
+ * worker never parks. */
+
+/* The poll worker co is homed on, or NULL. */
+static inline sched_worker_t *sched_poll_of(struct kc_sched *s, kcoro_t *co)
+{
+    uint32_t h = co->poll_home;
+    return h && h <= (uint32_t)s->npoll ? &s->w[s->workers + (int)h - 1] : NULL;
+}
+
+/* Queue a claimed, retained coroutine on poll worker p. */
+static void sched_poll_push(sched_worker_t *p, kcoro_t *co)
+{
+    kcoro_t *top = atomic_load_explicit(&p->inbox, memory_order_relaxed);
+    do {
+        co->next = top;
+    } while (!atomic_compare_exchange_weak_explicit(&p->inbox, &top, co,
+                                                    memory_order_release, memory_order_relaxed));
+}
+
+#ifndef KC_SCHED_STEAL_SCAN_MAX
+#define KC_SCHED_STEAL_SCAN_MAX 4  /* default steal_scan */
+#endif
+/* Extra tasks a successful steal moves into the thief's own deque (up to half
+ * of what the victim held); 0 steals one task at a time. */
+#ifndef KC_SCHED_STEAL_BATCH_MAX
+#define KC_SCHED_STEAL_BATCH_MAX 32
+#endif
+/* sched_steal calls per adaptive-depth window. */
+#ifndef KC_SCHED_STEAL_WINDOW
+#define KC_SCHED_STEAL_WINDOW 32
+#endif
+
+
+static inline void sched_count_run(sched_worker_t *w, int lane)
+{
+    sched_owner_add(&w->lane_run[lane], 1);
+}
+
+/* ---- Deadline heap (per worker, under dl_mu) ---- */
+static int dl_push_locked(sched_worker_t *w, kcoro_t *co)
+{
+    if (w->dl_len == w->dl_cap) {
+        uint32_t ncap = w->dl_cap ? w->dl_cap * 2 : 16;
+        kcoro_t **nh = (kcoro_t**)realloc(w->dl_heap, (size_t)ncap * sizeof(*nh));
+        if (!nh) return -1;
+        w->dl_heap = nh; w->dl_cap = ncap;
+    }
+    uint32_t i = w->dl_len++;
+    while (i > 0) {
+        uint32_t up = (i - 1) / 2;
+        if (w->dl_heap[up]->deadline_ns <= co->deadline_ns) break;
+        w->dl_heap[i] = w->dl_heap[up];
+        i = up;
+    }
+    w->dl_heap[i] = co;
+    atomic_store_explicit(&w->dl_min, w->dl_heap[0]->deadline_ns, memory_order_relaxed);
+    return 0;
+}
+
+static kcoro_t* dl_pop_locked(sched_worker_t *w)
+{
+    if (w->dl_len == 0) return NULL;
+    kcoro_t *top = w->dl_heap[0];
+    kcoro_t *last = w->dl_heap[--w->dl_len];
+    uint32_t i = 0, n = w->dl_len;
+    for (;;) {
+        uint32_t c = 2 * i + 1;
+        if (c >= n) break;
+        if (c + 1 < n && w->dl_heap[c + 1]->deadline_ns < w->dl_heap[c]->deadline_ns) c++;
+        if (last->deadline_ns <= w->dl_heap[c]->deadline_ns) break;
+        w->dl_heap[i] = w->dl_heap[c];
+        i = c;
+    }
+    if (n) w->dl_heap[i] = last;
+    atomic_store_explicit(&w->dl_min, n ? w->dl_heap[0]->deadline_ns : 0, memory_order_relaxed);
+    return top;
+}
+
+/* Most urgent coroutine of w's heap, or NULL; one relaxed load when empty. */
+static kcoro_t* sched_dl_take(struct kc_sched *s, sched_worker_t *w)
+{
+    if (!atomic_load_explicit(&w->dl_min, memory_order_relaxed)) return NULL;
+    KC_MUTEX_LOCK(&w->dl_mu);
+    kcoro_t *co = dl_pop_locked(w);
+    KC_MUTEX_UNLOCK(&w->dl_mu);
+    if (co) atomic_fetch_sub_explicit(&s->dl_queued, 1, memory_order_relaxed);
+    return co;
+}
+
+/* Queue a claimed, retained coroutine that has a deadline on the heap of the
+ * calling worker (a round-robin running worker from other threads, which is
+ * then woken). Out of memory it falls back to the global list. */
+static void sched_dl_push(struct kc_sched *s, kcoro_t *co)
+{
+    sched_worker_t *self = sched_self(s);
+    sched_worker_t *w = self ? self : sched_ext_worker(s);
+    KC_MUTEX_LOCK(&w->dl_mu);
+    int rc = dl_push_locked(w, co);
+    KC_MUTEX_UNLOCK(&w->dl_mu);
+    if (rc != 0) { rq_push_global(s, co); return; }
+    atomic_fetch_add_explicit(&s->dl_queued, 1, memory_order_relaxed);
+    if (w != self) sched_wake_worker(s, w);
+}
+
+/* Queue a claimed, retained coroutine on the shared structure of its lane:
+ * the bulk ring for bulk coroutines, the global list otherwise. Coroutines
+ * with a deadline go back to a deadline heap whatever their lane. */
+static void sched_requeue(struct kc_sched *s, kcoro_t *co, int lane)
+{
+    sched_worker_t *p = sched_poll_of(s, co);
+    if (p) { sched_poll_push(p, co); return; }
+    if (co->deadline_ns) { sched_dl_push(s, co); return; }
+    if (lane == KC_LANE_BULK && ring_push(&s->bulk, sched_resume_task, co) == 0) return;
+    rq_push_global(s, co);
+}
+
+/* The run that just ended overran its slice: charge the coroutine with it.
+ * The monitor stamped run_since up to one period after the run began, so
+ * max_run_ns is a lower bound. */
+static void sched_account_overrun(sched_worker_t *w, kcoro_t *co)
+{
+    atomic_store_explicit(&w->preempt, 0, memory_order_relaxed);
+    uint64_t since = atomic_load_explicit(&w->run_since, memory_order_relaxed);
+    uint64_t now = kc_now_ns();
+    co->overruns++;
+    if (since && now > since && now - since > co->max_run_ns) co->max_run_ns = now - since;
+}
+
+/* Run a claimed coroutine taken off any ready structure. Consumes the queue's
+ * reference: it is either handed back to a queue or released here. */
+static void sched_run_co_once(sched_worker_t *w, kcoro_t *co)
+{
+    struct kc_sched *s = w->sched;
+    /* The wake stamp belongs to this claim; take it before the next waker can */
+    uint64_t ready_ns = co->ready_ns;
+    co->ready_ns = 0;
+    atomic_store_explicit(&co->ready_enqueued, false, memory_order_release);
+    KC_SCHED_DEBUG("worker %d resume co=%p state=%d", w->id, (void*)co, co->state);
+    int expected = 0;
+    if (!atomic_compare_exchange_strong_explicit(&co->running_flag, &expected, 1,
+                                                 memory_order_acq_rel, memory_order_relaxed)) {
+        /* Still switching out on another worker; retry via the shared queue. */
+        if (sched_claim_ready(co)) { co->ready_ns = ready_ns; sched_requeue(s, co, co->lane); }
+        else { kcoro_release(co); sched_work_done(s, 1); }
+        return;
+    }
+    if (co->state == KCORO_FINISHED) {
+        /* Stale entry: a waker claimed it as it was finishing. Binding or
+         * acquiring a stack here would leave it held, since resume is a
+         * no-op and nothing ever switches out. */
+        atomic_store_explicit(&co->running_flag, 0, memory_order_release);
+        kcoro_release(co);
+        sched_work_done(s, 1);
+        return;
+    }
+
+    if (kcoro_stack_bind(co) != 0) {
+        /* No stack for a KCORO_STACK_LAZY coroutine right now; try again later. */
+        atomic_store_explicit(&co->running_flag, 0, memory_order_release);
+        if (sched_claim_ready(co)) { co->ready_ns = ready_ns; sched_requeue(s, co, co->lane); }
+        else { kcoro_release(co); sched_work_done(s, 1); }
+        return;
+    }
+    if (co->share && !kcoro_share_try_acquire(co)) {
+        /* Its shared stack is busy on another worker; try again later. */
+        atomic_store_explicit(&co->running_flag, 0, memory_order_release);
+        if (sched_claim_ready(co)) { co->ready_ns = ready_ns; sched_requeue(s, co, co->lane); }
+        else { kcoro_release(co); sched_work_done(s, 1); }
+        return;
+    }
+
+    co->main_co = w->main_co;
+    kcoro_set_thread_main(w->main_co);
+    co->scheduler = (kcoro_sched_t*)s;
+    co->last_worker = (uint32_t)w->id + 1;
+    if (ready_ns) {
+        struct kc_hist_shard *h = atomic_load_explicit(&s->wake_hist, memory_order_acquire);
+        uint64_t now = kc_now_ns();
+        if (h && now > ready_ns) kc_hist_record(&h[w->id], (unsigned long)(now - ready_ns));
+    }
+    KC_TRACE(KC_TRACE_RESUME, co, 0);
+    /* A flag raised for the previous run must not cut this one short. */
+    if (atomic_load_explicit(&w->preempt, memory_order_relaxed))
+        atomic_store_explicit(&w->preempt, 0, memory_order_relaxed);
+    atomic_store_explicit(&w->run_id, co->id, memory_order_relaxed);
+    atomic_store_explicit(&w->run_name, co->name, memory_order_relaxed);
+    uint32_t seq = atomic_load_explicit(&w->run_seq, memory_order_relaxed);
+    atomic_store_explicit(&w->run_seq, seq + 1, memory_order_release);
+    kcoro_resume(co);
+    atomic_store_explicit(&w->run_seq, seq + 2, memory_order_release);
+    if (atomic_load_explicit(&w->preempt, memory_order_relaxed)) sched_account_overrun(w, co);
+    KC_TRACE(KC_TRACE_SWITCH_OUT, co, co->state);
+    void (*release)(void *arg) = w->park_release;
+    void *release_arg = w->park_release_arg;
+    w->park_release = NULL;
+    if (release) {
+        /* Parked via kc_sched_park_release: wakers can only reach it once the
+         * hook drops their lock, so it is never requeued here. */
+        atomic_store_explicit(&co->running_flag, 0, memory_order_release);
+        release(release_arg);
+        kcoro_release(co);
+        sched_work_done(s, 1);
+        return;
+    }
+    if ((co->state == KCORO_READY || co->state == KCORO_SUSPENDED) && sched_claim_ready(co)) {
+        if (w->handoff) {
+            /* Handed off: resume right after the target, from runnext. */
+            kcoro_t *prev = atomic_exchange_explicit(&w->runnext, co, memory_order_acq_rel);
+            if (prev && deque_push(&w->dq, sched_resume_task, prev) != 0) rq_push_global(s, prev);
+        } else {
+            /* Yielded: requeue at the back of its lane's queue (queue hold transfers). */
+            sched_requeue(s, co, co->lane);
+        }
+        atomic_store_explicit(&co->running_flag, 0, memory_order_release);
+        return;
+    }
+    /* Finished: the stack can go back to the pool before the last handle drops. */
+    if (co->deadline_ns && kc_now_ns() > co->deadline_ns)
+        SCHED_WCOUNT(w, deadline_misses, 1);
+    kcoro_stack_reclaim(co);
+    atomic_store_explicit(&co->running_flag, 0, memory_order_release);
+    kcoro_release(co);
+    sched_work_done(s, 1);
+}
+
+/* Run co, then any kc_sched_handoff target it left behind, back to back. */
+static void sched_run_co(sched_worker_t *w, kcoro_t *co)
+{
+    while (co) {
+        sched_run_co_once(w, co);
+        co = w->handoff;
+        w->handoff = NULL;
+    }
+}
+
+/* Deque entry for a ready coroutine; stealable like any other task. */
+static void sched_resume_task(void *arg)
+{
+    sched_run_co(tls_current_worker, (kcoro_t*)arg);
+}
+
+static inline void sched_run_task(sched_worker_t *w, sched_task_t *t)
+{
+    t->fn(t->arg);
+    if (t->fn != sched_resume_task) { SCHED_WCOUNT(w, tasks_completed, 1); sched_work_done(w->sched, 1); }
+}
+
+/* Make a claimed, retained coroutine runnable on `lane`. Bulk coroutines go
+ * to the bulk ring. Interactive ones stay local on one of this scheduler's
+ * workers: into `runnext` (displacing the previous occupant into the deque)
+ * when `next` is set, else onto the deque. Other threads go through the
+ * global list. */
+static void sched_push_ready(struct kc_sched *s, kcoro_t *co, int next, int lane)
+{
+    SCHED_COUNT(s, lane_submitted[lane], 1);
+    if (lane == KC_LANE_BULK || co->deadline_ns || co->poll_home) { sched_requeue(s, co, lane); return; }
+    sched_worker_t *self = sched_self(s);
+    if (self) {
+        if (next) co = atomic_exchange_explicit(&self->runnext, co, memory_order_acq_rel);
+        if (co && deque_push(&self->dq, sched_resume_task, co) != 0) { rq_push_global(s, co); return; }
+        SCHED_WCOUNT(self, ready_local, 1);
+        return;
+    }
+    rq_push_global(s, co);
+}
+
+/* Cheap, racy check used right before sleeping. */
+static int sched_has_work(struct kc_sched *s, sched_worker_t *w)
+{
+    if (atomic_load_explicit(&w->last_task.state, memory_order_relaxed) != KC_SLOT_EMPTY) return 1;
+    if (atomic_load_explicit(&w->runnext, memory_order_relaxed)) return 1;
+    if (atomic_load_explicit(&s->rq_head, memory_order_relaxed)) return 1;
+    if (ring_len(&s->inject) || ring_len(&s->bulk)) return 1;
+    if (atomic_load_explicit(&s->dl_queued, memory_order_relaxed)) return 1;
+    if (atomic_load_explicit(&s->guest_bell, memory_order_relaxed)) return 1;
+    for (int i = 0; i < s->workers; i++)
+        if (deque_len(&s->w[i].dq) || atomic_load_explicit(&s->w[i].inbox, memory_order_relaxed)) return 1;
+    return 0;
+}
+
+/* Fire this worker's due timers; woken coroutines go to its runnext/deque. */
+static int sched_fire_timers(sched_worker_t *w)
+{
+    if (kc_timer_wheel_pending(&w->wheel) == 0) return 0;
+    kcoro_t *due[64];
+    int fired = 0;
+    uint64_t now = kc_now_ns();
+    size_t n;
+    do {
+        n = kc_timer_wheel_expire(&w->wheel, now, due, sizeof(due) / sizeof(due[0]));
+        for (size_t i = 0; i < n; i++) {
+            if (!due[i]) continue;
+            KC_TRACE(KC_TRACE_TIMER, due[i], 0);
+            kc_sched_enqueue_ready(w->sched, due[i]);
+        }
+        fired += (int)n;
+    } while (n == sizeof(due) / sizeof(due[0]));
+    return fired;
+}
+
+/* Ring the guest's bell; the 0 -> 1 edge wakes one parked worker. */
+static void sched_guest_ring(struct kc_sched *s)
+{
+    if (!atomic_exchange(&s->guest_bell, 1)) sched_wake_one(s);
+}
+
+/* One guest poll from worker w, when rung or forced (timers under load).
+ * The bell is taken before the call, so a notify during it rings again. */
+static int sched_guest_poll(sched_worker_t *w, int forced)
+{
+    struct kc_sched *s = w->sched;
+    if (!forced && !atomic_load_explicit(&s->guest_bell, memory_order_relaxed)) return 0;
+    atomic_fetch_add(&s->guest_calls, 1);
+    kc_sched_guest_t *g = atomic_load(&s->guest);
+    int ran = 0;
+    if (g) {
+        atomic_store(&s->guest_bell, 0);
+        ran = g->poll(g->arg, w->id, KC_SCHED_GUEST_BUDGET);
+        if (ran >= KC_SCHED_GUEST_BUDGET) sched_guest_ring(s);
+    } else {
+        atomic_store(&s->guest_bell, 0);
+    }
+    atomic_fetch_sub(&s->guest_calls, 1);
+    if (ran > 0) SCHED_WCOUNT(w, guest_runs, (unsigned long)ran);
+    return ran > 0 ? ran : 0;
+}
+
+/* The guest's next timer deadline, UINT64_MAX when none. */
+static uint64_t sched_guest_deadline(struct kc_sched *s)
+{
+    if (!atomic_load_explicit(&s->guest, memory_order_relaxed)) return UINT64_MAX;
+    atomic_fetch_add(&s->guest_calls, 1);
+    kc_sched_guest_t *g = atomic_load(&s->guest);
+    uint64_t d = UINT64_MAX;
+    if (g && g->next_deadline_ns) {
+        unsigned long long t = g->next_deadline_ns(g->arg);
+        if (t) d = (uint64_t)t;
+    }
+    atomic_fetch_sub(&s->guest_calls, 1);
+    return d;
+}
+
+/* Sleep until woken, the next timer, or `until` (UINT64_MAX => no bound). */
+static void sched_park(sched_worker_t *w, uint64_t until)
+{
+    struct kc_sched *s = w->sched;
+    const uint64_t bit = 1ull << (w->id % 64);
+    _Atomic(uint64_t) *word = &s->idle_mask[w->id / 64];
+    /* Sleep no further than this worker's next timer. Foreign arms wake us
+     * through sched_wake_worker, which also covers a newly earlier deadline. */
+    atomic_fetch_add(&s->idle_workers, 1);
+    atomic_fetch_or(word, bit);
+    uint64_t deadline = kc_timer_wheel_next_ns(&w->wheel);
+    uint64_t guest_due = sched_guest_deadline(s);
+    if (guest_due < deadline) deadline = guest_due;
+    if (until < deadline) deadline = until;
+    if (sched_has_work(s, w) || atomic_load(&s->stop) || deadline <= kc_now_ns()) {
+        /* Raced with a producer: withdraw unless a waker already claimed us
+         * (then its token arrives later and just causes one spurious pass). */
+        atomic_fetch_and(word, ~bit);
+        atomic_fetch_sub(&s->idle_workers, 1);
+        return;
+    }
+    SCHED_WCOUNT(w, park_events, 1);
+    sched_owner_add(&w->parks, 1);
+    uint64_t t0 = kc_now_ns();
+    atomic_store_explicit(&w->park_t0, t0, memory_order_relaxed);
+    if (deadline == UINT64_MAX) parker_wait(&w->park);
+    else parker_wait_until(&w->park, deadline);
+    atomic_store_explicit(&w->park_t0, 0, memory_order_relaxed);
+    atomic_store_explicit(&w->parked_ns, atomic_load_explicit(&w->parked_ns, memory_order_relaxed) + (kc_now_ns() - t0),
+                          memory_order_relaxed);
+    /* A timeout leaves our idle bit set; clear it so wakers do not spend their
+     * claim on a worker that is already awake. */
+    atomic_fetch_and(word, ~bit);
+    atomic_fetch_sub(&s->idle_workers, 1);
+    /* Woken for a guest timer: poll it on the next turn. */
+    if (guest_due != UINT64_MAX && kc_now_ns() >= guest_due) atomic_store(&s->guest_bell, 1);
+}
+
+/* Of two random victims from [lo, hi) of w's steal order, the one whose
+ * deque looks longer (deque_len is the load hint); *len receives its length. */
+static int sched_pick_victim(sched_worker_t *w, uint32_t *rng, int lo, int hi, uint32_t *len)
+{
+    struct kc_sched *s = w->sched;
+    int v = w->victims[lo + (int)(ws_rand(rng) % (uint32_t)(hi - lo))];
+    *len = deque_len(&s->w[v].dq);
+    if (hi - lo > 1) {
+        int u = w->victims[lo + (int)(ws_rand(rng) % (uint32_t)(hi - lo))];
+        uint32_t ulen = deque_len(&s->w[u].dq);
+        if (ulen > *len) { v = u; *len = ulen; }
+    }
+    return v;
+}
+
+/* Scan depth follows the success rate of the last KC_SCHED_STEAL_WINDOW
+ * calls: half or more successful keeps the full steal_scan, an all-miss
+ * window drops to one probe, so idle workers spinning before they park stop
+ * hammering empty deques while a skewed load keeps thieves scanning wide. */
+static int sched_steal_depth(sched_worker_t *w, int scan, int hit)
+{
+    w->steal_hits += (uint32_t)hit;
+    int d = atomic_load_explicit(&w->steal_depth, memory_order_relaxed);
+    if (++w->steal_calls >= KC_SCHED_STEAL_WINDOW) {
+        d = 1 + (int)((uint32_t)(scan - 1) * 2u * w->steal_hits / w->steal_calls);
+        w->steal_calls = w->steal_hits = 0;
+    }
+    if (d <= 0 || d > scan) d = scan;
+    atomic_store_explicit(&w->steal_depth, d, memory_order_relaxed);
+    return d;
+}
+
+/* Probe up to the adaptive depth of victims from [lo, hi) of w's steal
+ * order and run the first task taken. A successful steal also moves up to
+ * half of the victim's backlog (KC_SCHED_STEAL_BATCH_MAX at most) into w's
+ * own deque, so a thief of a skewed fan-out does not come back for every
+ * task. The extra tasks are taken one CAS at a time: Chase-Lev lets the
+ * owner pop without a CAS, so a single wider CAS on top could hand a task
+ * to both. */
+static int sched_steal(sched_worker_t *w, uint32_t *rng, int lo, int hi)
+{
+    struct kc_sched *s = w->sched;
+    if (hi <= lo) return 0;
+    int scan = atomic_load_explicit(&s->steal_scan, memory_order_relaxed);
+    int depth = atomic_load_explicit(&w->steal_depth, memory_order_relaxed);
+    if (depth <= 0 || depth > scan) depth = scan;
+    for (int attempt = 0; attempt < depth; ++attempt) {
+        uint32_t len;
+        int victim = sched_pick_victim(w, rng, lo, hi, &len);
+        kc_deque_t *vd = &s->w[victim].dq;
+        if (len == 0) continue;
+        SCHED_WCOUNT(w, steals_probes, 1);
+        sched_task_t stolen;
+        int sr = deque_steal(vd, &stolen);
+        if (sr == KC_DEQUE_OK) {
+            SCHED_WCOUNT(w, steals_succeeded, 1);
+            if (lo >= w->nnear) SCHED_WCOUNT(w, steals_remote, 1);
+            unsigned long moved = 0;
+            uint32_t extra = len / 2 > KC_SCHED_STEAL_BATCH_MAX ? KC_SCHED_STEAL_BATCH_MAX : len / 2;
+            if (extra && deque_reserve(&w->dq, extra) == 0) {
+                sched_task_t t2;
+                while (moved < extra && deque_steal(vd, &t2) == KC_DEQUE_OK) {
+                    (void)deque_push(&w->dq, t2.fn, t2.arg);   /* reserved: cannot fail */
+                    moved++;
+                }
+                if (moved) SCHED_WCOUNT(w, steals_batched, moved);
+            }
+            sched_owner_add(&w->steals, 1 + moved);
+            if (atomic_load_explicit(&s->steal_mx_on, memory_order_relaxed)) {
+                _Atomic(unsigned long) *mx = atomic_load_explicit(&s->steal_mx, memory_order_acquire);
+                sched_owner_add(&mx[(size_t)w->id * (size_t)s->workers + (size_t)victim], 1);
+            }
+            (void)sched_steal_depth(w, scan, 1);
+            KC_TRACE(KC_TRACE_STEAL, stolen.fn == sched_resume_task ? (kcoro_t*)stolen.arg : NULL, victim);
+            sched_run_task(w, &stolen);
+            return 1;
+        } else if (sr == KC_DEQUE_ABORT) {
+            SCHED_WCOUNT(w, steals_cas_failures, 1);
+        } else {
+            SCHED_WCOUNT(w, steals_failures, 1);
+        }
+    }
+    (void)sched_steal_depth(w, scan, 0);
+    return 0;
+}
+
+/* Out of work: take a remote-wake inbox another worker has not drained yet
+ * (it is busy in a long run) onto our deque. 1 if anything was moved. */
+static int sched_inbox_steal(sched_worker_t *w)
+{
+    struct kc_sched *s = w->sched;
+    for (int k = 1; k < s->workers; k++) {
+        sched_worker_t *v = &s->w[(w->id + k) % s->workers];
+        if (atomic_load_explicit(&v->inbox, memory_order_relaxed) && sched_inbox_drain(w, v)) {
+            SCHED_WCOUNT(w, steals_succeeded, 1);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Take the most urgent deadline coroutine queued on another worker, judged
+ * by each heap's published root. Only scans while deadline work is queued. */
+static int sched_dl_steal(sched_worker_t *w)
+{
+    struct kc_sched *s = w->sched;
+    if (!atomic_load_explicit(&s->dl_queued, memory_order_relaxed)) return 0;
+    for (int tries = 0; tries < 2; tries++) {
+        sched_worker_t *best = NULL;
+        uint64_t best_dl = UINT64_MAX;
+        for (int i = 0; i < s->workers; i++) {
+            uint64_t d = atomic_load_explicit(&s->w[i].dl_min, memory_order_relaxed);
+            if (d && d < best_dl && &s->w[i] != w) { best = &s->w[i]; best_dl = d; }
+        }
+        if (!best) return 0;
+        kcoro_t *co = sched_dl_take(s, best);
+        if (!co) continue;   /* its owner got there first: rescan once */
+        SCHED_WCOUNT(w, deadline_steals, 1);
+        SCHED_WCOUNT(w, deadline_run, 1);
+        sched_owner_add(&w->steals, 1);
+        KC_TRACE(KC_TRACE_STEAL, co, best->id);
+        sched_run_co(w, co);
+        return 1;
+    }
+    return 0;
+}
+
+/* An idle worker above min_workers gives up its thread. Called with nothing
+ * runnable in sight; returns 1 when the thread should exit. The slot goes
+ * dormant first and is then re-checked, pairing with sched_wake_worker's
+ * fence: work published after that check revives the slot instead. */
+static int sched_try_retire(sched_worker_t *w)
+{
+    struct kc_sched *s = w->sched;
+    if (kc_timer_wheel_pending(&w->wheel) || sched_has_work(s, w)) return 0;
+    int a = atomic_load(&s->active);
+    do {
+        if (a <= atomic_load_explicit(&s->min_workers, memory_order_relaxed)) return 0;
+    } while (!atomic_compare_exchange_weak(&s->active, &a, a - 1));
+    atomic_store(&w->on, 0);
+    if (kc_timer_wheel_pending(&w->wheel) || sched_has_work(s, w)) {
+        int off = 0;
+        if (atomic_compare_exchange_strong(&w->on, &off, 1)) {
+            atomic_fetch_add(&s->active, 1);
+            return 0;
+        }
+        /* A waker revived the slot already; its new thread takes over. */
+    }
+    atomic_fetch_add_explicit(&s->scale_downs, 1, memory_order_relaxed);
+    return 1;
+}
+
+static void* worker_main(void *arg){
+    sched_worker_t *w = (sched_worker_t*)arg;
+    struct kc_sched *s = w->sched;
+    tls_current_sched = s;
+    tls_current_worker = w;
+    /* Allocated here rather than in kc_sched_init so a placed worker touches
+     * its deque and main context first from its own CPU. A revived slot
+     * keeps its deque. */
+    w->start_rc = atomic_load(&w->dq.arr) ? 0 : deque_init(&w->dq, 256);
+    if (w->start_rc == 0 && !(w->main_co = kcoro_create_main())) {
+        KC_SCHED_DEBUG("worker %d failed to create main coroutine", w->id);
+        w->start_rc = -1;
+    }
+    if (w->start_rc == 0 && s->warm) {
+        /* Take the first-use page faults now rather than on the first spawns. */
+        kc_deque_array_t *a = atomic_load(&w->dq.arr);
+        sched_prefault(a, sizeof(*a) + (size_t)a->cap * sizeof(a->slot[0]));
+        (void)kcoro_stack_pool_prefill(0, ~0u);
+    }
+    pthread_mutex_lock(&s->start_mu);
+    s->started++;
+    pthread_cond_signal(&s->start_cv);
+    pthread_mutex_unlock(&s->start_mu);
+    if (w->start_rc != 0) {
+        atomic_store(&w->on, 0);
+        atomic_fetch_sub(&s->active, 1);
+        return NULL;
+    }
+    kcoro_set_thread_main(w->main_co);
+    kc_clock_coarse_worker();
+    sched_task_t task;
+    w->rng = (uint32_t)((intptr_t)w ^ 0x9e3779b9u);
+    int idle_rounds = 0;
+    uint32_t idle_tick = 0;
+    uint64_t idle_since = 0; /* start of the current idle stretch (elastic sizing) */
+    while (!atomic_load(&s->stop)) {
+        w->tick++;
+        kc_clock_coarse_expire();
+        if (sched_fire_timers(w) > 0) idle_rounds = 0;
+        (void)kc_uring_worker_poll(w->tick % 61 == 0);
+        /* Every bulk_share turns the bulk lane goes first, so it cannot starve. */
+        if (w->tick % atomic_load_explicit(&s->bulk_share, memory_order_relaxed) == 0 &&
+            ring_pop(&s->bulk, &task)) {
+            SCHED_WCOUNT(w, bulk_forced, 1);
+            sched_count_run(w, KC_LANE_BULK);
+            sched_run_task(w, &task);
+            continue;
+        }
+        /* Deadline class before everything else local: earliest deadline first. */
+        kcoro_t *dl = sched_dl_take(s, w);
+        if (dl) {
+            SCHED_WCOUNT(w, deadline_run, 1);
+            sched_count_run(w, KC_LANE_INTERACTIVE);
+            sched_run_co(w, dl);
+            continue;
+        }
+        if (slot_take(&w->last_task, &task)) {
+            task.fn(task.arg);
+            SCHED_WCOUNT(w, fastpath_hits, 1);
+            SCHED_WCOUNT(w, tasks_completed, 1);
+            sched_work_done(s, 1);
+            sched_count_run(w, KC_LANE_INTERACTIVE);
+            continue;
+        }
+        /* Remote wakes join the deque only once it is empty (or on the fair
+         * turn): drained on every turn, each batch would land on top of the
+         * last and the deque's LIFO pops would starve the older ones. */
+        if ((w->tick % 61 == 0 || !deque_len(&w->dq)) && atomic_load_explicit(&w->inbox, memory_order_relaxed))
+            (void)sched_inbox_drain(w, w);
+        /* Check the global list first now and then so overflow never starves. */
+        kcoro_t *co = (w->tick % 61 == 0) ? rq_pop_global(s) : NULL;
+        if (!co && (co = atomic_exchange_explicit(&w->runnext, NULL, memory_order_acq_rel)) != NULL)
+            SCHED_WCOUNT(w, runnext_hits, 1);
+        if (co || deque_pop_owner(&w->dq, &task) || (co = rq_pop_global(s)) != NULL) {
+            sched_count_run(w, KC_LANE_INTERACTIVE);
+            if (co) sched_run_co(w, co); else sched_run_task(w, &task);
+            continue;
+        }
+        if (ring_pop(&s->inject, &task)) {
+            task.fn(task.arg);
+            SCHED_WCOUNT(w, inject_pulls, 1);
+            SCHED_WCOUNT(w, tasks_completed, 1);
+            sched_work_done(s, 1);
+            sched_count_run(w, KC_LANE_INTERACTIVE);
+            continue;
+        }
+        /* Out of local work: submit the batch our coroutines queued. */
+        if (kc_uring_worker_poll(1) > 0) { idle_rounds = 0; continue; }
+        /* Then the guest runtime, if rung, before taking others' work; a
+         * forced turn now and then keeps its timers firing under load. */
+        if (sched_guest_poll(w, w->tick % 61 == 30 && atomic_load_explicit(&s->guest, memory_order_relaxed))) {
+            idle_rounds = 0;
+            continue;
+        }
+        if (sched_inbox_steal(w)) { idle_rounds = 0; continue; }
+        int found = sched_dl_steal(w) ||
+                    sched_steal(w, &w->rng, 0, w->nnear) ||
+                    sched_steal(w, &w->rng, w->nnear, w->nvictims);
+        if (!found && ring_pop(&s->bulk, &task)) {
+            sched_count_run(w, KC_LANE_BULK);
+            sched_run_task(w, &task);
+            found = 1;
+        } else if (found) {
+            sched_count_run(w, KC_LANE_INTERACTIVE);
+        }
+        if (found) {
+            idle_rounds = 0;
+            continue;
+        }
+        /* Every turn since the last idle one found work: a new idle stretch. */
+        if (idle_tick != w->tick - 1) idle_since = 0;
+        idle_tick = w->tick;
+        /* Spin-then-park: retry the whole scan a few times before sleeping. */
+        if (idle_rounds < atomic_load_explicit(&s->park_spin, memory_order_relaxed)) {
+            idle_rounds++;
+            for (int k = 0; k < 16; k++) kc_cpu_relax();
+            continue;
+        }
+        idle_rounds = 0;
+        uint64_t until = UINT64_MAX;
+        /* Elastic sizing; min_workers may change with a config reload. */
+        int minw = atomic_load_explicit(&s->min_workers, memory_order_relaxed);
+        if (minw < s->workers) {
+            uint64_t down_ns = atomic_load_explicit(&s->scale_down_ns, memory_order_relaxed);
+            uint64_t now = kc_now_ns();
+            if (!idle_since) idle_since = now;
+            if (now - idle_since >= down_ns && !kc_uring_worker_busy()) {
+                if (sched_try_retire(w)) goto retired;
+                idle_since = now;
+            }
+            if (atomic_load_explicit(&s->active, memory_order_relaxed) > minw)
+                until = idle_since + down_ns;
+        }
+        sched_park(w, until);
+    }
+    if (slot_take(&w->last_task, &task)) {
+        task.fn(task.arg);
+        SCHED_WCOUNT(w, fastpath_hits, 1);
+        SCHED_WCOUNT(w, tasks_completed, 1);
+        sched_work_done(s, 1);
+    }
+    /* Local ready coroutines are not resumed during shutdown; hand them to the
+     * global list, which kc_sched_shutdown tears down after the join. */
+    kcoro_t *rn = atomic_exchange_explicit(&w->runnext, NULL, memory_order_acq_rel);
+    if (rn) rq_push_global(s, rn);
+    for (kcoro_t *next; (rn = atomic_exchange(&w->inbox, NULL)) != NULL; )
+        for (; rn; rn = next) { next = rn->next; rn->next = NULL; rq_push_global(s, rn); }
+    while ((rn = sched_dl_take(s, w)) != NULL) rq_push_global(s, rn);
+    while (deque_pop_owner(&w->dq, &task)) {
+        if (task.fn == sched_resume_task) { rq_push_global(s, (kcoro_t*)task.arg); continue; }
+        task.fn(task.arg);
+        SCHED_WCOUNT(w, tasks_completed, 1);
+        sched_work_done(s, 1);
+    }
+retired:
+    kc_uring_worker_exit();
+    if (w->main_co) {
+        KC_SCHED_DEBUG("worker %d destroy main_co=%p", w->id, (void*)w->main_co);
+        kcoro_destroy(w->main_co);
+        w->main_co = NULL;
+    }
+    tls_current_sched = NULL;
+    tls_current_worker = NULL;
+    return NULL;
+}
+
+/* Poll worker idle step. On aarch64 an exclusive load of the inbox arms the
+ * event monitor, so WFE sleeps until a waker's CAS on it (or the kernel's
+ * periodic event stream, which bounds the timer delay); elsewhere a pause. */
+static inline void sched_poll_relax(sched_worker_t *w)
+{
+#if defined(__aarch64__)
+    uint64_t v;
+    __asm__ __volatile__("ldaxr %0, [%1]" : "=&r"(v) : "r"(&w->inbox) : "memory");
+    if (!v) __asm__ __volatile__("wfe" ::: "memory");
+#else
+    (void)w;
+    kc_cpu_relax();
+#endif
+}
+
+/* Busy-poll worker: fire its timers, refill the FIFO from its inbox, run the
+ * oldest entry; never parks, never steals, never touches shared queues. */
+static void* poll_main(void *arg){
+    sched_worker_t *w = (sched_worker_t*)arg;
+    struct kc_sched *s = w->sched;
+    tls_current_sched = s;
+    tls_current_worker = w;
+    /* The deque stays empty; kc_sched_help and kc_sched_local_depth read it. */
+    w->start_rc = deque_init(&w->dq, 16);
+    if (w->start_rc == 0 && !(w->main_co = kcoro_create_main())) w->start_rc = -1;
+    pthread_mutex_lock(&s->start_mu);
+    s->started++;
+    pthread_cond_signal(&s->start_cv);
+    pthread_mutex_unlock(&s->start_mu);
+    if (w->start_rc != 0) return NULL;
+    kcoro_set_thread_main(w->main_co);
+    kc_clock_coarse_worker();
+    kcoro_t *head = NULL, *tail = NULL;
+    uint64_t busy = 0;
+    atomic_store_explicit(&w->poll_t0, kc_now_ns(), memory_order_relaxed);
+    while (!atomic_load_explicit(&s->stop, memory_order_relaxed)) {
+        kc_clock_coarse_expire();
+        (void)sched_fire_timers(w);
+        (void)kc_uring_worker_poll(head == NULL);
+        kcoro_t *in = atomic_load_explicit(&w->inbox, memory_order_relaxed)
+                    ? atomic_exchange_explicit(&w->inbox, NULL, memory_order_acquire) : NULL;
+        if (in) {
+            /* Newest first: reverse onto the tail so the oldest runs first. */
+            kcoro_t *chain = NULL, *last = in;
+            while (in) { kcoro_t *next = in->next; in->next = chain; chain = in; in = next; }
+            if (tail) tail->next = chain; else head = chain;
+            tail = last;
+        }
+        if (!head) {
+            sched_owner_add(&w->poll_spins, 1);
+            sched_poll_relax(w);
+            continue;
+        }
+        kcoro_t *co = head;
+        head = co->next;
+        if (!head) tail = NULL;
+        co->next = NULL;
+        sched_count_run(w, KC_LANE_INTERACTIVE);
+        uint64_t t0 = kc_now_ns();
+        sched_run_co(w, co);
+        busy += kc_now_ns() - t0;
+        atomic_store_explicit(&w->poll_busy_ns, busy, memory_order_relaxed);
+    }
+    /* As worker_main: leftovers go to the global list for shutdown to free. */
+    for (kcoro_t *next; head; head = next) { next = head->next; head->next = NULL; rq_push_global(s, head); }
+    for (kcoro_t *rn, *next; (rn = atomic_exchange(&w->inbox, NULL)) != NULL; )
+        for (; rn; rn = next) { next = rn->next; rn->next = NULL; rq_push_global(s, rn); }
+    kc_uring_worker_exit();
+    kcoro_destroy(w->main_co);
+    w->main_co = NULL;
+    tls_current_sched = NULL;
+    tls_current_worker = NULL;
+    return NULL;
+}
+
+/* Start w's thread (its slot already marked on). The previous thread of a
+ * revived slot is joined first; it has finished with the slot once `on`
+ * dropped, and only has its exit left. */
+static int sched_start_thread(struct kc_sched *s, sched_worker_t *w)
+{
+    pthread_mutex_lock(&s->scale_mu);
+    if (s->scale_closed) { pthread_mutex_unlock(&s->scale_mu); return ECANCELED; }
+    if (w->joinable) { pthread_join(w->thr, NULL); w->joinable = 0; }
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+#ifdef __linux__
+    if (w->has_affinity) pthread_attr_setaffinity_np(&attr, sizeof(w->affinity), &w->affinity);
+#endif
+    int err = pthread_create(&w->thr, &attr, w->id < s->workers ? worker_main : poll_main, w);
+    pthread_attr_destroy(&attr);
+    if (!err) w->joinable = 1;
+    pthread_mutex_unlock(&s->scale_mu);
+    return err;
+}
+
+/* Give a dormant slot a thread (again). 1 if this call started it. */
+static int sched_revive_slot(struct kc_sched *s, sched_worker_t *w)
+{
+    int off = 0;
+    if (atomic_load(&s->stop) || !atomic_compare_exchange_strong(&w->on, &off, 1)) return 0;
+    atomic_fetch_add(&s->active, 1);
+    if (sched_start_thread(s, w) != 0) {
+        atomic_store(&w->on, 0);
+        atomic_fetch_sub(&s->active, 1);
+        return 0;
+    }
+    return 1;
+}
+
+static int sched_revive(struct kc_sched *s, sched_worker_t *w)
+{
+    if (!sched_revive_slot(s, w)) return 0;
+    atomic_fetch_add_explicit(&s->scale_ups, 1, memory_order_relaxed);
+    return 1;
+}
+
+/* ---- Worker placement ----
+ * kc_sched_opts_t.cpus / .placement are resolved once at init into a per-worker
+ * affinity mask (applied through the thread attributes, so the worker never
+ * runs elsewhere) and a NUMA node. Every worker also gets a steal order that
+ * lists same-node siblings before remote ones; without NUMA grouping all
+ * workers share node 0 and the order is a plain ring. */
+
+#ifdef __linux__
+/* NUMA node of a CPU, from the cpuN/nodeM link in sysfs; 0 when unknown. */
+static int sched_cpu_node(int cpu)
+{
+    char path[64];
+    snprintf(path, sizeof path, "/sys/devices/system/cpu/cpu%d", cpu);
+    DIR *d = opendir(path);
+    if (!d) return 0;
+    int node = 0;
+    struct dirent *e;
+    while ((e = readdir(d)) != NULL) {
+        if (strncmp(e->d_name, "node", 4) == 0 && e->d_name[4] >= '0' && e->d_name[4] <= '9') {
+            node = atoi(e->d_name + 4);
+            break;
+        }
+    }
+    closedir(d);
+    return node;
+}
+#endif
+
+/* CPUs workers may use, ascending and deduplicated, in a malloc'd *out.
+ * *nout stays 0 when opts asks for no placement. Returns 0 or an errno. */
+static int sched_place_cpus(const kc_sched_opts_t *opts, int **out, int *nout)
+{
+    *out = NULL;
+    *nout = 0;
+    if (!opts || (!opts->cpus && !opts->placement)) return 0;
+    if (opts->placement & ~(KC_SCHED_PLACE_PIN | KC_SCHED_PLACE_NUMA)) return EINVAL;
+    if (opts->cpus && opts->ncpus <= 0) return EINVAL;
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (opts->cpus) {
+        for (int i = 0; i < opts->ncpus; i++) {
+            if (opts->cpus[i] < 0 || opts->cpus[i] >= CPU_SETSIZE) return EINVAL;
+            CPU_SET(opts->cpus[i], &set);
+        }
+    } else if (sched_getaffinity(0, sizeof set, &set) != 0) {
+        return errno;
+    }
+    int n = CPU_COUNT(&set);
+    if (n <= 0) return EINVAL;
+    int *cpus = (int*)malloc((size_t)n * sizeof(int));
+    if (!cpus) return ENOMEM;
+    n = 0;
+    for (int c = 0; c < CPU_SETSIZE; c++)
+        if (CPU_ISSET(c, &set)) cpus[n++] = c;
+    *out = cpus;
+    *nout = n;
+    return 0;
+#else
+    return ENOTSUP;
+#endif
+}
+
+#ifdef __linux__
+/* Give every worker its affinity mask and node from the resolved CPU list. */
+static int sched_place_workers(struct kc_sched *s, const int *cpus, int ncpu, int flags)
+{
+    int *node_of = (int*)calloc((size_t)ncpu * 2, sizeof(int));
+    if (!node_of) return ENOMEM;
+    int *nodes = node_of + ncpu, nnodes = 0; /* distinct nodes, in CPU order */
+    for (int c = 0; c < ncpu; c++) {
+        if (flags & KC_SCHED_PLACE_NUMA) node_of[c] = sched_cpu_node(cpus[c]);
+        int seen = 0;
+        for (int k = 0; k < nnodes && !seen; k++) seen = (nodes[k] == node_of[c]);
+        if (!seen) nodes[nnodes++] = node_of[c];
+    }
+    for (int i = 0; i < s->workers; i++) {
+        sched_worker_t *w = &s->w[i];
+        CPU_ZERO(&w->affinity);
+        if (flags & KC_SCHED_PLACE_PIN) {
+            CPU_SET(cpus[i % ncpu], &w->affinity);
+            w->node = node_of[i % ncpu];
+        } else {
+            w->node = nodes[i % nnodes];
+            for (int c = 0; c < ncpu; c++)
+                if (node_of[c] == w->node) CPU_SET(cpus[c], &w->affinity);
+        }
+        w->has_affinity = 1;
+    }
+    free(node_of);
+    return 0;
+}
+#endif
+
+/* Steal order per worker: same-node siblings, then the rest, each group in
+ * ring order starting after the worker itself. */
+static int sched_build_victims(struct kc_sched *s)
+{
+    int n = s->workers;
+    if (n < 2) return 0;
+    s->victim_buf = (int*)malloc((size_t)n * (size_t)(n - 1) * sizeof(int));
+    if (!s->victim_buf) return ENOMEM;
+    for (int i = 0; i < n; i++) {
+        sched_worker_t *w = &s->w[i];
+        w->victims = s->victim_buf + (size_t)i * (size_t)(n - 1);
+        int k = 0;
+        for (int pass = 0; pass < 2; pass++) {
+            for (int d = 1; d < n; d++) {
+                int j = (i + d) % n;
+                if ((s->w[j].node == w->node) == (pass == 0)) w->victims[k++] = j;
+            }
+            if (pass == 0) w->nnear = k;
+        }
+        w->nvictims = k;
+    }
+    return 0;
+}
+
+int kc_sched_worker_node(kc_sched_t *s, int worker){
+    if (!s || worker < 0 || worker >= s->workers) return -1;
+    return s->w[worker].node;
+}
+
+/* ---- Stall watchdog (kc_sched_set_watchdog) ---- */
+
+#ifndef KC_SCHED_WATCHDOG_SIGNAL
+#define KC_SCHED_WATCHDOG_SIGNAL SIGURG
+#endif
+/* How long the monitor waits for a stalled worker's stack sample. */
+#ifndef KC_SCHED_WATCHDOG_SAMPLE_MS
+#define KC_SCHED_WATCHDOG_SAMPLE_MS 20
+#endif
+
+enum { WD_REQ_NONE, WD_REQ_ASKED, WD_REQ_TAKING, WD_REQ_DONE };
+
+/* Runs on the stalled worker. The sample is kept only if the run the
+ * monitor asked about is still the one interrupted. */
+static void sched_wd_handler(int sig, siginfo_t *si, void *ucv)
+{
+    (void)sig; (void)si;
+    int saved_errno = errno;
+    sched_worker_t *w = tls_current_worker;
+    int want = WD_REQ_ASKED;
+    if (w && atomic_compare_exchange_strong_explicit(&w->wd_req, &want, WD_REQ_TAKING,
+                                                     memory_order_acquire, memory_order_relaxed)) {
+        int in_co = 0;
+        w->wd_npc = 0;
+        if (atomic_load_explicit(&w->run_seq, memory_order_relaxed) == w->wd_seq)
+            w->wd_npc = kc_prof_walk(ucv, w->wd_pc, KC_STALL_DEPTH, &in_co);
+        atomic_store_explicit(&w->wd_req, WD_REQ_DONE, memory_order_release);
+    }
+    errno = saved_errno;
+}
+
+static int sched_wd_install(void)
+{
+    static pthread_mutex_t mu = PTHREAD_MUTEX_INITIALIZER;
+    static int installed;
+    int rc = 0;
+    pthread_mutex_lock(&mu);
+    if (!installed) {
+        struct sigaction sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_sigaction = sched_wd_handler;
+        sa.sa_flags = SA_SIGINFO | SA_RESTART;
+        sigemptyset(&sa.sa_mask);
+        if (sigaction(KC_SCHED_WATCHDOG_SIGNAL, &sa, NULL) != 0) rc = -errno;
+        else installed = 1;
+    }
+    pthread_mutex_unlock(&mu);
+    return rc;
+}
 
-/* Ready queue helpers */
-static void rq_push_locked(struct kc_sched *s, kcoro_t *co)
+/* Ask worker w, still in run q, for a frame walk; 0 frames on timeout. */
+static int sched_wd_sample(sched_worker_t *w, uint32_t q, uintptr_t *pc)
 {
-    if (!co) return;
-    if (co->ready_enqueued) {
-        KC_SCHED_DEBUG("skip enqueue co=%p (already enqueued)", (void*)co);
-        return;
+    w->wd_seq = q;
+    atomic_store_explicit(&w->wd_req, WD_REQ_ASKED, memory_order_release);
+    if (pthread_kill(w->thr, KC_SCHED_WATCHDOG_SIGNAL) != 0) {
+        atomic_store_explicit(&w->wd_req, WD_REQ_NONE, memory_order_relaxed);
+        return 0;
     }
-    if (co->next) {
-        KC_SCHED_DEBUG("enqueue co=%p while next=%p -- clearing", (void*)co, (void*)co->next);
+    int n = 0;
+    struct timespec tick = { 0, 100000 };
+    for (int i = 0; i < KC_SCHED_WATCHDOG_SAMPLE_MS * 10; i++) {
+        int st = atomic_load_explicit(&w->wd_req, memory_order_acquire);
+        if (st == WD_REQ_DONE) {
+            n = w->wd_npc;
+            memcpy(pc, w->wd_pc, (size_t)n * sizeof(*pc));
+            break;
+        }
+        nanosleep(&tick, NULL);
     }
-    co->next = NULL;
-    kcoro_t *tail = s->rq_tail;
-    KC_SCHED_DEBUG("push co=%p prev_tail=%p head=%p", (void*)co, (void*)tail, (void*)s->rq_head);
-    if (tail) tail->next = co; else s->rq_head = co;
-    s->rq_tail = co;
-    co->ready_enqueued = true;
+    /* A handler still running gets to finish; a late one finds no request */
+    int want = WD_REQ_ASKED;
+    if (!atomic_compare_exchange_strong_explicit(&w->wd_req, &want, WD_REQ_NONE,
+                                                 memory_order_relaxed, memory_order_relaxed)) {
+        while (atomic_load_explicit(&w->wd_req, memory_order_acquire) == WD_REQ_TAKING)
+            nanosleep(&tick, NULL);
+        atomic_store_explicit(&w->wd_req, WD_REQ_NONE, memory_order_relaxed);
+    }
+    return n;
 }
 
-static kcoro_t* rq_pop_locked(struct kc_sched *s)
+static void sched_wd_log(const kc_sched_stall_t *st)
 {
-    kcoro_t *co = s->rq_head;
-    if (co) {
-        kcoro_t *next = co->next;
-        KC_SCHED_DEBUG("pop co=%p next=%p head=%p tail=%p", (void*)co, (void*)next, (void*)s->rq_head, (void*)s->rq_tail);
-        s->rq_head = next;
-        if (!s->rq_head) s->rq_tail = NULL;
-        co->next = NULL;
-        co->ready_enqueued = false;
+    if (st->kind == KC_STALL_RUN)
+        fprintf(stderr, "kcoro: watchdog: worker %d: coroutine %llu%s%s%s running for %llu ms (%lu queued)\n",
+                st->worker, (unsigned long long)st->co_id, st->co_name[0] ? " (" : "", st->co_name,
+                st->co_name[0] ? ")" : "", st->stalled_ns / 1000000ull, st->queued);
+    else
+        fprintf(stderr, "kcoro: watchdog: %s %d: %lu ready, none started for %llu ms\n",
+                st->worker < 0 ? "shared queues" : "worker", st->worker, st->queued,
+                st->stalled_ns / 1000000ull);
+    for (int i = 0; i < st->npc; i++) {
+        Dl_info di;
+        if (dladdr((void*)st->pc[i], &di) && di.dli_sname)
+            fprintf(stderr, "    #%d %p %s+0x%lx\n", i, (void*)st->pc[i], di.dli_sname,
+                    (unsigned long)(st->pc[i] - (uintptr_t)di.dli_saddr));
+        else
+            fprintf(stderr, "    #%d %p\n", i, (void*)st->pc[i]);
     }
-    return co;
 }
 
-/* Inject queue */
-static int inject_init(struct kc_sched *s, uint32_t cap){ if(cap==0) cap=2048; s->inject_buf=(sched_task_t*)calloc(cap,sizeof(sched_task_t)); if(!s->inject_buf) return -1; s->inject_cap=cap; s->inject_head=s->inject_tail=0; pthread_mutex_init(&s->inject_mu,NULL); return 0; }
-static void inject_destroy(struct kc_sched *s){ if(s->inject_buf) free(s->inject_buf); pthread_mutex_destroy(&s->inject_mu);} 
-static int inject_push(struct kc_sched *s, sched_task_fn fn, void *arg){ pthread_mutex_lock(&s->inject_mu); uint32_t next=(s->inject_tail+1)%s->inject_cap; if(next==s->inject_head){ uint32_t ncap=s->inject_cap*2; sched_task_t *nbuf=(sched_task_t*)calloc(ncap,sizeof(sched_task_t)); if(!nbuf){ pthread_mutex_unlock(&s->inject_mu); return -1;} uint32_t i=0,h=s->inject_head; while(h!=s->inject_tail){ nbuf[i++]=s->inject_buf[h]; h=(h+1)%s->inject_cap;} s->inject_head=0; s->inject_tail=i; free(s->inject_buf); s->inject_buf=nbuf; s->inject_cap=ncap; next=(s->inject_tail+1)%s->inject_cap;} s->inject_buf[s->inject_tail].fn=fn; s->inject_buf[s->inject_tail].arg=arg; s->inject_tail=next; pthread_mutex_unlock(&s->inject_mu); return 0; }
-static int inject_pop(struct kc_sched *s, sched_task_t *out){ pthread_mutex_lock(&s->inject_mu); if(s->inject_head==s->inject_tail){ pthread_mutex_unlock(&s->inject_mu); return 0;} *out=s->inject_buf[s->inject_head]; s->inject_head=(s->inject_head+1)%s->inject_cap; pthread_mutex_unlock(&s->inject_mu); return 1; }
+static void sched_wd_report(struct kc_sched *s, kc_sched_stall_t *st)
+{
+    atomic_fetch_add_explicit(st->kind == KC_STALL_RUN ? &s->stalls_run : &s->stalls_queue, 1,
+                              memory_order_relaxed);
+    pthread_mutex_lock(&s->wd_mu);
+    kc_sched_stall_fn fn = s->wd_fn;
+    void *arg = s->wd_arg;
+    pthread_mutex_unlock(&s->wd_mu);
+    if (fn) fn(st, arg);
+    else sched_wd_log(st);
+}
 
-/* PRNG */
-static inline uint32_t ws_rand(uint32_t *state){ uint32_t x=*state; x^=x<<13; x^=x>>17; x^=x<<5; return *state = x?x:0x12345678u; }
+static unsigned long sched_wd_queued(sched_worker_t *w)
+{
+    return deque_len(&w->dq) + (atomic_load_explicit(&w->runnext, memory_order_relaxed) != NULL) +
+           (atomic_load_explicit(&w->inbox, memory_order_relaxed) != NULL) +
+           (atomic_load_explicit(&w->last_task.state, memory_order_relaxed) == KC_SLOT_FULL) +
+           (atomic_load_explicit(&w->dl_min, memory_order_relaxed) != 0);
+}
 
-#ifndef KC_SCHED_STEAL_SCAN_MAX
-#define KC_SCHED_STEAL_SCAN_MAX 4
-#endif
+/* Worker i has been in run q for ran ns. The run must still be going once
+ * its id and name are copied, or they may belong to the next one. */
+static void sched_wd_run(struct kc_sched *s, int i, uint32_t q, uint64_t ran)
+{
+    sched_worker_t *w = &s->w[i];
+    kc_sched_stall_t st;
+    memset(&st, 0, sizeof(st));
+    st.kind = KC_STALL_RUN;
+    st.worker = i;
+    st.stalled_ns = ran;
+    st.co_id = atomic_load_explicit(&w->run_id, memory_order_relaxed);
+    const char *name = atomic_load_explicit(&w->run_name, memory_order_relaxed);
+    for (size_t k = 0; name && k < sizeof(st.co_name) - 1 && name[k]; k++) st.co_name[k] = name[k];
+    if (atomic_load_explicit(&w->run_seq, memory_order_acquire) != q) return;
+    st.queued = sched_wd_queued(w);
+    if (atomic_load_explicit(&s->wd_flags, memory_order_relaxed) & KC_SCHED_WATCHDOG_STACK)
+        st.npc = sched_wd_sample(w, q, st.pc);
+    sched_wd_report(s, &st);
+}
 
-static void* worker_main(void *arg){
-    sched_worker_t *w = (sched_worker_t*)arg;
-    struct kc_sched *s = w->sched;
-    tls_current_sched = s;
-    w->main_co = kcoro_create_main();
-    if (!w->main_co) {
-        KC_SCHED_DEBUG("worker %d failed to create main coroutine", w->id);
-        return NULL;
+/* Queue watch for one slot (worker i, or the shared queues at
+ * KC_SCHED_MAX_WORKERS): an incident once queued work has sat for wd ns
+ * while run stayed put. */
+typedef struct sched_wd_queue { unsigned long run; uint64_t since; int reported; } sched_wd_queue_t;
+
+static void sched_wd_queue(struct kc_sched *s, sched_wd_queue_t *qs, int worker, unsigned long run,
+                           unsigned long queued, uint64_t now, uint64_t wd)
+{
+    if (run != qs->run || !queued || !qs->since) {
+        qs->run = run;
+        qs->since = now;
+        qs->reported = 0;
+        return;
     }
-    kcoro_set_thread_main(w->main_co);
-    sched_task_t task;
-    uint32_t rng = (uint32_t)((intptr_t)w ^ 0x9e3779b9u);
+    if (qs->reported || now - qs->since < wd) return;
+    qs->reported = 1;
+    kc_sched_stall_t st;
+    memset(&st, 0, sizeof(st));
+    st.kind = KC_STALL_QUEUE;
+    st.worker = worker;
+    st.stalled_ns = now - qs->since;
+    st.queued = queued;
+    sched_wd_report(s, &st);
+}
+
+/* Slice monitor: one thread per scheduler, started the first time a slice
+ * budget or a watchdog is set. Every half slice or half stall_ms, whichever
+ * is shorter (KC_SCHED_MONITOR_MIN_US at least), it samples each worker's
+ * run_seq; a coroutine run seen on two samples spanning slice_ns gets its
+ * worker's preempt flag, which kc_yield_if_needed and the channel ops act
+ * on, and one spanning stall_ms is reported once to the watchdog. It never
+ * touches the coroutine itself, which may be gone by the time it looks. */
+static void *sched_monitor_main(void *arg)
+{
+    struct kc_sched *s = (struct kc_sched*)arg;
+    uint32_t seen[KC_SCHED_MAX_WORKERS], reported[KC_SCHED_MAX_WORKERS];
+    uint64_t since[KC_SCHED_MAX_WORKERS];
+    sched_wd_queue_t qs[KC_SCHED_MAX_WORKERS + 1];
+    memset(seen, 0, sizeof(seen));
+    memset(reported, 0, sizeof(reported));
+    memset(qs, 0, sizeof(qs));
     while (!atomic_load(&s->stop)) {
-    sched_task_t *slot = atomic_exchange_explicit(&w->last_task, NULL, memory_order_acq_rel);
-        if (slot) {
-            slot->fn(slot->arg);
-            free(slot);
-            atomic_fetch_add(&s->fastpath_hits, 1);
-            atomic_fetch_add(&s->tasks_completed, 1);
-            continue;
-        }
-        if (deque_pop_owner(&w->dq, &task)) {
-            task.fn(task.arg);
-            atomic_fetch_add(&s->tasks_completed, 1);
-            continue;
-        }
-        pthread_mutex_lock(&s->rq_mu);
-        kcoro_t *co = rq_pop_locked(s);
-        pthread_mutex_unlock(&s->rq_mu);
-        if (co) {
-            KC_SCHED_DEBUG("worker %d resume co=%p state=%d tail=%p head=%p", w->id, (void*)co, co->state, (void*)s->rq_tail, (void*)s->rq_head);
-            int expected = 0;
-            if (!atomic_compare_exchange_strong_explicit(&co->running_flag, &expected, 1,
-                                                         memory_order_acq_rel, memory_order_relaxed)) {
-                pthread_mutex_lock(&s->rq_mu);
-                kcoro_retain(co);
-                rq_push_locked(s, co);
-                pthread_mutex_unlock(&s->rq_mu);
-                kcoro_release(co);
+        uint64_t slice = atomic_load_explicit(&s->slice_ns, memory_order_relaxed);
+        uint64_t wd = atomic_load_explicit(&s->wd_ns, memory_order_relaxed);
+        uint64_t period = slice ? slice / 2 : KC_SCHED_MONITOR_IDLE_MS * 1000000ull;
+        if (wd && wd / 2 < period) period = wd / 2;
+        if (period < KC_SCHED_MONITOR_MIN_US * 1000ull) period = KC_SCHED_MONITOR_MIN_US * 1000ull;
+        struct timespec ts = { (time_t)(period / 1000000000ull), (long)(period % 1000000000ull) };
+        nanosleep(&ts, NULL);
+        if (!slice && !wd) continue;
+        uint64_t now = kc_now_ns();
+        unsigned long run_all = 0;
+        for (int i = 0; i < s->workers; i++) {
+            sched_worker_t *w = &s->w[i];
+            uint32_t q = atomic_load_explicit(&w->run_seq, memory_order_acquire);
+            if (wd) {
+                unsigned long run = 0;
+                for (int l = 0; l < KC_LANE_COUNT; l++)
+                    run += atomic_load_explicit(&w->lane_run[l], memory_order_relaxed);
+                run_all += run;
+                /* A coroutine run is watched as a run; a dormant slot not at all */
+                int watch = !(q & 1) && atomic_load_explicit(&w->on, memory_order_relaxed);
+                sched_wd_queue(s, &qs[i], i, run, watch ? sched_wd_queued(w) : 0, now, wd);
+            }
+            if (!(q & 1)) { seen[i] = q; continue; }
+            if (q != seen[i]) {
+                seen[i] = q;
+                since[i] = now;
+                atomic_store_explicit(&w->run_since, now, memory_order_relaxed);
                 continue;
             }
-
-            co->main_co = w->main_co;
-            kcoro_set_thread_main(w->main_co);
-            co->scheduler = (kcoro_sched_t*)s;
-            kcoro_resume(co);
-            if (co->state == KCORO_READY || co->state == KCORO_SUSPENDED) {
-                kcoro_retain(co);
-                pthread_mutex_lock(&s->rq_mu);
-                rq_push_locked(s, co);
-                pthread_mutex_unlock(&s->rq_mu);
-                atomic_store_explicit(&co->running_flag, 0, memory_order_release);
-                kcoro_release(co);
-            } else if (co->state == KCORO_FINISHED) {
-                atomic_store_explicit(&co->running_flag, 0, memory_order_release);
-                kcoro_release(co);
-            } else {
-                atomic_store_explicit(&co->running_flag, 0, memory_order_release);
-                kcoro_release(co);
+            if (slice && now - since[i] >= slice && !atomic_load_explicit(&w->preempt, memory_order_relaxed)) {
+                atomic_store_explicit(&w->preempt, 1, memory_order_relaxed);
+                atomic_fetch_add_explicit(&s->preempt_flags, 1, memory_order_relaxed);
             }
-            continue;
-        }
-        if (inject_pop(s, &task)) {
-            task.fn(task.arg);
-            atomic_fetch_add(&s->inject_pulls, 1);
-            atomic_fetch_add(&s->tasks_completed, 1);
-            continue;
-        }
-        int found = 0;
-        for (int attempt = 0; attempt < KC_SCHED_STEAL_SCAN_MAX; ++attempt) {
-            uint32_t r32 = ws_rand(&rng);
-            int victim = (w->id + 1 + (int)(r32 % (uint32_t)(s->workers - 1))) % s->workers;
-            if (victim == w->id) continue;
-            kc_deque_t *vd = &s->w[victim].dq;
-            if (atomic_load_explicit(&vd->len, memory_order_relaxed) == 0) continue;
-            atomic_fetch_add(&s->steals_probes, 1);
-            sched_task_t stolen;
-            if (deque_steal(vd, &stolen)) {
-                atomic_fetch_add(&s->steals_succeeded, 1);
-                stolen.fn(stolen.arg);
-                atomic_fetch_add(&s->tasks_completed, 1);
-                found = 1;
-                break;
-            } else {
-                atomic_fetch_add(&s->steals_failures, 1);
+            if (wd && now - since[i] >= wd && reported[i] != q) {
+                reported[i] = q;
+                sched_wd_run(s, i, q, now - since[i]);
             }
         }
-        if (found) {
-            continue;
-        }
-        atomic_fetch_add(&s->idle_workers, 1);
-        pthread_mutex_lock(&s->park_mu);
-        struct timespec ts;
-        clock_gettime(CLOCK_REALTIME, &ts);
-        ts.tv_nsec += 5 * 1000 * 1000;
-        if (ts.tv_nsec >= 1000000000L) { ts.tv_sec++; ts.tv_nsec -= 1000000000L; }
-        if (!atomic_load(&s->stop)) pthread_cond_timedwait(&s->park_cv, &s->park_mu, &ts);
-        pthread_mutex_unlock(&s->park_mu);
-        atomic_fetch_sub(&s->idle_workers, 1);
-    }
-    sched_task_t *slot_rem = atomic_exchange_explicit(&w->last_task, NULL, memory_order_acq_rel);
-    if (slot_rem) {
-        slot_rem->fn(slot_rem->arg);
-        free(slot_rem);
-        atomic_fetch_add(&s->fastpath_hits, 1);
-        atomic_fetch_add(&s->tasks_completed, 1);
-    }
-    while (deque_pop_owner(&w->dq, &task)) {
-        task.fn(task.arg);
-        atomic_fetch_add(&s->tasks_completed, 1);
+        if (wd)
+            sched_wd_queue(s, &qs[KC_SCHED_MAX_WORKERS], -1, run_all,
+                           ring_len(&s->inject) + ring_len(&s->bulk), now, wd);
     }
-    if (w->main_co) {
-        KC_SCHED_DEBUG("worker %d destroy main_co=%p", w->id, (void*)w->main_co);
-        kcoro_destroy(w->main_co);
-        w->main_co = NULL;
-    }
-    tls_current_sched = NULL;
     return NULL;
 }
 
-/* ---- Timer implementation ---- */
+/* Start the monitor thread once; 0 or an errno. */
+static int sched_monitor_start(struct kc_sched *s)
+{
+    int err = 0;
+    pthread_mutex_lock(&s->scale_mu);
+    if (s->scale_closed) err = ECANCELED;
+    else if (!s->mon_started && (err = pthread_create(&s->mon_thr, NULL, sched_monitor_main, s)) == 0)
+        s->mon_started = 1;
+    pthread_mutex_unlock(&s->scale_mu);
+    return err;
+}
 
-static void* kc_timer_main(void *arg)
+int kc_sched_set_watchdog(kc_sched_t *s, unsigned stall_ms, unsigned flags,
+                          kc_sched_stall_fn fn, void *arg)
 {
-    struct kc_sched *s = (struct kc_sched*)arg;
-    for (;;) {
-        pthread_mutex_lock(&s->timer_mu);
-        // Wait until there is at least one timer or stop requested
-        while (!s->timer_head && !atomic_load(&s->stop)) {
-            pthread_cond_wait(&s->timer_cv, &s->timer_mu);
-        }
-        if (atomic_load(&s->stop)) {
-            pthread_mutex_unlock(&s->timer_mu);
-            break;
-        }
-        // Drop canceled items at head to maintain accurate earliest deadline
-        while (s->timer_head && s->timer_head->cancelled) {
-            kc_timer_item_t* del = s->timer_head; s->timer_head = del->next; free(del);
-        }
-        uint64_t now = kc_now_ns();
-        uint64_t when = s->timer_head ? s->timer_head->when_ns : now + 1000000000ull;
-        if (s->timer_head && s->timer_head->when_ns > now) {
-            // Sleep until the earliest deadline or stop
-            struct timespec ts;
-            uint64_t delta_ns = when - now;
-            clock_gettime(CLOCK_REALTIME, &ts);
-            // convert delta_ns to absolute timespec on CLOCK_REALTIME for timedwait
-            ts.tv_sec += (time_t)(delta_ns / 1000000000ull);
-            long add_ns = (long)(delta_ns % 1000000000ull);
-            ts.tv_nsec += add_ns;
-            if (ts.tv_nsec >= 1000000000L) { ts.tv_sec++; ts.tv_nsec -= 1000000000L; }
-            pthread_cond_timedwait(&s->timer_cv, &s->timer_mu, &ts);
-            pthread_mutex_unlock(&s->timer_mu);
-            continue;
-        }
-        // Pop all due timers (skip canceled)
-        kc_timer_item_t *due_head = NULL, *due_tail = NULL;
-        now = kc_now_ns();
-        while (s->timer_head && s->timer_head->when_ns <= now) {
-            kc_timer_item_t* it = s->timer_head;
-            s->timer_head = it->next;
-            if (!it->cancelled) {
-                it->next = NULL;
-                if (!due_head) due_head = it; else due_tail->next = it;
-                due_tail = it;
-            } else {
-                free(it);
-            }
-        }
-        pthread_mutex_unlock(&s->timer_mu);
-        // Enqueue ready outside timer lock
-        while (due_head) {
-            kc_timer_item_t* it = due_head; due_head = it->next;
-            if (it->co) kc_sched_enqueue_ready(s, it->co);
-            free(it);
-        }
+    if (!s || (flags & ~KC_SCHED_WATCHDOG_STACK)) return -EINVAL;
+    if (stall_ms && (flags & KC_SCHED_WATCHDOG_STACK)) {
+        int rc = sched_wd_install();
+        if (rc) return rc;
     }
-    return NULL;
+    pthread_mutex_lock(&s->wd_mu);
+    s->wd_fn = fn;
+    s->wd_arg = arg;
+    pthread_mutex_unlock(&s->wd_mu);
+    atomic_store_explicit(&s->wd_flags, flags, memory_order_relaxed);
+    atomic_store_explicit(&s->wd_ns, (uint64_t)stall_ms * 1000000ull, memory_order_relaxed);
+    if (!stall_ms) return 0;
+    int err = sched_monitor_start(s);
+    return err ? -err : 0;
 }
 
-static void kc_timer_ensure_started(struct kc_sched *s)
+/* Knobs kc_sched_opts_t left at 0 (not in s->pinned) take cfg's value, or
+ * the build default; used by kc_sched_init and on every config reload.
+ * Workers read each knob with a relaxed load where it applies, so a change
+ * shows up at the next steal, idle round or growth check. */
+static void sched_tune(struct kc_sched *s, const struct kc_runtime_config *cfg)
 {
-    int started = atomic_load(&s->timer_started);
-    if (started) return;
-    pthread_mutex_lock(&s->park_mu); // reuse park_mu to serialize start once
-    if (!atomic_load(&s->timer_started)) {
-        pthread_mutex_init(&s->timer_mu, NULL);
-        pthread_cond_init(&s->timer_cv, NULL);
-        s->timer_head = NULL;
-        if (pthread_create(&s->timer_thr, NULL, kc_timer_main, s) == 0) {
-            atomic_store(&s->timer_started, 1);
-        }
+    unsigned pin = s->pinned;
+    if (!(pin & SCHED_PIN_MIN)) {
+        int v = cfg->sched_min_workers;
+        atomic_store_explicit(&s->min_workers, v <= 0 || v > s->base_workers ? s->base_workers : v,
+                              memory_order_relaxed);
+    }
+    if (!(pin & SCHED_PIN_MAX)) {
+        int v = cfg->sched_max_workers;
+        if (v <= 0 || v > s->workers) v = s->workers;
+        if (v < s->base_workers) v = s->base_workers;
+        atomic_store_explicit(&s->max_active, v, memory_order_relaxed);
+    }
+    if (!(pin & SCHED_PIN_BACKLOG))
+        atomic_store_explicit(&s->scale_up_backlog, (uint32_t)(cfg->sched_scale_up_backlog > 0 ?
+                              cfg->sched_scale_up_backlog : KC_SCHED_SCALE_UP_BACKLOG_DEFAULT), memory_order_relaxed);
+    if (!(pin & SCHED_PIN_UP))
+        atomic_store_explicit(&s->scale_up_ns, (uint64_t)(cfg->sched_scale_up_ms > 0 ?
+                              cfg->sched_scale_up_ms : KC_SCHED_SCALE_UP_MS_DEFAULT) * 1000000ull, memory_order_relaxed);
+    if (!(pin & SCHED_PIN_DOWN))
+        atomic_store_explicit(&s->scale_down_ns, (uint64_t)(cfg->sched_scale_down_ms > 0 ?
+                              cfg->sched_scale_down_ms : KC_SCHED_SCALE_DOWN_MS_DEFAULT) * 1000000ull, memory_order_relaxed);
+    if (!(pin & SCHED_PIN_SPIN))
+        atomic_store_explicit(&s->park_spin, cfg->sched_park_spin > 0 ? cfg->sched_park_spin : KC_SCHED_PARK_SPIN_DEFAULT,
+                              memory_order_relaxed);
+    if (!(pin & SCHED_PIN_BULK))
+        atomic_store_explicit(&s->bulk_share, (uint32_t)(cfg->sched_bulk_share > 0 ?
+                              cfg->sched_bulk_share : KC_SCHED_BULK_SHARE_DEFAULT), memory_order_relaxed);
+    if (!(pin & SCHED_PIN_SLICE))
+        atomic_store_explicit(&s->slice_ns, (uint64_t)(cfg->sched_slice_us > 0 ? cfg->sched_slice_us : 0) * 1000ull,
+                              memory_order_relaxed);
+    if (!(pin & SCHED_PIN_STEAL)) {
+        int v = cfg->sched_steal_scan > 0 ? cfg->sched_steal_scan : KC_SCHED_STEAL_SCAN_MAX;
+        atomic_store_explicit(&s->steal_scan, v > KC_SCHED_MAX_WORKERS ? KC_SCHED_MAX_WORKERS : v,
+                              memory_order_relaxed);
     }
-    pthread_mutex_unlock(&s->park_mu);
+}
+
+/* kc_runtime_config_watch callback: re-tune, then wake running workers so
+ * those parked without a deadline re-evaluate retirement. */
+static void sched_config_changed(void *arg, const struct kc_runtime_config *cfg)
+{
+    struct kc_sched *s = (struct kc_sched*)arg;
+    sched_tune(s, cfg);
+    if (atomic_load_explicit(&s->slice_ns, memory_order_relaxed)) (void)sched_monitor_start(s);
+    for (int i = 0; i < s->workers; i++)
+        if (atomic_load(&s->w[i].on)) parker_unpark(&s->w[i].park);
 }
 
 /* ---- Public Creation / Shutdown (legacy names preserved) ---- */
 
 kc_sched_t* kc_sched_init(const kc_sched_opts_t *opts){
-    struct kc_sched *s=(struct kc_sched*)calloc(1,sizeof(*s));
-    if(!s) return NULL;
-    int ncpu=kc_get_nprocs();
+    if (opts && (opts->startup < KC_SCHED_START_EAGER || opts->startup > KC_SCHED_START_WARM)) { errno = EINVAL; return NULL; }
+    int *cpus = NULL, ncpu_set = 0;
+    int err = sched_place_cpus(opts, &cpus, &ncpu_set);
+    if (err) { errno = err; return NULL; }
+    /* Aligned: the worker counter blocks and queue heads are cache-line padded. */
+    struct kc_sched *s=(struct kc_sched*)aligned_alloc(64, (sizeof(*s)+63)&~(size_t)63);
+    if(!s){ free(cpus); return NULL; }
+    memset(s,0,sizeof(*s));
+    s->cpu_auto=!(opts && opts->workers>0) && ncpu_set==0;
+    int ncpu=ncpu_set>0? ncpu_set : kc_cpu_budget();
+    if(s->cpu_auto){ s->cpu_budget=ncpu; s->cpu_checked_ns=kc_now_ns(); }
     int n=(opts && opts->workers>0)? opts->workers : (ncpu>0?ncpu:1);
-    if(n<1) n=1; if(n>256) n=256; s->workers=n;
-    pthread_mutex_init(&s->park_mu,NULL);
-    pthread_cond_init(&s->park_cv,NULL);
-    pthread_mutex_init(&s->rq_mu,NULL);
-    /* Initialize timer subsystem state explicitly */
-    atomic_store(&s->timer_started, 0);
-    atomic_store(&s->next_timer_id, 0);
-    s->timer_head = NULL;
-    s->timer_thr = (pthread_t)0;
+    if(n<1) n=1;
+    if(n>KC_SCHED_MAX_WORKERS) n=KC_SCHED_MAX_WORKERS;
+    /* Elastic sizing: opts first, then the runtime config; both unset keep
+     * exactly n workers. Slots past n start dormant; a reload can move the
+     * bounds within them but not add slots. */
+    struct kc_runtime_config cfg;
+    kc_runtime_config_snapshot(&cfg);
+    int maxw=(opts && opts->max_workers>0)? opts->max_workers : cfg.sched_max_workers;
+    if(maxw<n) maxw=n;
+    if(maxw>KC_SCHED_MAX_WORKERS) maxw=KC_SCHED_MAX_WORKERS;
+    s->workers=maxw;
+    s->base_workers=n;
+    /* Poll workers: slots after the general ones, each timer wheel numbered
+     * by its slot, so both together stay within KC_SCHED_MAX_WORKERS. */
+    int npoll=(opts && opts->poll_workers>0)? opts->poll_workers : 0;
+    if(npoll>KC_SCHED_MAX_WORKERS-maxw || (npoll && opts->poll_cpus && opts->npoll_cpus<=0)){ free(cpus); free(s); errno=EINVAL; return NULL; }
+#ifndef __linux__
+    if(npoll && opts->poll_cpus){ free(cpus); free(s); errno=ENOTSUP; return NULL; }
+#endif
+    s->npoll=npoll;
+    if(opts && opts->startup==KC_SCHED_START_LAZY) atomic_store(&s->lazy_left,n);
+    s->warm=opts && opts->startup==KC_SCHED_START_WARM;
+    if(opts){
+        if(opts->min_workers>0){ s->pinned|=SCHED_PIN_MIN; s->min_workers=opts->min_workers>n? n : opts->min_workers; }
+        if(opts->max_workers>0){ s->pinned|=SCHED_PIN_MAX; s->max_active=maxw; }
+        if(opts->scale_up_backlog>0){ s->pinned|=SCHED_PIN_BACKLOG; s->scale_up_backlog=(uint32_t)opts->scale_up_backlog; }
+        if(opts->scale_up_ms>0){ s->pinned|=SCHED_PIN_UP; s->scale_up_ns=(uint64_t)opts->scale_up_ms*1000000ull; }
+        if(opts->scale_down_ms>0){ s->pinned|=SCHED_PIN_DOWN; s->scale_down_ns=(uint64_t)opts->scale_down_ms*1000000ull; }
+        if(opts->park_spin!=0){ s->pinned|=SCHED_PIN_SPIN; s->park_spin=opts->park_spin<0? 0 : opts->park_spin; }
+        if(opts->bulk_share>0){ s->pinned|=SCHED_PIN_BULK; s->bulk_share=(uint32_t)opts->bulk_share; }
+        if(opts->steal_scan>0){ s->pinned|=SCHED_PIN_STEAL; s->steal_scan=opts->steal_scan; }
+        if(opts->slice_us!=0){ s->pinned|=SCHED_PIN_SLICE; s->slice_ns=opts->slice_us<0? 0 : (uint64_t)opts->slice_us*1000ull; }
+    }
+    sched_tune(s,&cfg);
+    /* Lazy: the shared rings start small and grow with use. */
+    uint32_t ring_cap=atomic_load(&s->lazy_left)? KC_SCHED_LAZY_RING_CAP : 0;
+    if(ring_init(&s->inject,((opts && opts->inject_q_cap>0)? (uint32_t)opts->inject_q_cap : ring_cap))!=0){ free(cpus); free(s); return NULL; }
+    if(ring_init(&s->bulk,ring_cap)!=0){ ring_destroy(&s->inject); free(cpus); free(s); return NULL; }
+    if(s->warm){
+        sched_prefault(s->inject.buf,(size_t)s->inject.cap*sizeof(sched_task_t));
+        sched_prefault(s->bulk.buf,(size_t)s->bulk.cap*sizeof(sched_task_t));
+    }
+    KC_MUTEX_INIT(&s->rq_mu);
+    KC_MUTEX_INIT(&s->drain_mu);
+    KC_COND_INIT(&s->drain_cv);
+    pthread_mutex_init(&s->start_mu,NULL);
+    pthread_cond_init(&s->start_cv,NULL);
+    pthread_mutex_init(&s->scale_mu,NULL);
+    pthread_mutex_init(&s->wd_mu,NULL);
     /* Ready queue init */
     s->rq_head = NULL; s->rq_tail = NULL;
     /* Workers */
-    s->w=(sched_worker_t*)calloc((size_t)n,sizeof(sched_worker_t));
-    if(!s->w){ free(s); return NULL; }
-    for(int i=0;i<n;i++){
+    int nslots=s->workers+s->npoll;
+    s->w=(sched_worker_t*)aligned_alloc(64,(size_t)nslots*sizeof(sched_worker_t));
+    if(s->w) memset(s->w,0,(size_t)nslots*sizeof(sched_worker_t));
+    if(!s->w){ ring_destroy(&s->bulk); ring_destroy(&s->inject); free(cpus); free(s); return NULL; }
+#ifdef __linux__
+    if(ncpu_set>0) err=sched_place_workers(s,cpus,ncpu_set,opts->placement);
+#endif
+    free(cpus);
+    if(!err) err=sched_build_victims(s);
+    uint64_t now=kc_now_ns();
+    for(int i=0;i<nslots;i++){
+        sched_worker_t *w=&s->w[i];
+        w->id=i; w->sched=s; w->poll_cpu=-1; atomic_store(&w->last_task.state,KC_SLOT_EMPTY); atomic_store(&w->runnext,NULL);
+        parker_init(&w->park);
+        KC_MUTEX_INIT(&w->dl_mu);
+        if(kc_timer_wheel_init(&w->wheel,(uint32_t)i,now)!=0){}
+    }
+    int created=0;
+    for(int i=0;i<n && !err && !atomic_load(&s->lazy_left);i++){
         sched_worker_t *w=&s->w[i];
-        w->id=i; w->sched=s; atomic_store(&w->last_task,NULL);
-        if(deque_init(&w->dq,256)!=0){}
-        if(pthread_create(&w->thr,NULL,worker_main,w)!=0){}
+        atomic_store(&w->on,1);
+        atomic_fetch_add(&s->active,1);
+        err=sched_start_thread(s,w);
+        if(!err) created++;
+        else { atomic_store(&w->on,0); atomic_fetch_sub(&s->active,1); }
+    }
+    for(int i=0;i<s->npoll && !err;i++){
+        sched_worker_t *w=&s->w[s->workers+i];
+#ifdef __linux__
+        if(opts->poll_cpus){
+            int c=opts->poll_cpus[i%opts->npoll_cpus];
+            if(c<0 || c>=CPU_SETSIZE){ err=EINVAL; break; }
+            CPU_ZERO(&w->affinity);
+            CPU_SET(c,&w->affinity);
+            w->has_affinity=1;
+            w->poll_cpu=c;
+        }
+#endif
+        atomic_store(&w->on,1);
+        err=sched_start_thread(s,w);
+        if(!err) created++;
+        else atomic_store(&w->on,0);
     }
-    if(inject_init(s,0)!=0){}
+    /* Wait until every worker has set itself up. */
+    pthread_mutex_lock(&s->start_mu);
+    while(s->started<created) pthread_cond_wait(&s->start_cv,&s->start_mu);
+    pthread_mutex_unlock(&s->start_mu);
+    for(int i=0;i<nslots && !err;i++) if(s->w[i].joinable && s->w[i].start_rc!=0) err=ENOMEM;
+    if(err){ kc_sched_shutdown(s); errno=err; return NULL; }
+    if(atomic_load(&s->slice_ns) && (err=sched_monitor_start(s))!=0){ kc_sched_shutdown(s); errno=err; return NULL; }
+    /* Without a watch (ENOMEM) the scheduler keeps its current tuning. */
+    s->cfg_watched=kc_runtime_config_watch(sched_config_changed,s)==0;
     return s;
 }
 
 void kc_sched_shutdown(kc_sched_t *s){
     if(!s) return;
-    /* Request stop */
+    if(s->cfg_watched) kc_runtime_config_unwatch(sched_config_changed,s);
+    /* Request stop; no thread starts after scale_closed */
     atomic_store(&s->stop,1);
+    pthread_mutex_lock(&s->scale_mu);
+    s->scale_closed=1;
+    pthread_mutex_unlock(&s->scale_mu);
     /* Wake all worker threads */
-    pthread_mutex_lock(&s->park_mu);
-    pthread_cond_broadcast(&s->park_cv);
-    pthread_mutex_unlock(&s->park_mu);
-    /* Wake timer thread if started */
-    if (atomic_load(&s->timer_started)) {
-        pthread_mutex_lock(&s->timer_mu);
-        pthread_cond_broadcast(&s->timer_cv);
-        pthread_mutex_unlock(&s->timer_mu);
-    }
-    /* Join workers */
-    for(int i=0;i<s->workers;i++){
-        if(s->w[i].thr) pthread_join(s->w[i].thr,NULL);
+    for(int i=0;i<s->workers;i++) parker_unpark(&s->w[i].park);
+    /* The monitor first: the watchdog may signal a worker thread */
+    if(s->mon_started){ pthread_join(s->mon_thr,NULL); s->mon_started=0; }
+    /* Join workers, poll workers included */
+    int nslots=s->workers+s->npoll;
+    for(int i=0;i<nslots;i++){
+        if(s->w[i].joinable){ pthread_join(s->w[i].thr,NULL); s->w[i].joinable=0; }
         if(s->w[i].main_co){ kcoro_destroy(s->w[i].main_co); s->w[i].main_co=NULL; }
         deque_destroy(&s->w[i].dq);
+        parker_destroy(&s->w[i].park);
     }
-    /* Join timer thread and cleanup timers */
-    if (atomic_load(&s->timer_started)) {
-        pthread_join(s->timer_thr, NULL);
-        pthread_mutex_lock(&s->timer_mu);
-        kc_timer_item_t* it = s->timer_head; s->timer_head = NULL;
-        pthread_mutex_unlock(&s->timer_mu);
-        while (it) { kc_timer_item_t* n = it->next; free(it); it = n; }
-        pthread_mutex_destroy(&s->timer_mu);
-        pthread_cond_destroy(&s->timer_cv);
-    }
-    /* Destroy remaining ready coroutines */
-    pthread_mutex_lock(&s->rq_mu);
+    /* Pending timers do not own their coroutine; just drop the wheels. */
+    for(int i=0;i<nslots;i++) kc_timer_wheel_destroy(&s->w[i].wheel);
+    /* Exiting workers moved their deadline heaps to the global list; what a
+     * dormant slot still holds is destroyed like it. */
+    for(int i=0;i<nslots;i++){
+        kcoro_t *dl;
+        while((dl=dl_pop_locked(&s->w[i]))!=NULL) kcoro_destroy(dl);
+        free(s->w[i].dl_heap);
+        KC_MUTEX_DESTROY(&s->w[i].dl_mu);
+    }
+    /* Destroy remaining ready coroutines; inboxes first (wakes that raced
+     * the workers' exit), then the global list. */
+    for(int i=0;i<nslots;i++){
+        kcoro_t *co=atomic_exchange(&s->w[i].inbox,NULL);
+        while(co){ kcoro_t *next=co->next; co->next=NULL; kcoro_destroy(co); co=next; }
+    }
+    KC_MUTEX_LOCK(&s->rq_mu);
     kcoro_t *co=s->rq_head; while(co){ kcoro_t *next=co->next; co->next=NULL; kcoro_destroy(co); co=next; }
     s->rq_head=s->rq_tail=NULL;
-    pthread_mutex_unlock(&s->rq_mu);
-    pthread_mutex_destroy(&s->park_mu);
-    pthread_cond_destroy(&s->park_cv);
-    pthread_mutex_destroy(&s->rq_mu);
-    inject_destroy(s);
+    KC_MUTEX_UNLOCK(&s->rq_mu);
+    /* Bulk coroutines still queued go the same way; queued tasks are dropped
+     * like the inject queue's. */
+    sched_task_t task;
+    while(ring_pop(&s->bulk,&task)) if(task.fn==sched_resume_task) kcoro_destroy((kcoro_t*)task.arg);
+    KC_MUTEX_DESTROY(&s->rq_mu);
+    KC_MUTEX_DESTROY(&s->drain_mu);
+    KC_COND_DESTROY(&s->drain_cv);
+    pthread_mutex_destroy(&s->start_mu);
+    pthread_cond_destroy(&s->start_cv);
+    pthread_mutex_destroy(&s->scale_mu);
+    pthread_mutex_destroy(&s->wd_mu);
+    ring_destroy(&s->bulk);
+    ring_destroy(&s->inject);
+    free(s->victim_buf);
+    free(atomic_load(&s->guest));
+    free(atomic_load(&s->wake_hist));
+    free((void*)atomic_load(&s->steal_mx));
     free(s->w);
     free(s);
 }
 
-int kc_spawn(kc_sched_t *s, kc_task_fn fn, void *arg){ if(!s||!fn) return -1; static _Atomic(unsigned) rr=0; unsigned idx=atomic_fetch_add(&rr,1)%(unsigned)s->workers; sched_worker_t *w=&s->w[idx]; uint32_t qlen=atomic_load_explicit(&w->dq.len,memory_order_relaxed); const uint32_t DONATE_THRESHOLD=64; if(qlen>DONATE_THRESHOLD){ if(inject_push(s, fn, arg)!=0) return -1; atomic_fetch_add(&s->tasks_submitted,1); if(atomic_load(&s->idle_workers)>0){ pthread_mutex_lock(&s->park_mu); pthread_cond_signal(&s->park_cv); pthread_mutex_unlock(&s->park_mu);} return 0; } sched_task_t *t=(sched_task_t*)malloc(sizeof(sched_task_t)); if(!t) return -1; t->fn=(sched_task_fn)fn; t->arg=arg; sched_task_t *expected=NULL; if(!atomic_compare_exchange_strong_explicit(&w->last_task,&expected,t,memory_order_release,memory_order_relaxed)){ atomic_fetch_add(&s->fastpath_misses,1); free(t); if(deque_push(&w->dq,(sched_task_fn)fn,arg)!=0) return -1; } else { /* fast-path success counts as submission */ } atomic_fetch_add(&s->tasks_submitted,1); if(atomic_load(&s->idle_workers)>0){ pthread_mutex_lock(&s->park_mu); pthread_cond_signal(&s->park_cv); pthread_mutex_unlock(&s->park_mu);} return 0; }
+/* Local deque depth past which spawns go to the inject queue instead. */
+#define KC_SCHED_DONATE_THRESHOLD 64u
+
+int kc_spawn(kc_sched_t *s, kc_task_fn fn, void *arg){
+    if(!s||!fn) return -1;
+    const uint32_t DONATE_THRESHOLD=KC_SCHED_DONATE_THRESHOLD;
+    sched_worker_t *self = sched_self(s);
+    sched_work_add(s, 1);
+    if (self) {
+        /* Spawned from one of our workers: push onto its own deque (owner
+         * side of Chase-Lev); donate to inject when it is already deep. */
+        if (deque_len(&self->dq) > DONATE_THRESHOLD) {
+            if (ring_push(&s->inject, fn, arg) != 0) { sched_work_done(s, 1); return -1; }
+            SCHED_WCOUNT(self, donations, 1);
+        } else if (deque_push(&self->dq, (sched_task_fn)fn, arg) != 0) {
+            sched_work_done(s, 1);
+            return -1;
+        }
+        SCHED_WCOUNT(self, tasks_submitted, 1);
+        SCHED_WCOUNT(self, lane_submitted[KC_LANE_INTERACTIVE], 1);
+        sched_wake_one(s);
+        return 0;
+    }
+    /* External thread: only the owner may touch a deque's bottom, so offer the
+     * task through a worker's last_task slot and fall back to inject. */
+    sched_worker_t *w=sched_ext_worker(s);
+    if (atomic_load_explicit(&w->on, memory_order_relaxed) && deque_len(&w->dq) <= DONATE_THRESHOLD) {
+        if (slot_offer(&w->last_task, (sched_task_fn)fn, arg)) {
+            SCHED_COUNT(s, tasks_submitted, 1);
+            SCHED_COUNT(s, lane_submitted[KC_LANE_INTERACTIVE], 1);
+            sched_wake_worker(s, w); /* only w drains its last_task slot */
+            return 0;
+        }
+        SCHED_COUNT(s, fastpath_misses, 1);
+    }
+    if(ring_push(&s->inject, fn, arg)!=0) { sched_work_done(s, 1); return -1; }
+    SCHED_COUNT(s, tasks_submitted, 1);
+    SCHED_COUNT(s, lane_submitted[KC_LANE_INTERACTIVE], 1);
+    sched_wake_one(s);
+    return 0;
+}
+
+int kc_spawn_lane(kc_sched_t *s, kc_task_fn fn, void *arg, kc_lane_t lane){
+    if (lane == KC_LANE_INTERACTIVE) return kc_spawn(s, fn, arg);
+    if (!s || !fn || lane != KC_LANE_BULK) return -1;
+    sched_work_add(s, 1);
+    if (ring_push(&s->bulk, (sched_task_fn)fn, arg) != 0) { sched_work_done(s, 1); return -1; }
+    SCHED_COUNT(s, tasks_submitted, 1);
+    SCHED_COUNT(s, lane_submitted[KC_LANE_BULK], 1);
+    sched_wake_one(s);
+    return 0;
+}
 
 void kc_yield(void){
     kcoro_t* cur = kcoro_current();
@@ -461,176 +2413,582 @@ void kc_yield(void){
     /* Fallback: thread yield */
     sched_yield();
 }
+int kc_yield_if_needed(void){
+    sched_worker_t *w = tls_current_worker;
+    if (!w || !atomic_load_explicit(&w->preempt, memory_order_relaxed)) return 0;
+    kcoro_t *co = kcoro_current();
+    if (!co || co == w->main_co) return 0;
+    co->safepoint_yields++;
+    sched_owner_add(&w->preempt_yields, 1);
+    kcoro_yield();
+    return 1;
+}
+
+int kc_co_overrun_stats(const kcoro_t *co, kc_co_overrun_stats_t *out){
+    if (!co || !out) return -EINVAL;
+    out->overruns = co->overruns;
+    out->safepoint_yields = co->safepoint_yields;
+    out->max_run_ns = co->max_run_ns;
+    return 0;
+}
+
 void kc_sleep_ms(int ms){
     if (ms <= 0) return;
     kcoro_t* cur = kcoro_current();
     kc_sched_t* s = kc_sched_current();
     if (cur && s) {
-        /* Cooperative sleep: schedule wake and park */
-        (void)kc_sched_timer_wake_after(s, cur, ms);
-        kcoro_park();
+        /* Cooperative sleep: schedule wake and park. A stray wake (e.g. a late
+         * channel unpark) must not cut the sleep short, so re-arm until due. */
+        uint64_t deadline = kc_now_ns() + (uint64_t)ms * 1000000ull;
+        do {
+            kc_timer_handle_t h = kc_sched_timer_wake_at(s, cur, deadline);
+            kcoro_park();
+            (void)kc_sched_timer_cancel(s, h);
+        } while (kc_now_ns() < deadline);
         return;
     }
     /* Fallback: thread sleep */
     struct timespec ts; ts.tv_sec = ms/1000; ts.tv_nsec = (ms%1000)*1000000L; nanosleep(&ts, NULL);
 }
 
+int kc_sched_park_release(void (*release)(void *arg), void *arg)
+{
+    sched_worker_t *w = tls_current_worker;
+    kcoro_t *co = kcoro_current();
+    if (!w || !co || co == w->main_co || !release) return -1;
+    w->park_release = release;
+    w->park_release_arg = arg;
+    kcoro_park();
+    return 0;
+}
+
+int kc_sched_local_depth(kc_sched_t *s)
+{
+    sched_worker_t *w = tls_current_worker;
+    return w && w->sched == s ? (int)deque_len(&w->dq) : -1;
+}
+
+/* Joins run other work rather than sleep: the newest task of our own deque
+ * (usually a half we split off and nobody stole), else one stolen along the
+ * steal order from a random start. Inside a coroutine a resume task is not
+ * run, as that would nest one coroutine in another: a popped one goes back,
+ * a stolen one stays queued here. */
+int kc_sched_help(kc_sched_t *s)
+{
+    sched_worker_t *w = tls_current_worker;
+    if (!w || w->sched != s) return -1;
+    kcoro_t *cur = kcoro_current();
+    int nested = cur && cur != w->main_co;
+    sched_task_t t;
+    if (deque_pop_owner(&w->dq, &t)) {
+        if (!nested || t.fn != sched_resume_task) { sched_run_task(w, &t); return 1; }
+        if (deque_push(&w->dq, t.fn, t.arg) != 0) rq_push_global(s, (kcoro_t*)t.arg);
+    }
+    if (w->nvictims <= 0) return 0;
+    int start = (int)(ws_rand(&w->rng) % (uint32_t)w->nvictims);
+    for (int i = 0; i < w->nvictims; i++) {
+        int v = w->victims[(start + i) % w->nvictims];
+        if (!deque_len(&s->w[v].dq) || deque_steal(&s->w[v].dq, &t) != KC_DEQUE_OK) continue;
+        SCHED_WCOUNT(w, steals_succeeded, 1);
+        sched_owner_add(&w->steals, 1);
+        if (nested && t.fn == sched_resume_task) {
+            if (deque_push(&w->dq, t.fn, t.arg) != 0) rq_push_global(s, (kcoro_t*)t.arg);
+            return 0;
+        }
+        sched_run_task(w, &t);
+        return 1;
+    }
+    return 0;
+}
+
+/* Arm on the calling worker's wheel; other threads pick a worker round-robin
+ * and wake it so its park deadline is recomputed. */
+static kc_timer_handle_t sched_timer_arm(struct kc_sched *s, kcoro_t *co, uint64_t deadline_ns)
+{
+    kc_timer_handle_t h = {0};
+    sched_worker_t *self = tls_current_worker;
+    sched_worker_t *w = self;
+    /* Prefer a slot with a thread; arming a dormant one revives it. */
+    if (!self || self->sched != s) w = sched_ext_worker(s);
+    h.id = kc_timer_wheel_add(&w->wheel, co, deadline_ns);
+    if (h.id && w != self) sched_wake_worker(s, w);
+    return h;
+}
+
 kc_timer_handle_t kc_sched_timer_wake_after(kc_sched_t* s, kcoro_t* co, long delay_ms)
 {
     kc_timer_handle_t h = {0}; if (!s || !co) return h; if (delay_ms < 0) delay_ms = 0;
-    kc_timer_ensure_started(s);
-    uint64_t deadline = kc_now_ns() + (uint64_t)delay_ms * 1000000ull;
-    kc_timer_item_t* item = (kc_timer_item_t*)calloc(1, sizeof(kc_timer_item_t));
-    if (!item) return h;
-    uint64_t id = atomic_fetch_add(&s->next_timer_id, 1) + 1;
-    item->id = id; item->when_ns = deadline; item->co = co; item->cancelled = 0; item->next = NULL;
-    pthread_mutex_lock(&s->timer_mu);
-    int head_changed = 0;
-    if (!s->timer_head || deadline < s->timer_head->when_ns) {
-        item->next = s->timer_head; s->timer_head = item; head_changed = 1;
-    } else {
-        kc_timer_item_t* cur = s->timer_head;
-        while (cur->next && cur->next->when_ns <= deadline) cur = cur->next;
-        item->next = cur->next; cur->next = item;
-    }
-    if (head_changed) pthread_cond_signal(&s->timer_cv);
-    pthread_mutex_unlock(&s->timer_mu);
-    h.id = id; return h;
+    return sched_timer_arm(s, co, kc_now_ns() + (uint64_t)delay_ms * 1000000ull);
 }
 
 kc_timer_handle_t kc_sched_timer_wake_at(kc_sched_t* s, kcoro_t* co, unsigned long long deadline_ns)
 {
     kc_timer_handle_t h = {0}; if (!s || !co) return h;
-    kc_timer_ensure_started(s);
-    kc_timer_item_t* item = (kc_timer_item_t*)calloc(1, sizeof(kc_timer_item_t));
-    if (!item) return h;
-    uint64_t id = atomic_fetch_add(&s->next_timer_id, 1) + 1;
-    item->id = id; item->when_ns = (uint64_t)deadline_ns; item->co = co; item->cancelled = 0; item->next = NULL;
-    pthread_mutex_lock(&s->timer_mu);
-    int head_changed = 0;
-    if (!s->timer_head || item->when_ns < s->timer_head->when_ns) {
-        item->next = s->timer_head; s->timer_head = item; head_changed = 1;
-    } else {
-        kc_timer_item_t* cur = s->timer_head;
-        while (cur->next && cur->next->when_ns <= item->when_ns) cur = cur->next;
-        item->next = cur->next; cur->next = item;
-    }
-    if (head_changed) pthread_cond_signal(&s->timer_cv);
-    pthread_mutex_unlock(&s->timer_mu);
-    h.id = id; return h;
+    return sched_timer_arm(s, co, (uint64_t)deadline_ns);
 }
 
 int kc_sched_timer_cancel(kc_sched_t* s, kc_timer_handle_t h)
 {
     if (!s || h.id == 0) return 0;
-    pthread_mutex_lock(&s->timer_mu);
-    kc_timer_item_t* prev = NULL; kc_timer_item_t* cur = s->timer_head;
-    while (cur) {
-        if (cur->id == h.id) {
-            int head_cancelled = (prev == NULL);
-            if (prev) prev->next = cur->next; else s->timer_head = cur->next;
-            free(cur);
-            if (head_cancelled) pthread_cond_signal(&s->timer_cv);
-            pthread_mutex_unlock(&s->timer_mu);
-            return 1;
-        }
-        prev = cur; cur = cur->next;
+    uint32_t wn = kc_timer_id_wheel(h.id);
+    if (wn >= (uint32_t)(s->workers + s->npoll)) return 0;
+    return kc_timer_wheel_cancel(&s->w[wn].wheel, h.id);
+}
+
+/* How many of n new entries a worker keeps on its own deque (up to the
+ * donation threshold), with room reserved; the rest goes to shared queues. */
+static size_t sched_local_share(sched_worker_t *self, size_t n)
+{
+    uint32_t len = deque_len(&self->dq);
+    size_t room = len < KC_SCHED_DONATE_THRESHOLD ? KC_SCHED_DONATE_THRESHOLD - len : 0;
+    size_t k = n < room ? n : room;
+    if (k && deque_reserve(&self->dq, k) != 0) k = 0;
+    return k;
+}
+
+int kc_spawn_batch(kc_sched_t *s, kc_task_fn const *fns, void *const *args, size_t n){
+    if(!s||!fns||!args) return -1;
+    for (size_t i = 0; i < n; i++) if (!fns[i]) return -1;
+    if (n == 0) return 0;
+    /* Workers keep a prefix on their deque; external threads (which may not
+     * touch deque bottoms) and the overflow go to inject in one lock hold. */
+    sched_worker_t *self = sched_self(s);
+    size_t k = self ? sched_local_share(self, n) : 0;
+    sched_work_add(s, (long)n);
+    if (ring_push_many(&s->inject, NULL, (const sched_task_fn*)fns + k, args + k, n - k) != 0) {
+        sched_work_done(s, (long)n);
+        return -1;
     }
-    pthread_mutex_unlock(&s->timer_mu);
+    if (k) deque_push_many(&self->dq, NULL, (const sched_task_fn*)fns, args, k);
+    if (self && n > k) SCHED_WCOUNT(self, donations, n - k);
+    SCHED_COUNT(s, tasks_submitted, n);
+    SCHED_COUNT(s, lane_submitted[KC_LANE_INTERACTIVE], n);
+    sched_wake_many(s, n);
     return 0;
 }
 
 /* ---- Coroutine API (legacy names) ---- */
-int kc_spawn_co(kc_sched_t* s, kcoro_fn_t fn, void* arg, size_t stack_size, kcoro_t** out_co){
-    if(!s||!fn) return -1;
+static int sched_spawn_co(kc_sched_t* s, kcoro_fn_t fn, void* arg, size_t stack_size,
+                          kcoro_t** out_co, kc_lane_t lane, uint64_t deadline_ns, uint32_t poll_home){
+    if(!s||!fn||lane<0||lane>=KC_LANE_COUNT) return -1;
     kcoro_t *co=kcoro_create(fn,arg,stack_size);
-    if(!co) return -1;
+    if(!co) return -ENOMEM; /* out of memory or past the stack budget (kc_mem.h) */
     co->scheduler = (kcoro_sched_t*)s;
+    co->lane = (uint8_t)lane;
+    co->deadline_ns = deadline_ns;
+    co->poll_home = poll_home;
     if(out_co) *out_co=co;
-    /* Ready queue takes ownership; retain before enqueue so rq_pop_locked releases the queue hold. */
+    /* Ready queue takes ownership; retain before enqueue so the resume path releases the queue hold. */
     kcoro_retain(co);
-    pthread_mutex_lock(&s->rq_mu);
-    rq_push_locked(s,co);
-    pthread_mutex_unlock(&s->rq_mu);
-    if(atomic_load(&s->idle_workers)>0){ pthread_mutex_lock(&s->park_mu); pthread_cond_signal(&s->park_cv); pthread_mutex_unlock(&s->park_mu);} return 0; }
-void kc_sched_enqueue_ready(kc_sched_t* s, kcoro_t* co)
-{
-    if (!s || !co) return;
-    pthread_mutex_lock(&s->rq_mu);
-    if (co->state == KCORO_RUNNING || co->ready_enqueued) {
-        pthread_mutex_unlock(&s->rq_mu);
-        return;
+    (void)sched_claim_ready(co);
+    sched_work_add(s, 1);
+    KC_TRACE(KC_TRACE_SPAWN, co, lane);
+    sched_push_ready(s, co, 0, lane);
+    if (!poll_home) sched_wake_one(s);
+    return 0;
+}
+int kc_spawn_co_lane(kc_sched_t* s, kcoro_fn_t fn, void* arg, size_t stack_size,
+                     kcoro_t** out_co, kc_lane_t lane){
+    return sched_spawn_co(s, fn, arg, stack_size, out_co, lane, 0, 0);
+}
+int kc_spawn_co(kc_sched_t* s, kcoro_fn_t fn, void* arg, size_t stack_size, kcoro_t** out_co){
+    return kc_spawn_co_lane(s, fn, arg, stack_size, out_co, KC_LANE_INTERACTIVE);
+}
+int kc_spawn_lazy(kc_sched_t* s, kc_task_fn fn, void* arg){
+    return kc_spawn_co_lane(s, fn, arg, KCORO_STACK_LAZY, NULL, KC_LANE_INTERACTIVE);
+}
+int kc_spawn_co_deadline(kc_sched_t* s, kcoro_fn_t fn, void* arg, size_t stack_size,
+                         kcoro_t** out_co, unsigned long long deadline_ns){
+    return sched_spawn_co(s, fn, arg, stack_size, out_co, KC_LANE_INTERACTIVE, (uint64_t)deadline_ns, 0);
+}
+int kc_spawn_co_poll(kc_sched_t* s, int poll, kcoro_fn_t fn, void* arg, size_t stack_size, kcoro_t** out_co){
+    if(!s||!fn||poll<0||poll>=s->npoll) return -EINVAL;
+    return sched_spawn_co(s, fn, arg, stack_size, out_co, KC_LANE_INTERACTIVE, 0, (uint32_t)poll + 1u);
+}
+int kc_co_set_deadline(kcoro_t* co, unsigned long long deadline_ns){
+    if(!co) return -EINVAL;
+    co->deadline_ns = (uint64_t)deadline_ns;
+    return 0;
+}
+int kc_spawn_co_batch(kc_sched_t* s, kcoro_fn_t const* fns, void* const* args, size_t n,
+                      size_t stack_size, kcoro_t** out_cos){
+    if(!s||!fns||!args) return -1;
+    for (size_t i = 0; i < n; i++) if (!fns[i]) return -1;
+    if (n == 0) return 0;
+    kcoro_t **cos = out_cos ? out_cos : (kcoro_t**)malloc(n * sizeof(*cos));
+    if (!cos) return -1;
+    for (size_t i = 0; i < n; i++) {
+        cos[i] = kcoro_create(fns[i], args[i], stack_size);
+        if (!cos[i]) {
+            while (i--) kcoro_destroy(cos[i]);
+            if (!out_cos) free(cos);
+            return -ENOMEM;
+        }
     }
+    for (size_t i = 0; i < n; i++) {
+        cos[i]->scheduler = (kcoro_sched_t*)s;
+        kcoro_retain(cos[i]); /* queue hold, as in kc_spawn_co */
+        (void)sched_claim_ready(cos[i]);
+        KC_TRACE(KC_TRACE_SPAWN, cos[i], KC_LANE_INTERACTIVE);
+    }
+    sched_work_add(s, (long)n);
+    sched_worker_t *self = sched_self(s);
+    size_t k = self ? sched_local_share(self, n) : 0;
+    if (k) {
+        deque_push_many(&self->dq, sched_resume_task, NULL, (void* const*)cos, k);
+        SCHED_WCOUNT(self, ready_local, k);
+    }
+    rq_push_global_many(s, cos + k, n - k);
+    SCHED_COUNT(s, lane_submitted[KC_LANE_INTERACTIVE], n);
+    sched_wake_many(s, n);
+    if (!out_cos) free(cos);
+    return 0;
+}
+/* Claim co for one ready-queue entry on s, take the queue's hold and stamp
+ * it (ready_ns = now). Returns the lane to queue it on, or -1 when it is
+ * running, finished or already queued. */
+static int sched_wake_claim(struct kc_sched *s, kcoro_t *co, kc_lane_t lane, uint64_t now)
+{
+    if (co->state == KCORO_RUNNING) return -1;
     if (co->state == KCORO_FINISHED) {
         KC_SCHED_DEBUG("skip enqueue finished co=%p", (void*)co);
-        pthread_mutex_unlock(&s->rq_mu);
-        return;
+        return -1;
     }
+    if (!sched_claim_ready(co)) return -1; /* already queued somewhere */
+    sched_work_add(s, 1);
     if (co->state != KCORO_READY && co->state != KCORO_RUNNING) {
         co->state = KCORO_READY;
     }
     kcoro_retain(co);
     co->scheduler = (kcoro_sched_t*)s;
-    rq_push_locked(s, co);
-    pthread_mutex_unlock(&s->rq_mu);
-    if (atomic_load(&s->idle_workers) > 0) {
-        pthread_mutex_lock(&s->park_mu);
-        pthread_cond_signal(&s->park_cv);
-        pthread_mutex_unlock(&s->park_mu);
+    co->ready_ns = now;
+    if (lane < 0 || lane >= KC_LANE_COUNT) lane = (kc_lane_t)co->lane;
+    KC_TRACE(KC_TRACE_WAKE, co, lane);
+    return (int)lane;
+}
+void kc_sched_enqueue_ready_lane(kc_sched_t* s, kcoro_t* co, kc_lane_t lane)
+{
+    if (!s || !co) return;
+    int l = sched_wake_claim(s, co, lane, atomic_load_explicit(&s->wake_lat_on, memory_order_relaxed) ? kc_now_ns() : 0);
+    if (l < 0) return;
+    sched_worker_t *p = sched_poll_of(s, co);
+    if (p) {
+        SCHED_COUNT(s, lane_submitted[l], 1);
+        sched_poll_push(p, co);
+        return;
+    }
+    if (!sched_self(s) && l != KC_LANE_BULK && !co->deadline_ns) {
+        SCHED_COUNT(s, lane_submitted[l], 1);
+        co->next = NULL;
+        sched_remote_push(s, NULL, co, co, 1);
+        return;
+    }
+    sched_push_ready(s, co, 1, l);
+    sched_wake_one(s);
+}
+void kc_sched_enqueue_ready_home(kc_sched_t* s, kcoro_t* co, kc_lane_t lane)
+{
+    if (!s || !co) return;
+    sched_worker_t *home = co->poll_home || co->deadline_ns ? NULL : sched_home(s, co);
+    /* At home already, or homeless: the waker's worker is as good as any. */
+    if (!home || home == sched_self(s)) { kc_sched_enqueue_ready_lane(s, co, lane); return; }
+    int l = sched_wake_claim(s, co, lane, atomic_load_explicit(&s->wake_lat_on, memory_order_relaxed) ? kc_now_ns() : 0);
+    if (l < 0) return;
+    if (l == KC_LANE_BULK) { sched_push_ready(s, co, 0, l); sched_wake_one(s); return; }
+    SCHED_COUNT(s, lane_submitted[l], 1);
+    co->next = NULL;
+    sched_remote_push(s, home, co, co, 1);
+}
+size_t kc_sched_enqueue_ready_batch_lane(kc_sched_t* s, kcoro_t* const* cos, size_t n, kc_lane_t lane)
+{
+    if (!s || !cos || n == 0) return 0;
+    uint64_t now = atomic_load_explicit(&s->wake_lat_on, memory_order_relaxed) ? kc_now_ns() : 0;
+    sched_worker_t *self = sched_self(s);
+    /* Interactive wakes: a prefix onto this worker's deque (one bottom
+     * store), the rest chained and spliced onto the global list; from
+     * outside, the chain goes to one worker's inbox in a single CAS. Bulk
+     * and deadline coroutines take their own queues one at a time. */
+    size_t room = self ? sched_local_share(self, n) : 0;
+    void *local[KC_SCHED_DONATE_THRESHOLD];
+    size_t nlocal = 0, nglobal = 0, queued = 0;
+    unsigned long per_lane[KC_LANE_COUNT] = {0};
+    kcoro_t *head = NULL, *tail = NULL;
+    for (size_t i = 0; i < n; i++) {
+        kcoro_t *co = cos[i];
+        int l = co ? sched_wake_claim(s, co, lane, now) : -1;
+        if (l < 0) continue;
+        queued++;
+        per_lane[l]++;
+        if (l == KC_LANE_BULK || co->deadline_ns || co->poll_home) { sched_requeue(s, co, l); continue; }
+        if (nlocal < room) { local[nlocal++] = co; continue; }
+        if (!self) {
+            /* Newest first, as the inbox holds them */
+            co->next = head;
+            head = co;
+            if (!tail) tail = co;
+            nglobal++;
+            continue;
+        }
+        co->next = NULL;
+        if (tail) tail->next = co; else head = co;
+        tail = co;
+        nglobal++;
     }
+    if (nlocal) {
+        deque_push_many(&self->dq, sched_resume_task, NULL, local, nlocal);
+        SCHED_WCOUNT(self, ready_local, nlocal);
+    }
+    for (int l = 0; l < KC_LANE_COUNT; l++) if (per_lane[l]) SCHED_COUNT(s, lane_submitted[l], per_lane[l]);
+    if (!self && head) {
+        /* The push rang its target; wake the rest as usual, to steal. */
+        sched_remote_push(s, NULL, head, tail, nglobal);
+        sched_wake_many(s, queued - 1);
+        return queued;
+    }
+    rq_splice_global(s, head, tail, nglobal);
+    sched_wake_many(s, queued);
+    return queued;
+}
+size_t kc_sched_enqueue_ready_batch(kc_sched_t* s, kcoro_t* const* cos, size_t n)
+{
+    return kc_sched_enqueue_ready_batch_lane(s, cos, n, KC_LANE_INHERIT);
+}
+void kc_sched_enqueue_ready(kc_sched_t* s, kcoro_t* co)
+{
+    kc_sched_enqueue_ready_lane(s, co, KC_LANE_INHERIT);
+}
+int kc_sched_handoff(kcoro_t* co)
+{
+    sched_worker_t *w = tls_current_worker;
+    kcoro_t *self = kcoro_current();
+    if (!w || !co || !self || co == self || w->handoff) return -1;
+    struct kc_sched *s = w->sched;
+    /* Poll workers and their coroutines stay apart from the others. */
+    if (w->id >= s->workers || co->poll_home) return -1;
+    if (sched_wake_claim(s, co, KC_LANE_INHERIT,
+                         atomic_load_explicit(&s->wake_lat_on, memory_order_relaxed) ? kc_now_ns() : 0) < 0)
+        return -1;
+    w->handoff = co;
+    SCHED_WCOUNT(w, handoffs, 1);
+    kcoro_yield();
+    return 0;
 }
 kc_sched_t* kc_sched_current(void){ return tls_current_sched; }
 
+uint32_t kc_sched_rand(void)
+{
+    static __thread uint32_t tls_rng; /* plain threads */
+    sched_worker_t *w = tls_current_worker;
+    if (w) return ws_rand(&w->rng);
+    if (!tls_rng) tls_rng = (uint32_t)((intptr_t)&tls_rng ^ 0x9e3779b9u);
+    return ws_rand(&tls_rng);
+}
+
 /* ---- Default singleton ---- */
+static kc_sched_t *_Atomic g_default_sched;
+static pthread_mutex_t g_default_mu = PTHREAD_MUTEX_INITIALIZER;
+static kc_sched_opts_t g_default_opts;
+static int g_default_has_opts;
+
+int kc_sched_set_default_opts(const kc_sched_opts_t *opts){
+    int *cpus = NULL, *poll_cpus = NULL;
+    if (opts && opts->cpus && opts->ncpus > 0) {
+        cpus = (int*)malloc((size_t)opts->ncpus * sizeof(int));
+        if (!cpus) return -ENOMEM;
+        memcpy(cpus, opts->cpus, (size_t)opts->ncpus * sizeof(int));
+    }
+    if (opts && opts->poll_cpus && opts->npoll_cpus > 0) {
+        poll_cpus = (int*)malloc((size_t)opts->npoll_cpus * sizeof(int));
+        if (!poll_cpus) { free(cpus); return -ENOMEM; }
+        memcpy(poll_cpus, opts->poll_cpus, (size_t)opts->npoll_cpus * sizeof(int));
+    }
+    pthread_mutex_lock(&g_default_mu);
+    if (atomic_load(&g_default_sched)) {
+        pthread_mutex_unlock(&g_default_mu);
+        free(cpus);
+        free(poll_cpus);
+        return -EBUSY;
+    }
+    free((void*)g_default_opts.cpus);
+    free((void*)g_default_opts.poll_cpus);
+    memset(&g_default_opts, 0, sizeof(g_default_opts));
+    if (opts) { g_default_opts = *opts; g_default_opts.cpus = cpus; g_default_opts.poll_cpus = poll_cpus; }
+    g_default_has_opts = (opts != NULL);
+    pthread_mutex_unlock(&g_default_mu);
+    return 0;
+}
+
 kc_sched_t* kc_sched_default(void){
-    static kc_sched_t *g = NULL;
-    static pthread_mutex_t mu = PTHREAD_MUTEX_INITIALIZER;
+    kc_sched_t *g = atomic_load_explicit(&g_default_sched, memory_order_acquire);
     if (__builtin_expect(g != NULL, 1)) return g;
-    pthread_mutex_lock(&mu);
-    if (!g) g = kc_sched_init(NULL);
-    pthread_mutex_unlock(&mu);
+    pthread_mutex_lock(&g_default_mu);
+    g = atomic_load(&g_default_sched);
+    if (!g) {
+        g = kc_sched_init(g_default_has_opts ? &g_default_opts : NULL);
+        atomic_store_explicit(&g_default_sched, g, memory_order_release);
+    }
+    pthread_mutex_unlock(&g_default_mu);
     return g;
 }
 
-void kc_sched_get_stats(kc_sched_t *s, kc_sched_stats_t *out){ if(!s||!out) return; out->tasks_submitted=atomic_load(&s->tasks_submitted); out->tasks_completed=atomic_load(&s->tasks_completed); out->steals_probes=atomic_load(&s->steals_probes); out->steals_succeeded=atomic_load(&s->steals_succeeded); out->steals_failures=atomic_load(&s->steals_failures); out->fastpath_hits=atomic_load(&s->fastpath_hits); out->fastpath_misses=atomic_load(&s->fastpath_misses); out->inject_pulls=atomic_load(&s->inject_pulls); out->donations=atomic_load(&s->donations); }
+void kc_sched_get_stats(kc_sched_t *s, kc_sched_stats_t *out){
+    if(!s||!out) return;
+    /* Counters live per worker (plus ext_ctr for foreign threads); sum them. */
+    int nslots=s->workers+s->npoll;
+#define SCHED_SUM(f) out->f=atomic_load_explicit(&s->ext_ctr.f,memory_order_relaxed); \
+    for(int i=0;i<nslots;i++) out->f+=atomic_load_explicit(&s->w[i].ctr.f,memory_order_relaxed);
+    SCHED_COUNTERS(SCHED_SUM)
+#undef SCHED_SUM
+    out->preempt_flags=atomic_load_explicit(&s->preempt_flags,memory_order_relaxed); out->preempt_yields=0;
+    for(int i=0;i<s->workers;i++) out->preempt_yields+=atomic_load_explicit(&s->w[i].preempt_yields,memory_order_relaxed);
+    out->deadline_queued=atomic_load_explicit(&s->dl_queued,memory_order_relaxed);
+    out->stalls_run=atomic_load_explicit(&s->stalls_run,memory_order_relaxed);
+    out->stalls_queue=atomic_load_explicit(&s->stalls_queue,memory_order_relaxed);
+    out->workers_active=(unsigned long)atomic_load(&s->active);
+    out->cpu_budget=s->cpu_auto? (unsigned long)atomic_load(&s->cpu_budget) : 0; out->scale_ups=atomic_load(&s->scale_ups); out->scale_downs=atomic_load(&s->scale_downs);
+    out->inject_depth=ring_len(&s->inject); out->bulk_depth=ring_len(&s->bulk);
+    for(int l=0;l<KC_LANE_COUNT;l++){
+        out->lane_submitted[l]=atomic_load_explicit(&s->ext_ctr.lane_submitted[l],memory_order_relaxed);
+        out->lane_run[l]=0;
+        for(int i=0;i<nslots;i++){
+            out->lane_submitted[l]+=atomic_load_explicit(&s->w[i].ctr.lane_submitted[l],memory_order_relaxed);
+            out->lane_run[l]+=atomic_load_explicit(&s->w[i].lane_run[l],memory_order_relaxed);
+        }
+    }
+    out->poll_workers=(unsigned long)s->npoll; out->poll_busy_ns=0; out->poll_wall_ns=0;
+    for(int i=0;i<s->npoll;i++){
+        kc_sched_poll_stats_t ps;
+        kc_sched_get_poll_stats(s,i,&ps);
+        out->poll_busy_ns+=ps.busy_ns; out->poll_wall_ns+=ps.wall_ns;
+    }
+}
+
+int kc_sched_set_wake_latency(kc_sched_t *s, int on){
+    if(!s) return -EINVAL;
+    if(on && !atomic_load_explicit(&s->wake_hist, memory_order_acquire)){
+        /* One shard per slot: poll workers record their resumes too. */
+        size_t n = (size_t)(s->workers + s->npoll);
+        struct kc_hist_shard *h = aligned_alloc(_Alignof(struct kc_hist_shard), n * sizeof(*h));
+        if(!h) return -ENOMEM;
+        kc_hist_shard_init(h, n);
+        struct kc_hist_shard *expected = NULL;
+        if(!atomic_compare_exchange_strong(&s->wake_hist, &expected, h)) free(h);
+    }
+    atomic_store_explicit(&s->wake_lat_on, on ? 1 : 0, memory_order_relaxed);
+    return 0;
+}
 
-static int approx_idle(struct kc_sched *s){
-    /* Check global inject queue */
-    int inject_empty;
-    pthread_mutex_lock(&s->inject_mu);
-    inject_empty = (s->inject_head == s->inject_tail);
-    pthread_mutex_unlock(&s->inject_mu);
+int kc_sched_get_wake_latency(kc_sched_t *s, struct kc_hist *out, int reset){
+    if(!s||!out) return -EINVAL;
+    memset(out, 0, sizeof(*out));
+    struct kc_hist_shard *h = atomic_load_explicit(&s->wake_hist, memory_order_acquire);
+    if(!h) return -ENOENT;
+    kc_hist_merge(h, (size_t)(s->workers + s->npoll), out, reset);
+    return 0;
+}
 
-    /* Check ready queue */
-    int rq_empty;
-    pthread_mutex_lock(&s->rq_mu);
-    rq_empty = (s->rq_head == NULL);
-    pthread_mutex_unlock(&s->rq_mu);
+int kc_sched_set_guest(kc_sched_t *s, const kc_sched_guest_t *g){
+    if(!s || (g && !g->poll)) return -EINVAL;
+    kc_sched_guest_t *copy=NULL;
+    if(g){
+        if(!(copy=malloc(sizeof(*copy)))) return -ENOMEM;
+        *copy=*g;
+    }
+    kc_sched_guest_t *old=atomic_exchange(&s->guest,copy);
+    /* A worker that entered before the exchange may still hold old. */
+    while(atomic_load(&s->guest_calls)) sched_yield();
+    free(old);
+    if(copy) sched_guest_ring(s);
+    return 0;
+}
 
-    /* Check each worker's deque and last_task */
-    for (int i = 0; i < s->workers; i++){
-        sched_worker_t *w = &s->w[i];
-        if (atomic_load_explicit(&w->dq.len, memory_order_relaxed) != 0) return 0;
-        if (atomic_load_explicit(&w->last_task, memory_order_acquire) != NULL) return 0;
+void kc_sched_guest_notify(kc_sched_t *s){
+    if(s) sched_guest_ring(s);
+}
+
+int kc_sched_worker_count(kc_sched_t *s){
+    return s ? s->workers : -EINVAL;
+}
+
+int kc_sched_poll_count(kc_sched_t *s){
+    return s ? s->npoll : -EINVAL;
+}
+
+int kc_sched_get_poll_stats(kc_sched_t *s, int poll, kc_sched_poll_stats_t *out){
+    if(!s || !out || poll < 0 || poll >= s->npoll) return -EINVAL;
+    sched_worker_t *w = &s->w[s->workers + poll];
+    memset(out, 0, sizeof(*out));
+    out->cpu = w->poll_cpu;
+    out->run = atomic_load_explicit(&w->lane_run[KC_LANE_INTERACTIVE], memory_order_relaxed);
+    out->busy_ns = atomic_load_explicit(&w->poll_busy_ns, memory_order_relaxed);
+    uint64_t t0 = atomic_load_explicit(&w->poll_t0, memory_order_relaxed);
+    if (t0) { uint64_t now = kc_now_ns(); if (now > t0) out->wall_ns = now - t0; }
+    out->spins = atomic_load_explicit(&w->poll_spins, memory_order_relaxed);
+    return 0;
+}
+
+int kc_sched_get_worker_stats(kc_sched_t *s, int worker, kc_sched_worker_stats_t *out){
+    if(!s || !out || worker < 0 || worker >= s->workers) return -EINVAL;
+    sched_worker_t *w = &s->w[worker];
+    memset(out, 0, sizeof(*out));
+    out->on = atomic_load_explicit(&w->on, memory_order_relaxed);
+    out->parked = (atomic_load_explicit(&s->idle_mask[worker / 64], memory_order_relaxed) >> (worker % 64)) & 1;
+    for(int l=0;l<KC_LANE_COUNT;l++) out->run += atomic_load_explicit(&w->lane_run[l], memory_order_relaxed);
+    out->parks = atomic_load_explicit(&w->parks, memory_order_relaxed);
+    uint64_t t0 = atomic_load_explicit(&w->park_t0, memory_order_relaxed);
+    out->parked_ns = atomic_load_explicit(&w->parked_ns, memory_order_relaxed);
+    if (t0) { uint64_t now = kc_now_ns(); if (now > t0) out->parked_ns += now - t0; } /* sleep in progress */
+    out->steals = atomic_load_explicit(&w->steals, memory_order_relaxed);
+    out->steal_depth = (unsigned)atomic_load_explicit(&w->steal_depth, memory_order_relaxed);
+    out->deque_depth = deque_len(&w->dq);
+    out->runnext = atomic_load_explicit(&w->runnext, memory_order_relaxed) != NULL;
+    out->deadline_next_ns = atomic_load_explicit(&w->dl_min, memory_order_relaxed);
+    out->timers = kc_timer_wheel_pending(&w->wheel);
+    return 0;
+}
+
+int kc_sched_set_steal_matrix(kc_sched_t *s, int on){
+    if(!s) return -EINVAL;
+    if(on && !atomic_load_explicit(&s->steal_mx, memory_order_acquire)){
+        size_t n = (size_t)s->workers * (size_t)s->workers;
+        _Atomic(unsigned long) *mx = (_Atomic(unsigned long)*)calloc(n, sizeof(*mx));
+        if(!mx) return -ENOMEM;
+        _Atomic(unsigned long) *expected = NULL;
+        if(!atomic_compare_exchange_strong(&s->steal_mx, &expected, mx)) free((void*)mx);
     }
+    atomic_store_explicit(&s->steal_mx_on, on ? 1 : 0, memory_order_relaxed);
+    return 0;
+}
 
-    /* All workers idle? */
-    int idle = (atomic_load(&s->idle_workers) == s->workers);
-    return (inject_empty && rq_empty && idle) ? 1 : 0;
+int kc_sched_get_steal_matrix(kc_sched_t *s, unsigned long *out, size_t n){
+    if(!s || !out) return -EINVAL;
+    size_t need = (size_t)s->workers * (size_t)s->workers;
+    if(n < need) return -ENOSPC;
+    _Atomic(unsigned long) *mx = atomic_load_explicit(&s->steal_mx, memory_order_acquire);
+    if(!mx) return -ENOENT;
+    for(size_t i=0;i<need;i++) out[i] = atomic_load_explicit(&mx[i], memory_order_relaxed);
+    return s->workers;
 }
 
 int kc_sched_drain(struct kc_sched *s, long timeout_ms){
     if (!s) return -1;
-    if (timeout_ms == 0) return approx_idle(s) ? 0 : -ETIME;
-    long waited = 0;
-    const long slice = 5; /* ms */
-    if (timeout_ms < 0){
-        for(;;){ if (approx_idle(s)) return 0; kc_sleep_ms((int)slice); }
-    }
-    while (waited <= timeout_ms){
-        if (approx_idle(s)) return 0;
-        kc_sleep_ms((int)slice);
-        waited += slice;
-    }
-    return -ETIME;
+    if (atomic_load(&s->outstanding) == 0) return 0;
+    if (timeout_ms == 0) return -ETIME;
+    /* Our own run counts as outstanding: waiting here could never end. */
+    if (tls_current_worker && tls_current_worker->sched == s) return -EDEADLK;
+    uint64_t deadline = timeout_ms > 0 ? kc_now_ns() + (uint64_t)timeout_ms * 1000000ull : 0;
+    int rc = 0;
+    KC_MUTEX_LOCK(&s->drain_mu);
+    atomic_fetch_add(&s->drain_waiters, 1);
+    while (atomic_load(&s->outstanding) != 0) {
+        if (!deadline) { KC_COND_WAIT(&s->drain_cv, &s->drain_mu); continue; }
+        uint64_t now = kc_now_ns();
+        if (now >= deadline) { rc = -ETIME; break; }
+        struct timespec ts;
+        kc_clock_abstime(&ts, KC_COND_CLOCK, deadline);
+        (void)KC_COND_TIMEDWAIT_ABS(&s->drain_cv, &s->drain_mu, &ts);
+    }
+    atomic_fetch_sub(&s->drain_waiters, 1);
+    KC_MUTEX_UNLOCK(&s->drain_mu);
+    return rc;
 }
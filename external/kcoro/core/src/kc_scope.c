@@ -5,20 +5,51 @@
 #include <string.h>
 #include <errno.h>
 #include <time.h>
+#include <stdatomic.h>
 
 #include "../../include/kcoro.h"
+#include "../../include/kcoro_core.h"
 #include "../../include/kcoro_sched.h"
 #include "../../include/kcoro_port.h"
+#include "../../include/kcoro_arena.h"
+#include "kc_clock_internal.h"
+#include "kcoro_share_internal.h"
 
 struct kc_scope_child;
-
+struct kc_scope_waiter;
+
+/* Child records come from the scope's arena and go back on `spare` when the
+ * child finishes, so launching costs a list pop (or a pointer bump while
+ * the scope grows) and the arena never outgrows the peak child count.
+ *
+ * Completion takes no lock: the record is pushed back on `spare` (a
+ * Treiber stack; only launches pop, under mu, so there is no ABA) and
+ * `pending` is dropped with a CAS. Only the drop to zero takes mu, to wake
+ * waiters; kc_scope_wait_all takes mu once before returning, so nothing
+ * touches the scope after a wait has seen zero. Coroutine children are not
+ * tracked any further; actor children sit on `actors` (doubly linked, under
+ * mu) for cancellation. */
 struct kc_scope {
     kc_cancel_ctx_t cancel_ctx;
     KC_MUTEX_T mu;
     KC_COND_T  cv;
     int shutting_down;
-    int child_count;
-    struct kc_scope_child *children;
+    _Atomic int pending; /* children not yet finished */
+    struct kc_scope_child *actors;
+    _Atomic(struct kc_scope_child *) spare;
+    struct kc_scope_waiter *waiters; /* parked coroutines, under mu */
+    kc_arena_t *arena;   /* created on first use, under mu */
+};
+
+/* A coroutine parked in kc_scope_wait_all. */
+/* Also the park record: the release hook takes the waiter itself. */
+struct kc_scope_waiter {
+    struct kc_scope_waiter *next;
+    kcoro_t *co;
+    kc_sched_t *sched;
+    kc_scope_t *scope;
+    long long deadline_ns;
+    kc_timer_handle_t timer;
 };
 
 enum kc_scope_child_kind {
@@ -33,60 +64,121 @@ struct kc_scope_child {
         kcoro_t   *coro;
         kc_actor_t actor;
     } u;
-    struct kc_scope_child *next;
-};
-
-struct kc_scope_coro_wrapper {
-    kc_scope_t *scope;
+    /* coroutine body */
     kcoro_fn_t fn;
     void *arg;
-    struct kc_scope_child *child;
-};
-
-struct kc_scope_producer_state {
+    /* kc_scope_produce */
     kc_chan_t *chan;
-    kc_producer_fn fn;
+    kc_producer_fn produce;
     void *user;
+    struct kc_scope_child *prev, *next; /* actors list; next also links spare */
+    int linked;                         /* on actors */
 };
 
-static void kc_scope_child_complete(kc_scope_t *scope, struct kc_scope_child *child)
+static void kc_scope_unlink_actor_locked(kc_scope_t *scope, struct kc_scope_child *child)
 {
-    if (!scope || !child) return;
+    if (!child->linked) return;
+    if (child->prev) child->prev->next = child->next;
+    else scope->actors = child->next;
+    if (child->next) child->next->prev = child->prev;
+    child->linked = 0;
+}
+
+/* Drop one pending child; the last one wakes every waiter under mu. */
+static void kc_scope_pending_drop(kc_scope_t *scope)
+{
+    int n = atomic_load_explicit(&scope->pending, memory_order_relaxed);
+    while (n > 1) {
+        if (atomic_compare_exchange_weak_explicit(&scope->pending, &n, n - 1,
+                                                  memory_order_acq_rel, memory_order_relaxed))
+            return;
+    }
     KC_MUTEX_LOCK(&scope->mu);
-    struct kc_scope_child **pp = &scope->children;
-    while (*pp) {
-        if (*pp == child) {
-            *pp = child->next;
-            scope->child_count--;
-            KC_COND_BROADCAST(&scope->cv);
-            break;
+    if (atomic_fetch_sub_explicit(&scope->pending, 1, memory_order_acq_rel) == 1) {
+        struct kc_scope_waiter *w = scope->waiters;
+        scope->waiters = NULL;
+        while (w) {
+            /* The record lives on the waiter's stack: read it before the wake. */
+            struct kc_scope_waiter *next = w->next;
+            kc_sched_enqueue_ready(w->sched, w->co);
+            w = next;
         }
-        pp = &(*pp)->next;
+        KC_COND_BROADCAST(&scope->cv);
     }
     KC_MUTEX_UNLOCK(&scope->mu);
-    free(child);
 }
 
-static struct kc_scope_child* kc_scope_child_add(kc_scope_t *scope, enum kc_scope_child_kind kind)
+static void kc_scope_child_complete(kc_scope_t *scope, struct kc_scope_child *child)
+{
+    if (!scope || !child) return;
+    if (child->kind == KC_SCOPE_CHILD_ACTOR) {
+        KC_MUTEX_LOCK(&scope->mu);
+        kc_scope_unlink_actor_locked(scope, child);
+        KC_MUTEX_UNLOCK(&scope->mu);
+    }
+    /* Recycle before the drop: a wait that sees zero may destroy the arena. */
+    struct kc_scope_child *head = atomic_load_explicit(&scope->spare, memory_order_relaxed);
+    do {
+        child->next = head;
+    } while (!atomic_compare_exchange_weak_explicit(&scope->spare, &head, child,
+                                                    memory_order_release, memory_order_relaxed));
+    kc_scope_pending_drop(scope);
+}
+
+static kc_arena_t *kc_scope_arena_locked(kc_scope_t *scope)
+{
+    if (!scope->arena) (void)kc_arena_create(&scope->arena, 0, KC_ARENA_F_SHARED);
+    return scope->arena;
+}
+
+kc_arena_t *kc_scope_arena(kc_scope_t *scope)
+{
+    if (!scope) return NULL;
+    KC_MUTEX_LOCK(&scope->mu);
+    kc_arena_t *a = kc_scope_arena_locked(scope);
+    KC_MUTEX_UNLOCK(&scope->mu);
+    return a;
+}
+
+/* New pending child record: 0, KC_ECANCELED once the scope is shutting
+ * down, or -ENOMEM. */
+static int kc_scope_child_add(kc_scope_t *scope, enum kc_scope_child_kind kind,
+                              struct kc_scope_child **out)
 {
-    struct kc_scope_child *child = (struct kc_scope_child*)calloc(1, sizeof(*child));
-    if (!child) return NULL;
+    KC_MUTEX_LOCK(&scope->mu);
+    if (scope->shutting_down) {
+        KC_MUTEX_UNLOCK(&scope->mu);
+        return KC_ECANCELED;
+    }
+    struct kc_scope_child *child = atomic_load_explicit(&scope->spare, memory_order_acquire);
+    while (child && !atomic_compare_exchange_weak_explicit(&scope->spare, &child, child->next,
+                                                           memory_order_acquire, memory_order_acquire)) {}
+    if (!child && kc_scope_arena_locked(scope))
+        child = (struct kc_scope_child*)kc_arena_alloc(scope->arena, sizeof(*child));
+    if (!child) {
+        KC_MUTEX_UNLOCK(&scope->mu);
+        return -ENOMEM;
+    }
+    memset(child, 0, sizeof(*child));
     child->kind = kind;
     child->scope = scope;
-    KC_MUTEX_LOCK(&scope->mu);
-    child->next = scope->children;
-    scope->children = child;
-    scope->child_count++;
+    if (kind == KC_SCOPE_CHILD_ACTOR) {
+        child->next = scope->actors;
+        if (child->next) child->next->prev = child;
+        scope->actors = child;
+        child->linked = 1;
+    }
+    atomic_fetch_add_explicit(&scope->pending, 1, memory_order_relaxed);
     KC_MUTEX_UNLOCK(&scope->mu);
-    return child;
+    *out = child;
+    return 0;
 }
 
 static void kc_scope_coro_entry(void *arg)
 {
-    struct kc_scope_coro_wrapper *wrap = (struct kc_scope_coro_wrapper*)arg;
-    wrap->fn(wrap->arg);
-    kc_scope_child_complete(wrap->scope, wrap->child);
-    free(wrap);
+    struct kc_scope_child *child = (struct kc_scope_child*)arg;
+    child->fn(child->arg);
+    kc_scope_child_complete(child->scope, child);
 }
 
 static void kc_scope_actor_on_done(void *arg)
@@ -100,20 +192,7 @@ static int kc_scope_compute_deadline(long timeout_ms, struct timespec *ts_out)
 {
     if (timeout_ms < 0) return 0;
     if (!ts_out) return -EINVAL;
-    struct timespec now;
-#ifdef CLOCK_MONOTONIC
-    clock_gettime(CLOCK_MONOTONIC, &now);
-#else
-    clock_gettime(CLOCK_REALTIME, &now);
-#endif
-    long sec = timeout_ms / 1000;
-    long nsec = (timeout_ms % 1000) * 1000000L;
-    ts_out->tv_sec = now.tv_sec + sec;
-    ts_out->tv_nsec = now.tv_nsec + nsec;
-    if (ts_out->tv_nsec >= 1000000000L) {
-        ts_out->tv_sec++;
-        ts_out->tv_nsec -= 1000000000L;
-    }
+    kc_clock_abstime_ms(ts_out, KC_COND_CLOCK, timeout_ms);
     return 0;
 }
 
@@ -126,9 +205,8 @@ int kc_scope_init(kc_scope_t **out, const kc_cancel_t *parent)
     if (rc != 0) { free(scope); return rc; }
     if (KC_MUTEX_INIT(&scope->mu) != 0) { kc_cancel_ctx_destroy(&scope->cancel_ctx); free(scope); return -ENOMEM; }
     if (KC_COND_INIT(&scope->cv) != 0) { KC_MUTEX_DESTROY(&scope->mu); kc_cancel_ctx_destroy(&scope->cancel_ctx); free(scope); return -ENOMEM; }
-    scope->shutting_down = 0;
-    scope->child_count = 0;
-    scope->children = NULL;
+    atomic_init(&scope->pending, 0);
+    atomic_init(&scope->spare, NULL);
     *out = scope;
     return 0;
 }
@@ -139,84 +217,32 @@ const kc_cancel_t* kc_scope_token(const kc_scope_t *scope)
     return scope->cancel_ctx.token;
 }
 
-static int kc_scope_collect_actors(kc_scope_t *scope, kc_actor_t **actors_out, int *count_out)
-{
-    if (!actors_out || !count_out) return -EINVAL;
-    int count = 0;
-    KC_MUTEX_LOCK(&scope->mu);
-    for (struct kc_scope_child *c = scope->children; c; c = c->next) {
-        if (c->kind == KC_SCOPE_CHILD_ACTOR && c->u.actor) count++;
-    }
-    kc_actor_t *actors = NULL;
-    if (count > 0) {
-        actors = (kc_actor_t*)calloc((size_t)count, sizeof(kc_actor_t));
-        if (!actors) {
-            KC_MUTEX_UNLOCK(&scope->mu);
-            return -ENOMEM;
-        }
-        int idx = 0;
-        for (struct kc_scope_child *c = scope->children; c; c = c->next) {
-            if (c->kind == KC_SCOPE_CHILD_ACTOR && c->u.actor) {
-                actors[idx++] = c->u.actor;
-            }
-        }
-    }
-    KC_MUTEX_UNLOCK(&scope->mu);
-    *actors_out = actors;
-    *count_out = count;
-    return 0;
-}
-
 void kc_scope_cancel(kc_scope_t *scope)
 {
     if (!scope) return;
     kc_cancel_trigger(scope->cancel_ctx.token);
     KC_MUTEX_LOCK(&scope->mu);
     scope->shutting_down = 1;
-    KC_MUTEX_UNLOCK(&scope->mu);
-
-    kc_actor_t *actors = NULL;
-    int actor_count = 0;
-    if (kc_scope_collect_actors(scope, &actors, &actor_count) == 0 && actors) {
-        for (int i = 0; i < actor_count; ++i) {
-            kc_actor_cancel(actors[i]);
-        }
-        free(actors);
-    }
-}
-
-int kc_scope_launch(kc_scope_t *scope, kcoro_fn_t fn, void *arg,
-                    size_t stack_size, kcoro_t **out_co)
-{
-    if (!scope || !fn) return -EINVAL;
-
-    KC_MUTEX_LOCK(&scope->mu);
-    if (scope->shutting_down) {
+    /* Join the actors one at a time: kc_actor_cancel runs the child's
+     * on_done, which takes mu, so it is called with mu dropped. */
+    for (struct kc_scope_child *c; (c = scope->actors); ) {
+        kc_actor_t actor = c->u.actor;
+        kc_scope_unlink_actor_locked(scope, c);
         KC_MUTEX_UNLOCK(&scope->mu);
-        return KC_ECANCELED;
+        kc_actor_cancel(actor);
+        KC_MUTEX_LOCK(&scope->mu);
     }
     KC_MUTEX_UNLOCK(&scope->mu);
+}
 
-    struct kc_scope_child *child = kc_scope_child_add(scope, KC_SCOPE_CHILD_CORO);
-    if (!child) return -ENOMEM;
-
-    struct kc_scope_coro_wrapper *wrap = (struct kc_scope_coro_wrapper*)calloc(1, sizeof(*wrap));
-    if (!wrap) {
-        kc_scope_child_complete(scope, child);
-        return -ENOMEM;
-    }
-
-    wrap->scope = scope;
-    wrap->fn = fn;
-    wrap->arg = arg;
-    wrap->child = child;
-
+/* Run child->fn(child->arg) as a coroutine child of its scope. */
+static int kc_scope_spawn(struct kc_scope_child *child, size_t stack_size, kcoro_t **out_co)
+{
     kc_sched_t *sched = kc_sched_default();
     kcoro_t *co = NULL;
-    int rc = kc_spawn_co(sched, kc_scope_coro_entry, wrap, stack_size, &co);
+    int rc = kc_spawn_co(sched, kc_scope_coro_entry, child, stack_size, &co);
     if (rc != 0) {
-        kc_scope_child_complete(scope, child);
-        free(wrap);
+        kc_scope_child_complete(child->scope, child);
         return rc;
     }
     child->u.coro = co;
@@ -224,6 +250,19 @@ int kc_scope_launch(kc_scope_t *scope, kcoro_fn_t fn, void *arg,
     return 0;
 }
 
+int kc_scope_launch(kc_scope_t *scope, kcoro_fn_t fn, void *arg,
+                    size_t stack_size, kcoro_t **out_co)
+{
+    if (!scope || !fn) return -EINVAL;
+
+    struct kc_scope_child *child = NULL;
+    int rc = kc_scope_child_add(scope, KC_SCOPE_CHILD_CORO, &child);
+    if (rc != 0) return rc;
+    child->fn = fn;
+    child->arg = arg;
+    return kc_scope_spawn(child, stack_size, out_co);
+}
+
 kc_actor_t kc_scope_actor(kc_scope_t *scope, const kc_actor_ctx_t *ctx)
 {
     if (!scope || !ctx) return NULL;
@@ -239,8 +278,8 @@ kc_actor_t kc_scope_actor(kc_scope_t *scope, const kc_actor_ctx_t *ctx)
     kc_actor_t actor = kc_actor_start_ex(&ex);
     if (!actor) return NULL;
 
-    struct kc_scope_child *child = kc_scope_child_add(scope, KC_SCOPE_CHILD_ACTOR);
-    if (!child) {
+    struct kc_scope_child *child = NULL;
+    if (kc_scope_child_add(scope, KC_SCOPE_CHILD_ACTOR, &child) != 0) {
         kc_actor_cancel(actor);
         return NULL;
     }
@@ -251,47 +290,108 @@ kc_actor_t kc_scope_actor(kc_scope_t *scope, const kc_actor_ctx_t *ctx)
 
 static void kc_scope_producer_entry(void *arg)
 {
-    struct kc_scope_producer_state *st = (struct kc_scope_producer_state*)arg;
-    if (st->fn) st->fn(st->chan, st->user);
-    kc_chan_close(st->chan);
-    free(st);
+    struct kc_scope_child *child = (struct kc_scope_child*)arg;
+    child->produce(child->chan, child->user);
+    kc_chan_close(child->chan);
 }
 
 kc_chan_t* kc_scope_produce(kc_scope_t *scope, int kind, size_t elem_sz, size_t capacity,
                             kc_producer_fn fn, void *user)
 {
     if (!scope || !fn) return NULL;
+    KC_MUTEX_LOCK(&scope->mu);
+    int down = scope->shutting_down;
+    KC_MUTEX_UNLOCK(&scope->mu);
+    if (down) return NULL;
+
     kc_chan_t *ch = NULL;
     if (kc_chan_make(&ch, kind, elem_sz, capacity) != 0) return NULL;
-
-    struct kc_scope_producer_state *state = calloc(1, sizeof(*state));
-    if (!state) {
+    struct kc_scope_child *child = NULL;
+    if (kc_scope_child_add(scope, KC_SCOPE_CHILD_CORO, &child) != 0) {
         kc_chan_destroy(ch);
         return NULL;
     }
-    state->chan = ch;
-    state->fn = fn;
-    state->user = user;
-
-    int rc = kc_scope_launch(scope, kc_scope_producer_entry, state, 0, NULL);
-    if (rc != 0) {
+    child->fn = kc_scope_producer_entry;
+    child->arg = child;
+    child->chan = ch;
+    child->produce = fn;
+    child->user = user;
+    if (kc_scope_spawn(child, 0, NULL) != 0) {
         kc_chan_destroy(ch);
-        free(state);
         return NULL;
     }
     return ch;
 }
 
+/* Runs on the worker after the waiter switched out: only now may the last
+ * child see it on the list. */
+static void kc_scope_park_release(void *arg)
+{
+    struct kc_scope_waiter *w = (struct kc_scope_waiter*)arg;
+    if (w->deadline_ns > 0)
+        w->timer = kc_sched_timer_wake_at(w->sched, w->co, (unsigned long long)w->deadline_ns);
+    KC_MUTEX_UNLOCK(&w->scope->mu);
+}
+
+static void kc_scope_waiter_remove_locked(kc_scope_t *scope, struct kc_scope_waiter *w)
+{
+    for (struct kc_scope_waiter **pp = &scope->waiters; *pp; pp = &(*pp)->next) {
+        if (*pp == w) { *pp = w->next; return; }
+    }
+}
+
+/* Park the calling worker coroutine until pending reaches zero. Returns 0,
+ * KC_ETIME, or 1 when it could not park (caller waits as a thread). */
+static int kc_scope_wait_co(kc_scope_t *scope, kcoro_t *co, kc_sched_t *sched, long timeout_ms)
+{
+    long long deadline_ns = -1;
+    if (timeout_ms > 0) deadline_ns = (long long)kc_clock_ns() + (long long)timeout_ms * 1000000LL;
+    struct kc_scope_waiter local = { .co = co, .sched = sched, .scope = scope,
+                                     .deadline_ns = deadline_ns };
+    struct kc_scope_waiter *w = kcoro_park_record(co, &local, sizeof(local));
+    if (!w) return 1;
+    int rc = 0;
+    KC_MUTEX_LOCK(&scope->mu);
+    while (atomic_load(&scope->pending) > 0) {
+        if (deadline_ns > 0 && (long long)kc_clock_ns() >= deadline_ns) { rc = KC_ETIME; break; }
+        w->next = scope->waiters;
+        scope->waiters = w;
+        w->timer = (kc_timer_handle_t){0};
+        if (kc_sched_park_release(kc_scope_park_release, w) != 0) {
+            kc_scope_waiter_remove_locked(scope, w);
+            rc = 1;
+            break;
+        }
+        (void)kc_sched_timer_cancel(sched, w->timer);
+        KC_MUTEX_LOCK(&scope->mu);
+        /* Timer wake: still listed. */
+        kc_scope_waiter_remove_locked(scope, w);
+    }
+    KC_MUTEX_UNLOCK(&scope->mu);
+    kcoro_park_record_free(w, &local);
+    return rc;
+}
+
 int kc_scope_wait_all(kc_scope_t *scope, long timeout_ms)
 {
     if (!scope) return -EINVAL;
-    if (timeout_ms == 0) {
+    if (atomic_load_explicit(&scope->pending, memory_order_acquire) == 0 || timeout_ms == 0) {
+        /* Zero is written under mu: pass through it so the last child is
+         * done with the scope before the caller may destroy it. */
         KC_MUTEX_LOCK(&scope->mu);
-        int rc = (scope->child_count == 0) ? 0 : KC_EAGAIN;
+        int rc = (atomic_load(&scope->pending) == 0) ? 0 : KC_EAGAIN;
         KC_MUTEX_UNLOCK(&scope->mu);
         return rc;
     }
 
+    /* A worker coroutine parks; a thread blocks on the condvar. */
+    kcoro_t *co = kcoro_current();
+    kc_sched_t *sched = kc_sched_current();
+    if (co && sched) {
+        int rc = kc_scope_wait_co(scope, co, sched, timeout_ms);
+        if (rc != 1) return rc;
+    }
+
     struct timespec ts;
     struct timespec *deadline = NULL;
     if (timeout_ms > 0) {
@@ -301,7 +401,7 @@ int kc_scope_wait_all(kc_scope_t *scope, long timeout_ms)
 
     KC_MUTEX_LOCK(&scope->mu);
     int rc = 0;
-    while (scope->child_count > 0) {
+    while (atomic_load(&scope->pending) > 0) {
         if (timeout_ms < 0) {
             KC_COND_WAIT(&scope->cv, &scope->mu);
         } else {
@@ -316,21 +416,11 @@ int kc_scope_wait_all(kc_scope_t *scope, long timeout_ms)
 void kc_scope_destroy(kc_scope_t *scope)
 {
     if (!scope) return;
+    /* Cancel joins every actor child; the wait covers the coroutines. */
     kc_scope_cancel(scope);
     kc_scope_wait_all(scope, -1);
-    KC_MUTEX_LOCK(&scope->mu);
-    struct kc_scope_child *c = scope->children;
-    scope->children = NULL;
-    scope->child_count = 0;
-    KC_MUTEX_UNLOCK(&scope->mu);
-    while (c) {
-        struct kc_scope_child *next = c->next;
-        if (c->kind == KC_SCOPE_CHILD_ACTOR && c->u.actor) {
-            kc_actor_stop(c->u.actor);
-        }
-        free(c);
-        c = next;
-    }
+    /* Child records were carved from the arena: it frees them all. */
+    kc_arena_destroy(scope->arena);
     KC_COND_DESTROY(&scope->cv);
     KC_MUTEX_DESTROY(&scope->mu);
     kc_cancel_ctx_destroy(&scope->cancel_ctx);
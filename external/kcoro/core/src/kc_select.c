@@ -8,8 +8,12 @@
 #include <stdatomic.h>
 
 #include "kc_select_internal.h"
+#include "kc_cancel_internal.h"
+#include "kc_clock_internal.h"
+#include "kcoro_share_internal.h"
 #include "../../include/kcoro_sched.h"
 #include "../../include/kcoro_port.h"
+#include "../../include/kcoro_config.h"
 
 static int kc_select_reserve(struct kc_select *sel, int additional)
 {
@@ -20,20 +24,77 @@ static int kc_select_reserve(struct kc_select *sel, int additional)
     while (new_cap < need) new_cap *= 2;
     struct kc_select_clause_internal *nb = realloc(sel->clauses, (size_t)new_cap * sizeof(*nb));
     if (!nb) return -ENOMEM;
+    /* New positions start with zeroed stats */
+    memset(nb + sel->capacity, 0, (size_t)(new_cap - sel->capacity) * sizeof(*nb));
     sel->clauses = nb;
+    int *no = realloc(sel->order, (size_t)new_cap * sizeof(*no));
+    if (!no) return -ENOMEM;
+    sel->order = no;
     sel->capacity = new_cap;
     return 0;
 }
 
+/* PRIORITY probe order: stable insertion sort by descending priority, so
+ * equal priorities keep registration order. Rebuilt only after a change. */
+static void kc_select_build_order(struct kc_select *sel)
+{
+    for (int i = 0; i < sel->count; ++i) {
+        int p = sel->clauses[i].prio, j = i;
+        while (j > 0 && sel->clauses[sel->order[j - 1]].prio < p) {
+            sel->order[j] = sel->order[j - 1];
+            --j;
+        }
+        sel->order[j] = i;
+    }
+    sel->order_dirty = 0;
+}
+
+/* First position of this wait's probe and registration passes. */
+static int kc_select_start(struct kc_select *sel)
+{
+    switch (sel->policy) {
+    case KC_SELECT_POLICY_RANDOM:
+        return (int)(kc_sched_rand() % (uint32_t)sel->count);
+    case KC_SELECT_POLICY_ROUND_ROBIN:
+        return sel->rr_next < sel->count ? sel->rr_next : 0;
+    case KC_SELECT_POLICY_PRIORITY:
+        if (sel->order_dirty) kc_select_build_order(sel);
+        return 0;
+    default:
+        return 0;
+    }
+}
+
+/* Clause probed j-th in a pass starting at start. */
+static inline int kc_select_at(const struct kc_select *sel, int start, int j)
+{
+    int pos = start + j;
+    if (pos >= sel->count) pos -= sel->count;
+    return sel->policy == KC_SELECT_POLICY_PRIORITY ? sel->order[pos] : pos;
+}
+
+/* Book a completed clause (one of several for kc_select_wait_many). */
+static void kc_select_account_win(struct kc_select *sel, int winner)
+{
+    if (winner < 0 || winner >= sel->count) return;
+    struct kc_select_clause_internal *w = &sel->clauses[winner];
+    w->stats.wins++;
+    w->stats.policy = sel->policy;
+    sel->rr_next = winner + 1;
+}
+
+/* Book the outcome of one wait against its first and winning clauses. */
+static void kc_select_account(struct kc_select *sel, int first, int winner)
+{
+    struct kc_select_clause_internal *f = &sel->clauses[first];
+    f->stats.first++;
+    f->stats.policy = sel->policy;
+    kc_select_account_win(sel, winner);
+}
+
 static long long kc_select_now_ns(void)
 {
-    struct timespec ts;
-#ifdef CLOCK_MONOTONIC
-    clock_gettime(CLOCK_MONOTONIC, &ts);
-#else
-    clock_gettime(CLOCK_REALTIME, &ts);
-#endif
-    return (long long)ts.tv_sec * 1000000000LL + (long long)ts.tv_nsec;
+    return (long long)kc_clock_ns();
 }
 
 int kc_select_create(kc_select_t **out, const kc_cancel_t *cancel)
@@ -57,6 +118,7 @@ void kc_select_destroy(kc_select_t *sel)
 {
     if (!sel) return;
     free(sel->clauses);
+    free(sel->order);
     free(sel);
 }
 
@@ -64,6 +126,32 @@ void kc_select_reset(kc_select_t *sel)
 {
     if (!sel) return;
     sel->count = 0;
+    sel->order_dirty = 1;
+}
+
+int kc_select_set_policy(kc_select_t *sel, enum kc_select_policy policy)
+{
+    if (!sel || policy < KC_SELECT_POLICY_ORDERED || policy > KC_SELECT_POLICY_PRIORITY) return -EINVAL;
+    sel->policy = policy;
+    sel->order_dirty = 1;
+    return 0;
+}
+
+int kc_select_set_priority(kc_select_t *sel, int clause_index, int priority)
+{
+    if (!sel || clause_index < 0 || clause_index >= sel->count) return -EINVAL;
+    sel->clauses[clause_index].prio = priority;
+    sel->clauses[clause_index].stats.priority = priority;
+    sel->order_dirty = 1;
+    return 0;
+}
+
+int kc_select_get_clause_stats(const kc_select_t *sel, int clause_index,
+                               struct kc_select_clause_stats *out)
+{
+    if (!sel || !out || clause_index < 0 || clause_index >= sel->count) return -EINVAL;
+    *out = sel->clauses[clause_index].stats;
+    return 0;
 }
 
 void kc_select_reset_state(kc_select_t *sel)
@@ -104,6 +192,11 @@ int kc_select_try_complete(kc_select_t *sel, int clause_index, int result)
     return 0;
 }
 
+void kc_select_set_result(kc_select_t *sel, int result)
+{
+    if (sel) atomic_store(&sel->result, result);
+}
+
 void kc_select_get_result(const kc_select_t *sel, int *clause_index, int *result)
 {
     if (!sel) return;
@@ -135,7 +228,8 @@ int kc_select_is_completed(const kc_select_t *sel)
     return st != KC_SELECT_REG;
 }
 
-int kc_select_add_recv(kc_select_t *sel, kc_chan_t *chan, void *out)
+int kc_select_add_recv_hooks(kc_select_t *sel, kc_chan_t *chan, void *out,
+                             const struct kc_select_hooks *hooks, void *arg)
 {
     if (!sel || !chan || !out) return -EINVAL;
     int rc = kc_select_reserve(sel, 1);
@@ -143,10 +237,23 @@ int kc_select_add_recv(kc_select_t *sel, kc_chan_t *chan, void *out)
     sel->clauses[sel->count].kind = KC_SELECT_CLAUSE_RECV;
     sel->clauses[sel->count].chan = chan;
     sel->clauses[sel->count].data.recv_buf = out;
+    sel->clauses[sel->count].ptr = (kc_chan_capabilities(chan) & KC_CHAN_CAP_PTR) != 0;
+    sel->clauses[sel->count].prio = 0;
+    sel->clauses[sel->count].hooks = hooks;
+    sel->clauses[sel->count].hook_arg = arg;
+    sel->clauses[sel->count].armed = 0;
+    sel->clauses[sel->count].waiter = NULL;
+    sel->clauses[sel->count].stats.priority = 0;
     sel->count++;
+    sel->order_dirty = 1;
     return 0;
 }
 
+int kc_select_add_recv(kc_select_t *sel, kc_chan_t *chan, void *out)
+{
+    return kc_select_add_recv_hooks(sel, chan, out, NULL, NULL);
+}
+
 int kc_select_add_send(kc_select_t *sel, kc_chan_t *chan, const void *msg)
 {
     if (!sel || !chan || !msg) return -EINVAL;
@@ -155,7 +262,14 @@ int kc_select_add_send(kc_select_t *sel, kc_chan_t *chan, const void *msg)
     sel->clauses[sel->count].kind = KC_SELECT_CLAUSE_SEND;
     sel->clauses[sel->count].chan = chan;
     sel->clauses[sel->count].data.send_buf = msg;
+    sel->clauses[sel->count].ptr = (kc_chan_capabilities(chan) & KC_CHAN_CAP_PTR) != 0;
+    sel->clauses[sel->count].prio = 0;
+    sel->clauses[sel->count].hooks = NULL;
+    sel->clauses[sel->count].armed = 0;
+    sel->clauses[sel->count].waiter = NULL;
+    sel->clauses[sel->count].stats.priority = 0;
     sel->count++;
+    sel->order_dirty = 1;
     return 0;
 }
 
@@ -167,35 +281,82 @@ static void kc_select_cancel_all(kc_select_t *sel)
     }
 }
 
-int kc_select_wait(kc_select_t *sel, long timeout_ms, int *selected_index, int *op_result)
+struct kc_select_park {
+    kc_select_t *sel;
+    kc_sched_t *sched;
+    kcoro_t *co;
+    long long deadline_ns;
+    kc_timer_handle_t timer;
+};
+
+/* Runs on the worker after the waiting coroutine switched out. A clause that
+ * completed (or a token that fired) while it was still running saw nothing
+ * to wake, so the wake is ours. */
+static void kc_select_park_release(void *arg)
 {
-    if (!sel) return -EINVAL;
-    if (sel->count == 0) return -EINVAL;
+    struct kc_select_park *sp = (struct kc_select_park*)arg;
+    kc_select_t *sel = sp->sel;
+    kc_sched_t *s = sp->sched;
+    kcoro_t *co = sp->co;
+    if (sp->deadline_ns > 0)
+        sp->timer = kc_sched_timer_wake_at(s, co, (unsigned long long)sp->deadline_ns);
+    int cancelled = kc_cancel_wait_arm(co);
+    if (cancelled || atomic_load(&sel->state) != KC_SELECT_REG) kc_sched_enqueue_ready(s, co);
+}
 
-    /* Fast probe */
-    for (int i = 0; i < sel->count; ++i) {
-        struct kc_select_clause_internal *cl = &sel->clauses[i];
-        int rc = (cl->kind == KC_SELECT_CLAUSE_RECV)
-            ? kc_chan_recv(cl->chan, cl->data.recv_buf, 0)
-            : kc_chan_send(cl->chan, cl->data.send_buf, 0);
-        if (rc != KC_EAGAIN) {
-            if (selected_index) *selected_index = i;
-            if (op_result) *op_result = rc;
-            return rc;
+/* Move a still-registered select to a terminal state of our own. */
+static void kc_select_finish(kc_select_t *sel, int state, int result)
+{
+    int expected = KC_SELECT_REG;
+    if (atomic_compare_exchange_strong(&sel->state, &expected, state)) {
+        atomic_store(&sel->winner_index, -1);
+        atomic_store(&sel->result, result);
+    }
+}
+
+/* Non-blocking attempt at one clause. Pointer channels have their own
+ * entry points; the clause buffer carries the descriptor. */
+static int kc_select_probe(struct kc_select_clause_internal *cl)
+{
+    if (cl->ptr) {
+        if (cl->kind == KC_SELECT_CLAUSE_RECV) {
+            struct kc_chan_ptrmsg *m = (struct kc_chan_ptrmsg*)cl->data.recv_buf;
+            return kc_chan_recv_ptr(cl->chan, &m->ptr, &m->len, 0);
         }
+        const struct kc_chan_ptrmsg *m = (const struct kc_chan_ptrmsg*)cl->data.send_buf;
+        return kc_chan_send_ptr(cl->chan, m->ptr, m->len, 0);
     }
+    return (cl->kind == KC_SELECT_CLAUSE_RECV)
+        ? kc_chan_recv(cl->chan, cl->data.recv_buf, 0)
+        : kc_chan_send(cl->chan, cl->data.send_buf, 0);
+}
 
-    if (timeout_ms == 0) {
-        if (op_result) *op_result = KC_EAGAIN;
-        return KC_EAGAIN;
+/* Register every clause (from start, in the policy's order) and park until
+ * one completes, the deadline passes or the token fires. The registrations
+ * are reaped before it returns; *win_idx gets the winner, or -1. Runs in a
+ * coroutine. */
+static int kc_select_block(kc_select_t *sel, long timeout_ms, int start, int *win_idx)
+{
+    kcoro_t *waiter = kcoro_current();
+
+    /* Hooked clauses arm before anything registers: an arm that parks must
+     * not be woken by a clause completing meanwhile. */
+    int arm_idx = -1, arm_rc = 0;
+    for (int j = 0; j < sel->count && arm_idx < 0; ++j) {
+        int i = kc_select_at(sel, start, j);
+        struct kc_select_clause_internal *cl = &sel->clauses[i];
+        if (!cl->hooks) continue;
+        cl->armed = 1;
+        int rc = cl->hooks->arm ? cl->hooks->arm(cl->hook_arg) : 0;
+        if (rc != 0) { arm_idx = i; arm_rc = rc; }
     }
 
     kc_select_reset_state(sel);
-    kcoro_t *waiter = kcoro_current();
-    if (!waiter) return -EINVAL;
     kc_select_set_waiter(sel, waiter);
+    if (arm_idx >= 0) kc_select_try_complete(sel, arm_idx, arm_rc);
 
-    for (int i = 0; i < sel->count; ++i) {
+    for (int j = 0; j < sel->count && arm_idx < 0; ++j) {
+        int i = kc_select_at(sel, start, j);
         struct kc_select_clause_internal *cl = &sel->clauses[i];
         int rc = (cl->kind == KC_SELECT_CLAUSE_RECV)
             ? kc_chan_select_register_recv(cl->chan, sel, i)
@@ -206,51 +367,149 @@ int kc_select_wait(kc_select_t *sel, long timeout_ms, int *selected_index, int *
         }
     }
 
-    int st = atomic_load(&sel->state);
-    int infinite = (timeout_ms < 0) && (sel->cancel == NULL);
+    /* Park until a clause completes, the deadline timer fires or the token
+     * wakes us (kc_cancel_internal.h). Without a registration on the token
+     * (shared-stack OOM) it is polled every KCORO_CANCEL_SLICE_MS instead. */
     long long deadline_ns = -1;
     if (timeout_ms > 0) deadline_ns = kc_select_now_ns() + (long long)timeout_ms * 1000000LL;
-
-    if (st == KC_SELECT_REG) {
-        if (infinite) {
-            kcoro_park();
-        } else {
-            /* Fallback legacy yield loop for timeout/cancel cases */
-            for (;;) {
-                st = atomic_load(&sel->state);
-                if (st != KC_SELECT_REG) break;
-                if (sel->cancel && kc_cancel_is_set(sel->cancel)) {
-                    int expected = KC_SELECT_REG;
-                    if (atomic_compare_exchange_strong(&sel->state, &expected, KC_SELECT_CANCELED)) {
-                        atomic_store(&sel->winner_index, -1);
-                        atomic_store(&sel->result, KC_ECANCELED);
-                    }
-                    break;
-                }
-                if (timeout_ms > 0) {
-                    long long now = kc_select_now_ns();
-                    if (now >= deadline_ns) {
-                        int expected2 = KC_SELECT_REG;
-                        if (atomic_compare_exchange_strong(&sel->state, &expected2, KC_SELECT_TIMED_OUT)) {
-                            atomic_store(&sel->winner_index, -1);
-                            atomic_store(&sel->result, KC_ETIME);
-                        }
-                        break;
-                    }
-                }
-                kcoro_yield();
-            }
+    struct kc_cancel_wait local;
+    struct kc_cancel_wait *cw = NULL;
+    int cancelled = 0;
+    if (sel->cancel && atomic_load(&sel->state) == KC_SELECT_REG)
+        cw = kc_cancel_wait_begin(&local, sel->cancel, &cancelled);
+    for (;;) {
+        if (atomic_load(&sel->state) != KC_SELECT_REG) break;
+        if (cancelled || kc_cancel_wait_fired(waiter) || (sel->cancel && kc_cancel_is_set(sel->cancel))) {
+            kc_select_finish(sel, KC_SELECT_CANCELED, KC_ECANCELED);
+            continue;
+        }
+        long long now = (deadline_ns > 0 || (sel->cancel && !cw)) ? kc_select_now_ns() : 0;
+        if (deadline_ns > 0 && now >= deadline_ns) {
+            kc_select_finish(sel, KC_SELECT_TIMED_OUT, KC_ETIME);
+            continue;
         }
+        struct kc_select_park sp_local = { .sel = sel, .sched = kc_sched_current(), .co = waiter,
+                                           .deadline_ns = deadline_ns, .timer = {0} };
+        if (sel->cancel && !cw) {
+            long long slice_ns = now + (long long)KCORO_CANCEL_SLICE_MS * 1000000LL;
+            if (sp_local.deadline_ns <= 0 || slice_ns < sp_local.deadline_ns) sp_local.deadline_ns = slice_ns;
+        }
+        struct kc_select_park *sp = sp_local.sched ? kcoro_park_record(waiter, &sp_local, sizeof(sp_local)) : NULL;
+        if (!sp || kc_sched_park_release(kc_select_park_release, sp) != 0) {
+            /* Not on a worker (or no memory for the record): cooperative retry. */
+            kcoro_park_record_free(sp, &sp_local);
+            kcoro_yield();
+            continue;
+        }
+        if (kc_cancel_wait_disarm(waiter)) cancelled = 1;
+        (void)kc_sched_timer_cancel(sp->sched, sp->timer);
+        kcoro_park_record_free(sp, &sp_local);
     }
+    kc_cancel_wait_end(cw);
+
+    /* Remove outstanding registrations first: taking each channel's lock
+     * waits out a delivery that claimed the select and is still moving
+     * the element or settling the result. */
+    kc_select_cancel_all(sel);
 
     /* Read result */
     int final_result = atomic_load(&sel->result);
-    int win_idx = atomic_load(&sel->winner_index);
-    if (selected_index) *selected_index = win_idx;
-    if (op_result) *op_result = final_result;
+    int won = atomic_load(&sel->winner_index);
+    *win_idx = won;
 
-    kc_select_cancel_all(sel); /* remove any outstanding registrations */
     /* Do not reset state here; leave terminal state until reuse or destroy to avoid races */
     sel->waiter = NULL;
+    for (int i = 0; i < sel->count; ++i) {
+        struct kc_select_clause_internal *cl = &sel->clauses[i];
+        if (!cl->armed) continue;
+        cl->armed = 0;
+        if (cl->hooks->done) cl->hooks->done(cl->hook_arg, i == won);
+    }
+    return final_result;
+}
+
+int kc_select_wait(kc_select_t *sel, long timeout_ms, int *selected_index, int *op_result)
+{
+    if (!sel) return -EINVAL;
+    if (sel->count == 0) return -EINVAL;
+
+    /* Fast probe, in the policy's order */
+    int start = kc_select_start(sel);
+    int first = kc_select_at(sel, start, 0);
+    for (int j = 0; j < sel->count; ++j) {
+        int i = kc_select_at(sel, start, j);
+        struct kc_select_clause_internal *cl = &sel->clauses[i];
+        int rc = kc_select_probe(cl);
+        if (rc != KC_EAGAIN) {
+            kc_select_account(sel, first, i);
+            if (selected_index) *selected_index = i;
+            if (op_result) *op_result = rc;
+            return rc;
+        }
+    }
+
+    if (timeout_ms == 0) {
+        kc_select_account(sel, first, -1);
+        if (op_result) *op_result = KC_EAGAIN;
+        return KC_EAGAIN;
+    }
+
+    if (!kcoro_current()) return -EINVAL;
+    int win_idx = -1;
+    int final_result = kc_select_block(sel, timeout_ms, start, &win_idx);
+    if (selected_index) *selected_index = win_idx;
+    if (op_result) *op_result = final_result;
+    kc_select_account(sel, first, win_idx);
     return final_result;
 }
+
+/* One pass over the clauses from start, skipping `skip`: every clause that
+ * completes is appended to idx/res (up to max, from *n on). */
+static void kc_select_harvest(kc_select_t *sel, int start, int skip, int *idx, int *res, int max, int *n)
+{
+    for (int j = 0; j < sel->count && *n < max; ++j) {
+        int i = kc_select_at(sel, start, j);
+        if (i == skip) continue;
+        int rc = kc_select_probe(&sel->clauses[i]);
+        if (rc == KC_EAGAIN) continue;
+        idx[*n] = i;
+        if (res) res[*n] = rc;
+        ++*n;
+    }
+}
+
+int kc_select_wait_many(kc_select_t *sel, long timeout_ms, int *ready_indices, int *op_results,
+                        int max, int *n_ready)
+{
+    if (n_ready) *n_ready = 0;
+    if (!sel || !ready_indices || max <= 0 || !n_ready) return -EINVAL;
+    if (sel->count == 0) return -EINVAL;
+
+    int start = kc_select_start(sel);
+    int first = kc_select_at(sel, start, 0);
+    int n = 0;
+    kc_select_harvest(sel, start, -1, ready_indices, op_results, max, &n);
+    if (n == 0) {
+        if (timeout_ms == 0) {
+            kc_select_account(sel, first, -1);
+            return KC_EAGAIN;
+        }
+        if (!kcoro_current()) return -EINVAL;
+        int win_idx = -1;
+        int rc = kc_select_block(sel, timeout_ms, start, &win_idx);
+        if (win_idx < 0) {
+            kc_select_account(sel, first, -1);
+            return rc;
+        }
+        ready_indices[n] = win_idx;
+        if (op_results) op_results[n] = rc;
+        n = 1;
+        /* Whatever else became ready while we slept comes along. */
+        kc_select_harvest(sel, start, win_idx, ready_indices, op_results, max, &n);
+    }
+
+    kc_select_account(sel, first, ready_indices[0]);
+    for (int k = 1; k < n; ++k) kc_select_account_win(sel, ready_indices[k]);
+    *n_ready = n;
+    return 0;
+}
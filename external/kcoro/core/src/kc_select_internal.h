@@ -4,6 +4,8 @@
 #include "../../include/kcoro.h"
 #include "../../include/kcoro_core.h"
 
+struct kc_waiter;
+
 struct kc_select_clause_internal {
     enum kc_select_clause_kind kind;
     kc_chan_t *chan;
@@ -11,6 +13,13 @@ struct kc_select_clause_internal {
         void       *recv_buf;
         const void *send_buf;
     } data;
+    int ptr;   /* pointer channel: the buffer holds a struct kc_chan_ptrmsg */
+    int prio;
+    const struct kc_select_hooks *hooks; /* kc_select_add_recv_hooks, else NULL */
+    void *hook_arg;
+    int armed;                           /* arm ran in this wait */
+    struct kc_waiter *waiter;            /* registration on chan, reaped by kc_chan_select_cancel */
+    struct kc_select_clause_stats stats; /* by position: survives reset */
 };
 
 enum kc_select_state {
@@ -24,6 +33,10 @@ struct kc_select {
     struct kc_select_clause_internal *clauses;
     int count;
     int capacity;
+    int policy;      /* enum kc_select_policy */
+    int rr_next;     /* ROUND_ROBIN: first clause of the next wait */
+    int *order;      /* PRIORITY: clause indices by priority (capacity long) */
+    int order_dirty; /* clauses or priorities changed since order was built */
     const kc_cancel_t *cancel;
     kcoro_t *waiter;
     _Atomic int state;
@@ -35,6 +48,9 @@ void kc_select_set_waiter(kc_select_t *sel, kcoro_t *co);
 int  kc_select_has_waiter(const kc_select_t *sel);
 int  kc_select_try_complete(kc_select_t *sel, int clause_index, int result);
 void kc_select_get_result(const kc_select_t *sel, int *clause_index, int *result);
+/* Replace the result of a claimed select (the winning clause failed after
+ * claiming); the waiter reads it once it has drained the clause channels. */
+void kc_select_set_result(kc_select_t *sel, int result);
 void* kc_select_recv_buffer(kc_select_t *sel, int clause_index);
 const void* kc_select_send_buffer(kc_select_t *sel, int clause_index);
 void kc_select_reset_state(kc_select_t *sel);
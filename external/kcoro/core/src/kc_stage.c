@@ -0,0 +1,218 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/*
+ * kc_stage.c — N-buffer staging between a producer and a consumer stage
+ * ----------------------------------------------------------------------
+ *
+ * Layout
+ * - One kc_region_alloc region holds nbufs buffers `stride` bytes apart
+ *   (buf_size rounded up to a cache line). Buffer i is named by its index
+ *   everywhere; descriptors carry base + i * stride.
+ * - Two buffered channels of indices, each nbufs deep, carry ownership: the
+ *   free channel starts full and feeds writers, the ready channel carries
+ *   published buffers to readers in publish order. Neither can overflow, as
+ *   every index is in at most one of them.
+ *
+ * Ownership
+ * - state[i] is FREE, WRITING, READY or READING. The channel that hands an
+ *   index out moves it to WRITING / READING; publish and release must find
+ *   it there (a compare-and-swap), so a buffer published twice or released
+ *   by a writer is refused instead of being handed to two owners.
+ *
+ * Stalls
+ * - An acquire first tries its channel without waiting; only when that
+ *   misses does it time the blocking receive, so the counters measure
+ *   waiting and not the cost of the hand-off itself.
+ */
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include "../../include/kcoro.h"
+#include "../../include/kcoro_zcopy.h"
+#include "../../include/kcoro_port.h"
+#include "../../include/kcoro_core.h"
+#include "kc_chan_internal.h"
+
+#define STAGE_ALIGN 64
+
+enum { STAGE_FREE, STAGE_WRITING, STAGE_READY, STAGE_READING };
+
+struct kc_stage {
+    kc_region_t *reg;
+    unsigned long region_id;
+    unsigned char *base;
+    size_t buf_size, stride;
+    uint32_t n;
+    _Atomic(uint8_t) *state;
+    size_t *len;                /* published bytes, per buffer */
+    kc_chan_t *free_ch, *ready_ch;
+    atomic_int closed;
+    _Atomic unsigned long published, consumed;
+    _Atomic unsigned long write_stalls, read_stalls, write_stall_ns, read_stall_ns;
+};
+
+/* Index of the buffer d points into, or UINT32_MAX. */
+static uint32_t stage_index(const kc_stage_t *st, const kc_zdesc_t *d)
+{
+    const unsigned char *p = d->addr;
+    if (!p || p < st->base || p >= st->base + (size_t)st->n * st->stride) return UINT32_MAX;
+    return (uint32_t)((size_t)(p - st->base) / st->stride);
+}
+
+static void stage_desc(const kc_stage_t *st, uint32_t i, size_t len, kc_zdesc_t *d)
+{
+    d->addr = st->base + (size_t)i * st->stride;
+    d->len = len;
+    d->region_id = st->region_id;
+    d->offset = (size_t)i * st->stride;
+    d->flags = 0;
+}
+
+static int stage_take(kc_chan_t *ch, uint32_t *i, long timeout_ms,
+                      _Atomic unsigned long *stalls, _Atomic unsigned long *stall_ns)
+{
+    int rc = kc_chan_recv_thread(ch, i, 0);
+    if (rc != KC_EAGAIN || timeout_ms == 0) {
+        if (rc == KC_EAGAIN) atomic_fetch_add_explicit(stalls, 1, memory_order_relaxed);
+        return rc;
+    }
+    long t0 = kc_now_ns();
+    rc = kc_chan_recv_thread(ch, i, timeout_ms);
+    atomic_fetch_add_explicit(stalls, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(stall_ns, (unsigned long)(kc_now_ns() - t0), memory_order_relaxed);
+    return rc;
+}
+
+int kc_stage_create(kc_stage_t **out, unsigned nbufs, size_t buf_size, unsigned region_flags)
+{
+    if (!out || !nbufs || !buf_size) return -EINVAL;
+    *out = NULL;
+    size_t stride = (buf_size + STAGE_ALIGN - 1) & ~(size_t)(STAGE_ALIGN - 1);
+    if (stride < buf_size || stride > SIZE_MAX / nbufs) return -EINVAL;
+    kc_stage_t *st = calloc(1, sizeof(*st));
+    if (!st) return -ENOMEM;
+    st->buf_size = buf_size;
+    st->stride = stride;
+    st->n = nbufs;
+    int rc = -ENOMEM;
+    st->state = calloc(nbufs, sizeof(*st->state));
+    st->len = calloc(nbufs, sizeof(*st->len));
+    if (!st->state || !st->len) goto fail;
+    if ((rc = kc_region_alloc(&st->reg, (size_t)nbufs * stride, region_flags)) != 0) goto fail;
+    st->base = kc_region_addr(st->reg, NULL);
+    (void)kc_region_export_id(st->reg, &st->region_id);
+    if ((rc = kc_chan_make(&st->free_ch, KC_BUFFERED, sizeof(uint32_t), nbufs)) != 0 ||
+        (rc = kc_chan_make(&st->ready_ch, KC_BUFFERED, sizeof(uint32_t), nbufs)) != 0)
+        goto fail;
+    for (uint32_t i = 0; i < nbufs; i++) (void)kc_chan_send_thread(st->free_ch, &i, 0);
+    *out = st;
+    return 0;
+fail:
+    if (st->free_ch) kc_chan_destroy(st->free_ch);
+    if (st->ready_ch) kc_chan_destroy(st->ready_ch);
+    if (st->reg) (void)kc_region_deregister(st->reg);
+    free(st->state);
+    free(st->len);
+    free(st);
+    return rc;
+}
+
+int kc_stage_acquire_for_write(kc_stage_t *st, kc_zdesc_t *d, long timeout_ms)
+{
+    if (!st || !d) return -EINVAL;
+    if (atomic_load_explicit(&st->closed, memory_order_acquire)) return KC_EPIPE;
+    uint32_t i;
+    int rc = stage_take(st->free_ch, &i, timeout_ms, &st->write_stalls, &st->write_stall_ns);
+    if (rc != 0) return rc;
+    atomic_store_explicit(&st->state[i], STAGE_WRITING, memory_order_relaxed);
+    stage_desc(st, i, st->buf_size, d);
+    return 0;
+}
+
+int kc_stage_publish(kc_stage_t *st, const kc_zdesc_t *d)
+{
+    if (!st || !d) return -EINVAL;
+    uint32_t i = stage_index(st, d);
+    if (i == UINT32_MAX || d->len > st->buf_size) return -EINVAL;
+    uint8_t want = STAGE_WRITING;
+    if (!atomic_compare_exchange_strong_explicit(&st->state[i], &want, STAGE_READY,
+                                                 memory_order_acq_rel, memory_order_relaxed))
+        return -EINVAL;
+    st->len[i] = d->len;
+    /* The channel's lock orders the writer's payload before the reader's view */
+    if (atomic_load_explicit(&st->closed, memory_order_acquire) ||
+        kc_chan_send_thread(st->ready_ch, &i, 0) != 0) {
+        atomic_store_explicit(&st->state[i], STAGE_FREE, memory_order_release);
+        return KC_EPIPE;
+    }
+    atomic_fetch_add_explicit(&st->published, 1, memory_order_relaxed);
+    return 0;
+}
+
+int kc_stage_acquire_for_read(kc_stage_t *st, kc_zdesc_t *d, long timeout_ms)
+{
+    if (!st || !d) return -EINVAL;
+    uint32_t i;
+    int rc = stage_take(st->ready_ch, &i, timeout_ms, &st->read_stalls, &st->read_stall_ns);
+    if (rc != 0) return rc;
+    atomic_store_explicit(&st->state[i], STAGE_READING, memory_order_relaxed);
+    atomic_fetch_add_explicit(&st->consumed, 1, memory_order_relaxed);
+    stage_desc(st, i, st->len[i], d);
+    return 0;
+}
+
+int kc_stage_release(kc_stage_t *st, const kc_zdesc_t *d)
+{
+    if (!st || !d) return -EINVAL;
+    uint32_t i = stage_index(st, d);
+    if (i == UINT32_MAX) return -EINVAL;
+    uint8_t want = STAGE_READING;
+    if (!atomic_compare_exchange_strong_explicit(&st->state[i], &want, STAGE_FREE,
+                                                 memory_order_acq_rel, memory_order_relaxed))
+        return -EINVAL;
+    /* Closed: writers are done, the buffer just stays free */
+    (void)kc_chan_send_thread(st->free_ch, &i, 0);
+    return 0;
+}
+
+void kc_stage_close(kc_stage_t *st)
+{
+    if (!st || atomic_exchange_explicit(&st->closed, 1, memory_order_acq_rel)) return;
+    kc_chan_close(st->free_ch);
+    kc_chan_close(st->ready_ch);
+}
+
+size_t kc_stage_buf_size(const kc_stage_t *st) { return st ? st->buf_size : 0; }
+kc_region_t *kc_stage_region(const kc_stage_t *st) { return st ? st->reg : NULL; }
+
+int kc_stage_get_stats(kc_stage_t *st, struct kc_stage_stats *out)
+{
+    if (!st || !out) return -EINVAL;
+    out->published = atomic_load_explicit(&st->published, memory_order_relaxed);
+    out->consumed = atomic_load_explicit(&st->consumed, memory_order_relaxed);
+    out->write_stalls = atomic_load_explicit(&st->write_stalls, memory_order_relaxed);
+    out->read_stalls = atomic_load_explicit(&st->read_stalls, memory_order_relaxed);
+    out->write_stall_ns = atomic_load_explicit(&st->write_stall_ns, memory_order_relaxed);
+    out->read_stall_ns = atomic_load_explicit(&st->read_stall_ns, memory_order_relaxed);
+    out->ready = 0;
+    for (uint32_t i = 0; i < st->n; i++)
+        if (atomic_load_explicit(&st->state[i], memory_order_relaxed) == STAGE_READY) out->ready++;
+    out->nbufs = st->n;
+    return 0;
+}
+
+int kc_stage_destroy(kc_stage_t *st)
+{
+    if (!st) return -EINVAL;
+    for (uint32_t i = 0; i < st->n; i++) {
+        uint8_t s = atomic_load_explicit(&st->state[i], memory_order_acquire);
+        if (s == STAGE_WRITING || s == STAGE_READING) return -EBUSY;
+    }
+    kc_chan_destroy(st->free_ch);
+    kc_chan_destroy(st->ready_ch);
+    (void)kc_region_deregister(st->reg);
+    free(st->state);
+    free(st->len);
+    free(st);
+    return 0;
+}
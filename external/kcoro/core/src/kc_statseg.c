@@ -0,0 +1,474 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/*
+ * kc_statseg.c — shared-memory stats segment
+ * ------------------------------------------
+ *
+ * Publisher
+ * - One POSIX shm object per kc_statseg_publish, sized to kc_statseg_data_t,
+ *   and one plain thread that wakes every interval_ms. A sample is built in
+ *   a private scratch copy (kc_sched_get_stats, kc_sched_get_worker_stats,
+ *   kc_sched_get_steal_matrix, kc_metrics_chans: relaxed loads only) and
+ *   then copied into the segment under the seqlock, so the odd-seq window a
+ *   reader can collide with is a single memcpy.
+ * - With more registered channels than KC_STATSEG_CHANS, the ones that moved
+ *   most since the previous sample are published.
+ *
+ * Reader
+ * - Maps the object read-only and copies it between two even, equal seq
+ *   reads. Once mapped, a read is plain loads on both sides: no syscall and
+ *   no lock in the observed process, whatever the reader's poll rate.
+ * - Accepts segments of the same version that are larger than its own
+ *   layout (fields appended by a newer publisher) and maps only the prefix
+ *   it knows.
+ * - kc_statseg_render formats a copy with kc_metrics_render's family names,
+ *   so an external exporter's text lines up with the in-process one.
+ */
+#define _GNU_SOURCE 1
+#include <errno.h>
+#include <stdarg.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "../../include/kcoro_config.h"
+#include "../../include/kcoro_metrics.h"
+#include "../../include/kcoro_statseg.h"
+#include "../../include/kc_mem.h"
+#include "../../include/kcoro_port.h"
+#include "kc_clock_internal.h"
+
+#define STATSEG_READ_TRIES 100
+
+struct statseg_prev { const void *chan; uint64_t ops; };
+
+struct kc_statseg {
+    char name[64];
+    kc_sched_t *sched;
+    int interval_ms;
+    kc_statseg_data_t *seg;       /* shared mapping */
+    kc_statseg_data_t *scratch;   /* sample under construction */
+    kc_metrics_chan_t *chans;     /* KCORO_METRICS_MAX */
+    struct statseg_prev *prev;    /* per-channel ops at the previous sample */
+    int nprev;
+    unsigned long *steal;         /* workers^2 */
+    int workers;
+    pthread_t thr;
+    pthread_mutex_t mu;
+    pthread_cond_t cv;
+    int stop;
+};
+
+static uint64_t statseg_now_ns(void)
+{
+    return kc_clock_ns();
+}
+
+int kc_statseg_default_name(int pid, char *buf, size_t cap)
+{
+    if (!buf) return -EINVAL;
+    int n = snprintf(buf, cap, "/kcoro-%d", pid);
+    return n < 0 || (size_t)n >= cap ? -ENAMETOOLONG : 0;
+}
+
+/* ---- Publisher ---- */
+
+static uint64_t statseg_prev_ops(const struct kc_statseg *g, const void *chan)
+{
+    for (int i = 0; i < g->nprev; i++)
+        if (g->prev[i].chan == chan) return g->prev[i].ops;
+    return 0;
+}
+
+static void statseg_sample_chans(struct kc_statseg *g, kc_statseg_data_t *d)
+{
+    int n = kc_metrics_chans(g->chans, KCORO_METRICS_MAX);
+    if (n < 0) n = 0;
+    d->chans_total = (uint32_t)n;
+    /* Rank by ops since the previous sample (selection of the top slots). */
+    uint64_t delta[KCORO_METRICS_MAX];
+    for (int i = 0; i < n; i++) {
+        uint64_t ops = g->chans[i].s.total_sends + g->chans[i].s.total_recvs;
+        uint64_t was = statseg_prev_ops(g, g->chans[i].s.chan);
+        delta[i] = ops >= was ? ops - was : ops;
+    }
+    int keep = n < KC_STATSEG_CHANS ? n : KC_STATSEG_CHANS;
+    for (int k = 0; k < keep && n > KC_STATSEG_CHANS; k++) {
+        int best = k;
+        for (int i = k + 1; i < n; i++) if (delta[i] > delta[best]) best = i;
+        if (best != k) {
+            kc_metrics_chan_t t = g->chans[k]; g->chans[k] = g->chans[best]; g->chans[best] = t;
+            uint64_t td = delta[k]; delta[k] = delta[best]; delta[best] = td;
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        g->prev[i].chan = g->chans[i].s.chan;
+        g->prev[i].ops = g->chans[i].s.total_sends + g->chans[i].s.total_recvs;
+    }
+    g->nprev = n;
+    d->nchans = (uint32_t)keep;
+    for (int i = 0; i < keep; i++) {
+        const struct kc_chan_snapshot *s = &g->chans[i].s;
+        kc_statseg_chan_t *c = &d->ch[i];
+        memset(c, 0, sizeof(*c));
+        memcpy(c->name, g->chans[i].name, sizeof(c->name) - 1);
+        c->sends = s->total_sends;
+        c->recvs = s->total_recvs;
+        c->bytes_sent = s->total_bytes_sent;
+        c->bytes_recv = s->total_bytes_recv;
+        c->count = s->count;
+        c->capacity = s->capacity;
+        c->send_waiters = s->send_waiters;
+        c->recv_waiters = s->recv_waiters;
+        c->kind = s->kind;
+        c->closed = s->closed;
+    }
+}
+
+static void statseg_sample(struct kc_statseg *g)
+{
+    kc_statseg_data_t *d = g->scratch;
+    kc_sched_stats_t st;
+    memset(&st, 0, sizeof(st));
+    kc_sched_get_stats(g->sched, &st);
+    d->sample_ns = statseg_now_ns();
+    d->tasks_submitted = st.tasks_submitted;
+    d->tasks_completed = st.tasks_completed;
+    d->steals_succeeded = st.steals_succeeded;
+    d->park_events = st.park_events;
+    d->inject_depth = st.inject_depth;
+    d->bulk_depth = st.bulk_depth;
+    d->workers_active = (uint32_t)st.workers_active;
+    d->workers_total = (uint32_t)g->workers;
+    int nw = g->workers < KC_STATSEG_WORKERS ? g->workers : KC_STATSEG_WORKERS;
+    d->workers = (uint32_t)nw;
+    for (int i = 0; i < nw; i++) {
+        kc_sched_worker_stats_t ws;
+        kc_statseg_worker_t *w = &d->w[i];
+        memset(w, 0, sizeof(*w));
+        if (kc_sched_get_worker_stats(g->sched, i, &ws) != 0) continue;
+        w->on = (uint8_t)ws.on;
+        w->parked = (uint8_t)ws.parked;
+        w->runnext = (uint8_t)ws.runnext;
+        w->deque_depth = ws.deque_depth;
+        w->timers = ws.timers;
+        w->run = ws.run;
+        w->parks = ws.parks;
+        w->parked_ns = ws.parked_ns;
+        w->steals = ws.steals;
+    }
+    d->steal_valid = kc_sched_get_steal_matrix(g->sched, g->steal, (size_t)g->workers * (size_t)g->workers) > 0;
+    for (int t = 0; t < nw; t++)
+        for (int v = 0; v < nw; v++)
+            d->steal[t][v] = d->steal_valid ? g->steal[(size_t)t * (size_t)g->workers + (size_t)v] : 0;
+    statseg_sample_chans(g, d);
+    kc_mem_stats_t ms;
+    kc_mem_get_stats(&ms);
+    d->mem_cats = KC_MEM_CAT_COUNT < KC_STATSEG_MEM_CATS ? KC_MEM_CAT_COUNT : KC_STATSEG_MEM_CATS;
+    for (uint32_t c = 0; c < d->mem_cats; c++) {
+        d->mem_bytes[c] = ms.bytes[c];
+        d->mem_limit[c] = ms.limit[c];
+        d->mem_denied[c] = ms.denied[c];
+    }
+    d->mem_total = ms.total;
+    d->mem_total_limit = ms.total_limit;
+
+    /* Seqlock write of everything after the header. */
+    kc_statseg_data_t *out = g->seg;
+    uint64_t q = out->seq;
+    d->samples = out->samples + 1;
+    __atomic_store_n(&out->seq, q + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    const size_t off = offsetof(kc_statseg_data_t, samples);
+    memcpy((char*)out + off, (const char*)d + off, sizeof(*d) - off);
+    __atomic_store_n(&out->seq, q + 2, __ATOMIC_RELEASE);
+}
+
+static void *statseg_main(void *arg)
+{
+    struct kc_statseg *g = (struct kc_statseg*)arg;
+    pthread_mutex_lock(&g->mu);
+    while (!g->stop) {
+        pthread_mutex_unlock(&g->mu);
+        statseg_sample(g);
+        pthread_mutex_lock(&g->mu);
+        struct timespec ts;
+        kc_clock_abstime_ms(&ts, KC_PORT_PTHREAD_COND_CLOCK, (long)g->interval_ms);
+        while (!g->stop && pthread_cond_timedwait(&g->cv, &g->mu, &ts) != ETIMEDOUT) { }
+    }
+    pthread_mutex_unlock(&g->mu);
+    return NULL;
+}
+
+static void statseg_free(struct kc_statseg *g)
+{
+    if (g->seg) munmap(g->seg, sizeof(*g->seg));
+    free(g->scratch);
+    free(g->chans);
+    free(g->prev);
+    free(g->steal);
+    free(g);
+}
+
+int kc_statseg_publish(kc_sched_t *s, const char *name, int interval_ms, kc_statseg_t **out)
+{
+    if (!out) return -EINVAL;
+    if (!s) s = kc_sched_default();
+    if (!s) return -ENOMEM;
+    struct kc_statseg *g = (struct kc_statseg*)calloc(1, sizeof(*g));
+    if (!g) return -ENOMEM;
+    int rc = 0;
+    if (name) {
+        if (strlen(name) >= sizeof(g->name)) { free(g); return -ENAMETOOLONG; }
+        snprintf(g->name, sizeof(g->name), "%s", name);
+    } else {
+        kc_statseg_default_name((int)getpid(), g->name, sizeof(g->name));
+    }
+    g->sched = s;
+    g->interval_ms = interval_ms > 0 ? interval_ms : 250;
+    g->workers = kc_sched_worker_count(s);
+    g->scratch = (kc_statseg_data_t*)calloc(1, sizeof(*g->scratch));
+    g->chans = (kc_metrics_chan_t*)calloc(KCORO_METRICS_MAX, sizeof(*g->chans));
+    g->prev = (struct statseg_prev*)calloc(KCORO_METRICS_MAX, sizeof(*g->prev));
+    g->steal = (unsigned long*)calloc((size_t)g->workers * (size_t)g->workers, sizeof(*g->steal));
+    if (!g->scratch || !g->chans || !g->prev || !g->steal) { statseg_free(g); return -ENOMEM; }
+
+    int fd = shm_open(g->name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) { rc = -errno; statseg_free(g); return rc; }
+    void *m = MAP_FAILED;
+    if (ftruncate(fd, (off_t)sizeof(kc_statseg_data_t)) == 0)
+        m = mmap(NULL, sizeof(kc_statseg_data_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (m == MAP_FAILED) rc = -errno;
+    close(fd);
+    if (rc) { shm_unlink(g->name); statseg_free(g); return rc; }
+    g->seg = (kc_statseg_data_t*)m;
+    g->seg->version = KC_STATSEG_VERSION;
+    g->seg->size = (uint32_t)sizeof(kc_statseg_data_t);
+    g->seg->pid = (int32_t)getpid();
+    g->seg->interval_ms = (uint32_t)g->interval_ms;
+
+    if ((rc = kc_sched_set_steal_matrix(s, 1)) != 0) { shm_unlink(g->name); statseg_free(g); return rc; }
+    kc_posix_cond_init_monotonic(&g->cv);
+    pthread_mutex_init(&g->mu, NULL);
+    statseg_sample(g);
+    __atomic_store_n(&g->seg->magic, KC_STATSEG_MAGIC, __ATOMIC_RELEASE);
+    if ((rc = pthread_create(&g->thr, NULL, statseg_main, g)) != 0) {
+        kc_sched_set_steal_matrix(s, 0);
+        pthread_cond_destroy(&g->cv);
+        pthread_mutex_destroy(&g->mu);
+        shm_unlink(g->name);
+        statseg_free(g);
+        return -rc;
+    }
+    *out = g;
+    return 0;
+}
+
+const char *kc_statseg_name(const kc_statseg_t *seg)
+{
+    return seg ? seg->name : NULL;
+}
+
+int kc_statseg_stop(kc_statseg_t *g)
+{
+    if (!g) return -EINVAL;
+    pthread_mutex_lock(&g->mu);
+    g->stop = 1;
+    pthread_cond_signal(&g->cv);
+    pthread_mutex_unlock(&g->mu);
+    pthread_join(g->thr, NULL);
+    kc_sched_set_steal_matrix(g->sched, 0);
+    shm_unlink(g->name);
+    pthread_cond_destroy(&g->cv);
+    pthread_mutex_destroy(&g->mu);
+    statseg_free(g);
+    return 0;
+}
+
+/* ---- Reader ---- */
+
+int kc_statseg_attach(const char *name, const kc_statseg_data_t **out)
+{
+    if (!name || !out) return -EINVAL;
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) return -errno;
+    struct stat st;
+    if (fstat(fd, &st) != 0) { int rc = -errno; close(fd); return rc; }
+    if ((size_t)st.st_size < sizeof(kc_statseg_data_t)) { close(fd); return st.st_size ? -EPROTO : -EAGAIN; }
+    void *m = mmap(NULL, sizeof(kc_statseg_data_t), PROT_READ, MAP_SHARED, fd, 0);
+    int rc = m == MAP_FAILED ? -errno : 0;
+    close(fd);
+    if (rc) return rc;
+    const kc_statseg_data_t *d = (const kc_statseg_data_t*)m;
+    uint64_t magic = __atomic_load_n(&d->magic, __ATOMIC_ACQUIRE);
+    if (magic != KC_STATSEG_MAGIC || d->version != KC_STATSEG_VERSION || d->size < sizeof(*d)) {
+        munmap(m, sizeof(kc_statseg_data_t));
+        return magic == 0 ? -EAGAIN : -EPROTO;
+    }
+    *out = d;
+    return 0;
+}
+
+int kc_statseg_read(const kc_statseg_data_t *seg, kc_statseg_data_t *copy)
+{
+    if (!seg || !copy) return -EINVAL;
+    for (int i = 0; i < STATSEG_READ_TRIES; i++) {
+        uint64_t s0 = __atomic_load_n(&seg->seq, __ATOMIC_ACQUIRE);
+        if (s0 & 1) { sched_yield(); continue; }
+        memcpy(copy, seg, sizeof(*copy));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&seg->seq, __ATOMIC_RELAXED) == s0) {
+            copy->seq = s0;
+            return 0;
+        }
+    }
+    return -EAGAIN;
+}
+
+void kc_statseg_detach(const kc_statseg_data_t *seg)
+{
+    if (seg) munmap((void*)seg, sizeof(*seg));
+}
+
+/* ---- OpenMetrics ---- */
+
+struct statseg_out { char *buf; size_t cap, len; };
+
+static void so_printf(struct statseg_out *o, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+static void so_printf(struct statseg_out *o, const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    int n = o->len < o->cap ? vsnprintf(o->buf + o->len, o->cap - o->len, fmt, ap)
+                            : vsnprintf(NULL, 0, fmt, ap);
+    va_end(ap);
+    if (n > 0) o->len += (size_t)n;
+}
+
+static void so_family(struct statseg_out *o, const char *name, const char *type, const char *help)
+{
+    so_printf(o, "# TYPE %s %s\n# HELP %s %s\n", name, type, name, help);
+}
+
+/* Channel names arrive escaped (kc_metrics labels) but cut at
+ * KC_STATSEG_NAME_MAX - 1 bytes; drop a dangling escape. */
+static int so_label_len(const char *name)
+{
+    int n = (int)strnlen(name, KC_STATSEG_NAME_MAX - 1), bs = 0;
+    while (bs < n && name[n - 1 - bs] == '\\') bs++;
+    return n - (bs & 1);
+}
+
+long kc_statseg_render(const kc_statseg_data_t *d, char *buf, size_t cap)
+{
+    if (!d || (!buf && cap)) return -EINVAL;
+    struct statseg_out o = { buf, cap, 0 };
+    if (cap) buf[0] = '\0';
+    uint32_t nw = d->workers < KC_STATSEG_WORKERS ? d->workers : KC_STATSEG_WORKERS;
+    uint32_t nc = d->nchans < KC_STATSEG_CHANS ? d->nchans : KC_STATSEG_CHANS;
+
+    static const struct { const char *name, *type, *help; size_t off; } chan_f[] = {
+#define CF(n, t, h, f) { n, t, h, offsetof(kc_statseg_chan_t, f) }
+        CF("kcoro_chan_sends", "counter", "Elements sent.", sends),
+        CF("kcoro_chan_recvs", "counter", "Elements received.", recvs),
+        CF("kcoro_chan_sent_bytes", "counter", "Payload bytes sent.", bytes_sent),
+        CF("kcoro_chan_received_bytes", "counter", "Payload bytes received.", bytes_recv),
+        CF("kcoro_chan_depth", "gauge", "Elements queued.", count),
+        CF("kcoro_chan_capacity", "gauge", "Capacity in elements (0 for rendezvous and conflated).", capacity),
+#undef CF
+    };
+    if (nc) {
+        for (size_t f = 0; f < sizeof(chan_f) / sizeof(chan_f[0]); f++) {
+            int counter = chan_f[f].type[0] == 'c';
+            so_family(&o, chan_f[f].name, chan_f[f].type, chan_f[f].help);
+            for (uint32_t i = 0; i < nc; i++) {
+                uint64_t v;
+                memcpy(&v, (const char*)&d->ch[i] + chan_f[f].off, sizeof(v));
+                so_printf(&o, "%s%s{chan=\"%.*s\"} %llu\n", chan_f[f].name, counter ? "_total" : "",
+                          so_label_len(d->ch[i].name), d->ch[i].name, (unsigned long long)v);
+            }
+        }
+        so_family(&o, "kcoro_chan_waiters", "gauge", "Ops blocked on the channel, by direction (select and zref waits excluded).");
+        for (uint32_t i = 0; i < nc; i++) {
+            int ln = so_label_len(d->ch[i].name);
+            so_printf(&o, "kcoro_chan_waiters{chan=\"%.*s\",op=\"send\"} %u\n", ln, d->ch[i].name, d->ch[i].send_waiters);
+            so_printf(&o, "kcoro_chan_waiters{chan=\"%.*s\",op=\"recv\"} %u\n", ln, d->ch[i].name, d->ch[i].recv_waiters);
+        }
+    }
+
+    const struct { const char *name, *type, *help; uint64_t v; } sched_f[] = {
+        { "kcoro_sched_tasks_submitted", "counter", "Tasks submitted.", d->tasks_submitted },
+        { "kcoro_sched_tasks_completed", "counter", "Tasks completed.", d->tasks_completed },
+        { "kcoro_sched_steals", "counter", "Tasks stolen from another worker.", d->steals_succeeded },
+        { "kcoro_sched_worker_parks", "counter", "Times a worker went to sleep.", d->park_events },
+        { "kcoro_sched_workers_active", "gauge", "Worker slots with a running thread.", d->workers_active },
+        { "kcoro_sched_inject_depth", "gauge", "Tasks queued in the global inject ring.", d->inject_depth },
+        { "kcoro_sched_bulk_depth", "gauge", "Tasks queued in the bulk-lane ring.", d->bulk_depth },
+    };
+    for (size_t f = 0; f < sizeof(sched_f) / sizeof(sched_f[0]); f++) {
+        so_family(&o, sched_f[f].name, sched_f[f].type, sched_f[f].help);
+        so_printf(&o, "%s%s %llu\n", sched_f[f].name, sched_f[f].type[0] == 'c' ? "_total" : "",
+                  (unsigned long long)sched_f[f].v);
+    }
+
+    static const struct { const char *name, *type, *help; size_t off; int width; } worker_f[] = {
+#define WF(n, t, h, f) { n, t, h, offsetof(kc_statseg_worker_t, f), (int)sizeof(((kc_statseg_worker_t*)0)->f) }
+        WF("kcoro_worker_run", "counter", "Tasks run and coroutine resumes.", run),
+        WF("kcoro_worker_parks", "counter", "Times the worker went to sleep.", parks),
+        WF("kcoro_worker_steals", "counter", "Tasks the worker stole.", steals),
+        WF("kcoro_worker_deque_depth", "gauge", "Tasks in the worker's deque.", deque_depth),
+        WF("kcoro_worker_timers", "gauge", "Timers armed on the worker's wheel.", timers),
+        WF("kcoro_worker_parked", "gauge", "1 while the worker sleeps.", parked),
+#undef WF
+    };
+    for (size_t f = 0; f < sizeof(worker_f) / sizeof(worker_f[0]); f++) {
+        int counter = worker_f[f].type[0] == 'c';
+        so_family(&o, worker_f[f].name, worker_f[f].type, worker_f[f].help);
+        for (uint32_t i = 0; i < nw; i++) {
+            if (!d->w[i].on) continue;
+            const char *p = (const char*)&d->w[i] + worker_f[f].off;
+            uint64_t v = 0;
+            if (worker_f[f].width == 8) memcpy(&v, p, 8);
+            else if (worker_f[f].width == 4) { uint32_t v32; memcpy(&v32, p, 4); v = v32; }
+            else v = *(const uint8_t*)p;
+            so_printf(&o, "%s%s{worker=\"%u\"} %llu\n", worker_f[f].name, counter ? "_total" : "", i, (unsigned long long)v);
+        }
+    }
+    so_family(&o, "kcoro_worker_parked_seconds", "counter", "Time the worker spent asleep.");
+    for (uint32_t i = 0; i < nw; i++)
+        if (d->w[i].on)
+            so_printf(&o, "kcoro_worker_parked_seconds_total{worker=\"%u\"} %.9f\n", i, (double)d->w[i].parked_ns / 1e9);
+    if (d->steal_valid) {
+        so_family(&o, "kcoro_worker_steals_from", "counter", "Tasks stolen, by thief and victim.");
+        for (uint32_t t = 0; t < nw; t++)
+            for (uint32_t v = 0; v < nw; v++)
+                if (d->steal[t][v])
+                    so_printf(&o, "kcoro_worker_steals_from_total{worker=\"%u\",victim=\"%u\"} %llu\n",
+                              t, v, (unsigned long long)d->steal[t][v]);
+    }
+    uint32_t nm = d->mem_cats < KC_STATSEG_MEM_CATS ? d->mem_cats : KC_STATSEG_MEM_CATS;
+    const struct { const char *name, *type, *help; const uint64_t *v; } mem_f[] = {
+        { "kcoro_mem_bytes", "gauge", "Bytes charged to each runtime memory category.", d->mem_bytes },
+        { "kcoro_mem_limit_bytes", "gauge", "Soft limit of each category (0 = none).", d->mem_limit },
+        { "kcoro_mem_denied", "counter", "Charges refused by a soft limit.", d->mem_denied },
+    };
+    for (size_t f = 0; nm && f < sizeof(mem_f) / sizeof(mem_f[0]); f++) {
+        so_family(&o, mem_f[f].name, mem_f[f].type, mem_f[f].help);
+        for (uint32_t c = 0; c < nm; c++) {
+            const char *cat = kc_mem_cat_name((kc_mem_cat_t)c);
+            so_printf(&o, "%s%s{cat=\"%s\"} %llu\n", mem_f[f].name, mem_f[f].type[0] == 'c' ? "_total" : "",
+                      cat ? cat : "unknown", (unsigned long long)mem_f[f].v[c]);
+        }
+    }
+    if (nm) {
+        so_family(&o, "kcoro_mem_total_bytes", "gauge", "Bytes charged over all categories.");
+        so_printf(&o, "kcoro_mem_total_bytes %llu\n", (unsigned long long)d->mem_total);
+    }
+    so_printf(&o, "# EOF\n");
+    return (long)o.len;
+}
@@ -0,0 +1,215 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/*
+ * kc_task_group.c — fork-join task groups with a helping join
+ * -----------------------------------------------------------
+ *
+ * Accounting
+ * - `pending` counts members spawned and not yet returned. A member that
+ *   leaves others pending drops it with a CAS; the one that would take it
+ *   to 0 does so under mu and wakes the waiters there. So once a waiter has
+ *   seen 0 and taken mu once, no member touches the group again and the
+ *   caller may destroy it.
+ * - Member records (fn, arg, group) come from a per-thread cache
+ *   (KCORO_TASK_GROUP_CACHE_PER_THREAD) and return to the cache of the
+ *   thread that ran them, so steady fork-join costs no malloc.
+ *
+ * Waiting
+ * - First help: kc_sched_help runs the caller's own newest task (usually a
+ *   member it just spawned, hot in cache) or steals one, for as long as
+ *   there is any, then KCORO_PARALLEL_JOIN_SPIN empty rounds.
+ * - Then park. A worker coroutine pushes a record from its stack on
+ *   `waiters` and parks through kc_sched_park_release, which drops mu only
+ *   once it has switched out; the last member enqueues it. A plain thread
+ *   sleeps on cv. A worker's task context has nothing to park, so it
+ *   yields and goes back to helping.
+ */
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#include "../../include/kcoro.h"
+#include "../../include/kcoro_core.h"
+#include "../../include/kcoro_sched.h"
+#include "../../include/kcoro_port.h"
+#include "../../include/kcoro_config.h"
+#include "kc_parallel_internal.h"
+
+struct tg_waiter {
+    kcoro_t *co;
+    kc_sched_t *sched;        /* the worker's, to enqueue it on */
+    struct tg_waiter *next;
+};
+
+struct kc_task_group {
+    kc_sched_t *s;
+    _Atomic unsigned long pending;
+    KC_MUTEX_T mu;
+    KC_COND_T cv;
+    struct tg_waiter *waiters;   /* parked coroutines, under mu */
+    int thread_waiters;          /* under mu */
+};
+
+struct tg_member {
+    kc_task_group_t *g;
+    kc_task_fn fn;
+    void *arg;
+    struct tg_member *next;      /* cache link */
+};
+
+/* Per-thread cache of free member records, linked through `next`. */
+struct tg_cache { struct tg_member *head; unsigned count; };
+static __thread struct tg_cache tls_members;
+static pthread_key_t tg_key;
+static pthread_once_t tg_once = PTHREAD_ONCE_INIT;
+
+static void tg_cache_drop(void *arg)
+{
+    (void)arg;
+    struct tg_member *m = tls_members.head;
+    while (m) { struct tg_member *n = m->next; free(m); m = n; }
+    tls_members.head = NULL;
+    tls_members.count = 0;
+}
+
+static void tg_key_init(void)
+{
+    (void)pthread_key_create(&tg_key, tg_cache_drop);
+}
+
+static struct tg_member *member_alloc(void)
+{
+    struct tg_member *m = tls_members.head;
+    if (m) {
+        tls_members.head = m->next;
+        tls_members.count--;
+        return m;
+    }
+    return (struct tg_member *)malloc(sizeof(*m));
+}
+
+static void member_free(struct tg_member *m)
+{
+    if (tls_members.count >= KCORO_TASK_GROUP_CACHE_PER_THREAD) { free(m); return; }
+    if (!tls_members.head) {
+        /* First record cached on this thread: free the cache at exit. */
+        pthread_once(&tg_once, tg_key_init);
+        (void)pthread_setspecific(tg_key, &tls_members);
+    }
+    m->next = tls_members.head;
+    tls_members.head = m;
+    tls_members.count++;
+}
+
+static void tg_member_done(kc_task_group_t *g)
+{
+    unsigned long c = atomic_load_explicit(&g->pending, memory_order_relaxed);
+    while (c > 1)
+        if (atomic_compare_exchange_weak_explicit(&g->pending, &c, c - 1, memory_order_release,
+                                                  memory_order_relaxed)) return;
+    KC_MUTEX_LOCK(&g->mu);
+    struct tg_waiter *w = NULL;
+    if (atomic_fetch_sub_explicit(&g->pending, 1, memory_order_release) == 1) {
+        w = g->waiters;
+        g->waiters = NULL;
+        if (g->thread_waiters) KC_COND_BROADCAST(&g->cv);
+    }
+    KC_MUTEX_UNLOCK(&g->mu);
+    while (w) {
+        struct tg_waiter *next = w->next;   /* w lives on a stack we are about to wake */
+        kc_sched_enqueue_ready(w->sched, w->co);
+        w = next;
+    }
+}
+
+static void tg_member_run(void *arg)
+{
+    struct tg_member *m = (struct tg_member *)arg;
+    kc_task_group_t *g = m->g;
+    m->fn(m->arg);
+    member_free(m);
+    tg_member_done(g);
+}
+
+static void tg_unlock(void *arg)
+{
+    kc_task_group_t *g = (kc_task_group_t *)arg;
+    KC_MUTEX_UNLOCK(&g->mu);
+}
+
+static inline void tg_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield" ::: "memory");
+#endif
+}
+
+int kc_task_group_create(kc_task_group_t **out, kc_sched_t *s)
+{
+    if (!out || !s) return -EINVAL;
+    kc_task_group_t *g = (kc_task_group_t *)calloc(1, sizeof(*g));
+    if (!g) return -ENOMEM;
+    g->s = s;
+    atomic_init(&g->pending, 0);
+    KC_MUTEX_INIT(&g->mu);
+    KC_COND_INIT(&g->cv);
+    *out = g;
+    return 0;
+}
+
+int kc_task_group_spawn(kc_task_group_t *g, kc_task_fn fn, void *arg)
+{
+    if (!g || !fn) return -EINVAL;
+    struct tg_member *m = member_alloc();
+    if (!m) return -ENOMEM;
+    m->g = g;
+    m->fn = fn;
+    m->arg = arg;
+    atomic_fetch_add_explicit(&g->pending, 1, memory_order_relaxed);
+    if (kc_spawn(g->s, tg_member_run, m) != 0) {
+        member_free(m);
+        tg_member_done(g);
+        return -ENOMEM;
+    }
+    return 0;
+}
+
+int kc_task_group_wait(kc_task_group_t *g)
+{
+    if (!g) return -EINVAL;
+    unsigned idle = 0;
+    while (atomic_load_explicit(&g->pending, memory_order_acquire) != 0) {
+        if (kc_sched_help(g->s) > 0) { idle = 0; continue; }
+        if (++idle < KCORO_PARALLEL_JOIN_SPIN) { tg_relax(); continue; }
+        idle = 0;
+        KC_MUTEX_LOCK(&g->mu);
+        if (atomic_load_explicit(&g->pending, memory_order_acquire) == 0) { KC_MUTEX_UNLOCK(&g->mu); break; }
+        struct tg_waiter me = { kcoro_current(), kc_sched_current(), g->waiters };
+        g->waiters = &me;
+        if (kc_sched_park_release(tg_unlock, g) == 0) continue;
+        g->waiters = me.next;   /* not a worker coroutine; still ours: we hold mu */
+        if (me.sched) {         /* a worker's task context: never block the thread */
+            KC_MUTEX_UNLOCK(&g->mu);
+            kc_yield();
+            continue;
+        }
+        g->thread_waiters++;
+        while (atomic_load_explicit(&g->pending, memory_order_acquire) != 0) KC_COND_WAIT(&g->cv, &g->mu);
+        g->thread_waiters--;
+        KC_MUTEX_UNLOCK(&g->mu);
+    }
+    /* The last member may still be inside mu after its decrement. */
+    KC_MUTEX_LOCK(&g->mu);
+    KC_MUTEX_UNLOCK(&g->mu);
+    return 0;
+}
+
+void kc_task_group_destroy(kc_task_group_t *g)
+{
+    if (!g) return;
+    KC_COND_DESTROY(&g->cv);
+    KC_MUTEX_DESTROY(&g->mu);
+    free(g);
+}
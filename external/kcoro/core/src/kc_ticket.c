@@ -0,0 +1,446 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/*
+ * kc_ticket.c — correlation tickets
+ * ---------------------------------
+ *
+ * Table
+ * - Slots live in pages of KC_TICKET_PAGE, installed by CAS the first time
+ *   an index in the page is handed out and never freed, so a stale ticket
+ *   always points at valid memory. A ticket is (generation << 32) | (index
+ *   + 1); publishing bumps the slot's generation.
+ * - Free slots sit on a per-thread list (KCORO_TICKET_CACHE_PER_THREAD);
+ *   past the cap half of it moves to a global Treiber stack whose head
+ *   carries a tag against ABA. An empty thread list refills from the stack,
+ *   else carves fresh indices from a bump counter capped at
+ *   KCORO_TICKET_MAX. A pthread key destructor returns a thread's list when
+ *   it exits.
+ *
+ * Slot state: one word, generation << 32 | phase
+ *   ARMED   published; the owner is running (or about to park)
+ *   PARKED  the owner switched out; a completer must wake it
+ *   BUSY    a completer won the CAS and is swapping the payload
+ *   DONE    completed; the owner reads the payload
+ *   GONE    the owner timed out first; completions are refused
+ *   FREE    back on a free list
+ * The owner parks with kc_sched_park_release: once it is switched out the
+ * hook moves ARMED -> PARKED, or finds the completion already there and
+ * requeues it, so a wake can never be lost or land on a running coroutine.
+ * A completer that found ARMED leaves the wake to that hook. BUSY lasts a
+ * payload copy; the owner and hook spin on it.
+ */
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../include/kcoro_config.h"
+#include "../../include/kcoro_core.h"
+#include "../../include/kcoro_port.h"
+#include "../../include/kcoro_sched.h"
+#include "kc_cancel_internal.h"  /* cancel wakes for _c ops */
+#include "kc_chan_internal.h"    /* kc_now_ns */
+#include "kc_ticket_internal.h"
+#include "kcoro_share_internal.h"
+
+#define KC_TICKET_PAGE_SHIFT 10
+#define KC_TICKET_PAGE (1u << KC_TICKET_PAGE_SHIFT)
+#define KC_TICKET_PAGES ((KCORO_TICKET_MAX + KC_TICKET_PAGE - 1) / KC_TICKET_PAGE)
+
+enum {
+    KC_TS_FREE = 0,
+    KC_TS_ARMED,
+    KC_TS_PARKED,
+    KC_TS_BUSY,
+    KC_TS_DONE,
+    KC_TS_GONE,
+};
+
+#define KC_TS(gen, phase) ((uint64_t)(gen) << 32 | (uint64_t)(phase))
+#define KC_TS_GEN(st)     ((uint32_t)((st) >> 32))
+#define KC_TS_PHASE(st)   ((unsigned)((st) & 0xffffffffu))
+
+/* One cache line per slot: completers on other threads touch only theirs. */
+struct kc_ticket_slot {
+    _Alignas(64) _Atomic uint64_t state;
+    kcoro_t             *co;        /* owner, retained while published */
+    kc_ticket_payload_t  payload;
+    _Atomic uint32_t     next_free; /* free lists: index + 1, 0 ends */
+    kc_ticket_t          qnext;     /* kc_ticket_queue link */
+};
+
+static struct kc_ticket_slot *_Atomic g_pages[KC_TICKET_PAGES];
+static _Atomic uint32_t g_carved;                /* indices handed out so far */
+static _Atomic uint64_t g_free;                  /* tag << 32 | (index + 1) */
+
+static struct kc_ticket_slot *kc_ticket_slot_at(uint32_t idx)
+{
+    struct kc_ticket_slot *page = atomic_load_explicit(&g_pages[idx >> KC_TICKET_PAGE_SHIFT],
+                                                       memory_order_acquire);
+    return page ? &page[idx & (KC_TICKET_PAGE - 1)] : NULL;
+}
+
+static struct kc_ticket_slot *kc_ticket_slot_of(kc_ticket_t t)
+{
+    uint32_t low = (uint32_t)t;
+    if (low == 0 || low > KCORO_TICKET_MAX) return NULL;
+    return kc_ticket_slot_at(low - 1);
+}
+
+static void kc_ticket_relax(unsigned *spins)
+{
+    if (++*spins % 64 == 0) { sched_yield(); return; }
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield" ::: "memory");
+#else
+    atomic_signal_fence(memory_order_seq_cst);
+#endif
+}
+
+/* ---- Slot allocation ---- */
+
+struct kc_ticket_cache {
+    uint32_t head;      /* index + 1 */
+    unsigned count;
+    int registered;
+};
+
+static __thread struct kc_ticket_cache tls_tickets;
+static pthread_key_t ticket_cache_key;
+static pthread_once_t ticket_cache_once = PTHREAD_ONCE_INIT;
+
+static struct kc_ticket_slot *kc_ticket_page(uint32_t pg)
+{
+    struct kc_ticket_slot *page = atomic_load_explicit(&g_pages[pg], memory_order_acquire);
+    if (page) return page;
+    void *mem = NULL;
+    if (posix_memalign(&mem, 64, (size_t)KC_TICKET_PAGE * sizeof(struct kc_ticket_slot)) != 0) return NULL;
+    memset(mem, 0, (size_t)KC_TICKET_PAGE * sizeof(struct kc_ticket_slot));
+    if (!atomic_compare_exchange_strong_explicit(&g_pages[pg], &page, (struct kc_ticket_slot*)mem,
+                                                 memory_order_acq_rel, memory_order_acquire)) {
+        free(mem);   /* another thread installed it */
+        return page;
+    }
+    return (struct kc_ticket_slot*)mem;
+}
+
+/* Push the chain first..last (linked through next_free) on the global stack. */
+static void kc_ticket_depot_push(uint32_t first, struct kc_ticket_slot *last)
+{
+    uint64_t h = atomic_load_explicit(&g_free, memory_order_relaxed);
+    do {
+        atomic_store_explicit(&last->next_free, (uint32_t)h, memory_order_relaxed);
+    } while (!atomic_compare_exchange_weak_explicit(&g_free, &h, ((h >> 32) + 1) << 32 | first,
+                                                    memory_order_release, memory_order_relaxed));
+}
+
+/* Top of the global stack (index + 1), or 0 when empty. */
+static uint32_t kc_ticket_depot_pop(void)
+{
+    uint64_t h = atomic_load_explicit(&g_free, memory_order_acquire);
+    for (;;) {
+        uint32_t top = (uint32_t)h;
+        if (!top) return 0;
+        uint32_t next = atomic_load_explicit(&kc_ticket_slot_at(top - 1)->next_free, memory_order_relaxed);
+        if (atomic_compare_exchange_weak_explicit(&g_free, &h, ((h >> 32) + 1) << 32 | next,
+                                                  memory_order_acq_rel, memory_order_acquire))
+            return top;
+    }
+}
+
+/* Move up to n slots from the thread list to the global stack. */
+static void kc_ticket_spill(struct kc_ticket_cache *c, unsigned n)
+{
+    if (!n || !c->head) return;
+    uint32_t first = c->head;
+    struct kc_ticket_slot *last = kc_ticket_slot_at(first - 1);
+    unsigned moved = 1;
+    uint32_t next;
+    while (moved < n && (next = atomic_load_explicit(&last->next_free, memory_order_relaxed)) != 0) {
+        last = kc_ticket_slot_at(next - 1);
+        moved++;
+    }
+    c->head = atomic_load_explicit(&last->next_free, memory_order_relaxed);
+    c->count -= moved;
+    kc_ticket_depot_push(first, last);
+}
+
+static void kc_ticket_cache_drain(void *arg)
+{
+    struct kc_ticket_cache *c = (struct kc_ticket_cache*)arg;
+    kc_ticket_spill(c, c->count);
+}
+
+static void kc_ticket_cache_key_init(void)
+{
+    (void)pthread_key_create(&ticket_cache_key, kc_ticket_cache_drain);
+}
+
+static void kc_ticket_cache_put(struct kc_ticket_cache *c, uint32_t top)
+{
+    atomic_store_explicit(&kc_ticket_slot_at(top - 1)->next_free, c->head, memory_order_relaxed);
+    c->head = top;
+    c->count++;
+}
+
+/* Refill an empty thread list from the global stack, else carve new indices. */
+static int kc_ticket_refill(struct kc_ticket_cache *c)
+{
+    if (!c->registered) {
+        pthread_once(&ticket_cache_once, kc_ticket_cache_key_init);
+        (void)pthread_setspecific(ticket_cache_key, c);
+        c->registered = 1;
+    }
+    unsigned want = KCORO_TICKET_CACHE_PER_THREAD / 2 ? KCORO_TICKET_CACHE_PER_THREAD / 2 : 1;
+    uint32_t top;
+    for (unsigned i = 0; i < want && (top = kc_ticket_depot_pop()) != 0; i++) kc_ticket_cache_put(c, top);
+    if (c->head) return 0;
+
+    uint32_t base = atomic_load_explicit(&g_carved, memory_order_relaxed), n;
+    do {
+        n = KCORO_TICKET_MAX - base < want ? KCORO_TICKET_MAX - base : want;
+        if (n == 0) return -ENOMEM;
+    } while (!atomic_compare_exchange_weak_explicit(&g_carved, &base, base + n,
+                                                    memory_order_relaxed, memory_order_relaxed));
+    for (uint32_t i = n; i-- > 0;) {
+        if (!kc_ticket_page((base + i) >> KC_TICKET_PAGE_SHIFT)) continue;   /* OOM: index lost */
+        kc_ticket_cache_put(c, base + i + 1);
+    }
+    return c->head ? 0 : -ENOMEM;
+}
+
+/* Out of line so the TLS address is never cached across a coroutine switch. */
+__attribute__((noinline)) static int kc_ticket_slot_alloc(uint32_t *idx)
+{
+    struct kc_ticket_cache *c = &tls_tickets;
+    if (!c->head && kc_ticket_refill(c) != 0) return -ENOMEM;
+    uint32_t top = c->head;
+    c->head = atomic_load_explicit(&kc_ticket_slot_at(top - 1)->next_free, memory_order_relaxed);
+    c->count--;
+    *idx = top - 1;
+    return 0;
+}
+
+__attribute__((noinline)) static void kc_ticket_slot_free(uint32_t idx)
+{
+    struct kc_ticket_cache *c = &tls_tickets;
+    kc_ticket_cache_put(c, idx + 1);
+    if (c->count > KCORO_TICKET_CACHE_PER_THREAD)
+        kc_ticket_spill(c, c->count - KCORO_TICKET_CACHE_PER_THREAD / 2);
+}
+
+/* ---- Publish / complete ---- */
+
+kc_ticket_t kc_ticket_publish(const kc_ticket_payload_t *initial)
+{
+    kcoro_t *co = kcoro_current();
+    uint32_t idx;
+    if (!co || kc_ticket_slot_alloc(&idx) != 0) return 0;
+    struct kc_ticket_slot *s = kc_ticket_slot_at(idx);
+    uint32_t gen = KC_TS_GEN(atomic_load_explicit(&s->state, memory_order_relaxed)) + 1;
+    if (gen == 0) gen = 1;
+    kcoro_retain(co);
+    s->co = co;
+    if (initial) s->payload = *initial;
+    else memset(&s->payload, 0, sizeof(s->payload));
+    s->qnext = 0;
+    atomic_store_explicit(&s->state, KC_TS(gen, KC_TS_ARMED), memory_order_release);
+    return (kc_ticket_t)gen << 32 | (idx + 1);
+}
+
+/* Make a switched-out owner runnable, as kc_chan_schedule_wake does. */
+static void kc_ticket_wake(kcoro_t *co, int lane)
+{
+    kc_sched_t *s = (kc_sched_t*)co->scheduler;
+    if (!s) s = kc_sched_current() ? kc_sched_current() : kc_sched_default();
+    if (lane != KC_LANE_INHERIT) kc_sched_enqueue_ready_lane(s, co, (kc_lane_t)lane);
+    if (kcoro_is_parked(co)) kcoro_unpark(co);
+    kc_sched_enqueue_ready(s, co);
+}
+
+int kc_ticket_complete_lane(kc_ticket_t t, kc_ticket_payload_t *io, int lane)
+{
+    struct kc_ticket_slot *s = kc_ticket_slot_of(t);
+    if (!s || !io) return -EINVAL;
+    uint32_t gen = (uint32_t)(t >> 32);
+    uint64_t st = atomic_load_explicit(&s->state, memory_order_acquire);
+    unsigned phase;
+    for (;;) {
+        phase = KC_TS_PHASE(st);
+        if (KC_TS_GEN(st) != gen || (phase != KC_TS_ARMED && phase != KC_TS_PARKED)) return -ESTALE;
+        if (atomic_compare_exchange_weak_explicit(&s->state, &st, KC_TS(gen, KC_TS_BUSY),
+                                                  memory_order_acq_rel, memory_order_acquire))
+            break;
+    }
+    kc_ticket_payload_t mine = s->payload;
+    s->payload = *io;
+    *io = mine;
+    /* The owner may free the slot as soon as it sees DONE: take co first. */
+    kcoro_t *co = s->co;
+    if (phase == KC_TS_PARKED) kcoro_retain(co);
+    atomic_store_explicit(&s->state, KC_TS(gen, KC_TS_DONE), memory_order_release);
+    if (phase == KC_TS_PARKED) {
+        kc_ticket_wake(co, lane);
+        kcoro_release(co);
+    }
+    return 0;
+}
+
+int kc_ticket_complete(kc_ticket_t t, kc_ticket_payload_t *io)
+{
+    return kc_ticket_complete_lane(t, io, KC_LANE_INHERIT);
+}
+
+int kc_ticket_cancel(kc_ticket_t t, int reason)
+{
+    kc_ticket_payload_t p = { .ptr = NULL, .len = 0, .status = reason, .data = 0 };
+    return kc_ticket_complete_lane(t, &p, KC_LANE_INHERIT);
+}
+
+/* ---- Wait ---- */
+
+struct kc_ticket_park {
+    _Atomic uint64_t *state;
+    uint64_t armed;       /* KC_TS(gen, ARMED) */
+    kc_sched_t *sched;
+    kcoro_t *co;
+    long deadline_ns;
+    kc_timer_handle_t timer;
+};
+
+/* Runs on the worker once the owner switched out. Everything is read before
+ * the CAS: from then on a completer may resume the owner and end `arg`. */
+static void kc_ticket_park_release(void *arg)
+{
+    struct kc_ticket_park *p = (struct kc_ticket_park*)arg;
+    _Atomic uint64_t *state = p->state;
+    const uint64_t armed = p->armed;
+    kc_sched_t *s = p->sched;
+    kcoro_t *co = p->co;
+    if (kc_cancel_wait_arm(co)) {                        /* token fired first */
+        kc_sched_enqueue_ready(s, co);
+        return;
+    }
+    if (p->deadline_ns > 0)
+        p->timer = kc_sched_timer_wake_at(s, co, (unsigned long long)p->deadline_ns);
+    const uint64_t parked = (armed & ~0xffffffffull) | KC_TS_PARKED;
+    unsigned spins = 0;
+    uint64_t st = armed;
+    while (!atomic_compare_exchange_weak_explicit(state, &st, parked,
+                                                  memory_order_acq_rel, memory_order_acquire)) {
+        if (st == armed) continue;                      /* spurious failure */
+        if (KC_TS_PHASE(st) == KC_TS_BUSY) { kc_ticket_relax(&spins); st = armed; continue; }
+        kc_sched_enqueue_ready(s, co);                  /* completed before we parked */
+        return;
+    }
+}
+
+int kc_ticket_wait_until(kc_ticket_t t, long deadline_ns, kc_ticket_payload_t *out)
+{
+    struct kc_ticket_slot *s = kc_ticket_slot_of(t);
+    if (!s) return -EINVAL;
+    const uint32_t gen = (uint32_t)(t >> 32);
+    kcoro_t *self = kcoro_current();
+    int cancelled = kc_cancel_wait_fired(self);
+    unsigned spins = 0;
+    for (;;) {
+        uint64_t st = atomic_load_explicit(&s->state, memory_order_acquire);
+        if (KC_TS_GEN(st) != gen) return -EINVAL;
+        unsigned phase = KC_TS_PHASE(st);
+        if (phase == KC_TS_DONE) {
+            if (out) *out = s->payload;
+            return s->payload.status;
+        }
+        if (phase == KC_TS_BUSY) { kc_ticket_relax(&spins); continue; }
+        if (phase == KC_TS_GONE) return KC_ETIME;
+        if (phase != KC_TS_ARMED && phase != KC_TS_PARKED) return -EINVAL;
+        /* Armed, or parked but resumed by the timer, the cancel token or a
+         * stray wake: give up, or take the ticket back and park again. */
+        int expired = deadline_ns > 0 && kc_now_ns() >= deadline_ns;
+        if (cancelled || expired) {
+            if (atomic_compare_exchange_strong_explicit(&s->state, &st, KC_TS(gen, KC_TS_GONE),
+                                                        memory_order_acq_rel, memory_order_acquire))
+                return cancelled ? KC_ECANCELED : KC_ETIME;
+            continue;
+        }
+        if (phase == KC_TS_PARKED) {
+            (void)atomic_compare_exchange_strong_explicit(&s->state, &st, KC_TS(gen, KC_TS_ARMED),
+                                                          memory_order_acq_rel, memory_order_acquire);
+            continue;
+        }
+        struct kc_ticket_park p_local = { .state = &s->state, .armed = st, .sched = kc_sched_current(),
+                                          .co = self, .deadline_ns = deadline_ns, .timer = {0} };
+        struct kc_ticket_park *p = p_local.sched && self ? kcoro_park_record(self, &p_local, sizeof(p_local))
+                                                         : NULL;
+        if (!p || kc_sched_park_release(kc_ticket_park_release, p) != 0) {
+            /* Not on a worker (or no memory for the record): cooperative retry. */
+            kcoro_park_record_free(p, &p_local);
+            kcoro_yield();
+            cancelled = kc_cancel_wait_fired(self);
+            continue;
+        }
+        (void)kc_sched_timer_cancel(p->sched, p->timer);
+        kcoro_park_record_free(p, &p_local);
+        if (kc_cancel_wait_disarm(self)) cancelled = 1;
+    }
+}
+
+void kc_ticket_release(kc_ticket_t t)
+{
+    struct kc_ticket_slot *s = kc_ticket_slot_of(t);
+    if (!s) return;
+    kcoro_t *co = s->co;
+    s->co = NULL;
+    atomic_store_explicit(&s->state, KC_TS((uint32_t)(t >> 32), KC_TS_FREE), memory_order_release);
+    kcoro_release(co);
+    kc_ticket_slot_free((uint32_t)t - 1);
+}
+
+int kc_ticket_wait(kc_ticket_t t, long timeout_ms, kc_ticket_payload_t *out)
+{
+    if (!kc_ticket_slot_of(t)) return -EINVAL;
+    long deadline_ns = timeout_ms < 0 ? 0 : timeout_ms == 0 ? 1 : kc_now_ns() + timeout_ms * 1000000L;
+    int rc = kc_ticket_wait_until(t, deadline_ns, out);
+    if (rc != -EINVAL) kc_ticket_release(t);
+    return rc;
+}
+
+/* ---- Queue ---- */
+
+void kc_ticket_queue_push(struct kc_ticket_queue *q, kc_ticket_t t)
+{
+    kc_ticket_slot_of(t)->qnext = 0;
+    if (q->tail) kc_ticket_slot_of(q->tail)->qnext = t;
+    else q->head = t;
+    q->tail = t;
+}
+
+kc_ticket_t kc_ticket_queue_pop(struct kc_ticket_queue *q)
+{
+    kc_ticket_t t = q->head;
+    if (!t) return 0;
+    struct kc_ticket_slot *s = kc_ticket_slot_of(t);
+    q->head = s->qnext;
+    if (!q->head) q->tail = 0;
+    s->qnext = 0;
+    return t;
+}
+
+int kc_ticket_queue_remove(struct kc_ticket_queue *q, kc_ticket_t t)
+{
+    kc_ticket_t prev = 0;
+    for (kc_ticket_t cur = q->head; cur; prev = cur, cur = kc_ticket_slot_of(cur)->qnext) {
+        if (cur != t) continue;
+        kc_ticket_t next = kc_ticket_slot_of(cur)->qnext;
+        if (prev) kc_ticket_slot_of(prev)->qnext = next;
+        else q->head = next;
+        if (q->tail == t) q->tail = prev;
+        kc_ticket_slot_of(cur)->qnext = 0;
+        return 1;
+    }
+    return 0;
+}
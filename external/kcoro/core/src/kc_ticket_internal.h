@@ -0,0 +1,37 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+/* Ticket internals shared with the pointer channels (kc_chan.c). */
+
+#include "../../include/kcoro_ticket.h"
+
+/* FIFO of published tickets, linked through their slots. Not thread-safe:
+ * the owner's lock (ch->mu) covers every call. A waiter that gave up
+ * (timeout) stays linked until its owner removes it, so a queued slot is
+ * never reused; pop hands out such tickets too and the caller's
+ * complete then fails with -ESTALE. */
+struct kc_ticket_queue {
+    kc_ticket_t head, tail;
+};
+
+void        kc_ticket_queue_push(struct kc_ticket_queue *q, kc_ticket_t t);
+kc_ticket_t kc_ticket_queue_pop(struct kc_ticket_queue *q);
+/* 1 if t was queued (and is now unlinked), else 0. */
+int         kc_ticket_queue_remove(struct kc_ticket_queue *q, kc_ticket_t t);
+
+static inline int kc_ticket_queue_empty(const struct kc_ticket_queue *q)
+{
+    return q->head == 0;
+}
+
+/* kc_ticket_wait split in two for tickets that sit in a kc_ticket_queue:
+ * wait_until parks (deadline_ns <= 0: none) and leaves the slot allocated,
+ * so its owner can unlink it before kc_ticket_release recycles it. It also
+ * gives up with KC_ECANCELED when the token of an enclosing _c op fires
+ * (kc_cancel_internal.h). */
+int  kc_ticket_wait_until(kc_ticket_t t, long deadline_ns, kc_ticket_payload_t *out);
+void kc_ticket_release(kc_ticket_t t);
+
+/* kc_ticket_complete waking the coroutine on `lane` (kc_lane_t;
+ * KC_LANE_INHERIT: its own). */
+int  kc_ticket_complete_lane(kc_ticket_t t, kc_ticket_payload_t *io, int lane);
@@ -0,0 +1,238 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Hierarchical timing wheel used by the scheduler workers (see
+ * kc_timer_internal.h for the layout). Level L slot s holds entries whose
+ * expiry falls in the 64^L-tick block that maps to s; when the current tick
+ * enters that block the slot is cascaded one level down, and level-0 slots
+ * fire directly. Entries that are due while cascading go straight to the
+ * due list, which also bridges the gap when a caller's output batch fills. */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "kc_timer_internal.h"
+#include "../../include/kcoro_config.h"
+#include "../../include/kc_mem.h"
+
+#define KC_TW_DUE_LEVEL  KC_TW_LEVELS      /* entry->level for the due list */
+#define KC_TW_INDEX_BITS 24
+#define KC_TW_INDEX_MASK ((1u << KC_TW_INDEX_BITS) - 1u)
+
+static inline uint64_t tw_ns_to_tick_ceil(uint64_t ns)
+{
+    return ns / KC_TW_TICK_NS + (ns % KC_TW_TICK_NS ? 1 : 0);
+}
+
+static inline int32_t *tw_list(kc_timer_wheel_t *tw, const kc_tw_entry_t *e)
+{
+    return e->level == KC_TW_DUE_LEVEL ? &tw->due_head : &tw->head[e->level][e->slot];
+}
+
+static void tw_link(kc_timer_wheel_t *tw, int32_t idx)
+{
+    kc_tw_entry_t *e = &tw->ent[idx];
+    int32_t *head = tw_list(tw, e);
+    e->prev = KC_TW_NIL;
+    e->next = *head;
+    if (*head != KC_TW_NIL) tw->ent[*head].prev = idx;
+    *head = idx;
+}
+
+static void tw_unlink(kc_timer_wheel_t *tw, int32_t idx)
+{
+    kc_tw_entry_t *e = &tw->ent[idx];
+    if (e->prev != KC_TW_NIL) tw->ent[e->prev].next = e->next;
+    else *tw_list(tw, e) = e->next;
+    if (e->next != KC_TW_NIL) tw->ent[e->next].prev = e->prev;
+    e->next = e->prev = KC_TW_NIL;
+}
+
+/* File an entry relative to tw->now_tick (or on the due list if already due). */
+static void tw_place(kc_timer_wheel_t *tw, int32_t idx)
+{
+    kc_tw_entry_t *e = &tw->ent[idx];
+    const uint64_t now = tw->now_tick;
+    if (e->expires <= now) {
+        e->level = KC_TW_DUE_LEVEL; e->slot = 0;
+        tw_link(tw, idx);
+        return;
+    }
+    int level = KC_TW_LEVELS - 1;
+    uint64_t block = (now >> (KC_TW_BITS * level)) + KC_TW_MASK; /* clamp: re-cascade later */
+    for (int l = 0; l < KC_TW_LEVELS; l++) {
+        unsigned shift = (unsigned)(KC_TW_BITS * l);
+        if ((e->expires >> shift) - (now >> shift) < KC_TW_SLOTS) {
+            level = l; block = e->expires >> shift;
+            break;
+        }
+    }
+    e->level = (uint8_t)level;
+    e->slot = (uint8_t)(block & KC_TW_MASK);
+    tw_link(tw, idx);
+}
+
+static void tw_release(kc_timer_wheel_t *tw, int32_t idx)
+{
+    kc_tw_entry_t *e = &tw->ent[idx];
+    e->active = 0;
+    e->co = NULL;
+    if (++e->gen == 0) e->gen = 1;
+    e->next = tw->free_head;
+    tw->free_head = idx;
+    atomic_fetch_sub_explicit(&tw->pending, 1, memory_order_relaxed);
+}
+
+static int tw_grow(kc_timer_wheel_t *tw)
+{
+    uint32_t ncap = tw->cap ? tw->cap * 2 : 64;
+    if (ncap > KC_TW_INDEX_MASK + 1u) return -1;
+    size_t more = (size_t)(ncap - tw->cap) * sizeof(kc_tw_entry_t);
+    if (kc_mem_charge(KC_MEM_TIMERS, more) != 0) return -1;
+    kc_tw_entry_t *n = (kc_tw_entry_t*)realloc(tw->ent, (size_t)ncap * sizeof(*n));
+    if (!n) { kc_mem_uncharge(KC_MEM_TIMERS, more); return -1; }
+    for (uint32_t i = tw->cap; i < ncap; i++) {
+        memset(&n[i], 0, sizeof(n[i]));
+        n[i].gen = 1;
+        n[i].prev = KC_TW_NIL;
+        n[i].next = (i + 1 < ncap) ? (int32_t)(i + 1) : tw->free_head;
+    }
+    tw->free_head = (int32_t)tw->cap;
+    tw->ent = n;
+    tw->cap = ncap;
+    return 0;
+}
+
+int kc_timer_wheel_init(kc_timer_wheel_t *tw, uint32_t wheel_no, uint64_t now_ns)
+{
+    memset(tw, 0, sizeof(*tw));
+    if (pthread_mutex_init(&tw->mu, NULL) != 0) return -1;
+    for (int l = 0; l < KC_TW_LEVELS; l++)
+        for (unsigned i = 0; i < KC_TW_SLOTS; i++) tw->head[l][i] = KC_TW_NIL;
+    tw->due_head = KC_TW_NIL;
+    tw->free_head = KC_TW_NIL;
+    tw->now_tick = now_ns / KC_TW_TICK_NS;
+    tw->wheel_no = wheel_no;
+    atomic_store(&tw->pending, 0);
+    return 0;
+}
+
+void kc_timer_wheel_destroy(kc_timer_wheel_t *tw)
+{
+    kc_mem_uncharge(KC_MEM_TIMERS, (size_t)tw->cap * sizeof(kc_tw_entry_t));
+    free(tw->ent);
+    tw->ent = NULL;
+    tw->cap = 0;
+    pthread_mutex_destroy(&tw->mu);
+}
+
+uint64_t kc_timer_wheel_add(kc_timer_wheel_t *tw, kcoro_t *co, uint64_t deadline_ns)
+{
+    pthread_mutex_lock(&tw->mu);
+    if (tw->free_head == KC_TW_NIL && tw_grow(tw) != 0) {
+        pthread_mutex_unlock(&tw->mu);
+        return 0;
+    }
+    int32_t idx = tw->free_head;
+    kc_tw_entry_t *e = &tw->ent[idx];
+    tw->free_head = e->next;
+    e->co = co;
+    e->expires = tw_ns_to_tick_ceil(deadline_ns);
+    e->active = 1;
+    tw_place(tw, idx);
+    atomic_fetch_add_explicit(&tw->pending, 1, memory_order_relaxed);
+    uint64_t id = ((uint64_t)e->gen << 32) | ((uint64_t)(tw->wheel_no & 0xFFu) << KC_TW_INDEX_BITS) | (uint64_t)idx;
+    pthread_mutex_unlock(&tw->mu);
+    return id;
+}
+
+int kc_timer_wheel_cancel(kc_timer_wheel_t *tw, uint64_t id)
+{
+    uint32_t idx = (uint32_t)(id & KC_TW_INDEX_MASK);
+    uint32_t gen = (uint32_t)(id >> 32);
+    int ok = 0;
+    pthread_mutex_lock(&tw->mu);
+    if (idx < tw->cap && tw->ent[idx].active && tw->ent[idx].gen == gen) {
+        tw_unlink(tw, (int32_t)idx);
+        tw_release(tw, (int32_t)idx);
+        ok = 1;
+    }
+    pthread_mutex_unlock(&tw->mu);
+    return ok;
+}
+
+/* Move every entry of one slot through tw_place (cascade or fire). */
+static void tw_replace_slot(kc_timer_wheel_t *tw, int level, unsigned slot)
+{
+    int32_t idx = tw->head[level][slot];
+    tw->head[level][slot] = KC_TW_NIL;
+    while (idx != KC_TW_NIL) {
+        int32_t next = tw->ent[idx].next;
+        tw_place(tw, idx);
+        idx = next;
+    }
+}
+
+static uint64_t tw_next_tick_locked(kc_timer_wheel_t *tw)
+{
+    if (tw->due_head != KC_TW_NIL) return tw->now_tick;
+    uint64_t best = UINT64_MAX;
+    for (int l = 0; l < KC_TW_LEVELS; l++) {
+        unsigned shift = (unsigned)(KC_TW_BITS * l);
+        uint64_t base = tw->now_tick >> shift;
+        for (uint64_t k = 1; k <= KC_TW_SLOTS; k++) {
+            if (tw->head[l][(base + k) & KC_TW_MASK] != KC_TW_NIL) {
+                uint64_t t = (base + k) << shift;
+                if (t < best) best = t;
+                break;
+            }
+        }
+    }
+    return best;
+}
+
+size_t kc_timer_wheel_expire(kc_timer_wheel_t *tw, uint64_t now_ns, kcoro_t **out, size_t max)
+{
+    size_t n = 0;
+    const uint64_t target = now_ns / KC_TW_TICK_NS;
+    pthread_mutex_lock(&tw->mu);
+    if (atomic_load_explicit(&tw->pending, memory_order_relaxed) == 0) {
+        if (target > tw->now_tick) tw->now_tick = target;
+        pthread_mutex_unlock(&tw->mu);
+        return 0;
+    }
+    /* Skip idle stretches: nothing cascades or fires before the next tick. */
+    uint64_t next = tw_next_tick_locked(tw);
+    if (next != UINT64_MAX && next > tw->now_tick + 1) {
+        uint64_t skip_to = next - 1 < target ? next - 1 : target;
+        if (skip_to > tw->now_tick) tw->now_tick = skip_to;
+    }
+    for (;;) {
+        while (n < max && tw->due_head != KC_TW_NIL) {
+            int32_t idx = tw->due_head;
+            out[n++] = tw->ent[idx].co;
+            tw_unlink(tw, idx);
+            tw_release(tw, idx);
+        }
+        if (n == max || tw->now_tick >= target) break;
+        const uint64_t t = ++tw->now_tick;
+        /* Highest levels first so cascaded entries land in this tick's slot. */
+        for (int l = KC_TW_LEVELS - 1; l >= 1; l--) {
+            unsigned shift = (unsigned)(KC_TW_BITS * l);
+            if ((t & ((1ull << shift) - 1)) == 0)
+                tw_replace_slot(tw, l, (unsigned)((t >> shift) & KC_TW_MASK));
+        }
+        tw_replace_slot(tw, 0, (unsigned)(t & KC_TW_MASK));
+    }
+    pthread_mutex_unlock(&tw->mu);
+    return n;
+}
+
+uint64_t kc_timer_wheel_next_ns(kc_timer_wheel_t *tw)
+{
+    if (atomic_load_explicit(&tw->pending, memory_order_relaxed) == 0) return UINT64_MAX;
+    pthread_mutex_lock(&tw->mu);
+    uint64_t t = tw_next_tick_locked(tw);
+    pthread_mutex_unlock(&tw->mu);
+    return t == UINT64_MAX ? t : t * KC_TW_TICK_NS;
+}
+
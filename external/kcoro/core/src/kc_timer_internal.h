@@ -0,0 +1,78 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "../../include/kcoro_core.h"
+#include "kc_clock_internal.h"
+
+/* Hashed hierarchical timing wheel (Varghese & Lauck), one per scheduler
+ * worker. Internal to kc_sched.c / kc_timer.c; not part of the public API.
+ *
+ * - 1 ms ticks, KC_TW_LEVELS levels of KC_TW_SLOTS slots each (64^4 ms ≈ 4.6 h
+ *   of direct range; longer deadlines park in the last level and cascade).
+ * - Entries live in a per-wheel slab and are linked by index, so insert and
+ *   cancel are O(1) and a cancelled entry returns to the freelist at once.
+ * - Handles encode (generation, wheel, slot index); a stale handle (fired or
+ *   cancelled entry) simply fails the generation check.
+ * - The mutex is normally uncontended: the owning worker arms and fires, other
+ *   threads only take it to cancel or to arm on behalf of a foreign thread. */
+
+#define KC_TW_BITS   6
+#define KC_TW_SLOTS  (1u << KC_TW_BITS)
+#define KC_TW_MASK   (KC_TW_SLOTS - 1u)
+#define KC_TW_LEVELS 4
+#define KC_TW_NIL    (-1)
+#define KC_TW_TICK_NS 1000000ull
+
+typedef struct kc_tw_entry {
+    uint64_t expires;   /* absolute tick */
+    kcoro_t *co;        /* coroutine to enqueue when due */
+    int32_t  next, prev;/* slot list links, or freelist link in next */
+    uint32_t gen;       /* bumped on every release; part of the handle */
+    uint8_t  level, slot, active;
+} kc_tw_entry_t;
+
+typedef struct kc_timer_wheel {
+    pthread_mutex_t mu;
+    uint64_t now_tick;                          /* last processed tick */
+    int32_t  head[KC_TW_LEVELS][KC_TW_SLOTS];
+    int32_t  due_head;                          /* expired, not yet handed out */
+    kc_tw_entry_t *ent;
+    uint32_t cap;
+    int32_t  free_head;
+    _Atomic(uint32_t) pending;                  /* armed entries */
+    uint32_t wheel_no;                          /* owner index, encoded in handles */
+} kc_timer_wheel_t;
+
+int  kc_timer_wheel_init(kc_timer_wheel_t *tw, uint32_t wheel_no, uint64_t now_ns);
+void kc_timer_wheel_destroy(kc_timer_wheel_t *tw);
+
+/** Arm a wake for `co` at absolute CLOCK_MONOTONIC `deadline_ns`. Returns the
+ *  handle id (never 0) or 0 on allocation failure. */
+uint64_t kc_timer_wheel_add(kc_timer_wheel_t *tw, kcoro_t *co, uint64_t deadline_ns);
+
+/** Cancel by handle id. Returns 1 if the entry was armed and is now freed. */
+int kc_timer_wheel_cancel(kc_timer_wheel_t *tw, uint64_t id);
+
+/** Advance to `now_ns`, writing up to `max` due coroutines into `out`.
+ *  Returns how many were written; call again while it returns `max`. */
+size_t kc_timer_wheel_expire(kc_timer_wheel_t *tw, uint64_t now_ns, kcoro_t **out, size_t max);
+
+/** Lower bound on the next deadline (CLOCK_MONOTONIC ns) or UINT64_MAX. */
+uint64_t kc_timer_wheel_next_ns(kc_timer_wheel_t *tw);
+
+static inline uint32_t kc_timer_wheel_pending(kc_timer_wheel_t *tw)
+{
+    return atomic_load_explicit(&tw->pending, memory_order_relaxed);
+}
+
+/** Wheel number encoded in a handle id. */
+static inline uint32_t kc_timer_id_wheel(uint64_t id)
+{
+    return (uint32_t)((id >> 24) & 0xFFu);
+}
+
@@ -0,0 +1,358 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/*
+ * kc_trace.c — per-thread scheduler event rings and Chrome trace export
+ * --------------------------------------------------------------------
+ *
+ * Recording
+ * - Every thread that hits a trace point while tracing is on gets a ring of
+ *   32-byte records, allocated on its first event and registered in a global
+ *   list. Only the owner writes it: fill slot head & mask, then publish
+ *   head + 1 with a release store. No locks or shared lines on the hot path.
+ * - Stamps are raw CPU ticks (TSC, CNTVCT) where available and are turned
+ *   into nanoseconds at dump time from two clock_gettime/tick pairs.
+ *
+ * Lifetime
+ * - kc_trace_start bumps the generation; an owner that finds its ring from
+ *   an older trace abandons it and attaches a fresh one. Abandoned rings and
+ *   rings of exited threads are marked dead and freed by the next start, so
+ *   a reader never sees a ring vanish under it.
+ */
+#define _GNU_SOURCE 1
+#include <errno.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+#include "kcoro_config.h"
+#include "kcoro_sched.h"
+#include "kc_trace_internal.h"
+#include "kc_hist_internal.h" /* kc_sched_self_index */
+#include "kc_clock_internal.h"
+
+#define TRACE_MAX_EVENTS (1u << 24)
+
+struct kc_trace_rec {
+    uint64_t ticks;
+    uint64_t co;       /* coroutine id, 0 when none */
+    uint64_t arg;
+    uint32_t ev;
+    uint32_t pad;
+};
+
+struct kc_trace_ring {
+    _Atomic uint64_t head;     /* records written in this ring's trace */
+    uint64_t mask;
+    unsigned gen;              /* trace this ring belongs to */
+    int tid;
+    int worker;                /* kc_sched_self_index at attach, or -1 */
+    _Atomic int dead;          /* owner gone or moved on; freed by next start */
+    struct kc_trace_ring *next;
+    struct kc_trace_rec recs[];
+};
+
+_Atomic int kc_trace_on;
+
+static pthread_mutex_t g_mu = PTHREAD_MUTEX_INITIALIZER;
+static struct kc_trace_ring *g_rings;      /* g_mu */
+static _Atomic unsigned g_gen;
+static size_t g_events;                    /* g_mu */
+static uint64_t g_t0_ticks, g_t0_ns;       /* calibration at start */
+static uint64_t g_t1_ticks, g_t1_ns;       /* and at stop (0 while running) */
+static pthread_once_t g_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t g_key;
+
+static __thread struct kc_trace_ring *tls_ring;
+static __thread unsigned tls_failed_gen;   /* allocation failed for this trace */
+
+static inline uint64_t trace_ns(void)
+{
+    return kc_clock_mono_ns();
+}
+
+static inline uint64_t trace_ticks(void)
+{
+    return kc_clock_ticks();
+}
+
+static int trace_tid(void)
+{
+#ifdef __linux__
+    return (int)syscall(SYS_gettid);
+#else
+    static _Atomic int next_tid = 1;
+    return atomic_fetch_add_explicit(&next_tid, 1, memory_order_relaxed);
+#endif
+}
+
+static void trace_thread_exit(void *p)
+{
+    atomic_store_explicit(&((struct kc_trace_ring*)p)->dead, 1, memory_order_release);
+}
+
+static void trace_key_init(void)
+{
+    (void)pthread_key_create(&g_key, trace_thread_exit);
+}
+
+/* Slow path of kc_trace_emit: give the calling thread a ring in the current
+ * trace, or NULL when tracing stopped or the allocation failed. */
+static struct kc_trace_ring *trace_attach(void)
+{
+    if (tls_failed_gen == atomic_load_explicit(&g_gen, memory_order_relaxed)) return NULL;
+    pthread_once(&g_key_once, trace_key_init);
+    pthread_mutex_lock(&g_mu);
+    unsigned gen = atomic_load_explicit(&g_gen, memory_order_relaxed);
+    struct kc_trace_ring *old = tls_ring, *r = NULL;
+    if (old && old->gen == gen) { pthread_mutex_unlock(&g_mu); return old; }
+    if (atomic_load_explicit(&kc_trace_on, memory_order_relaxed) && tls_failed_gen != gen) {
+        r = (struct kc_trace_ring*)malloc(sizeof(*r) + g_events * sizeof(r->recs[0]));
+        if (r) {
+            atomic_init(&r->head, 0);
+            r->mask = g_events - 1;
+            r->gen = gen;
+            r->tid = trace_tid();
+            r->worker = kc_sched_self_index();
+            atomic_init(&r->dead, 0);
+            r->next = g_rings;
+            g_rings = r;
+        } else {
+            tls_failed_gen = gen;
+        }
+    }
+    if (old) atomic_store_explicit(&old->dead, 1, memory_order_release);
+    tls_ring = r;
+    (void)pthread_setspecific(g_key, r);
+    pthread_mutex_unlock(&g_mu);
+    return r;
+}
+
+void kc_trace_emit(enum kc_trace_event ev, const kcoro_t *co, uint64_t arg)
+{
+    struct kc_trace_ring *r = tls_ring;
+    if (__builtin_expect(!r || r->gen != atomic_load_explicit(&g_gen, memory_order_relaxed), 0)
+        && !(r = trace_attach()))
+        return;
+    uint64_t h = atomic_load_explicit(&r->head, memory_order_relaxed);
+    struct kc_trace_rec *rec = &r->recs[h & r->mask];
+    rec->ticks = trace_ticks();
+    rec->co = co ? co->id : 0;
+    rec->arg = arg;
+    rec->ev = (uint32_t)ev;
+    atomic_store_explicit(&r->head, h + 1, memory_order_release);
+}
+
+int kc_trace_start(size_t events_per_thread)
+{
+    if (events_per_thread == 0) events_per_thread = KCORO_TRACE_EVENTS;
+    if (events_per_thread > TRACE_MAX_EVENTS) return -EINVAL;
+    size_t cap = 16;
+    while (cap < events_per_thread) cap <<= 1;
+    pthread_mutex_lock(&g_mu);
+    if (atomic_load_explicit(&kc_trace_on, memory_order_relaxed)) {
+        pthread_mutex_unlock(&g_mu);
+        return -EBUSY;
+    }
+    struct kc_trace_ring **pp = &g_rings;
+    while (*pp) {
+        struct kc_trace_ring *r = *pp;
+        if (atomic_load_explicit(&r->dead, memory_order_acquire)) { *pp = r->next; free(r); }
+        else pp = &r->next;
+    }
+    g_events = cap;
+    g_t0_ns = trace_ns();
+    g_t0_ticks = trace_ticks();
+    g_t1_ns = g_t1_ticks = 0;
+    atomic_fetch_add_explicit(&g_gen, 1, memory_order_relaxed);
+    atomic_store_explicit(&kc_trace_on, 1, memory_order_release);
+    pthread_mutex_unlock(&g_mu);
+    return 0;
+}
+
+void kc_trace_stop(void)
+{
+    pthread_mutex_lock(&g_mu);
+    if (atomic_exchange_explicit(&kc_trace_on, 0, memory_order_acq_rel)) {
+        g_t1_ns = trace_ns();
+        g_t1_ticks = trace_ticks();
+    }
+    pthread_mutex_unlock(&g_mu);
+}
+
+int kc_trace_active(void)
+{
+    return atomic_load_explicit(&kc_trace_on, memory_order_relaxed);
+}
+
+/* Rings of the current trace; caller holds g_mu. */
+static inline int trace_ring_current(const struct kc_trace_ring *r)
+{
+    return r->gen == atomic_load_explicit(&g_gen, memory_order_relaxed);
+}
+
+void kc_trace_get_stats(kc_trace_stats_t *out)
+{
+    if (!out) return;
+    memset(out, 0, sizeof(*out));
+    pthread_mutex_lock(&g_mu);
+    for (struct kc_trace_ring *r = g_rings; r; r = r->next) {
+        if (!trace_ring_current(r)) continue;
+        uint64_t h = atomic_load_explicit(&r->head, memory_order_acquire);
+        out->events += h;
+        if (h > r->mask + 1) out->overwritten += h - (r->mask + 1);
+        out->threads++;
+    }
+    pthread_mutex_unlock(&g_mu);
+}
+
+/* ---- Chrome trace-event JSON ---- */
+
+struct trace_out {
+    int fd;
+    int err;
+    size_t n;
+    char buf[16384];
+};
+
+static void out_flush(struct trace_out *o)
+{
+    size_t off = 0;
+    while (!o->err && off < o->n) {
+        ssize_t w = write(o->fd, o->buf + off, o->n - off);
+        if (w < 0) { if (errno != EINTR) o->err = errno; continue; }
+        off += (size_t)w;
+    }
+    o->n = 0;
+}
+
+static void out_printf(struct trace_out *o, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+static void out_printf(struct trace_out *o, const char *fmt, ...)
+{
+    if (o->err) return;
+    if (sizeof(o->buf) - o->n < 512) out_flush(o);
+    va_list ap;
+    va_start(ap, fmt);
+    int w = vsnprintf(o->buf + o->n, sizeof(o->buf) - o->n, fmt, ap);
+    va_end(ap);
+    if (w > 0) o->n += (size_t)w < sizeof(o->buf) - o->n ? (size_t)w : sizeof(o->buf) - o->n - 1;
+}
+
+static const char *trace_state_name(uint64_t st)
+{
+    switch (st) {
+    case KCORO_READY: case KCORO_SUSPENDED: return "yielded";
+    case KCORO_PARKED: return "parked";
+    case KCORO_FINISHED: return "finished";
+    default: return "running";
+    }
+}
+
+static const char *trace_instant_name(uint32_t ev)
+{
+    switch (ev) {
+    case KC_TRACE_SPAWN: return "spawn";
+    case KC_TRACE_PARK: return "park";
+    case KC_TRACE_WAKE: return "wake";
+    case KC_TRACE_STEAL: return "steal";
+    case KC_TRACE_TIMER: return "timer";
+    case KC_TRACE_CHAN_BLOCK: return "chan block";
+    case KC_TRACE_CHAN_WAKE: return "chan wake";
+    default: return "event";
+    }
+}
+
+static void trace_dump_ring(struct trace_out *o, const struct kc_trace_ring *r, int pid,
+                            uint64_t t0, double ns_per_tick, int *first)
+{
+    uint64_t head = atomic_load_explicit(&r->head, memory_order_acquire);
+    uint64_t cap = r->mask + 1;
+    /* The oldest slot of a wrapped ring may be under rewrite */
+    uint64_t i = head > cap ? head - cap + 1 : 0;
+    int open = 0;      /* a "B" without its "E" yet */
+    uint64_t open_co = 0;
+    double last_us = 0.0;
+    for (; i < head; i++) {
+        const struct kc_trace_rec *e = &r->recs[i & r->mask];
+        double us = e->ticks > t0 ? (double)(e->ticks - t0) * ns_per_tick / 1000.0 : 0.0;
+        last_us = us;
+        if (e->ev == KC_TRACE_SWITCH_OUT && (!open || open_co != e->co)) continue; /* B lost to wrap */
+        const char *sep = *first ? "" : ",\n";
+        *first = 0;
+        switch (e->ev) {
+        case KC_TRACE_RESUME:
+            if (open) out_printf(o, "%s{\"ph\":\"E\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f},\n", sep, pid, r->tid, us), sep = "";
+            out_printf(o, "%s{\"ph\":\"B\",\"cat\":\"co\",\"name\":\"co %llu\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f},\n"
+                       "{\"ph\":\"f\",\"bp\":\"e\",\"cat\":\"wake\",\"name\":\"wake\",\"id\":%llu,\"pid\":%d,\"tid\":%d,\"ts\":%.3f}",
+                       sep, (unsigned long long)e->co, pid, r->tid, us,
+                       (unsigned long long)e->co, pid, r->tid, us);
+            open = 1;
+            open_co = e->co;
+            break;
+        case KC_TRACE_SWITCH_OUT:
+            out_printf(o, "%s{\"ph\":\"E\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"args\":{\"state\":\"%s\"}}",
+                       sep, pid, r->tid, us, trace_state_name(e->arg));
+            open = 0;
+            break;
+        default:
+            out_printf(o, "%s{\"ph\":\"i\",\"s\":\"t\",\"cat\":\"kcoro\",\"name\":\"%s\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,"
+                       "\"args\":{\"co\":%llu,\"arg\":\"0x%llx\"}}",
+                       sep, trace_instant_name(e->ev), pid, r->tid, us,
+                       (unsigned long long)e->co, (unsigned long long)e->arg);
+            if (e->ev == KC_TRACE_WAKE || e->ev == KC_TRACE_SPAWN)
+                out_printf(o, ",\n{\"ph\":\"s\",\"cat\":\"wake\",\"name\":\"wake\",\"id\":%llu,\"pid\":%d,\"tid\":%d,\"ts\":%.3f}",
+                           (unsigned long long)e->co, pid, r->tid, us);
+            break;
+        }
+    }
+    if (open) out_printf(o, ",\n{\"ph\":\"E\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f}", pid, r->tid, last_us);
+}
+
+int kc_trace_dump_chrome(int fd)
+{
+    if (fd < 0) return -EBADF;
+    struct trace_out *o = (struct trace_out*)malloc(sizeof(*o));
+    if (!o) return -ENOMEM;
+    o->fd = fd;
+    o->err = 0;
+    o->n = 0;
+    int pid = (int)getpid();
+    pthread_mutex_lock(&g_mu);
+    uint64_t t1_ticks = g_t1_ticks, t1_ns = g_t1_ns;
+    if (!t1_ticks) { t1_ns = trace_ns(); t1_ticks = trace_ticks(); }
+    double ns_per_tick = t1_ticks > g_t0_ticks
+        ? (double)(t1_ns - g_t0_ns) / (double)(t1_ticks - g_t0_ticks) : 1.0;
+    out_printf(o, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    int first = 1;
+    for (struct kc_trace_ring *r = g_rings; r; r = r->next) {
+        if (!trace_ring_current(r)) continue;
+        char name[48];
+        if (r->worker >= 0) snprintf(name, sizeof(name), "kc worker %d", r->worker);
+        else snprintf(name, sizeof(name), "thread %d", r->tid);
+        out_printf(o, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                   first ? "" : ",\n", pid, r->tid, name);
+        first = 0;
+        trace_dump_ring(o, r, pid, g_t0_ticks, ns_per_tick, &first);
+    }
+    pthread_mutex_unlock(&g_mu);
+    out_printf(o, "\n]}\n");
+    out_flush(o);
+    int err = o->err;
+    free(o);
+    return err ? -err : 0;
+}
+
+int kc_trace_dump_chrome_file(const char *path)
+{
+    if (!path) return -EINVAL;
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return -errno;
+    int rc = kc_trace_dump_chrome(fd);
+    if (close(fd) != 0 && rc == 0) rc = -errno;
+    return rc;
+}
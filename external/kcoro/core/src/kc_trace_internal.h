@@ -0,0 +1,31 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include "../../include/kcoro_core.h"
+
+/* Trace points (kc_trace.c). KC_TRACE costs one relaxed load and a branch
+ * predicted not taken while tracing is off; on, it appends one record to the
+ * calling thread's ring. `co` may be NULL; `arg` is event specific. */
+enum kc_trace_event {
+    KC_TRACE_SPAWN = 1,  /* co queued for its first run; arg = lane */
+    KC_TRACE_RESUME,     /* worker switches into co */
+    KC_TRACE_SWITCH_OUT, /* co left the worker; arg = kcoro_state_t */
+    KC_TRACE_PARK,       /* co parks */
+    KC_TRACE_WAKE,       /* co made runnable again; arg = lane */
+    KC_TRACE_STEAL,      /* task taken from another worker; arg = victim */
+    KC_TRACE_TIMER,      /* timer fired for co */
+    KC_TRACE_CHAN_BLOCK, /* co blocks on a channel; arg = channel */
+    KC_TRACE_CHAN_WAKE,  /* channel hands co a wake; arg = channel */
+};
+
+extern _Atomic int kc_trace_on;
+
+void kc_trace_emit(enum kc_trace_event ev, const kcoro_t *co, uint64_t arg);
+
+#define KC_TRACE(ev, co, arg)                                                   \
+    do {                                                                        \
+        if (__builtin_expect(atomic_load_explicit(&kc_trace_on, memory_order_relaxed), 0)) \
+            kc_trace_emit((ev), (co), (uint64_t)(arg));                         \
+    } while (0)
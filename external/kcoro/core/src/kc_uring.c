@@ -0,0 +1,649 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* io_uring backend for the kc_io_* calls (kcoro_io.h).
+ *
+ * - Every worker thread that issues I/O gets its own ring (created lazily,
+ *   handed to the next worker thread when it exits). Only the owning worker
+ *   fills and submits SQEs, so the submission side needs no lock.
+ * - An op lives on the calling coroutine's stack. Its SQE is written from a
+ *   kc_sched_park_release hook, i.e. after the coroutine has switched out, so
+ *   no completion can requeue it before the park. The hook submits at once
+ *   only past KCORO_URING_BATCH queued SQEs; otherwise the worker submits
+ *   when it runs out of ready work (kc_uring_worker_poll), one
+ *   io_uring_enter for everything its coroutines queued meanwhile.
+ * - Completions are reaped under the ring's cq_mu by the worker between
+ *   tasks and, while it sleeps, by the reactor poller, which watches an
+ *   eventfd registered with the ring. The reaper marks the op done and
+ *   requeues its coroutine; a coroutine woken early re-parks under cq_mu.
+ * - Buffers inside a kc_region_register region go out as READ_FIXED /
+ *   WRITE_FIXED. A ring re-registers its buffer table when the region
+ *   generation moves and none of its fixed ops is in flight; until then
+ *   those ops run unfixed.
+ * - A worker with ops in flight does not retire: the kernel cancels a
+ *   thread's io_uring requests when it exits.
+ * - Shared-stack coroutines (their stack is not addressable while parked),
+ *   non-worker callers, kernels without io_uring and non-Linux builds run
+ *   the syscall directly and wait in the reactor on -EAGAIN. */
+#define _GNU_SOURCE 1
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/eventfd.h>
+#include <linux/io_uring.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter) && defined(__NR_io_uring_register)
+#define KC_HAVE_URING 1
+#endif
+#endif
+#endif
+
+#include "kcoro.h"
+#include "kcoro_core.h"
+#include "kcoro_sched.h"
+#include "kcoro_io.h"
+#include "kcoro_config.h"
+#include "kc_region_internal.h"
+#include "kc_uring_internal.h"
+#if KC_HAVE_URING
+#include "kc_reactor_internal.h"
+#endif
+
+/* Largest single transfer, as the kernel clamps read/write. */
+#define KC_IO_MAX_RW 0x7ffff000u
+
+static struct {
+    _Atomic(unsigned long) submitted, completed, enters, fixed, fallbacks;
+} g_io_stats;
+
+#if KC_HAVE_URING
+
+typedef struct kc_uring {
+    struct kc_uring *next;          /* free list (rings of exited workers) */
+    int fd, efd;
+    /* Submission side: owning worker only. */
+    unsigned *sq_head, *sq_tail, *sq_array, *sq_flags;
+    unsigned sq_mask, sq_entries;
+    struct io_uring_sqe *sqes;
+    unsigned sq_local_tail;         /* next free SQE */
+    unsigned pending;               /* filled, not yet accepted by the kernel */
+    uint64_t fixed_gen;             /* region generation of the buffer table */
+    int nfixed;
+    int fixed_idx[KCORO_REGION_MAX]; /* region slot -> buffer index, or -1 */
+    /* Completion side: under cq_mu. */
+    pthread_mutex_t cq_mu;
+    unsigned *cq_head, *cq_tail, cq_mask;
+    struct io_uring_cqe *cqes;
+    _Atomic(int) inflight, fixed_inflight;
+} kc_uring_t;
+
+typedef struct kc_uring_op {
+    kcoro_t *co;
+    kc_sched_t *sched;
+    kc_uring_t *ring;
+    kc_region_t *region;            /* READ/WRITE buffer's region, if any */
+    int region_slot;
+    uint8_t opcode;
+    int fd;
+    uint32_t len, op_flags;         /* rw/msg/accept flags, poll events */
+    uint64_t off, addr, addr2;
+    int res;
+    int done, queued, fixed;        /* done: under ring->cq_mu */
+} kc_uring_op_t;
+
+static struct {
+    pthread_mutex_t mu;
+    int state;                      /* 0 untried, 1 usable, -1 unavailable */
+    unsigned char ops[256];         /* IORING_REGISTER_PROBE result */
+    kc_uring_t *free;
+} g_uring = { .mu = PTHREAD_MUTEX_INITIALIZER };
+
+/* The ring of the calling worker. Coroutines move between workers, so the
+ * TLS access stays out of line (see kcoro_core.c). */
+static __thread kc_uring_t *tls_ring;
+__attribute__((noinline)) static kc_uring_t* tls_ring_get(void)
+{ __asm__ __volatile__("" ::: "memory"); return tls_ring; }
+__attribute__((noinline)) static void tls_ring_set(kc_uring_t *r)
+{ __asm__ __volatile__("" ::: "memory"); tls_ring = r; }
+
+/* Ring words the kernel reads or writes concurrently. */
+static inline unsigned ring_load(const unsigned *p) { return __atomic_load_n(p, __ATOMIC_ACQUIRE); }
+static inline void ring_store(unsigned *p, unsigned v) { __atomic_store_n(p, v, __ATOMIC_RELEASE); }
+
+static int sys_setup(unsigned entries, struct io_uring_params *p)
+{ return (int)syscall(__NR_io_uring_setup, entries, p); }
+static int sys_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+{ return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0); }
+static int sys_register(int fd, unsigned opcode, const void *arg, unsigned nr)
+{ return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nr); }
+
+static void ring_submit(kc_uring_t *r)
+{
+    ring_store(r->sq_tail, r->sq_local_tail);
+    while (r->pending) {
+        int n = sys_enter(r->fd, r->pending, 0, 0);
+        if (n < 0 && errno == EINTR) continue;
+        /* EAGAIN/EBUSY: the kernel is short on memory or CQ room; the worker
+         * retries on its next poll. */
+        if (n <= 0) break;
+        r->pending -= (unsigned)n;
+        atomic_fetch_add_explicit(&g_io_stats.enters, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&g_io_stats.submitted, (unsigned long)n, memory_order_relaxed);
+    }
+}
+
+static struct io_uring_sqe* ring_sqe(kc_uring_t *r)
+{
+    if (r->sq_local_tail - ring_load(r->sq_head) >= r->sq_entries) {
+        ring_submit(r);
+        if (r->sq_local_tail - ring_load(r->sq_head) >= r->sq_entries) return NULL;
+    }
+    unsigned idx = r->sq_local_tail & r->sq_mask;
+    r->sq_array[idx] = idx;
+    r->sq_local_tail++;
+    r->pending++;
+    struct io_uring_sqe *sqe = &r->sqes[idx];
+    memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+static int ring_reap(kc_uring_t *r)
+{
+    int n = 0;
+    pthread_mutex_lock(&r->cq_mu);
+    for (;;) {
+        unsigned head = *r->cq_head, tail = ring_load(r->cq_tail);
+        while (head != tail) {
+            struct io_uring_cqe *cqe = &r->cqes[head & r->cq_mask];
+            kc_uring_op_t *op = (kc_uring_op_t*)(uintptr_t)cqe->user_data;
+            head++;
+            kcoro_t *co = op->co;
+            if (op->fixed) atomic_fetch_sub_explicit(&r->fixed_inflight, 1, memory_order_relaxed);
+            atomic_fetch_sub_explicit(&r->inflight, 1, memory_order_relaxed);
+            op->res = cqe->res;
+            op->done = 1; /* op may go away once cq_mu drops */
+            kc_sched_enqueue_ready(op->sched, co);
+            kcoro_release(co);
+            n++;
+        }
+        ring_store(r->cq_head, head);
+        /* CQEs the kernel held back while the CQ was full. */
+        if (!(ring_load(r->sq_flags) & IORING_SQ_CQ_OVERFLOW)) break;
+        if (sys_enter(r->fd, 0, 0, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) break;
+    }
+    pthread_mutex_unlock(&r->cq_mu);
+    if (n) atomic_fetch_add_explicit(&g_io_stats.completed, (unsigned long)n, memory_order_relaxed);
+    return n;
+}
+
+/* Reactor watch on the ring's eventfd: completions while the worker sleeps. */
+static void ring_efd_ready(void *arg)
+{
+    kc_uring_t *r = (kc_uring_t*)arg;
+    uint64_t v;
+    while (read(r->efd, &v, sizeof v) < 0 && errno == EINTR) {}
+    ring_reap(r);
+}
+
+static void ring_sync_regions(kc_uring_t *r)
+{
+    uint64_t gen = kc_region_generation();
+    if (r->fixed_gen == gen || atomic_load_explicit(&r->fixed_inflight, memory_order_relaxed)) return;
+    if (r->nfixed) {
+        (void)sys_register(r->fd, IORING_UNREGISTER_BUFFERS, NULL, 0);
+        r->nfixed = 0;
+    }
+    for (int i = 0; i < KCORO_REGION_MAX; i++) r->fixed_idx[i] = -1;
+    struct iovec iov[KCORO_REGION_MAX];
+    int slot_of[KCORO_REGION_MAX];
+    int n = kc_region_snapshot(iov, slot_of, KCORO_REGION_MAX, &gen);
+    /* A failed registration (RLIMIT_MEMLOCK, ...) leaves the table empty
+     * until the next region change. */
+    if (n > 0 && sys_register(r->fd, IORING_REGISTER_BUFFERS, iov, (unsigned)n) == 0) {
+        r->nfixed = n;
+        for (int k = 0; k < n; k++) r->fixed_idx[slot_of[k]] = k;
+    }
+    r->fixed_gen = gen;
+}
+
+static kc_uring_t* ring_create(void)
+{
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    p.flags = IORING_SETUP_CLAMP;
+    int fd = sys_setup(KCORO_URING_ENTRIES, &p);
+    if (fd < 0) return NULL;
+    kc_uring_t *r = NULL;
+    void *sq = MAP_FAILED, *cq = MAP_FAILED, *sqes = MAP_FAILED;
+    size_t sq_sz = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    size_t cq_sz = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    size_t sqes_sz = p.sq_entries * sizeof(struct io_uring_sqe);
+    const int single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    /* Current-position reads (off = -1) and no dropped CQEs are assumed. */
+    if (!(p.features & IORING_FEAT_RW_CUR_POS) || !(p.features & IORING_FEAT_NODROP)) goto fail;
+    if (single && cq_sz > sq_sz) sq_sz = cq_sz;
+    sq = mmap(NULL, sq_sz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (sq == MAP_FAILED) goto fail;
+    cq = single ? sq : mmap(NULL, cq_sz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    if (cq == MAP_FAILED) goto fail;
+    sqes = mmap(NULL, sqes_sz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) goto fail;
+    if (!(r = (kc_uring_t*)calloc(1, sizeof(*r)))) goto fail;
+    r->fd = fd;
+    r->efd = -1;
+    r->sq_head = (unsigned*)((char*)sq + p.sq_off.head);
+    r->sq_tail = (unsigned*)((char*)sq + p.sq_off.tail);
+    r->sq_flags = (unsigned*)((char*)sq + p.sq_off.flags);
+    r->sq_array = (unsigned*)((char*)sq + p.sq_off.array);
+    r->sq_mask = *(unsigned*)((char*)sq + p.sq_off.ring_mask);
+    r->sq_entries = *(unsigned*)((char*)sq + p.sq_off.ring_entries);
+    r->sqes = (struct io_uring_sqe*)sqes;
+    r->sq_local_tail = *r->sq_tail;
+    r->cq_head = (unsigned*)((char*)cq + p.cq_off.head);
+    r->cq_tail = (unsigned*)((char*)cq + p.cq_off.tail);
+    r->cq_mask = *(unsigned*)((char*)cq + p.cq_off.ring_mask);
+    r->cqes = (struct io_uring_cqe*)((char*)cq + p.cq_off.cqes);
+    for (int i = 0; i < KCORO_REGION_MAX; i++) r->fixed_idx[i] = -1;
+    pthread_mutex_init(&r->cq_mu, NULL);
+    if ((r->efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0) goto fail;
+    if (sys_register(fd, IORING_REGISTER_EVENTFD, &r->efd, 1) != 0) goto fail;
+    if (g_uring.state == 0) {
+        size_t psz = sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op);
+        struct io_uring_probe *pr = (struct io_uring_probe*)calloc(1, psz);
+        if (!pr) goto fail;
+        if (sys_register(fd, IORING_REGISTER_PROBE, pr, 256) == 0)
+            for (unsigned i = 0; i < pr->ops_len && i < 256; i++)
+                if (pr->ops[i].flags & IO_URING_OP_SUPPORTED) g_uring.ops[pr->ops[i].op] = 1;
+        free(pr);
+    }
+    /* Last: the watch lasts for the life of the process. */
+    if (kc_reactor_watch(r->efd, ring_efd_ready, r) != 0) goto fail;
+    return r;
+fail:
+    if (r) {
+        if (r->efd >= 0) close(r->efd);
+        pthread_mutex_destroy(&r->cq_mu);
+        free(r);
+    }
+    if (sqes != MAP_FAILED) munmap(sqes, sqes_sz);
+    if (cq != MAP_FAILED && cq != sq) munmap(cq, cq_sz);
+    if (sq != MAP_FAILED) munmap(sq, sq_sz);
+    close(fd);
+    return NULL;
+}
+
+/* The calling worker's ring, attaching one on first use; NULL when the
+ * caller cannot park on a ring (see the header comment). */
+static kc_uring_t* uring_here(uint8_t opcode)
+{
+    kcoro_t *co = kcoro_current();
+    if (!co || co->share || !kc_sched_current()) return NULL;
+    kc_uring_t *r = tls_ring_get();
+    if (r) return g_uring.ops[opcode] ? r : NULL;
+    pthread_mutex_lock(&g_uring.mu);
+    if (g_uring.state >= 0) {
+        if ((r = g_uring.free) != NULL) g_uring.free = r->next;
+        else r = ring_create();
+        /* One failure means no io_uring here (ENOSYS, seccomp, old kernel). */
+        g_uring.state = r ? 1 : -1;
+    }
+    pthread_mutex_unlock(&g_uring.mu);
+    if (!r) return NULL;
+    tls_ring_set(r);
+    return g_uring.ops[opcode] ? r : NULL;
+}
+
+/* Runs on the worker after the coroutine switched out. */
+static void uring_park_submit(void *arg)
+{
+    kc_uring_op_t *op = (kc_uring_op_t*)arg;
+    kc_uring_t *r = op->ring;
+    uint8_t opcode = op->opcode;
+    uint16_t buf_index = 0;
+    if (op->region) {
+        ring_sync_regions(r);
+        int idx = r->fixed_idx[op->region_slot];
+        uint8_t fixed = opcode == IORING_OP_READ ? IORING_OP_READ_FIXED : IORING_OP_WRITE_FIXED;
+        if (idx >= 0 && g_uring.ops[fixed]) {
+            opcode = fixed;
+            buf_index = (uint16_t)idx;
+        }
+    }
+    struct io_uring_sqe *sqe = ring_sqe(r);
+    if (!sqe) {
+        /* SQ full and the kernel takes nothing: run the syscall instead. */
+        pthread_mutex_lock(&r->cq_mu);
+        op->done = 1;
+        pthread_mutex_unlock(&r->cq_mu);
+        kc_sched_enqueue_ready(op->sched, op->co);
+        kcoro_release(op->co);
+        return;
+    }
+    op->queued = 1;
+    op->fixed = opcode != op->opcode;
+    sqe->opcode = opcode;
+    sqe->fd = op->fd;
+    sqe->off = op->off;
+    sqe->addr = op->addr;
+    sqe->len = op->len;
+    sqe->rw_flags = (__kernel_rwf_t)op->op_flags;
+    sqe->buf_index = buf_index;
+    if (opcode == IORING_OP_ACCEPT) sqe->addr2 = op->addr2;
+    sqe->user_data = (uint64_t)(uintptr_t)op;
+    atomic_fetch_add_explicit(&r->inflight, 1, memory_order_relaxed);
+    if (op->fixed) {
+        atomic_fetch_add_explicit(&r->fixed_inflight, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&g_io_stats.fixed, 1, memory_order_relaxed);
+    }
+    /* Once submitted the op may complete and its stack frame go away. */
+    if (r->pending >= KCORO_URING_BATCH) ring_submit(r);
+}
+
+static void uring_park_unlock(void *arg)
+{
+    pthread_mutex_unlock((pthread_mutex_t*)arg);
+}
+
+/* Run op on the calling worker's ring. 0 with *res set, or -1 when the
+ * caller should take the syscall path. */
+static int uring_try(kc_uring_op_t *op, int *res)
+{
+    kc_uring_t *r = uring_here(op->opcode);
+    if (!r) return -1;
+    kcoro_t *co = kcoro_current();
+    op->co = co;
+    op->sched = kc_sched_current();
+    op->ring = r;
+    op->done = op->queued = op->fixed = 0;
+    kcoro_retain(co); /* the ring's hold, dropped by the reaper */
+    if (kc_sched_park_release(uring_park_submit, op) != 0) {
+        kcoro_release(co);
+        return -1;
+    }
+    pthread_mutex_lock(&r->cq_mu);
+    while (!op->done) {
+        if (kc_sched_park_release(uring_park_unlock, &r->cq_mu) != 0) break;
+        pthread_mutex_lock(&r->cq_mu);
+    }
+    pthread_mutex_unlock(&r->cq_mu);
+    if (!op->queued) return -1;
+    *res = op->res;
+    return 0;
+}
+
+static uint32_t poll_mask(short events)
+{
+    uint32_t m = (uint16_t)events;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    m = (m << 16) | (m >> 16); /* poll32_events is word-swapped on BE */
+#endif
+    return m;
+}
+
+/* op on the ring; -EAGAIN from a non-blocking fd waits in a POLL_ADD on the
+ * same ring and retries. events 0: no retry. */
+static int uring_io(const kc_uring_op_t *tmpl, short events, long *res)
+{
+    for (;;) {
+        kc_uring_op_t op = *tmpl;
+        int rc;
+        if (uring_try(&op, &rc) != 0) return -1;
+        if (rc != -EAGAIN || !events) { *res = rc; return 0; }
+        kc_uring_op_t p;
+        memset(&p, 0, sizeof(p));
+        p.opcode = IORING_OP_POLL_ADD;
+        p.fd = tmpl->fd;
+        p.op_flags = poll_mask(events);
+        if (uring_try(&p, &rc) != 0) return -1;
+        if (rc < 0) { *res = rc; return 0; }
+    }
+}
+
+static int uring_rw(uint8_t opcode, int fd, uint64_t addr, uint32_t len, off_t off, short events, long *res)
+{
+    kc_uring_op_t op;
+    memset(&op, 0, sizeof(op));
+    op.opcode = opcode;
+    op.fd = fd;
+    op.addr = addr;
+    op.len = len;
+    op.off = off < 0 ? (uint64_t)-1 : (uint64_t)off;
+    if ((opcode == IORING_OP_READ || opcode == IORING_OP_WRITE) && len && kc_region_generation() &&
+        uring_here(opcode))
+        op.region = kc_region_acquire((const void*)(uintptr_t)addr, len, &op.region_slot);
+    int rc = uring_io(&op, events, res);
+    kc_region_release(op.region);
+    return rc;
+}
+
+static int uring_op(uint8_t opcode, int fd, uint64_t addr, uint64_t addr2, uint32_t len,
+                    uint32_t flags, short events, long *res)
+{
+    kc_uring_op_t op;
+    memset(&op, 0, sizeof(op));
+    op.opcode = opcode;
+    op.fd = fd;
+    op.addr = addr;
+    op.addr2 = addr2;
+    op.off = addr2;
+    op.len = len;
+    op.op_flags = flags;
+    return uring_io(&op, events, res);
+}
+
+int kc_uring_worker_poll(int flush)
+{
+    kc_uring_t *r = tls_ring;
+    if (!r) return 0;
+    if (flush && r->pending) ring_submit(r);
+    if (ring_load(r->cq_tail) == *r->cq_head) return 0;
+    return ring_reap(r);
+}
+
+int kc_uring_worker_busy(void)
+{
+    kc_uring_t *r = tls_ring;
+    return r && (r->pending || atomic_load_explicit(&r->inflight, memory_order_relaxed) > 0);
+}
+
+void kc_uring_worker_exit(void)
+{
+    kc_uring_t *r = tls_ring;
+    if (!r) return;
+    ring_submit(r);
+    tls_ring = NULL;
+    pthread_mutex_lock(&g_uring.mu);
+    r->next = g_uring.free;
+    g_uring.free = r;
+    pthread_mutex_unlock(&g_uring.mu);
+}
+
+#else /* !KC_HAVE_URING */
+
+int kc_uring_worker_poll(int flush) { (void)flush; return 0; }
+int kc_uring_worker_busy(void) { return 0; }
+void kc_uring_worker_exit(void) {}
+
+#endif
+
+/* ---- Syscall path ---- */
+
+static void io_fallback(void)
+{
+    atomic_fetch_add_explicit(&g_io_stats.fallbacks, 1, memory_order_relaxed);
+}
+
+/* After a failed call: 0 to retry (interrupted, or fd ready again after
+ * -EAGAIN), else the negative errno to return. */
+static int io_retry(int fd, int writable)
+{
+    int err = errno;
+    if (err == EINTR) return 0;
+    if (err != EAGAIN && err != EWOULDBLOCK) return -err;
+    return writable ? kc_await_writable(fd, -1) : kc_await_readable(fd, -1);
+}
+
+/* Sockets get MSG_DONTWAIT on a worker so a blocking fd parks instead of
+ * stalling the thread. */
+static int io_msg_flags(int flags)
+{
+    return kc_sched_current() && kcoro_current() ? flags | MSG_DONTWAIT : flags;
+}
+
+ssize_t kc_io_read(int fd, void *buf, size_t len, off_t off)
+{
+    if (len > KC_IO_MAX_RW) len = KC_IO_MAX_RW;
+#if KC_HAVE_URING
+    long res;
+    if (uring_rw(IORING_OP_READ, fd, (uint64_t)(uintptr_t)buf, (uint32_t)len, off, POLLIN, &res) == 0) return res;
+#endif
+    io_fallback();
+    for (;;) {
+        ssize_t n = off < 0 ? read(fd, buf, len) : pread(fd, buf, len, off);
+        if (n >= 0) return n;
+        int rc = io_retry(fd, 0);
+        if (rc != 0) return rc;
+    }
+}
+
+ssize_t kc_io_write(int fd, const void *buf, size_t len, off_t off)
+{
+    if (len > KC_IO_MAX_RW) len = KC_IO_MAX_RW;
+#if KC_HAVE_URING
+    long res;
+    if (uring_rw(IORING_OP_WRITE, fd, (uint64_t)(uintptr_t)buf, (uint32_t)len, off, POLLOUT, &res) == 0) return res;
+#endif
+    io_fallback();
+    for (;;) {
+        ssize_t n = off < 0 ? write(fd, buf, len) : pwrite(fd, buf, len, off);
+        if (n >= 0) return n;
+        int rc = io_retry(fd, 1);
+        if (rc != 0) return rc;
+    }
+}
+
+ssize_t kc_io_readv(int fd, const struct iovec *iov, int iovcnt, off_t off)
+{
+    if (iovcnt < 0) return -EINVAL;
+#if KC_HAVE_URING
+    long res;
+    if (uring_rw(IORING_OP_READV, fd, (uint64_t)(uintptr_t)iov, (uint32_t)iovcnt, off, POLLIN, &res) == 0) return res;
+#endif
+    io_fallback();
+    for (;;) {
+        ssize_t n = off < 0 ? readv(fd, iov, iovcnt) : preadv(fd, iov, iovcnt, off);
+        if (n >= 0) return n;
+        int rc = io_retry(fd, 0);
+        if (rc != 0) return rc;
+    }
+}
+
+ssize_t kc_io_writev(int fd, const struct iovec *iov, int iovcnt, off_t off)
+{
+    if (iovcnt < 0) return -EINVAL;
+#if KC_HAVE_URING
+    long res;
+    if (uring_rw(IORING_OP_WRITEV, fd, (uint64_t)(uintptr_t)iov, (uint32_t)iovcnt, off, POLLOUT, &res) == 0) return res;
+#endif
+    io_fallback();
+    for (;;) {
+        ssize_t n = off < 0 ? writev(fd, iov, iovcnt) : pwritev(fd, iov, iovcnt, off);
+        if (n >= 0) return n;
+        int rc = io_retry(fd, 1);
+        if (rc != 0) return rc;
+    }
+}
+
+int kc_io_accept(int fd, struct sockaddr *addr, socklen_t *addrlen, int flags)
+{
+#if KC_HAVE_URING
+    long res;
+    if (uring_op(IORING_OP_ACCEPT, fd, (uint64_t)(uintptr_t)addr, (uint64_t)(uintptr_t)addrlen, 0,
+                 (uint32_t)flags, POLLIN, &res) == 0) return (int)res;
+#endif
+    io_fallback();
+    for (;;) {
+        int c = accept4(fd, addr, addrlen, flags);
+        if (c >= 0) return c;
+        int rc = io_retry(fd, 0);
+        if (rc != 0) return rc;
+    }
+}
+
+/* A non-blocking connect in progress: wait for writability, then the result. */
+static int io_connect_wait(int fd)
+{
+    int rc = kc_await_writable(fd, -1);
+    if (rc != 0) return rc;
+    int err = 0;
+    socklen_t elen = sizeof(err);
+    if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &elen) != 0) return -errno;
+    return -err;
+}
+
+int kc_io_connect(int fd, const struct sockaddr *addr, socklen_t addrlen)
+{
+#if KC_HAVE_URING
+    long res;
+    if (uring_op(IORING_OP_CONNECT, fd, (uint64_t)(uintptr_t)addr, (uint64_t)addrlen, 0, 0, 0, &res) == 0)
+        return res == -EINPROGRESS ? io_connect_wait(fd) : (int)res;
+#endif
+    io_fallback();
+    for (;;) {
+        if (connect(fd, addr, addrlen) == 0) return 0;
+        if (errno == EINTR) continue;
+        return errno == EINPROGRESS ? io_connect_wait(fd) : -errno;
+    }
+}
+
+ssize_t kc_io_recvmsg(int fd, struct msghdr *msg, int flags)
+{
+#if KC_HAVE_URING
+    long res;
+    if (uring_op(IORING_OP_RECVMSG, fd, (uint64_t)(uintptr_t)msg, 0, 1, (uint32_t)flags, POLLIN, &res) == 0)
+        return res;
+#endif
+    io_fallback();
+    flags = io_msg_flags(flags);
+    for (;;) {
+        ssize_t n = recvmsg(fd, msg, flags);
+        if (n >= 0) return n;
+        int rc = io_retry(fd, 0);
+        if (rc != 0) return rc;
+    }
+}
+
+ssize_t kc_io_sendmsg(int fd, const struct msghdr *msg, int flags)
+{
+#if KC_HAVE_URING
+    long res;
+    if (uring_op(IORING_OP_SENDMSG, fd, (uint64_t)(uintptr_t)msg, 0, 1, (uint32_t)flags, POLLOUT, &res) == 0)
+        return res;
+#endif
+    io_fallback();
+    flags = io_msg_flags(flags);
+    for (;;) {
+        ssize_t n = sendmsg(fd, msg, flags);
+        if (n >= 0) return n;
+        int rc = io_retry(fd, 1);
+        if (rc != 0) return rc;
+    }
+}
+
+void kc_io_get_stats(kc_io_stats_t *out)
+{
+    if (!out) return;
+    out->submitted = atomic_load_explicit(&g_io_stats.submitted, memory_order_relaxed);
+    out->completed = atomic_load_explicit(&g_io_stats.completed, memory_order_relaxed);
+    out->enters = atomic_load_explicit(&g_io_stats.enters, memory_order_relaxed);
+    out->fixed = atomic_load_explicit(&g_io_stats.fixed, memory_order_relaxed);
+    out->fallbacks = atomic_load_explicit(&g_io_stats.fallbacks, memory_order_relaxed);
+}
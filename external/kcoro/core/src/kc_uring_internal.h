@@ -0,0 +1,17 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+/* Scheduler hooks into the io_uring backend (kc_uring.c); the kc_io_* calls
+ * are declared in kcoro_io.h. All act on the calling worker thread's ring
+ * and are no-ops for a worker that never issued io_uring I/O. */
+
+/* Reap the ring's completions (requeueing their coroutines); with flush,
+ * first submit the SQEs its coroutines queued. Returns completions reaped. */
+int kc_uring_worker_poll(int flush);
+
+/* Nonzero while the ring has queued or in-flight ops: the worker must not
+ * exit, since the kernel cancels a thread's requests when it does. */
+int kc_uring_worker_busy(void);
+
+/* Worker thread exit: submit what is queued and pass the ring on. */
+void kc_uring_worker_exit(void);
@@ -0,0 +1,45 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include "../../include/kcoro_sched.h"
+
+/* Wake coalescing for paths that wake many coroutines at once (channel
+ * close, broadcast, cancellation): coroutines are added one at a time and
+ * handed to kc_sched_enqueue_ready_batch_lane whenever the batch fills or
+ * the target scheduler or lane changes, and once more at the end. With
+ * release set, flushing drops one reference per entry after it is queued
+ * (the waker's hold, as kc_chan_schedule_wake does). */
+#define KC_WAKE_BATCH 64
+
+struct kc_wake_batch {
+    kc_sched_t *s;
+    kc_lane_t   lane;
+    int         release;
+    size_t      n;
+    kcoro_t    *co[KC_WAKE_BATCH];
+};
+
+static inline void kc_wake_batch_init(struct kc_wake_batch *b, int release)
+{
+    b->s = NULL;
+    b->lane = KC_LANE_INHERIT;
+    b->release = release;
+    b->n = 0;
+}
+
+static inline void kc_wake_batch_flush(struct kc_wake_batch *b)
+{
+    if (!b->n) return;
+    kc_sched_enqueue_ready_batch_lane(b->s, b->co, b->n, b->lane);
+    if (b->release) for (size_t i = 0; i < b->n; i++) kcoro_release(b->co[i]);
+    b->n = 0;
+}
+
+static inline void kc_wake_batch_add(struct kc_wake_batch *b, kc_sched_t *s, kcoro_t *co, kc_lane_t lane)
+{
+    if (!co) return;
+    if (b->n && (b->n == KC_WAKE_BATCH || b->s != s || b->lane != lane)) kc_wake_batch_flush(b);
+    b->s = s;
+    b->lane = lane;
+    b->co[b->n++] = co;
+}
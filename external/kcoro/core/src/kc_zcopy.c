@@ -1,6 +1,6 @@
 // SPDX-License-Identifier: BSD-3-Clause
 /*
- * kc_zcopy.c — Unified zero‑copy backend (zref) and neutral region stubs
+ * kc_zcopy.c — Unified zero‑copy backend (zref) and the region registry
  * ----------------------------------------------------------------------
  *
  * Scope
@@ -10,8 +10,11 @@
  * - Exposes a tiny backend registry so external adapters
  *   can register their own ops in a separate library without pulling any
  *   non‑POSIX headers into kcoro.
- * - Supplies neutral region stubs; actual region registration/translation is
- *   reserved for out‑of‑tree adapters.
+ * - Keeps the process-wide region registry (kc_region_register). Regions are
+ *   bounds for zero-copy hand-offs and the fixed buffers of the io_uring
+ *   backend (kc_uring.c). Shared regions (kc_region_create_shared) are
+ *   memfd mappings another process can map too; the IPC transport passes
+ *   their descriptor and peers exchange (region_id, offset) descriptors.
  *
  * Invariants
  * - Return 0 on success; negative KC_* (mapped to -errno) on failure.
@@ -28,9 +31,24 @@
  * (ptr,len) record; payloads remain external.
  */
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE 1 /* memfd_create */
+#endif
 #include <errno.h>
 #include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
 #include <assert.h>
+#include <pthread.h>
+#include <sys/uio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
 #include "../../include/kcoro.h"
 #include "../../include/kcoro_zcopy.h"
 #include "../../include/kcoro_core.h"
@@ -38,19 +56,22 @@
 #include "../../include/kcoro_config.h"
 #include "kc_chan_internal.h"
 #include "kc_select_internal.h"
+#include "kc_region_internal.h"
 #include <stdio.h>
 #include <stdarg.h>
 
-static void kc_zref_schedule_co(kcoro_t *co)
+/* lane: the channel's wake_lane, read under its lock. */
+static void kc_zref_schedule_co(kcoro_t *co, int lane)
 {
     if (!co) return;
-    if (kcoro_is_parked(co)) {
-        kcoro_unpark(co);
-    }
     kc_sched_t *sched = kc_sched_current();
     if (!sched) {
         sched = kc_sched_default();
     }
+    if (sched && lane != KC_LANE_INHERIT) kc_sched_enqueue_ready_lane(sched, co, (kc_lane_t)lane);
+    if (kcoro_is_parked(co)) {
+        kcoro_unpark(co);
+    }
     if (sched) {
         kc_sched_enqueue_ready(sched, co);
     }
@@ -117,6 +138,7 @@ int kc_chan_enable_zero_copy_backend(kc_chan_t *c,
 {
     struct kc_chan *ch = (struct kc_chan*)c;
     if (!ch) return -EINVAL;
+    if (ch->ring) return -ENOTSUP;
     if (id < 0 || id >= g_zbackends_cnt) return -ENOENT;
     const kc_zcopy_backend_ops_t *ops = g_zbackends[id].ops;
     KC_MUTEX_LOCK(&ch->mu);
@@ -129,23 +151,704 @@ int kc_chan_enable_zero_copy_backend(kc_chan_t *c,
     return rc;
 }
 
-/* Region management stubs — placeholders for future adapters. */
-struct kc_region { int unused; };
+void *kc_chan_zcopy_priv(kc_chan_t *c)
+{
+    return c ? ((struct kc_chan*)c)->zc_priv : NULL;
+}
+
+void kc_chan_zcopy_set_priv(kc_chan_t *c, void *priv)
+{
+    if (c) ((struct kc_chan*)c)->zc_priv = priv;
+}
+
+void kc_chan_zcopy_account(kc_chan_t *c, int send, size_t len)
+{
+    struct kc_chan *ch = (struct kc_chan*)c;
+    if (!ch) return;
+    KC_MUTEX_LOCK(&ch->mu);
+    if (send) kc_chan_update_send_stats_len_locked(ch, len);
+    else kc_chan_update_recv_stats_len_locked(ch, len);
+    KC_MUTEX_UNLOCK(&ch->mu);
+}
+
+int kc_chan_zcopy_closed(kc_chan_t *c)
+{
+    struct kc_chan *ch = (struct kc_chan*)c;
+    if (!ch) return 1;
+    KC_MUTEX_LOCK(&ch->mu);
+    int closed = ch->closed;
+    KC_MUTEX_UNLOCK(&ch->mu);
+    return closed;
+}
+
+/* Region registry: at most KCORO_REGION_MAX live, non-overlapping regions in
+ * a fixed table whose entries are reused, never freed. Lookups take no lock:
+ * an ID names its slot (id % KCORO_REGION_MAX), and a reader takes a
+ * reference first, then checks the slot still carries that ID and is not
+ * dead. Writers (register, deregister, teardown) hold g_regions.mu. Every
+ * change bumps a generation so users that mirror the table (io_uring fixed
+ * buffers) know to resync.
+ *
+ * References are held by kc_region_get/kc_region_acquire callers and by zref
+ * descriptors in flight, from send until a receiver takes them. Deregister
+ * marks the region dead and waits for them to drain; kc_region_retire leaves
+ * the teardown to whoever drops the last one. */
+struct kc_region {
+    void *addr;
+    size_t len;
+    unsigned flags;  /* KC_REGION_F_* hints that took effect */
+    int slot;
+    int fd;       /* shared/imported: the mapping's descriptor, else -1 */
+    int owned;    /* teardown unmaps addr (alloc, shared, imported) */
+    int nofixed;  /* kept out of io_uring buffer tables (streamed files) */
+    int used;     /* slot taken, also while dead; under g_regions.mu */
+    int retired;  /* last release tears down; under g_regions.mu */
+    _Atomic(unsigned long) id;   /* 0 while the slot is free */
+    _Atomic(uintptr_t) lo, hi;   /* [addr, addr+len) for lock-free scans */
+    _Atomic(int) refs;           /* in-flight references */
+    _Atomic(int) dead;           /* deregistering: no new references */
+    unsigned hooked;             /* pinned: hooks that accepted it; under g_regions.mu */
+    void *hook_data[KCORO_REGION_HOOKS_MAX];
+};
+
+_Static_assert(KCORO_REGION_HOOKS_MAX > 0 && KCORO_REGION_HOOKS_MAX <= 32,
+               "KCORO_REGION_HOOKS_MAX must fit kc_region::hooked");
+
+static struct {
+    pthread_mutex_t mu;
+    pthread_cond_t cv;
+    kc_region_t slot[KCORO_REGION_MAX];
+    _Atomic(uint64_t) gen;
+    unsigned long next_seq;
+} g_regions = {
+    .mu = PTHREAD_MUTEX_INITIALIZER,
+    .cv = PTHREAD_COND_INITIALIZER,
+};
+
+static int region_add(kc_region_t **out, void *addr, size_t len, unsigned flags, int fd, int owned, int nofixed)
+{
+    if (!out || !addr || len == 0 || (uintptr_t)addr + len < (uintptr_t)addr) return -EINVAL;
+    *out = NULL;
+    uintptr_t lo = (uintptr_t)addr, hi = lo + len;
+    pthread_mutex_lock(&g_regions.mu);
+    int free_slot = -1;
+    for (int i = 0; i < KCORO_REGION_MAX; i++) {
+        kc_region_t *r = &g_regions.slot[i];
+        if (!r->used) { if (free_slot < 0) free_slot = i; continue; }
+        uintptr_t rlo = (uintptr_t)r->addr, rhi = rlo + r->len;
+        if (lo < rhi && rlo < hi) { pthread_mutex_unlock(&g_regions.mu); return -EEXIST; }
+    }
+    if (free_slot < 0) { pthread_mutex_unlock(&g_regions.mu); return -ENOSPC; }
+    kc_region_t *reg = &g_regions.slot[free_slot];
+    reg->addr = addr;
+    reg->len = len;
+    reg->flags = flags;
+    reg->fd = fd;
+    reg->owned = owned;
+    reg->nofixed = nofixed;
+    reg->slot = free_slot;
+    reg->used = 1;
+    reg->retired = 0;
+    reg->hooked = 0;
+    atomic_store_explicit(&reg->lo, lo, memory_order_relaxed);
+    atomic_store_explicit(&reg->hi, hi, memory_order_relaxed);
+    atomic_store(&reg->dead, 0);
+    /* IDs are never reused; the sequence part keeps stale ones from matching. */
+    atomic_store(&reg->id, ++g_regions.next_seq * KCORO_REGION_MAX + (unsigned long)free_slot);
+    atomic_fetch_add(&g_regions.gen, 1);
+    pthread_mutex_unlock(&g_regions.mu);
+    *out = reg;
+    return 0;
+}
+
+/* Free the slot of a dead region nobody references. Called with
+ * g_regions.mu held; the caller passes the results (*len 0 unless the region
+ * owns its mapping) to region_unmap once the lock is dropped. */
+static void region_free_locked(kc_region_t *reg, void **addr, size_t *len, int *fd)
+{
+    *addr = reg->addr;
+    *len = reg->owned ? reg->len : 0;
+    *fd = reg->fd;
+    atomic_store(&reg->id, 0);
+    atomic_store_explicit(&reg->lo, 0, memory_order_relaxed);
+    atomic_store_explicit(&reg->hi, 0, memory_order_relaxed);
+    reg->used = 0;
+    reg->retired = 0;
+    atomic_fetch_add(&g_regions.gen, 1);
+}
+
+static void region_unmap(void *addr, size_t len, int fd)
+{
+    if (len) munmap(addr, len);
+    if (fd >= 0) close(fd);
+}
+
+/* Drop one reference. The last one on a dead region wakes deregister, or
+ * tears a retired region down. */
+static void region_teardown(kc_region_t *reg);
+
+static void region_unref(kc_region_t *reg)
+{
+    if (atomic_fetch_sub(&reg->refs, 1) != 1 || !atomic_load(&reg->dead)) return;
+    int last = 0;
+    pthread_mutex_lock(&g_regions.mu);
+    if (reg->used && reg->retired && atomic_load(&reg->refs) == 0) {
+        reg->retired = 0; /* ours to tear down */
+        last = 1;
+    } else {
+        pthread_cond_broadcast(&g_regions.cv);
+    }
+    pthread_mutex_unlock(&g_regions.mu);
+    if (last) region_teardown(reg);
+}
+
+/* Take a reference on reg if it still is the live region id. A deregister
+ * that marks it dead either sees this reference or is seen here. */
+static int region_ref(kc_region_t *reg, unsigned long id)
+{
+    atomic_fetch_add(&reg->refs, 1);
+    if (!atomic_load(&reg->dead) && atomic_load(&reg->id) == id) return 1;
+    region_unref(reg);
+    return 0;
+}
+
+/* ---- Registration hooks ---- */
+
+/* Installed hook sets, copied by value. Pinned regions are offered to each
+ * and remember the ones that took them in hooked, so teardown reports back
+ * to exactly those. Hooks run with neither this lock nor g_regions.mu held. */
+struct region_hook {
+    int used;
+    kc_region_hooks_t ops;
+    void *arg;
+};
+
+static struct {
+    pthread_mutex_t mu;
+    struct region_hook h[KCORO_REGION_HOOKS_MAX];
+} g_region_hooks = { .mu = PTHREAD_MUTEX_INITIALIZER };
+
+static void region_hooks_copy(struct region_hook *out)
+{
+    pthread_mutex_lock(&g_region_hooks.mu);
+    memcpy(out, g_region_hooks.h, sizeof(g_region_hooks.h));
+    pthread_mutex_unlock(&g_region_hooks.mu);
+}
+
+int kc_region_hooks_add(const kc_region_hooks_t *hooks, void *arg)
+{
+    if (!hooks || (!hooks->on_register && !hooks->on_deregister)) return -EINVAL;
+    int id = -ENOSPC;
+    pthread_mutex_lock(&g_region_hooks.mu);
+    for (int i = 0; i < KCORO_REGION_HOOKS_MAX; i++) {
+        struct region_hook *h = &g_region_hooks.h[i];
+        if (h->used) continue;
+        h->used = 1;
+        h->ops = *hooks;
+        h->arg = arg;
+        id = i;
+        break;
+    }
+    pthread_mutex_unlock(&g_region_hooks.mu);
+    return id;
+}
+
+int kc_region_hooks_remove(int id)
+{
+    if (id < 0 || id >= KCORO_REGION_HOOKS_MAX) return -ENOENT;
+    pthread_mutex_lock(&g_region_hooks.mu);
+    int was = g_region_hooks.h[id].used;
+    memset(&g_region_hooks.h[id], 0, sizeof(g_region_hooks.h[id]));
+    pthread_mutex_unlock(&g_region_hooks.mu);
+    if (!was) return -ENOENT;
+    /* A later hook in this slot must not hear about these regions */
+    pthread_mutex_lock(&g_regions.mu);
+    for (int i = 0; i < KCORO_REGION_MAX; i++) g_regions.slot[i].hooked &= ~(1u << id);
+    pthread_mutex_unlock(&g_regions.mu);
+    return 0;
+}
+
+void *kc_region_hook_data(const kc_region_t *reg, int id)
+{
+    if (!reg || id < 0 || id >= KCORO_REGION_HOOKS_MAX || !(reg->hooked & (1u << id))) return NULL;
+    return reg->hook_data[id];
+}
+
+/* Offer a new pinned region to every hook set; stops at the first refusal,
+ * with the ones that accepted recorded for the teardown. */
+static int region_hooks_offer(kc_region_t *reg)
+{
+    struct region_hook h[KCORO_REGION_HOOKS_MAX];
+    region_hooks_copy(h);
+    for (int i = 0; i < KCORO_REGION_HOOKS_MAX; i++) {
+        if (!h[i].used || !h[i].ops.on_register) continue;
+        void *data = NULL;
+        int rc = h[i].ops.on_register(h[i].arg, reg, &data);
+        if (rc != 0) return rc;
+        pthread_mutex_lock(&g_regions.mu);
+        reg->hook_data[i] = data;
+        reg->hooked |= 1u << i;
+        pthread_mutex_unlock(&g_regions.mu);
+    }
+    return 0;
+}
+
+/* Report a drained region to the hooks that accepted it, in reverse. */
+static void region_hooks_drop(kc_region_t *reg)
+{
+    pthread_mutex_lock(&g_regions.mu);
+    unsigned hooked = reg->hooked;
+    reg->hooked = 0;
+    pthread_mutex_unlock(&g_regions.mu);
+    if (!hooked) return;
+    struct region_hook h[KCORO_REGION_HOOKS_MAX];
+    region_hooks_copy(h);
+    for (int i = KCORO_REGION_HOOKS_MAX - 1; i >= 0; i--)
+        if ((hooked & (1u << i)) && h[i].used && h[i].ops.on_deregister)
+            h[i].ops.on_deregister(h[i].arg, reg, reg->hook_data[i]);
+}
+
+/* Tear down a dead region nobody references, which the caller claimed under
+ * g_regions.mu (deregister, or the last reference of a retired one): the
+ * hooks first, then the slot, then the memory. The slot stays used until
+ * region_free_locked, so it cannot be reused meanwhile. */
+static void region_teardown(kc_region_t *reg)
+{
+    int pinned = (reg->flags & KC_REGION_F_PINNED) != 0;
+    if (pinned) region_hooks_drop(reg);
+    void *addr = NULL; size_t len = 0; int fd = -1;
+    size_t span = reg->len;
+    int unlock = pinned && !reg->owned;
+    pthread_mutex_lock(&g_regions.mu);
+    region_free_locked(reg, &addr, &len, &fd);
+    pthread_mutex_unlock(&g_regions.mu);
+    /* Unmapping drops the lock of owned memory; caller memory stays mapped */
+    if (unlock) munlock(addr, span);
+    region_unmap(addr, len, fd);
+}
+
+/* region_add for the registering calls. KC_REGION_F_PINNED in want locks
+ * the range first and offers the region to the hooks once it is in the
+ * table; a refusal undoes the registration but leaves the mapping and fd to
+ * the caller's own error path. */
+static int region_publish(kc_region_t **out, void *addr, size_t len, unsigned want,
+                          unsigned got, int fd, int owned)
+{
+    if (want & KC_REGION_F_PINNED) {
+        if (!addr || !len) return -EINVAL;
+        if (mlock(addr, len) != 0) return -errno;
+        got |= KC_REGION_F_PINNED;
+    }
+    int rc = region_add(out, addr, len, got, fd, owned, 0);
+    if (rc != 0) {
+        if (got & KC_REGION_F_PINNED) munlock(addr, len);
+        return rc;
+    }
+    if (!(got & KC_REGION_F_PINNED) || (rc = region_hooks_offer(*out)) == 0) return 0;
+    kc_region_t *reg = *out;
+    *out = NULL;
+    reg->owned = 0;
+    reg->fd = -1;
+    (void)kc_region_deregister(reg);
+    return rc;
+}
+
+/* ---- Placement hints ---- */
+
+#ifndef MAP_HUGETLB
+#define MAP_HUGETLB 0
+#endif
+#ifndef MFD_HUGETLB
+#define MFD_HUGETLB 0
+#endif
+#define REGION_MPOL_PREFERRED 1        /* MPOL_PREFERRED (numaif.h) */
+#define REGION_MPOL_MF_MOVE   (1 << 1) /* MPOL_MF_MOVE */
+#define REGION_F_KNOWN (KC_REGION_F_HUGEPAGE | KC_REGION_F_NUMA_SET | KC_REGION_F_NUMA(0xff) | \
+                        KC_REGION_F_PINNED)
+
+static size_t huge_round(size_t len)
+{
+    const size_t h = KCORO_HUGEPAGE_SIZE;
+    return len > SIZE_MAX - h ? 0 : (len + h - 1) & ~(h - 1);
+}
+
+unsigned kc_mem_hint(void *addr, size_t len, unsigned flags, int move)
+{
+    unsigned got = 0;
+#ifdef __linux__
+    long sps = sysconf(_SC_PAGESIZE);
+    uintptr_t ps = sps > 0 ? (uintptr_t)sps : 4096;
+    uintptr_t lo = ((uintptr_t)addr + ps - 1) & ~(ps - 1);
+    uintptr_t hi = ((uintptr_t)addr + len) & ~(ps - 1);
+    if (hi <= lo) return 0;
+#ifdef MADV_HUGEPAGE
+    if ((flags & KC_REGION_F_HUGEPAGE) && madvise((void*)lo, hi - lo, MADV_HUGEPAGE) == 0)
+        got |= KC_REGION_F_HUGEPAGE;
+#endif
+    if (flags & KC_REGION_F_NUMA_SET) {
+        /* Preferred, not bound: a full node spills instead of failing faults. */
+        enum { BITS = 8 * sizeof(unsigned long) };
+        unsigned long mask[256 / BITS] = { 0 };
+        unsigned node = KC_REGION_F_NUMA_NODE(flags);
+        mask[node / BITS] = 1ul << (node % BITS);
+        if (syscall(SYS_mbind, (void*)lo, (unsigned long)(hi - lo), REGION_MPOL_PREFERRED, mask,
+                    (unsigned long)(256 + 1), move ? REGION_MPOL_MF_MOVE : 0) == 0)
+            got |= KC_REGION_F_NUMA(node);
+    }
+#else
+    (void)addr; (void)len; (void)flags; (void)move;
+#endif
+    return got;
+}
+
+/* len bytes of private anonymous memory starting on a huge page boundary,
+ * so transparent huge pages can back all of it. */
+static void *map_huge_aligned(size_t len)
+{
+    const size_t h = KCORO_HUGEPAGE_SIZE;
+    if (len > SIZE_MAX - h) return MAP_FAILED;
+    unsigned char *raw = (unsigned char*)mmap(NULL, len + h, PROT_READ | PROT_WRITE,
+                                              MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) return MAP_FAILED;
+    unsigned char *p = (unsigned char*)(((uintptr_t)raw + h - 1) & ~(uintptr_t)(h - 1));
+    if (p > raw) munmap(raw, (size_t)(p - raw));
+    if (raw + len + h > p + len) munmap(p + len, (size_t)(raw + len + h - (p + len)));
+    return p;
+}
 
 int kc_region_register(kc_region_t **out, void *addr, size_t len, unsigned flags) {
-    (void)addr; (void)len; (void)flags;
-    if (out) *out = NULL;
-    return -ENOTSUP;
+    if (flags & ~REGION_F_KNOWN) return -EINVAL;
+    if (flags & KC_REGION_F_PINNED) {
+        long ps = sysconf(_SC_PAGESIZE);
+        uintptr_t mask = (uintptr_t)(ps > 0 ? ps : 4096) - 1;
+        if (!out || (((uintptr_t)addr | (uintptr_t)len) & mask)) return -EINVAL;
+    }
+    unsigned got = flags && addr && len ? kc_mem_hint(addr, len, flags, 1) : 0;
+    return region_publish(out, addr, len, flags, got, -1, 0);
 }
+
+int kc_region_alloc(kc_region_t **out, size_t len, unsigned flags)
+{
+    if (!out || len == 0 || (flags & ~REGION_F_KNOWN)) return -EINVAL;
+    void *addr = MAP_FAILED;
+    unsigned got = 0;
+    if (flags & KC_REGION_F_HUGEPAGE) {
+        if (!(len = huge_round(len))) return -EINVAL;
+        if (MAP_HUGETLB) {
+            addr = mmap(NULL, len, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (addr != MAP_FAILED) got = KC_REGION_F_HUGEPAGE;
+        }
+        /* No reserved huge pages: transparent ones, if the kernel allows. */
+        if (addr == MAP_FAILED) addr = map_huge_aligned(len);
+    } else {
+        addr = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    }
+    if (addr == MAP_FAILED) return -errno;
+    got |= kc_mem_hint(addr, len, got ? flags & ~KC_REGION_F_HUGEPAGE : flags, 0);
+    int rc = region_publish(out, addr, len, flags, got, -1, 1);
+    if (rc != 0) munmap(addr, len);
+    return rc;
+}
+
+static int region_fd_open(void)
+{
+#ifdef __linux__
+    int fd = memfd_create("kcoro-region", MFD_CLOEXEC);
+    return fd < 0 ? -errno : fd;
+#else
+    char name[64];
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    snprintf(name, sizeof(name), "/kcoro-region-%ld-%ld", (long)getpid(), (long)ts.tv_nsec);
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) return -errno;
+    (void)shm_unlink(name);
+    (void)fcntl(fd, F_SETFD, FD_CLOEXEC);
+    return fd;
+#endif
+}
+
+/* Map fd, apply the placement hints and register the mapping; the region
+ * takes fd on success. */
+static int region_map(kc_region_t **out, int fd, size_t len, unsigned flags, unsigned got)
+{
+    void *addr = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) return -errno;
+    got |= kc_mem_hint(addr, len, flags & ~got, 0);
+    int rc = region_publish(out, addr, len, flags, got, fd, 1);
+    if (rc != 0) munmap(addr, len);
+    return rc;
+}
+
+/* fd's huge page size when it lives on hugetlbfs (memfd_create with
+ * MFD_HUGETLB), else 0. Such files only map in whole huge pages. */
+static size_t region_fd_huge(int fd)
+{
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_blksize < KCORO_HUGEPAGE_SIZE) return 0;
+    return (size_t)st.st_blksize;
+}
+
+int kc_region_create_shared_ex(kc_region_t **out, size_t len, unsigned flags)
+{
+    if (!out || len == 0 || (flags & ~REGION_F_KNOWN)) return -EINVAL;
+    int fd, rc;
+    if (flags & KC_REGION_F_HUGEPAGE) {
+        /* Rounded for either kind of huge page, so a peer's mapping is too. */
+        if (!(len = huge_round(len))) return -EINVAL;
+#ifdef __linux__
+        if (MFD_HUGETLB && (fd = memfd_create("kcoro-region", MFD_CLOEXEC | MFD_HUGETLB)) >= 0) {
+            size_t hp = region_fd_huge(fd);
+            /* The mmap fails when too few huge pages are reserved. */
+            rc = !hp || len % hp || ftruncate(fd, (off_t)len) != 0
+                     ? -EINVAL : region_map(out, fd, len, flags, KC_REGION_F_HUGEPAGE);
+            if (rc == 0) return 0;
+            close(fd);
+        }
+#endif
+    }
+    if ((fd = region_fd_open()) < 0) return fd;
+    rc = ftruncate(fd, (off_t)len) != 0 ? -errno : region_map(out, fd, len, flags, 0);
+    if (rc != 0) close(fd);
+    return rc;
+}
+
+int kc_region_create_shared(kc_region_t **out, size_t len)
+{
+    return kc_region_create_shared_ex(out, len, KC_REGION_F_NONE);
+}
+
+int kc_region_adopt_file(kc_region_t **out, void *addr, size_t len, int fd)
+{
+    if (!out || fd < 0) return -EINVAL;
+    return region_add(out, addr, len, KC_REGION_F_NONE, fd, 1, 1);
+}
+
+int kc_region_import(kc_region_t **out, int fd, size_t len)
+{
+    if (!out || fd < 0 || len == 0) return -EINVAL;
+    struct stat st;
+    if (fstat(fd, &st) != 0) return -errno;
+    if ((uint64_t)st.st_size < (uint64_t)len) return -EINVAL; /* would fault past EOF */
+    size_t hp = region_fd_huge(fd);
+    if (hp && len % hp) return -EINVAL;
+    return region_map(out, fd, len, KC_REGION_F_NONE, hp ? KC_REGION_F_HUGEPAGE : 0);
+}
+
+/* Mark reg dead under g_regions.mu; -ENOENT unless it is a live region. */
+static int region_kill_locked(kc_region_t *reg)
+{
+    if (reg < g_regions.slot || reg >= g_regions.slot + KCORO_REGION_MAX ||
+        !reg->used || atomic_load(&reg->dead))
+        return -ENOENT;
+    atomic_store(&reg->dead, 1);
+    return 0;
+}
+
 int kc_region_deregister(kc_region_t *reg) {
-    (void)reg; return -ENOTSUP;
+    if (!reg) return -EINVAL;
+    pthread_mutex_lock(&g_regions.mu);
+    int rc = region_kill_locked(reg);
+    if (rc == 0)
+        while (atomic_load(&reg->refs) > 0) pthread_cond_wait(&g_regions.cv, &g_regions.mu);
+    pthread_mutex_unlock(&g_regions.mu);
+    if (rc == 0) region_teardown(reg);
+    return rc;
+}
+
+int kc_region_retire(kc_region_t *reg)
+{
+    if (!reg) return -EINVAL;
+    int last = 0;
+    pthread_mutex_lock(&g_regions.mu);
+    int rc = region_kill_locked(reg);
+    if (rc == 0) {
+        last = atomic_load(&reg->refs) == 0;
+        reg->retired = !last; /* else the last reference tears it down */
+    }
+    pthread_mutex_unlock(&g_regions.mu);
+    if (last) region_teardown(reg);
+    return rc;
 }
+
 int kc_region_export_id(const kc_region_t *reg, unsigned long *out_id) {
-    (void)reg; if (out_id) *out_id = 0; return -ENOTSUP;
+    if (!reg || !out_id) return -EINVAL;
+    *out_id = atomic_load(&((kc_region_t*)reg)->id);
+    return 0;
+}
+
+int kc_region_fd(const kc_region_t *reg)
+{
+    if (!reg) return -EINVAL;
+    return reg->fd >= 0 ? reg->fd : -ENOTSUP;
+}
+
+unsigned kc_region_flags(const kc_region_t *reg)
+{
+    return reg ? reg->flags : 0;
+}
+
+void *kc_region_addr(const kc_region_t *reg, size_t *len)
+{
+    if (!reg) return NULL;
+    if (len) *len = reg->len;
+    return reg->addr;
+}
+
+kc_region_t *kc_region_get(unsigned long id)
+{
+    if (!id) return NULL;
+    kc_region_t *r = &g_regions.slot[id % KCORO_REGION_MAX];
+    if (atomic_load(&r->id) != id) return NULL;
+    return region_ref(r, id) ? r : NULL;
+}
+
+void kc_region_put(kc_region_t *reg)
+{
+    kc_region_release(reg);
+}
+
+uint64_t kc_region_generation(void)
+{
+    return atomic_load_explicit(&g_regions.gen, memory_order_acquire);
+}
+
+int kc_region_snapshot(struct iovec *iov, int *slot_of, int max, uint64_t *gen)
+{
+    int n = 0;
+    pthread_mutex_lock(&g_regions.mu);
+    for (int i = 0; i < KCORO_REGION_MAX && n < max; i++) {
+        kc_region_t *r = &g_regions.slot[i];
+        if (!r->used || r->nofixed || atomic_load(&r->dead)) continue;
+        iov[n].iov_base = r->addr;
+        iov[n].iov_len = r->len;
+        slot_of[n] = i;
+        n++;
+    }
+    if (gen) *gen = atomic_load(&g_regions.gen);
+    pthread_mutex_unlock(&g_regions.mu);
+    return n;
+}
+
+/* The region whose range holds [lo, hi), dead or alive; NULL for none.
+ * Only stable while the caller holds a reference on it. */
+static kc_region_t *region_find(uintptr_t lo, uintptr_t hi, unsigned long *id)
+{
+    for (int i = 0; i < KCORO_REGION_MAX; i++) {
+        kc_region_t *r = &g_regions.slot[i];
+        unsigned long rid = atomic_load(&r->id);
+        if (!rid) continue;
+        if (lo < atomic_load_explicit(&r->lo, memory_order_relaxed) ||
+            hi > atomic_load_explicit(&r->hi, memory_order_relaxed))
+            continue;
+        *id = rid;
+        return r;
+    }
+    return NULL;
+}
+
+kc_region_t* kc_region_acquire(const void *addr, size_t len, int *slot)
+{
+    uintptr_t lo = (uintptr_t)addr, hi = lo + len;
+    if (!addr || hi < lo) return NULL;
+    if (atomic_load_explicit(&g_regions.gen, memory_order_relaxed) == 0) return NULL; /* none ever */
+    unsigned long id = 0;
+    kc_region_t *hit = region_find(lo, hi, &id);
+    if (!hit || !region_ref(hit, id)) return NULL;
+    /* Held: the range read without the lock cannot have changed under us. */
+    if (lo < (uintptr_t)hit->addr || hi > (uintptr_t)hit->addr + hit->len) {
+        region_unref(hit);
+        return NULL;
+    }
+    if (slot) *slot = hit->slot;
+    return hit;
+}
+
+void kc_region_release(kc_region_t *reg)
+{
+    if (reg) region_unref(reg);
 }
 
 /* ================= Zero‑Copy Backend (zref unified) ====================== */
 
+/* A zref payload inside a registered region holds a reference on it from
+ * send until a receiver takes it, so the region outlives the descriptor.
+ * A descriptor in flight (queued, or published for a rendezvous) is stored
+ * as a struct kc_chan_ptrmsg whose len carries ZREF_HELD and ZREF_IOV
+ * (kc_chan_internal.h); for a kc_ziov_t each segment holds its own. */
+
+/* kc_ziov_t segment i's [lo, hi). */
+static void ziov_range(const kc_ziov_t *v, uint32_t i, uintptr_t *lo, uintptr_t *hi)
+{
+    const kc_zseg_t *sg = kc_ziov_seg(v, i);
+    *lo = (uintptr_t)sg->addr;
+    *hi = *lo + sg->len;
+}
+
+/* Drop the references an in-flight descriptor held; clears ZREF_HELD. */
+static void zref_unhold(struct kc_chan_ptrmsg *m)
+{
+    if (!(m->len & ZREF_HELD)) return;
+    m->len &= ~ZREF_HELD;
+    unsigned long id = 0;
+    if (m->len & ZREF_IOV) {
+        kc_ziov_t *v = (kc_ziov_t*)m->ptr;
+        uint64_t held = v->held;
+        v->held = 0;
+        for (uint32_t i = 0; held; i++, held >>= 1) {
+            if (!(held & 1)) continue;
+            uintptr_t lo, hi;
+            ziov_range(v, i, &lo, &hi);
+            kc_region_release(region_find(lo, hi, &id));
+        }
+        return;
+    }
+    uintptr_t lo = (uintptr_t)m->ptr;
+    kc_region_release(region_find(lo, lo + (m->len & ZREF_LEN_MASK), &id));
+}
+
+/* Whether a send descriptor names a payload zref can carry. */
+static int zref_valid(const kc_zdesc_t *d)
+{
+    if (d->flags & KC_ZDESC_F_IOV) {
+        size_t total = kc_ziov_len((const kc_ziov_t*)d->addr);
+        return total != 0 && !(total & ~ZREF_LEN_MASK);
+    }
+    return d->addr && d->len != 0 && !(d->len & ~ZREF_LEN_MASK);
+}
+
+/* The element a send stores for d, taking the region references its
+ * payload holds until received; zref_unhold gives them back. */
+static int zref_stage(const kc_zdesc_t *d, struct kc_chan_ptrmsg *m)
+{
+    if (!zref_valid(d)) return -EINVAL;
+    if (d->flags & KC_ZDESC_F_IOV) {
+        kc_ziov_t *v = (kc_ziov_t*)d->addr;
+        v->held = 0;
+        for (uint32_t i = 0; i < v->nseg; i++) {
+            const kc_zseg_t *sg = kc_ziov_seg(v, i);
+            if (kc_region_acquire(sg->addr, sg->len, NULL)) v->held |= (uint64_t)1 << i;
+        }
+        m->ptr = v;
+        m->len = kc_ziov_len(v) | ZREF_IOV | (v->held ? ZREF_HELD : 0);
+        return 0;
+    }
+    m->ptr = d->addr;
+    m->len = d->len | (kc_region_acquire(d->addr, d->len, NULL) ? ZREF_HELD : 0);
+    return 0;
+}
+
+/* A received element into *d, giving back its references. */
+static void zref_deliver(struct kc_chan_ptrmsg *m, kc_zdesc_t *d)
+{
+    zref_unhold(m);
+    d->addr = m->ptr;
+    d->len = m->len & ZREF_LEN_MASK;
+    if (m->len & ZREF_IOV) d->flags |= KC_ZDESC_F_IOV;
+    else d->flags &= ~KC_ZDESC_F_IOV;
+}
+
 /* ==================== zref rendezvous backend (moved) ==================== */
 
 /* No compile-time debug macros; use explicit logging in rare cases. */
@@ -153,15 +856,12 @@ int kc_region_export_id(const kc_region_t *reg, unsigned long *out_id) {
 /** Pop first parked SEND waiter (zref). */
 static struct kc_waiter* zref_pop_first_sender(struct kc_waiter **head, struct kc_waiter **tail)
 {
-    struct kc_waiter *prev = NULL, *cur = *head;
-    while (cur) {
+    (void)tail;
+    for (struct kc_waiter *cur = *head; cur; cur = cur->next) {
         if (cur->is_zref && cur->clause_kind == KC_SELECT_CLAUSE_SEND) {
-            if (prev) prev->next = cur->next; else *head = cur->next;
-            if (*tail == cur) *tail = prev;
-            cur->next = NULL;
+            kc_waiter_unlink(cur);
             return cur;
         }
-        prev = cur; cur = cur->next;
     }
     return NULL;
 }
@@ -169,15 +869,12 @@ static struct kc_waiter* zref_pop_first_sender(struct kc_waiter **head, struct k
 /** Pop first parked RECV waiter (zref). */
 static struct kc_waiter* zref_pop_first_recv(struct kc_waiter **head, struct kc_waiter **tail)
 {
-    struct kc_waiter *prev = NULL, *cur = *head;
-    while (cur) {
+    (void)tail;
+    for (struct kc_waiter *cur = *head; cur; cur = cur->next) {
         if (cur->is_zref && cur->clause_kind == KC_SELECT_CLAUSE_RECV) {
-            if (prev) prev->next = cur->next; else *head = cur->next;
-            if (*tail == cur) *tail = prev;
-            cur->next = NULL;
+            kc_waiter_unlink(cur);
             return cur;
         }
-        prev = cur; cur = cur->next;
     }
     return NULL;
 }
@@ -231,52 +928,30 @@ static int zref_wait_recv(struct kc_chan *ch, long timeout_ms, long *deadline_ns
     return 1;
 }
 
-static int zref_send(kc_chan_t *c, const kc_zdesc_t *d, long timeout_ms)
+/* m: the zref_stage'd element, whose references the channel takes on success. */
+static int zref_send_msg(kc_chan_t *c, const struct kc_chan_ptrmsg *m, long timeout_ms)
 {
     struct kc_chan *ch = (struct kc_chan*)c;
-    if (!ch || !d || !d->addr || d->len == 0) return -EINVAL;
-    /* Non-rendezvous: queued descriptor path (former ptr backend) */
-    if (ch->kind != KC_RENDEZVOUS) {
+    size_t len = m->len & ZREF_LEN_MASK;
+    /* Buffered/unlimited: the descriptor goes into the ring like an element */
+    if (ch->kind == KC_BUFFERED || ch->kind == KC_UNLIMITED) {
+        assert(kcoro_current() != NULL);
+        size_t done = 0;
+        return kc_chan_put_run(ch, m, 1, timeout_ms, &done);
+    }
+    if (ch->kind == KC_CONFLATED) {
+        /* Keep only the latest; the value it replaces gives its reference back */
         assert(kcoro_current() != NULL);
-        long deadline_ns = 0; int timed = (timeout_ms > 0);
-        if (timed) deadline_ns = kc_now_ns() + timeout_ms * 1000000L;
-    again_qsend:
         KC_MUTEX_LOCK(&ch->mu);
         if (ch->closed) { ch->send_epipe++; KC_MUTEX_UNLOCK(&ch->mu); return KC_EPIPE; }
-        /* Conflated: keep only latest */
-        if (ch->kind == KC_CONFLATED) {
-            struct kc_chan_ptrmsg msg = { .ptr=(void*)d->addr, .len=d->len };
-            memcpy(ch->slot, &msg, sizeof(msg)); ch->has_value=1;
-            kc_chan_update_send_stats_len_locked(ch, d->len);
-            KC_COND_SIGNAL(&ch->cv_recv);
-            KC_MUTEX_UNLOCK(&ch->mu); return 0;
-        }
-        if (timeout_ms == 0) {
-            if (ch->count == ch->capacity && ch->kind != KC_UNLIMITED) { ch->send_eagain++; KC_MUTEX_UNLOCK(&ch->mu); return KC_EAGAIN; }
-        } else if (timeout_ms < 0) {
-            if (ch->count == ch->capacity && ch->kind != KC_UNLIMITED) { KC_MUTEX_UNLOCK(&ch->mu); kcoro_yield(); goto again_qsend; }
-        } else {
-            if (ch->count == ch->capacity && ch->kind != KC_UNLIMITED) { KC_MUTEX_UNLOCK(&ch->mu); if (kc_now_ns() >= deadline_ns) { ch->send_etime++; return KC_ETIME; } kcoro_yield(); goto again_qsend; }
-        }
-        if (ch->count == ch->capacity && ch->kind == KC_UNLIMITED) {
-            size_t newcap = ch->capacity ? ch->capacity * 2 : KCORO_UNLIMITED_INIT_CAP;
-            unsigned char *nbuf = malloc(newcap * ch->elem_sz);
-            if (!nbuf) { KC_MUTEX_UNLOCK(&ch->mu); return -ENOMEM; }
-            size_t old_cap = ch->capacity; size_t old_mask = ch->mask;
-            for (size_t i = 0; i < ch->count; ++i) {
-                size_t idx = old_mask ? ((ch->head + i) & old_mask) : ((ch->head + i) % old_cap);
-                memcpy(nbuf + (i * ch->elem_sz), ch->buf + (idx * ch->elem_sz), ch->elem_sz);
-            }
-            free(ch->buf); ch->buf = nbuf; ch->capacity = newcap; ch->mask = newcap - 1; ch->head = 0; ch->tail = ch->count;
-        }
-        size_t t = kc_ring_idx(ch, ch->tail);
-        struct kc_chan_ptrmsg msg = { .ptr=(void*)d->addr, .len=d->len };
-        memcpy(ch->buf + (t * ch->elem_sz), &msg, sizeof(msg));
-        size_t next = ch->tail + 1; ch->tail = ch->mask ? (next & ch->mask) : (next % ch->capacity);
-        ch->count++;
-        kc_chan_update_send_stats_len_locked(ch, d->len);
+        struct kc_chan_ptrmsg old = { 0 };
+        if (ch->has_value) memcpy(&old, ch->slot, sizeof(old));
+        memcpy(ch->slot, m, sizeof(*m)); ch->has_value=1;
+        if (m->len & ZREF_HELD) ch->zref_mode = 1;
+        kc_chan_update_send_stats_len_locked(ch, len);
         KC_COND_SIGNAL(&ch->cv_recv);
         KC_MUTEX_UNLOCK(&ch->mu);
+        zref_unhold(&old);
         return 0;
     }
     assert(kcoro_current() != NULL);
@@ -295,8 +970,8 @@ again:
     }
     if (ch->wq_recv_head == NULL) {
         if (timeout_ms < 0) {
-            ch->zref_ptr = (void*)d->addr; ch->zref_len = d->len; ch->zref_ready = 1; ch->zref_epoch++; ch->zref_sent++;
-            kc_chan_update_send_stats_len_locked(ch, d->len);
+            ch->zref_ptr = m->ptr; ch->zref_len = m->len; ch->zref_ready = 1; ch->zref_epoch++; ch->zref_sent++;
+            kc_chan_update_send_stats_len_locked(ch, len);
             struct kc_waiter *w = kc_waiter_new_coro(KC_SELECT_CLAUSE_SEND);
             if (!w) { ch->zref_ready=0; ch->zref_ptr=NULL; ch->zref_len=0; KC_MUTEX_UNLOCK(&ch->mu); return -ENOMEM; }
             w->is_zref=1; kc_waiter_append(&ch->wq_send_head, &ch->wq_send_tail, w);
@@ -306,8 +981,8 @@ again:
             ch->zref_sender_waiter_expected = 0; zref_assert_invariants(ch); KC_MUTEX_UNLOCK(&ch->mu); return ret;
         } else { int r = zref_wait_send(ch, timeout_ms, &deadline_ns); if (r==1) goto again; else return r; }
     }
-    ch->zref_ptr = (void*)d->addr; ch->zref_len = d->len; ch->zref_ready = 1; ch->zref_epoch++; ch->zref_sent++;
-    kc_chan_update_send_stats_len_locked(ch, d->len);
+    ch->zref_ptr = m->ptr; ch->zref_len = m->len; ch->zref_ready = 1; ch->zref_epoch++; ch->zref_sent++;
+    kc_chan_update_send_stats_len_locked(ch, len);
     /* Wake a pending zref receiver (if any) */
     kcoro_t *wake_co = NULL;
     struct kc_waiter *w = zref_pop_first_recv(&ch->wq_recv_head, &ch->wq_recv_tail);
@@ -319,53 +994,54 @@ again:
         kc_waiter_dispose(w);
     }
     KC_COND_SIGNAL(&ch->cv_recv);
+    int lane = ch->wake_lane;
     KC_MUTEX_UNLOCK(&ch->mu);
-    kc_zref_schedule_co(wake_co);
+    kc_zref_schedule_co(wake_co, lane);
     return 0;
 }
 
+static int zref_send(kc_chan_t *c, const kc_zdesc_t *d, long timeout_ms)
+{
+    if (!c || !d) return -EINVAL;
+    if (((struct kc_chan*)c)->wal) return -ENOTSUP;   /* a pointer cannot outlive the process */
+    struct kc_chan_ptrmsg m;
+    int rc = zref_stage(d, &m);
+    if (rc != 0) return rc;
+    rc = zref_send_msg(c, &m, timeout_ms);
+    if (rc != 0) zref_unhold(&m);
+    return rc;
+}
+
 static int zref_recv(kc_chan_t *c, kc_zdesc_t *d, long timeout_ms)
 {
     struct kc_chan *ch = (struct kc_chan*)c;
     if (!ch || !d) return -EINVAL;
-    /* Non-rendezvous: queued descriptor path */
-    if (ch->kind != KC_RENDEZVOUS) {
+    if (ch->kind == KC_BUFFERED || ch->kind == KC_UNLIMITED) {
+        assert(kcoro_current() != NULL);
+        struct kc_chan_ptrmsg tmp;
+        size_t got = 0;
+        int rc = kc_chan_take_run(ch, &tmp, 1, timeout_ms, &got);
+        if (rc != 0) return rc;
+        zref_deliver(&tmp, d);
+        return 0;
+    }
+    if (ch->kind == KC_CONFLATED) {
         assert(kcoro_current() != NULL);
         long deadline_ns = 0; int timed = (timeout_ms > 0);
         if (timed) deadline_ns = kc_now_ns() + timeout_ms * 1000000L;
     again_qrecv:
         KC_MUTEX_LOCK(&ch->mu);
-        if (ch->kind == KC_CONFLATED) {
-            int rc = 0;
-            if (!ch->has_value) {
-                if (timeout_ms == 0) { ch->recv_eagain++; KC_MUTEX_UNLOCK(&ch->mu); return KC_EAGAIN; }
-                if (timeout_ms < 0) { KC_MUTEX_UNLOCK(&ch->mu); kcoro_yield(); goto again_qrecv; }
-                KC_MUTEX_UNLOCK(&ch->mu); if (kc_now_ns() >= deadline_ns) { ch->recv_etime++; return KC_ETIME; } kcoro_yield(); goto again_qrecv;
-            }
-            struct kc_chan_ptrmsg tmp; memcpy(&tmp, ch->slot, sizeof(tmp)); ch->has_value = 0;
-            d->addr = tmp.ptr; d->len = tmp.len;
-            kc_chan_update_recv_stats_len_locked(ch, tmp.len);
-            KC_COND_SIGNAL(&ch->cv_send);
-            KC_MUTEX_UNLOCK(&ch->mu); return rc;
-        }
-        if (timeout_ms == 0) {
-            if (ch->count == 0) { int rcl = ch->closed ? KC_EPIPE : KC_EAGAIN; if (rcl==KC_EAGAIN) ch->recv_eagain++; else ch->recv_epipe++; KC_MUTEX_UNLOCK(&ch->mu); return rcl; }
-        } else if (timeout_ms < 0) {
-            if (ch->count == 0 && !ch->closed) { KC_MUTEX_UNLOCK(&ch->mu); kcoro_yield(); goto again_qrecv; }
-        } else {
-            if (ch->count == 0 && !ch->closed) { KC_MUTEX_UNLOCK(&ch->mu); if (kc_now_ns() >= deadline_ns) { ch->recv_etime++; return KC_ETIME; } kcoro_yield(); goto again_qrecv; }
-        }
-        if (ch->count > 0) {
-            size_t h = kc_ring_idx(ch, ch->head);
-            struct kc_chan_ptrmsg tmp; memcpy(&tmp, ch->buf + (h * ch->elem_sz), sizeof(tmp));
-            size_t n2 = ch->head + 1; ch->head = ch->mask ? (n2 & ch->mask) : (n2 % ch->capacity);
-            ch->count--; d->addr = tmp.ptr; d->len = tmp.len;
-            kc_chan_update_recv_stats_len_locked(ch, tmp.len);
-            KC_COND_SIGNAL(&ch->cv_send);
-            KC_MUTEX_UNLOCK(&ch->mu); return 0;
+        if (!ch->has_value) {
+            if (timeout_ms == 0) { ch->recv_eagain++; KC_MUTEX_UNLOCK(&ch->mu); return KC_EAGAIN; }
+            if (timeout_ms < 0) { KC_MUTEX_UNLOCK(&ch->mu); kcoro_yield(); goto again_qrecv; }
+            KC_MUTEX_UNLOCK(&ch->mu); if (kc_now_ns() >= deadline_ns) { ch->recv_etime++; return KC_ETIME; } kcoro_yield(); goto again_qrecv;
         }
-        if (ch->closed && ch->count == 0) { KC_MUTEX_UNLOCK(&ch->mu); return KC_EPIPE; }
-        KC_MUTEX_UNLOCK(&ch->mu); return KC_EAGAIN;
+        struct kc_chan_ptrmsg tmp; memcpy(&tmp, ch->slot, sizeof(tmp)); ch->has_value = 0;
+        kc_chan_update_recv_stats_len_locked(ch, tmp.len & ZREF_LEN_MASK);
+        KC_COND_SIGNAL(&ch->cv_send);
+        KC_MUTEX_UNLOCK(&ch->mu);
+        zref_deliver(&tmp, d);
+        return 0;
     }
     assert(kcoro_current() != NULL);
     long deadline_ns = 0; int timed = (timeout_ms > 0);
@@ -377,11 +1053,12 @@ again:
     if (ch->kind != KC_RENDEZVOUS) { KC_MUTEX_UNLOCK(&ch->mu); return -ENOTSUP; }
     ch->zref_mode = 1;
     if (ch->zref_ready) {
-        d->addr = ch->zref_ptr; d->len = ch->zref_len; ch->zref_ready=0; ch->zref_ptr=NULL; ch->zref_len=0;
+        struct kc_chan_ptrmsg tmp = { .ptr = ch->zref_ptr, .len = ch->zref_len };
+        ch->zref_ready=0; ch->zref_ptr=NULL; ch->zref_len=0;
         ch->zref_received++; ch->zref_last_consumed_epoch = ch->zref_epoch;
         ch->rv_matches++;
         ch->rv_zdesc_matches++;
-        kc_chan_update_recv_stats_len_locked(ch, d->len);
+        kc_chan_update_recv_stats_len_locked(ch, tmp.len & ZREF_LEN_MASK);
         /* Wake first parked zref sender */
         kcoro_t *wake_co = NULL;
         struct kc_waiter *w = zref_pop_first_sender(&ch->wq_send_head, &ch->wq_send_tail);
@@ -400,8 +1077,10 @@ again:
             ch->zref_sender_waiter_expected = 0;
         }
         zref_assert_invariants(ch);
+        int lane = ch->wake_lane;
         KC_MUTEX_UNLOCK(&ch->mu);
-        kc_zref_schedule_co(wake_co);
+        zref_deliver(&tmp, d);
+        kc_zref_schedule_co(wake_co, lane);
         return 0;
     }
     if (ch->closed) { KC_MUTEX_UNLOCK(&ch->mu); return KC_EPIPE; }
@@ -419,6 +1098,19 @@ static const kc_zcopy_backend_ops_t g_zref_ops = {
     .send_c = zref_send_c, .recv_c = zref_recv_c,
 };
 
+void kc_zref_chan_drop(struct kc_chan *ch)
+{
+    if (ch->zc_ops != &g_zref_ops || ch->kind == KC_RENDEZVOUS) return;
+    KC_MUTEX_LOCK(&ch->mu);
+    struct kc_chan_ptrmsg m;
+    if (ch->kind == KC_CONFLATED) {
+        if (ch->has_value) { memcpy(&m, ch->slot, sizeof(m)); ch->has_value = 0; zref_unhold(&m); }
+    } else {
+        while (ch->count > 0) { kc_chan_buf_take_locked(ch, &m); zref_unhold(&m); }
+    }
+    KC_MUTEX_UNLOCK(&ch->mu);
+}
+
 /* Public zref wrappers now call unified descriptor API */
 int kc_chan_send_zref(kc_chan_t *c, void *ptr, size_t len, long timeout_ms)
 {
@@ -449,12 +1141,76 @@ int kc_chan_recv_zref_c(kc_chan_t *c, void **out_ptr, size_t *out_len, long time
 /* kc_chan_send_ptr_c is defined in kc_chan.c */
 
 /* kc_chan_recv_ptr_c is defined in kc_chan.c */
+size_t kc_ziov_len(const kc_ziov_t *v)
+{
+    if (!v || v->nseg == 0 || v->nseg > KC_ZIOV_MAX || (v->nseg > KC_ZIOV_INLINE && !v->more)) return 0;
+    size_t total = 0;
+    for (uint32_t i = 0; i < v->nseg; i++) {
+        const kc_zseg_t *sg = kc_ziov_seg(v, i);
+        if (!sg->addr || sg->len == 0 || sg->len > SIZE_MAX - total) return 0;
+        total += sg->len;
+    }
+    return total;
+}
+
+size_t kc_ziov_copyout(const kc_ziov_t *v, void *dst, size_t cap)
+{
+    if (!kc_ziov_len(v) || !dst) return 0;
+    size_t done = 0;
+    for (uint32_t i = 0; i < v->nseg && done < cap; i++) {
+        const kc_zseg_t *sg = kc_ziov_seg(v, i);
+        size_t k = sg->len < cap - done ? sg->len : cap - done;
+        memcpy((uint8_t*)dst + done, sg->addr, k);
+        done += k;
+    }
+    return done;
+}
+
+/* A descriptor naming (region_id, offset) rather than addr: point *d at a
+ * copy carrying the address inside that registered region. A kc_ziov_t
+ * takes addr, and only the zref backend knows its layout. */
+static int desc_resolve(const struct kc_chan *ch, const kc_zdesc_t **d, kc_zdesc_t *tmp)
+{
+    const kc_zdesc_t *in = *d;
+    if (in->flags & KC_ZDESC_F_IOV) {
+        if (ch->zc_ops != &g_zref_ops) return -ENOTSUP;
+        return in->region_id ? -EINVAL : 0;
+    }
+    if (in->addr || !in->region_id) return 0;
+    kc_region_t *r = kc_region_get((unsigned long)in->region_id);
+    if (!r) return -ENOENT;
+    int rc = (in->offset > r->len || in->len > r->len - in->offset) ? -EINVAL : 0;
+    if (rc == 0) {
+        *tmp = *in;
+        tmp->addr = (uint8_t*)r->addr + in->offset;
+        *d = tmp;
+    }
+    kc_region_put(r);
+    return rc;
+}
+
+/* KC_ZDESC_F_REGION on recv: name the region the payload lies in (0: none). */
+static void desc_locate(kc_zdesc_t *d)
+{
+    d->region_id = 0;
+    d->offset = 0;
+    if (d->flags & KC_ZDESC_F_IOV) return;
+    kc_region_t *r = kc_region_acquire(d->addr, d->len, NULL);
+    if (!r) return;
+    d->region_id = r->id;
+    d->offset = (uint64_t)((uintptr_t)d->addr - (uintptr_t)r->addr);
+    kc_region_release(r);
+}
+
 /* Unified descriptor-based API */
 int kc_chan_send_desc(kc_chan_t *c, const kc_zdesc_t *d, long tmo_ms)
 {
     struct kc_chan *ch = (struct kc_chan*)c;
     if (!ch || !d) return -EINVAL;
     if (!ch->zc_ops || !ch->zc_ops->send) return -ENOTSUP;
+    kc_zdesc_t tmp;
+    int rc = desc_resolve(ch, &d, &tmp);
+    if (rc != 0) return rc;
     return ch->zc_ops->send(c, d, tmo_ms);
 }
 
@@ -463,7 +1219,10 @@ int kc_chan_recv_desc(kc_chan_t *c, kc_zdesc_t *d, long tmo_ms)
     struct kc_chan *ch = (struct kc_chan*)c;
     if (!ch || !d) return -EINVAL;
     if (!ch->zc_ops || !ch->zc_ops->recv) return -ENOTSUP;
-    return ch->zc_ops->recv(c, d, tmo_ms);
+    uint32_t want = d->flags & KC_ZDESC_F_REGION;
+    int rc = ch->zc_ops->recv(c, d, tmo_ms);
+    if (rc == 0 && want) desc_locate(d);
+    return rc;
 }
 
 int kc_chan_send_desc_c(kc_chan_t *c, const kc_zdesc_t *d, long tmo_ms, const kc_cancel_t *ct)
@@ -472,6 +1231,9 @@ int kc_chan_send_desc_c(kc_chan_t *c, const kc_zdesc_t *d, long tmo_ms, const kc
     if (!ch || !d) return -EINVAL;
     if (ct && kc_cancel_is_set(ct)) return KC_ECANCELED;
     if (!ch->zc_ops) return -ENOTSUP;
+    kc_zdesc_t tmp;
+    int rrc = desc_resolve(ch, &d, &tmp);
+    if (rrc != 0) return rrc;
     if (ch->zc_ops->send_c) return ch->zc_ops->send_c(c, d, tmo_ms, ct);
     /* Fallback: slice loop using non-cancellable send */
     if (!ct) return kc_chan_send_desc(c, d, tmo_ms);
@@ -490,7 +1252,12 @@ int kc_chan_recv_desc_c(kc_chan_t *c, kc_zdesc_t *d, long tmo_ms, const kc_cance
     if (!ch || !d) return -EINVAL;
     if (ct && kc_cancel_is_set(ct)) return KC_ECANCELED;
     if (!ch->zc_ops) return -ENOTSUP;
-    if (ch->zc_ops->recv_c) return ch->zc_ops->recv_c(c, d, tmo_ms, ct);
+    if (ch->zc_ops->recv_c) {
+        uint32_t want = d->flags & KC_ZDESC_F_REGION;
+        int rc = ch->zc_ops->recv_c(c, d, tmo_ms, ct);
+        if (rc == 0 && want) desc_locate(d);
+        return rc;
+    }
     if (!ct) return kc_chan_recv_desc(c, d, tmo_ms);
     const long SLICE_MS = KCORO_CANCEL_SLICE_MS;
     if (tmo_ms == 0) return kc_chan_recv_desc(c, d, 0);
@@ -500,6 +1267,110 @@ int kc_chan_recv_desc_c(kc_chan_t *c, kc_zdesc_t *d, long tmo_ms, const kc_cance
         long remain=tmo_ms; while (remain>=0) { if (kc_cancel_is_set(ct)) return KC_ECANCELED; long slice=(SLICE_MS<remain)?SLICE_MS:remain; int rc=kc_chan_recv_desc(c,d,slice); if (rc==0 || rc==KC_EPIPE) return rc; if (rc!=KC_ETIME && rc!=KC_EAGAIN) return rc; remain-=slice; if (remain<=0) return KC_ETIME; } return KC_ETIME;
     }
 }
+
+/* Descriptors staged per lock hold on the batch paths. */
+#define ZDESC_RUN 64
+
+/* zref buffered/unlimited: descriptors queue in the ring, so a batch can go
+ * through kc_chan_put_run/take_run rather than one descriptor at a time. */
+static int desc_queued(const struct kc_chan *ch)
+{
+    return ch->zc_ops == &g_zref_ops && (ch->kind == KC_BUFFERED || ch->kind == KC_UNLIMITED);
+}
+
+/* What is left of a batch timeout for the next call; KC_ETIME once spent. */
+static int desc_slice(long tmo_ms, long deadline_ns, long *slice_ms)
+{
+    if (tmo_ms <= 0) { *slice_ms = tmo_ms; return 0; }
+    long left = deadline_ns - kc_now_ns();
+    if (left <= 0) return KC_ETIME;
+    *slice_ms = (left + 999999L) / 1000000L;
+    return 0;
+}
+
+int kc_chan_send_desc_many(kc_chan_t *c, const kc_zdesc_t *d, size_t n, long tmo_ms, size_t *sent)
+{
+    struct kc_chan *ch = (struct kc_chan*)c;
+    size_t done = 0;
+    if (sent) *sent = 0;
+    if (!ch || (!d && n)) return -EINVAL;
+    if (!ch->zc_ops || !ch->zc_ops->send) return -ENOTSUP;
+    for (size_t i = 0; i < n; ++i) {
+        const kc_zdesc_t *e = &d[i];
+        kc_zdesc_t tmp;
+        int rc = desc_resolve(ch, &e, &tmp);
+        if (rc != 0) return rc;
+        if (!zref_valid(e)) return -EINVAL;
+    }
+    if (n == 0) return 0;
+    assert(kcoro_current() != NULL);
+    long deadline_ns = tmo_ms > 0 ? kc_now_ns() + tmo_ms * 1000000L : 0;
+    int rc = 0;
+    if (!desc_queued(ch)) {
+        while (done < n) {
+            long slice;
+            if ((rc = desc_slice(tmo_ms, deadline_ns, &slice)) != 0) break;
+            if ((rc = kc_chan_send_desc(c, &d[done], slice)) != 0) break;
+            done++;
+        }
+        if (sent) *sent = done;
+        return rc;
+    }
+    struct kc_chan_ptrmsg run[ZDESC_RUN];
+    while (done < n && rc == 0) {
+        size_t k = n - done < ZDESC_RUN ? n - done : ZDESC_RUN, put = 0;
+        for (size_t i = 0; i < k; ++i) {
+            const kc_zdesc_t *e = &d[done + i];
+            kc_zdesc_t tmp;
+            /* A region can go between the check above and here */
+            if ((rc = desc_resolve(ch, &e, &tmp)) != 0 || (rc = zref_stage(e, &run[i])) != 0) { k = i; break; }
+        }
+        long slice;
+        int trc = k ? desc_slice(tmo_ms, deadline_ns, &slice) : 0;
+        if (trc == 0 && k) trc = kc_chan_put_run(ch, run, k, slice, &put);
+        if (trc != 0) rc = trc;
+        /* The channel owns the references it queued; give back the rest */
+        for (size_t i = put; i < k; ++i) zref_unhold(&run[i]);
+        done += put;
+    }
+    if (sent) *sent = done;
+    return rc;
+}
+
+int kc_chan_recv_desc_many(kc_chan_t *c, kc_zdesc_t *out, size_t max, long tmo_ms, size_t *got)
+{
+    struct kc_chan *ch = (struct kc_chan*)c;
+    size_t n = 0;
+    if (got) *got = 0;
+    if (!ch || !out || max == 0) return -EINVAL;
+    if (!ch->zc_ops || !ch->zc_ops->recv) return -ENOTSUP;
+    uint32_t want = out[0].flags & KC_ZDESC_F_REGION;
+    assert(kcoro_current() != NULL);
+    int rc;
+    if (desc_queued(ch)) {
+        struct kc_chan_ptrmsg run[ZDESC_RUN];
+        rc = kc_chan_take_run(ch, run, max < ZDESC_RUN ? max : ZDESC_RUN, tmo_ms, &n);
+        for (size_t i = 0; i < n; ++i) {
+            out[i].flags = want;
+            zref_deliver(&run[i], &out[i]);
+            if (want) desc_locate(&out[i]);
+        }
+    } else {
+        out[0].flags = want;
+        rc = kc_chan_recv_desc(c, &out[0], tmo_ms);
+        if (rc == 0) {
+            n = 1;
+            while (n < max) {
+                out[n].flags = want;
+                if (kc_chan_recv_desc(c, &out[n], 0) != 0) break;
+                n++;
+            }
+        }
+    }
+    if (got) *got = n;
+    return rc;
+}
+
 /* No direct dependency on kc_chan's wake helpers; we rely on condvars and
  * cooperative yields for test coverage paths. */
 /* Runtime debug logging (enabled when KCORO_DEBUG=1). */
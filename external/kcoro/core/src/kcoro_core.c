@@ -7,37 +7,280 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+#include <time.h>
 #include <stdint.h>
+#include <stdatomic.h>
+#include <stddef.h>
 #include <assert.h>
-#include <sys/mman.h>
-#include <unistd.h>
 #include <pthread.h>
 
-#ifndef MAP_ANON
-#define MAP_ANON 0x1000
-#endif
-#ifndef MAP_ANONYMOUS
-#define MAP_ANONYMOUS MAP_ANON
-#endif
-
+#include "kcoro_config.h"
 #include "kcoro_core.h"
 #include "kcoro_sched.h"
+#include "kcoro_stack_internal.h"
+#include "kcoro_share_internal.h"
+#include "kc_trace_internal.h"
+#include "kc_cls_internal.h"
+#include "kc_clock_internal.h"
 
 /* Thread-local current coroutine */
 static __thread kcoro_t* current_kcoro = NULL;
 /* Thread-local main coroutine (yield target) */
 static __thread kcoro_t* main_kcoro = NULL;
 
-/* Coroutine ID counter */
-static uint64_t next_kcoro_id = 1;
+/* TLS accessors. A coroutine may be switched out on one worker and resumed on
+ * another, so code after kcoro_switch must not reuse a TLS address the
+ * compiler computed before the switch. Keeping every access behind a
+ * non-inlined call forces a fresh lookup on the thread we are running on. */
+__attribute__((noinline)) static kcoro_t* tls_current(void)
+{ __asm__ __volatile__("" ::: "memory"); return current_kcoro; }
+__attribute__((noinline)) static void tls_set_current(kcoro_t* co)
+{ __asm__ __volatile__("" ::: "memory"); current_kcoro = co; }
+__attribute__((noinline)) static kcoro_t* tls_main(void)
+{ __asm__ __volatile__("" ::: "memory"); return main_kcoro; }
+__attribute__((noinline)) static void tls_set_main(kcoro_t* co)
+{ __asm__ __volatile__("" ::: "memory"); main_kcoro = co; }
+
+/* Coroutine that performed the latest switch on this thread; the context it
+ * switched to settles its shared stack. Only tracked once a shared-stack
+ * coroutine exists. */
+static __thread kcoro_t* switched_from = NULL;
+static _Atomic int g_share_active;
+
+__attribute__((noinline)) static kcoro_t* tls_take_switched(void)
+{ __asm__ __volatile__("" ::: "memory"); kcoro_t* co = switched_from; switched_from = NULL; return co; }
+__attribute__((noinline)) static void tls_set_switched(kcoro_t* co)
+{ __asm__ __volatile__("" ::: "memory"); switched_from = co; }
+
+/* Runs first in whatever context a switch lands in. */
+static void kcoro_settle(void)
+{
+    if (!atomic_load_explicit(&g_share_active, memory_order_relaxed)) return;
+    kcoro_t* prev = tls_take_switched();
+    if (prev && prev->share) kcoro_share_unload(prev);
+}
+
+#if KCORO_CO_STATS
+/* Accounting (KCORO_CO_STATS). One clock read per switch: it closes the run
+ * slice of `from` (stamping its park when kcoro_park marked it parking: the
+ * state alone may already be flipped back by a waker) and opens the slice
+ * of `to` (closing its park). Only the switching thread writes either side,
+ * so plain relaxed load/store pairs suffice. */
+#define KCORO_STATS_PARKING UINT64_MAX
+static inline uint64_t kcoro_stats_now(void)
+{
+    return kc_clock_ns();
+}
+
+static inline void kcoro_stats_add(atomic_uint_least64_t* v, uint64_t d)
+{
+    atomic_store_explicit(v, atomic_load_explicit(v, memory_order_relaxed) + d, memory_order_relaxed);
+}
+
+static void kcoro_stats_switch(kcoro_t* from, kcoro_t* to)
+{
+    uint64_t now = kcoro_stats_now();
+    if (from) {
+        uint64_t t0 = atomic_load_explicit(&from->run_start_ns, memory_order_relaxed);
+        if (t0) {
+            kcoro_stats_add(&from->run_ns, now - t0);
+            atomic_store_explicit(&from->run_start_ns, 0, memory_order_relaxed);
+        }
+        if (from->park_start_ns == KCORO_STATS_PARKING) from->park_start_ns = now;
+    }
+    if (to->park_start_ns) {
+        if (to->park_start_ns != KCORO_STATS_PARKING) kcoro_stats_add(&to->parked_ns, now - to->park_start_ns);
+        to->park_start_ns = 0;
+    }
+    kcoro_stats_add(&to->switches, 1);
+    atomic_store_explicit(&to->run_start_ns, now, memory_order_relaxed);
+}
+
+/* Live coroutines by id stripe, for kcoro_stats_top. */
+#define KCORO_STATS_STRIPES 16
+struct kcoro_stats_stripe {
+    pthread_mutex_t mu;
+    kcoro_t* head;
+} __attribute__((aligned(64)));
+static struct kcoro_stats_stripe g_stats_reg[KCORO_STATS_STRIPES];
+static pthread_once_t g_stats_once = PTHREAD_ONCE_INIT;
+
+static void kcoro_stats_reg_init(void)
+{
+    for (int i = 0; i < KCORO_STATS_STRIPES; i++) pthread_mutex_init(&g_stats_reg[i].mu, NULL);
+}
+
+static void kcoro_stats_register(kcoro_t* co)
+{
+    pthread_once(&g_stats_once, kcoro_stats_reg_init);
+    struct kcoro_stats_stripe* r = &g_stats_reg[co->id % KCORO_STATS_STRIPES];
+    pthread_mutex_lock(&r->mu);
+    co->stats_prev = NULL;
+    co->stats_next = r->head;
+    if (r->head) r->head->stats_prev = co;
+    r->head = co;
+    pthread_mutex_unlock(&r->mu);
+}
+
+static void kcoro_stats_unregister(kcoro_t* co)
+{
+    struct kcoro_stats_stripe* r = &g_stats_reg[co->id % KCORO_STATS_STRIPES];
+    pthread_mutex_lock(&r->mu);
+    if (co->stats_prev) co->stats_prev->stats_next = co->stats_next;
+    else r->head = co->stats_next;
+    if (co->stats_next) co->stats_next->stats_prev = co->stats_prev;
+    pthread_mutex_unlock(&r->mu);
+}
+#endif
+
+/* FP environment of the thread's non-opted-in code, saved when control
+ * passes to a kcoro_set_fpu_preserve coroutine and reloaded when it passes
+ * back. Both happen on one thread: only opted-in coroutines run between. */
+static __thread struct kcoro_fpu_ctx tls_fpu_ambient;
+
+/* kcoro_switch plus the shared-stack bookkeeping on either side of it. */
+static void kcoro_switch_co(kcoro_t* from, kcoro_t* to)
+{
+#if KCORO_CO_STATS
+    kcoro_stats_switch(from, to);
+#endif
+    if (atomic_load_explicit(&g_share_active, memory_order_relaxed)) {
+        if (to->share) kcoro_share_load(to, from);
+        tls_set_switched(from);
+    }
+    if (__builtin_expect(from->fpu | to->fpu, 0))
+        kcoro_switch_fpu(from, to,
+                         from->fpu ? from->fpu_ctx : &tls_fpu_ambient,
+                         to->fpu ? to->fpu_ctx : &tls_fpu_ambient);
+    else
+        kcoro_switch(from, to);
+    kcoro_settle();
+}
+
+_Static_assert(offsetof(struct kcoro, state) == 128 &&
+               offsetof(struct kcoro, stack_size) + sizeof(size_t) <= 192,
+               "kcoro_t hot fields must share the cache line after reg[]");
+
+/* Coroutine ID counter; threads reserve KCORO_ID_BATCH IDs at a time. */
+static _Atomic uint64_t next_kcoro_id = 1;
+static __thread uint64_t tls_id_next, tls_id_end;
+
+static uint64_t kcoro_next_id(void)
+{
+    if (tls_id_next == tls_id_end) {
+        tls_id_next = atomic_fetch_add_explicit(&next_kcoro_id, KCORO_ID_BATCH, memory_order_relaxed);
+        tls_id_end = tls_id_next + KCORO_ID_BATCH;
+    }
+    return tls_id_next++;
+}
+
+/* kcoro_t slab. Control blocks are carved KCORO_CORO_SLAB at a time from
+ * cache-line aligned chunks and recycled through a per-thread free list
+ * (linked through `next`); past KCORO_CORO_CACHE_PER_THREAD half of the list
+ * moves to a global depot that empty thread lists refill from. Slabs are
+ * never returned to the allocator, so memory tracks the peak live count. */
+struct kcoro_slab_cache {
+    kcoro_t *head;
+    unsigned count;
+    int registered;
+};
+
+static __thread struct kcoro_slab_cache tls_slab;
+static pthread_key_t slab_key;
+static pthread_once_t slab_once = PTHREAD_ONCE_INIT;
+static struct {
+    pthread_mutex_t mu;
+    kcoro_t *head;
+    unsigned count;
+} g_slab_depot = { .mu = PTHREAD_MUTEX_INITIALIZER };
+
+#define KCORO_SLAB_LINK(co) ((co)->next)
+
+/* Move up to n blocks from the thread list to the depot. */
+static void kcoro_slab_spill(struct kcoro_slab_cache *c, unsigned n)
+{
+    if (!n || !c->head) return;
+    kcoro_t *first = c->head, *last = first;
+    unsigned moved = 1;
+    while (moved < n && KCORO_SLAB_LINK(last)) { last = KCORO_SLAB_LINK(last); moved++; }
+    c->head = KCORO_SLAB_LINK(last);
+    c->count -= moved;
+    pthread_mutex_lock(&g_slab_depot.mu);
+    KCORO_SLAB_LINK(last) = g_slab_depot.head;
+    g_slab_depot.head = first;
+    g_slab_depot.count += moved;
+    pthread_mutex_unlock(&g_slab_depot.mu);
+}
+
+static void kcoro_slab_drain(void *arg)
+{
+    struct kcoro_slab_cache *c = (struct kcoro_slab_cache*)arg;
+    kcoro_slab_spill(c, c->count);
+}
+
+static void kcoro_slab_key_init(void)
+{
+    (void)pthread_key_create(&slab_key, kcoro_slab_drain);
+}
+
+/* Refill an empty thread list from the depot, else carve a new slab. */
+static int kcoro_slab_refill(struct kcoro_slab_cache *c)
+{
+    if (!c->registered) {
+        pthread_once(&slab_once, kcoro_slab_key_init);
+        (void)pthread_setspecific(slab_key, c);
+        c->registered = 1;
+    }
+    pthread_mutex_lock(&g_slab_depot.mu);
+    unsigned take = KCORO_CORO_CACHE_PER_THREAD / 2 ? KCORO_CORO_CACHE_PER_THREAD / 2 : 1;
+    while (take-- && g_slab_depot.head) {
+        kcoro_t *co = g_slab_depot.head;
+        g_slab_depot.head = KCORO_SLAB_LINK(co);
+        g_slab_depot.count--;
+        KCORO_SLAB_LINK(co) = c->head;
+        c->head = co;
+        c->count++;
+    }
+    pthread_mutex_unlock(&g_slab_depot.mu);
+    if (c->head) return 0;
+
+    void *mem = NULL;
+    if (posix_memalign(&mem, 64, (size_t)KCORO_CORO_SLAB * sizeof(kcoro_t)) != 0) return -1;
+    kcoro_t *slab = (kcoro_t*)mem;
+    for (int i = KCORO_CORO_SLAB - 1; i >= 0; --i) {
+        KCORO_SLAB_LINK(&slab[i]) = c->head;
+        c->head = &slab[i];
+    }
+    c->count += KCORO_CORO_SLAB;
+    return 0;
+}
+
+/* Zeroed, cache-line aligned control block. */
+static kcoro_t *kcoro_alloc(void)
+{
+    struct kcoro_slab_cache *c = &tls_slab;
+    if (!c->head && kcoro_slab_refill(c) != 0) return NULL;
+    kcoro_t *co = c->head;
+    c->head = KCORO_SLAB_LINK(co);
+    c->count--;
+    memset(co, 0, sizeof(*co));
+    return co;
+}
 
-/* Default stack size */
-#define KCORO_DEFAULT_STACK_SIZE (64 * 1024)  /* 64KB */
+static void kcoro_dealloc(kcoro_t *co)
+{
+    struct kcoro_slab_cache *c = &tls_slab;
+    KCORO_SLAB_LINK(co) = c->head;
+    c->head = co;
+    if (++c->count > KCORO_CORO_CACHE_PER_THREAD)
+        kcoro_slab_spill(c, c->count - KCORO_CORO_CACHE_PER_THREAD / 2);
+}
 
 /* Function protector implementation */
 void kcoro_funcp_protector(void)
 {
-    kcoro_t *current = current_kcoro;
+    kcoro_t *current = tls_current();
     int state = current ? (int)current->state : -1;
     fprintf(stderr,
             "kcoro: coroutine function returned unexpectedly (co=%p state=%d main=%p fn=%p)\n",
@@ -53,11 +296,10 @@ static void kcoro_trampoline(void);
 
 kcoro_t* kcoro_create_main(void)
 {
-    kcoro_t* main_co = (kcoro_t*)calloc(1, sizeof(kcoro_t));
+    kcoro_t* main_co = kcoro_alloc();
     if (!main_co) return NULL;
 
     /* Initialize main coroutine */
-    memset(main_co->reg, 0, sizeof(main_co->reg));
     main_co->state = KCORO_RUNNING;
     main_co->fn = NULL;  /* Main has no function */
     main_co->arg = NULL;
@@ -69,78 +311,128 @@ kcoro_t* kcoro_create_main(void)
     atomic_init(&main_co->refcount, 1);
     
     /* Set as current */
-    current_kcoro = main_co;
-    main_kcoro = main_co;
+    tls_set_current(main_co);
+    tls_set_main(main_co);
 
     return main_co;
 }
 
 void kcoro_set_thread_main(kcoro_t* main_co)
 {
-    main_kcoro = main_co;
-    current_kcoro = main_co;
+    tls_set_main(main_co);
+    tls_set_current(main_co);
 }
 
 kcoro_t* kcoro_create(kcoro_fn_t fn, void* arg, size_t stack_size)
 {
     if (!fn) return NULL;
-    if (stack_size == 0) stack_size = KCORO_DEFAULT_STACK_SIZE;
+    if (stack_size == 0) stack_size = kcoro_stack_tuned_size(fn);
     
-    kcoro_t* co = (kcoro_t*)calloc(1, sizeof(kcoro_t));
+    kcoro_t* co = kcoro_alloc();
     if (!co) return NULL;
     
-    /* Allocate stack with mmap for guard page support */
-    long page_size = sysconf(_SC_PAGESIZE);
-    if (page_size < 0) page_size = 4096;
-    
-    /* Align stack size to page boundary */
-    size_t total_size = (stack_size + page_size - 1) & ~(page_size - 1);
-    
-    void* stack_mem = mmap(NULL, total_size, PROT_READ | PROT_WRITE,
-                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-    if (stack_mem == MAP_FAILED) {
-        free(co);
-        return NULL;
-    }
-    
     /* Initialize coroutine */
-    memset(co->reg, 0, sizeof(co->reg));
     co->state = KCORO_CREATED;
     co->fn = fn;
     co->arg = arg;
-    co->id = __sync_fetch_and_add(&next_kcoro_id, 1);
-    co->main_co = main_kcoro;     /* Default yield target */
-    co->stack_ptr = stack_mem;
-    co->stack_size = total_size;
+    co->id = kcoro_next_id();
+    co->main_co = tls_main();     /* Default yield target */
     co->ready_enqueued = false;
     atomic_init(&co->running_flag, 0);
     atomic_init(&co->refcount, 1);
-    
+    co->reg[13] = (void*)kcoro_trampoline;    /* LR at reg[13] - entry point */
+
+    if (stack_size == KCORO_STACK_LAZY) {
+        /* Stack mapped by kcoro_stack_bind on the first resume */
+        co->stack_size = kcoro_stack_tuned_size(fn);
+#if KCORO_CO_STATS
+        kcoro_stats_register(co);
+#endif
+        return co;
+    }
+    if (stack_size == KCORO_STACK_SHARED) {
+        /* SP/FP are seeded when the first resume binds a shared stack */
+        if (kcoro_share_init(co) != 0) {
+            kcoro_dealloc(co);
+            return NULL;
+        }
+        atomic_store_explicit(&g_share_active, 1, memory_order_relaxed);
+#if KCORO_CO_STATS
+        kcoro_stats_register(co);
+#endif
+        return co;
+    }
+
+    /* Stack from the pool (page aligned, rounded up to its size class) */
+    size_t total_size = stack_size;
+    void* stack_mem = kcoro_stack_alloc(&total_size);
+    if (!stack_mem) {
+        kcoro_dealloc(co);
+        return NULL;
+    }
+    co->stack_ptr = stack_mem;
+    co->stack_size = total_size;
+    kcoro_seed_stack(co, (unsigned char*)stack_mem + total_size);
+#if KCORO_CO_STATS
+    kcoro_stats_register(co);
+#endif
+    return co;
+}
+
+int kcoro_stack_bind(kcoro_t* co)
+{
+    if (__builtin_expect(co->state != KCORO_CREATED || co->stack_ptr || co->share || !co->fn, 1)) return 0;
+    size_t total_size = co->stack_size;
+    void* stack_mem = kcoro_stack_alloc(&total_size);
+    if (!stack_mem) return -ENOMEM;
+    co->stack_ptr = stack_mem;
+    co->stack_size = total_size;
+    kcoro_seed_stack(co, (unsigned char*)stack_mem + total_size);
+    return 0;
+}
+
+void kcoro_seed_stack(kcoro_t* co, void* top)
+{
     /* Set up stack and entry point (ARM64 ABI compliant) */
-    uintptr_t stack_top = (uintptr_t)stack_mem + total_size;
+    uintptr_t stack_top = (uintptr_t)top;
     stack_top = stack_top & ~0xFUL;  /* 16-byte align */
     stack_top -= 16;  /* Leave space */
+#if defined(__x86_64__)
+    /* SysV entry state: RSP % 16 == 8, as if a return address were pushed. */
+    stack_top -= 8;
+    *(void**)stack_top = NULL;
+#endif
     
     co->reg[14] = (void*)stack_top;           /* SP at reg[14] */
     co->reg[15] = (void*)stack_top;           /* FP at reg[15] */  
-    co->reg[13] = (void*)kcoro_trampoline;    /* LR at reg[13] - entry point */
-    
-    return co;
+#if KCORO_FAST_SWITCH && defined(__x86_64__)
+    /* The fast switch resumes with `ret` from reg[14] and restores rbp from
+     * reg[5]: push the entry point as the return address, so the trampoline
+     * still starts at RSP % 16 == 8. */
+    stack_top -= 8;
+    *(void**)stack_top = co->reg[13];
+    co->reg[14] = (void*)stack_top;
+    co->reg[5]  = co->reg[15];
+#endif
 }
 
 static void kcoro_free(kcoro_t* co)
 {
     if (!co) return;
-    if (co->stack_ptr && co->stack_size > 0) {
-        munmap(co->stack_ptr, co->stack_size);
-    }
-    if (current_kcoro == co) {
-        current_kcoro = NULL;
+#if KCORO_CO_STATS
+    if (co->fn) kcoro_stats_unregister(co); /* main coroutines are not listed */
+#endif
+    kc_cls_finish(co);
+    kcoro_stack_release(co);
+    kcoro_share_free(co);
+    free(co->fpu_ctx);
+    if (tls_current() == co) {
+        tls_set_current(NULL);
     }
-    if (main_kcoro == co) {
-        main_kcoro = NULL;
+    if (tls_main() == co) {
+        tls_set_main(NULL);
     }
-    free(co);
+    kcoro_dealloc(co);
 }
 
 static int kcoro_ref_debug_enabled(void)
@@ -165,14 +457,37 @@ void kcoro_set_name(kcoro_t* co, const char* name)
     }
 }
 
+int kcoro_set_fpu_preserve(kcoro_t* co, int on)
+{
+    if (!co) return -EINVAL;
+    int self = (co == tls_current());
+    if (!self && co->state != KCORO_CREATED) return -EBUSY;
+    if (!on) {
+        /* Running opted in: the thread's environment is the ambient one */
+        if (self && co->fpu) kcoro_fpu_load_control(&tls_fpu_ambient);
+        co->fpu = 0;
+        return 0;
+    }
+    if (co->fpu) return 0;
+    if (!co->fpu_ctx) {
+        co->fpu_ctx = (struct kcoro_fpu_ctx*)calloc(1, sizeof(*co->fpu_ctx));
+        if (!co->fpu_ctx) return -ENOMEM;
+    }
+    /* Self: what the switch out restores for the thread. Otherwise: the
+     * environment the coroutine starts with. */
+    kcoro_fpu_save(self ? &tls_fpu_ambient : co->fpu_ctx);
+    co->fpu = 1;
+    return 0;
+}
+
 kcoro_t* kcoro_current(void)
 {
-    return current_kcoro;
+    return tls_current();
 }
 
 kcoro_t* kcoro_thread_main(void)
 {
-    return main_kcoro;
+    return tls_main();
 }
 
 void kcoro_retain(kcoro_t* co)
@@ -199,9 +514,10 @@ void kcoro_release(kcoro_t* co)
 void kcoro_resume(kcoro_t* co)
 {
     if (!co || co->state == KCORO_FINISHED) return;
+    if (kcoro_stack_bind(co) != 0) return;
     
-    kcoro_t* yield_co = current_kcoro;
-    kcoro_t* from_co = yield_co ? yield_co : main_kcoro;
+    kcoro_t* yield_co = tls_current();
+    kcoro_t* from_co = yield_co ? yield_co : tls_main();
     if (!from_co) {
         from_co = co->main_co;
     }
@@ -211,24 +527,24 @@ void kcoro_resume(kcoro_t* co)
         yield_co->state = KCORO_SUSPENDED;
     }
     co->state = KCORO_RUNNING;
-    current_kcoro = co;
+    tls_set_current(co);
     
     /* Context switch */
-    kcoro_switch(from_co, co);
+    kcoro_switch_co(from_co, co);
 
     /* Returned from context switch - restore current */
-    current_kcoro = yield_co ? yield_co : main_kcoro;
+    tls_set_current(yield_co ? yield_co : tls_main());
     if (yield_co) {
         yield_co->state = KCORO_RUNNING;
-    } else if (main_kcoro) {
-        main_kcoro->state = KCORO_RUNNING;
+    } else if (tls_main()) {
+        tls_main()->state = KCORO_RUNNING;
     }
 }
 
 void kcoro_yield(void)
 {
-    kcoro_t* current = current_kcoro;
-    kcoro_t* main_co = main_kcoro ? main_kcoro : (current ? current->main_co : NULL);
+    kcoro_t* current = tls_current();
+    kcoro_t* main_co = tls_main() ? tls_main() : (current ? current->main_co : NULL);
     if (!current || !main_co) {
         /* No main coroutine to yield to - this might be in a different context */
         return;
@@ -237,56 +553,61 @@ void kcoro_yield(void)
     /* Update states */
     current->state = KCORO_SUSPENDED;
     main_co->state = KCORO_RUNNING;
-    current_kcoro = main_co;
+    tls_set_current(main_co);
     
     /* Context switch back to main */
-    kcoro_switch(current, main_co);
+    kcoro_switch_co(current, main_co);
     
     /* When resumed, we'll be back here */
     current->state = KCORO_RUNNING;
-    current_kcoro = current;
+    tls_set_current(current);
 }
 
 void kcoro_yield_to(kcoro_t* target_co)
 {
-    if (!target_co) return;
+    if (!target_co || kcoro_stack_bind(target_co) != 0) return;
     
-    kcoro_t* current = current_kcoro;
+    kcoro_t* current = tls_current();
     
     /* Update states */
     if (current) {
         current->state = KCORO_SUSPENDED;
     }
     target_co->state = KCORO_RUNNING;
-    current_kcoro = target_co;
+    tls_set_current(target_co);
     
     /* Context switch */
-    kcoro_switch(current, target_co);
+    kcoro_switch_co(current, target_co);
     
     /* When resumed, restore our state */
     if (current) {
         current->state = KCORO_RUNNING;
-        current_kcoro = current;
+        tls_set_current(current);
     }
 }
 
 /* Park current coroutine: transitions to KCORO_PARKED and switches to main */
 void kcoro_park(void)
 {
-    kcoro_t* current = current_kcoro;
-    kcoro_t* main_co = main_kcoro ? main_kcoro : (current ? current->main_co : NULL);
+    kcoro_t* current = tls_current();
+    kcoro_t* main_co = tls_main() ? tls_main() : (current ? current->main_co : NULL);
     if (!current || !main_co) return;
     if (current->state == KCORO_FINISHED) return;
+    KC_TRACE(KC_TRACE_PARK, current, 0);
+#if KCORO_CO_STATS
+    kcoro_stats_add(&current->parks, 1);
+    current->park_start_ns = KCORO_STATS_PARKING;
+#endif
     current->state = KCORO_PARKED;
     main_co->state = KCORO_RUNNING;
-    current_kcoro = main_co;
-    kcoro_switch(current, main_co);
+    tls_set_current(main_co);
+    kcoro_switch_co(current, main_co);
     /* When unparked & resumed, state will be set by kcoro_unpark before scheduling */
     if (current->state == KCORO_PARKED) {
         /* Defensive: if resumed without state change, mark running */
         current->state = KCORO_RUNNING;
     }
-    current_kcoro = current;
+    tls_set_current(current);
 }
 
 void kcoro_unpark(kcoro_t* co)
@@ -301,6 +622,9 @@ void kcoro_unpark(kcoro_t* co)
      * background thread concurrently resuming coroutines, leading to races and
      * duplicate consumption. */
     if (s) {
+        /* Back to the scheduler it last ran on; from another one's worker
+         * that is a remote wake, not a migration. */
+        if (co->scheduler) s = (kc_sched_t*)co->scheduler;
         /* Unified scheduler path: legacy and v2 merged, so enqueue is always work-stealing aware now. */
         kc_sched_enqueue_ready(s, co);
     }
@@ -314,25 +638,117 @@ int kcoro_is_parked(const kcoro_t* co)
 /* Internal coroutine trampoline function */
 static void kcoro_trampoline(void)
 {
-    kcoro_t* current = current_kcoro;
+    kcoro_settle();
+    kcoro_t* current = tls_current();
     assert(current && current->fn);
     
     /* Mark as running and call the function */
     current->state = KCORO_RUNNING;
     current->fn(current->arg);
+    /* Coroutine-local destructors still see this coroutine as current */
+    kc_cls_finish(current);
     
     /* Function completed - mark as finished */
     current->state = KCORO_FINISHED;
     
     /* Yield back to main coroutine */
-    if (main_kcoro) {
-        kcoro_t* main_co = main_kcoro;
+    if (tls_main()) {
+        kcoro_t* main_co = tls_main();
         main_co->state = KCORO_RUNNING;
-        current_kcoro = main_co;
-        kcoro_switch(current, main_co);
+        tls_set_current(main_co);
+        kcoro_switch_co(current, main_co);
         return;
     }
 
     /* Should never reach here, but if we do, call protector */
     kcoro_funcp_protector();
 }
+
+/* ---- Accounting API ---- */
+#if KCORO_CO_STATS
+static void kcoro_stats_fill(const kcoro_t* co, kcoro_stats_t* out, uint64_t now)
+{
+    uint64_t t0 = atomic_load_explicit(&co->run_start_ns, memory_order_relaxed);
+    out->id = co->id;
+    out->name = co->name;
+    out->state = co->state;
+    out->run_ns = atomic_load_explicit(&co->run_ns, memory_order_relaxed);
+    if (t0 && now > t0) out->run_ns += now - t0;
+    out->switches = atomic_load_explicit(&co->switches, memory_order_relaxed);
+    out->parks = atomic_load_explicit(&co->parks, memory_order_relaxed);
+    out->parked_ns = atomic_load_explicit(&co->parked_ns, memory_order_relaxed);
+}
+#endif
+
+int kcoro_stats(const kcoro_t* co, kcoro_stats_t* out)
+{
+#if KCORO_CO_STATS
+    if (!co || !out) return -EINVAL;
+    kcoro_stats_fill(co, out, kcoro_stats_now());
+    return 0;
+#else
+    (void)co; (void)out;
+    return -ENOTSUP;
+#endif
+}
+
+int kcoro_stats_top(kcoro_stats_t* out, size_t n)
+{
+#if KCORO_CO_STATS
+    if (!out && n) return -EINVAL;
+    pthread_once(&g_stats_once, kcoro_stats_reg_init);
+    uint64_t now = kcoro_stats_now();
+    size_t have = 0;
+    for (int i = 0; i < KCORO_STATS_STRIPES && n; i++) {
+        pthread_mutex_lock(&g_stats_reg[i].mu);
+        for (kcoro_t* co = g_stats_reg[i].head; co; co = co->stats_next) {
+            kcoro_stats_t st;
+            kcoro_stats_fill(co, &st, now);
+            if (have == n && st.run_ns <= out[n - 1].run_ns) continue;
+            /* Insertion into the sorted prefix; n is a screenful */
+            size_t j = have < n ? have++ : n - 1;
+            while (j > 0 && out[j - 1].run_ns < st.run_ns) { out[j] = out[j - 1]; j--; }
+            out[j] = st;
+        }
+        pthread_mutex_unlock(&g_stats_reg[i].mu);
+    }
+    return (int)have;
+#else
+    (void)out; (void)n;
+    return -ENOTSUP;
+#endif
+}
+
+static const char* kcoro_state_name(kcoro_state_t st)
+{
+    switch (st) {
+    case KCORO_CREATED: return "created";
+    case KCORO_READY: return "ready";
+    case KCORO_RUNNING: return "running";
+    case KCORO_SUSPENDED: return "suspended";
+    case KCORO_PARKED: return "parked";
+    case KCORO_FINISHED: return "finished";
+    }
+    return "?";
+}
+
+int kcoro_stats_dump_top(int fd, size_t n)
+{
+    if (n == 0) return 0;
+    kcoro_stats_t* top = (kcoro_stats_t*)malloc(n * sizeof(*top));
+    if (!top) return -ENOMEM;
+    int got = kcoro_stats_top(top, n);
+    if (got < 0) { free(top); return got; }
+    int rc = dprintf(fd, "%10s %-16s %-9s %12s %10s %8s %12s\n",
+                     "id", "name", "state", "run_ms", "switches", "parks", "parked_ms") < 0 ? -errno : 0;
+    for (int i = 0; i < got && rc == 0; i++) {
+        const kcoro_stats_t* t = &top[i];
+        if (dprintf(fd, "%10llu %-16.16s %-9s %12.3f %10llu %8llu %12.3f\n",
+                    (unsigned long long)t->id, t->name ? t->name : "-", kcoro_state_name(t->state),
+                    (double)t->run_ns / 1e6, (unsigned long long)t->switches,
+                    (unsigned long long)t->parks, (double)t->parked_ns / 1e6) < 0)
+            rc = -errno;
+    }
+    free(top);
+    return rc;
+}
@@ -0,0 +1,173 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE 1
+#endif
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "kcoro_config.h"
+#include "kcoro_share_internal.h"
+#include "kcoro_stack_internal.h"
+
+/* Load and unload copy live frames whole, redzones and all. Under
+ * AddressSanitizer the stack range is unpoisoned first, or memcpy reports
+ * the redzones of every frame it moves. */
+#if defined(__SANITIZE_ADDRESS__)
+#define KCORO_SHARE_ASAN 1
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define KCORO_SHARE_ASAN 1
+#endif
+#endif
+#ifdef KCORO_SHARE_ASAN
+#include <sanitizer/asan_interface.h>
+#define KCORO_SHARE_UNPOISON(p, n) ASAN_UNPOISON_MEMORY_REGION((p), (n))
+#else
+#define KCORO_SHARE_UNPOISON(p, n) ((void)(p), (void)(n))
+#endif
+
+struct kcoro_share_stack {
+    _Atomic(kcoro_t*) owner;   /* resident coroutine, NULL when free */
+    unsigned char *base;
+    size_t size;
+};
+
+static struct kcoro_share_stack g_stacks[KCORO_SHARED_STACKS];
+static pthread_once_t g_stacks_once = PTHREAD_ONCE_INIT;
+static int g_stacks_ok;
+static __thread unsigned tls_bind_cursor;
+
+static void kcoro_share_stacks_map(void)
+{
+    for (int i = 0; i < KCORO_SHARED_STACKS; ++i) {
+        size_t size = KCORO_SHARED_STACK_SIZE;
+        void *base = kcoro_stack_alloc(&size);
+        if (!base) return;
+        g_stacks[i].base = (unsigned char*)base;
+        g_stacks[i].size = size;
+    }
+    g_stacks_ok = 1;
+}
+
+static unsigned char *kcoro_share_top(const struct kcoro_share_stack *st)
+{
+    return st->base + st->size;
+}
+
+int kcoro_share_bounds(const kcoro_t *co, uintptr_t *lo, uintptr_t *hi)
+{
+    const struct kcoro_share_stack *st = co->share ? co->share->stack : NULL;
+    if (!st) return 0;
+    *lo = (uintptr_t)st->base;
+    *hi = (uintptr_t)kcoro_share_top(st);
+    return 1;
+}
+
+int kcoro_share_init(kcoro_t *co)
+{
+    pthread_once(&g_stacks_once, kcoro_share_stacks_map);
+    if (!g_stacks_ok) return -ENOMEM;
+    co->share = (struct kcoro_share*)calloc(1, sizeof(*co->share));
+    return co->share ? 0 : -ENOMEM;
+}
+
+/* First run: take any free stack, starting from a per-thread cursor so
+ * concurrent binders spread out, and seed the entry frame at its top. */
+static int kcoro_share_bind(kcoro_t *co)
+{
+    unsigned start = tls_bind_cursor;
+    for (unsigned i = 0; i < KCORO_SHARED_STACKS; ++i) {
+        struct kcoro_share_stack *st = &g_stacks[(start + i) % KCORO_SHARED_STACKS];
+        kcoro_t *expected = NULL;
+        if (atomic_load_explicit(&st->owner, memory_order_relaxed) != NULL ||
+            !atomic_compare_exchange_strong_explicit(&st->owner, &expected, co,
+                                                     memory_order_acquire, memory_order_relaxed))
+            continue;
+        tls_bind_cursor = start + i + 1;
+        co->share->stack = st;
+        kcoro_seed_stack(co, kcoro_share_top(st));
+        co->share->loaded = 1;
+        return 1;
+    }
+    return 0;
+}
+
+int kcoro_share_try_acquire(kcoro_t *co)
+{
+    struct kcoro_share *sh = co->share;
+    if (!sh) return 1;
+    if (!sh->stack) return kcoro_share_bind(co);
+    kcoro_t *expected = NULL;
+    if (atomic_compare_exchange_strong_explicit(&sh->stack->owner, &expected, co,
+                                                memory_order_acquire, memory_order_relaxed))
+        return 1;
+    return expected == co;
+}
+
+void kcoro_share_load(kcoro_t *co, kcoro_t *from)
+{
+    struct kcoro_share *sh = co->share;
+    if (from && from->share && from->share->stack && from->share->stack == sh->stack) {
+        fprintf(stderr, "kcoro: co=%p switches to co=%p on its own shared stack\n",
+                (void*)from, (void*)co);
+        abort();
+    }
+    for (unsigned spins = 0; !kcoro_share_try_acquire(co); ++spins) {
+        if (spins >= 64) sched_yield();
+    }
+    if (sh->loaded) return;
+    KCORO_SHARE_UNPOISON(kcoro_share_top(sh->stack) - sh->len, sh->len);
+    memcpy(kcoro_share_top(sh->stack) - sh->len, sh->buf, sh->len);
+    sh->loaded = 1;
+}
+
+void kcoro_share_unload(kcoro_t *co)
+{
+    struct kcoro_share *sh = co->share;
+    if (!sh || !sh->loaded) return;
+    struct kcoro_share_stack *st = sh->stack;
+    if (co->state == KCORO_FINISHED) {
+        free(sh->buf);
+        sh->buf = NULL;
+        sh->len = sh->cap = 0;
+    } else {
+        unsigned char *sp = (unsigned char*)co->reg[14];
+        size_t len = (size_t)(kcoro_share_top(st) - sp);
+        if (len > sh->cap) {
+            size_t cap = sh->cap ? sh->cap : 256;
+            while (cap < len) cap *= 2;
+            unsigned char *buf = (unsigned char*)realloc(sh->buf, cap);
+            /* No memory: stay resident; coroutines bound here wait for it. */
+            if (!buf) return;
+            sh->buf = buf;
+            sh->cap = cap;
+        }
+        KCORO_SHARE_UNPOISON(sp, len);
+        memcpy(sh->buf, sp, len);
+        sh->len = len;
+    }
+    sh->loaded = 0;
+    atomic_store_explicit(&st->owner, NULL, memory_order_release);
+}
+
+void kcoro_share_free(kcoro_t *co)
+{
+    struct kcoro_share *sh = co->share;
+    if (!sh) return;
+    if (sh->stack) {
+        kcoro_t *expected = co;
+        atomic_compare_exchange_strong_explicit(&sh->stack->owner, &expected, NULL,
+                                                memory_order_release, memory_order_relaxed);
+    }
+    free(sh->buf);
+    free(sh);
+    co->share = NULL;
+}
@@ -0,0 +1,83 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../include/kcoro_core.h"
+
+/* Shared-stack (copy-on-switch) coroutines. Internal to kcoro_core.c /
+ * kcoro_share.c / kc_sched.c, bar the park-record helpers at the end,
+ * which every module that parks uses; selected with KCORO_STACK_SHARED.
+ *
+ * - A shared coroutine has no stack of its own. Its frames hold absolute
+ *   addresses, so on first run it binds for life to one of
+ *   KCORO_SHARED_STACKS process-wide stacks (the first free one), not to a
+ *   worker: work stealing may resume it anywhere.
+ * - A stack has at most one resident coroutine (`owner`). kcoro_share_load()
+ *   claims it and copies the coroutine's saved bytes back in right before the
+ *   switch; once the coroutine has switched out, kcoro_share_unload() copies
+ *   [saved SP, top) into its save buffer and frees the stack, so an idle
+ *   shared coroutine costs only the bytes it had in use.
+ * - Unload runs on the thread that resumed the coroutine, before the
+ *   scheduler drops running_flag, so a coroutine is never loaded on one
+ *   worker while still being saved on another.
+ * - A shared coroutine cannot switch directly to another one bound to the
+ *   same stack (that would overwrite the running frames); resume goes
+ *   through a context on some other stack, as scheduler workers do. */
+
+struct kcoro_share_stack;
+
+struct kcoro_share {
+    struct kcoro_share_stack *stack; /* bound on first run */
+    unsigned char *buf;              /* saved bytes while switched out */
+    size_t len, cap;
+    int loaded;                      /* bytes are on the stack, not in buf */
+};
+
+/* Seed the entry SP/FP of co below `top` (kcoro_core.c). */
+void kcoro_seed_stack(kcoro_t *co, void *top);
+
+/* Attach an (unbound) shared-stack context to a fresh coroutine. 0 or -ENOMEM. */
+int kcoro_share_init(kcoro_t *co);
+
+/* Claim co's shared stack (binding one on first run). 1 when co can be
+ * switched to now, 0 when another coroutine is resident there. */
+int kcoro_share_try_acquire(kcoro_t *co);
+
+/* Claim (waiting if needed) and fill co's stack; called by `from`, which is
+ * about to switch to co. */
+void kcoro_share_load(kcoro_t *co, kcoro_t *from);
+
+/* co has switched out: save its live bytes and release the stack. A finished
+ * coroutine only releases. */
+void kcoro_share_unload(kcoro_t *co);
+
+/* Drop the context (and a stack still held by co). */
+void kcoro_share_free(kcoro_t *co);
+
+/* Usable [lo, hi) of co's shared stack; 0 until one is bound. Plain loads,
+ * safe from a signal handler (kc_prof.c). */
+int kcoro_share_bounds(const kcoro_t *co, uintptr_t *lo, uintptr_t *hi);
+
+/* Park records. While a shared-stack coroutine is parked its frames sit in
+ * its save buffer and the stack holds whoever runs there next, so a record
+ * that a park hook, a waker or a timer reads or writes after the switch-out
+ * cannot live on it. kcoro_park_record() returns `local`, the caller's
+ * filled-in stack record, for a coroutine with a stack of its own (or no
+ * coroutine), else a heap copy of it, NULL when out of memory;
+ * kcoro_park_record_free() releases what it returned. */
+static inline void *kcoro_park_record(const kcoro_t *co, void *local, size_t size)
+{
+    if (!co || !co->share) return local;
+    void *rec = malloc(size);
+    if (rec) memcpy(rec, local, size);
+    return rec;
+}
+
+static inline void kcoro_park_record_free(void *rec, void *local)
+{
+    if (rec != local) free(rec);
+}
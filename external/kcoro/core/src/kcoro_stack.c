@@ -0,0 +1,559 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE 1
+#endif
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#ifndef MAP_ANON
+#define MAP_ANON 0x1000
+#endif
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+/* Reservations are committed page by page on first touch: keep them out of
+ * overcommit accounting and (Linux) away from transparent huge pages. */
+#ifndef MAP_NORESERVE
+#define MAP_NORESERVE 0
+#endif
+#ifndef MAP_STACK
+#define MAP_STACK 0
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <dlfcn.h>
+
+#include "kcoro_config.h"
+#include "kc_mem.h"
+#include "kcoro_stack_internal.h"
+#include "kc_region_internal.h"
+
+/* Release advice for pooled stacks: Darwin only reclaims on MADV_FREE. */
+#if defined(__APPLE__) && defined(MADV_FREE)
+#define KCORO_STACK_MADV MADV_FREE
+#else
+#define KCORO_STACK_MADV MADV_DONTNEED
+#endif
+
+#define KCORO_STACK_CLASSES 10 /* CLASS_MIN << 0 .. CLASS_MIN << 9 */
+
+/* Free-list link, stored in the (still resident) top page of a free stack. */
+struct kcoro_stack_node {
+    struct kcoro_stack_node *next;
+};
+
+struct kcoro_stack_cache {
+    struct kcoro_stack_node *head[KCORO_STACK_CLASSES];
+    unsigned count[KCORO_STACK_CLASSES];
+    /* counters folded into the globals when the cache meets the depot */
+    unsigned long reused, mapped, unmapped;
+    int registered;
+};
+
+static __thread struct kcoro_stack_cache tls_stack_cache;
+static pthread_key_t stack_cache_key;
+static pthread_once_t stack_cache_once = PTHREAD_ONCE_INIT;
+
+static struct {
+    pthread_mutex_t mu;
+    struct kcoro_stack_node *head[KCORO_STACK_CLASSES];
+    unsigned count[KCORO_STACK_CLASSES];
+} g_depot = { .mu = PTHREAD_MUTEX_INITIALIZER };
+
+static _Atomic unsigned g_limit_thread = KCORO_STACK_CACHE_PER_THREAD;
+static _Atomic unsigned g_limit_depot = KCORO_STACK_DEPOT_MAX;
+static _Atomic unsigned long g_reused, g_mapped, g_unmapped;
+static _Atomic size_t g_default_size = KCORO_STACK_DEFAULT_SIZE;
+static _Atomic unsigned g_hints; /* KC_REGION_F_* for new mappings */
+static _Atomic int g_track_hwm;
+static _Atomic size_t g_hwm_max;
+static _Atomic unsigned long g_hwm_samples;
+static _Atomic uint64_t g_hwm_sum;
+
+/* Per-spawn-site sizing (kcoro_stack_autotune): an open-addressed table
+ * keyed by entry function. Slots are claimed with one CAS on fn and never
+ * freed; a full table leaves further sites on the default size. */
+struct kcoro_stack_site_slot {
+    _Atomic(uintptr_t) fn;
+    _Atomic size_t peak;             /* deepest high-water mark seen */
+    _Atomic size_t size;             /* tuned stack size, 0 until enough samples */
+    _Atomic unsigned long samples;
+    _Atomic unsigned long anomalies;
+};
+static struct kcoro_stack_site_slot g_sites[KCORO_STACK_TUNE_SITES];
+static _Atomic int g_tune;
+static _Atomic unsigned long g_tune_anomalies;
+
+static size_t kcoro_page_size(void)
+{
+    static size_t cached;
+    if (!cached) {
+        long ps = sysconf(_SC_PAGESIZE);
+        cached = ps > 0 ? (size_t)ps : 4096;
+    }
+    return cached;
+}
+
+/* Bytes of PROT_NONE mapping below every stack. */
+static size_t kcoro_stack_guard(void)
+{
+    return (size_t)KCORO_STACK_GUARD_PAGES * kcoro_page_size();
+}
+
+static size_t kcoro_stack_class_size(int cls)
+{
+    size_t sz = (size_t)KCORO_STACK_CLASS_MIN << cls;
+    size_t ps = kcoro_page_size();
+    return (sz + ps - 1) & ~(ps - 1);
+}
+
+/* Smallest class holding `size`, or -1 when it is too large to pool. */
+static int kcoro_stack_class(size_t size)
+{
+    for (int c = 0; c < KCORO_STACK_CLASSES; ++c)
+        if (size <= kcoro_stack_class_size(c)) return c;
+    return -1;
+}
+
+static struct kcoro_stack_node *kcoro_stack_node(void *base, size_t size)
+{
+    return (struct kcoro_stack_node*)(void*)((unsigned char*)base + size - sizeof(struct kcoro_stack_node));
+}
+
+static void *kcoro_stack_base(struct kcoro_stack_node *n, size_t size)
+{
+    return (unsigned char*)(void*)n + sizeof(*n) - size;
+}
+
+static void kcoro_stack_unmap(void *base, size_t size)
+{
+    size_t guard = kcoro_stack_guard();
+    munmap((unsigned char*)base - guard, size + guard);
+    kc_mem_uncharge(KC_MEM_STACKS, size);
+}
+
+static void kcoro_stack_fold_counters(struct kcoro_stack_cache *c)
+{
+    if (c->reused) atomic_fetch_add_explicit(&g_reused, c->reused, memory_order_relaxed);
+    if (c->mapped) atomic_fetch_add_explicit(&g_mapped, c->mapped, memory_order_relaxed);
+    if (c->unmapped) atomic_fetch_add_explicit(&g_unmapped, c->unmapped, memory_order_relaxed);
+    c->reused = c->mapped = c->unmapped = 0;
+}
+
+/* Move `n` stacks of class `cls` from the thread cache to the depot; what the
+ * depot cannot hold is unmapped. */
+static void kcoro_stack_spill(struct kcoro_stack_cache *c, int cls, unsigned n)
+{
+    size_t size = kcoro_stack_class_size(cls);
+    unsigned limit = atomic_load_explicit(&g_limit_depot, memory_order_relaxed);
+    struct kcoro_stack_node *drop = NULL;
+    pthread_mutex_lock(&g_depot.mu);
+    while (n-- && c->head[cls]) {
+        struct kcoro_stack_node *s = c->head[cls];
+        c->head[cls] = s->next;
+        c->count[cls]--;
+        if (g_depot.count[cls] < limit) {
+            s->next = g_depot.head[cls];
+            g_depot.head[cls] = s;
+            g_depot.count[cls]++;
+        } else {
+            s->next = drop;
+            drop = s;
+        }
+    }
+    pthread_mutex_unlock(&g_depot.mu);
+    while (drop) {
+        struct kcoro_stack_node *next = drop->next;
+        kcoro_stack_unmap(kcoro_stack_base(drop, size), size);
+        c->unmapped++;
+        drop = next;
+    }
+    kcoro_stack_fold_counters(c);
+}
+
+/* Pull up to `n` stacks of class `cls` from the depot into the thread cache. */
+static void kcoro_stack_refill(struct kcoro_stack_cache *c, int cls, unsigned n)
+{
+    pthread_mutex_lock(&g_depot.mu);
+    while (n-- && g_depot.head[cls]) {
+        struct kcoro_stack_node *s = g_depot.head[cls];
+        g_depot.head[cls] = s->next;
+        g_depot.count[cls]--;
+        s->next = c->head[cls];
+        c->head[cls] = s;
+        c->count[cls]++;
+    }
+    pthread_mutex_unlock(&g_depot.mu);
+    kcoro_stack_fold_counters(c);
+}
+
+static void kcoro_stack_cache_drain(void *arg)
+{
+    struct kcoro_stack_cache *c = (struct kcoro_stack_cache*)arg;
+    for (int cls = 0; cls < KCORO_STACK_CLASSES; ++cls)
+        kcoro_stack_spill(c, cls, c->count[cls]);
+}
+
+static void kcoro_stack_cache_key_init(void)
+{
+    (void)pthread_key_create(&stack_cache_key, kcoro_stack_cache_drain);
+}
+
+/* A thread's cache goes to the depot when the thread exits. */
+static void kcoro_stack_cache_register(struct kcoro_stack_cache *c)
+{
+    if (c->registered) return;
+    pthread_once(&stack_cache_once, kcoro_stack_cache_key_init);
+    (void)pthread_setspecific(stack_cache_key, c);
+    c->registered = 1;
+}
+
+/* Reserve guard + size bytes; only the usable part above the guard is
+ * accessible, and none of it is backed by memory until touched. With the
+ * huge page hint a stack of at least one huge page starts on a huge page
+ * boundary, so whole huge pages can back it. */
+static void *kcoro_stack_map(size_t size)
+{
+    if (kc_mem_charge(KC_MEM_STACKS, size) != 0) { errno = ENOMEM; return NULL; }
+    size_t guard = kcoro_stack_guard();
+    unsigned hints = atomic_load_explicit(&g_hints, memory_order_relaxed);
+    size_t h = (hints & KC_REGION_F_HUGEPAGE) && size >= KCORO_HUGEPAGE_SIZE ? KCORO_HUGEPAGE_SIZE : 0;
+    size_t span = size + guard + h;
+    unsigned char *mem = (unsigned char*)mmap(NULL, span, PROT_READ | PROT_WRITE,
+                                              MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0);
+    if (mem == MAP_FAILED) { kc_mem_uncharge(KC_MEM_STACKS, size); return NULL; }
+    unsigned char *base = mem + guard;
+    if (h) {
+        unsigned char *want = (unsigned char*)(((uintptr_t)base + h - 1) & ~(uintptr_t)(h - 1));
+        if (want > base) munmap(mem, (size_t)(want - base));
+        if (mem + span > want + size) munmap(want + size, (size_t)(mem + span - (want + size)));
+        base = want;
+        mem = want - guard;
+    }
+    if (guard && mprotect(mem, guard, PROT_NONE) != 0) {
+        munmap(mem, size + guard);
+        kc_mem_uncharge(KC_MEM_STACKS, size);
+        return NULL;
+    }
+    if (hints) (void)kc_mem_hint(base, size, hints, 0);
+    return base;
+}
+
+/* Distance from the top of the stack to its lowest resident page: the
+ * deepest the stack has been since it was mapped or last recycled (pooled
+ * stacks are released down to their top page). 0 if it cannot be read. */
+static size_t kcoro_stack_depth(void *base, size_t size)
+{
+    size_t ps = kcoro_page_size();
+    size_t pages = size / ps;
+    unsigned char vec[256];
+    for (size_t first = 0; first < pages; first += sizeof(vec)) {
+        size_t n = pages - first < sizeof(vec) ? pages - first : sizeof(vec);
+        unsigned char *addr = (unsigned char*)base + first * ps;
+        if (mincore(addr, n * ps, (void*)vec) != 0) return 0;
+        for (size_t i = 0; i < n; ++i)
+            if (vec[i] & 1) return size - (first + i) * ps;
+    }
+    return 0;
+}
+
+void *kcoro_stack_alloc(size_t *size)
+{
+    size_t ps = kcoro_page_size();
+    size_t want = (*size + ps - 1) & ~(ps - 1);
+    struct kcoro_stack_cache *c = &tls_stack_cache;
+    int cls = atomic_load_explicit(&g_limit_thread, memory_order_relaxed) ? kcoro_stack_class(want) : -1;
+    if (cls < 0) {
+        void *mem = kcoro_stack_map(want);
+        if (mem) { c->mapped++; *size = want; }
+        return mem;
+    }
+    size_t csize = kcoro_stack_class_size(cls);
+    if (!c->head[cls]) {
+        unsigned limit = atomic_load_explicit(&g_limit_thread, memory_order_relaxed);
+        kcoro_stack_refill(c, cls, limit > 1 ? limit / 2 : 1);
+    }
+    struct kcoro_stack_node *s = c->head[cls];
+    if (s) {
+        c->head[cls] = s->next;
+        c->count[cls]--;
+        c->reused++;
+        *size = csize;
+        return kcoro_stack_base(s, csize);
+    }
+    void *mem = kcoro_stack_map(csize);
+    if (mem) { c->mapped++; *size = csize; }
+    return mem;
+}
+
+void kcoro_stack_free(void *base, size_t size)
+{
+    if (!base) return;
+    struct kcoro_stack_cache *c = &tls_stack_cache;
+    unsigned limit = atomic_load_explicit(&g_limit_thread, memory_order_relaxed);
+    int cls = kcoro_stack_class(size);
+    if (!limit || cls < 0 || kcoro_stack_class_size(cls) != size) {
+        kcoro_stack_unmap(base, size);
+        c->unmapped++;
+        return;
+    }
+    kcoro_stack_cache_register(c);
+    size_t ps = kcoro_page_size();
+    /* Releasing pages would split the huge pages the hint asked for. */
+    if (size > ps && !(atomic_load_explicit(&g_hints, memory_order_relaxed) & KC_REGION_F_HUGEPAGE))
+        (void)madvise(base, size - ps, KCORO_STACK_MADV);
+    struct kcoro_stack_node *s = kcoro_stack_node(base, size);
+    s->next = c->head[cls];
+    c->head[cls] = s;
+    if (++c->count[cls] > limit)
+        kcoro_stack_spill(c, cls, c->count[cls] - limit / 2);
+}
+
+size_t kcoro_stack_default_size(void)
+{
+    return atomic_load_explicit(&g_default_size, memory_order_relaxed);
+}
+
+static void kcoro_stack_atomic_max(_Atomic size_t *v, size_t x)
+{
+    size_t cur = atomic_load_explicit(v, memory_order_relaxed);
+    while (x > cur &&
+           !atomic_compare_exchange_weak_explicit(v, &cur, x, memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+/* Site slot of fn; claimed when absent and `claim` is set. NULL when the
+ * table is full (or fn unknown and not claimed). */
+static struct kcoro_stack_site_slot *kcoro_stack_site(kcoro_fn_t fn, int claim)
+{
+    uintptr_t key = (uintptr_t)fn;
+    size_t h = (size_t)((key >> 4) * 0x9e3779b97f4a7c15ull);
+    for (size_t i = 0; i < KCORO_STACK_TUNE_SITES; ++i) {
+        struct kcoro_stack_site_slot *s = &g_sites[(h + i) % KCORO_STACK_TUNE_SITES];
+        uintptr_t cur = atomic_load_explicit(&s->fn, memory_order_acquire);
+        if (cur == key) return s;
+        if (cur) continue;
+        if (!claim) return NULL;
+        if (atomic_compare_exchange_strong_explicit(&s->fn, &cur, key, memory_order_acq_rel, memory_order_acquire) ||
+            cur == key)
+            return s;
+    }
+    return NULL;
+}
+
+/* Smallest pooled class holding hwm plus its headroom (at least a page);
+ * 0 when that is too large to pool. */
+static size_t kcoro_stack_fit(size_t hwm)
+{
+    size_t room = hwm / 100 * KCORO_STACK_TUNE_HEADROOM;
+    if (room < kcoro_page_size()) room = kcoro_page_size();
+    int cls = kcoro_stack_class(hwm + room);
+    return cls < 0 ? 0 : kcoro_stack_class_size(cls);
+}
+
+/* A released stack of a site reached hwm. Once the site has enough
+ * samples it gets a size; a later sample that does not fit that size with
+ * its headroom is an anomaly and grows it. */
+static void kcoro_stack_site_record(kcoro_fn_t fn, size_t hwm)
+{
+    struct kcoro_stack_site_slot *s = kcoro_stack_site(fn, 1);
+    if (!s) return;
+    kcoro_stack_atomic_max(&s->peak, hwm);
+    unsigned long n = atomic_fetch_add_explicit(&s->samples, 1, memory_order_relaxed) + 1;
+    size_t size = atomic_load_explicit(&s->size, memory_order_relaxed);
+    size_t fit = kcoro_stack_fit(hwm);
+    if (size) {
+        if (fit && fit <= size) return;
+        if (atomic_fetch_add_explicit(&s->anomalies, 1, memory_order_relaxed) == 0) {
+            Dl_info di;
+            const char *name = dladdr((void*)(uintptr_t)fn, &di) && di.dli_sname ? di.dli_sname : "?";
+            fprintf(stderr, "kcoro: stack: spawn site %p (%s) used %zu bytes, past the headroom of its %zu-byte tuned stack\n",
+                    (void*)(uintptr_t)fn, name, hwm, size);
+        }
+        atomic_fetch_add_explicit(&g_tune_anomalies, 1, memory_order_relaxed);
+        /* Too deep to pool: fall back to the default size. */
+        if (!fit) { atomic_store_explicit(&s->size, 0, memory_order_relaxed); return; }
+        kcoro_stack_atomic_max(&s->size, fit);
+        return;
+    }
+    if (n >= KCORO_STACK_TUNE_SAMPLES) {
+        size_t tuned = kcoro_stack_fit(atomic_load_explicit(&s->peak, memory_order_relaxed));
+        if (tuned) kcoro_stack_atomic_max(&s->size, tuned);
+    }
+}
+
+size_t kcoro_stack_tuned_size(kcoro_fn_t fn)
+{
+    if (atomic_load_explicit(&g_tune, memory_order_relaxed)) {
+        struct kcoro_stack_site_slot *s = kcoro_stack_site(fn, 0);
+        size_t size = s ? atomic_load_explicit(&s->size, memory_order_relaxed) : 0;
+        if (size) return size;
+    }
+    return kcoro_stack_default_size();
+}
+
+void kcoro_stack_release(kcoro_t *co)
+{
+    if (!co || !co->stack_ptr) return;
+    int track = atomic_load_explicit(&g_track_hwm, memory_order_relaxed);
+    /* Stacks under the huge page hint stay resident, so their depth says nothing. */
+    int tune = co->fn && atomic_load_explicit(&g_tune, memory_order_relaxed) &&
+               !(atomic_load_explicit(&g_hints, memory_order_relaxed) & KC_REGION_F_HUGEPAGE);
+    if (track || tune) {
+        size_t hwm = kcoro_stack_depth(co->stack_ptr, co->stack_size);
+        co->stack_hwm = hwm;
+        if (track) {
+            kcoro_stack_atomic_max(&g_hwm_max, hwm);
+            atomic_fetch_add_explicit(&g_hwm_samples, 1, memory_order_relaxed);
+            atomic_fetch_add_explicit(&g_hwm_sum, hwm, memory_order_relaxed);
+        }
+        if (tune && hwm) kcoro_stack_site_record(co->fn, hwm);
+    }
+    kcoro_stack_free(co->stack_ptr, co->stack_size);
+    co->stack_ptr = NULL;
+    co->stack_size = 0;
+}
+
+void kcoro_stack_reclaim(kcoro_t *co)
+{
+    if (!co || co->state != KCORO_FINISHED) return;
+    kcoro_stack_release(co);
+}
+
+void kcoro_stack_set_default_size(size_t bytes)
+{
+    atomic_store_explicit(&g_default_size, bytes ? bytes : (size_t)KCORO_STACK_DEFAULT_SIZE,
+                          memory_order_relaxed);
+}
+
+void kcoro_stack_track_high_water(int on)
+{
+    atomic_store_explicit(&g_track_hwm, on != 0, memory_order_relaxed);
+}
+
+void kcoro_stack_autotune(int on)
+{
+    atomic_store_explicit(&g_tune, on != 0, memory_order_relaxed);
+}
+
+size_t kcoro_stack_sites(struct kcoro_stack_site *out, size_t n)
+{
+    size_t k = 0;
+    for (size_t i = 0; i < KCORO_STACK_TUNE_SITES; ++i) {
+        struct kcoro_stack_site_slot *s = &g_sites[i];
+        uintptr_t fn = atomic_load_explicit(&s->fn, memory_order_acquire);
+        if (!fn) continue;
+        if (k < n && out) {
+            out[k].fn = (kcoro_fn_t)fn;
+            out[k].peak = atomic_load_explicit(&s->peak, memory_order_relaxed);
+            out[k].size = atomic_load_explicit(&s->size, memory_order_relaxed);
+            out[k].samples = atomic_load_explicit(&s->samples, memory_order_relaxed);
+            out[k].anomalies = atomic_load_explicit(&s->anomalies, memory_order_relaxed);
+        }
+        k++;
+    }
+    return k;
+}
+
+size_t kcoro_stack_high_water(const kcoro_t *co)
+{
+    if (!co) return 0;
+    if (!co->stack_ptr) return co->stack_hwm;
+    return kcoro_stack_depth(co->stack_ptr, co->stack_size);
+}
+
+void kcoro_stack_pool_set_limits(unsigned per_thread, unsigned depot)
+{
+    atomic_store_explicit(&g_limit_thread, per_thread, memory_order_relaxed);
+    atomic_store_explicit(&g_limit_depot, depot, memory_order_relaxed);
+}
+
+void kcoro_stack_pool_set_hints(unsigned region_flags)
+{
+    atomic_store_explicit(&g_hints, region_flags, memory_order_relaxed);
+}
+
+unsigned kcoro_stack_pool_prefill(size_t size, unsigned n)
+{
+    size_t ps = kcoro_page_size();
+    if (!size) size = kcoro_stack_default_size();
+    unsigned limit = atomic_load_explicit(&g_limit_thread, memory_order_relaxed);
+    int cls = limit ? kcoro_stack_class((size + ps - 1) & ~(ps - 1)) : -1;
+    if (cls < 0) return 0;
+    struct kcoro_stack_cache *c = &tls_stack_cache;
+    size_t csize = kcoro_stack_class_size(cls);
+    kcoro_stack_cache_register(c);
+    unsigned added = 0;
+    while (added < n && c->count[cls] < limit) {
+        unsigned char *base = (unsigned char*)kcoro_stack_map(csize);
+        if (!base) break;
+        c->mapped++;
+        /* Resident until the stack's first release, which trims it as usual. */
+        for (size_t off = 0; off < csize; off += ps) base[off] = 0;
+        struct kcoro_stack_node *s = kcoro_stack_node(base, csize);
+        s->next = c->head[cls];
+        c->head[cls] = s;
+        c->count[cls]++;
+        added++;
+    }
+    return added;
+}
+
+void kcoro_stack_pool_trim(void)
+{
+    struct kcoro_stack_cache *c = &tls_stack_cache;
+    for (int cls = 0; cls < KCORO_STACK_CLASSES; ++cls) {
+        size_t size = kcoro_stack_class_size(cls);
+        while (c->head[cls]) {
+            struct kcoro_stack_node *s = c->head[cls];
+            c->head[cls] = s->next;
+            c->count[cls]--;
+            kcoro_stack_unmap(kcoro_stack_base(s, size), size);
+            c->unmapped++;
+        }
+        pthread_mutex_lock(&g_depot.mu);
+        struct kcoro_stack_node *s = g_depot.head[cls];
+        g_depot.head[cls] = NULL;
+        g_depot.count[cls] = 0;
+        pthread_mutex_unlock(&g_depot.mu);
+        while (s) {
+            struct kcoro_stack_node *next = s->next;
+            kcoro_stack_unmap(kcoro_stack_base(s, size), size);
+            c->unmapped++;
+            s = next;
+        }
+    }
+    kcoro_stack_fold_counters(c);
+}
+
+void kcoro_stack_pool_get_stats(struct kcoro_stack_pool_stats *out)
+{
+    if (!out) return;
+    struct kcoro_stack_cache *c = &tls_stack_cache;
+    kcoro_stack_fold_counters(c);
+    memset(out, 0, sizeof(*out));
+    out->reused = atomic_load_explicit(&g_reused, memory_order_relaxed);
+    out->mapped = atomic_load_explicit(&g_mapped, memory_order_relaxed);
+    out->unmapped = atomic_load_explicit(&g_unmapped, memory_order_relaxed);
+    pthread_mutex_lock(&g_depot.mu);
+    for (int cls = 0; cls < KCORO_STACK_CLASSES; ++cls) {
+        out->depot_stacks += g_depot.count[cls];
+        out->depot_bytes += g_depot.count[cls] * kcoro_stack_class_size(cls);
+    }
+    pthread_mutex_unlock(&g_depot.mu);
+    for (int cls = 0; cls < KCORO_STACK_CLASSES; ++cls)
+        out->thread_stacks += c->count[cls];
+    out->high_water_max = atomic_load_explicit(&g_hwm_max, memory_order_relaxed);
+    out->high_water_samples = atomic_load_explicit(&g_hwm_samples, memory_order_relaxed);
+    out->high_water_sum = atomic_load_explicit(&g_hwm_sum, memory_order_relaxed);
+    for (size_t i = 0; i < KCORO_STACK_TUNE_SITES; ++i)
+        if (atomic_load_explicit(&g_sites[i].size, memory_order_relaxed)) out->tuned_sites++;
+    out->tune_anomalies = atomic_load_explicit(&g_tune_anomalies, memory_order_relaxed);
+}
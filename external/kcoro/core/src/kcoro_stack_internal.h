@@ -0,0 +1,54 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <stddef.h>
+
+#include "../../include/kcoro_core.h"
+
+/* Coroutine stack pool. Internal to kcoro_core.c / kcoro_stack.c; the public
+ * knobs and counters are declared in kcoro_core.h.
+ *
+ * - Sizes are rounded up to a power-of-two size class (KCORO_STACK_CLASS_MIN
+ *   << n); larger requests bypass the pool and are mapped/unmapped directly.
+ * - Each thread keeps up to `per_thread` free stacks per class. Past that
+ *   mark half of them move to a mutex-protected global depot (bounded by
+ *   `depot` per class), and an empty thread cache refills from the depot in
+ *   one batch, so stacks freed on one worker are reused by another.
+ * - A stack returned to the pool has every page but the topmost released
+ *   with madvise, so cached stacks cost one resident page each. The free-list
+ *   link lives in that top page.
+ * - Every stack sits above KCORO_STACK_GUARD_PAGES of PROT_NONE and is mapped
+ *   MAP_NORESERVE, so an overflow faults instead of corrupting a neighbour
+ *   and a large reservation (kcoro_stack_set_default_size) only costs the
+ *   pages actually touched. High-water marks are read back with mincore.
+ * - Under kcoro_stack_autotune each release also feeds the high-water mark
+ *   to its spawn site (entry function), and default-size requests of a
+ *   site with enough samples get the smallest class that fits its peak
+ *   plus KCORO_STACK_TUNE_HEADROOM. */
+
+/* Map (or reuse) a stack of at least *size bytes; *size is updated to the
+ * usable size actually provided. Returns NULL when mapping fails. */
+void *kcoro_stack_alloc(size_t *size);
+
+/* Return a stack obtained from kcoro_stack_alloc() with the size it reported. */
+void kcoro_stack_free(void *base, size_t size);
+
+/* Default size for kcoro_create(..., 0). */
+size_t kcoro_stack_default_size(void);
+
+/* Size for a default-size stack of a coroutine entering at fn: the site's
+ * tuned size under kcoro_stack_autotune, else the default. */
+size_t kcoro_stack_tuned_size(kcoro_fn_t fn);
+
+/* Return co's stack to the pool (recording its high-water mark when
+ * tracking is on) and clear stack_ptr. Used by kcoro_free(). */
+void kcoro_stack_release(kcoro_t *co);
+
+/* Give a KCORO_STACK_LAZY coroutine its stack before its first switch-in
+ * (no-op for any other coroutine). 0, or -ENOMEM with co left unstarted. */
+int kcoro_stack_bind(kcoro_t *co);
+
+/* Hand a finished coroutine's stack back to the pool ahead of kcoro_free(),
+ * which may be much later when handles keep the coroutine alive. The caller
+ * must own the coroutine's execution (nothing can resume it concurrently). */
+void kcoro_stack_reclaim(kcoro_t *co);
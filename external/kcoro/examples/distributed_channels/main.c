@@ -6,7 +6,7 @@
  * - channel.send() / channel.receive() 
  * - channel.trySend() / channel.tryReceive()
  * - Different channel types (RENDEZVOUS, BUFFERED, CONFLATED, UNLIMITED)
- * - Cross-process communication via IPC
+ * - Cross-process communication via IPC (Unix socket, or TCP with --tcp)
  */
 #define _POSIX_C_SOURCE 200112L
 #include <stdio.h>
@@ -16,9 +16,11 @@
 #include <string.h>
 #include <signal.h>
 #include <stdarg.h>
+#include <errno.h>
 
 #include "kcoro.h"
 #include "kcoro_port.h"
+#include "kcoro_sched.h"
 #include "kcoro_proto.h"
 #include "kcoro_ipc_posix.h"
 #include "kcoro_ipc_chan.h"
@@ -52,6 +54,13 @@ static void enable_debug(void)
 /* Producer - sends messages to channel (like Kotlin producer coroutine) */
 static const char *KC_SOCK = "/tmp/kcoro_example.sock";
 static const char *KC_CHAN_FILE = "/tmp/kcoro_example.chan";
+static const char *g_tcp_port = NULL; /* --tcp PORT: loopback TCP instead */
+
+static int example_connect(kc_ipc_conn_t **conn)
+{
+    if (g_tcp_port) return kc_ipc_connect_tcp("127.0.0.1", g_tcp_port, conn);
+    return kc_ipc_connect(KC_SOCK, conn);
+}
 
 static int write_chan_info(uint32_t id, int kind, size_t elem_sz)
 {
@@ -81,7 +90,7 @@ static int producer_process(void)
     
     /* Connect to kcoro server */
     kc_ipc_conn_t *conn = NULL;
-    if (kc_ipc_connect(KC_SOCK, &conn) != 0) {
+    if (example_connect(&conn) != 0) {
         perror("connect");
         return 1;
     }
@@ -161,7 +170,7 @@ static int consumer_process(void)
     
     /* Connect to same kcoro server */
     kc_ipc_conn_t *conn = NULL;
-    if (kc_ipc_connect(KC_SOCK, &conn) != 0) {
+    if (example_connect(&conn) != 0) {
         perror("connect");
         return 1;
     }
@@ -258,86 +267,38 @@ static int consumer_process(void)
     return 0;
 }
 
-/* Simple server that handles channel operations */
-/* Simple threaded server that handles channel operations */
-struct worker_arg { kc_ipc_server_ctx_t *ctx; kc_ipc_conn_t *conn; };
-
-static void *server_worker(void *arg)
-{
-    struct worker_arg *wa = (struct worker_arg*)arg;
-    kc_ipc_conn_t *conn = wa->conn; kc_ipc_server_ctx_t *ctx = wa->ctx;
-    free(wa);
-    uint32_t maj=0,min=0;
-    (void)kc_ipc_hs_srv(conn, &maj, &min); /* best effort */
-    for (;;) {
-        uint16_t cmd=0; uint8_t *pl=NULL; size_t len=0;
-        int rc = kc_ipc_recv(conn, &cmd, &pl, &len);
-        if (rc != 0) { dbg("server recv rc=%d -> exit", rc); break; }
-        dbg("server got cmd=%u len=%zu", cmd, len);
-        if (cmd == KCORO_CMD_GET_INFO) {
-            uint8_t buf[64]; uint8_t *cur=buf, *end=buf+sizeof(buf);
-            kc_tlv_put_u32(&cur, end, KCORO_ATTR_ABI_MAJOR, KCORO_PROTO_ABI_MAJOR);
-            kc_tlv_put_u32(&cur, end, KCORO_ATTR_ABI_MINOR, KCORO_PROTO_ABI_MINOR);
-            kc_tlv_put_u32(&cur, end, KCORO_ATTR_CAPS, 0);
-            kc_ipc_send(conn, KCORO_CMD_GET_INFO, buf, (size_t)(cur-buf));
-        } else if (cmd == KCORO_CMD_GET_STATS) {
-            uint8_t buf[64]; uint8_t *cur=buf, *end=buf+sizeof(buf);
-            kc_tlv_put_u32(&cur, end, KCORO_ATTR_SEND_OPS, 0);
-            kc_tlv_put_u32(&cur, end, KCORO_ATTR_RECV_OPS, 0);
-            kc_ipc_send(conn, KCORO_CMD_GET_STATS, buf, (size_t)(cur-buf));
-        } else {
-            int hr = kc_ipc_handle_command(ctx, conn, cmd, pl, len);
-            dbg("server handled cmd=%u rc=%d", cmd, hr);
-        }
-        free(pl);
-    }
-    kc_ipc_conn_close(conn);
-    return NULL;
-}
-
 static int server_process(void)
 {
     printf("[Server] Starting kcoro server...\n");
     
-    /* This would use the server-side handler we created */
-    /* For now, just demonstrate the IPC server setup */
-    
     kc_ipc_server_t *srv = NULL;
-    unlink(KC_SOCK);
-    if (kc_ipc_srv_listen(KC_SOCK, &srv) != 0) {
-        perror("listen");
+    int rc;
+    if (g_tcp_port) {
+        rc = kc_ipc_srv_listen_tcp("127.0.0.1", g_tcp_port, &srv);
+    } else {
+        unlink(KC_SOCK);
+        rc = kc_ipc_srv_listen(KC_SOCK, &srv);
+    }
+    if (rc != 0) {
+        fprintf(stderr, "listen: %s\n", strerror(-rc));
         return 1;
     }
-    printf("[Server] Listening on %s\n", KC_SOCK);
+    if (g_tcp_port) printf("[Server] Listening on 127.0.0.1:%s\n", g_tcp_port);
+    else printf("[Server] Listening on %s\n", KC_SOCK);
 
     kc_ipc_server_ctx_t *ctx = kc_ipc_server_ctx_create();
     if (!ctx) { fprintf(stderr, "ctx create failed\n"); kc_ipc_srv_close(srv); return 1; }
 
-    for (;;) {
-        kc_ipc_conn_t *conn = NULL;
-        if (kc_ipc_srv_accept(srv, &conn) == 0) {
-            printf("[Server] Client connected\n");
-            pthread_t th; struct worker_arg *wa = malloc(sizeof(*wa));
-            if (!wa) { kc_ipc_conn_close(conn); continue; }
-            wa->ctx = ctx; wa->conn = conn;
-            if (pthread_create(&th, NULL, server_worker, wa) != 0) {
-                kc_ipc_conn_close(conn);
-                free(wa);
-                continue;
-            }
-            pthread_detach(th);
-        } else {
-            /* Brief nap to avoid busy loop */
-            struct timespec ts; ts.tv_sec = 0; ts.tv_nsec = 100000000L; nanosleep(&ts, NULL);
-        }
-        /* Stop when parent kills us */
+    /* One acceptor coroutine; each client is served by a coroutine of its own. */
+    kc_ipc_acceptor_t *acc = NULL;
+    if (kc_ipc_server_start(ctx, &srv, 1, NULL, &acc) != 0) {
+        fprintf(stderr, "accept coroutine failed\n");
+        kc_ipc_server_ctx_destroy(ctx);
+        kc_ipc_srv_close(srv);
+        return 1;
     }
-
-    kc_ipc_server_ctx_destroy(ctx);
-    kc_ipc_srv_close(srv);
-    printf("[Server] Shutdown\n");
-    
-    return 0;
+    /* Serve until the parent kills us */
+    for (;;) pause();
 }
 
 int main(int argc, char **argv)
@@ -346,12 +307,14 @@ int main(int argc, char **argv)
     for (int i = 1; i < argc; ++i) {
         if (strcmp(argv[i], "--debug") == 0 || strcmp(argv[i], "-d") == 0) {
             enable_debug();
+        } else if (strcmp(argv[i], "--tcp") == 0 && i + 1 < argc) {
+            g_tcp_port = argv[++i];
         } else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
-            printf("Usage: %s [--debug]\n", argv[0]);
+            printf("Usage: %s [--debug] [--tcp PORT]\n", argv[0]);
             return 0;
         } else {
             fprintf(stderr, "Unknown arg: %s\n", argv[i]);
-            printf("Usage: %s [--debug]\n", argv[0]);
+            printf("Usage: %s [--debug] [--tcp PORT]\n", argv[0]);
             return 2;
         }
     }
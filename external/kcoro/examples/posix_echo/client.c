@@ -1,9 +1,15 @@
 // SPDX-License-Identifier: BSD-3-Clause
+/* Echo client: opens `conns` connections at once (default 1), then sends
+ * GET_INFO and GET_STATS on each before closing them all.
+ *
+ *   client [sock_path] [conns]
+ */
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <arpa/inet.h>
+#include <sys/resource.h>
 
 #include "../../../kcoro/proto/kcoro_proto.h"
 #include "../../../kcoro/ipc/posix/include/kcoro_ipc_posix.h"
@@ -33,32 +39,46 @@ static void print_tlvs(const uint8_t *p, size_t n)
     printf("\n");
 }
 
-int main(int argc, char **argv)
+static int request(kc_ipc_conn_t *conn, uint16_t want, const char *name, int verbose)
 {
-    const char *sock = (argc > 1) ? argv[1] : "/tmp/kcoro.sock";
-    kc_ipc_conn_t *conn = NULL;
-    if (kc_ipc_connect(sock, &conn) != 0) { perror("connect"); return 1; }
-    uint32_t maj=0,min=0; 
-    if (kc_ipc_hs_cli(conn, &maj, &min) != 0) { fprintf(stderr, "handshake failed\n"); kc_ipc_conn_close(conn); return 1; }
-    printf("[cli] server ABI: %u.%u\n", maj, min);
-
-    /* GET_INFO */
-    kc_ipc_send(conn, KCORO_CMD_GET_INFO, NULL, 0);
-    uint16_t cmd; uint8_t *pl=NULL; size_t len=0;
-    if (kc_ipc_recv(conn, &cmd, &pl, &len) == 0) {
-        printf("[cli] GET_INFO reply cmd=%u len=%zu\n", cmd, len);
+    uint16_t cmd; uint8_t *pl = NULL; size_t len = 0;
+    if (kc_ipc_send(conn, want, NULL, 0) != 0 || kc_ipc_recv(conn, &cmd, &pl, &len) != 0) return -1;
+    if (verbose) {
+        printf("[cli] %s reply cmd=%u len=%zu\n", name, cmd, len);
         if (len) { printf("[cli] payload:"); print_tlvs(pl, len); }
-        free(pl);
     }
+    free(pl);
+    return cmd == want ? 0 : -1;
+}
 
-    /* GET_STATS */
-    kc_ipc_send(conn, KCORO_CMD_GET_STATS, NULL, 0);
-    if (kc_ipc_recv(conn, &cmd, &pl, &len) == 0) {
-        printf("[cli] GET_STATS reply cmd=%u len=%zu\n", cmd, len);
-        if (len) { printf("[cli] payload:"); print_tlvs(pl, len); }
-        free(pl);
+int main(int argc, char **argv)
+{
+    const char *sock = (argc > 1) ? argv[1] : "/tmp/kcoro.sock";
+    int n = (argc > 2) ? atoi(argv[2]) : 1;
+    if (n < 1) n = 1;
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < rl.rlim_max) {
+        rl.rlim_cur = rl.rlim_max;
+        (void)setrlimit(RLIMIT_NOFILE, &rl);
     }
-
-    kc_ipc_conn_close(conn);
-    return 0;
+    kc_ipc_conn_t **conn = calloc((size_t)n, sizeof(*conn));
+    if (!conn) return 1;
+    int rc = 0, open = 0;
+    for (; open < n; open++) {
+        uint32_t maj = 0, min = 0;
+        if (kc_ipc_connect(sock, &conn[open]) != 0) { perror("connect"); rc = 1; break; }
+        if (kc_ipc_hs_cli(conn[open], &maj, &min) != 0) {
+            fprintf(stderr, "handshake failed\n"); kc_ipc_conn_close(conn[open]); rc = 1; break;
+        }
+        if (open == 0) printf("[cli] server ABI: %u.%u\n", maj, min);
+    }
+    int ok = 0;
+    for (int i = 0; i < open; i++) {
+        if (request(conn[i], KCORO_CMD_GET_INFO, "GET_INFO", i == 0) == 0 &&
+            request(conn[i], KCORO_CMD_GET_STATS, "GET_STATS", i == 0) == 0) ok++;
+    }
+    for (int i = 0; i < open; i++) kc_ipc_conn_close(conn[i]);
+    free(conn);
+    if (n > 1) printf("[cli] %d/%d connections served\n", ok, n);
+    return rc || ok != n;
 }
@@ -2,11 +2,13 @@
 set -euo pipefail
 
 sock=${1:-/tmp/kcoro.sock}
+conns=${2:-1}
 
 cd "$(dirname "$0")"
-echo "[build] IPC lib + demo"
+echo "[build] core + IPC lib + demo"
+make -C ../../core all >/dev/null
 make -C ../../ipc/posix >/dev/null
-make -C . >/dev/null
+make -C . all >/dev/null
 
 echo "[run] server -> $sock"
 rm -f "$sock"
@@ -16,4 +18,4 @@ trap 'kill $srv 2>/dev/null || true; rm -f "$sock"' EXIT
 sleep 0.2
 
 echo "[run] client"
-./build/client "$sock"
+./build/client "$sock" "$conns"
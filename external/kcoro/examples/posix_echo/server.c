@@ -1,16 +1,27 @@
 // SPDX-License-Identifier: BSD-3-Clause
+/* Echo server: one coroutine per connection on a few scheduler workers.
+ * Sockets are non-blocking; on -EAGAIN a coroutine parks in
+ * kc_await_readable / kc_await_writable and the reactor requeues it when the
+ * fd turns ready, so idle connections cost a parked coroutine, not a thread.
+ *
+ *   server [sock_path] [workers]
+ */
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <errno.h>
+#include <stdatomic.h>
 #include <arpa/inet.h>
-#include <sys/epoll.h>
+#include <sys/resource.h>
 
 #include "../../../kcoro/proto/kcoro_proto.h"
 #include "../../../kcoro/ipc/posix/include/kcoro_ipc_posix.h"
 #include "../../../kcoro/include/kcoro_abi.h"
-#include <errno.h>
+#include "../../../kcoro/include/kcoro_sched.h"
+
+static _Atomic(unsigned long) g_conns, g_live;
 
 static void print_tlvs(const uint8_t *p, size_t n)
 {
@@ -33,95 +44,110 @@ static void print_tlvs(const uint8_t *p, size_t n)
     printf("\n");
 }
 
-int main(int argc, char **argv)
+/* Queue a reply and flush it, parking while the socket is full. */
+static int reply(kc_ipc_conn_t *c, uint16_t cmd, const void *pl, size_t len)
 {
-    const char *sock = (argc > 1) ? argv[1] : "/tmp/kcoro.sock";
-    kc_ipc_server_t *srv = NULL; kc_ipc_conn_t *conn = NULL;
-    int efd = -1; int srvfd = -1; int connfd = -1; int want_out = 0;
+    int rc = kc_ipc_send_nb(c, cmd, pl, len);
+    while (rc == -EAGAIN) {
+        if ((rc = kc_ipc_await_flush(c, -1)) != 0) break;
+        rc = kc_ipc_flush(c);
+    }
+    return rc;
+}
 
-    if (kc_ipc_srv_listen(sock, &srv) != 0) { perror("listen"); return 1; }
-    kc_ipc_srv_set_nb(srv, 1);
-    srvfd = kc_ipc_srv_fd(srv);
-    printf("[srv] listening on %s\n", sock);
+static void conn_main(void *arg)
+{
+    kc_ipc_conn_t *c = (kc_ipc_conn_t*)arg;
+    int fd = kc_ipc_conn_fd(c);
+    unsigned long id = atomic_fetch_add(&g_conns, 1);
+    int verbose = id == 0; /* log the first connection only */
+    atomic_fetch_add(&g_live, 1);
 
-    efd = epoll_create1(EPOLL_CLOEXEC);
-    if (efd < 0) { perror("epoll_create1"); kc_ipc_srv_close(srv); return 1; }
-    struct epoll_event ev = { .events = EPOLLIN, .data.fd = srvfd };
-    if (epoll_ctl(efd, EPOLL_CTL_ADD, srvfd, &ev) < 0) { perror("epoll_ctl add srv"); kc_ipc_srv_close(srv); close(efd); return 1; }
+    /* The handshake is two small frames: wait for the HELLO, then run the
+     * blocking exchange (it does not stall the worker in practice). */
+    uint32_t maj = 0, min = 0;
+    kc_ipc_conn_set_nb(c, 0);
+    if (kc_await_readable(fd, 5000) != 0 || kc_ipc_hs_srv(c, &maj, &min) != 0) {
+        fprintf(stderr, "[srv] handshake failed\n");
+        goto out;
+    }
+    kc_ipc_conn_set_nb(c, 1);
+    if (verbose) printf("[srv] peer ABI: %u.%u\n", maj, min);
 
-    struct epoll_event events[8];
     for (;;) {
-        int n = epoll_wait(efd, events, 8, -1);
-        if (n < 0) { if (errno == EINTR) continue; perror("epoll_wait"); break; }
-        for (int i = 0; i < n; ++i) {
-            int fd = events[i].data.fd;
-            uint32_t evs = events[i].events;
-            if (fd == srvfd && (evs & EPOLLIN)) {
-                /* accept all pending connections; keep the first and close extras */
-                kc_ipc_conn_t *c = NULL;
-                while (kc_ipc_srv_accept_nb(srv, &c) == 0) {
-                    if (!conn) {
-                        conn = c; connfd = kc_ipc_conn_fd(conn);
-                        kc_ipc_conn_set_nb(conn, 1);
-                        struct epoll_event cev = { .events = EPOLLIN, .data.fd = connfd };
-                        epoll_ctl(efd, EPOLL_CTL_ADD, connfd, &cev);
-                        printf("[srv] client connected\n");
-                        /* blocking handshake (simple) */
-                        uint32_t maj=0,min=0;
-                        if (kc_ipc_hs_srv(conn, &maj, &min) != 0) { fprintf(stderr, "handshake failed\n"); }
-                        else { printf("[srv] peer ABI: %u.%u\n", maj, min); }
-                    } else {
-                        /* single-client example: close extras */
-                        kc_ipc_conn_close(c);
-                    }
-                }
-            } else if (conn && fd == connfd) {
-                if (evs & EPOLLIN) {
-                    for (;;) {
-                        uint16_t cmd; uint8_t *pl=NULL; size_t len=0;
-                        int rc = kc_ipc_recv_nb(conn, &cmd, &pl, &len);
-                        if (rc == -EAGAIN) break;
-                        if (rc != 0) { fprintf(stderr, "[srv] recv error %d\n", rc); free(pl); goto out; }
-                        printf("[srv] cmd=%u len=%zu\n", cmd, len);
-                        if (cmd == KCORO_CMD_GET_INFO) {
-                            uint8_t buf[64]; uint8_t *cur=buf, *end=buf+sizeof(buf);
-                            kc_tlv_put_u32(&cur, end, KCORO_ATTR_ABI_MAJOR, KCORO_PROTO_ABI_MAJOR);
-                            kc_tlv_put_u32(&cur, end, KCORO_ATTR_ABI_MINOR, KCORO_PROTO_ABI_MINOR);
-                            kc_tlv_put_u32(&cur, end, KCORO_ATTR_CAPS, 0);
-                            int s = kc_ipc_send_nb(conn, KCORO_CMD_GET_INFO, buf, (size_t)(cur-buf));
-                            if (s == -EAGAIN) { want_out = 1; struct epoll_event mev={.events=EPOLLIN|EPOLLOUT,.data.fd=connfd}; epoll_ctl(efd, EPOLL_CTL_MOD, connfd, &mev); }
-                        } else if (cmd == KCORO_CMD_GET_STATS) {
-                            uint8_t buf[64]; uint8_t *cur=buf, *end=buf+sizeof(buf);
-                            kc_tlv_put_u32(&cur, end, KCORO_ATTR_SEND_OPS, 0);
-                            kc_tlv_put_u32(&cur, end, KCORO_ATTR_RECV_OPS, 0);
-                            int s = kc_ipc_send_nb(conn, KCORO_CMD_GET_STATS, buf, (size_t)(cur-buf));
-                            if (s == -EAGAIN) { want_out = 1; struct epoll_event mev={.events=EPOLLIN|EPOLLOUT,.data.fd=connfd}; epoll_ctl(efd, EPOLL_CTL_MOD, connfd, &mev); }
-                        } else {
-                            int s = kc_ipc_send_nb(conn, cmd, pl, len);
-                            if (s == -EAGAIN) { want_out = 1; struct epoll_event mev={.events=EPOLLIN|EPOLLOUT,.data.fd=connfd}; epoll_ctl(efd, EPOLL_CTL_MOD, connfd, &mev); }
-                        }
-                        if (len) { printf("[srv] payload:"); print_tlvs(pl, len); }
-                        free(pl);
-                    }
-                }
-                if (want_out && (evs & EPOLLOUT)) {
-                    int fr = kc_ipc_flush(conn);
-                    if (fr == 0) {
-                        want_out = 0; struct epoll_event mev={.events=EPOLLIN,.data.fd=connfd}; epoll_ctl(efd, EPOLL_CTL_MOD, connfd, &mev);
-                    } else if (fr != -EAGAIN) {
-                        fprintf(stderr, "[srv] flush error %d\n", fr); goto out;
-                    }
-                }
-                if (evs & (EPOLLHUP|EPOLLERR)) {
-                    fprintf(stderr, "[srv] peer closed/error\n");
-                    goto out;
-                }
-            }
+        uint16_t cmd; uint8_t *pl = NULL; size_t len = 0;
+        int rc = kc_ipc_recv_nb(c, &cmd, &pl, &len);
+        if (rc == -EAGAIN) {
+            if (kc_await_readable(fd, -1) != 0) break;
+            continue;
+        }
+        if (rc != 0) { if (rc != -ECONNRESET) fprintf(stderr, "[srv] recv error %d\n", rc); break; }
+        if (verbose) printf("[srv] cmd=%u len=%zu\n", cmd, len);
+        uint8_t buf[64]; uint8_t *cur = buf, *end = buf + sizeof(buf);
+        if (cmd == KCORO_CMD_GET_INFO) {
+            kc_tlv_put_u32(&cur, end, KCORO_ATTR_ABI_MAJOR, KCORO_PROTO_ABI_MAJOR);
+            kc_tlv_put_u32(&cur, end, KCORO_ATTR_ABI_MINOR, KCORO_PROTO_ABI_MINOR);
+            kc_tlv_put_u32(&cur, end, KCORO_ATTR_CAPS, 0);
+            rc = reply(c, cmd, buf, (size_t)(cur - buf));
+        } else if (cmd == KCORO_CMD_GET_STATS) {
+            kc_tlv_put_u32(&cur, end, KCORO_ATTR_SEND_OPS, 0);
+            kc_tlv_put_u32(&cur, end, KCORO_ATTR_RECV_OPS, 0);
+            rc = reply(c, cmd, buf, (size_t)(cur - buf));
+        } else {
+            rc = reply(c, cmd, pl, len);
         }
+        if (verbose && len) { printf("[srv] payload:"); print_tlvs(pl, len); }
+        free(pl);
+        if (rc != 0) { fprintf(stderr, "[srv] send error %d\n", rc); break; }
     }
 out:
-    if (conn) kc_ipc_conn_close(conn);
-    if (srv) kc_ipc_srv_close(srv);
-    if (efd >= 0) close(efd);
-    return 0;
+    kc_ipc_conn_close(c);
+    atomic_fetch_sub(&g_live, 1);
+}
+
+typedef struct { kc_ipc_server_t *srv; kc_sched_t *s; } accept_args_t;
+
+static void accept_main(void *arg)
+{
+    accept_args_t *a = (accept_args_t*)arg;
+    int srvfd = kc_ipc_srv_fd(a->srv);
+    for (;;) {
+        kc_ipc_conn_t *c = NULL;
+        int rc = kc_ipc_srv_accept_nb(a->srv, &c);
+        if (rc == -EAGAIN) {
+            if (kc_await_readable(srvfd, -1) != 0) break;
+            continue;
+        }
+        if (rc != 0) { fprintf(stderr, "[srv] accept error %d\n", rc); kc_sleep_ms(10); continue; }
+        kc_ipc_conn_set_nb(c, 1);
+        if (kc_spawn_co(a->s, conn_main, c, 0, NULL) != 0) kc_ipc_conn_close(c);
+        unsigned long n = atomic_load(&g_conns) + 1;
+        if (n % 1000 == 0) printf("[srv] %lu connections (%lu open)\n", n, atomic_load(&g_live));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *sock = (argc > 1) ? argv[1] : "/tmp/kcoro.sock";
+    int workers = (argc > 2) ? atoi(argv[2]) : 4;
+    kc_ipc_server_t *srv = NULL;
+
+    /* Room for 10k connections. */
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < rl.rlim_max) {
+        rl.rlim_cur = rl.rlim_max;
+        (void)setrlimit(RLIMIT_NOFILE, &rl);
+    }
+
+    if (kc_ipc_srv_listen(sock, &srv) != 0) { perror("listen"); return 1; }
+    kc_ipc_srv_set_nb(srv, 1);
+    printf("[srv] listening on %s (%d workers)\n", sock, workers);
+
+    kc_sched_opts_t opts = {0};
+    opts.workers = workers > 0 ? workers : 4;
+    kc_sched_t *s = kc_sched_init(&opts);
+    if (!s) { fprintf(stderr, "kc_sched_init failed\n"); kc_ipc_srv_close(srv); return 1; }
+    accept_args_t a = { srv, s };
+    if (kc_spawn_co(s, accept_main, &a, 0, NULL) != 0) { kc_sched_shutdown(s); kc_ipc_srv_close(srv); return 1; }
+    for (;;) pause(); /* until killed */
 }
@@ -0,0 +1,53 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+/**
+ * @file kc_cls.h
+ * @brief Coroutine-local storage.
+ *
+ * A key names one pointer-sized slot in every coroutine, the way a
+ * pthread_key_t names one in every thread. Keys below KCORO_CLS_INLINE live
+ * in the coroutine's own control block; the rest in a table allocated on the
+ * first set, so kc_cls_get is an index either way, with no lookup by
+ * coroutine ID.
+ *
+ * A value still set when the coroutine function returns is passed to the
+ * key's destructor, on the coroutine's own stack and with kcoro_current()
+ * still the finishing coroutine. Values a destructor sets again are cleaned
+ * up the same way, up to KCORO_CLS_DTOR_PASSES rounds. A coroutine destroyed
+ * without finishing has its destructors run when the last handle drops, on
+ * the releasing thread.
+ *
+ * Values belong to whatever kcoro_current() returns: on a scheduler worker
+ * outside any coroutine that is the worker's main context, whose values stay
+ * until the worker exits.
+ *
+ * Status & install guidance
+ *   - Status: implemented in core (kc_cls.c). kcoro_cpp::CoroutineLocal<T>
+ *     is the C++ counterpart for kcoro_cpp coroutines.
+ *   - Install: part of the public surface alongside kcoro.h.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef unsigned kc_cls_key_t;
+typedef void (*kc_cls_dtor_fn)(void *value);
+
+/** New key with an optional destructor. Keys are never reused; creating
+ *  more than KCORO_CLS_KEYS returns -EAGAIN. 0, -EINVAL or -EAGAIN. */
+int kc_cls_key_create(kc_cls_key_t *out, kc_cls_dtor_fn dtor);
+
+/** Value of key in the current coroutine; NULL if unset, for a key never
+ *  created, or on a thread with no coroutine context. */
+void *kc_cls_get(kc_cls_key_t key);
+
+/** Set key in the current coroutine (NULL clears it without calling the
+ *  destructor). 0, -EINVAL (key not created), -ESRCH (no coroutine
+ *  context) or -ENOMEM (first key past the inline slots). */
+int kc_cls_set(kc_cls_key_t key, void *value);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+/**
+ * @file kc_deferred.h
+ * @brief Deferred values: kc_async / kc_await.
+ *
+ * A deferred is a single-assignment result slot. It starts PENDING and is
+ * settled exactly once: COMPLETED with a value pointer, FAILED with a
+ * negative code, or CANCELLED. Settling wakes the awaiter; later attempts
+ * return -EALREADY and change nothing.
+ *
+ * kc_async runs fn(arg, &value) as a coroutine bound to a child job of the
+ * caller's job (kc_job_launch), and settles the deferred from its return:
+ * 0 completes it with value, KC_ECANCELED cancels it, any other negative
+ * code fails it. kc_deferred_cancel settles the deferred at once and
+ * cancels that job, so the body sees kc_job_token(kc_job_current()) fire at
+ * its next _c op. A deferred from kc_deferred_create is settled by hand.
+ *
+ * One awaiter at a time: a deferred holds a single waiter slot, so a second
+ * concurrent kc_await on it returns -EBUSY (kc_await_any counts as an
+ * awaiter of each deferred it watches). Settled results can be read any
+ * number of times. Awaiting from a coroutine parks it; only plain threads
+ * block on a condvar.
+ *
+ * Lifetime: the creator owns one reference and drops it with
+ * kc_deferred_release; kc_async's body holds its own until it returns.
+ * Blocks are recycled through a per-thread cache
+ * (KCORO_DEFERRED_CACHE_PER_THREAD).
+ *
+ * Awaits return 0 (COMPLETED; *result gets the value), the failure code
+ * (FAILED), KC_ECANCELED (CANCELLED, or the _c token fired), KC_EAGAIN
+ * (timeout_ms == 0 and still pending) or KC_ETIME (timeout expired).
+ * timeout_ms < 0 waits without a deadline.
+ */
+
+#include <stddef.h>
+
+#include "kc_job.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    KC_DEFERRED_PENDING = 0,
+    KC_DEFERRED_COMPLETED,
+    KC_DEFERRED_FAILED,
+    KC_DEFERRED_CANCELLED
+} kc_deferred_state_t;
+
+/** kc_async body: 0 and *result to complete, a negative code to fail. */
+typedef int (*kc_async_fn)(void *arg, void **result);
+
+/** New PENDING deferred settled by hand. 0, -EINVAL or -ENOMEM. */
+int kc_deferred_create(kc_deferred_t **out);
+
+/** Run fn(arg, &value) in a child job of kc_job_current() on the default
+ *  scheduler; *out settles when it returns. 0, -EINVAL, -ENOMEM, or
+ *  KC_ECANCELED when the parent job has already finished. */
+int kc_async(kc_async_fn fn, void *arg, kc_deferred_t **out);
+
+/** Settle d. 0, -EINVAL (fail: code >= 0), or -EALREADY once settled. */
+int kc_deferred_complete(kc_deferred_t *d, void *value);
+int kc_deferred_fail(kc_deferred_t *d, int code);
+
+/** Settle d as CANCELLED and cancel its kc_async job, if any.
+ *  0 or -EALREADY once settled. */
+int kc_deferred_cancel(kc_deferred_t *d);
+
+/** Query state (non-blocking). */
+kc_deferred_state_t kc_deferred_state(const kc_deferred_t *d);
+
+/** Drop the creator's reference. */
+void kc_deferred_release(kc_deferred_t *d);
+
+/** Wait for d to settle (see the return codes above). */
+int kc_await(kc_deferred_t *d, long timeout_ms, void **result);
+
+/** kc_await that also gives up with KC_ECANCELED when cancel fires; d
+ *  itself is left as it is. */
+int kc_await_c(kc_deferred_t *d, long timeout_ms, const kc_cancel_t *cancel, void **result);
+
+/** Wait for all n within one timeout. 0 when every one COMPLETED;
+ *  otherwise the first non-zero result in index order, or KC_EAGAIN /
+ *  KC_ETIME if the time ran out first. results (optional) gets each
+ *  completed value, NULL for the rest. */
+int kc_await_all(kc_deferred_t *const *ds, size_t n, long timeout_ms, void **results);
+
+/** Wait for the first of n to settle; *index (optional) gets the lowest
+ *  settled index and the return value is its result. KC_EAGAIN/KC_ETIME
+ *  when none settled in time, -EBUSY if another awaiter holds one. */
+int kc_await_any(kc_deferred_t *const *ds, size_t n, long timeout_ms, size_t *index, void **result);
+
+#ifdef __cplusplus
+}
+#endif
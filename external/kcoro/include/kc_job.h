@@ -3,19 +3,29 @@
 
 /**
  * @file kc_job.h
- * @brief Structured concurrency job API (draft).
+ * @brief Structured concurrency jobs.
  *
  * Jobs generalize hierarchical cancellation and lifetime management. A parent
  * owns child jobs; cancelling the parent propagates downstream. Joining a job
- * waits for completion and returns a result code. This API sketches the stable
- * surface we will finalize in Phase S3.
+ * waits for completion and returns a result code.
+ *
+ * A job is done when its own part is done and every attached child has
+ * reached a terminal state:
+ *   - kc_job_launch: the own part is the coroutine body; it ends on return.
+ *   - kc_job_create: the own part is the creator; it ends at the first
+ *     kc_job_join (the creator has nothing more to add), so create, launch
+ *     children into it, join is a fan-out/fan-in.
+ * The terminal state is FAILED if kc_job_fail was called on the job or a
+ * child failed, CANCELLED if it was cancelled, COMPLETED otherwise. A
+ * failing child cancels its parent (and so its siblings) unless the parent
+ * is a supervisor; a supervisor records nothing and carries on.
+ *
+ * Joining from a coroutine parks it; only plain threads block on a condvar.
  *
  * Status & install guidance
- *   - Status: design documented; implementation pending. The core library does
- *     not depend on these APIs yet.
- *   - Install: treat this header as draft/experimental. It can be excluded from
- *     "installed" headers until implementation lands, to keep the production
- *     surface crisp.
+ *   - Status: implemented in core (kc_job.c). Contexts (kc_context.h) are not
+ *     yet wired in: kc_job_launch takes ctx == NULL only.
+ *   - Install: part of the public surface alongside kcoro.h.
  */
 
 #include <stddef.h>
@@ -26,6 +36,7 @@ extern "C" {
 #endif
 
 typedef struct kc_job kc_job_t; /* opaque */
+typedef struct kc_cancel kc_cancel_t;
 
 typedef enum {
     KC_JOB_ACTIVE = 0,
@@ -44,8 +55,8 @@ typedef enum {
 #define KC_JOB_F_SUPERVISOR   (1u<<0)
 /**
  * Detached job: not tracked by parent for joins.
- * Lifetime is managed externally; parent shutdown will not wait on it unless
- * an explicit join is later performed.
+ * Lifetime is managed externally; parent shutdown will not wait on it, its
+ * failure does not reach the parent and parent cancellation does not reach it.
  */
 #define KC_JOB_F_DETACHED     (1u<<1)
 /**
@@ -55,31 +66,51 @@ typedef enum {
  */
 #define KC_JOB_F_TIMEOUT_WRP  (1u<<2)
 
-/* Create child job (internal use; public launch helpers will wrap). */
+/** Create a job under parent (NULL: a root). The caller owns one reference
+ *  and must kc_job_join the job once: until then it cannot finish.
+ *  0, -EINVAL, -ENOMEM, or KC_ECANCELED when parent has already finished. */
 int kc_job_create(kc_job_t **out, kc_job_t *parent, unsigned flags);
 
 /* Increment external reference (deferred handle / API consumer). */
 kc_job_t* kc_job_retain(kc_job_t *j);
 
-/* Release external reference; object freed when refcount hits 0. */
+/* Release external reference; object freed when refcount hits 0 and the
+ * job is terminal. */
 void kc_job_release(kc_job_t *j);
 
-/* Current executing job (NULL if not in coroutine context). */
+/* Current executing job (NULL outside a kc_job_launch coroutine). */
 kc_job_t* kc_job_current(void);
 
-/* Request cancellation (reason is errno-style; 0 => generic). */
+/** Request cancellation of j and its attached descendants (reason is
+ *  errno-style; 0 => KC_ECANCELED). 0, or -EALREADY once j left ACTIVE. */
 int kc_job_cancel(kc_job_t *j, int reason);
 
-/* Join (wait until terminal). Returns 0 on success, <0 on error (failure/cancel). */
+/** Record a failure (code < 0) of j's own part and cancel its children.
+ *  The first code wins. 0 or -EINVAL. */
+int kc_job_fail(kc_job_t *j, int code);
+
+/** 1 once j is cancelling or terminal for a reason other than completion. */
+int kc_job_is_cancelled(const kc_job_t *j);
+
+/** Token triggered when j is cancelled, for the _c channel ops. Created on
+ *  first use; lives as long as j. NULL on allocation failure. */
+const kc_cancel_t* kc_job_token(kc_job_t *j);
+
+/** Join (wait until terminal). Returns 0 when COMPLETED, the failure code
+ *  when FAILED, KC_ECANCELED when CANCELLED; *out_result_code (optional)
+ *  gets kc_job_result_code. */
 int kc_job_join(kc_job_t *j, int *out_result_code);
 
 /* Query state (non-blocking). */
 kc_job_state_t kc_job_state(const kc_job_t *j);
 
-/* Retrieve failure/cancel code after terminal state. */
+/* Retrieve failure/cancel code after terminal state (0 when COMPLETED). */
 int kc_job_result_code(const kc_job_t *j);
 
-/* Launch a coroutine bound to a new child job (stack_size=0 => default). */
+/* Launch a coroutine bound to a new child job (stack_size=0 => default).
+ * parent NULL means kc_job_current(). ctx is reserved and must be NULL.
+ * *out_job (optional) receives a reference the caller releases.
+ * 0, -EINVAL, -ENOTSUP, -ENOMEM, or KC_ECANCELED when parent has finished. */
 struct kc_context; /* forward */
 typedef void (*kcoro_fn_t)(void*); /* reuse existing typedef location later */
 typedef struct kc_deferred kc_deferred_t; /* forward for async handles */
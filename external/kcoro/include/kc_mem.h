@@ -0,0 +1,78 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+/**
+ * @file kc_mem.h
+ * @brief Runtime memory accounting and soft limits (kc_mem.c).
+ *
+ * The runtime charges what it allocates for its own structures to one of a
+ * few categories and gives it back when it frees them; each category keeps
+ * a gauge, a peak and a count of refused charges. Charges are one relaxed
+ * atomic add, plus a compare when a limit is set.
+ *
+ * A charge that would take its category past its limit, or all categories
+ * together past the total limit, is refused and nothing is held. What a
+ * refusal means depends on the caller:
+ *   - stacks: kcoro_create returns NULL and kc_spawn_co -ENOMEM (errno
+ *     ENOMEM); a KCORO_STACK_LAZY coroutine stays queued until a stack fits.
+ *   - KC_UNLIMITED growth: a send that needs a new segment returns KC_EAGAIN
+ *     at timeout 0 and otherwise waits (backpressure) until receives free
+ *     room or its deadline passes (KC_ETIME). Channel buffers refused at
+ *     kc_chan_make fail it with -ENOMEM.
+ *   - waiters, timer slots and IPC buffers: the operation fails with -ENOMEM
+ *     as if malloc had.
+ *
+ * Stacks count their full reservation (not the resident pages), pooled ones
+ * included; channel buffers count ring storage and unlimited segments.
+ * Limits are soft: they bound what is charged from now on and never take
+ * back what already is.
+ *
+ * Status & install guidance
+ *   - Status: implemented in core. kc_metrics_render and the stats segment
+ *     (kc_statseg) publish the gauges.
+ *   - Install: part of the public surface alongside kcoro.h.
+ */
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum kc_mem_cat {
+    KC_MEM_STACKS = 0,   /* coroutine stacks, in use or pooled */
+    KC_MEM_CHAN,         /* channel rings and KC_UNLIMITED segments */
+    KC_MEM_WAITERS,      /* blocked-operation records */
+    KC_MEM_TIMERS,       /* timer wheel slots */
+    KC_MEM_IPC,          /* IPC connection receive buffers */
+    KC_MEM_CAT_COUNT
+} kc_mem_cat_t;
+
+typedef struct kc_mem_stats {
+    size_t        bytes[KC_MEM_CAT_COUNT];   /* charged now */
+    size_t        peak[KC_MEM_CAT_COUNT];    /* highest charged */
+    size_t        limit[KC_MEM_CAT_COUNT];   /* 0 => none */
+    unsigned long denied[KC_MEM_CAT_COUNT];  /* charges refused */
+    size_t        total;                     /* sum of bytes[] */
+    size_t        total_limit;               /* 0 => none */
+} kc_mem_stats_t;
+
+/** Soft limit for one category (0 removes it). 0 or -EINVAL. */
+int kc_mem_set_limit(kc_mem_cat_t cat, size_t bytes);
+/** Soft limit over all categories together (0 removes it). */
+void kc_mem_set_total_limit(size_t bytes);
+void kc_mem_get_stats(kc_mem_stats_t *out);
+/** "stacks", "chan", ... (the cat label kc_metrics_render uses); NULL when
+ *  out of range. */
+const char *kc_mem_cat_name(kc_mem_cat_t cat);
+
+/** For extensions that allocate on the runtime's behalf (the IPC library):
+ *  charge bytes to cat, or -ENOMEM with nothing charged when a limit would
+ *  be passed. Every successful charge is paired with an uncharge of the
+ *  same size. */
+int  kc_mem_charge(kc_mem_cat_t cat, size_t bytes);
+void kc_mem_uncharge(kc_mem_cat_t cat, size_t bytes);
+
+#ifdef __cplusplus
+}
+#endif
@@ -41,6 +41,7 @@
 #pragma once
 
 #include <stddef.h>
+#include <stdint.h>
 #include "kcoro_abi.h"
 
 #ifdef __cplusplus
@@ -60,9 +61,15 @@ enum kc_kind {
     KC_RENDEZVOUS = 0,  /**< Sender and receiver meet; no buffering. */
     KC_BUFFERED   = 1,  /**< Bounded ring buffer with given capacity. */
     KC_CONFLATED  = -1, /**< Single slot; latest value overwrites previous. */
-    KC_UNLIMITED  = -2  /**< Logically unbounded; grows in segments as needed. */
+    KC_UNLIMITED  = -2, /**< Logically unbounded; grows in segments as needed. */
+    KC_DELAYED    = -3, /**< Unbounded; each element is received once its due time passes. */
+    KC_PRIORITY   = -4  /**< Bounded; highest of KC_CHAN_PRIO_LEVELS levels received first. */
 };
 
+/** Priority levels of a KC_PRIORITY channel: 0 (lowest, the level of plain
+ *  sends) to KC_CHAN_PRIO_LEVELS - 1. */
+#define KC_CHAN_PRIO_LEVELS 8
+
 /* Opaque types */
 typedef struct kc_chan kc_chan_t;
 typedef void* kc_actor_t; /* platform-specific task handle */
@@ -76,6 +83,13 @@ int  kc_cancel_init(kc_cancel_t **out);
 void kc_cancel_trigger(kc_cancel_t *t);
 int  kc_cancel_is_set(const kc_cancel_t *t);
 void kc_cancel_destroy(kc_cancel_t *t);
+/** Run fn(arg) once when t is triggered, directly or through an ancestor;
+ *  right away when it already is. fn runs on the triggering thread with the
+ *  token locked, so it must be short and must not call back into t.
+ *  0, -EINVAL or -ENOMEM. */
+int  kc_cancel_watch(kc_cancel_t *t, void (*fn)(void *arg), void *arg);
+/** Drop a watch. Once this returns fn is not running and will not run. */
+void kc_cancel_unwatch(kc_cancel_t *t, void (*fn)(void *arg), void *arg);
 
 /* Hierarchical cancellation context (Phase 1.5) */
 typedef struct kc_cancel_ctx {
@@ -98,6 +112,194 @@ void kc_chan_close(kc_chan_t* ch);
 unsigned kc_chan_len(kc_chan_t* ch);
 /** @} */
 
+/**
+ * @brief Queue msg on a KC_DELAYED channel, to be received at deadline_ns.
+ * deadline_ns is absolute CLOCK_MONOTONIC nanoseconds, the clock of the
+ * scheduler timers (kc_sched_timer_wake_at); a deadline already past makes
+ * the element due at once, and plain kc_chan_send(ch, msg, tmo) means "due
+ * now". Receivers get elements in deadline order (send order among equal
+ * deadlines) and wait, with their own timeout, until the earliest is due;
+ * however many elements are pending, one parked receiver holds a timer for
+ * the earliest deadline. Sends never wait: the store is unbounded and
+ * charged to KC_MEM_CHAN. kc_chan_len counts pending elements, due or not.
+ * After kc_chan_close receivers still get every pending element as it
+ * comes due, then KC_EPIPE. select, readiness sets, zero-copy, pointer
+ * mode and kc_chan_post are not supported on delayed channels.
+ * @return 0, KC_EPIPE (closed), -EINVAL (not a delayed channel) or -ENOMEM
+ */
+int  kc_chan_send_at(kc_chan_t* ch, const void* msg, long deadline_ns);
+
+/**
+ * @brief Send msg on a KC_PRIORITY channel at priority prio.
+ * A priority channel is bounded like KC_BUFFERED (capacity elements over
+ * all levels, taken as given, not rounded) and otherwise behaves like one
+ * for waiting, timeouts, close and select. Every receive takes the oldest
+ * element of the highest non-empty level, so order is FIFO within a level
+ * only. Plain kc_chan_send, select sends, kc_chan_post and pointer sends
+ * queue at level 0. Levels share the capacity: a full channel blocks every
+ * level. kc_chan_snapshot reports the depth of each level in prio_depth.
+ * Batch calls go element by element; zero-copy is not supported.
+ * @return as kc_chan_send; -EINVAL for a prio outside
+ *         [0, KC_CHAN_PRIO_LEVELS) or a channel of another kind
+ */
+int  kc_chan_send_prio(kc_chan_t* ch, const void* msg, int prio, long timeout_ms);
+
+/**
+ * @brief Bound the memory KC_UNLIMITED backlogs hold.
+ * Once the queued segments of all unlimited channels together pass
+ * resident_bytes, a sender that needs a new segment first moves its
+ * channel's coldest full segment (one that is neither being read nor
+ * written) to a spill file in dir (NULL: $TMPDIR, else /tmp). A spilled
+ * segment comes back, with one read, when receives reach it, so FIFO order
+ * and kc_chan_len are unchanged; only that receive pays the read. Each
+ * channel's file is unlinked at creation. If a file cannot be created or
+ * written the segment stays in memory. 0 turns spilling off (the default)
+ * for new segments. Returns 0 or -EINVAL (empty or overlong dir).
+ */
+int  kc_chan_set_spill(size_t resident_bytes, const char *dir);
+/** Queued segment bytes of all KC_UNLIMITED channels now in memory. */
+size_t kc_chan_spill_resident(void);
+
+/**
+ * @brief Create a KC_BUFFERED channel backed by a lock-free bounded MPMC ring.
+ * Sends and receives that find room/data complete without taking the channel
+ * mutex; only parking (and waking a parked peer) uses the waiter path. The
+ * channel reports KC_CHAN_CAP_MPMC and otherwise behaves like
+ * kc_chan_make(out, KC_BUFFERED, elem_sz, capacity): select, close, len and
+ * snapshots work unchanged. Differences: a send racing kc_chan_close may
+ * still land (and be drained by receivers), and zero-copy / metrics pipes
+ * are not supported (-ENOTSUP).
+ * @return 0 on success; -EINVAL or -ENOMEM on failure
+ */
+int  kc_chan_make_mpmc(kc_chan_t** out, size_t elem_sz, size_t capacity);
+
+/**
+ * @brief Create a buffered channel for exactly one sender and one receiver.
+ * Same contract as kc_chan_make_mpmc() (KC_CHAN_CAP_SPSC instead of _MPMC),
+ * but the ring is wait-free: each side owns one cursor and re-reads the
+ * peer's only when the ring looks full/empty. At most one coroutine may send
+ * (directly or via select) and one may receive at any time; the two roles
+ * may be held by different coroutines over the channel's lifetime as long as
+ * hand-offs are ordered (e.g. through another channel).
+ * @return 0 on success; -EINVAL or -ENOMEM on failure
+ */
+int  kc_chan_make_spsc(kc_chan_t** out, size_t elem_sz, size_t capacity);
+
+/** Most stripes kc_chan_make_striped() uses. */
+#define KC_CHAN_MAX_STRIPES 64
+
+/**
+ * @brief Create a KC_BUFFERED channel spread over several lock-free MPMC rings.
+ * For producer counts that saturate one ring's cursors: each thread pushes
+ * to its own home stripe (the others only when that one is full) and pops
+ * from its home stripe first, then from the others. `stripes` is rounded up
+ * to a power of two (0: one per online CPU; at most KC_CHAN_MAX_STRIPES) and
+ * each stripe gets capacity/stripes cells, rounded up likewise.
+ * Order is FIFO within a stripe only: a thread's sends stay in order while
+ * its home stripe has room, but sends of different threads are received in
+ * no particular order. Otherwise the contract of kc_chan_make_mpmc() holds
+ * (it reports KC_CHAN_CAP_MPMC | KC_CHAN_CAP_STRIPED); len, select
+ * readiness and snapshots add up every stripe.
+ * @return 0 on success; -EINVAL or -ENOMEM on failure
+ */
+int  kc_chan_make_striped(kc_chan_t** out, size_t elem_sz, size_t capacity, unsigned stripes);
+
+/**
+ * @name Two-phase sends and receives (lock-free rings)
+ * kc_chan_reserve claims the next cell of a kc_chan_make_mpmc / _spsc /
+ * _striped channel and hands back its elem_sz bytes in slot->data, so a
+ * producer can build or read the element straight into the ring (say,
+ * read(2) into it) instead of into a buffer that a send then copies.
+ * kc_chan_commit publishes the cell and wakes a parked receiver.
+ * kc_chan_recv_peek is the mirror image: it claims the oldest element and
+ * lends it in place until kc_chan_recv_release gives the cell back to the
+ * producers.
+ *
+ * The _many variants claim a batch of up to max consecutive cells of one
+ * stripe (at least one; slot->n says how many) and commit or release them
+ * as one; kc_chan_slot_elem addresses the i-th, since a batch may wrap
+ * around the ring.
+ *
+ * A claim cannot be given back: every successful reserve must be
+ * committed and every peek released, and soon, since the other side waits
+ * behind a claimed cell (on an MPMC ring, cells claimed later are held back
+ * too). Do not park in between. On SPSC rings, finish one claim before the
+ * next on the same side. Commit after a close still delivers the elements;
+ * peek drains them before reporting KC_EPIPE.
+ *
+ * reserve/peek: 0, KC_EAGAIN/KC_ETIME when the ring stayed full (resp.
+ * empty), KC_EPIPE (closed), KC_ECANCELED, -EINVAL, or -ENOTSUP on
+ * channels without a ring. timeout_ms != 0 needs a coroutine, as for
+ * kc_chan_send / kc_chan_recv.
+ * @{ */
+typedef struct kc_chan_slot {
+    void    *data;    /* first claimed cell: elem_sz bytes */
+    size_t   n;       /* cells claimed (1 unless a _many call) */
+    size_t   pos;     /* ring position (internal) */
+    unsigned stripe;  /* ring stripe (internal) */
+} kc_chan_slot_t;
+
+int  kc_chan_reserve(kc_chan_t* ch, kc_chan_slot_t* slot, long timeout_ms);
+int  kc_chan_reserve_many(kc_chan_t* ch, kc_chan_slot_t* slot, size_t max, long timeout_ms);
+/** 0, or -EINVAL when slot does not come from kc_chan_reserve on ch. */
+int  kc_chan_commit(kc_chan_t* ch, const kc_chan_slot_t* slot);
+int  kc_chan_recv_peek(kc_chan_t* ch, kc_chan_slot_t* slot, long timeout_ms);
+int  kc_chan_recv_peek_many(kc_chan_t* ch, kc_chan_slot_t* slot, size_t max, long timeout_ms);
+/** 0, or -EINVAL when slot does not come from kc_chan_recv_peek on ch. */
+int  kc_chan_recv_release(kc_chan_t* ch, const kc_chan_slot_t* slot);
+/** Cell i (< slot->n) of a claim, NULL when out of range. */
+void* kc_chan_slot_elem(kc_chan_t* ch, const kc_chan_slot_t* slot, size_t i);
+/** @} */
+
+/** Shape of a durable channel's log (kc_chan_make_durable); zero fields take
+ *  the kcoro_config.h defaults. */
+typedef struct kc_chan_durable_opts {
+    size_t segment_bytes;    /**< log segment file size (KCORO_DURABLE_SEGMENT_BYTES) */
+    long   commit_window_ms; /**< group-commit window (KCORO_DURABLE_COMMIT_MS);
+                                  < 0: commit only in kc_chan_sync / destroy */
+} kc_chan_durable_opts_t;
+
+/**
+ * @brief Create a KC_UNLIMITED channel whose queue survives a restart.
+ * Every send appends its element to a write-ahead log in dir (created if
+ * missing) before queueing it; the log is committed with one fdatasync per
+ * commit window, so sends never wait for the disk. Receivers report the
+ * elements they are done with through kc_chan_ack; reopening dir after a
+ * crash or a plain destroy queues every element sent but not acknowledged,
+ * in order (at-least-once). Elements sent within the last commit window
+ * before a crash may be lost; kc_chan_sync closes that window on demand.
+ * The channel reports KC_CHAN_CAP_DURABLE; pointer and zero-copy modes are
+ * not available. One open channel per directory.
+ * @return 0; -EINVAL (bad args, or dir holds a log of another elem_sz),
+ *         -EBUSY (dir open elsewhere), -ENOMEM or -errno from the file system
+ */
+int  kc_chan_make_durable(kc_chan_t** out, const char* dir, size_t elem_sz,
+                          const kc_chan_durable_opts_t* opts);
+/** Acknowledge the n oldest received, not yet acknowledged elements of a
+ *  durable channel; they are dropped from the log at the next commit.
+ *  0, -EINVAL (not durable) or -ERANGE (fewer than n received). */
+int  kc_chan_ack(kc_chan_t* ch, size_t n);
+/** Commit a durable channel now: when this returns 0, every element sent
+ *  and every acknowledgement made before the call is on disk. From a
+ *  scheduler worker the caller moves to the blocking pool for the sync.
+ *  0, -EINVAL (not durable) or -errno from the first failed sync. */
+int  kc_chan_sync(kc_chan_t* ch);
+
+/**
+ * @name Batch send/receive
+ * Buffered and unlimited channels move each contiguous run under one lock
+ * acquisition with one stats update and one wake pass; other kinds fall back
+ * to per-element calls. timeout_ms applies to the whole batch.
+ * @{ */
+/** Send all n elements in order (elem_sz each), waiting while full.
+ *  Returns 0 once all are queued; otherwise the error that stopped the batch
+ *  (KC_EAGAIN/KC_ETIME/KC_EPIPE/...) with *sent = elements queued so far. */
+int  kc_chan_send_many(kc_chan_t* ch, const void* msgs, size_t n, long timeout_ms, size_t* sent);
+/** Wait for at least one element, then take up to max without waiting again.
+ *  Returns 0 with *got >= 1, or KC_EAGAIN/KC_ETIME/KC_EPIPE with *got = 0. */
+int  kc_chan_recv_many(kc_chan_t* ch, void* out, size_t max, long timeout_ms, size_t* got);
+/** @} */
+
 /**
  * @name Cancellable variants
  * These return KC_ECANCELED promptly when the token is triggered.
@@ -106,16 +308,48 @@ int  kc_chan_send_c(kc_chan_t* ch, const void* msg, long timeout_ms, const kc_ca
 int  kc_chan_recv_c(kc_chan_t* ch, void* out, long timeout_ms, const kc_cancel_t* cancel);
 /** @} */
 
-/* Non-blocking convenience wrappers */
-static inline int kc_chan_try_send(kc_chan_t* ch, const void* msg) {
-    return kc_chan_send(ch, msg, 0);
-}
-static inline int kc_chan_try_recv(kc_chan_t* ch, void* out) {
-    return kc_chan_recv(ch, out, 0);
-}
+/* Non-blocking send / recv: kc_chan_send / kc_chan_recv with timeout 0.
+ * On lock-free ring channels they go straight to the ring. */
+int  kc_chan_try_send(kc_chan_t* ch, const void* msg);
+int  kc_chan_try_recv(kc_chan_t* ch, void* out);
+
+/**
+ * @name Threads outside the scheduler
+ * kc_chan_send/kc_chan_recv may only wait in a coroutine (timeout_ms 0 works
+ * anywhere). These variants may also be called from any other thread, e.g.
+ * a library's callback thread: while the op would block, the thread queues
+ * itself on the channel's waiter list like a parked coroutine and sleeps on
+ * a condvar until a peer (coroutine or thread) pops it, or timeout_ms runs
+ * out. Same results as kc_chan_send/recv; in a coroutine they are the same
+ * call. Pointer and zero-copy channels are refused (-EINVAL).
+ * @{ */
+int  kc_chan_send_thread(kc_chan_t* ch, const void* msg, long timeout_ms);
+int  kc_chan_recv_thread(kc_chan_t* ch, void* out, long timeout_ms);
+/** kc_chan_send_many / kc_chan_recv_many from any thread: each run moves
+ *  under one lock acquisition, and a batch that stalls sleeps like
+ *  kc_chan_send_thread before it carries on. */
+int  kc_chan_send_many_thread(kc_chan_t* ch, const void* msgs, size_t n, long timeout_ms, size_t* sent);
+int  kc_chan_recv_many_thread(kc_chan_t* ch, void* out, size_t max, long timeout_ms, size_t* got);
+/** Fire-and-forget send for buffered and unlimited (mutex) channels, from
+ *  any thread: never waits and is lock-free while other posts are already
+ *  pending; only the poster that finds none takes the channel lock, to move
+ *  the pending elements in and wake receivers. Elements that find a
+ *  buffered channel full wait on the side (not counted by kc_chan_len) and
+ *  move in as receivers make room. Posts of one thread arrive in order;
+ *  against kc_chan_send from the same thread they may be reordered.
+ *  0, KC_EPIPE (seen closed; a post racing close is dropped and counted as
+ *  an EPIPE send), -ENOMEM, or -EINVAL (other kinds, rings, pointer/zref). */
+int  kc_chan_post(kc_chan_t* ch, const void* msg);
+/** @} */
 
 /* Actor API */
 typedef int (*kc_actor_fn)(const void* msg, void* user);
+/* n contiguous messages of msg_size bytes each */
+typedef int (*kc_actor_batch_fn)(const void* msgs, size_t n, void* user);
+typedef struct kc_actor_reply kc_actor_reply_t; /* one pending kc_actor_ask */
+/* Handles one kc_actor_ask: answer with kc_actor_reply; a negative return
+ * fails the ask with that code. */
+typedef int (*kc_actor_ask_fn)(const void* msg, kc_actor_reply_t* reply, void* user);
 
 typedef struct kc_actor_ctx {
     kc_chan_t   *chan;       /* channel to consume */
@@ -123,6 +357,18 @@ typedef struct kc_actor_ctx {
     int          timeout_ms; /* -1=forever, 0=nonblocking */
     kc_actor_fn  process;    /* called for each received message */
     void        *user;       /* opaque */
+    /* Throughput: a turn handles up to batch_max messages (0 = 1) or runs
+     * batch_us microseconds (0 = no limit), whichever ends first, then
+     * yields. process_batch, when set, replaces process and is handed the
+     * runs kc_chan_recv_many returns. */
+    size_t            batch_max;
+    long              batch_us;
+    kc_actor_batch_fn process_batch;
+    /* Request/reply: when ask is set the actor also serves kc_actor_ask,
+     * handing each ask message (msg_size bytes) to ask; replies are
+     * reply_size bytes. */
+    kc_actor_ask_fn   ask;
+    size_t            reply_size;
 } kc_actor_ctx_t;
 
 kc_actor_t kc_actor_start(const kc_actor_ctx_t* ctx);
@@ -138,6 +384,20 @@ kc_actor_t kc_actor_start_ex(const kc_actor_ctx_ex_t* ctx);
 void       kc_actor_cancel(kc_actor_t actor); /* triggers token if present, else fallback stop */
 void       kc_actor_on_done(kc_actor_t actor, void (*cb)(void *arg), void *arg);
 
+/** Send msg (msg_size bytes) to the actor's ask handler and wait for the
+ *  reply, copied into reply_buf (reply_size bytes). Costs one enqueue on
+ *  the actor's ask queue and one wake; the reply slot is pooled. Parks a
+ *  coroutine, blocks a thread. 0 once replied; the handler's negative
+ *  return; -ENOMSG if it returned without replying; KC_ETIME when
+ *  timeout_ms (< 0: none) passes first, after which a late reply is
+ *  dropped; KC_EPIPE once the actor has stopped; -ENOTSUP without an ask
+ *  handler; -EINVAL or -ENOMEM. Asks and mailbox messages are served in
+ *  the same turns but not ordered against each other. */
+int        kc_actor_ask(kc_actor_t actor, const void *msg, void *reply_buf, long timeout_ms);
+/** From the ask handler: copy reply_size bytes of data to the asker.
+ *  0, or -EALREADY on a second reply. */
+int        kc_actor_reply(kc_actor_reply_t *reply, const void *data);
+
 typedef int (*kc_producer_fn)(kc_chan_t *ch, void *user);
 typedef int (*kc_transform_fn)(const void *in, void *out, void *user);
 
@@ -152,6 +412,101 @@ int  kc_scope_wait_all(kc_scope_t *scope, long timeout_ms);
 void kc_scope_destroy(kc_scope_t *scope);
 const kc_cancel_t* kc_scope_token(const kc_scope_t *scope);
 
+/* Flows: a pipeline over a source channel, run as children of a scope.
+ * Stages are fused: consecutive stages run in one coroutine, one element
+ * call after another, with no channel between them. A channel only appears
+ * where the parallelism changes (into and out of kc_flow_parallel_map, at a
+ * merge, before a kc_flow_batch that follows parallel stages) and moves
+ * KCORO_FLOW_BATCH elements per transfer. Stages after a parallel map run
+ * in each of its coroutines, so order is only kept in flows without one.
+ *
+ * Build with kc_flow_create and the stage calls, then kc_flow_launch once;
+ * the scope's token stops the flow and kc_flow_destroy waits for it. */
+typedef struct kc_flow kc_flow_t;
+struct kc_chan_snapshot;
+
+/** Keep in (nonzero) or drop it (0). */
+typedef int (*kc_flow_pred_fn)(const void *in, void *user);
+/** Terminal stage: called for every element reaching it. */
+typedef void (*kc_flow_each_fn)(const void *in, void *user);
+
+/** Element of a kc_flow_batch stage: up to n input elements back to back. */
+typedef struct kc_flow_chunk {
+    size_t        count;
+    unsigned char items[];
+} kc_flow_chunk_t;
+#define KC_FLOW_CHUNK_SIZE(n, elem_sz) (sizeof(kc_flow_chunk_t) + (size_t)(n) * (elem_sz))
+
+/** src carries elem_sz elements; the flow ends when it is closed and
+ *  drained. 0, -EINVAL or -ENOMEM. */
+int  kc_flow_create(kc_flow_t **out, kc_scope_t *scope, kc_chan_t *src, size_t elem_sz);
+/** fn turns each element into an out_sz one; a nonzero return drops it.
+ *  Stage calls return the stage index (>= 0) for kc_flow_stage_snapshot,
+ *  -EINVAL, -EBUSY (launched or merged) or -ENOMEM. */
+int  kc_flow_map(kc_flow_t *f, kc_transform_fn fn, size_t out_sz, void *user);
+int  kc_flow_filter(kc_flow_t *f, kc_flow_pred_fn fn, void *user);
+/** Group n elements into one kc_flow_chunk_t (KC_FLOW_CHUNK_SIZE bytes);
+ *  the last chunk may hold fewer. */
+int  kc_flow_batch(kc_flow_t *f, size_t n);
+/** kc_flow_map on n coroutines fed through one channel (unordered). */
+int  kc_flow_parallel_map(kc_flow_t *f, int n, kc_transform_fn fn, size_t out_sz, void *user);
+int  kc_flow_each(kc_flow_t *f, kc_flow_each_fn fn, void *user);
+/** One flow over the outputs of flows[0..n) (same element size, same
+ *  scope), interleaved as they arrive. The inputs become part of it: launch
+ *  and destroy only the merged flow. 0, -EINVAL, -EBUSY or -ENOMEM. */
+int  kc_flow_merge(kc_flow_t **out, kc_flow_t *const *flows, int n);
+/** Start the flow. With out, the results arrive on a new KC_BUFFERED
+ *  channel of the given capacity (0: KCORO_FLOW_CHAN_CAP), closed when the
+ *  flow ends; the caller destroys it after kc_flow_destroy. Without out the
+ *  flow must end in kc_flow_each (or results are discarded).
+ *  0, -EINVAL, -EBUSY, -ENOMEM or the kc_scope_launch error. */
+int  kc_flow_launch(kc_flow_t *f, size_t capacity, kc_chan_t **out);
+/** A stage's traffic as a channel snapshot (total_recvs: elements in,
+ *  total_sends: elements out, bytes likewise, op times), for
+ *  kc_chan_compute_rate. 0 or -EINVAL. */
+int  kc_flow_stage_snapshot(kc_flow_t *f, int stage, struct kc_chan_snapshot *out);
+/** Wait for the flow's coroutines, then free it and its inner channels. */
+void kc_flow_destroy(kc_flow_t *f);
+
+/* Actor pools: n identical actors behind one address. Each member has its
+ * own KC_BUFFERED mailbox and runs as a kc_scope_actor of a scope the pool
+ * owns, so cancelling the parent token (or stopping the pool) ends them
+ * all. kc_actor_pool_send picks a member with the pool's router. */
+typedef struct kc_actor_pool kc_actor_pool_t;
+
+enum kc_actor_router {
+    KC_ACTOR_ROUTE_ROUND_ROBIN = 0,
+    KC_ACTOR_ROUTE_LEAST_LOADED,   /* shortest mailbox (kc_chan_len) */
+    KC_ACTOR_ROUTE_HASH            /* consistent hash of the send key */
+};
+
+typedef struct kc_actor_pool_ctx {
+    kc_actor_ctx_t      base;      /* chan ignored; user is passed through */
+    size_t              capacity;  /* per-member mailbox, 0 = 64 */
+    const kc_cancel_t  *cancel;    /* optional parent of the pool's scope */
+} kc_actor_pool_ctx_t;
+
+/* Per-member counters; sample twice for throughput. */
+struct kc_actor_pool_member_stats {
+    unsigned long routed;     /* messages kc_actor_pool_send delivered */
+    unsigned long processed;  /* messages handed to process/process_batch */
+    unsigned      queued;     /* mailbox length at snapshot time */
+};
+
+/** NULL on bad arguments (n == 0, no msg_size) or allocation failure. */
+kc_actor_pool_t* kc_actor_pool_start(const kc_actor_pool_ctx_t *ctx, size_t n, int router);
+/** Cancel every member, wait for them, free mailboxes; queued messages are dropped. */
+void   kc_actor_pool_stop(kc_actor_pool_t *pool);
+/** Send msg to the member the router picks for key (ignored unless
+ *  KC_ACTOR_ROUTE_HASH). Must run in a coroutine; kc_chan_send results. */
+int    kc_actor_pool_send(kc_actor_pool_t *pool, unsigned long key, const void *msg, long timeout_ms);
+/** Member kc_actor_pool_send would pick now, or -EINVAL. */
+int    kc_actor_pool_route(kc_actor_pool_t *pool, unsigned long key);
+size_t kc_actor_pool_size(const kc_actor_pool_t *pool);
+kc_chan_t* kc_actor_pool_mailbox(kc_actor_pool_t *pool, size_t member);
+/** Fill up to max entries, one per member; returns how many were written. */
+size_t kc_actor_pool_snapshot(kc_actor_pool_t *pool, struct kc_actor_pool_member_stats *out, size_t max);
+
 /* Select / multiplexing API */
 /** Select clause kinds for kc_select_t. */
 enum kc_select_clause_kind {
@@ -161,10 +516,154 @@ enum kc_select_clause_kind {
 
 int  kc_select_create(kc_select_t **out, const kc_cancel_t *cancel);
 void kc_select_destroy(kc_select_t *sel);
+/** Drop the clauses; their storage is kept, so a loop that resets and adds
+ *  the same clauses again does not allocate. */
 void kc_select_reset(kc_select_t *sel);
 int  kc_select_add_recv(kc_select_t *sel, kc_chan_t *chan, void *out);
 int  kc_select_add_send(kc_select_t *sel, kc_chan_t *chan, const void *msg);
+/** Hooks for a receive clause whose channel is filled from elsewhere, e.g.
+ *  a remote receive relayed into it (kc_ipc_select_add_recv). When no
+ *  clause is ready and the wait will park (timeout_ms != 0), arm(arg) runs
+ *  before any clause registers, so it may park itself; a nonzero return
+ *  ends the wait with that result for this clause. After a wait that armed
+ *  it, done(arg, won) runs once the registrations are gone; won says this
+ *  clause was taken. Either may be NULL. */
+struct kc_select_hooks {
+    int  (*arm)(void *arg);
+    void (*done)(void *arg, int won);
+};
+/** kc_select_add_recv with hooks; they must outlive the clause. */
+int  kc_select_add_recv_hooks(kc_select_t *sel, kc_chan_t *chan, void *out,
+                              const struct kc_select_hooks *hooks, void *arg);
+/** Wait for one clause (timeout_ms < 0: no deadline). Parks until a clause
+ *  completes, the deadline timer fires or the select's token is triggered:
+ *  the op result, KC_EAGAIN (timeout_ms 0), KC_ETIME or KC_ECANCELED. */
 int  kc_select_wait(kc_select_t *sel, long timeout_ms, int *selected_index, int *op_result);
+/** Fan-in harvest: complete every clause that is ready, not just one. A
+ *  probe pass takes each ready clause (in the policy's order, up to max);
+ *  only when none is does it register and park like kc_select_wait, then
+ *  sweeps the rest once more on wake. Writes the completed clause indices to
+ *  ready_indices and, when op_results is non-NULL, each op's result
+ *  (KC_EPIPE for a closed channel) to op_results; *n_ready gets the count.
+ *  The clauses stay added, so a loop calls it again without re-adding.
+ *  Returns 0 when at least one clause completed, else KC_EAGAIN
+ *  (timeout_ms 0), KC_ETIME, KC_ECANCELED or -EINVAL. */
+int  kc_select_wait_many(kc_select_t *sel, long timeout_ms, int *ready_indices, int *op_results,
+                         int max, int *n_ready);
+
+/** Which ready clause kc_select_wait takes when several are. */
+enum kc_select_policy {
+    KC_SELECT_POLICY_ORDERED = 0, /**< registration order (default) */
+    KC_SELECT_POLICY_RANDOM,      /**< random first clause per wait, like Go */
+    KC_SELECT_POLICY_ROUND_ROBIN, /**< start after the last winner */
+    KC_SELECT_POLICY_PRIORITY,    /**< highest kc_select_set_priority first; ties in order */
+};
+/** 0 or -EINVAL. Applies from the next wait; kept across kc_select_reset. */
+int  kc_select_set_policy(kc_select_t *sel, enum kc_select_policy policy);
+/** Priority of clause i (0 when added) for KC_SELECT_POLICY_PRIORITY.
+ *  0 or -EINVAL. */
+int  kc_select_set_priority(kc_select_t *sel, int clause_index, int priority);
+
+/** Per-clause counters, kept by clause position across kc_select_reset (a
+ *  loop re-adding the same clauses accumulates). */
+struct kc_select_clause_stats {
+    unsigned long wins;    /* waits this clause completed */
+    unsigned long first;   /* waits that probed this clause first */
+    int policy;            /* enum kc_select_policy of the last such wait */
+    int priority;
+};
+/** 0 or -EINVAL (bad index). */
+int  kc_select_get_clause_stats(const kc_select_t *sel, int clause_index,
+                                struct kc_select_clause_stats *out);
+
+/* Readiness sets: epoll for channels. A kc_chan_set_t watches any number of
+ * channels; a channel that changes state queues itself on the sets watching
+ * it, and kc_chan_set_wait pulls the ready list in O(ready) rather than
+ * probing every member. Readiness is re-checked when reported, so it is a
+ * hint to try the op with timeout 0, not a reservation. Memberships are
+ * level-triggered (reported on every wait while the channel stays ready)
+ * unless added with KC_CHAN_SET_EDGE (reported once per state change).
+ *
+ * A set belongs to one coroutine: add, remove and wait do not race each
+ * other, while channels signal it from anywhere. Remove a channel (or
+ * destroy the set) before destroying the channel; kc_chan_destroy detaches
+ * leftovers, which then never report. Rendezvous and zero-copy channels
+ * have no readiness state to watch and are refused. Ring channels in a set
+ * take their lock on every op to signal it. */
+typedef struct kc_chan_set kc_chan_set_t;
+
+#define KC_CHAN_SET_RECV   (1u << 0) /* an element to receive */
+#define KC_CHAN_SET_SEND   (1u << 1) /* room to send */
+#define KC_CHAN_SET_CLOSED (1u << 2) /* closed; always reported, with RECV|SEND */
+#define KC_CHAN_SET_EDGE   (1u << 3) /* kc_chan_set_add: edge-triggered */
+
+struct kc_chan_set_event {
+    kc_chan_t *ch;
+    void      *user;    /* as given to kc_chan_set_add */
+    unsigned   events;  /* KC_CHAN_SET_RECV/SEND/CLOSED */
+};
+
+/** cancel (optional) makes a parked kc_chan_set_wait return KC_ECANCELED. */
+int  kc_chan_set_create(kc_chan_set_t **out, const kc_cancel_t *cancel);
+void kc_chan_set_destroy(kc_chan_set_t *set);
+/** Watch ch for events (RECV and/or SEND, optionally | EDGE). Already ready
+ *  channels are reported by the next wait. 0, -EINVAL, -EEXIST, -ENOTSUP
+ *  or -ENOMEM. */
+int  kc_chan_set_add(kc_chan_set_t *set, kc_chan_t *ch, unsigned events, void *user);
+/** 0 or -ENOENT. */
+int  kc_chan_set_remove(kc_chan_set_t *set, kc_chan_t *ch);
+/** Fill up to max events and return how many (> 0), parking until one is
+ *  ready (timeout_ms < 0: no deadline). KC_EAGAIN (timeout_ms 0), KC_ETIME,
+ *  KC_ECANCELED or -EINVAL. Must run in a coroutine unless timeout_ms is 0. */
+int  kc_chan_set_wait(kc_chan_set_t *set, struct kc_chan_set_event *out, int max, long timeout_ms);
+
+/* Broadcast channels: fan-out without a send per subscriber. A kc_bcast_t
+ * is a ring of `capacity` messages written once per kc_bcast_send; each
+ * subscriber reads it through its own cursor, starting with the first
+ * message sent after it subscribed. What a subscriber that falls behind
+ * does is its own choice:
+ *   - KC_BCAST_SUSPEND: senders wait while it is `capacity` messages behind
+ *     (no loss; the slowest such subscriber paces the feed).
+ *   - KC_BCAST_DROP: it loses the oldest messages it has not read.
+ *   - KC_BCAST_CONFLATE: each recv returns the latest message.
+ * Without SUSPEND subscribers a send never waits. Each kc_bcast_sub_t is
+ * used by one coroutine at a time; any number may send. A waiting send or
+ * recv parks and must run in a coroutine. For payloads larger than a
+ * pointer send kc_bufpool buffers (kc_bcast_set_bufpool, kcoro_zcopy.h) so
+ * the payload is written once. */
+typedef struct kc_bcast kc_bcast_t;
+typedef struct kc_bcast_sub kc_bcast_sub_t;
+
+enum kc_bcast_overflow {
+    KC_BCAST_SUSPEND  = 0,
+    KC_BCAST_DROP     = 1,
+    KC_BCAST_CONFLATE = 2,
+};
+
+struct kc_bcast_sub_stats {
+    unsigned long received;
+    unsigned long dropped;    /* overwritten before this subscriber read them (DROP) */
+    unsigned long conflated;  /* skipped for a later message (CONFLATE) */
+    unsigned long lag;        /* sent messages this subscriber can still read */
+};
+
+/** 0, -EINVAL or -ENOMEM. */
+int  kc_bcast_make(kc_bcast_t **out, size_t elem_sz, size_t capacity);
+/** Frees subscriptions left over; nothing may be using b. */
+void kc_bcast_destroy(kc_bcast_t *b);
+/** Sends fail with KC_EPIPE from now on; subscribers drain what they can
+ *  still read, then get KC_EPIPE. */
+void kc_bcast_close(kc_bcast_t *b);
+/** Copy msg (elem_sz bytes) in once for every subscriber. 0, KC_EAGAIN
+ *  (timeout_ms 0), KC_ETIME, KC_EPIPE or -EINVAL. */
+int  kc_bcast_send(kc_bcast_t *b, const void *msg, long timeout_ms);
+/** 0, -EINVAL, -ENOMEM or KC_EPIPE (closed). */
+int  kc_bcast_subscribe(kc_bcast_t *b, kc_bcast_sub_t **out, enum kc_bcast_overflow policy);
+void kc_bcast_unsubscribe(kc_bcast_sub_t *sub);
+/** Next message for this subscriber. 0, KC_EAGAIN (timeout_ms 0), KC_ETIME,
+ *  KC_EPIPE (closed and read to the end) or -EINVAL. */
+int  kc_bcast_recv(kc_bcast_sub_t *sub, void *out, long timeout_ms);
+int  kc_bcast_sub_get_stats(const kc_bcast_sub_t *sub, struct kc_bcast_sub_stats *out);
 
 /* --- Zero-Copy Channel Extensions (Phase Z) ---------------------------------
  * Portable surface: these APIs do not expose platform‑specific kernel or
@@ -175,8 +674,8 @@ int  kc_select_wait(kc_select_t *sel, long timeout_ms, int *selected_index, int
  *  - Opt-in via channel capability flag; existing channels unchanged.
  *  - No implicit buffer allocation or free; ownership transfer contract is
  *    documented in design docs (Phase Z).
- *  - Region APIs are forward-declared; base implementation may return
- *    -ENOTSUP until a region backend is provided.
+ *  - Regions (kc_region_register) are process-wide; shared ones are memfd
+ *    mappings the IPC transport can hand to another process.
  */
 
 /* Capability flag query (bitmask). Additional flags may follow. */
@@ -195,6 +694,30 @@ unsigned kc_chan_capabilities(kc_chan_t *ch);
  * not payload copies; zref may route via backend when enabled.
  */
 #define KC_CHAN_CAP_PTR         (1u<<1)
+/**
+ * Channel is backed by the lock-free MPMC ring (kc_chan_make_mpmc).
+ */
+#define KC_CHAN_CAP_MPMC        (1u<<2)
+/**
+ * Channel is backed by the wait-free SPSC ring (kc_chan_make_spsc).
+ */
+#define KC_CHAN_CAP_SPSC        (1u<<3)
+/**
+ * Channel logs its queue to disk (kc_chan_make_durable).
+ */
+#define KC_CHAN_CAP_DURABLE     (1u<<4)
+/**
+ * Channel is spread over several MPMC rings (kc_chan_make_striped).
+ */
+#define KC_CHAN_CAP_STRIPED     (1u<<5)
+/**
+ * Channel delivers elements at their due time (KC_DELAYED, kc_chan_send_at).
+ */
+#define KC_CHAN_CAP_DELAYED     (1u<<6)
+/**
+ * Channel orders elements by priority level (KC_PRIORITY, kc_chan_send_prio).
+ */
+#define KC_CHAN_CAP_PRIORITY    (1u<<7)
 
 /* Zero-copy send/recv (rendezvous or buffered). Returns 0 on success, negative errno.
  * On success kc_chan_recv_zref stores pointer/length; caller owns pointer until
@@ -205,23 +728,139 @@ int kc_chan_send_zref_c(kc_chan_t *ch, void *ptr, size_t len, long timeout_ms, c
 int kc_chan_recv_zref(kc_chan_t *ch, void **out_ptr, size_t *out_len, long timeout_ms);
 int kc_chan_recv_zref_c(kc_chan_t *ch, void **out_ptr, size_t *out_len, long timeout_ms, const kc_cancel_t *cancel);
 
-/* Shared Region Registration (Phase Z.3+, forward declarations). A region is a
- * stable memory area whose pointer+offset can be handed off instead of copying.
- * Base implementation may stub these (return -ENOTSUP). */
+/* Shared Region Registration. A region is a stable memory area whose
+ * pointer+offset can be handed off instead of copying; reads and writes whose
+ * buffer lies inside one run as io_uring fixed-buffer ops (kcoro_io.h).
+ * Up to KCORO_REGION_MAX live regions; they may not overlap. */
 typedef struct kc_region kc_region_t; /* opaque */
 
 /**
- * Region flags (reserved for future NUMA/hugepage hints).
- * Placeholder for adapter‑specific policies; core treats KC_REGION_F_NONE as
- * the only defined value today.
+ * Region placement hints. Best effort: a hint the kernel refuses is dropped
+ * and kc_region_flags reports the ones that took effect.
+ * - KC_REGION_F_HUGEPAGE: back the region with huge pages. Regions kcoro maps
+ *   (kc_region_alloc, kc_region_create_shared_ex) try reserved hugetlb pages
+ *   first, then transparent huge pages, and round len up to a multiple of
+ *   KCORO_HUGEPAGE_SIZE; kc_region_register can only ask for transparent ones.
+ * - KC_REGION_F_NUMA(node): prefer memory on NUMA node 0..255; pages already
+ *   touched in a kc_region_register range are migrated there.
+ * KC_REGION_F_PINNED is a requirement, not a hint: the range is faulted in
+ * and mlock'ed (device DMA staging, no page faults on first touch), and the
+ * call fails with the mlock errno (-ENOMEM past RLIMIT_MEMLOCK, -EPERM)
+ * when that is refused. kc_region_register then wants addr and len on page
+ * boundaries (-EINVAL), since teardown unlocks whole pages; it unlocks the
+ * caller's range, even pages the caller had locked itself. Pinned regions
+ * are also offered to the registration hooks below.
  */
 #define KC_REGION_F_NONE        0u
+#define KC_REGION_F_HUGEPAGE    (1u<<0)
+#define KC_REGION_F_NUMA_SET    (1u<<1)
+#define KC_REGION_F_PINNED      (1u<<2)
+#define KC_REGION_F_NUMA(node)  (KC_REGION_F_NUMA_SET | (((unsigned)(node) & 0xffu) << 8))
+#define KC_REGION_F_NUMA_NODE(flags) (((flags) >> 8) & 0xffu)
 
+/* 0, -EINVAL (also for unknown flags), -EEXIST (overlaps a live region),
+ * -ENOSPC, or for KC_REGION_F_PINNED the mlock errno or a hook's code. */
 int  kc_region_register(kc_region_t **out, void *addr, size_t len, unsigned flags);
-int  kc_region_deregister(kc_region_t *reg); /* blocks until no in-flight refs */
-/* Optional: export an ID for IPC; -ENOTSUP if not implemented. */
+/* len bytes of new private anonymous memory, zero-filled and registered; the
+ * region owns the mapping and teardown unmaps it. 0, -EINVAL, -ENOSPC or the
+ * mmap errno. */
+int  kc_region_alloc(kc_region_t **out, size_t len, unsigned flags);
+/* KC_REGION_F_* hints in effect for reg. */
+unsigned kc_region_flags(const kc_region_t *reg);
+/* In-flight references: kc_region_get holders, and zref descriptors
+ * (kc_chan_send_desc and friends) whose payload lies in the region, from
+ * send until a receiver takes them or their channel is destroyed.
+ * kc_region_deregister stops new lookups at once and blocks until those
+ * drain; kc_region_retire returns at once and the last reference tears the
+ * region down, so a shared region may be unmapped as soon as its last
+ * descriptor is received. Both return 0 or -ENOENT (not live). */
+int  kc_region_deregister(kc_region_t *reg);
+int  kc_region_retire(kc_region_t *reg);
+/* Process-unique region ID (never reused) for IPC descriptors. */
 int  kc_region_export_id(const kc_region_t *reg, unsigned long *out_id);
 
+/* Shared regions: len bytes of a new memfd mapping (shm_open elsewhere),
+ * zero-filled and registered. kc_region_import maps a descriptor received
+ * from another process (SCM_RIGHTS) and takes it on success. Both kinds own
+ * their mapping: kc_region_deregister unmaps it and closes the descriptor.
+ * 0, -EINVAL, -ENOSPC, -ENOMEM or the mmap/memfd errno. */
+int  kc_region_create_shared(kc_region_t **out, size_t len);
+int  kc_region_create_shared_ex(kc_region_t **out, size_t len, unsigned flags);
+int  kc_region_import(kc_region_t **out, int fd, size_t len);
+/* The mapping's descriptor (owned by the region), -ENOTSUP for plain
+ * kc_region_register regions. */
+int  kc_region_fd(const kc_region_t *reg);
+void *kc_region_addr(const kc_region_t *reg, size_t *len);
+/* The live region with this export ID, held until kc_region_put
+ * (kc_region_deregister waits); NULL when there is none. */
+kc_region_t *kc_region_get(unsigned long id);
+void kc_region_put(kc_region_t *reg);
+
+/* Registration hooks, for device backends that register pinned memory with
+ * their driver (an RDMA memory region, a GPU host registration) so zref
+ * descriptors into it are DMA-ready. on_register runs for every
+ * KC_REGION_F_PINNED region before its registering call returns, and may
+ * leave a per-region pointer in *data (kc_region_hook_data reads it back,
+ * e.g. to find a memory key for a received descriptor); a nonzero result
+ * fails the registration with that code. on_deregister runs once the
+ * region has drained, before it is unmapped or unlocked, for every hook
+ * whose on_register accepted it. Both run with no kcoro lock held and may
+ * not register or tear down regions. Regions live when a hook set is added
+ * are not offered to it. */
+typedef struct kc_region_hooks {
+    int  (*on_register)(void *arg, kc_region_t *reg, void **data);
+    void (*on_deregister)(void *arg, kc_region_t *reg, void *data);
+} kc_region_hooks_t;
+
+/* A hook ID >= 0, -EINVAL or -ENOSPC (KCORO_REGION_HOOKS_MAX). */
+int   kc_region_hooks_add(const kc_region_hooks_t *hooks, void *arg);
+/* 0 or -ENOENT. Call it once the backend's regions are gone: regions it
+ * still accepted are no longer reported to it, but a teardown already
+ * under way may still call it. */
+int   kc_region_hooks_remove(int id);
+void *kc_region_hook_data(const kc_region_t *reg, int id);
+
+/* Scheduler lane (kc_lane_t in kcoro_sched.h) for coroutines this channel
+ * wakes, e.g. KC_LANE_INTERACTIVE on a heartbeat channel read by bulk
+ * workers. KC_LANE_INHERIT (the default) keeps each coroutine's own lane.
+ * Returns 0 or -EINVAL. */
+int  kc_chan_set_wake_lane(kc_chan_t *ch, int lane);
+
+/* Where the coroutines a channel wakes resume (soft worker affinity).
+ * KC_AFFINITY_WAKER (the default) queues them on the waking worker.
+ * KC_AFFINITY_FOLLOW_PRODUCER does so for receivers but sends woken senders
+ * back to the worker they last ran on, so a consumer is pulled to its
+ * producer's worker and the pair settles there, sharing its cache.
+ * KC_AFFINITY_HOME sends every woken coroutine back to its last worker.
+ * A worker with a backlog still lets idle ones steal. Returns 0 or -EINVAL. */
+#define KC_AFFINITY_WAKER           0
+#define KC_AFFINITY_FOLLOW_PRODUCER 1
+#define KC_AFFINITY_HOME            2
+int  kc_chan_set_affinity(kc_chan_t *ch, int mode);
+
+/* Direct handoff for request/response over a KC_RENDEZVOUS channel. When on,
+ * a blocking kc_chan_recv parks with its destination buffer, and a
+ * kc_chan_send that finds such a receiver copies into that buffer and runs
+ * the receiver at once on the sender's worker (kc_sched_handoff); the sender
+ * resumes from that worker's runnext slot when the receiver switches out.
+ * Nothing passes through ch->slot or a ready queue. A KCORO_STACK_SHARED
+ * receiver never parks with its buffer (its stack is swapped out while it
+ * is parked) and receives as on a plain channel. Returns 0, or -EINVAL for
+ * other channel kinds and pointer / zero-copy channels. */
+int  kc_chan_set_handoff(kc_chan_t *ch, int on);
+
+/* Wake coalescing for a buffered channel (interrupt moderation): a put that
+ * finds a parked receiver does not wake it until max_batch elements have
+ * been put since the first, or max_delay_us have passed since the first,
+ * whichever comes first. Pair it with kc_chan_recv_many so the receiver
+ * drains the run in one go. The delay rides the scheduler's timer wheel,
+ * so it is rounded up to whole milliseconds (a receiver's own, earlier
+ * deadline still wins). Receivers that cannot be held (select, thread ops)
+ * and channels in a readiness set are woken at once. max_batch <= 1 or
+ * max_delay_us <= 0 turns it off and releases a held wake. Returns 0, or
+ * -EINVAL for rendezvous, conflated, delayed and pointer channels. */
+int  kc_chan_set_coalesce(kc_chan_t *ch, unsigned max_batch, long max_delay_us);
+
 /* Associate a channel with zero-copy capability after creation (optional).
  * Returns 0 if enabled, -EINVAL if channel kind incompatible, -EBUSY if already in use. */
 int  kc_chan_enable_zero_copy(kc_chan_t *ch);
@@ -234,6 +873,10 @@ struct kc_chan_zstats {
     unsigned long zref_fallback_capacity;
     unsigned long zref_canceled;
     unsigned long zref_aborted_close;
+    /* kc_bufpool bound with kc_chan_set_bufpool (0 when none) */
+    unsigned long pool_hits;    /* gets served from a thread cache */
+    unsigned long pool_misses;  /* gets that went to the depot */
+    unsigned long pool_empty;   /* gets that found no free buffer */
 };
 int kc_chan_get_zstats(kc_chan_t *ch, struct kc_chan_zstats *out);
 
@@ -267,6 +910,11 @@ int kc_chan_recv_ptr(kc_chan_t *ch, void **out_ptr, size_t *out_len, long timeou
 int kc_chan_send_ptr_c(kc_chan_t *ch, void *ptr, size_t len, long timeout_ms, const kc_cancel_t *cancel);
 int kc_chan_recv_ptr_c(kc_chan_t *ch, void **out_ptr, size_t *out_len, long timeout_ms, const kc_cancel_t *cancel);
 
+/* Batch variants for descriptor arrays; semantics of kc_chan_send_many /
+ * kc_chan_recv_many, bytes accounted by each len (every len must be > 0). */
+int kc_chan_send_ptr_many(kc_chan_t *ch, const struct kc_chan_ptrmsg *msgs, size_t n, long timeout_ms, size_t *sent);
+int kc_chan_recv_ptr_many(kc_chan_t *ch, struct kc_chan_ptrmsg *out, size_t max, long timeout_ms, size_t *got);
+
 /** @name Channel throughput statistics */
 struct kc_chan_stats {
     unsigned long total_sends;        /* Total successful sends */
@@ -284,7 +932,29 @@ struct kc_chan_stats {
 int kc_chan_get_stats(kc_chan_t *ch, struct kc_chan_stats *out);
 
 /**
- * @brief Comprehensive instantaneous snapshot (low overhead lock + memcpy).
+ * How much a channel records per successful op. Failure counters are always
+ * kept; lock-free ring channels derive totals from their cursors at any level.
+ * - OFF: nothing; total_* and timestamps stay where they were.
+ * - COUNTERS: total_* only; no clock read.
+ * - FULL (default): also first/last op time, from a coarse per-thread clock
+ *   (see KCORO_COARSE_CLOCK_READS).
+ * New channels take channel.stats_level from kcoro_config_runtime.h.
+ */
+enum kc_chan_stats_level {
+    KC_CHAN_STATS_OFF = 0,
+    KC_CHAN_STATS_COUNTERS = 1,
+    KC_CHAN_STATS_FULL = 2,
+};
+/** 0, or -EINVAL for a NULL channel or unknown level. */
+int kc_chan_set_stats_level(kc_chan_t *ch, int level);
+
+/**
+ * @brief Comprehensive instantaneous snapshot, taken without the channel
+ * lock so sampling never stalls senders or receivers. The send and the
+ * receive counters each come as a consistent set (a seqlock per side,
+ * retried by the reader only), with total_sends never behind total_recvs;
+ * the other fields are individually current. kc_chan_get_stats and
+ * kc_chan_len are lock-free too.
  * Fail‑fast policy: this struct must always be available to dependents; no
  * conditional fallback allowed.
  */
@@ -305,6 +975,7 @@ struct kc_chan_snapshot {
     int           closed;           /* 1 if closed */
     int           zref_mode;        /* 1 if zero-copy path engaged */
     int           ptr_mode;         /* 1 if pointer-descriptor channel */
+    int           stats_level;      /* enum kc_chan_stats_level */
 
     /* Success counters */
     unsigned long total_sends;
@@ -332,6 +1003,31 @@ struct kc_chan_snapshot {
     unsigned long rv_cancels;
     unsigned long rv_zdesc_matches;
 
+    /* Ops blocked in send/recv right now (copy and pointer paths; select
+     * and zref waits are not counted) */
+    unsigned      send_waiters;
+    unsigned      recv_waiters;
+
+    /* KC_UNLIMITED spill (kc_chan_set_spill): payload bytes on file now,
+     * segments written out and read back so far */
+    size_t        spilled_bytes;
+    unsigned long spill_writes;
+    unsigned long spill_reads;
+
+    /* KC_PRIORITY: queued elements per level (0 lowest) */
+    size_t        prio_depth[KC_CHAN_PRIO_LEVELS];
+
+    /* Wake coalescing (kc_chan_set_coalesce): receiver wakes held back, and
+     * puts that closed a window with a wake (windows that ran out wake the
+     * receiver by its timer and are not counted) */
+    unsigned long coalesce_held;
+    unsigned long coalesce_flushes;
+
+    /* Spin-before-park (KCORO_CHAN_SPIN_NS): blocking ops the channel became
+     * ready for while they spun, and spins that ran out and went on to park */
+    unsigned long spin_wins;
+    unsigned long spin_parks;
+
     /* Derived */
     double        duration_sec;
 };
@@ -377,16 +1073,139 @@ int kc_chan_compute_rate(const struct kc_chan_snapshot *prev,
                          const struct kc_chan_snapshot *curr,
                          struct kc_chan_rate_sample *out);
 
+/* ----------------------------- Latency histograms -----------------------------
+ * Log-linear (HDR-style) histograms of nanosecond latencies: values below 16
+ * get a bucket each, every power of two above is split into 8 buckets, so a
+ * bucket's width is at most 1/8 of its lower bound. Values of 2^40 ns
+ * (~18 min) and more land in the last bucket; max_ns keeps the exact value.
+ * Recording is lock-free into per-worker shards and merged on read.
+ */
+#define KC_HIST_BUCKETS (16 + 36 * 8)
+
+struct kc_hist {
+    unsigned long count;
+    unsigned long sum_ns;
+    unsigned long min_ns;   /* 0 when count == 0 */
+    unsigned long max_ns;
+    unsigned long buckets[KC_HIST_BUCKETS];
+};
+
+/** Bucket holding ns. */
+int kc_hist_bucket(unsigned long ns);
+/** Smallest and largest value that land in bucket i. */
+unsigned long kc_hist_bucket_lo(int i);
+unsigned long kc_hist_bucket_hi(int i);
+/** Upper bound (clamped to max_ns) of the bucket holding quantile q in
+ *  [0, 1], e.g. 0.99 for p99; 0 for an empty histogram. */
+unsigned long kc_hist_quantile(const struct kc_hist *h, double q);
+/** Mean in ns (0 when empty). */
+double kc_hist_mean(const struct kc_hist *h);
+
+/* Per-channel latency histograms, off by default:
+ *  - queue:     enqueue to dequeue of each element. Buffered and unlimited
+ *               (mutex) channels only; rendezvous hand-offs never queue and
+ *               conflated and lock-free ring channels leave it empty.
+ *  - send_park, recv_park: time a send / recv spent blocked, one sample
+ *               per op that had to wait, from its first wait until it
+ *               returned (timeouts and closes included).
+ * Enabling costs a clock read per op (two per parked op). Elements already
+ * queued when latency is switched on are not counted. */
+struct kc_chan_latency {
+    struct kc_hist queue;
+    struct kc_hist send_park;
+    struct kc_hist recv_park;
+};
+
+/** Switch latency recording on (1) or off (0). 0, -EINVAL, or -ENOMEM. */
+int kc_chan_set_latency(kc_chan_t *ch, int on);
+/** Merge the histograms into out; with reset set, recording restarts from
+ *  zero (samples racing the call land in one interval or the next, never
+ *  both). 0, -EINVAL, or -ENOENT when latency was never enabled. */
+int kc_chan_get_latency(kc_chan_t *ch, struct kc_chan_latency *out, int reset);
+
+/* Traffic recording (kc_chan_rec.c): every channel op issued while a
+ * recording runs is logged as one 32-byte kc_chan_rec into a buffer of the
+ * calling thread, which its owner appends to the file when full; stop
+ * writes what is left. Off, an op pays one relaxed load and a predicted
+ * branch; on, two clock reads and a record. Copy sends and receives (plain,
+ * try, prio, thread, batched), pointer sends and receives and close are
+ * recorded; select, reserve/commit, post and zero-copy ops are not.
+ * bench/kcreplay plays a file back against another configuration.
+ *
+ * File: a kc_chan_rec_header, then records in flush order (each thread's
+ * records in issue order). The first op on a channel within a recording
+ * is preceded by its KC_CHAN_REC_CHAN record; each thread's first record
+ * is a KC_CHAN_REC_THREAD. */
+#define KC_CHAN_REC_MAGIC   "KCCHREC"
+#define KC_CHAN_REC_VERSION 1
+
+enum kc_chan_rec_op {
+    KC_CHAN_REC_CHAN = 1,   /* descriptor: count = capacity, bytes = elem_sz, rc = kind,
+                               co = KC_CHAN_CAP_* bits, dur_ns = ring stripes */
+    KC_CHAN_REC_THREAD,     /* thread = its number in the file, count = worker index + 1
+                               (0 outside a scheduler) */
+    KC_CHAN_REC_SEND,       /* count = elements moved, bytes = their size */
+    KC_CHAN_REC_RECV,
+    KC_CHAN_REC_TRY_SEND,   /* timeout 0 */
+    KC_CHAN_REC_TRY_RECV,
+    KC_CHAN_REC_SEND_MANY,
+    KC_CHAN_REC_RECV_MANY,
+    KC_CHAN_REC_SEND_PTR,   /* bytes = descriptor length */
+    KC_CHAN_REC_RECV_PTR,
+    KC_CHAN_REC_CLOSE,
+};
+
+struct kc_chan_rec_header {
+    char     magic[8];      /* KC_CHAN_REC_MAGIC */
+    uint32_t version;       /* KC_CHAN_REC_VERSION */
+    uint32_t rec_size;      /* sizeof(struct kc_chan_rec) */
+    uint64_t start_ns;      /* CLOCK_MONOTONIC at kc_chan_rec_start */
+};
+
+struct kc_chan_rec {
+    uint64_t t_ns;          /* op issued, ns since start_ns */
+    uint32_t dur_ns;        /* issue to return, saturated */
+    uint32_t chan;          /* channel number in this file, from 1 */
+    uint32_t co;            /* coroutine id (low bits), 0 on a plain thread */
+    uint32_t count;
+    uint32_t bytes;
+    uint16_t thread;        /* recording thread, from 1 */
+    uint8_t  op;            /* enum kc_chan_rec_op */
+    int8_t   rc;            /* op result (0, KC_EAGAIN, KC_ETIME, KC_EPIPE, ...) */
+};
+
+/** Start recording into path (created or truncated). events_per_thread is
+ *  the buffer each thread fills before it writes (0: KCORO_CHAN_REC_EVENTS,
+ *  rounded up to a power of two); the owner's write blocks that thread, so
+ *  larger buffers mean rarer, longer stalls. 0, -EBUSY when already
+ *  recording, -EINVAL or -errno from open. */
+int  kc_chan_rec_start(const char *path, size_t events_per_thread);
+/** Write every thread's remaining records and close the file. Ops racing
+ *  the stop may be left out. 0, or the first write error as -errno. */
+int  kc_chan_rec_stop(void);
+int  kc_chan_rec_active(void);
+
+typedef struct {
+    unsigned long events;    /* recorded since kc_chan_rec_start */
+    unsigned long written;   /* of those, in the file */
+    unsigned long dropped;   /* lost to write errors */
+    unsigned long channels;  /* descriptors recorded */
+    unsigned long threads;   /* buffers in the current recording */
+} kc_chan_rec_stats_t;
+void kc_chan_rec_get_stats(kc_chan_rec_stats_t *out);
+
 /* ------------------------- Metrics Pipe (Phase M1) -------------------------
  * Optional per-channel live metrics event stream. When enabled, the channel
- * pushes periodic aggregate+delta events into an internal buffered channel.
- * Overhead when disabled: one NULL branch per send/recv fast-path.
+ * is registered with a metrics sampler: a coroutine on the default scheduler
+ * that wakes every channel.metrics.sample_ms (kcoro_config_runtime.h) and
+ * pushes aggregate+delta events into an internal buffered channel. Sends and
+ * recvs only count; a slow or absent pipe reader never delays them (a full
+ * pipe drops the event and the next one carries the whole delta).
  *
- * Emission policy (initial implementation): emit when either:
- *   - (delta_sends + delta_recvs) >= KC_CHAN_METRICS_EMIT_MIN_OPS, OR
- *   - now - last_emit_time_ns >= KC_CHAN_METRICS_EMIT_MIN_NS
- * Constants are intentionally conservative to cap overhead; future phases
- * may expose tuning knobs or adaptive heuristics.
+ * A channel gets an event on a sampler pass when it moved anything since its
+ * last event and either:
+ *   - (delta_sends + delta_recvs) >= channel.metrics.emit_min_ops, OR
+ *   - now - last emit >= channel.metrics.emit_min_ms
  */
 struct kc_chan_metrics_event {
     void         *chan;              /* identity (raw pointer) */
@@ -0,0 +1,66 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+/* Bump allocation.
+ *
+ * An arena hands out memory by advancing a pointer through malloc'd chunks
+ * (KCORO_ARENA_CHUNK bytes unless created otherwise) and frees it all at
+ * once: kc_arena_reset, kc_arena_rewind back to a kc_arena_mark, or
+ * kc_arena_destroy. There is no per-allocation free. Allocations are
+ * 16-byte aligned; one larger than a quarter chunk gets a chunk of its own
+ * so it does not strand the rest of the current one.
+ *
+ * Arenas are single-owner unless created with KC_ARENA_F_SHARED, which
+ * serializes allocations behind a lock. Two arenas come ready-made:
+ *
+ * - kc_arena_local: the calling thread's arena (each scheduler worker has
+ *   its own), for scratch that does not outlive the current call. Coroutines
+ *   on one worker share it, so never hold its memory, or a mark, across a
+ *   yield, park or blocking channel op: another coroutine may rewind it.
+ * - kc_scope_arena: shared, owned by a kc_scope_t and freed wholesale by
+ *   kc_scope_destroy, for state that lives as long as the scope's children.
+ *   The scope also draws its own child records from it. */
+
+#include <stddef.h>
+#include "kcoro.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct kc_arena kc_arena_t;
+
+/* Position for kc_arena_rewind (opaque). */
+typedef struct kc_arena_mark {
+    void  *chunk, *big;
+    size_t used, total;
+} kc_arena_mark_t;
+
+#define KC_ARENA_F_SHARED 1u   /* allocations from several threads */
+
+/** chunk_size 0 takes KCORO_ARENA_CHUNK. 0, -EINVAL or -ENOMEM. */
+int   kc_arena_create(kc_arena_t **out, size_t chunk_size, unsigned flags);
+void  kc_arena_destroy(kc_arena_t *a);
+/** len bytes (len 0 counts as 1), or NULL when out of memory. */
+void *kc_arena_alloc(kc_arena_t *a, size_t len);
+/** kc_arena_alloc, zero-filled. */
+void *kc_arena_calloc(kc_arena_t *a, size_t n, size_t size);
+/** Free everything; the first chunk stays for reuse. */
+void  kc_arena_reset(kc_arena_t *a);
+kc_arena_mark_t kc_arena_mark(kc_arena_t *a);
+/** Free everything allocated since m was taken. */
+void  kc_arena_rewind(kc_arena_t *a, kc_arena_mark_t m);
+/** Bytes handed out since creation or the last reset/rewind. */
+size_t kc_arena_used(kc_arena_t *a);
+
+/** The calling thread's arena, created on first use and freed when the
+ *  thread exits; NULL when it cannot be created. */
+kc_arena_t *kc_arena_local(void);
+
+/** The scope's shared arena, created on first use and freed by
+ *  kc_scope_destroy; NULL when it cannot be created. */
+kc_arena_t *kc_scope_arena(kc_scope_t *scope);
+
+#ifdef __cplusplus
+}
+#endif
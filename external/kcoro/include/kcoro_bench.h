@@ -36,6 +36,9 @@ typedef struct kc_bench_params {
     int     spin_iters;         /* spin attempts before yield on EAGAIN */
     size_t  packet_size;        /* logical payload size (bytes) for ptr-mode */
     int     pointer_mode;       /* 1 = pointer-descriptor mode, 0 = int payload */
+    int     mpmc;               /* 1 = lock-free MPMC ring (kc_chan_make_mpmc, int payload) */
+    int     spsc;               /* 1 = wait-free SPSC ring (kc_chan_make_spsc, int payload, 1x1) */
+    double  rate;               /* open loop: target sends/s over all producers (0 = closed loop) */
 } kc_bench_params_t;
 
 /* Starts a channel benchmark workload as coroutines on kc_sched_default().
@@ -44,9 +47,54 @@ int kc_bench_chan_start(const kc_bench_params_t *p,
                         kc_bench_handle_t **out_handle,
                         kc_chan_t **out_chan);
 
+/* Open loop (rate > 0): producers ignore packets_per_cycle and spin_iters
+ * and send on a fixed schedule, parking on scheduler timers in between;
+ * each message carries its scheduled send time (a 64-bit element, or the
+ * first 8 bytes of the packet in pointer mode) and sends block when the
+ * channel is full, so a backlog counts as latency. Consumers record
+ * scheduled-send-to-receive latency. */
+
+/* Send-to-receive latency since start or the last resetting read.
+ * 0, -EINVAL, or -ENOENT for a closed-loop run. */
+struct kc_hist;
+int kc_bench_chan_latency(kc_bench_handle_t *h, struct kc_hist *out, int reset);
+
 /* Signals shutdown, closes channel, joins coroutines, and destroys resources. */
 void kc_bench_chan_stop(kc_bench_handle_t *h);
 
+/* Hardware/software counters for a benchmark run (Linux perf_event_open).
+ *
+ * kc_bench_perf_open opens every counter it can on every thread of the
+ * process (start the scheduler first), inheriting into threads created
+ * afterwards, and counts user and, when perf_event_paranoid allows it,
+ * kernel time. kc_bench_perf_start marks a point and kc_bench_perf_read the
+ * totals since then, scaled for multiplexing. Counters the kernel or the PMU
+ * refuses (VMs, paranoid settings) are left out of `valid`; when none open,
+ * or off Linux, open returns -ENOTSUP (or the kernel's -EACCES). */
+enum kc_bench_perf_counter {
+    KC_BENCH_PERF_CYCLES = 0,
+    KC_BENCH_PERF_INSTRUCTIONS,
+    KC_BENCH_PERF_L1D_MISSES,       /* L1 data read misses */
+    KC_BENCH_PERF_LLC_MISSES,       /* last-level cache misses */
+    KC_BENCH_PERF_BRANCH_MISSES,
+    KC_BENCH_PERF_CTX_SWITCHES,     /* kernel context switches (software) */
+    KC_BENCH_PERF_COUNT
+};
+
+typedef struct kc_bench_perf kc_bench_perf_t; /* opaque */
+
+typedef struct kc_bench_perf_sample {
+    uint64_t value[KC_BENCH_PERF_COUNT];
+    unsigned valid;              /* bit (1u << counter) set when value is meaningful */
+} kc_bench_perf_sample_t;
+
+int  kc_bench_perf_open(kc_bench_perf_t **out);
+int  kc_bench_perf_start(kc_bench_perf_t *p);
+int  kc_bench_perf_read(kc_bench_perf_t *p, kc_bench_perf_sample_t *out);
+void kc_bench_perf_close(kc_bench_perf_t *p);
+/* Short name ("cycles", "instructions", "l1d_misses", ...), NULL if out of range. */
+const char *kc_bench_perf_name(int counter);
+
 #ifdef __cplusplus
 }
 #endif
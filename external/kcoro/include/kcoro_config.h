@@ -14,12 +14,78 @@
  *   Used by core library:
  *     - KCORO_CANCEL_SLICE_MS: slice cadence for cancellable ops when backends
  *       lack a native cancellable primitive.
- *     - KCORO_UNLIMITED_INIT_CAP: initial capacity when KC_UNLIMITED first
- *       grows.
+ *     - KCORO_UNLIMITED_INIT_CAP: segment size of KC_UNLIMITED channels
+ *       created with capacity 0.
+ *     - KCORO_UNLIMITED_SEG_CACHE: drained segments an unlimited channel keeps.
+ *     - KCORO_DURABLE_SEGMENT_BYTES / KCORO_DURABLE_COMMIT_MS: log segment
+ *       file size and group-commit window of kc_chan_make_durable.
+ *     - KCORO_COARSE_CLOCK_READS: reads served per refresh of the coarse
+ *       clock behind channel timing stats (kc_timer.c).
+ *     - KCORO_CLOCK_CALIB_MS / KCORO_CLOCK_RESYNC_MS: TSC calibration window
+ *       and resync period of the runtime clock (kc_clock.c).
+ *     - KCORO_METRICS_MAX: channels plus schedulers the metrics registry
+ *       holds (kc_metrics.c).
+ *     - KCORO_CO_STATS: per-coroutine run/park accounting (kcoro_stats),
+ *       off by default.
+ *     - KCORO_LOCK_PROF: per-call-site KC_MUTEX contention counters
+ *       (kcoro_lockprof.h), off by default.
+ *     - KCORO_FAST_SWITCH: ret-based kcoro_switch (kc_ctx_switch_fast.S),
+ *       off by default.
+ *     - KCORO_STACK_CLASS_MIN / KCORO_STACK_CACHE_PER_THREAD /
+ *       KCORO_STACK_DEPOT_MAX: coroutine stack pool shape and high-water marks.
+ *     - KCORO_STACK_DEFAULT_SIZE / KCORO_STACK_GUARD_PAGES: default stack
+ *       reservation and the PROT_NONE guard below each stack.
+ *     - KCORO_STACK_TUNE_SITES / KCORO_STACK_TUNE_SAMPLES /
+ *       KCORO_STACK_TUNE_HEADROOM: per-spawn-site stack sizing
+ *       (kcoro_stack_autotune).
+ *     - KCORO_CORO_SLAB / KCORO_CORO_CACHE_PER_THREAD / KCORO_ID_BATCH:
+ *       kcoro_t slab shape and per-thread coroutine ID reservations.
+ *     - KCORO_JOB_CACHE_PER_THREAD: freed kc_job_t blocks a thread keeps
+ *       for reuse (kc_job.c).
+ *     - KCORO_TASK_GROUP_CACHE_PER_THREAD: the same for task group member
+ *       records (kc_task_group.c).
+ *     - KCORO_DEFERRED_CACHE_PER_THREAD: the same for kc_deferred_t blocks
+ *       (kc_deferred.c).
+ *     - KCORO_ACTOR_REPLY_CACHE_PER_THREAD: the same for kc_actor_ask reply
+ *       slots (kc_actor.c).
+ *     - KCORO_TICKET_MAX / KCORO_TICKET_CACHE_PER_THREAD: live kc_ticket
+ *       slots and the free ones a thread keeps (kc_ticket.c).
+ *     - KCORO_SHARED_STACKS / KCORO_SHARED_STACK_SIZE: stacks used by
+ *       KCORO_STACK_SHARED (copy-on-switch) coroutines.
+ *     - KCORO_BLOCKING_MAX_THREADS / KCORO_BLOCKING_IDLE_MS: size cap and
+ *       idle retirement of the elastic blocking pool (kc_blocking.c).
+ *     - KCORO_REACTOR_EVENTS: readiness events the I/O poller takes per wait
+ *       (kc_reactor.c).
+ *     - KCORO_URING_ENTRIES / KCORO_URING_BATCH: per-worker io_uring size and
+ *       submit batching (kc_uring.c).
+ *     - KCORO_REGION_MAX: live kc_region_register regions (kc_zcopy.c).
+ *     - KCORO_REGION_HOOKS_MAX: device backends watching pinned regions
+ *       (kc_zcopy.c).
+ *     - KCORO_HUGEPAGE_SIZE: huge page size that KC_REGION_F_HUGEPAGE
+ *       rounds and aligns to (kc_zcopy.c, kcoro_stack.c).
+ *     - KCORO_ARENA_CHUNK: default kc_arena chunk size (kc_arena.c).
+ *     - KCORO_BUFPOOL_CACHES / KCORO_BUFPOOL_CACHE: per-thread cache slots of
+ *       each kc_bufpool and the free buffers each slot holds (kc_bufpool.c).
+ *     - KCORO_FLOW_BATCH / KCORO_FLOW_CHAN_CAP: elements a kc_flow segment
+ *       moves per channel transfer and the capacity of the channels between
+ *       segments (kc_flow.c).
  *
  *   Used by lab/tools (not by core):
  *     - KCORO_IPC_BACKLOG: listen backlog in sample IPC tool.
+ *     - KCORO_IPC_PIPELINE: parked requests per kc_ipc_server_serve connection.
+ *     - KCORO_IPC_WINDOW: default in-flight requests per kc_ipc_mux client.
  *     - KCORO_IPC_MAX_TLV_ELEM: TLV element size bound in IPC transport.
+ *     - KCORO_IPC_MAX_FRAME: largest frame payload the IPC transport carries.
+ *     - KCORO_IPC_TXQ: frames one IPC connection stages for a single flush.
+ *     - KCORO_IPC_SHM / KCORO_IPC_SHM_RING: shared-memory rings for IPC
+ *       connections and their size.
+ *     - KCORO_IPC_LZ4 / KCORO_IPC_LZ4_MIN: LZ4 compression of TCP IPC
+ *       connections and the smallest flush it packs.
+ *     - KCORO_IPC_FIXED: fixed-layout (non-TLV) hot channel commands over IPC.
+ *     - KCORO_IPC_REGIONS: shared regions one IPC connection passes each way.
+ *     - KCORO_IPC_CREDITS: send credits one IPC channel handle holds at most.
+ *     - KCORO_IPC_ACTOR_BATCH: messages a remote actor reference ships per
+ *       round trip.
  *
  * Production policy
  *   If you export an “installed” header set, you may keep this file as part of
@@ -40,16 +106,483 @@
 #define KCORO_CANCEL_SLICE_MS 50
 #endif
 
-/* Initial capacity for UNLIMITED channels when first growth triggers. */
+/* Segment size (elements) for UNLIMITED channels created with capacity 0. */
 /**
- * Initial ring capacity chosen when KC_UNLIMITED first grows.
- * A conservative default that avoids early reallocations while keeping
- * memory overhead modest; override at build time if needed.
+ * Elements per segment of a KC_UNLIMITED channel when kc_chan_make() is
+ * given capacity 0; a non-zero capacity is used as the segment size instead.
+ * Growth links one more segment, so larger values trade memory for fewer
+ * allocations; override at build time if needed.
  */
 #ifndef KCORO_UNLIMITED_INIT_CAP
 #define KCORO_UNLIMITED_INIT_CAP 64
 #endif
 
+/* Drained segments an UNLIMITED channel keeps for reuse. */
+/**
+ * Upper bound on emptied segments cached per KC_UNLIMITED channel. Segments
+ * drained beyond this are freed, so memory shrinks back after a burst while
+ * steady traffic crossing segment boundaries does not hit malloc.
+ */
+#ifndef KCORO_UNLIMITED_SEG_CACHE
+#define KCORO_UNLIMITED_SEG_CACHE 2
+#endif
+
+/**
+ * Buffered rings of at least KCORO_CHAN_LAZY_RING_BYTES are reserved with
+ * mmap instead of malloc: pages are committed as the tail first reaches
+ * them, so resident memory follows occupancy rather than capacity. When
+ * such a ring empties, its pages (except the one under head) are handed
+ * back with MADV_FREE, at most once per KCORO_CHAN_RING_TRIM_MS. 0 disables
+ * the mapping.
+ */
+#ifndef KCORO_CHAN_LAZY_RING_BYTES
+#define KCORO_CHAN_LAZY_RING_BYTES (1u << 20)
+#endif
+#ifndef KCORO_CHAN_RING_TRIM_MS
+#define KCORO_CHAN_RING_TRIM_MS 1000
+#endif
+
+/**
+ * Blocking channel ops spin up to this long (re-checking the channel, one
+ * pause per probe round) before they queue a waiter and park. Each channel
+ * tunes its own budget below this: a spin that wins moves it toward four
+ * times the wait it saw, one that runs out shrinks it by an eighth, down to
+ * a sixteenth of the cap. 0, or a CPU budget of one (kc_cpu_budget),
+ * parks at once.
+ */
+#ifndef KCORO_CHAN_SPIN_NS
+#define KCORO_CHAN_SPIN_NS 2000
+#endif
+
+/**
+ * Durable channels (kc_chan_make_durable) log to preallocated segment files
+ * of about this size and fdatasync at most once per commit window; both are
+ * defaults for a zero field in kc_chan_durable_opts_t.
+ */
+#ifndef KCORO_DURABLE_SEGMENT_BYTES
+#define KCORO_DURABLE_SEGMENT_BYTES (4u << 20)
+#endif
+#ifndef KCORO_DURABLE_COMMIT_MS
+#define KCORO_DURABLE_COMMIT_MS 2
+#endif
+
+/**
+ * The runtime clock reads the CPU counter once it knows its rate: an x86 TSC
+ * is timed against CLOCK_MONOTONIC for KCORO_CLOCK_CALIB_MS first (reads in
+ * the meantime use clock_gettime). Every KCORO_CLOCK_RESYNC_MS the rate is
+ * corrected so the counter clock tracks CLOCK_MONOTONIC, NTP slew included.
+ */
+#ifndef KCORO_CLOCK_CALIB_MS
+#define KCORO_CLOCK_CALIB_MS 10
+#endif
+#ifndef KCORO_CLOCK_RESYNC_MS
+#define KCORO_CLOCK_RESYNC_MS 500
+#endif
+
+/**
+ * Channel timing stats read a per-thread cached clock: each refresh reads
+ * the runtime clock and serves this many reads, and a scheduler worker drops
+ * it before every coroutine or task it runs. 1 reads the clock every time.
+ */
+#ifndef KCORO_COARSE_CLOCK_READS
+#define KCORO_COARSE_CLOCK_READS 64
+#endif
+
+/**
+ * Recording shards per channel latency histogram (kc_chan_set_latency).
+ * A scheduler worker records into shard (worker index % shards), other
+ * threads into one picked per thread; kc_chan_get_latency merges them.
+ * Each shard of each histogram is about 2.5 KiB.
+ */
+#ifndef KCORO_LAT_SHARDS
+#define KCORO_LAT_SHARDS 8
+#endif
+
+/**
+ * Default events per thread ring for kc_trace_start (rounded up to a power
+ * of two); a full ring overwrites its oldest events. 32 bytes each.
+ */
+#ifndef KCORO_TRACE_EVENTS
+#define KCORO_TRACE_EVENTS (64 * 1024)
+#endif
+
+/**
+ * Default records per thread buffer for kc_chan_rec_start (rounded up to a
+ * power of two); the owner writes a full buffer to the file. 32 bytes each.
+ */
+#ifndef KCORO_CHAN_REC_EVENTS
+#define KCORO_CHAN_REC_EVENTS (16 * 1024)
+#endif
+
+/**
+ * Entries in the metrics registry (kc_metrics_register_chan/_sched), shared
+ * by channels and schedulers. A scrape scans every slot.
+ */
+#ifndef KCORO_METRICS_MAX
+#define KCORO_METRICS_MAX 256
+#endif
+
+/**
+ * Per-coroutine accounting (kcoro_stats, kcoro_stats_top): every context
+ * switch reads CLOCK_MONOTONIC and coroutine creation/teardown takes a
+ * striped registry lock, so it is compiled out unless set to 1
+ * (`make CO_STATS=1`); the calls then return -ENOTSUP.
+ */
+#ifndef KCORO_CO_STATS
+#define KCORO_CO_STATS 0
+#endif
+
+/**
+ * KC_MUTEX contention profile (kcoro_lockprof.h): port/posix.h swaps in a
+ * mutex that counts and times acquisitions per KC_MUTEX_LOCK call site. Two
+ * clock reads per acquisition, so it is off unless set to 1
+ * (`make LOCK_PROF=1`); the report calls then return -ENOTSUP.
+ */
+#ifndef KCORO_LOCK_PROF
+#define KCORO_LOCK_PROF 0
+#endif
+
+/**
+ * Adaptive KC_MUTEX_T (kc_amutex.c, `make ADAPTIVE_MUTEX=1`): on Linux and
+ * macOS port/posix.h swaps pthread mutexes and condvars for a one-word lock
+ * that spins KCORO_AMUTEX_SPIN rounds before sleeping on a futex
+ * (__ulock on macOS). Contention shows in kc_lockprof_adaptive. Rebuild
+ * everything that includes kcoro_port.h when toggling it: the lock type
+ * changes size.
+ */
+#ifndef KCORO_ADAPTIVE_MUTEX
+#define KCORO_ADAPTIVE_MUTEX 0
+#endif
+/** Chunks per worker that KC_PARALLEL_GRAIN_AUTO sizes a parallel loop's
+ * grain for: enough for lazy splitting to rebalance uneven iterations, few
+ * enough that per-chunk work dwarfs the depth check between chunks. */
+#ifndef KCORO_PARALLEL_AUTO_CHUNKS
+#define KCORO_PARALLEL_AUTO_CHUNKS 8
+#endif
+/** Empty rounds a parallel-loop or task-group join spins (one pause each)
+ * before it yields or parks while stolen work finishes. */
+#ifndef KCORO_PARALLEL_JOIN_SPIN
+#define KCORO_PARALLEL_JOIN_SPIN 128
+#endif
+
+/** Spin rounds (one pause each) before an adaptive lock sleeps. */
+#ifndef KCORO_AMUTEX_SPIN
+#define KCORO_AMUTEX_SPIN 64
+#endif
+
+/**
+ * Build against arch/<cpu>/kc_ctx_switch_fast.S instead of kc_ctx_switch.S
+ * (`make FAST_SWITCH=1`): the callee-saved set and the call-site
+ * continuation only, in fewer stores (pairs on aarch64). On x86_64 the
+ * continuation stays on the coroutine's stack, so kcoro_seed_stack plants
+ * the trampoline there. Rebuild the core from clean when toggling it.
+ */
+#ifndef KCORO_FAST_SWITCH
+#define KCORO_FAST_SWITCH 0
+#endif
+
+/* Coroutine stack pool (kcoro_stack.c). */
+/**
+ * Smallest stack size class in bytes. Stack sizes are rounded up to
+ * KCORO_STACK_CLASS_MIN << n (ten classes); larger stacks are not pooled.
+ */
+#ifndef KCORO_STACK_CLASS_MIN
+#define KCORO_STACK_CLASS_MIN (16 * 1024)
+#endif
+
+/**
+ * Free stacks each thread keeps per size class before spilling half of them
+ * to the global depot. 0 disables pooling. Adjustable at runtime with
+ * kcoro_stack_pool_set_limits().
+ */
+#ifndef KCORO_STACK_CACHE_PER_THREAD
+#define KCORO_STACK_CACHE_PER_THREAD 16
+#endif
+
+/**
+ * Free stacks the global depot keeps per size class; stacks spilled beyond
+ * this are unmapped.
+ */
+#ifndef KCORO_STACK_DEPOT_MAX
+#define KCORO_STACK_DEPOT_MAX 64
+#endif
+
+/**
+ * Stack size for coroutines created with stack_size 0. Stacks are committed
+ * on first touch, so raising this (e.g. to 1 MiB) mostly costs address space.
+ * Adjustable at runtime with kcoro_stack_set_default_size().
+ */
+#ifndef KCORO_STACK_DEFAULT_SIZE
+#define KCORO_STACK_DEFAULT_SIZE (64 * 1024)
+#endif
+
+/**
+ * PROT_NONE pages mapped below each coroutine stack so that an overflow
+ * faults. Each guarded stack is two kernel mappings; a million live stacks
+ * need vm.max_map_count raised accordingly on Linux. 0 disables the guard.
+ */
+#ifndef KCORO_STACK_GUARD_PAGES
+#define KCORO_STACK_GUARD_PAGES 1
+#endif
+
+/**
+ * Spawn sites (entry functions) kcoro_stack_autotune tracks; later ones keep
+ * the default stack size.
+ */
+#ifndef KCORO_STACK_TUNE_SITES
+#define KCORO_STACK_TUNE_SITES 256
+#endif
+
+/**
+ * Released stacks a site reports before its coroutines get a tuned size.
+ */
+#ifndef KCORO_STACK_TUNE_SAMPLES
+#define KCORO_STACK_TUNE_SAMPLES 16
+#endif
+
+/**
+ * Room a tuned stack leaves above its site's peak, in percent of the peak
+ * (at least one page), before rounding up to a size class.
+ */
+#ifndef KCORO_STACK_TUNE_HEADROOM
+#define KCORO_STACK_TUNE_HEADROOM 50
+#endif
+
+/* Shared-stack coroutines (kcoro_share.c). */
+/**
+ * Process-wide stacks that KCORO_STACK_SHARED coroutines run on. Each such
+ * coroutine binds to one on its first run; at most one coroutine is resident
+ * per stack at a time, so this bounds how many run in parallel. Keep it well
+ * above the worker count to make collisions rare.
+ */
+#ifndef KCORO_SHARED_STACKS
+#define KCORO_SHARED_STACKS 16
+#endif
+
+/**
+ * Size of each shared stack. Committed on first touch, so only the deepest
+ * call chain seen costs memory.
+ */
+#ifndef KCORO_SHARED_STACK_SIZE
+#define KCORO_SHARED_STACK_SIZE (1024 * 1024)
+#endif
+
+/* Coroutine control blocks (kcoro_core.c). */
+/**
+ * kcoro_t blocks carved per slab allocation when a thread's free list and
+ * the global depot are both empty.
+ */
+#ifndef KCORO_CORO_SLAB
+#define KCORO_CORO_SLAB 64
+#endif
+
+/**
+ * Free kcoro_t blocks a thread keeps before moving half of them to the
+ * global depot.
+ */
+#ifndef KCORO_CORO_CACHE_PER_THREAD
+#define KCORO_CORO_CACHE_PER_THREAD 256
+#endif
+
+/**
+ * Coroutine IDs a thread reserves from the global counter at once. IDs stay
+ * unique but are only increasing per creating thread.
+ */
+#ifndef KCORO_ID_BATCH
+#define KCORO_ID_BATCH 1024
+#endif
+
+/* Coroutine-local storage (kc_cls.c). */
+/**
+ * Keys kc_cls_key_create can hand out, process-wide. A coroutine that sets
+ * a key past the inline slots allocates a table of this many minus
+ * KCORO_CLS_INLINE pointers.
+ */
+#ifndef KCORO_CLS_KEYS
+#define KCORO_CLS_KEYS 128
+#endif
+
+/**
+ * Keys whose slots live in kcoro_t itself (8 bytes each per coroutine).
+ */
+#ifndef KCORO_CLS_INLINE
+#define KCORO_CLS_INLINE 4
+#endif
+
+/**
+ * Rounds of destructor calls at coroutine finish while destructors keep
+ * setting values (PTHREAD_DESTRUCTOR_ITERATIONS for threads).
+ */
+#ifndef KCORO_CLS_DTOR_PASSES
+#define KCORO_CLS_DTOR_PASSES 4
+#endif
+
+/**
+ * Freed kc_job_t blocks a thread keeps for its next kc_job_create or
+ * kc_job_launch; beyond this they go back to malloc.
+ */
+#ifndef KCORO_JOB_CACHE_PER_THREAD
+#define KCORO_JOB_CACHE_PER_THREAD 256
+#endif
+
+/**
+ * Finished kc_task_group member records a thread keeps for its next
+ * kc_task_group_spawn; beyond this they go back to malloc.
+ */
+#ifndef KCORO_TASK_GROUP_CACHE_PER_THREAD
+#define KCORO_TASK_GROUP_CACHE_PER_THREAD 256
+#endif
+
+/**
+ * Freed kc_deferred_t blocks a thread keeps for its next kc_async or
+ * kc_deferred_create; beyond this they go back to malloc.
+ */
+#ifndef KCORO_DEFERRED_CACHE_PER_THREAD
+#define KCORO_DEFERRED_CACHE_PER_THREAD 256
+#endif
+
+/**
+ * Finished kc_actor_ask reply slots (with their envelope buffers) a thread
+ * keeps for its next ask; beyond this they go back to malloc.
+ */
+#ifndef KCORO_ACTOR_REPLY_CACHE_PER_THREAD
+#define KCORO_ACTOR_REPLY_CACHE_PER_THREAD 256
+#endif
+
+/* Correlation tickets (kc_ticket.c). */
+/**
+ * Tickets that can be published at once, process-wide. Slots are allocated
+ * 1024 at a time as the peak grows and never freed; publishing past the cap
+ * fails (a pointer channel op then returns -ENOMEM).
+ */
+#ifndef KCORO_TICKET_MAX
+#define KCORO_TICKET_MAX (1u << 20)
+#endif
+
+/**
+ * Free ticket slots a thread keeps before moving half of them to the
+ * global free stack.
+ */
+#ifndef KCORO_TICKET_CACHE_PER_THREAD
+#define KCORO_TICKET_CACHE_PER_THREAD 64
+#endif
+
+/* Elastic blocking pool (kc_blocking.c). */
+/**
+ * Most threads the blocking pool runs at once. A thread is added whenever
+ * work arrives and none is idle; past the cap, work queues for the next free
+ * thread. kc_dispatcher_set_io_opts() can lower or raise it at runtime.
+ */
+#ifndef KCORO_BLOCKING_MAX_THREADS
+#define KCORO_BLOCKING_MAX_THREADS 512
+#endif
+
+/**
+ * Milliseconds a blocking-pool thread stays idle before it exits, so the pool
+ * shrinks back after a burst of blocking calls.
+ */
+#ifndef KCORO_BLOCKING_IDLE_MS
+#define KCORO_BLOCKING_IDLE_MS 10000
+#endif
+
+/* I/O reactor (kc_reactor.c). */
+/**
+ * Readiness events the poller thread collects per epoll_wait/kevent call.
+ * Larger batches amortise the syscall when many descriptors turn ready at
+ * once; the buffer lives on the poller's stack.
+ */
+#ifndef KCORO_REACTOR_EVENTS
+#define KCORO_REACTOR_EVENTS 256
+#endif
+
+/* io_uring backend (kc_uring.c). */
+/**
+ * Submission-queue entries of each worker's ring; the completion queue is
+ * twice that. Coroutines beyond a full SQ trigger an early submit.
+ */
+#ifndef KCORO_URING_ENTRIES
+#define KCORO_URING_ENTRIES 256
+#endif
+
+/**
+ * Queued SQEs that force a submit from the parking coroutine's worker.
+ * Below it the worker submits once it runs out of ready work (or every few
+ * dozen scheduling turns), so one io_uring_enter covers the whole batch.
+ */
+#ifndef KCORO_URING_BATCH
+#define KCORO_URING_BATCH 32
+#endif
+
+/* Region registry (kc_zcopy.c). */
+/**
+ * Most regions kc_region_register keeps live at once. Each one is also an
+ * io_uring fixed buffer, whose table the kernel caps at 16K entries.
+ */
+#ifndef KCORO_REGION_MAX
+#define KCORO_REGION_MAX 64
+#endif
+
+/**
+ * Most kc_region_hooks_add hook sets installed at once (a device backend
+ * each). At most 32.
+ */
+#ifndef KCORO_REGION_HOOKS_MAX
+#define KCORO_REGION_HOOKS_MAX 4
+#endif
+
+/**
+ * Huge page size KC_REGION_F_HUGEPAGE mappings are rounded and aligned to:
+ * the default hugetlb and transparent huge page size on x86-64 and on
+ * 4K-page arm64. A power of two.
+ */
+#ifndef KCORO_HUGEPAGE_SIZE
+#define KCORO_HUGEPAGE_SIZE (2u * 1024 * 1024)
+#endif
+
+/**
+ * Bytes per kc_arena chunk when the arena is created with chunk_size 0, as
+ * kc_arena_local and kc_scope_arena are. Allocations over a quarter of
+ * this get a chunk of their own.
+ */
+#ifndef KCORO_ARENA_CHUNK
+#define KCORO_ARENA_CHUNK (16 * 1024)
+#endif
+
+/**
+ * kc_bufpool caches: slots per pool (threads get one each, in order, and
+ * share once there are more threads than slots) and the free buffers a slot
+ * holds before it spills half to the pool's depot.
+ */
+#ifndef KCORO_BUFPOOL_CACHES
+#define KCORO_BUFPOOL_CACHES 16
+#endif
+#ifndef KCORO_BUFPOOL_CACHE
+#define KCORO_BUFPOOL_CACHE 32
+#endif
+
+/**
+ * kc_mstream defaults: bytes kept advised MADV_WILLNEED past the stream
+ * position, and descriptors out at once before kc_mstream_next waits.
+ */
+#ifndef KCORO_MSTREAM_READAHEAD
+#define KCORO_MSTREAM_READAHEAD (4u * 1024 * 1024)
+#endif
+#ifndef KCORO_MSTREAM_WINDOW
+#define KCORO_MSTREAM_WINDOW 64
+#endif
+
+/**
+ * kc_flow: elements a segment takes per kc_chan_recv_many and hands on per
+ * kc_chan_send_many, and the KC_BUFFERED capacity of the channels a flow
+ * puts at its parallelism boundaries.
+ */
+#ifndef KCORO_FLOW_BATCH
+#define KCORO_FLOW_BATCH 64
+#endif
+#ifndef KCORO_FLOW_CHAN_CAP
+#define KCORO_FLOW_CHAN_CAP 256
+#endif
+
 /* IPC listen backlog (tooling).
  * Not used by the core; affects only the optional IPC samples. */
 /**
@@ -58,15 +591,126 @@
  * shipped in the repository.
  */
 #ifndef KCORO_IPC_BACKLOG
-#define KCORO_IPC_BACKLOG 8
+#define KCORO_IPC_BACKLOG 1024
+#endif
+
+/**
+ * Parked requests one connection of kc_ipc_server_serve keeps in flight.
+ * Past it the connection stops reading until one completes.
+ */
+#ifndef KCORO_IPC_PIPELINE
+#define KCORO_IPC_PIPELINE 64
+#endif
+
+/**
+ * Requests a kc_ipc_mux client keeps in flight when created with window 0.
+ * Further calls wait for a reply to free a slot.
+ */
+#ifndef KCORO_IPC_WINDOW
+#define KCORO_IPC_WINDOW 64
+#endif
+
+/**
+ * Send credits an IPC handle to a buffered channel asks for and holds at
+ * most. Each lets one send go out without waiting for its reply; the server
+ * grants no more than the channel's free capacity. 0 turns credits off.
+ */
+#ifndef KCORO_IPC_CREDITS
+#define KCORO_IPC_CREDITS 64
+#endif
+
+/**
+ * Messages a kc_ipc_actor_ref flusher takes from its outbox per batch; a
+ * batch larger than one frame goes out as several.
+ */
+#ifndef KCORO_IPC_ACTOR_BATCH
+#define KCORO_IPC_ACTOR_BATCH 256
 #endif
 
-/* Max single TLV element payload (transport uses uint16 length). */
+/* Max single TLV element payload on socket connections. */
 /**
- * Maximum single TLV payload size for the IPC transport.
- * Constrained by the uint16 length field; tooling can lower it to bound
- * allocation size during fuzzing or stress.
+ * Maximum single TLV payload size for socket IPC connections (longer TLVs
+ * use the extended length form and need shared-memory rings). Tooling can
+ * lower it to bound allocation size during fuzzing or stress.
  */
 #ifndef KCORO_IPC_MAX_TLV_ELEM
 #define KCORO_IPC_MAX_TLV_ELEM 65535
 #endif
+
+/**
+ * Largest frame payload the IPC transport sends or receives: one maximal
+ * element plus room for the request's other TLVs. Each frame travels as one
+ * socket record, and receive buffers are sized to it.
+ */
+#ifndef KCORO_IPC_MAX_FRAME
+#define KCORO_IPC_MAX_FRAME (KCORO_IPC_MAX_TLV_ELEM + 256)
+#endif
+
+/**
+ * Frames a connection stages for kc_ipc_flush, which hands them to the
+ * kernel in one call (sendmmsg on Linux). Staging buffers are kept and
+ * reused, so a steady stream of frames allocates nothing.
+ */
+#ifndef KCORO_IPC_TXQ
+#define KCORO_IPC_TXQ 16
+#endif
+
+/**
+ * Most payload segments one kc_ipc_sendv frame may gather (the header takes
+ * one more iovec). Matches KC_ZIOV_MAX so any kc_ziov_t fits.
+ */
+#ifndef KCORO_IPC_IOV_MAX
+#define KCORO_IPC_IOV_MAX 64
+#endif
+
+/**
+ * Offer (client) and accept (server) shared-memory rings in the IPC
+ * handshake. Set to 0 to keep every connection on the socket.
+ */
+#ifndef KCORO_IPC_SHM
+#define KCORO_IPC_SHM 1
+#endif
+
+/**
+ * Bytes per direction in an IPC connection's shared-memory rings; a power
+ * of two. One frame may use nearly all of it, so this also bounds the
+ * element size of channels made over such a connection.
+ */
+#ifndef KCORO_IPC_SHM_RING
+#define KCORO_IPC_SHM_RING (1u << 20)
+#endif
+
+/**
+ * Offer (client) and accept (server) LZ4 compression in the handshake of a
+ * TCP IPC connection. Set to 0 to send every frame as it is.
+ */
+#ifndef KCORO_IPC_LZ4
+#define KCORO_IPC_LZ4 1
+#endif
+
+/**
+ * Bytes of staged frames (headers included) below which a compressing TCP
+ * connection sends them as they are: small request/reply traffic would pay
+ * the codec for nothing.
+ */
+#ifndef KCORO_IPC_LZ4_MIN
+#define KCORO_IPC_LZ4_MIN 1024
+#endif
+
+/**
+ * Offer (client) and accept (server) the fixed-layout form of the hot IPC
+ * channel commands (KCORO_CAP_FIXED): send, receive and batches then skip
+ * TLV encoding both ways. Set to 0 to keep every frame TLV.
+ */
+#ifndef KCORO_IPC_FIXED
+#define KCORO_IPC_FIXED 1
+#endif
+
+/**
+ * Shared regions (kc_region_create_shared) one IPC connection carries in
+ * each direction: how many it exports and how many of the peer's it keeps
+ * mapped. Every imported region also takes a KCORO_REGION_MAX slot.
+ */
+#ifndef KCORO_IPC_REGIONS
+#define KCORO_IPC_REGIONS 16
+#endif
@@ -19,25 +19,63 @@ extern "C" {
  *
  * Schema (see CONFIGURATION.md) — example snippet:
  * {
- *   "channel": {"metrics": {
+ *   "channel": {"stats_level": "counters", "flow_batch": 128, "metrics": {
+ *       "sample_ms":     10,
  *       "emit_min_ops":  128,
  *       "emit_min_ms":   250,
  *       "auto_enable":   true,
  *       "pipe_capacity": 4096
- *   }}
+ *   }},
+ *   "scheduler": {
+ *       "min_workers": 2, "max_workers": 16,
+ *       "scale_up_backlog": 64, "scale_up_ms": 10, "scale_down_ms": 1000,
+ *       "park_spin": 64, "steal_scan": 4, "bulk_share": 16, "slice_us": 2000
+ *   },
+ *   "stack": {"cache_per_thread": 16, "depot_max": 64, "default_size": 65536}
  * }
  *
+ * Hot reload
+ *   kc_runtime_config_reload re-parses the file and then calls every watcher
+ *   registered with kc_runtime_config_watch. Running schedulers re-apply the
+ *   scheduler knobs their kc_sched_opts_t left at 0, the stack pool takes the
+ *   "stack" limits, and channels/flows created afterwards see the rest.
+ *
  * Install guidance
  *   - This header is part of the production public API and should be installed.
  */
 
 struct kc_runtime_config {
+    long          chan_metrics_sample_ms;        /* >=1: metrics sampler period */
     unsigned long chan_metrics_emit_min_ops;     /* >=1 */
     long          chan_metrics_emit_min_ms;      /* >=0 */
     int           chan_metrics_auto_enable;      /* boolean */
     size_t        chan_metrics_pipe_capacity;    /* >=1 */
+    int           chan_stats_level;              /* enum kc_chan_stats_level for new channels */
+    /* kc_sched_init defaults for kc_sched_opts_t fields left 0 (0 => unset). */
+    int           sched_min_workers;
+    int           sched_max_workers;
+    int           sched_scale_up_backlog;
+    int           sched_scale_up_ms;
+    int           sched_scale_down_ms;
+    int           sched_park_spin;               /* idle rounds before parking */
+    int           sched_steal_scan;              /* victims probed per steal attempt */
+    int           sched_bulk_share;              /* worker turns per guaranteed bulk item */
+    int           sched_slice_us;                /* coroutine time-slice budget (0 => off) */
+    /* kc_flow segments (0 => KCORO_FLOW_BATCH / KCORO_FLOW_CHAN_CAP). */
+    int           chan_flow_batch;
+    int           chan_flow_capacity;
+    /* Stack pool (-1 => unset: kcoro_stack_* setters and build defaults rule). */
+    long          stack_cache_per_thread;
+    long          stack_depot_max;
+    long          stack_default_size;
+    long          stack_autotune;                /* kcoro_stack_autotune (nonzero => on) */
+    unsigned long generation;                    /* bumped by every load */
 };
 
+/* Called after each (re)load with the new config; the config lock is held,
+ * so a watcher must not call back into kc_runtime_config_*. */
+typedef void (*kc_runtime_config_watch_fn)(void *arg, const struct kc_runtime_config *cfg);
+
 /* Initialize from path (NULL => env KCORO_CONFIG, else fallback "kcoro_config.json").
  * Safe to call multiple times (idempotent); returns 0 or -errno. */
 int kc_runtime_config_init(const char *path);
@@ -45,6 +83,13 @@ int kc_runtime_config_init(const char *path);
 int kc_runtime_config_reload(const char *path);
 /* Access current config (initializes lazily with defaults if not yet loaded). */
 const struct kc_runtime_config* kc_runtime_config_get(void);
+/* Copy the current config under the lock (a reload cannot tear it). */
+void kc_runtime_config_snapshot(struct kc_runtime_config *out);
+/* Subscribe fn(arg, cfg) to reloads. 0, -EINVAL (fn NULL) or -ENOMEM. */
+int kc_runtime_config_watch(kc_runtime_config_watch_fn fn, void *arg);
+/* Drop a watch registered with the same fn and arg; once this returns the
+ * watcher is not running and will not be called again. 0 or -ENOENT. */
+int kc_runtime_config_unwatch(kc_runtime_config_watch_fn fn, void *arg);
 
 #ifdef __cplusplus
 }
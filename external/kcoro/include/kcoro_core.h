@@ -11,8 +11,8 @@
  *   Assembly keeps context hops fast; scheduling and policy remain in C.
  *
  * Optional items
- *   - This header intentionally has no optional tunables. The primitives here
- *     are foundational and stable.
+ *   - No tunables of its own. KCORO_CO_STATS (kcoro_config.h) adds the
+ *     accounting fields to kcoro_t and backs the kcoro_stats calls.
  *
  * Install guidance
  *   - This header is part of the production public API and should be installed.
@@ -23,6 +23,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <stdatomic.h>
+#include "kcoro_config.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -31,6 +32,7 @@ extern "C" {
 /* Forward declarations */
 typedef struct kcoro kcoro_t;
 typedef struct kcoro_sched kcoro_sched_t;
+struct kcoro_share;
 
 /* Coroutine function type */
 typedef void (*kcoro_fn_t)(void* arg);
@@ -45,39 +47,85 @@ typedef enum {
     KCORO_FINISHED           /* Completed execution */
 } kcoro_state_t;
 
-/* Core coroutine structure - matches ARM64 assembly requirements */
+/* Register save slots used by the context switchers (kc_ctx_switch.S under
+ * arch/ touches reg[0..15]). */
+#define KCORO_REG_SLOTS 16
+
+/* Core coroutine structure - matches ARM64 assembly requirements.
+ * Allocated from a per-thread slab on cache-line boundaries: the registers
+ * fill the first two lines, the fields touched on every resume, yield and
+ * enqueue the third, and creation/debug metadata comes last. */
 struct kcoro {
     /* Register save area - MUST be first field for assembly */
-    void* reg[32];               /* ARM64: x19-x28, x30, sp, x29 at specific indices */
-    
-    /* Coroutine metadata */
-    kcoro_state_t state;         /* Current execution state */
-    kcoro_fn_t fn;               /* Task function */
-    void* arg;                   /* Task argument */
-    uint64_t id;                 /* Unique coroutine ID */
+    void* reg[KCORO_REG_SLOTS];  /* ARM64: x19-x28, x30, sp, x29 at specific indices */
 
-    /* Execution context */
-    kcoro_t* main_co;            /* Main coroutine (yield target) */
-    kcoro_sched_t* scheduler;    /* Owning scheduler */
-    bool ready_enqueued;         /* Scheduler ready-queue flag */
+    /* Hot: scheduling state and linkage */
+    kcoro_state_t state;         /* Current execution state */
     atomic_int running_flag;     /* 0 = idle, 1 = running */
     atomic_int refcount;         /* Reference count for lifetime management */
-
-    /* Stack management */
-    void* stack_ptr;             /* Private stack (if not using shared) */
-    size_t stack_size;           /* Stack size */
-    
-    /* Scheduler linkage */
+    atomic_bool ready_enqueued;  /* Scheduler ready-queue flag (claimed by CAS) */
+    uint8_t lane;                /* Scheduler priority lane (kc_lane_t; 0 = interactive) */
+    uint8_t fpu;                 /* Switch the FP environment too (kcoro_set_fpu_preserve) */
+    uint8_t cls_used;            /* A coroutine-local value was set (kc_cls.h) */
     kcoro_t* next;               /* Next in queue */
     kcoro_t* prev;               /* Previous in queue */
-    
-    /* Debug info */
+    kcoro_t* main_co;            /* Main coroutine (yield target) */
+    kcoro_sched_t* scheduler;    /* Owning scheduler */
+    void* stack_ptr;             /* Private stack (if not using shared) */
+    size_t stack_size;           /* Stack size */
+
+    uint64_t ready_ns;           /* Wake stamp for the scheduler's wake-latency histogram, 0 => none;
+                                  * first on the next line, as the hot line is full */
+    uint64_t deadline_ns;        /* EDF deadline (kc_spawn_co_deadline, CLOCK_MONOTONIC), 0 => none */
+    uint32_t poll_home;          /* Poll worker it is homed on + 1 (kc_spawn_co_poll), 0 => none */
+    uint32_t last_worker;        /* Worker slot it last ran on + 1 (soft affinity), 0 => none */
+
+    /* Cold: set at creation, read at entry, teardown or for debugging */
+    kcoro_fn_t fn;               /* Task function */
+    void* arg;                   /* Task argument */
+    uint64_t id;                 /* Unique coroutine ID */
+    size_t stack_hwm;            /* High-water mark recorded when the stack was released */
     const char* name;            /* Optional name for debugging */
-};
+    struct kcoro_share* share;   /* Copy-on-switch state (KCORO_STACK_SHARED only) */
+    struct kc_job* job;          /* Job bound by kc_job_launch (kc_job_current) */
+    struct kc_cancel_wait* cancel_wait; /* Cancel wake registration of a _c op in progress */
+    struct kcoro_fpu_ctx* fpu_ctx; /* FP environment while switched out (fpu set) */
+    uint32_t overruns;           /* Slice budget overruns (kc_co_overrun_stats), */
+    uint32_t safepoint_yields;   /* written by the worker running it */
+    uint64_t max_run_ns;
+    void* cls[KCORO_CLS_INLINE]; /* Coroutine-local slots of the first keys (kc_cls.h) */
+    void** cls_ext;              /* Slots of the other keys, allocated on first use */
+
+#if KCORO_CO_STATS
+    /* Accounting (kcoro_stats): written by the thread switching the
+     * coroutine in or out, read racily by kcoro_stats */
+    atomic_uint_least64_t run_ns;        /* Completed on-CPU time */
+    atomic_uint_least64_t run_start_ns;  /* Switched in at, 0 while off-CPU */
+    atomic_uint_least64_t switches;      /* Times switched in */
+    atomic_uint_least64_t parks;
+    atomic_uint_least64_t parked_ns;     /* Park until switched in again */
+    uint64_t park_start_ns;              /* 0 unless parked */
+    kcoro_t* stats_next;                 /* Live-coroutine registry (kcoro_stats_top) */
+    kcoro_t* stats_prev;
+#endif
+} __attribute__((aligned(64)));
 
 /** ARM64 assembly context switching primitive (internal). */
 extern void* kcoro_switch(kcoro_t* from_co, kcoro_t* to_co);
 
+/* Callee-saved FP environment (arch/<cpu>/kc_ctx_fpu.S): MXCSR and the x87
+ * control word on x86_64, d8-d15 and FPCR on aarch64. */
+struct kcoro_fpu_ctx {
+    uint64_t slot[9];
+};
+
+/* kcoro_switch that also saves the FP environment into *save and loads it
+ * from *load (internal). */
+extern void* kcoro_switch_fpu(kcoro_t* from_co, kcoro_t* to_co,
+                              struct kcoro_fpu_ctx* save, const struct kcoro_fpu_ctx* load);
+extern void kcoro_fpu_save(struct kcoro_fpu_ctx* save);
+extern void kcoro_fpu_load_control(const struct kcoro_fpu_ctx* load);
+
 /* Function protector for proper stack cleanup */
 extern void kcoro_funcp_protector_asm(void);
 void kcoro_funcp_protector(void);
@@ -86,12 +134,38 @@ void kcoro_funcp_protector(void);
  * @name Core coroutine API
  * Create/destroy coroutines and control execution.
  * @{ */
+/* stack_size value (also accepted by kc_spawn_co and friends) that runs the
+ * coroutine on one of KCORO_SHARED_STACKS shared stacks instead of its own:
+ * its used stack bytes are copied out when it switches out and back in when
+ * it resumes. Idle coroutines then cost their live frames rather than a
+ * stack, at the price of a copy per switch. A shared-stack coroutine must not
+ * kcoro_resume/kcoro_yield_to another one bound to the same stack. */
+#define KCORO_STACK_SHARED ((size_t)-1)
+/* stack_size value for a coroutine whose stack (of the default size) is
+ * taken from the pool when it is first resumed, by the resuming thread,
+ * instead of at creation. Queued coroutines then hold no stack; under the
+ * scheduler, which hands a finished coroutine's stack back at once, one that
+ * runs to completion borrows a warm pooled stack of its worker for its run
+ * only, and one that parks keeps the stack until it finishes. */
+#define KCORO_STACK_LAZY ((size_t)-2)
+
 kcoro_t* kcoro_create(kcoro_fn_t fn, void* arg, size_t stack_size);
 void kcoro_destroy(kcoro_t* co);
 
 /* Set optional name for debugging */
 void kcoro_set_name(kcoro_t* co, const char* name);
 
+/* Give co its own floating-point environment across switches: rounding
+ * mode and exception masks (MXCSR, x87 control word / FPCR), plus d8-d15
+ * on aarch64, which the plain switch leaves alone. Switches where neither
+ * side opted in are unchanged; the others cost a few FP control-register
+ * moves. Call it on a coroutine that has not run yet (it starts with the
+ * caller's environment) or on the running coroutine itself, before it
+ * touches the environment (kc_spawn_co bodies opt in this way); on=0 from
+ * the coroutine itself puts the thread's environment back. Returns 0,
+ * -EBUSY for any other coroutine, -ENOMEM, or -EINVAL. */
+int kcoro_set_fpu_preserve(kcoro_t* co, int on);
+
 /** Execution control */
 void kcoro_resume(kcoro_t* co);
 kcoro_t* kcoro_current(void);
@@ -111,6 +185,114 @@ kcoro_t* kcoro_create_main(void);
 void kcoro_set_thread_main(kcoro_t* main_co);
 /** @} */
 
+/**
+ * @name Coroutine accounting
+ * Built with KCORO_CO_STATS=1 every context switch charges the coroutine
+ * switched out with its on-CPU time, and a park is timed until the
+ * coroutine runs again. Default builds compile this out and the calls
+ * return -ENOTSUP.
+ * @{ */
+typedef struct {
+    uint64_t id;
+    const char* name;
+    kcoro_state_t state;
+    uint64_t run_ns;     /* On-CPU time, including a slice in progress */
+    uint64_t switches;   /* Times switched in */
+    uint64_t parks;
+    uint64_t parked_ns;  /* Completed parks, kcoro_park to running again */
+} kcoro_stats_t;
+
+/* 0, -EINVAL or -ENOTSUP. */
+int kcoro_stats(const kcoro_t* co, kcoro_stats_t* out);
+/* Up to n live coroutines with the most run time, busiest first (main
+ * coroutines excluded). Returns how many were filled, or -ENOTSUP. */
+int kcoro_stats_top(kcoro_stats_t* out, size_t n);
+/* kcoro_stats_top as a text table on fd. 0, -ENOTSUP or -errno. */
+int kcoro_stats_dump_top(int fd, size_t n);
+/** @} */
+
+/**
+ * @name Stack pool
+ * Stacks of destroyed coroutines are kept for reuse instead of unmapped:
+ * per-thread caches bucketed by power-of-two size class, backed by a global
+ * depot that rebalances stacks between threads. Pooled stacks keep only
+ * their top page resident. Every stack has a PROT_NONE guard page below it
+ * and is committed lazily, so a large default size (say 1 MiB) costs only the
+ * pages a coroutine touches; overflow faults instead of corrupting memory.
+ * Defaults come from kcoro_config.h.
+ * @{ */
+struct kcoro_stack_pool_stats {
+    unsigned long reused;     /* stacks handed out from a cache or the depot */
+    unsigned long mapped;     /* stacks newly mapped */
+    unsigned long unmapped;   /* stacks given back to the OS */
+    size_t depot_stacks;      /* free stacks in the global depot */
+    size_t depot_bytes;
+    size_t thread_stacks;     /* free stacks in the calling thread's cache */
+    /* Over stacks released while high-water tracking was on: */
+    size_t high_water_max;    /* deepest, in bytes */
+    unsigned long high_water_samples;
+    uint64_t high_water_sum;  /* divide by samples for the mean */
+    /* kcoro_stack_autotune: */
+    size_t tuned_sites;       /* spawn sites running on a tuned size */
+    unsigned long tune_anomalies; /* samples that outgrew their site's size */
+};
+
+/* High-water marks, in stacks per size class. per_thread == 0 disables pooling. */
+void kcoro_stack_pool_set_limits(unsigned per_thread, unsigned depot);
+/* Placement hints (KC_REGION_F_HUGEPAGE, KC_REGION_F_NUMA(node) from kcoro.h)
+ * for stacks mapped from now on; already pooled ones keep theirs, so set
+ * this before spawning (and trim if needed). Huge pages only back stacks of
+ * at least KCORO_HUGEPAGE_SIZE, and pooled stacks then stay resident rather
+ * than being released down to their top page. 0 (default) clears. */
+void kcoro_stack_pool_set_hints(unsigned region_flags);
+/* Map up to n stacks of size's class (0 => the default size) into the calling
+ * thread's cache with every page already faulted in, stopping at the
+ * per-thread limit; the first coroutines to take them start without page
+ * faults. Returns how many were added. */
+unsigned kcoro_stack_pool_prefill(size_t size, unsigned n);
+/* Unmap the free stacks of the depot and of the calling thread's cache. */
+void kcoro_stack_pool_trim(void);
+/* Counters of other threads are folded in whenever they exchange stacks with
+ * the depot or exit, so they may lag slightly. */
+void kcoro_stack_pool_get_stats(struct kcoro_stack_pool_stats *out);
+/* Stack size used when kcoro_create()/kc_spawn_co() get 0; 0 restores
+ * KCORO_STACK_DEFAULT_SIZE. Only touched pages are backed by memory, so this
+ * can be generous. Sizes above 8 MiB (with the default classes) are not pooled. */
+void kcoro_stack_set_default_size(size_t bytes);
+/* Bytes of co's stack in use so far: from the top down to its deepest
+ * resident page, page granular. Once the stack has been released this is the
+ * value recorded at release (0 unless tracking was on). co must stay alive. */
+size_t kcoro_stack_high_water(const kcoro_t* co);
+/* Record each released stack's high-water mark in the pool stats and in the
+ * coroutine (one mincore call per release). Off by default. */
+void kcoro_stack_track_high_water(int on);
+
+/* Per-spawn-site stack sizing. With autotune on, every released stack's
+ * high-water mark is charged to its coroutine's entry function (one mincore
+ * call per release). After KCORO_STACK_TUNE_SAMPLES of them, coroutines of
+ * that function created with stack_size 0 (or KCORO_STACK_LAZY) get the
+ * smallest pooled class that holds the site's peak plus
+ * KCORO_STACK_TUNE_HEADROOM percent (at least a page), which may be above
+ * the default. Explicit sizes are left alone. A later sample that does not
+ * fit its site's size that way is an anomaly: it is counted, the size grows
+ * to fit, and the first one per site is logged to stderr. Stacks under the
+ * huge page hint are not sampled, and a stack filled by
+ * kcoro_stack_pool_prefill reads as fully used on its first release. Off by
+ * default. */
+void kcoro_stack_autotune(int on);
+struct kcoro_stack_site {
+    kcoro_fn_t fn;            /* entry function */
+    size_t peak;              /* deepest high-water mark seen, bytes */
+    size_t size;              /* tuned stack size, 0 while still sampling */
+    unsigned long samples;
+    unsigned long anomalies;
+};
+/* Copy up to n sites (table order) into out; returns how many there are.
+ * Sites are never forgotten; past KCORO_STACK_TUNE_SITES new ones keep the
+ * default size. */
+size_t kcoro_stack_sites(struct kcoro_stack_site *out, size_t n);
+/** @} */
+
 #ifdef __cplusplus
 }
 #endif
@@ -15,8 +15,22 @@ kc_dispatcher_t* kc_dispatcher_retain(kc_dispatcher_t* dispatcher);
 void kc_dispatcher_release(kc_dispatcher_t* dispatcher);
 
 kc_dispatcher_t* kc_dispatcher_default(void);
+/* Elastic pool for blocking work: kc_dispatcher_spawn runs on a
+ * blocking-pool thread (see kc_sched_block_begin), and spawned coroutines
+ * start there, moving to the default scheduler (kc_dispatcher_scheduler) once
+ * they yield or call kc_sched_block_end. */
 kc_dispatcher_t* kc_dispatcher_io(void);
 kc_dispatcher_t* kc_dispatcher_new(int workers);
+/* Dispatcher over a private scheduler built from opts (placement included). */
+kc_dispatcher_t* kc_dispatcher_new_opts(const kc_sched_opts_t* opts);
+
+/* Blocking-pool limits for kc_dispatcher_io(): `workers` caps its threads
+ * (<= 0 keeps the current cap, KCORO_BLOCKING_MAX_THREADS by default) and
+ * `cpus`/`ncpus` confine new pool threads to that set; placement flags do not
+ * apply. NULL restores the defaults. Must run before the IO dispatcher is
+ * first created; returns 0, -EBUSY afterwards, or -EINVAL for a bad CPU.
+ * kc_dispatcher_default() follows kc_sched_set_default_opts(). */
+int kc_dispatcher_set_io_opts(const kc_sched_opts_t* opts);
 
 kc_sched_t* kc_dispatcher_scheduler(kc_dispatcher_t* dispatcher);
 
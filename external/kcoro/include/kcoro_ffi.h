@@ -0,0 +1,85 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+/* Channel surface for foreign-function bindings (kc_ffi.c).
+ *
+ * Shaped for generators such as Kotlin/Native cinterop, Swift or ctypes,
+ * where every crossing costs far more than a C call:
+ * - Handles are opaque pointers returned by value; no struct is passed or
+ *   returned by value and there are no out-parameter structs.
+ * - Elements move in batches of contiguous primitive arrays (a pinned
+ *   FloatArray, a ByteArray), and pointer descriptors as two parallel
+ *   arrays of addresses and lengths, so one crossing moves a whole run.
+ * - Nothing calls back into the host. Long operations are started as ops
+ *   that run on the default scheduler; the host polls them (one atomic
+ *   load), so a Kotlin coroutine can suspend between polls instead of
+ *   blocking a thread.
+ *
+ * Synchronous calls may be made from any thread, in or out of a
+ * coroutine. Counts are returned as the result: the number of elements
+ * moved, or a negative KC_* / -errno code when none moved. A send cut
+ * short reports what it queued; the next call reports the error.
+ *
+ * Buffers handed to an async op belong to it until kc_ffi_op_poll stops
+ * returning KC_EAGAIN, or kc_ffi_op_free returns. Hosts with a moving GC
+ * keep them pinned that long. */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "kcoro.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Channels. kind is KC_BUFFERED, KC_UNLIMITED and so on, as for
+ * kc_chan_make. NULL on failure. */
+kc_chan_t *kc_ffi_chan_new(int kind, size_t elem_sz, size_t capacity);
+/* A pointer-descriptor channel (kc_chan_make_ptr). */
+kc_chan_t *kc_ffi_chan_new_ptr(int kind, size_t capacity);
+void kc_ffi_chan_close(kc_chan_t *ch);
+void kc_ffi_chan_free(kc_chan_t *ch);
+/* Element size, or 0 for a pointer-descriptor channel */
+size_t kc_ffi_chan_elem_size(const kc_chan_t *ch);
+long kc_ffi_chan_len(kc_chan_t *ch);
+
+/* Synchronous batches (kc_chan_send_many_thread / _recv_many_thread):
+ * send queues up to n elements; recv waits for one, then takes up to max
+ * without waiting again. The typed forms refuse (-EINVAL) a channel whose
+ * element is not that type's size. */
+long kc_ffi_send(kc_chan_t *ch, const void *src, size_t n, long timeout_ms);
+long kc_ffi_recv(kc_chan_t *ch, void *dst, size_t max, long timeout_ms);
+long kc_ffi_send_f32(kc_chan_t *ch, const float *src, size_t n, long timeout_ms);
+long kc_ffi_recv_f32(kc_chan_t *ch, float *dst, size_t max, long timeout_ms);
+long kc_ffi_send_f64(kc_chan_t *ch, const double *src, size_t n, long timeout_ms);
+long kc_ffi_recv_f64(kc_chan_t *ch, double *dst, size_t max, long timeout_ms);
+long kc_ffi_send_i32(kc_chan_t *ch, const int32_t *src, size_t n, long timeout_ms);
+long kc_ffi_recv_i32(kc_chan_t *ch, int32_t *dst, size_t max, long timeout_ms);
+long kc_ffi_send_i64(kc_chan_t *ch, const int64_t *src, size_t n, long timeout_ms);
+long kc_ffi_recv_i64(kc_chan_t *ch, int64_t *dst, size_t max, long timeout_ms);
+long kc_ffi_send_u8(kc_chan_t *ch, const uint8_t *src, size_t n, long timeout_ms);
+long kc_ffi_recv_u8(kc_chan_t *ch, uint8_t *dst, size_t max, long timeout_ms);
+
+/* Async ops. Each runs as a coroutine on kc_sched_default() with the
+ * semantics of the synchronous call (ptrs / lens: descriptor i is
+ * ptrs[i], lens[i]). NULL when the op could not be started. */
+typedef struct kc_ffi_op kc_ffi_op_t;
+
+kc_ffi_op_t *kc_ffi_send_async(kc_chan_t *ch, const void *src, size_t n, long timeout_ms);
+kc_ffi_op_t *kc_ffi_recv_async(kc_chan_t *ch, void *dst, size_t max, long timeout_ms);
+kc_ffi_op_t *kc_ffi_send_ptrs_async(kc_chan_t *ch, void *const *ptrs, const size_t *lens, size_t n, long timeout_ms);
+kc_ffi_op_t *kc_ffi_recv_ptrs_async(kc_chan_t *ch, void **ptrs, size_t *lens, size_t max, long timeout_ms);
+/* KC_EAGAIN while running; then 0, or the error that ended it */
+int  kc_ffi_op_poll(kc_ffi_op_t *op);
+/* Elements moved so far (final once poll is done) */
+long kc_ffi_op_count(kc_ffi_op_t *op);
+/* Block the calling thread until done or timeout_ms: poll's result */
+int  kc_ffi_op_wait(kc_ffi_op_t *op, long timeout_ms);
+/* Ask a running op to stop; it ends with KC_ECANCELED, keeping what moved */
+void kc_ffi_op_cancel(kc_ffi_op_t *op);
+/* Cancel if still running, wait for it, free it */
+void kc_ffi_op_free(kc_ffi_op_t *op);
+
+#ifdef __cplusplus
+}
+#endif
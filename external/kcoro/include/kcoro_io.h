@@ -0,0 +1,61 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+/* Coroutine file and socket I/O.
+ *
+ * Each call behaves like its syscall but parks only the calling coroutine:
+ * on Linux the operation goes to an io_uring owned by the coroutine's worker
+ * thread, and the coroutine is requeued when its completion arrives. SQEs
+ * from all coroutines parked on one worker are submitted together (see
+ * KCORO_URING_BATCH), so a busy worker pays one io_uring_enter per batch.
+ *
+ * Reads and writes whose buffer lies inside a kc_region_register region go
+ * out as fixed-buffer ops, skipping the per-call page pinning.
+ *
+ * Shared-stack coroutines, callers outside a worker coroutine, kernels
+ * without io_uring and other platforms run the plain syscall instead,
+ * waiting in kc_await_readable/writable when a non-blocking descriptor says
+ * -EAGAIN. Either way the descriptor's O_NONBLOCK setting does not leak out:
+ * the calls wait rather than return -EAGAIN. On that path a blocking
+ * descriptor blocks the thread (sockets excepted for recvmsg/sendmsg), so
+ * give descriptors O_NONBLOCK when shared-stack coroutines use them.
+ *
+ * All calls return the syscall's result (bytes, a new fd, 0) or a negative
+ * errno. */
+
+#include <stddef.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** pread/pwrite at off; off < 0 uses (and advances) the file position, as
+ *  read/write do, which is what pipes and sockets need. */
+ssize_t kc_io_read(int fd, void *buf, size_t len, off_t off);
+ssize_t kc_io_write(int fd, const void *buf, size_t len, off_t off);
+ssize_t kc_io_readv(int fd, const struct iovec *iov, int iovcnt, off_t off);
+ssize_t kc_io_writev(int fd, const struct iovec *iov, int iovcnt, off_t off);
+
+/** accept4(2); flags takes SOCK_NONBLOCK / SOCK_CLOEXEC. */
+int kc_io_accept(int fd, struct sockaddr *addr, socklen_t *addrlen, int flags);
+/** connect(2), waiting out EINPROGRESS on non-blocking sockets. */
+int kc_io_connect(int fd, const struct sockaddr *addr, socklen_t addrlen);
+ssize_t kc_io_recvmsg(int fd, struct msghdr *msg, int flags);
+ssize_t kc_io_sendmsg(int fd, const struct msghdr *msg, int flags);
+
+typedef struct kc_io_stats {
+    unsigned long submitted;  /* SQEs handed to the kernel */
+    unsigned long completed;  /* CQEs reaped */
+    unsigned long enters;     /* io_uring_enter submit calls */
+    unsigned long fixed;      /* READ_FIXED / WRITE_FIXED ops */
+    unsigned long fallbacks;  /* calls served by the plain syscall path */
+} kc_io_stats_t;
+
+void kc_io_get_stats(kc_io_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+/* Lock contention profile (kc_lockprof.c).
+ *
+ * Built with KCORO_LOCK_PROF=1 (`make LOCK_PROF=1`) the port's KC_MUTEX_*
+ * macros become an instrumented mutex: each KC_MUTEX_LOCK call site keeps
+ * acquisitions, acquisitions that found the lock held, time spent waiting
+ * for it, and how long its holder kept it. That covers the channel mutex,
+ * the scheduler's ready-queue and inject/bulk rings, and every other core
+ * lock taken through the port. Sites register on first use; counters are
+ * relaxed atomics, so a report taken while locks are in use is approximate.
+ *
+ * Default builds compile the instrumentation out and the calls below return
+ * -ENOTSUP (kc_lockprof_enabled returns 0). */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct kc_lockprof_site {
+    const char *file;         /* source file of the KC_MUTEX_LOCK call */
+    int line;
+    const char *lock;         /* lock expression, e.g. "&ch->mu" */
+    uint64_t acquisitions;
+    uint64_t contended;       /* acquisitions that had to wait */
+    uint64_t wait_ns;         /* total time waiting to acquire */
+    uint64_t max_wait_ns;
+    uint64_t hold_ns;         /* total time held (acquire to unlock) */
+    uint64_t max_hold_ns;
+} kc_lockprof_site_t;
+
+/* 1 when the library was built with KCORO_LOCK_PROF. */
+int kc_lockprof_enabled(void);
+
+/* Up to n sites that were ever acquired, most total wait first (then most
+ * acquisitions). Returns how many were filled, or -ENOTSUP / -EINVAL. */
+int kc_lockprof_snapshot(kc_lockprof_site_t *out, size_t n);
+
+/* Zero every site's counters. 0 or -ENOTSUP. */
+int kc_lockprof_reset(void);
+
+/* The top n sites (0: all) as a text table on fd. 0, -ENOTSUP or -errno. */
+int kc_lockprof_dump(int fd, size_t n);
+
+/* Adaptive lock (`make ADAPTIVE_MUTEX=1`, Linux and macOS): process-wide
+ * counts of the acquisitions that found KC_MUTEX_T held, of those that got
+ * it within the spin, and of the kernel sleeps and wakes the rest cost.
+ * Independent of LOCK_PROF; uncontended acquisitions are not counted. */
+typedef struct kc_lockprof_adaptive {
+    uint64_t contended;       /* lock calls that found the lock held */
+    uint64_t spin_acquired;   /* ...and took it while spinning */
+    uint64_t sleeps;          /* futex / __ulock waits for the lock */
+    uint64_t wakes;           /* unlocks that woke a sleeper */
+} kc_lockprof_adaptive_t;
+
+/* 0, -EINVAL, or -ENOTSUP (pthread locks; *out zeroed). */
+int kc_lockprof_adaptive(kc_lockprof_adaptive_t *out);
+/* Zero the counters. 0 or -ENOTSUP. */
+int kc_lockprof_adaptive_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,71 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+/* Metrics registry and OpenMetrics exporter (kc_metrics.c).
+ *
+ * Channels and schedulers registered under a name are rendered as OpenMetrics
+ * text (counters and gauges from kc_chan_snapshot and kc_sched_get_stats,
+ * plus the process-wide kc_io_get_stats). Collection takes no channel or
+ * scheduler lock: channel counters are read with relaxed loads, so a scrape
+ * never stalls a send or recv, at the price of values that may trail
+ * in-flight ops and are not one consistent cut.
+ *
+ * The registry holds KCORO_METRICS_MAX entries. Unregister an object before
+ * destroying it; unregistering waits out a scrape that is reading it.
+ *
+ * Functions return 0 or a negative errno unless stated otherwise. */
+
+#include <stddef.h>
+#include "kcoro.h"
+#include "kcoro_sched.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* name is copied (up to 63 bytes) and becomes the chan="..." / sched="..."
+ * label. -EEXIST when the object is already registered, -ENOSPC when the
+ * registry is full. */
+int kc_metrics_register_chan(kc_chan_t *ch, const char *name);
+int kc_metrics_unregister_chan(kc_chan_t *ch);
+int kc_metrics_register_sched(kc_sched_t *s, const char *name);
+int kc_metrics_unregister_sched(kc_sched_t *s);
+
+/* Render every registered object into buf, NUL-terminated and ending in
+ * "# EOF\n". Returns the text length; like snprintf, a result >= cap means
+ * the text was truncated and needs a buffer of result + 1. */
+long kc_metrics_render(char *buf, size_t cap);
+
+/* The registered channels with their counters (the same lock-free reads as
+ * a render), for in-process monitors. name is the label as rendered.
+ * Returns how many of out[0..n) were filled, or -EINVAL. */
+typedef struct kc_metrics_chan {
+    char name[128];
+    struct kc_chan_snapshot s;
+} kc_metrics_chan_t;
+
+int kc_metrics_chans(kc_metrics_chan_t *out, int n);
+
+/* Push the registered channels into a metrics pipe: one
+ * kc_chan_metrics_event per channel that moved since the previous push
+ * (deltas are per registry entry), sent without blocking; an event that
+ * does not fit is dropped and the next push carries its delta. pipe must
+ * be a channel of struct kc_chan_metrics_event. Call from a coroutine, like
+ * any channel op. Returns events sent. */
+int kc_metrics_push(kc_chan_t *pipe);
+
+/* HTTP exporter: a coroutine on s (NULL: default scheduler) listening on
+ * host:port (NULL host: all interfaces; port 0: ephemeral) that answers each
+ * request with the rendered text as application/openmetrics-text. It waits
+ * for connections through the reactor, so it holds no worker while idle. */
+typedef struct kc_metrics_server kc_metrics_server_t;
+
+int kc_metrics_serve(kc_sched_t *s, const char *host, int port, kc_metrics_server_t **out);
+/* Bound port (useful after port 0). */
+int kc_metrics_server_port(const kc_metrics_server_t *srv);
+/* Stop accepting, wait for the coroutine to finish and free srv. */
+int kc_metrics_server_stop(kc_metrics_server_t *srv);
+
+#ifdef __cplusplus
+}
+#endif
@@ -10,8 +10,9 @@
  *   these macros and types, allowing the core to remain strictly ANSI/POSIX.
  *
  * Optional items (implementation‑dependent)
- *   - KC_CLOCK_REALTIME: supply if your port needs a clock identifier for
- *     timed waits; otherwise ignore.
+ *   - KC_PORT_COND_CLOCK: the clock KC_COND_TIMEDWAIT_ABS deadlines are on
+ *     (CLOCK_MONOTONIC wherever the condvar can use it). The core builds
+ *     deadlines through kc_clock_abstime, so a port only names the clock.
  *   - KC_ALLOC/KC_FREE: supply if you want to route allocations; otherwise the
  *     core uses malloc/free directly.
  *
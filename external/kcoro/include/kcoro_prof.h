@@ -0,0 +1,68 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+/* Coroutine-aware sampling profiler (kc_prof.c).
+ *
+ * An external profiler sees worker threads only: a sample lands on
+ * whichever coroutine stack happens to be live, and frame-pointer unwinding
+ * falls off at the kcoro_switch boundary. kc_prof_start arms a process-wide
+ * SIGPROF timer (ITIMER_PROF, CPU time); the handler records the running
+ * kcoro_t's id and name and walks frame pointers from the interrupted
+ * context, accepting only frames inside that coroutine's stack
+ * (stack_ptr .. stack_ptr + stack_size, or its bound shared stack). Samples
+ * taken outside a coroutine (scheduler loops, plain threads) keep the
+ * interrupted pc only, since their stack bounds are not known to the
+ * handler.
+ *
+ * Samples go to a buffer sized at start; the handler takes no lock and does
+ * not allocate, and samples past the end are counted as dropped.
+ * kc_prof_write_collapsed symbolizes (dladdr) and aggregates them into
+ * collapsed-stack lines for flamegraph.pl and friends, rooted at the
+ * coroutine name.
+ *
+ * Walks need frame pointers: build the library with `make FRAME_POINTERS=1`
+ * and the application with -fno-omit-frame-pointer. Symbols of a static
+ * executable's own functions need -rdynamic; without it those frames print
+ * as module+0xoffset (feed them to addr2line). SIGPROF belongs to the
+ * profiler while it runs, so do not combine it with setitimer(ITIMER_PROF)
+ * or another SIGPROF user. Functions return 0 or a negative errno unless
+ * stated otherwise. */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define KC_PROF_DEPTH     64   /* frames kept per sample, leaf first */
+#define KC_PROF_NAME_MAX  32   /* coroutine name bytes kept per sample */
+
+/* Start sampling at hz (<= 0: 99) into a buffer of max_samples (0: 65536).
+ * Clears the previous run's samples. -EBUSY while running. */
+int kc_prof_start(int hz, size_t max_samples);
+/* Stop the timer and restore the previous SIGPROF disposition. Samples stay
+ * until the next start. -EINVAL when not running. */
+int kc_prof_stop(void);
+
+typedef struct kc_prof_stats {
+    uint64_t samples;         /* recorded */
+    uint64_t in_coroutine;    /* of those, taken while a coroutine ran */
+    uint64_t dropped;         /* buffer full */
+    uint64_t truncated;       /* walk hit KC_PROF_DEPTH */
+} kc_prof_stats_t;
+
+int kc_prof_get_stats(kc_prof_stats_t *out);
+
+/* Collapsed-stack output flags. */
+#define KC_PROF_BY_ID  1u     /* root frame "name#id": one tower per coroutine */
+
+/* Write "root;outer;...;leaf count\n" lines to fd, one per distinct stack.
+ * The root is the coroutine name ("co" when unnamed, "[thread]" outside a
+ * coroutine). Call after kc_prof_stop. Returns lines written, or -EBUSY
+ * while sampling, or a write error. */
+long kc_prof_write_collapsed(int fd, unsigned flags);
+
+#ifdef __cplusplus
+}
+#endif
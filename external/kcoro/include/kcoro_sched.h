@@ -12,9 +12,32 @@
  *
  * Optional tunables
  *   - KC_SCHED_STEAL_SCAN_MAX
- *     Compile‑time bound on the number of deques probed during a steal. Lower
+ *     Compile‑time default for the number of deques probed during a steal
+ *     (kc_sched_opts_t.steal_scan / config "steal_scan" override it). Lower
  *     values reduce probe cost; higher values can improve fairness under skew.
- *     This is a harmless, overridable macro and can be left at its default.
+ *   - kc_sched_opts_t.park_spin
+ *     Spin-then-park policy: how many idle scan rounds a worker makes before
+ *     sleeping on its wake token. Idle workers sleep without a timeout and are
+ *     woken one at a time by spawns/wakes.
+ *   - kc_sched_opts_t.cpus / .placement
+ *     CPU set, per-core pinning and NUMA grouping for workers; stealing tries
+ *     same-node siblings before remote nodes. Zero keeps OS placement.
+ *   - kc_sched_block_begin / kc_sched_block_end / kc_run_blocking
+ *     Move a coroutine to the elastic blocking pool around a blocking call so
+ *     its worker is not pinned.
+ *   - kc_await_readable / kc_await_writable
+ *     Park a coroutine on fd readiness (epoll/kqueue poller thread) instead of
+ *     spinning on -EAGAIN.
+ *   - kc_sched_opts_t.min_workers / .max_workers / .scale_*
+ *     Elastic sizing: grow under sustained shared-queue backlog, retire idle
+ *     workers down to min_workers. Also settable from kc_runtime_config, and
+ *     re-applied on kc_runtime_config_reload for fields opts leaves at 0.
+ *   - kc_sched_opts_t.poll_workers / .poll_cpus
+ *     Dedicated busy-poll workers that never park and run only the
+ *     coroutines spawned onto them (kc_spawn_co_poll).
+ *   - kc_sched_opts_t.bulk_share
+ *     Interactive/bulk lanes: bulk work runs when interactive queues are empty,
+ *     plus one forced bulk turn every bulk_share worker turns (0 => 16).
  *
  * Install guidance
  *   - This header is part of the production public API and should be installed.
@@ -37,24 +60,179 @@ typedef struct kc_sched kc_sched_t;   /* opaque */
 /* Task entrypoint: runs on a worker thread. */
 typedef void (*kc_task_fn)(void *arg);
 
+/* Priority lanes. Interactive work (the default for kc_spawn/kc_spawn_co and
+ * every wake) runs first; bulk work runs when a worker has nothing else, plus
+ * at least one bulk item every kc_sched_opts_t.bulk_share turns so a steady
+ * interactive load cannot starve it. */
+typedef enum kc_lane {
+    KC_LANE_INHERIT     = -1, /* wakes only: the coroutine's own lane */
+    KC_LANE_INTERACTIVE = 0,  /* latency-sensitive: heartbeats, RPC replies */
+    KC_LANE_BULK        = 1,  /* background throughput work */
+    KC_LANE_COUNT       = 2
+} kc_lane_t;
+
 typedef struct kc_sched_opts {
     int  workers;        /* number of worker threads (<=0 => auto) */
     int  queue_capacity; /* optional, 0 => unbounded (legacy placeholder) */
     int  inject_q_cap;   /* optional global inject queue capacity (0 => default) */
+    int  park_spin;      /* idle scan rounds before a worker sleeps (0 => config/default, <0 => park at once) */
+    const int *cpus;     /* CPUs workers may run on (NULL => the caller's affinity); copied */
+    int  ncpus;          /* entries in cpus; also the default worker count when workers <= 0 */
+    int  placement;      /* KC_SCHED_PLACE_* flags (0 => the OS places workers) */
+    int  bulk_share;     /* take a bulk item at least every N worker turns (0 => config/default 16) */
+    /* Elastic sizing; 0 => runtime config "scheduler" value, else fixed at workers.
+     * Fields left 0 here (and park_spin, bulk_share, steal_scan) follow
+     * kc_runtime_config_reload while the scheduler runs; set ones are pinned. */
+    int  min_workers;    /* idle workers retire down to this (<= workers) */
+    int  max_workers;    /* sustained backlog adds workers up to this (>= workers, <= 256) */
+    int  scale_up_backlog; /* queued shared tasks counted as backlog (0 => 64) */
+    int  scale_up_ms;    /* backlog must last this long per added worker (0 => 10) */
+    int  scale_down_ms;  /* a worker idle this long retires (0 => 1000) */
+    int  steal_scan;     /* random victims probed per steal attempt (0 => config/KC_SCHED_STEAL_SCAN_MAX) */
+    int  slice_us;       /* coroutine time-slice budget (0 => config, off by default; <0 => off) */
+    int  startup;        /* KC_SCHED_START_* (0 => eager) */
+    int  poll_workers;   /* busy-poll workers for kc_spawn_co_poll (0 => none; slots + these <= 256) */
+    const int *poll_cpus; /* CPU of poll worker i is poll_cpus[i mod npoll_cpus] (NULL => unpinned); copied */
+    int  npoll_cpus;     /* entries in poll_cpus */
 } kc_sched_opts_t;
 
+/* Startup mode (kc_sched_opts_t.startup); other values make kc_sched_init
+ * fail with errno EINVAL.
+ *   EAGER  init starts `workers` threads and returns once they run.
+ *   LAZY   init starts no thread. A submit that finds no idle worker starts
+ *          the next slot at once, until `workers` threads have been started;
+ *          growth past that is elastic sizing as usual. The shared queues
+ *          start small and grow. Suits CLI tools and short batch jobs.
+ *   WARM   as EAGER, and every worker faults in its deque and fills its
+ *          stack cache (kcoro_stack_pool_prefill) before init returns; the
+ *          shared queues are faulted in too. Suits latency-critical servers. */
+#define KC_SCHED_START_EAGER 0
+#define KC_SCHED_START_LAZY  1
+#define KC_SCHED_START_WARM  2
+
+/* Worker placement (kc_sched_opts_t.placement). Affinity is applied when the
+ * worker thread is created, so its stack, deque and main context are touched
+ * first on the CPU it will run on (node-local under first-touch).
+ *   PIN   worker i is pinned to the (i mod n)-th CPU of the set (ascending).
+ *   NUMA  workers are grouped by NUMA node. Without PIN, worker i floats over
+ *         the CPUs of the (i mod nodes)-th node in the set. Idle workers steal
+ *         from same-node siblings before trying remote nodes.
+ * A set or flags the OS cannot apply make kc_sched_init fail (errno EINVAL or
+ * ENOTSUP). */
+#define KC_SCHED_PLACE_PIN  0x1
+#define KC_SCHED_PLACE_NUMA 0x2
+
 /** Create and start a scheduler with a worker pool. */
 kc_sched_t* kc_sched_init(const kc_sched_opts_t *opts);
 
+/** CPUs this process can use: the calling thread's affinity mask, lowered
+ *  to the cgroup (v1 or v2) CPU quota rounded up, at least 1. The default
+ *  worker count when kc_sched_opts_t sets neither workers nor cpus; such a
+ *  scheduler re-reads it every KC_SCHED_CPU_RECHECK_MS and grows (elastic
+ *  sizing) no further than it. Reads /proc and /sys on each call. */
+int kc_cpu_budget(void);
+
+#define KC_SCHED_CPU_RECHECK_MS 1000
+
+/** Use opts for the default scheduler (kc_sched_default, kc_dispatcher_default).
+ *  Must run before it is first created. Returns 0, -EBUSY afterwards, or
+ *  -ENOMEM. */
+int kc_sched_set_default_opts(const kc_sched_opts_t *opts);
+
+/** NUMA node a worker of s was placed on (0 without KC_SCHED_PLACE_NUMA),
+ *  or -1 for a bad index. */
+int kc_sched_worker_node(kc_sched_t *s, int worker);
+
 /** Stop workers and free scheduler. Blocks until all workers exit. */
 void kc_sched_shutdown(kc_sched_t *s);
 
 /** Spawn a task on the scheduler. Returns 0 on success. */
 int kc_spawn(kc_sched_t *s, kc_task_fn fn, void *arg);
 
+/** kc_spawn for functions that may block: fn runs as a coroutine
+ *  (KCORO_STACK_LAZY) that only takes a pooled stack from its worker when
+ *  it starts and hands it back when it finishes; only if it parks does the
+ *  stack stay bound to it meanwhile. Queued work holds no stack. Returns 0,
+ *  or -1. */
+int kc_spawn_lazy(kc_sched_t *s, kc_task_fn fn, void *arg);
+
+/** Spawn n tasks (fns[i](args[i])) with one publication: from a worker of s a
+ *  prefix goes onto its deque with a single store and the rest onto the inject
+ *  queue in one lock hold; from other threads all of it goes to inject. Wakes
+ *  up to min(n, idle) workers at once. Returns 0, or -1 (nothing spawned) on
+ *  bad arguments or allocation failure. */
+int kc_spawn_batch(kc_sched_t *s, kc_task_fn const *fns, void *const *args, size_t n);
+
+/** kc_spawn on a given lane (KC_LANE_INTERACTIVE or KC_LANE_BULK). Bulk tasks
+ *  always go through the shared bulk queue. Returns 0, or -1. */
+int kc_spawn_lane(kc_sched_t *s, kc_task_fn fn, void *arg, kc_lane_t lane);
+
 /** Yield CPU to allow other tasks to run. */
 void kc_yield(void);
 
+/* Time-slice budget (kc_sched_opts_t.slice_us, config "slice_us"). A monitor
+ * thread flags a worker whose coroutine has run longer than the budget
+ * without switching out; the flag is acted on only at safepoints: this call,
+ * and the entry of kc_chan_send/_recv/_send_many/_recv_many. Coroutines
+ * that loop without channel ops should call it now and then; it costs one
+ * thread-local read and a relaxed load while no flag is up. */
+/** Yield if the current coroutine has overrun its slice: 1 if it yielded,
+ *  0 otherwise (also outside a coroutine or with the budget off). */
+int kc_yield_if_needed(void);
+
+typedef struct kc_co_overrun_stats {
+    unsigned long overruns;          /* runs that outlasted the slice budget */
+    unsigned long safepoint_yields;  /* yields it took in kc_yield_if_needed */
+    unsigned long long max_run_ns;   /* longest overrunning run seen (lower bound,
+                                      * within one monitor period) */
+} kc_co_overrun_stats_t;
+
+/** Overrun counters of co (kept by the worker that runs it). 0 or -EINVAL. */
+int kc_co_overrun_stats(const kcoro_t *co, kc_co_overrun_stats_t *out);
+
+/* Stall watchdog. The slice monitor thread also watches for workers lost
+ * to a coroutine that blocks in a syscall or spins:
+ *   RUN    one coroutine run has lasted stall_ms without switching out;
+ *   QUEUE  a worker outside any coroutine run (a plain task, or the worker
+ *          loop itself) has had ready work queued and started nothing for
+ *          stall_ms; worker -1 is the shared queues with no worker starting
+ *          anything.
+ * Each incident is reported once, counted in kc_sched_stats_t, and passed
+ * to fn on the monitor thread (NULL fn: one line on stderr). Keep fn short:
+ * the monitor samples nothing else meanwhile. It is the hook for offload
+ * and preemption policies; fn must not touch the coroutine itself, which
+ * may be gone by the time it runs.
+ *
+ * With KC_SCHED_WATCHDOG_STACK the monitor also signals a RUN incident's
+ * worker (KC_SCHED_WATCHDOG_SIGNAL, SIGURG by default) for a frame-pointer
+ * walk of the stalled coroutine, as kc_prof takes it. The signal is
+ * installed with SA_RESTART, but a sleep or wait in progress on that worker
+ * may still return EINTR. */
+#define KC_SCHED_WATCHDOG_STACK 0x1u
+
+#define KC_STALL_RUN   1
+#define KC_STALL_QUEUE 2
+#define KC_STALL_DEPTH 32   /* frames kept per stack sample, leaf first */
+
+typedef struct kc_sched_stall {
+    int kind;                      /* KC_STALL_RUN or KC_STALL_QUEUE */
+    int worker;                    /* worker slot, -1 for the shared queues */
+    uint64_t co_id;                /* RUN: the coroutine's id */
+    char co_name[32];              /* RUN: its kcoro_set_name label, or "" */
+    unsigned long long stalled_ns; /* how long so far (lower bound, within a monitor period) */
+    unsigned long queued;          /* ready items waiting on that worker / the shared queues */
+    int npc;                       /* frames in pc, 0 without a stack sample */
+    uintptr_t pc[KC_STALL_DEPTH];
+} kc_sched_stall_t;
+
+typedef void (*kc_sched_stall_fn)(const kc_sched_stall_t *st, void *arg);
+
+/** Watch s for stalls longer than stall_ms (0 => off). flags:
+ *  KC_SCHED_WATCHDOG_STACK or 0. 0, -EINVAL, or a negative errno when the
+ *  monitor thread or the signal handler could not be set up. */
+int kc_sched_set_watchdog(kc_sched_t *s, unsigned stall_ms, unsigned flags,
+                          kc_sched_stall_fn fn, void *arg);
+
 /* Sleep helper for tasks. If called from a coroutine running on a kcoro
  * worker, this is cooperative (parks the coroutine and wakes it later without
  * blocking a worker thread). Otherwise falls back to thread sleep. */
@@ -65,44 +243,425 @@ void kc_sleep_ms(int ms);
 /** Get or start a default scheduler instance. */
 kc_sched_t* kc_sched_default(void);
 
-/** Spawn a coroutine on the scheduler (M:N). out_co optional. */
+/** Spawn a coroutine on the scheduler (M:N). out_co optional. 0, -1 for bad
+ *  arguments, or -ENOMEM when no stack could be had (kc_mem.h limits). */
 int kc_spawn_co(kc_sched_t* s, kcoro_fn_t fn, void* arg, size_t stack_size, kcoro_t** out_co);
 
+/** Spawn n coroutines (fns[i](args[i]), each with stack_size) like
+ *  kc_spawn_batch: created first, then published to the local deque and the
+ *  global ready list in one pass each. out_cos (optional, n entries) receives
+ *  the handles as kc_spawn_co's out_co would. Returns 0, or -1 (-ENOMEM
+ *  when a coroutine could not be created) with nothing spawned. */
+int kc_spawn_co_batch(kc_sched_t* s, kcoro_fn_t const* fns, void* const* args, size_t n,
+                      size_t stack_size, kcoro_t** out_cos);
+
 /** Enqueue a coroutine to be resumed by the scheduler. */
 void kc_sched_enqueue_ready(kc_sched_t* s, kcoro_t* co);
 
+/** kc_spawn_co with the coroutine placed on `lane` (kept for its yields and
+ *  default wakes). Returns 0, or -1. */
+int kc_spawn_co_lane(kc_sched_t* s, kcoro_fn_t fn, void* arg, size_t stack_size,
+                     kcoro_t** out_co, kc_lane_t lane);
+
+/* Deadline class. A coroutine with a deadline (absolute CLOCK_MONOTONIC ns,
+ * the clock of kc_sched_timer_wake_at) is queued, whenever it becomes ready,
+ * on a per-worker heap ordered by deadline instead of its lane's queues.
+ * Workers run their heap's earliest deadline before any other local work and
+ * steal the most urgent deadline coroutine before touching other deques.
+ * Finishing past the deadline counts as a miss (deadline_misses). */
+/** kc_spawn_co with a deadline (0 => plain kc_spawn_co). Returns 0, or -1. */
+int kc_spawn_co_deadline(kc_sched_t* s, kcoro_fn_t fn, void* arg, size_t stack_size,
+                         kcoro_t** out_co, unsigned long long deadline_ns);
+/** Set or clear (0) co's deadline; takes effect at its next enqueue, e.g.
+ *  for a long-lived coroutine starting on a new request. 0 or -EINVAL. */
+int kc_co_set_deadline(kcoro_t* co, unsigned long long deadline_ns);
+
+/* Busy-poll workers (kc_sched_opts_t.poll_workers). Each is a thread of its
+ * own that never parks: it spins on its timers and its inbox, where every
+ * wake of a coroutine homed on it lands, and runs those coroutines in FIFO
+ * order. Poll workers take no part in stealing, spawning or the shared
+ * queues, and a normal coroutine woken from one is queued as from a foreign
+ * thread, so a poll worker only ever runs its own coroutines. The idle step
+ * is a pause (x86) or a WFE armed on the inbox (aarch64). Give each one an
+ * isolated core (poll_cpus, plus isolcpus= / nohz_full= on the kernel
+ * command line): it burns that core whether or not there is work. */
+/** kc_spawn_co onto poll worker `poll` (0 .. poll_workers - 1). The
+ *  coroutine runs, and is resumed after every wake, yield and timer, only
+ *  there; its lane and deadline are ignored. 0, -EINVAL (no such poll
+ *  worker, bad arguments) or -ENOMEM. */
+int kc_spawn_co_poll(kc_sched_t* s, int poll, kcoro_fn_t fn, void* arg, size_t stack_size, kcoro_t** out_co);
+
+/** kc_sched_enqueue_ready onto the worker co last ran on (soft affinity):
+ *  its inbox when that is another worker, so co finds its cache there,
+ *  unless an idle worker steals it first. Falls back to the usual wake when
+ *  co never ran on s or that worker has retired. */
+void kc_sched_enqueue_ready_home(kc_sched_t* s, kcoro_t* co, kc_lane_t lane);
+
+/** kc_sched_enqueue_ready choosing the lane for this wake only;
+ *  KC_LANE_INHERIT uses the coroutine's own lane. */
+void kc_sched_enqueue_ready_lane(kc_sched_t* s, kcoro_t* co, kc_lane_t lane);
+
+/** kc_sched_enqueue_ready for n coroutines at once (channel close, broadcast,
+ *  cancellation). On a worker of s a prefix goes onto its deque; the rest is
+ *  spliced onto the global ready list in one lock hold, and one pass over the
+ *  idle mask wakes up to min(n, idle) workers. NULL, running, finished and
+ *  already-queued entries are skipped. Returns the number queued. */
+size_t kc_sched_enqueue_ready_batch(kc_sched_t* s, kcoro_t* const* cos, size_t n);
+/** kc_sched_enqueue_ready_batch choosing the lane for these wakes only. */
+size_t kc_sched_enqueue_ready_batch_lane(kc_sched_t* s, kcoro_t* const* cos, size_t n, kc_lane_t lane);
+
+/** Direct handoff from a coroutine on a worker: run co (parked or otherwise
+ *  not queued) next on this worker and put the caller in the worker's
+ *  runnext slot, so it resumes as soon as co switches out. No queue or idle
+ *  mask is touched. Returns 0 once the caller runs again, or -1 with nothing
+ *  done when not on a worker or co is running, finished or already queued. */
+int kc_sched_handoff(kcoro_t* co);
+
 /** Scheduler bound to the current worker thread, if any. */
 kc_sched_t* kc_sched_current(void);
 
+/** Cheap non-cryptographic random number from the calling worker's xorshift
+ *  state (the one work stealing uses); plain threads get a thread-local one. */
+uint32_t kc_sched_rand(void);
+
+/** Park the calling coroutine, then run `release(arg)` on its worker once the
+ *  coroutine has fully switched out. Use it to drop the lock a waker must take
+ *  (and/or arm a timer) so no wake can slip in before the park. Returns 0 once
+ *  resumed, or -1 without parking when not called from a worker coroutine. */
+int kc_sched_park_release(void (*release)(void *arg), void *arg);
+
+/* -------------------- Guest runtimes -------------------- */
+/* A second runtime in the process (kcoro_cpp's WorkStealingScheduler in
+ * hosted mode) can run on s's workers instead of starting threads of its
+ * own. It queues work however it likes, rings s with kc_sched_guest_notify,
+ * and a worker calls poll() once it is out of local work, before stealing
+ * (and every 61 turns regardless, which also fires the guest's timers under
+ * load). poll runs on the worker thread, outside any kcoro coroutine, and
+ * returns how many items it ran; a poll that used its whole budget rings
+ * again so another worker can help. An idle worker parks no later than
+ * next_deadline_ns() and then polls, so the guest needs no timer thread;
+ * arming a timer earlier than the current one must ring too.
+ *
+ *     static void ring(void *s) { kc_sched_guest_notify(s); }
+ *     kc_sched_t *s = kc_sched_default();
+ *     void *h = kcoro_cpp_sched_init_hosted(kc_sched_worker_count(s), ring, s);
+ *     kcoro_cpp_sched_set_default(h);
+ *     kc_sched_guest_t g = { kcoro_cpp_sched_poll, kcoro_cpp_sched_next_timer_ns, h };
+ *     kc_sched_set_guest(s, &g);
+ *     ...
+ *     kc_sched_set_guest(s, NULL);   // before kcoro_cpp_sched_shutdown(h)
+ */
+typedef struct kc_sched_guest {
+    /* Run up to budget items as host worker `worker`; returns how many ran. */
+    int (*poll)(void *arg, int worker, int budget);
+    /* CLOCK_MONOTONIC ns by which poll is next needed for timers, 0 => none.
+     * Optional. */
+    unsigned long long (*next_deadline_ns)(void *arg);
+    void *arg;
+} kc_sched_guest_t;
+
+/* Items one guest poll may run before the worker looks at its own queues. */
+#define KC_SCHED_GUEST_BUDGET 32
+
+/** Attach guest g (copied) to s, replacing any previous one; NULL detaches.
+ *  Returns once no worker is inside the old guest's callbacks, so it must
+ *  not be called from one. 0, -EINVAL (no s, or g without poll) or -ENOMEM. */
+int kc_sched_set_guest(kc_sched_t *s, const kc_sched_guest_t *g);
+
+/** The guest queued work: wake a parked worker of s to poll it. Cheap while
+ *  a ring is already pending. Safe from any thread. */
+void kc_sched_guest_notify(kc_sched_t *s);
+
+/* -------------------- Parallel loops -------------------- */
+/* Data-parallel loops over an index range without a task per element. The
+ * caller runs the range in chunks of `grain` iterations; while its own
+ * deque is empty it forks the upper half of what is left as a task (lazy
+ * binary splitting), so on a busy scheduler the loop runs in place and idle
+ * workers steal halves, and split them again, only while they have nothing
+ * else to do. A worker of s waits for stolen halves by running queued tasks
+ * (coroutine resumes only from task context); other threads sleep.
+ *
+ *     static void scale(void *ctx, size_t b, size_t e) { float *v = ctx; for (; b < e; b++) v[b] *= 2; }
+ *     kc_parallel_for(s, 0, n, KC_PARALLEL_GRAIN_AUTO, scale, v);
+ */
+
+/** Pass as grain to size chunks from the range and worker count
+ *  (KCORO_PARALLEL_AUTO_CHUNKS chunks per worker). */
+#define KC_PARALLEL_GRAIN_AUTO 0
+
+/** Loop body: run iterations [begin, end). */
+typedef void (*kc_range_fn)(void *ctx, size_t begin, size_t end);
+/** Reduce body: fold iterations [begin, end) into acc. */
+typedef void (*kc_reduce_fn)(void *ctx, size_t begin, size_t end, void *acc);
+/** acc = acc (+) other. Must be associative and commutative: partial results
+ *  are combined in completion order. */
+typedef void (*kc_combine_fn)(void *ctx, void *acc, const void *other);
+
+/** Run fn over [begin, end) on s and return once every iteration has run.
+ *  0, -EINVAL (NULL s/fn, end < begin) or -ENOMEM. */
+int kc_parallel_for(kc_sched_t *s, size_t begin, size_t end, size_t grain, kc_range_fn fn, void *ctx);
+
+/** Fold [begin, end) into *out (acc_size bytes). Every split starts from a
+ *  copy of identity; *out starts from one too and receives each partial
+ *  through combine. Return codes as kc_parallel_for. */
+int kc_parallel_reduce(kc_sched_t *s, size_t begin, size_t end, size_t grain, const void *identity,
+                       size_t acc_size, kc_reduce_fn fn, kc_combine_fn combine, void *ctx, void *out);
+
+/* -------------------- Task groups -------------------- */
+/* Fork-join over plain tasks. Members are kc_spawn tasks, so from a worker
+ * they land on its own deque; kc_task_group_wait runs queued tasks (its own
+ * newest first, which are usually the members it just spawned, else stolen
+ * ones) until the group is empty, and only then parks: a coroutine parks
+ * on the group, a plain thread sleeps, and a worker's task context yields,
+ * so no worker thread is ever blocked on its own children.
+ *
+ *     kc_task_group_create(&g, s);
+ *     for (i = 0; i < n; i++) kc_task_group_spawn(g, work, &items[i]);
+ *     kc_task_group_wait(g);
+ *     kc_task_group_destroy(g);
+ */
+typedef struct kc_task_group kc_task_group_t;   /* opaque */
+
+/** Create an empty group whose members run on s. 0, -EINVAL or -ENOMEM. */
+int kc_task_group_create(kc_task_group_t **out, kc_sched_t *s);
+
+/** Run fn(arg) as a member. Members may spawn further members.
+ *  0, -EINVAL or -ENOMEM. */
+int kc_task_group_spawn(kc_task_group_t *g, kc_task_fn fn, void *arg);
+
+/** Return once every member spawned so far, and every member those spawn,
+ *  has returned. Not from a member of g. The group can be reused. 0 or
+ *  -EINVAL. */
+int kc_task_group_wait(kc_task_group_t *g);
+
+/** Free an idle group (no member pending; e.g. after kc_task_group_wait). */
+void kc_task_group_destroy(kc_task_group_t *g);
+
+/* -------------------- Blocking calls -------------------- */
+/* A coroutine about to block its thread (blocking socket / file I/O, DNS,
+ * kc_ipc_recv on a blocking fd) moves itself to the elastic blocking pool for
+ * the duration, so its worker keeps running everyone else:
+ *
+ *     if (kc_sched_block_begin() == 0) { n = read(fd, buf, len); kc_sched_block_end(); }
+ *     else n = read(fd, buf, len);         // not on a worker: block in place
+ *
+ * Between the two calls the coroutine runs on a pool thread with no current
+ * scheduler; restrict it to the blocking call itself (channel waits, kc_yield
+ * and timers there degrade to thread-level waits). block_end requeues it on
+ * its scheduler in its own lane. The blocking pool is process-wide, grows a
+ * thread whenever work arrives and none is idle (up to
+ * KCORO_BLOCKING_MAX_THREADS) and retires threads idle for
+ * KCORO_BLOCKING_IDLE_MS. */
+
+/** Move the calling worker coroutine to a blocking-pool thread. Returns 0 once
+ *  running there, or -1 (not a worker coroutine, or no pool thread could be
+ *  started) with the caller still where it was. */
+int kc_sched_block_begin(void);
+
+/** Return from a blocking-pool thread to the scheduler the coroutine came
+ *  from. No-op when kc_sched_block_begin did not move the caller. */
+void kc_sched_block_end(void);
+
+/** Run fn(arg) between block_begin/block_end; in place when the caller is not
+ *  a worker coroutine. Returns 0, or -1 for a NULL fn. */
+int kc_run_blocking(kc_task_fn fn, void *arg);
+
+/** Run fn(arg) on a blocking-pool thread (fire and forget). Returns 0, or -1
+ *  for a NULL fn / when no pool thread can be started. */
+int kc_blocking_spawn(kc_task_fn fn, void *arg);
+
+typedef struct kc_blocking_stats {
+    unsigned long threads;        /* live pool threads */
+    unsigned long idle;           /* of which waiting for work */
+    unsigned long peak;           /* most live threads seen */
+    unsigned long tasks;          /* kc_blocking_spawn work run */
+    unsigned long migrations;     /* block_begin hand-offs (and IO coroutines) */
+    unsigned long spawn_failures; /* pthread_create failures */
+} kc_blocking_stats_t;
+
+void kc_blocking_get_stats(kc_blocking_stats_t *out);
+
+/* -------------------- I/O readiness -------------------- */
+/* Park the calling coroutine until fd is readable / writable, so non-blocking
+ * I/O (kc_ipc_recv_nb, kc_ipc_send_nb, plain sockets) waits without spinning
+ * on -EAGAIN:
+ *
+ *     while ((rc = kc_ipc_recv_nb(c, &cmd, &pl, &len)) == -EAGAIN)
+ *         if ((rc = kc_await_readable(kc_ipc_conn_fd(c), -1)) != 0) break;
+ *
+ * A process-wide poller thread (epoll on Linux, kqueue on BSD/macOS) requeues
+ * the coroutine on its scheduler when the fd turns ready. Readiness is a hint:
+ * retry the operation and wait again on -EAGAIN. Hang-ups and errors count as
+ * ready. Do not close fd while a coroutine waits on it. Outside a worker
+ * coroutine the calls poll(2) on the calling thread. */
+
+/** Wait until fd is readable (timeout_ms < 0: no limit, 0: just check).
+ *  Returns 0, KC_ETIME on timeout, or a negative errno. */
+int kc_await_readable(int fd, long timeout_ms);
+
+/** Wait until fd is writable; as kc_await_readable. */
+int kc_await_writable(int fd, long timeout_ms);
+
+typedef struct kc_reactor_stats {
+    unsigned long waits;    /* coroutine waits queued on the poller */
+    unsigned long wakeups;  /* waiters requeued on readiness */
+    unsigned long timeouts; /* waits that hit their timeout */
+    unsigned long polls;    /* thread-level poll(2) waits (not on a worker) */
+} kc_reactor_stats_t;
+
+void kc_reactor_get_stats(kc_reactor_stats_t *out);
+
 /* -------------------- Statistics (from former v2) -------------------- */
 typedef struct kc_sched_stats {
     unsigned long tasks_submitted;
     unsigned long tasks_completed;
     unsigned long steals_probes;
     unsigned long steals_succeeded;
-    unsigned long steals_failures;
+    unsigned long steals_failures;     /* probe found the victim deque empty */
+    unsigned long steals_cas_failures; /* lost the top CAS to the owner or another thief */
     unsigned long fastpath_hits;
     unsigned long fastpath_misses;
     unsigned long inject_pulls;
     unsigned long donations;
+    unsigned long ready_local;   /* coroutine wakes kept on the waking worker (runnext/deque) */
+    unsigned long ready_global;  /* coroutine enqueues through the global overflow list */
+    unsigned long runnext_hits;  /* resumes taken from a worker's runnext slot */
+    unsigned long park_events;   /* times a worker went to sleep */
+    unsigned long unpark_events; /* targeted wakes of a sleeping worker */
+    unsigned long steals_remote; /* successful steals from a worker on another NUMA node */
+    unsigned long lane_submitted[KC_LANE_COUNT]; /* tasks spawned + coroutines made ready, per lane */
+    unsigned long lane_run[KC_LANE_COUNT];       /* tasks run + coroutine resumes, per lane */
+    unsigned long bulk_forced;   /* bulk items taken on a bulk_share turn (starvation guard) */
+    unsigned long workers_active; /* slots with a running thread (elastic sizing) */
+    unsigned long cpu_budget;    /* kc_cpu_budget() as last read; 0 when workers or cpus were given */
+    unsigned long scale_ups;     /* dormant workers started (backlog or a targeted wake) */
+    unsigned long scale_downs;   /* workers retired after scale_down_ms idle */
+    unsigned long inject_depth;  /* tasks waiting in the inject queue (gauge) */
+    unsigned long bulk_depth;    /* items waiting in the bulk lane queue (gauge) */
+    unsigned long steals_batched; /* extra tasks a steal moved into the thief's deque (steal-half) */
+    unsigned long preempt_flags; /* coroutine runs the slice monitor found over budget */
+    unsigned long preempt_yields; /* yields taken at a safepoint because of such a flag */
+    unsigned long deadline_queued; /* coroutines waiting in deadline heaps (gauge) */
+    unsigned long deadline_run;    /* resumes taken from a deadline heap */
+    unsigned long deadline_steals; /* of those, taken from another worker's heap */
+    unsigned long deadline_misses; /* deadline coroutines that finished after their deadline */
+    unsigned long handoffs;        /* kc_sched_handoff switches (target run with no queue trip) */
+    unsigned long remote_wakes;    /* wakes queued on a worker's inbox (from outside the workers, or sent home) */
+    unsigned long remote_doorbells; /* of those, inbox pushes that had to unpark (or start) a worker */
+    unsigned long home_wakes;      /* wakes sent to the coroutine's last worker from elsewhere (soft affinity) */
+    unsigned long guest_runs;      /* items guest polls ran on the workers (kc_sched_set_guest) */
+    unsigned long stalls_run;      /* watchdog: coroutine runs past stall_ms */
+    unsigned long stalls_queue;    /* watchdog: ready queues that did not move for stall_ms */
+    unsigned long poll_workers;    /* busy-poll workers (kc_sched_opts_t.poll_workers) */
+    unsigned long long poll_busy_ns; /* summed over them: time running coroutines, */
+    unsigned long long poll_wall_ns; /* and time since they started (duty = busy / wall) */
 } kc_sched_stats_t;
 
 /** Obtain a snapshot of scheduler counters (best‑effort, racy). */
 void kc_sched_get_stats(kc_sched_t *s, kc_sched_stats_t *out);
 
+/* Per-worker view for monitors; every field is a relaxed read of state the
+ * worker keeps anyway (plus two clock reads per park for parked_ns). */
+typedef struct kc_sched_worker_stats {
+    int on;                      /* a thread runs this slot */
+    int parked;                  /* asleep (or about to be) */
+    unsigned long run;           /* tasks run + coroutine resumes, all lanes */
+    unsigned long parks;
+    unsigned long long parked_ns;/* time asleep, including a sleep in progress;
+                                  * utilization = 1 - d(parked_ns)/dt */
+    unsigned long steals;        /* tasks this worker took from others (batches included) */
+    unsigned steal_depth;        /* victims it probes per steal attempt now (adapts to success rate) */
+    unsigned deque_depth;
+    int runnext;                 /* a coroutine waits in the runnext slot */
+    unsigned long long deadline_next_ns; /* earliest deadline in its heap, 0 => empty */
+    unsigned timers;             /* timers armed on this worker's wheel */
+} kc_sched_worker_stats_t;
+
+/* Poll worker view (kc_sched_opts_t.poll_workers). busy_ns is time spent
+ * inside coroutine runs, wall_ns time since the worker started, so the
+ * poll loop's duty cycle is d(busy_ns)/d(wall_ns); the rest went to
+ * spinning on an empty inbox. */
+typedef struct kc_sched_poll_stats {
+    int cpu;                     /* CPU it is pinned to, -1 when unpinned */
+    unsigned long run;           /* coroutine resumes */
+    unsigned long long busy_ns;
+    unsigned long long wall_ns;
+    unsigned long spins;         /* loop turns that found nothing to run */
+} kc_sched_poll_stats_t;
+
+/** Poll workers of s (kc_sched_opts_t.poll_workers), or -EINVAL. */
+int kc_sched_poll_count(kc_sched_t *s);
+/** 0 or -EINVAL (poll out of range). */
+int kc_sched_get_poll_stats(kc_sched_t *s, int poll, kc_sched_poll_stats_t *out);
+
+/** Worker slots (the kc_sched_opts_t workers / elastic maximum), or -EINVAL. */
+int kc_sched_worker_count(kc_sched_t *s);
+/** 0 or -EINVAL (worker out of range). */
+int kc_sched_get_worker_stats(kc_sched_t *s, int worker, kc_sched_worker_stats_t *out);
+/* Steal matrix: successful steals per thief/victim pair. Off by default
+ * (workers^2 counters, allocated on first enable); while on, a steal costs
+ * one more owner-only counter bump. */
+/** Start (1) or pause (0) counting. 0, -EINVAL or -ENOMEM. */
+int kc_sched_set_steal_matrix(kc_sched_t *s, int on);
+/** Copy the matrix into out[thief * workers + victim] (n >= workers^2).
+ *  Returns workers, -EINVAL, -ENOSPC, or -ENOENT if never switched on. */
+int kc_sched_get_steal_matrix(kc_sched_t *s, unsigned long *out, size_t n);
+
+/* Wake-to-resume latency: time from kc_sched_enqueue_ready (or a timer
+ * wake) to the coroutine running again on a worker, recorded per worker
+ * into a struct kc_hist (kcoro.h). Off by default; costs a clock read per
+ * wake and per resume while on. */
+struct kc_hist;
+/** Switch recording on (1) or off (0). 0, -EINVAL or -ENOMEM. */
+int kc_sched_set_wake_latency(kc_sched_t *s, int on);
+/** Merge the workers' histograms into out, restarting them when reset is
+ *  set. 0, -EINVAL, or -ENOENT when recording was never switched on. */
+int kc_sched_get_wake_latency(kc_sched_t *s, struct kc_hist *out, int reset);
+
+/* Event tracing: spawn, resume/switch-out, park, wake, steal, timer fires and
+ * channel blocks/wakes, recorded into a ring per thread while tracing is on
+ * (one relaxed load and a predicted branch per trace point while off). Rings
+ * are flight recorders: a full one drops its oldest events.
+ * kc_trace_start(0) uses KCORO_TRACE_EVENTS per thread; starting again
+ * discards the previous trace. 0, -EBUSY when already on, -EINVAL. */
+int  kc_trace_start(size_t events_per_thread);
+void kc_trace_stop(void);
+int  kc_trace_active(void);
+
+typedef struct {
+    unsigned long events;      /* recorded since kc_trace_start */
+    unsigned long overwritten; /* lost to full rings */
+    unsigned long threads;     /* rings in the current trace */
+} kc_trace_stats_t;
+void kc_trace_get_stats(kc_trace_stats_t *out);
+
+/* Write the trace as Chrome trace-event JSON (chrome://tracing, Perfetto UI):
+ * one track per thread, a slice per coroutine run, instants for the other
+ * events and flow arrows from each wake to the resume it caused. Call after
+ * kc_trace_stop; a dump of a running trace may miss in-flight events.
+ * 0 or -errno. */
+int  kc_trace_dump_chrome(int fd);
+int  kc_trace_dump_chrome_file(const char *path);
+
 /* Steal scan tunable (was KC_SCHED2_STEAL_SCAN_MAX during migration) */
 /**
- * @brief Upper bound on victim deques probed during a steal attempt.
- * Lower values reduce probe cost; higher may improve fairness under skew.
+ * @brief Default upper bound on victim deques probed during a steal attempt.
+ * Each worker probes fewer while its recent steals keep missing
+ * (kc_sched_worker_stats_t.steal_depth). Lower values reduce probe cost;
+ * higher may improve fairness under skew.
  */
 #ifndef KC_SCHED_STEAL_SCAN_MAX
 #define KC_SCHED_STEAL_SCAN_MAX 4
 #endif
 
 /**
- * @brief Best‑effort drain to a quiescent state.
- * Waits until ready queues and deques are empty and workers appear idle, or
- * until timeout_ms elapses. Returns 0 if quiescent observed, KC_ETIME if timed out.
+ * @brief Wait until the scheduler has no outstanding work.
+ * Outstanding work is every submitted task not yet run and every queued or
+ * running coroutine; coroutines parked on a channel, timer or the blocking
+ * pool count as quiescent until something wakes them. The last completion
+ * signals the waiter, so no polling is involved. timeout_ms < 0 waits
+ * forever, 0 only checks. Returns 0 once quiescent, KC_ETIME on timeout and
+ * -EDEADLK when called from one of this scheduler's own workers.
  */
 int kc_sched_drain(kc_sched_t *s, long timeout_ms);
 
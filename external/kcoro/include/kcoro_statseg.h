@@ -0,0 +1,130 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+/* Shared-memory stats segment (kc_statseg.c).
+ *
+ * A process that wants to be watched calls kc_statseg_publish: a sampling
+ * thread (not a coroutine, so it never occupies a worker) copies scheduler,
+ * per-worker and registered-channel counters into a POSIX shared-memory
+ * object every interval_ms. Each sample is a handful of relaxed loads per
+ * worker and per channel; no scheduler or channel lock is taken. While
+ * published, the scheduler's steal matrix is switched on.
+ *
+ * A monitor in another process (lab/tui/chanmon -a) maps the object
+ * read-only with kc_statseg_attach and takes consistent copies with
+ * kc_statseg_read: the publisher bumps seq to odd before writing and back to
+ * even after, and the reader retries copies that straddle a write.
+ *
+ * Once mapped, reading costs the observed process nothing: no syscall and
+ * no lock on either side.
+ *
+ * The layout below is the contract between the two sides. New fields go at
+ * the end and raise size, which readers built against the older layout
+ * accept (they see their prefix); bump KC_STATSEG_VERSION only for changes
+ * that move or reinterpret existing fields. Functions return 0 or a
+ * negative errno unless stated otherwise. */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "kcoro_sched.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define KC_STATSEG_MAGIC     0x3167657374736b63ull /* "kcstseg1" */
+#define KC_STATSEG_VERSION   1
+#define KC_STATSEG_WORKERS   64   /* workers published (lower slot ids first) */
+#define KC_STATSEG_CHANS     32   /* registered channels published */
+#define KC_STATSEG_NAME_MAX  64
+#define KC_STATSEG_MEM_CATS  8    /* kc_mem categories (KC_MEM_CAT_COUNT used) */
+
+typedef struct kc_statseg_worker {
+    uint8_t  on, parked, runnext, _pad;
+    uint32_t deque_depth;
+    uint32_t timers;             /* armed on this worker's wheel */
+    uint32_t _pad2;
+    uint64_t run;                /* tasks run + coroutine resumes */
+    uint64_t parks;
+    uint64_t parked_ns;
+    uint64_t steals;
+} kc_statseg_worker_t;
+
+typedef struct kc_statseg_chan {
+    char     name[KC_STATSEG_NAME_MAX]; /* kc_metrics_register_chan name */
+    uint64_t sends, recvs;
+    uint64_t bytes_sent, bytes_recv;
+    uint64_t count, capacity;
+    uint32_t send_waiters, recv_waiters;
+    int32_t  kind, closed;
+} kc_statseg_chan_t;
+
+typedef struct kc_statseg_data {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t size;               /* sizeof(kc_statseg_data_t) */
+    int32_t  pid;
+    uint32_t interval_ms;
+    uint64_t seq;                /* odd while a sample is being written */
+    uint64_t samples;
+    uint64_t sample_ns;          /* CLOCK_MONOTONIC of the sample */
+    /* scheduler */
+    uint32_t workers;            /* entries valid in w[] and steal[][] */
+    uint32_t workers_total;      /* scheduler slots */
+    uint32_t workers_active;
+    uint32_t steal_valid;        /* steal[][] holds data */
+    uint64_t tasks_submitted, tasks_completed;
+    uint64_t steals_succeeded, park_events;
+    uint64_t inject_depth, bulk_depth;
+    kc_statseg_worker_t w[KC_STATSEG_WORKERS];
+    uint64_t steal[KC_STATSEG_WORKERS][KC_STATSEG_WORKERS]; /* [thief][victim] */
+    /* channels */
+    uint32_t nchans;             /* entries valid in ch[] */
+    uint32_t chans_total;        /* registered channels */
+    kc_statseg_chan_t ch[KC_STATSEG_CHANS];
+    /* memory accounting (kc_mem.h), indexed by kc_mem_cat_t */
+    uint32_t mem_cats;           /* entries valid in mem_*[] */
+    uint32_t _pad;
+    uint64_t mem_bytes[KC_STATSEG_MEM_CATS];
+    uint64_t mem_limit[KC_STATSEG_MEM_CATS];
+    uint64_t mem_denied[KC_STATSEG_MEM_CATS];
+    uint64_t mem_total, mem_total_limit;
+} kc_statseg_data_t;
+
+/* ---- Publisher (observed process) ---- */
+
+typedef struct kc_statseg kc_statseg_t;
+
+/* Publish s (NULL: default scheduler) and the metrics registry's channels
+ * under name ("/kcoro-<pid>" when NULL, see kc_statseg_default_name) every
+ * interval_ms (<= 0: 250). -EEXIST when the name is taken. */
+int kc_statseg_publish(kc_sched_t *s, const char *name, int interval_ms, kc_statseg_t **out);
+const char *kc_statseg_name(const kc_statseg_t *seg);
+/* Stop sampling, unlink the object (attached readers keep their mapping)
+ * and free seg. */
+int kc_statseg_stop(kc_statseg_t *seg);
+
+/* "/kcoro-<pid>" into buf. */
+int kc_statseg_default_name(int pid, char *buf, size_t cap);
+
+/* ---- Reader (monitor) ---- */
+
+/* Map name read-only. -ENOENT (no such segment), -EPROTO (not a segment of
+ * this version, or smaller than this layout), -EAGAIN (publisher still
+ * initialising) or the shm_open/mmap error. */
+int kc_statseg_attach(const char *name, const kc_statseg_data_t **out);
+/* A consistent copy of the latest sample; -EAGAIN if every retry raced a
+ * write. */
+int kc_statseg_read(const kc_statseg_data_t *seg, kc_statseg_data_t *copy);
+void kc_statseg_detach(const kc_statseg_data_t *seg);
+
+/* Render a copy from kc_statseg_read as OpenMetrics text, for exporters and
+ * agents serving another process's stats: channel and scheduler families
+ * named as in kc_metrics_render (schedulers unlabelled: a segment carries
+ * one), plus per-worker kcoro_worker_* families and the steal matrix when
+ * on. Same return convention as kc_metrics_render. */
+long kc_statseg_render(const kc_statseg_data_t *d, char *buf, size_t cap);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+/* Correlation tickets (kc_ticket.c): park a coroutine on an id and resume it
+ * from whatever completes the id.
+ *
+ * kc_ticket_publish takes a slot in a process-wide table for the calling
+ * coroutine and returns its ticket. The coroutine hands the ticket to a
+ * completion source (an io_uring SQE's user_data, an IPC request id, a
+ * channel queue) and parks in kc_ticket_wait. kc_ticket_complete, from any
+ * thread, swaps in the result and makes the coroutine ready: one CAS on the
+ * slot, no lock and no allocation. Pointer channels park their blocked
+ * kc_chan_send_ptr / kc_chan_recv_ptr calls this way (kcoro.h).
+ *
+ * A ticket is the slot index plus a generation that changes each time the
+ * slot is reused, so a completion that arrives late (after a timeout, or
+ * twice) finds a different generation and is refused with -ESTALE instead
+ * of waking the slot's next owner. Slots are never freed; free ones are
+ * cached per thread (KCORO_TICKET_CACHE_PER_THREAD) over a lock-free global
+ * stack, and the table holds at most KCORO_TICKET_MAX tickets at once.
+ *
+ * Functions return 0 or a negative errno unless stated otherwise. */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef uint64_t kc_ticket_t;   /* 0 is never a valid ticket */
+
+/* What a ticket carries each way: the publisher's value goes to the
+ * completer and the completer's to the waiter (kc_ticket_complete). */
+typedef struct kc_ticket_payload {
+    void    *ptr;
+    size_t   len;
+    int      status;   /* 0, or a negative KC_* / errno code */
+    uint64_t data;     /* completion-specific word (CQE res/flags, request id) */
+} kc_ticket_payload_t;
+
+/** Publish a ticket owned by the calling coroutine. initial (NULL: zeros) is
+ *  what the completer receives. Returns 0 outside a coroutine or when the
+ *  table is full. The owner must end it with kc_ticket_wait. */
+kc_ticket_t kc_ticket_publish(const kc_ticket_payload_t *initial);
+
+/** Park until the ticket is completed or cancelled, or timeout_ms passes
+ *  (< 0 waits forever, 0 only checks). The ticket is spent either way.
+ *  Returns the completion's status with its payload in *out (may be NULL),
+ *  KC_ETIME when it timed out first, or KC_ECANCELED when the token of an
+ *  enclosing _c channel op fired; a completion racing either wins if it
+ *  already claimed the slot. Only the owner may wait. */
+int kc_ticket_wait(kc_ticket_t t, long timeout_ms, kc_ticket_payload_t *out);
+
+/** Complete a published ticket from any thread: *io goes to the waiter and
+ *  *io receives the publisher's payload. Exactly one completion per ticket
+ *  succeeds; the others, and any for a spent ticket, return -ESTALE with
+ *  *io untouched. */
+int kc_ticket_complete(kc_ticket_t t, kc_ticket_payload_t *io);
+
+/** kc_ticket_complete with {NULL, 0, reason, 0}; reason should be negative
+ *  (e.g. KC_ECANCELED). Returns 0 or -ESTALE. */
+int kc_ticket_cancel(kc_ticket_t t, int reason);
+
+#ifdef __cplusplus
+}
+#endif
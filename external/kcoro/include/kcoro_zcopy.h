@@ -48,7 +48,7 @@
  *
  * Reader’s map
  *   - @defgroup kcoro_zcopy introduces the portable surface and conventions.
- *   - kc_zdesc is the common descriptor; addr+len today, region fields reserved.
+ *   - kc_zdesc is the common descriptor: addr+len, or a (region_id, offset).
  *   - kc_zcopy_backend_ops is the minimal vtable for pluggable backends.
  *   - kc_chan_send_desc / kc_chan_recv_desc are the canonical APIs for zcopy.
  */
@@ -124,24 +124,80 @@ static inline int kc_chan_is_zero_copy(kc_chan_t *ch) {
 /**
  * @brief Common zero-copy descriptor.
  *
- * Today only addr + len are required. Region fields are reserved for future
- * shared-memory or adapter backends and remain inert in the unified "zref"
- * backend.
+ * A send names its payload by addr + len, or, with addr NULL, by region_id
+ * (kc_region_export_id) + offset; the send resolves that against the
+ * registry and fails with -ENOENT or -EINVAL when the range is not in a live
+ * region. Backends only ever see addr. With KC_ZDESC_F_IOV, addr is a
+ * kc_ziov_t (below) rather than the payload. A recv that sets KC_ZDESC_F_REGION
+ * in flags gets region_id/offset filled in as well (0 outside any region),
+ * which is how the IPC layer turns a queued payload back into a descriptor
+ * the peer can map.
  */
 typedef struct kc_zdesc {
-    void       *addr;      /* optional fast-path local address */
+    void       *addr;      /* local address; NULL: use region_id + offset */
     size_t      len;       /* payload length */
-    uint64_t    region_id; /* optional: opaque region identifier */
-    uint64_t    offset;    /* optional: offset within region */
-    uint32_t    flags;     /* reserved for future use */
+    uint64_t    region_id; /* region export ID, 0 for none */
+    uint64_t    offset;    /* offset within region */
+    uint32_t    flags;     /* KC_ZDESC_F_* */
 } kc_zdesc_t;
 
+/** Recv: also report region_id/offset for the received addr. */
+#define KC_ZDESC_F_REGION (1u<<0)
+/** addr is a kc_ziov_t: a payload in several segments (zref backend). */
+#define KC_ZDESC_F_IOV    (1u<<1)
+
+/** Segments a kc_ziov_t keeps inline; the rest sit behind `more`. */
+#define KC_ZIOV_INLINE 4
+/** Most segments in one kc_ziov_t. */
+#define KC_ZIOV_MAX    64
+
+/** One payload segment (laid out like struct iovec). */
+typedef struct kc_zseg {
+    void   *addr;
+    size_t  len;
+} kc_zseg_t;
+
+/**
+ * @brief Scatter-gather payload, e.g. a header and a body in separate buffers.
+ *
+ * Sent by reference: a kc_zdesc_t with KC_ZDESC_F_IOV and addr = &ziov (len
+ * is ignored, region_id must be 0). The receiver gets KC_ZDESC_F_IOV, addr
+ * pointing at the same kc_ziov_t and len the total of its segments, which is
+ * also what byte counters see. Like any zref payload the struct and its
+ * segments stay the sender's until the receiver is done with them, and a
+ * kc_ziov_t sits in one channel at a time: while queued, `held` records the
+ * segments whose registered region it keeps alive.
+ */
+typedef struct kc_ziov {
+    uint32_t   nseg;                 /* segments in use, 1..KC_ZIOV_MAX */
+    uint32_t   rsvd;
+    kc_zseg_t  seg[KC_ZIOV_INLINE];  /* segments 0..KC_ZIOV_INLINE-1 */
+    kc_zseg_t *more;                 /* segments KC_ZIOV_INLINE..nseg-1 */
+    uint64_t   held;                 /* owned by the channel while in flight */
+} kc_ziov_t;
+
+/** Segment i of v (i < v->nseg). */
+static inline const kc_zseg_t *kc_ziov_seg(const kc_ziov_t *v, uint32_t i)
+{
+    return i < KC_ZIOV_INLINE ? &v->seg[i] : &v->more[i - KC_ZIOV_INLINE];
+}
+
+/** Total bytes in v's segments; 0 when v is not well formed (no segments,
+ *  more than KC_ZIOV_MAX, a NULL or empty segment, `more` missing). */
+size_t kc_ziov_len(const kc_ziov_t *v);
+/** Gather v into dst[cap]; returns the bytes copied (at most cap). For the
+ *  consumer that needs the message flat after all. */
+size_t kc_ziov_copyout(const kc_ziov_t *v, void *dst, size_t cap);
+
 /**
  * @brief Backend vtable for zero-copy operations.
  *
- * The channel router ensures per-op statistics are updated by calling shared
- * helpers. Implementations must not free payload memory; ownership remains
- * with the caller/integration.
+ * Backends update per-op statistics themselves (kc_chan_zcopy_account
+ * below). Implementations must not free payload memory; ownership remains
+ * with the caller/integration. attach runs from
+ * kc_chan_enable_zero_copy_backend and detach from kc_chan_destroy, both
+ * with the channel lock held; detach is the last call a backend sees for the
+ * channel.
  */
 typedef struct kc_zcopy_backend_ops {
     int  (*attach)(kc_chan_t *ch, const void *opts); /* set up per-channel state */
@@ -184,6 +240,20 @@ int kc_chan_enable_zero_copy_backend(kc_chan_t *ch,
                                      kc_zcopy_backend_id id,
                                      const void *opts);
 
+/**
+ * @brief Channel state for backends living outside core.
+ *
+ * kc_chan_zcopy_set_priv is meant for attach (lock held, so it takes none);
+ * kc_chan_zcopy_priv returns the pointer afterwards. kc_chan_zcopy_account
+ * counts one successful send (send != 0) or recv of len bytes in the
+ * channel's stats. kc_chan_zcopy_closed is 1 once the channel was closed, for
+ * backends that wait on their own descriptors rather than the channel.
+ */
+void *kc_chan_zcopy_priv(kc_chan_t *ch);
+void  kc_chan_zcopy_set_priv(kc_chan_t *ch, void *priv);
+void  kc_chan_zcopy_account(kc_chan_t *ch, int send, size_t len);
+int   kc_chan_zcopy_closed(kc_chan_t *ch);
+
 /**
  * @brief Send/receive using a descriptor (canonical zcopy API).
  *
@@ -196,6 +266,198 @@ int kc_chan_recv_desc(kc_chan_t *ch, kc_zdesc_t *d, long timeout_ms);
 /** Cancellable variants; return KC_ECANCELED if token is set. */
 int kc_chan_send_desc_c(kc_chan_t *ch, const kc_zdesc_t *d, long timeout_ms, const kc_cancel_t *ct);
 int kc_chan_recv_desc_c(kc_chan_t *ch, kc_zdesc_t *d, long timeout_ms, const kc_cancel_t *ct);
+/**
+ * @brief Batch variants; semantics of kc_chan_send_many / kc_chan_recv_many.
+ *
+ * On a zref buffered/unlimited channel a batch moves descriptors in and out
+ * of the channel's descriptor ring in runs, one lock hold per run, and
+ * producers may run ahead of consumers up to its capacity. Other kinds and
+ * backends loop over kc_chan_send_desc/kc_chan_recv_desc. Every descriptor
+ * is checked before any is sent; KC_ZDESC_F_REGION in out[0].flags asks
+ * for region_id/offset on every received one.
+ */
+int kc_chan_send_desc_many(kc_chan_t *ch, const kc_zdesc_t *d, size_t n, long timeout_ms, size_t *sent);
+int kc_chan_recv_desc_many(kc_chan_t *ch, kc_zdesc_t *out, size_t max, long timeout_ms, size_t *got);
+
+/* ============================ Buffer Pools ============================== */
+/**
+ * @brief Fixed-size payload buffers carved out of a registered region.
+ *
+ * Gives zref producers a buffer lifecycle without malloc/free per message:
+ * kc_bufpool_get hands out a buffer holding one reference, each extra
+ * consumer of a fanned-out buffer takes one with kc_bufpool_retain, and
+ * the last kc_bufpool_release puts it back. Gets and releases go through a
+ * small per-thread cache, so a buffer freed on the consumer's worker is
+ * reused there instead of bouncing back to the producer's allocator.
+ *
+ * Buffers are buf_size rounded up to 64 bytes; the region holds
+ * len / that many. The pool keeps a reference on the region until
+ * kc_bufpool_destroy, which fails with -EBUSY while buffers are out.
+ */
+typedef struct kc_bufpool kc_bufpool_t;
+
+struct kc_bufpool_stats {
+    unsigned long hits;      /* gets served from a thread cache */
+    unsigned long misses;    /* gets that refilled from the depot */
+    unsigned long empty;     /* gets that found no free buffer (NULL) */
+    unsigned long capacity;  /* buffers in the pool */
+    unsigned long in_use;    /* buffers handed out, not yet released */
+};
+
+/** 0, -EINVAL (region smaller than one buffer), -ENOENT (region not live) or -ENOMEM. */
+int   kc_bufpool_create(kc_bufpool_t **out, kc_region_t *reg, size_t buf_size);
+int   kc_bufpool_destroy(kc_bufpool_t *pool);
+/** A free buffer with one reference, or NULL when all are out. */
+void *kc_bufpool_get(kc_bufpool_t *pool);
+/** buf may point anywhere inside a buffer. 0, or -EINVAL when buf is not a
+ *  buffer of this pool or is not handed out. */
+int   kc_bufpool_retain(kc_bufpool_t *pool, void *buf);
+int   kc_bufpool_release(kc_bufpool_t *pool, void *buf);
+size_t kc_bufpool_buf_size(const kc_bufpool_t *pool);
+kc_region_t *kc_bufpool_region(const kc_bufpool_t *pool);
+int   kc_bufpool_get_stats(kc_bufpool_t *pool, struct kc_bufpool_stats *out);
+
+/** Report pool's counters in this channel's kc_chan_get_zstats (NULL
+ *  unbinds). The pool must outlive the binding. */
+int   kc_chan_set_bufpool(kc_chan_t *ch, kc_bufpool_t *pool);
+
+/** Carry pool buffers through a broadcast channel made with
+ *  elem_sz == sizeof(void*): a send hands the sender's reference to the
+ *  ring, every recv returns the pointer with a reference of its own for the
+ *  receiver to release, and the ring drops its reference once the message
+ *  is overwritten or b destroyed. One payload write serves every
+ *  subscriber. 0, -EINVAL, or -EBUSY after the first send or a second
+ *  binding. The pool must outlive b. */
+int   kc_bcast_set_bufpool(kc_bcast_t *b, kc_bufpool_t *pool);
+
+/* ========================= Mapped file streams ========================== */
+/**
+ * @brief Zero-copy reader over one file (a dataset shard).
+ *
+ * kc_mstream_open maps the file read-only as a registered region and
+ * kc_mstream_next hands it out front to back as descriptors of whole
+ * records, so a loader passes records to consumers without read() or a
+ * copy. The stream keeps opts.readahead bytes past its position advised
+ * MADV_WILLNEED (the mapping is MADV_SEQUENTIAL as well), so page-in
+ * overlaps with the consumers' work. Consumers kc_mstream_release each
+ * descriptor when done. Pages below the oldest unreleased one (less
+ * opts.keep_behind) are dropped with MADV_DONTNEED. At most opts.window
+ * descriptors, counted from the oldest one still out, are handed out at
+ * once; next waits for releases past that. Resident memory thus stays near
+ * readahead + keep_behind + what the window holds, whatever the file size.
+ *
+ * Records are framed by opts.framing. A descriptor carries as many whole
+ * records as fit in opts.batch_bytes (at least one). Its addr points into
+ * the mapping and region_id / offset name it in the region, so IPC
+ * channels can forward it too.
+ */
+typedef struct kc_mstream kc_mstream_t;
+
+#define KC_MSTREAM_FIXED  0   /**< records of record_size bytes */
+#define KC_MSTREAM_DELIM  1   /**< records end with, and include, the byte delim */
+#define KC_MSTREAM_LEN32  2   /**< a little-endian u32 length, then that many bytes */
+
+typedef struct kc_mstream_opts {
+    int      framing;      /* KC_MSTREAM_* */
+    size_t   record_size;  /* KC_MSTREAM_FIXED */
+    int      delim;        /* KC_MSTREAM_DELIM, e.g. '\n'; the last record may lack it */
+    size_t   batch_bytes;  /* 0: one record per descriptor */
+    size_t   readahead;    /* 0: KCORO_MSTREAM_READAHEAD */
+    size_t   keep_behind;  /* released bytes left resident; 0 drops them at once */
+    unsigned window;       /* descriptors from the oldest one out; 0: KCORO_MSTREAM_WINDOW */
+} kc_mstream_opts_t;
+
+struct kc_mstream_stats {
+    unsigned long records;   /* records handed out */
+    unsigned long descs;     /* descriptors handed out */
+    unsigned long bytes;     /* bytes handed out */
+    unsigned long inflight;  /* descriptors not yet released */
+    unsigned long willneed;  /* bytes advised MADV_WILLNEED */
+    unsigned long dropped;   /* bytes released with MADV_DONTNEED */
+    unsigned long window_waits; /* nexts that found the window full */
+};
+
+/** 0, -EINVAL (bad opts, empty file), -ENOSPC (region table full) or the
+ *  open/mmap errno. */
+int  kc_mstream_open(kc_mstream_t **out, const char *path, const kc_mstream_opts_t *opts);
+/** The next descriptor. 0; KC_EPIPE past the last record; KC_EAGAIN /
+ *  KC_ETIME while the window stays full; -EBADMSG at a record the file
+ *  truncates (the stream stays there). Coroutines and plain threads may
+ *  call it. */
+int  kc_mstream_next(kc_mstream_t *s, kc_zdesc_t *d, long timeout_ms);
+/** Send every remaining descriptor on ch (a zcopy channel) from a
+ *  coroutine. 0 at the end of the file, else next's or the send's error;
+ *  a descriptor the send refused is handed out again by the next call. */
+int  kc_mstream_pump(kc_mstream_t *s, kc_chan_t *ch, long timeout_ms);
+/** d as next handed it out (addr is enough), from any thread. 0, or
+ *  -EINVAL when it is not out. */
+int  kc_mstream_release(kc_mstream_t *s, const kc_zdesc_t *d);
+kc_region_t *kc_mstream_region(const kc_mstream_t *s);
+size_t kc_mstream_size(const kc_mstream_t *s);
+int  kc_mstream_get_stats(kc_mstream_t *s, struct kc_mstream_stats *out);
+/** 0, or -EBUSY while descriptors are out. Waits for channels still
+ *  holding sent descriptors (kc_region_deregister). */
+int  kc_mstream_close(kc_mstream_t *s);
+
+/* ====================== Double-buffered staging ========================= */
+/**
+ * @brief N region buffers cycling between a filling stage and a draining one.
+ *
+ * Ping-pong (N = 2) or deeper staging without hand-built channels: a writer
+ * takes a free buffer with kc_stage_acquire_for_write, fills it and hands it
+ * on with kc_stage_publish; a reader takes published buffers in publish
+ * order with kc_stage_acquire_for_read and gives them back to the free set
+ * with kc_stage_release. Buffers never
+ * move: each step hands over ownership of the same region-backed memory, so
+ * descriptors remain valid for zref channels and IPC. Every buffer is in
+ * exactly one state (free, writing, ready, reading) and a step from the
+ * wrong one is refused.
+ *
+ * Acquires park a coroutine (or sleep a plain thread) when nothing is
+ * available; the time spent there is counted per side. Writers stalling
+ * means readers are the bottleneck or N is too small to absorb their
+ * jitter; readers stalling means the writer is slower than the readers.
+ */
+typedef struct kc_stage kc_stage_t;
+
+struct kc_stage_stats {
+    unsigned long published;       /* buffers published */
+    unsigned long consumed;        /* buffers acquired for read */
+    unsigned long write_stalls;    /* write acquires that found no free buffer */
+    unsigned long read_stalls;     /* read acquires that found nothing published */
+    unsigned long write_stall_ns;  /* time write acquires spent waiting */
+    unsigned long read_stall_ns;   /* time read acquires spent waiting */
+    unsigned long ready;           /* published, not yet acquired for read */
+    unsigned long nbufs;
+};
+
+/** nbufs buffers of buf_size bytes (rounded up to 64) in one kc_region_alloc
+ *  region made with region_flags (KC_REGION_F_PINNED for DMA staging).
+ *  0, -EINVAL, or kc_region_alloc's error. */
+int  kc_stage_create(kc_stage_t **out, unsigned nbufs, size_t buf_size, unsigned region_flags);
+/** A free buffer: d->addr / len (the full buffer) / region_id / offset.
+ *  0, KC_EAGAIN / KC_ETIME when none frees up in time, KC_EPIPE once
+ *  closed. Coroutines and plain threads may call it. */
+int  kc_stage_acquire_for_write(kc_stage_t *st, kc_zdesc_t *d, long timeout_ms);
+/** Hand a written buffer to the readers with d->len valid bytes. 0;
+ *  -EINVAL when it is not being written or len exceeds it; KC_EPIPE once
+ *  closed (the buffer goes back to the free set). */
+int  kc_stage_publish(kc_stage_t *st, const kc_zdesc_t *d);
+/** The oldest published buffer, d->len as published. 0, KC_EAGAIN /
+ *  KC_ETIME, or KC_EPIPE once closed and drained. */
+int  kc_stage_acquire_for_read(kc_stage_t *st, kc_zdesc_t *d, long timeout_ms);
+/** Return a buffer taken for read to the free set. 0, or -EINVAL when it
+ *  is not being read. */
+int  kc_stage_release(kc_stage_t *st, const kc_zdesc_t *d);
+/** Writers get KC_EPIPE from now on; readers drain what was published,
+ *  then get KC_EPIPE. Idempotent. */
+void kc_stage_close(kc_stage_t *st);
+size_t kc_stage_buf_size(const kc_stage_t *st);
+kc_region_t *kc_stage_region(const kc_stage_t *st);
+int  kc_stage_get_stats(kc_stage_t *st, struct kc_stage_stats *out);
+/** 0, or -EBUSY while a buffer is being written or read. Waits for
+ *  channels still holding descriptors into it (kc_region_deregister). */
+int  kc_stage_destroy(kc_stage_t *st);
 
 
 #ifdef __cplusplus
@@ -0,0 +1,76 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/**
+ * @file kcoro_ipc_actor.h
+ * @brief Remote actor references: tell a kc_actor in another process.
+ *
+ * The server exports the actor's mailbox (kc_ipc_server_export) and hands
+ * its ID to clients. A client opens a reference over a kc_ipc_mux and tells
+ * it messages as it would send to the local mailbox; the reference queues
+ * them and a flusher coroutine ships whatever piled up since its last
+ * round trip as one kc_ipc_chan_send_many, which the server delivers with
+ * kc_chan_send_many. While a batch is in flight the next one builds, so
+ * batches grow with load and a lone message goes out at once. Frames of all
+ * references on one mux share its writer, which sends what the tick queued
+ * in one flush.
+ *
+ * Per reference, messages arrive in the order they were told. Delivery is
+ * fire-and-forget: a batch that fails (connection lost, mailbox closed)
+ * drops its messages, counts them in the stats and closes the reference,
+ * after which kc_ipc_actor_tell returns KC_EPIPE.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "kcoro_ipc_chan.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct kc_ipc_actor_ref kc_ipc_actor_ref_t;
+
+/* Per-reference counters; throughput from two snapshots or msgs_per_sec. */
+typedef struct kc_ipc_actor_stats {
+    unsigned long told;        /* accepted by kc_ipc_actor_tell */
+    unsigned long delivered;   /* queued into the remote mailbox */
+    unsigned long dropped;     /* lost to a failed batch */
+    unsigned long batches;     /* kc_ipc_chan_send_many round trips */
+    unsigned long bytes;       /* message bytes delivered */
+    uint64_t rtt_last_ns;      /* latest batch round trip */
+    uint64_t rtt_avg_ns;       /* mean over batches */
+    uint64_t rtt_max_ns;
+    uint64_t elapsed_ns;       /* since open */
+    double msgs_per_sec;       /* delivered / elapsed */
+    int error;                 /* error that closed the reference, 0 if none */
+} kc_ipc_actor_stats_t;
+
+/**
+ * Reference the exported mailbox chan_id (elements of msg_size bytes)
+ *
+ * The flusher runs on s (NULL: kc_sched_default()). Callable from any
+ * thread; the mux must outlive the reference.
+ *
+ * @return 0, -EINVAL or -ENOMEM
+ */
+int kc_ipc_actor_ref_open(kc_ipc_mux_t *mux, kc_sched_t *s, uint32_t chan_id, size_t msg_size,
+                          kc_ipc_actor_ref_t **out);
+
+/** Queue one message (msg_size bytes) without waiting, from any thread.
+ *  0, KC_EPIPE once the reference is closed, -EINVAL or -ENOMEM. */
+int kc_ipc_actor_tell(kc_ipc_actor_ref_t *ref, const void *msg);
+
+/** Snapshot the reference's counters. */
+void kc_ipc_actor_ref_stats(const kc_ipc_actor_ref_t *ref, kc_ipc_actor_stats_t *out);
+
+/**
+ * Stop accepting messages, wait until everything told is delivered or
+ * dropped, then free the reference. A coroutine caller parks; a thread
+ * blocks. The remote mailbox stays open.
+ */
+void kc_ipc_actor_ref_close(kc_ipc_actor_ref_t *ref);
+
+#ifdef __cplusplus
+}
+#endif
@@ -6,6 +6,7 @@
 
 #include "kcoro_ipc_posix.h"
 #include "../../../include/kcoro.h"
+#include "../../../include/kcoro_sched.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -14,6 +15,9 @@ extern "C" {
 /* Distributed channel handle (opaque) */
 typedef struct kc_ipc_chan kc_ipc_chan_t;
 
+/* Multiplexed client connection (opaque) */
+typedef struct kc_ipc_mux kc_ipc_mux_t;
+
 /* Distributed Channel API - Kotlin-like patterns over IPC */
 
 /**
@@ -24,7 +28,10 @@ typedef struct kc_ipc_chan kc_ipc_chan_t;
  * @param conn IPC connection to remote kcoro server
  * @param kind Channel kind (KC_RENDEZVOUS, KC_BUFFERED, etc.)
  * @param elem_sz Size of each element in bytes
- *                 Note: TLV transport limits a single element to <= 65535 bytes.
+ *                 An element must fit one frame: about 64 KiB on a socket
+ *                 connection, nearly KCORO_IPC_SHM_RING over shared memory
+ *                 (kc_ipc_conn_max_frame). Larger sizes return -EMSGSIZE.
+ *                 0 makes a descriptor channel (kc_ipc_chan_send_desc).
  * @param capacity Buffer capacity
  * @param out Output handle to created distributed channel
  * @return 0 on success, negative errno on failure
@@ -41,6 +48,60 @@ int kc_ipc_chan_make(kc_ipc_conn_t *conn, int kind, size_t elem_sz,
 int kc_ipc_chan_open(kc_ipc_conn_t *conn, uint32_t chan_id, int kind,
                      size_t elem_sz, kc_ipc_chan_t **out);
 
+/**
+ * Multiplex one connection for many in-flight requests
+ *
+ * Plain handles (kc_ipc_chan_make/open) send a request and block for its
+ * reply, so each op costs a full round trip. A mux lets up to `window`
+ * requests share the connection: each goes out tagged with a `req_id`, and a
+ * demux coroutine hands every reply to the caller whose `req_id` it echoes,
+ * in whatever order the server completes them. A writer coroutine owns the
+ * socket's send side. Both run on `s` (NULL: kc_sched_default()).
+ *
+ * Handshake first (kc_ipc_hs_cli); the mux then sets the connection
+ * non-blocking and owns it: do not use `conn` directly afterwards. If create
+ * fails before spawning its coroutines `conn` is left to the caller;
+ * -ENOMEM from kc_spawn_co closes it.
+ *
+ * Ops on mux handles must run in coroutines (they park); other callers get
+ * -EINVAL. Past `window` in-flight ops, callers wait for a free slot. A lost
+ * connection fails every waiting op with its error (-ECONNRESET on hang-up).
+ *
+ * @param window In-flight requests, at most 65535 (0 = KCORO_IPC_WINDOW)
+ * @return 0 on success, negative errno on failure
+ */
+int kc_ipc_mux_create(kc_ipc_conn_t *conn, kc_sched_t *s, size_t window, kc_ipc_mux_t **out);
+
+/**
+ * Tear down a mux and close its connection
+ *
+ * Ops still in flight return -ECONNRESET; memory goes when the last of them
+ * leaves. Start no new ops (and destroy no handles) after this. Callable
+ * from any thread.
+ */
+void kc_ipc_mux_destroy(kc_ipc_mux_t *mux);
+
+/* Load and latency of one mux (kc_ipc_mux_stats). */
+typedef struct kc_ipc_mux_stats {
+    size_t window;             /* in-flight limit */
+    unsigned inflight;         /* calls awaiting a reply, including those waiting for a slot */
+    unsigned queued;           /* frames waiting for the writer */
+    unsigned long calls;       /* replies received */
+    uint64_t rtt_last_ns;      /* latest call, queueing included */
+    uint64_t rtt_avg_ns;       /* mean over calls */
+    uint64_t rtt_max_ns;
+    int error;                 /* error that took the link down, 0 while up */
+} kc_ipc_mux_stats_t;
+
+/** Snapshot a mux's counters; callable from any thread. */
+void kc_ipc_mux_stats(kc_ipc_mux_t *mux, kc_ipc_mux_stats_t *out);
+
+/** kc_ipc_chan_make/open over a mux; the handle's ops go through it. */
+int kc_ipc_mux_chan_make(kc_ipc_mux_t *mux, int kind, size_t elem_sz,
+                         size_t capacity, kc_ipc_chan_t **out);
+int kc_ipc_mux_chan_open(kc_ipc_mux_t *mux, uint32_t chan_id, int kind,
+                         size_t elem_sz, kc_ipc_chan_t **out);
+
 /**
  * Get the remote channel ID associated with this handle.
  */
@@ -56,6 +117,14 @@ uint32_t kc_ipc_chan_id(kc_ipc_chan_t *ich);
  * @param msg Element to send (must be exactly elem_sz bytes)
  * @param timeout_ms Timeout in milliseconds (-1 = infinite, 0 = non-blocking)
  * @return 0 on success, KC_EAGAIN if would block, KC_ETIME on timeout, KC_EPIPE if closed
+ *
+ * Send credits (KC_BUFFERED, timeout_ms -1): a send that waits for its reply
+ * asks for up to KCORO_IPC_CREDITS credits, and the server grants what the
+ * ring has free. While credits remain, sends go out without waiting and return
+ * 0 once queued; a send that finds none left blocks and asks again. A
+ * credited send can be overtaken by a later one only when other producers
+ * filled the ring in between. One that hits a closed channel is dropped and
+ * the next blocking op reports KC_EPIPE.
  */
 int kc_ipc_chan_send(kc_ipc_chan_t *ich, const void *msg, long timeout_ms);
 
@@ -72,6 +141,78 @@ int kc_ipc_chan_send(kc_ipc_chan_t *ich, const void *msg, long timeout_ms);
  */
 int kc_ipc_chan_recv(kc_ipc_chan_t *ich, void *out, long timeout_ms);
 
+/**
+ * Batch send/receive (kc_chan_send_many/kc_chan_recv_many over IPC)
+ *
+ * Elements travel back to back as many per frame as fit one (about
+ * kc_ipc_conn_max_frame / elem_sz); a larger send goes out as several
+ * frames, one round trip each, and timeout_ms applies to each of them.
+ * Served connections only (kc_ipc_server_serve); -ENOTSUP otherwise.
+ *
+ * send_many: 0 once all n are queued, in order; otherwise the error that
+ * stopped it with *sent = elements queued so far.
+ * recv_many: waits for the first element, then takes up to max (capped to
+ * one frame's worth) without waiting again. 0 with *got >= 1, or
+ * KC_EAGAIN/KC_ETIME/KC_EPIPE with *got = 0.
+ */
+int kc_ipc_chan_send_many(kc_ipc_chan_t *ich, const void *msgs, size_t n, long timeout_ms,
+                          size_t *sent);
+int kc_ipc_chan_recv_many(kc_ipc_chan_t *ich, void *out, size_t max, long timeout_ms,
+                          size_t *got);
+
+/**
+ * Add a receive from a mux handle to a local select
+ *
+ * The clause waits on a local relay channel of the handle. When
+ * kc_select_wait is about to park it sends one CHAN_RECV with no time
+ * limit, pipelined like any mux call, and the demux drops the element into
+ * the relay when the server answers; local and remote clauses then share
+ * one parked wait. When another clause wins, the remote receive is
+ * cancelled (CHAN_CANCEL). An element the server handed out before the
+ * cancel got there stays in the relay. The next select or receive on the
+ * handle takes it first.
+ *
+ * - A wait with timeout_ms 0 sends nothing and sees only what the relay
+ *   already holds.
+ * - The remote channel closing, or the link going down, closes the relay;
+ *   the clause then completes with KC_EPIPE. A link already down when the
+ *   wait starts ends it with the link's error.
+ * - A handle takes part in one wait at a time, and its other receives must
+ *   not run during it.
+ *
+ * @return 0, -EINVAL or -ENOTSUP (not a mux handle, or a descriptor
+ *         channel), or an error of kc_select_add_recv
+ */
+int kc_ipc_select_add_recv(kc_select_t *sel, kc_ipc_chan_t *ich, void *out);
+
+/**
+ * Send a payload by reference through a descriptor channel (elem_sz 0)
+ *
+ * The payload is len bytes at off in reg, a shared region
+ * (kc_region_create_shared). The region goes to the server once per
+ * connection (kc_ipc_region_export); after that only (region, off, len)
+ * crosses the link, whatever the payload size. The bytes are neither copied
+ * nor owned by the channel: leave them alone until the receiver is done,
+ * and keep this connection open while descriptors into its regions are
+ * queued (the server unmaps them when it closes).
+ *
+ * @return 0 on success, negative errno or KC_* code as kc_ipc_chan_send;
+ *         -EINVAL when the range is outside reg or ich carries elements
+ */
+int kc_ipc_chan_send_desc(kc_ipc_chan_t *ich, kc_region_t *reg, size_t off, size_t len,
+                          long timeout_ms);
+
+/**
+ * Receive a descriptor from a descriptor channel
+ *
+ * *ptr points into this process's mapping of the sender's region, mapped
+ * when the first descriptor into it arrived and kept until the connection
+ * closes; the sender's writes are visible there directly.
+ *
+ * @return 0 on success, negative errno or KC_* code as kc_ipc_chan_recv
+ */
+int kc_ipc_chan_recv_desc(kc_ipc_chan_t *ich, void **ptr, size_t *len, long timeout_ms);
+
 /**
  * Non-blocking send to distributed channel
  * 
@@ -100,6 +241,7 @@ int kc_ipc_chan_try_recv(kc_ipc_chan_t *ich, void *out);
  * Close distributed channel for sending
  * 
  * Equivalent to Kotlin's channel.close()
+ * On a mux handle this also waits for the server's acknowledgment.
  * 
  * @param ich Distributed channel handle
  * @return 0 on success, negative errno on failure
@@ -115,6 +257,16 @@ int kc_ipc_chan_close(kc_ipc_chan_t *ich);
  */
 void kc_ipc_chan_destroy(kc_ipc_chan_t *ich);
 
+/* Process-wide counters for distributed channels. */
+typedef struct kc_ipc_stats {
+    unsigned long credited_sends;   /* sends posted on a credit, no reply awaited */
+    unsigned long credit_stalls;    /* buffered sends that found no credit and blocked */
+    unsigned long credits_granted;  /* credits the servers handed out */
+    kc_ipc_lz4_stats_t lz4;         /* TCP compression (kc_ipc_get_lz4_stats) */
+} kc_ipc_stats_t;
+
+void kc_ipc_get_stats(kc_ipc_stats_t *out);
+
 #ifdef __cplusplus
 }
 #endif
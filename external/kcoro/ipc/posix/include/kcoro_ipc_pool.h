@@ -0,0 +1,70 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/**
+ * @file kcoro_ipc_pool.h
+ * @brief Client connection pool: shard channels over several muxed links.
+ *
+ * One kc_ipc_mux_t pipelines many requests, but they still share a single
+ * socket and server-side serve loop. One connection per coroutine would
+ * spread the load, but it runs out of descriptors. A pool sits between the
+ * two: it wraps N connections to the same server in one mux each and hands
+ * out handles bound to one of them.
+ *
+ * - kc_ipc_pool_chan_open shards by ID: chan_id % N, so all handles to a
+ *   channel share a link and a channel's ops stay in order on it.
+ * - kc_ipc_pool_chan_make puts the new channel on the link with the fewest
+ *   calls in flight (round robin among equals). The returned handle is bound to that link, which may
+ *   not be the one an open of the same ID picks later; the server's
+ *   registry serves any ID on any connection.
+ *
+ * Handles are ordinary mux handles (kc_ipc_chan_*, kc_ipc_chan_destroy);
+ * their ops run in coroutines, as on a mux.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "kcoro_ipc_chan.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct kc_ipc_pool kc_ipc_pool_t;
+
+/**
+ * Pool n handshaken connections to one server (kc_ipc_hs_cli on each)
+ *
+ * Each gets a kc_ipc_mux_create(conn, s, window); see there. On success the
+ * pool owns all of them. On failure, muxes already created are destroyed
+ * with their connections, the one that failed goes as kc_ipc_mux_create
+ * says, and the rest stay with the caller.
+ *
+ * @return 0, -EINVAL (no connections) or an error of kc_ipc_mux_create
+ */
+int kc_ipc_pool_create(kc_ipc_conn_t **conns, size_t n, kc_sched_t *s, size_t window,
+                       kc_ipc_pool_t **out);
+
+/** Destroy every mux and close the connections; handles must be gone. */
+void kc_ipc_pool_destroy(kc_ipc_pool_t *pool);
+
+/** Connections in the pool. */
+size_t kc_ipc_pool_size(const kc_ipc_pool_t *pool);
+
+/** The mux for chan_id (chan_id % size), e.g. for kc_ipc_actor_ref_open. */
+kc_ipc_mux_t *kc_ipc_pool_mux(kc_ipc_pool_t *pool, uint32_t chan_id);
+
+/** kc_ipc_mux_chan_make on the least busy connection. */
+int kc_ipc_pool_chan_make(kc_ipc_pool_t *pool, int kind, size_t elem_sz, size_t capacity,
+                          kc_ipc_chan_t **out);
+
+/** kc_ipc_mux_chan_open on kc_ipc_pool_mux(pool, chan_id). */
+int kc_ipc_pool_chan_open(kc_ipc_pool_t *pool, uint32_t chan_id, int kind, size_t elem_sz,
+                          kc_ipc_chan_t **out);
+
+/** kc_ipc_mux_stats of connection i (< size); zeros when out of range. */
+void kc_ipc_pool_stats(kc_ipc_pool_t *pool, size_t i, kc_ipc_mux_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
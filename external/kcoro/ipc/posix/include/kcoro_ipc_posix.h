@@ -1,7 +1,8 @@
 // SPDX-License-Identifier: BSD-3-Clause
 /**
  * @file kcoro_ipc_posix.h
- * @brief POSIX domain-socket transport for kcoro IPC (full‑duplex, frame‑based).
+ * @brief POSIX socket transport for kcoro IPC (full‑duplex, frame‑based):
+ *        Unix-domain on one host, TCP across hosts.
  *
  * Purpose
  * - Provide a small, portable, full‑duplex transport that carries channel RPCs
@@ -10,9 +11,32 @@
  *   clean layering (channels remain pure library logic).
  *
  * Framing
- * - Wire header (versioned) + TLV payload. Request/response correlation is
- *   handled by `req_id` TLV; servers echo the same `req_id` so clients can
- *   complete the correct awaiter.
+ * - Wire header (versioned) + TLV payload, sent together as one socket
+ *   record of at most KCORO_IPC_MAX_FRAME payload bytes. Request/response
+ *   correlation is handled by `req_id` TLV; servers echo the same `req_id`
+ *   so clients can complete the correct awaiter.
+ * - A TLV length of KC_TLV_LEN_EXT means a 32‑bit length follows the
+ *   header; that is how elements of 64 KiB and up are encoded.
+ *
+ * TCP
+ * - kc_ipc_srv_listen_tcp/kc_ipc_connect_tcp carry the same frames over a
+ *   TCP stream (TCP_NODELAY); every call below works the same on it. A
+ *   stream receive reads ahead, so frames may be waiting with the socket
+ *   not readable: drain with the _nb receives until -EAGAIN before waiting
+ *   on kc_ipc_conn_fd. No descriptors cross TCP, hence no shared memory and
+ *   no shared regions.
+ *
+ * Shared memory
+ * - When both ends agree in the handshake (KCORO_CAP_SHM), frames move
+ *   through a pair of shared‑memory rings and the socket only carries
+ *   doorbells. The calls below behave the same either way, except that a
+ *   writer whose flush says -EAGAIN must wait in kc_ipc_await_flush rather
+ *   than on the socket being writable.
+ *
+ * Shared regions
+ * - kc_ipc_region_export hands a shared region (kc_region_create_shared) to
+ *   the peer over SCM_RIGHTS; the peer maps it once and payloads inside it
+ *   can then be named by (region ID, offset, length) instead of copied.
  *
  * Semantics
  * - Transport preserves channel error codes (EAGAIN/ETIME/ECANCELED/EPIPE).
@@ -23,8 +47,10 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <sys/uio.h>
 
 #include "../../../proto/kcoro_proto.h"
+#include "../../../include/kcoro.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -46,29 +72,123 @@ int  kc_ipc_srv_fd(kc_ipc_server_t *srv); /* for epoll/kqueue */
 /* Client lifecycle (active connect). */
 int  kc_ipc_connect(const char *sock_path, kc_ipc_conn_t **out);
 
-/* Handshake (version exchange). Returns 0 on success; fills peer ABI. */
+/* TCP endpoints. host NULL listens on every address; port "0" picks a free
+ * one, which kc_ipc_srv_port reports (-ENOTSUP for a Unix socket). Names
+ * that do not resolve return -EADDRNOTAVAIL. Connect parks a coroutine
+ * caller until the connection is up. */
+int  kc_ipc_srv_listen_tcp(const char *host, const char *port, kc_ipc_server_t **out);
+/* As kc_ipc_srv_listen_tcp with SO_REUSEPORT: several listeners bind the
+ * same port and the kernel spreads incoming connections across them (give
+ * the later ones the first one's kc_ipc_srv_port when it was "0").
+ * -ENOTSUP where the option does not exist. */
+int  kc_ipc_srv_listen_tcp_reuseport(const char *host, const char *port, kc_ipc_server_t **out);
+int  kc_ipc_srv_port(kc_ipc_server_t *srv);
+int  kc_ipc_connect_tcp(const char *host, const char *port, kc_ipc_conn_t **out);
+/* SO_BUSY_POLL on a TCP connection: spin up to usec on the device queue
+ * before sleeping in a receive. Needs CAP_NET_ADMIN to raise above the
+ * system default; -ENOTSUP where unavailable or on Unix sockets. */
+int  kc_ipc_conn_set_busy_poll(kc_ipc_conn_t *c, unsigned usec);
+
+/* Handshake (version exchange). Returns 0 on success; fills peer ABI.
+ * The client offers shared-memory rings (KCORO_IPC_SHM); the server sets
+ * them up when it can, and both ends switch to them once it answers.
+ * Over TCP it offers LZ4 instead (KCORO_IPC_LZ4): with both ends willing,
+ * each flush of at least KCORO_IPC_LZ4_MIN bytes goes out as one
+ * compressed frame when that makes it smaller. Either way both ends offer
+ * the fixed-layout hot commands (KCORO_CAP_FIXED, see kc_ipc_conn_fixed). */
 int  kc_ipc_hs_cli(kc_ipc_conn_t *c, uint32_t *peer_major, uint32_t *peer_minor);
 int  kc_ipc_hs_srv(kc_ipc_conn_t *c, uint32_t *peer_major, uint32_t *peer_minor);
+/* Server side of kc_ipc_hs_srv for a HELLO payload the caller already read. */
+int  kc_ipc_hs_answer(kc_ipc_conn_t *c, const uint8_t *hello, size_t n,
+                      uint32_t *peer_major, uint32_t *peer_minor);
 
 /* Message send/recv (TLV‑encoded payload). Allocates *payload on recv; caller frees. */
 int  kc_ipc_send(kc_ipc_conn_t *c, uint16_t cmd, const void *payload, size_t len);
+/* One frame whose payload is gathered from iov[0..iovcnt) (at most
+ * KCORO_IPC_IOV_MAX): a socket link hands the segments to one sendmsg, shared
+ * memory copies them into the ring in turn. kc_ipc_send_ziov sends a
+ * kc_ziov_t (kcoro_zcopy.h) that way, e.g. one taken off a zref channel. */
+int  kc_ipc_sendv(kc_ipc_conn_t *c, uint16_t cmd, const struct iovec *iov, int iovcnt);
+struct kc_ziov;
+int  kc_ipc_send_ziov(kc_ipc_conn_t *c, uint16_t cmd, const struct kc_ziov *v);
 int  kc_ipc_recv(kc_ipc_conn_t *c, uint16_t *cmd, uint8_t **payload, size_t *len);
 
+/* Receive into caller storage: no allocation. *len gets the payload size;
+ * a frame larger than cap is dropped with -EMSGSIZE. */
+int  kc_ipc_recv_into(kc_ipc_conn_t *c, uint16_t *cmd, void *buf, size_t cap, size_t *len);
+
 /* Close connection and free resources. */
 void kc_ipc_conn_close(kc_ipc_conn_t *c);
 
 /* Non‑blocking helpers for connections. */
 int  kc_ipc_conn_set_nb(kc_ipc_conn_t *c, int nb_on);
-int  kc_ipc_conn_fd(kc_ipc_conn_t *c); /* for epoll/kqueue */
+int  kc_ipc_conn_fd(kc_ipc_conn_t *c); /* for epoll/kqueue; readable = frames waiting */
+/* Largest payload one frame may carry: KCORO_IPC_MAX_FRAME on a socket,
+ * nearly the ring size over shared memory. Size receive buffers with it. */
+size_t kc_ipc_conn_max_frame(kc_ipc_conn_t *c);
+/* Shut the link down both ways; parked readers and writers wake with an
+ * error. The connection still needs kc_ipc_conn_close. */
+int  kc_ipc_conn_shutdown(kc_ipc_conn_t *c);
+/* 1 when the handshake turned on LZ4 compression for c. */
+int  kc_ipc_conn_lz4(kc_ipc_conn_t *c);
+/* 1 when both HELLOs offered KCORO_CAP_FIXED: channel handles on c then
+ * send their send/recv/batch requests in the fixed layout. */
+int  kc_ipc_conn_fixed(kc_ipc_conn_t *c);
+
+/* Process-wide LZ4 counters over all compressing TCP connections. */
+typedef struct kc_ipc_lz4_stats {
+    unsigned long batches;      /* compressed frames sent */
+    unsigned long frames;       /* frames they carried */
+    unsigned long skipped;      /* flushes sent as they were: no gain */
+    unsigned long unpacked;     /* compressed frames received */
+    uint64_t raw_bytes;         /* batches before compression, headers included */
+    uint64_t wire_bytes;        /* the same batches as sent */
+    uint64_t compress_ns;       /* CPU time compressing (skipped flushes too) */
+    uint64_t decompress_ns;     /* CPU time unpacking */
+    double ratio;               /* raw_bytes / wire_bytes; 0 before the first batch */
+} kc_ipc_lz4_stats_t;
 
-/* Frame‑based non‑blocking I/O with internal state (staged buffers). */
+void kc_ipc_get_lz4_stats(kc_ipc_lz4_stats_t *out);
+
+/* Frame‑based non‑blocking I/O with internal state (staged buffers).
+ * Up to KCORO_IPC_TXQ frames are staged per connection; kc_ipc_flush sends
+ * them all with as few syscalls as the kernel allows (one sendmmsg on Linux).
+ * Do not mix with the blocking kc_ipc_send while frames are staged. */
+/* Stage a frame without any I/O; -ENOBUFS when KCORO_IPC_TXQ are staged. */
+int  kc_ipc_queue(kc_ipc_conn_t *c, uint16_t cmd, const void *payload, size_t len);
+/* Stage and flush: 0 when everything is out, -EAGAIN when this frame is
+ * staged but some is still pending (flush again once writable), -ENOBUFS
+ * when the queue stayed full and nothing was staged. */
 int  kc_ipc_send_nb(kc_ipc_conn_t *c, uint16_t cmd, const void *payload, size_t len);
 int  kc_ipc_flush(kc_ipc_conn_t *c); /* attempt to flush pending write; -EAGAIN if still pending */
+/* Park (or block, off a coroutine) until a flush that said -EAGAIN can make
+ * progress: the socket is writable, or the peer freed ring space. */
+int  kc_ipc_await_flush(kc_ipc_conn_t *c, long timeout_ms);
 int  kc_ipc_recv_nb(kc_ipc_conn_t *c, uint16_t *cmd, uint8_t **payload, size_t *len);
+int  kc_ipc_recv_nb_into(kc_ipc_conn_t *c, uint16_t *cmd, void *buf, size_t cap, size_t *len);
+
+/* Shared regions. Export passes reg's descriptor to the peer once per
+ * connection (later calls return 0 at once); -ENOTSUP for a region without
+ * one or over TCP, -ENOSPC past KCORO_IPC_REGIONS. The peer maps it on receipt, before
+ * it sees any frame sent after the export, and keeps it mapped until its
+ * connection closes; lookup returns that mapping by the exporter's
+ * kc_region_export_id, or -ENOENT. The region belongs to the connection:
+ * do not deregister it. */
+int  kc_ipc_region_export(kc_ipc_conn_t *c, kc_region_t *reg);
+int  kc_ipc_region_lookup(kc_ipc_conn_t *c, uint64_t peer_id, kc_region_t **out);
 
 /* TLV helpers (encode into a flat buffer). */
+#define KC_TLV_LEN_EXT 0xFFFFu /* length field escape: u32 length follows */
 int  kc_tlv_put_u32(uint8_t **cursor, uint8_t *end, uint16_t type, uint32_t v);
 int  kc_tlv_put_u64(uint8_t **cursor, uint8_t *end, uint16_t type, uint64_t v);
+/* Any length; uses the KC_TLV_LEN_EXT form from 0xFFFF bytes up. */
+int  kc_tlv_put_bytes(uint8_t **cursor, uint8_t *end, uint16_t type, const void *v, size_t len);
+/* Decode the TLV at *off (advanced past it). 1 while one was read, 0 at the
+ * end of p[n] or on a truncated TLV. */
+int  kc_tlv_next(const uint8_t *p, size_t n, size_t *off, uint16_t *type,
+                 const uint8_t **val, size_t *vlen);
+/* The value of an 8-byte TLV read by kc_tlv_next (kc_tlv_put_u64's). */
+uint64_t kc_tlv_val_u64(const uint8_t *val);
 
 /* No alias layer; short names are canonical. */
 
@@ -4,13 +4,15 @@
  * @brief Minimal server‑side dispatcher for distributed channel RPCs.
  *
  * Role
- * - Owns a simple registry of local channels (chan_id → kc_chan_t*).
+ * - Owns a registry of local channels (chan_id → kc_chan_t*), indexed by ID
+ *   with lock-free lookups.
  * - Decodes incoming frames (CHAN_MAKE/SEND/RECV/CLOSE/DESTROY), invokes the
  *   corresponding local operation, and replies with a result payload.
  * - Echoes `req_id` (if provided) so clients can correlate responses.
  *
  * Notes
- * - The coroutine‑native version replaces any blocking waits with park/unpark.
+ * - kc_ipc_server_serve runs a connection entirely on coroutines: channel ops
+ *   park instead of blocking, and parked requests pipeline.
  * - Error codes in replies mirror local channel semantics.
  */
 #pragma once
@@ -19,6 +21,8 @@
 #include <stdint.h>
 
 #include "kcoro_ipc_posix.h"
+#include "../../../include/kcoro.h"
+#include "../../../include/kcoro_sched.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -41,6 +45,21 @@ kc_ipc_server_ctx_t *kc_ipc_server_ctx_create(void);
  */
 void kc_ipc_server_ctx_destroy(kc_ipc_server_ctx_t *ctx);
 
+/**
+ * Make a channel the caller owns reachable by ID (e.g. an actor's mailbox)
+ *
+ * Clients attach with kc_ipc_chan_open/kc_ipc_mux_chan_open using the ID
+ * and the same kind and element size. The channel stays the caller's: a
+ * client's CHAN_DESTROY leaves it open and kc_ipc_server_ctx_destroy does
+ * not destroy it, but it must outlive ctx (entries are never removed).
+ *
+ * @param ch Local channel; elem_sz must be its element size (not 0)
+ * @param out_id Channel ID for clients
+ * @return 0 on success, -EINVAL or -ENOMEM
+ */
+int kc_ipc_server_export(kc_ipc_server_ctx_t *ctx, kc_chan_t *ch, int kind, size_t elem_sz,
+                         size_t capacity, uint32_t *out_id);
+
 /**
  * Handle an incoming IPC command from a client
  * 
@@ -57,6 +76,52 @@ void kc_ipc_server_ctx_destroy(kc_ipc_server_ctx_t *ctx);
 int kc_ipc_handle_command(kc_ipc_server_ctx_t *ctx, kc_ipc_conn_t *conn,
                          uint16_t cmd, const uint8_t *payload, size_t len);
 
+/**
+ * Serve one connection from the calling coroutine until the peer hangs up
+ *
+ * Runs the HELLO handshake, then handles frames as kc_ipc_handle_command
+ * does without blocking the worker: reads park in kc_await_readable, and a
+ * send/recv that has to wait runs in its own coroutine while later frames
+ * are served (up to KCORO_IPC_PIPELINE at a time), so replies may come back
+ * out of order and are matched by req_id. Ops still parked at hang-up end
+ * with KC_ECANCELED. Spawn one coroutine per accepted connection.
+ *
+ * @param ctx Server context (shared by all connections; must outlive them)
+ * @param conn Accepted connection; closed (and freed) before returning
+ * @return 0 when the peer hung up, negative errno on failure; -EINVAL
+ *         (conn untouched) when not called from a scheduler coroutine
+ */
+int kc_ipc_server_serve(kc_ipc_server_ctx_t *ctx, kc_ipc_conn_t *conn);
+
+/* Accept loops started by kc_ipc_server_start (opaque) */
+typedef struct kc_ipc_acceptor kc_ipc_acceptor_t;
+
+/**
+ * Accept and serve connections on listeners[0..n) from coroutines on s
+ *
+ * Each listener gets an acceptor coroutine (and is set non-blocking); each
+ * accepted connection gets its own kc_ipc_server_serve coroutine, which the
+ * scheduler spreads over its workers. Several acceptors: one per Unix
+ * socket or TCP address served, or several kc_ipc_srv_listen_tcp_reuseport
+ * listeners on one port, among which the kernel balances connections.
+ *
+ * @param s Scheduler (NULL: kc_sched_default())
+ * @return 0, -EINVAL or -ENOMEM
+ */
+int kc_ipc_server_start(kc_ipc_server_ctx_t *ctx, kc_ipc_server_t *const *listeners, size_t n,
+                        kc_sched_t *s, kc_ipc_acceptor_t **out);
+
+/**
+ * Stop accepting and wait for the acceptor coroutines to leave
+ *
+ * Shuts the listeners down (close them afterwards); connections already
+ * accepted are served until their peers hang up. Callable from any thread.
+ */
+void kc_ipc_server_stop(kc_ipc_acceptor_t *a);
+
+/** Connections accepted so far. */
+unsigned long kc_ipc_server_accepted(const kc_ipc_acceptor_t *a);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,144 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/*
+ * Remote actor references
+ * -----------------------
+ *
+ * kc_ipc_actor_tell queues into a local unlimited outbox, so it never waits
+ * and works from any thread. One flusher coroutine per reference takes all
+ * the outbox holds (up to KCORO_IPC_ACTOR_BATCH) with kc_chan_recv_many and
+ * ships it as one kc_ipc_chan_send_many over the mux; messages told during
+ * that round trip make up the next batch. The server runs each batch frame
+ * through kc_chan_send_many into the exported mailbox.
+ *
+ * The flusher is the only writer of the counters; stats readers see each
+ * one atomically. Closing the outbox (kc_ipc_actor_ref_close, or the
+ * flusher itself after a failed batch) lets it drain and exit; it destroys
+ * the IPC handle and closes `done`, which the closer waits on.
+ */
+#define _POSIX_C_SOURCE 200809L /* clock_gettime */
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+#include <stdatomic.h>
+
+#include "../include/kcoro_ipc_actor.h"
+#include "../../../include/kcoro.h"
+#include "../../../include/kcoro_sched.h"
+#include "../../../include/kcoro_config.h"
+#include "../../../include/kcoro_port.h"
+
+struct kc_ipc_actor_ref {
+    kc_ipc_chan_t *ich;
+    size_t msg_size;
+    kc_chan_t *outbox;      /* KC_UNLIMITED: told, not yet shipped */
+    kc_chan_t *done;        /* closed by the flusher as it exits */
+    uint8_t *batch;         /* flusher's buffer, KCORO_IPC_ACTOR_BATCH messages */
+    uint64_t opened_ns;
+    _Atomic(unsigned long) told, delivered, dropped, batches;
+    _Atomic(uint64_t) rtt_last, rtt_sum, rtt_max;
+    _Atomic(int) error;
+};
+
+static uint64_t now_ns(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000ull + (uint64_t)t.tv_nsec;
+}
+
+static void ref_flusher(void *arg)
+{
+    kc_ipc_actor_ref_t *r = (kc_ipc_actor_ref_t*)arg;
+    size_t got = 0;
+    while (kc_chan_recv_many(r->outbox, r->batch, KCORO_IPC_ACTOR_BATCH, -1, &got) == 0) {
+        if (atomic_load_explicit(&r->error, memory_order_relaxed)) {
+            atomic_fetch_add_explicit(&r->dropped, got, memory_order_relaxed);
+            continue;
+        }
+        size_t sent = 0;
+        uint64_t t0 = now_ns();
+        int rc = kc_ipc_chan_send_many(r->ich, r->batch, got, -1, &sent);
+        uint64_t rtt = now_ns() - t0;
+        atomic_fetch_add_explicit(&r->batches, 1, memory_order_relaxed);
+        atomic_store_explicit(&r->rtt_last, rtt, memory_order_relaxed);
+        atomic_fetch_add_explicit(&r->rtt_sum, rtt, memory_order_relaxed);
+        if (rtt > atomic_load_explicit(&r->rtt_max, memory_order_relaxed))
+            atomic_store_explicit(&r->rtt_max, rtt, memory_order_relaxed);
+        atomic_fetch_add_explicit(&r->delivered, sent, memory_order_relaxed);
+        if (rc != 0) {
+            atomic_fetch_add_explicit(&r->dropped, got - sent, memory_order_relaxed);
+            atomic_store(&r->error, rc);
+            kc_chan_close(r->outbox); /* later tells see KC_EPIPE; the rest drains */
+        }
+    }
+    kc_ipc_chan_destroy(r->ich);
+    kc_chan_close(r->done);
+}
+
+int kc_ipc_actor_ref_open(kc_ipc_mux_t *mux, kc_sched_t *s, uint32_t chan_id, size_t msg_size,
+                          kc_ipc_actor_ref_t **out)
+{
+    if (!mux || !out || chan_id == 0 || msg_size == 0) return -EINVAL;
+    *out = NULL;
+    kc_ipc_actor_ref_t *r = calloc(1, sizeof(*r));
+    if (!r) return -ENOMEM;
+    r->msg_size = msg_size;
+    r->opened_ns = now_ns();
+    r->batch = malloc((size_t)KCORO_IPC_ACTOR_BATCH * msg_size);
+    int rc = r->batch ? 0 : -ENOMEM;
+    if (rc == 0) rc = kc_chan_make(&r->outbox, KC_UNLIMITED, msg_size, 0);
+    if (rc == 0) rc = kc_chan_make(&r->done, KC_UNLIMITED, sizeof(int), 0);
+    if (rc == 0) rc = kc_ipc_mux_chan_open(mux, chan_id, KC_BUFFERED, msg_size, &r->ich);
+    if (rc == 0) rc = kc_spawn_co(s ? s : kc_sched_default(), ref_flusher, r, 0, NULL);
+    if (rc != 0) {
+        kc_ipc_chan_destroy(r->ich);
+        if (r->done) kc_chan_destroy(r->done);
+        if (r->outbox) kc_chan_destroy(r->outbox);
+        free(r->batch);
+        free(r);
+        return rc;
+    }
+    *out = r;
+    return 0;
+}
+
+int kc_ipc_actor_tell(kc_ipc_actor_ref_t *r, const void *msg)
+{
+    if (!r || !msg) return -EINVAL;
+    int rc = kc_chan_send(r->outbox, msg, 0);
+    if (rc == 0) atomic_fetch_add_explicit(&r->told, 1, memory_order_relaxed);
+    return rc;
+}
+
+void kc_ipc_actor_ref_stats(const kc_ipc_actor_ref_t *cr, kc_ipc_actor_stats_t *out)
+{
+    if (!out) return;
+    *out = (kc_ipc_actor_stats_t){0};
+    if (!cr) return;
+    kc_ipc_actor_ref_t *r = (kc_ipc_actor_ref_t*)cr; /* atomic loads take non-const */
+    out->told = atomic_load_explicit(&r->told, memory_order_relaxed);
+    out->delivered = atomic_load_explicit(&r->delivered, memory_order_relaxed);
+    out->dropped = atomic_load_explicit(&r->dropped, memory_order_relaxed);
+    out->batches = atomic_load_explicit(&r->batches, memory_order_relaxed);
+    out->bytes = out->delivered * r->msg_size;
+    out->rtt_last_ns = atomic_load_explicit(&r->rtt_last, memory_order_relaxed);
+    out->rtt_max_ns = atomic_load_explicit(&r->rtt_max, memory_order_relaxed);
+    if (out->batches)
+        out->rtt_avg_ns = atomic_load_explicit(&r->rtt_sum, memory_order_relaxed) / out->batches;
+    out->elapsed_ns = now_ns() - r->opened_ns;
+    if (out->elapsed_ns)
+        out->msgs_per_sec = (double)out->delivered * 1e9 / (double)out->elapsed_ns;
+    out->error = atomic_load(&r->error);
+}
+
+void kc_ipc_actor_ref_close(kc_ipc_actor_ref_t *r)
+{
+    if (!r) return;
+    kc_chan_close(r->outbox);
+    int c;
+    while (kc_chan_recv_thread(r->done, &c, -1) != KC_EPIPE) {}
+    kc_chan_destroy(r->done);
+    kc_chan_destroy(r->outbox);
+    free(r->batch);
+    free(r);
+}
@@ -1,237 +1,1019 @@
 // SPDX-License-Identifier: BSD-3-Clause
 /*
  * Distributed Channel Operations over IPC
- * 
+ *
  * This implements Kotlin-like distributed channels using the kcoro IPC layer.
  * It bridges local channel operations (kc_chan_*) with remote IPC commands,
  * enabling cross-process channel communication.
+ *
+ * Two client modes share the encoding below:
+ * - Plain: each op sends its frame and blocks in kc_ipc_recv for the reply,
+ *   one op per connection at a time.
+ * - Multiplexed (kc_ipc_mux_t): callers are coroutines. Each takes a window
+ *   slot, tags its frame with a `req_id` naming the slot, queues it to the
+ *   writer coroutine and parks on the slot's reply channel. A demux coroutine
+ *   reads replies in whatever order the server completes them and hands each
+ *   to the slot its `req_id` names. Up to `window` ops share one round trip.
+ *
+ * A select clause on a mux handle (kc_ipc_select_add_recv) is a receive
+ * whose reply the demux drops into a local relay channel instead of waking
+ * a caller; the select waits on the relay like on any local channel and
+ * cancels the receive when another clause wins.
+ *
+ * Descriptor channels (element size 0) carry (region, offset, len) instead
+ * of bytes: a send exports the region over the connection first, so the
+ * server has it mapped before the request arrives, and a receive resolves
+ * the reply against the region the server exported just ahead of it.
  */
+#define _POSIX_C_SOURCE 200809L /* clock_gettime */
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <time.h>
+#include <stdatomic.h>
 #include <arpa/inet.h>
 
 #include "../include/kcoro_ipc_posix.h"
+#include "../include/kcoro_ipc_chan.h"
 #include "../../../include/kcoro.h"
+#include "../../../include/kcoro_core.h"
+#include "../../../include/kcoro_sched.h"
+#include "../../../include/kcoro_config.h"
+#include "../../../include/kcoro_port.h"
+#include "../../../include/kc_mem.h"
 #include "../../../proto/kcoro_proto.h"
 
+/* A handle's remote select receive (kc_ipc_select_add_recv). Shared by the
+ * handle and the receive it has out, if any. */
+typedef struct mux_relay {
+    kc_chan_t *inbox;       /* KC_BUFFERED, capacity 1: the element received */
+    kc_chan_t *back;        /* a token per receive the demux finished */
+    _Atomic(uint32_t) req;  /* req_id of the receive out, 0 when none */
+    _Atomic(int) shut;      /* inbox closed: nothing more will come */
+    _Atomic(int) refs;      /* handle + receive out */
+    size_t elem_sz;
+} mux_relay_t;
+
 /* Distributed channel handle */
 typedef struct kc_ipc_chan {
     kc_ipc_conn_t *conn;    /* IPC connection */
+    kc_ipc_mux_t *mux;      /* multiplexer owning conn, or NULL (plain) */
     uint32_t chan_id;       /* Remote channel ID */
     int kind;               /* Channel kind (local copy) */
     size_t elem_sz;         /* Element size (local copy) */
+    _Atomic(uint32_t) credits; /* sends the server pre-approved, no reply due */
+    mux_relay_t *relay;     /* first kc_ipc_select_add_recv creates it */
+    int fixed;              /* kc_ipc_conn_fixed: hot ops skip TLV */
 } kc_ipc_chan_t;
 
-/* Create a distributed channel */
-int kc_ipc_chan_make(kc_ipc_conn_t *conn, int kind, size_t elem_sz, 
-                     size_t capacity, kc_ipc_chan_t **out)
+static struct {
+    _Atomic(unsigned long) credited_sends, credit_stalls, credits_granted;
+} g_ipc_stats;
+
+/* A frame queued to the writer, or a reply handed to a waiting caller. */
+typedef struct mux_frame {
+    uint16_t cmd;
+    size_t len;
+    uint8_t data[];
+} mux_frame_t;
+
+typedef struct mux_slot {
+    _Atomic(uint32_t) pending; /* req_id awaiting its reply, 0 when idle */
+    uint32_t seq;              /* bumped per request; stale ids never match */
+    kc_chan_t *reply;          /* capacity 1: mux_frame_t*, NULL on hang-up */
+    mux_relay_t *relay;        /* set: the reply goes there, nobody waits */
+} mux_slot_t;
+
+struct kc_ipc_mux {
+    kc_ipc_conn_t *conn;
+    size_t window;
+    mux_slot_t *slot;
+    kc_chan_t *tx;          /* mux_frame_t* to the writer; closing stops it */
+    kc_chan_t *free_slots;  /* slot indices, one token per idle slot */
+    _Atomic(int) dead;      /* first fatal error; 0 while the link is up */
+    _Atomic(int) refs;      /* owner + writer + demux + calls in flight */
+    uint8_t *rxbuf;         /* demux's frame buffer */
+    size_t rxcap;           /* kc_ipc_conn_max_frame(conn) */
+    /* kc_ipc_mux_stats: calls awaiting a reply (slot or not yet), and the
+     * round trips of those answered */
+    _Atomic(unsigned) inflight;
+    _Atomic(unsigned long) calls;
+    _Atomic(uint64_t) rtt_last, rtt_sum, rtt_max;
+};
+
+static uint64_t now_ns(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000ull + (uint64_t)t.tv_nsec;
+}
+
+/* Called by the owner, writer, demux and each call as it leaves; the last
+ * one run owns the mux alone. No coroutine is left to drain the channels:
+ * the writer empties tx before exiting and every reply is consumed by the
+ * call waiting for it. */
+static void mux_put(kc_ipc_mux_t *m)
+{
+    if (atomic_fetch_sub(&m->refs, 1) != 1) return;
+    if (m->conn) kc_ipc_conn_close(m->conn);
+    for (size_t i = 0; m->slot && i < m->window; i++)
+        if (m->slot[i].reply) kc_chan_destroy(m->slot[i].reply);
+    if (m->tx) kc_chan_destroy(m->tx);
+    if (m->free_slots) kc_chan_destroy(m->free_slots);
+    if (m->rxbuf) kc_mem_uncharge(KC_MEM_IPC, m->rxcap);
+    free(m->rxbuf);
+    free(m->slot);
+    free(m);
+}
+
+/* Record the first error and wake the demux, which fails every waiter. */
+static void mux_fail(kc_ipc_mux_t *m, int err)
+{
+    int zero = 0;
+    (void)atomic_compare_exchange_strong(&m->dead, &zero, err);
+    (void)kc_ipc_conn_shutdown(m->conn);
+}
+
+/* The only coroutine writing to the socket: staged frames never interleave.
+ * Requests queued together go out in one flush. */
+static void mux_writer(void *arg)
+{
+    kc_ipc_mux_t *m = (kc_ipc_mux_t*)arg;
+    mux_frame_t *f = NULL;
+    while (kc_chan_recv(m->tx, &f, -1) == 0) { /* until closed and drained */
+        int staged = 0, rc = 0;
+        do {
+            if (f && !atomic_load(&m->dead)) {
+                if ((rc = kc_ipc_queue(m->conn, f->cmd, f->data, f->len)) == 0) staged++;
+                else mux_fail(m, rc);
+            }
+            free(f);
+            f = NULL;
+        } while (staged < KCORO_IPC_TXQ && kc_chan_try_recv(m->tx, &f) == 0);
+        if (!staged || atomic_load(&m->dead)) continue;
+        rc = kc_ipc_flush(m->conn);
+        while (rc == -EAGAIN) {
+            if ((rc = kc_ipc_await_flush(m->conn, -1)) != 0) break;
+            rc = kc_ipc_flush(m->conn);
+        }
+        if (rc != 0) mux_fail(m, rc);
+    }
+    mux_put(m);
+}
+
+static uint32_t reply_u32(const uint8_t *p, size_t n, uint16_t attr, uint32_t dflt)
+{
+    size_t off = 0, l;
+    uint16_t t;
+    const uint8_t *v;
+    while (kc_tlv_next(p, n, &off, &t, &v, &l)) {
+        if (t == attr && l == 4) {
+            uint32_t x;
+            memcpy(&x, v, 4);
+            return ntohl(x);
+        }
+    }
+    return dflt;
+}
+
+/* A reply's req_id, 0 when it has none. */
+static uint32_t reply_req_id(uint16_t cmd, const uint8_t *p, size_t n)
+{
+    if (!(cmd & KCORO_CMD_FIXED)) return reply_u32(p, n, KCORO_ATTR_REQ_ID, 0);
+    struct kcoro_fixed_hdr h;
+    if (n < sizeof(h)) return 0;
+    memcpy(&h, p, sizeof(h));
+    return ntohl(h.req_id);
+}
+
+static void relay_put(mux_relay_t *r)
+{
+    if (atomic_fetch_sub(&r->refs, 1) != 1) return;
+    kc_chan_destroy(r->inbox);
+    kc_chan_destroy(r->back);
+    free(r);
+}
+
+/* A relayed receive is over (pl NULL: the link is gone): its element goes
+ * to the inbox, which closes when no more can come, and the slot goes back.
+ * The caller claimed the slot's pending id. */
+static void relay_finish(kc_ipc_mux_t *m, size_t idx, const uint8_t *pl, size_t len)
+{
+    mux_slot_t *sl = &m->slot[idx];
+    mux_relay_t *r = sl->relay;
+    sl->relay = NULL;
+    int rc = pl ? (int)reply_u32(pl, len, KCORO_ATTR_RESULT, (uint32_t)-EPROTO) : -ECONNRESET;
+    const uint8_t *v = NULL;
+    size_t off = 0, l;
+    uint16_t t;
+    while (rc == 0 && !v && kc_tlv_next(pl, len, &off, &t, &v, &l))
+        if (t != KCORO_ATTR_ELEMENT || l != r->elem_sz) v = NULL;
+    if (v) (void)kc_chan_send(r->inbox, v, 0); /* fails only once the handle is gone */
+    else if (rc != KC_ECANCELED) { atomic_store(&r->shut, 1); kc_chan_close(r->inbox); }
+    atomic_store(&r->req, 0);
+    int tok = 1;
+    (void)kc_chan_send(r->back, &tok, 0); /* full: a token is already there */
+    atomic_fetch_sub_explicit(&m->inflight, 1, memory_order_relaxed);
+    int i = (int)idx;
+    (void)kc_chan_send(m->free_slots, &i, 0);
+    relay_put(r);
+}
+
+/* Reads replies and completes the slot each req_id names. */
+static void mux_demux(void *arg)
+{
+    kc_ipc_mux_t *m = (kc_ipc_mux_t*)arg;
+    int fd = kc_ipc_conn_fd(m->conn);
+    /* Seeded here rather than in create, which may run off a scheduler;
+     * calls made meanwhile simply wait for a token. */
+    for (size_t i = 0; i < m->window; i++) {
+        int idx = (int)i;
+        (void)kc_chan_send(m->free_slots, &idx, 0);
+    }
+    int rc = 0;
+    while (!atomic_load(&m->dead)) {
+        uint16_t cmd = 0; size_t len = 0;
+        const uint8_t *pl = m->rxbuf;
+        rc = kc_ipc_recv_nb_into(m->conn, &cmd, m->rxbuf, m->rxcap, &len);
+        if (rc == -EAGAIN) {
+            if ((rc = kc_await_readable(fd, -1)) != 0) break;
+            continue;
+        }
+        if (rc != 0) break;
+        uint32_t id = reply_req_id(cmd, pl, len);
+        size_t idx = (size_t)(id & 0xFFFFu);
+        if (idx >= 1 && idx <= m->window) {
+            mux_slot_t *sl = &m->slot[idx - 1];
+            uint32_t want = id;
+            if (atomic_compare_exchange_strong(&sl->pending, &want, 0)) {
+                if (sl->relay) {
+                    relay_finish(m, idx - 1, pl, len);
+                } else {
+                    /* NULL (out of memory) reads as a lost link to the caller. */
+                    mux_frame_t *f = malloc(sizeof(*f) + len);
+                    if (f) { f->cmd = cmd; f->len = len; if (len) memcpy(f->data, pl, len); }
+                    (void)kc_chan_send(sl->reply, &f, 0);
+                }
+            }
+        }
+        /* an unmatched reply is dropped */
+    }
+    mux_fail(m, rc ? rc : -ECONNRESET);
+    /* A call that saw the link up still has its req_id in pending: claim it
+     * and wake the caller with NULL. */
+    for (size_t i = 0; i < m->window; i++) {
+        if (atomic_exchange(&m->slot[i].pending, 0) == 0) continue;
+        if (m->slot[i].relay) { relay_finish(m, i, NULL, 0); continue; }
+        mux_frame_t *nil = NULL;
+        (void)kc_chan_send(m->slot[i].reply, &nil, 0);
+    }
+    mux_put(m);
+}
+
+int kc_ipc_mux_create(kc_ipc_conn_t *conn, kc_sched_t *s, size_t window, kc_ipc_mux_t **out)
 {
     if (!conn || !out) return -EINVAL;
-    if (elem_sz == 0 || elem_sz > 0xFFFFu) return -EMSGSIZE; /* TLV element length is uint16_t */
-    
+    if (window == 0) window = KCORO_IPC_WINDOW;
+    if (window > 0xFFFFu) return -EINVAL; /* slot number lives in req_id's low half */
+    if (!s) s = kc_sched_default();
+    if (!s) return -ENOMEM;
+    kc_ipc_mux_t *m = calloc(1, sizeof(*m));
+    if (!m) return -ENOMEM;
+    m->window = window;
+    m->slot = calloc(window, sizeof(*m->slot));
+    int rc = m->slot ? 0 : -ENOMEM;
+    for (size_t i = 0; rc == 0 && i < window; i++)
+        rc = kc_chan_make_mpmc(&m->slot[i].reply, sizeof(mux_frame_t*), 1);
+    if (rc == 0) rc = kc_chan_make_mpmc(&m->tx, sizeof(mux_frame_t*), window);
+    if (rc == 0) rc = kc_chan_make_mpmc(&m->free_slots, sizeof(int), window);
+    m->rxcap = kc_ipc_conn_max_frame(conn);
+    if (rc == 0) rc = kc_mem_charge(KC_MEM_IPC, m->rxcap);
+    if (rc == 0 && !(m->rxbuf = malloc(m->rxcap))) { kc_mem_uncharge(KC_MEM_IPC, m->rxcap); rc = -ENOMEM; }
+    if (rc == 0) rc = kc_ipc_conn_set_nb(conn, 1);
+    atomic_store(&m->refs, 1);
+    if (rc != 0) { mux_put(m); return rc; } /* conn stays with the caller */
+
+    /* From here on the mux owns conn, even if create fails. */
+    m->conn = conn;
+    atomic_store(&m->refs, 3);
+    if (kc_spawn_co(s, mux_writer, m, 0, NULL) != 0) {
+        atomic_store(&m->refs, 1);
+        mux_put(m);
+        return -ENOMEM;
+    }
+    if (kc_spawn_co(s, mux_demux, m, 0, NULL) != 0) {
+        /* The writer is running: stop it and let the last put free the mux. */
+        atomic_fetch_sub(&m->refs, 1);
+        kc_ipc_mux_destroy(m);
+        return -ENOMEM;
+    }
+    *out = m;
+    return 0;
+}
+
+void kc_ipc_mux_destroy(kc_ipc_mux_t *m)
+{
+    if (!m) return;
+    mux_fail(m, -ECONNRESET);
+    kc_chan_close(m->tx);
+    kc_chan_close(m->free_slots);
+    mux_put(m);
+}
+
+void kc_ipc_mux_stats(kc_ipc_mux_t *m, kc_ipc_mux_stats_t *out)
+{
+    if (!out) return;
+    *out = (kc_ipc_mux_stats_t){0};
+    if (!m) return;
+    out->window = m->window;
+    out->inflight = atomic_load_explicit(&m->inflight, memory_order_relaxed);
+    out->queued = kc_chan_len(m->tx);
+    out->calls = atomic_load_explicit(&m->calls, memory_order_relaxed);
+    out->rtt_last_ns = atomic_load_explicit(&m->rtt_last, memory_order_relaxed);
+    out->rtt_max_ns = atomic_load_explicit(&m->rtt_max, memory_order_relaxed);
+    if (out->calls)
+        out->rtt_avg_ns = atomic_load_explicit(&m->rtt_sum, memory_order_relaxed) / out->calls;
+    out->error = atomic_load(&m->dead);
+}
+
+/* Give up a slot whose request never got out: if the demux already claimed
+ * it, its NULL is on the way and must be taken. */
+static void mux_abandon(mux_slot_t *sl)
+{
+    if (atomic_exchange(&sl->pending, 0) == 0) {
+        mux_frame_t *f = NULL;
+        (void)kc_chan_recv(sl->reply, &f, -1);
+        free(f);
+    }
+}
+
+/* One round trip on the mux: the frame goes out tagged with REQ_ID, the
+ * reply comes back in *reply (caller frees). want_reply=0 skips the slot
+ * for commands the server does not answer. */
+static int mux_call(kc_ipc_mux_t *m, uint16_t cmd, const uint8_t *tlv, size_t len,
+                    int want_reply, mux_frame_t **reply)
+{
+    if (!kcoro_current()) return -EINVAL; /* callers park: coroutines only */
+    /* Caught here: the writer would have to fail the whole link. */
+    if (len + 8 > kc_ipc_conn_max_frame(m->conn)) return -EMSGSIZE;
+    atomic_fetch_add(&m->refs, 1);
+    int rc = 0, idx = -1;
+    mux_slot_t *sl = NULL;
+    uint32_t id = 0;
+    uint64_t t0 = 0;
+    if (want_reply) {
+        atomic_fetch_add_explicit(&m->inflight, 1, memory_order_relaxed);
+        t0 = now_ns();
+        if (kc_chan_recv(m->free_slots, &idx, -1) != 0) { rc = -ECONNRESET; goto out; }
+        sl = &m->slot[idx];
+        sl->seq = (sl->seq + 1) & 0x7FFFu;
+        id = (sl->seq << 16) | (uint32_t)(idx + 1);
+    }
+    mux_frame_t *f = malloc(sizeof(*f) + len + 8);
+    if (!f) { rc = -ENOMEM; goto out; }
+    f->cmd = cmd;
+    memcpy(f->data, tlv, len);
+    uint8_t *cur = f->data + len;
+    if (cmd & KCORO_CMD_FIXED) {
+        uint32_t be = htonl(id);
+        memcpy(f->data + offsetof(struct kcoro_fixed_hdr, req_id), &be, sizeof(be));
+    } else if (id) {
+        (void)kc_tlv_put_u32(&cur, cur + 8, KCORO_ATTR_REQ_ID, id);
+    }
+    f->len = (size_t)(cur - f->data);
+
+    if (sl) {
+        /* pending before the dead check: either the demux's final sweep sees
+         * this id, or this call sees the link down. */
+        atomic_store(&sl->pending, id);
+        if (atomic_load(&m->dead)) { free(f); mux_abandon(sl); rc = atomic_load(&m->dead); goto out; }
+    }
+    if (kc_chan_send(m->tx, &f, -1) != 0) {
+        free(f);
+        if (sl) mux_abandon(sl);
+        rc = -ECONNRESET;
+        goto out;
+    }
+    if (sl) {
+        mux_frame_t *r = NULL;
+        (void)kc_chan_recv(sl->reply, &r, -1); /* exactly one arrives */
+        if (!r) { rc = atomic_load(&m->dead); if (!rc) rc = -ENOMEM; goto out; }
+        *reply = r;
+        uint64_t rtt = now_ns() - t0;
+        atomic_fetch_add_explicit(&m->calls, 1, memory_order_relaxed);
+        atomic_store_explicit(&m->rtt_last, rtt, memory_order_relaxed);
+        atomic_fetch_add_explicit(&m->rtt_sum, rtt, memory_order_relaxed);
+        uint64_t mx = atomic_load_explicit(&m->rtt_max, memory_order_relaxed);
+        while (rtt > mx && !atomic_compare_exchange_weak_explicit(&m->rtt_max, &mx, rtt,
+                                                                  memory_order_relaxed, memory_order_relaxed)) {}
+    }
+out:
+    if (want_reply) atomic_fetch_sub_explicit(&m->inflight, 1, memory_order_relaxed);
+    if (idx >= 0) (void)kc_chan_send(m->free_slots, &idx, 0); /* closed after destroy */
+    mux_put(m);
+    return rc;
+}
+
+/* Send one request and fetch its reply, on the mux or in line (plain).
+ * *payload points into *owner, which the caller frees. */
+static int chan_call(kc_ipc_conn_t *conn, kc_ipc_mux_t *mux, uint16_t cmd,
+                     const uint8_t *tlv, size_t len, void **owner,
+                     const uint8_t **payload, size_t *plen)
+{
+    if (mux) {
+        mux_frame_t *r = NULL;
+        int rc = mux_call(mux, cmd, tlv, len, 1, &r);
+        if (rc != 0) return rc;
+        if (r->cmd != cmd) { free(r); return -EPROTO; }
+        *owner = r; *payload = r->data; *plen = r->len;
+        return 0;
+    }
+    int rc = kc_ipc_send(conn, cmd, tlv, len);
+    if (rc != 0) return rc;
+    uint16_t rcmd;
+    uint8_t *p = NULL;
+    rc = kc_ipc_recv(conn, &rcmd, &p, plen);
+    if (rc != 0) return rc;
+    if (rcmd != cmd) { free(p); return -EPROTO; }
+    *owner = p; *payload = p;
+    return 0;
+}
+
+/* chan_call, then: the reply's result, if any, lands in *result; *out_elem
+ * gets a copy of an ELEMENT attribute of elem_sz bytes. */
+static int chan_rpc(kc_ipc_conn_t *conn, kc_ipc_mux_t *mux, uint16_t cmd,
+                    const uint8_t *tlv, size_t len, uint16_t reply_attr, uint32_t *reply_val,
+                    void *out_elem, size_t elem_sz)
+{
+    void *owner = NULL;
+    const uint8_t *payload = NULL;
+    size_t plen = 0;
+    int rc = chan_call(conn, mux, cmd, tlv, len, &owner, &payload, &plen);
+    if (rc != 0) return rc;
+
+    *reply_val = reply_u32(payload, plen, reply_attr, *reply_val);
+    if (out_elem) {
+        size_t off = 0, l;
+        uint16_t t;
+        const uint8_t *v;
+        while (kc_tlv_next(payload, plen, &off, &t, &v, &l))
+            if (t == KCORO_ATTR_ELEMENT && l == elem_sz) memcpy(out_elem, v, elem_sz);
+    }
+    free(owner);
+    return 0;
+}
+
+/* A fixed-layout request header (req_id left 0 for the mux to fill in);
+ * dlen bytes of data follow it. */
+static void fixed_put(uint8_t *buf, uint32_t chan_id, uint32_t flags, size_t dlen, long timeout_ms,
+                      uint32_t count)
+{
+    struct kcoro_fixed_hdr h = { htonl(chan_id), 0, htonl(flags), htonl((uint32_t)dlen),
+                                 htonl((uint32_t)timeout_ms), htonl(count) };
+    memcpy(buf, &h, sizeof(h));
+}
+
+/* chan_call for a fixed-layout request: *h gets the reply's header in host
+ * order and *data its h->len bytes of data, inside *owner (caller frees). */
+static int chan_call_fixed(kc_ipc_chan_t *ich, uint16_t cmd, const uint8_t *req, size_t len,
+                           void **owner, struct kcoro_fixed_hdr *h, const uint8_t **data)
+{
+    const uint8_t *payload = NULL;
+    size_t plen = 0;
+    int rc = chan_call(ich->conn, ich->mux, (uint16_t)(cmd | KCORO_CMD_FIXED), req, len,
+                       owner, &payload, &plen);
+    if (rc != 0) return rc;
+    if (plen < sizeof(*h)) rc = -EPROTO;
+    if (rc == 0) {
+        memcpy(h, payload, sizeof(*h));
+        h->chan_id = ntohl(h->chan_id);
+        h->req_id = ntohl(h->req_id);
+        h->flags = ntohl(h->flags);
+        h->len = ntohl(h->len);
+        h->status = ntohl(h->status);
+        h->count = ntohl(h->count);
+        if (h->len != plen - sizeof(*h)) rc = -EPROTO;
+        *data = payload + sizeof(*h);
+    }
+    if (rc != 0) { free(*owner); *owner = NULL; }
+    return rc;
+}
+
+/* Fire-and-forget command (no reply from the server). */
+static int chan_post(kc_ipc_conn_t *conn, kc_ipc_mux_t *mux, uint16_t cmd,
+                     const uint8_t *tlv, size_t len)
+{
+    if (mux) return mux_call(mux, cmd, tlv, len, 0, NULL);
+    return kc_ipc_send(conn, cmd, tlv, len);
+}
+
+/* Room a send or recv frame needs besides the element: CHAN_ID, TIMEOUT,
+ * RESULT and REQ_ID TLVs plus the element's long-form header. */
+#define CHAN_FRAME_OVERHEAD 64
+
+/* The element must fit one frame; shared-memory connections allow more. */
+static size_t chan_max_elem(kc_ipc_conn_t *conn)
+{
+    return kc_ipc_conn_max_frame(conn) - CHAN_FRAME_OVERHEAD;
+}
+
+static int chan_make(kc_ipc_conn_t *conn, kc_ipc_mux_t *mux, int kind, size_t elem_sz,
+                     size_t capacity, kc_ipc_chan_t **out)
+{
+    if (elem_sz > chan_max_elem(conn)) return -EMSGSIZE;
+
     /* Send CHAN_MAKE command */
     uint8_t buf[64];
     uint8_t *cur = buf, *end = buf + sizeof(buf);
-    
+
     if (kc_tlv_put_u32(&cur, end, KCORO_ATTR_KIND, (uint32_t)kind) != 0) return -EMSGSIZE;
     if (kc_tlv_put_u32(&cur, end, KCORO_ATTR_ELEM_SIZE, (uint32_t)elem_sz) != 0) return -EMSGSIZE;
     if (kc_tlv_put_u32(&cur, end, KCORO_ATTR_CAPACITY, (uint32_t)capacity) != 0) return -EMSGSIZE;
-    
-    int rc = kc_ipc_send(conn, KCORO_CMD_CHAN_MAKE, buf, (size_t)(cur - buf));
-    if (rc != 0) return rc;
-    
-    /* Receive response with channel ID */
-    uint16_t cmd;
-    uint8_t *payload = NULL;
-    size_t len = 0;
-    rc = kc_ipc_recv(conn, &cmd, &payload, &len);
-    if (rc != 0) return rc;
-    
-    if (cmd != KCORO_CMD_CHAN_MAKE) {
-        free(payload);
-        return -EPROTO;
-    }
-    
-    /* Parse channel ID from response */
+
+    /* Reply carries the channel ID */
     uint32_t chan_id = 0;
-    size_t off = 0;
-    while (off + 4 <= len) {
-        uint16_t t, l;
-        memcpy(&t, payload + off, 2);
-        memcpy(&l, payload + off + 2, 2);
-        t = ntohs(t);
-        l = ntohs(l);
-        off += 4;
-        
-        if (off + l > len) break;
-        if (t == KCORO_ATTR_CHAN_ID && l == 4) {
-            uint32_t v;
-            memcpy(&v, payload + off, 4);
-            chan_id = ntohl(v);
-        }
-        off += l;
-    }
-    free(payload);
-    
+    int rc = chan_rpc(conn, mux, KCORO_CMD_CHAN_MAKE, buf, (size_t)(cur - buf),
+                      KCORO_ATTR_CHAN_ID, &chan_id, NULL, 0);
+    if (rc != 0) return rc;
     if (chan_id == 0) return -EPROTO;
-    
+
     /* Create local handle */
     kc_ipc_chan_t *ich = malloc(sizeof(*ich));
     if (!ich) return -ENOMEM;
-    
+
     ich->conn = conn;
+    ich->mux = mux;
     ich->chan_id = chan_id;
     ich->kind = kind;
     ich->elem_sz = elem_sz;
-    
+    atomic_init(&ich->credits, 0);
+    ich->relay = NULL;
+    ich->fixed = kc_ipc_conn_fixed(conn);
+
     *out = ich;
     return 0;
 }
 
-/* Open handle to an existing distributed channel (by ID) */
-int kc_ipc_chan_open(kc_ipc_conn_t *conn, uint32_t chan_id, int kind,
+static int chan_open(kc_ipc_conn_t *conn, kc_ipc_mux_t *mux, uint32_t chan_id, int kind,
                      size_t elem_sz, kc_ipc_chan_t **out)
 {
-    if (!conn || !out || elem_sz == 0 || chan_id == 0) return -EINVAL;
+    if (!out || chan_id == 0) return -EINVAL;
     kc_ipc_chan_t *ich = malloc(sizeof(*ich));
     if (!ich) return -ENOMEM;
     ich->conn = conn;
+    ich->mux = mux;
     ich->chan_id = chan_id;
     ich->kind = kind;
     ich->elem_sz = elem_sz;
+    atomic_init(&ich->credits, 0);
+    ich->relay = NULL;
+    ich->fixed = kc_ipc_conn_fixed(conn);
     *out = ich;
     return 0;
 }
 
+/* Create a distributed channel */
+int kc_ipc_chan_make(kc_ipc_conn_t *conn, int kind, size_t elem_sz,
+                     size_t capacity, kc_ipc_chan_t **out)
+{
+    if (!conn || !out) return -EINVAL;
+    return chan_make(conn, NULL, kind, elem_sz, capacity, out);
+}
+
+int kc_ipc_mux_chan_make(kc_ipc_mux_t *mux, int kind, size_t elem_sz,
+                         size_t capacity, kc_ipc_chan_t **out)
+{
+    if (!mux || !out) return -EINVAL;
+    return chan_make(mux->conn, mux, kind, elem_sz, capacity, out);
+}
+
+/* Open handle to an existing distributed channel (by ID) */
+int kc_ipc_chan_open(kc_ipc_conn_t *conn, uint32_t chan_id, int kind,
+                     size_t elem_sz, kc_ipc_chan_t **out)
+{
+    if (!conn) return -EINVAL;
+    return chan_open(conn, NULL, chan_id, kind, elem_sz, out);
+}
+
+int kc_ipc_mux_chan_open(kc_ipc_mux_t *mux, uint32_t chan_id, int kind,
+                         size_t elem_sz, kc_ipc_chan_t **out)
+{
+    if (!mux) return -EINVAL;
+    return chan_open(mux->conn, mux, chan_id, kind, elem_sz, out);
+}
+
 /* Send to distributed channel (Kotlin channel.send() equivalent) */
+/* Take one credit if any is left. */
+static int credit_take(kc_ipc_chan_t *ich)
+{
+    uint32_t c = atomic_load_explicit(&ich->credits, memory_order_relaxed);
+    while (c && !atomic_compare_exchange_weak(&ich->credits, &c, c - 1)) {}
+    return c != 0;
+}
+
+static void credit_add(kc_ipc_chan_t *ich, uint32_t grant)
+{
+    uint32_t c = atomic_load_explicit(&ich->credits, memory_order_relaxed), n;
+    do n = c + grant > KCORO_IPC_CREDITS ? KCORO_IPC_CREDITS : c + grant;
+    while (!atomic_compare_exchange_weak(&ich->credits, &c, n));
+    atomic_fetch_add_explicit(&g_ipc_stats.credits_granted, grant, memory_order_relaxed);
+}
+
 int kc_ipc_chan_send(kc_ipc_chan_t *ich, const void *msg, long timeout_ms)
 {
-    if (!ich || !msg) return -EINVAL;
-    if (ich->elem_sz > 0xFFFFu) return -EMSGSIZE;
-    
-    /* Prepare message with channel ID, element data, and timeout */
-    size_t total_len = 4 + 2 + 4 + 2 + ich->elem_sz + 4 + 2 + 4; // TLV overhead
+    if (!ich || !msg || ich->elem_sz == 0) return -EINVAL;
+    if (ich->elem_sz > chan_max_elem(ich->conn)) return -EMSGSIZE;
+
+    /* Prepare message with channel ID, element data, timeout and credit */
+    size_t total_len = ich->fixed ? sizeof(struct kcoro_fixed_hdr) + ich->elem_sz
+                                  : 8 + 8 + 8 + 8 + ich->elem_sz; // TLV overhead
     uint8_t *buf = malloc(total_len);
     if (!buf) return -ENOMEM;
-    
+
     uint8_t *cur = buf, *end = buf + total_len;
-    
-    /* Pack TLVs */
-    if (kc_tlv_put_u32(&cur, end, KCORO_ATTR_CHAN_ID, ich->chan_id) != 0 ||
-        kc_tlv_put_u32(&cur, end, KCORO_ATTR_TIMEOUT_MS, (uint32_t)timeout_ms) != 0) {
+    uint16_t cmd = KCORO_CMD_CHAN_SEND;
+
+    /* Only sends with no time limit use credits. A credited send is posted
+     * without a reply and may still wait on the server: the grant said there
+     * was room, but other producers can have taken it since. */
+    int credited = timeout_ms < 0 && credit_take(ich);
+    uint32_t want = (timeout_ms < 0 && !credited && ich->kind == KC_BUFFERED) ?
+                    KCORO_IPC_CREDITS : 0;
+
+    if (ich->fixed) {
+        /* Header and element: nothing to encode */
+        fixed_put(buf, ich->chan_id, credited ? KCORO_FIXED_CREDITED : 0, ich->elem_sz, timeout_ms, want);
+        memcpy(buf + sizeof(struct kcoro_fixed_hdr), msg, ich->elem_sz);
+        cur = end;
+    } else if (kc_tlv_put_u32(&cur, end, KCORO_ATTR_CHAN_ID, ich->chan_id) != 0 ||
+               kc_tlv_put_u32(&cur, end, KCORO_ATTR_TIMEOUT_MS, (uint32_t)timeout_ms) != 0 ||
+               (credited && kc_tlv_put_u32(&cur, end, KCORO_ATTR_CREDITED, 1) != 0) ||
+               (want && kc_tlv_put_u32(&cur, end, KCORO_ATTR_CREDIT, want) != 0) ||
+               /* Element data TLV (long form past 64 KiB) */
+               kc_tlv_put_bytes(&cur, end, KCORO_ATTR_ELEMENT, msg, ich->elem_sz) != 0) {
         free(buf);
         return -EMSGSIZE;
     }
-    
-    /* Add element data TLV manually */
-    if ((size_t)(end - cur) < 4 + ich->elem_sz) {
+
+    if (credited) {
+        if (ich->fixed) cmd |= KCORO_CMD_FIXED;
+        int rc = chan_post(ich->conn, ich->mux, cmd, buf, (size_t)(cur - buf));
         free(buf);
-        return -EMSGSIZE;
+        if (rc == 0) atomic_fetch_add_explicit(&g_ipc_stats.credited_sends, 1, memory_order_relaxed);
+        return rc;
     }
-    
-    uint16_t t = htons(KCORO_ATTR_ELEMENT);
-    uint16_t l = htons((uint16_t)ich->elem_sz);
-    memcpy(cur, &t, 2);
-    memcpy(cur + 2, &l, 2);
-    memcpy(cur + 4, msg, ich->elem_sz);
-    cur += 4 + ich->elem_sz;
-    
-    int rc = kc_ipc_send(ich->conn, KCORO_CMD_CHAN_SEND, buf, (size_t)(cur - buf));
-    free(buf);
-    if (rc != 0) return rc;
-    
-    /* Receive result */
-    uint16_t cmd;
-    uint8_t *payload = NULL;
-    size_t len = 0;
-    rc = kc_ipc_recv(ich->conn, &cmd, &payload, &len);
-    if (rc != 0) return rc;
-    
-    if (cmd != KCORO_CMD_CHAN_SEND) {
-        free(payload);
-        return -EPROTO;
-    }
-    
-    /* Parse result code */
-    int result = 0;
-    size_t off = 0;
-    while (off + 4 <= len) {
-        uint16_t t, l;
-        memcpy(&t, payload + off, 2);
-        memcpy(&l, payload + off + 2, 2);
-        t = ntohs(t);
-        l = ntohs(l);
-        off += 4;
-        
-        if (off + l > len) break;
-        if (t == KCORO_ATTR_RESULT && l == 4) {
-            uint32_t v;
-            memcpy(&v, payload + off, 4);
-            result = (int)ntohl(v);
-        }
-        off += l;
+    if (want) atomic_fetch_add_explicit(&g_ipc_stats.credit_stalls, 1, memory_order_relaxed);
+
+    /* Receive result code and whatever credit came with it */
+    void *owner = NULL;
+    uint32_t grant = 0;
+    int rc;
+    if (ich->fixed) {
+        struct kcoro_fixed_hdr h;
+        const uint8_t *data = NULL;
+        rc = chan_call_fixed(ich, cmd, buf, (size_t)(cur - buf), &owner, &h, &data);
+        free(buf);
+        if (rc != 0) return rc;
+        rc = (int)h.status;
+        grant = h.count;
+    } else {
+        const uint8_t *payload = NULL;
+        size_t plen = 0;
+        rc = chan_call(ich->conn, ich->mux, cmd, buf, (size_t)(cur - buf), &owner, &payload, &plen);
+        free(buf);
+        if (rc != 0) return rc;
+        rc = (int)reply_u32(payload, plen, KCORO_ATTR_RESULT, 0);
+        grant = reply_u32(payload, plen, KCORO_ATTR_CREDIT, 0);
     }
-    free(payload);
-    
-    return result;
+    free(owner);
+    if (rc == 0 && grant) credit_add(ich, grant);
+    return rc;
+}
+
+void kc_ipc_get_stats(kc_ipc_stats_t *out)
+{
+    if (!out) return;
+    out->credited_sends = atomic_load_explicit(&g_ipc_stats.credited_sends, memory_order_relaxed);
+    out->credit_stalls = atomic_load_explicit(&g_ipc_stats.credit_stalls, memory_order_relaxed);
+    out->credits_granted = atomic_load_explicit(&g_ipc_stats.credits_granted, memory_order_relaxed);
+    kc_ipc_get_lz4_stats(&out->lz4);
 }
 
 /* Receive from distributed channel (Kotlin channel.receive() equivalent) */
 int kc_ipc_chan_recv(kc_ipc_chan_t *ich, void *out, long timeout_ms)
 {
-    if (!ich || !out) return -EINVAL;
-    if (ich->elem_sz > 0xFFFFu) return -EMSGSIZE;
-    
+    if (!ich || !out || ich->elem_sz == 0) return -EINVAL;
+    if (ich->elem_sz > chan_max_elem(ich->conn)) return -EMSGSIZE;
+    /* What a select left behind comes first. */
+    if (ich->relay && kc_chan_try_recv(ich->relay->inbox, out) == 0) return 0;
+
     /* Send CHAN_RECV command */
     uint8_t buf[32];
     uint8_t *cur = buf, *end = buf + sizeof(buf);
-    
+
+    if (ich->fixed) {
+        void *owner = NULL;
+        struct kcoro_fixed_hdr h;
+        const uint8_t *data = NULL;
+        fixed_put(buf, ich->chan_id, 0, 0, timeout_ms, 0);
+        int rc = chan_call_fixed(ich, KCORO_CMD_CHAN_RECV, buf, sizeof(h), &owner, &h, &data);
+        if (rc != 0) return rc;
+        rc = (int)h.status;
+        if (rc == 0 && h.len != ich->elem_sz) rc = -EPROTO;
+        if (rc == 0) memcpy(out, data, ich->elem_sz);
+        free(owner);
+        return rc;
+    }
+
     if (kc_tlv_put_u32(&cur, end, KCORO_ATTR_CHAN_ID, ich->chan_id) != 0 ||
         kc_tlv_put_u32(&cur, end, KCORO_ATTR_TIMEOUT_MS, (uint32_t)timeout_ms) != 0) {
         return -EMSGSIZE;
     }
-    
-    int rc = kc_ipc_send(ich->conn, KCORO_CMD_CHAN_RECV, buf, (size_t)(cur - buf));
-    if (rc != 0) return rc;
-    
-    /* Receive response */
-    uint16_t cmd;
-    uint8_t *payload = NULL;
-    size_t len = 0;
-    rc = kc_ipc_recv(ich->conn, &cmd, &payload, &len);
+
+    /* Result and element data */
+    uint32_t result = (uint32_t)-EPROTO;
+    int rc = chan_rpc(ich->conn, ich->mux, KCORO_CMD_CHAN_RECV, buf, (size_t)(cur - buf),
+                      KCORO_ATTR_RESULT, &result, out, ich->elem_sz);
+    return rc != 0 ? rc : (int)result;
+}
+
+/* Elements one batch frame carries. */
+static size_t chan_batch_max(kc_ipc_chan_t *ich)
+{
+    size_t k = chan_max_elem(ich->conn) / ich->elem_sz;
+    return k > UINT32_MAX ? UINT32_MAX : k;
+}
+
+/* Send a run of elements, a frame's worth per CHAN_SEND_BATCH */
+int kc_ipc_chan_send_many(kc_ipc_chan_t *ich, const void *msgs, size_t n, long timeout_ms,
+                          size_t *sent)
+{
+    if (sent) *sent = 0;
+    if (!ich || (!msgs && n) || ich->elem_sz == 0) return -EINVAL;
+    size_t per = chan_batch_max(ich);
+    if (per == 0) return -EMSGSIZE;
+    if (n == 0) return 0;
+    size_t chunk = n < per ? n : per;
+    size_t cap = 32 + chunk * ich->elem_sz; /* TLVs, or the smaller fixed header */
+    uint8_t *buf = malloc(cap);
+    if (!buf) return -ENOMEM;
+
+    const uint8_t *src = msgs;
+    size_t done = 0;
+    int rc = 0;
+    while (done < n) {
+        size_t k = n - done < per ? n - done : per;
+        uint8_t *cur = buf, *end = buf + cap;
+        void *owner = NULL;
+        if (ich->fixed) {
+            struct kcoro_fixed_hdr h;
+            const uint8_t *data = NULL;
+            fixed_put(buf, ich->chan_id, 0, k * ich->elem_sz, timeout_ms, (uint32_t)k);
+            memcpy(buf + sizeof(h), src + done * ich->elem_sz, k * ich->elem_sz);
+            rc = chan_call_fixed(ich, KCORO_CMD_CHAN_SEND_BATCH, buf, sizeof(h) + k * ich->elem_sz,
+                                 &owner, &h, &data);
+            if (rc != 0) break;
+            free(owner);
+            rc = (int)h.status;
+            done += h.count < k ? h.count : k;
+            if (rc != 0) break;
+            continue;
+        }
+        if (kc_tlv_put_u32(&cur, end, KCORO_ATTR_CHAN_ID, ich->chan_id) != 0 ||
+            kc_tlv_put_u32(&cur, end, KCORO_ATTR_TIMEOUT_MS, (uint32_t)timeout_ms) != 0 ||
+            kc_tlv_put_u32(&cur, end, KCORO_ATTR_COUNT, (uint32_t)k) != 0 ||
+            kc_tlv_put_bytes(&cur, end, KCORO_ATTR_ELEMENTS, src + done * ich->elem_sz,
+                             k * ich->elem_sz) != 0) { rc = -EMSGSIZE; break; }
+        const uint8_t *payload = NULL;
+        size_t plen = 0;
+        rc = chan_call(ich->conn, ich->mux, KCORO_CMD_CHAN_SEND_BATCH, buf, (size_t)(cur - buf),
+                       &owner, &payload, &plen);
+        if (rc != 0) break;
+        rc = (int)reply_u32(payload, plen, KCORO_ATTR_RESULT, (uint32_t)-EPROTO);
+        uint32_t moved = reply_u32(payload, plen, KCORO_ATTR_COUNT, 0);
+        free(owner);
+        done += moved < k ? moved : k;
+        if (rc != 0) break;
+    }
+    free(buf);
+    if (sent) *sent = done;
+    return rc;
+}
+
+/* Receive up to max elements in one CHAN_RECV_BATCH */
+int kc_ipc_chan_recv_many(kc_ipc_chan_t *ich, void *out, size_t max, long timeout_ms,
+                          size_t *got)
+{
+    if (got) *got = 0;
+    if (!ich || !out || max == 0 || ich->elem_sz == 0) return -EINVAL;
+    size_t per = chan_batch_max(ich);
+    if (per == 0) return -EMSGSIZE;
+    if (max > per) max = per;
+    if (ich->relay && kc_chan_try_recv(ich->relay->inbox, out) == 0) {
+        if (got) *got = 1;
+        return 0;
+    }
+
+    uint8_t buf[32];
+    uint8_t *cur = buf, *end = buf + sizeof(buf);
+    if (ich->fixed) {
+        void *owner = NULL;
+        struct kcoro_fixed_hdr h;
+        const uint8_t *data = NULL;
+        fixed_put(buf, ich->chan_id, 0, 0, timeout_ms, (uint32_t)max);
+        int rc = chan_call_fixed(ich, KCORO_CMD_CHAN_RECV_BATCH, buf, sizeof(h), &owner, &h, &data);
+        if (rc != 0) return rc;
+        rc = (int)h.status;
+        if (rc == 0 && (h.count == 0 || h.count > max || h.len != h.count * ich->elem_sz)) rc = -EPROTO;
+        if (rc == 0) { memcpy(out, data, h.len); if (got) *got = h.count; }
+        free(owner);
+        return rc;
+    }
+    if (kc_tlv_put_u32(&cur, end, KCORO_ATTR_CHAN_ID, ich->chan_id) != 0 ||
+        kc_tlv_put_u32(&cur, end, KCORO_ATTR_TIMEOUT_MS, (uint32_t)timeout_ms) != 0 ||
+        kc_tlv_put_u32(&cur, end, KCORO_ATTR_COUNT, (uint32_t)max) != 0) return -EMSGSIZE;
+
+    void *owner = NULL;
+    const uint8_t *payload = NULL;
+    size_t plen = 0;
+    int rc = chan_call(ich->conn, ich->mux, KCORO_CMD_CHAN_RECV_BATCH, buf, (size_t)(cur - buf),
+                       &owner, &payload, &plen);
     if (rc != 0) return rc;
-    
-    if (cmd != KCORO_CMD_CHAN_RECV) {
-        free(payload);
-        return -EPROTO;
-    }
-    
-    /* Parse result and element data */
-    int result = -EPROTO;
-    size_t off = 0;
-    while (off + 4 <= len) {
-        uint16_t t, l;
-        memcpy(&t, payload + off, 2);
-        memcpy(&l, payload + off + 2, 2);
-        t = ntohs(t);
-        l = ntohs(l);
-        off += 4;
-        
-        if (off + l > len) break;
-        
-        if (t == KCORO_ATTR_RESULT && l == 4) {
-            uint32_t v;
-            memcpy(&v, payload + off, 4);
-            result = (int)ntohl(v);
-        } else if (t == KCORO_ATTR_ELEMENT && l == ich->elem_sz) {
-            memcpy(out, payload + off, ich->elem_sz);
+    rc = (int)reply_u32(payload, plen, KCORO_ATTR_RESULT, (uint32_t)-EPROTO);
+    size_t n = reply_u32(payload, plen, KCORO_ATTR_COUNT, 0);
+    if (rc == 0 && (n == 0 || n > max)) rc = -EPROTO;
+    if (rc == 0) {
+        size_t off = 0, l = 0;
+        uint16_t t;
+        const uint8_t *v = NULL;
+        while (kc_tlv_next(payload, plen, &off, &t, &v, &l) && t != KCORO_ATTR_ELEMENTS) v = NULL;
+        if (!v || l != n * ich->elem_sz) rc = -EPROTO;
+        else { memcpy(out, v, l); if (got) *got = n; }
+    }
+    free(owner);
+    return rc;
+}
+
+/* Ask the server to drop the parked receive id (it replies KC_ECANCELED),
+ * should it still be parked. */
+static void relay_cancel(kc_ipc_chan_t *ich, uint32_t id)
+{
+    uint8_t buf[16];
+    uint8_t *cur = buf;
+    if (kc_tlv_put_u32(&cur, buf + sizeof(buf), KCORO_ATTR_REQ_ID, id) == 0)
+        (void)mux_call(ich->mux, KCORO_CMD_CHAN_CANCEL, buf, (size_t)(cur - buf), 0, NULL);
+}
+
+/* Select arm: unless the inbox has something to give, put one receive out.
+ * Runs in the waiting coroutine before its clauses register. */
+static int relay_arm(void *arg)
+{
+    kc_ipc_chan_t *ich = (kc_ipc_chan_t*)arg;
+    mux_relay_t *r = ich->relay;
+    kc_ipc_mux_t *m = ich->mux;
+    int tok;
+    /* A receive whose cancel is on its way: its reply may still bring an
+     * element, and then the inbox needs the room. */
+    while (atomic_load(&r->req)) (void)kc_chan_recv(r->back, &tok, -1);
+    if (atomic_load(&r->shut) || kc_chan_len(r->inbox) > 0) return 0;
+    int rc = atomic_load(&m->dead);
+    if (rc) return rc;
+
+    uint8_t buf[32];
+    uint8_t *cur = buf, *end = buf + sizeof(buf);
+    if (kc_tlv_put_u32(&cur, end, KCORO_ATTR_CHAN_ID, ich->chan_id) != 0 ||
+        kc_tlv_put_u32(&cur, end, KCORO_ATTR_TIMEOUT_MS, (uint32_t)-1) != 0) return -EMSGSIZE;
+    size_t len = (size_t)(cur - buf);
+    mux_frame_t *f = malloc(sizeof(*f) + len + 8);
+    if (!f) return -ENOMEM;
+    atomic_fetch_add(&m->refs, 1);
+    int idx = -1;
+    if (kc_chan_recv(m->free_slots, &idx, -1) != 0) { free(f); mux_put(m); return -ECONNRESET; }
+    mux_slot_t *sl = &m->slot[idx];
+    sl->seq = (sl->seq + 1) & 0x7FFFu;
+    uint32_t id = (sl->seq << 16) | (uint32_t)(idx + 1);
+    f->cmd = KCORO_CMD_CHAN_RECV;
+    memcpy(f->data, buf, len);
+    cur = f->data + len;
+    (void)kc_tlv_put_u32(&cur, cur + 8, KCORO_ATTR_REQ_ID, id);
+    f->len = (size_t)(cur - f->data);
+
+    /* From here the demux owns the slot once it claims id; relay_finish
+     * gives everything back. */
+    atomic_fetch_add(&r->refs, 1);
+    atomic_fetch_add_explicit(&m->inflight, 1, memory_order_relaxed);
+    atomic_store(&r->req, id);
+    sl->relay = r;
+    atomic_store(&sl->pending, id);
+    rc = atomic_load(&m->dead);
+    if (rc == 0 && kc_chan_send(m->tx, &f, -1) != 0) rc = -ECONNRESET;
+    if (rc != 0) {
+        free(f);
+        /* Unless the demux's sweep got to it first */
+        if (atomic_exchange(&sl->pending, 0) != 0) relay_finish(m, (size_t)idx, NULL, 0);
+    }
+    mux_put(m);
+    return rc;
+}
+
+/* Select done: a receive still out after the wait went elsewhere is cancelled. */
+static void relay_done(void *arg, int won)
+{
+    kc_ipc_chan_t *ich = (kc_ipc_chan_t*)arg;
+    uint32_t id = atomic_load(&ich->relay->req);
+    if (!won && id) relay_cancel(ich, id);
+}
+
+static const struct kc_select_hooks relay_hooks = { relay_arm, relay_done };
+
+int kc_ipc_select_add_recv(kc_select_t *sel, kc_ipc_chan_t *ich, void *out)
+{
+    if (!sel || !ich || !out) return -EINVAL;
+    if (!ich->mux || ich->elem_sz == 0) return -ENOTSUP;
+    if (!ich->relay) {
+        mux_relay_t *r = calloc(1, sizeof(*r));
+        if (!r) return -ENOMEM;
+        r->elem_sz = ich->elem_sz;
+        atomic_init(&r->refs, 1);
+        int rc = kc_chan_make(&r->inbox, KC_BUFFERED, ich->elem_sz, 1);
+        if (rc == 0) rc = kc_chan_make(&r->back, KC_BUFFERED, sizeof(int), 1);
+        if (rc != 0) {
+            if (r->inbox) kc_chan_destroy(r->inbox);
+            free(r);
+            return rc;
         }
-        off += l;
+        ich->relay = r;
     }
-    free(payload);
-    
-    return result;
+    return kc_select_add_recv_hooks(sel, ich->relay->inbox, out, &relay_hooks, ich);
+}
+
+/* Send a region descriptor to a descriptor channel */
+int kc_ipc_chan_send_desc(kc_ipc_chan_t *ich, kc_region_t *reg, size_t off, size_t len,
+                          long timeout_ms)
+{
+    if (!ich || !reg || ich->elem_sz != 0 || len == 0) return -EINVAL;
+    size_t rlen = 0;
+    (void)kc_region_addr(reg, &rlen);
+    if (off > rlen || len > rlen - off) return -EINVAL;
+    unsigned long id = 0;
+    (void)kc_region_export_id(reg, &id);
+    /* Ahead of the request: the server maps it before it reads the frame. */
+    int rc = kc_ipc_region_export(ich->conn, reg);
+    if (rc != 0) return rc;
+
+    uint8_t buf[64];
+    uint8_t *cur = buf, *end = buf + sizeof(buf);
+    if (kc_tlv_put_u32(&cur, end, KCORO_ATTR_CHAN_ID, ich->chan_id) != 0 ||
+        kc_tlv_put_u32(&cur, end, KCORO_ATTR_TIMEOUT_MS, (uint32_t)timeout_ms) != 0 ||
+        kc_tlv_put_u64(&cur, end, KCORO_ATTR_REGION_ID, id) != 0 ||
+        kc_tlv_put_u64(&cur, end, KCORO_ATTR_REGION_OFF, off) != 0 ||
+        kc_tlv_put_u64(&cur, end, KCORO_ATTR_REGION_LEN, len) != 0) {
+        return -EMSGSIZE;
+    }
+    uint32_t result = 0;
+    rc = chan_rpc(ich->conn, ich->mux, KCORO_CMD_CHAN_SEND_DESC, buf, (size_t)(cur - buf),
+                  KCORO_ATTR_RESULT, &result, NULL, 0);
+    return rc != 0 ? rc : (int)result;
+}
+
+/* Receive a region descriptor: *ptr lands in this process's mapping */
+int kc_ipc_chan_recv_desc(kc_ipc_chan_t *ich, void **ptr, size_t *len, long timeout_ms)
+{
+    if (!ich || !ptr || !len || ich->elem_sz != 0) return -EINVAL;
+    uint8_t buf[32];
+    uint8_t *cur = buf, *end = buf + sizeof(buf);
+    if (kc_tlv_put_u32(&cur, end, KCORO_ATTR_CHAN_ID, ich->chan_id) != 0 ||
+        kc_tlv_put_u32(&cur, end, KCORO_ATTR_TIMEOUT_MS, (uint32_t)timeout_ms) != 0) {
+        return -EMSGSIZE;
+    }
+    void *owner = NULL;
+    const uint8_t *p = NULL;
+    size_t plen = 0;
+    int rc = chan_call(ich->conn, ich->mux, KCORO_CMD_CHAN_RECV_DESC, buf, (size_t)(cur - buf),
+                       &owner, &p, &plen);
+    if (rc != 0) return rc;
+    rc = (int)reply_u32(p, plen, KCORO_ATTR_RESULT, (uint32_t)-EPROTO);
+    uint64_t rid = 0, roff = 0, rl = 0;
+    size_t o = 0, l;
+    uint16_t t;
+    const uint8_t *v;
+    while (kc_tlv_next(p, plen, &o, &t, &v, &l)) {
+        if (l != 8) continue;
+        if (t == KCORO_ATTR_REGION_ID) rid = kc_tlv_val_u64(v);
+        else if (t == KCORO_ATTR_REGION_OFF) roff = kc_tlv_val_u64(v);
+        else if (t == KCORO_ATTR_REGION_LEN) rl = kc_tlv_val_u64(v);
+    }
+    free(owner);
+    if (rc != 0) return rc;
+
+    kc_region_t *reg = NULL;
+    if (kc_ipc_region_lookup(ich->conn, rid, &reg) != 0) return -EPROTO;
+    size_t mlen = 0;
+    uint8_t *base = (uint8_t*)kc_region_addr(reg, &mlen);
+    if (roff > mlen || rl > mlen - roff) return -EPROTO;
+    *ptr = base + roff;
+    *len = (size_t)rl;
+    return 0;
 }
 
 /* Non-blocking send (Kotlin channel.trySend() equivalent) */
@@ -250,14 +1032,21 @@ int kc_ipc_chan_try_recv(kc_ipc_chan_t *ich, void *out)
 int kc_ipc_chan_close(kc_ipc_chan_t *ich)
 {
     if (!ich) return -EINVAL;
-    
+
     uint8_t buf[16];
     uint8_t *cur = buf, *end = buf + sizeof(buf);
-    
+
     if (kc_tlv_put_u32(&cur, end, KCORO_ATTR_CHAN_ID, ich->chan_id) != 0) {
         return -EMSGSIZE;
     }
-    
+
+    if (ich->mux) {
+        /* The mux can wait for the acknowledgment without stalling others. */
+        uint32_t result = 0;
+        int rc = chan_rpc(ich->conn, ich->mux, KCORO_CMD_CHAN_CLOSE, buf, (size_t)(cur - buf),
+                          KCORO_ATTR_RESULT, &result, NULL, 0);
+        return rc != 0 ? rc : (int)result;
+    }
     return kc_ipc_send(ich->conn, KCORO_CMD_CHAN_CLOSE, buf, (size_t)(cur - buf));
 }
 
@@ -265,15 +1054,23 @@ int kc_ipc_chan_close(kc_ipc_chan_t *ich)
 void kc_ipc_chan_destroy(kc_ipc_chan_t *ich)
 {
     if (!ich) return;
-    
+
     /* Send destroy command (best effort) */
     uint8_t buf[16];
     uint8_t *cur = buf, *end = buf + sizeof(buf);
-    
+
     if (kc_tlv_put_u32(&cur, end, KCORO_ATTR_CHAN_ID, ich->chan_id) == 0) {
-        kc_ipc_send(ich->conn, KCORO_CMD_CHAN_DESTROY, buf, (size_t)(cur - buf));
+        (void)chan_post(ich->conn, ich->mux, KCORO_CMD_CHAN_DESTROY, buf, (size_t)(cur - buf));
+    }
+    if (ich->relay) {
+        /* A receive still out finds the inbox closed when it ends. */
+        uint32_t id = atomic_load(&ich->relay->req);
+        if (id) relay_cancel(ich, id);
+        atomic_store(&ich->relay->shut, 1);
+        kc_chan_close(ich->relay->inbox);
+        relay_put(ich->relay);
     }
-    
+
     free(ich);
 }
 
@@ -0,0 +1,149 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/*
+ * LZ4 block codec (TCP frame batches)
+ * -----------------------------------
+ *
+ * Block format
+ * - A block is a run of sequences. Each starts with a token: literal count
+ *   in the high nibble, match length minus 4 in the low one; 15 in either
+ *   means more length follows in bytes of 255 plus a final smaller one.
+ *   Then come the literals, then a 2-byte little-endian offset back into
+ *   the output and the match length continuation. The last sequence has
+ *   literals only.
+ * - End rules: the last 5 bytes are always literals and no match starts in
+ *   the last 12, so decoders may copy in wide steps; this encoder keeps
+ *   both.
+ *
+ * Compressor
+ * - Greedy: hash the 4 bytes at each position, try the one earlier position
+ *   the table remembers, extend a hit both ways. Positions between hits go
+ *   into the table only at the match end. Misses advance faster the longer
+ *   the literal run, so incompressible input costs little.
+ */
+#include <string.h>
+#include <errno.h>
+
+#include "kcoro_ipc_lz4_internal.h"
+
+#define LZ4_MINMATCH    4
+#define LZ4_LASTLITERALS 5
+#define LZ4_MFLIMIT     12
+#define LZ4_MAX_OFFSET  65535u
+
+static inline uint32_t lz4_read32(const uint8_t *p)
+{
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+static inline uint32_t lz4_hash(uint32_t v)
+{
+    return (v * 2654435761u) >> (32 - KC_LZ4_HASH_BITS);
+}
+
+/* Length continuation bytes for len (already minus 15); NULL past end. */
+static uint8_t *lz4_put_len(uint8_t *op, const uint8_t *end, size_t len)
+{
+    for (; len >= 255; len -= 255) {
+        if (op >= end) return NULL;
+        *op++ = 255;
+    }
+    if (op >= end) return NULL;
+    *op++ = (uint8_t)len;
+    return op;
+}
+
+/* One sequence: lit literals, then a match of ml bytes at off (ml 0: none). */
+static uint8_t *lz4_put_seq(uint8_t *op, const uint8_t *end, const uint8_t *lit, size_t nlit,
+                            size_t off, size_t ml)
+{
+    if (op >= end) return NULL;
+    uint8_t *token = op++;
+    size_t mcode = ml ? ml - LZ4_MINMATCH : 0;
+    *token = (uint8_t)(((nlit >= 15 ? 15 : nlit) << 4) | (mcode >= 15 ? 15 : mcode));
+    if (nlit >= 15 && !(op = lz4_put_len(op, end, nlit - 15))) return NULL;
+    if ((size_t)(end - op) < nlit) return NULL;
+    memcpy(op, lit, nlit);
+    op += nlit;
+    if (!ml) return op;
+    if (end - op < 2) return NULL;
+    *op++ = (uint8_t)off;
+    *op++ = (uint8_t)(off >> 8);
+    if (mcode >= 15 && !(op = lz4_put_len(op, end, mcode - 15))) return NULL;
+    return op;
+}
+
+size_t kc_lz4_compress(const uint8_t *src, size_t n, uint8_t *dst, size_t cap, uint32_t *table)
+{
+    uint8_t *op = dst;
+    const uint8_t *end = dst + cap;
+    size_t anchor = 0;
+    if (n >= LZ4_MFLIMIT + 1) {
+        memset(table, 0, KC_LZ4_TABLE_BYTES);
+        size_t ip = 1, limit = n - LZ4_MFLIMIT;
+        while (ip < limit) {
+            uint32_t v = lz4_read32(src + ip);
+            uint32_t h = lz4_hash(v);
+            size_t cand = table[h];
+            table[h] = (uint32_t)ip;
+            if (ip - cand > LZ4_MAX_OFFSET || lz4_read32(src + cand) != v) {
+                ip += 1 + ((ip - anchor) >> 6);
+                continue;
+            }
+            size_t ml = LZ4_MINMATCH, maxml = n - LZ4_LASTLITERALS - ip;
+            while (ml < maxml && src[cand + ml] == src[ip + ml]) ml++;
+            while (ip > anchor && cand > 0 && src[ip - 1] == src[cand - 1]) { ip--; cand--; ml++; }
+            op = lz4_put_seq(op, end, src + anchor, ip - anchor, ip - cand, ml);
+            if (!op) return 0;
+            ip += ml;
+            anchor = ip;
+            if (ip < limit) table[lz4_hash(lz4_read32(src + ip - 2))] = (uint32_t)(ip - 2);
+        }
+    }
+    op = lz4_put_seq(op, end, src + anchor, n - anchor, 0, 0);
+    return op ? (size_t)(op - dst) : 0;
+}
+
+/* Length continuation; SIZE_MAX when the block ends inside it. */
+static size_t lz4_get_len(const uint8_t **ip, const uint8_t *iend, size_t len)
+{
+    uint8_t b;
+    do {
+        if (*ip >= iend) return SIZE_MAX;
+        b = *(*ip)++;
+        len += b;
+    } while (b == 255);
+    return len;
+}
+
+int kc_lz4_decompress(const uint8_t *src, size_t n, uint8_t *dst, size_t cap, size_t *out)
+{
+    const uint8_t *ip = src, *iend = src + n;
+    uint8_t *op = dst;
+    for (;;) {
+        if (ip >= iend) return -EPROTO;
+        uint8_t token = *ip++;
+        size_t nlit = token >> 4;
+        if (nlit == 15 && (nlit = lz4_get_len(&ip, iend, nlit)) == SIZE_MAX) return -EPROTO;
+        if (nlit > (size_t)(iend - ip) || nlit > cap - (size_t)(op - dst)) return -EPROTO;
+        memcpy(op, ip, nlit);
+        op += nlit;
+        ip += nlit;
+        if (ip == iend) break; /* the last sequence has no match */
+        if (iend - ip < 2) return -EPROTO;
+        size_t off = (size_t)ip[0] | ((size_t)ip[1] << 8);
+        ip += 2;
+        if (off == 0 || off > (size_t)(op - dst)) return -EPROTO;
+        size_t ml = token & 15;
+        if (ml == 15 && (ml = lz4_get_len(&ip, iend, ml)) == SIZE_MAX) return -EPROTO;
+        ml += LZ4_MINMATCH;
+        if (ml > cap - (size_t)(op - dst)) return -EPROTO;
+        const uint8_t *m = op - off;
+        if (off >= ml) memcpy(op, m, ml);
+        else for (size_t i = 0; i < ml; i++) op[i] = m[i]; /* overlapping: repeats */
+        op += ml;
+    }
+    *out = (size_t)(op - dst);
+    return 0;
+}
@@ -0,0 +1,24 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+/* LZ4 block codec for compressed TCP frame batches (internal).
+ *
+ * Plain LZ4 block format (no frame header, no checksum): what the standard
+ * LZ4_decompress_safe reads and LZ4_compress_default writes, so either end
+ * may be swapped for liblz4. The compressor is the greedy single-probe
+ * variant; the decompressor bounds-checks every length and offset, so a
+ * corrupt block yields -EPROTO rather than an overrun. */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Hash table the compressor works in; callers keep one per connection. */
+#define KC_LZ4_HASH_BITS 12
+#define KC_LZ4_TABLE_BYTES ((size_t)sizeof(uint32_t) << KC_LZ4_HASH_BITS)
+
+/* Compress n bytes of src into dst. Returns the block size, 0 when it does
+ * not fit in cap. n must be below 2^31. */
+size_t kc_lz4_compress(const uint8_t *src, size_t n, uint8_t *dst, size_t cap, uint32_t *table);
+
+/* Decode a block into dst. 0 with *out = bytes written, or -EPROTO when the
+ * block is malformed or would exceed cap. */
+int kc_lz4_decompress(const uint8_t *src, size_t n, uint8_t *dst, size_t cap, size_t *out);
@@ -0,0 +1,87 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/*
+ * Client connection pool
+ * ----------------------
+ *
+ * An array of muxes, one per pooled connection. Opens shard by channel ID;
+ * makes go to the mux with the fewest calls in flight, read from the mux's
+ * own counter. Each make starts its scan one mux further on, so ties (an
+ * idle pool) go round robin.
+ */
+#include <stdlib.h>
+#include <errno.h>
+#include <stdatomic.h>
+
+#include "../include/kcoro_ipc_pool.h"
+
+struct kc_ipc_pool {
+    size_t n;
+    _Atomic(size_t) next;   /* where the next make starts its scan */
+    kc_ipc_mux_t *mux[];
+};
+
+int kc_ipc_pool_create(kc_ipc_conn_t **conns, size_t n, kc_sched_t *s, size_t window,
+                       kc_ipc_pool_t **out)
+{
+    if (!conns || n == 0 || !out) return -EINVAL;
+    *out = NULL;
+    kc_ipc_pool_t *p = calloc(1, sizeof(*p) + n * sizeof(p->mux[0]));
+    if (!p) return -ENOMEM;
+    for (size_t i = 0; i < n; i++) {
+        int rc = kc_ipc_mux_create(conns[i], s, window, &p->mux[i]);
+        if (rc != 0) {
+            while (i-- > 0) kc_ipc_mux_destroy(p->mux[i]);
+            free(p);
+            return rc;
+        }
+        p->n = i + 1;
+    }
+    *out = p;
+    return 0;
+}
+
+void kc_ipc_pool_destroy(kc_ipc_pool_t *p)
+{
+    if (!p) return;
+    for (size_t i = 0; i < p->n; i++) kc_ipc_mux_destroy(p->mux[i]);
+    free(p);
+}
+
+size_t kc_ipc_pool_size(const kc_ipc_pool_t *p)
+{
+    return p ? p->n : 0;
+}
+
+kc_ipc_mux_t *kc_ipc_pool_mux(kc_ipc_pool_t *p, uint32_t chan_id)
+{
+    return p ? p->mux[chan_id % p->n] : NULL;
+}
+
+int kc_ipc_pool_chan_make(kc_ipc_pool_t *p, int kind, size_t elem_sz, size_t capacity,
+                          kc_ipc_chan_t **out)
+{
+    if (!p) return -EINVAL;
+    size_t start = atomic_fetch_add_explicit(&p->next, 1, memory_order_relaxed);
+    size_t best = start % p->n;
+    unsigned best_load = ~0u;
+    for (size_t k = 0; k < p->n; k++) {
+        size_t i = (start + k) % p->n;
+        kc_ipc_mux_stats_t st;
+        kc_ipc_mux_stats(p->mux[i], &st);
+        if (st.error) continue; /* a dead link fails every call */
+        if (st.inflight < best_load) { best = i; best_load = st.inflight; }
+    }
+    return kc_ipc_mux_chan_make(p->mux[best], kind, elem_sz, capacity, out);
+}
+
+int kc_ipc_pool_chan_open(kc_ipc_pool_t *p, uint32_t chan_id, int kind, size_t elem_sz,
+                          kc_ipc_chan_t **out)
+{
+    if (!p) return -EINVAL;
+    return kc_ipc_mux_chan_open(kc_ipc_pool_mux(p, chan_id), chan_id, kind, elem_sz, out);
+}
+
+void kc_ipc_pool_stats(kc_ipc_pool_t *p, size_t i, kc_ipc_mux_stats_t *out)
+{
+    kc_ipc_mux_stats(p && i < p->n ? p->mux[i] : NULL, out);
+}
@@ -11,16 +11,76 @@
  * Framing
  * - Wire header carries cmd and payload length; the payload is TLV‑encoded.
  *   Request/response correlation uses a `req_id` TLV that servers echo.
+ *   A HELLO may offer KCORO_CAP_FIXED; when both sides did, the hot channel
+ *   commands use the fixed header of kcoro_proto.h (kc_ipc_conn_fixed).
+ *
+ * Records
+ * - Each frame (header + payload) is one SOCK_SEQPACKET record, written with
+ *   a single gather sendmsg and read with a single recvmsg. Records are
+ *   atomic, so a non‑blocking send either queues the whole frame in the
+ *   kernel or fails with EAGAIN, and a receive never sees half a frame.
  *
  * Non‑blocking model
- * - This implementation supports staged non‑blocking send/recv with internal
- *   buffers. The coroutine‑native harness will drive these with yield/park.
+ * - kc_ipc_queue/kc_ipc_send_nb stage up to KCORO_IPC_TXQ frames in
+ *   per‑connection buffers that are reused (grown, never shrunk); kc_ipc_flush
+ *   hands every staged frame to the kernel in one sendmmsg on Linux.
+ * - Receives land in caller storage (kc_ipc_recv_into/_nb_into) or in the
+ *   connection's receive buffer, from which kc_ipc_recv/_nb copy out the
+ *   payload the caller frees. Coroutine callers drive both with
+ *   kc_await_readable/writable.
+ *
+ * Shared memory
+ * - A client HELLO may offer KCORO_CAP_SHM. A server that takes it creates a
+ *   pair of frame rings (kcoro_ipc_shm.c) and passes the mapping, plus one
+ *   end of a socketpair, back with its HELLO via SCM_RIGHTS. From then on
+ *   frames travel through the rings and the socket carries only one‑byte
+ *   doorbells: a side rings its peer only when the peer armed its wait flag,
+ *   so a busy stream makes no syscalls. The socketpair carries "room freed"
+ *   doorbells for a producer facing a full ring (kc_ipc_await_flush).
+ * - Ring frames may be much larger than socket records (see
+ *   kc_ipc_conn_max_frame); receive buffers are sized per connection.
+ *
+ * Shared regions
+ * - kc_ipc_region_export announces a memfd region with KCORO_CMD_REGION and
+ *   its descriptor as SCM_RIGHTS, once per connection. On the socket both
+ *   travel in one record. With rings the record goes on the socket first and
+ *   a copy of the frame follows through the ring, so the receiver meets it
+ *   in order and collects the descriptor from the socket right then.
+ * - Receivers consume REGION frames themselves: the region is mapped
+ *   (kc_region_import) before any later frame is returned, and stays mapped
+ *   until the connection closes and no descriptor queued in a channel still
+ *   points into it. kc_ipc_region_lookup finds it by the sender's ID.
+ *
+ * TCP
+ * - kc_ipc_srv_listen_tcp/kc_ipc_connect_tcp give the same connection over
+ *   a TCP stream, with TCP_NODELAY set. The frames are the same; the stream
+ *   has no record boundaries, so receives read ahead into a per-connection
+ *   buffer and cut frames out of it (one recv often yields several), and
+ *   every send goes through the staged queue, which keeps a partly written
+ *   frame at its head until the rest is out. A flush gathers all staged
+ *   frames into one sendmsg, so a batch leaves as full segments.
+ * - TCP links carry no descriptors: no shared-memory rings, and region
+ *   export returns -ENOTSUP.
+ * - LZ4 (KCORO_CAP_LZ4, both ends willing): a flush first packs the frames
+ *   at the head of the queue, as many as fit one frame, into one
+ *   KCORO_CMD_LZ4 frame, provided they add up to KCORO_IPC_LZ4_MIN and
+ *   shrink. The receiver unpacks such a frame into a buffer of its own and
+ *   cuts the frames out of that before reading on, so callers never see
+ *   it. Packing never splits a frame and happens only while nothing of the
+ *   head is on the wire yet.
  *
  * Semantics
  * - Preserves channel error codes in replies. Logging is gated by KCORO_DEBUG.
  */
+#ifdef __linux__
+#define _GNU_SOURCE 1 /* sendmmsg, MSG_CMSG_CLOEXEC */
+#endif
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
 #include <unistd.h>
 #include <stdlib.h>
 #include <string.h>
@@ -31,13 +91,29 @@
 #include <pthread.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <stdatomic.h>
+#include <time.h>
 
 #include "../include/kcoro_ipc_posix.h"
+#include "kcoro_ipc_shm_internal.h"
+#include "kcoro_ipc_lz4_internal.h"
 #include "../../../include/kcoro_abi.h"
 #include "../../../include/kcoro_config.h"
+#include "../../../include/kcoro_sched.h"
+#include "../../../include/kcoro.h"
+#include "../../../include/kcoro_io.h"
+#include "../../../include/kcoro_zcopy.h"
+#include "../../../include/kc_mem.h"
+
+#ifdef MSG_NOSIGNAL
+#define KC_MSG_NOSIGNAL MSG_NOSIGNAL
+#else
+#define KC_MSG_NOSIGNAL 0
+#endif
 
 typedef struct kc_ipc_server {
     int fd;
+    int stream;         /* TCP listener */
     char path[108];
     pthread_mutex_t mu; /* thread-safe accept/config */
 } kc_ipc_server_t;
@@ -48,21 +124,89 @@ struct kc_wire_hdr {
     uint32_t len;     /* payload bytes */
 };
 
+/* A staged frame: header plus a private copy of the payload. */
+struct kc_txf {
+    struct kc_wire_hdr hdr;
+    uint8_t *buf;       /* payload copy; kept for the next frame */
+    size_t   cap;
+    size_t   len;
+};
+
 typedef struct kc_ipc_conn {
     int fd;
-    /* Non-blocking staged write */
-    uint8_t *wbuf;      /* header+payload staged */
-    size_t   wlen;      /* total bytes */
-    size_t   woff;      /* bytes already sent */
-    /* Non-blocking staged read */
-    struct kc_wire_hdr rhdr;  /* header staging */
-    size_t   rgot;      /* bytes of header read so far */
-    uint8_t *rbuf;      /* payload buffer */
-    size_t   rlen;      /* expected payload length */
-    size_t   roff;      /* bytes of payload read */
-    pthread_mutex_t mu; /* thread-safe staged I/O */
+    int stream;         /* TCP: no record boundaries, no descriptors */
+    /* Staged writes: a ring of KCORO_IPC_TXQ frames, oldest at tx_head */
+    struct kc_txf txq[KCORO_IPC_TXQ];
+    unsigned tx_head, tx_count;
+    size_t tx_off;      /* stream: bytes of the head frame already sent */
+    pthread_mutex_t mu; /* staged writes; the tx ring */
+    /* Receive buffer for kc_ipc_recv/_nb (kc_ipc_conn_max_frame, on first use) */
+    uint8_t *rxbuf;
+    size_t rxcap;
+    pthread_mutex_t rx_mu; /* the rx ring; the stream buffer */
+    /* Stream read-ahead: s_len bytes at sbuf + s_off, not yet cut into frames
+     * (STREAM_BUF bytes, on first use) */
+    uint8_t *sbuf;
+    size_t s_off, s_len;
+    /* LZ4, once both HELLOs offered it. Sender (c->mu): the run being
+     * packed, the block it packs to and the compressor's table; receiver
+     * (c->rx_mu): the unpacked run, z_len bytes at zbuf + z_off not yet
+     * taken. Buffers come on first use. */
+    int lz4;
+    uint8_t *zraw, *zout;
+    uint32_t *ztab;
+    uint8_t *zbuf;
+    size_t z_off, z_len;
+    /* Both HELLOs offered KCORO_CAP_FIXED */
+    int fixed;
+    /* Shared-memory rings, once the handshake set them up */
+    int shm_on;
+    kc_shm_t shm;
+    int space_fd;       /* "room freed" doorbells to and from the peer */
+    int rx_armed;       /* rx_wait was armed: a data doorbell may be queued */
+    int tx_dirty;       /* frames put since the last doorbell check */
+    /* Shared regions: ours the peer has mapped, and the peer's we mapped */
+    pthread_mutex_t ex_mu;  /* exports, one at a time */
+    unsigned long rg_out[KCORO_IPC_REGIONS];
+    unsigned n_out;
+    pthread_mutex_t rg_mu;  /* imports */
+    struct { uint64_t peer_id; kc_region_t *reg; } rg_in[KCORO_IPC_REGIONS];
+    unsigned n_in;
 } kc_ipc_conn_t;
 
+#define STREAM_BUF (sizeof(struct kc_wire_hdr) + KCORO_IPC_MAX_FRAME)
+
+static struct {
+    _Atomic(unsigned long) batches, frames, skipped, unpacked;
+    _Atomic(uint64_t) raw_bytes, wire_bytes, compress_ns, decompress_ns;
+} g_lz4;
+
+/* This thread's CPU clock: a coroutine runs the codec without switching. */
+static uint64_t cpu_ns(void)
+{
+    struct timespec t;
+#ifdef CLOCK_THREAD_CPUTIME_ID
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t);
+#else
+    clock_gettime(CLOCK_MONOTONIC, &t);
+#endif
+    return (uint64_t)t.tv_sec * 1000000000ull + (uint64_t)t.tv_nsec;
+}
+
+void kc_ipc_get_lz4_stats(kc_ipc_lz4_stats_t *out)
+{
+    if (!out) return;
+    out->batches = atomic_load_explicit(&g_lz4.batches, memory_order_relaxed);
+    out->frames = atomic_load_explicit(&g_lz4.frames, memory_order_relaxed);
+    out->skipped = atomic_load_explicit(&g_lz4.skipped, memory_order_relaxed);
+    out->unpacked = atomic_load_explicit(&g_lz4.unpacked, memory_order_relaxed);
+    out->raw_bytes = atomic_load_explicit(&g_lz4.raw_bytes, memory_order_relaxed);
+    out->wire_bytes = atomic_load_explicit(&g_lz4.wire_bytes, memory_order_relaxed);
+    out->compress_ns = atomic_load_explicit(&g_lz4.compress_ns, memory_order_relaxed);
+    out->decompress_ns = atomic_load_explicit(&g_lz4.decompress_ns, memory_order_relaxed);
+    out->ratio = out->wire_bytes ? (double)out->raw_bytes / (double)out->wire_bytes : 0.0;
+}
+
 static size_t kc_strnlen(const char *s, size_t max)
 {
     size_t i = 0; if (!s) return 0; while (i < max && s[i] != '\0') i++; return i;
@@ -94,6 +238,23 @@ static void kc_dbg(const char *fmt, ...)
     va_end(ap);
 }
 
+static void conn_init_locks(kc_ipc_conn_t *c)
+{
+    pthread_mutex_init(&c->mu, NULL);
+    pthread_mutex_init(&c->rx_mu, NULL);
+    pthread_mutex_init(&c->ex_mu, NULL);
+    pthread_mutex_init(&c->rg_mu, NULL);
+    c->space_fd = -1;
+}
+
+/* TCP: frames leave as soon as they are flushed. */
+static void conn_set_stream(kc_ipc_conn_t *c)
+{
+    int one = 1;
+    (void)setsockopt(c->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    c->stream = 1;
+}
+
 int kc_ipc_srv_listen(const char *sock_path, kc_ipc_server_t **out)
 {
     if (!sock_path || !out) return -EINVAL;
@@ -119,7 +280,9 @@ int kc_ipc_srv_accept(kc_ipc_server_t *srv, kc_ipc_conn_t **out)
     if (cfd < 0) return -errno;
     (void)fcntl(cfd, F_SETFD, FD_CLOEXEC);
     kc_ipc_conn_t *c = calloc(1, sizeof(*c)); if (!c) { close(cfd); return -ENOMEM; }
-    c->fd = cfd; pthread_mutex_init(&c->mu, NULL); *out = c; kc_dbg("srv%p accept fd=%d conn%p", (void*)srv, cfd, (void*)c); return 0;
+    c->fd = cfd; conn_init_locks(c);
+    if (srv->stream) conn_set_stream(c);
+    *out = c; kc_dbg("srv%p accept fd=%d conn%p", (void*)srv, cfd, (void*)c); return 0;
 }
 
 int kc_ipc_srv_set_nb(kc_ipc_server_t *srv, int nb_on)
@@ -141,7 +304,9 @@ int kc_ipc_srv_accept_nb(kc_ipc_server_t *srv, kc_ipc_conn_t **out)
     if (cfd < 0) return (errno == EAGAIN || errno == EWOULDBLOCK) ? -EAGAIN : -errno;
     (void)fcntl(cfd, F_SETFD, FD_CLOEXEC);
     kc_ipc_conn_t *c = calloc(1, sizeof(*c)); if (!c) { close(cfd); return -ENOMEM; }
-    c->fd = cfd; pthread_mutex_init(&c->mu, NULL); *out = c; kc_dbg("srv%p try_accept fd=%d conn%p", (void*)srv, cfd, (void*)c); return 0;
+    c->fd = cfd; conn_init_locks(c);
+    if (srv->stream) conn_set_stream(c);
+    *out = c; kc_dbg("srv%p try_accept fd=%d conn%p", (void*)srv, cfd, (void*)c); return 0;
 }
 
 int kc_ipc_srv_fd(kc_ipc_server_t *srv)
@@ -151,7 +316,7 @@ void kc_ipc_srv_close(kc_ipc_server_t *srv)
 {
     if (!srv) return;
     close(srv->fd);
-    unlink(srv->path);
+    if (!srv->stream) unlink(srv->path);
     kc_dbg("srv%p close fd=%d", (void*)srv, srv->fd);
     pthread_mutex_destroy(&srv->mu);
     free(srv);
@@ -165,7 +330,112 @@ int kc_ipc_connect(const char *sock_path, kc_ipc_conn_t **out)
     if (len < 0) { close(fd); return len; }
     if (connect(fd, (struct sockaddr*)&sa, len) < 0) { int e=-errno; close(fd); return e; }
     kc_ipc_conn_t *c = calloc(1, sizeof(*c)); if (!c) { close(fd); return -ENOMEM; }
-    c->fd = fd; pthread_mutex_init(&c->mu, NULL); *out = c; kc_dbg("conn%p connect %s fd=%d", (void*)c, sock_path, fd); return 0;
+    c->fd = fd; conn_init_locks(c); *out = c; kc_dbg("conn%p connect %s fd=%d", (void*)c, sock_path, fd); return 0;
+}
+
+/* Resolve host:port for a stream socket; host NULL means any (listen). */
+static int tcp_resolve(const char *host, const char *port, int passive, struct addrinfo **res)
+{
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = passive ? AI_PASSIVE : 0;
+    int rc = getaddrinfo(host, port, &hints, res);
+    if (rc == 0) return 0;
+    return rc == EAI_SYSTEM ? -errno : -EADDRNOTAVAIL;
+}
+
+static int tcp_listen(const char *host, const char *port, int reuseport, kc_ipc_server_t **out)
+{
+    if (!port || !out) return -EINVAL;
+#ifndef SO_REUSEPORT
+    if (reuseport) return -ENOTSUP;
+#endif
+    struct addrinfo *res = NULL;
+    int rc = tcp_resolve(host, port, 1, &res);
+    if (rc != 0) return rc;
+    int fd = -1;
+    rc = -EADDRNOTAVAIL;
+    for (struct addrinfo *ai = res; ai; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0) { rc = -errno; continue; }
+        (void)fcntl(fd, F_SETFD, FD_CLOEXEC);
+        int one = 1;
+        (void)setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+#ifdef SO_REUSEPORT
+        if (reuseport && setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) != 0) {
+            rc = -errno; close(fd); fd = -1; continue;
+        }
+#endif
+        if (bind(fd, ai->ai_addr, ai->ai_addrlen) == 0 && listen(fd, KCORO_IPC_BACKLOG) == 0) { rc = 0; break; }
+        rc = -errno; close(fd); fd = -1;
+    }
+    freeaddrinfo(res);
+    if (rc != 0) return rc;
+    kc_ipc_server_t *srv = calloc(1, sizeof(*srv));
+    if (!srv) { close(fd); return -ENOMEM; }
+    srv->fd = fd; srv->stream = 1;
+    pthread_mutex_init(&srv->mu, NULL);
+    kc_dbg("srv%p listen tcp %s:%s fd=%d", (void*)srv, host ? host : "*", port, fd);
+    *out = srv; return 0;
+}
+
+int kc_ipc_srv_listen_tcp(const char *host, const char *port, kc_ipc_server_t **out)
+{
+    return tcp_listen(host, port, 0, out);
+}
+
+int kc_ipc_srv_listen_tcp_reuseport(const char *host, const char *port, kc_ipc_server_t **out)
+{
+    return tcp_listen(host, port, 1, out);
+}
+
+int kc_ipc_srv_port(kc_ipc_server_t *srv)
+{
+    if (!srv) return -EINVAL;
+    if (!srv->stream) return -ENOTSUP;
+    struct sockaddr_storage ss; socklen_t sl = sizeof(ss);
+    if (getsockname(srv->fd, (struct sockaddr*)&ss, &sl) != 0) return -errno;
+    if (ss.ss_family == AF_INET) return ntohs(((struct sockaddr_in*)&ss)->sin_port);
+    if (ss.ss_family == AF_INET6) return ntohs(((struct sockaddr_in6*)&ss)->sin6_port);
+    return -EAFNOSUPPORT;
+}
+
+int kc_ipc_connect_tcp(const char *host, const char *port, kc_ipc_conn_t **out)
+{
+    if (!host || !port || !out) return -EINVAL;
+    struct addrinfo *res = NULL;
+    int rc = tcp_resolve(host, port, 0, &res);
+    if (rc != 0) return rc;
+    int fd = -1;
+    rc = -EADDRNOTAVAIL;
+    for (struct addrinfo *ai = res; ai; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0) { rc = -errno; continue; }
+        (void)fcntl(fd, F_SETFD, FD_CLOEXEC);
+        /* Parks a coroutine caller rather than its worker. */
+        if ((rc = kc_io_connect(fd, ai->ai_addr, ai->ai_addrlen)) == 0) break;
+        close(fd); fd = -1;
+    }
+    freeaddrinfo(res);
+    if (rc != 0) return rc;
+    kc_ipc_conn_t *c = calloc(1, sizeof(*c)); if (!c) { close(fd); return -ENOMEM; }
+    c->fd = fd; conn_init_locks(c); conn_set_stream(c);
+    *out = c; kc_dbg("conn%p connect tcp %s:%s fd=%d", (void*)c, host, port, fd); return 0;
+}
+
+int kc_ipc_conn_set_busy_poll(kc_ipc_conn_t *c, unsigned usec)
+{
+    if (!c) return -EINVAL;
+    if (!c->stream) return -ENOTSUP;
+#ifdef SO_BUSY_POLL
+    int v = (int)usec;
+    return setsockopt(c->fd, SOL_SOCKET, SO_BUSY_POLL, &v, sizeof(v)) < 0 ? -errno : 0;
+#else
+    (void)usec;
+    return -ENOTSUP;
+#endif
 }
 
 void kc_ipc_conn_close(kc_ipc_conn_t *c)
@@ -173,11 +443,26 @@ void kc_ipc_conn_close(kc_ipc_conn_t *c)
     if (!c) return;
     pthread_mutex_lock(&c->mu);
     close(c->fd);
-    free(c->wbuf);
-    free(c->rbuf);
+    if (c->space_fd >= 0) close(c->space_fd);
+    if (c->shm_on) kc_shm_unmap(&c->shm);
+    for (unsigned i = 0; i < KCORO_IPC_TXQ; i++) free(c->txq[i].buf);
+    kc_mem_uncharge(KC_MEM_IPC, c->rxcap + (c->sbuf ? STREAM_BUF : 0) +
+                                (c->zraw ? 2 * KCORO_IPC_MAX_FRAME + KC_LZ4_TABLE_BYTES : 0) +
+                                (c->zbuf ? KCORO_IPC_MAX_FRAME : 0));
+    free(c->rxbuf);
+    free(c->sbuf);
+    free(c->zraw);
+    free(c->zout);
+    free(c->ztab);
+    free(c->zbuf);
+    /* Descriptors into them may still sit in channels: the last one unmaps. */
+    for (unsigned i = 0; i < c->n_in; i++) (void)kc_region_retire(c->rg_in[i].reg);
     kc_dbg("conn%p close fd=%d", (void*)c, c->fd);
     pthread_mutex_unlock(&c->mu);
     pthread_mutex_destroy(&c->mu);
+    pthread_mutex_destroy(&c->rx_mu);
+    pthread_mutex_destroy(&c->ex_mu);
+    pthread_mutex_destroy(&c->rg_mu);
     free(c);
 }
 
@@ -196,128 +481,697 @@ int kc_ipc_conn_set_nb(kc_ipc_conn_t *c, int nb_on)
 int kc_ipc_conn_fd(kc_ipc_conn_t *c)
 { return c ? c->fd : -1; }
 
-static int send_all(int fd, const void *buf, size_t len)
+size_t kc_ipc_conn_max_frame(kc_ipc_conn_t *c)
 {
-    const uint8_t *p = buf; size_t off=0; ssize_t n;
-    while (off < len) { n = send(fd, p+off, len-off, 0); if (n < 0) return -errno; off += (size_t)n; }
-    return 0;
+    if (c && c->shm_on) return kc_shm_max_payload(&c->shm);
+    return KCORO_IPC_MAX_FRAME;
 }
 
-static int recv_all(int fd, void *buf, size_t len)
+int kc_ipc_conn_lz4(kc_ipc_conn_t *c)
+{ return c ? c->lz4 : 0; }
+
+int kc_ipc_conn_fixed(kc_ipc_conn_t *c)
 {
-    uint8_t *p = buf; size_t off=0; ssize_t n;
-    while (off < len) { n = recv(fd, p+off, len-off, 0); if (n <= 0) return n==0 ? -ECONNRESET : -errno; off += (size_t)n; }
-    return 0;
+    return c ? c->fixed : 0;
 }
 
-int kc_ipc_send(kc_ipc_conn_t *c, uint16_t cmd, const void *payload, size_t len)
+int kc_ipc_conn_shutdown(kc_ipc_conn_t *c)
 {
     if (!c) return -EINVAL;
-    struct kc_wire_hdr h = { .cmd = htons(cmd), .rsvd = 0, .len = htonl((uint32_t)len) };
-    int rc = send_all(c->fd, &h, sizeof(h)); if (rc) return rc;
-    if (len && payload) rc = send_all(c->fd, payload, len);
-    kc_dbg("conn%p send cmd=%u len=%zu rc=%d", (void*)c, cmd, len, rc);
+    int rc = shutdown(c->fd, SHUT_RDWR) < 0 ? -errno : 0;
+    if (c->space_fd >= 0) (void)shutdown(c->space_fd, SHUT_RDWR);
     return rc;
 }
 
-int kc_ipc_recv(kc_ipc_conn_t *c, uint16_t *cmd, uint8_t **payload, size_t *len)
+/* ---- Doorbells (shared-memory connections) ---- */
+
+static void ring_bell(int fd)
 {
-    if (!c || !cmd || !payload || !len) return -EINVAL;
-    struct kc_wire_hdr h; int rc = recv_all(c->fd, &h, sizeof(h)); if (rc) return rc;
-    uint32_t n = ntohl(h.len);
-    uint16_t k = ntohs(h.cmd);
-    uint8_t *buf = NULL;
-    if (n) { buf = malloc(n); if (!buf) return -ENOMEM; rc = recv_all(c->fd, buf, n); if (rc) { free(buf); return rc; } }
-    *cmd = k; *payload = buf; *len = n; kc_dbg("conn%p recv cmd=%u len=%zu", (void*)c, k, (size_t)n); return 0;
+    char b = 1;
+    /* A full socket already holds doorbells the peer has yet to read. */
+    (void)send(fd, &b, 1, MSG_DONTWAIT | KC_MSG_NOSIGNAL);
 }
 
-/* Non-blocking staged send: returns 0 when fully flushed, -EAGAIN if pending */
-int kc_ipc_flush(kc_ipc_conn_t *c)
+/* Read every doorbell queued on fd: 0, or -ECONNRESET once the peer is gone. */
+static int drain_bells(int fd)
+{
+    char b[16];
+    for (;;) {
+        ssize_t n = recv(fd, b, sizeof(b), MSG_DONTWAIT);
+        if (n > 0) continue;
+        if (n == 0) return -ECONNRESET;
+        if (errno == EINTR) continue;
+        return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -errno;
+    }
+}
+
+static int region_accept(kc_ipc_conn_t *c, const uint8_t *p, size_t n, int fd);
+static ssize_t recv_frame(int fd, struct kc_wire_hdr *h, void *buf, size_t cap, int flags, int *fd_out);
+
+/* Drain the data socket of a shared-memory connection: doorbells, and the
+ * REGION records whose frames the ring carries. */
+static int drain_sock(kc_ipc_conn_t *c)
+{
+    uint8_t buf[64];
+    for (;;) {
+        struct kc_wire_hdr h;
+        int rfd = -1;
+        ssize_t n = recv_frame(c->fd, &h, buf, sizeof(buf), MSG_DONTWAIT, &rfd);
+        if (n == -EAGAIN) return 0;
+        if (n == -ECONNRESET) return (int)n;
+        if (n >= 0 && ntohs(h.cmd) == KCORO_CMD_REGION) { (void)region_accept(c, buf, (size_t)n, rfd); continue; }
+        if (rfd >= 0) close(rfd);
+        /* A one-byte doorbell reads as -EPROTO (shorter than a header). */
+        if (n < 0 && n != -EPROTO && n != -EMSGSIZE) return (int)n;
+    }
+}
+
+/* Producer side: wait until the peer frees room in the tx ring. */
+static int wait_room(kc_ipc_conn_t *c, long timeout_ms)
+{
+    int rc = kc_await_readable(c->space_fd, timeout_ms);
+    return rc != 0 ? rc : drain_bells(c->space_fd);
+}
+
+int kc_ipc_await_flush(kc_ipc_conn_t *c, long timeout_ms)
 {
     if (!c) return -EINVAL;
+    if (!c->shm_on) return kc_await_writable(c->fd, timeout_ms);
+    return wait_room(c, timeout_ms);
+}
+
+/* Next ring record into buf. Called with c->rx_mu held. */
+static int shm_recv_locked(kc_ipc_conn_t *c, uint16_t *cmd, void *buf, size_t cap, size_t *len, int nb)
+{
+    for (;;) {
+        int rc = kc_shm_get(&c->shm, cmd, buf, cap, len);
+        if (rc != -EAGAIN) {
+            if (rc != -EPROTO && kc_shm_claim_tx_wake(&c->shm)) ring_bell(c->space_fd);
+            if (rc == 0 && *cmd == KCORO_CMD_REGION) {
+                /* Its record was on the socket before this frame was put. */
+                if ((rc = drain_sock(c)) != 0) return rc;
+                continue;
+            }
+            return rc;
+        }
+        if (c->rx_armed) {
+            /* Empty after an arm: collect its doorbell, and see a hang-up. */
+            c->rx_armed = 0;
+            if ((rc = drain_sock(c)) != 0) return rc;
+        }
+        if (kc_shm_arm_rx(&c->shm)) {
+            c->rx_armed = kc_shm_disarm_rx(&c->shm);
+            continue;
+        }
+        c->rx_armed = 1;
+        if (nb) return -EAGAIN;
+        if ((rc = kc_await_readable(c->fd, -1)) != 0) return rc;
+    }
+}
+
+/* Blocking put of the len bytes in iov[0..n): waits (outside c->mu) while
+ * the ring is full. */
+static int shm_sendv(kc_ipc_conn_t *c, uint16_t cmd, const struct iovec *iov, int n, size_t len)
+{
     pthread_mutex_lock(&c->mu);
-    if (c->wbuf == NULL || c->wlen == c->woff) { pthread_mutex_unlock(&c->mu); return 0; }
-    ssize_t n = send(c->fd, c->wbuf + c->woff, c->wlen - c->woff, 0);
-    if (n < 0) {
-        if (errno == EAGAIN || errno == EWOULDBLOCK) { pthread_mutex_unlock(&c->mu); return -EAGAIN; }
-        int e = -errno; free(c->wbuf); c->wbuf=NULL; c->wlen=c->woff=0; pthread_mutex_unlock(&c->mu); return e;
-    }
-    c->woff += (size_t)n;
-    if (c->woff == c->wlen) { free(c->wbuf); c->wbuf=NULL; c->wlen=c->woff=0; pthread_mutex_unlock(&c->mu); kc_dbg("conn%p flush done", (void*)c); return 0; }
+    int rc;
+    while ((rc = kc_shm_putv(&c->shm, cmd, iov, n, len)) == -EAGAIN) {
+        if (kc_shm_arm_tx(&c->shm, len)) continue;
+        pthread_mutex_unlock(&c->mu);
+        rc = wait_room(c, -1);
+        pthread_mutex_lock(&c->mu);
+        if (rc != 0) break;
+    }
+    if (rc == 0 && kc_shm_claim_rx_wake(&c->shm)) ring_bell(c->fd);
     pthread_mutex_unlock(&c->mu);
-    return -EAGAIN;
+    return rc;
 }
 
-int kc_ipc_send_nb(kc_ipc_conn_t *c, uint16_t cmd, const void *payload, size_t len)
+static int shm_send(kc_ipc_conn_t *c, uint16_t cmd, const void *payload, size_t len)
 {
-    if (!c) return -EINVAL;
-    pthread_mutex_lock(&c->mu);
-    /* If a previous frame is pending, attempt to flush it first */
-    if (c->wbuf && c->wlen != c->woff) {
-        ssize_t n = send(c->fd, c->wbuf + c->woff, c->wlen - c->woff, 0);
+    struct iovec one = { (void*)payload, len };
+    return shm_sendv(c, cmd, &one, 1, len);
+}
+
+/* One frame as one record, gathered from the header and iov[0..n). */
+static ssize_t send_framev(int fd, const struct kc_wire_hdr *h, const struct iovec *iov, int n)
+{
+    struct iovec v[1 + KCORO_IPC_IOV_MAX];
+    v[0].iov_base = (void*)h; v[0].iov_len = sizeof(*h);
+    int k = 1;
+    for (int i = 0; i < n; i++) if (iov[i].iov_len) v[k++] = iov[i];
+    struct msghdr mh;
+    memset(&mh, 0, sizeof(mh));
+    mh.msg_iov = v; mh.msg_iovlen = (size_t)k;
+    ssize_t r;
+    do r = sendmsg(fd, &mh, 0); while (r < 0 && errno == EINTR);
+    return r;
+}
+
+#ifndef __linux__
+static ssize_t send_frame(int fd, const struct kc_wire_hdr *h, const void *payload, size_t len)
+{
+    struct iovec one = { (void*)payload, len };
+    return send_framev(fd, h, &one, 1);
+}
+#endif
+
+/* Read one record into *h and buf[cap]. Returns the payload length or a
+ * negative errno: -EAGAIN when none is waiting (MSG_DONTWAIT), -EMSGSIZE
+ * when the payload did not fit. The record is consumed either way; a
+ * descriptor it carried lands in *fd_out (-1 when none). */
+static ssize_t recv_frame(int fd, struct kc_wire_hdr *h, void *buf, size_t cap, int flags, int *fd_out)
+{
+    struct iovec iov[2] = { { h, sizeof(*h) }, { buf, cap } };
+    union { struct cmsghdr h; char b[CMSG_SPACE(sizeof(int))]; } ctl;
+    struct msghdr mh;
+    memset(&mh, 0, sizeof(mh));
+    mh.msg_iov = iov; mh.msg_iovlen = cap ? 2 : 1;
+    mh.msg_control = ctl.b; mh.msg_controllen = sizeof(ctl.b);
+#ifdef MSG_CMSG_CLOEXEC
+    flags |= MSG_CMSG_CLOEXEC;
+#endif
+    ssize_t n;
+    do n = recvmsg(fd, &mh, flags); while (n < 0 && errno == EINTR);
+    *fd_out = -1;
+    if (n < 0) return (errno == EAGAIN || errno == EWOULDBLOCK) ? -EAGAIN : -errno;
+    for (struct cmsghdr *cm = CMSG_FIRSTHDR(&mh); cm; cm = CMSG_NXTHDR(&mh, cm)) {
+        if (cm->cmsg_level != SOL_SOCKET || cm->cmsg_type != SCM_RIGHTS) continue;
+        size_t k = (cm->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        for (size_t i = 0; i < k; i++) {
+            int rfd; memcpy(&rfd, CMSG_DATA(cm) + i * sizeof(int), sizeof(int));
+            if (*fd_out < 0) *fd_out = rfd; else close(rfd);
+        }
+    }
+    if (n == 0) return -ECONNRESET;
+    if ((size_t)n < sizeof(*h)) return -EPROTO;
+    size_t plen = ntohl(h->len);
+    if ((mh.msg_flags & MSG_TRUNC) || plen > cap) return -EMSGSIZE;
+    if (plen != (size_t)n - sizeof(*h)) return -EPROTO;
+    return (ssize_t)plen;
+}
+
+/* ---- Stream (TCP) framing ---- */
+
+/* Unpack a KCORO_CMD_LZ4 payload into c->zbuf. Called with c->rx_mu held
+ * and nothing left there. */
+static int stream_unpack_locked(kc_ipc_conn_t *c, const uint8_t *p, size_t n)
+{
+    uint32_t raw;
+    if (n < sizeof(raw)) return -EPROTO;
+    memcpy(&raw, p, sizeof(raw));
+    raw = ntohl(raw);
+    if (raw > KCORO_IPC_MAX_FRAME) return -EPROTO;
+    if (!c->zbuf) {
+        if (kc_mem_charge(KC_MEM_IPC, KCORO_IPC_MAX_FRAME) != 0) return -ENOMEM;
+        if (!(c->zbuf = malloc(KCORO_IPC_MAX_FRAME))) { kc_mem_uncharge(KC_MEM_IPC, KCORO_IPC_MAX_FRAME); return -ENOMEM; }
+    }
+    uint64_t t0 = cpu_ns();
+    size_t got = 0;
+    int rc = kc_lz4_decompress(p + sizeof(raw), n - sizeof(raw), c->zbuf, raw, &got);
+    atomic_fetch_add_explicit(&g_lz4.decompress_ns, cpu_ns() - t0, memory_order_relaxed);
+    if (rc != 0 || got != raw) return -EPROTO;
+    atomic_fetch_add_explicit(&g_lz4.unpacked, 1, memory_order_relaxed);
+    c->z_off = 0;
+    c->z_len = got;
+    return 0;
+}
+
+/* The next frame of an unpacked run; the sender only packs whole frames. */
+static int stream_take_unpacked(kc_ipc_conn_t *c, uint16_t *cmd, void *buf, size_t cap, size_t *len)
+{
+    struct kc_wire_hdr h;
+    if (c->z_len < sizeof(h)) { c->z_len = 0; return -EPROTO; }
+    memcpy(&h, c->zbuf + c->z_off, sizeof(h));
+    size_t plen = ntohl(h.len);
+    if (plen > c->z_len - sizeof(h)) { c->z_len = 0; return -EPROTO; }
+    int rc = 0;
+    if (plen > cap) rc = -EMSGSIZE;
+    else if (plen) memcpy(buf, c->zbuf + c->z_off + sizeof(h), plen);
+    c->z_off += sizeof(h) + plen;
+    c->z_len -= sizeof(h) + plen;
+    if (rc == 0) { *cmd = ntohs(h.cmd); *len = plen; }
+    return rc;
+}
+
+/* Cut the next frame out of the read-ahead buffer, reading more as needed.
+ * Same results as recv_frame; a frame larger than cap is skipped with
+ * -EMSGSIZE. Frames of an unpacked LZ4 run come before anything read
+ * after it. Called with c->rx_mu held. */
+static int stream_recv_locked(kc_ipc_conn_t *c, uint16_t *cmd, void *buf, size_t cap, size_t *len, int flags)
+{
+    if (!c->sbuf) {
+        if (kc_mem_charge(KC_MEM_IPC, STREAM_BUF) != 0) return -ENOMEM;
+        if (!(c->sbuf = malloc(STREAM_BUF))) { kc_mem_uncharge(KC_MEM_IPC, STREAM_BUF); return -ENOMEM; }
+    }
+    for (;;) {
+        if (c->z_len) return stream_take_unpacked(c, cmd, buf, cap, len);
+        struct kc_wire_hdr h;
+        if (c->s_len >= sizeof(h)) {
+            memcpy(&h, c->sbuf + c->s_off, sizeof(h));
+            size_t plen = ntohl(h.len);
+            if (plen > KCORO_IPC_MAX_FRAME) return -EPROTO; /* no way to resync */
+            if (c->s_len >= sizeof(h) + plen) {
+                int rc = 0;
+                if (c->lz4 && ntohs(h.cmd) == KCORO_CMD_LZ4) {
+                    rc = stream_unpack_locked(c, c->sbuf + c->s_off + sizeof(h), plen);
+                    c->s_off += sizeof(h) + plen;
+                    c->s_len -= sizeof(h) + plen;
+                    if (c->s_len == 0) c->s_off = 0;
+                    if (rc != 0) return rc;
+                    continue;
+                }
+                if (plen > cap) rc = -EMSGSIZE;
+                else if (plen) memcpy(buf, c->sbuf + c->s_off + sizeof(h), plen);
+                c->s_off += sizeof(h) + plen;
+                c->s_len -= sizeof(h) + plen;
+                if (c->s_len == 0) c->s_off = 0;
+                if (rc == 0) { *cmd = ntohs(h.cmd); *len = plen; }
+                return rc;
+            }
+        }
+        /* Only a partial frame is left: move it to the front. */
+        if (c->s_off) { memmove(c->sbuf, c->sbuf + c->s_off, c->s_len); c->s_off = 0; }
+        ssize_t n = recv(c->fd, c->sbuf + c->s_len, STREAM_BUF - c->s_len, flags);
         if (n < 0) {
-            if (errno == EAGAIN || errno == EWOULDBLOCK) { pthread_mutex_unlock(&c->mu); return -EAGAIN; }
-            int e = -errno; free(c->wbuf); c->wbuf=NULL; c->wlen=c->woff=0; pthread_mutex_unlock(&c->mu); return e;
+            if (errno == EINTR) continue;
+            return (errno == EAGAIN || errno == EWOULDBLOCK) ? -EAGAIN : -errno;
         }
-        c->woff += (size_t)n;
-        if (c->woff != c->wlen) { pthread_mutex_unlock(&c->mu); return -EAGAIN; }
-        free(c->wbuf); c->wbuf=NULL; c->wlen=c->woff=0;
+        if (n == 0) return -ECONNRESET;
+        c->s_len += (size_t)n;
     }
+}
 
-    /* Stage header+payload into a single contiguous buffer */
-    size_t tot = sizeof(struct kc_wire_hdr) + len;
-    uint8_t *buf = malloc(tot); if (!buf) { pthread_mutex_unlock(&c->mu); return -ENOMEM; }
-    struct kc_wire_hdr h = { .cmd = htons(cmd), .rsvd = 0, .len = htonl((uint32_t)len) };
-    memcpy(buf, &h, sizeof(h));
-    if (len && payload) memcpy(buf + sizeof(h), payload, len);
+/* Send every staged frame that fits in one gathered sendmsg, resuming
+ * mid-frame after a short write. Returns sent bytes or a negative errno. */
+static ssize_t stream_send_staged(kc_ipc_conn_t *c)
+{
+    struct iovec iov[KCORO_IPC_TXQ * 2];
+    int k = 0;
+    size_t skip = c->tx_off;
+    for (unsigned i = 0; i < c->tx_count; i++) {
+        struct kc_txf *f = &c->txq[(c->tx_head + i) % KCORO_IPC_TXQ];
+        struct iovec part[2] = { { &f->hdr, sizeof(f->hdr) }, { f->buf, f->len } };
+        for (int j = 0; j < 2; j++) {
+            if (skip >= part[j].iov_len) { skip -= part[j].iov_len; continue; }
+            iov[k].iov_base = (uint8_t*)part[j].iov_base + skip;
+            iov[k].iov_len = part[j].iov_len - skip;
+            skip = 0; k++;
+        }
+    }
+    struct msghdr mh;
+    memset(&mh, 0, sizeof(mh));
+    mh.msg_iov = iov; mh.msg_iovlen = (size_t)k;
+    ssize_t n = sendmsg(c->fd, &mh, KC_MSG_NOSIGNAL);
+    return n < 0 ? -errno : n;
+}
+
+/* LZ4: replace the frames at the head of the queue, as many as fit one
+ * frame, by one KCORO_CMD_LZ4 frame in the last one's place. They stay as
+ * they are below KCORO_IPC_LZ4_MIN bytes or when the frame would not come
+ * out smaller. Called with c->mu held, none of the head sent. */
+static void stream_pack_locked(kc_ipc_conn_t *c)
+{
+    const uint16_t lz4_cmd = htons(KCORO_CMD_LZ4);
+    unsigned k = 0;
+    size_t raw = 0;
+    for (; k < c->tx_count; k++) {
+        struct kc_txf *f = &c->txq[(c->tx_head + k) % KCORO_IPC_TXQ];
+        size_t flen = sizeof(f->hdr) + f->len;
+        if (f->hdr.cmd == lz4_cmd || raw + flen > KCORO_IPC_MAX_FRAME) break;
+        raw += flen;
+    }
+    if (k == 0 || raw < KCORO_IPC_LZ4_MIN || raw < 64) return; /* 64: nothing to gain */
+    if (!c->zraw) {
+        size_t need = 2 * KCORO_IPC_MAX_FRAME + KC_LZ4_TABLE_BYTES;
+        if (kc_mem_charge(KC_MEM_IPC, need) != 0) return;
+        c->zraw = malloc(KCORO_IPC_MAX_FRAME);
+        c->zout = malloc(KCORO_IPC_MAX_FRAME);
+        c->ztab = malloc(KC_LZ4_TABLE_BYTES);
+        if (!c->zraw || !c->zout || !c->ztab) {
+            free(c->zraw); free(c->zout); free(c->ztab);
+            c->zraw = c->zout = NULL; c->ztab = NULL;
+            kc_mem_uncharge(KC_MEM_IPC, need);
+            return;
+        }
+    }
+    size_t at = 0;
+    for (unsigned i = 0; i < k; i++) {
+        struct kc_txf *f = &c->txq[(c->tx_head + i) % KCORO_IPC_TXQ];
+        memcpy(c->zraw + at, &f->hdr, sizeof(f->hdr));
+        if (f->len) memcpy(c->zraw + at + sizeof(f->hdr), f->buf, f->len);
+        at += sizeof(f->hdr) + f->len;
+    }
+    uint32_t raw_be = htonl((uint32_t)raw);
+    uint64_t t0 = cpu_ns();
+    /* Worth it only if the frame (header, length, block) beats the run. */
+    size_t room = raw - sizeof(struct kc_wire_hdr) - sizeof(raw_be) - 1;
+    size_t zn = kc_lz4_compress(c->zraw, raw, c->zout + sizeof(raw_be), room, c->ztab);
+    atomic_fetch_add_explicit(&g_lz4.compress_ns, cpu_ns() - t0, memory_order_relaxed);
+    struct kc_txf *last = &c->txq[(c->tx_head + k - 1) % KCORO_IPC_TXQ];
+    size_t flen = sizeof(raw_be) + zn;
+    if (zn && flen > last->cap) {
+        uint8_t *nb = realloc(last->buf, flen);
+        if (nb) { last->buf = nb; last->cap = flen; } else zn = 0;
+    }
+    if (zn == 0) { atomic_fetch_add_explicit(&g_lz4.skipped, 1, memory_order_relaxed); return; }
+    memcpy(c->zout, &raw_be, sizeof(raw_be));
+    memcpy(last->buf, c->zout, flen);
+    last->len = flen;
+    last->hdr.cmd = lz4_cmd; last->hdr.rsvd = 0; last->hdr.len = htonl((uint32_t)last->len);
+    c->tx_head = (c->tx_head + k - 1) % KCORO_IPC_TXQ;
+    c->tx_count -= k - 1;
+    atomic_fetch_add_explicit(&g_lz4.batches, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&g_lz4.frames, k, memory_order_relaxed);
+    atomic_fetch_add_explicit(&g_lz4.raw_bytes, raw, memory_order_relaxed);
+    atomic_fetch_add_explicit(&g_lz4.wire_bytes, sizeof(last->hdr) + last->len, memory_order_relaxed);
+}
 
-    /* Try to write immediately */
-    ssize_t n = send(c->fd, buf, tot, 0);
-    if (n < 0) {
-        if (errno == EAGAIN || errno == EWOULDBLOCK) { c->wbuf = buf; c->wlen = tot; c->woff = 0; pthread_mutex_unlock(&c->mu); return -EAGAIN; }
-        int e = -errno; free(buf); pthread_mutex_unlock(&c->mu); return e;
+/* flush_locked for a stream. */
+static int stream_flush_locked(kc_ipc_conn_t *c)
+{
+    while (c->tx_count) {
+        if (c->lz4 && c->tx_off == 0) stream_pack_locked(c);
+        ssize_t n = stream_send_staged(c);
+        if (n == -EINTR) continue;
+        if (n == -EAGAIN || n == -EWOULDBLOCK) return -EAGAIN;
+        if (n < 0) { c->tx_head = c->tx_count = 0; c->tx_off = 0; return (int)n; }
+        size_t done = c->tx_off + (size_t)n;
+        while (c->tx_count) {
+            struct kc_txf *f = &c->txq[c->tx_head];
+            size_t flen = sizeof(f->hdr) + f->len;
+            if (done < flen) break;
+            done -= flen;
+            c->tx_head = (c->tx_head + 1) % KCORO_IPC_TXQ;
+            c->tx_count--;
+        }
+        c->tx_off = done;
     }
-    if ((size_t)n == tot) { free(buf); pthread_mutex_unlock(&c->mu); kc_dbg("conn%p send_nb cmd=%u len=%zu ok", (void*)c, cmd, len); return 0; }
-    /* Partial */
-    c->wbuf = buf; c->wlen = tot; c->woff = (size_t)n; pthread_mutex_unlock(&c->mu); kc_dbg("conn%p send_nb cmd=%u len=%zu EAGAIN", (void*)c, cmd, len); return -EAGAIN;
+    return 0;
 }
 
-/* Non-blocking staged recv: returns 0 and fills out when a full frame is ready;
- * -EAGAIN if need more data. Allocates *payload for caller to free. */
-int kc_ipc_recv_nb(kc_ipc_conn_t *c, uint16_t *cmd, uint8_t **payload, size_t *len)
+static int stage_locked_v(kc_ipc_conn_t *c, uint16_t cmd, const struct iovec *iov, int n, size_t len);
+
+/* Blocking send on a stream: stage behind any pending frames and flush,
+ * waiting (outside c->mu) while the socket is full. */
+static int stream_sendv(kc_ipc_conn_t *c, uint16_t cmd, const struct iovec *iov, int n, size_t len)
 {
-    if (!c || !cmd || !payload || !len) return -EINVAL;
     pthread_mutex_lock(&c->mu);
-    /* Stage header */
-    if (c->rgot < sizeof(struct kc_wire_hdr)) {
-        ssize_t n = recv(c->fd, ((uint8_t*)&c->rhdr) + c->rgot, sizeof(struct kc_wire_hdr) - c->rgot, 0);
-        if (n < 0) { int e = (errno == EAGAIN || errno == EWOULDBLOCK) ? -EAGAIN : -errno; pthread_mutex_unlock(&c->mu); return e; }
-        if (n == 0) { pthread_mutex_unlock(&c->mu); return -ECONNRESET; }
-        c->rgot += (size_t)n;
-        if (c->rgot < sizeof(struct kc_wire_hdr)) { pthread_mutex_unlock(&c->mu); return -EAGAIN; }
-        c->rlen = ntohl(c->rhdr.len);
-        c->roff = 0;
-        if (c->rlen) { c->rbuf = malloc(c->rlen); if (!c->rbuf) { c->rgot = 0; pthread_mutex_unlock(&c->mu); return -ENOMEM; } }
-    }
-    /* Stage payload */
-    if (c->rlen) {
-        ssize_t n = recv(c->fd, c->rbuf + c->roff, c->rlen - c->roff, 0);
-        if (n < 0) { int e = (errno == EAGAIN || errno == EWOULDBLOCK) ? -EAGAIN : -errno; pthread_mutex_unlock(&c->mu); return e; }
-        if (n == 0) { pthread_mutex_unlock(&c->mu); return -ECONNRESET; }
-        c->roff += (size_t)n;
-        if (c->roff < c->rlen) { pthread_mutex_unlock(&c->mu); return -EAGAIN; }
-    }
-    /* Full frame */
-    *cmd = ntohs(c->rhdr.cmd);
-    *len = c->rlen;
-    *payload = c->rbuf; /* may be NULL for zero-length */
-    /* Reset state for next frame */
-    c->rbuf = NULL; c->rlen = 0; c->roff = 0; c->rgot = 0;
+    int rc, staged = 0;
+    for (;;) {
+        if (!staged) {
+            rc = stage_locked_v(c, cmd, iov, n, len);
+            if (rc == 0) staged = 1;
+            else if (rc != -ENOBUFS) break;
+        }
+        rc = stream_flush_locked(c);
+        if (rc != -EAGAIN) {
+            if (rc == 0 && !staged) continue;
+            break;
+        }
+        pthread_mutex_unlock(&c->mu);
+        rc = kc_await_writable(c->fd, -1);
+        pthread_mutex_lock(&c->mu);
+        if (rc != 0) break;
+    }
     pthread_mutex_unlock(&c->mu);
-    kc_dbg("conn%p recv_nb cmd=%u len=%zu", (void*)c, *cmd, *len);
+    return rc;
+}
+
+static int stream_send(kc_ipc_conn_t *c, uint16_t cmd, const void *payload, size_t len)
+{
+    struct iovec one = { (void*)payload, len };
+    return stream_sendv(c, cmd, &one, 1, len);
+}
+
+int kc_ipc_sendv(kc_ipc_conn_t *c, uint16_t cmd, const struct iovec *iov, int iovcnt)
+{
+    if (!c || iovcnt < 0 || iovcnt > KCORO_IPC_IOV_MAX || (iovcnt && !iov)) return -EINVAL;
+    size_t len = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        if (iov[i].iov_len && !iov[i].iov_base) return -EINVAL;
+        if (iov[i].iov_len > SIZE_MAX - len) return -EMSGSIZE;
+        len += iov[i].iov_len;
+    }
+    if (len > kc_ipc_conn_max_frame(c)) return -EMSGSIZE;
+    int rc;
+    if (c->shm_on) {
+        rc = shm_sendv(c, cmd, iov, iovcnt, len);
+    } else if (c->stream) {
+        rc = stream_sendv(c, cmd, iov, iovcnt, len);
+    } else {
+        struct kc_wire_hdr h = { .cmd = htons(cmd), .rsvd = 0, .len = htonl((uint32_t)len) };
+        rc = send_framev(c->fd, &h, iov, iovcnt) < 0 ? -errno : 0;
+    }
+    kc_dbg("conn%p send cmd=%u len=%zu segs=%d rc=%d", (void*)c, cmd, len, iovcnt, rc);
+    return rc;
+}
+
+int kc_ipc_send(kc_ipc_conn_t *c, uint16_t cmd, const void *payload, size_t len)
+{
+    if (!c || (len && !payload)) return -EINVAL;
+    struct iovec one = { (void*)payload, len };
+    return kc_ipc_sendv(c, cmd, &one, 1);
+}
+
+int kc_ipc_send_ziov(kc_ipc_conn_t *c, uint16_t cmd, const kc_ziov_t *v)
+{
+    if (!kc_ziov_len(v)) return -EINVAL;
+    struct iovec iov[KCORO_IPC_IOV_MAX];
+    for (uint32_t i = 0; i < v->nseg; i++) {
+        const kc_zseg_t *sg = kc_ziov_seg(v, i);
+        iov[i].iov_base = sg->addr;
+        iov[i].iov_len = sg->len;
+    }
+    return kc_ipc_sendv(c, cmd, iov, (int)v->nseg);
+}
+
+/* Receive through the connection buffer and hand out a malloc'd copy. */
+static int recv_copy(kc_ipc_conn_t *c, uint16_t *cmd, uint8_t **payload, size_t *len, int flags)
+{
+    if (!c || !cmd || !payload || !len) return -EINVAL;
+    pthread_mutex_lock(&c->rx_mu);
+    size_t want = kc_ipc_conn_max_frame(c);
+    if (c->rxcap < want) {
+        /* First use, or the handshake moved the connection to the rings. */
+        if (kc_mem_charge(KC_MEM_IPC, want - c->rxcap) != 0) { pthread_mutex_unlock(&c->rx_mu); return -ENOMEM; }
+        uint8_t *nb = realloc(c->rxbuf, want);
+        if (!nb) { kc_mem_uncharge(KC_MEM_IPC, want - c->rxcap); pthread_mutex_unlock(&c->rx_mu); return -ENOMEM; }
+        c->rxbuf = nb; c->rxcap = want;
+    }
+    uint16_t rcmd = 0;
+    ssize_t n;
+    if (c->shm_on) {
+        size_t got = 0;
+        int rc = shm_recv_locked(c, &rcmd, c->rxbuf, c->rxcap, &got, flags != 0);
+        n = rc != 0 ? rc : (ssize_t)got;
+    } else if (c->stream) {
+        size_t got = 0;
+        int rc = stream_recv_locked(c, &rcmd, c->rxbuf, c->rxcap, &got, flags);
+        n = rc != 0 ? rc : (ssize_t)got;
+    } else {
+        for (;;) {
+            struct kc_wire_hdr h;
+            int rfd = -1;
+            n = recv_frame(c->fd, &h, c->rxbuf, c->rxcap, flags, &rfd);
+            rcmd = ntohs(h.cmd);
+            if (n >= 0 && rcmd == KCORO_CMD_REGION) { (void)region_accept(c, c->rxbuf, (size_t)n, rfd); continue; }
+            if (rfd >= 0) close(rfd);
+            break;
+        }
+    }
+    uint8_t *buf = NULL;
+    if (n > 0) {
+        if ((buf = malloc((size_t)n)) != NULL) memcpy(buf, c->rxbuf, (size_t)n);
+        else n = -ENOMEM;
+    }
+    pthread_mutex_unlock(&c->rx_mu);
+    if (n < 0) return (int)n;
+    *cmd = rcmd; *payload = buf; *len = (size_t)n;
+    kc_dbg("conn%p recv cmd=%u len=%zu", (void*)c, *cmd, *len);
     return 0;
 }
 
+int kc_ipc_recv(kc_ipc_conn_t *c, uint16_t *cmd, uint8_t **payload, size_t *len)
+{
+    return recv_copy(c, cmd, payload, len, 0);
+}
+
+/* Non-blocking recv: 0 and a malloc'd *payload (NULL when empty) once a
+ * frame is in, -EAGAIN if none is waiting. */
+int kc_ipc_recv_nb(kc_ipc_conn_t *c, uint16_t *cmd, uint8_t **payload, size_t *len)
+{
+    return recv_copy(c, cmd, payload, len, MSG_DONTWAIT);
+}
+
+static int recv_into(kc_ipc_conn_t *c, uint16_t *cmd, void *buf, size_t cap, size_t *len, int flags)
+{
+    if (!c || !cmd || !len || (cap && !buf)) return -EINVAL;
+    if (c->shm_on || c->stream) {
+        pthread_mutex_lock(&c->rx_mu);
+        int rc = c->shm_on ? shm_recv_locked(c, cmd, buf, cap, len, flags != 0)
+                           : stream_recv_locked(c, cmd, buf, cap, len, flags);
+        pthread_mutex_unlock(&c->rx_mu);
+        return rc;
+    }
+    for (;;) {
+        struct kc_wire_hdr h;
+        int rfd = -1;
+        ssize_t n = recv_frame(c->fd, &h, buf, cap, flags, &rfd);
+        if (n >= 0 && ntohs(h.cmd) == KCORO_CMD_REGION) { (void)region_accept(c, buf, (size_t)n, rfd); continue; }
+        if (rfd >= 0) close(rfd);
+        if (n < 0) return (int)n;
+        *cmd = ntohs(h.cmd); *len = (size_t)n;
+        return 0;
+    }
+}
+
+int kc_ipc_recv_into(kc_ipc_conn_t *c, uint16_t *cmd, void *buf, size_t cap, size_t *len)
+{
+    return recv_into(c, cmd, buf, cap, len, 0);
+}
+
+int kc_ipc_recv_nb_into(kc_ipc_conn_t *c, uint16_t *cmd, void *buf, size_t cap, size_t *len)
+{
+    return recv_into(c, cmd, buf, cap, len, MSG_DONTWAIT);
+}
+
+/* Copy one frame in behind those already staged. On a shared-memory
+ * connection with nothing staged the frame goes straight into the ring, and
+ * only the doorbell waits for the flush. Called with c->mu held. */
+static int stage_locked_v(kc_ipc_conn_t *c, uint16_t cmd, const struct iovec *iov, int n, size_t len)
+{
+    if (len > kc_ipc_conn_max_frame(c)) return -EMSGSIZE;
+    if (c->shm_on && c->tx_count == 0) {
+        int rc = kc_shm_putv(&c->shm, cmd, iov, n, len);
+        if (rc == 0) { c->tx_dirty = 1; return 0; }
+        if (rc != -EAGAIN) return rc;
+    }
+    if (c->tx_count == KCORO_IPC_TXQ) return -ENOBUFS;
+    struct kc_txf *f = &c->txq[(c->tx_head + c->tx_count) % KCORO_IPC_TXQ];
+    if (len > f->cap) {
+        uint8_t *nb = realloc(f->buf, len);
+        if (!nb) return -ENOMEM;
+        f->buf = nb; f->cap = len;
+    }
+    size_t at = 0;
+    for (int i = 0; i < n; i++) {
+        if (!iov[i].iov_len) continue;
+        memcpy(f->buf + at, iov[i].iov_base, iov[i].iov_len);
+        at += iov[i].iov_len;
+    }
+    f->hdr.cmd = htons(cmd); f->hdr.rsvd = 0; f->hdr.len = htonl((uint32_t)len);
+    f->len = len;
+    c->tx_count++;
+    return 0;
+}
+
+static int stage_locked(kc_ipc_conn_t *c, uint16_t cmd, const void *payload, size_t len)
+{
+    if (len && !payload) return -EINVAL;
+    struct iovec one = { (void*)payload, len };
+    return stage_locked_v(c, cmd, &one, 1, len);
+}
+
+/* Hand staged frames to the kernel, oldest first, as many per call as it
+ * takes. Returns how many went out, or a negative errno. */
+static int send_staged(kc_ipc_conn_t *c)
+{
+#ifdef __linux__
+    struct iovec iov[KCORO_IPC_TXQ][2];
+    struct mmsghdr mm[KCORO_IPC_TXQ];
+    unsigned n = c->tx_count;
+    memset(mm, 0, sizeof(mm[0]) * n);
+    for (unsigned i = 0; i < n; i++) {
+        struct kc_txf *f = &c->txq[(c->tx_head + i) % KCORO_IPC_TXQ];
+        iov[i][0].iov_base = &f->hdr; iov[i][0].iov_len = sizeof(f->hdr);
+        iov[i][1].iov_base = f->buf;  iov[i][1].iov_len = f->len;
+        mm[i].msg_hdr.msg_iov = iov[i];
+        mm[i].msg_hdr.msg_iovlen = f->len ? 2 : 1;
+    }
+    int sent = sendmmsg(c->fd, mm, n, 0);
+    return sent < 0 ? -errno : sent;
+#else
+    struct kc_txf *f = &c->txq[c->tx_head];
+    return send_frame(c->fd, &f->hdr, f->buf, f->len) < 0 ? -errno : 1;
+#endif
+}
+
+/* Move staged frames into the ring, then ring the peer if it waits. Past a
+ * full ring, arms tx_wait so the peer's next release rings space_fd. */
+static int shm_flush_locked(kc_ipc_conn_t *c)
+{
+    int rc = 0;
+    while (c->tx_count) {
+        struct kc_txf *f = &c->txq[c->tx_head];
+        rc = kc_shm_put(&c->shm, ntohs(f->hdr.cmd), f->buf, f->len);
+        if (rc == -EAGAIN) {
+            if (kc_shm_arm_tx(&c->shm, f->len)) continue;
+            break;
+        }
+        if (rc != 0) { c->tx_head = c->tx_count = 0; break; }
+        c->tx_head = (c->tx_head + 1) % KCORO_IPC_TXQ;
+        c->tx_count--;
+        c->tx_dirty = 1;
+    }
+    if (c->tx_dirty && kc_shm_claim_rx_wake(&c->shm)) ring_bell(c->fd);
+    c->tx_dirty = 0;
+    return rc;
+}
+
+/* 0 once nothing is staged, -EAGAIN while frames remain. Any other error
+ * drops the staged frames: the link is gone. Called with c->mu held. */
+static int flush_locked(kc_ipc_conn_t *c)
+{
+    if (c->shm_on) return shm_flush_locked(c);
+    if (c->stream) return stream_flush_locked(c);
+    while (c->tx_count) {
+        int sent = send_staged(c);
+        if (sent == -EINTR) continue;
+        if (sent == -EAGAIN || sent == -EWOULDBLOCK) return -EAGAIN;
+        if (sent < 0) { c->tx_head = c->tx_count = 0; return sent; }
+        c->tx_head = (c->tx_head + (unsigned)sent) % KCORO_IPC_TXQ;
+        c->tx_count -= (unsigned)sent;
+    }
+    return 0;
+}
+
+int kc_ipc_flush(kc_ipc_conn_t *c)
+{
+    if (!c) return -EINVAL;
+    pthread_mutex_lock(&c->mu);
+    int rc = flush_locked(c);
+    pthread_mutex_unlock(&c->mu);
+    if (rc == 0) kc_dbg("conn%p flush done", (void*)c);
+    return rc;
+}
+
+int kc_ipc_queue(kc_ipc_conn_t *c, uint16_t cmd, const void *payload, size_t len)
+{
+    if (!c) return -EINVAL;
+    pthread_mutex_lock(&c->mu);
+    int rc = stage_locked(c, cmd, payload, len);
+    pthread_mutex_unlock(&c->mu);
+    return rc;
+}
+
+int kc_ipc_send_nb(kc_ipc_conn_t *c, uint16_t cmd, const void *payload, size_t len)
+{
+    if (!c) return -EINVAL;
+    pthread_mutex_lock(&c->mu);
+    int rc = stage_locked(c, cmd, payload, len);
+    if (rc == -ENOBUFS) {
+        /* Full: make room by flushing what is already staged. */
+        rc = flush_locked(c);
+        if (rc == 0) rc = stage_locked(c, cmd, payload, len);
+        else if (rc == -EAGAIN) rc = -ENOBUFS;
+    }
+    if (rc == 0) rc = flush_locked(c);
+    pthread_mutex_unlock(&c->mu);
+    kc_dbg("conn%p send_nb cmd=%u len=%zu rc=%d", (void*)c, cmd, len, rc);
+    return rc;
+}
+
 int kc_tlv_put_u32(uint8_t **cursor, uint8_t *end, uint16_t type, uint32_t v)
 {
     if (!cursor || !*cursor) return -EINVAL;
@@ -350,36 +1204,230 @@ int kc_tlv_put_u64(uint8_t **cursor, uint8_t *end, uint16_t type, uint64_t v)
     *cursor = p+12; return 0;
 }
 
-/* Simple HELLO handshake using KCORO_CMD_HELLO with ABI in TLVs */
-static int send_hello(kc_ipc_conn_t *c, uint32_t major, uint32_t minor)
+int kc_tlv_put_bytes(uint8_t **cursor, uint8_t *end, uint16_t type, const void *v, size_t len)
+{
+    if (!cursor || !*cursor || (len && !v)) return -EINVAL;
+    uint8_t *p = *cursor;
+    int ext = len >= KC_TLV_LEN_EXT;
+    size_t hdr = ext ? 8 : 4;
+    if (len > UINT32_MAX || (size_t)(end - p) < hdr || (size_t)(end - p) - hdr < len) return -EMSGSIZE;
+    uint16_t t = htons(type), l = htons(ext ? KC_TLV_LEN_EXT : (uint16_t)len);
+    memcpy(p, &t, 2); memcpy(p+2, &l, 2);
+    if (ext) { uint32_t xl = htonl((uint32_t)len); memcpy(p+4, &xl, 4); }
+    if (len) memcpy(p + hdr, v, len);
+    *cursor = p + hdr + len; return 0;
+}
+
+int kc_tlv_next(const uint8_t *p, size_t n, size_t *off, uint16_t *type,
+                const uint8_t **val, size_t *vlen)
+{
+    size_t o = *off;
+    if (o + 4 > n) return 0;
+    uint16_t t, l; memcpy(&t, p+o, 2); memcpy(&l, p+o+2, 2); o += 4;
+    size_t len = ntohs(l);
+    if (len == KC_TLV_LEN_EXT) {
+        if (o + 4 > n) return 0;
+        uint32_t xl; memcpy(&xl, p+o, 4); o += 4;
+        len = ntohl(xl);
+    }
+    if (len > n - o) return 0;
+    *type = ntohs(t); *val = p + o; *vlen = len;
+    *off = o + len;
+    return 1;
+}
+
+uint64_t kc_tlv_val_u64(const uint8_t *val)
+{
+    uint64_t x; memcpy(&x, val, 8);
+    return kc_htobe64(x); /* a byte swap either way */
+}
+
+/* HELLO handshake: KCORO_CMD_HELLO with ABI (and capabilities) in TLVs. A
+ * server reply accepting KCORO_CAP_SHM carries the ring mapping and its end
+ * of the doorbell socketpair as SCM_RIGHTS. */
+#define HELLO_FDS 2
+
+/* One socket record carrying nfds descriptors as SCM_RIGHTS. */
+static int send_fds(kc_ipc_conn_t *c, uint16_t cmd, const uint8_t *buf, size_t len,
+                    const int *fds, int nfds)
+{
+    if (c->stream) return nfds > 0 ? -ENOTSUP : stream_send(c, cmd, buf, len);
+    struct kc_wire_hdr h = { .cmd = htons(cmd), .rsvd = 0, .len = htonl((uint32_t)len) };
+    struct iovec iov[2] = { { &h, sizeof(h) }, { (void*)buf, len } };
+    union { struct cmsghdr h; char b[CMSG_SPACE(HELLO_FDS * sizeof(int))]; } ctl;
+    struct msghdr mh;
+    memset(&mh, 0, sizeof(mh));
+    mh.msg_iov = iov; mh.msg_iovlen = 2;
+    if (nfds > 0) {
+        memset(&ctl, 0, sizeof(ctl));
+        mh.msg_control = ctl.b;
+        mh.msg_controllen = CMSG_SPACE((size_t)nfds * sizeof(int));
+        struct cmsghdr *cm = CMSG_FIRSTHDR(&mh);
+        cm->cmsg_level = SOL_SOCKET;
+        cm->cmsg_type = SCM_RIGHTS;
+        cm->cmsg_len = CMSG_LEN((size_t)nfds * sizeof(int));
+        memcpy(CMSG_DATA(cm), fds, (size_t)nfds * sizeof(int));
+    }
+    for (;;) {
+        if (sendmsg(c->fd, &mh, KC_MSG_NOSIGNAL) >= 0) return 0;
+        if (errno == EINTR) continue;
+        if (errno != EAGAIN && errno != EWOULDBLOCK) return -errno;
+        int rc = kc_await_writable(c->fd, -1); /* non-blocking connection */
+        if (rc != 0) return rc;
+    }
+}
+
+static int send_hello(kc_ipc_conn_t *c, uint32_t caps, const int *fds, int nfds)
 {
     uint8_t buf[32]; uint8_t *cur = buf, *end = buf + sizeof(buf);
-    if (kc_tlv_put_u32(&cur, end, KCORO_ATTR_ABI_MAJOR, major)) return -EMSGSIZE;
-    if (kc_tlv_put_u32(&cur, end, KCORO_ATTR_ABI_MINOR, minor)) return -EMSGSIZE;
-    return kc_ipc_send(c, KCORO_CMD_HELLO, buf, (size_t)(cur - buf));
+    if (kc_tlv_put_u32(&cur, end, KCORO_ATTR_ABI_MAJOR, KCORO_PROTO_ABI_MAJOR)) return -EMSGSIZE;
+    if (kc_tlv_put_u32(&cur, end, KCORO_ATTR_ABI_MINOR, KCORO_PROTO_ABI_MINOR)) return -EMSGSIZE;
+    if (caps && kc_tlv_put_u32(&cur, end, KCORO_ATTR_CAPS, caps)) return -EMSGSIZE;
+    return send_fds(c, KCORO_CMD_HELLO, buf, (size_t)(cur - buf), fds, nfds);
 }
 
-static int parse_hello(const uint8_t *p, size_t n, uint32_t *maj, uint32_t *min)
+static int parse_hello(const uint8_t *p, size_t n, uint32_t *maj, uint32_t *min, uint32_t *caps)
 {
-    size_t off = 0; *maj = *min = 0;
-    while (off + 4 <= n) {
-        uint16_t t, l; memcpy(&t, p+off, 2); memcpy(&l, p+off+2, 2); t = ntohs(t); l = ntohs(l); off += 4;
-        if (off + l > n) return -EMSGSIZE;
-        if (t == KCORO_ATTR_ABI_MAJOR && l == 4) { uint32_t v; memcpy(&v, p+off, 4); *maj = ntohl(v); }
-        else if (t == KCORO_ATTR_ABI_MINOR && l == 4) { uint32_t v; memcpy(&v, p+off, 4); *min = ntohl(v); }
-        off += l;
+    size_t off = 0; uint16_t t; const uint8_t *v; size_t l;
+    *maj = *min = *caps = 0;
+    while (kc_tlv_next(p, n, &off, &t, &v, &l)) {
+        if (l != 4) continue;
+        uint32_t x; memcpy(&x, v, 4); x = ntohl(x);
+        if (t == KCORO_ATTR_ABI_MAJOR) *maj = x;
+        else if (t == KCORO_ATTR_ABI_MINOR) *min = x;
+        else if (t == KCORO_ATTR_CAPS) *caps = x;
     }
     return (*maj || *min) ? 0 : -EINVAL;
 }
 
+/* The server's HELLO, with any descriptors it carries (-1 when absent). */
+static int recv_hello(kc_ipc_conn_t *c, uint8_t *buf, size_t cap, size_t *len, int fds[HELLO_FDS])
+{
+    struct kc_wire_hdr h;
+    struct iovec iov[2] = { { &h, sizeof(h) }, { buf, cap } };
+    union { struct cmsghdr h; char b[CMSG_SPACE(HELLO_FDS * sizeof(int))]; } ctl;
+    struct msghdr mh;
+    int flags = 0;
+#ifdef MSG_CMSG_CLOEXEC
+    flags |= MSG_CMSG_CLOEXEC;
+#endif
+    for (int i = 0; i < HELLO_FDS; i++) fds[i] = -1;
+    if (c->stream) {
+        uint16_t cmd = 0;
+        int rc;
+        while ((rc = recv_into(c, &cmd, buf, cap, len, 0)) == -EAGAIN)
+            if ((rc = kc_await_readable(c->fd, -1)) != 0) return rc; /* non-blocking connection */
+        return rc != 0 ? rc : cmd != KCORO_CMD_HELLO ? -EPROTO : 0;
+    }
+    ssize_t n;
+    for (;;) {
+        memset(&mh, 0, sizeof(mh));
+        mh.msg_iov = iov; mh.msg_iovlen = 2;
+        mh.msg_control = ctl.b; mh.msg_controllen = sizeof(ctl.b);
+        n = recvmsg(c->fd, &mh, flags);
+        if (n >= 0) break;
+        if (errno == EINTR) continue;
+        if (errno != EAGAIN && errno != EWOULDBLOCK) return -errno;
+        int rc = kc_await_readable(c->fd, -1); /* non-blocking connection */
+        if (rc != 0) return rc;
+    }
+    int got = 0;
+    for (struct cmsghdr *cm = CMSG_FIRSTHDR(&mh); cm; cm = CMSG_NXTHDR(&mh, cm)) {
+        if (cm->cmsg_level != SOL_SOCKET || cm->cmsg_type != SCM_RIGHTS) continue;
+        size_t k = (cm->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        for (size_t i = 0; i < k; i++) {
+            int fd; memcpy(&fd, CMSG_DATA(cm) + i * sizeof(int), sizeof(int));
+            if (got < HELLO_FDS) fds[got++] = fd; else close(fd);
+        }
+    }
+    int rc = 0;
+    if (n == 0) rc = -ECONNRESET;
+    else if ((size_t)n < sizeof(h) || ntohs(h.cmd) != KCORO_CMD_HELLO) rc = -EPROTO;
+    else if ((mh.msg_flags & (MSG_TRUNC | MSG_CTRUNC)) || ntohl(h.len) != (size_t)n - sizeof(h)) rc = -EPROTO;
+    if (rc != 0) {
+        for (int i = 0; i < got; i++) close(fds[i]);
+        return rc;
+    }
+    *len = (size_t)n - sizeof(h);
+    return 0;
+}
+
+static int set_fd_nb(int fd)
+{
+    int fl = fcntl(fd, F_GETFL, 0);
+    return (fl < 0 || fcntl(fd, F_SETFL, fl | O_NONBLOCK) < 0) ? -errno : 0;
+}
+
 int kc_ipc_hs_cli(kc_ipc_conn_t *c, uint32_t *peer_major, uint32_t *peer_minor)
 {
     if (!c || !peer_major || !peer_minor) return -EINVAL;
-    int rc = send_hello(c, KCORO_PROTO_ABI_MAJOR, KCORO_PROTO_ABI_MINOR); if (rc) return rc;
-    uint16_t cmd; uint8_t *pl = NULL; size_t n = 0;
-    rc = kc_ipc_recv(c, &cmd, &pl, &n); if (rc) return rc;
-    if (cmd != KCORO_CMD_HELLO) { free(pl); return -EPROTO; }
-    rc = parse_hello(pl, n, peer_major, peer_minor); free(pl); kc_dbg("conn%p hs_cli ok peer=%u.%u", (void*)c, *peer_major, *peer_minor); return rc;
+    uint32_t offer = c->stream ? (KCORO_IPC_LZ4 ? KCORO_CAP_LZ4 : 0) : (KCORO_IPC_SHM ? KCORO_CAP_SHM : 0);
+    if (KCORO_IPC_FIXED) offer |= KCORO_CAP_FIXED;
+    int rc = send_hello(c, offer, NULL, 0); if (rc) return rc;
+    uint8_t buf[64]; size_t n = 0; int fds[HELLO_FDS];
+    rc = recv_hello(c, buf, sizeof(buf), &n, fds); if (rc) return rc;
+    uint32_t caps = 0;
+    rc = parse_hello(buf, n, peer_major, peer_minor, &caps);
+    if (rc == 0 && (caps & KCORO_CAP_SHM)) {
+        /* The server switched to the rings already: using them is not optional. */
+        if (fds[0] < 0 || fds[1] < 0) rc = -EPROTO;
+        if (rc == 0) rc = kc_shm_map(fds[0], 0, &c->shm);
+        if (rc == 0 && (rc = set_fd_nb(fds[1])) != 0) kc_shm_unmap(&c->shm);
+        if (rc == 0) { c->space_fd = fds[1]; fds[1] = -1; c->shm_on = 1; }
+    }
+    if (rc == 0 && (caps & offer & KCORO_CAP_LZ4)) c->lz4 = 1;
+    if (rc == 0 && (caps & offer & KCORO_CAP_FIXED)) c->fixed = 1;
+    for (int i = 0; i < HELLO_FDS; i++) if (fds[i] >= 0) close(fds[i]);
+    kc_dbg("conn%p hs_cli rc=%d peer=%u.%u shm=%d lz4=%d fixed=%d", (void*)c, rc, *peer_major, *peer_minor,
+           c->shm_on, c->lz4, c->fixed);
+    return rc;
+}
+
+/* Set up the rings for c; on success fds[] are the peer's descriptors. */
+static int shm_offer(kc_ipc_conn_t *c, int fds[HELLO_FDS])
+{
+    int mfd = -1, sp[2];
+    int rc = kc_shm_create(KCORO_IPC_SHM_RING, &mfd);
+    if (rc != 0) return rc;
+    if ((rc = kc_shm_map(mfd, 1, &c->shm)) != 0) { close(mfd); return rc; }
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sp) != 0) {
+        rc = -errno;
+        kc_shm_unmap(&c->shm); close(mfd);
+        return rc;
+    }
+    (void)fcntl(sp[0], F_SETFD, FD_CLOEXEC);
+    if ((rc = set_fd_nb(sp[0])) != 0) {
+        close(sp[0]); close(sp[1]); kc_shm_unmap(&c->shm); close(mfd);
+        return rc;
+    }
+    c->space_fd = sp[0];
+    fds[0] = mfd; fds[1] = sp[1];
+    return 0;
+}
+
+int kc_ipc_hs_answer(kc_ipc_conn_t *c, const uint8_t *hello, size_t n,
+                     uint32_t *peer_major, uint32_t *peer_minor)
+{
+    if (!c || (n && !hello) || !peer_major || !peer_minor) return -EINVAL;
+    uint32_t caps = 0;
+    int rc = parse_hello(hello, n, peer_major, peer_minor, &caps); if (rc) return rc;
+    int fds[HELLO_FDS] = { -1, -1 };
+    /* Falls back to the socket when the rings cannot be set up. */
+    int shm = KCORO_IPC_SHM && !c->stream && (caps & KCORO_CAP_SHM) && shm_offer(c, fds) == 0;
+    int lz4 = KCORO_IPC_LZ4 && c->stream && (caps & KCORO_CAP_LZ4);
+    int fixed = KCORO_IPC_FIXED && (caps & KCORO_CAP_FIXED);
+    rc = send_hello(c, (shm ? KCORO_CAP_SHM : 0) | (lz4 ? KCORO_CAP_LZ4 : 0) | (fixed ? KCORO_CAP_FIXED : 0),
+                    fds, shm ? HELLO_FDS : 0);
+    if (rc == 0 && lz4) c->lz4 = 1; /* the HELLO itself went out plain */
+    if (rc == 0 && fixed) c->fixed = 1;
+    if (shm) {
+        close(fds[0]); close(fds[1]); /* the peer holds its own copies now */
+        if (rc == 0) c->shm_on = 1;
+        else { close(c->space_fd); c->space_fd = -1; kc_shm_unmap(&c->shm); }
+    }
+    kc_dbg("conn%p hs_srv rc=%d peer=%u.%u shm=%d lz4=%d fixed=%d", (void*)c, rc, *peer_major, *peer_minor,
+           c->shm_on, c->lz4, c->fixed);
+    return rc;
 }
 
 int kc_ipc_hs_srv(kc_ipc_conn_t *c, uint32_t *peer_major, uint32_t *peer_minor)
@@ -388,7 +1436,78 @@ int kc_ipc_hs_srv(kc_ipc_conn_t *c, uint32_t *peer_major, uint32_t *peer_minor)
     uint16_t cmd; uint8_t *pl = NULL; size_t n = 0;
     int rc = kc_ipc_recv(c, &cmd, &pl, &n); if (rc) return rc;
     if (cmd != KCORO_CMD_HELLO) { free(pl); return -EPROTO; }
-    rc = parse_hello(pl, n, peer_major, peer_minor); free(pl); if (rc) return rc;
-    kc_dbg("conn%p hs_srv peer=%u.%u", (void*)c, *peer_major, *peer_minor);
-    return send_hello(c, KCORO_PROTO_ABI_MAJOR, KCORO_PROTO_ABI_MINOR);
+    rc = kc_ipc_hs_answer(c, pl, n, peer_major, peer_minor);
+    free(pl);
+    return rc;
+}
+
+/* ---- Shared regions ---- */
+
+/* A REGION announcement: map the descriptor that came with it. A region
+ * that cannot be mapped is dropped; descriptors naming it then fail to
+ * resolve. Takes fd. */
+static int region_accept(kc_ipc_conn_t *c, const uint8_t *p, size_t n, int fd)
+{
+    uint64_t id = 0, len = 0;
+    size_t off = 0, l; uint16_t t; const uint8_t *v;
+    while (kc_tlv_next(p, n, &off, &t, &v, &l)) {
+        if (l != 8) continue;
+        if (t == KCORO_ATTR_REGION_ID) id = kc_tlv_val_u64(v);
+        else if (t == KCORO_ATTR_REGION_LEN) len = kc_tlv_val_u64(v);
+    }
+    int rc = (fd < 0 || id == 0 || len == 0 || (uint64_t)(size_t)len != len) ? -EPROTO : 0;
+    pthread_mutex_lock(&c->rg_mu);
+    for (unsigned i = 0; rc == 0 && i < c->n_in; i++)
+        if (c->rg_in[i].peer_id == id) rc = -EEXIST;
+    if (rc == 0 && c->n_in == KCORO_IPC_REGIONS) rc = -ENOSPC;
+    kc_region_t *reg = NULL;
+    if (rc == 0 && (rc = kc_region_import(&reg, fd, (size_t)len)) == 0) {
+        c->rg_in[c->n_in].peer_id = id;
+        c->rg_in[c->n_in].reg = reg;
+        c->n_in++;
+        fd = -1;
+    }
+    pthread_mutex_unlock(&c->rg_mu);
+    if (fd >= 0) close(fd);
+    kc_dbg("conn%p region in id=%llu len=%llu rc=%d", (void*)c, (unsigned long long)id,
+           (unsigned long long)len, rc);
+    return rc;
+}
+
+int kc_ipc_region_export(kc_ipc_conn_t *c, kc_region_t *reg)
+{
+    if (!c || !reg) return -EINVAL;
+    int fd = kc_region_fd(reg);
+    if (fd < 0) return fd;
+    unsigned long id = 0; size_t len = 0;
+    (void)kc_region_export_id(reg, &id);
+    (void)kc_region_addr(reg, &len);
+    int rc = 0;
+    pthread_mutex_lock(&c->ex_mu);
+    for (unsigned i = 0; i < c->n_out; i++)
+        if (c->rg_out[i] == id) goto out; /* the peer has it */
+    if (c->n_out == KCORO_IPC_REGIONS) { rc = -ENOSPC; goto out; }
+    uint8_t buf[24]; uint8_t *cur = buf, *end = buf + sizeof(buf);
+    (void)kc_tlv_put_u64(&cur, end, KCORO_ATTR_REGION_ID, id);
+    (void)kc_tlv_put_u64(&cur, end, KCORO_ATTR_REGION_LEN, len);
+    rc = send_fds(c, KCORO_CMD_REGION, buf, (size_t)(cur - buf), &fd, 1);
+    /* Rings: the copy in the ring tells the peer when to collect it. */
+    if (rc == 0 && c->shm_on) rc = shm_send(c, KCORO_CMD_REGION, buf, (size_t)(cur - buf));
+    if (rc == 0) c->rg_out[c->n_out++] = id;
+out:
+    pthread_mutex_unlock(&c->ex_mu);
+    kc_dbg("conn%p region out id=%lu rc=%d", (void*)c, id, rc);
+    return rc;
+}
+
+int kc_ipc_region_lookup(kc_ipc_conn_t *c, uint64_t peer_id, kc_region_t **out)
+{
+    if (!c || !out) return -EINVAL;
+    int rc = -ENOENT;
+    pthread_mutex_lock(&c->rg_mu);
+    for (unsigned i = 0; i < c->n_in; i++) {
+        if (c->rg_in[i].peer_id == peer_id) { *out = c->rg_in[i].reg; rc = 0; break; }
+    }
+    pthread_mutex_unlock(&c->rg_mu);
+    return rc;
 }
@@ -6,26 +6,72 @@
  * Role
  * - Receives channel RPC frames over a POSIX socket connection, decodes TLV
  *   payloads, invokes the corresponding local channel operation, and replies.
- * - Maintains a registry of local channels (chan_id → kc_chan_t*).
+ * - Maintains a registry of local channels (chan_id → kc_chan_t*): a slot
+ *   array indexed by the ID, grown in chunks that never move, so lookups are
+ *   two acquire loads and take no lock. Registration serializes on ctx->mu.
+ *   Entries are never retired (CHAN_DESTROY only closes), so an ID is never
+ *   reused for another channel within a context.
  * - Echoes `req_id` in responses (when present) for client correlation.
+ * - Send, receive and the batch commands may arrive in the fixed layout
+ *   (KCORO_CMD_FIXED, struct kcoro_fixed_hdr) instead of TLV; srv_decode
+ *   reads either form into one srv_op_t and the reply keeps the request's.
  *
- * Notes
- * - The coroutine‑native variant replaces the condvar bridges with park/unpark
- *   while preserving exact error semantics (EAGAIN/ETIME/ECANCELED/EPIPE).
+ * Coroutine‑native serving (kc_ipc_server_serve)
+ * - One reader coroutine per connection takes frames with
+ *   kc_ipc_recv_nb_into into its own buffer, parking in kc_await_readable,
+ *   and runs each op directly. A send/recv that would park moves to a
+ *   request coroutine of its own, so the frames behind it keep flowing (at
+ *   most KCORO_IPC_PIPELINE in flight). Replies can then
+ *   leave out of order; clients match them by `req_id`.
+ * - Replies go through a channel to one writer coroutine per connection,
+ *   the only one that touches the socket's send side; it stages all replies
+ *   queued so far and flushes them together.
+ * - The handshake is answered in line and may move the connection onto
+ *   shared-memory rings (kc_ipc_hs_answer); the reader and writer then run
+ *   unchanged, and the reader's buffer grows to the larger frame limit.
+ * - When the peer hangs up, a cancel token aborts the ops still parked for
+ *   it; the last of reader and writer closes the connection. Each parked
+ *   request with a `req_id` waits under a child token of its own, which
+ *   CHAN_CANCEL triggers (a remote select clause that lost).
+ *
+ * Descriptor channels (CHAN_MAKE with element size 0) queue (ptr, len)
+ * descriptors into shared regions the clients exported over their
+ * connections. SEND_DESC resolves the client's region ID to the server's
+ * mapping; RECV_DESC exports the region to the receiving connection before
+ * replying with its ID there. Payload bytes never pass through the server.
+ * Served connections only (kc_ipc_server_serve).
+ *
+ * Batches (CHAN_SEND_BATCH/RECV_BATCH) move a frame's worth of elements per
+ * request through kc_chan_send_many/recv_many, one lock pass per run. Where
+ * they must wait they wait for one element through the cancellable calls,
+ * then go on in bulk. Served connections only.
+ *
+ * Thread callers (kc_ipc_handle_command off a scheduler) keep a bridge: the
+ * op runs in a coroutine on the default scheduler while the thread waits on
+ * a condvar. Error semantics (EAGAIN/ETIME/ECANCELED/EPIPE) match either way.
  */
+#define _POSIX_C_SOURCE 200809L /* clock_gettime */
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
 #include <stdio.h>
+#include <time.h>
 #include <arpa/inet.h>
+#include <sys/socket.h>
 #include <pthread.h>
+#include <stdatomic.h>
 
 #include "../include/kcoro_ipc_posix.h"
+#include "../include/kcoro_ipc_server.h"
 #include "../../../include/kcoro.h"
+#include "../../../include/kcoro_zcopy.h"
+#include "../../../include/kcoro_core.h"
 #include "../../../include/kcoro_sched.h"
+#include "../../../include/kcoro_config.h"
+#include "../../../include/kcoro_port.h"
 
-/* Small helpers to run channel ops inside coroutine context */
-struct kc_send_task { kc_chan_t* ch; void* elem; long tmo; int rc; pthread_mutex_t mu; pthread_cond_t cv; int done; };
+/* Thread-caller bridge: run a channel op inside coroutine context */
+struct kc_send_task { kc_chan_t* ch; const void* elem; long tmo; int rc; pthread_mutex_t mu; pthread_cond_t cv; int done; };
 struct kc_recv_task { kc_chan_t* ch; void* elem; long tmo; int rc; pthread_mutex_t mu; pthread_cond_t cv; int done; };
 
 static void kc_ipc_send_co(void* arg)
@@ -49,72 +95,412 @@ struct kc_chan_entry {
     kc_chan_t *chan;
     int kind;
     size_t elem_sz;
-    struct kc_chan_entry *next;
+    size_t capacity;                 /* KC_BUFFERED: bound for send credits */
+    int borrowed;                    /* kc_ipc_server_export: never closed or destroyed here */
+};
+
+/* Registry: chunk i holds IDs SRV_ID_BASE + i * SRV_REG_CHUNK onwards. */
+#define SRV_ID_BASE    1001u
+#define SRV_REG_CHUNK  1024u
+#define SRV_REG_CHUNKS 4096u  /* 4M channels per context */
+
+struct srv_reg_chunk {
+    _Atomic(struct kc_chan_entry*) slot[SRV_REG_CHUNK];
 };
 
 /* Server context */
 typedef struct kc_ipc_server_ctx {
-    struct kc_chan_entry *channels;  /* Channel registry */
-    uint32_t next_chan_id;           /* Next channel ID to assign */
+    _Atomic(struct srv_reg_chunk*) chunk[SRV_REG_CHUNKS];
+    uint32_t nslots;                 /* slots handed out; under mu */
+    pthread_mutex_t mu;              /* registration: connections run concurrently */
 } kc_ipc_server_ctx_t;
 
+/* Coroutine-native connection state (kc_ipc_server_serve). */
+typedef struct srv_frame {
+    uint16_t cmd;
+    size_t off;           /* the frame starts at data + off */
+    size_t len;
+    uint8_t data[];
+} srv_frame_t;
+
+typedef struct srv_conn {
+    kc_ipc_server_ctx_t *ctx;
+    kc_ipc_conn_t *conn;
+    kc_chan_t *replies;   /* srv_frame_t* to the writer; NULL ends it */
+    kc_chan_t *slots;     /* KCORO_IPC_PIPELINE request tokens */
+    kc_cancel_t *cancel;  /* triggered on hang-up */
+    _Atomic(int) refs;    /* reader + writer + request coroutines */
+    int werr;             /* writer's first send error */
+    uint8_t *rxbuf;       /* reader's frame buffer */
+    size_t rxcap;         /* kc_ipc_conn_max_frame(conn) */
+    /* Parked requests by slot token, for CHAN_CANCEL: each has a token of
+     * its own under cancel. Entries change under pmu. */
+    pthread_mutex_t pmu;
+    struct srv_parked {
+        uint32_t req_id;      /* 0: free, or the request carried none */
+        kc_cancel_ctx_t cc;
+    } parked[KCORO_IPC_PIPELINE];
+} srv_conn_t;
+
+/* Handler result: the op would park; run it from a request coroutine. */
+#define SRV_WOULD_PARK 1
+
 /* Parse TLV attributes from payload */
 static int parse_tlv_u32(const uint8_t *payload, size_t len, uint16_t attr_type, uint32_t *out)
 {
-    size_t off = 0;
-    while (off + 4 <= len) {
-        uint16_t t, l;
-        memcpy(&t, payload + off, 2);
-        memcpy(&l, payload + off + 2, 2);
-        t = ntohs(t);
-        l = ntohs(l);
-        off += 4;
-        
-        if (off + l > len) break;
+    size_t off = 0, l;
+    uint16_t t;
+    const uint8_t *v;
+    while (kc_tlv_next(payload, len, &off, &t, &v, &l)) {
         if (t == attr_type && l == 4) {
-            uint32_t v;
-            memcpy(&v, payload + off, 4);
-            *out = ntohl(v);
+            uint32_t x;
+            memcpy(&x, v, 4);
+            *out = ntohl(x);
             return 0;
         }
-        off += l;
     }
     return -1;
 }
 
-/* Parse element data from TLV */
-static int parse_tlv_element(const uint8_t *payload, size_t len, void *out, size_t elem_sz)
-{
-    size_t off = 0;
-    while (off + 4 <= len) {
-        uint16_t t, l;
-        memcpy(&t, payload + off, 2);
-        memcpy(&l, payload + off + 2, 2);
-        t = ntohs(t);
-        l = ntohs(l);
-        off += 4;
-        
-        if (off + l > len) break;
-        if (t == KCORO_ATTR_ELEMENT && l == elem_sz) {
-            memcpy(out, payload + off, elem_sz);
+static int parse_tlv_u64(const uint8_t *payload, size_t len, uint16_t attr_type, uint64_t *out)
+{
+    size_t off = 0, l;
+    uint16_t t;
+    const uint8_t *v;
+    while (kc_tlv_next(payload, len, &off, &t, &v, &l)) {
+        if (t == attr_type && l == 8) {
+            *out = kc_tlv_val_u64(v);
             return 0;
         }
-        off += l;
     }
     return -1;
 }
 
-/* Find channel by ID */
+/* A send, recv or batch request, decoded once from either form. */
+typedef struct srv_op {
+    uint32_t chan_id, req_id, timeout_ms;
+    uint32_t count;           /* COUNT (batches) */
+    uint32_t want;            /* CREDIT wanted (CHAN_SEND) */
+    int has_chan, has_count, credited, fixed;
+    const uint8_t *data;      /* ELEMENT or ELEMENTS, in place */
+    size_t dlen;
+} srv_op_t;
+
+/* Fixed layout: one header load. TLV: one pass over the attributes. A
+ * fixed payload too short for its header or its len is -EINVAL (with
+ * whatever of the header could be read). */
+static int srv_decode(uint16_t cmd, const uint8_t *payload, size_t len, srv_op_t *op)
+{
+    memset(op, 0, sizeof(*op));
+    if (cmd & KCORO_CMD_FIXED) {
+        struct kcoro_fixed_hdr h;
+        op->fixed = 1;
+        if (len < sizeof(h)) return -EINVAL;
+        memcpy(&h, payload, sizeof(h));
+        op->chan_id = ntohl(h.chan_id);
+        op->req_id = ntohl(h.req_id);
+        op->timeout_ms = ntohl(h.status);
+        op->count = op->want = ntohl(h.count);
+        op->credited = (ntohl(h.flags) & KCORO_FIXED_CREDITED) != 0;
+        op->has_chan = op->has_count = 1;
+        op->data = payload + sizeof(h);
+        op->dlen = len - sizeof(h);
+        return ntohl(h.len) == op->dlen ? 0 : -EINVAL;
+    }
+    size_t off = 0, l;
+    uint16_t t;
+    const uint8_t *v;
+    while (kc_tlv_next(payload, len, &off, &t, &v, &l)) {
+        if (t == KCORO_ATTR_ELEMENT || t == KCORO_ATTR_ELEMENTS) {
+            if (!op->data) { op->data = v; op->dlen = l; }
+            continue;
+        }
+        if (l != 4) continue;
+        uint32_t x;
+        memcpy(&x, v, 4);
+        x = ntohl(x);
+        switch (t) {
+        case KCORO_ATTR_CHAN_ID:    op->chan_id = x; op->has_chan = 1; break;
+        case KCORO_ATTR_REQ_ID:     op->req_id = x; break;
+        case KCORO_ATTR_TIMEOUT_MS: op->timeout_ms = x; break;
+        case KCORO_ATTR_COUNT:      op->count = x; op->has_count = 1; break;
+        case KCORO_ATTR_CREDIT:     op->want = x; break;
+        case KCORO_ATTR_CREDITED:   op->credited = x != 0; break;
+        default: break;
+        }
+    }
+    return 0;
+}
+
+/* The req_id of any request, 0 when it has none. */
+static uint32_t srv_req_id(uint16_t cmd, const uint8_t *payload, size_t len)
+{
+    uint32_t req_id = 0;
+    if (cmd & KCORO_CMD_FIXED) {
+        struct kcoro_fixed_hdr h;
+        if (len >= sizeof(h)) { memcpy(&h, payload, sizeof(h)); req_id = ntohl(h.req_id); }
+    } else {
+        (void)parse_tlv_u32(payload, len, KCORO_ATTR_REQ_ID, &req_id);
+    }
+    return req_id;
+}
+
+/* Find channel by ID, without locking */
 static struct kc_chan_entry *find_channel(kc_ipc_server_ctx_t *ctx, uint32_t chan_id)
 {
-    for (struct kc_chan_entry *e = ctx->channels; e; e = e->next) {
-        if (e->id == chan_id) return e;
+    uint32_t i = chan_id - SRV_ID_BASE; /* IDs below the base wrap past the end */
+    if (i >= SRV_REG_CHUNK * SRV_REG_CHUNKS) return NULL;
+    struct srv_reg_chunk *c = atomic_load_explicit(&ctx->chunk[i / SRV_REG_CHUNK],
+                                                   memory_order_acquire);
+    if (!c) return NULL;
+    return atomic_load_explicit(&c->slot[i % SRV_REG_CHUNK], memory_order_acquire);
+    /* entries live until the context is destroyed */
+}
+
+/* Give entry the next ID and publish it to lock-free readers. */
+static int srv_register(kc_ipc_server_ctx_t *ctx, struct kc_chan_entry *entry)
+{
+    int rc = 0;
+    pthread_mutex_lock(&ctx->mu);
+    uint32_t i = ctx->nslots;
+    struct srv_reg_chunk *c = NULL;
+    if (i >= SRV_REG_CHUNK * SRV_REG_CHUNKS) {
+        rc = -ENOSPC;
+    } else if (!(c = atomic_load_explicit(&ctx->chunk[i / SRV_REG_CHUNK], memory_order_relaxed))) {
+        if ((c = calloc(1, sizeof(*c))) != NULL)
+            atomic_store_explicit(&ctx->chunk[i / SRV_REG_CHUNK], c, memory_order_release);
+        else
+            rc = -ENOMEM;
+    }
+    if (rc == 0) {
+        entry->id = SRV_ID_BASE + i;
+        atomic_store_explicit(&c->slot[i % SRV_REG_CHUNK], entry, memory_order_release);
+        ctx->nslots = i + 1;
+    }
+    pthread_mutex_unlock(&ctx->mu);
+    return rc;
+}
+
+/* Send a reply: queued for the writer coroutine, or straight out. */
+static int srv_reply(kc_ipc_conn_t *conn, srv_conn_t *sc, uint16_t cmd, const void *buf, size_t len)
+{
+    if (!sc) return kc_ipc_send(conn, cmd, buf, len);
+    srv_frame_t *f = malloc(sizeof(*f) + len);
+    if (!f) return -ENOMEM;
+    f->cmd = cmd;
+    f->off = 0;
+    f->len = len;
+    if (len) memcpy(f->data, buf, len);
+    int rc = kc_chan_send(sc->replies, &f, -1);
+    if (rc != 0) free(f);
+    return rc;
+}
+
+/* Reply carrying the request's req_id (if any) and a result code. */
+static int srv_reply_rc(kc_ipc_conn_t *conn, srv_conn_t *sc, uint16_t cmd,
+                        const uint8_t *payload, size_t len, int rc)
+{
+    uint8_t buf[32]; uint8_t *cur = buf, *end = buf + sizeof(buf);
+    uint32_t req_id = 0; (void)parse_tlv_u32(payload, len, KCORO_ATTR_REQ_ID, &req_id);
+    if (req_id) (void)kc_tlv_put_u32(&cur, end, KCORO_ATTR_REQ_ID, req_id);
+    (void)kc_tlv_put_u32(&cur, end, KCORO_ATTR_RESULT, (uint32_t)rc);
+    return srv_reply(conn, sc, cmd, buf, (size_t)(cur - buf));
+}
+
+/* Room in front of a hot reply's data for the longest lead: a fixed header,
+ * or REQ_ID, RESULT, COUNT and a long-form data TLV header. */
+#define SRV_LEAD 40
+
+/* A reply frame with room for dlen bytes of data, which go at
+ * srv_frame_data(f); srv_frame_reply puts the lead in front of them. */
+static srv_frame_t *srv_frame_new(size_t dlen)
+{
+    return malloc(sizeof(srv_frame_t) + SRV_LEAD + dlen);
+}
+
+static uint8_t *srv_frame_data(srv_frame_t *f)
+{
+    return f->data + SRV_LEAD;
+}
+
+/* The lead of op's reply, written so that it ends at end: a fixed header
+ * when op was fixed, else REQ_ID (when op had one), RESULT, count as
+ * CREDIT (CHAN_SEND) or COUNT when nonzero, and the header of the ELEMENT
+ * (CHAN_RECV) or ELEMENTS TLV holding dlen bytes. Returns its length. */
+static size_t srv_lead(uint8_t *end, uint16_t cmd, const srv_op_t *op, int rc, uint32_t count,
+                       size_t dlen)
+{
+    if (op->fixed) {
+        struct kcoro_fixed_hdr h = { htonl(op->chan_id), htonl(op->req_id), 0, htonl((uint32_t)dlen),
+                                     htonl((uint32_t)rc), htonl(count) };
+        memcpy(end - sizeof(h), &h, sizeof(h));
+        return sizeof(h);
+    }
+    uint8_t lead[SRV_LEAD]; uint8_t *cur = lead, *lend = lead + sizeof(lead);
+    if (op->req_id) (void)kc_tlv_put_u32(&cur, lend, KCORO_ATTR_REQ_ID, op->req_id);
+    (void)kc_tlv_put_u32(&cur, lend, KCORO_ATTR_RESULT, (uint32_t)rc);
+    if (count)
+        (void)kc_tlv_put_u32(&cur, lend, cmd == KCORO_CMD_CHAN_SEND ? KCORO_ATTR_CREDIT : KCORO_ATTR_COUNT, count);
+    if (dlen) {
+        size_t hl = dlen >= KC_TLV_LEN_EXT ? 8 : 4;
+        uint16_t t = htons(cmd == KCORO_CMD_CHAN_RECV ? KCORO_ATTR_ELEMENT : KCORO_ATTR_ELEMENTS);
+        uint16_t l = htons(hl == 8 ? KC_TLV_LEN_EXT : (uint16_t)dlen);
+        memcpy(cur, &t, 2); memcpy(cur + 2, &l, 2);
+        if (hl == 8) { uint32_t xl = htonl((uint32_t)dlen); memcpy(cur + 4, &xl, 4); }
+        cur += hl;
+    }
+    size_t n = (size_t)(cur - lead);
+    memcpy(end - n, lead, n);
+    return n;
+}
+
+/* Send f, whose data (dlen bytes) is in place, as the reply to op; frees f.
+ * The reply is fixed when op was. */
+static int srv_frame_reply(kc_ipc_conn_t *conn, srv_conn_t *sc, srv_frame_t *f, uint16_t cmd,
+                           const srv_op_t *op, int rc, uint32_t count, size_t dlen)
+{
+    size_t n = srv_lead(srv_frame_data(f), cmd, op, rc, count, dlen);
+    f->cmd = op->fixed ? (uint16_t)(cmd | KCORO_CMD_FIXED) : cmd;
+    f->off = SRV_LEAD - n;
+    f->len = n + dlen;
+    if (!sc) {
+        rc = kc_ipc_send(conn, f->cmd, f->data + f->off, f->len);
+        free(f);
+        return rc;
+    }
+    rc = kc_chan_send(sc->replies, &f, -1);
+    if (rc != 0) free(f);
+    return rc;
+}
+
+/* A hot reply without data. */
+static int srv_reply_op(kc_ipc_conn_t *conn, srv_conn_t *sc, uint16_t cmd, const srv_op_t *op,
+                        int rc, uint32_t count)
+{
+    srv_frame_t *f = srv_frame_new(0);
+    if (!f) return -ENOMEM;
+    return srv_frame_reply(conn, sc, f, cmd, op, rc, count, 0);
+}
+
+static int srv_chan_send(srv_conn_t *sc, const kc_cancel_t *cancel, kc_chan_t *ch,
+                         const void *elem, long tmo)
+{
+    if (sc) return kc_chan_send_c(ch, elem, tmo, cancel);
+    struct kc_send_task st = { .ch = ch, .elem = elem, .tmo = tmo, .rc = 0, .done = 0 };
+    pthread_mutex_init(&st.mu, NULL); pthread_cond_init(&st.cv, NULL);
+    if (kc_spawn_co(kc_sched_default(), kc_ipc_send_co, &st, 0, NULL) != 0) { pthread_mutex_destroy(&st.mu); pthread_cond_destroy(&st.cv); return -ENOMEM; }
+    pthread_mutex_lock(&st.mu); while (!st.done) pthread_cond_wait(&st.cv, &st.mu); pthread_mutex_unlock(&st.mu);
+    pthread_cond_destroy(&st.cv); pthread_mutex_destroy(&st.mu);
+    return st.rc;
+}
+
+static int srv_chan_recv(srv_conn_t *sc, const kc_cancel_t *cancel, kc_chan_t *ch,
+                         void *elem, long tmo)
+{
+    if (sc) return kc_chan_recv_c(ch, elem, tmo, cancel);
+    struct kc_recv_task rt = { .ch = ch, .elem = elem, .tmo = tmo, .rc = 0, .done = 0 };
+    pthread_mutex_init(&rt.mu, NULL); pthread_cond_init(&rt.cv, NULL);
+    if (kc_spawn_co(kc_sched_default(), kc_ipc_recv_co, &rt, 0, NULL) != 0) { pthread_mutex_destroy(&rt.mu); pthread_cond_destroy(&rt.cv); return -ENOMEM; }
+    pthread_mutex_lock(&rt.mu); while (!rt.done) pthread_cond_wait(&rt.cv, &rt.mu); pthread_mutex_unlock(&rt.mu);
+    pthread_cond_destroy(&rt.cv); pthread_mutex_destroy(&rt.mu);
+    return rt.rc;
+}
+
+/* What is left of a batch's timeout after the time since t0; 0 once spent
+ * (never for tmo < 0). */
+static long srv_ms_left(long tmo, const struct timespec *t0)
+{
+    if (tmo <= 0) return tmo;
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    long spent = (long)(t.tv_sec - t0->tv_sec) * 1000L + (t.tv_nsec - t0->tv_nsec) / 1000000L;
+    return spent >= tmo ? 0 : tmo - spent;
+}
+
+/* kc_chan_send_many that waits cancellably: whenever the ring fills, one
+ * element waits in kc_chan_send_c and the rest follow in bulk. */
+static int srv_send_batch(const kc_cancel_t *cancel, kc_chan_t *ch, const uint8_t *src, size_t n,
+                          size_t esz, long tmo, size_t *sent)
+{
+    struct timespec t0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    size_t done = 0;
+    int rc = 0;
+    while (done < n) {
+        size_t k = 0;
+        rc = kc_chan_send_many(ch, src + done * esz, n - done, 0, &k);
+        done += k;
+        if (rc != KC_EAGAIN || tmo == 0) break;
+        long left = srv_ms_left(tmo, &t0);
+        if (left == 0) { rc = KC_ETIME; break; }
+        if ((rc = kc_chan_send_c(ch, src + done * esz, left, cancel)) != 0) break;
+        done++;
+    }
+    *sent = done;
+    return rc;
+}
+
+/* Handle CHAN_SEND_BATCH: COUNT elements in ELEMENTS, queued in order. A
+ * batch that may wait always runs from a request coroutine: a partial try
+ * could not be picked up where it stopped. */
+static int handle_chan_send_batch(kc_ipc_server_ctx_t *ctx, kc_ipc_conn_t *conn, srv_conn_t *sc,
+                                  uint16_t cmd, const uint8_t *payload, size_t len, int try_only,
+                                  const kc_cancel_t *cancel)
+{
+    srv_op_t op;
+    size_t sent = 0;
+    int rc = srv_decode(cmd, payload, len, &op);
+    if (!sc) rc = -ENOTSUP;
+    else if (rc == 0 && (!op.has_chan || !op.has_count || !op.data)) rc = -EINVAL;
+    long tmo = (long)(int32_t)op.timeout_ms;
+    struct kc_chan_entry *entry = rc ? NULL : find_channel(ctx, op.chan_id);
+    if (rc == 0 && !entry) rc = -ENOENT;
+    if (rc == 0 && (entry->elem_sz == 0 || (size_t)op.count * entry->elem_sz != op.dlen)) rc = -EINVAL;
+    if (rc == 0 && try_only && tmo != 0) return SRV_WOULD_PARK;
+    if (rc == 0) rc = srv_send_batch(cancel, entry->chan, op.data, op.count, entry->elem_sz, tmo, &sent);
+    return srv_reply_op(conn, sc, KCORO_CMD_CHAN_SEND_BATCH, &op, rc, (uint32_t)sent);
+}
+
+/* Handle CHAN_RECV_BATCH: wait for one element, then take up to COUNT (as
+ * many as fit one reply frame). try_only as for CHAN_RECV. */
+static int handle_chan_recv_batch(kc_ipc_server_ctx_t *ctx, kc_ipc_conn_t *conn, srv_conn_t *sc,
+                                  uint16_t cmd, const uint8_t *payload, size_t len, int try_only,
+                                  const kc_cancel_t *cancel)
+{
+    srv_op_t op;
+    int rc = srv_decode(cmd, payload, len, &op);
+    uint32_t max = op.count;
+    if (!sc) rc = -ENOTSUP;
+    else if (rc == 0 && (!op.has_chan || !op.has_count || max == 0)) rc = -EINVAL;
+    long tmo = (long)(int32_t)op.timeout_ms;
+    struct kc_chan_entry *entry = rc ? NULL : find_channel(ctx, op.chan_id);
+    if (rc == 0 && !entry) rc = -ENOENT;
+    if (rc == 0 && entry->elem_sz == 0) rc = -EINVAL;
+    if (rc != 0) return srv_reply_op(conn, sc, KCORO_CMD_CHAN_RECV_BATCH, &op, rc, 0);
+
+    size_t esz = entry->elem_sz, fit = (kc_ipc_conn_max_frame(conn) - 64) / esz;
+    if (fit == 0) return srv_reply_op(conn, sc, KCORO_CMD_CHAN_RECV_BATCH, &op, -EMSGSIZE, 0);
+    if (max > fit) max = (uint32_t)fit;
+    /* Elements land where the reply carries them; the lead goes in front. */
+    srv_frame_t *f = srv_frame_new((size_t)max * esz);
+    if (!f) return -ENOMEM;
+    uint8_t *elems = srv_frame_data(f);
+    size_t got = 0;
+    rc = kc_chan_recv_many(entry->chan, elems, max, 0, &got);
+    if (rc == KC_EAGAIN && tmo != 0) {
+        if (try_only) { free(f); return SRV_WOULD_PARK; }
+        rc = kc_chan_recv_c(entry->chan, elems, tmo, cancel);
+        if (rc == 0) {
+            size_t more = 0;
+            if (max > 1) (void)kc_chan_recv_many(entry->chan, elems + esz, max - 1, 0, &more);
+            got = 1 + more;
+        }
     }
-    return NULL;
+    return srv_frame_reply(conn, sc, f, KCORO_CMD_CHAN_RECV_BATCH, &op, rc, (uint32_t)got, got * esz);
 }
 
 /* Handle CHAN_MAKE command */
-static int handle_chan_make(kc_ipc_server_ctx_t *ctx, kc_ipc_conn_t *conn, 
+static int handle_chan_make(kc_ipc_server_ctx_t *ctx, kc_ipc_conn_t *conn, srv_conn_t *sc,
                            const uint8_t *payload, size_t len)
 {
     uint32_t kind = KC_RENDEZVOUS, elem_sz = 0, capacity = 0;
@@ -124,13 +510,21 @@ static int handle_chan_make(kc_ipc_server_ctx_t *ctx, kc_ipc_conn_t *conn,
     parse_tlv_u32(payload, len, KCORO_ATTR_ELEM_SIZE, &elem_sz);  
     parse_tlv_u32(payload, len, KCORO_ATTR_CAPACITY, &capacity);
     
-    if (elem_sz == 0 || elem_sz > 65536) {
-        return -EINVAL; /* Reasonable size limits */
+    /* An element and its request's other TLVs must fit one frame. */
+    if ((size_t)elem_sz + 64 > kc_ipc_conn_max_frame(conn)) {
+        return -EINVAL;
     }
     
-    /* Create local channel */
+    /* Create local channel; size 0 makes a descriptor channel */
     kc_chan_t *chan = NULL;
-    int rc = kc_chan_make(&chan, (int)kind, elem_sz, capacity);
+    int rc;
+    if (elem_sz == 0) {
+        rc = kc_chan_make_ptr(&chan, (int)kind, capacity);
+        if (rc == 0 && (rc = kc_chan_enable_zero_copy_backend(chan, kc_zcopy_resolve("zref"), NULL)) != 0)
+            kc_chan_destroy(chan);
+    } else {
+        rc = kc_chan_make(&chan, (int)kind, elem_sz, capacity);
+    }
     if (rc != 0) return rc;
     
     /* Add to registry */
@@ -140,12 +534,16 @@ static int handle_chan_make(kc_ipc_server_ctx_t *ctx, kc_ipc_conn_t *conn,
         return -ENOMEM;
     }
     
-    entry->id = ++ctx->next_chan_id;
     entry->chan = chan;
     entry->kind = (int)kind;
     entry->elem_sz = elem_sz;
-    entry->next = ctx->channels;
-    ctx->channels = entry;
+    entry->capacity = capacity;
+    entry->borrowed = 0;
+    if ((rc = srv_register(ctx, entry)) != 0) {
+        kc_chan_destroy(chan);
+        free(entry);
+        return rc;
+    }
     
     /* Send response with channel ID (echo req_id if present) */
     uint8_t buf[32];
@@ -159,155 +557,139 @@ static int handle_chan_make(kc_ipc_server_ctx_t *ctx, kc_ipc_conn_t *conn,
         return -EMSGSIZE;
     }
     
-    return kc_ipc_send(conn, KCORO_CMD_CHAN_MAKE, buf, (size_t)(cur - buf));
+    return srv_reply(conn, sc, KCORO_CMD_CHAN_MAKE, buf, (size_t)(cur - buf));
 }
 
 /* Handle CHAN_SEND command */
-static int handle_chan_send(kc_ipc_server_ctx_t *ctx, kc_ipc_conn_t *conn,
-                           const uint8_t *payload, size_t len)
+/* try_only: a parking op returns SRV_WOULD_PARK without replying. */
+static int handle_chan_send(kc_ipc_server_ctx_t *ctx, kc_ipc_conn_t *conn, srv_conn_t *sc,
+                            uint16_t cmd, const uint8_t *payload, size_t len, int try_only,
+                            const kc_cancel_t *cancel)
 {
-    uint32_t chan_id = 0, timeout_ms = 0;
-    
-    /* Parse parameters */
-    if (parse_tlv_u32(payload, len, KCORO_ATTR_CHAN_ID, &chan_id) != 0) {
-        /* Respond with error */
-        uint8_t buf[32]; uint8_t *cur = buf, *end = buf + sizeof(buf);
-        kc_tlv_put_u32(&cur, end, KCORO_ATTR_RESULT, (uint32_t)-EINVAL);
-        return kc_ipc_send(conn, KCORO_CMD_CHAN_SEND, buf, (size_t)(cur - buf));
-    }
-    parse_tlv_u32(payload, len, KCORO_ATTR_TIMEOUT_MS, &timeout_ms);
-    
-    /* Find channel */
-    struct kc_chan_entry *entry = find_channel(ctx, chan_id);
-    if (!entry) {
-        uint8_t buf[32]; uint8_t *cur = buf, *end = buf + sizeof(buf);
-        kc_tlv_put_u32(&cur, end, KCORO_ATTR_RESULT, (uint32_t)-ENOENT);
-        return kc_ipc_send(conn, KCORO_CMD_CHAN_SEND, buf, (size_t)(cur - buf));
-    }
-    
-    /* Extract element data */
-    void *element = malloc(entry->elem_sz);
-    if (!element) return -ENOMEM;
-    
-    int rc = parse_tlv_element(payload, len, element, entry->elem_sz);
-    if (rc != 0) {
-        free(element);
-        uint8_t buf[32]; uint8_t *cur = buf, *end = buf + sizeof(buf);
-        kc_tlv_put_u32(&cur, end, KCORO_ATTR_RESULT, (uint32_t)-EINVAL);
-        return kc_ipc_send(conn, KCORO_CMD_CHAN_SEND, buf, (size_t)(cur - buf));
-    }
-    
-    /* Perform send operation inside coroutine context */
-    struct kc_send_task st = {
-        .ch = entry->chan, .elem = element, .tmo = (long)timeout_ms, .rc = 0, .done = 0
-    };
-    pthread_mutex_init(&st.mu, NULL); pthread_cond_init(&st.cv, NULL);
-    kc_sched_t *sched = kc_sched_default();
-    if (kc_spawn_co(sched, kc_ipc_send_co, &st, 0, NULL) != 0) { pthread_mutex_destroy(&st.mu); pthread_cond_destroy(&st.cv); free(element); return -ENOMEM; }
-    pthread_mutex_lock(&st.mu); while (!st.done) pthread_cond_wait(&st.cv, &st.mu); pthread_mutex_unlock(&st.mu);
-    rc = st.rc;
-    pthread_cond_destroy(&st.cv); pthread_mutex_destroy(&st.mu);
-    free(element);
-    
-    /* Send result back (echo req_id if present) */
-    uint8_t buf[32];
-    uint8_t *cur = buf, *end = buf + sizeof(buf);
-    {
-        uint32_t req_id = 0; (void)parse_tlv_u32(payload, len, KCORO_ATTR_REQ_ID, &req_id);
-        if (req_id) { (void)kc_tlv_put_u32(&cur, end, KCORO_ATTR_REQ_ID, req_id); }
+    srv_op_t op;
+    int rc = srv_decode(cmd, payload, len, &op);
+    struct kc_chan_entry *entry = NULL;
+    if (rc == 0 && !op.has_chan) rc = -EINVAL;
+    if (rc == 0 && !(entry = find_channel(ctx, op.chan_id))) rc = -ENOENT;
+    /* The element is sent straight out of the frame: no staging copy. */
+    if (rc == 0 && (entry->elem_sz == 0 || !op.data || op.dlen != entry->elem_sz)) rc = -EINVAL;
+    if (rc == 0) {
+        /* The wire carries the timeout as u32; -1 means no limit. */
+        long tmo = (long)(int32_t)op.timeout_ms;
+        rc = srv_chan_send(sc, cancel, entry->chan, op.data, try_only ? 0 : tmo);
+        if (try_only && rc == KC_EAGAIN && tmo != 0) return SRV_WOULD_PARK;
     }
-    
-    if (kc_tlv_put_u32(&cur, end, KCORO_ATTR_RESULT, (uint32_t)rc) != 0) {
-        return -EMSGSIZE;
+    /* A credited send spent a credit and waits for no reply; failures
+     * surface on the client's next blocking op on the channel. */
+    if (op.credited) return 0;
+
+    /* Grant credits against the room left now; nothing is reserved, so a
+     * credited send that meets a full ring just parks like any other. */
+    uint32_t grant = 0;
+    if (rc == 0 && entry->kind == KC_BUFFERED && op.want) {
+        size_t used = kc_chan_len(entry->chan);
+        size_t room = entry->capacity > used ? entry->capacity - used : 0;
+        grant = room < op.want ? (uint32_t)room : op.want;
     }
-    
-    return kc_ipc_send(conn, KCORO_CMD_CHAN_SEND, buf, (size_t)(cur - buf));
+    return srv_reply_op(conn, sc, KCORO_CMD_CHAN_SEND, &op, rc, grant);
 }
 
 /* Handle CHAN_RECV command */
-static int handle_chan_recv(kc_ipc_server_ctx_t *ctx, kc_ipc_conn_t *conn,
-                           const uint8_t *payload, size_t len)
+/* try_only: a parking op returns SRV_WOULD_PARK without replying. */
+static int handle_chan_recv(kc_ipc_server_ctx_t *ctx, kc_ipc_conn_t *conn, srv_conn_t *sc,
+                            uint16_t cmd, const uint8_t *payload, size_t len, int try_only,
+                            const kc_cancel_t *cancel)
+{
+    srv_op_t op;
+    int rc = srv_decode(cmd, payload, len, &op);
+    struct kc_chan_entry *entry = NULL;
+    if (rc == 0 && !op.has_chan) rc = -EINVAL;
+    if (rc == 0 && !(entry = find_channel(ctx, op.chan_id))) rc = -ENOENT;
+    if (rc == 0 && entry->elem_sz == 0) rc = -EINVAL;
+    if (rc != 0) return srv_reply_op(conn, sc, KCORO_CMD_CHAN_RECV, &op, rc, 0);
+
+    /* The element lands where the reply carries it. */
+    srv_frame_t *f = srv_frame_new(entry->elem_sz);
+    if (!f) return -ENOMEM;
+    long tmo = (long)(int32_t)op.timeout_ms;
+    rc = srv_chan_recv(sc, cancel, entry->chan, srv_frame_data(f), try_only ? 0 : tmo);
+    if (try_only && rc == KC_EAGAIN && tmo != 0) { free(f); return SRV_WOULD_PARK; }
+    return srv_frame_reply(conn, sc, f, KCORO_CMD_CHAN_RECV, &op, rc, 0, rc == 0 ? entry->elem_sz : 0);
+}
+
+/* Handle CHAN_SEND_DESC: the payload lies in a region the client exported
+ * over this connection. try_only as for CHAN_SEND. */
+static int handle_chan_send_desc(kc_ipc_server_ctx_t *ctx, kc_ipc_conn_t *conn, srv_conn_t *sc,
+                                 const uint8_t *payload, size_t len, int try_only,
+                                 const kc_cancel_t *cancel)
 {
     uint32_t chan_id = 0, timeout_ms = 0;
-    
-    /* Parse parameters */
-    if (parse_tlv_u32(payload, len, KCORO_ATTR_CHAN_ID, &chan_id) != 0) {
-        uint8_t buf[32]; uint8_t *cur = buf, *end = buf + sizeof(buf);
-        kc_tlv_put_u32(&cur, end, KCORO_ATTR_RESULT, (uint32_t)-EINVAL);
-        return kc_ipc_send(conn, KCORO_CMD_CHAN_RECV, buf, (size_t)(cur - buf));
-    }
-    parse_tlv_u32(payload, len, KCORO_ATTR_TIMEOUT_MS, &timeout_ms);
-    
-    /* Find channel */
-    struct kc_chan_entry *entry = find_channel(ctx, chan_id);
-    if (!entry) {
-        uint8_t buf[32]; uint8_t *cur = buf, *end = buf + sizeof(buf);
-        kc_tlv_put_u32(&cur, end, KCORO_ATTR_RESULT, (uint32_t)-ENOENT);
-        return kc_ipc_send(conn, KCORO_CMD_CHAN_RECV, buf, (size_t)(cur - buf));
-    }
-    
-    /* Allocate buffer for received element */
-    void *element = malloc(entry->elem_sz);
-    if (!element) return -ENOMEM;
-    
-    /* Perform receive operation inside coroutine context */
-    struct kc_recv_task rt = {
-        .ch = entry->chan, .elem = element, .tmo = (long)timeout_ms, .rc = 0, .done = 0
-    };
-    pthread_mutex_init(&rt.mu, NULL); pthread_cond_init(&rt.cv, NULL);
-    kc_sched_t *sched = kc_sched_default();
-    if (kc_spawn_co(sched, kc_ipc_recv_co, &rt, 0, NULL) != 0) { pthread_mutex_destroy(&rt.mu); pthread_cond_destroy(&rt.cv); free(element); return -ENOMEM; }
-    pthread_mutex_lock(&rt.mu); while (!rt.done) pthread_cond_wait(&rt.cv, &rt.mu); pthread_mutex_unlock(&rt.mu);
-    int rc = rt.rc;
-    pthread_cond_destroy(&rt.cv); pthread_mutex_destroy(&rt.mu);
-    
-    /* Prepare response (echo req_id if present) */
-    size_t resp_size = 32 + entry->elem_sz;
-    uint8_t *resp_buf = malloc(resp_size);
-    if (!resp_buf) {
-        free(element);
-        return -ENOMEM;
-    }
-    
-    uint8_t *cur = resp_buf, *end = resp_buf + resp_size;
-    
-    /* Add req_id and result code */
-    {
-        uint32_t req_id = 0; (void)parse_tlv_u32(payload, len, KCORO_ATTR_REQ_ID, &req_id);
-        if (req_id) { (void)kc_tlv_put_u32(&cur, end, KCORO_ATTR_REQ_ID, req_id); }
+    uint64_t rid = 0, roff = 0, rlen = 0;
+    int rc = 0;
+    if (!sc) rc = -ENOTSUP;
+    else if (parse_tlv_u32(payload, len, KCORO_ATTR_CHAN_ID, &chan_id) != 0 ||
+             parse_tlv_u64(payload, len, KCORO_ATTR_REGION_ID, &rid) != 0 ||
+             parse_tlv_u64(payload, len, KCORO_ATTR_REGION_OFF, &roff) != 0 ||
+             parse_tlv_u64(payload, len, KCORO_ATTR_REGION_LEN, &rlen) != 0) rc = -EINVAL;
+    struct kc_chan_entry *entry = rc ? NULL : find_channel(ctx, chan_id);
+    if (rc == 0 && !entry) rc = -ENOENT;
+    if (rc == 0 && entry->elem_sz != 0) rc = -EINVAL;
+    kc_region_t *reg = NULL;
+    if (rc == 0) rc = kc_ipc_region_lookup(conn, rid, &reg);
+    if (rc == 0) {
+        /* The server's own numbering for its mapping of the region. */
+        unsigned long lid = 0;
+        (void)kc_region_export_id(reg, &lid);
+        kc_zdesc_t d = { .addr = NULL, .len = (size_t)rlen, .region_id = lid, .offset = roff };
+        (void)parse_tlv_u32(payload, len, KCORO_ATTR_TIMEOUT_MS, &timeout_ms);
+        long tmo = (long)(int32_t)timeout_ms;
+        rc = kc_chan_send_desc_c(entry->chan, &d, try_only ? 0 : tmo, cancel);
+        if (try_only && rc == KC_EAGAIN && tmo != 0) return SRV_WOULD_PARK;
     }
-    if (kc_tlv_put_u32(&cur, end, KCORO_ATTR_RESULT, (uint32_t)rc) != 0) {
-        free(element);
-        free(resp_buf);
-        return -EMSGSIZE;
+    return srv_reply_rc(conn, sc, KCORO_CMD_CHAN_SEND_DESC, payload, len, rc);
+}
+
+/* Handle CHAN_RECV_DESC: hands the receiver the region before the reply
+ * that names it. try_only as for CHAN_RECV. */
+static int handle_chan_recv_desc(kc_ipc_server_ctx_t *ctx, kc_ipc_conn_t *conn, srv_conn_t *sc,
+                                 const uint8_t *payload, size_t len, int try_only,
+                                 const kc_cancel_t *cancel)
+{
+    uint32_t chan_id = 0, timeout_ms = 0;
+    int rc = 0;
+    if (!sc) rc = -ENOTSUP;
+    else if (parse_tlv_u32(payload, len, KCORO_ATTR_CHAN_ID, &chan_id) != 0) rc = -EINVAL;
+    struct kc_chan_entry *entry = rc ? NULL : find_channel(ctx, chan_id);
+    if (rc == 0 && !entry) rc = -ENOENT;
+    if (rc == 0 && entry->elem_sz != 0) rc = -EINVAL;
+    kc_zdesc_t d = { .flags = KC_ZDESC_F_REGION };
+    if (rc == 0) {
+        (void)parse_tlv_u32(payload, len, KCORO_ATTR_TIMEOUT_MS, &timeout_ms);
+        long tmo = (long)(int32_t)timeout_ms;
+        rc = kc_chan_recv_desc_c(entry->chan, &d, try_only ? 0 : tmo, cancel);
+        if (try_only && rc == KC_EAGAIN && tmo != 0) return SRV_WOULD_PARK;
     }
-    
-    /* Add element data if successful */
     if (rc == 0) {
-        if ((size_t)(end - cur) < 4 + entry->elem_sz) {
-            free(element);
-            free(resp_buf);
-            return -EMSGSIZE;
-        }
-        
-        uint16_t t = htons(KCORO_ATTR_ELEMENT);
-        uint16_t l = htons((uint16_t)entry->elem_sz);
-        memcpy(cur, &t, 2);
-        memcpy(cur + 2, &l, 2);
-        memcpy(cur + 4, element, entry->elem_sz);
-        cur += 4 + entry->elem_sz;
+        /* Its sender's region, unless that connection has closed since. */
+        kc_region_t *reg = kc_region_get((unsigned long)d.region_id);
+        rc = reg ? kc_ipc_region_export(conn, reg) : -ENOENT;
+        kc_region_put(reg);
     }
-    
-    rc = kc_ipc_send(conn, KCORO_CMD_CHAN_RECV, resp_buf, (size_t)(cur - resp_buf));
-    
-    free(element);
-    free(resp_buf);
-    return rc;
+    if (rc != 0) return srv_reply_rc(conn, sc, KCORO_CMD_CHAN_RECV_DESC, payload, len, rc);
+
+    uint8_t buf[64]; uint8_t *cur = buf, *end = buf + sizeof(buf);
+    uint32_t req_id = 0; (void)parse_tlv_u32(payload, len, KCORO_ATTR_REQ_ID, &req_id);
+    if (req_id) (void)kc_tlv_put_u32(&cur, end, KCORO_ATTR_REQ_ID, req_id);
+    (void)kc_tlv_put_u32(&cur, end, KCORO_ATTR_RESULT, 0);
+    (void)kc_tlv_put_u64(&cur, end, KCORO_ATTR_REGION_ID, d.region_id);
+    (void)kc_tlv_put_u64(&cur, end, KCORO_ATTR_REGION_OFF, d.offset);
+    (void)kc_tlv_put_u64(&cur, end, KCORO_ATTR_REGION_LEN, (uint64_t)d.len);
+    return srv_reply(conn, sc, KCORO_CMD_CHAN_RECV_DESC, buf, (size_t)(cur - buf));
 }
 
 /* Handle CHAN_CLOSE command */
-static int handle_chan_close(kc_ipc_server_ctx_t *ctx, kc_ipc_conn_t *conn,
-                            const uint8_t *payload, size_t len)
+static int handle_chan_close(kc_ipc_server_ctx_t *ctx, kc_ipc_conn_t *conn, srv_conn_t *sc,
+                           const uint8_t *payload, size_t len)
 {
     uint32_t chan_id = 0;
     
@@ -318,7 +700,7 @@ static int handle_chan_close(kc_ipc_server_ctx_t *ctx, kc_ipc_conn_t *conn,
             if (req_id) { (void)kc_tlv_put_u32(&cur, end, KCORO_ATTR_REQ_ID, req_id); }
         }
         kc_tlv_put_u32(&cur, end, KCORO_ATTR_RESULT, (uint32_t)-EINVAL);
-        return kc_ipc_send(conn, KCORO_CMD_CHAN_CLOSE, buf, (size_t)(cur - buf));
+        return srv_reply(conn, sc, KCORO_CMD_CHAN_CLOSE, buf, (size_t)(cur - buf));
     }
     
     struct kc_chan_entry *entry = find_channel(ctx, chan_id);
@@ -329,7 +711,7 @@ static int handle_chan_close(kc_ipc_server_ctx_t *ctx, kc_ipc_conn_t *conn,
             if (req_id) { (void)kc_tlv_put_u32(&cur, end, KCORO_ATTR_REQ_ID, req_id); }
         }
         kc_tlv_put_u32(&cur, end, KCORO_ATTR_RESULT, (uint32_t)-ENOENT);
-        return kc_ipc_send(conn, KCORO_CMD_CHAN_CLOSE, buf, (size_t)(cur - buf));
+        return srv_reply(conn, sc, KCORO_CMD_CHAN_CLOSE, buf, (size_t)(cur - buf));
     }
     
     kc_chan_close(entry->chan);
@@ -345,71 +727,437 @@ static int handle_chan_close(kc_ipc_server_ctx_t *ctx, kc_ipc_conn_t *conn,
         return -EMSGSIZE;
     }
     
-    return kc_ipc_send(conn, KCORO_CMD_CHAN_CLOSE, buf, (size_t)(cur - buf));
+    return srv_reply(conn, sc, KCORO_CMD_CHAN_CLOSE, buf, (size_t)(cur - buf));
 }
 
 /* Handle CHAN_DESTROY command */
-static int handle_chan_destroy(kc_ipc_server_ctx_t *ctx, kc_ipc_conn_t *conn,
-                              const uint8_t *payload, size_t len)
+static int handle_chan_destroy(kc_ipc_server_ctx_t *ctx, kc_ipc_conn_t *conn, srv_conn_t *sc,
+                           const uint8_t *payload, size_t len)
 {
-    (void)conn; /* unused parameter */
+    (void)conn; (void)sc; /* no reply */
     uint32_t chan_id = 0;
     
     if (parse_tlv_u32(payload, len, KCORO_ATTR_CHAN_ID, &chan_id) != 0) {
         return 0; /* ignore */
     }
-    /* Do not remove the channel immediately; just close it to allow draining */
+    /* Do not remove the channel immediately; just close it to allow draining.
+     * An exported channel belongs to the server process: a client dropping
+     * its handle leaves it open. */
     struct kc_chan_entry *entry = find_channel(ctx, chan_id);
-    if (entry && entry->chan) {
+    if (entry && entry->chan && !entry->borrowed) {
         kc_chan_close(entry->chan);
     }
     return 0; /* best effort */
 }
 
-/* Main command dispatcher for kcoro server */
-int kc_ipc_handle_command(kc_ipc_server_ctx_t *ctx, kc_ipc_conn_t *conn,
-                         uint16_t cmd, const uint8_t *payload, size_t len)
+/* Command dispatcher shared by the thread and coroutine paths. */
+/* Handle CHAN_CANCEL: trigger the token of the parked request REQ_ID names,
+ * if it is still parked. No reply; the request sends its own. */
+static int handle_chan_cancel(srv_conn_t *sc, const uint8_t *payload, size_t len)
+{
+    uint32_t req_id = 0;
+    if (!sc || parse_tlv_u32(payload, len, KCORO_ATTR_REQ_ID, &req_id) != 0 || !req_id) return 0;
+    pthread_mutex_lock(&sc->pmu);
+    for (int i = 0; i < KCORO_IPC_PIPELINE; i++) {
+        if (sc->parked[i].req_id != req_id) continue;
+        kc_cancel_trigger(sc->parked[i].cc.token);
+        break;
+    }
+    pthread_mutex_unlock(&sc->pmu);
+    return 0;
+}
+
+/* cancel: the token a parking op waits under (unused with try_only). */
+static int srv_dispatch(kc_ipc_server_ctx_t *ctx, kc_ipc_conn_t *conn, srv_conn_t *sc,
+                        uint16_t cmd, const uint8_t *payload, size_t len, int try_only,
+                        const kc_cancel_t *cancel)
 {
     switch (cmd) {
         case KCORO_CMD_CHAN_MAKE:
-            return handle_chan_make(ctx, conn, payload, len);
+            return handle_chan_make(ctx, conn, sc, payload, len);
+        /* The hot commands come in either layout; srv_decode tells them apart. */
         case KCORO_CMD_CHAN_SEND:
         case KCORO_CMD_CHAN_TRY_SEND: /* Same handler, timeout differentiates */
-            return handle_chan_send(ctx, conn, payload, len);
+        case KCORO_CMD_CHAN_SEND | KCORO_CMD_FIXED:
+        case KCORO_CMD_CHAN_TRY_SEND | KCORO_CMD_FIXED:
+            return handle_chan_send(ctx, conn, sc, cmd, payload, len, try_only, cancel);
         case KCORO_CMD_CHAN_RECV:
         case KCORO_CMD_CHAN_TRY_RECV: /* Same handler, timeout differentiates */
-            return handle_chan_recv(ctx, conn, payload, len);
+        case KCORO_CMD_CHAN_RECV | KCORO_CMD_FIXED:
+        case KCORO_CMD_CHAN_TRY_RECV | KCORO_CMD_FIXED:
+            return handle_chan_recv(ctx, conn, sc, cmd, payload, len, try_only, cancel);
+        case KCORO_CMD_CHAN_SEND_DESC:
+            return handle_chan_send_desc(ctx, conn, sc, payload, len, try_only, cancel);
+        case KCORO_CMD_CHAN_RECV_DESC:
+            return handle_chan_recv_desc(ctx, conn, sc, payload, len, try_only, cancel);
+        case KCORO_CMD_CHAN_SEND_BATCH:
+        case KCORO_CMD_CHAN_SEND_BATCH | KCORO_CMD_FIXED:
+            return handle_chan_send_batch(ctx, conn, sc, cmd, payload, len, try_only, cancel);
+        case KCORO_CMD_CHAN_RECV_BATCH:
+        case KCORO_CMD_CHAN_RECV_BATCH | KCORO_CMD_FIXED:
+            return handle_chan_recv_batch(ctx, conn, sc, cmd, payload, len, try_only, cancel);
         case KCORO_CMD_CHAN_CLOSE:
-            return handle_chan_close(ctx, conn, payload, len);
+            return handle_chan_close(ctx, conn, sc, payload, len);
         case KCORO_CMD_CHAN_DESTROY:
-            return handle_chan_destroy(ctx, conn, payload, len);
+            return handle_chan_destroy(ctx, conn, sc, payload, len);
+        case KCORO_CMD_CHAN_CANCEL:
+            return handle_chan_cancel(sc, payload, len);
         default:
             return -ENOSYS; /* Unsupported command */
     }
 }
 
+/* Main command dispatcher for kcoro server (thread callers) */
+int kc_ipc_handle_command(kc_ipc_server_ctx_t *ctx, kc_ipc_conn_t *conn,
+                         uint16_t cmd, const uint8_t *payload, size_t len)
+{
+    return srv_dispatch(ctx, conn, NULL, cmd, payload, len, 0, NULL);
+}
+
+/* ---- Coroutine-native serving ---- */
+
+static void srv_conn_put(srv_conn_t *sc)
+{
+    if (atomic_fetch_sub(&sc->refs, 1) != 1) return;
+    kc_ipc_conn_close(sc->conn);
+    kc_chan_destroy(sc->replies);
+    kc_chan_destroy(sc->slots);
+    kc_cancel_destroy(sc->cancel);
+    pthread_mutex_destroy(&sc->pmu);
+    free(sc->rxbuf);
+    free(sc);
+}
+
+/* The only coroutine writing to the socket: staged frames never interleave.
+ * Replies queued together go out in one flush. */
+static void srv_writer(void *arg)
+{
+    srv_conn_t *sc = (srv_conn_t*)arg;
+    int stop = 0;
+    while (!stop) {
+        srv_frame_t *f = NULL;
+        if (kc_chan_recv(sc->replies, &f, -1) != 0) break;
+        int staged = 0;
+        for (;;) {
+            if (!f) { stop = 1; break; }
+            /* After a failure keep draining, so request coroutines never
+             * park on a full reply queue. */
+            if (!sc->werr) {
+                int rc = kc_ipc_queue(sc->conn, f->cmd, f->data + f->off, f->len);
+                if (rc == 0) staged++; else sc->werr = rc;
+            }
+            free(f);
+            if (staged == KCORO_IPC_TXQ || kc_chan_try_recv(sc->replies, &f) != 0) break;
+        }
+        if (staged && !sc->werr) {
+            int rc = kc_ipc_flush(sc->conn);
+            while (rc == -EAGAIN) {
+                if ((rc = kc_ipc_await_flush(sc->conn, -1)) != 0) break;
+                rc = kc_ipc_flush(sc->conn);
+            }
+            sc->werr = rc;
+        }
+    }
+    srv_conn_put(sc);
+}
+
+typedef struct srv_req {
+    srv_conn_t *sc;
+    int slot;             /* its token, indexing sc->parked */
+    uint16_t cmd;
+    size_t len;
+    uint8_t payload[];
+} srv_req_t;
+
+/* Give a parked request a token CHAN_CANCEL can find by its req_id. Without
+ * one (no req_id, or out of memory) it waits under the connection's. */
+static void srv_park(srv_conn_t *sc, int slot, uint16_t cmd, const uint8_t *payload, size_t len)
+{
+    struct srv_parked *pk = &sc->parked[slot];
+    uint32_t req_id = srv_req_id(cmd, payload, len);
+    pk->cc.token = NULL;
+    if (!req_id) return;
+    if (kc_cancel_ctx_init(&pk->cc, sc->cancel) != 0) { pk->cc.token = NULL; return; }
+    pthread_mutex_lock(&sc->pmu);
+    pk->req_id = req_id;
+    pthread_mutex_unlock(&sc->pmu);
+}
+
+static void srv_unpark(srv_conn_t *sc, int slot)
+{
+    struct srv_parked *pk = &sc->parked[slot];
+    if (!pk->cc.token) return;
+    pthread_mutex_lock(&sc->pmu);
+    pk->req_id = 0;
+    pthread_mutex_unlock(&sc->pmu);
+    kc_cancel_ctx_destroy(&pk->cc);
+}
+
+/* A send/recv that parks: runs with the full timeout, then frees its slot. */
+static void srv_request(void *arg)
+{
+    srv_req_t *rq = (srv_req_t*)arg;
+    srv_conn_t *sc = rq->sc;
+    struct srv_parked *pk = &sc->parked[rq->slot];
+    (void)srv_dispatch(sc->ctx, sc->conn, sc, rq->cmd, rq->payload, rq->len, 0,
+                       pk->cc.token ? pk->cc.token : sc->cancel);
+    srv_unpark(sc, rq->slot);
+    int tok = rq->slot;
+    free(rq);
+    (void)kc_chan_send(sc->slots, &tok, -1);
+    /* The reader may finish teardown as soon as the token lands, while this
+     * send is still waking it: hold sc until the send has returned. */
+    srv_conn_put(sc);
+}
+
+/* Next frame into sc->rxbuf, parking while none is buffered. */
+static int srv_read(srv_conn_t *sc, uint16_t *cmd, size_t *len)
+{
+    for (;;) {
+        int rc = kc_ipc_recv_nb_into(sc->conn, cmd, sc->rxbuf, sc->rxcap, len);
+        if (rc != -EAGAIN) return rc;
+        if ((rc = kc_await_readable(kc_ipc_conn_fd(sc->conn), -1)) != 0) return rc;
+    }
+}
+
+static int srv_handshake(srv_conn_t *sc)
+{
+    uint16_t cmd = 0; size_t n = 0;
+    int rc = srv_read(sc, &cmd, &n);
+    if (rc != 0) return rc;
+    if (cmd != KCORO_CMD_HELLO) return -EPROTO;
+    /* Answered in line: it may hand the client shared-memory rings, and
+     * nothing else is queued to the writer yet. */
+    uint32_t maj = 0, min = 0;
+    if ((rc = kc_ipc_hs_answer(sc->conn, sc->rxbuf, n, &maj, &min)) != 0) return rc;
+    size_t want = kc_ipc_conn_max_frame(sc->conn);
+    if (want > sc->rxcap) {
+        uint8_t *nb = realloc(sc->rxbuf, want);
+        if (!nb) return -ENOMEM;
+        sc->rxbuf = nb;
+        sc->rxcap = want;
+    }
+    return 0;
+}
+
+int kc_ipc_server_serve(kc_ipc_server_ctx_t *ctx, kc_ipc_conn_t *conn)
+{
+    kc_sched_t *s = kc_sched_current();
+    if (!ctx || !conn || !s || !kcoro_current()) return -EINVAL;
+    srv_conn_t *sc = calloc(1, sizeof(*sc));
+    if (!sc) { kc_ipc_conn_close(conn); return -ENOMEM; }
+    sc->ctx = ctx;
+    sc->conn = conn;
+    /* Room for every request's reply plus the reader's own. */
+    int rc = kc_chan_make_mpmc(&sc->replies, sizeof(srv_frame_t*), KCORO_IPC_PIPELINE + 1);
+    if (rc == 0) rc = kc_chan_make_mpmc(&sc->slots, sizeof(int), KCORO_IPC_PIPELINE);
+    if (rc == 0) rc = kc_cancel_init(&sc->cancel);
+    sc->rxcap = KCORO_IPC_MAX_FRAME; /* the handshake may grow it */
+    if (rc == 0 && !(sc->rxbuf = malloc(sc->rxcap))) rc = -ENOMEM;
+    for (int i = 0; rc == 0 && i < KCORO_IPC_PIPELINE; i++) rc = kc_chan_send(sc->slots, &i, 0);
+    pthread_mutex_init(&sc->pmu, NULL);
+    if (rc == 0) rc = kc_ipc_conn_set_nb(conn, 1);
+    atomic_store(&sc->refs, 2);
+    if (rc == 0 && kc_spawn_co(s, srv_writer, sc, 0, NULL) != 0) rc = -ENOMEM;
+    if (rc != 0) {
+        if (sc->replies) kc_chan_destroy(sc->replies);
+        if (sc->slots) kc_chan_destroy(sc->slots);
+        if (sc->cancel) kc_cancel_destroy(sc->cancel);
+        pthread_mutex_destroy(&sc->pmu);
+        free(sc->rxbuf);
+        free(sc);
+        kc_ipc_conn_close(conn);
+        return rc;
+    }
+
+    rc = srv_handshake(sc);
+    while (rc == 0) {
+        uint16_t cmd = 0; size_t len = 0;
+        if ((rc = srv_read(sc, &cmd, &len)) != 0) break;
+        /* Most ops finish without parking, straight from the reader's
+         * buffer; only those that would park get a coroutine (and a copy of
+         * the frame), so frames keep flowing behind them. */
+        int hr = srv_dispatch(ctx, conn, sc, cmd, sc->rxbuf, len, 1, sc->cancel);
+        if (hr != SRV_WOULD_PARK) continue;
+        int tok = 0;
+        (void)kc_chan_recv(sc->slots, &tok, -1); /* pipeline depth */
+        srv_req_t *rq = malloc(sizeof(*rq) + len);
+        if (rq) { rq->sc = sc; rq->slot = tok; rq->cmd = cmd; rq->len = len; memcpy(rq->payload, sc->rxbuf, len); }
+        /* Findable before any later frame is read: a CHAN_CANCEL right
+         * behind it must not miss it. */
+        if (rq) srv_park(sc, tok, cmd, sc->rxbuf, len);
+        atomic_fetch_add(&sc->refs, 1);
+        if (!rq || kc_spawn_co(s, srv_request, rq, 0, NULL) != 0) {
+            atomic_fetch_sub(&sc->refs, 1);
+            if (rq) srv_unpark(sc, tok);
+            free(rq);
+            (void)srv_dispatch(ctx, conn, sc, cmd, sc->rxbuf, len, 0, sc->cancel); /* in line, then */
+            (void)kc_chan_send(sc->slots, &tok, 0);
+        }
+    }
+    /* Hang-up: ops parked for this peer end with KC_ECANCELED; wait for all
+     * request coroutines (each hands its slot back), then stop the writer. */
+    kc_cancel_trigger(sc->cancel);
+    for (int i = 0; i < KCORO_IPC_PIPELINE; i++) { int tok = 0; (void)kc_chan_recv(sc->slots, &tok, -1); }
+    srv_frame_t *nil = NULL;
+    (void)kc_chan_send(sc->replies, &nil, -1);
+    srv_conn_put(sc);
+    return rc == -ECONNRESET ? 0 : rc;
+}
+
+/* Accept fan-out: an acceptor coroutine per listener, a serving coroutine
+ * per connection, spread over the scheduler's workers. */
+typedef struct srv_listener {
+    kc_ipc_acceptor_t *owner;
+    kc_ipc_server_t *srv;
+} srv_listener_t;
+
+struct kc_ipc_acceptor {
+    kc_ipc_server_ctx_t *ctx;
+    kc_sched_t *s;
+    _Atomic(int) stop;
+    _Atomic(unsigned long) accepted;
+    kc_chan_t *exited;    /* one token per acceptor coroutine as it leaves */
+    size_t n;
+    srv_listener_t l[];
+};
+
+typedef struct srv_accepted {
+    kc_ipc_server_ctx_t *ctx;
+    kc_ipc_conn_t *conn;
+} srv_accepted_t;
+
+static void srv_serve_co(void *arg)
+{
+    srv_accepted_t acc = *(srv_accepted_t*)arg;
+    free(arg);
+    (void)kc_ipc_server_serve(acc.ctx, acc.conn);
+}
+
+static void srv_accept_loop(void *arg)
+{
+    srv_listener_t *l = (srv_listener_t*)arg;
+    kc_ipc_acceptor_t *a = l->owner;
+    int fd = kc_ipc_srv_fd(l->srv);
+    while (!atomic_load(&a->stop)) {
+        kc_ipc_conn_t *conn = NULL;
+        int rc = kc_ipc_srv_accept_nb(l->srv, &conn);
+        if (rc == -EAGAIN) {
+            if (kc_await_readable(fd, -1) != 0) break;
+            continue;
+        }
+        if (rc != 0) {
+            if (!atomic_load(&a->stop)) kc_sleep_ms(10); /* out of descriptors, say */
+            continue;
+        }
+        srv_accepted_t *acc = malloc(sizeof(*acc));
+        if (acc) { acc->ctx = a->ctx; acc->conn = conn; }
+        if (!acc || kc_spawn_co(a->s, srv_serve_co, acc, 0, NULL) != 0) {
+            free(acc);
+            kc_ipc_conn_close(conn);
+            continue;
+        }
+        atomic_fetch_add_explicit(&a->accepted, 1, memory_order_relaxed);
+    }
+    int tok = 1;
+    (void)kc_chan_send(a->exited, &tok, 0);
+}
+
+int kc_ipc_server_start(kc_ipc_server_ctx_t *ctx, kc_ipc_server_t *const *listeners, size_t n,
+                        kc_sched_t *s, kc_ipc_acceptor_t **out)
+{
+    if (!ctx || !listeners || n == 0 || !out) return -EINVAL;
+    if (!s && !(s = kc_sched_default())) return -ENOMEM;
+    kc_ipc_acceptor_t *a = calloc(1, sizeof(*a) + n * sizeof(a->l[0]));
+    if (!a) return -ENOMEM;
+    a->ctx = ctx;
+    a->s = s;
+    a->n = n;
+    int rc = kc_chan_make(&a->exited, KC_BUFFERED, sizeof(int), n);
+    for (size_t i = 0; rc == 0 && i < n; i++) {
+        a->l[i].owner = a;
+        a->l[i].srv = listeners[i];
+        if (!listeners[i]) rc = -EINVAL;
+        else rc = kc_ipc_srv_set_nb(listeners[i], 1);
+    }
+    if (rc != 0) {
+        if (a->exited) kc_chan_destroy(a->exited);
+        free(a);
+        return rc;
+    }
+    size_t spawned = 0;
+    while (spawned < n && kc_spawn_co(s, srv_accept_loop, &a->l[spawned], 0, NULL) == 0) spawned++;
+    if (spawned < n) {
+        a->n = spawned;
+        kc_ipc_server_stop(a);
+        return -ENOMEM;
+    }
+    *out = a;
+    return 0;
+}
+
+void kc_ipc_server_stop(kc_ipc_acceptor_t *a)
+{
+    if (!a) return;
+    atomic_store(&a->stop, 1);
+    /* Wakes an acceptor parked on the descriptor; accepts fail from now on. */
+    for (size_t i = 0; i < a->n; i++) (void)shutdown(kc_ipc_srv_fd(a->l[i].srv), SHUT_RDWR);
+    for (size_t i = 0; i < a->n; i++) { int tok; (void)kc_chan_recv_thread(a->exited, &tok, -1); }
+    kc_chan_destroy(a->exited);
+    free(a);
+}
+
+unsigned long kc_ipc_server_accepted(const kc_ipc_acceptor_t *a)
+{
+    return a ? atomic_load_explicit(&((kc_ipc_acceptor_t*)a)->accepted, memory_order_relaxed) : 0;
+}
+
 /* Create server context */
 kc_ipc_server_ctx_t *kc_ipc_server_ctx_create(void)
 {
     kc_ipc_server_ctx_t *ctx = calloc(1, sizeof(*ctx));
     if (ctx) {
-        ctx->next_chan_id = 1000; /* Start IDs from 1000 */
+        pthread_mutex_init(&ctx->mu, NULL);
     }
     return ctx;
 }
 
+/* Register a channel the caller owns */
+int kc_ipc_server_export(kc_ipc_server_ctx_t *ctx, kc_chan_t *ch, int kind, size_t elem_sz,
+                         size_t capacity, uint32_t *out_id)
+{
+    if (!ctx || !ch || !out_id || elem_sz == 0) return -EINVAL;
+    struct kc_chan_entry *entry = malloc(sizeof(*entry));
+    if (!entry) return -ENOMEM;
+    entry->chan = ch;
+    entry->kind = kind;
+    entry->elem_sz = elem_sz;
+    entry->capacity = capacity;
+    entry->borrowed = 1;
+    int rc = srv_register(ctx, entry);
+    if (rc != 0) { free(entry); return rc; }
+    *out_id = entry->id;
+    return 0;
+}
+
 /* Destroy server context */
 void kc_ipc_server_ctx_destroy(kc_ipc_server_ctx_t *ctx)
 {
     if (!ctx) return;
     
     /* Clean up all channels */
-    while (ctx->channels) {
-        struct kc_chan_entry *entry = ctx->channels;
-        ctx->channels = entry->next;
-        kc_chan_destroy(entry->chan);
-        free(entry);
+    for (uint32_t k = 0; k < SRV_REG_CHUNKS; k++) {
+        struct srv_reg_chunk *c = atomic_load_explicit(&ctx->chunk[k], memory_order_relaxed);
+        if (!c) break;
+        for (uint32_t j = 0; j < SRV_REG_CHUNK; j++) {
+            struct kc_chan_entry *entry = atomic_load_explicit(&c->slot[j], memory_order_relaxed);
+            if (!entry) continue;
+            if (!entry->borrowed) kc_chan_destroy(entry->chan);
+            free(entry);
+        }
+        free(c);
     }
     
+    pthread_mutex_destroy(&ctx->mu);
     free(ctx);
 }
@@ -0,0 +1,236 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/*
+ * Shared-memory frame rings (same-host IPC)
+ * -----------------------------------------
+ *
+ * Layout
+ * - A header page (magic, ring size) and then two rings, client→server
+ *   first. Each ring starts with its indices and wait flags on separate
+ *   cache lines, followed by `cap` data bytes.
+ *
+ * Trust
+ * - The peer shares the mapping and could scribble on it. Indices and
+ *   record lengths read from the ring are bounds-checked before any copy,
+ *   so a bad peer gets -EPROTO rather than an overrun here.
+ *
+ * Portability
+ * - memfd_create on Linux; elsewhere shm_open on a throwaway name that is
+ *   unlinked at once, leaving only the descriptor.
+ */
+#ifdef __linux__
+#define _GNU_SOURCE 1 /* memfd_create */
+#endif
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include "kcoro_ipc_shm_internal.h"
+
+#define KC_SHM_MAGIC 0x6b637368u /* "kcsh" */
+#define KC_SHM_LINE  64
+
+struct kc_shm_ring {
+    _Atomic(uint64_t) head;          /* producer: bytes published */
+    char pad0[KC_SHM_LINE - sizeof(uint64_t)];
+    _Atomic(uint64_t) tail;          /* consumer: bytes released */
+    char pad1[KC_SHM_LINE - sizeof(uint64_t)];
+    _Atomic(uint32_t) rx_wait;       /* consumer parked for data */
+    _Atomic(uint32_t) tx_wait;       /* producer parked for room */
+    char pad2[KC_SHM_LINE - 2 * sizeof(uint32_t)];
+    uint8_t data[];
+};
+
+struct kc_shm_hdr {
+    uint32_t magic;
+    uint32_t rsvd;
+    uint64_t cap;
+};
+
+/* Record header in the ring. */
+struct kc_shm_rec {
+    uint32_t len;
+    uint16_t cmd;
+    uint16_t rsvd;
+};
+
+#define KC_SHM_HDR_LEN KC_SHM_LINE
+
+static size_t rec_size(size_t len) { return sizeof(struct kc_shm_rec) + ((len + 7) & ~(size_t)7); }
+static size_t ring_len(size_t cap) { return sizeof(kc_shm_ring_t) + cap; }
+
+static kc_shm_ring_t *ring_at(void *base, size_t cap, int i)
+{
+    return (kc_shm_ring_t*)((uint8_t*)base + KC_SHM_HDR_LEN + (size_t)i * ring_len(cap));
+}
+
+/* Copy across the ring end as needed; pos is a free-running index. */
+static void ring_write(kc_shm_ring_t *r, size_t cap, uint64_t pos, const void *src, size_t n)
+{
+    size_t off = (size_t)(pos & (cap - 1)), first = cap - off;
+    if (first > n) first = n;
+    memcpy(r->data + off, src, first);
+    if (n > first) memcpy(r->data, (const uint8_t*)src + first, n - first);
+}
+
+static void ring_read(const kc_shm_ring_t *r, size_t cap, uint64_t pos, void *dst, size_t n)
+{
+    size_t off = (size_t)(pos & (cap - 1)), first = cap - off;
+    if (first > n) first = n;
+    memcpy(dst, r->data + off, first);
+    if (n > first) memcpy((uint8_t*)dst + first, r->data, n - first);
+}
+
+static int shm_fd_open(void)
+{
+#ifdef __linux__
+    int fd = memfd_create("kcoro-ipc", MFD_CLOEXEC);
+    return fd < 0 ? -errno : fd;
+#else
+    char name[64];
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    snprintf(name, sizeof(name), "/kcoro-ipc-%ld-%ld", (long)getpid(), (long)ts.tv_nsec);
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) return -errno;
+    (void)shm_unlink(name);
+    (void)fcntl(fd, F_SETFD, FD_CLOEXEC);
+    return fd;
+#endif
+}
+
+int kc_shm_create(size_t cap, int *fd_out)
+{
+    if (!fd_out || cap < 4096 || (cap & (cap - 1))) return -EINVAL;
+    int fd = shm_fd_open();
+    if (fd < 0) return fd;
+    size_t len = KC_SHM_HDR_LEN + 2 * ring_len(cap);
+    if (ftruncate(fd, (off_t)len) != 0) { int e = -errno; close(fd); return e; }
+    void *base = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) { int e = -errno; close(fd); return e; }
+    /* ftruncate zero-fills: indices and flags start at 0. */
+    struct kc_shm_hdr *h = (struct kc_shm_hdr*)base;
+    h->cap = cap;
+    h->magic = KC_SHM_MAGIC;
+    munmap(base, len);
+    *fd_out = fd;
+    return 0;
+}
+
+int kc_shm_map(int fd, int server_side, kc_shm_t *out)
+{
+    if (fd < 0 || !out) return -EINVAL;
+    struct stat st;
+    if (fstat(fd, &st) != 0) return -errno;
+    size_t len = (size_t)st.st_size;
+    if (len < KC_SHM_HDR_LEN) return -EPROTO;
+    void *base = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) return -errno;
+    const struct kc_shm_hdr *h = (const struct kc_shm_hdr*)base;
+    size_t cap = (size_t)h->cap;
+    if (h->magic != KC_SHM_MAGIC || cap < 4096 || (cap & (cap - 1)) ||
+        len < KC_SHM_HDR_LEN + 2 * ring_len(cap)) {
+        munmap(base, len);
+        return -EPROTO;
+    }
+    out->base = base;
+    out->map_len = len;
+    out->cap = cap;
+    out->tx = ring_at(base, cap, server_side ? 1 : 0);
+    out->rx = ring_at(base, cap, server_side ? 0 : 1);
+    return 0;
+}
+
+void kc_shm_unmap(kc_shm_t *s)
+{
+    if (s && s->base) munmap(s->base, s->map_len);
+    if (s) memset(s, 0, sizeof(*s));
+}
+
+size_t kc_shm_max_payload(const kc_shm_t *s)
+{
+    return s->cap - sizeof(struct kc_shm_rec);
+}
+
+int kc_shm_put(kc_shm_t *s, uint16_t cmd, const void *payload, size_t len)
+{
+    struct iovec one = { (void*)payload, len };
+    return kc_shm_putv(s, cmd, &one, 1, len);
+}
+
+int kc_shm_putv(kc_shm_t *s, uint16_t cmd, const struct iovec *iov, int n, size_t len)
+{
+    kc_shm_ring_t *r = s->tx;
+    size_t need = rec_size(len);
+    if (need > s->cap || len > UINT32_MAX) return -EMSGSIZE;
+    uint64_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    uint64_t tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+    if (head - tail > s->cap || s->cap - (size_t)(head - tail) < need) return -EAGAIN;
+    struct kc_shm_rec rec = { .len = (uint32_t)len, .cmd = cmd, .rsvd = 0 };
+    ring_write(r, s->cap, head, &rec, sizeof(rec));
+    uint64_t at = head + sizeof(rec);
+    for (int i = 0; i < n; i++) {
+        if (!iov[i].iov_len) continue;
+        ring_write(r, s->cap, at, iov[i].iov_base, iov[i].iov_len);
+        at += iov[i].iov_len;
+    }
+    atomic_store(&r->head, head + need);
+    return 0;
+}
+
+int kc_shm_get(kc_shm_t *s, uint16_t *cmd, void *buf, size_t cap, size_t *len)
+{
+    kc_shm_ring_t *r = s->rx;
+    uint64_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    uint64_t head = atomic_load_explicit(&r->head, memory_order_acquire);
+    if (head == tail) return -EAGAIN;
+    uint64_t avail = head - tail;
+    if (avail > s->cap || avail < sizeof(struct kc_shm_rec)) return -EPROTO;
+    struct kc_shm_rec rec;
+    ring_read(r, s->cap, tail, &rec, sizeof(rec));
+    size_t need = rec_size(rec.len);
+    if (need > avail) return -EPROTO;
+    int rc = 0;
+    if (rec.len > cap) rc = -EMSGSIZE;
+    else if (rec.len) ring_read(r, s->cap, tail + sizeof(rec), buf, rec.len);
+    atomic_store(&r->tail, tail + need);
+    if (rc == 0) { *cmd = rec.cmd; *len = rec.len; }
+    return rc;
+}
+
+int kc_shm_arm_rx(kc_shm_t *s)
+{
+    atomic_store(&s->rx->rx_wait, 1);
+    return atomic_load(&s->rx->head) != atomic_load_explicit(&s->rx->tail, memory_order_relaxed);
+}
+
+int kc_shm_disarm_rx(kc_shm_t *s)
+{
+    return atomic_exchange(&s->rx->rx_wait, 0) == 0;
+}
+
+int kc_shm_arm_tx(kc_shm_t *s, size_t len)
+{
+    kc_shm_ring_t *r = s->tx;
+    atomic_store(&r->tx_wait, 1);
+    uint64_t used = atomic_load_explicit(&r->head, memory_order_relaxed) - atomic_load(&r->tail);
+    if (used > s->cap || s->cap - (size_t)used < rec_size(len)) return 0;
+    /* Room after all; a doorbell the peer already claimed does no harm. */
+    atomic_store(&r->tx_wait, 0);
+    return 1;
+}
+
+int kc_shm_claim_rx_wake(kc_shm_t *s)
+{
+    return atomic_load(&s->tx->rx_wait) && atomic_exchange(&s->tx->rx_wait, 0);
+}
+
+int kc_shm_claim_tx_wake(kc_shm_t *s)
+{
+    return atomic_load(&s->rx->tx_wait) && atomic_exchange(&s->rx->tx_wait, 0);
+}
@@ -0,0 +1,57 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+/* Shared-memory frame rings for same-host IPC connections (internal).
+ *
+ * One mapping holds two single-producer/single-consumer byte rings, one per
+ * direction. A record is an 8-byte header (payload length, cmd) followed by
+ * the payload, padded to 8 bytes; records wrap around the ring end. The
+ * producer publishes `head`, the consumer `tail`, both free-running.
+ *
+ * The rings never sleep on their own. A consumer that finds its ring empty
+ * arms `rx_wait` and rechecks; a producer that publishes into an armed ring
+ * claims the flag and must ring the peer's data doorbell. `tx_wait` is the
+ * same handshake for a producer waiting on space. Flags and indices are
+ * seq_cst so an arm and a publish can never both miss each other. */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/uio.h>
+
+typedef struct kc_shm_ring kc_shm_ring_t;
+
+typedef struct kc_shm {
+    void *base;
+    size_t map_len;
+    size_t cap;            /* data bytes per ring, a power of two */
+    kc_shm_ring_t *tx;     /* this side produces */
+    kc_shm_ring_t *rx;     /* this side consumes */
+} kc_shm_t;
+
+/* New anonymous mapping with both rings; *fd is its descriptor to pass on. */
+int  kc_shm_create(size_t cap, int *fd);
+/* Map fd; the server side produces into the server→client ring. */
+int  kc_shm_map(int fd, int server_side, kc_shm_t *out);
+void kc_shm_unmap(kc_shm_t *s);
+
+/* Largest payload one record can carry. */
+size_t kc_shm_max_payload(const kc_shm_t *s);
+
+/* 0, -EAGAIN when the ring lacks room, -EMSGSIZE when it never could. */
+int  kc_shm_put(kc_shm_t *s, uint16_t cmd, const void *payload, size_t len);
+/* kc_shm_put of the len bytes gathered from iov[0..n). */
+int  kc_shm_putv(kc_shm_t *s, uint16_t cmd, const struct iovec *iov, int n, size_t len);
+/* 0, -EAGAIN when empty, -EMSGSIZE when the payload exceeds cap (the record
+ * is skipped), -EPROTO when the peer corrupted the ring. */
+int  kc_shm_get(kc_shm_t *s, uint16_t *cmd, void *buf, size_t cap, size_t *len);
+
+/* Consumer: arm rx_wait; nonzero if a record is already there. */
+int  kc_shm_arm_rx(kc_shm_t *s);
+/* Consumer: drop an arm that found data; nonzero if the producer claimed it
+ * first (its doorbell is on the way). */
+int  kc_shm_disarm_rx(kc_shm_t *s);
+/* Producer: arm tx_wait; nonzero if len bytes already fit. */
+int  kc_shm_arm_tx(kc_shm_t *s, size_t len);
+/* After a put (producer) or get (consumer): nonzero if the peer was armed
+ * and now needs a doorbell. */
+int  kc_shm_claim_rx_wake(kc_shm_t *s);
+int  kc_shm_claim_tx_wake(kc_shm_t *s);
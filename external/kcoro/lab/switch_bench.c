@@ -0,0 +1,95 @@
+/* Lab: kcoro_switch ping-pong, kc_ctx_switch.S vs kc_ctx_switch_fast.S
+ *
+ * Two contexts hand control back and forth through the bare assembly switch
+ * (no kcoro_t, no scheduler), so the number is the switch itself. Built
+ * twice: lab_switch_bench against kc_ctx_switch.S and lab_switch_bench_fast
+ * against kc_ctx_switch_fast.S (-DFAST_SWITCH, which seeds the entry the
+ * way kcoro_seed_stack does under KCORO_FAST_SWITCH).
+ *
+ *   ./build/lab_switch_bench [round_trips]
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#define STACK_SIZE (64 * 1024)
+
+typedef struct {
+    void* reg[16];   /* kcoro_t layout: register file first */
+} lab_ctx_t;
+
+extern void* kcoro_switch(lab_ctx_t* from_co, lab_ctx_t* to_co);
+
+void kcoro_funcp_protector(void);
+void kcoro_funcp_protector(void)
+{
+    fprintf(stderr, "switch_bench: context function returned\n");
+    abort();
+}
+
+static lab_ctx_t main_ctx, task_ctx;
+static volatile long g_hops;
+
+static void task(void)
+{
+    for (;;) {
+        g_hops++;
+        kcoro_switch(&task_ctx, &main_ctx);
+    }
+}
+
+static void seed(lab_ctx_t* c, unsigned char* stack)
+{
+    uintptr_t top = ((uintptr_t)stack + STACK_SIZE) & ~0xFUL;
+    top -= 16;
+#if defined(__x86_64__)
+    top -= 8;
+    *(void**)top = NULL;
+#endif
+    c->reg[13] = (void*)task;
+    c->reg[14] = c->reg[15] = (void*)top;
+#if defined(FAST_SWITCH) && defined(__x86_64__)
+    top -= 8;
+    *(void**)top = c->reg[13];
+    c->reg[14] = (void*)top;
+    c->reg[5] = c->reg[15];
+#endif
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+int main(int argc, char** argv)
+{
+    long n = argc > 1 ? atol(argv[1]) : 20000000L;
+    unsigned char* stack = aligned_alloc(64, STACK_SIZE);
+    if (!stack || n <= 0) return 1;
+    seed(&task_ctx, stack);
+
+    for (long i = 0; i < n / 10; i++) kcoro_switch(&main_ctx, &task_ctx);   /* warm up */
+    g_hops = 0;
+    double t0 = now_ns();
+    for (long i = 0; i < n; i++) kcoro_switch(&main_ctx, &task_ctx);
+    double ns = now_ns() - t0;
+
+    if (g_hops != n) {
+        fprintf(stderr, "switch_bench: %ld hops for %ld round trips\n", (long)g_hops, n);
+        return 1;
+    }
+#ifdef FAST_SWITCH
+    const char* which = "kc_ctx_switch_fast.S";
+#else
+    const char* which = "kc_ctx_switch.S";
+#endif
+    printf("%-22s %ld round trips  %.2f ns/round trip  %.2f ns/switch\n",
+           which, n, ns / (double)n, ns / (double)n / 2.0);
+    free(stack);
+    return 0;
+}
@@ -0,0 +1,280 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/*
+ * chanmon_attach.c — read-only view of another process (kcoro_mon -a)
+ *
+ * Maps the target's stats segment (kcoro_statseg.h) and redraws from two
+ * consecutive samples: a per-worker utilization heatmap with queue/timer
+ * columns, the steal matrix for the last interval, and the registered
+ * channels by throughput with their blocked waiters. Nothing here runs
+ * kcoro code in the target; the sampling cost there is one relaxed read
+ * per counter per interval.
+ */
+#define _POSIX_C_SOURCE 199309L
+#define _GNU_SOURCE 1
+#include <errno.h>
+#include <ncurses.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "kcoro_statseg.h"
+
+int chanmon_attach_run(const char *target, bool headless, double duration_s, volatile bool *shutdown);
+
+#define HEAT_COLS 48     /* samples of history per worker row */
+static const char k_heat[] = " .:-=+*#%@";
+
+typedef struct attach_view {
+    kc_statseg_data_t *cur, *prev;
+    bool have_prev;
+    float heat[KC_STATSEG_WORKERS][HEAT_COLS]; /* utilization, <0: worker off */
+    int heat_pos, heat_n;
+} attach_view_t;
+
+static double attach_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void attach_sleep_ms(int ms)
+{
+    struct timespec ts = { ms / 1000, (long)(ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+static char heat_char(float u)
+{
+    if (u < 0) return ' ';
+    int i = (int)(u * (float)(sizeof(k_heat) - 2) + 0.5f);
+    if (i < 0) i = 0;
+    if (i > (int)sizeof(k_heat) - 2) i = (int)sizeof(k_heat) - 2;
+    return k_heat[i];
+}
+
+/* Utilization over the last interval: 1 - slept/elapsed. */
+static float worker_util(const attach_view_t *v, int i, double dt_ns)
+{
+    const kc_statseg_worker_t *w = &v->cur->w[i], *p = &v->prev->w[i];
+    if (!w->on) return -1.0f;
+    if (dt_ns <= 0) return 0.0f;
+    double slept = w->parked_ns >= p->parked_ns ? (double)(w->parked_ns - p->parked_ns) : 0.0;
+    double u = 1.0 - slept / dt_ns;
+    return (float)(u < 0 ? 0 : u > 1 ? 1 : u);
+}
+
+static void attach_push_heat(attach_view_t *v, double dt_ns)
+{
+    for (uint32_t i = 0; i < v->cur->workers; i++) v->heat[i][v->heat_pos] = worker_util(v, (int)i, dt_ns);
+    v->heat_pos = (v->heat_pos + 1) % HEAT_COLS;
+    if (v->heat_n < HEAT_COLS) v->heat_n++;
+}
+
+static double rate(uint64_t now, uint64_t was, double dt_s)
+{
+    return dt_s > 0 && now >= was ? (double)(now - was) / dt_s : 0.0;
+}
+
+/* Channel i's previous totals, matched by name (the publisher may reorder). */
+static const kc_statseg_chan_t *prev_chan(const attach_view_t *v, const kc_statseg_chan_t *c)
+{
+    for (uint32_t i = 0; i < v->prev->nchans; i++)
+        if (strcmp(v->prev->ch[i].name, c->name) == 0) return &v->prev->ch[i];
+    return NULL;
+}
+
+typedef struct chan_row { const kc_statseg_chan_t *c; double msgs, bytes; } chan_row_t;
+
+static int chan_row_cmp(const void *a, const void *b)
+{
+    const chan_row_t *x = (const chan_row_t*)a, *y = (const chan_row_t*)b;
+    return x->msgs < y->msgs ? 1 : x->msgs > y->msgs ? -1 : 0;
+}
+
+static int collect_chans(const attach_view_t *v, double dt_s, chan_row_t *rows)
+{
+    int n = 0;
+    for (uint32_t i = 0; i < v->cur->nchans; i++) {
+        const kc_statseg_chan_t *c = &v->cur->ch[i], *p = prev_chan(v, c);
+        rows[n].c = c;
+        rows[n].msgs = p ? rate(c->recvs, p->recvs, dt_s) : 0.0;
+        rows[n].bytes = p ? rate(c->bytes_recv, p->bytes_recv, dt_s) : 0.0;
+        n++;
+    }
+    qsort(rows, (size_t)n, sizeof(*rows), chan_row_cmp);
+    return n;
+}
+
+static void draw_attach(const attach_view_t *v, const char *name)
+{
+    const kc_statseg_data_t *d = v->cur, *p = v->prev;
+    double dt_s = v->have_prev ? (double)(d->sample_ns - p->sample_ns) / 1e9 : 0.0;
+    int rows, cols;
+    getmaxyx(stdscr, rows, cols);
+    erase();
+    int y = 0;
+    mvprintw(y++, 0, " KCoro Attach: %s  pid %d  sample %llu every %u ms   (q quit)",
+             name, d->pid, (unsigned long long)d->samples, d->interval_ms);
+    mvprintw(y++, 0, " workers %u/%u active   tasks/s %.0f   steals/s %.0f   parks/s %.0f   inject %llu  bulk %llu",
+             d->workers_active, d->workers_total,
+             rate(d->tasks_completed, p->tasks_completed, dt_s), rate(d->steals_succeeded, p->steals_succeeded, dt_s),
+             rate(d->park_events, p->park_events, dt_s),
+             (unsigned long long)d->inject_depth, (unsigned long long)d->bulk_depth);
+    y++;
+
+    /* Worker heatmap: newest sample on the right. */
+    int nw = (int)d->workers;
+    int wrows = rows / 2 - y - 1;
+    if (wrows > nw) wrows = nw;
+    mvprintw(y++, 0, " %-4s %-*s %6s %6s %3s %6s %8s %8s", "wkr", HEAT_COLS, "utilization (oldest -> newest)",
+             "util%", "deque", "rn", "timers", "parks/s", "steals/s");
+    unsigned timers_total = 0;
+    for (int i = 0; i < nw; i++) timers_total += d->w[i].timers;
+    for (int i = 0; i < wrows; i++) {
+        char bar[HEAT_COLS + 1];
+        memset(bar, ' ', HEAT_COLS);
+        bar[HEAT_COLS] = '\0';
+        for (int k = 0; k < v->heat_n; k++) {
+            int src = (v->heat_pos - v->heat_n + k + HEAT_COLS) % HEAT_COLS;
+            bar[HEAT_COLS - v->heat_n + k] = heat_char(v->heat[i][src]);
+        }
+        const kc_statseg_worker_t *w = &d->w[i];
+        float u = v->heat_n ? v->heat[i][(v->heat_pos + HEAT_COLS - 1) % HEAT_COLS] : 0.0f;
+        char util[8];
+        if (u < 0) snprintf(util, sizeof(util), "off");
+        else snprintf(util, sizeof(util), "%.0f", u * 100.0f);
+        mvprintw(y++, 0, " %-4d %s %6s %6u %3s %6u %8.0f %8.0f", i, bar, util, w->deque_depth,
+                 w->runnext ? "*" : "", w->timers,
+                 rate(w->parks, p->w[i].parks, dt_s), rate(w->steals, p->w[i].steals, dt_s));
+    }
+    if (wrows < nw) mvprintw(y++, 0, " ... %d more workers", nw - wrows);
+    mvprintw(y++, 0, " timer wheels: %u armed", timers_total);
+    y++;
+
+    /* Steal matrix (last interval): rows steal from columns. */
+    int half = y;
+    int mw = nw;
+    if (mw > (cols / 2 - 8) / 2) mw = (cols / 2 - 8) / 2;
+    if (mw > rows - y - 3) mw = rows - y - 3;
+    mvprintw(y++, 0, " steals thief\\victim %s", d->steal_valid ? "" : "(matrix off)");
+    if (mw > 0 && d->steal_valid) {
+        uint64_t max = 0;
+        for (int t = 0; t < mw; t++)
+            for (int c = 0; c < mw; c++) {
+                uint64_t dd = d->steal[t][c] - p->steal[t][c];
+                if (dd > max) max = dd;
+            }
+        move(y++, 6);
+        for (int c = 0; c < mw; c++) printw("%2d", c % 100);
+        for (int t = 0; t < mw; t++) {
+            mvprintw(y++, 1, "%4d ", t);
+            for (int c = 0; c < mw; c++) {
+                uint64_t dd = d->steal[t][c] - p->steal[t][c];
+                float u = max ? (float)dd / (float)max : 0.0f;
+                printw(" %c", t == c ? '\\' : dd ? heat_char(u < 0.12f ? 0.12f : u) : '.');
+            }
+        }
+        mvprintw(y++, 1, "max %llu per cell", (unsigned long long)max);
+    }
+
+    /* Channels by receive rate, to the right of the matrix. */
+    int cx = cols / 2, cy = half;
+    chan_row_t crow[KC_STATSEG_CHANS];
+    int nc = collect_chans(v, dt_s, crow);
+    mvprintw(cy++, cx, "%-20s %11s %9s %13s %4s %4s", "channel", "msgs/s", "MB/s", "depth/cap", "sndw", "rcvw");
+    for (int i = 0; i < nc && cy < rows - 1; i++) {
+        const kc_statseg_chan_t *c = crow[i].c;
+        char depth[32];
+        if (c->capacity) snprintf(depth, sizeof(depth), "%llu/%llu", (unsigned long long)c->count,
+                                  (unsigned long long)c->capacity);
+        else snprintf(depth, sizeof(depth), "%llu", (unsigned long long)c->count);
+        mvprintw(cy++, cx, "%-20.20s %11.0f %9.2f %13s %4u %4u%s", c->name, crow[i].msgs, crow[i].bytes / 1e6,
+                 depth, c->send_waiters, c->recv_waiters, c->closed ? " closed" : "");
+    }
+    if (d->chans_total > d->nchans)
+        mvprintw(cy++, cx, "(%u of %u registered channels)", d->nchans, d->chans_total);
+    else if (nc == 0)
+        mvprintw(cy++, cx, "(no channels registered with kc_metrics_register_chan)");
+    refresh();
+}
+
+static void print_attach(const attach_view_t *v)
+{
+    const kc_statseg_data_t *d = v->cur, *p = v->prev;
+    double dt_s = (double)(d->sample_ns - p->sample_ns) / 1e9;
+    printf("sample=%llu tasks/s=%.0f inject=%llu util=", (unsigned long long)d->samples,
+           rate(d->tasks_completed, p->tasks_completed, dt_s), (unsigned long long)d->inject_depth);
+    for (uint32_t i = 0; i < d->workers; i++) {
+        float u = v->heat[i][(v->heat_pos + HEAT_COLS - 1) % HEAT_COLS];
+        printf(u < 0 ? "%s-" : "%s%.0f", i ? "," : "", (double)u * 100.0);
+    }
+    chan_row_t crow[KC_STATSEG_CHANS];
+    int nc = collect_chans(v, dt_s, crow);
+    for (int i = 0; i < nc && i < 3; i++)
+        printf(" %s=%.0f/s(w%u/%u)", crow[i].c->name, crow[i].msgs, crow[i].c->send_waiters, crow[i].c->recv_waiters);
+    printf("\n");
+    fflush(stdout);
+}
+
+int chanmon_attach_run(const char *target, bool headless, double duration_s, volatile bool *shutdown)
+{
+    char name[64];
+    char *end = NULL;
+    long pid = strtol(target, &end, 10);
+    if (end && *end == '\0' && pid > 0) kc_statseg_default_name((int)pid, name, sizeof(name));
+    else snprintf(name, sizeof(name), "%s%s", target[0] == '/' ? "" : "/", target);
+
+    const kc_statseg_data_t *seg = NULL;
+    int rc = kc_statseg_attach(name, &seg);
+    if (rc != 0) {
+        fprintf(stderr, "attach %s: %s%s\n", name, strerror(-rc),
+                rc == -ENOENT ? " (is the target calling kc_statseg_publish?)" : "");
+        return 1;
+    }
+    attach_view_t *v = (attach_view_t*)calloc(1, sizeof(*v));
+    kc_statseg_data_t *a = (kc_statseg_data_t*)malloc(sizeof(*a)), *b = (kc_statseg_data_t*)malloc(sizeof(*b));
+    if (!v || !a || !b) { free(v); free(a); free(b); kc_statseg_detach(seg); return 2; }
+    v->cur = a;
+    v->prev = b;
+    if (kc_statseg_read(seg, v->prev) != 0) memset(v->prev, 0, sizeof(*v->prev));
+    if (!headless) {
+        initscr();
+        cbreak();
+        noecho();
+        nodelay(stdscr, TRUE);
+        curs_set(0);
+    }
+    double start = attach_now();
+    int interval = (int)v->prev->interval_ms > 0 ? (int)v->prev->interval_ms : 250;
+    while (!*shutdown) {
+        if (!headless) {
+            int ch = getch();
+            if (ch == 'q' || ch == 'Q') break;
+        }
+        attach_sleep_ms(interval);
+        if (kc_statseg_read(seg, v->cur) != 0) continue;
+        if (v->cur->samples == v->prev->samples) continue; /* publisher slower than us */
+        if (kill(v->cur->pid, 0) != 0 && v->cur->pid > 0) {
+            if (!headless) { mvprintw(0, 60, "[target exited]"); refresh(); }
+            else { printf("target %d exited\n", v->cur->pid); }
+            break;
+        }
+        double dt_ns = (double)(v->cur->sample_ns - v->prev->sample_ns);
+        attach_push_heat(v, dt_ns);
+        v->have_prev = true;
+        if (headless) print_attach(v);
+        else draw_attach(v, name);
+        kc_statseg_data_t *t = v->prev; v->prev = v->cur; v->cur = t;
+        if (duration_s > 0 && attach_now() - start >= duration_s) break;
+    }
+    if (!headless) endwin();
+    kc_statseg_detach(seg);
+    free(a);
+    free(b);
+    free(v);
+    return 0;
+}
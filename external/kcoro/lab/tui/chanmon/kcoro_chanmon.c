@@ -10,6 +10,9 @@
  *   - Fast-path hit ratio, steal success ratio, inject pulls
  *   - Graph repurposed to show tasks/sec
  *   - Toggle with 't' (or CLI -m tasks)
+ *
+ * Attach mode (-a PID|NAME, chanmon_attach.c): no benchmark; watch another
+ * process through its kc_statseg_publish segment.
  */
 
 #define _POSIX_C_SOURCE 199309L
@@ -36,8 +39,12 @@
 #include "kcoro.h" /* ensures struct kc_chan_rate_sample definition available */
 #include "kcoro_sched.h"    /* Scheduler stats for tasks mode */
 #include "kcoro_core.h"     /* Coroutine core functions */
+#include "kcoro_lockprof.h" /* Lock contention pane */
 #include "posix.h"          /* Error codes KC_EPIPE, KC_EAGAIN */
 
+/* chanmon_attach.c */
+int chanmon_attach_run(const char *target, bool headless, double duration_s, volatile bool *shutdown);
+
 /* Ensure new rate sample API visible even if an older installed kcoro.h was
  * picked up by build system include paths. Fallback local definition mirrors
  * library header and is compiled out when up-to-date header present. */
@@ -73,7 +80,8 @@ void kcoro_yield(void);
 #define MAX_HISTORY 100
 #define UPDATE_INTERVAL_MS 50
 #define STATS_WINDOW_SECS 5
-#define KCORO_MON_SCHEMA_VERSION 2
+#define KCORO_MON_SCHEMA_VERSION 4
+#define TOP_ROWS 16
 
 typedef enum {
     MODE_CHANNEL = 0,
@@ -91,6 +99,17 @@ typedef struct {
     int active_consumers;
 } perf_sample_t;
 
+/* Summary of one interval's latency histogram */
+typedef struct {
+    unsigned long count, p50, p99, p999, max;
+} lat_pcts_t;
+
+static lat_pcts_t lat_pcts(const struct kc_hist *h) {
+    lat_pcts_t p = { h->count, kc_hist_quantile(h, 0.50), kc_hist_quantile(h, 0.99),
+                     kc_hist_quantile(h, 0.999), h->max_ns };
+    return p;
+}
+
 typedef struct {
     int producers;
     int consumers;
@@ -98,6 +117,7 @@ typedef struct {
     size_t capacity;
     size_t packet_size;
     int spin_iters;
+    double rate;         /* open-loop offered packets/s (0 => closed loop) */
     bool running;
     monitor_mode_t mode; /* channel or tasks */
     
@@ -200,6 +220,20 @@ typedef struct {
     unsigned long rv_matches_delta;
     unsigned long rv_cancels_delta;
     unsigned long rv_zdesc_delta;
+
+    /* Latency over the last sample interval (ns): element queue time,
+     * send/recv blocking time, scheduler wake-to-resume, and in open loop
+     * scheduled send to receive */
+    lat_pcts_t lat_queue, lat_send_park, lat_recv_park, lat_wake, lat_e2e;
+
+    /* Top coroutines pane ('o'); previous read for per-interval CPU share */
+    bool show_top;
+    kcoro_stats_t top_prev[TOP_ROWS];
+    int top_prev_n;
+    double top_prev_ts;
+
+    /* Lock contention pane ('l') */
+    bool show_locks;
 } monitor_ctx_t;
 
 static monitor_ctx_t g_ctx;
@@ -288,6 +322,7 @@ static _Atomic int g_active_consumers = 0; /* number of live consumer coroutines
 
 static void co_producer(void *arg) {
     chan_prod_arg_t *pa = (chan_prod_arg_t*)arg; 
+    kcoro_set_name(kcoro_current(), "producer");
     /* pointer-first */
     static __thread unsigned char *buf = NULL;
     if (!buf) buf = aligned_alloc(64, pa->msg_size ? pa->msg_size : 64);
@@ -338,6 +373,7 @@ sent_label: ;
 
 static void co_consumer(void *arg) {
     chan_cons_arg_t *ca = (chan_cons_arg_t*)arg; 
+    kcoro_set_name(kcoro_current(), "consumer");
     void *ptr = NULL; size_t len = 0;
     static _Atomic int announced = 0;
     if (announced == 0) {
@@ -393,7 +429,8 @@ static void co_benchmark_coordinator(void *arg) {
         .packets_per_cycle = (ctx->n_packets > 0 ? ctx->n_packets : 100000),
         .spin_iters = ctx->spin_iters,
         .packet_size = ctx->packet_size,
-        .pointer_mode = 1
+        .pointer_mode = 1,
+        .rate = ctx->rate
     };
     kc_bench_handle_t *bh = NULL;
     kc_chan_t *persistent_ch = NULL;
@@ -401,6 +438,9 @@ static void co_benchmark_coordinator(void *arg) {
         fprintf(stderr, "[coord][ERR] failed to start bench\n");
         return;
     }
+    /* Histograms are read (and restarted) once per sample */
+    if (kc_chan_set_latency(persistent_ch, 1) != 0 || kc_sched_set_wake_latency(sched, 1) != 0)
+        fprintf(stderr, "[coord][WARN] latency histograms unavailable\n");
     
     int producers = ctx->producers > 0 ? ctx->producers : 1;
     int consumers = ctx->consumers > 0 ? ctx->consumers : 1;
@@ -433,6 +473,9 @@ static void co_benchmark_coordinator(void *arg) {
      * / consumer its own coroutine stack and allows blocking channel semantics if we
      * later switch away from try_* APIs. */
     int spawned_consumers = 0, spawned_producers = 0;
+    /* Open loop: the bench's paced producers own the channel, and its
+     * consumers read a stamp from every packet */
+    if (ctx->rate > 0) consumers = producers = 0;
     for (int i = 0; i < consumers; i++) {
         if (kc_spawn_co(sched, (kcoro_fn_t)co_consumer, &cargs[i], 0, NULL) != 0) {
             fprintf(stderr, "[coord][WARN] failed to spawn consumer %d (sched=%p)\n", i, (void*)sched);
@@ -516,6 +559,17 @@ static void co_benchmark_coordinator(void *arg) {
 
                 ctx->total_packets = snap.total_sends;
 
+                struct kc_chan_latency lat;
+                struct kc_hist wake;
+                if (kc_chan_get_latency(persistent_ch, &lat, 1) == 0) {
+                    ctx->lat_queue = lat_pcts(&lat.queue);
+                    ctx->lat_send_park = lat_pcts(&lat.send_park);
+                    ctx->lat_recv_park = lat_pcts(&lat.recv_park);
+                }
+                if (kc_sched_get_wake_latency(sched, &wake, 1) == 0) ctx->lat_wake = lat_pcts(&wake);
+                struct kc_hist e2e;
+                if (kc_bench_chan_latency(bh, &e2e, 1) == 0) ctx->lat_e2e = lat_pcts(&e2e);
+
                 if (rate.delta_sends || rate.delta_recvs) {
                     ctx->last_result.pps = pps;
                     ctx->last_result.gbps = gbps;
@@ -535,16 +589,18 @@ static void co_benchmark_coordinator(void *arg) {
             }
         }
         
-        /* Sample interval */
-        for (int i = 0; i < 50 && !g_shutdown; i++) { /* ~50ms */
-            kcoro_yield();
-        }
+        /* Sample interval: a timer, not yields, which return at once while
+         * an open-loop run leaves the workers idle */
+        kc_sleep_ms(50);
     }
     
     /* Cleanup */
     kc_bench_chan_stop(bh);
 }
 
+/* Latency fields are [count, p50, p99, p999, max] */
+#define LAT_ARGS(l) (l).count, (l).p50, (l).p99, (l).p999, (l).max
+
 /* Emit current metrics as NDJSON (channel mode) */
 static void emit_json_channel(monitor_ctx_t *ctx, const perf_sample_t *sample) {
     if (!ctx->json_out || !sample) return;
@@ -564,7 +620,10 @@ static void emit_json_channel(monitor_ctx_t *ctx, const perf_sample_t *sample) {
         "\"zref_sent_total\":%lu,\"zref_received_total\":%lu,\"zref_aborted_total\":%lu,"
         "\"zref_sent_delta\":%lu,\"zref_received_delta\":%lu,\"zref_aborted_delta\":%lu,"
         "\"rv_matches_total\":%lu,\"rv_cancels_total\":%lu,\"rv_zdesc_total\":%lu,"
-        "\"rv_matches_delta\":%lu,\"rv_cancels_delta\":%lu,\"rv_zdesc_delta\":%lu}\n",
+        "\"rv_matches_delta\":%lu,\"rv_cancels_delta\":%lu,\"rv_zdesc_delta\":%lu,"
+        "\"lat_queue_ns\":[%lu,%lu,%lu,%lu,%lu],\"lat_send_park_ns\":[%lu,%lu,%lu,%lu,%lu],"
+        "\"lat_recv_park_ns\":[%lu,%lu,%lu,%lu,%lu],\"lat_wake_ns\":[%lu,%lu,%lu,%lu,%lu],"
+        "\"offered_pps\":%.3f,\"lat_e2e_ns\":[%lu,%lu,%lu,%lu,%lu]}\n",
         KCORO_MON_SCHEMA_VERSION,
         sample->timestamp,
         sample->pps,
@@ -606,7 +665,13 @@ static void emit_json_channel(monitor_ctx_t *ctx, const perf_sample_t *sample) {
         ctx->rv_zdesc_total,
         ctx->rv_matches_delta,
         ctx->rv_cancels_delta,
-        ctx->rv_zdesc_delta);
+        ctx->rv_zdesc_delta,
+        LAT_ARGS(ctx->lat_queue),
+        LAT_ARGS(ctx->lat_send_park),
+        LAT_ARGS(ctx->lat_recv_park),
+        LAT_ARGS(ctx->lat_wake),
+        ctx->rate,
+        LAT_ARGS(ctx->lat_e2e));
     fflush(ctx->json_out);
 }
 
@@ -807,6 +872,18 @@ static void draw_stats(WINDOW *win, const monitor_ctx_t *ctx) {
         mvwprintw(win, y++, 2, "Rendezvous Delta: matches=%lu cancels=%lu desc=%lu",
                   ctx->rv_matches_delta, ctx->rv_cancels_delta, ctx->rv_zdesc_delta);
         y++;
+        mvwprintw(win, y++, 2, "Latency (last interval, us)   count      p50      p99     p999      max");
+        const struct { const char *name; const lat_pcts_t *l; } lat_rows[] = {
+            { "queue", &ctx->lat_queue }, { "send blocked", &ctx->lat_send_park },
+            { "recv blocked", &ctx->lat_recv_park }, { "sched wake", &ctx->lat_wake },
+            { "send to recv (open loop)", &ctx->lat_e2e },
+        };
+        for (size_t i = 0; i < sizeof(lat_rows) / sizeof(lat_rows[0]) - (ctx->rate > 0 ? 0 : 1); i++) {
+            const lat_pcts_t *l = lat_rows[i].l;
+            mvwprintw(win, y++, 4, "%-24s %8lu %8.1f %8.1f %8.1f %8.1f", lat_rows[i].name, l->count,
+                      l->p50 / 1e3, l->p99 / 1e3, l->p999 / 1e3, l->max / 1e3);
+        }
+        y++;
         mvwprintw(win, y++, 2, "Peak Performance:");
         mvwprintw(win, y++, 4, "PPS: %12.3f M", ctx->peak_pps / 1e6);
         mvwprintw(win, y++, 4, "Gbps: %11.3f", ctx->peak_gbps);
@@ -863,6 +940,7 @@ static void draw_main(WINDOW *win, const monitor_ctx_t *ctx) {
         mvwprintw(win, y++, 4, "Channel Capacity: %zu", ctx->capacity);
         mvwprintw(win, y++, 4, "Packet Size: %zu bytes", ctx->packet_size);
         mvwprintw(win, y++, 4, "Spin Iterations: %d", ctx->spin_iters);
+        if (ctx->rate > 0) mvwprintw(win, y++, 4, "Offered Load: %.0f packets/s (open loop)", ctx->rate);
     } else {
         mvwprintw(win, y++, 2, "Configuration (Tasks):");
         mvwprintw(win, y++, 4, "Workers: auto (scheduler default)");
@@ -887,6 +965,84 @@ static void draw_main(WINDOW *win, const monitor_ctx_t *ctx) {
     wrefresh(win);
 }
 
+// Draw top coroutines (by cumulative run time) in place of the graph
+static void draw_top(WINDOW *win, monitor_ctx_t *ctx) {
+    werase(win);
+    box(win, 0, 0);
+    mvwprintw(win, 0, 2, " Top Coroutines ");
+    kcoro_stats_t top[TOP_ROWS];
+    int rows = getmaxy(win) - 4;
+    if (rows > TOP_ROWS) rows = TOP_ROWS;
+    int n = rows > 0 ? kcoro_stats_top(top, (size_t)rows) : 0;
+    if (n < 0) {
+        mvwprintw(win, 2, 2, "Coroutine accounting compiled out (rebuild kcoro with make CO_STATS=1)");
+        wrefresh(win);
+        return;
+    }
+    double now = now_sec();
+    double dt = now - ctx->top_prev_ts;
+    mvwprintw(win, 1, 2, "%10s %-12s %-9s %6s %12s %10s %8s %12s",
+              "id", "name", "state", "cpu%", "run_ms", "switches", "parks", "parked_ms");
+    static const char *states[] = { "created", "ready", "running", "suspended", "parked", "finished" };
+    for (int i = 0; i < n; i++) {
+        const kcoro_stats_t *t = &top[i];
+        double cpu = -1.0;
+        for (int j = 0; j < ctx->top_prev_n && dt > 0; j++)
+            if (ctx->top_prev[j].id == t->id) {
+                cpu = (double)(t->run_ns - ctx->top_prev[j].run_ns) / (dt * 1e7);
+                break;
+            }
+        char cpu_s[16];
+        if (cpu < 0) snprintf(cpu_s, sizeof(cpu_s), "-");
+        else snprintf(cpu_s, sizeof(cpu_s), "%.1f", cpu);
+        mvwprintw(win, 2 + i, 2, "%10llu %-12.12s %-9s %6s %12.3f %10llu %8llu %12.3f",
+                  (unsigned long long)t->id, t->name ? t->name : "-",
+                  (unsigned)t->state < 6 ? states[t->state] : "?", cpu_s,
+                  (double)t->run_ns / 1e6, (unsigned long long)t->switches,
+                  (unsigned long long)t->parks, (double)t->parked_ns / 1e6);
+    }
+    memcpy(ctx->top_prev, top, (size_t)n * sizeof(top[0]));
+    ctx->top_prev_n = n;
+    ctx->top_prev_ts = now;
+    wrefresh(win);
+}
+
+// Draw KC_MUTEX call sites by total wait time in place of the graph
+static void draw_locks(WINDOW *win)
+{
+    werase(win);
+    box(win, 0, 0);
+    mvwprintw(win, 0, 2, " Lock Contention ");
+    kc_lockprof_adaptive_t ad;
+    if (kc_lockprof_adaptive(&ad) == 0)
+        mvwprintw(win, getmaxy(win) - 1, 2, " adaptive: contended %llu, spun %llu, sleeps %llu, wakes %llu ",
+                  (unsigned long long)ad.contended, (unsigned long long)ad.spin_acquired,
+                  (unsigned long long)ad.sleeps, (unsigned long long)ad.wakes);
+    kc_lockprof_site_t sites[TOP_ROWS];
+    int rows = getmaxy(win) - 4;
+    if (rows > TOP_ROWS) rows = TOP_ROWS;
+    int n = rows > 0 ? kc_lockprof_snapshot(sites, (size_t)rows) : 0;
+    if (n < 0) {
+        mvwprintw(win, 2, 2, "Lock profiling compiled out (rebuild kcoro with make LOCK_PROF=1)");
+        wrefresh(win);
+        return;
+    }
+    mvwprintw(win, 1, 2, "%-24s %-18s %12s %10s %6s %10s %9s %10s %9s",
+              "site", "lock", "acquired", "contended", "cont%", "wait_ms", "maxwt_us", "hold_ms", "maxhd_us");
+    for (int i = 0; i < n; i++) {
+        const kc_lockprof_site_t *l = &sites[i];
+        const char *base = strrchr(l->file, '/');
+        char where[48];
+        snprintf(where, sizeof(where), "%s:%d", base ? base + 1 : l->file, l->line);
+        mvwprintw(win, 2 + i, 2, "%-24.24s %-18.18s %12llu %10llu %6.2f %10.3f %9.1f %10.3f %9.1f",
+                  where, l->lock, (unsigned long long)l->acquisitions, (unsigned long long)l->contended,
+                  100.0 * (double)l->contended / (double)l->acquisitions,
+                  (double)l->wait_ns / 1e6, (double)l->max_wait_ns / 1e3,
+                  (double)l->hold_ns / 1e6, (double)l->max_hold_ns / 1e3);
+    }
+    wrefresh(win);
+}
+
 // Draw help window
 static void draw_help(WINDOW *win) {
     werase(win);
@@ -898,7 +1054,9 @@ static void draw_help(WINDOW *win) {
     mvwprintw(win, 3, 2, "r - Toggle Run/Stop");
     mvwprintw(win, 4, 2, "c - Clear statistics");
     mvwprintw(win, 5, 2, "t - Toggle Channel/Tasks");
-    mvwprintw(win, 6, 2, "h - Toggle help");
+    mvwprintw(win, 6, 2, "o - Top coroutines");
+    mvwprintw(win, 7, 2, "l - Lock contention");
+    mvwprintw(win, 8, 2, "h - Toggle help");
     
     wrefresh(win);
 }
@@ -918,7 +1076,7 @@ static void init_ui(monitor_ctx_t *ctx) {
     ctx->main_win = newwin(height/2, width/2, 0, 0);
     ctx->stats_win = newwin(height/2, width/2, 0, width/2);
     ctx->graph_win = newwin(height/2, width, height/2, 0);
-    ctx->help_win = newwin(8, 20, 2, width - 22);
+    ctx->help_win = newwin(10, 22, 2, width - 24);
     
     refresh();
 }
@@ -970,8 +1128,12 @@ static void ui_loop(monitor_ctx_t *ctx) {
             ctx->peak_gbps = 0;
             ctx->total_packets = 0;
             pthread_mutex_unlock(&ctx->stats_lock);
+            (void)kc_lockprof_reset();
+            (void)kc_lockprof_adaptive_reset();
             break;
         case 'h': case 'H': show_help = !show_help; break;
+        case 'o': case 'O': ctx->show_top = !ctx->show_top; ctx->show_locks = false; ctx->top_prev_n = 0; break;
+        case 'l': case 'L': ctx->show_locks = !ctx->show_locks; ctx->show_top = false; break;
         case 't': case 'T':
             ctx->mode = (ctx->mode == MODE_CHANNEL) ? MODE_TASKS : MODE_CHANNEL;
             /* Reset statistics when switching modes */
@@ -1062,7 +1224,9 @@ static void ui_loop(monitor_ctx_t *ctx) {
             // Draw UI
             draw_main(ctx->main_win, ctx);
             draw_stats(ctx->stats_win, ctx);
-            draw_graph(ctx->graph_win, ctx);
+            if (ctx->show_top) draw_top(ctx->graph_win, ctx);
+            else if (ctx->show_locks) draw_locks(ctx->graph_win);
+            else draw_graph(ctx->graph_win, ctx);
             if (show_help) draw_help(ctx->help_win);
             sleep_ms(UPDATE_INTERVAL_MS);
         } else {
@@ -1088,10 +1252,12 @@ static void usage(const char *prog) {
     printf("  -c, --capacity N     Channel capacity (default: 16384)\n");
     printf("  -k, --packet-size N  Packet size in bytes (default: 1500)\n");
     printf("  -s, --spin N         Spin iterations (default: 4096)\n");
+    printf("  -r, --rate N         Open loop: offer N packets/s, adds send-to-recv latency\n");
     printf("  -m, --mode M         Mode: channel|tasks (default: channel)\n");
     printf("  -H, --headless       Headless mode (no TUI, useful with -j/-d)\n");
     printf("  -d, --duration SEC   Run duration in seconds (headless)\n");
     printf("  -j, --json PATH      NDJSON export file\n");
+    printf("  -a, --attach PID|NAME  Watch another process's stats segment (kc_statseg_publish)\n");
     printf("\nEMA smoothing (alpha=0.25) active; mismatch messages tracked.\n");
     printf("  -h, --help           Show this help\n");
     printf("\nOptimal ARM64 configuration: -P 2 -C 2 -N 200000 -c 16384 -s 4096 -k 1500\n");
@@ -1118,16 +1284,19 @@ int main(int argc, char *argv[]) {
         {"capacity", required_argument, 0, 'c'},
         {"packet-size", required_argument, 0, 'k'},
         {"spin", required_argument, 0, 's'},
+        {"rate", required_argument, 0, 'r'},
         {"mode", required_argument, 0, 'm'},
         {"headless", no_argument, 0, 'H'},
         {"duration", required_argument, 0, 'd'},
         {"json", required_argument, 0, 'j'},
+        {"attach", required_argument, 0, 'a'},
         {"help", no_argument, 0, 'h'},
         {0, 0, 0, 0}
     };
     
+    const char *attach = NULL;
     int c;
-    while ((c = getopt_long(argc, argv, "P:C:N:c:k:s:m:Hd:j:h", long_options, NULL)) != -1) {
+    while ((c = getopt_long(argc, argv, "P:C:N:c:k:s:r:m:Hd:j:a:h", long_options, NULL)) != -1) {
         switch (c) {
         case 'P':
             g_ctx.producers = atoi(optarg);
@@ -1147,6 +1316,9 @@ int main(int argc, char *argv[]) {
         case 's':
             g_ctx.spin_iters = atoi(optarg);
             break;
+        case 'r':
+            g_ctx.rate = atof(optarg);
+            break;
         case 'm':
             if (strcasecmp(optarg, "tasks") == 0) g_ctx.mode = MODE_TASKS;
             else g_ctx.mode = MODE_CHANNEL;
@@ -1160,6 +1332,8 @@ int main(int argc, char *argv[]) {
             if (!g_ctx.json_out) { perror("json open"); return 2; }
             setvbuf(g_ctx.json_out, NULL, _IOLBF, 0); /* line buffered */
             break;
+        case 'a':
+            attach = optarg; break;
         case 'h':
             usage(argv[0]);
             return 0;
@@ -1172,6 +1346,8 @@ int main(int argc, char *argv[]) {
     // Setup signal handlers
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
+
+    if (attach) return chanmon_attach_run(attach, g_ctx.headless, g_ctx.run_duration_s, &g_shutdown);
     
     // Initialize mutex
     pthread_mutex_init(&g_ctx.stats_lock, NULL);
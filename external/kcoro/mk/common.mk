@@ -9,11 +9,41 @@ KC_BASE_CFLAGS := -std=c11 -Wall -Wextra -Werror -Wshadow -Wundef -Wpointer-arit
 # Optimization / debug defaults (override with OPT?=... or DEBUG=1)
 DEBUG ?= 0
 ifeq ($(DEBUG),1)
-  KC_OPTFLAGS := -O0 -g3 -fno-omit-frame-pointer
+  KC_OPTFLAGS := -O0 -g3 -fno-omit-frame-pointer -DKCORO_DEBUG_BUILD=1
 else
   KC_OPTFLAGS := -O2 -g
 endif
 
+# Per-coroutine run/park accounting (kcoro_stats); off by default
+CO_STATS ?= 0
+ifeq ($(CO_STATS),1)
+  KC_OPTFLAGS += -DKCORO_CO_STATS=1
+endif
+
+# KC_MUTEX contention profile (kcoro_lockprof.h); off by default
+LOCK_PROF ?= 0
+ifeq ($(LOCK_PROF),1)
+  KC_OPTFLAGS += -DKCORO_LOCK_PROF=1
+endif
+
+# Spin-then-futex KC_MUTEX_T (kcoro_config.h); off by default
+ADAPTIVE_MUTEX ?= 0
+ifeq ($(ADAPTIVE_MUTEX),1)
+  KC_OPTFLAGS += -DKCORO_ADAPTIVE_MUTEX=1
+endif
+
+# kcoro_switch from arch/<cpu>/kc_ctx_switch_fast.S (kcoro_config.h); off by default
+FAST_SWITCH ?= 0
+ifeq ($(FAST_SWITCH),1)
+  KC_OPTFLAGS += -DKCORO_FAST_SWITCH=1
+endif
+
+# Frame pointers everywhere, for kc_prof stack walks (kcoro_prof.h); off by default
+FRAME_POINTERS ?= 0
+ifeq ($(FRAME_POINTERS),1)
+  KC_OPTFLAGS += -fno-omit-frame-pointer -mno-omit-leaf-frame-pointer
+endif
+
 # Thread + position independent (for static + potential shared builds)
 KC_PLATFORM_FLAGS := -pthread -fPIC -MMD -MP -D_GNU_SOURCE
 
@@ -4,11 +4,11 @@
 #include <pthread.h>
 #include <errno.h>
 #include <time.h>
+#include <unistd.h>   /* _POSIX_TIMERS */
 
-#define KC_MUTEX_T            pthread_mutex_t
-#define KC_COND_T             pthread_cond_t
-
-#define KC_MUTEX_INIT(m)      pthread_mutex_init((m), NULL)
+/* Pthread condvars the runtime waits on with a deadline, the port's own
+ * included, are made with this; their deadlines are on
+ * KC_PORT_PTHREAD_COND_CLOCK. */
 static inline int kc_posix_cond_init_monotonic(pthread_cond_t *c)
 {
     pthread_condattr_t a;
@@ -26,18 +26,149 @@ static inline int kc_posix_cond_init_monotonic(pthread_cond_t *c)
     return rc;
 }
 
-#define KC_COND_INIT(c)       kc_posix_cond_init_monotonic((c))
-#define KC_MUTEX_DESTROY(m)    pthread_mutex_destroy((m))
-#define KC_COND_DESTROY(c)     pthread_cond_destroy((c))
+#if defined(__APPLE__) || defined(__MACH__)
+#define KC_PORT_PTHREAD_COND_CLOCK      CLOCK_REALTIME
+#else
+#define KC_PORT_PTHREAD_COND_CLOCK      CLOCK_MONOTONIC
+#endif
+
+#if defined(KCORO_ADAPTIVE_MUTEX) && KCORO_ADAPTIVE_MUTEX && (defined(__linux__) || defined(__APPLE__))
+/* Adaptive lock build (make ADAPTIVE_MUTEX=1, kc_amutex.c): a one-word
+ * mutex that spins a bounded KCORO_AMUTEX_SPIN rounds with a pause hint
+ * before sleeping on a futex (Linux) or __ulock (macOS), and a condvar on
+ * the same wait primitive. Uncontended lock and unlock are one atomic each
+ * and never enter the kernel. Other systems keep pthreads. */
+#include <stdint.h>
+#include <stdatomic.h>
+
+typedef struct kc_amutex {
+    _Atomic uint32_t state;   /* 0 free, 1 held, 2 held and a thread may sleep */
+} kc_amutex_t;
+
+typedef struct kc_acond {
+    _Atomic uint32_t seq;     /* bumped by every signal/broadcast */
+    _Atomic uint32_t waiters; /* lets signal skip the wake call */
+} kc_acond_t;
+
+/* Out of line, like the pthread calls they replace: inlined at every
+ * KC_MUTEX_LOCK site they bloat the channel hot paths measurably. */
+int  kc_amutex_lock(kc_amutex_t *m);
+int  kc_amutex_trylock(kc_amutex_t *m);
+int  kc_amutex_unlock(kc_amutex_t *m);
+/* abs: CLOCK_MONOTONIC deadline, NULL for none. 0 or ETIMEDOUT. */
+int  kc_acond_wait(kc_acond_t *c, kc_amutex_t *m, const struct timespec *abs);
+void kc_acond_wake(kc_acond_t *c, int all);
+
+static inline int kc_amutex_init(kc_amutex_t *m) { atomic_init(&m->state, 0); return 0; }
+static inline int kc_amutex_destroy(kc_amutex_t *m) { (void)m; return 0; }
+
+static inline int kc_acond_init(kc_acond_t *c)
+{
+    atomic_init(&c->seq, 0);
+    atomic_init(&c->waiters, 0);
+    return 0;
+}
+
+static inline int kc_acond_destroy(kc_acond_t *c) { (void)c; return 0; }
 
-#define KC_MUTEX_LOCK(m)      pthread_mutex_lock((m))
-#define KC_MUTEX_UNLOCK(m)    pthread_mutex_unlock((m))
+/* Waiters register under the mutex, so a signaller that changed the state
+ * under it sees them; with none, signalling costs one load. */
+static inline int kc_acond_signal(kc_acond_t *c, int all)
+{
+    if (!atomic_load_explicit(&c->waiters, memory_order_seq_cst)) return 0;
+    atomic_fetch_add_explicit(&c->seq, 1, memory_order_seq_cst);
+    kc_acond_wake(c, all);
+    return 0;
+}
+
+#define KC_PORT_ADAPTIVE_MUTEX 1
+#define KC_PORT_MUTEX_T                 kc_amutex_t
+#define KC_PORT_MUTEX_INIT(m)           kc_amutex_init((m))
+#define KC_PORT_MUTEX_DESTROY(m)        kc_amutex_destroy((m))
+#define KC_PORT_MUTEX_LOCK(m)           kc_amutex_lock((m))
+#define KC_PORT_MUTEX_TRYLOCK(m)        kc_amutex_trylock((m))
+#define KC_PORT_MUTEX_UNLOCK(m)         kc_amutex_unlock((m))
+#define KC_PORT_COND_T                  kc_acond_t
+#define KC_PORT_COND_CLOCK              CLOCK_MONOTONIC
+#define KC_PORT_COND_INIT(c)            kc_acond_init((c))
+#define KC_PORT_COND_DESTROY(c)         kc_acond_destroy((c))
+#define KC_PORT_COND_WAIT(c,m)          kc_acond_wait((c),(m),NULL)
+#define KC_PORT_COND_TIMEDWAIT_ABS(c,m,ts) kc_acond_wait((c),(m),(ts))
+#define KC_PORT_COND_SIGNAL(c)          kc_acond_signal((c),0)
+#define KC_PORT_COND_BROADCAST(c)       kc_acond_signal((c),1)
+#else
+#define KC_PORT_MUTEX_T                 pthread_mutex_t
+#define KC_PORT_MUTEX_INIT(m)           pthread_mutex_init((m), NULL)
+#define KC_PORT_MUTEX_DESTROY(m)        pthread_mutex_destroy((m))
+#define KC_PORT_MUTEX_LOCK(m)           pthread_mutex_lock((m))
+#define KC_PORT_MUTEX_TRYLOCK(m)        pthread_mutex_trylock((m))
+#define KC_PORT_MUTEX_UNLOCK(m)         pthread_mutex_unlock((m))
+#define KC_PORT_COND_T                  pthread_cond_t
+#define KC_PORT_COND_CLOCK              KC_PORT_PTHREAD_COND_CLOCK
+#define KC_PORT_COND_INIT(c)            kc_posix_cond_init_monotonic((c))
+#define KC_PORT_COND_DESTROY(c)         pthread_cond_destroy((c))
+#define KC_PORT_COND_WAIT(c,m)          pthread_cond_wait((c),(m))
+#define KC_PORT_COND_TIMEDWAIT_ABS(c,m,ts) pthread_cond_timedwait((c),(m),(ts))
+#define KC_PORT_COND_SIGNAL(c)          pthread_cond_signal((c))
+#define KC_PORT_COND_BROADCAST(c)       pthread_cond_broadcast((c))
+#endif
+
+#if defined(KCORO_LOCK_PROF) && KCORO_LOCK_PROF
+/* Contention profiling build (make LOCK_PROF=1): every KC_MUTEX_LOCK call
+ * site gets a static record of acquisitions, contended acquisitions, wait
+ * time and hold time, reported through kcoro_lockprof.h. Hold time is
+ * charged to the site that took the lock. Wraps whichever lock the port
+ * selected above. */
+#include <stdint.h>
+#include <stdatomic.h>
+
+typedef struct kc_lock_site {
+    const char *file;
+    int line;
+    const char *lock;                 /* the KC_MUTEX_LOCK argument, as text */
+    struct kc_lock_site *next;        /* registry list, set on first use */
+    _Atomic(int) registered;
+    _Atomic(uint64_t) acquisitions, contended;
+    _Atomic(uint64_t) wait_ns, max_wait_ns, hold_ns, max_hold_ns;
+} kc_lock_site_t;
+
+typedef struct kc_prof_mutex {
+    KC_PORT_MUTEX_T m;
+    kc_lock_site_t *site;             /* holder's site; written under m */
+    uint64_t acquired_ns;
+} kc_prof_mutex_t;
+
+int kc_lockprof_mutex_init(kc_prof_mutex_t *m);
+int kc_lockprof_lock(kc_prof_mutex_t *m, kc_lock_site_t *site);
+int kc_lockprof_unlock(kc_prof_mutex_t *m);
+int kc_lockprof_cond_wait(KC_PORT_COND_T *c, kc_prof_mutex_t *m);
+int kc_lockprof_cond_timedwait(KC_PORT_COND_T *c, kc_prof_mutex_t *m, const struct timespec *ts);
+
+#define KC_MUTEX_T            kc_prof_mutex_t
+#define KC_MUTEX_INIT(m)      kc_lockprof_mutex_init((m))
+#define KC_MUTEX_DESTROY(pm)  KC_PORT_MUTEX_DESTROY(&(pm)->m)
+#define KC_MUTEX_LOCK(m)      do { static kc_lock_site_t kc_site_ = { __FILE__, __LINE__, #m, 0, 0, 0, 0, 0, 0, 0, 0 }; \
+                                   kc_lockprof_lock((m), &kc_site_); } while (0)
+#define KC_MUTEX_UNLOCK(m)    kc_lockprof_unlock((m))
+#define KC_COND_WAIT(c,m)     kc_lockprof_cond_wait((c),(m))
+#define KC_COND_TIMEDWAIT_ABS(c,m,ts) kc_lockprof_cond_timedwait((c),(m),(ts))
+#else
+#define KC_MUTEX_T            KC_PORT_MUTEX_T
+#define KC_MUTEX_INIT(m)      KC_PORT_MUTEX_INIT((m))
+#define KC_MUTEX_DESTROY(m)   KC_PORT_MUTEX_DESTROY((m))
+#define KC_MUTEX_LOCK(m)      KC_PORT_MUTEX_LOCK((m))
+#define KC_MUTEX_UNLOCK(m)    KC_PORT_MUTEX_UNLOCK((m))
+#define KC_COND_WAIT(c,m)     KC_PORT_COND_WAIT((c),(m))
+#define KC_COND_TIMEDWAIT_ABS(c,m,ts) KC_PORT_COND_TIMEDWAIT_ABS((c),(m),(ts))
+#endif
+#define KC_COND_T             KC_PORT_COND_T
+#define KC_COND_CLOCK         KC_PORT_COND_CLOCK   /* clock of KC_COND_TIMEDWAIT_ABS deadlines */
 
-#define KC_COND_WAIT(c,m)     pthread_cond_wait((c),(m))
-#define KC_COND_TIMEDWAIT_ABS(c,m,ts) pthread_cond_timedwait((c),(m),(ts))
+#define KC_COND_INIT(c)       KC_PORT_COND_INIT((c))
+#define KC_COND_DESTROY(c)    KC_PORT_COND_DESTROY((c))
 
-#define KC_COND_SIGNAL(c)     pthread_cond_signal((c))
-#define KC_COND_BROADCAST(c)  pthread_cond_broadcast((c))
+#define KC_COND_SIGNAL(c)     KC_PORT_COND_SIGNAL((c))
+#define KC_COND_BROADCAST(c)  KC_PORT_COND_BROADCAST((c))
 
 #define KC_ALLOC(n)           malloc((n))
 #define KC_FREE(p)            free((p))
@@ -11,12 +11,74 @@
  * - Request/response correlation uses `KCORO_ATTR_REQ_ID` (32‑bit). Servers
  *   echo the client’s req_id in responses so clients can complete the correct
  *   awaiter.
+ * - A TLV whose 16-bit length reads 0xFFFF carries a 32-bit length right
+ *   after its header (ABI minor 1), so one element may exceed 64 KiB.
+ *
+ * Send credits (ABI minor 3)
+ * - A CHAN_SEND that carries KCORO_ATTR_CREDIT asks for credits; a
+ *   successful reply on a buffered channel grants up to that many, bounded
+ *   by the channel's free capacity at that moment. Each credit lets the
+ *   client post one CHAN_SEND marked KCORO_ATTR_CREDITED without waiting:
+ *   the server sends no reply to it and parks it, like any send, should the
+ *   room be gone by the time it arrives.
+ *
+ * Batches (ABI minor 4)
+ * - CHAN_SEND_BATCH carries KCORO_ATTR_COUNT elements back to back in one
+ *   KCORO_ATTR_ELEMENTS; the reply's COUNT says how many were queued, in
+ *   order, before RESULT stopped the batch. CHAN_RECV_BATCH asks for up to
+ *   COUNT, waits for the first, and replies with those it took. Both must
+ *   fit one frame; the timeout covers the whole batch.
+ *
+ * Compression (ABI minor 5)
+ * - On TCP, either HELLO may carry KCORO_CAP_LZ4; once both did, either
+ *   side may send KCORO_CMD_LZ4 in place of a run of frames. Its payload
+ *   is not TLV: the run's length as a big-endian u32, then the run (whole
+ *   frames, headers included, at most one frame's worth) as one LZ4 block.
+ *   The receiver unpacks it and takes the frames in order, as if they had
+ *   come one by one.
+ *
+ * Cancel (ABI minor 6)
+ * - CHAN_CANCEL names a parked request of the same connection by its
+ *   KCORO_ATTR_REQ_ID. If it is still waiting it ends with
+ *   RESULT=KC_ECANCELED and its usual reply; if it already finished (its
+ *   reply may be on the way) nothing happens. CHAN_CANCEL has no reply of
+ *   its own, and servers before minor 6 ignore it.
+ *
+ * Fixed layout (ABI minor 7)
+ * - Once both HELLOs carried KCORO_CAP_FIXED, CHAN_SEND, CHAN_RECV and the
+ *   two batch commands may go out with KCORO_CMD_FIXED or'ed into cmd. Such
+ *   a payload is not TLV: a struct kcoro_fixed_hdr (fields big-endian), then
+ *   `len` bytes of element data. The reply to a fixed request is fixed too,
+ *   with RESULT in `status` and COUNT or the granted CREDIT in `count`.
+ *   Every other command, and any request sent without the bit, stays TLV.
  */
 #pragma once
 
+#include <stdint.h>
+
 // Protocol version - used for compatibility checking between kcoro implementations
 #define KCORO_PROTO_ABI_MAJOR 1  // Major version - breaks compatibility on changes
-#define KCORO_PROTO_ABI_MINOR 0  // Minor version - additive features only
+#define KCORO_PROTO_ABI_MINOR 7  // Minor version - additive features only (1: CAPS, long TLVs; 2: regions; 3: credits; 4: batches; 5: LZ4; 6: cancel; 7: fixed layout)
+
+/* Capability bits carried in KCORO_ATTR_CAPS during HELLO */
+#define KCORO_CAP_SHM 0x1u  // Client: can use shared-memory rings; server: rings attached
+#define KCORO_CAP_LZ4 0x2u  // TCP: can unpack KCORO_CMD_LZ4 frames
+#define KCORO_CAP_FIXED 0x4u // Can decode KCORO_CMD_FIXED send/recv/batch frames
+
+/* Set in cmd: the payload is a struct kcoro_fixed_hdr plus data, not TLVs */
+#define KCORO_CMD_FIXED 0x8000u
+
+/* Fixed-layout header of the hot channel commands and their replies. One
+ * load decodes it; every field is big-endian on the wire. */
+struct kcoro_fixed_hdr {
+    uint32_t chan_id;   // KCORO_ATTR_CHAN_ID (echoed in replies)
+    uint32_t req_id;    // KCORO_ATTR_REQ_ID, 0 for none
+    uint32_t flags;     // KCORO_FIXED_*
+    uint32_t len;       // bytes of element data after the header
+    uint32_t status;    // request: TIMEOUT_MS; reply: RESULT
+    uint32_t count;     // batches: COUNT; CHAN_SEND: CREDIT wanted (request) or granted (reply)
+};
+#define KCORO_FIXED_CREDITED 0x1u // CHAN_SEND spends a credit: no reply (KCORO_ATTR_CREDITED)
 
 /* Commands (transport maps these to its own message types) */
 enum kcoro_cmd {
@@ -34,6 +96,21 @@ enum kcoro_cmd {
     KCORO_CMD_CHAN_CLOSE  = 15,   // Close a channel (graceful shutdown)
     KCORO_CMD_CHAN_DESTROY= 16,   // Destroy a channel (immediate cleanup)
 
+    /* Shared regions (same host): payloads travel as (region, offset, len) */
+    KCORO_CMD_REGION      = 17,   // Announce a region; its memfd rides as SCM_RIGHTS (no reply)
+    KCORO_CMD_CHAN_SEND_DESC = 18, // Send a region descriptor to a descriptor channel
+    KCORO_CMD_CHAN_RECV_DESC = 19, // Receive a region descriptor from a descriptor channel
+
+    /* Batches: many elements per frame */
+    KCORO_CMD_CHAN_SEND_BATCH = 22, // Send COUNT elements in order (kc_chan_send_many)
+    KCORO_CMD_CHAN_RECV_BATCH = 23, // Receive up to COUNT elements (kc_chan_recv_many)
+
+    /* Transport: a compressed run of frames (KCORO_CAP_LZ4) */
+    KCORO_CMD_LZ4 = 24,
+
+    /* Abort a parked request (select on remote channels) */
+    KCORO_CMD_CHAN_CANCEL = 25,   // REQ_ID: the request to end with KC_ECANCELED (no reply)
+
     /* Reserved for future (not implemented yet) */
     KCORO_CMD_GET_INFO    = 2,    // Retrieve information about the system or channel
     KCORO_CMD_GET_STATS   = 3,    // Get statistics about channel operations
@@ -56,6 +133,7 @@ enum kcoro_attr {
     /* Handshake (version/capability negotiation) */
     KCORO_ATTR_ABI_MAJOR = 1,  // Protocol major version (breaks on change)
     KCORO_ATTR_ABI_MINOR = 2,  // Protocol minor version (additive features)
+    KCORO_ATTR_CAPS      = 3,  // Capability flags (KCORO_CAP_*)
 
     /* Channel creation/ops (in use today) */
     KCORO_ATTR_KIND       = 5,  // Channel kind (RENDEZVOUS/BUFFERED/…)
@@ -68,9 +146,15 @@ enum kcoro_attr {
     KCORO_ATTR_ELEMENT    = 21, // Operation payload (send/recv element data)
     KCORO_ATTR_RESULT     = 22, // Operation result code (0 or negative KC_* error codes)
     KCORO_ATTR_REQ_ID     = 26, // 32-bit request correlation ID; echoed by server for response matching
+    KCORO_ATTR_REGION_ID  = 27, // u64 region ID in the sender's numbering (kc_region_export_id)
+    KCORO_ATTR_REGION_OFF = 28, // u64 payload offset within the region
+    KCORO_ATTR_REGION_LEN = 29, // u64 region size (REGION) or payload length (descriptor ops)
+    KCORO_ATTR_CREDIT     = 30, // u32 send credits: wanted (CHAN_SEND request) or granted (its reply)
+    KCORO_ATTR_CREDITED   = 31, // u32 flag on CHAN_SEND: spends a credit, no reply
+    KCORO_ATTR_COUNT      = 32, // u32 elements in a batch: carried/wanted (request), moved (reply)
+    KCORO_ATTR_ELEMENTS   = 33, // COUNT elements of the channel's size, back to back
 
     /* Reserved for future (not implemented yet) */
-    KCORO_ATTR_CAPS       = 3,  // Capabilities or feature flags
     KCORO_ATTR_ID         = 4,  // Generic identifier attribute
     KCORO_ATTR_SEND_OPS   = 9,  // Count of send operations performed
     KCORO_ATTR_RECV_OPS   = 10, // Count of receive operations performed
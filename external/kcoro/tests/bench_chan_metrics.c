@@ -8,6 +8,7 @@
 
 #include "kcoro_bench.h"
 #include "kcoro.h"
+#include "kcoro_sched.h"
 
 static double monotonic_sec(void) {
     struct timespec ts;
@@ -15,10 +16,27 @@ static double monotonic_sec(void) {
     return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
 }
 
+/* p50/p99/p999/max of one interval's histogram */
+struct lat_pcts { unsigned long p50, p99, p999, max; };
+
+static struct lat_pcts lat_pcts(const struct kc_hist *h) {
+    struct lat_pcts p = {
+        kc_hist_quantile(h, 0.50), kc_hist_quantile(h, 0.99),
+        kc_hist_quantile(h, 0.999), h->max_ns,
+    };
+    return p;
+}
+
 static void usage(const char *prog) {
     fprintf(stderr,
             "Usage: %s [-d duration_sec] [-i interval_sec] [-p producers] "
-            "[-c consumers] [-n packets_per_cycle] [-s packet_size_bytes] [-o output.jsonl]\n",
+            "[-c consumers] [-n packets_per_cycle] [-s packet_size_bytes] [-r rate] [-I] [-m] [-S] [-L] [-P] [-o output.jsonl]\n"
+            "  -r  open loop: offer this many packets/s in total; adds send-to-receive latency\n"
+            "  -I  int payload on a mutex-protected KC_BUFFERED channel\n"
+            "  -m  int payload on a lock-free MPMC ring channel (kc_chan_make_mpmc)\n"
+            "  -S  int payload on a wait-free SPSC ring channel, 1 producer x 1 consumer\n"
+            "  -L  latency histograms per interval: queue, send/recv park, scheduler wake\n"
+            "  -P  perf counters per interval, per packet sent (where perf events are available)\n",
             prog);
 }
 
@@ -38,7 +56,9 @@ int main(int argc, char **argv) {
 
     int opt;
     const char *out_path = NULL;
-    while ((opt = getopt(argc, argv, "d:i:p:c:n:s:o:h")) != -1) {
+    bool latency = false;
+    bool want_perf = false;
+    while ((opt = getopt(argc, argv, "d:i:p:c:n:s:r:ImSLPo:h")) != -1) {
         switch (opt) {
         case 'd': duration = atof(optarg); break;
         case 'i': interval = atof(optarg); break;
@@ -46,10 +66,17 @@ int main(int argc, char **argv) {
         case 'c': params.consumers = atoi(optarg); break;
         case 'n': params.packets_per_cycle = atoi(optarg); break;
         case 's': params.packet_size = strtoul(optarg, NULL, 10); params.pointer_mode = 1; break;
+        case 'r': params.rate = atof(optarg); break;
+        case 'I': params.pointer_mode = 0; params.mpmc = 0; break;
+        case 'm': params.pointer_mode = 0; params.mpmc = 1; break;
+        case 'S': params.pointer_mode = 0; params.spsc = 1; break;
+        case 'L': latency = true; break;
+        case 'P': want_perf = true; break;
         case 'o': out_path = optarg; break;
         case 'h': default: usage(argv[0]); return 1;
         }
     }
+    if (params.spsc) { params.producers = 1; params.consumers = 1; params.mpmc = 0; }
     if (duration <= 0.0) duration = 5.0;
     if (interval <= 0.0) interval = 0.5;
 
@@ -60,6 +87,21 @@ int main(int argc, char **argv) {
         return 1;
     }
 
+    if (latency && (kc_chan_set_latency(chan, 1) != 0 ||
+                    kc_sched_set_wake_latency(kc_sched_default(), 1) != 0)) {
+        fprintf(stderr, "enabling latency histograms failed\n");
+        kc_bench_chan_stop(handle);
+        return 1;
+    }
+
+    /* After start: the counters attach to the scheduler's worker threads */
+    kc_bench_perf_t *perf = NULL;
+    kc_bench_perf_sample_t perf_prev = {0}, perf_curr = {0};
+    if (want_perf) {
+        int prc = kc_bench_perf_open(&perf);
+        if (prc != 0) fprintf(stderr, "perf counters unavailable (%s), continuing without\n", strerror(-prc));
+    }
+
     FILE *out_file = NULL;
     if (out_path) {
         out_file = fopen(out_path, "w");
@@ -97,11 +139,34 @@ int main(int argc, char **argv) {
         kc_chan_compute_rate(&prev, &curr, &sample);
         double pps = sample.sends_per_sec;
         double gbps = (sample.bytes_sent_per_sec * 8.0) / 1e9;
+        /* Histograms cover the interval just ended: each read resets them */
+        struct kc_chan_latency lat = {0};
+        struct kc_hist wake = {0};
+        struct lat_pcts q = {0}, sp = {0}, rp = {0}, wk = {0}, e2e = {0};
+        struct kc_hist e2e_h = {0};
+        bool open_loop = params.rate > 0 && kc_bench_chan_latency(handle, &e2e_h, 1) == 0;
+        if (open_loop) e2e = lat_pcts(&e2e_h);
+        if (latency) {
+            kc_chan_get_latency(chan, &lat, 1);
+            kc_sched_get_wake_latency(kc_sched_default(), &wake, 1);
+            q = lat_pcts(&lat.queue);
+            sp = lat_pcts(&lat.send_park);
+            rp = lat_pcts(&lat.recv_park);
+            wk = lat_pcts(&wake);
+        }
+        /* Counter deltas over the interval, per packet sent */
+        double per_pkt[KC_BENCH_PERF_COUNT] = {0};
+        if (perf) {
+            kc_bench_perf_read(perf, &perf_curr);
+            for (int c = 0; c < KC_BENCH_PERF_COUNT; c++)
+                per_pkt[c] = sample.delta_sends ? (double)(perf_curr.value[c] - perf_prev.value[c]) / (double)sample.delta_sends : 0.0;
+            perf_prev = perf_curr;
+        }
         if (out_file) {
             fprintf(out_file,
                     "{\"interval_sec\":%.6f,\"pps\":%.3f,\"gbps\":%.6f,"
                     "\"delta_packets\":%lu,\"delta_bytes\":%lu,"
-                    "\"delta_rv_matches\":%lu,\"delta_rv_cancels\":%lu,\"delta_rv_zdesc\":%lu}\n",
+                    "\"delta_rv_matches\":%lu,\"delta_rv_cancels\":%lu,\"delta_rv_zdesc\":%lu",
                     sample.interval_sec,
                     pps,
                     gbps,
@@ -110,6 +175,29 @@ int main(int argc, char **argv) {
                     sample.delta_rv_matches,
                     sample.delta_rv_cancels,
                     sample.delta_rv_zdesc_matches);
+            if (open_loop)
+                fprintf(out_file,
+                        ",\"offered_pps\":%.3f,\"e2e_count\":%lu,\"e2e_p50_ns\":%lu,\"e2e_p99_ns\":%lu,"
+                        "\"e2e_p999_ns\":%lu,\"e2e_max_ns\":%lu",
+                        params.rate, e2e_h.count, e2e.p50, e2e.p99, e2e.p999, e2e.max);
+            if (latency) {
+                const struct { const char *name; const struct kc_hist *h; struct lat_pcts p; } rows[] = {
+                    {"queue", &lat.queue, q}, {"send_park", &lat.send_park, sp},
+                    {"recv_park", &lat.recv_park, rp}, {"wake", &wake, wk},
+                };
+                for (size_t r = 0; r < sizeof(rows) / sizeof(rows[0]); r++)
+                    fprintf(out_file,
+                            ",\"%s_count\":%lu,\"%s_p50_ns\":%lu,\"%s_p99_ns\":%lu,"
+                            "\"%s_p999_ns\":%lu,\"%s_max_ns\":%lu",
+                            rows[r].name, rows[r].h->count, rows[r].name, rows[r].p.p50,
+                            rows[r].name, rows[r].p.p99, rows[r].name, rows[r].p.p999,
+                            rows[r].name, rows[r].p.max);
+            }
+            if (perf)
+                for (int c = 0; c < KC_BENCH_PERF_COUNT; c++)
+                    if (perf_curr.valid & (1u << c))
+                        fprintf(out_file, ",\"%s_per_pkt\":%.4f", kc_bench_perf_name(c), per_pkt[c]);
+            fputs("}\n", out_file);
             fflush(out_file);
         } else {
             printf("interval %.3fs: packets/s %.2f, Gbps %.3f, rv_matches %lu, rv_cancels %lu, rv_zdesc %lu\n",
@@ -117,6 +205,20 @@ int main(int argc, char **argv) {
                    sample.delta_rv_matches,
                    sample.delta_rv_cancels,
                    sample.delta_rv_zdesc_matches);
+            if (open_loop)
+                printf("  offered %.0f/s, send-to-recv ns p50/p99/p999/max: %lu/%lu/%lu/%lu\n",
+                       params.rate, e2e.p50, e2e.p99, e2e.p999, e2e.max);
+            if (latency)
+                printf("  ns p50/p99/p999/max: queue %lu/%lu/%lu/%lu, send_park %lu/%lu/%lu/%lu, "
+                       "recv_park %lu/%lu/%lu/%lu, wake %lu/%lu/%lu/%lu\n",
+                       q.p50, q.p99, q.p999, q.max, sp.p50, sp.p99, sp.p999, sp.max,
+                       rp.p50, rp.p99, rp.p999, rp.max, wk.p50, wk.p99, wk.p999, wk.max);
+            if (perf) {
+                printf("  per packet:");
+                for (int c = 0; c < KC_BENCH_PERF_COUNT; c++)
+                    if (perf_curr.valid & (1u << c)) printf(" %s %.2f", kc_bench_perf_name(c), per_pkt[c]);
+                printf("\n");
+            }
         }
         total_packets += pps;
         total_gbps += gbps;
@@ -127,6 +229,7 @@ int main(int argc, char **argv) {
         prev = curr;
     }
 
+    kc_bench_perf_close(perf);
     kc_bench_chan_stop(handle);
     if (out_file) fclose(out_file);
 
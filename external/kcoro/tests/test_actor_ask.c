@@ -0,0 +1,134 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Test kc_actor_ask: replies to a thread and to concurrent coroutines,
+// handler failures and missing replies, an ask timing out before a slow
+// reply (which is then dropped), mailbox messages served alongside, asks
+// left queued at exit failing with KC_EPIPE, and -ENOTSUP without a handler
+#include <stdio.h>
+#include <assert.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_core.h"
+#include "../include/kcoro_port.h"
+
+#define ASKERS 4
+#define ASKS   1000
+#define SLOW   7
+
+static atomic_int mailbox_seen;
+static atomic_int askers_done;
+static int asker_bad;
+static int slow_rc = 1, queued_rc = 1;
+
+static int on_ask(const void *msg, kc_actor_reply_t *reply, void *user)
+{
+    (void)user;
+    long v = *(const long*)msg;
+    if (v < 0) return -EDOM;
+    if (v == 0) return 0; /* no reply */
+    if (v == SLOW) kc_sleep_ms(50);
+    long sq = v * v;
+    assert(kc_actor_reply(reply, &sq) == 0);
+    assert(kc_actor_reply(reply, &sq) == -EALREADY);
+    return 0;
+}
+
+static int on_msg(const void *msg, void *user)
+{
+    (void)msg; (void)user;
+    atomic_fetch_add(&mailbox_seen, 1);
+    return 0;
+}
+
+static void asker(void *arg)
+{
+    kc_actor_t a = (kc_actor_t)arg;
+    for (long i = 1; i <= ASKS; i++) {
+        long v = i % 100 + 10, out = 0;
+        if (kc_actor_ask(a, &v, &out, -1) != 0 || out != v * v) asker_bad++;
+    }
+    atomic_fetch_add(&askers_done, 1);
+}
+
+static void slow_asker(void *arg)
+{
+    long v = SLOW, out = 0;
+    slow_rc = kc_actor_ask((kc_actor_t)arg, &v, &out, -1);
+    atomic_fetch_add(&askers_done, 1);
+}
+
+static void queued_asker(void *arg)
+{
+    long v = 3, out = 0;
+    queued_rc = kc_actor_ask((kc_actor_t)arg, &v, &out, -1);
+    atomic_fetch_add(&askers_done, 1);
+}
+
+static void wait_askers(int want)
+{
+    for (int i = 0; i < 5000 && atomic_load(&askers_done) < want; i++) kc_sleep_ms(1);
+    assert(atomic_load(&askers_done) >= want);
+    atomic_store(&askers_done, 0);
+}
+
+int main(void)
+{
+    printf("[test] actor_ask start\n");
+    kc_sched_t *s = kc_sched_default();
+    kc_chan_t *mbox = NULL;
+    assert(kc_chan_make(&mbox, KC_BUFFERED, sizeof(long), 64) == 0);
+    kc_cancel_t *tok = NULL;
+    assert(kc_cancel_init(&tok) == 0);
+    kc_actor_ctx_ex_t ex = { .base = { .chan = mbox, .msg_size = sizeof(long), .timeout_ms = -1,
+                                        .process = on_msg, .ask = on_ask, .reply_size = sizeof(long) },
+                             .cancel = tok };
+    kc_actor_t a = kc_actor_start_ex(&ex);
+    assert(a);
+
+    /* From this thread */
+    long v = 12, out = 0;
+    assert(kc_actor_ask(a, &v, &out, -1) == 0 && out == 144);
+    v = -1;
+    assert(kc_actor_ask(a, &v, &out, 1000) == -EDOM);
+    v = 0;
+    assert(kc_actor_ask(a, &v, &out, 1000) == -ENOMSG);
+    assert(kc_actor_ask(a, &v, NULL, 1000) == -EINVAL);
+
+    /* Mailbox traffic and concurrent asking coroutines */
+    for (long i = 0; i < 32; i++) assert(kc_chan_send(mbox, &i, 0) == 0);
+    for (int i = 0; i < ASKERS; i++) assert(kc_spawn_co(s, asker, a, 0, NULL) == 0);
+    wait_askers(ASKERS);
+    assert(asker_bad == 0);
+    for (int i = 0; i < 2000 && atomic_load(&mailbox_seen) < 32; i++) kc_sleep_ms(1);
+    assert(atomic_load(&mailbox_seen) == 32);
+
+    /* A slow reply after the asker gave up is dropped */
+    v = SLOW; out = -5;
+    assert(kc_actor_ask(a, &v, &out, 10) == KC_ETIME);
+    kc_sleep_ms(80);
+    assert(out == -5);
+    v = 5;
+    assert(kc_actor_ask(a, &v, &out, -1) == 0 && out == 25);
+
+    /* Exit with an ask still queued behind a slow one */
+    assert(kc_spawn_co(s, slow_asker, a, 0, NULL) == 0);
+    kc_sleep_ms(10);
+    assert(kc_spawn_co(s, queued_asker, a, 0, NULL) == 0);
+    kc_sleep_ms(10);
+    kc_cancel_trigger(tok);
+    wait_askers(2);
+    assert(slow_rc == 0 && queued_rc == KC_EPIPE);
+    kc_actor_cancel(a);
+    kc_cancel_destroy(tok);
+
+    /* No handler */
+    kc_actor_ctx_t plain = { .chan = mbox, .msg_size = sizeof(long), .timeout_ms = -1, .process = on_msg };
+    a = kc_actor_start(&plain);
+    assert(a);
+    assert(kc_actor_ask(a, &v, &out, 10) == -ENOTSUP);
+    kc_actor_stop(a);
+    kc_chan_destroy(mbox);
+    printf("[test] actor_ask ok\n");
+    return 0;
+}
@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Test actor batching: a deep mailbox is handed to process_batch in runs of
+// at most batch_max, in order, and per-message process honours the budget
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <unistd.h>
+#include <stdatomic.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_core.h"
+#include "../include/kcoro_port.h"
+
+#define MSGS  1000
+#define BATCH 64
+
+struct tally { atomic_int seen; int calls, max_run, bad; };
+
+static int on_batch(const void *msgs, size_t n, void *user)
+{
+    struct tally *t = (struct tally*)user;
+    const int *m = (const int*)msgs;
+    int base = atomic_load(&t->seen);
+    for (size_t i = 0; i < n; i++) if (m[i] != base + (int)i) t->bad++;
+    t->calls++;
+    if ((int)n > t->max_run) t->max_run = (int)n;
+    atomic_fetch_add(&t->seen, (int)n);
+    return 0;
+}
+
+static int on_msg(const void *msg, void *user)
+{
+    struct tally *t = (struct tally*)user;
+    if (*(const int*)msg != atomic_load(&t->seen)) t->bad++;
+    t->calls++;
+    atomic_fetch_add(&t->seen, 1);
+    return 0;
+}
+
+struct feed { kc_chan_t *ch; volatile int done; int bad; };
+
+static void feeder(void *arg)
+{
+    struct feed *f = (struct feed*)arg;
+    static int v[MSGS];
+    for (int i = 0; i < MSGS; i++) v[i] = i;
+    size_t sent = 0;
+    if (kc_chan_send_many(f->ch, v, MSGS, -1, &sent) != 0 || sent != MSGS) f->bad++;
+    f->done = 1;
+}
+
+static void fill(kc_chan_t *ch)
+{
+    struct feed f = { .ch = ch };
+    assert(kc_spawn_co(kc_sched_default(), feeder, &f, 0, NULL) == 0);
+    for (int i = 0; i < 2000 && !f.done; i++) usleep(1000);
+    assert(f.done && f.bad == 0);
+}
+
+static void wait_seen(struct tally *t)
+{
+    for (int i = 0; i < 2000 && atomic_load(&t->seen) < MSGS; i++) usleep(1000);
+    assert(atomic_load(&t->seen) == MSGS && t->bad == 0);
+}
+
+int main(void)
+{
+    /* Queue everything first, then let a batching actor drain it */
+    kc_chan_t *ch = NULL;
+    assert(kc_chan_make(&ch, KC_BUFFERED, sizeof(int), MSGS) == 0);
+    fill(ch);
+    struct tally t = { 0 };
+    kc_actor_ctx_t ctx = { .chan = ch, .msg_size = sizeof(int), .user = &t,
+                           .batch_max = BATCH, .process_batch = on_batch };
+    kc_actor_t a = kc_actor_start(&ctx);
+    assert(a);
+    wait_seen(&t);
+    assert(t.max_run <= BATCH && t.calls >= MSGS / BATCH && t.calls < MSGS / 4);
+    kc_actor_stop(a);
+    kc_chan_destroy(ch);
+
+    /* Per-message process with a batch and a time budget */
+    assert(kc_chan_make(&ch, KC_BUFFERED, sizeof(int), MSGS) == 0);
+    fill(ch);
+    struct tally u = { 0 };
+    kc_actor_ctx_t ctx2 = { .chan = ch, .msg_size = sizeof(int), .user = &u, .process = on_msg,
+                            .batch_max = 128, .batch_us = 50 };
+    a = kc_actor_start(&ctx2);
+    assert(a);
+    wait_seen(&u);
+    assert(u.calls == MSGS);
+    kc_actor_stop(a);
+    kc_chan_destroy(ch);
+
+    printf("[actor batch] ok calls=%d max_run=%d\n", t.calls, t.max_run);
+    return 0;
+}
@@ -0,0 +1,122 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Test parked actors: idle actors use no CPU, messages still reach them, and
+// stop, cancel (also through a parent token) and mailbox close wake them
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <errno.h>
+#include <unistd.h>
+#include <stdatomic.h>
+#include <sys/resource.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_core.h"
+#include "../include/kcoro_port.h"
+
+#define ACTORS 16
+#define MSGS   100
+
+static atomic_int processed;
+static atomic_int finished;
+
+static int count_msg(const void *msg, void *user)
+{
+    (void)user;
+    if (*(const int*)msg >= 0) atomic_fetch_add(&processed, 1);
+    return 0;
+}
+
+static void on_done(void *arg)
+{
+    (void)arg;
+    atomic_fetch_add(&finished, 1);
+}
+
+struct feed { kc_chan_t **ch; volatile int done; int bad; };
+
+static void feeder(void *arg)
+{
+    struct feed *f = (struct feed*)arg;
+    for (int i = 0; i < MSGS; i++)
+        if (kc_chan_send(f->ch[i % ACTORS], &i, -1) != 0) f->bad++;
+    f->done = 1;
+}
+
+static long cpu_us(void)
+{
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000000L + ru.ru_utime.tv_usec + ru.ru_stime.tv_usec;
+}
+
+static void wait_for(atomic_int *v, int want)
+{
+    for (int i = 0; i < 2000 && atomic_load(v) < want; i++) usleep(1000);
+    assert(atomic_load(v) == want);
+}
+
+static int fired;
+static void note_fire(void *arg) { (void)arg; fired++; }
+
+int main(void)
+{
+    kc_chan_t *ch[ACTORS];
+    kc_actor_t a[ACTORS];
+    kc_cancel_t *root = NULL;
+    kc_cancel_ctx_t sub;
+    assert(kc_cancel_init(&root) == 0);
+    assert(kc_cancel_ctx_init(&sub, root) == 0);
+
+    for (int i = 0; i < ACTORS; i++) {
+        assert(kc_chan_make(&ch[i], KC_BUFFERED, sizeof(int), 8) == 0);
+        kc_actor_ctx_ex_t ex = { .base = { .chan = ch[i], .msg_size = sizeof(int), .process = count_msg } };
+        /* A quarter on the root token, a quarter on its child, the rest plain */
+        ex.cancel = (i % 4 == 0) ? root : (i % 4 == 1) ? sub.token : NULL;
+        a[i] = kc_actor_start_ex(&ex);
+        assert(a[i]);
+        kc_actor_on_done(a[i], on_done, NULL);
+    }
+
+    /* Idle: parked actors do not spin */
+    usleep(50000);
+    long t0 = cpu_us();
+    usleep(200000);
+    long idle = cpu_us() - t0;
+    assert(idle < 50000);
+
+    struct feed f = { .ch = ch };
+    assert(kc_spawn_co(kc_sched_default(), feeder, &f, 0, NULL) == 0);
+    for (int i = 0; i < 2000 && !f.done; i++) usleep(1000);
+    assert(f.done && f.bad == 0);
+    wait_for(&processed, MSGS);
+    assert(atomic_load(&finished) == 0);
+
+    /* Triggering the root wakes actors on it and on its child */
+    kc_cancel_trigger(root);
+    wait_for(&finished, ACTORS / 2);
+    assert(kc_cancel_is_set(sub.token));
+
+    /* Closing a mailbox ends its actor */
+    kc_chan_close(ch[2]);
+    wait_for(&finished, ACTORS / 2 + 1);
+
+    /* Stop wakes the remaining parked actors */
+    for (int i = 0; i < ACTORS; i++) kc_actor_stop(a[i]);
+    wait_for(&finished, ACTORS);
+
+    /* Watches: immediate on a triggered token, never after unwatch */
+    assert(kc_cancel_watch(root, note_fire, NULL) == 0 && fired == 1);
+    kc_cancel_t *t = NULL;
+    assert(kc_cancel_init(&t) == 0);
+    assert(kc_cancel_watch(t, note_fire, NULL) == 0 && fired == 1);
+    kc_cancel_unwatch(t, note_fire, NULL);
+    kc_cancel_trigger(t);
+    assert(fired == 1);
+    kc_cancel_destroy(t);
+
+    for (int i = 0; i < ACTORS; i++) kc_chan_destroy(ch[i]);
+    kc_cancel_ctx_destroy(&sub);
+    kc_cancel_destroy(root);
+    printf("[actor park] ok processed=%d idle_cpu_us=%ld\n", atomic_load(&processed), idle);
+    return 0;
+}
@@ -0,0 +1,117 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Test actor pools: round robin spreads evenly, least loaded balances stalled
+// mailboxes, hashing keeps keys on one member and moves few on resize, and
+// the parent token stops every member
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <unistd.h>
+#include <stdatomic.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_core.h"
+#include "../include/kcoro_port.h"
+
+static atomic_int processed;
+static volatile int gate = 1;
+
+static int on_msg(const void *msg, void *user)
+{
+    (void)msg; (void)user;
+    while (!gate) kc_sleep_ms(1);
+    atomic_fetch_add(&processed, 1);
+    return 0;
+}
+
+struct job { kc_actor_pool_t *p; int msgs; unsigned long key; int fixed; volatile int done; int bad; };
+
+static void sender(void *arg)
+{
+    struct job *j = (struct job*)arg;
+    for (int i = 0; i < j->msgs; i++) {
+        unsigned long key = j->fixed ? j->key : (unsigned long)i;
+        if (kc_actor_pool_send(j->p, key, &i, -1) != 0) j->bad++;
+    }
+    j->done = 1;
+}
+
+static void run(kc_actor_pool_t *p, int msgs, int fixed, unsigned long key)
+{
+    struct job j = { .p = p, .msgs = msgs, .fixed = fixed, .key = key };
+    assert(kc_spawn_co(kc_sched_default(), sender, &j, 0, NULL) == 0);
+    for (int i = 0; i < 2000 && !j.done; i++) usleep(1000);
+    assert(j.done && j.bad == 0);
+}
+
+static void wait_processed(int want)
+{
+    for (int i = 0; i < 2000 && atomic_load(&processed) < want; i++) usleep(1000);
+    assert(atomic_load(&processed) == want);
+}
+
+int main(void)
+{
+    kc_actor_pool_ctx_t ctx = { .base = { .msg_size = sizeof(int), .process = on_msg } };
+    struct kc_actor_pool_member_stats st[9];
+    assert(kc_actor_pool_start(&ctx, 0, KC_ACTOR_ROUTE_ROUND_ROBIN) == NULL);
+    assert(kc_actor_pool_start(&ctx, 2, 99) == NULL);
+
+    /* Round robin: an even split */
+    kc_actor_pool_t *p = kc_actor_pool_start(&ctx, 4, KC_ACTOR_ROUTE_ROUND_ROBIN);
+    assert(p && kc_actor_pool_size(p) == 4);
+    run(p, 400, 0, 0);
+    wait_processed(400);
+    assert(kc_actor_pool_snapshot(p, st, 9) == 4);
+    for (int i = 0; i < 4; i++) assert(st[i].routed == 100 && st[i].processed == 100 && st[i].queued == 0);
+    kc_actor_pool_stop(p);
+
+    /* Least loaded: with every member stalled, mailboxes fill evenly */
+    atomic_store(&processed, 0);
+    gate = 0;
+    p = kc_actor_pool_start(&ctx, 3, KC_ACTOR_ROUTE_LEAST_LOADED);
+    assert(p);
+    run(p, 3, 0, 0);        /* one in flight per member */
+    usleep(20000);
+    run(p, 30, 0, 0);
+    assert(kc_actor_pool_snapshot(p, st, 9) == 3);
+    for (int i = 0; i < 3; i++) assert(st[i].queued == 10);
+    gate = 1;
+    wait_processed(33);
+    kc_actor_pool_stop(p);
+
+    /* Hash: one key, one member; growing 8 -> 9 moves about 1/9 of keys */
+    atomic_store(&processed, 0);
+    p = kc_actor_pool_start(&ctx, 8, KC_ACTOR_ROUTE_HASH);
+    kc_actor_pool_t *q = kc_actor_pool_start(&ctx, 9, KC_ACTOR_ROUTE_HASH);
+    assert(p && q);
+    int home = kc_actor_pool_route(p, 12345);
+    run(p, 50, 1, 12345);
+    wait_processed(50);
+    assert(kc_actor_pool_snapshot(p, st, 9) == 8);
+    for (int i = 0; i < 8; i++) assert(st[i].routed == (i == home ? 50u : 0u));
+    int moved = 0, hit[9] = { 0 };
+    for (unsigned long k = 0; k < 9000; k++) {
+        int a = kc_actor_pool_route(p, k), b = kc_actor_pool_route(q, k);
+        assert(a >= 0 && a < 8 && b >= 0 && b < 9);
+        if (a != b) { moved++; assert(b == 8); }
+        hit[b]++;
+    }
+    assert(moved > 700 && moved < 1300);
+    for (int i = 0; i < 9; i++) assert(hit[i] > 700 && hit[i] < 1300);
+    kc_actor_pool_stop(q);
+    kc_actor_pool_stop(p);
+
+    /* The parent token ends the members; stop still cleans up */
+    kc_cancel_t *root = NULL;
+    assert(kc_cancel_init(&root) == 0);
+    ctx.cancel = root;
+    p = kc_actor_pool_start(&ctx, 4, KC_ACTOR_ROUTE_ROUND_ROBIN);
+    assert(p);
+    kc_cancel_trigger(root);
+    usleep(20000);
+    kc_actor_pool_stop(p);
+    kc_cancel_destroy(root);
+
+    printf("[actor pool] ok moved=%d/9000\n", moved);
+    return 0;
+}
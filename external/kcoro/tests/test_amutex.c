@@ -0,0 +1,100 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// KC_MUTEX_T / KC_COND_T under whichever lock the build picked (pthreads,
+// or the adaptive spin-then-futex lock with ADAPTIVE_MUTEX=1):
+// 1) threads hammer one counter; no increment may be lost.
+// 2) two threads ping-pong a turn variable through signal and broadcast.
+// 3) a timed wait nobody signals returns ETIMEDOUT after its deadline.
+// 4) kc_lockprof_adaptive reports -ENOTSUP, or counters that add up.
+#include <stdio.h>
+#include <errno.h>
+#include <time.h>
+#include <assert.h>
+#include <pthread.h>
+#include "../include/kcoro_config.h"
+#include "../include/kcoro_port.h"
+#include "../include/kcoro_lockprof.h"
+
+enum { THREADS = 4, PER_THREAD = 200000, ROUNDS = 20000 };
+
+static KC_MUTEX_T g_mu;
+static KC_COND_T g_cv;
+static unsigned long g_counter;
+static int g_turn;
+
+static void *bump(void *arg){
+    (void)arg;
+    for (int i = 0; i < PER_THREAD; i++) {
+        KC_MUTEX_LOCK(&g_mu);
+        g_counter++;
+        KC_MUTEX_UNLOCK(&g_mu);
+    }
+    return NULL;
+}
+
+static void *pong(void *arg){
+    int me = (int)(long)arg;
+    for (int i = 0; i < ROUNDS; i++) {
+        KC_MUTEX_LOCK(&g_mu);
+        while (g_turn != me) KC_COND_WAIT(&g_cv, &g_mu);
+        g_turn = !me;
+        if (i & 1) KC_COND_BROADCAST(&g_cv); else KC_COND_SIGNAL(&g_cv);
+        KC_MUTEX_UNLOCK(&g_mu);
+    }
+    return NULL;
+}
+
+static long long mono_ns(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+int main(void){
+    printf("[test] amutex start\n");
+    KC_MUTEX_INIT(&g_mu);
+    KC_COND_INIT(&g_cv);
+    kc_lockprof_adaptive_reset();
+
+    pthread_t t[THREADS];
+    for (long i = 0; i < THREADS; i++) assert(pthread_create(&t[i], NULL, bump, (void*)i) == 0);
+    for (int i = 0; i < THREADS; i++) pthread_join(t[i], NULL);
+    if (g_counter != (unsigned long)THREADS * PER_THREAD) {
+        fprintf(stderr, "counter=%lu\n", g_counter); return 1;
+    }
+
+    assert(pthread_create(&t[0], NULL, pong, (void*)0L) == 0);
+    assert(pthread_create(&t[1], NULL, pong, (void*)1L) == 0);
+    pthread_join(t[0], NULL);
+    pthread_join(t[1], NULL);
+
+    long long start = mono_ns();
+    struct timespec abs;
+    clock_gettime(CLOCK_MONOTONIC, &abs);
+    abs.tv_nsec += 30 * 1000000L;
+    if (abs.tv_nsec >= 1000000000L) { abs.tv_sec++; abs.tv_nsec -= 1000000000L; }
+    int rc = 0;
+    KC_MUTEX_LOCK(&g_mu);
+    while (rc == 0) rc = KC_COND_TIMEDWAIT_ABS(&g_cv, &g_mu, &abs);
+    KC_MUTEX_UNLOCK(&g_mu);
+    long long waited = mono_ns() - start;
+    if (rc != ETIMEDOUT || waited < 25 * 1000000LL) {
+        fprintf(stderr, "timedwait rc=%d waited=%lldns\n", rc, waited); return 4;
+    }
+
+    kc_lockprof_adaptive_t st;
+    rc = kc_lockprof_adaptive(&st);
+#if KCORO_ADAPTIVE_MUTEX && (defined(__linux__) || defined(__APPLE__))
+    if (rc != 0 || st.spin_acquired > st.contended) return 5;
+    printf("[test] amutex adaptive contended=%llu spun=%llu sleeps=%llu wakes=%llu\n",
+           (unsigned long long)st.contended, (unsigned long long)st.spin_acquired,
+           (unsigned long long)st.sleeps, (unsigned long long)st.wakes);
+#else
+    if (rc != -ENOTSUP || st.contended != 0) return 5;
+#endif
+    if (kc_lockprof_adaptive(NULL) != -EINVAL) return 6;
+
+    KC_COND_DESTROY(&g_cv);
+    KC_MUTEX_DESTROY(&g_mu);
+    printf("[test] amutex ok\n");
+    return 0;
+}
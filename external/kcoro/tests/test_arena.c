@@ -0,0 +1,90 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Test kc_arena: alignment, chunk growth, large allocations, mark/rewind,
+// reset, per-thread arenas, and scope arenas freed with their scope
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_arena.h"
+
+static void *local_thread(void *arg)
+{
+    kc_arena_t **out = (kc_arena_t**)arg;
+    *out = kc_arena_local();
+    assert(*out && kc_arena_local() == *out);
+    assert(kc_arena_alloc(*out, 100));
+    return NULL;
+}
+
+static volatile int ran;
+
+static void child(void *arg)
+{
+    (void)arg;
+    __atomic_add_fetch(&ran, 1, __ATOMIC_SEQ_CST);
+}
+
+int main(void)
+{
+    kc_arena_t *a = NULL;
+    assert(kc_arena_create(&a, 1024, 0) == 0 && a);
+
+    /* Aligned, distinct, writable */
+    char *p[64];
+    for (int i = 0; i < 64; i++) {
+        p[i] = (char*)kc_arena_alloc(a, (size_t)i + 1);
+        assert(p[i] && ((uintptr_t)p[i] & 15) == 0);
+        memset(p[i], i, (size_t)i + 1);
+    }
+    for (int i = 0; i < 64; i++) assert(p[i][i] == (char)i);
+    size_t used = kc_arena_used(a);
+    assert(used >= 64 * 16);
+
+    /* Large allocations stand alone; mark/rewind gives everything back */
+    kc_arena_mark_t m = kc_arena_mark(a);
+    char *big = (char*)kc_arena_alloc(a, 10000);
+    assert(big && ((uintptr_t)big & 15) == 0);
+    memset(big, 1, 10000);
+    int *z = (int*)kc_arena_calloc(a, 100, sizeof(int));
+    for (int i = 0; i < 100; i++) assert(z[i] == 0);
+    assert(kc_arena_used(a) >= used + 10000 + 400);
+    kc_arena_rewind(a, m);
+    assert(kc_arena_used(a) == used);
+    assert(p[63][63] == 63);
+
+    kc_arena_reset(a);
+    assert(kc_arena_used(a) == 0);
+    assert(kc_arena_alloc(a, 8));
+    kc_arena_destroy(a);
+
+    /* One arena per thread */
+    kc_arena_t *t1 = NULL, *t2 = NULL;
+    pthread_t th;
+    assert(pthread_create(&th, NULL, local_thread, &t1) == 0);
+    pthread_join(th, NULL);
+    assert(pthread_create(&th, NULL, local_thread, &t2) == 0);
+    pthread_join(th, NULL);
+    kc_arena_t *mine = kc_arena_local();
+    assert(mine && t1 && t2 && mine != t1 && mine != t2);
+
+    /* Scope arena: child records are recycled, so it stays small */
+    kc_scope_t *scope = NULL;
+    assert(kc_scope_init(&scope, NULL) == 0);
+    kc_arena_t *sa = kc_scope_arena(scope);
+    assert(sa && kc_scope_arena(scope) == sa);
+    assert(kc_arena_alloc(sa, 64));
+    for (int round = 0; round < 50; round++) {
+        for (int i = 0; i < 20; i++) assert(kc_scope_launch(scope, child, NULL, 0, NULL) == 0);
+        assert(kc_scope_wait_all(scope, 5000) == 0);
+    }
+    assert(ran == 1000);
+    size_t sused = kc_arena_used(sa);
+    assert(sused < 64 * 1024);
+    kc_scope_destroy(scope);
+    printf("[arena] ok scope_used=%zu\n", sused);
+    return 0;
+}
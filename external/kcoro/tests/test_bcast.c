@@ -0,0 +1,165 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Test broadcast channels: every SUSPEND subscriber sees every message in
+// order while the slowest paces the sender, DROP and CONFLATE subscribers
+// fall behind without holding it back, close drains then reports KC_EPIPE,
+// and pool buffers fan out with one reference per reader
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <unistd.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_zcopy.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_core.h"
+#include "../include/kcoro_port.h"
+
+#define MSGS 5000
+#define SUBS 16
+#define CAP  8
+
+static char arena[64 * 1024] __attribute__((aligned(64)));
+
+struct ctx {
+    kc_bcast_t *b;
+    kc_bcast_sub_t *subs[SUBS];
+    volatile int done, sent;
+    int bad;
+    long sum[SUBS];
+};
+
+struct reader { struct ctx *c; int id; };
+
+static void producer(void *arg)
+{
+    struct ctx *c = (struct ctx*)arg;
+    for (int i = 0; i < MSGS; i++)
+        if (kc_bcast_send(c->b, &i, -1) != 0) c->bad++;
+    kc_bcast_close(c->b);
+    int v = 0;
+    if (kc_bcast_send(c->b, &v, 0) != KC_EPIPE) c->bad++;
+    c->sent = 1;
+}
+
+static void reader(void *arg)
+{
+    struct reader *r = (struct reader*)arg;
+    struct ctx *c = r->c;
+    int v = 0, next = 0, rc;
+    while ((rc = kc_bcast_recv(c->subs[r->id], &v, -1)) == 0) {
+        if (v != next++) c->bad++;
+        c->sum[r->id] += v;
+        /* Readers run at different speeds */
+        if ((v + r->id) % 64 == 0) kcoro_yield();
+    }
+    if (rc != KC_EPIPE || next != MSGS) c->bad++;
+    __atomic_add_fetch(&c->done, 1, __ATOMIC_RELAXED);
+}
+
+/* Empty and full rings; timeouts */
+static void edges(void *arg)
+{
+    struct ctx *c = (struct ctx*)arg;
+    kc_bcast_t *b = NULL;
+    kc_bcast_sub_t *s = NULL;
+    int v = 0;
+    if (kc_bcast_make(&b, sizeof(int), 2) != 0 || kc_bcast_subscribe(b, &s, KC_BCAST_SUSPEND) != 0) { c->bad++; c->done = -1; return; }
+    if (kc_bcast_recv(s, &v, 0) != KC_EAGAIN || kc_bcast_recv(s, &v, 20) != KC_ETIME) c->bad++;
+    for (v = 0; v < 2; v++) if (kc_bcast_send(b, &v, 0) != 0) c->bad++;
+    if (kc_bcast_send(b, &v, 0) != KC_EAGAIN || kc_bcast_send(b, &v, 20) != KC_ETIME) c->bad++;
+    if (kc_bcast_recv(s, &v, 0) != 0 || v != 0 || kc_bcast_send(b, &v, 0) != 0) c->bad++;
+    /* Unsubscribing the only SUSPEND reader frees the sender */
+    kc_bcast_unsubscribe(s);
+    for (v = 0; v < 10; v++) if (kc_bcast_send(b, &v, 0) != 0) c->bad++;
+    kc_bcast_destroy(b);
+    c->done = -1;
+}
+
+static void pooled(void *arg)
+{
+    struct ctx *c = (struct ctx*)arg;
+    kc_region_t *reg = NULL;
+    kc_bufpool_t *pool = NULL;
+    kc_bcast_t *b = NULL;
+    kc_bcast_sub_t *s[3] = { 0 };
+    if (kc_region_register(&reg, arena, sizeof(arena), KC_REGION_F_NONE) != 0 ||
+        kc_bufpool_create(&pool, reg, 1024) != 0 || kc_bcast_make(&b, sizeof(void*), 4) != 0) {
+        c->bad++; c->done = -2; return;
+    }
+    kc_bcast_t *wide = NULL;
+    if (kc_bcast_make(&wide, 16, 4) != 0 || kc_bcast_set_bufpool(wide, pool) != -EINVAL) c->bad++;
+    kc_bcast_destroy(wide);
+    if (kc_bcast_set_bufpool(b, pool) != 0 || kc_bcast_set_bufpool(b, pool) != -EBUSY) c->bad++;
+    for (int i = 0; i < 3; i++) if (kc_bcast_subscribe(b, &s[i], KC_BCAST_DROP) != 0) c->bad++;
+    /* Ten buffers through a four-slot ring: readers see the last four */
+    for (int i = 0; i < 10; i++) {
+        unsigned char *p = kc_bufpool_get(pool);
+        if (!p) { c->bad++; break; }
+        memset(p, i, 1024);
+        if (kc_bcast_send(b, &p, 0) != 0) c->bad++;
+    }
+    struct kc_bufpool_stats ps;
+    if (kc_bufpool_get_stats(pool, &ps) != 0 || ps.in_use != 4) c->bad++;
+    for (int i = 0; i < 3; i++) {
+        for (int k = 6; k < 10; k++) {
+            unsigned char *p = NULL;
+            if (kc_bcast_recv(s[i], &p, 0) != 0 || !p || p[1023] != k) c->bad++;
+            else (void)kc_bufpool_release(pool, p);
+        }
+        struct kc_bcast_sub_stats st;
+        if (kc_bcast_sub_get_stats(s[i], &st) != 0 || st.received != 4 || st.dropped != 6 || st.lag != 0) c->bad++;
+    }
+    if (kc_bufpool_get_stats(pool, &ps) != 0 || ps.in_use != 4) c->bad++;
+    kc_bcast_destroy(b);
+    if (kc_bufpool_get_stats(pool, &ps) != 0 || ps.in_use != 0) c->bad++;
+    if (kc_bufpool_destroy(pool) != 0 || kc_region_deregister(reg) != 0) c->bad++;
+    c->done = -2;
+}
+
+int main(void)
+{
+    static struct ctx c;
+    static struct reader r[SUBS];
+    assert(kc_bcast_make(&c.b, sizeof(int), 0) == -EINVAL);
+    assert(kc_bcast_make(&c.b, sizeof(int), CAP) == 0);
+    for (int i = 0; i < SUBS; i++) assert(kc_bcast_subscribe(c.b, &c.subs[i], KC_BCAST_SUSPEND) == 0);
+    kc_bcast_sub_t *drop = NULL, *conf = NULL;
+    assert(kc_bcast_subscribe(c.b, &drop, KC_BCAST_DROP) == 0);
+    assert(kc_bcast_subscribe(c.b, &conf, KC_BCAST_CONFLATE) == 0);
+    assert(kc_bcast_subscribe(c.b, &drop, (enum kc_bcast_overflow)7) == -EINVAL);
+
+    for (int i = 0; i < SUBS; i++) {
+        r[i] = (struct reader){ &c, i };
+        assert(kc_spawn_co(kc_sched_default(), reader, &r[i], 0, NULL) == 0);
+    }
+    assert(kc_spawn_co(kc_sched_default(), producer, &c, 0, NULL) == 0);
+    for (int i = 0; i < 20000 && !(c.sent && c.done == SUBS); i++) usleep(1000);
+    assert(c.sent && c.done == SUBS && c.bad == 0);
+    for (int i = 0; i < SUBS; i++) assert(c.sum[i] == (long)MSGS * (MSGS - 1) / 2);
+
+    /* Nobody read these two: DROP kept the last CAP, CONFLATE the last one */
+    int v = -1;
+    struct kc_bcast_sub_stats st;
+    assert(kc_bcast_sub_get_stats(drop, &st) == 0 && st.lag == CAP && st.received == 0);
+    for (int k = MSGS - CAP; k < MSGS; k++) assert(kc_bcast_recv(drop, &v, 0) == 0 && v == k);
+    assert(kc_bcast_recv(drop, &v, 0) == KC_EPIPE);
+    assert(kc_bcast_sub_get_stats(drop, &st) == 0 && st.dropped == MSGS - CAP && st.received == CAP);
+    assert(kc_bcast_recv(conf, &v, 0) == 0 && v == MSGS - 1);
+    assert(kc_bcast_recv(conf, &v, 0) == KC_EPIPE);
+    assert(kc_bcast_sub_get_stats(conf, &st) == 0 && st.conflated == MSGS - 1 && st.received == 1);
+    kc_bcast_sub_t *late = NULL;
+    assert(kc_bcast_subscribe(c.b, &late, KC_BCAST_SUSPEND) == KC_EPIPE);
+    kc_bcast_unsubscribe(drop);
+    kc_bcast_destroy(c.b);
+
+    c.done = 0;
+    assert(kc_spawn_co(kc_sched_default(), edges, &c, 0, NULL) == 0);
+    for (int i = 0; i < 2000 && c.done != -1; i++) usleep(1000);
+    assert(c.done == -1 && c.bad == 0);
+    assert(kc_spawn_co(kc_sched_default(), pooled, &c, 0, NULL) == 0);
+    for (int i = 0; i < 2000 && c.done != -2; i++) usleep(1000);
+    assert(c.done == -2 && c.bad == 0);
+    printf("[bcast] ok msgs=%d subscribers=%d cap=%d\n", MSGS, SUBS, CAP);
+    return 0;
+}
@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Test the benchmark perf counters: names, argument checks, and that a
+// thread started after kc_bench_perf_open is counted (sleeps show up as
+// context switches, a loop as instructions). Where perf events are not
+// available the open must fail cleanly with -ENOTSUP or -EACCES.
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "../include/kcoro_bench.h"
+#include "../include/kcoro_sched.h"
+
+static void *sleeper(void *arg)
+{
+    (void)arg;
+    volatile unsigned long x = 0;
+    for (int i = 0; i < 20; i++) {
+        usleep(200);
+        for (int k = 0; k < 100000; k++) x += (unsigned long)k;
+    }
+    return NULL;
+}
+
+int main(void)
+{
+    assert(strcmp(kc_bench_perf_name(KC_BENCH_PERF_CYCLES), "cycles") == 0);
+    assert(strcmp(kc_bench_perf_name(KC_BENCH_PERF_CTX_SWITCHES), "ctx_switches") == 0);
+    assert(kc_bench_perf_name(-1) == NULL && kc_bench_perf_name(KC_BENCH_PERF_COUNT) == NULL);
+    int rc = kc_bench_perf_open(NULL);
+    assert(rc == -EINVAL || rc == -ENOTSUP);
+
+    (void)kc_sched_default();
+    kc_bench_perf_t *p = NULL;
+    rc = kc_bench_perf_open(&p);
+    if (rc == -ENOTSUP || rc == -EACCES) {
+        assert(p == NULL);
+        printf("[bench perf] ok (perf events unavailable: %s)\n", strerror(-rc));
+        return 0;
+    }
+    assert(rc == 0 && p);
+    kc_bench_perf_sample_t s;
+    assert(kc_bench_perf_read(NULL, &s) == -EINVAL && kc_bench_perf_read(p, NULL) == -EINVAL);
+
+    assert(kc_bench_perf_start(p) == 0);
+    pthread_t th;
+    assert(pthread_create(&th, NULL, sleeper, NULL) == 0);
+    pthread_join(th, NULL);
+    assert(kc_bench_perf_read(p, &s) == 0);
+    assert(s.valid != 0 && (s.valid >> KC_BENCH_PERF_COUNT) == 0);
+    for (int c = 0; c < KC_BENCH_PERF_COUNT; c++)
+        if (s.valid & (1u << c)) printf("[bench perf] %s %llu\n", kc_bench_perf_name(c), (unsigned long long)s.value[c]);
+    if (s.valid & (1u << KC_BENCH_PERF_CTX_SWITCHES)) assert(s.value[KC_BENCH_PERF_CTX_SWITCHES] >= 20);
+    if (s.valid & (1u << KC_BENCH_PERF_INSTRUCTIONS)) assert(s.value[KC_BENCH_PERF_INSTRUCTIONS] >= 2000000);
+
+    /* start marks a new zero point */
+    assert(kc_bench_perf_start(p) == 0);
+    kc_bench_perf_sample_t s2;
+    assert(kc_bench_perf_read(p, &s2) == 0);
+    if (s.valid & (1u << KC_BENCH_PERF_CTX_SWITCHES))
+        assert(s2.value[KC_BENCH_PERF_CTX_SWITCHES] < s.value[KC_BENCH_PERF_CTX_SWITCHES]);
+    kc_bench_perf_close(p);
+    kc_bench_perf_close(NULL);
+    printf("[bench perf] ok\n");
+    return 0;
+}
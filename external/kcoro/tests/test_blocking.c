@@ -0,0 +1,128 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Blocking offload
+// 1) outside a worker coroutine kc_run_blocking runs in place and
+//    kc_sched_block_begin refuses.
+// 2) on a one-worker scheduler, coroutines blocked in kc_run_blocking sit on
+//    pool threads at the same time while the worker keeps running others;
+//    each comes back to a worker of its scheduler (shared stacks included).
+// 3) kc_dispatcher_io runs tasks on the pool; its coroutines start there and
+//    move to the default scheduler at kc_sched_block_end.
+#include <stdio.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <stdatomic.h>
+#include <assert.h>
+#include <pthread.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_core.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_dispatch.h"
+#include "../include/kcoro_port.h"
+#include "../include/kcoro_config.h"
+
+enum { BLOCKERS = 8, BLOCK_MS = 200 };
+
+static kc_sched_t *g_s;
+static pthread_t g_worker;
+static _Atomic(int) g_ticks, g_stop_ticks, g_done, g_bad_pool, g_bad_back, g_io_task, g_io_co;
+
+static uint64_t now_ms(void){
+    struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+}
+
+static void block_call(void *arg){
+    int *on_pool = (int*)arg;
+    *on_pool = kc_sched_current() == NULL && !pthread_equal(pthread_self(), g_worker);
+    struct timespec ts = { 0, BLOCK_MS * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+static void blocker(void *arg){
+    long keep[4] = { (long)(intptr_t)arg, 7, 11, 13 };
+    int on_pool = 0;
+    assert(kc_run_blocking(block_call, &on_pool) == 0);
+    if (!on_pool) atomic_fetch_add(&g_bad_pool, 1);
+    if (kc_sched_current() != g_s || !pthread_equal(pthread_self(), g_worker) ||
+        keep[0] != (long)(intptr_t)arg || keep[1] + keep[2] + keep[3] != 31)
+        atomic_fetch_add(&g_bad_back, 1);
+    atomic_fetch_add(&g_done, 1);
+}
+
+static void ticker(void *arg){
+    (void)arg;
+    while (!atomic_load(&g_stop_ticks)) { atomic_fetch_add(&g_ticks, 1); kc_sleep_ms(5); }
+}
+
+static void who(void *arg){ (void)arg; g_worker = pthread_self(); atomic_store(&g_done, -1); }
+
+static void io_task(void *arg){
+    (void)arg;
+    atomic_store(&g_io_task, kc_sched_current() == NULL ? 1 : -1);
+}
+
+static void io_co(void *arg){
+    kc_sched_t *home = (kc_sched_t*)arg;
+    int ok = kc_sched_current() == NULL;
+    kc_sched_block_end();
+    ok = ok && kc_sched_current() == home;
+    atomic_store(&g_io_co, ok ? 1 : -1);
+}
+
+static int wait_for(_Atomic(int) *v, int want){
+    for (int i = 0; i < 2000 && atomic_load(v) != want; i++) kc_sleep_ms(5);
+    return atomic_load(v) == want;
+}
+
+int main(void){
+    printf("[test] blocking start\n");
+    int in_place = -1;
+    assert(kc_run_blocking(block_call, &in_place) == 0 && in_place == 1);
+    assert(kc_sched_block_begin() == -1);
+    kc_sched_block_end();
+    assert(kc_run_blocking(NULL, NULL) == -1);
+
+    kc_sched_opts_t opts = {0};
+    opts.workers = 1;
+    g_s = kc_sched_init(&opts); assert(g_s);
+    assert(kc_spawn(g_s, who, NULL) == 0);
+    if (!wait_for(&g_done, -1)) { fprintf(stderr, "worker never ran\n"); return 1; }
+    atomic_store(&g_done, 0);
+
+    kc_blocking_stats_t b0, b1;
+    kc_blocking_get_stats(&b0);
+    assert(kc_spawn_co(g_s, ticker, NULL, 0, NULL) == 0);
+    uint64_t t0 = now_ms();
+    for (int i = 0; i < BLOCKERS; i++) {
+        size_t st = (i & 1) ? KCORO_STACK_SHARED : 0;
+        assert(kc_spawn_co(g_s, blocker, (void*)(intptr_t)i, st, NULL) == 0);
+    }
+    if (!wait_for(&g_done, BLOCKERS)) { fprintf(stderr, "blockers done=%d\n", atomic_load(&g_done)); return 2; }
+    uint64_t took = now_ms() - t0;
+    atomic_store(&g_stop_ticks, 1);
+    int ticks = atomic_load(&g_ticks);
+    if (took >= (uint64_t)BLOCKERS * BLOCK_MS / 2) { fprintf(stderr, "blockers serialized: %llums\n", (unsigned long long)took); return 3; }
+    if (ticks < 5) { fprintf(stderr, "worker starved while blocked: ticks=%d\n", ticks); return 4; }
+    if (atomic_load(&g_bad_pool) || atomic_load(&g_bad_back)) {
+        fprintf(stderr, "bad pool=%d back=%d\n", atomic_load(&g_bad_pool), atomic_load(&g_bad_back)); return 5;
+    }
+    kc_blocking_get_stats(&b1);
+    if (b1.migrations - b0.migrations != BLOCKERS || b1.peak < BLOCKERS) {
+        fprintf(stderr, "stats migrations=%lu peak=%lu\n", b1.migrations - b0.migrations, b1.peak); return 6;
+    }
+    kc_sched_shutdown(g_s);
+
+    kc_dispatcher_t *io = kc_dispatcher_io(); assert(io);
+    assert(kc_dispatcher_spawn(io, io_task, NULL) == 0);
+    if (!wait_for(&g_io_task, 1)) { fprintf(stderr, "io task on a scheduler\n"); return 7; }
+    kc_sched_t *home = kc_dispatcher_scheduler(io);
+    assert(home == kc_sched_default());
+    assert(kc_dispatcher_spawn_co(io, io_co, home, 0, NULL) == 0);
+    if (!wait_for(&g_io_co, 1)) { fprintf(stderr, "io coroutine did not move: %d\n", atomic_load(&g_io_co)); return 8; }
+    if (kc_dispatcher_set_io_opts(NULL) != -EBUSY) { fprintf(stderr, "late io opts accepted\n"); return 9; }
+    kc_dispatcher_release(io);
+
+    printf("[test] blocking ok took=%llums ticks=%d peak=%lu\n", (unsigned long long)took, ticks, b1.peak);
+    return 0;
+}
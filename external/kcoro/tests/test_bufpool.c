@@ -0,0 +1,116 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Test kc_bufpool: buffers carved from a region, reference counts for
+// fan-out, return on last release, and the counters kc_chan_get_zstats shows
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <unistd.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_zcopy.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_core.h"
+
+#define ROUNDS 2000
+
+static char arena[64 * 1024] __attribute__((aligned(64)));
+
+struct ctx { kc_chan_t *ch; kc_bufpool_t *pool; volatile int prod_done, cons_done; int bad; };
+
+static void producer(void *arg)
+{
+    struct ctx *c = (struct ctx*)arg;
+    for (int i = 0; i < ROUNDS; i++) {
+        unsigned char *b;
+        while (!(b = kc_bufpool_get(c->pool))) kcoro_yield();
+        memset(b, (unsigned char)i, 64);
+        if (kc_chan_send_zref(c->ch, b, 64, -1) != 0) c->bad++;
+    }
+    c->prod_done = 1;
+}
+
+static void consumer(void *arg)
+{
+    struct ctx *c = (struct ctx*)arg;
+    for (int i = 0; i < ROUNDS; i++) {
+        void *p = NULL; size_t len = 0;
+        if (kc_chan_recv_zref(c->ch, &p, &len, -1) != 0) { c->bad++; continue; }
+        if (len != 64 || ((unsigned char*)p)[63] != (unsigned char)i) c->bad++;
+        if (kc_bufpool_release(c->pool, p) != 0) c->bad++;
+    }
+    c->cons_done = 1;
+}
+
+int main(void)
+{
+    kc_region_t *reg = NULL;
+    int rc = kc_region_register(&reg, arena, sizeof(arena), KC_REGION_F_NONE);
+    assert(rc == 0);
+    kc_bufpool_t *pool = NULL;
+    assert(kc_bufpool_create(&pool, reg, sizeof(arena) + 1) == -EINVAL);
+    rc = kc_bufpool_create(&pool, reg, 1000);
+    assert(rc == 0 && pool);
+    assert(kc_bufpool_buf_size(pool) == 1024);
+    assert(kc_bufpool_region(pool) == reg);
+
+    /* All 64 buffers, distinct and in the arena; then none */
+    void *got[64];
+    for (int i = 0; i < 64; i++) {
+        got[i] = kc_bufpool_get(pool);
+        assert(got[i] && (char*)got[i] >= arena && (char*)got[i] < arena + sizeof(arena));
+        for (int j = 0; j < i; j++) assert(got[j] != got[i]);
+    }
+    assert(kc_bufpool_get(pool) == NULL);
+    struct kc_bufpool_stats st;
+    assert(kc_bufpool_get_stats(pool, &st) == 0);
+    assert(st.capacity == 64 && st.in_use == 64 && st.empty == 1);
+    assert(kc_bufpool_destroy(pool) == -EBUSY);
+
+    /* Fan-out: three references, back on the third release */
+    assert(kc_bufpool_retain(pool, got[0]) == 0);
+    assert(kc_bufpool_retain(pool, (char*)got[0] + 10) == 0);
+    assert(kc_bufpool_release(pool, got[0]) == 0);
+    assert(kc_bufpool_release(pool, got[0]) == 0);
+    assert(kc_bufpool_get(pool) == NULL);
+    assert(kc_bufpool_release(pool, got[0]) == 0);
+    assert(kc_bufpool_release(pool, got[0]) == -EINVAL);
+    assert(kc_bufpool_retain(pool, got[0]) == -EINVAL);
+    static char other[64];
+    assert(kc_bufpool_release(pool, other) == -EINVAL);
+    void *again = kc_bufpool_get(pool);
+    assert(again == got[0]);
+    for (int i = 0; i < 64; i++) assert(kc_bufpool_release(pool, got[i]) == 0);
+
+    /* Producer and consumer coroutines cycle buffers through a zref channel */
+    kc_chan_t *ch = NULL;
+    rc = kc_chan_make_ptr(&ch, KC_BUFFERED, 16);
+    assert(rc == 0);
+    rc = kc_chan_enable_zero_copy_backend(ch, kc_zcopy_resolve("zref"), NULL);
+    assert(rc == 0);
+    assert(kc_chan_set_bufpool(ch, pool) == 0);
+    struct kc_bufpool_stats before;
+    (void)kc_bufpool_get_stats(pool, &before);
+    struct ctx c = { .ch = ch, .pool = pool };
+    rc = kc_spawn_co(kc_sched_default(), consumer, &c, 0, NULL);
+    assert(rc == 0);
+    rc = kc_spawn_co(kc_sched_default(), producer, &c, 0, NULL);
+    assert(rc == 0);
+    for (int i = 0; i < 10000 && !(c.prod_done && c.cons_done); i++) usleep(1000);
+    assert(c.prod_done && c.cons_done && c.bad == 0);
+
+    struct kc_chan_zstats zs;
+    assert(kc_chan_get_zstats(ch, &zs) == 0);
+    (void)kc_bufpool_get_stats(pool, &st);
+    assert(st.in_use == 0);
+    assert(zs.pool_hits == st.hits && zs.pool_misses == st.misses);
+    assert(st.hits + st.misses - st.empty >= before.hits + before.misses - before.empty + ROUNDS);
+    /* Buffers come back through the caches: the depot sees a fraction */
+    assert(st.hits - before.hits > 8 * (st.misses - before.misses));
+
+    kc_chan_destroy(ch);
+    assert(kc_bufpool_destroy(pool) == 0);
+    assert(kc_region_deregister(reg) == 0);
+    printf("[bufpool] ok hits=%lu misses=%lu empty=%lu\n", st.hits, st.misses, st.empty);
+    return 0;
+}
@@ -0,0 +1,133 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Test cancel wakeups: coroutines parked in _c channel ops return
+// KC_ECANCELED as soon as the token (or its parent) fires, well inside one
+// cancel slice, including thousands of them on shared stacks and ones that
+// race the trigger on their way into the park
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <time.h>
+#include <unistd.h>
+#include <stdatomic.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_core.h"
+#include "../include/kcoro_port.h"
+#include "../include/kcoro_config.h"
+
+#define FEW  64
+#define MANY 50000
+
+struct ctx {
+    kc_chan_t *ch;
+    const kc_cancel_t *tok;
+    long timeout_ms;
+    atomic_int parked, done, bad;
+};
+
+static void waiter(void *arg)
+{
+    struct ctx *c = (struct ctx*)arg;
+    int v;
+    atomic_fetch_add(&c->parked, 1);
+    int rc = kc_chan_recv_c(c->ch, &v, c->timeout_ms, c->tok);
+    if (rc != KC_ECANCELED) atomic_fetch_add(&c->bad, 1);
+    atomic_fetch_add(&c->done, 1);
+}
+
+static void sender(void *arg)
+{
+    struct ctx *c = (struct ctx*)arg;
+    int v = 1;
+    atomic_fetch_add(&c->parked, 1);
+    if (kc_chan_send_c(c->ch, &v, c->timeout_ms, c->tok) != KC_ECANCELED) atomic_fetch_add(&c->bad, 1);
+    atomic_fetch_add(&c->done, 1);
+}
+
+static void fill(void *arg)
+{
+    struct ctx *c = (struct ctx*)arg;
+    int v = 0;
+    if (kc_chan_send(c->ch, &v, 0) != 0) atomic_fetch_add(&c->bad, 1);
+    atomic_fetch_add(&c->done, 1);
+}
+
+static long now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000L + ts.tv_nsec / 1000;
+}
+
+static void wait_for(atomic_int *v, int want)
+{
+    for (int i = 0; i < 20000 && atomic_load(v) < want; i++) usleep(500);
+    assert(atomic_load(v) == want);
+}
+
+/* Spawn n coroutines on ch, let them park, fire root; returns the time from
+ * the trigger until the last one returned. */
+static long run(kc_chan_t *ch, kc_cancel_t *root, const kc_cancel_t *tok, int n, size_t stack,
+                long timeout_ms, void (*fn)(void*))
+{
+    struct ctx c = { .ch = ch, .tok = tok, .timeout_ms = timeout_ms };
+    for (int i = 0; i < n; i++) assert(kc_spawn_co(kc_sched_default(), fn, &c, stack, NULL) == 0);
+    wait_for(&c.parked, n);
+    usleep(5000);
+    assert(atomic_load(&c.done) == 0);
+    long t0 = now_us();
+    kc_cancel_trigger(root);
+    wait_for(&c.done, n);
+    long dt = now_us() - t0;
+    assert(atomic_load(&c.bad) == 0);
+    return dt;
+}
+
+int main(void)
+{
+    kc_chan_t *ch = NULL, *full = NULL;
+    assert(kc_chan_make(&ch, KC_RENDEZVOUS, sizeof(int), 0) == 0);
+    assert(kc_chan_make(&full, KC_BUFFERED, sizeof(int), 1) == 0);
+
+    /* A few receivers with no deadline, cancelled through a parent */
+    kc_cancel_t *root = NULL;
+    assert(kc_cancel_init(&root) == 0);
+    kc_cancel_ctx_t sub;
+    assert(kc_cancel_ctx_init(&sub, root) == 0);
+    long few_us = run(ch, root, sub.token, FEW, 0, -1, waiter);
+    assert(few_us < KCORO_CANCEL_SLICE_MS * 1000L / 2);
+    kc_cancel_ctx_destroy(&sub);
+    kc_cancel_destroy(root);
+
+    /* Senders on a full buffer with a finite timeout */
+    struct ctx f = { .ch = full };
+    assert(kc_spawn_co(kc_sched_default(), fill, &f, 0, NULL) == 0);
+    wait_for(&f.done, 1);
+    assert(atomic_load(&f.bad) == 0);
+    assert(kc_cancel_init(&root) == 0);
+    long send_us = run(full, root, root, FEW, 0, 10000, sender);
+    assert(send_us < KCORO_CANCEL_SLICE_MS * 1000L / 2);
+    kc_cancel_destroy(root);
+
+    /* Many parked receivers on shared stacks */
+    assert(kc_cancel_init(&root) == 0);
+    long many_us = run(ch, root, root, MANY, KCORO_STACK_SHARED, -1, waiter);
+    kc_cancel_destroy(root);
+
+    /* Trigger while the receivers are still on their way into the park */
+    for (int round = 0; round < 20; round++) {
+        assert(kc_cancel_init(&root) == 0);
+        struct ctx c = { .ch = ch, .tok = root, .timeout_ms = -1 };
+        for (int i = 0; i < FEW; i++) assert(kc_spawn_co(kc_sched_default(), waiter, &c, 0, NULL) == 0);
+        if (round & 1) usleep(50);
+        kc_cancel_trigger(root);
+        wait_for(&c.done, FEW);
+        assert(atomic_load(&c.bad) == 0);
+        kc_cancel_destroy(root);
+    }
+
+    kc_chan_destroy(full);
+    kc_chan_destroy(ch);
+    printf("[cancel wake] ok few=%ldus send=%ldus many=%d in %ldus\n", few_us, send_us, MANY, many_us);
+    return 0;
+}
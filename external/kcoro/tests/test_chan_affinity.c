@@ -0,0 +1,122 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Wake placement: receivers on scheduler B are woken by senders on
+// scheduler A. With KC_AFFINITY_HOME every wake goes back to the receiver's
+// last worker (counted as home_wakes); with the default none does. A
+// FOLLOW_PRODUCER ping-pong inside one scheduler delivers every message in
+// order while senders are sent home. Bad modes are refused.
+#include <stdio.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <assert.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_port.h"
+
+enum { RECEIVERS = 8, MSGS = 200, ROUNDS = 2000 };
+
+static kc_chan_t *g_ch, *g_ping, *g_pong;
+static _Atomic(int) g_got, g_done, g_bad;
+
+static void receiver(void *arg){
+    (void)arg;
+    int v;
+    for (int i = 0; i < MSGS; i++) {
+        if (kc_chan_recv(g_ch, &v, 5000) != 0) { atomic_fetch_add(&g_bad, 1); break; }
+        atomic_fetch_add(&g_got, 1);
+    }
+    atomic_fetch_add(&g_done, 1);
+}
+
+static void sender(void *arg){
+    (void)arg;
+    for (int i = 0; i < MSGS; i++)
+        if (kc_chan_send(g_ch, &i, 5000) != 0) atomic_fetch_add(&g_bad, 1);
+}
+
+static void pinger(void *arg){
+    (void)arg;
+    for (int i = 0; i < ROUNDS; i++) {
+        int v = -1;
+        if (kc_chan_send(g_ping, &i, 5000) != 0 || kc_chan_recv(g_pong, &v, 5000) != 0 || v != i)
+            atomic_fetch_add(&g_bad, 1);
+    }
+    atomic_fetch_add(&g_done, 1);
+}
+
+static void ponger(void *arg){
+    (void)arg;
+    for (int i = 0; i < ROUNDS; i++) {
+        int v = -1;
+        if (kc_chan_recv(g_ping, &v, 5000) != 0 || v != i || kc_chan_send(g_pong, &v, 5000) != 0)
+            atomic_fetch_add(&g_bad, 1);
+    }
+    atomic_fetch_add(&g_done, 1);
+}
+
+/* Cross-scheduler run on a fresh rendezvous channel; returns B's home wakes. */
+static long run_remote(int mode){
+    kc_sched_opts_t oa = {0}, ob = {0};
+    oa.workers = 2;
+    ob.workers = 2;
+    kc_sched_t *a = kc_sched_init(&oa), *b = kc_sched_init(&ob);
+    assert(a && b);
+    assert(kc_chan_make(&g_ch, KC_RENDEZVOUS, sizeof(int), 0) == 0);
+    assert(kc_chan_set_affinity(g_ch, mode) == 0);
+    atomic_store(&g_got, 0);
+    atomic_store(&g_done, 0);
+
+    kc_sched_stats_t st0, st;
+    kc_sched_get_stats(b, &st0);
+    for (int i = 0; i < RECEIVERS; i++) assert(kc_spawn_co(b, receiver, NULL, 0, NULL) == 0);
+    kc_sleep_ms(5);
+    for (int i = 0; i < RECEIVERS; i++) assert(kc_spawn_co(a, sender, NULL, 0, NULL) == 0);
+    for (int i = 0; i < 2000 && atomic_load(&g_done) < RECEIVERS; i++) kc_sleep_ms(5);
+    kc_sched_get_stats(b, &st);
+    long home = atomic_load(&g_got) == RECEIVERS * MSGS ? (long)(st.home_wakes - st0.home_wakes) : -1;
+
+    kc_sched_shutdown(a);
+    kc_sched_shutdown(b);
+    kc_chan_destroy(g_ch);
+    return home;
+}
+
+int main(void){
+    printf("[test] chan_affinity start\n");
+    assert(kc_chan_make(&g_ch, KC_BUFFERED, sizeof(int), 4) == 0);
+    assert(kc_chan_set_affinity(g_ch, -1) == -EINVAL);
+    assert(kc_chan_set_affinity(g_ch, KC_AFFINITY_HOME + 1) == -EINVAL);
+    assert(kc_chan_set_affinity(NULL, KC_AFFINITY_HOME) == -EINVAL);
+    kc_chan_destroy(g_ch);
+
+    long waker = run_remote(KC_AFFINITY_WAKER);
+    long home = run_remote(KC_AFFINITY_HOME);
+    if (waker != 0 || home <= 0 || atomic_load(&g_bad)) {
+        fprintf(stderr, "waker=%ld home=%ld bad=%d\n", waker, home, atomic_load(&g_bad));
+        return 1;
+    }
+
+    kc_sched_opts_t o = {0};
+    o.workers = 2;
+    kc_sched_t *s = kc_sched_init(&o);
+    assert(s);
+    assert(kc_chan_make(&g_ping, KC_BUFFERED, sizeof(int), 1) == 0);
+    assert(kc_chan_make(&g_pong, KC_BUFFERED, sizeof(int), 1) == 0);
+    assert(kc_chan_set_affinity(g_ping, KC_AFFINITY_FOLLOW_PRODUCER) == 0);
+    assert(kc_chan_set_affinity(g_pong, KC_AFFINITY_FOLLOW_PRODUCER) == 0);
+    atomic_store(&g_done, 0);
+    assert(kc_spawn_co(s, ponger, NULL, 0, NULL) == 0);
+    assert(kc_spawn_co(s, pinger, NULL, 0, NULL) == 0);
+    for (int i = 0; i < 4000 && atomic_load(&g_done) < 2; i++) kc_sleep_ms(5);
+    if (atomic_load(&g_done) != 2 || atomic_load(&g_bad)) {
+        fprintf(stderr, "done=%d bad=%d\n", atomic_load(&g_done), atomic_load(&g_bad));
+        return 2;
+    }
+    kc_sched_stats_t st;
+    kc_sched_get_stats(s, &st);
+
+    kc_sched_shutdown(s);
+    kc_chan_destroy(g_ping);
+    kc_chan_destroy(g_pong);
+    printf("[test] chan_affinity ok home=%ld ping-pong home=%lu\n", home, st.home_wakes);
+    return 0;
+}
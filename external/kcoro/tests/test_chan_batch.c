@@ -0,0 +1,165 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Batch channel ops (kc_chan_send_many / kc_chan_recv_many and _ptr_ variants)
+// 1) buffered: partial try-send reports KC_EAGAIN with the count queued, runs
+//    wrap around the ring, FIFO holds, stats count every element once.
+// 2) unlimited grows to fit a whole batch; rendezvous falls back per element.
+// 3) pointer descriptors: bytes are accounted by len.
+// 4) a batching producer and consumer on a small ring: every value arrives
+//    once, in order, and close ends the consumer with EPIPE.
+#include <stdio.h>
+#include <stdatomic.h>
+#include <assert.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_core.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_port.h"
+
+enum { ITEMS = 100000, BATCH = 37 };
+
+static kc_chan_t *g_ch, *g_rv;
+static _Atomic(int) g_stage;
+static _Atomic(int) g_recvd;
+static _Atomic(int) g_out_of_order;
+static int g_basic_ok, g_rv_got;
+
+static void producer(void *arg){
+    (void)arg;
+    int buf[BATCH];
+    for (int base = 0; base < ITEMS; base += BATCH) {
+        int n = ITEMS - base < BATCH ? ITEMS - base : BATCH;
+        for (int i = 0; i < n; i++) buf[i] = base + i;
+        size_t sent = 0;
+        int rc = (base / BATCH) & 1 ? kc_chan_send_many(g_ch, buf, (size_t)n, -1, &sent)
+                                    : kc_chan_send_many(g_ch, buf, (size_t)n, 5000, &sent);
+        assert(rc == 0 && sent == (size_t)n);
+    }
+    kc_chan_close(g_ch);
+}
+
+static void consumer(void *arg){
+    (void)arg;
+    int buf[BATCH + 5];
+    int expect = 0;
+    for (;;) {
+        size_t got = 0;
+        int rc = kc_chan_recv_many(g_ch, buf, sizeof(buf) / sizeof(buf[0]), -1, &got);
+        if (rc == KC_EPIPE) break;
+        assert(rc == 0 && got >= 1);
+        for (size_t i = 0; i < got; i++) {
+            if (buf[i] != expect) atomic_fetch_add(&g_out_of_order, 1);
+            expect = buf[i] + 1;
+        }
+        atomic_fetch_add(&g_recvd, (int)got);
+    }
+    atomic_fetch_add(&g_stage, 1);
+}
+
+static void rv_sender(void *arg){
+    (void)arg;
+    int v[3] = {5, 6, 7};
+    size_t sent = 0;
+    assert(kc_chan_send_many(g_rv, v, 3, -1, &sent) == 0 && sent == 3);
+}
+
+static void rv_receiver(void *arg){
+    (void)arg;
+    int v[3] = {0};
+    for (int i = 0; i < 3; i++) {
+        size_t got = 0;
+        assert(kc_chan_recv_many(g_rv, &v[i], 1, -1, &got) == 0 && got == 1);
+    }
+    g_rv_got = v[0] == 5 && v[1] == 6 && v[2] == 7;
+    atomic_fetch_add(&g_stage, 1);
+}
+
+static void basic(void *arg){
+    (void)arg;
+    kc_chan_t *ch = NULL;
+    assert(kc_chan_make(&ch, KC_BUFFERED, sizeof(int), 8) == 0);
+    int in[12], out[12];
+    for (int i = 0; i < 12; i++) in[i] = i;
+    size_t n = 0;
+    assert(kc_chan_send_many(ch, in, 5, 0, &n) == 0 && n == 5);
+    assert(kc_chan_recv_many(ch, out, 3, 0, &n) == 0 && n == 3);
+    assert(out[0] == 0 && out[2] == 2);
+    /* 2 queued, 6 free: the next run wraps and stops at capacity */
+    assert(kc_chan_send_many(ch, in + 5, 7, 0, &n) == KC_EAGAIN && n == 6);
+    assert(kc_chan_len(ch) == 8);
+    assert(kc_chan_recv_many(ch, out, 12, 0, &n) == 0 && n == 8);
+    for (int i = 0; i < 8; i++) assert(out[i] == i + 3);
+    assert(kc_chan_recv_many(ch, out, 12, 0, &n) == KC_EAGAIN && n == 0);
+    assert(kc_chan_recv_many(ch, out, 12, 10, &n) == KC_ETIME && n == 0);
+    struct kc_chan_snapshot snap;
+    assert(kc_chan_snapshot(ch, &snap) == 0);
+    assert(snap.total_sends == 11 && snap.total_recvs == 11);
+    assert(snap.total_bytes_sent == 11 * sizeof(int) && snap.send_eagain == 1 && snap.recv_etime == 1);
+    kc_chan_close(ch);
+    assert(kc_chan_send_many(ch, in, 1, 0, &n) == KC_EPIPE && n == 0);
+    assert(kc_chan_recv_many(ch, out, 1, -1, &n) == KC_EPIPE);
+    kc_chan_destroy(ch);
+
+    assert(kc_chan_make(&ch, KC_UNLIMITED, sizeof(int), 4) == 0);
+    int big[100];
+    for (int i = 0; i < 100; i++) big[i] = i;
+    assert(kc_chan_send_many(ch, big, 100, 0, &n) == 0 && n == 100);
+    assert(kc_chan_len(ch) == 100);
+    assert(kc_chan_recv_many(ch, big, 100, 0, &n) == 0 && n == 100 && big[99] == 99);
+    kc_chan_destroy(ch);
+
+    assert(kc_chan_make_ptr(&ch, KC_BUFFERED, 4) == 0);
+    char a[10], b[20], c[30];
+    struct kc_chan_ptrmsg pm[3] = { { a, sizeof(a) }, { b, sizeof(b) }, { c, sizeof(c) } }, pr[4];
+    assert(kc_chan_send_ptr_many(ch, pm, 3, 0, &n) == 0 && n == 3);
+    assert(kc_chan_recv_ptr_many(ch, pr, 4, 0, &n) == 0 && n == 3);
+    assert(pr[0].ptr == a && pr[1].len == sizeof(b) && pr[2].ptr == c);
+    assert(kc_chan_snapshot(ch, &snap) == 0);
+    assert(snap.total_bytes_sent == 60 && snap.total_bytes_recv == 60);
+    assert(kc_chan_recv_many(ch, out, 1, 0, &n) == -EINVAL);
+    kc_chan_destroy(ch);
+
+    g_basic_ok = 1;
+    atomic_store(&g_stage, 1);
+}
+
+static int wait_for(_Atomic(int) *v, int want){
+    for (int i = 0; i < 2000 && atomic_load(v) < want; i++) kc_sleep_ms(5);
+    return atomic_load(v) >= want;
+}
+
+int main(void){
+    printf("[test] chan_batch start\n");
+    kc_sched_opts_t opts = {0};
+    opts.workers = 2;
+    kc_sched_t *s = kc_sched_init(&opts); assert(s);
+
+    assert(kc_spawn_co(s, basic, NULL, 0, NULL) == 0);
+    int ok_basic = wait_for(&g_stage, 1);
+
+    assert(kc_chan_make(&g_rv, KC_RENDEZVOUS, sizeof(int), 0) == 0);
+    assert(kc_spawn_co(s, rv_receiver, NULL, 0, NULL) == 0);
+    assert(kc_spawn_co(s, rv_sender, NULL, 0, NULL) == 0);
+    int ok_rv = wait_for(&g_stage, 2);
+
+    assert(kc_chan_make(&g_ch, KC_BUFFERED, sizeof(int), 16) == 0);
+    assert(kc_spawn_co(s, consumer, NULL, 0, NULL) == 0);
+    assert(kc_spawn_co(s, producer, NULL, 0, NULL) == 0);
+    int ok_stream = wait_for(&g_stage, 3);
+
+    struct kc_chan_snapshot snap;
+    assert(kc_chan_snapshot(g_ch, &snap) == 0);
+    kc_sched_shutdown(s);
+    kc_chan_destroy(g_ch);
+    kc_chan_destroy(g_rv);
+
+    if (!ok_basic || !g_basic_ok) { fprintf(stderr, "basic batch checks did not finish\n"); return 1; }
+    if (!ok_rv || !g_rv_got) { fprintf(stderr, "rendezvous batch fallback failed\n"); return 2; }
+    if (!ok_stream) { fprintf(stderr, "stalled: recvd=%d\n", atomic_load(&g_recvd)); return 3; }
+    if (atomic_load(&g_recvd) != ITEMS || atomic_load(&g_out_of_order)) {
+        fprintf(stderr, "recvd=%d out_of_order=%d\n", atomic_load(&g_recvd), atomic_load(&g_out_of_order)); return 4;
+    }
+    if (snap.total_sends != ITEMS || snap.total_recvs != ITEMS) {
+        fprintf(stderr, "snapshot sends=%lu recvs=%lu\n", snap.total_sends, snap.total_recvs); return 5;
+    }
+    printf("[test] chan_batch ok msgs=%d\n", ITEMS);
+    return 0;
+}
@@ -0,0 +1,110 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Wake coalescing: a receiver parked in kc_chan_recv_many on a coalescing
+// channel is not woken by the first puts of a window. It wakes once the
+// window counts max_batch puts (and drains them in one call), or once the
+// delay after the first put runs out, or when coalescing is turned off.
+#include <stdio.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <errno.h>
+#include <assert.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_port.h"
+
+enum { BATCH = 16, ROUNDS = 10 };
+
+static kc_chan_t *g_ch;
+static _Atomic(int) g_got, g_calls, g_done;
+static _Atomic(uint64_t) g_last_ms;
+
+static uint64_t now_ms(void){
+    struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+}
+
+static void receiver(void *arg){
+    (void)arg;
+    int buf[64];
+    size_t got;
+    while (kc_chan_recv_many(g_ch, buf, 64, -1, &got) == 0) {
+        atomic_fetch_add(&g_calls, 1);
+        atomic_store(&g_last_ms, now_ms());
+        atomic_fetch_add(&g_got, (int)got);
+    }
+    atomic_store(&g_done, 1);
+}
+
+/* Wait until the receiver is parked again. */
+static void wait_parked(void){
+    struct kc_chan_snapshot sn;
+    for (int i = 0; i < 400; i++) {
+        kc_chan_snapshot(g_ch, &sn);
+        if (sn.recv_waiters == 1) return;
+        kc_sleep_ms(1);
+    }
+}
+
+static int wait_got(int want, int ms){
+    for (int i = 0; i < ms && atomic_load(&g_got) < want; i++) kc_sleep_ms(1);
+    return atomic_load(&g_got) >= want;
+}
+
+int main(void){
+    printf("[test] chan_coalesce start\n");
+    kc_chan_t *rv;
+    assert(kc_chan_make(&rv, KC_RENDEZVOUS, sizeof(int), 0) == 0);
+    assert(kc_chan_set_coalesce(rv, BATCH, 1000) == -EINVAL);
+    kc_chan_destroy(rv);
+
+    assert(kc_chan_make(&g_ch, KC_BUFFERED, sizeof(int), 1024) == 0);
+    assert(kc_chan_set_coalesce(g_ch, BATCH, 100000) == 0);
+    assert(kc_spawn_co(kc_sched_default(), receiver, NULL, 0, NULL) == 0);
+
+    /* Count: BATCH - 1 puts are held, the BATCH-th wakes for all of them. */
+    for (int r = 1; r <= ROUNDS; r++) {
+        wait_parked();
+        int calls0 = atomic_load(&g_calls);
+        for (int i = 0; i < BATCH - 1; i++) assert(kc_chan_send(g_ch, &i, 0) == 0);
+        kc_sleep_ms(10);
+        if (atomic_load(&g_got) != (r - 1) * BATCH) { fprintf(stderr, "round %d woke early\n", r); return 1; }
+        int v = BATCH;
+        assert(kc_chan_send(g_ch, &v, 0) == 0);
+        if (!wait_got(r * BATCH, 2000)) { fprintf(stderr, "round %d got=%d\n", r, atomic_load(&g_got)); return 2; }
+        if (atomic_load(&g_calls) - calls0 != 1) { fprintf(stderr, "round %d took %d calls\n", r, atomic_load(&g_calls) - calls0); return 3; }
+    }
+
+    /* Time: a lone put is delivered once the 100 ms window runs out. */
+    wait_parked();
+    int v = 1, base = atomic_load(&g_got);
+    uint64_t t0 = now_ms();
+    assert(kc_chan_send(g_ch, &v, 0) == 0);
+    if (!wait_got(base + 1, 2000)) { fprintf(stderr, "lone put never delivered\n"); return 4; }
+    uint64_t lat = atomic_load(&g_last_ms) - t0;
+    if (lat < 90) { fprintf(stderr, "lone put delivered after %llu ms\n", (unsigned long long)lat); return 5; }
+
+    /* Off: a held put is released at once. */
+    wait_parked();
+    base = atomic_load(&g_got);
+    assert(kc_chan_send(g_ch, &v, 0) == 0);
+    kc_sleep_ms(5);
+    if (atomic_load(&g_got) != base) { fprintf(stderr, "held put delivered early\n"); return 6; }
+    t0 = now_ms();
+    assert(kc_chan_set_coalesce(g_ch, 0, 0) == 0);
+    if (!wait_got(base + 1, 2000) || atomic_load(&g_last_ms) - t0 > 50) { fprintf(stderr, "off did not release\n"); return 7; }
+
+    struct kc_chan_snapshot sn;
+    kc_chan_snapshot(g_ch, &sn);
+    if (sn.coalesce_held < (unsigned long)ROUNDS * (BATCH - 1) || sn.coalesce_flushes < ROUNDS) {
+        fprintf(stderr, "held=%lu flushes=%lu\n", sn.coalesce_held, sn.coalesce_flushes);
+        return 8;
+    }
+    kc_chan_close(g_ch);
+    for (int i = 0; i < 2000 && !atomic_load(&g_done); i++) kc_sleep_ms(1);
+    assert(atomic_load(&g_done));
+    kc_chan_destroy(g_ch);
+    printf("[test] chan_coalesce ok held=%lu flushes=%lu lone=%llums\n", sn.coalesce_held, sn.coalesce_flushes,
+           (unsigned long long)lat);
+    return 0;
+}
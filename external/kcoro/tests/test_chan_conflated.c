@@ -0,0 +1,183 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Conflated channels (copy mode: lock-free cell)
+// 1) shape: the latest send wins, empty is KC_EAGAIN, a value sent before
+//    close is still received, then KC_EPIPE; snapshots count every send.
+// 2) writer threads hammer the cell while a reader checks that every value
+//    it takes is whole and that the stream never goes back in time.
+// 3) a parked coroutine recv, a parked select clause and a thread recv are
+//    each woken by a later send.
+#include <stdio.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <assert.h>
+#include <pthread.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_core.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_port.h"
+
+enum { WRITERS = 4, PER_WRITER = 200000, WORDS = 8 };
+
+struct sample { unsigned long w[WORDS]; };
+
+static kc_chan_t *g_ch;
+static _Atomic(int) g_writers_done, g_recv_done, g_sel_done;
+static int g_recv_rc = 1, g_recv_val, g_sel_rc = 1, g_sel_val;
+static unsigned long g_last_seen[WRITERS];
+static long g_torn, g_backwards, g_taken;
+
+static void *writer(void *arg){
+    int id = (int)(long)arg;
+    for (unsigned long i = 1; i <= PER_WRITER; i++) {
+        struct sample s;
+        for (int k = 0; k < WORDS; k++) s.w[k] = ((unsigned long)id << 56) | i;
+        assert(kc_chan_send(g_ch, &s, 0) == 0);
+    }
+    atomic_fetch_add(&g_writers_done, 1);
+    return NULL;
+}
+
+static void *reader(void *arg){
+    (void)arg;
+    struct sample s;
+    for (;;) {
+        int done = atomic_load(&g_writers_done) == WRITERS;
+        while (kc_chan_recv(g_ch, &s, 0) == 0) {
+            g_taken++;
+            for (int k = 1; k < WORDS; k++) if (s.w[k] != s.w[0]) { g_torn++; break; }
+            unsigned id = (unsigned)(s.w[0] >> 56);
+            unsigned long seq = s.w[0] & ((1ul << 56) - 1);
+            if (id >= WRITERS) { g_torn++; continue; }
+            if (seq <= g_last_seen[id]) g_backwards++;
+            g_last_seen[id] = seq;
+        }
+        if (done) break;
+    }
+    return NULL;
+}
+
+static void parked_recv(void *arg){
+    (void)arg;
+    g_recv_rc = kc_chan_recv(g_ch, &g_recv_val, -1);
+    atomic_store(&g_recv_done, 1);
+}
+
+static void selector(void *arg){
+    (void)arg;
+    kc_select_t *sel = NULL;
+    assert(kc_select_create(&sel, NULL) == 0);
+    assert(kc_select_add_recv(sel, g_ch, &g_sel_val) == 0);
+    int idx = -1;
+    g_sel_rc = kc_select_wait(sel, 5000, &idx, NULL);
+    kc_select_destroy(sel);
+    atomic_store(&g_sel_done, 1);
+}
+
+static void late_send(void *arg){
+    int v = (int)(long)arg;
+    kc_sleep_ms(20);
+    assert(kc_chan_send(g_ch, &v, 0) == 0);
+}
+
+static void *thread_recv(void *arg){
+    (void)arg;
+    g_recv_rc = kc_chan_recv_thread(g_ch, &g_recv_val, 5000);
+    atomic_store(&g_recv_done, 1);
+    return NULL;
+}
+
+static int wait_for(_Atomic(int) *v, int want){
+    for (int i = 0; i < 4000 && atomic_load(v) < want; i++) kc_sleep_ms(5);
+    return atomic_load(v) >= want;
+}
+
+static int basic(void){
+    kc_chan_t *ch = NULL;
+    assert(kc_chan_make(&ch, KC_CONFLATED, sizeof(int), 0) == 0);
+    int v;
+    if (kc_chan_recv(ch, &v, 0) != KC_EAGAIN || kc_chan_len(ch) != 0) return 1;
+    for (v = 1; v <= 3; v++) assert(kc_chan_send(ch, &v, 0) == 0);
+    if (kc_chan_len(ch) != 1) return 2;
+    if (kc_chan_recv(ch, &v, 0) != 0 || v != 3) return 3;
+    if (kc_chan_recv(ch, &v, 0) != KC_EAGAIN) return 4;
+    v = 7; assert(kc_chan_send(ch, &v, 0) == 0);
+    kc_chan_close(ch);
+    if (kc_chan_send(ch, &v, 0) != KC_EPIPE) return 5;
+    v = 0;
+    if (kc_chan_recv(ch, &v, 0) != 0 || v != 7) return 6;
+    if (kc_chan_recv(ch, &v, 0) != KC_EPIPE) return 7;
+    struct kc_chan_snapshot snap;
+    assert(kc_chan_snapshot(ch, &snap) == 0);
+    if (snap.total_sends != 4 || snap.total_recvs != 2 || snap.count != 0) return 8;
+    if (snap.send_epipe != 1 || snap.recv_epipe != 1 || snap.first_op_time_ns == 0) return 9;
+    if (kc_chan_enable_zero_copy(ch) != -ENOTSUP) return 10;
+    kc_chan_destroy(ch);
+    return 0;
+}
+
+static int stress(void){
+    assert(kc_chan_make(&g_ch, KC_CONFLATED, sizeof(struct sample), 0) == 0);
+    pthread_t w[WRITERS], r;
+    assert(pthread_create(&r, NULL, reader, NULL) == 0);
+    for (long i = 0; i < WRITERS; i++) assert(pthread_create(&w[i], NULL, writer, (void*)i) == 0);
+    for (int i = 0; i < WRITERS; i++) pthread_join(w[i], NULL);
+    pthread_join(r, NULL);
+    struct kc_chan_snapshot snap;
+    assert(kc_chan_snapshot(g_ch, &snap) == 0);
+    kc_chan_destroy(g_ch);
+    if (g_torn || g_backwards || g_taken == 0) {
+        fprintf(stderr, "torn=%ld backwards=%ld taken=%ld\n", g_torn, g_backwards, g_taken); return 1;
+    }
+    if (snap.total_sends != (size_t)WRITERS * PER_WRITER || snap.total_recvs != (size_t)g_taken) {
+        fprintf(stderr, "sends=%zu recvs=%zu taken=%ld\n", (size_t)snap.total_sends, (size_t)snap.total_recvs, g_taken);
+        return 2;
+    }
+    return 0;
+}
+
+int main(void){
+    printf("[test] chan_conflated start\n");
+    int rc = basic();
+    if (rc) { fprintf(stderr, "basic check %d failed\n", rc); return 1; }
+    rc = stress();
+    if (rc) { fprintf(stderr, "stress check %d failed\n", rc); return 2; }
+
+    kc_sched_opts_t opts = {0};
+    opts.workers = 4;
+    kc_sched_t *s = kc_sched_init(&opts); assert(s);
+    assert(kc_chan_make(&g_ch, KC_CONFLATED, sizeof(int), 0) == 0);
+
+    /* An untimed coroutine recv parks until the next send. */
+    assert(kc_spawn_co(s, parked_recv, NULL, 0, NULL) == 0);
+    assert(kc_spawn_co(s, late_send, (void*)11L, 0, NULL) == 0);
+    if (!wait_for(&g_recv_done, 1) || g_recv_rc != 0 || g_recv_val != 11) {
+        fprintf(stderr, "parked recv rc=%d val=%d\n", g_recv_rc, g_recv_val); return 3;
+    }
+    /* A parked select clause, likewise. */
+    assert(kc_spawn_co(s, selector, NULL, 0, NULL) == 0);
+    assert(kc_spawn_co(s, late_send, (void*)22L, 0, NULL) == 0);
+    if (!wait_for(&g_sel_done, 1) || g_sel_rc != 0 || g_sel_val != 22) {
+        fprintf(stderr, "select rc=%d val=%d\n", g_sel_rc, g_sel_val); return 4;
+    }
+    /* And a thread outside the scheduler. */
+    atomic_store(&g_recv_done, 0); g_recv_rc = 1;
+    pthread_t t;
+    assert(pthread_create(&t, NULL, thread_recv, NULL) == 0);
+    assert(kc_spawn_co(s, late_send, (void*)33L, 0, NULL) == 0);
+    pthread_join(t, NULL);
+    if (g_recv_rc != 0 || g_recv_val != 33) {
+        fprintf(stderr, "thread recv rc=%d val=%d\n", g_recv_rc, g_recv_val); return 5;
+    }
+    /* Close wakes a parked receiver with KC_EPIPE. */
+    atomic_store(&g_recv_done, 0); g_recv_rc = 1;
+    assert(kc_spawn_co(s, parked_recv, NULL, 0, NULL) == 0);
+    kc_sleep_ms(20);
+    kc_chan_close(g_ch);
+    if (!wait_for(&g_recv_done, 1) || g_recv_rc != KC_EPIPE) {
+        fprintf(stderr, "close rc=%d\n", g_recv_rc); return 6;
+    }
+    kc_sched_shutdown(s);
+    kc_chan_destroy(g_ch);
+    printf("[test] chan_conflated ok\n");
+    return 0;
+}
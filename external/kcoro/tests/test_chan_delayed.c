@@ -0,0 +1,146 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Delayed-delivery channels (KC_DELAYED, kc_chan_send_at)
+// 1) shape: elements come out in deadline order and only once due; plain
+//    send means "due now"; unsupported uses are refused.
+// 2) 4 receivers x 2000 elements at scattered deadlines: none is received
+//    early, each receiver sees deadlines in order, all arrive.
+// 3) a timed recv ends with KC_ETIME before the element is due; a thread
+//    recv waits until it is.
+// 4) close: pending elements still arrive when due, then KC_EPIPE.
+#include <stdio.h>
+#include <time.h>
+#include <stdatomic.h>
+#include <assert.h>
+#include <errno.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_core.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_port.h"
+
+enum { RECEIVERS = 4, N = 2000, SPREAD_MS = 200 };
+
+struct item { long due; int id; };
+
+static kc_chan_t *g_ch;
+static _Atomic(int) g_recvd, g_early, g_unordered, g_done, g_timed_done;
+static _Atomic(long) g_max_late;
+static int g_timed_rc = 1;
+
+static long now_ns(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long)ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+static void receiver(void *arg){
+    (void)arg;
+    long last_due = 0;
+    struct item it;
+    while (kc_chan_recv(g_ch, &it, -1) == 0) {
+        long t = now_ns();
+        if (t < it.due) atomic_fetch_add(&g_early, 1);
+        if (it.due < last_due) atomic_fetch_add(&g_unordered, 1);
+        last_due = it.due;
+        long late = t - it.due, m = atomic_load(&g_max_late);
+        while (late > m && !atomic_compare_exchange_weak(&g_max_late, &m, late)) {}
+        atomic_fetch_add(&g_recvd, 1);
+    }
+    atomic_fetch_add(&g_done, 1);
+}
+
+static void timed_receiver(void *arg){
+    (void)arg;
+    struct item it;
+    g_timed_rc = kc_chan_recv(g_ch, &it, 20);
+    atomic_store(&g_timed_done, 1);
+}
+
+static int wait_for(_Atomic(int) *v, int want){
+    for (int i = 0; i < 4000 && atomic_load(v) < want; i++) kc_sleep_ms(5);
+    return atomic_load(v) >= want;
+}
+
+static int basic(void){
+    kc_chan_t *ch = NULL;
+    assert(kc_chan_make(&ch, KC_DELAYED, sizeof(struct item), 2) == 0);
+    if (!(kc_chan_capabilities(ch) & KC_CHAN_CAP_DELAYED)) return 1;
+    long t0 = now_ns();
+    struct item it = { t0 + 60000000L, 3 };
+    assert(kc_chan_send_at(ch, &it, it.due) == 0);
+    it = (struct item){ t0 + 30000000L, 2 };
+    assert(kc_chan_send_at(ch, &it, it.due) == 0);
+    it = (struct item){ t0 + 30000000L, 4 };   /* same deadline, sent later */
+    assert(kc_chan_send_at(ch, &it, it.due) == 0);
+    it = (struct item){ t0, 1 };
+    assert(kc_chan_send(ch, &it, 0) == 0);
+    if (kc_chan_recv(ch, &it, 0) != 0 || it.id != 1) return 2;
+    if (kc_chan_recv(ch, &it, 0) != KC_EAGAIN || kc_chan_len(ch) != 3) return 3;
+    if (kc_chan_post(ch, &it) != -EINVAL || kc_chan_enable_zero_copy(ch) != -ENOTSUP) return 4;
+
+    int want[] = { 2, 4, 3 };
+    for (int i = 0; i < 3; i++) {
+        int rc;
+        while ((rc = kc_chan_recv(ch, &it, 0)) == KC_EAGAIN) kc_sleep_ms(1);
+        if (rc != 0 || it.id != want[i] || now_ns() < it.due) return 5 + i;
+    }
+    struct kc_chan_snapshot snap;
+    assert(kc_chan_snapshot(ch, &snap) == 0);
+    if (snap.total_sends != 4 || snap.total_recvs != 4 || snap.count != 0) return 8;
+    kc_chan_destroy(ch);
+
+    assert(kc_chan_make(&ch, KC_BUFFERED, sizeof(struct item), 4) == 0);
+    int rc = kc_chan_send_at(ch, &it, t0);
+    kc_chan_destroy(ch);
+    return rc == -EINVAL ? 0 : 9;
+}
+
+int main(void){
+    printf("[test] chan_delayed start\n");
+    int rc = basic();
+    if (rc) { fprintf(stderr, "basic check %d failed\n", rc); return 1; }
+
+    kc_sched_opts_t opts = {0};
+    opts.workers = 4;
+    kc_sched_t *s = kc_sched_init(&opts); assert(s);
+
+    /* Timed recv gives up before the element is due; a thread waits it out. */
+    assert(kc_chan_make(&g_ch, KC_DELAYED, sizeof(struct item), 0) == 0);
+    struct item it = { now_ns() + 80000000L, 7 };
+    assert(kc_chan_send_at(g_ch, &it, it.due) == 0);
+    assert(kc_spawn_co(s, timed_receiver, NULL, 0, NULL) == 0);
+    int ok_timed = wait_for(&g_timed_done, 1);
+    if (!ok_timed || g_timed_rc != KC_ETIME) { fprintf(stderr, "timed recv rc=%d\n", g_timed_rc); return 2; }
+    if (kc_chan_recv_thread(g_ch, &it, 2000) != 0 || it.id != 7 || now_ns() < it.due) {
+        fprintf(stderr, "thread recv id=%d\n", it.id); return 3;
+    }
+    kc_chan_destroy(g_ch);
+
+    assert(kc_chan_make(&g_ch, KC_DELAYED, sizeof(struct item), 0) == 0);
+    for (long i = 0; i < RECEIVERS; i++) assert(kc_spawn_co(s, receiver, NULL, 0, NULL) == 0);
+    long t0 = now_ns() + 50000000L;   /* every send lands before the first is due */
+    unsigned x = 12345;
+    for (int i = 0; i < N; i++) {
+        x = x * 1103515245u + 12345u;
+        it = (struct item){ t0 + (long)((x >> 8) % (SPREAD_MS * 1000)) * 1000L, i };
+        assert(kc_chan_send_at(g_ch, &it, it.due) == 0);
+    }
+    int ok_recv = wait_for(&g_recvd, N);
+
+    /* Close with elements pending: they still arrive, then EPIPE. */
+    it = (struct item){ now_ns() + 30000000L, N };
+    assert(kc_chan_send_at(g_ch, &it, it.due) == 0);
+    kc_chan_close(g_ch);
+    if (kc_chan_send_at(g_ch, &it, it.due) != KC_EPIPE) { fprintf(stderr, "send after close\n"); return 4; }
+    int ok_done = wait_for(&g_done, RECEIVERS);
+    kc_sched_shutdown(s);
+    kc_chan_destroy(g_ch);
+
+    if (!ok_recv || !ok_done || atomic_load(&g_recvd) != N + 1) {
+        fprintf(stderr, "stalled recvd=%d done=%d\n", atomic_load(&g_recvd), atomic_load(&g_done)); return 5;
+    }
+    if (atomic_load(&g_early) || atomic_load(&g_unordered)) {
+        fprintf(stderr, "early=%d unordered=%d\n", atomic_load(&g_early), atomic_load(&g_unordered)); return 6;
+    }
+    printf("[test] chan_delayed ok msgs=%d max_late=%ldus\n", N + 1, atomic_load(&g_max_late) / 1000);
+    return 0;
+}
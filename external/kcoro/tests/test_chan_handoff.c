@@ -0,0 +1,107 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Rendezvous handoff (kc_chan_set_handoff)
+// 1) request/response ping-pong over two handoff channels: every value
+//    arrives in order and the scheduler counts direct handoffs.
+// 2) the same with timed receives.
+// 3) close still wakes a receiver parked in handoff mode (KC_EPIPE), and
+//    only plain rendezvous channels accept the mode.
+// 4) 1) and 2) with shared-stack coroutines, whose receivers wait the plain
+//    way: every value still arrives in order.
+#include <stdio.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <assert.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_core.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_port.h"
+
+enum { ROUNDS = 20000 };
+
+static kc_chan_t *g_req, *g_rsp;
+static _Atomic(int) g_done, g_bad, g_epipe;
+static long g_recv_timeout;
+
+static void server(void *arg){
+    (void)arg;
+    for (int i = 0; i < ROUNDS; i++) {
+        int v = -1;
+        if (kc_chan_recv(g_req, &v, g_recv_timeout) != 0 || v != i) { atomic_fetch_add(&g_bad, 1); break; }
+        v += 1;
+        if (kc_chan_send(g_rsp, &v, -1) != 0) { atomic_fetch_add(&g_bad, 1); break; }
+    }
+    atomic_fetch_add(&g_done, 1);
+}
+
+static void client(void *arg){
+    (void)arg;
+    for (int i = 0; i < ROUNDS; i++) {
+        int v = i, r = -1;
+        if (kc_chan_send(g_req, &v, -1) != 0) { atomic_fetch_add(&g_bad, 1); break; }
+        if (kc_chan_recv(g_rsp, &r, g_recv_timeout) != 0 || r != i + 1) { atomic_fetch_add(&g_bad, 1); break; }
+    }
+    atomic_fetch_add(&g_done, 1);
+}
+
+static void closed_recv(void *arg){
+    (void)arg;
+    int v;
+    if (kc_chan_recv(g_req, &v, -1) == KC_EPIPE) atomic_fetch_add(&g_epipe, 1);
+}
+
+static int wait_for(_Atomic(int) *v, int want){
+    for (int i = 0; i < 4000 && atomic_load(v) < want; i++) kc_sleep_ms(5);
+    return atomic_load(v) >= want;
+}
+
+static int pingpong(kc_sched_t *s, long recv_timeout, size_t stack){
+    g_recv_timeout = recv_timeout;
+    atomic_store(&g_done, 0);
+    assert(kc_chan_make(&g_req, KC_RENDEZVOUS, sizeof(int), 0) == 0);
+    assert(kc_chan_make(&g_rsp, KC_RENDEZVOUS, sizeof(int), 0) == 0);
+    assert(kc_chan_set_handoff(g_req, 1) == 0 && kc_chan_set_handoff(g_rsp, 1) == 0);
+    kc_sched_stats_t st0, st;
+    kc_sched_get_stats(s, &st0);
+    assert(kc_spawn_co(s, server, NULL, stack, NULL) == 0);
+    assert(kc_spawn_co(s, client, NULL, stack, NULL) == 0);
+    if (!wait_for(&g_done, 2) || atomic_load(&g_bad)) {
+        fprintf(stderr, "pingpong tmo=%ld done=%d bad=%d\n", recv_timeout, atomic_load(&g_done), atomic_load(&g_bad));
+        return -1;
+    }
+    kc_sched_get_stats(s, &st);
+    printf("[test] chan_handoff tmo=%ld shared=%d handoffs=%lu\n", recv_timeout, stack != 0,
+           st.handoffs - st0.handoffs);
+    if (!stack && st.handoffs == st0.handoffs) { fprintf(stderr, "no handoffs\n"); return -1; }
+    kc_chan_destroy(g_req);
+    kc_chan_destroy(g_rsp);
+    return 0;
+}
+
+int main(void){
+    printf("[test] chan_handoff start\n");
+    kc_sched_opts_t opts = {0};
+    opts.workers = 2;
+    kc_sched_t *s = kc_sched_init(&opts); assert(s);
+
+    if (pingpong(s, -1, 0) != 0) return 1;
+    if (pingpong(s, 5000, 0) != 0) return 2;
+    if (pingpong(s, -1, KCORO_STACK_SHARED) != 0) return 5;
+    if (pingpong(s, 5000, KCORO_STACK_SHARED) != 0) return 6;
+
+    assert(kc_chan_make(&g_req, KC_RENDEZVOUS, sizeof(int), 0) == 0);
+    assert(kc_chan_set_handoff(g_req, 1) == 0);
+    assert(kc_spawn_co(s, closed_recv, NULL, 0, NULL) == 0);
+    kc_sleep_ms(50);
+    kc_chan_close(g_req);
+    if (!wait_for(&g_epipe, 1)) { fprintf(stderr, "handoff receiver not woken by close\n"); return 3; }
+    kc_chan_destroy(g_req);
+
+    kc_chan_t *b;
+    assert(kc_chan_make(&b, KC_BUFFERED, sizeof(int), 4) == 0);
+    if (kc_chan_set_handoff(b, 1) != -EINVAL || kc_chan_set_handoff(NULL, 1) != -EINVAL) { fprintf(stderr, "setter accepted\n"); return 4; }
+    kc_chan_destroy(b);
+
+    kc_sched_shutdown(s);
+    printf("[test] chan_handoff ok\n");
+    return 0;
+}
@@ -0,0 +1,150 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Test latency histograms: bucket bounds and quantiles, queue latency of a
+// buffered channel (including elements queued before enabling), park time
+// of a receiver waiting on an empty channel, resetting reads, and the
+// scheduler's wake-to-resume histogram
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <errno.h>
+#include <unistd.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_core.h"
+
+static void buckets(void)
+{
+    /* Every value lies inside its bucket; bounds are contiguous */
+    unsigned long probes[] = { 0, 1, 15, 16, 17, 31, 32, 1000, 123456, 1UL << 39, (1UL << 40) - 1 };
+    for (size_t i = 0; i < sizeof(probes) / sizeof(probes[0]); i++) {
+        int b = kc_hist_bucket(probes[i]);
+        assert(b >= 0 && b < KC_HIST_BUCKETS);
+        assert(kc_hist_bucket_lo(b) <= probes[i] && probes[i] <= kc_hist_bucket_hi(b));
+    }
+    for (int b = 1; b < KC_HIST_BUCKETS; b++)
+        assert(kc_hist_bucket_lo(b) == kc_hist_bucket_hi(b - 1) + 1);
+    assert(kc_hist_bucket(1UL << 50) == KC_HIST_BUCKETS - 1);
+    /* Relative error stays within 1/8 */
+    int b = kc_hist_bucket(1000000);
+    assert((kc_hist_bucket_hi(b) - kc_hist_bucket_lo(b)) * 8 <= kc_hist_bucket_lo(b));
+
+    struct kc_hist h = {0};
+    for (unsigned long v = 1; v <= 100; v++) {
+        h.buckets[kc_hist_bucket(v * 1000)]++;
+        h.count++;
+        h.sum_ns += v * 1000;
+    }
+    h.min_ns = 1000;
+    h.max_ns = 100000;
+    unsigned long p50 = kc_hist_quantile(&h, 0.5), p99 = kc_hist_quantile(&h, 0.99);
+    assert(p50 >= 50000 && p50 <= 50000 + 50000 / 8);
+    assert(p99 >= 99000 && p99 <= 100000);
+    assert(kc_hist_quantile(&h, 1.0) == 100000);
+    assert(kc_hist_mean(&h) == 50500.0);
+    struct kc_hist empty = {0};
+    assert(kc_hist_quantile(&empty, 0.5) == 0 && kc_hist_mean(&empty) == 0.0);
+}
+
+static void queue_latency(void *arg)
+{
+    volatile int *done = (volatile int*)arg;
+    kc_chan_t *ch = NULL;
+    struct kc_chan_latency lat;
+    assert(kc_chan_make(&ch, KC_BUFFERED, sizeof(int), 8) == 0);
+    assert(kc_chan_get_latency(ch, &lat, 0) == -ENOENT);
+    assert(kc_chan_set_latency(NULL, 1) == -EINVAL);
+
+    int v = 0;
+    assert(kc_chan_send(ch, &v, 0) == 0); /* queued before enabling: not counted */
+    assert(kc_chan_set_latency(ch, 1) == 0);
+    for (v = 1; v <= 3; v++) assert(kc_chan_send(ch, &v, 0) == 0);
+    kc_sleep_ms(2);
+    for (int i = 0; i < 4; i++) assert(kc_chan_recv(ch, &v, 0) == 0 && v == i);
+    assert(kc_chan_get_latency(ch, &lat, 0) == 0);
+    assert(lat.queue.count == 3);
+    assert(lat.queue.min_ns >= 2000000 && lat.queue.max_ns >= lat.queue.min_ns);
+    assert(lat.send_park.count == 0 && lat.recv_park.count == 0);
+
+    /* Batches are stamped per element */
+    int batch[5] = { 0, 1, 2, 3, 4 }, got[5];
+    size_t n = 0;
+    assert(kc_chan_send_many(ch, batch, 5, 0, &n) == 0 && n == 5);
+    assert(kc_chan_recv_many(ch, got, 5, 0, &n) == 0 && n == 5);
+    assert(kc_chan_get_latency(ch, &lat, 1) == 0 && lat.queue.count == 8);
+    assert(kc_chan_get_latency(ch, &lat, 0) == 0 && lat.queue.count == 0 && lat.queue.max_ns == 0);
+
+    /* Off: nothing recorded, and stamps from before do not leak into later reads */
+    assert(kc_chan_send(ch, &v, 0) == 0);
+    assert(kc_chan_set_latency(ch, 0) == 0);
+    assert(kc_chan_recv(ch, &v, 0) == 0);
+    assert(kc_chan_set_latency(ch, 1) == 0);
+    assert(kc_chan_send(ch, &v, 0) == 0 && kc_chan_recv(ch, &v, 0) == 0);
+    assert(kc_chan_get_latency(ch, &lat, 0) == 0 && lat.queue.count == 1 && lat.queue.max_ns < 1000000000UL);
+    kc_chan_destroy(ch);
+
+    /* KC_UNLIMITED grows its stamp FIFO with the queue */
+    assert(kc_chan_make(&ch, KC_UNLIMITED, sizeof(int), 4) == 0);
+    assert(kc_chan_set_latency(ch, 1) == 0);
+    for (v = 0; v < 1000; v++) assert(kc_chan_send(ch, &v, 0) == 0);
+    for (int i = 0; i < 1000; i++) assert(kc_chan_recv(ch, &v, 0) == 0 && v == i);
+    assert(kc_chan_get_latency(ch, &lat, 0) == 0 && lat.queue.count == 1000);
+    kc_chan_destroy(ch);
+    *done = 1;
+}
+
+struct park_ctx { kc_chan_t *ch; volatile int done; };
+
+static void parked_recv(void *arg)
+{
+    struct park_ctx *c = (struct park_ctx*)arg;
+    int v = 0;
+    assert(kc_chan_recv(c->ch, &v, -1) == 0 && v == 42);
+    c->done = 1;
+}
+
+static void late_send(void *arg)
+{
+    struct park_ctx *c = (struct park_ctx*)arg;
+    kc_sleep_ms(20);
+    int v = 42;
+    assert(kc_chan_send(c->ch, &v, 0) == 0);
+}
+
+static void park_latency(void)
+{
+    kc_sched_t *s = kc_sched_default();
+    kc_chan_t *ch = NULL;
+    struct kc_chan_latency lat;
+    struct kc_hist wake;
+    assert(kc_sched_get_wake_latency(s, &wake, 0) == -ENOENT);
+    assert(kc_sched_set_wake_latency(s, 1) == 0);
+    assert(kc_chan_make(&ch, KC_BUFFERED, sizeof(int), 8) == 0);
+    assert(kc_chan_set_latency(ch, 1) == 0);
+
+    struct park_ctx c = { .ch = ch };
+    assert(kc_spawn_co(s, parked_recv, &c, 0, NULL) == 0);
+    assert(kc_spawn_co(s, late_send, &c, 0, NULL) == 0);
+    for (int i = 0; i < 2000 && !c.done; i++) usleep(1000);
+    assert(c.done);
+
+    assert(kc_chan_get_latency(ch, &lat, 1) == 0);
+    assert(lat.recv_park.count == 1 && lat.recv_park.min_ns >= 10000000UL);
+    assert(lat.queue.count == 1);
+    assert(kc_sched_get_wake_latency(s, &wake, 1) == 0);
+    assert(wake.count >= 1 && wake.max_ns < 1000000000UL);
+    assert(kc_sched_get_wake_latency(s, &wake, 0) == 0 && wake.count == 0);
+    assert(kc_sched_set_wake_latency(s, 0) == 0);
+    kc_chan_destroy(ch);
+}
+
+int main(void)
+{
+    buckets();
+    volatile int done = 0;
+    assert(kc_spawn_co(kc_sched_default(), queue_latency, (void*)&done, 0, NULL) == 0);
+    for (int i = 0; i < 2000 && !done; i++) usleep(1000);
+    assert(done);
+    park_latency();
+    printf("[chan latency] ok\n");
+    return 0;
+}
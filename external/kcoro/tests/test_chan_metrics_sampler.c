@@ -0,0 +1,92 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Test the metrics sampler: events for a buffered and a ring channel arrive
+// without the data path emitting, their deltas add up to the totals, an
+// unread full pipe never blocks sends, and a disabled channel goes quiet
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <unistd.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_core.h"
+
+#define OPS 5000
+
+struct ctx {
+    kc_chan_t *ch, *pipe;
+    volatile int done, events;
+    unsigned long sends, recvs;
+    int bad;
+};
+
+static void traffic(void *arg)
+{
+    struct ctx *c = (struct ctx*)arg;
+    for (int i = 0; i < OPS; i++) {
+        int v = i, out = -1;
+        if (kc_chan_send(c->ch, &v, -1) != 0) c->bad++;
+        if (kc_chan_recv(c->ch, &out, -1) != 0 || out != i) c->bad++;
+        if (i % 1000 == 999) kc_sleep_ms(15);
+    }
+    c->done = 1;
+}
+
+/* Drain the pipe until the summed deltas reach the channel's totals. */
+static void reader(void *arg)
+{
+    struct ctx *c = (struct ctx*)arg;
+    struct kc_chan_metrics_event ev;
+    while (c->sends < OPS || c->recvs < OPS) {
+        if (kc_chan_recv(c->pipe, &ev, 2000) != 0) { c->bad++; break; }
+        if (ev.chan != (void*)c->ch) c->bad++;
+        c->sends += ev.delta_sends;
+        c->recvs += ev.delta_recvs;
+        if (ev.total_sends != c->sends || ev.total_recvs != c->recvs) c->bad++;
+        c->events++;
+    }
+}
+
+static void run(struct ctx *c)
+{
+    assert(kc_chan_enable_metrics_pipe(c->ch, &c->pipe, 256) == 0 && c->pipe);
+    assert(kc_chan_metrics_pipe(c->ch) == c->pipe);
+    assert(kc_spawn_co(kc_sched_default(), reader, c, 0, NULL) == 0);
+    assert(kc_spawn_co(kc_sched_default(), traffic, c, 0, NULL) == 0);
+    for (int i = 0; i < 5000 && !(c->done && c->sends == OPS && c->recvs == OPS); i++) usleep(1000);
+    assert(c->done && c->bad == 0 && c->sends == OPS && c->recvs == OPS && c->events >= 1);
+}
+
+int main(void)
+{
+    static struct ctx a, r, full;
+    assert(kc_chan_make(&a.ch, KC_BUFFERED, sizeof(int), 16) == 0);
+    run(&a);
+    assert(kc_chan_make_mpmc(&r.ch, sizeof(int), 16) == 0);
+    run(&r);
+
+    /* Nobody reads this pipe: it fills and traffic still completes */
+    assert(kc_chan_make(&full.ch, KC_BUFFERED, sizeof(int), 16) == 0);
+    assert(kc_chan_enable_metrics_pipe(full.ch, &full.pipe, 1) == 0);
+    assert(kc_spawn_co(kc_sched_default(), traffic, &full, 0, NULL) == 0);
+    for (int i = 0; i < 5000 && !full.done; i++) usleep(1000);
+    assert(full.done && full.bad == 0);
+    assert(kc_chan_len(full.pipe) == 1);
+
+    /* Disabled: no more events */
+    assert(kc_chan_disable_metrics_pipe(a.ch) == 0 && kc_chan_metrics_pipe(a.ch) == NULL);
+    a.done = 0;
+    int before = a.events;
+    assert(kc_spawn_co(kc_sched_default(), traffic, &a, 0, NULL) == 0);
+    for (int i = 0; i < 5000 && !a.done; i++) usleep(1000);
+    usleep(50000);
+    assert(a.done && kc_chan_len(a.pipe) == 0 && a.events == before);
+
+    kc_chan_destroy(a.ch);
+    kc_chan_destroy(r.ch);
+    kc_chan_destroy(full.ch);
+    kc_chan_destroy(a.pipe);
+    kc_chan_destroy(r.pipe);
+    kc_chan_destroy(full.pipe);
+    printf("[chan metrics sampler] ok events=%d/%d\n", a.events, r.events);
+    return 0;
+}
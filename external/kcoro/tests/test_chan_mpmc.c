@@ -0,0 +1,141 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Lock-free MPMC ring channel (kc_chan_make_mpmc)
+// 1) try ops: EAGAIN when full/empty, FIFO order, capability bit, len.
+// 2) 4 producers x 4 consumers with blocking and timed ops on a tiny ring:
+//    every value arrives exactly once and the snapshot totals match.
+// 3) a select recv parked on the ring is completed by a later send.
+// 4) close: queued values drain, then EPIPE; sends fail with EPIPE.
+#include <stdio.h>
+#include <stdatomic.h>
+#include <assert.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_core.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_port.h"
+
+enum { PRODUCERS = 4, CONSUMERS = 4, PER_PRODUCER = 20000 };
+
+static kc_chan_t *g_ch;
+static _Atomic(int) g_recvd;
+static _Atomic(long long) g_sum;
+static _Atomic(int) g_cons_done;
+static _Atomic(int) g_prod_done;
+static _Atomic(int) g_dups;
+static unsigned char g_seen[PRODUCERS * PER_PRODUCER];
+static int g_sel_rc = 1, g_sel_idx = -1, g_sel_val;
+static _Atomic(int) g_sel_done;
+
+static void producer(void *arg){
+    int id = (int)(long)arg;
+    for (int i = 0; i < PER_PRODUCER; i++) {
+        int v = id * PER_PRODUCER + i;
+        int rc;
+        do rc = (i & 1) ? kc_chan_send(g_ch, &v, -1) : kc_chan_send(g_ch, &v, 50);
+        while (rc == KC_ETIME);
+        assert(rc == 0);
+    }
+    atomic_fetch_add(&g_prod_done, 1);
+}
+
+static void consumer(void *arg){
+    int timed = (int)(long)arg & 1;
+    for (;;) {
+        int v = -1;
+        int rc = timed ? kc_chan_recv(g_ch, &v, 50) : kc_chan_recv(g_ch, &v, -1);
+        if (rc == KC_ETIME) continue;
+        if (rc == KC_EPIPE) break;
+        assert(rc == 0 && v >= 0 && v < PRODUCERS * PER_PRODUCER);
+        if (__atomic_exchange_n(&g_seen[v], 1, __ATOMIC_RELAXED)) atomic_fetch_add(&g_dups, 1);
+        atomic_fetch_add(&g_sum, v);
+        atomic_fetch_add(&g_recvd, 1);
+    }
+    atomic_fetch_add(&g_cons_done, 1);
+}
+
+static void selector(void *arg){
+    (void)arg;
+    kc_select_t *sel = NULL;
+    assert(kc_select_create(&sel, NULL) == 0);
+    assert(kc_select_add_recv(sel, g_ch, &g_sel_val) == 0);
+    g_sel_rc = kc_select_wait(sel, 5000, &g_sel_idx, NULL);
+    kc_select_destroy(sel);
+    atomic_store(&g_sel_done, 1);
+}
+
+static void late_send(void *arg){
+    (void)arg;
+    kc_sleep_ms(20);
+    int v = 99;
+    assert(kc_chan_send(g_ch, &v, -1) == 0);
+}
+
+static void basic(void *arg){
+    (void)arg;
+    kc_chan_t *ch = NULL;
+    assert(kc_chan_make_mpmc(&ch, sizeof(int), 3) == 0); /* rounds up to 4 */
+    assert(kc_chan_capabilities(ch) & KC_CHAN_CAP_MPMC);
+    int v;
+    assert(kc_chan_recv(ch, &v, 0) == KC_EAGAIN);
+    for (int i = 0; i < 4; i++) assert(kc_chan_send(ch, &i, 0) == 0);
+    assert(kc_chan_send(ch, &v, 0) == KC_EAGAIN);
+    assert(kc_chan_len(ch) == 4);
+    for (int i = 0; i < 2; i++) { assert(kc_chan_recv(ch, &v, 0) == 0 && v == i); }
+    kc_chan_close(ch);
+    assert(kc_chan_send(ch, &v, 0) == KC_EPIPE);
+    for (int i = 2; i < 4; i++) { assert(kc_chan_recv(ch, &v, -1) == 0 && v == i); }
+    assert(kc_chan_recv(ch, &v, -1) == KC_EPIPE);
+    struct kc_chan_snapshot snap;
+    assert(kc_chan_snapshot(ch, &snap) == 0);
+    assert(snap.total_sends == 4 && snap.total_recvs == 4 && snap.count == 0);
+    assert(snap.send_eagain == 1 && snap.recv_eagain == 1 && snap.closed);
+    kc_chan_destroy(ch);
+    atomic_store(&g_sel_done, 2);
+}
+
+static int wait_for(_Atomic(int) *v, int want){
+    for (int i = 0; i < 2000 && atomic_load(v) < want; i++) kc_sleep_ms(5);
+    return atomic_load(v) >= want;
+}
+
+int main(void){
+    printf("[test] chan_mpmc start\n");
+    kc_sched_opts_t opts = {0};
+    opts.workers = 4;
+    kc_sched_t *s = kc_sched_init(&opts); assert(s);
+
+    assert(kc_spawn_co(s, basic, NULL, 0, NULL) == 0);
+    int ok_basic = wait_for(&g_sel_done, 2);
+    atomic_store(&g_sel_done, 0);
+
+    assert(kc_chan_make_mpmc(&g_ch, sizeof(int), 8) == 0);
+    assert(kc_spawn_co(s, selector, NULL, 0, NULL) == 0);
+    assert(kc_spawn_co(s, late_send, NULL, 0, NULL) == 0);
+    int ok_sel = wait_for(&g_sel_done, 1);
+
+    for (long i = 0; i < CONSUMERS; i++) assert(kc_spawn_co(s, consumer, (void*)i, 0, NULL) == 0);
+    for (long i = 0; i < PRODUCERS; i++) assert(kc_spawn_co(s, producer, (void*)i, 0, NULL) == 0);
+    int ok_prod = wait_for(&g_prod_done, PRODUCERS);
+    kc_chan_close(g_ch);
+    int ok_cons = wait_for(&g_cons_done, CONSUMERS);
+
+    struct kc_chan_snapshot snap;
+    assert(kc_chan_snapshot(g_ch, &snap) == 0);
+    kc_sched_shutdown(s);
+    kc_chan_destroy(g_ch);
+
+    const long long n = (long long)PRODUCERS * PER_PRODUCER;
+    if (!ok_basic) { fprintf(stderr, "basic ring checks did not finish\n"); return 1; }
+    if (!ok_sel || g_sel_rc != 0 || g_sel_idx != 0 || g_sel_val != 99) {
+        fprintf(stderr, "select recv rc=%d idx=%d val=%d\n", g_sel_rc, g_sel_idx, g_sel_val); return 2;
+    }
+    if (!ok_prod || !ok_cons) { fprintf(stderr, "stalled: producers=%d consumers=%d recvd=%d\n",
+                                        atomic_load(&g_prod_done), atomic_load(&g_cons_done), atomic_load(&g_recvd)); return 3; }
+    if (atomic_load(&g_recvd) != n || atomic_load(&g_dups) || atomic_load(&g_sum) != n * (n - 1) / 2) {
+        fprintf(stderr, "recvd=%d dups=%d sum=%lld\n", atomic_load(&g_recvd), atomic_load(&g_dups), atomic_load(&g_sum)); return 4;
+    }
+    if (snap.total_sends != (unsigned long)n + 1 || snap.total_recvs != (unsigned long)n + 1) {
+        fprintf(stderr, "snapshot sends=%lu recvs=%lu\n", snap.total_sends, snap.total_recvs); return 5;
+    }
+    printf("[test] chan_mpmc ok msgs=%lld\n", n);
+    return 0;
+}
@@ -0,0 +1,157 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Test kc_chan_recv_peek / kc_chan_recv_release and the batch claims
+// (kc_chan_reserve_many / kc_chan_recv_peek_many): elements read in place
+// on MPMC, SPSC and striped rings, batches wrapping around the ring, a
+// peeked cell holding producers off until released, drain before EPIPE, a
+// receiver parked in peek until commit, a batch pipeline between threads,
+// and -ENOTSUP / -EINVAL
+#include <stdio.h>
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_core.h"
+#include "../include/kcoro_port.h"
+
+#define TOTAL 200000
+#define BATCH 32
+
+static atomic_int co_done;
+static int co_rc;
+static long co_val;
+
+static void parked_peeker(void *arg)
+{
+    kc_chan_t *ch = (kc_chan_t*)arg;
+    kc_chan_slot_t slot;
+    co_rc = kc_chan_recv_peek(ch, &slot, -1);
+    if (co_rc == 0) { co_val = *(long*)slot.data; kc_chan_recv_release(ch, &slot); }
+    atomic_store(&co_done, 1);
+}
+
+static void wait_done(void)
+{
+    for (int i = 0; i < 4000 && !atomic_load(&co_done); i++) kc_sleep_ms(1);
+    assert(atomic_load(&co_done));
+    atomic_store(&co_done, 0);
+}
+
+static void *batch_producer(void *arg)
+{
+    kc_chan_t *ch = (kc_chan_t*)arg;
+    long next = 1;
+    while (next <= TOTAL) {
+        kc_chan_slot_t slot;
+        size_t want = TOTAL - next + 1 < BATCH ? (size_t)(TOTAL - next + 1) : BATCH;
+        int rc = kc_chan_reserve_many(ch, &slot, want, 0);
+        if (rc == KC_EAGAIN) { kc_sleep_ms(0); continue; }
+        assert(rc == 0 && slot.n >= 1 && slot.n <= want);
+        for (size_t i = 0; i < slot.n; i++) *(long*)kc_chan_slot_elem(ch, &slot, i) = next++;
+        assert(kc_chan_commit(ch, &slot) == 0);
+    }
+    kc_chan_close(ch);
+    return NULL;
+}
+
+int main(void)
+{
+    printf("[test] chan_peek start\n");
+    kc_sched_t *s = kc_sched_default();
+    assert(s);
+
+    for (int kind = 0; kind < 3; kind++) {
+        kc_chan_t *ch = NULL;
+        if (kind == 0) assert(kc_chan_make_mpmc(&ch, sizeof(long), 8) == 0);
+        if (kind == 1) assert(kc_chan_make_spsc(&ch, sizeof(long), 8) == 0);
+        if (kind == 2) assert(kc_chan_make_striped(&ch, sizeof(long), 8, 1) == 0);
+        kc_chan_slot_t slot;
+        assert(kc_chan_recv_peek(ch, &slot, 0) == KC_EAGAIN);
+
+        /* Peek reads in place; the cell stays taken until released */
+        for (long i = 0; i < 8; i++) assert(kc_chan_send(ch, &i, 0) == 0);
+        assert(kc_chan_recv_peek(ch, &slot, 0) == 0 && slot.n == 1 && *(long*)slot.data == 0);
+        long v = 100;
+        assert(kc_chan_send(ch, &v, 0) == KC_EAGAIN);
+        assert(kc_chan_recv_release(ch, &slot) == 0);
+        assert(kc_chan_send(ch, &v, 0) == 0);
+
+        /* Batch peek stops at what is queued; the next one wraps the ring */
+        assert(kc_chan_recv_peek_many(ch, &slot, 5, 0) == 0 && slot.n == 5);
+        for (size_t i = 0; i < 5; i++) assert(*(long*)kc_chan_slot_elem(ch, &slot, i) == (long)i + 1);
+        assert(kc_chan_slot_elem(ch, &slot, 5) == NULL);
+        assert(kc_chan_recv_release(ch, &slot) == 0);
+        assert(kc_chan_recv_peek_many(ch, &slot, 64, 0) == 0 && slot.n == 3);
+        assert(*(long*)kc_chan_slot_elem(ch, &slot, 2) == 100);
+        assert(kc_chan_recv_release(ch, &slot) == 0);
+        assert(kc_chan_len(ch) == 0);
+
+        /* Batch reserve: as many free cells as there are, across the wrap */
+        assert(kc_chan_reserve_many(ch, &slot, 64, 0) == 0 && slot.n == 8);
+        for (size_t i = 0; i < slot.n; i++) *(long*)kc_chan_slot_elem(ch, &slot, i) = 10 + (long)i;
+        if (kind != 1) { /* SPSC: one claim at a time per side */
+            assert(kc_chan_reserve(ch, &slot, 0) == KC_EAGAIN); /* slot is left as it was */
+            assert(kc_chan_reserve_many(ch, &slot, 64, 0) == KC_EAGAIN);
+        }
+        assert(kc_chan_commit(ch, &slot) == 0);
+        for (long i = 0; i < 8; i++) { v = -1; assert(kc_chan_recv(ch, &v, 0) == 0 && v == 10 + i); }
+
+        /* Close: the rest drains through peek, then EPIPE */
+        v = 7;
+        assert(kc_chan_send(ch, &v, 0) == 0);
+        kc_chan_close(ch);
+        assert(kc_chan_recv_peek(ch, &slot, 0) == 0 && *(long*)slot.data == 7);
+        assert(kc_chan_recv_release(ch, &slot) == 0);
+        assert(kc_chan_recv_peek_many(ch, &slot, 4, 0) == KC_EPIPE);
+        kc_chan_destroy(ch);
+    }
+
+    /* A receiver parks in peek until a reserve is committed */
+    kc_chan_t *ch = NULL;
+    assert(kc_chan_make_mpmc(&ch, sizeof(long), 4) == 0);
+    assert(kc_spawn_co(s, parked_peeker, ch, 0, NULL) == 0);
+    kc_sleep_ms(10);
+    assert(!atomic_load(&co_done));
+    kc_chan_slot_t slot;
+    assert(kc_chan_reserve_many(ch, &slot, 2, 0) == 0 && slot.n == 2);
+    *(long*)kc_chan_slot_elem(ch, &slot, 0) = 41;
+    *(long*)kc_chan_slot_elem(ch, &slot, 1) = 42;
+    assert(kc_chan_commit(ch, &slot) == 0);
+    wait_done();
+    assert(co_rc == 0 && co_val == 41);
+    long v = -1;
+    assert(kc_chan_recv(ch, &v, 0) == 0 && v == 42);
+    kc_chan_destroy(ch);
+
+    /* Batches in, batches out, between two threads */
+    for (int kind = 0; kind < 2; kind++) {
+        if (kind == 0) assert(kc_chan_make_mpmc(&ch, sizeof(long), 256) == 0);
+        else assert(kc_chan_make_spsc(&ch, sizeof(long), 256) == 0);
+        pthread_t th;
+        pthread_create(&th, NULL, batch_producer, ch);
+        long expect = 1;
+        int rc;
+        while ((rc = kc_chan_recv_peek_many(ch, &slot, BATCH, 0)) != KC_EPIPE) {
+            if (rc == KC_EAGAIN) { kc_sleep_ms(0); continue; }
+            assert(rc == 0);
+            for (size_t i = 0; i < slot.n; i++) assert(*(long*)kc_chan_slot_elem(ch, &slot, i) == expect++);
+            assert(kc_chan_recv_release(ch, &slot) == 0);
+        }
+        pthread_join(th, NULL);
+        assert(expect == TOTAL + 1);
+        kc_chan_destroy(ch);
+    }
+
+    /* Mutex channels have no cells to lend; a zero batch is invalid */
+    assert(kc_chan_make(&ch, KC_BUFFERED, sizeof(long), 4) == 0);
+    assert(kc_chan_recv_peek(ch, &slot, 0) == -ENOTSUP);
+    kc_chan_destroy(ch);
+    assert(kc_chan_make_mpmc(&ch, sizeof(long), 4) == 0);
+    assert(kc_chan_recv_peek_many(ch, &slot, 0, 0) == -EINVAL);
+    slot.n = 0;
+    assert(kc_chan_recv_release(ch, &slot) == -EINVAL);
+    kc_chan_destroy(ch);
+    printf("[test] chan_peek ok\n");
+    return 0;
+}
@@ -0,0 +1,162 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Test the channel traffic recorder: start/stop/-EBUSY, a ping-pong over
+// rendezvous channels plus batched and try ops from a plain thread, recorded
+// through 16-record buffers so owners write them out mid-run. The file holds
+// a header, one descriptor per channel ahead of its ops, one thread record
+// per buffer and every op with its size and result; a restart truncates it.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <unistd.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_core.h"
+#include "../include/kcoro_port.h"
+
+#define ROUNDS 50
+#define BATCH 8
+
+struct pp { kc_chan_t *ping, *pong; volatile int done; };
+
+static void pinger(void *arg)
+{
+    struct pp *p = (struct pp*)arg;
+    for (int i = 0; i < ROUNDS; i++) {
+        int v = i;
+        assert(kc_chan_send(p->ping, &v, -1) == 0);
+        assert(kc_chan_recv(p->pong, &v, -1) == 0 && v == i + 1);
+    }
+    p->done++;
+}
+
+static void ponger(void *arg)
+{
+    struct pp *p = (struct pp*)arg;
+    for (int i = 0; i < ROUNDS; i++) {
+        int v = 0;
+        assert(kc_chan_recv(p->ping, &v, -1) == 0 && v == i);
+        v++;
+        assert(kc_chan_send(p->pong, &v, -1) == 0);
+    }
+    p->done++;
+}
+
+static struct kc_chan_rec *load(const char *path, size_t *n)
+{
+    FILE *f = fopen(path, "rb");
+    assert(f);
+    struct kc_chan_rec_header h;
+    assert(fread(&h, sizeof(h), 1, f) == 1);
+    assert(memcmp(h.magic, KC_CHAN_REC_MAGIC, sizeof(KC_CHAN_REC_MAGIC)) == 0);
+    assert(h.version == KC_CHAN_REC_VERSION && h.rec_size == sizeof(struct kc_chan_rec) && h.start_ns);
+    fseek(f, 0, SEEK_END);
+    long bytes = ftell(f) - (long)sizeof(h);
+    assert(bytes >= 0 && bytes % (long)sizeof(struct kc_chan_rec) == 0);
+    *n = (size_t)bytes / sizeof(struct kc_chan_rec);
+    struct kc_chan_rec *r = (struct kc_chan_rec*)malloc(*n * sizeof(*r) + 1);
+    fseek(f, (long)sizeof(h), SEEK_SET);
+    assert(r && fread(r, sizeof(*r), *n, f) == *n);
+    fclose(f);
+    return r;
+}
+
+int main(void)
+{
+    char path[] = "/tmp/kc_chan_rec_XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    close(fd);
+
+    assert(!kc_chan_rec_active());
+    assert(kc_chan_rec_start(NULL, 0) == -EINVAL);
+    assert(kc_chan_rec_start(path, (size_t)1 << 30) == -EINVAL);
+    assert(kc_chan_rec_start("/nonexistent-dir/rec.bin", 0) == -ENOENT);
+    assert(kc_chan_rec_start(path, 16) == 0);
+    assert(kc_chan_rec_active());
+    assert(kc_chan_rec_start(path, 16) == -EBUSY);
+
+    kc_sched_t *s = kc_sched_default();
+    struct pp p = {0};
+    assert(kc_chan_make(&p.ping, KC_RENDEZVOUS, sizeof(int), 0) == 0);
+    assert(kc_chan_make(&p.pong, KC_RENDEZVOUS, sizeof(int), 0) == 0);
+    assert(kc_spawn_co(s, ponger, &p, 0, NULL) == 0);
+    assert(kc_spawn_co(s, pinger, &p, 0, NULL) == 0);
+
+    /* Plain thread: a batch in, a try on the empty channel after draining it */
+    kc_chan_t *q;
+    int in[BATCH], out[BATCH], v;
+    for (int i = 0; i < BATCH; i++) in[i] = i;
+    assert(kc_chan_make(&q, KC_BUFFERED, sizeof(int), 64) == 0);
+    size_t moved = 0;
+    assert(kc_chan_send_many_thread(q, in, BATCH, 0, &moved) == 0 && moved == BATCH);
+    assert(kc_chan_recv_many_thread(q, out, BATCH, 0, &moved) == 0 && moved == BATCH);
+    assert(kc_chan_try_recv(q, &v) == KC_EAGAIN);
+    kc_chan_close(q);
+
+    for (int i = 0; i < 5000 && p.done < 2; i++) usleep(1000);
+    assert(p.done == 2);
+    assert(kc_chan_rec_stop() == 0);
+    assert(!kc_chan_rec_active());
+    assert(kc_chan_rec_stop() == 0);
+
+    kc_chan_rec_stats_t st;
+    kc_chan_rec_get_stats(&st);
+    printf("[chan rec] events=%lu written=%lu threads=%lu channels=%lu\n",
+           st.events, st.written, st.threads, st.channels);
+    assert(st.channels == 3 && st.threads >= 2 && st.dropped == 0 && st.written == st.events);
+
+    size_t n;
+    struct kc_chan_rec *r = load(path, &n);
+    assert(n == st.written);
+    uint32_t ping = 0, pong = 0, qid = 0;
+    int chans = 0, threads = 0, sends = 0, recvs = 0, many = 0, tries = 0, closes = 0;
+    unsigned seen_thread[64] = {0};
+    for (size_t i = 0; i < n; i++) {
+        const struct kc_chan_rec *e = &r[i];
+        assert(e->thread >= 1 && e->thread < 64);
+        if (e->op == KC_CHAN_REC_THREAD) { threads++; seen_thread[e->thread]++; continue; }
+        assert(seen_thread[e->thread] == 1);   /* a thread's first record names it */
+        if (e->op == KC_CHAN_REC_CHAN) {
+            chans++;
+            assert(e->bytes == sizeof(int));
+            if (e->rc == KC_BUFFERED) { qid = e->chan; assert(e->count == 64); }
+            else if (!ping) ping = e->chan;
+            else pong = e->chan;
+            continue;
+        }
+        assert(e->chan == ping || e->chan == pong || e->chan == qid);
+        assert(e->chan != 0 && e->dur_ns < 5000000000u);
+        switch (e->op) {
+        case KC_CHAN_REC_SEND: sends++; assert(e->co && e->rc == 0 && e->count == 1 && e->bytes == sizeof(int)); break;
+        case KC_CHAN_REC_RECV: recvs++; assert(e->co && e->rc == 0 && e->count == 1); break;
+        case KC_CHAN_REC_SEND_MANY: case KC_CHAN_REC_RECV_MANY:
+            many++;
+            assert(e->chan == qid && e->co == 0 && e->count == BATCH && e->bytes == BATCH * sizeof(int));
+            break;
+        case KC_CHAN_REC_TRY_RECV: tries++; assert(e->chan == qid && e->rc == KC_EAGAIN && e->count == 0); break;
+        case KC_CHAN_REC_CLOSE: closes++; assert(e->chan == qid); break;
+        default: assert(!"unexpected op");
+        }
+    }
+    assert(chans == 3 && ping && pong && qid && threads == (int)st.threads);
+    assert(sends == 2 * ROUNDS && recvs == 2 * ROUNDS && many == 2 && tries == 1 && closes == 1);
+    free(r);
+
+    /* Restart: a fresh file, numbering starts over */
+    assert(kc_chan_rec_start(path, 0) == 0);
+    assert(kc_chan_try_send(p.ping, &v) == KC_EAGAIN);
+    assert(kc_chan_rec_stop() == 0);
+    r = load(path, &n);
+    assert(n == 3 && r[0].op == KC_CHAN_REC_THREAD && r[1].op == KC_CHAN_REC_CHAN && r[1].chan == 1);
+    assert(r[2].op == KC_CHAN_REC_TRY_SEND && r[2].chan == 1 && r[2].rc == KC_EAGAIN);
+    free(r);
+
+    kc_chan_destroy(q);
+    kc_chan_destroy(p.ping);
+    kc_chan_destroy(p.pong);
+    unlink(path);
+    printf("[chan rec] ok\n");
+    return 0;
+}
@@ -0,0 +1,190 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Test readiness sets: a set over thousands of channels reports only the
+// ready ones, level-triggered members repeat while edge-triggered ones fire
+// once per change, a parked wait wakes on send, close, timeout and cancel,
+// and ring channels signal from their lock-free paths
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <assert.h>
+#include <time.h>
+#include <unistd.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_core.h"
+#include "../include/kcoro_port.h"
+
+#define NCH    4096
+#define ROUNDS 2000
+
+static kc_chan_t *chs[NCH];
+
+struct ctx {
+    kc_chan_t *ring;
+    kc_cancel_t *tok;
+    volatile int stage, done, fed, acked;
+    int bad;
+    long wait_ns, cancel_us;
+};
+
+static long now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000L + ts.tv_nsec / 1000;
+}
+
+/* Feeds the waiter one stage at a time, one element per parked wait. */
+static void feeder(void *arg)
+{
+    struct ctx *c = (struct ctx*)arg;
+    while (c->stage < 1) kc_sleep_ms(1);
+    for (int i = 0; i < ROUNDS; i++) {
+        int v = i;
+        if (kc_chan_send(chs[(i * 7919) % NCH], &v, -1) != 0) c->bad++;
+        while (c->acked <= i) kcoro_yield();
+    }
+    while (c->stage < 2) kc_sleep_ms(1);
+    kc_sleep_ms(20);
+    kc_chan_close(chs[NCH - 1]);
+    while (c->stage < 3) kc_sleep_ms(1);
+    kc_sleep_ms(20);
+    for (int i = 0; i < 100; i++) {
+        int v = i;
+        if (kc_chan_send(c->ring, &v, -1) != 0) c->bad++;
+        kcoro_yield();
+    }
+    c->fed = 1;
+}
+
+static void waiter(void *arg)
+{
+    struct ctx *c = (struct ctx*)arg;
+    kc_chan_set_t *set = NULL, *edge = NULL;
+    struct kc_chan_set_event ev[8];
+    int v = 0;
+    if (kc_chan_set_create(&set, NULL) != 0 || kc_chan_set_create(&edge, NULL) != 0) { c->bad++; c->done = 1; return; }
+    for (int i = 0; i < NCH; i++)
+        if (kc_chan_set_add(set, chs[i], KC_CHAN_SET_RECV, (void*)(long)i) != 0) c->bad++;
+    if (kc_chan_set_add(set, chs[0], KC_CHAN_SET_RECV, NULL) != -EEXIST) c->bad++;
+    if (kc_chan_set_wait(set, ev, 8, 0) != KC_EAGAIN) c->bad++;
+
+    /* Level-triggered: reported until drained; max caps each wait */
+    for (int i = 0; i < 3; i++) { v = i; if (kc_chan_send(chs[i * 1000], &v, 0) != 0) c->bad++; }
+    if (kc_chan_set_wait(set, ev, 2, 0) != 2 || ev[0].user != (void*)0L || ev[1].user != (void*)1000L) c->bad++;
+    if (kc_chan_set_wait(set, ev, 8, 0) != 3 || ev[0].user != (void*)2000L || ev[0].events != KC_CHAN_SET_RECV) c->bad++;
+    for (int i = 0; i < 3; i++) if (kc_chan_recv(chs[i * 1000], &v, 0) != 0 || v != i) c->bad++;
+    if (kc_chan_set_wait(set, ev, 8, 0) != KC_EAGAIN) c->bad++;
+
+    /* Edge-triggered: once per state change */
+    if (kc_chan_set_add(edge, chs[5], KC_CHAN_SET_RECV | KC_CHAN_SET_EDGE, NULL) != 0) c->bad++;
+    v = 1; (void)kc_chan_send(chs[5], &v, 0);
+    if (kc_chan_set_wait(edge, ev, 8, 0) != 1 || ev[0].ch != chs[5]) c->bad++;
+    if (kc_chan_set_wait(edge, ev, 8, 0) != KC_EAGAIN) c->bad++;
+    (void)kc_chan_send(chs[5], &v, 0);
+    if (kc_chan_set_wait(edge, ev, 8, 0) != 1) c->bad++;
+    while (kc_chan_recv(chs[5], &v, 0) == 0) {}
+    (void)kc_chan_set_wait(set, ev, 8, 0);
+
+    /* SEND interest: full until a receive makes room */
+    if (kc_chan_set_add(edge, chs[6], KC_CHAN_SET_SEND, NULL) != 0) c->bad++;
+    if (kc_chan_set_wait(edge, ev, 8, 0) != 1 || ev[0].events != KC_CHAN_SET_SEND) c->bad++;
+    while (kc_chan_send(chs[6], &v, 0) == 0) {}
+    if (kc_chan_set_wait(edge, ev, 8, 0) != KC_EAGAIN) c->bad++;
+    (void)kc_chan_recv(chs[6], &v, 0);
+    if (kc_chan_set_wait(edge, ev, 8, 0) != 1 || ev[0].ch != chs[6]) c->bad++;
+    if (kc_chan_set_remove(edge, chs[6]) != 0 || kc_chan_set_remove(edge, chs[6]) != -ENOENT) c->bad++;
+    while (kc_chan_recv(chs[6], &v, 0) == 0) {}
+    (void)kc_chan_set_wait(set, ev, 8, 0);
+
+    /* Parked: each send wakes the wait, which sees one channel of NCH */
+    if (kc_chan_set_wait(set, ev, 8, 0) != KC_EAGAIN) c->bad++;
+    c->stage = 1;
+    long t0 = now_us();
+    for (int i = 0; i < ROUNDS; i++) {
+        int n = kc_chan_set_wait(set, ev, 8, -1);
+        if (n != 1 || ev[0].user != (void*)(long)((i * 7919) % NCH)) { c->bad++; c->acked = i + 1; continue; }
+        if (kc_chan_recv(ev[0].ch, &v, 0) != 0 || v != i) c->bad++;
+        c->acked = i + 1;
+    }
+    c->wait_ns = (now_us() - t0) * 1000 / ROUNDS;
+
+    /* Close reports CLOSED; removing stops it */
+    c->stage = 2;
+    if (kc_chan_set_wait(set, ev, 8, -1) != 1 || ev[0].ch != chs[NCH - 1] || !(ev[0].events & KC_CHAN_SET_CLOSED)) c->bad++;
+    if (kc_chan_set_remove(set, chs[NCH - 1]) != 0) c->bad++;
+
+    /* Timeout */
+    long t1 = now_us();
+    if (kc_chan_set_wait(set, ev, 8, 50) != KC_ETIME || now_us() - t1 < 45000) c->bad++;
+
+    /* Ring channel: lock-free sends still signal */
+    kc_chan_set_t *rs = NULL;
+    if (kc_chan_set_create(&rs, NULL) != 0 || kc_chan_set_add(rs, c->ring, KC_CHAN_SET_RECV, NULL) != 0) c->bad++;
+    c->stage = 3;
+    int got = 0;
+    while (got < 100) {
+        int n = kc_chan_set_wait(rs, ev, 8, 2000);
+        if (n != 1) { c->bad++; break; }
+        while (kc_chan_recv(c->ring, &v, 0) == 0) { if (v != got) c->bad++; got++; }
+    }
+    kc_chan_set_destroy(rs);
+    kc_chan_set_destroy(edge);
+    kc_chan_set_destroy(set);
+    c->done = 1;
+}
+
+static void cancelled(void *arg)
+{
+    struct ctx *c = (struct ctx*)arg;
+    kc_chan_set_t *set = NULL;
+    struct kc_chan_set_event ev[1];
+    if (kc_chan_set_create(&set, c->tok) != 0 || kc_chan_set_add(set, chs[1], KC_CHAN_SET_RECV, NULL) != 0) c->bad++;
+    c->stage = 4;
+    if (kc_chan_set_wait(set, ev, 1, -1) != KC_ECANCELED) c->bad++;
+    c->cancel_us = now_us();
+    kc_chan_set_destroy(set);
+    c->done = 2;
+}
+
+int main(void)
+{
+    static struct ctx c;
+    for (int i = 0; i < NCH; i++) assert(kc_chan_make(&chs[i], KC_BUFFERED, sizeof(int), 4) == 0);
+    assert(kc_chan_make_mpmc(&c.ring, sizeof(int), 16) == 0);
+
+    /* Nothing to watch on a rendezvous channel */
+    kc_chan_t *rv = NULL;
+    kc_chan_set_t *s = NULL;
+    assert(kc_chan_make(&rv, KC_RENDEZVOUS, sizeof(int), 0) == 0);
+    assert(kc_chan_set_create(&s, NULL) == 0);
+    assert(kc_chan_set_add(s, rv, KC_CHAN_SET_RECV, NULL) == -ENOTSUP);
+    assert(kc_chan_set_add(s, chs[0], 0, NULL) == -EINVAL);
+    kc_chan_set_destroy(s);
+    kc_chan_destroy(rv);
+
+    assert(kc_spawn_co(kc_sched_default(), waiter, &c, 0, NULL) == 0);
+    assert(kc_spawn_co(kc_sched_default(), feeder, &c, 0, NULL) == 0);
+    for (int i = 0; i < 20000 && !c.done; i++) usleep(1000);
+    assert(c.done == 1 && c.fed && c.bad == 0);
+
+    assert(kc_cancel_init(&c.tok) == 0);
+    assert(kc_spawn_co(kc_sched_default(), cancelled, &c, 0, NULL) == 0);
+    for (int i = 0; i < 2000 && c.stage < 4; i++) usleep(1000);
+    usleep(20000);
+    assert(c.done == 1);
+    long t0 = now_us();
+    kc_cancel_trigger(c.tok);
+    for (int i = 0; i < 2000 && c.done != 2; i++) usleep(100);
+    assert(c.done == 2 && c.bad == 0);
+
+    /* A destroyed member detaches itself */
+    assert(kc_chan_set_create(&s, NULL) == 0);
+    assert(kc_chan_set_add(s, chs[2], KC_CHAN_SET_RECV, NULL) == 0);
+    for (int i = 0; i < NCH; i++) kc_chan_destroy(chs[i]);
+    kc_chan_set_destroy(s);
+    kc_chan_destroy(c.ring);
+    kc_cancel_destroy(c.tok);
+    printf("[chan set] ok channels=%d wait=%ldns cancel=%ldus\n", NCH, c.wait_ns, c.cancel_us - t0);
+    return 0;
+}
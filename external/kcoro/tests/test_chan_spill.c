@@ -0,0 +1,109 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// KC_UNLIMITED spill files (kc_chan_set_spill)
+// 1) a backlog far past the resident limit spills cold segments, keeps the
+//    resident byte count near the limit, and drains in FIFO order: every
+//    spilled segment is read back once and the file ends up empty.
+// 2) batch sends/receives across spilled segments keep FIFO order, and a
+//    channel destroyed with segments still on file gives back its resident
+//    bytes.
+// 3) a bad spill directory leaves segments resident; nothing is lost.
+#include <stdio.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <assert.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_port.h"
+#include "../include/kcoro_sched.h"
+
+enum { SEG = 64, LIMIT = 16 * 1024, BURST = 20000 };
+
+static struct kc_chan_snapshot snap(kc_chan_t *ch){
+    struct kc_chan_snapshot s;
+    assert(kc_chan_snapshot(ch, &s) == 0);
+    return s;
+}
+
+static void burst_fifo(void){
+    kc_chan_t *ch = NULL;
+    assert(kc_chan_make(&ch, KC_UNLIMITED, sizeof(int), SEG) == 0);
+    size_t peak = 0;
+    for (int i = 0; i < BURST; i++) {
+        assert(kc_chan_send(ch, &i, 0) == 0);
+        if (kc_chan_spill_resident() > peak) peak = kc_chan_spill_resident();
+    }
+    assert(kc_chan_len(ch) == BURST);
+    struct kc_chan_snapshot s = snap(ch);
+    assert(s.spill_writes > 0 && s.spilled_bytes == s.spill_writes * SEG * sizeof(int));
+    /* limit plus the head / tail segments that never spill */
+    assert(peak <= LIMIT + 2 * SEG * sizeof(int));
+    for (int i = 0; i < BURST; i++) {
+        int v = -1;
+        assert(kc_chan_recv(ch, &v, 0) == 0 && v == i);
+    }
+    int v;
+    assert(kc_chan_recv(ch, &v, 0) == KC_EAGAIN);
+    s = snap(ch);
+    assert(s.spill_reads == s.spill_writes && s.spilled_bytes == 0);
+    printf("[test] chan_spill burst=%d spilled=%lu peak=%zu\n", BURST, s.spill_writes, peak);
+    kc_chan_destroy(ch);
+    assert(kc_chan_spill_resident() == 0);
+}
+
+static void batches_and_destroy(void){
+    kc_chan_t *ch = NULL;
+    assert(kc_chan_make(&ch, KC_UNLIMITED, sizeof(int), SEG) == 0);
+    static int in[3 * SEG + 5], out[3 * SEG + 5];
+    int next = 0, want = 0;
+    for (int round = 0; round < 200; round++) {
+        size_t n = 0;
+        for (int i = 0; i < 3 * SEG + 5; i++) in[i] = next++;
+        assert(kc_chan_send_many(ch, in, 3 * SEG + 5, 0, &n) == 0 && n == 3 * SEG + 5);
+        assert(kc_chan_recv_many(ch, out, 2 * SEG + 1, 0, &n) == 0 && n == 2 * SEG + 1);
+        for (size_t i = 0; i < n; i++) assert(out[i] == want++);
+    }
+    assert(snap(ch).spill_writes > 0 && snap(ch).spilled_bytes > 0);
+    /* destroyed with a spilled backlog */
+    kc_chan_destroy(ch);
+    assert(kc_chan_spill_resident() == 0);
+}
+
+static void bad_dir(void){
+    assert(kc_chan_set_spill(LIMIT, "") == -EINVAL);
+    assert(kc_chan_set_spill(LIMIT, "/nonexistent/kcoro-spill") == 0);
+    kc_chan_t *ch = NULL;
+    assert(kc_chan_make(&ch, KC_UNLIMITED, sizeof(int), SEG) == 0);
+    for (int i = 0; i < 4000; i++) assert(kc_chan_send(ch, &i, 0) == 0);
+    struct kc_chan_snapshot s = snap(ch);
+    assert(s.spill_writes == 0 && s.spilled_bytes == 0);
+    for (int i = 0; i < 4000; i++) {
+        int v = -1;
+        assert(kc_chan_recv(ch, &v, 0) == 0 && v == i);
+    }
+    kc_chan_destroy(ch);
+}
+
+static _Atomic(int) g_done;
+
+static void run_all(void *arg){
+    (void)arg;
+    burst_fifo();
+    batches_and_destroy();
+    bad_dir();
+    atomic_store(&g_done, 1);
+}
+
+int main(void){
+    printf("[test] chan_spill start\n");
+    assert(kc_chan_spill_resident() == 0);
+    assert(kc_chan_set_spill(LIMIT, NULL) == 0);
+    kc_sched_opts_t opts = {0};
+    opts.workers = 1;
+    kc_sched_t *s = kc_sched_init(&opts); assert(s);
+    assert(kc_spawn_co(s, run_all, NULL, 0, NULL) == 0);
+    for (int i = 0; i < 2000 && !atomic_load(&g_done); i++) kc_sleep_ms(5);
+    kc_sched_shutdown(s);
+    assert(kc_chan_set_spill(0, NULL) == 0);
+    if (!atomic_load(&g_done)) { fprintf(stderr, "spill checks did not finish\n"); return 1; }
+    printf("[test] chan_spill ok\n");
+    return 0;
+}
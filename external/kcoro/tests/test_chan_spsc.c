@@ -0,0 +1,167 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Wait-free SPSC ring channel (kc_chan_make_spsc)
+// 1) try ops: EAGAIN when full/empty, FIFO order, capability bit, len,
+//    close drains then EPIPE, snapshot totals.
+// 2) a select recv parked on the empty ring is completed by a later send,
+//    and a select send parked on the full ring by a later recv.
+// 3) one producer and one consumer stream values through a tiny ring with
+//    alternating blocking and timed ops: strict FIFO, nothing lost.
+#include <stdio.h>
+#include <stdatomic.h>
+#include <assert.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_core.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_port.h"
+
+enum { ITEMS = 200000 };
+
+static kc_chan_t *g_ch;
+static _Atomic(int) g_stage;
+static _Atomic(int) g_recvd;
+static _Atomic(int) g_out_of_order;
+static int g_sel_rc = 1, g_sel_idx = -1, g_sel_val;
+static int g_ssel_rc = 1, g_ssel_idx = -1;
+
+static void producer(void *arg){
+    (void)arg;
+    for (int i = 0; i < ITEMS; i++) {
+        int rc;
+        do rc = (i & 1) ? kc_chan_send(g_ch, &i, -1) : kc_chan_send(g_ch, &i, 50);
+        while (rc == KC_ETIME);
+        assert(rc == 0);
+    }
+    kc_chan_close(g_ch);
+}
+
+static void consumer(void *arg){
+    (void)arg;
+    int expect = 0;
+    for (;;) {
+        int v = -1;
+        int rc = (expect & 1) ? kc_chan_recv(g_ch, &v, 50) : kc_chan_recv(g_ch, &v, -1);
+        if (rc == KC_ETIME) continue;
+        if (rc == KC_EPIPE) break;
+        assert(rc == 0);
+        if (v != expect) atomic_fetch_add(&g_out_of_order, 1);
+        expect = v + 1;
+        atomic_fetch_add(&g_recvd, 1);
+    }
+    atomic_fetch_add(&g_stage, 1);
+}
+
+static void select_recv(void *arg){
+    (void)arg;
+    kc_select_t *sel = NULL;
+    assert(kc_select_create(&sel, NULL) == 0);
+    assert(kc_select_add_recv(sel, g_ch, &g_sel_val) == 0);
+    g_sel_rc = kc_select_wait(sel, 5000, &g_sel_idx, NULL);
+    kc_select_destroy(sel);
+    atomic_fetch_add(&g_stage, 1);
+}
+
+static void late_send(void *arg){
+    (void)arg;
+    kc_sleep_ms(20);
+    int v = 99;
+    assert(kc_chan_send(g_ch, &v, -1) == 0);
+}
+
+static void select_send(void *arg){
+    (void)arg;
+    for (int i = 0; i < 2; i++) assert(kc_chan_send(g_ch, &i, 0) == 0);
+    int v = 7;
+    kc_select_t *sel = NULL;
+    assert(kc_select_create(&sel, NULL) == 0);
+    assert(kc_select_add_send(sel, g_ch, &v) == 0);
+    g_ssel_rc = kc_select_wait(sel, -1, &g_ssel_idx, NULL);
+    kc_select_destroy(sel);
+    atomic_fetch_add(&g_stage, 1);
+}
+
+static void late_recv(void *arg){
+    (void)arg;
+    kc_sleep_ms(20);
+    int v = -1;
+    assert(kc_chan_recv(g_ch, &v, -1) == 0 && v == 0);
+    assert(kc_chan_recv(g_ch, &v, -1) == 0 && v == 1);
+    assert(kc_chan_recv(g_ch, &v, -1) == 0 && v == 7);
+}
+
+static void basic(void *arg){
+    (void)arg;
+    kc_chan_t *ch = NULL;
+    assert(kc_chan_make_spsc(&ch, sizeof(int), 3) == 0); /* rounds up to 4 */
+    assert(kc_chan_capabilities(ch) & KC_CHAN_CAP_SPSC);
+    assert(!(kc_chan_capabilities(ch) & KC_CHAN_CAP_MPMC));
+    int v;
+    assert(kc_chan_recv(ch, &v, 0) == KC_EAGAIN);
+    for (int i = 0; i < 4; i++) assert(kc_chan_send(ch, &i, 0) == 0);
+    assert(kc_chan_send(ch, &v, 0) == KC_EAGAIN);
+    assert(kc_chan_len(ch) == 4);
+    for (int i = 0; i < 2; i++) { assert(kc_chan_recv(ch, &v, 0) == 0 && v == i); }
+    for (int i = 4; i < 6; i++) assert(kc_chan_send(ch, &i, 0) == 0); /* wraps */
+    kc_chan_close(ch);
+    assert(kc_chan_send(ch, &v, 0) == KC_EPIPE);
+    for (int i = 2; i < 6; i++) { assert(kc_chan_recv(ch, &v, -1) == 0 && v == i); }
+    assert(kc_chan_recv(ch, &v, -1) == KC_EPIPE);
+    struct kc_chan_snapshot snap;
+    assert(kc_chan_snapshot(ch, &snap) == 0);
+    assert(snap.total_sends == 6 && snap.total_recvs == 6 && snap.count == 0);
+    assert(snap.total_bytes_sent == 6 * sizeof(int));
+    assert(snap.send_eagain == 1 && snap.recv_eagain == 1 && snap.closed);
+    kc_chan_destroy(ch);
+    atomic_store(&g_stage, 1);
+}
+
+static int wait_for(_Atomic(int) *v, int want){
+    for (int i = 0; i < 2000 && atomic_load(v) < want; i++) kc_sleep_ms(5);
+    return atomic_load(v) >= want;
+}
+
+int main(void){
+    printf("[test] chan_spsc start\n");
+    kc_sched_opts_t opts = {0};
+    opts.workers = 2;
+    kc_sched_t *s = kc_sched_init(&opts); assert(s);
+
+    assert(kc_spawn_co(s, basic, NULL, 0, NULL) == 0);
+    int ok_basic = wait_for(&g_stage, 1);
+
+    assert(kc_chan_make_spsc(&g_ch, sizeof(int), 2) == 0);
+    assert(kc_spawn_co(s, select_recv, NULL, 0, NULL) == 0);
+    assert(kc_spawn_co(s, late_send, NULL, 0, NULL) == 0);
+    int ok_sel = wait_for(&g_stage, 2);
+    assert(kc_spawn_co(s, select_send, NULL, 0, NULL) == 0);
+    assert(kc_spawn_co(s, late_recv, NULL, 0, NULL) == 0);
+    int ok_ssel = wait_for(&g_stage, 3);
+    for (int i = 0; i < 200 && kc_chan_len(g_ch); i++) kc_sleep_ms(5);
+    kc_chan_destroy(g_ch);
+
+    assert(kc_chan_make_spsc(&g_ch, sizeof(int), 4) == 0);
+    assert(kc_spawn_co(s, consumer, NULL, 0, NULL) == 0);
+    assert(kc_spawn_co(s, producer, NULL, 0, NULL) == 0);
+    int ok_stream = wait_for(&g_stage, 4);
+
+    struct kc_chan_snapshot snap;
+    assert(kc_chan_snapshot(g_ch, &snap) == 0);
+    kc_sched_shutdown(s);
+    kc_chan_destroy(g_ch);
+
+    if (!ok_basic) { fprintf(stderr, "basic ring checks did not finish\n"); return 1; }
+    if (!ok_sel || g_sel_rc != 0 || g_sel_idx != 0 || g_sel_val != 99) {
+        fprintf(stderr, "select recv rc=%d idx=%d val=%d\n", g_sel_rc, g_sel_idx, g_sel_val); return 2;
+    }
+    if (!ok_ssel || g_ssel_rc != 0 || g_ssel_idx != 0) {
+        fprintf(stderr, "select send rc=%d idx=%d\n", g_ssel_rc, g_ssel_idx); return 3;
+    }
+    if (!ok_stream) { fprintf(stderr, "stalled: recvd=%d\n", atomic_load(&g_recvd)); return 4; }
+    if (atomic_load(&g_recvd) != ITEMS || atomic_load(&g_out_of_order)) {
+        fprintf(stderr, "recvd=%d out_of_order=%d\n", atomic_load(&g_recvd), atomic_load(&g_out_of_order)); return 5;
+    }
+    if (snap.total_sends != ITEMS || snap.total_recvs != ITEMS || !snap.closed) {
+        fprintf(stderr, "snapshot sends=%lu recvs=%lu closed=%d\n", snap.total_sends, snap.total_recvs, snap.closed); return 6;
+    }
+    printf("[test] chan_spsc ok msgs=%d\n", ITEMS);
+    return 0;
+}
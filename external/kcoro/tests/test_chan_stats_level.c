@@ -0,0 +1,86 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Test per-channel stats levels: off records nothing, counters skip the
+// timestamps, full keeps them, and a coroutine's coarse clock moves on
+// across a sleep
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <errno.h>
+#include <unistd.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_core.h"
+#include "../include/kcoro_port.h"
+
+static void ops(kc_chan_t *ch, int n)
+{
+    for (int i = 0; i < n; i++) {
+        int v = i, out = -1;
+        assert(kc_chan_send(ch, &v, 0) == 0);
+        assert(kc_chan_recv(ch, &out, 0) == 0 && out == i);
+    }
+}
+
+struct ctx { kc_chan_t *ch; volatile int done; };
+
+static void levels(void *arg)
+{
+    struct ctx *c = (struct ctx*)arg;
+    kc_chan_t *ch = c->ch;
+    struct kc_chan_snapshot s;
+    assert(kc_chan_snapshot(ch, &s) == 0 && s.stats_level == KC_CHAN_STATS_FULL);
+    assert(kc_chan_set_stats_level(ch, 3) == -EINVAL);
+    assert(kc_chan_set_stats_level(NULL, 0) == -EINVAL);
+
+    assert(kc_chan_set_stats_level(ch, KC_CHAN_STATS_OFF) == 0);
+    ops(ch, 10);
+    assert(kc_chan_snapshot(ch, &s) == 0);
+    assert(s.stats_level == KC_CHAN_STATS_OFF && s.total_sends == 0 && s.total_recvs == 0);
+
+    assert(kc_chan_set_stats_level(ch, KC_CHAN_STATS_COUNTERS) == 0);
+    ops(ch, 10);
+    int v = 0;
+    assert(kc_chan_recv(ch, &v, 0) == KC_EAGAIN);
+    assert(kc_chan_snapshot(ch, &s) == 0);
+    assert(s.total_sends == 10 && s.total_recvs == 10 && s.total_bytes_sent == 10 * sizeof(int));
+    assert(s.first_op_time_ns == 0 && s.last_op_time_ns == 0 && s.recv_eagain == 1);
+
+    assert(kc_chan_set_stats_level(ch, KC_CHAN_STATS_FULL) == 0);
+    ops(ch, 10);
+    assert(kc_chan_snapshot(ch, &s) == 0);
+    assert(s.total_sends == 20 && s.first_op_time_ns > 0 && s.last_op_time_ns >= s.first_op_time_ns);
+    c->done = 1;
+}
+
+static void sleeper(void *arg)
+{
+    struct ctx *c = (struct ctx*)arg;
+    ops(c->ch, 1);
+    kc_sleep_ms(30);
+    ops(c->ch, 1);
+    c->done = 1;
+}
+
+int main(void)
+{
+    kc_chan_t *ch = NULL;
+    assert(kc_chan_make(&ch, KC_BUFFERED, sizeof(int), 8) == 0);
+    struct ctx l = { .ch = ch };
+    assert(kc_spawn_co(kc_sched_default(), levels, &l, 0, NULL) == 0);
+    for (int i = 0; i < 2000 && !l.done; i++) usleep(1000);
+    assert(l.done);
+    kc_chan_destroy(ch);
+
+    /* The clock is refreshed when the coroutine resumes after its sleep */
+    struct kc_chan_snapshot s;
+    assert(kc_chan_make(&ch, KC_BUFFERED, sizeof(int), 8) == 0);
+    struct ctx c = { .ch = ch };
+    assert(kc_spawn_co(kc_sched_default(), sleeper, &c, 0, NULL) == 0);
+    for (int i = 0; i < 2000 && !c.done; i++) usleep(1000);
+    assert(c.done);
+    assert(kc_chan_snapshot(ch, &s) == 0);
+    assert(s.total_sends == 2 && s.last_op_time_ns - s.first_op_time_ns >= 25 * 1000000L);
+    kc_chan_destroy(ch);
+    printf("[chan stats level] ok\n");
+    return 0;
+}
@@ -0,0 +1,145 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Striped MPMC channel (kc_chan_make_striped)
+// 1) shape: stripes and per-stripe capacity round up to powers of two,
+//    capability bits; a full channel means every stripe is full, and len /
+//    snapshots add the stripes up.
+// 2) 16 producers x 4 consumers on a small striped channel: every value
+//    arrives exactly once and the snapshot totals match.
+// 3) a select recv parked on the channel is completed by a later send.
+// 4) close: queued values drain from every stripe, then EPIPE.
+#include <stdio.h>
+#include <stdatomic.h>
+#include <assert.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_core.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_port.h"
+
+enum { PRODUCERS = 16, CONSUMERS = 4, PER_PRODUCER = 10000 };
+
+static kc_chan_t *g_ch;
+static _Atomic(int) g_recvd, g_cons_done, g_prod_done, g_dups, g_sel_done;
+static _Atomic(long long) g_sum;
+static unsigned char g_seen[PRODUCERS * PER_PRODUCER];
+static int g_sel_rc = 1, g_sel_idx = -1, g_sel_val;
+
+static void producer(void *arg){
+    int id = (int)(long)arg;
+    for (int i = 0; i < PER_PRODUCER; i++) {
+        int v = id * PER_PRODUCER + i;
+        int rc;
+        do rc = (i & 1) ? kc_chan_send(g_ch, &v, -1) : kc_chan_send(g_ch, &v, 50);
+        while (rc == KC_ETIME);
+        assert(rc == 0);
+    }
+    atomic_fetch_add(&g_prod_done, 1);
+}
+
+static void consumer(void *arg){
+    int timed = (int)(long)arg & 1;
+    for (;;) {
+        int v = -1;
+        int rc = timed ? kc_chan_recv(g_ch, &v, 50) : kc_chan_recv(g_ch, &v, -1);
+        if (rc == KC_ETIME) continue;
+        if (rc == KC_EPIPE) break;
+        assert(rc == 0 && v >= 0 && v < PRODUCERS * PER_PRODUCER);
+        if (__atomic_exchange_n(&g_seen[v], 1, __ATOMIC_RELAXED)) atomic_fetch_add(&g_dups, 1);
+        atomic_fetch_add(&g_sum, v);
+        atomic_fetch_add(&g_recvd, 1);
+    }
+    atomic_fetch_add(&g_cons_done, 1);
+}
+
+static void selector(void *arg){
+    (void)arg;
+    kc_select_t *sel = NULL;
+    assert(kc_select_create(&sel, NULL) == 0);
+    assert(kc_select_add_recv(sel, g_ch, &g_sel_val) == 0);
+    g_sel_rc = kc_select_wait(sel, 5000, &g_sel_idx, NULL);
+    kc_select_destroy(sel);
+    atomic_store(&g_sel_done, 1);
+}
+
+static void late_send(void *arg){
+    (void)arg;
+    kc_sleep_ms(20);
+    int v = 99;
+    assert(kc_chan_send(g_ch, &v, -1) == 0);
+}
+
+static int wait_for(_Atomic(int) *v, int want){
+    for (int i = 0; i < 4000 && atomic_load(v) < want; i++) kc_sleep_ms(5);
+    return atomic_load(v) >= want;
+}
+
+static int basic(void){
+    kc_chan_t *ch = NULL;
+    assert(kc_chan_make_striped(&ch, sizeof(int), 6, 3) == 0); /* 4 stripes x 2 */
+    unsigned caps = kc_chan_capabilities(ch);
+    if (!(caps & KC_CHAN_CAP_STRIPED) || !(caps & KC_CHAN_CAP_MPMC)) return 1;
+    int v, seen = 0;
+    assert(kc_chan_recv(ch, &v, 0) == KC_EAGAIN);
+    for (int i = 0; i < 8; i++) if (kc_chan_send(ch, &i, 0) != 0) return 2;
+    if (kc_chan_send(ch, &v, 0) != KC_EAGAIN || kc_chan_len(ch) != 8) return 3;
+    struct kc_chan_snapshot snap;
+    assert(kc_chan_snapshot(ch, &snap) == 0);
+    if (snap.capacity != 8 || snap.count != 8 || snap.total_sends != 8 || snap.send_eagain != 1) return 4;
+    for (int i = 0; i < 4; i++) { if (kc_chan_recv(ch, &v, 0) != 0) return 5; seen |= 1 << v; }
+    kc_chan_close(ch);
+    assert(kc_chan_send(ch, &v, 0) == KC_EPIPE);
+    for (int i = 0; i < 4; i++) { if (kc_chan_recv(ch, &v, 0) != 0) return 6; seen |= 1 << v; }
+    if (seen != 0xff || kc_chan_recv(ch, &v, 0) != KC_EPIPE) return 7;
+    assert(kc_chan_snapshot(ch, &snap) == 0);
+    if (snap.total_recvs != 8 || snap.count != 0 || !snap.closed) return 8;
+    kc_chan_destroy(ch);
+
+    /* 1 stripe is a plain MPMC ring; 0 picks one per CPU. */
+    assert(kc_chan_make_striped(&ch, sizeof(int), 64, 1) == 0);
+    caps = kc_chan_capabilities(ch);
+    kc_chan_destroy(ch);
+    if (caps & KC_CHAN_CAP_STRIPED) return 9;
+    assert(kc_chan_make_striped(&ch, sizeof(int), 0, 0) == 0);
+    kc_chan_destroy(ch);
+    return 0;
+}
+
+int main(void){
+    printf("[test] chan_striped start\n");
+    int rc = basic();
+    if (rc) { fprintf(stderr, "basic shape check %d failed\n", rc); return 1; }
+
+    kc_sched_opts_t opts = {0};
+    opts.workers = 4;
+    kc_sched_t *s = kc_sched_init(&opts); assert(s);
+
+    assert(kc_chan_make_striped(&g_ch, sizeof(int), 16, 4) == 0);
+    assert(kc_spawn_co(s, selector, NULL, 0, NULL) == 0);
+    assert(kc_spawn_co(s, late_send, NULL, 0, NULL) == 0);
+    int ok_sel = wait_for(&g_sel_done, 1);
+
+    for (long i = 0; i < CONSUMERS; i++) assert(kc_spawn_co(s, consumer, (void*)i, 0, NULL) == 0);
+    for (long i = 0; i < PRODUCERS; i++) assert(kc_spawn_co(s, producer, (void*)i, 0, NULL) == 0);
+    int ok_prod = wait_for(&g_prod_done, PRODUCERS);
+    kc_chan_close(g_ch);
+    int ok_cons = wait_for(&g_cons_done, CONSUMERS);
+
+    struct kc_chan_snapshot snap;
+    assert(kc_chan_snapshot(g_ch, &snap) == 0);
+    kc_sched_shutdown(s);
+    kc_chan_destroy(g_ch);
+
+    const long long n = (long long)PRODUCERS * PER_PRODUCER;
+    if (!ok_sel || g_sel_rc != 0 || g_sel_idx != 0 || g_sel_val != 99) {
+        fprintf(stderr, "select recv rc=%d idx=%d val=%d\n", g_sel_rc, g_sel_idx, g_sel_val); return 2;
+    }
+    if (!ok_prod || !ok_cons) { fprintf(stderr, "stalled: producers=%d consumers=%d recvd=%d\n",
+                                        atomic_load(&g_prod_done), atomic_load(&g_cons_done), atomic_load(&g_recvd)); return 3; }
+    if (atomic_load(&g_recvd) != n || atomic_load(&g_dups) || atomic_load(&g_sum) != n * (n - 1) / 2) {
+        fprintf(stderr, "recvd=%d dups=%d sum=%lld\n", atomic_load(&g_recvd), atomic_load(&g_dups), atomic_load(&g_sum)); return 4;
+    }
+    if (snap.total_sends != (unsigned long)n + 1 || snap.total_recvs != (unsigned long)n + 1) {
+        fprintf(stderr, "snapshot sends=%lu recvs=%lu\n", snap.total_sends, snap.total_recvs); return 5;
+    }
+    printf("[test] chan_striped ok msgs=%lld\n", n);
+    return 0;
+}
@@ -0,0 +1,177 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Channel ops from threads outside the scheduler
+// 1) kc_chan_send_thread / kc_chan_recv_thread against coroutines on a
+//    small buffered channel, an MPMC ring and a rendezvous channel (request
+//    and reply): everything arrives, in order.
+// 2) a timed kc_chan_recv_thread expires (KC_ETIME), close wakes a blocked
+//    thread (KC_EPIPE).
+// 3) kc_chan_post from several threads into a small buffered channel: every
+//    element arrives, each thread's in order; other kinds are refused.
+#include <stdio.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <assert.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_core.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_port.h"
+
+enum { N = 20000, POSTERS = 4, PER_POSTER = 10000 };
+
+static kc_chan_t *g_a, *g_b;
+static _Atomic(int) g_done, g_bad;
+
+static int wait_for(_Atomic(int) *v, int want){
+    for (int i = 0; i < 4000 && atomic_load(v) < want; i++) kc_sleep_ms(5);
+    return atomic_load(v) >= want;
+}
+
+/* Coroutine side: receive N in order from g_a, then send N to g_b. */
+static void co_recv_then_send(void *arg){
+    (void)arg;
+    for (int i = 0; i < N; i++) {
+        int v = -1;
+        if (kc_chan_recv(g_a, &v, -1) != 0 || v != i) { atomic_fetch_add(&g_bad, 1); break; }
+    }
+    for (int i = 0; i < N; i++) if (kc_chan_send(g_b, &i, -1) != 0) { atomic_fetch_add(&g_bad, 1); break; }
+    atomic_fetch_add(&g_done, 1);
+}
+
+/* Coroutine side of the request/reply run: answer v with v + 1. */
+static void co_echo(void *arg){
+    (void)arg;
+    for (int i = 0; i < N; i++) {
+        int v = -1;
+        if (kc_chan_recv(g_a, &v, -1) != 0) { atomic_fetch_add(&g_bad, 1); break; }
+        v += 1;
+        if (kc_chan_send(g_b, &v, -1) != 0) { atomic_fetch_add(&g_bad, 1); break; }
+    }
+    atomic_fetch_add(&g_done, 1);
+}
+
+static void *th_send_then_recv(void *arg){
+    (void)arg;
+    for (int i = 0; i < N; i++) if (kc_chan_send_thread(g_a, &i, -1) != 0) { atomic_fetch_add(&g_bad, 1); return NULL; }
+    for (int i = 0; i < N; i++) {
+        int v = -1;
+        if (kc_chan_recv_thread(g_b, &v, 5000) != 0 || v != i) { atomic_fetch_add(&g_bad, 1); return NULL; }
+    }
+    return NULL;
+}
+
+static void *th_request(void *arg){
+    (void)arg;
+    for (int i = 0; i < N; i++) {
+        int r = -1;
+        if (kc_chan_send_thread(g_a, &i, -1) != 0 || kc_chan_recv_thread(g_b, &r, -1) != 0 || r != i + 1) {
+            atomic_fetch_add(&g_bad, 1); return NULL;
+        }
+    }
+    return NULL;
+}
+
+static int run(kc_sched_t *s, const char *name, kcoro_fn_t co_fn, void *(*th_fn)(void *)){
+    atomic_store(&g_done, 0);
+    pthread_t t;
+    assert(kc_spawn_co(s, co_fn, NULL, 0, NULL) == 0);
+    assert(pthread_create(&t, NULL, th_fn, NULL) == 0);
+    pthread_join(t, NULL);
+    if (!wait_for(&g_done, 1) || atomic_load(&g_bad)) {
+        fprintf(stderr, "%s done=%d bad=%d\n", name, atomic_load(&g_done), atomic_load(&g_bad));
+        return -1;
+    }
+    kc_chan_destroy(g_a);
+    kc_chan_destroy(g_b);
+    return 0;
+}
+
+static _Atomic(int) g_closed_rc;
+
+static void *th_blocked_recv(void *arg){
+    (void)arg;
+    int v;
+    atomic_store(&g_closed_rc, kc_chan_recv_thread(g_a, &v, -1));
+    return NULL;
+}
+
+static _Atomic(int) g_posted;
+static int g_last[POSTERS];
+
+static void *th_post(void *arg){
+    int id = (int)(long)arg;
+    for (int i = 0; i < PER_POSTER; i++) {
+        int v = id * PER_POSTER + i;
+        if (kc_chan_post(g_a, &v) != 0) { atomic_fetch_add(&g_bad, 1); break; }
+    }
+    return NULL;
+}
+
+static void co_drain_posts(void *arg){
+    (void)arg;
+    for (int i = 0; i < POSTERS; i++) g_last[i] = -1;
+    for (int n = 0; n < POSTERS * PER_POSTER; n++) {
+        int v = -1;
+        if (kc_chan_recv(g_a, &v, 5000) != 0) { atomic_fetch_add(&g_bad, 1); break; }
+        int id = v / PER_POSTER, seq = v % PER_POSTER;
+        if (id < 0 || id >= POSTERS || seq != g_last[id] + 1) { atomic_fetch_add(&g_bad, 1); break; }
+        g_last[id] = seq;
+        atomic_fetch_add(&g_posted, 1);
+    }
+}
+
+int main(void){
+    printf("[test] chan_thread start\n");
+    kc_sched_opts_t opts = {0};
+    opts.workers = 2;
+    kc_sched_t *s = kc_sched_init(&opts); assert(s);
+
+    assert(kc_chan_make(&g_a, KC_BUFFERED, sizeof(int), 4) == 0);
+    assert(kc_chan_make(&g_b, KC_BUFFERED, sizeof(int), 4) == 0);
+    if (run(s, "buffered", co_recv_then_send, th_send_then_recv) != 0) return 1;
+
+    assert(kc_chan_make_mpmc(&g_a, sizeof(int), 4) == 0);
+    assert(kc_chan_make_mpmc(&g_b, sizeof(int), 4) == 0);
+    if (run(s, "mpmc", co_recv_then_send, th_send_then_recv) != 0) return 2;
+
+    assert(kc_chan_make(&g_a, KC_RENDEZVOUS, sizeof(int), 0) == 0);
+    assert(kc_chan_make(&g_b, KC_RENDEZVOUS, sizeof(int), 0) == 0);
+    if (run(s, "rendezvous", co_echo, th_request) != 0) return 3;
+
+    assert(kc_chan_make(&g_a, KC_BUFFERED, sizeof(int), 4) == 0);
+    int v;
+    if (kc_chan_recv_thread(g_a, &v, 0) != KC_EAGAIN || kc_chan_recv_thread(g_a, &v, 20) != KC_ETIME) {
+        fprintf(stderr, "empty recv_thread did not time out\n"); return 4;
+    }
+    pthread_t t;
+    atomic_store(&g_closed_rc, 1);
+    assert(pthread_create(&t, NULL, th_blocked_recv, NULL) == 0);
+    kc_sleep_ms(50);
+    kc_chan_close(g_a);
+    pthread_join(t, NULL);
+    if (atomic_load(&g_closed_rc) != KC_EPIPE) { fprintf(stderr, "close rc=%d\n", atomic_load(&g_closed_rc)); return 5; }
+    kc_chan_destroy(g_a);
+
+    assert(kc_chan_make(&g_a, KC_BUFFERED, sizeof(int), 64) == 0);
+    assert(kc_spawn_co(s, co_drain_posts, NULL, 0, NULL) == 0);
+    pthread_t p[POSTERS];
+    for (long i = 0; i < POSTERS; i++) assert(pthread_create(&p[i], NULL, th_post, (void*)i) == 0);
+    for (int i = 0; i < POSTERS; i++) pthread_join(p[i], NULL);
+    if (!wait_for(&g_posted, POSTERS * PER_POSTER) || atomic_load(&g_bad)) {
+        fprintf(stderr, "posts received=%d bad=%d\n", atomic_load(&g_posted), atomic_load(&g_bad)); return 6;
+    }
+    kc_chan_close(g_a);
+    if (kc_chan_post(g_a, &v) != KC_EPIPE) { fprintf(stderr, "post after close\n"); return 7; }
+    kc_chan_destroy(g_a);
+
+    kc_chan_t *r, *m;
+    assert(kc_chan_make(&r, KC_RENDEZVOUS, sizeof(int), 0) == 0);
+    assert(kc_chan_make_mpmc(&m, sizeof(int), 4) == 0);
+    if (kc_chan_post(r, &v) != -EINVAL || kc_chan_post(m, &v) != -EINVAL) { fprintf(stderr, "post accepted\n"); return 8; }
+    kc_chan_destroy(r);
+    kc_chan_destroy(m);
+
+    kc_sched_shutdown(s);
+    printf("[test] chan_thread ok n=%d posts=%d\n", N, POSTERS * PER_POSTER);
+    return 0;
+}
@@ -0,0 +1,152 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Timed channel waits must park (not yield-spin) until a peer or the deadline.
+// 1) recv with a 300 ms timeout on an empty channel: KC_ETIME, no early
+//    return, and the worker stays nearly idle meanwhile.
+// 2) recv with a long timeout is satisfied by a sender 30 ms later, promptly.
+// 3) rendezvous send with a timeout completes once a receiver shows up.
+// 4) shared-stack receivers: 64 KCORO_STACK_SHARED coroutines in timed recv
+//    on a buffered channel fed by one sender, on two workers, take every
+//    element exactly once and never time out.
+#include <stdio.h>
+#include <stdatomic.h>
+#include <assert.h>
+#include <time.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_core.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_port.h"
+
+static kc_chan_t *g_buf, *g_rv;
+static _Atomic(int) g_stage_done;
+static int g_rc_timeout, g_rc_recv, g_val_recv, g_rc_rv_send, g_rc_rv_recv, g_val_rv;
+static double g_timeout_ms, g_recv_ms;
+
+enum { SHARED_RX = 64, SHARED_PER = 200 };
+static kc_chan_t *g_shared;
+static _Atomic(int) g_shared_got, g_shared_bad, g_shared_done;
+static _Atomic(long) g_shared_sum;
+
+static double now_ms(void){
+    struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e3 + (double)ts.tv_nsec / 1e6;
+}
+
+static void timeout_waiter(void *arg){
+    (void)arg;
+    int v = 0;
+    double t0 = now_ms();
+    g_rc_timeout = kc_chan_recv(g_buf, &v, 300);
+    g_timeout_ms = now_ms() - t0;
+    atomic_fetch_add(&g_stage_done, 1);
+}
+
+static void late_sender(void *arg){
+    (void)arg;
+    kc_sleep_ms(30);
+    int v = 42;
+    (void)kc_chan_send(g_buf, &v, -1);
+}
+
+static void timed_receiver(void *arg){
+    (void)arg;
+    double t0 = now_ms();
+    g_rc_recv = kc_chan_recv(g_buf, &g_val_recv, 5000);
+    g_recv_ms = now_ms() - t0;
+    atomic_fetch_add(&g_stage_done, 1);
+}
+
+static void rv_sender(void *arg){
+    (void)arg;
+    int v = 7;
+    g_rc_rv_send = kc_chan_send(g_rv, &v, 5000);
+    atomic_fetch_add(&g_stage_done, 1);
+}
+
+static void rv_receiver(void *arg){
+    (void)arg;
+    kc_sleep_ms(20);
+    g_rc_rv_recv = kc_chan_recv(g_rv, &g_val_rv, 5000);
+    atomic_fetch_add(&g_stage_done, 1);
+}
+
+static void shared_receiver(void *arg){
+    (void)arg;
+    for (int i = 0; i < SHARED_PER; i++) {
+        int v = -1;
+        if (kc_chan_recv(g_shared, &v, 5000) != 0) { atomic_fetch_add(&g_shared_bad, 1); continue; }
+        atomic_fetch_add(&g_shared_got, 1);
+        atomic_fetch_add(&g_shared_sum, v);
+    }
+    atomic_fetch_add(&g_shared_done, 1);
+}
+
+static void shared_sender(void *arg){
+    (void)arg;
+    for (int i = 0; i < SHARED_RX * SHARED_PER; i++) (void)kc_chan_send(g_shared, &i, -1);
+}
+
+static double cpu_ms(void){
+    struct timespec ts; clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (double)ts.tv_sec * 1e3 + (double)ts.tv_nsec / 1e6;
+}
+
+static int wait_stage(int want){
+    for (int i = 0; i < 2000 && atomic_load(&g_stage_done) < want; i++) kc_sleep_ms(5);
+    return atomic_load(&g_stage_done) >= want;
+}
+
+int main(void){
+    printf("[test] chan_timed_park start\n");
+    kc_sched_opts_t opts = {0};
+    opts.workers = 1;
+    kc_sched_t *s = kc_sched_init(&opts); assert(s);
+    assert(kc_chan_make(&g_buf, KC_BUFFERED, sizeof(int), 4) == 0);
+    assert(kc_chan_make(&g_rv, KC_RENDEZVOUS, sizeof(int), 0) == 0);
+
+    double c0 = cpu_ms();
+    assert(kc_spawn_co(s, timeout_waiter, NULL, 0, NULL) == 0);
+    int ok1 = wait_stage(1);
+    double waited_cpu = cpu_ms() - c0;
+
+    assert(kc_spawn_co(s, timed_receiver, NULL, 0, NULL) == 0);
+    assert(kc_spawn_co(s, late_sender, NULL, 0, NULL) == 0);
+    int ok2 = wait_stage(2);
+
+    assert(kc_spawn_co(s, rv_sender, NULL, 0, NULL) == 0);
+    assert(kc_spawn_co(s, rv_receiver, NULL, 0, NULL) == 0);
+    int ok3 = wait_stage(4);
+
+    kc_sched_shutdown(s);
+    kc_chan_destroy(g_buf);
+    kc_chan_destroy(g_rv);
+
+    opts.workers = 2;
+    s = kc_sched_init(&opts); assert(s);
+    assert(kc_chan_make(&g_shared, KC_BUFFERED, sizeof(int), 16) == 0);
+    for (int i = 0; i < SHARED_RX; i++)
+        assert(kc_spawn_co(s, shared_receiver, NULL, KCORO_STACK_SHARED, NULL) == 0);
+    assert(kc_spawn_co(s, shared_sender, NULL, 0, NULL) == 0);
+    for (int i = 0; i < 2000 && atomic_load(&g_shared_done) < SHARED_RX; i++) kc_sleep_ms(5);
+    kc_sched_shutdown(s);
+    kc_chan_destroy(g_shared);
+
+    if (!ok1 || g_rc_timeout != KC_ETIME || g_timeout_ms < 300.0) {
+        fprintf(stderr, "timeout recv rc=%d after %.1f ms\n", g_rc_timeout, g_timeout_ms); return 1;
+    }
+    /* A yield-spinning wait would burn roughly the whole 300 ms. */
+    if (waited_cpu > 100.0) { fprintf(stderr, "timed wait burned %.1f ms CPU\n", waited_cpu); return 2; }
+    if (!ok2 || g_rc_recv != 0 || g_val_recv != 42 || g_recv_ms > 1000.0) {
+        fprintf(stderr, "timed recv rc=%d val=%d after %.1f ms\n", g_rc_recv, g_val_recv, g_recv_ms); return 3;
+    }
+    if (!ok3 || g_rc_rv_send != 0 || g_rc_rv_recv != 0 || g_val_rv != 7) {
+        fprintf(stderr, "rendezvous timed send=%d recv=%d val=%d\n", g_rc_rv_send, g_rc_rv_recv, g_val_rv); return 4;
+    }
+    long n = (long)SHARED_RX * SHARED_PER;
+    if (atomic_load(&g_shared_done) != SHARED_RX || atomic_load(&g_shared_bad) ||
+        atomic_load(&g_shared_got) != n || atomic_load(&g_shared_sum) != n * (n - 1) / 2) {
+        fprintf(stderr, "shared-stack recv done=%d got=%d bad=%d\n", atomic_load(&g_shared_done),
+                atomic_load(&g_shared_got), atomic_load(&g_shared_bad)); return 5;
+    }
+    printf("[test] chan_timed_park ok timeout=%.1fms cpu=%.2fms recv=%.1fms\n", g_timeout_ms, waited_cpu, g_recv_ms);
+    return 0;
+}
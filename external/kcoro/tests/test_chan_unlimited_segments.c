@@ -0,0 +1,121 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// KC_UNLIMITED segment list
+// 1) a burst far beyond one segment is accepted by try, blocking and timed
+//    sends alike (nothing overwritten), drains in FIFO order, and the
+//    snapshot capacity falls back to a single segment afterwards.
+// 2) batch sends and receives crossing segment boundaries keep FIFO order.
+// 3) a select recv parked on an empty unlimited channel is completed by a
+//    later send; pointer descriptors survive segment hops.
+#include <stdio.h>
+#include <stdatomic.h>
+#include <assert.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_core.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_port.h"
+
+enum { SEG = 8, BURST = 10000 };
+
+static kc_chan_t *g_ch;
+static _Atomic(int) g_stage;
+static int g_basic_ok, g_sel_rc = 1, g_sel_idx = -1, g_sel_val;
+
+static size_t snap_capacity(kc_chan_t *ch){
+    struct kc_chan_snapshot snap;
+    assert(kc_chan_snapshot(ch, &snap) == 0);
+    return snap.capacity;
+}
+
+static void basic(void *arg){
+    (void)arg;
+    kc_chan_t *ch = NULL;
+    assert(kc_chan_make(&ch, KC_UNLIMITED, sizeof(int), SEG) == 0);
+    assert(kc_chan_len(ch) == 0);
+    for (int i = 0; i < BURST; i++) {
+        long tmo = i % 3 == 0 ? 0 : (i % 3 == 1 ? -1 : 50);
+        assert(kc_chan_send(ch, &i, tmo) == 0);
+    }
+    assert(kc_chan_len(ch) == BURST);
+    assert(snap_capacity(ch) >= BURST && snap_capacity(ch) < BURST + SEG);
+    for (int i = 0; i < BURST; i++) {
+        int v = -1;
+        assert(kc_chan_recv(ch, &v, 0) == 0 && v == i);
+    }
+    int v;
+    assert(kc_chan_recv(ch, &v, 0) == KC_EAGAIN);
+    assert(snap_capacity(ch) == SEG); /* drained: one segment stays linked */
+
+    int in[3 * SEG + 3], out[3 * SEG + 3];
+    for (int round = 0; round < 4; round++) {
+        for (int i = 0; i < 3 * SEG + 3; i++) in[i] = round * 100 + i;
+        size_t n = 0;
+        assert(kc_chan_send_many(ch, in, 5, 0, &n) == 0 && n == 5);
+        assert(kc_chan_send_many(ch, in + 5, 3 * SEG - 2, -1, &n) == 0 && n == 3 * SEG - 2);
+        assert(kc_chan_recv_many(ch, out, SEG + 1, 0, &n) == 0 && n == SEG + 1);
+        assert(kc_chan_recv_many(ch, out + SEG + 1, 3 * SEG + 3, 0, &n) == 0 && n == 2 * SEG + 2);
+        for (int i = 0; i < 3 * SEG + 3; i++) assert(out[i] == in[i]);
+    }
+    kc_chan_close(ch);
+    assert(kc_chan_send(ch, &v, -1) == KC_EPIPE);
+    assert(kc_chan_recv(ch, &v, -1) == KC_EPIPE);
+    kc_chan_destroy(ch);
+
+    assert(kc_chan_make_ptr(&ch, KC_UNLIMITED, 2) == 0);
+    static char bytes[7];
+    for (size_t i = 0; i < sizeof(bytes); i++) assert(kc_chan_send_ptr(ch, &bytes[i], i + 1, 0) == 0);
+    for (size_t i = 0; i < sizeof(bytes); i++) {
+        void *p = NULL; size_t len = 0;
+        assert(kc_chan_recv_ptr(ch, &p, &len, -1) == 0 && p == &bytes[i] && len == i + 1);
+    }
+    kc_chan_destroy(ch);
+
+    g_basic_ok = 1;
+    atomic_store(&g_stage, 1);
+}
+
+static void select_recv(void *arg){
+    (void)arg;
+    kc_select_t *sel = NULL;
+    assert(kc_select_create(&sel, NULL) == 0);
+    assert(kc_select_add_recv(sel, g_ch, &g_sel_val) == 0);
+    g_sel_rc = kc_select_wait(sel, 5000, &g_sel_idx, NULL);
+    kc_select_destroy(sel);
+    atomic_fetch_add(&g_stage, 1);
+}
+
+static void late_send(void *arg){
+    (void)arg;
+    kc_sleep_ms(20);
+    int v = 99;
+    assert(kc_chan_send(g_ch, &v, -1) == 0);
+}
+
+static int wait_for(_Atomic(int) *v, int want){
+    for (int i = 0; i < 2000 && atomic_load(v) < want; i++) kc_sleep_ms(5);
+    return atomic_load(v) >= want;
+}
+
+int main(void){
+    printf("[test] chan_unlimited_segments start\n");
+    kc_sched_opts_t opts = {0};
+    opts.workers = 2;
+    kc_sched_t *s = kc_sched_init(&opts); assert(s);
+
+    assert(kc_spawn_co(s, basic, NULL, 0, NULL) == 0);
+    int ok_basic = wait_for(&g_stage, 1);
+
+    assert(kc_chan_make(&g_ch, KC_UNLIMITED, sizeof(int), 0) == 0);
+    assert(kc_spawn_co(s, select_recv, NULL, 0, NULL) == 0);
+    assert(kc_spawn_co(s, late_send, NULL, 0, NULL) == 0);
+    int ok_sel = wait_for(&g_stage, 2);
+
+    kc_sched_shutdown(s);
+    kc_chan_destroy(g_ch);
+
+    if (!ok_basic || !g_basic_ok) { fprintf(stderr, "segment checks did not finish\n"); return 1; }
+    if (!ok_sel || g_sel_rc != 0 || g_sel_idx != 0 || g_sel_val != 99) {
+        fprintf(stderr, "select recv rc=%d idx=%d val=%d\n", g_sel_rc, g_sel_idx, g_sel_val); return 2;
+    }
+    printf("[test] chan_unlimited_segments ok burst=%d\n", BURST);
+    return 0;
+}
@@ -0,0 +1,117 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Runtime clock: reads never go back, on one thread or across several, and
+// stay within a millisecond of CLOCK_MONOTONIC through calibration and a
+// resync. Timed waits on a pthread condvar and on KC_COND end at their
+// deadline, neither early nor a wall-clock epoch late. Off a worker the
+// coarse clock reads the clock each time.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "../include/kcoro_config.h"
+#include "../include/kcoro_port.h"
+#include "../core/src/kc_clock_internal.h"
+
+#define THREADS 4
+#define READS   200000
+
+static long long skew(void)
+{
+    uint64_t a = kc_clock_mono_ns();
+    uint64_t c = kc_clock_ns();
+    uint64_t b = kc_clock_mono_ns();
+    if (c < a) return (long long)(c - a);
+    if (c > b) return (long long)(c - b);
+    return 0;
+}
+
+static void *reader(void *arg)
+{
+    (void)arg;
+    uint64_t last = kc_clock_ns();
+    for (int i = 0; i < READS; i++) {
+        uint64_t now = kc_clock_ns();
+        assert(now >= last);
+        last = now;
+    }
+    return NULL;
+}
+
+int main(void)
+{
+    printf("[test] clock start\n");
+    uint64_t t0 = kc_clock_ns();
+    assert(t0 > 0 && llabs(skew()) < 1000000);
+    /* Calibration ends on the first read past its window. */
+    usleep((KCORO_CLOCK_CALIB_MS + 5) * 1000);
+    (void)kc_clock_ns();
+    const char *src = kc_clock_source();
+    assert(!strcmp(src, "tsc") || !strcmp(src, "cntvct") || !strcmp(src, "monotonic"));
+
+    pthread_t thr[THREADS];
+    for (int i = 0; i < THREADS; i++) assert(pthread_create(&thr[i], NULL, reader, NULL) == 0);
+    for (int i = 0; i < THREADS; i++) pthread_join(thr[i], NULL);
+
+    /* Across more than a resync period, in steps. */
+    long long worst = 0;
+    uint64_t last = kc_clock_ns();
+    for (int i = 0; i < 12; i++) {
+        usleep(KCORO_CLOCK_RESYNC_MS * 1000 / 8);
+        uint64_t now = kc_clock_ns();
+        assert(now >= last);
+        last = now;
+        long long s = llabs(skew());
+        if (s > worst) worst = s;
+    }
+    assert(worst < 1000000);
+
+    /* pthread condvar on the port's pthread clock. */
+    pthread_mutex_t mu = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t cv;
+    assert(kc_posix_cond_init_monotonic(&cv) == 0);
+    struct timespec ts;
+    uint64_t start = kc_clock_ns();
+    kc_clock_abstime(&ts, KC_PORT_PTHREAD_COND_CLOCK, start + 20000000ull);
+    pthread_mutex_lock(&mu);
+    int rc;
+    while ((rc = pthread_cond_timedwait(&cv, &mu, &ts)) == 0) { }
+    pthread_mutex_unlock(&mu);
+    uint64_t took = kc_clock_ns() - start;
+    assert(rc == ETIMEDOUT && took >= 19000000ull && took < 1000000000ull);
+    pthread_cond_destroy(&cv);
+
+    /* A deadline already past returns at once. */
+    kc_clock_abstime(&ts, KC_PORT_PTHREAD_COND_CLOCK, start);
+    assert(kc_posix_cond_init_monotonic(&cv) == 0);
+    pthread_mutex_lock(&mu);
+    assert(pthread_cond_timedwait(&cv, &mu, &ts) == ETIMEDOUT);
+    pthread_mutex_unlock(&mu);
+    pthread_cond_destroy(&cv);
+
+    /* KC_COND on its own clock. */
+    KC_MUTEX_T km;
+    KC_COND_T kcv;
+    KC_MUTEX_INIT(&km);
+    KC_COND_INIT(&kcv);
+    start = kc_clock_ns();
+    kc_clock_abstime_ms(&ts, KC_COND_CLOCK, 20);
+    KC_MUTEX_LOCK(&km);
+    while ((rc = KC_COND_TIMEDWAIT_ABS(&kcv, &km, &ts)) == 0) { }
+    KC_MUTEX_UNLOCK(&km);
+    took = kc_clock_ns() - start;
+    assert(rc == ETIMEDOUT && took >= 19000000ull && took < 1000000000ull);
+    KC_COND_DESTROY(&kcv);
+    KC_MUTEX_DESTROY(&km);
+
+    /* Off a worker every coarse read is a fresh one. */
+    long c1 = kc_clock_coarse_ns();
+    usleep(2000);
+    long c2 = kc_clock_coarse_ns();
+    assert(c2 - c1 >= 2000000);
+
+    printf("[test] clock ok source=%s worst_skew_ns=%lld\n", src, worst);
+    return 0;
+}
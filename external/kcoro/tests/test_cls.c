@@ -0,0 +1,79 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Coroutine-local storage
+// 1) values in inline and overflow slots are private to each coroutine and
+//    survive yields.
+// 2) destructors run at finish with the finishing coroutine current, and
+//    values a destructor sets again get another round.
+// 3) bad keys and threads without a coroutine are rejected.
+#include <stdio.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <assert.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_core.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kc_cls.h"
+
+enum { NCO = 8 };
+
+static kc_cls_key_t k_plain, k_inline, k_over, k_again;
+static _Atomic(int) g_dtor_calls, g_dtor_self, g_again_calls, g_done;
+
+static void count_dtor(void *v){
+    atomic_fetch_add(&g_dtor_calls, 1);
+    /* k_inline goes first: the finishing coroutine is still current and
+     * its k_over slot is still set */
+    intptr_t x = (intptr_t)v;
+    if (x >= 1 && x <= NCO && kc_cls_get(k_over) == (void*)(x + 99)) atomic_fetch_add(&g_dtor_self, 1);
+}
+
+static void again_dtor(void *v){
+    atomic_fetch_add(&g_again_calls, 1);
+    if ((intptr_t)v == 1) assert(kc_cls_set(k_again, (void*)(intptr_t)2) == 0);
+}
+
+static void worker(void *arg){
+    intptr_t id = (intptr_t)arg;
+    assert(kc_cls_get(k_inline) == NULL && kc_cls_get(k_over) == NULL);
+    assert(kc_cls_set(k_inline, (void*)(id + 1)) == 0);
+    assert(kc_cls_set(k_over, (void*)(id + 100)) == 0);
+    assert(kc_cls_set(k_plain, (void*)(id + 1000)) == 0);
+    for (int i = 0; i < 10; i++) {
+        kc_yield();
+        assert(kc_cls_get(k_inline) == (void*)(id + 1));
+        assert(kc_cls_get(k_over) == (void*)(id + 100));
+    }
+    assert(kc_cls_set(k_plain, NULL) == 0);   /* cleared: no destructor */
+    if (id == 0) assert(kc_cls_set(k_again, (void*)(intptr_t)1) == 0);
+    atomic_fetch_add(&g_done, 1);
+}
+
+int main(void){
+    printf("[test] cls start\n");
+    assert(kc_cls_key_create(NULL, NULL) == -EINVAL);
+    assert(kc_cls_key_create(&k_plain, count_dtor) == 0);
+    while (k_inline < KCORO_CLS_INLINE - 1) assert(kc_cls_key_create(&k_inline, NULL) == 0);
+    /* the last inline slot gets a destructor, the next key overflows */
+    assert(kc_cls_key_create(&k_inline, count_dtor) == 0 && k_inline == KCORO_CLS_INLINE);
+    assert(kc_cls_key_create(&k_over, count_dtor) == 0 && k_over > KCORO_CLS_INLINE);
+    assert(kc_cls_key_create(&k_again, again_dtor) == 0);
+    assert(kc_cls_set(k_again + 1, (void*)1) == -EINVAL);
+    assert(kc_cls_get(KCORO_CLS_KEYS) == NULL);
+    if (!kcoro_current()) assert(kc_cls_set(k_plain, (void*)1) == -ESRCH);
+
+    kc_sched_opts_t opts = {0};
+    opts.workers = 2;
+    kc_sched_t *s = kc_sched_init(&opts); assert(s);
+    for (intptr_t i = 0; i < NCO; i++) assert(kc_spawn_co(s, worker, (void*)i, 0, NULL) == 0);
+    for (int i = 0; i < 500 && atomic_load(&g_done) < NCO; i++) kc_sleep_ms(2);
+    kc_sleep_ms(20);
+    kc_sched_shutdown(s);
+    assert(atomic_load(&g_done) == NCO);
+    /* k_inline and k_over per coroutine; k_plain was cleared */
+    assert(atomic_load(&g_dtor_calls) == 2 * NCO);
+    assert(atomic_load(&g_dtor_self) == NCO);
+    assert(atomic_load(&g_again_calls) == 2);
+    printf("[test] cls ok dtors=%d\n", atomic_load(&g_dtor_calls));
+    return 0;
+}
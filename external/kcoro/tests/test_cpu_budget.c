@@ -0,0 +1,100 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// CPU budget: cgroup quotas read from fake v2 and v1 trees. A v2 quota is
+// rounded up to whole CPUs and the tightest level on the way up wins; v1
+// reads the cpu hierarchy's cfs files; a namespaced "/" group reads the
+// mount itself; no quota, or no cgroup file, means no limit. The live
+// budget stays within the affinity mask, and a scheduler sized by default
+// reports it while one with explicit workers does not.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <sys/stat.h>
+#include <assert.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_sched.h"
+#include "../core/src/kc_cpu_internal.h"
+
+static char g_root[64];
+
+static void put(const char *rel, const char *text){
+    char path[256];
+    snprintf(path, sizeof path, "%s/%s", g_root, rel);
+    /* mkdir -p of the parent */
+    for (char *p = path + strlen(g_root) + 1; (p = strchr(p, '/')) != NULL; p++) {
+        *p = '\0';
+        mkdir(path, 0755);
+        *p = '/';
+    }
+    FILE *f = fopen(path, "w");
+    assert(f);
+    fputs(text, f);
+    fclose(f);
+}
+
+static int limit(const char *proc_rel){
+    char proc[256];
+    snprintf(proc, sizeof proc, "%s/%s", g_root, proc_rel);
+    return kc_cpu_cgroup_limit(proc, g_root);
+}
+
+int main(void){
+    printf("[test] cpu_budget start\n");
+    strcpy(g_root, "/tmp/kc_cpu_XXXXXX");
+    assert(mkdtemp(g_root));
+
+    /* v2: 4 CPUs on the pod, none on the container */
+    put("v2", "0::/kubepods/pod1/ctr\n");
+    put("kubepods/pod1/cpu.max", "400000 100000\n");
+    put("kubepods/pod1/ctr/cpu.max", "max 100000\n");
+    assert(limit("v2") == 4);
+    /* 1.5 CPUs on the container rounds up to 2 and is tighter */
+    put("kubepods/pod1/ctr/cpu.max", "150000 100000\n");
+    assert(limit("v2") == 2);
+
+    /* Namespaced: the group is "/" and the mount is the container's group */
+    put("ns", "0::/\n");
+    put("cpu.max", "300000 100000\n");
+    assert(limit("ns") == 3);
+    put("cpu.max", "max 100000\n");
+    assert(limit("ns") == 0);
+
+    /* v1: only the cpu controller line counts */
+    put("v1", "5:memory:/docker/abc\n4:cpu,cpuacct:/docker/abc\n3:cpuset:/docker/abc\n");
+    put("cpu,cpuacct/docker/abc/cpu.cfs_quota_us", "250000\n");
+    put("cpu,cpuacct/docker/abc/cpu.cfs_period_us", "100000\n");
+    assert(limit("v1") == 3);
+    put("cpu,cpuacct/docker/abc/cpu.cfs_quota_us", "-1\n");
+    assert(limit("v1") == 0);
+    /* "cpuacct" alone is not the cpu controller */
+    put("v1acct", "4:cpuacct:/docker/abc\n");
+    assert(limit("v1acct") == 0);
+
+    assert(limit("missing") == 0);
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    assert(sched_getaffinity(0, sizeof set, &set) == 0);
+    int budget = kc_cpu_budget();
+    assert(budget >= 1 && budget <= CPU_COUNT(&set));
+
+    kc_sched_t *s = kc_sched_init(NULL);
+    assert(s);
+    kc_sched_stats_t st;
+    kc_sched_get_stats(s, &st);
+    assert(st.cpu_budget == (unsigned long)budget && kc_sched_worker_count(s) >= budget);
+    kc_sched_shutdown(s);
+    kc_sched_opts_t o = {0};
+    o.workers = 2;
+    s = kc_sched_init(&o);
+    assert(s);
+    kc_sched_get_stats(s, &st);
+    assert(st.cpu_budget == 0);
+    kc_sched_shutdown(s);
+
+    char cmd[128];
+    snprintf(cmd, sizeof cmd, "rm -rf %s", g_root);
+    if (system(cmd) != 0) return 1;
+    printf("[test] cpu_budget ok budget=%d affinity=%d\n", budget, CPU_COUNT(&set));
+    return 0;
+}
@@ -0,0 +1,186 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Test kc_deferred: hand-settled deferreds awaited from a thread (timeouts,
+// single assignment, -EBUSY for a second awaiter), kc_async fan-out joined
+// with kc_await_all from a coroutine, failures, kc_deferred_cancel reaching
+// the body through its job token, kc_await_any and kc_await_c
+#include <stdio.h>
+#include <assert.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include "../include/kcoro.h"
+#include "../include/kc_deferred.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_core.h"
+#include "../include/kcoro_port.h"
+
+#define FANOUT 1000
+
+static kc_chan_t *idle_ch;
+static atomic_int body_saw_cancel;
+static atomic_int co_done;
+static int co_rc;
+
+static int twice(void *arg, void **result)
+{
+    *result = (void*)((long)arg * 2);
+    return 0;
+}
+
+static int failing(void *arg, void **result)
+{
+    (void)arg; (void)result;
+    kc_sleep_ms(2);
+    return -EIO;
+}
+
+static int stuck(void *arg, void **result)
+{
+    (void)arg; (void)result;
+    int v;
+    int rc = kc_chan_recv_c(idle_ch, &v, -1, kc_job_token(kc_job_current()));
+    if (rc == KC_ECANCELED) atomic_store(&body_saw_cancel, 1);
+    return rc;
+}
+
+struct settle { kc_deferred_t *d; long value; };
+
+static void late_complete(void *arg)
+{
+    struct settle *st = (struct settle*)arg;
+    kc_sleep_ms(20);
+    assert(kc_deferred_complete(st->d, (void*)st->value) == 0);
+}
+
+static void fan_out(void *arg)
+{
+    (void)arg;
+    static kc_deferred_t *ds[FANOUT];
+    static void *vals[FANOUT];
+    for (long i = 0; i < FANOUT; i++) assert(kc_async(twice, (void*)i, &ds[i]) == 0);
+    co_rc = kc_await_all(ds, FANOUT, 5000, vals);
+    for (long i = 0; i < FANOUT && co_rc == 0; i++)
+        if ((long)vals[i] != 2 * i) co_rc = -100;
+    for (int i = 0; i < FANOUT; i++) kc_deferred_release(ds[i]);
+    atomic_store(&co_done, 1);
+}
+
+struct any_args { kc_deferred_t *ds[3]; size_t idx; void *val; };
+
+static void any_waiter(void *arg)
+{
+    struct any_args *a = (struct any_args*)arg;
+    co_rc = kc_await_any(a->ds, 3, 5000, &a->idx, &a->val);
+    atomic_store(&co_done, 1);
+}
+
+static void timed_waiter(void *arg)
+{
+    co_rc = kc_await((kc_deferred_t*)arg, 20, NULL);
+    atomic_store(&co_done, 1);
+}
+
+static kc_cancel_t *g_tok;
+
+static void token_waiter(void *arg)
+{
+    co_rc = kc_await_c((kc_deferred_t*)arg, -1, g_tok, NULL);
+    atomic_store(&co_done, 1);
+}
+
+static void wait_done(void)
+{
+    for (int i = 0; i < 4000 && !atomic_load(&co_done); i++) kc_sleep_ms(1);
+    assert(atomic_load(&co_done));
+    atomic_store(&co_done, 0);
+}
+
+int main(void)
+{
+    printf("[test] deferred start\n");
+    kc_sched_t *s = kc_sched_default();
+    assert(s);
+    assert(kc_chan_make(&idle_ch, KC_UNLIMITED, sizeof(int), 0) == 0);
+
+    /* Hand-settled, awaited from this thread */
+    kc_deferred_t *d = NULL;
+    void *v = NULL;
+    assert(kc_deferred_create(&d) == 0);
+    assert(kc_deferred_state(d) == KC_DEFERRED_PENDING);
+    assert(kc_await(d, 0, &v) == KC_EAGAIN);
+    assert(kc_await(d, 10, &v) == KC_ETIME);
+    struct settle st = { d, 42 };
+    assert(kc_spawn_co(s, late_complete, &st, 0, NULL) == 0);
+    assert(kc_await(d, 5000, &v) == 0 && (long)v == 42);
+    assert(kc_deferred_complete(d, NULL) == -EALREADY);
+    assert(kc_deferred_cancel(d) == -EALREADY);
+    v = NULL;
+    assert(kc_await(d, 0, &v) == 0 && (long)v == 42);
+    kc_deferred_release(d);
+
+    /* Failure code; fail with a non-negative code is rejected */
+    assert(kc_deferred_create(&d) == 0);
+    assert(kc_deferred_fail(d, 0) == -EINVAL);
+    assert(kc_deferred_fail(d, -ENOENT) == 0);
+    assert(kc_await(d, -1, &v) == -ENOENT && v == NULL);
+    assert(kc_deferred_state(d) == KC_DEFERRED_FAILED);
+    kc_deferred_release(d);
+
+    /* kc_async fan-out joined from a coroutine */
+    assert(kc_spawn_co(s, fan_out, NULL, 0, NULL) == 0);
+    wait_done();
+    assert(co_rc == 0);
+
+    /* A failing body */
+    assert(kc_async(failing, NULL, &d) == 0);
+    assert(kc_await(d, -1, NULL) == -EIO);
+    kc_deferred_release(d);
+
+    /* Cancel settles at once and reaches the body through its job token */
+    assert(kc_async(stuck, NULL, &d) == 0);
+    kc_sleep_ms(5);
+    assert(kc_deferred_cancel(d) == 0);
+    assert(kc_await(d, -1, NULL) == KC_ECANCELED);
+    for (int i = 0; i < 4000 && !atomic_load(&body_saw_cancel); i++) kc_sleep_ms(1);
+    assert(atomic_load(&body_saw_cancel));
+    kc_deferred_release(d);
+
+    /* await_any from a coroutine; a second awaiter is turned away */
+    struct any_args a = { .idx = 99 };
+    for (int i = 0; i < 3; i++) assert(kc_deferred_create(&a.ds[i]) == 0);
+    assert(kc_spawn_co(s, any_waiter, &a, 0, NULL) == 0);
+    kc_sleep_ms(10);
+    assert(kc_await(a.ds[2], 10, NULL) == -EBUSY);
+    assert(kc_deferred_complete(a.ds[1], (void*)7L) == 0);
+    wait_done();
+    assert(co_rc == 0 && a.idx == 1 && (long)a.val == 7);
+    /* The record is gone from the others: they can be awaited again */
+    assert(kc_await(a.ds[0], 0, NULL) == KC_EAGAIN);
+    assert(kc_deferred_cancel(a.ds[2]) == 0);
+    size_t idx = 99;
+    assert(kc_await_any(a.ds, 3, 0, &idx, NULL) == 0 && idx == 1);
+    assert(kc_await_all(a.ds, 3, 0, NULL) == KC_EAGAIN);
+    assert(kc_deferred_complete(a.ds[0], NULL) == 0);
+    assert(kc_await_all(a.ds, 3, 0, NULL) == KC_ECANCELED);
+
+    /* Coroutine timeout and a token that fires leave d pending */
+    assert(kc_spawn_co(s, timed_waiter, a.ds[0], 0, NULL) == 0);
+    wait_done();
+    assert(co_rc == 0);
+    assert(kc_deferred_create(&d) == 0);
+    assert(kc_spawn_co(s, timed_waiter, d, 0, NULL) == 0);
+    wait_done();
+    assert(co_rc == KC_ETIME);
+    assert(kc_cancel_init(&g_tok) == 0);
+    assert(kc_spawn_co(s, token_waiter, d, 0, NULL) == 0);
+    kc_sleep_ms(10);
+    kc_cancel_trigger(g_tok);
+    wait_done();
+    kc_cancel_destroy(g_tok);
+    assert(co_rc == KC_ECANCELED && kc_deferred_state(d) == KC_DEFERRED_PENDING);
+    kc_deferred_release(d);
+    for (int i = 0; i < 3; i++) kc_deferred_release(a.ds[i]);
+
+    kc_chan_destroy(idle_ch);
+    printf("[test] deferred ok\n");
+    return 0;
+}
@@ -0,0 +1,157 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Test the FFI surface from plain threads: batch calls fold counts into the
+// result and check element types, batches stream between threads in order,
+// and polled ops complete, time out, cancel and carry pointer descriptors
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_ffi.h"
+#include "../include/kcoro_port.h"
+
+static void test_sync_batches(void)
+{
+    kc_chan_t *ch = kc_ffi_chan_new(KC_BUFFERED, sizeof(float), 8);
+    assert(ch && kc_ffi_chan_elem_size(ch) == sizeof(float));
+    float in[20], out[20];
+    for (int i = 0; i < 20; i++) in[i] = (float)i + 0.5f;
+    /* Room for 8: the count is the result, then the error */
+    assert(kc_ffi_send_f32(ch, in, 20, 0) == 8);
+    assert(kc_ffi_send_f32(ch, in + 8, 12, 0) == KC_EAGAIN);
+    assert(kc_ffi_send_f64(ch, (const double*)in, 1, 0) == -EINVAL);
+    assert(kc_ffi_chan_len(ch) == 8);
+    assert(kc_ffi_recv_f32(ch, out, 5, 0) == 5 && out[4] == 4.5f);
+    assert(kc_ffi_recv_f32(ch, out, 20, 0) == 3 && out[0] == 5.5f && out[2] == 7.5f);
+    assert(kc_ffi_recv_f32(ch, out, 20, 0) == KC_EAGAIN);
+    assert(kc_ffi_recv_f32(ch, out, 20, 10) == KC_ETIME);
+    kc_ffi_chan_close(ch);
+    assert(kc_ffi_send_f32(ch, in, 1, 0) == KC_EPIPE && kc_ffi_recv_f32(ch, out, 1, -1) == KC_EPIPE);
+    kc_ffi_chan_free(ch);
+    assert(kc_ffi_chan_new(KC_BUFFERED, 0, 8) == NULL);
+}
+
+#define STREAM 100000
+
+struct reader { kc_chan_t *ch; long got, bad, calls; };
+
+static void *reader_thread(void *arg)
+{
+    struct reader *r = arg;
+    int32_t buf[256];
+    long n;
+    while ((n = kc_ffi_recv_i32(r->ch, buf, 256, -1)) > 0) {
+        for (long i = 0; i < n; i++) if (buf[i] != (int32_t)(r->got + i)) r->bad++;
+        r->got += n;
+        r->calls++;
+    }
+    if (n != KC_EPIPE) r->bad++;
+    return NULL;
+}
+
+static void test_thread_stream(void)
+{
+    struct reader r = { .ch = kc_ffi_chan_new(KC_BUFFERED, sizeof(int32_t), 64) };
+    assert(r.ch);
+    pthread_t t;
+    assert(pthread_create(&t, NULL, reader_thread, &r) == 0);
+    int32_t *v = malloc(STREAM * sizeof(*v));
+    assert(v);
+    for (int i = 0; i < STREAM; i++) v[i] = i;
+    long sent = 0, calls = 0;
+    while (sent < STREAM) {
+        long n = kc_ffi_send_i32(r.ch, v + sent, (size_t)(STREAM - sent), -1);
+        assert(n > 0);
+        sent += n;
+        calls++;
+    }
+    kc_ffi_chan_close(r.ch);
+    pthread_join(t, NULL);
+    assert(r.got == STREAM && r.bad == 0);
+    /* Batches, not element calls */
+    assert(r.calls < STREAM / 2);
+    printf("[ffi] %d elements: %ld send calls, %ld recv calls\n", STREAM, calls, r.calls);
+    kc_ffi_chan_free(r.ch);
+    free(v);
+}
+
+static void test_ops(void)
+{
+    kc_chan_t *ch = kc_ffi_chan_new(KC_BUFFERED, sizeof(double), 4);
+    double out[16], in[100];
+    for (int i = 0; i < 100; i++) in[i] = i;
+    /* Pending until a sender shows up, then done with what was there */
+    kc_ffi_op_t *op = kc_ffi_recv_async(ch, out, 16, -1);
+    assert(op && kc_ffi_op_poll(op) == KC_EAGAIN && kc_ffi_op_count(op) == 0);
+    assert(kc_ffi_op_wait(op, 20) == KC_EAGAIN);
+    assert(kc_ffi_send_f64(ch, in, 3, -1) == 3);
+    while (kc_ffi_op_poll(op) == KC_EAGAIN) usleep(100);
+    assert(kc_ffi_op_poll(op) == 0 && kc_ffi_op_count(op) >= 1 && out[0] == 0.0);
+    long first = kc_ffi_op_count(op);
+    kc_ffi_op_free(op);
+    if (first < 3) assert(kc_ffi_recv_f64(ch, out, 16, 0) == 3 - first);
+    /* A send larger than the channel completes as a reader drains it */
+    op = kc_ffi_send_async(ch, in, 100, -1);
+    assert(op);
+    long got = 0;
+    while (got < 100) {
+        long n = kc_ffi_recv_f64(ch, out, 16, 1000);
+        assert(n > 0 && out[0] == (double)got);
+        got += n;
+    }
+    assert(kc_ffi_op_wait(op, -1) == 0 && kc_ffi_op_count(op) == 100);
+    kc_ffi_op_free(op);
+    /* Timed out, cancelled, and freed while running */
+    op = kc_ffi_recv_async(ch, out, 16, 20);
+    assert(kc_ffi_op_wait(op, -1) == KC_ETIME && kc_ffi_op_count(op) == 0);
+    kc_ffi_op_free(op);
+    op = kc_ffi_recv_async(ch, out, 16, -1);
+    kc_ffi_op_cancel(op);
+    assert(kc_ffi_op_wait(op, 5000) == KC_ECANCELED);
+    kc_ffi_op_free(op);
+    kc_ffi_op_free(kc_ffi_recv_async(ch, out, 16, -1));
+    /* Wrong kind of channel, or nothing to receive into */
+    assert(kc_ffi_send_ptrs_async(ch, NULL, NULL, 0, 0) == NULL && kc_ffi_recv_async(ch, out, 0, 0) == NULL);
+    kc_ffi_chan_free(ch);
+}
+
+static void test_ptr_ops(void)
+{
+    kc_chan_t *ch = kc_ffi_chan_new_ptr(KC_BUFFERED, 16);
+    assert(ch && kc_ffi_chan_elem_size(ch) == 0);
+    static char blob[200];
+    void *ptrs[100];
+    size_t lens[100];
+    for (int i = 0; i < 100; i++) { ptrs[i] = blob + i; lens[i] = (size_t)i + 1; }
+    kc_ffi_op_t *s = kc_ffi_send_ptrs_async(ch, ptrs, lens, 100, -1);
+    assert(s);
+    void *rp[64];
+    size_t rl[64];
+    long got = 0;
+    while (got < 100) {
+        kc_ffi_op_t *r = kc_ffi_recv_ptrs_async(ch, rp, rl, 64, 1000);
+        assert(r && kc_ffi_op_wait(r, -1) == 0);
+        long n = kc_ffi_op_count(r);
+        assert(n >= 1);
+        for (long i = 0; i < n; i++) assert(rp[i] == blob + got + i && rl[i] == (size_t)(got + i + 1));
+        got += n;
+        kc_ffi_op_free(r);
+    }
+    assert(kc_ffi_op_wait(s, -1) == 0 && kc_ffi_op_count(s) == 100);
+    kc_ffi_op_free(s);
+    kc_ffi_chan_free(ch);
+}
+
+int main(void)
+{
+    test_sync_batches();
+    test_thread_stream();
+    test_ops();
+    test_ptr_ops();
+    printf("[ffi] ok\n");
+    return 0;
+}
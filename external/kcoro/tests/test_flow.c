@@ -0,0 +1,185 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Test flows: fused map/filter/map keeps order and ends in chunks with a
+// partial last one, parallel_map spreads over coroutines without losing
+// elements, merged flows deliver both inputs, and stage snapshots feed
+// kc_chan_compute_rate
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <unistd.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_core.h"
+#include "../include/kcoro_port.h"
+
+#define N     10001
+#define CHUNK 100
+
+struct ctx {
+    kc_chan_t *out;
+    volatile int done;
+    int bad;
+    long sum;
+    int chunks, last_count, items;
+};
+
+static int produce(kc_chan_t *ch, void *user)
+{
+    long n = (long)user;
+    for (int i = 0; i < n; i++) if (kc_chan_send(ch, &i, -1) != 0) return -1;
+    return 0;
+}
+
+static int triple(const void *in, void *out, void *user)
+{
+    (void)user;
+    *(int*)out = *(const int*)in * 3;
+    return 0;
+}
+
+static int even(const void *in, void *user)
+{
+    (void)user;
+    return *(const int*)in % 2 == 0;
+}
+
+static int widen(const void *in, void *out, void *user)
+{
+    (void)user;
+    *(long*)out = *(const int*)in;
+    return 0;
+}
+
+static int square(const void *in, void *out, void *user)
+{
+    (void)user;
+    long v = *(const int*)in;
+    *(long*)out = v * v;
+    /* Let the other mappers in */
+    if (v % 256 == 0) kcoro_yield();
+    return 0;
+}
+
+static void add(const void *in, void *user)
+{
+    __atomic_add_fetch((long*)user, *(const long*)in, __ATOMIC_RELAXED);
+}
+
+/* Reads chunks of longs: each is x*3 for even x, in order. */
+static void chunk_reader(void *arg)
+{
+    struct ctx *c = (struct ctx*)arg;
+    unsigned char buf[KC_FLOW_CHUNK_SIZE(CHUNK, sizeof(long))];
+    kc_flow_chunk_t *k = (kc_flow_chunk_t*)buf;
+    long next = 0;
+    while (kc_chan_recv(c->out, buf, -1) == 0) {
+        c->chunks++;
+        c->last_count = (int)k->count;
+        for (size_t i = 0; i < k->count; i++) {
+            long v;
+            memcpy(&v, k->items + i * sizeof(long), sizeof(v));
+            if (v != next * 3) c->bad++;
+            next += 2;
+            c->items++;
+        }
+    }
+    c->done = 1;
+}
+
+static void long_reader(void *arg)
+{
+    struct ctx *c = (struct ctx*)arg;
+    long v = 0;
+    while (kc_chan_recv(c->out, &v, -1) == 0) { c->sum += v; c->items++; }
+    c->done = 1;
+}
+
+static void wait_done(struct ctx *c)
+{
+    for (int i = 0; i < 20000 && !c->done; i++) usleep(1000);
+    assert(c->done);
+}
+
+int main(void)
+{
+    kc_scope_t *scope = NULL;
+    assert(kc_scope_init(&scope, NULL) == 0);
+
+    /* 1. map/filter/map fused, then fixed-size chunks */
+    static struct ctx a;
+    kc_chan_t *src = kc_scope_produce(scope, KC_BUFFERED, sizeof(int), 64, produce, (void*)(long)N);
+    assert(src);
+    kc_flow_t *f = NULL;
+    assert(kc_flow_create(&f, scope, src, 0) == -EINVAL);
+    assert(kc_flow_create(&f, scope, src, sizeof(int)) == 0);
+    assert(kc_flow_map(f, triple, sizeof(int), NULL) == 0);
+    assert(kc_flow_filter(f, even, NULL) == 1);
+    assert(kc_flow_map(f, widen, sizeof(long), NULL) == 2);
+    assert(kc_flow_batch(f, CHUNK) == 3);
+    assert(kc_flow_launch(f, 0, &a.out) == 0);
+    assert(kc_flow_launch(f, 0, NULL) == -EBUSY && kc_flow_map(f, triple, sizeof(int), NULL) == -EBUSY);
+    assert(kc_spawn_co(kc_sched_default(), chunk_reader, &a, 0, NULL) == 0);
+    wait_done(&a);
+    assert(a.bad == 0 && a.items == (N + 1) / 2);
+    assert(a.chunks == (a.items + CHUNK - 1) / CHUNK && a.last_count == a.items % CHUNK);
+
+    struct kc_chan_snapshot s0, s1;
+    assert(kc_flow_stage_snapshot(f, 0, &s0) == 0 && s0.total_recvs == N && s0.total_sends == N);
+    assert(kc_flow_stage_snapshot(f, 1, &s1) == 0 && s1.total_recvs == N && s1.total_sends == (unsigned long)a.items);
+    assert(s1.total_bytes_sent == s1.total_sends * sizeof(int));
+    /* The output closes just before the last coroutine returns */
+    for (int i = 0; i < 1000 && (kc_flow_stage_snapshot(f, 3, &s1) != 0 || !s1.closed); i++) usleep(1000);
+    assert(s1.closed && s1.total_sends == (unsigned long)a.chunks);
+    assert(kc_flow_stage_snapshot(f, 4, &s1) == -EINVAL);
+    struct kc_chan_snapshot zero;
+    struct kc_chan_rate_sample rate;
+    memset(&zero, 0, sizeof(zero));
+    assert(kc_flow_stage_snapshot(f, 0, &s0) == 0);
+    assert(kc_chan_compute_rate(&zero, &s0, &rate) == 0 && rate.delta_recvs == N && rate.recvs_per_sec > 0);
+    kc_flow_destroy(f);
+    kc_chan_destroy(a.out);
+    kc_chan_destroy(src);
+
+    /* 2. parallel_map into a sink: every square summed once */
+    static long total;
+    src = kc_scope_produce(scope, KC_BUFFERED, sizeof(int), 64, produce, (void*)(long)N);
+    assert(src && kc_flow_create(&f, scope, src, sizeof(int)) == 0);
+    assert(kc_flow_filter(f, even, NULL) == 0);
+    assert(kc_flow_parallel_map(f, 4, square, sizeof(long), NULL) == 1);
+    assert(kc_flow_parallel_map(f, 0, square, sizeof(long), NULL) == -EINVAL);
+    int sink = kc_flow_each(f, add, &total);
+    assert(sink == 2 && kc_flow_each(f, add, &total) == -EINVAL);
+    assert(kc_flow_launch(f, 0, NULL) == 0);
+    kc_flow_destroy(f);
+    long want = 0;
+    for (long i = 0; i < N; i += 2) want += i * i;
+    assert(total == want);
+    kc_chan_destroy(src);
+
+    /* 3. two flows merged into one output */
+    static struct ctx m;
+    kc_chan_t *s2[2];
+    kc_flow_t *in[2], *mf = NULL;
+    for (int i = 0; i < 2; i++) {
+        s2[i] = kc_scope_produce(scope, KC_BUFFERED, sizeof(int), 16, produce, (void*)(long)(N / (i + 1)));
+        assert(s2[i] && kc_flow_create(&in[i], scope, s2[i], sizeof(int)) == 0);
+        assert(kc_flow_map(in[i], widen, sizeof(long), NULL) == 0);
+    }
+    assert(kc_flow_merge(&mf, in, 2) == 0);
+    assert(kc_flow_map(in[0], widen, sizeof(long), NULL) == -EBUSY);
+    assert(kc_flow_launch(mf, 32, &m.out) == 0);
+    assert(kc_spawn_co(kc_sched_default(), long_reader, &m, 0, NULL) == 0);
+    wait_done(&m);
+    long n2 = N / 2;
+    assert(m.items == N + n2 && m.sum == (long)N * (N - 1) / 2 + n2 * (n2 - 1) / 2);
+    kc_flow_destroy(mf);
+    kc_chan_destroy(m.out);
+    for (int i = 0; i < 2; i++) kc_chan_destroy(s2[i]);
+
+    assert(kc_scope_wait_all(scope, 1000) == 0);
+    kc_scope_destroy(scope);
+    printf("[flow] ok n=%d chunks=%d last=%d merged=%d\n", N, a.chunks, a.last_count, m.items);
+    return 0;
+}
@@ -0,0 +1,134 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Test kcoro_set_fpu_preserve: opted-in coroutines keep their own rounding
+// mode across yields (manual resume and scheduler workers), while main and
+// plain coroutines keep seeing the thread's default
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <errno.h>
+#include <fenv.h>
+#include <unistd.h>
+#include <stdatomic.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_core.h"
+
+#define ROUNDS 200
+#define SPAWNS 64
+
+static volatile double g_one = 1.0, g_minus_one = -1.0, g_three = 3.0;
+
+/* Rounding mode as the SSE/NEON unit applies it, not just as reported. */
+static int sse_rounds_up(void)
+{
+    double lo = g_minus_one / g_three, hi = g_one / g_three;
+    return -lo < hi;   /* upward: 1/3 rounds up, -1/3 towards zero */
+}
+
+static int mode_ok(int want)
+{
+    if (fegetround() != want) return 0;
+    return want == FE_UPWARD ? sse_rounds_up() : !sse_rounds_up();
+}
+
+/* ---- manual resume: main, an opted-in and a plain coroutine ---- */
+
+static int g_bad;
+
+static void upward_co(void *arg)
+{
+    (void)arg;
+    assert(fesetround(FE_UPWARD) == 0);
+    for (int i = 0; i < ROUNDS; i++) {
+        if (!mode_ok(FE_UPWARD)) g_bad++;
+        kcoro_yield();
+    }
+}
+
+static void plain_co(void *arg)
+{
+    (void)arg;
+    for (int i = 0; i < ROUNDS; i++) {
+        if (!mode_ok(FE_TONEAREST)) g_bad++;
+        kcoro_yield();
+    }
+}
+
+static void test_manual(void)
+{
+    kcoro_t *main_co = kcoro_create_main();
+    assert(main_co);
+    kcoro_t *up = kcoro_create(upward_co, NULL, 0);
+    kcoro_t *plain = kcoro_create(plain_co, NULL, 0);
+    assert(up && plain);
+    assert(kcoro_set_fpu_preserve(up, 1) == 0);
+    assert(kcoro_set_fpu_preserve(NULL, 1) == -EINVAL);
+
+    kcoro_resume(up);   /* sets FE_UPWARD, then yields */
+    assert(kcoro_set_fpu_preserve(up, 0) == -EBUSY);   /* already started */
+    for (int i = 0; i < ROUNDS; i++) {
+        assert(mode_ok(FE_TONEAREST));
+        kcoro_resume(plain);
+        assert(mode_ok(FE_TONEAREST));
+        kcoro_resume(up);
+    }
+    kcoro_resume(plain);
+    kcoro_resume(up);
+    assert(g_bad == 0);
+    assert(mode_ok(FE_TONEAREST));
+    kcoro_destroy(up);
+    kcoro_destroy(plain);
+    kcoro_destroy(main_co);
+}
+
+/* ---- scheduler: coroutines opt themselves in and migrate between workers ---- */
+
+static atomic_int g_done, g_sbad;
+
+static void self_opt_co(void *arg)
+{
+    int want = (int)(long)arg;
+    assert(kcoro_set_fpu_preserve(kcoro_current(), 1) == 0);
+    assert(fesetround(want) == 0);
+    for (int i = 0; i < ROUNDS; i++) {
+        if (!mode_ok(want)) atomic_fetch_add(&g_sbad, 1);
+        kc_yield();
+    }
+    /* Opting out puts the worker's environment back */
+    assert(kcoro_set_fpu_preserve(kcoro_current(), 0) == 0);
+    if (!mode_ok(FE_TONEAREST)) atomic_fetch_add(&g_sbad, 1);
+    atomic_fetch_add(&g_done, 1);
+}
+
+static void plain_sched_co(void *arg)
+{
+    (void)arg;
+    for (int i = 0; i < ROUNDS; i++) {
+        if (!mode_ok(FE_TONEAREST)) atomic_fetch_add(&g_sbad, 1);
+        kc_yield();
+    }
+    atomic_fetch_add(&g_done, 1);
+}
+
+static void test_sched(void)
+{
+    kc_sched_t *s = kc_sched_default();
+    for (int i = 0; i < SPAWNS; i++) {
+        long want = (i % 2) ? FE_UPWARD : FE_TONEAREST;
+        assert(kc_spawn_co(s, self_opt_co, (void*)want, 0, NULL) == 0);
+        assert(kc_spawn_co(s, plain_sched_co, NULL, 0, NULL) == 0);
+    }
+    for (int i = 0; i < 20000 && atomic_load(&g_done) < 2 * SPAWNS; i++) usleep(500);
+    assert(atomic_load(&g_done) == 2 * SPAWNS);
+    assert(atomic_load(&g_sbad) == 0);
+}
+
+int main(void)
+{
+    assert(mode_ok(FE_TONEAREST));
+    test_manual();
+    test_sched();
+    printf("[fpu ctx] ok rounds=%d spawns=%d\n", ROUNDS, SPAWNS);
+    (void)kc_sched_drain(kc_sched_default(), 500);
+    return 0;
+}
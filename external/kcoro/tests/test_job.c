@@ -0,0 +1,140 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Test kc_job: fan-out/fan-in joined from a thread and from a coroutine,
+// nested launches, failure cancelling siblings, supervisors, external
+// cancel through the job token, detached children and launch after finish
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <errno.h>
+#include <unistd.h>
+#include <stdatomic.h>
+#include "../include/kcoro.h"
+#include "../include/kc_job.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_core.h"
+#include "../include/kcoro_port.h"
+
+#define FANOUT 2000
+
+static atomic_int ran;
+static atomic_int saw_cancel;
+
+static void leaf(void *arg)
+{
+    (void)arg;
+    assert(kc_job_current() != NULL);
+    atomic_fetch_add(&ran, 1);
+}
+
+static void branch(void *arg)
+{
+    (void)arg;
+    atomic_fetch_add(&ran, 1);
+    /* parent NULL: a child of this coroutine's own job */
+    assert(kc_job_launch(NULL, NULL, leaf, NULL, 0, NULL) == 0);
+}
+
+static void failer(void *arg)
+{
+    kc_sleep_ms(5);
+    assert(kc_job_fail(kc_job_current(), (int)(long)arg) == 0);
+}
+
+static void worker(void *arg)
+{
+    int rounds = (int)(long)arg;
+    for (int i = 0; i < rounds; i++) {
+        if (kc_job_is_cancelled(kc_job_current())) { atomic_fetch_add(&saw_cancel, 1); return; }
+        kc_sleep_ms(1);
+    }
+    atomic_fetch_add(&ran, 1);
+}
+
+static kc_chan_t *idle_ch;
+
+static void blocked(void *arg)
+{
+    (void)arg;
+    int v;
+    if (kc_chan_recv_c(idle_ch, &v, -1, kc_job_token(kc_job_current())) == KC_ECANCELED)
+        atomic_fetch_add(&saw_cancel, 1);
+}
+
+struct co_join { volatile int done; int rc; };
+
+static void joiner(void *arg)
+{
+    struct co_join *c = (struct co_join*)arg;
+    kc_job_t *j = NULL;
+    assert(kc_job_create(&j, NULL, 0) == 0);
+    for (int i = 0; i < 100; i++) assert(kc_job_launch(j, NULL, worker, (void*)2L, 0, NULL) == 0);
+    c->rc = kc_job_join(j, NULL);
+    kc_job_release(j);
+    c->done = 1;
+}
+
+int main(void)
+{
+    /* Fan-out/fan-in with nested launches, joined from this thread */
+    kc_job_t *root = NULL;
+    assert(kc_job_create(&root, NULL, 0) == 0);
+    assert(kc_job_state(root) == KC_JOB_ACTIVE);
+    for (int i = 0; i < FANOUT; i++) assert(kc_job_launch(root, NULL, branch, NULL, 0, NULL) == 0);
+    int code = 1;
+    assert(kc_job_join(root, &code) == 0 && code == 0);
+    assert(atomic_load(&ran) == 2 * FANOUT && kc_job_state(root) == KC_JOB_COMPLETED);
+    /* Finished: no more children */
+    assert(kc_job_launch(root, NULL, leaf, NULL, 0, NULL) == KC_ECANCELED);
+    kc_job_release(root);
+
+    /* Joined from a coroutine: it parks */
+    atomic_store(&ran, 0);
+    struct co_join cj = { 0 };
+    assert(kc_spawn_co(kc_sched_default(), joiner, &cj, 0, NULL) == 0);
+    for (int i = 0; i < 5000 && !cj.done; i++) usleep(1000);
+    assert(cj.done && cj.rc == 0 && atomic_load(&ran) == 100);
+
+    /* A failing child cancels its siblings and fails the parent */
+    atomic_store(&ran, 0);
+    assert(kc_job_create(&root, NULL, 0) == 0);
+    for (int i = 0; i < 10; i++) assert(kc_job_launch(root, NULL, worker, (void*)100000L, 0, NULL) == 0);
+    kc_job_t *bad = NULL;
+    assert(kc_job_launch(root, NULL, failer, (void*)(long)-EIO, 0, &bad) == 0);
+    assert(kc_job_join(root, &code) == -EIO && code == -EIO);
+    assert(kc_job_state(root) == KC_JOB_FAILED && kc_job_state(bad) == KC_JOB_FAILED);
+    assert(atomic_load(&saw_cancel) == 10 && atomic_load(&ran) == 0);
+    assert(kc_job_join(bad, NULL) == -EIO);
+    kc_job_release(bad);
+    kc_job_release(root);
+
+    /* Supervisor: the failure stays with the child */
+    atomic_store(&saw_cancel, 0);
+    assert(kc_job_create(&root, NULL, KC_JOB_F_SUPERVISOR) == 0);
+    for (int i = 0; i < 10; i++) assert(kc_job_launch(root, NULL, worker, (void*)20L, 0, NULL) == 0);
+    assert(kc_job_launch(root, NULL, failer, (void*)(long)-EIO, 0, &bad) == 0);
+    assert(kc_job_join(root, NULL) == 0 && kc_job_state(root) == KC_JOB_COMPLETED);
+    assert(atomic_load(&ran) == 10 && atomic_load(&saw_cancel) == 0);
+    assert(kc_job_state(bad) == KC_JOB_FAILED && kc_job_result_code(bad) == -EIO);
+    kc_job_release(bad);
+    kc_job_release(root);
+
+    /* External cancel reaches children parked on the job token */
+    assert(kc_chan_make(&idle_ch, KC_BUFFERED, sizeof(int), 4) == 0);
+    assert(kc_job_create(&root, NULL, 0) == 0);
+    for (int i = 0; i < 8; i++) assert(kc_job_launch(root, NULL, blocked, NULL, 0, NULL) == 0);
+    kc_job_t *det = NULL;
+    assert(kc_job_create(&det, root, KC_JOB_F_DETACHED) == 0);
+    usleep(20000);
+    assert(kc_job_cancel(root, 0) == 0 && kc_job_cancel(root, 0) == -EALREADY);
+    assert(kc_job_join(root, &code) == KC_ECANCELED && code == KC_ECANCELED);
+    assert(kc_job_state(root) == KC_JOB_CANCELLED && atomic_load(&saw_cancel) == 8);
+    /* The detached job neither held up the parent nor was cancelled */
+    assert(kc_job_state(det) == KC_JOB_ACTIVE);
+    assert(kc_job_join(det, NULL) == 0);
+    kc_job_release(det);
+    kc_job_release(root);
+    kc_chan_destroy(idle_ch);
+
+    printf("[job] ok fanout=%d\n", FANOUT);
+    return 0;
+}
@@ -0,0 +1,108 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Test the KC_MUTEX contention profile. Default builds: the report calls
+// return -ENOTSUP. LOCK_PROF=1 builds: two threads fighting over a port
+// mutex with a sleep in the critical section show up as one contended site
+// with wait and hold time, channel traffic registers the ch->mu sites, and
+// reset zeroes the counters.
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_port.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_lockprof.h"
+
+#define SITES 256
+
+static KC_MUTEX_T g_mu;
+static int g_counter;
+
+static void *fighter(void *arg)
+{
+    (void)arg;
+    for (int i = 0; i < 20; i++) {
+        KC_MUTEX_LOCK(&g_mu);
+        g_counter++;
+        usleep(500);
+        KC_MUTEX_UNLOCK(&g_mu);
+        usleep(50);
+    }
+    return NULL;
+}
+
+static volatile int g_done;
+
+static void traffic(void *arg)
+{
+    kc_chan_t *ch = (kc_chan_t*)arg;
+    for (int i = 0; i < 100; i++) {
+        int v = i, r = -1;
+        assert(kc_chan_try_send(ch, &v) == 0);
+        assert(kc_chan_try_recv(ch, &r) == 0 && r == i);
+    }
+    g_done = 1;
+}
+
+static const kc_lockprof_site_t *find(const kc_lockprof_site_t *v, int n, const char *file, const char *lock)
+{
+    for (int i = 0; i < n; i++)
+        if (strstr(v[i].file, file) && strcmp(v[i].lock, lock) == 0) return &v[i];
+    return NULL;
+}
+
+int main(void)
+{
+    static kc_lockprof_site_t v[SITES];
+    if (!kc_lockprof_enabled()) {
+        assert(kc_lockprof_snapshot(v, SITES) == -ENOTSUP);
+        assert(kc_lockprof_reset() == -ENOTSUP);
+        assert(kc_lockprof_dump(STDOUT_FILENO, 0) == -ENOTSUP);
+        printf("[lockprof] ok (compiled out)\n");
+        return 0;
+    }
+    assert(kc_lockprof_snapshot(NULL, 1) == -EINVAL);
+
+    KC_MUTEX_INIT(&g_mu);
+    pthread_t a, b;
+    assert(pthread_create(&a, NULL, fighter, NULL) == 0);
+    assert(pthread_create(&b, NULL, fighter, NULL) == 0);
+    pthread_join(a, NULL);
+    pthread_join(b, NULL);
+    assert(g_counter == 40);
+
+    kc_chan_t *ch = NULL;
+    assert(kc_chan_make(&ch, KC_BUFFERED, sizeof(int), 8) == 0);
+    assert(kc_spawn_co(kc_sched_default(), traffic, ch, 0, NULL) == 0);
+    for (int i = 0; i < 5000 && !g_done; i++) usleep(1000);
+    assert(g_done);
+
+    int n = kc_lockprof_snapshot(v, SITES);
+    assert(n > 0);
+    for (int i = 1; i < n; i++) assert(v[i - 1].wait_ns >= v[i].wait_ns);
+    const kc_lockprof_site_t *s = find(v, n, "test_lockprof.c", "&g_mu");
+    assert(s && s->acquisitions == 40);
+    assert(s->contended > 0 && s->contended <= s->acquisitions);
+    assert(s->wait_ns > 0 && s->max_wait_ns <= s->wait_ns);
+    assert(s->hold_ns >= 40ull * 500 * 1000 && s->max_hold_ns >= 500 * 1000);
+    const kc_lockprof_site_t *c = find(v, n, "kc_chan.c", "&ch->mu");
+    assert(c && c->acquisitions >= 100);
+
+    int fd = open("/dev/null", O_WRONLY);
+    assert(fd >= 0 && kc_lockprof_dump(fd, 10) == 0);
+    close(fd);
+    assert(kc_lockprof_dump(STDOUT_FILENO, 5) == 0);
+
+    assert(kc_lockprof_reset() == 0);
+    n = kc_lockprof_snapshot(v, SITES);
+    assert(n >= 0 && !find(v, n, "test_lockprof.c", "&g_mu"));
+
+    kc_chan_close(ch);
+    kc_chan_destroy(ch);
+    KC_MUTEX_DESTROY(&g_mu);
+    printf("[lockprof] ok\n");
+    return 0;
+}
@@ -0,0 +1,124 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Runtime memory accounting (kc_mem.h)
+// 1) a stack budget that cannot fit one more stack makes kc_spawn_co fail
+//    with -ENOMEM and counts the refusal; lifting it lets spawns through.
+// 2) kc_chan_make of a buffered channel past the channel budget: -ENOMEM.
+// 3) KC_UNLIMITED growth past the budget: KC_EAGAIN at timeout 0, KC_ETIME
+//    for a timed send, and a blocking send waits until receives free room.
+// 4) destroying the channels brings the gauge back; kc_metrics_render
+//    publishes the families.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <assert.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_core.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_port.h"
+#include "../include/kcoro_metrics.h"
+#include "../include/kc_mem.h"
+
+enum { SEG = 16, MORE = 100 };
+
+static kc_chan_t *g_ch;
+static _Atomic(int) g_ran, g_timed_rc = 1, g_sent;
+
+static void coro(void *arg){
+    (void)arg;
+    atomic_fetch_add(&g_ran, 1);
+}
+
+static void timed_sender(void *arg){
+    (void)arg;
+    int v = -1;
+    atomic_store(&g_timed_rc, kc_chan_send(g_ch, &v, 30));
+}
+
+static void sender(void *arg){
+    (void)arg;
+    for (int i = 0; i < MORE; i++) {
+        int v = 1000 + i;
+        if (kc_chan_send(g_ch, &v, -1) != 0) return;
+        atomic_fetch_add(&g_sent, 1);
+    }
+}
+
+int main(void){
+    printf("[test] mem_budget start\n");
+    kc_mem_stats_t m0, m;
+    if (kc_mem_set_limit(KC_MEM_CAT_COUNT, 1) != -EINVAL) { fprintf(stderr, "bad category accepted\n"); return 1; }
+
+    kc_sched_opts_t opts = {0};
+    opts.workers = 2;
+    kc_sched_t *s = kc_sched_init(&opts); assert(s);
+
+    kc_mem_get_stats(&m0);
+    kc_mem_set_limit(KC_MEM_STACKS, m0.bytes[KC_MEM_STACKS] + 1);
+    int rc = kc_spawn_co(s, coro, NULL, 0, NULL);
+    kc_mem_get_stats(&m);
+    if (rc != -ENOMEM || m.denied[KC_MEM_STACKS] <= m0.denied[KC_MEM_STACKS]) {
+        fprintf(stderr, "stack budget rc=%d denied=%lu\n", rc, m.denied[KC_MEM_STACKS]); return 2;
+    }
+    kc_mem_set_limit(KC_MEM_STACKS, 0);
+    assert(kc_spawn_co(s, coro, NULL, 0, NULL) == 0);
+    if (kc_sched_drain(s, 5000) != 0 || atomic_load(&g_ran) != 1) { fprintf(stderr, "spawn after lift failed\n"); return 3; }
+
+    kc_mem_get_stats(&m0);
+    size_t chan0 = m0.bytes[KC_MEM_CHAN];
+    kc_mem_set_limit(KC_MEM_CHAN, chan0 + 4096);
+    kc_chan_t *big = NULL;
+    if (kc_chan_make(&big, KC_BUFFERED, 8, 1 << 16) != -ENOMEM || big) { fprintf(stderr, "big buffered channel made\n"); return 4; }
+
+    assert(kc_chan_make(&g_ch, KC_UNLIMITED, sizeof(int), SEG) == 0);
+    int n = 0;
+    while (n < 100000) {
+        int v = n;
+        if ((rc = kc_chan_send(g_ch, &v, 0)) != 0) break;
+        n++;
+    }
+    kc_mem_get_stats(&m);
+    if (rc != KC_EAGAIN || n < SEG || m.bytes[KC_MEM_CHAN] > chan0 + 4096) {
+        fprintf(stderr, "unlimited rc=%d n=%d bytes=%zu\n", rc, n, m.bytes[KC_MEM_CHAN]); return 5;
+    }
+
+    assert(kc_spawn_co(s, timed_sender, NULL, 0, NULL) == 0);
+    /* drain counts a coroutine asleep between retries as quiescent */
+    for (int i = 0; i < 5000 && atomic_load(&g_timed_rc) == 1; i++) kc_sleep_ms(1);
+    if (atomic_load(&g_timed_rc) != KC_ETIME) {
+        fprintf(stderr, "timed send rc=%d\n", atomic_load(&g_timed_rc)); return 6;
+    }
+
+    assert(kc_spawn_co(s, sender, NULL, 0, NULL) == 0);
+    kc_sleep_ms(20);
+    if (atomic_load(&g_sent) != 0) { fprintf(stderr, "sender not held back sent=%d\n", atomic_load(&g_sent)); return 7; }
+    int got = 0, v, order_ok = 1;
+    for (int i = 0; i < 10000 && got < n + MORE; i++) {
+        while (got < n + MORE && kc_chan_recv(g_ch, &v, 0) == 0) {
+            if (v != (got < n ? got : 1000 + got - n)) order_ok = 0;
+            got++;
+        }
+        if (got < n + MORE) kc_sleep_ms(1);
+    }
+    if (kc_sched_drain(s, 5000) != 0 || got != n + MORE || atomic_load(&g_sent) != MORE || !order_ok) {
+        fprintf(stderr, "drain got=%d sent=%d order=%d\n", got, atomic_load(&g_sent), order_ok); return 8;
+    }
+
+    char *buf = (char*)malloc(1 << 20); assert(buf);
+    long len = kc_metrics_render(buf, 1 << 20);
+    if (len <= 0 || !strstr(buf, "kcoro_mem_bytes{cat=\"chan\"}") || !strstr(buf, "kcoro_mem_denied_total{cat=\"stacks\"}")) {
+        fprintf(stderr, "metrics missing mem families\n"); return 9;
+    }
+    free(buf);
+
+    kc_chan_destroy(g_ch);
+    kc_mem_get_stats(&m);
+    if (m.bytes[KC_MEM_CHAN] != chan0 || m.peak[KC_MEM_CHAN] <= chan0) {
+        fprintf(stderr, "chan gauge %zu want %zu peak %zu\n", m.bytes[KC_MEM_CHAN], chan0, m.peak[KC_MEM_CHAN]); return 10;
+    }
+    kc_mem_set_limit(KC_MEM_CHAN, 0);
+    kc_sched_shutdown(s);
+    printf("[test] mem_budget ok unlimited=%d denied_chan=%lu\n", n, m.denied[KC_MEM_CHAN]);
+    return 0;
+}
@@ -0,0 +1,192 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Test the metrics registry: register/unregister errors, OpenMetrics text
+// for a channel and a scheduler (label escaping, grouped families, # EOF),
+// snprintf-style truncation, delta events pushed into a metrics pipe, and
+// the HTTP exporter on an ephemeral port
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_metrics.h"
+
+struct ctx { kc_chan_t *ch; int n; volatile int done; };
+
+static void producer(void *arg)
+{
+    struct ctx *c = (struct ctx*)arg;
+    for (int i = 0; i < c->n; i++) assert(kc_chan_send(c->ch, &i, -1) == 0);
+    c->done++;
+}
+
+static void consumer(void *arg)
+{
+    struct ctx *c = (struct ctx*)arg;
+    for (int i = 0; i < c->n; i++) { int v; assert(kc_chan_recv(c->ch, &v, -1) == 0 && v == i); }
+    c->done++;
+}
+
+static void run_traffic(kc_chan_t *ch, int n)
+{
+    struct ctx c = { ch, n, 0 };
+    assert(kc_spawn_co(kc_sched_default(), consumer, &c, 0, NULL) == 0);
+    assert(kc_spawn_co(kc_sched_default(), producer, &c, 0, NULL) == 0);
+    for (int i = 0; i < 5000 && c.done < 2; i++) usleep(1000);
+    assert(c.done == 2);
+}
+
+static volatile int g_co_done;
+
+static void run_co(void (*fn)(void*), void *arg)
+{
+    g_co_done = 0;
+    assert(kc_spawn_co(kc_sched_default(), fn, arg, 0, NULL) == 0);
+    for (int i = 0; i < 5000 && !g_co_done; i++) usleep(1000);
+    assert(g_co_done);
+}
+
+static void send_one(void *arg)
+{
+    int v = 7;
+    assert(kc_chan_try_send((kc_chan_t*)arg, &v) == 0);
+    g_co_done = 1;
+}
+
+struct push_ctx { kc_chan_t *ch, *pipe; };
+
+static void push_steps(void *arg)
+{
+    struct push_ctx *p = (struct push_ctx*)arg;
+    struct kc_chan_metrics_event ev;
+    int v;
+    assert(kc_metrics_push(NULL) == -EINVAL);
+    assert(kc_metrics_push(p->pipe) == 1);
+    assert(kc_chan_try_recv(p->pipe, &ev) == 0);
+    assert(ev.chan == p->ch && ev.delta_sends == 101 && ev.delta_recvs == 100 && ev.total_sends == 101);
+    assert(kc_metrics_push(p->pipe) == 0);
+    assert(kc_chan_try_recv(p->ch, &v) == 0 && v == 7);
+    assert(kc_metrics_push(p->pipe) == 1);
+    assert(kc_chan_try_recv(p->pipe, &ev) == 0 && ev.delta_sends == 0 && ev.delta_recvs == 1);
+    g_co_done = 1;
+}
+
+static char *render(void)
+{
+    long n = kc_metrics_render(NULL, 0);
+    assert(n > 0);
+    char *buf = (char*)malloc((size_t)n + 256);
+    long m = kc_metrics_render(buf, (size_t)n + 256);
+    assert(m > 0 && m < n + 256);
+    return buf;
+}
+
+static char *http_get(int port, const char *req)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    assert(fd >= 0);
+    struct sockaddr_in sa = { .sin_family = AF_INET, .sin_port = htons((uint16_t)port) };
+    sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    assert(connect(fd, (struct sockaddr*)&sa, sizeof(sa)) == 0);
+    assert(write(fd, req, strlen(req)) == (ssize_t)strlen(req));
+    size_t cap = 65536, len = 0;
+    char *buf = (char*)malloc(cap);
+    ssize_t r;
+    while ((r = read(fd, buf + len, cap - 1 - len)) > 0) {
+        len += (size_t)r;
+        if (len + 1 == cap) buf = (char*)realloc(buf, cap *= 2);
+    }
+    buf[len] = '\0';
+    close(fd);
+    return buf;
+}
+
+int main(void)
+{
+    kc_sched_t *s = kc_sched_default();
+    kc_chan_t *ch = NULL;
+    assert(kc_chan_make(&ch, KC_BUFFERED, sizeof(int), 8) == 0);
+
+    assert(kc_metrics_register_chan(NULL, "x") == -EINVAL);
+    assert(kc_metrics_register_chan(ch, NULL) == -EINVAL);
+    assert(kc_metrics_register_chan(ch, "jobs \"in\"") == 0);
+    assert(kc_metrics_register_chan(ch, "again") == -EEXIST);
+    assert(kc_metrics_register_sched(s, "default") == 0);
+    assert(kc_metrics_unregister_sched(NULL) == -EINVAL);
+
+    run_traffic(ch, 100);
+    run_co(send_one, ch);
+
+    char *txt = render();
+    assert(strstr(txt, "# TYPE kcoro_chan_sends counter\n"));
+    assert(strstr(txt, "kcoro_chan_sends_total{chan=\"jobs \\\"in\\\"\"} 101\n"));
+    assert(strstr(txt, "kcoro_chan_recvs_total{chan=\"jobs \\\"in\\\"\"} 100\n"));
+    assert(strstr(txt, "kcoro_chan_depth{chan=\"jobs \\\"in\\\"\"} 1\n"));
+    assert(strstr(txt, "kcoro_chan_capacity{chan=\"jobs \\\"in\\\"\"} 8\n"));
+    assert(strstr(txt, "kcoro_chan_send_failures_total{chan=\"jobs \\\"in\\\"\",reason=\"epipe\"} 0\n"));
+    assert(strstr(txt, "kcoro_sched_tasks_submitted_total{sched=\"default\"} "));
+    assert(strstr(txt, "kcoro_sched_lane_run_total{sched=\"default\",lane=\"bulk\"} "));
+    assert(strstr(txt, "# TYPE kcoro_io_submitted counter\n"));
+    size_t len = strlen(txt);
+    assert(len > 6 && strcmp(txt + len - 6, "# EOF\n") == 0);
+    /* Each family appears once */
+    const char *first = strstr(txt, "# TYPE kcoro_chan_sends ");
+    assert(first && !strstr(first + 1, "# TYPE kcoro_chan_sends "));
+
+    /* Truncation: the result is the full length, buf stays terminated */
+    char small[32];
+    long full = kc_metrics_render(small, sizeof(small));
+    assert(full == (long)len && strlen(small) == sizeof(small) - 1);
+    free(txt);
+
+    /* Push: one event with the deltas since the previous push */
+    kc_chan_t *pipe = NULL;
+    assert(kc_chan_make(&pipe, KC_BUFFERED, sizeof(struct kc_chan_metrics_event), 4) == 0);
+    struct push_ctx pc = { ch, pipe };
+    run_co(push_steps, &pc);
+
+    /* Exporter */
+    kc_metrics_server_t *srv = NULL;
+    assert(kc_metrics_serve(s, "127.0.0.1", 70000, &srv) == -EINVAL);
+    assert(kc_metrics_serve(s, "127.0.0.1", 0, &srv) == 0);
+    int port = kc_metrics_server_port(srv);
+    assert(port > 0);
+    char *resp = http_get(port, "GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    assert(strncmp(resp, "HTTP/1.0 200 OK\r\n", 17) == 0);
+    assert(strstr(resp, "Content-Type: application/openmetrics-text; version=1.0.0; charset=utf-8\r\n"));
+    char *body = strstr(resp, "\r\n\r\n");
+    assert(body);
+    body += 4;
+    long clen = atol(strstr(resp, "Content-Length: ") + 16);
+    assert(clen == (long)strlen(body));
+    assert(strstr(body, "kcoro_chan_recvs_total{chan=\"jobs \\\"in\\\"\"} 101\n"));
+    assert(strcmp(body + strlen(body) - 6, "# EOF\n") == 0);
+    free(resp);
+    resp = http_get(port, "GET /nope HTTP/1.0\r\n\r\n");
+    assert(strncmp(resp, "HTTP/1.0 404", 12) == 0);
+    free(resp);
+    resp = http_get(port, "POST /metrics HTTP/1.0\r\n\r\n");
+    assert(strncmp(resp, "HTTP/1.0 405", 12) == 0);
+    free(resp);
+    assert(kc_metrics_server_stop(srv) == 0);
+
+    /* Unregistered objects drop out of the text and free their slot */
+    assert(kc_metrics_unregister_chan(ch) == 0);
+    assert(kc_metrics_unregister_chan(ch) == -ENOENT);
+    assert(kc_metrics_unregister_sched(s) == 0);
+    txt = render();
+    assert(!strstr(txt, "kcoro_chan_") && !strstr(txt, "kcoro_sched_") && strstr(txt, "# EOF\n"));
+    free(txt);
+    assert(kc_metrics_register_chan(ch, "again") == 0);
+    assert(kc_metrics_unregister_chan(ch) == 0);
+
+    kc_chan_destroy(pipe);
+    kc_chan_destroy(ch);
+    printf("[metrics] ok\n");
+    return 0;
+}
@@ -0,0 +1,201 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Test kc_mstream: record framing and batching, the descriptor window,
+// truncated records, drop-behind keeping the mapped footprint bounded, and
+// a pump coroutine feeding a zref channel
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+#include <errno.h>
+#include <unistd.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_zcopy.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_core.h"
+#include "../include/kcoro_port.h"
+
+static char g_path[64];
+
+static void write_file(const void *p, size_t n)
+{
+    strcpy(g_path, "/tmp/kc_mstream_XXXXXX");
+    int fd = mkstemp(g_path);
+    assert(fd >= 0);
+    assert(write(fd, p, n) == (ssize_t)n);
+    close(fd);
+}
+
+/* RssFile from /proc/self/status in kB, -1 where there is none */
+static long rss_file_kb(void)
+{
+    FILE *f = fopen("/proc/self/status", "r");
+    if (!f) return -1;
+    char line[256];
+    long kb = -1;
+    while (fgets(line, sizeof(line), f))
+        if (sscanf(line, "RssFile: %ld", &kb) == 1) break;
+    fclose(f);
+    return kb;
+}
+
+static void test_delim(void)
+{
+    const char text[] = "alpha\nbeta\ngamma\ndelta\nlast";
+    write_file(text, sizeof(text) - 1);
+    kc_mstream_opts_t o = { .framing = KC_MSTREAM_DELIM, .delim = '\n', .batch_bytes = 12, .window = 2 };
+    kc_mstream_t *s = NULL;
+    assert(kc_mstream_open(&s, g_path, &o) == 0);
+    assert(kc_mstream_size(s) == sizeof(text) - 1);
+    unsigned long rid = 0;
+    assert(kc_region_export_id(kc_mstream_region(s), &rid) == 0);
+    kc_zdesc_t a, b, c;
+    /* "alpha\nbeta\n" fits 12 bytes, "gamma\n" would not */
+    assert(kc_mstream_next(s, &a, 0) == 0);
+    assert(a.len == 11 && memcmp(a.addr, "alpha\nbeta\n", 11) == 0 && a.offset == 0 && a.region_id == rid);
+    assert(kc_mstream_next(s, &b, 0) == 0);
+    assert(b.len == 12 && memcmp(b.addr, "gamma\ndelta\n", 12) == 0 && b.offset == 11);
+    /* Window of two is full */
+    assert(kc_mstream_next(s, &c, 0) == KC_EAGAIN);
+    assert(kc_mstream_next(s, &c, 20) == KC_ETIME);
+    assert(kc_mstream_release(s, &b) == 0);
+    assert(kc_mstream_release(s, &b) == -EINVAL);
+    /* Still held: the window counts from a, the oldest one out */
+    assert(kc_mstream_next(s, &c, 0) == KC_EAGAIN);
+    assert(kc_mstream_release(s, &a) == 0);
+    /* The record without a delimiter closes the file */
+    assert(kc_mstream_next(s, &c, 0) == 0);
+    assert(c.len == 4 && memcmp(c.addr, "last", 4) == 0);
+    assert(kc_mstream_close(s) == -EBUSY);
+    assert(kc_mstream_release(s, &c) == 0);
+    assert(kc_mstream_next(s, &c, 0) == KC_EPIPE);
+    struct kc_mstream_stats st;
+    assert(kc_mstream_get_stats(s, &st) == 0);
+    assert(st.records == 5 && st.descs == 3 && st.bytes == sizeof(text) - 1 && st.inflight == 0);
+    assert(st.window_waits == 3 && st.willneed > 0);
+    assert(kc_mstream_close(s) == 0);
+    /* The region went with it */
+    assert(kc_region_get(rid) == NULL);
+    unlink(g_path);
+}
+
+static void test_fixed_and_len32(void)
+{
+    unsigned char buf[100];
+    for (int i = 0; i < 100; i++) buf[i] = (unsigned char)i;
+    write_file(buf, sizeof(buf));
+    kc_mstream_t *s = NULL;
+    kc_mstream_opts_t bad = { .framing = KC_MSTREAM_FIXED };
+    assert(kc_mstream_open(&s, g_path, &bad) == -EINVAL);
+    kc_mstream_opts_t o = { .framing = KC_MSTREAM_FIXED, .record_size = 16, .batch_bytes = 40 };
+    assert(kc_mstream_open(&s, "/nonexistent/kc_mstream", &o) == -ENOENT);
+    assert(kc_mstream_open(&s, g_path, &o) == 0);
+    kc_zdesc_t d;
+    uint64_t off = 0;
+    for (int i = 0; i < 3; i++) {
+        assert(kc_mstream_next(s, &d, 0) == 0);
+        assert(d.len == 32 && d.offset == off && ((unsigned char*)d.addr)[0] == (unsigned char)off);
+        off += d.len;
+        assert(kc_mstream_release(s, &d) == 0);
+    }
+    /* 4 bytes left: a record the file cuts short, every time */
+    assert(kc_mstream_next(s, &d, 0) == -EBADMSG);
+    assert(kc_mstream_next(s, &d, 0) == -EBADMSG);
+    assert(kc_mstream_close(s) == 0);
+    unlink(g_path);
+
+    /* Length-prefixed: 3, 0 and 5 byte records, then one that overruns */
+    const unsigned char l32[] = { 3,0,0,0, 'a','b','c', 0,0,0,0, 5,0,0,0, '1','2','3','4','5', 9,0,0,0, 'x' };
+    write_file(l32, sizeof(l32));
+    kc_mstream_opts_t lo = { .framing = KC_MSTREAM_LEN32 };
+    assert(kc_mstream_open(&s, g_path, &lo) == 0);
+    size_t want[] = { 7, 4, 9 };
+    for (int i = 0; i < 3; i++) {
+        assert(kc_mstream_next(s, &d, 0) == 0 && d.len == want[i]);
+        assert(kc_mstream_release(s, &d) == 0);
+    }
+    assert(kc_mstream_next(s, &d, 0) == -EBADMSG);
+    assert(kc_mstream_close(s) == 0);
+    unlink(g_path);
+}
+
+/* Streams a file several times the readahead plus window; reading every
+ * byte must not leave the whole file mapped in */
+static void test_drop_behind(void)
+{
+    const size_t size = 32u << 20, rec = 64u << 10;
+    char *buf = malloc(size);
+    assert(buf);
+    for (size_t i = 0; i < size; i++) buf[i] = (char)(i * 7);
+    write_file(buf, size);
+    free(buf);
+    kc_mstream_opts_t o = { .framing = KC_MSTREAM_FIXED, .record_size = rec, .readahead = 1u << 20, .window = 4 };
+    kc_mstream_t *s = NULL;
+    assert(kc_mstream_open(&s, g_path, &o) == 0);
+    long base = rss_file_kb(), peak = 0;
+    kc_zdesc_t d;
+    unsigned long sum = 0;
+    while (kc_mstream_next(s, &d, 0) == 0) {
+        for (size_t i = 0; i < d.len; i += 512) sum += ((unsigned char*)d.addr)[i];
+        long r = rss_file_kb();
+        if (r - base > peak) peak = r - base;
+        assert(kc_mstream_release(s, &d) == 0);
+    }
+    struct kc_mstream_stats st;
+    assert(kc_mstream_get_stats(s, &st) == 0);
+    assert(st.bytes == size && st.dropped >= size - rec - 4096);
+    if (base >= 0) assert(peak < 8 * 1024);
+    assert(kc_mstream_close(s) == 0);
+    unlink(g_path);
+    printf("[mstream] drop-behind peak RssFile +%ld kB (sum %lu)\n", peak, sum);
+}
+
+struct pump_ctx { kc_mstream_t *s; kc_chan_t *ch; volatile int done, got, bad, rc; };
+
+static void pump_co(void *arg)
+{
+    struct pump_ctx *c = arg;
+    c->rc = kc_mstream_pump(c->s, c->ch, -1);
+    kc_chan_close(c->ch);
+}
+
+static void consume_co(void *arg)
+{
+    struct pump_ctx *c = arg;
+    kc_zdesc_t d = { 0 };
+    while (kc_chan_recv_desc(c->ch, &d, -1) == 0) {
+        if (d.len != 128 || ((unsigned char*)d.addr)[0] != (unsigned char)(c->got * 2)) c->bad++;
+        c->got++;
+        if (kc_mstream_release(c->s, &d) != 0) c->bad++;
+    }
+    c->done = 1;
+}
+
+static void test_pump(void)
+{
+    unsigned char buf[64 * 128];
+    for (int r = 0; r < 64; r++) memset(buf + r * 128, r * 2, 128);
+    write_file(buf, sizeof(buf));
+    kc_mstream_opts_t o = { .framing = KC_MSTREAM_FIXED, .record_size = 128, .window = 8 };
+    struct pump_ctx c = { 0 };
+    assert(kc_mstream_open(&c.s, g_path, &o) == 0);
+    assert(kc_chan_make_ptr(&c.ch, KC_BUFFERED, 4) == 0);
+    assert(kc_chan_enable_zero_copy_backend(c.ch, kc_zcopy_resolve("zref"), NULL) == 0);
+    assert(kc_spawn_co(kc_sched_default(), consume_co, &c, 0, NULL) == 0);
+    assert(kc_spawn_co(kc_sched_default(), pump_co, &c, 0, NULL) == 0);
+    for (int i = 0; i < 10000 && !c.done; i++) usleep(1000);
+    assert(c.done && c.rc == 0 && c.got == 64 && c.bad == 0);
+    kc_chan_destroy(c.ch);
+    assert(kc_mstream_close(c.s) == 0);
+    unlink(g_path);
+}
+
+int main(void)
+{
+    test_delim();
+    test_fixed_and_len32();
+    test_drop_behind();
+    test_pump();
+    printf("[mstream] ok\n");
+    return 0;
+}
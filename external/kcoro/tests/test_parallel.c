@@ -0,0 +1,121 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// kc_parallel_for / kc_parallel_reduce
+// 1) from a plain thread: every index is visited exactly once, for an
+//    explicit grain and an auto grain; a reduce over a two-field
+//    accumulator matches the closed form.
+// 2) from a task and from a coroutine on a worker (the helping join), with
+//    a nested loop inside the body.
+// 3) empty ranges, a single worker, and bad arguments.
+#include <stdio.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <assert.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_core.h"
+#include "../include/kcoro_sched.h"
+
+enum { N = 1 << 20, OUTER = 64, INNER = 512 };
+
+static _Atomic unsigned char *g_hits;
+static kc_sched_t *g_s;
+static _Atomic(int) g_done;
+static int g_rc = -1;
+
+struct sum { unsigned long long total, count; };
+
+static void visit(void *ctx, size_t b, size_t e){
+    (void)ctx;
+    for (; b < e; b++) atomic_fetch_add_explicit(&g_hits[b], 1, memory_order_relaxed);
+}
+
+static void fold(void *ctx, size_t b, size_t e, void *acc){
+    (void)ctx;
+    struct sum *s = acc;
+    for (; b < e; b++) { s->total += b; s->count++; }
+}
+
+static void combine(void *ctx, void *acc, const void *other){
+    (void)ctx;
+    struct sum *a = acc;
+    const struct sum *o = other;
+    a->total += o->total;
+    a->count += o->count;
+}
+
+static int check_hits(size_t n){
+    for (size_t i = 0; i < n; i++) {
+        if (atomic_load_explicit(&g_hits[i], memory_order_relaxed) != 1) {
+            fprintf(stderr, "index %zu visited %u times\n", i, (unsigned)g_hits[i]);
+            return 0;
+        }
+        atomic_store_explicit(&g_hits[i], 0, memory_order_relaxed);
+    }
+    return 1;
+}
+
+static int check_reduce(kc_sched_t *s, size_t grain){
+    struct sum id = {0, 0}, out = {1, 1};
+    if (kc_parallel_reduce(s, 0, N, grain, &id, sizeof(id), fold, combine, NULL, &out) != 0) return 0;
+    return out.total == (unsigned long long)N * (N - 1) / 2 && out.count == N;
+}
+
+/* Each outer iteration runs its own inner loop over a slice of g_hits. */
+static void outer(void *ctx, size_t b, size_t e){
+    (void)ctx;
+    for (; b < e; b++) assert(kc_parallel_for(g_s, b * INNER, (b + 1) * INNER, 16, visit, NULL) == 0);
+}
+
+static int from_worker(void){
+    if (kc_parallel_for(g_s, 0, N, KC_PARALLEL_GRAIN_AUTO, visit, NULL) != 0 || !check_hits(N)) return 1;
+    if (kc_parallel_for(g_s, 0, OUTER, 1, outer, NULL) != 0 || !check_hits((size_t)OUTER * INNER)) return 2;
+    if (!check_reduce(g_s, KC_PARALLEL_GRAIN_AUTO)) return 3;
+    return 0;
+}
+
+static void task_body(void *arg){ (void)arg; g_rc = from_worker(); atomic_store(&g_done, 1); }
+static void co_body(void *arg){ (void)arg; g_rc = from_worker(); atomic_store(&g_done, 1); }
+
+static int wait_done(void){
+    for (int i = 0; i < 6000 && !atomic_load(&g_done); i++) kc_sleep_ms(5);
+    return atomic_load(&g_done);
+}
+
+int main(void){
+    printf("[test] parallel start\n");
+    g_hits = calloc(N, sizeof(*g_hits));
+    assert(g_hits);
+    kc_sched_opts_t opts = {0};
+    opts.workers = 4;
+    g_s = kc_sched_init(&opts); assert(g_s);
+
+    if (kc_parallel_for(g_s, 0, N, 1024, visit, NULL) != 0 || !check_hits(N)) return 1;
+    if (kc_parallel_for(g_s, 0, N, KC_PARALLEL_GRAIN_AUTO, visit, NULL) != 0 || !check_hits(N)) return 2;
+    if (kc_parallel_for(g_s, 0, OUTER, 1, outer, NULL) != 0 || !check_hits((size_t)OUTER * INNER)) return 3;
+    if (!check_reduce(g_s, 4096) || !check_reduce(g_s, KC_PARALLEL_GRAIN_AUTO)) return 4;
+
+    assert(kc_spawn(g_s, task_body, NULL) == 0);
+    if (!wait_done() || g_rc != 0) { fprintf(stderr, "task caller rc=%d\n", g_rc); return 5; }
+    atomic_store(&g_done, 0); g_rc = -1;
+    assert(kc_spawn_co(g_s, co_body, NULL, 0, NULL) == 0);
+    if (!wait_done() || g_rc != 0) { fprintf(stderr, "coroutine caller rc=%d\n", g_rc); return 6; }
+
+    struct sum id = {0, 0}, out = {5, 5};
+    if (kc_parallel_for(g_s, 7, 7, 0, visit, NULL) != 0) return 7;
+    if (kc_parallel_reduce(g_s, 3, 3, 0, &id, sizeof(id), fold, combine, NULL, &out) != 0 || out.total || out.count)
+        return 8;
+    if (kc_parallel_for(NULL, 0, 1, 0, visit, NULL) != -EINVAL || kc_parallel_for(g_s, 2, 1, 0, visit, NULL) != -EINVAL ||
+        kc_parallel_for(g_s, 0, 1, 0, NULL, NULL) != -EINVAL) return 9;
+    if (kc_parallel_reduce(g_s, 0, 1, 0, &id, 0, fold, combine, NULL, &out) != -EINVAL ||
+        kc_parallel_reduce(g_s, 0, 1, 0, &id, sizeof(id), fold, NULL, NULL, &out) != -EINVAL) return 10;
+    kc_sched_shutdown(g_s);
+
+    opts.workers = 1;
+    g_s = kc_sched_init(&opts); assert(g_s);
+    if (kc_parallel_for(g_s, 0, N, KC_PARALLEL_GRAIN_AUTO, visit, NULL) != 0 || !check_hits(N)) return 11;
+    if (!check_reduce(g_s, 1000)) return 12;
+    kc_sched_shutdown(g_s);
+    free((void *)g_hits);
+    printf("[test] parallel ok\n");
+    return 0;
+}
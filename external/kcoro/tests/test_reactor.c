@@ -0,0 +1,154 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// I/O reactor
+// 1) outside a worker coroutine the waits poll in place (ready, timeout).
+// 2) on two workers, PAIRS coroutines (half on shared stacks) park in
+//    kc_await_readable on socketpairs; one write per pair from an external
+//    thread wakes each, with the workers free for other coroutines meanwhile.
+// 3) a timed wait on a silent fd returns KC_ETIME near its deadline.
+// 4) a writer blocked on a full socket wakes in kc_await_writable once the
+//    peer drains; regular files count as always ready.
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdatomic.h>
+#include <assert.h>
+#include <sys/socket.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_core.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_port.h"
+
+enum { PAIRS = 500 };
+
+static int g_sv[PAIRS][2];
+static _Atomic(int) g_parked, g_woke, g_bad, g_ticks, g_timeout_rc, g_timeout_ms, g_wr_rc, g_file_rc;
+
+static uint64_t now_ms(void){
+    struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+}
+
+static void reader(void *arg){
+    int i = (int)(intptr_t)arg;
+    char c = 0;
+    atomic_fetch_add(&g_parked, 1);
+    for (;;) {
+        ssize_t n = read(g_sv[i][0], &c, 1);
+        if (n == 1) break;
+        if (n < 0 && errno != EAGAIN) { atomic_fetch_add(&g_bad, 1); return; }
+        if (kc_await_readable(g_sv[i][0], 10000) != 0) { atomic_fetch_add(&g_bad, 1); return; }
+    }
+    if (c != (char)('a' + i % 26)) atomic_fetch_add(&g_bad, 1);
+    atomic_fetch_add(&g_woke, 1);
+}
+
+static void ticker(void *arg){
+    (void)arg;
+    while (atomic_load(&g_woke) < PAIRS && atomic_load(&g_ticks) < 100000) { atomic_fetch_add(&g_ticks, 1); kc_sleep_ms(2); }
+}
+
+static void timed(void *arg){
+    int fd = (int)(intptr_t)arg;
+    uint64_t t0 = now_ms();
+    atomic_store(&g_timeout_rc, kc_await_readable(fd, 100));
+    atomic_store(&g_timeout_ms, (int)(now_ms() - t0));
+}
+
+static void writer(void *arg){
+    int fd = (int)(intptr_t)arg;
+    char buf[4096] = {0};
+    int rc = 0;
+    while (write(fd, buf, sizeof buf) > 0) {}
+    if (errno != EAGAIN) rc = -1;
+    else rc = kc_await_writable(fd, 5000);
+    atomic_store(&g_wr_rc, rc == 0 && write(fd, buf, 1) == 1 ? 1 : -1);
+}
+
+static void file_waiter(void *arg){
+    atomic_store(&g_file_rc, kc_await_readable((int)(intptr_t)arg, 1000) == 0 ? 1 : -1);
+}
+
+static int wait_nonzero(_Atomic(int) *v){
+    for (int i = 0; i < 2000 && atomic_load(v) == 0; i++) kc_sleep_ms(5);
+    return atomic_load(v);
+}
+
+static void set_nb(int fd){ fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK); }
+
+int main(void){
+    printf("[test] reactor start\n");
+    int sv[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+    assert(kc_await_writable(sv[0], 0) == 0);
+    assert(kc_await_readable(sv[0], 0) == KC_ETIME);
+    assert(kc_await_readable(sv[0], 20) == KC_ETIME);
+    assert(write(sv[1], "x", 1) == 1);
+    assert(kc_await_readable(sv[0], -1) == 0);
+    assert(kc_await_readable(-1, 0) == -EBADF);
+    close(sv[0]); close(sv[1]);
+
+    kc_sched_opts_t opts = {0};
+    opts.workers = 2;
+    kc_sched_t *s = kc_sched_init(&opts); assert(s);
+    kc_reactor_stats_t r0, r1;
+    kc_reactor_get_stats(&r0);
+
+    for (int i = 0; i < PAIRS; i++) {
+        assert(socketpair(AF_UNIX, SOCK_STREAM, 0, g_sv[i]) == 0);
+        set_nb(g_sv[i][0]);
+    }
+    assert(kc_spawn_co(s, ticker, NULL, 0, NULL) == 0);
+    for (int i = 0; i < PAIRS; i++) {
+        size_t st = (i & 1) ? KCORO_STACK_SHARED : 0;
+        assert(kc_spawn_co(s, reader, (void*)(intptr_t)i, st, NULL) == 0);
+    }
+    for (int i = 0; i < 2000 && atomic_load(&g_parked) < PAIRS; i++) kc_sleep_ms(1);
+    kc_sleep_ms(20);
+    int ticks0 = atomic_load(&g_ticks);
+    kc_sleep_ms(50);
+    if (atomic_load(&g_woke) != 0 || atomic_load(&g_ticks) - ticks0 < 5) {
+        fprintf(stderr, "parked readers: woke=%d ticks=%d\n", atomic_load(&g_woke), atomic_load(&g_ticks) - ticks0); return 1;
+    }
+    for (int i = 0; i < PAIRS; i++) { char c = (char)('a' + i % 26); assert(write(g_sv[i][1], &c, 1) == 1); }
+    for (int i = 0; i < 2000 && atomic_load(&g_woke) + atomic_load(&g_bad) < PAIRS; i++) kc_sleep_ms(5);
+    if (atomic_load(&g_woke) != PAIRS || atomic_load(&g_bad)) {
+        fprintf(stderr, "readers woke=%d bad=%d\n", atomic_load(&g_woke), atomic_load(&g_bad)); return 2;
+    }
+    kc_reactor_get_stats(&r1);
+    if (r1.waits - r0.waits < PAIRS || r1.wakeups - r0.wakeups < PAIRS) {
+        fprintf(stderr, "stats waits=%lu wakeups=%lu\n", r1.waits - r0.waits, r1.wakeups - r0.wakeups); return 3;
+    }
+    for (int i = 0; i < PAIRS; i++) { close(g_sv[i][0]); close(g_sv[i][1]); }
+
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+    set_nb(sv[0]);
+    assert(kc_spawn_co(s, timed, (void*)(intptr_t)sv[0], 0, NULL) == 0);
+    if (wait_nonzero(&g_timeout_rc) != KC_ETIME || atomic_load(&g_timeout_ms) < 95 || atomic_load(&g_timeout_ms) > 1000) {
+        fprintf(stderr, "timeout rc=%d after %dms\n", atomic_load(&g_timeout_rc), atomic_load(&g_timeout_ms)); return 4;
+    }
+
+    assert(kc_spawn_co(s, writer, (void*)(intptr_t)sv[0], 0, NULL) == 0);
+    kc_sleep_ms(50);
+    if (atomic_load(&g_wr_rc) != 0) { fprintf(stderr, "writer did not block: %d\n", atomic_load(&g_wr_rc)); return 5; }
+    char drain[65536];
+    set_nb(sv[1]);
+    for (int i = 0; i < 2000 && atomic_load(&g_wr_rc) == 0; i++)
+        if (read(sv[1], drain, sizeof drain) <= 0) kc_sleep_ms(1);
+    if (wait_nonzero(&g_wr_rc) != 1) { fprintf(stderr, "writer rc=%d\n", atomic_load(&g_wr_rc)); return 6; }
+    close(sv[0]); close(sv[1]);
+
+    char path[64];
+    snprintf(path, sizeof path, "/tmp/kcoro_reactor_%d", (int)getpid());
+    int ffd = open(path, O_CREAT | O_RDWR | O_TRUNC, 0600); assert(ffd >= 0);
+    assert(kc_spawn_co(s, file_waiter, (void*)(intptr_t)ffd, 0, NULL) == 0);
+    if (wait_nonzero(&g_file_rc) != 1) { fprintf(stderr, "regular file not ready\n"); return 7; }
+    close(ffd); unlink(path);
+
+    kc_sched_shutdown(s);
+    printf("[test] reactor ok waits=%lu wakeups=%lu\n", r1.waits - r0.waits, r1.wakeups - r0.wakeups);
+    return 0;
+}
@@ -0,0 +1,85 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Test region placement hints: kc_region_alloc, huge page rounding and
+// alignment, NUMA preference, shared regions and hinted stack-pool stacks
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+#include <errno.h>
+#include <unistd.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_core.h"
+#include "../include/kcoro_config.h"
+
+#define HINTS (KC_REGION_F_HUGEPAGE | KC_REGION_F_NUMA_SET | KC_REGION_F_NUMA(0xff))
+
+static char plain[8192];
+static volatile int deep_done;
+
+static void deep(void *arg)
+{
+    (void)arg;
+    volatile char buf[512 * 1024];
+    memset((char*)buf, 1, sizeof(buf));
+    deep_done = buf[sizeof(buf) - 1];
+}
+
+int main(void)
+{
+    kc_region_t *r = NULL;
+    assert(kc_region_register(&r, plain, sizeof(plain), 1u << 5) == -EINVAL);
+    assert(kc_region_alloc(&r, 0, 0) == -EINVAL);
+
+    /* Plain allocation: zero-filled, owned, no hints */
+    assert(kc_region_alloc(&r, 100, KC_REGION_F_NONE) == 0);
+    size_t len = 0;
+    unsigned char *p = (unsigned char*)kc_region_addr(r, &len);
+    assert(p && len == 100 && p[99] == 0 && kc_region_flags(r) == 0);
+    assert(kc_region_fd(r) == -ENOTSUP);
+    memset(p, 7, len);
+    assert(kc_region_deregister(r) == 0);
+
+    /* Huge pages: whole, aligned huge pages whichever kind backs them */
+    assert(kc_region_alloc(&r, 100, KC_REGION_F_HUGEPAGE | KC_REGION_F_NUMA(0)) == 0);
+    p = (unsigned char*)kc_region_addr(r, &len);
+    assert(len == KCORO_HUGEPAGE_SIZE && ((uintptr_t)p & (KCORO_HUGEPAGE_SIZE - 1)) == 0);
+    memset(p, 1, len);
+    unsigned got = kc_region_flags(r);
+    assert((got & ~HINTS) == 0);
+    if (got & KC_REGION_F_NUMA_SET) assert(KC_REGION_F_NUMA_NODE(got) == 0);
+    assert(kc_region_deregister(r) == 0);
+
+    /* A node that does not exist is dropped, not an error */
+    assert(kc_region_alloc(&r, 4096, KC_REGION_F_NUMA(200)) == 0);
+    assert(!(kc_region_flags(r) & KC_REGION_F_NUMA_SET));
+    assert(kc_region_deregister(r) == 0);
+
+    /* Caller memory takes hints in place */
+    assert(kc_region_register(&r, plain, sizeof(plain), KC_REGION_F_NUMA(0)) == 0);
+    assert((kc_region_flags(r) & ~HINTS) == 0);
+    assert(kc_region_deregister(r) == 0);
+
+    /* Shared: rounded so an importer maps whole huge pages too */
+    assert(kc_region_create_shared_ex(&r, 5000, KC_REGION_F_HUGEPAGE) == 0);
+    p = (unsigned char*)kc_region_addr(r, &len);
+    assert(len == KCORO_HUGEPAGE_SIZE);
+    p[len - 1] = 9;
+    int fd = dup(kc_region_fd(r));
+    assert(fd >= 0);
+    assert(kc_region_deregister(r) == 0);
+    kc_region_t *imp = NULL;
+    assert(kc_region_import(&imp, fd, len) == 0);
+    assert(((unsigned char*)kc_region_addr(imp, NULL))[len - 1] == 9);
+    assert(kc_region_deregister(imp) == 0);
+
+    /* Hinted stacks: a huge-page-sized stack runs deep and is pooled */
+    kcoro_stack_pool_set_hints(KC_REGION_F_HUGEPAGE | KC_REGION_F_NUMA(0));
+    assert(kc_spawn_co(kc_sched_default(), deep, NULL, KCORO_HUGEPAGE_SIZE, NULL) == 0);
+    for (int i = 0; i < 2000 && !deep_done; i++) usleep(1000);
+    assert(deep_done == 1);
+    kcoro_stack_pool_set_hints(0);
+    printf("[region hints] ok flags=%#x\n", got);
+    return 0;
+}
@@ -0,0 +1,146 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Test in-flight region references: queued zref descriptors hold their
+// region, deregister waits for them, retire leaves the teardown to the last
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_zcopy.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_core.h"
+
+static char plain[8192];
+
+struct ctx {
+    kc_chan_t *buf, *conf;
+    char *shared;
+    volatile int stage, done;
+    int rc_send, rc_recv, rc_conf;
+    kc_zdesc_t got;
+};
+
+static void wait_stage(struct ctx *c, int s)
+{
+    while (c->stage < s) kc_sleep_ms(1);
+}
+
+static void runner(void *arg)
+{
+    struct ctx *c = (struct ctx*)arg;
+    /* 1: a descriptor into plain[] sits in the channel while main deregisters */
+    kc_zdesc_t d = { .addr = plain + 100, .len = 50 };
+    c->rc_send = kc_chan_send_desc(c->buf, &d, 0);
+    c->done = 1;
+    wait_stage(c, 1);
+    c->rc_recv = kc_chan_recv_desc(c->buf, &c->got, 0);
+    c->done = 2;
+
+    /* 2: into a shared region main retires before it is received */
+    wait_stage(c, 2);
+    kc_zdesc_t s = { .addr = c->shared, .len = 8 };
+    c->rc_send = kc_chan_send_desc(c->buf, &s, 0);
+    c->done = 3;
+    wait_stage(c, 3);
+    c->rc_recv = kc_chan_recv_desc(c->buf, &c->got, 0);
+    c->done = 4;
+
+    /* 3: conflated drops the value it replaces; one left for destroy */
+    wait_stage(c, 4);
+    kc_zdesc_t a = { .addr = plain, .len = 10 }, b = { .addr = plain + 10, .len = 10 };
+    c->rc_conf = kc_chan_send_desc(c->conf, &a, 0);
+    if (c->rc_conf == 0) c->rc_conf = kc_chan_send_desc(c->conf, &b, 0);
+    if (c->rc_conf == 0) c->rc_conf = kc_chan_send_desc(c->buf, &a, 0);
+    c->done = 5;
+}
+
+struct dereg { kc_region_t *reg; volatile int done; int rc; };
+
+static void *dereg_thread(void *arg)
+{
+    struct dereg *g = (struct dereg*)arg;
+    g->rc = kc_region_deregister(g->reg);
+    g->done = 1;
+    return NULL;
+}
+
+static void wait_done(struct ctx *c, int v)
+{
+    for (int i = 0; i < 2000 && c->done < v; i++) usleep(1000);
+    assert(c->done >= v);
+}
+
+int main(void)
+{
+    struct ctx c = { 0 };
+    int rc = kc_chan_make_ptr(&c.buf, KC_BUFFERED, 4);
+    assert(rc == 0);
+    rc = kc_chan_enable_zero_copy_backend(c.buf, kc_zcopy_resolve("zref"), NULL);
+    assert(rc == 0);
+    rc = kc_chan_make_ptr(&c.conf, KC_CONFLATED, 1);
+    assert(rc == 0);
+    rc = kc_chan_enable_zero_copy_backend(c.conf, kc_zcopy_resolve("zref"), NULL);
+    assert(rc == 0);
+
+    kc_region_t *pr = NULL;
+    rc = kc_region_register(&pr, plain, sizeof(plain), KC_REGION_F_NONE);
+    assert(rc == 0);
+    unsigned long id = 0;
+    (void)kc_region_export_id(pr, &id);
+    assert(id != 0 && kc_region_get(id) == pr);
+    kc_region_put(pr);
+
+    rc = kc_spawn_co(kc_sched_default(), runner, &c, 0, NULL);
+    assert(rc == 0);
+    wait_done(&c, 1);
+    assert(c.rc_send == 0);
+
+    /* Deregister blocks on the queued descriptor but stops lookups at once */
+    struct dereg g = { .reg = pr };
+    pthread_t th;
+    rc = pthread_create(&th, NULL, dereg_thread, &g);
+    assert(rc == 0);
+    usleep(50000);
+    assert(!g.done);
+    assert(kc_region_get(id) == NULL);
+    assert(kc_region_deregister(pr) == -ENOENT);
+    c.stage = 1;
+    wait_done(&c, 2);
+    pthread_join(th, NULL);
+    assert(g.done && g.rc == 0);
+    assert(c.rc_recv == 0 && c.got.addr == plain + 100 && c.got.len == 50);
+
+    /* Retire returns at once; the mapping lasts until the descriptor is taken */
+    kc_region_t *sr = NULL;
+    rc = kc_region_create_shared(&sr, 4096);
+    assert(rc == 0);
+    c.shared = (char*)kc_region_addr(sr, NULL);
+    int fd = kc_region_fd(sr);
+    c.stage = 2;
+    wait_done(&c, 3);
+    assert(c.rc_send == 0);
+    (void)kc_region_export_id(sr, &id);
+    assert(kc_region_retire(sr) == 0);
+    assert(kc_region_get(id) == NULL);
+    assert(fcntl(fd, F_GETFD) >= 0);
+    c.stage = 3;
+    wait_done(&c, 4);
+    assert(c.rc_recv == 0 && c.got.addr == c.shared && c.got.len == 8);
+    assert(fcntl(fd, F_GETFD) == -1 && errno == EBADF);
+
+    /* Overwritten and destroyed descriptors give their references back */
+    rc = kc_region_register(&pr, plain, sizeof(plain), KC_REGION_F_NONE);
+    assert(rc == 0);
+    c.stage = 4;
+    wait_done(&c, 5);
+    assert(c.rc_conf == 0);
+    kc_chan_destroy(c.conf);
+    kc_chan_destroy(c.buf);
+    assert(kc_region_deregister(pr) == 0);
+    printf("[region inflight] ok\n");
+    return 0;
+}
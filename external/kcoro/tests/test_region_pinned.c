@@ -0,0 +1,155 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Test pinned regions: KC_REGION_F_PINNED locks and unlocks the range,
+// registration hooks see pinned regions only, keep per-region data, hear
+// about teardown after the region drains, and can refuse a registration
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+#include <errno.h>
+#include <unistd.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_config.h"
+
+/* VmLck from /proc/self/status in kB, -1 where there is none */
+static long locked_kb(void)
+{
+    FILE *f = fopen("/proc/self/status", "r");
+    if (!f) return -1;
+    char line[256];
+    long kb = -1;
+    while (fgets(line, sizeof(line), f))
+        if (sscanf(line, "VmLck: %ld", &kb) == 1) break;
+    fclose(f);
+    return kb;
+}
+
+struct dev {
+    int regs, deregs;
+    int refuse;           /* on_register result */
+    void *last;           /* region seen last */
+    void *data_back;      /* data on_deregister got */
+    int order;            /* deregs seen by the other hook before ours */
+};
+
+static int g_seq;
+
+static int dev_register(void *arg, kc_region_t *reg, void **data)
+{
+    struct dev *d = (struct dev*)arg;
+    if (d->refuse) return d->refuse;
+    d->regs++;
+    d->last = reg;
+    *data = d;
+    return 0;
+}
+
+static void dev_deregister(void *arg, kc_region_t *reg, void *data)
+{
+    struct dev *d = (struct dev*)arg;
+    size_t len = 0;
+    /* Still mapped and readable here */
+    assert(kc_region_addr(reg, &len) && len > 0);
+    d->deregs++;
+    d->last = reg;
+    d->data_back = data;
+    d->order = ++g_seq;
+}
+
+static const kc_region_hooks_t dev_hooks = { dev_register, dev_deregister };
+
+int main(void)
+{
+    long ps = sysconf(_SC_PAGESIZE);
+    size_t len = 4 * (size_t)ps;
+    unsigned char *buf = NULL;
+    assert(posix_memalign((void**)&buf, (size_t)ps, len) == 0);
+    kc_region_t *r = NULL;
+
+    /* Caller memory must sit on page boundaries */
+    assert(kc_region_register(&r, buf + 1, (size_t)ps, KC_REGION_F_PINNED) == -EINVAL);
+    assert(kc_region_register(&r, buf, (size_t)ps + 1, KC_REGION_F_PINNED) == -EINVAL);
+
+    long before = locked_kb();
+    int rc = kc_region_register(&r, buf, len, KC_REGION_F_PINNED);
+    if (rc == -ENOMEM || rc == -EPERM) {
+        printf("[region pinned] skipped: mlock refused (%d)\n", rc);
+        free(buf);
+        return 0;
+    }
+    assert(rc == 0 && kc_region_flags(r) == KC_REGION_F_PINNED);
+    if (before >= 0) assert(locked_kb() >= before + (long)(len / 1024));
+    assert(kc_region_deregister(r) == 0);
+    if (before >= 0) assert(locked_kb() == before);
+
+    /* Hooks: pinned regions only, data kept per region and hook */
+    struct dev a = { 0 }, b = { 0 };
+    int ha = kc_region_hooks_add(&dev_hooks, &a);
+    int hb = kc_region_hooks_add(&dev_hooks, &b);
+    assert(ha >= 0 && hb >= 0 && ha != hb);
+    assert(kc_region_hooks_add(NULL, &a) == -EINVAL);
+
+    assert(kc_region_alloc(&r, len, KC_REGION_F_NONE) == 0);
+    assert(a.regs == 0 && b.regs == 0);
+    assert(kc_region_hook_data(r, ha) == NULL);
+    assert(kc_region_deregister(r) == 0 && a.deregs == 0);
+
+    assert(kc_region_alloc(&r, len, KC_REGION_F_PINNED) == 0);
+    assert(kc_region_flags(r) & KC_REGION_F_PINNED);
+    assert(a.regs == 1 && b.regs == 1 && a.last == r);
+    assert(kc_region_hook_data(r, ha) == &a && kc_region_hook_data(r, hb) == &b);
+    assert(kc_region_hook_data(r, KCORO_REGION_HOOKS_MAX) == NULL);
+
+    /* Retired while referenced: the hooks hear about it at the last reference */
+    unsigned long id = 0;
+    assert(kc_region_export_id(r, &id) == 0);
+    kc_region_t *held = kc_region_get(id);
+    assert(held == r);
+    assert(kc_region_retire(r) == 0);
+    assert(a.deregs == 0 && b.deregs == 0);
+    kc_region_put(held);
+    assert(a.deregs == 1 && b.deregs == 1 && a.data_back == &a && b.data_back == &b);
+    /* Reverse order of registration */
+    assert((ha < hb) == (b.order < a.order));
+
+    /* A refusal fails the registration; hooks that accepted hear it undone */
+    b.refuse = -EIO;
+    assert(kc_region_register(&r, buf, len, KC_REGION_F_PINNED) == -EIO);
+    assert(r == NULL);
+    int first_refuses = hb < ha;
+    assert(a.regs == (first_refuses ? 1 : 2) && a.deregs == (first_refuses ? 1 : 2));
+    if (before >= 0) assert(locked_kb() == before);
+    /* The range is free again */
+    b.refuse = 0;
+    assert(kc_region_register(&r, buf, len, KC_REGION_F_PINNED) == 0);
+    assert(kc_region_deregister(r) == 0);
+
+    /* Shared memory pins too */
+    assert(kc_region_create_shared_ex(&r, len, KC_REGION_F_PINNED) == 0);
+    assert(kc_region_flags(r) & KC_REGION_F_PINNED);
+    int regs = a.regs;
+    assert(kc_region_deregister(r) == 0 && a.deregs == regs);
+
+    /* Removed hooks hear nothing more */
+    assert(kc_region_hooks_remove(hb) == 0);
+    assert(kc_region_hooks_remove(hb) == -ENOENT);
+    assert(kc_region_hooks_remove(-1) == -ENOENT);
+    int bregs = b.regs;
+    assert(kc_region_alloc(&r, len, KC_REGION_F_PINNED) == 0);
+    assert(b.regs == bregs && a.regs == regs + 1);
+    assert(kc_region_hook_data(r, hb) == NULL);
+    assert(kc_region_deregister(r) == 0);
+    assert(kc_region_hooks_remove(ha) == 0);
+
+    /* The table is bounded */
+    int ids[KCORO_REGION_HOOKS_MAX];
+    for (int i = 0; i < KCORO_REGION_HOOKS_MAX; i++) assert((ids[i] = kc_region_hooks_add(&dev_hooks, &a)) >= 0);
+    assert(kc_region_hooks_add(&dev_hooks, &a) == -ENOSPC);
+    for (int i = 0; i < KCORO_REGION_HOOKS_MAX; i++) assert(kc_region_hooks_remove(ids[i]) == 0);
+
+    if (before >= 0) assert(locked_kb() == before);
+    free(buf);
+    printf("[region pinned] ok\n");
+    return 0;
+}
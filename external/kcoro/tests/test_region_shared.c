@@ -0,0 +1,95 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Test shared regions: memfd mappings, import of their descriptor, and
+// descriptors that name a payload by (region_id, offset)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <unistd.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_zcopy.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_core.h"
+
+struct ctx { kc_chan_t *ch; kc_region_t *reg; volatile int done; int rc_send, rc_recv, rc_bad; kc_zdesc_t got; };
+
+static void runner(void *arg)
+{
+    struct ctx *c = (struct ctx*)arg;
+    unsigned long id = 0;
+    (void)kc_region_export_id(c->reg, &id);
+    /* By region and offset, no address */
+    kc_zdesc_t d = { .addr = NULL, .len = 100, .region_id = id, .offset = 4096 };
+    c->rc_send = kc_chan_send_desc(c->ch, &d, 0);
+    /* Past the region's end */
+    kc_zdesc_t bad = { .addr = NULL, .len = 8192, .region_id = id, .offset = 4096 };
+    c->rc_bad = kc_chan_send_desc(c->ch, &bad, 0);
+    c->got.flags = KC_ZDESC_F_REGION;
+    c->rc_recv = kc_chan_recv_desc(c->ch, &c->got, 0);
+    c->done = 1;
+}
+
+int main(void)
+{
+    kc_region_t *reg = NULL;
+    int rc = kc_region_create_shared(&reg, 8192);
+    assert(rc == 0 && reg);
+    int fd = kc_region_fd(reg);
+    assert(fd >= 0);
+    size_t len = 0;
+    char *a = (char*)kc_region_addr(reg, &len);
+    assert(a && len == 8192);
+
+    /* A second mapping of the same memory, as a peer process would get */
+    kc_region_t *imp = NULL;
+    int fd2 = dup(fd);
+    assert(fd2 >= 0);
+    rc = kc_region_import(&imp, fd2, 8192);
+    assert(rc == 0 && imp);
+    char *b = (char*)kc_region_addr(imp, NULL);
+    assert(b && b != a);
+    strcpy(a + 4096, "shared");
+    assert(strcmp(b + 4096, "shared") == 0);
+
+    /* Plain registrations have no descriptor */
+    static char plain[4096];
+    kc_region_t *pr = NULL;
+    rc = kc_region_register(&pr, plain, sizeof(plain), KC_REGION_F_NONE);
+    assert(rc == 0);
+    assert(kc_region_fd(pr) == -ENOTSUP);
+
+    /* Lookup by ID holds the region until put */
+    unsigned long id = 0;
+    (void)kc_region_export_id(imp, &id);
+    kc_region_t *held = kc_region_get(id);
+    assert(held == imp);
+    kc_region_put(held);
+    assert(kc_region_get(0) == NULL);
+
+    kc_chan_t *ch = NULL;
+    rc = kc_chan_make_ptr(&ch, KC_BUFFERED, 4);
+    assert(rc == 0);
+    rc = kc_chan_enable_zero_copy_backend(ch, kc_zcopy_resolve("zref"), NULL);
+    assert(rc == 0);
+    struct ctx c = { .ch = ch, .reg = imp };
+    rc = kc_spawn_co(kc_sched_default(), runner, &c, 0, NULL);
+    assert(rc == 0);
+    for (int i = 0; i < 2000 && !c.done; i++) usleep(1000);
+    assert(c.done);
+    assert(c.rc_send == 0);
+    assert(c.rc_bad == -EINVAL);
+    assert(c.rc_recv == 0);
+    assert(c.got.addr == b + 4096 && c.got.len == 100);
+    assert(c.got.region_id == id && c.got.offset == 4096);
+    assert(strcmp((char*)c.got.addr, "shared") == 0);
+
+    assert(kc_region_deregister(imp) == 0);
+    assert(kc_region_deregister(pr) == 0);
+    assert(kc_region_deregister(reg) == 0);
+    /* Both mappings are gone; the descriptor closed with its region */
+    assert(kc_region_get(id) == NULL);
+    kc_chan_destroy(ch);
+    printf("[region shared] ok\n");
+    return 0;
+}
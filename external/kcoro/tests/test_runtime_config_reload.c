@@ -0,0 +1,118 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Hot-reloaded runtime configuration
+// 1) watchers see every load with a new generation, cannot reload from the
+//    callback, and are not called after kc_runtime_config_unwatch.
+// 2) a running scheduler follows "scheduler" min_workers on reload and
+//    shrinks; one that set min_workers in its opts keeps it.
+// 3) "stack" limits (and autotune) apply on reload and revert once the file
+//    drops them;
+//    channel.flow_batch / flow_capacity and the new scheduler keys parse.
+#include <stdio.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <assert.h>
+#include <unistd.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_config_runtime.h"
+
+static char g_path[64];
+static _Atomic(int) g_calls;
+static unsigned long g_gen;
+static int g_nested_rc;
+
+static void write_config(const char *json){
+    FILE *f = fopen(g_path, "w"); assert(f);
+    fputs(json, f);
+    fclose(f);
+    assert(kc_runtime_config_reload(g_path) == 0);
+}
+
+static void on_reload(void *arg, const struct kc_runtime_config *cfg){
+    assert(arg == &g_calls);
+    g_gen = cfg->generation;
+    g_nested_rc = kc_runtime_config_reload(g_path);
+    atomic_fetch_add(&g_calls, 1);
+}
+
+static unsigned long active(kc_sched_t *s){
+    kc_sched_stats_t st; kc_sched_get_stats(s, &st); return st.workers_active;
+}
+
+static void noop(void *arg){ (void)arg; }
+
+static void watchers(void){
+    unsigned long gen = kc_runtime_config_get()->generation;
+    assert(kc_runtime_config_watch(NULL, NULL) == -EINVAL);
+    assert(kc_runtime_config_watch(on_reload, &g_calls) == 0);
+    write_config("{}");
+    assert(atomic_load(&g_calls) == 1 && g_gen == gen + 1 && g_nested_rc == -EALREADY);
+    write_config("{ \"scheduler\": {\"park_spin\": 8} }");
+    assert(atomic_load(&g_calls) == 2 && g_gen == gen + 2);
+    struct kc_runtime_config snap;
+    kc_runtime_config_snapshot(&snap);
+    assert(snap.generation == gen + 2 && snap.sched_park_spin == 8);
+    assert(kc_runtime_config_unwatch(on_reload, &g_calls) == 0);
+    assert(kc_runtime_config_unwatch(on_reload, &g_calls) == -ENOENT);
+    write_config("{}");
+    assert(atomic_load(&g_calls) == 2);
+}
+
+static void live_sched(void){
+    write_config("{ \"scheduler\": {\"scale_down_ms\": 20} }");
+    kc_sched_opts_t opts = {0};
+    opts.workers = 3;
+    kc_sched_t *follow = kc_sched_init(&opts); assert(follow);
+    opts.min_workers = 2;
+    kc_sched_t *pinned = kc_sched_init(&opts); assert(pinned);
+    /* the config has no min_workers yet: follow keeps its 3 workers */
+    for (int i = 0; i < 200 && active(pinned) > 2; i++) kc_sleep_ms(10);
+    assert(active(follow) == 3 && active(pinned) == 2);
+
+    write_config("{ \"scheduler\": {\"min_workers\": 1, \"scale_down_ms\": 20,"
+                 " \"steal_scan\": 2, \"bulk_share\": 4} }");
+    for (int i = 0; i < 200 && active(follow) > 1; i++) kc_sleep_ms(10);
+    if (active(follow) != 1) { fprintf(stderr, "reload min ignored: %lu\n", active(follow)); assert(0); }
+    assert(active(pinned) == 2);
+    /* still runs work after shrinking under the new knobs */
+    for (int i = 0; i < 64; i++) assert(kc_spawn(follow, noop, NULL) == 0);
+    kc_sleep_ms(20);
+    kc_sched_shutdown(pinned);
+    kc_sched_shutdown(follow);
+}
+
+static void cycle_stack(void){
+    kcoro_t *co = kcoro_create(noop, NULL, 0); assert(co);
+    kcoro_destroy(co);
+}
+
+static void stack_and_parse(void){
+    struct kcoro_stack_pool_stats st;
+    write_config("{ \"stack\": {\"cache_per_thread\": 0, \"depot_max\": 0, \"autotune\": 1},"
+                 "  \"channel\": {\"flow_batch\": 16, \"flow_capacity\": 32} }");
+    kcoro_stack_pool_trim();
+    cycle_stack();
+    kcoro_stack_pool_get_stats(&st);
+    assert(st.thread_stacks == 0 && st.depot_stacks == 0);
+    const struct kc_runtime_config *cfg = kc_runtime_config_get();
+    assert(cfg->chan_flow_batch == 16 && cfg->chan_flow_capacity == 32);
+    assert(cfg->stack_cache_per_thread == 0 && cfg->stack_default_size == -1 && cfg->stack_autotune == 1);
+
+    write_config("{}");
+    cycle_stack();
+    kcoro_stack_pool_get_stats(&st);
+    assert(st.thread_stacks == 1);
+    kcoro_stack_pool_trim();
+}
+
+int main(void){
+    printf("[test] runtime_config_reload start\n");
+    snprintf(g_path, sizeof g_path, "/tmp/kcoro_cfg_reload_%d.json", (int)getpid());
+    watchers();
+    live_sched();
+    stack_and_parse();
+    remove(g_path);
+    assert(kc_runtime_config_reload("/nonexistent/kcoro_config.json") == 0);
+    printf("[test] runtime_config_reload ok gen=%lu\n", kc_runtime_config_get()->generation);
+    return 0;
+}
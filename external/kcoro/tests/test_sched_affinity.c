@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Worker placement
+// 1) KC_SCHED_PLACE_PIN keeps every worker (and the tasks it runs) on its CPU;
+//    workers <= 0 starts one worker per CPU of the set.
+// 2) NUMA grouping reports each worker's node and steals run node-first.
+// 3) bad CPU sets / flags fail kc_sched_init with EINVAL.
+// 4) the default scheduler and dispatchers take placement options.
+#define _GNU_SOURCE 1
+#include <stdio.h>
+#include <stdint.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_dispatch.h"
+#include "../include/kcoro_port.h"
+
+enum { TASKS = 2000 };
+
+static int g_cpu;
+static _Atomic(int) g_done, g_misplaced;
+
+static void where(void *arg){
+    (void)arg;
+    cpu_set_t set;
+    if (sched_getcpu() != g_cpu ||
+        pthread_getaffinity_np(pthread_self(), sizeof set, &set) != 0 ||
+        CPU_COUNT(&set) != 1 || !CPU_ISSET(g_cpu, &set))
+        atomic_fetch_add(&g_misplaced, 1);
+    atomic_fetch_add(&g_done, 1);
+}
+
+static int run_where(kc_sched_t *s, int n){
+    atomic_store(&g_done, 0);
+    atomic_store(&g_misplaced, 0);
+    for (int i = 0; i < n; i++) assert(kc_spawn(s, where, NULL) == 0);
+    for (int i = 0; i < 2000 && atomic_load(&g_done) < n; i++) kc_sleep_ms(5);
+    return atomic_load(&g_done) == n && atomic_load(&g_misplaced) == 0;
+}
+
+int main(void){
+    printf("[test] sched_affinity start\n");
+    cpu_set_t allowed;
+    assert(sched_getaffinity(0, sizeof allowed, &allowed) == 0);
+    g_cpu = -1;
+    for (int c = 0; c < CPU_SETSIZE && g_cpu < 0; c++) if (CPU_ISSET(c, &allowed)) g_cpu = c;
+    assert(g_cpu >= 0);
+
+    kc_sched_opts_t opts = {0};
+    opts.cpus = &g_cpu; opts.ncpus = 1;
+    opts.placement = KC_SCHED_PLACE_PIN;
+    kc_sched_t *s = kc_sched_init(&opts); assert(s);
+    if (kc_sched_worker_node(s, 0) != 0 || kc_sched_worker_node(s, 1) != -1) {
+        fprintf(stderr, "default worker count for one CPU is not 1\n"); return 1;
+    }
+    if (!run_where(s, TASKS)) { fprintf(stderr, "pinned: done=%d misplaced=%d\n", atomic_load(&g_done), atomic_load(&g_misplaced)); return 2; }
+    kc_sched_shutdown(s);
+
+    opts.workers = 4;
+    opts.placement = KC_SCHED_PLACE_PIN | KC_SCHED_PLACE_NUMA;
+    s = kc_sched_init(&opts); assert(s);
+    int node = kc_sched_worker_node(s, 0);
+    for (int i = 1; i < 4; i++)
+        if (kc_sched_worker_node(s, i) != node) { fprintf(stderr, "worker %d node differs\n", i); return 3; }
+    if (!run_where(s, TASKS)) { fprintf(stderr, "numa: done=%d misplaced=%d\n", atomic_load(&g_done), atomic_load(&g_misplaced)); return 4; }
+    kc_sched_stats_t st;
+    kc_sched_get_stats(s, &st);
+    if (st.steals_remote != 0) { fprintf(stderr, "remote steals on one node: %lu\n", st.steals_remote); return 5; }
+    kc_sched_shutdown(s);
+
+    int bad = -1;
+    kc_sched_opts_t bo = {0};
+    bo.cpus = &bad; bo.ncpus = 1;
+    errno = 0;
+    if (kc_sched_init(&bo) != NULL || errno != EINVAL) { fprintf(stderr, "bad cpu accepted\n"); return 6; }
+    bo.cpus = NULL; bo.placement = 0x80;
+    errno = 0;
+    if (kc_sched_init(&bo) != NULL || errno != EINVAL) { fprintf(stderr, "bad flags accepted\n"); return 7; }
+
+    opts.workers = 2;
+    opts.placement = KC_SCHED_PLACE_PIN;
+    assert(kc_sched_set_default_opts(&opts) == 0);
+    kc_dispatcher_t *d = kc_dispatcher_default(); assert(d);
+    if (!run_where(kc_dispatcher_scheduler(d), TASKS)) { fprintf(stderr, "default sched not pinned\n"); return 8; }
+    if (kc_sched_set_default_opts(NULL) != -EBUSY) { fprintf(stderr, "late default opts accepted\n"); return 9; }
+    kc_dispatcher_release(d);
+
+    kc_dispatcher_t *pd = kc_dispatcher_new_opts(&opts); assert(pd);
+    if (!run_where(kc_dispatcher_scheduler(pd), TASKS)) { fprintf(stderr, "dispatcher not pinned\n"); return 10; }
+    kc_dispatcher_release(pd);
+
+    printf("[test] sched_affinity ok cpu=%d node=%d\n", g_cpu, node);
+    return 0;
+}
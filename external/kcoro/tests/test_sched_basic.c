@@ -39,6 +39,6 @@ int main(void){
 
     // Shutdown the scheduler and report results
     kc_sched_shutdown(s);
-    printf("[sched] basic test passed: %d tasks executed, probes=%lu succ=%lu fail=%lu fast_hits=%lu fast_miss=%lu\n", N, st.steals_probes, st.steals_succeeded, st.steals_failures, st.fastpath_hits, st.fastpath_misses);
+    printf("[sched] basic test passed: %d tasks executed, probes=%lu succ=%lu fail=%lu cas_fail=%lu fast_hits=%lu fast_miss=%lu\n", N, st.steals_probes, st.steals_succeeded, st.steals_failures, st.steals_cas_failures, st.fastpath_hits, st.fastpath_misses);
     return 0;
 }
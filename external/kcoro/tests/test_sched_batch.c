@@ -0,0 +1,96 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Batch spawn
+// 1) kc_spawn_batch from an external thread: every task runs exactly once.
+// 2) from a worker coroutine, kc_spawn_batch and kc_spawn_co_batch fan out
+//    10k tasks / 5k coroutines; a prefix stays local, the overflow is
+//    donated, and all of them run.
+// 3) a NULL entry rejects the whole batch; out_cos hands back live handles.
+#include <stdio.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <assert.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_core.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_port.h"
+
+enum { TASKS = 10000, COROS = 5000 };
+
+static _Atomic(long) g_task_sum;
+static _Atomic(int) g_tasks, g_coros, g_fanned;
+static kc_task_fn g_task_fns[TASKS];
+static kcoro_fn_t g_co_fns[COROS];
+static void *g_args[TASKS];
+static kcoro_t *g_handles[COROS];
+
+static void task(void *arg){
+    atomic_fetch_add(&g_task_sum, (long)(intptr_t)arg);
+    atomic_fetch_add(&g_tasks, 1);
+}
+
+static void coro(void *arg){
+    (void)arg;
+    kc_yield();
+    atomic_fetch_add(&g_coros, 1);
+}
+
+static void fan_out(void *arg){
+    kc_sched_t *s = (kc_sched_t*)arg;
+    assert(kc_spawn_batch(s, g_task_fns, g_args, TASKS) == 0);
+    assert(kc_spawn_co_batch(s, g_co_fns, g_args, COROS, 0, NULL) == 0);
+    atomic_store(&g_fanned, 1);
+}
+
+static int wait_for(_Atomic(int) *v, int want){
+    for (int i = 0; i < 2000 && atomic_load(v) < want; i++) kc_sleep_ms(5);
+    return atomic_load(v) >= want;
+}
+
+int main(void){
+    printf("[test] sched_batch start\n");
+    for (int i = 0; i < TASKS; i++) { g_task_fns[i] = task; g_args[i] = (void*)(intptr_t)(i + 1); }
+    for (int i = 0; i < COROS; i++) g_co_fns[i] = coro;
+    const long want_sum = (long)TASKS * (TASKS + 1) / 2;
+
+    kc_sched_opts_t opts = {0};
+    opts.workers = 4;
+    kc_sched_t *s = kc_sched_init(&opts); assert(s);
+    kc_sched_stats_t st0, st;
+    kc_sched_get_stats(s, &st0);
+
+    assert(kc_spawn_batch(s, g_task_fns, g_args, TASKS) == 0);
+    if (!wait_for(&g_tasks, TASKS) || atomic_load(&g_task_sum) != want_sum) {
+        fprintf(stderr, "external batch tasks=%d sum=%ld\n", atomic_load(&g_tasks), atomic_load(&g_task_sum)); return 1;
+    }
+
+    atomic_store(&g_tasks, 0); atomic_store(&g_task_sum, 0);
+    assert(kc_spawn_co(s, fan_out, s, 0, NULL) == 0);
+    if (!wait_for(&g_fanned, 1) || !wait_for(&g_tasks, TASKS) || !wait_for(&g_coros, COROS)) {
+        fprintf(stderr, "worker batch tasks=%d coros=%d\n", atomic_load(&g_tasks), atomic_load(&g_coros)); return 2;
+    }
+    if (atomic_load(&g_task_sum) != want_sum) { fprintf(stderr, "worker batch sum=%ld\n", atomic_load(&g_task_sum)); return 3; }
+    kc_sched_get_stats(s, &st);
+    if (st.tasks_submitted - st0.tasks_submitted != 2 * TASKS || st.donations == st0.donations) {
+        fprintf(stderr, "submitted=%lu donations=%lu\n", st.tasks_submitted - st0.tasks_submitted,
+                st.donations - st0.donations); return 4;
+    }
+
+    g_co_fns[7] = NULL;
+    assert(kc_spawn_co_batch(s, g_co_fns, g_args, COROS, 0, NULL) == -1);
+    g_task_fns[7] = NULL;
+    assert(kc_spawn_batch(s, g_task_fns, g_args, TASKS) == -1);
+    g_co_fns[7] = coro;
+    atomic_store(&g_coros, 0);
+    assert(kc_spawn_co_batch(s, g_co_fns, g_args, 64, KCORO_STACK_SHARED, g_handles) == 0);
+    if (!wait_for(&g_coros, 64)) { fprintf(stderr, "out_cos batch coros=%d\n", atomic_load(&g_coros)); return 5; }
+    for (int i = 0; i < 64; i++) {
+        for (int k = 0; k < 1000 && g_handles[i] && g_handles[i]->state != KCORO_FINISHED; k++) kc_sleep_ms(1);
+        if (!g_handles[i] || g_handles[i]->state != KCORO_FINISHED) { fprintf(stderr, "handle %d not finished\n", i); return 6; }
+        kcoro_release(g_handles[i]);
+    }
+    if (atomic_load(&g_tasks) != TASKS) { fprintf(stderr, "rejected batch ran tasks\n"); return 7; }
+
+    kc_sched_shutdown(s);
+    printf("[test] sched_batch ok tasks=%d coros=%d\n", TASKS, COROS);
+    return 0;
+}
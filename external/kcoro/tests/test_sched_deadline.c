@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Deadline (EDF) class
+// 1) one worker: coroutines spawned with deadlines run earliest deadline
+//    first and ahead of plain coroutines spawned before them.
+// 2) finishing after the deadline counts as a miss, before it does not.
+// 3) two workers: an idle worker steals the deadline coroutines queued on a
+//    busy one.
+#include <stdio.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <assert.h>
+#include <time.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_sched.h"
+
+enum { N = 6 };
+
+static _Atomic(int) g_seq, g_done;
+static int g_order[2 * N];
+
+static unsigned long long now_ns(void){
+    struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ull + (unsigned long long)ts.tv_nsec;
+}
+
+static void record(void *arg){
+    g_order[atomic_fetch_add(&g_seq, 1)] = (int)(intptr_t)arg;
+    atomic_fetch_add(&g_done, 1);
+}
+
+static void wait_done(int want){
+    for (int i = 0; i < 1000 && atomic_load(&g_done) < want; i++) kc_sleep_ms(2);
+    assert(atomic_load(&g_done) == want);
+}
+
+/* Holds the only worker while it spawns, so nothing runs until it returns. */
+static void edf_root(void *arg){
+    kc_sched_t *s = (kc_sched_t*)arg;
+    unsigned long long base = now_ns() + 10ull * 1000000000ull;
+    for (int i = 0; i < N; i++)
+        assert(kc_spawn_co(s, record, (void*)(intptr_t)(100 + i), 0, NULL) == 0);
+    /* ids 0..N-1 get deadlines in reverse spawn order: N-1 is most urgent */
+    for (int i = 0; i < N; i++)
+        assert(kc_spawn_co_deadline(s, record, (void*)(intptr_t)i, 0, NULL,
+                                    base + (unsigned long long)(N - i) * 1000000ull) == 0);
+}
+
+static void late(void *arg){ (void)arg; atomic_fetch_add(&g_done, 1); }
+
+static void busy_root(void *arg){
+    kc_sched_t *s = (kc_sched_t*)arg;
+    unsigned long long far = now_ns() + 10ull * 1000000000ull;
+    for (int i = 0; i < N; i++)
+        assert(kc_spawn_co_deadline(s, late, NULL, 0, NULL, far) == 0);
+    /* keep this worker busy so the other one has to steal */
+    unsigned long long end = now_ns() + 200ull * 1000000ull;
+    while (atomic_load(&g_done) < N && now_ns() < end) { }
+}
+
+int main(void){
+    printf("[test] sched_deadline start\n");
+    kc_sched_opts_t opts = {0};
+    opts.workers = 1;
+    kc_sched_t *s = kc_sched_init(&opts); assert(s);
+    assert(kc_spawn_co(s, edf_root, s, 0, NULL) == 0);
+    wait_done(2 * N);
+    for (int i = 0; i < N; i++)
+        if (g_order[i] != N - 1 - i) { fprintf(stderr, "slot %d ran %d\n", i, g_order[i]); assert(0); }
+    for (int i = N; i < 2 * N; i++) assert(g_order[i] >= 100);
+    kc_sched_stats_t st;
+    kc_sched_get_stats(s, &st);
+    assert(st.deadline_run == N && st.deadline_misses == 0 && st.deadline_queued == 0);
+
+    /* already past its deadline: one miss; 0 is a plain spawn */
+    atomic_store(&g_done, 0);
+    assert(kc_spawn_co_deadline(s, late, NULL, 0, NULL, now_ns() - 1) == 0);
+    assert(kc_spawn_co_deadline(s, late, NULL, 0, NULL, 0) == 0);
+    wait_done(2);
+    kc_sched_get_stats(s, &st);
+    assert(st.deadline_run == N + 1 && st.deadline_misses == 1);
+    assert(kc_co_set_deadline(NULL, 1) == -EINVAL);
+    kc_sched_worker_stats_t ws;
+    assert(kc_sched_get_worker_stats(s, 0, &ws) == 0 && ws.deadline_next_ns == 0);
+    kc_sched_shutdown(s);
+
+    opts.workers = 2;
+    s = kc_sched_init(&opts); assert(s);
+    atomic_store(&g_done, 0);
+    assert(kc_spawn_co(s, busy_root, s, 0, NULL) == 0);
+    wait_done(N);
+    kc_sched_get_stats(s, &st);
+    kc_sched_shutdown(s);
+    if (st.deadline_steals == 0) { fprintf(stderr, "no deadline steals\n"); assert(0); }
+    printf("[test] sched_deadline ok steals=%lu misses=%lu\n", st.deadline_steals, st.deadline_misses);
+    return 0;
+}
@@ -0,0 +1,84 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Event-driven kc_sched_drain
+// 1) drain(0) on an idle scheduler reports quiescence.
+// 2) a burst of tasks and (yielding) coroutines: drain(-1) returns only after
+//    every one of them ran.
+// 3) a coroutine parked on a channel (timed receive, so it really parks
+//    instead of yield-retrying) counts as quiescent.
+// 4) a long-running task makes a short drain time out; drain from a worker
+//    is refused.
+#include <stdio.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <assert.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_core.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_port.h"
+
+enum { TASKS = 20000, COROS = 2000, YIELDS = 10 };
+
+static _Atomic(int) g_tasks, g_coros, g_parked, g_woken, g_stop, g_inner;
+static kc_chan_t *g_ch;
+
+static void task(void *arg){
+    (void)arg;
+    atomic_fetch_add(&g_tasks, 1);
+}
+
+static void coro(void *arg){
+    (void)arg;
+    for (int i = 0; i < YIELDS; i++) kcoro_yield();
+    atomic_fetch_add(&g_coros, 1);
+}
+
+static void parked(void *arg){
+    (void)arg;
+    int v;
+    atomic_fetch_add(&g_parked, 1);
+    if (kc_chan_recv(g_ch, &v, 30000) == 0) atomic_fetch_add(&g_woken, 1);
+}
+
+static void spinner(void *arg){
+    kc_sched_t *s = (kc_sched_t*)arg;
+    atomic_store(&g_inner, kc_sched_drain(s, -1));
+    while (!atomic_load(&g_stop)) kc_sleep_ms(1);
+}
+
+int main(void){
+    printf("[test] sched_drain start\n");
+    kc_sched_opts_t opts = {0};
+    opts.workers = 4;
+    kc_sched_t *s = kc_sched_init(&opts); assert(s);
+
+    if (kc_sched_drain(s, 0) != 0) { fprintf(stderr, "idle drain(0) failed\n"); return 1; }
+
+    for (int i = 0; i < TASKS; i++) assert(kc_spawn(s, task, NULL) == 0);
+    for (int i = 0; i < COROS; i++) assert(kc_spawn_co(s, coro, NULL, KCORO_STACK_SHARED, NULL) == 0);
+    int rc = kc_sched_drain(s, -1);
+    if (rc != 0 || atomic_load(&g_tasks) != TASKS || atomic_load(&g_coros) != COROS) {
+        fprintf(stderr, "burst rc=%d tasks=%d coros=%d\n", rc, atomic_load(&g_tasks), atomic_load(&g_coros));
+        return 2;
+    }
+
+    assert(kc_chan_make(&g_ch, KC_BUFFERED, sizeof(int), 4) == 0);
+    assert(kc_spawn_co(s, parked, NULL, 0, NULL) == 0);
+    rc = kc_sched_drain(s, 2000);
+    if (rc != 0 || atomic_load(&g_parked) != 1) { fprintf(stderr, "parked rc=%d parked=%d\n", rc, atomic_load(&g_parked)); return 3; }
+    int v = 7;
+    assert(kc_chan_send(g_ch, &v, 0) == 0);
+    rc = kc_sched_drain(s, 2000);
+    if (rc != 0 || atomic_load(&g_woken) != 1) { fprintf(stderr, "wake rc=%d woken=%d\n", rc, atomic_load(&g_woken)); return 4; }
+    kc_chan_destroy(g_ch);
+
+    assert(kc_spawn(s, spinner, s) == 0);
+    rc = kc_sched_drain(s, 50);
+    if (rc != KC_ETIME) { fprintf(stderr, "busy drain rc=%d\n", rc); return 5; }
+    atomic_store(&g_stop, 1);
+    if (kc_sched_drain(s, 2000) != 0) { fprintf(stderr, "spinner never drained\n"); return 6; }
+    if (atomic_load(&g_inner) != -EDEADLK) { fprintf(stderr, "worker drain rc=%d\n", atomic_load(&g_inner)); return 7; }
+
+    kc_sched_shutdown(s);
+    printf("[test] sched_drain ok tasks=%d coros=%d\n", TASKS, COROS);
+    return 0;
+}
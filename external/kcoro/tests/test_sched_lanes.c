@@ -0,0 +1,122 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Priority lanes
+// 1) with one worker, interactive tasks queued behind a bulk flood run first;
+//    bulk only gets its guaranteed share (1 in bulk_share turns) meanwhile.
+// 2) an interactive coroutine that never stops yielding cannot starve bulk.
+// 3) a channel's wake lane overrides a bulk coroutine's lane for that wake;
+//    by default the wake stays in the coroutine's own lane.
+#include <stdio.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <assert.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_core.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_port.h"
+
+enum { BULK = 1000, INTERACTIVE = 100, SHARE = 4 };
+
+static _Atomic(int) g_bulk, g_inter, g_bulk_at_inter_end, g_spin_done;
+
+static void bulk_task(void *arg){ (void)arg; atomic_fetch_add(&g_bulk, 1); }
+
+static void inter_task(void *arg){
+    (void)arg;
+    if (atomic_fetch_add(&g_inter, 1) + 1 == INTERACTIVE) atomic_store(&g_bulk_at_inter_end, atomic_load(&g_bulk));
+}
+
+static void flood(void *arg){
+    kc_sched_t *s = (kc_sched_t*)arg;
+    for (int i = 0; i < BULK; i++) assert(kc_spawn_lane(s, bulk_task, NULL, KC_LANE_BULK) == 0);
+    for (int i = 0; i < INTERACTIVE; i++) assert(kc_spawn(s, inter_task, NULL) == 0);
+}
+
+static void spinner(void *arg){
+    (void)arg;
+    for (int i = 0; i < 50000000 && atomic_load(&g_bulk) < BULK; i++) kc_yield();
+    atomic_store(&g_spin_done, atomic_load(&g_bulk) >= BULK ? 1 : -1);
+}
+
+static kc_chan_t *g_ch;
+static _Atomic(int) g_got;
+
+static void receiver(void *arg){
+    (void)arg;
+    int v = 0;
+    assert(kc_chan_recv(g_ch, &v, 5000) == 0); /* timed waits park; -1 yield-polls */
+    atomic_store(&g_got, v);
+}
+
+static void sender(void *arg){
+    int v = (int)(intptr_t)arg;
+    assert(kc_chan_send(g_ch, &v, 5000) == 0);
+}
+
+static int wait_for(_Atomic(int) *v, int want){
+    for (int i = 0; i < 2000 && atomic_load(v) < want; i++) kc_sleep_ms(5);
+    return atomic_load(v) >= want;
+}
+
+/* Returns lane_submitted deltas across one bulk receiver woken by an
+ * interactive sender. */
+static int chan_round(kc_sched_t *s, int value, unsigned long d[KC_LANE_COUNT]){
+    kc_sched_stats_t a, b;
+    kcoro_t *rx = NULL;
+    atomic_store(&g_got, 0);
+    kc_sched_get_stats(s, &a);
+    if (kc_spawn_co_lane(s, receiver, NULL, 0, &rx, KC_LANE_BULK) != 0) return 0;
+    for (int i = 0; i < 2000 && !kcoro_is_parked(rx); i++) kc_sleep_ms(1);
+    if (!kcoro_is_parked(rx)) return 0;
+    if (kc_spawn_co(s, sender, (void*)(intptr_t)value, 0, NULL) != 0) return 0;
+    if (!wait_for(&g_got, value)) return 0;
+    for (int i = 0; i < 1000 && rx->state != KCORO_FINISHED; i++) kc_sleep_ms(1);
+    kcoro_release(rx);
+    kc_sched_get_stats(s, &b);
+    for (int l = 0; l < KC_LANE_COUNT; l++) d[l] = b.lane_submitted[l] - a.lane_submitted[l];
+    return 1;
+}
+
+int main(void){
+    printf("[test] sched_lanes start\n");
+    kc_sched_opts_t opts = {0};
+    opts.workers = 1;
+    opts.bulk_share = SHARE;
+    kc_sched_t *s = kc_sched_init(&opts); assert(s);
+    assert(kc_spawn_lane(s, bulk_task, NULL, (kc_lane_t)7) == -1);
+
+    assert(kc_spawn_co(s, flood, s, 0, NULL) == 0);
+    if (!wait_for(&g_inter, INTERACTIVE) || !wait_for(&g_bulk, BULK)) {
+        fprintf(stderr, "flood inter=%d bulk=%d\n", atomic_load(&g_inter), atomic_load(&g_bulk)); return 1;
+    }
+    int early = atomic_load(&g_bulk_at_inter_end);
+    if (early > 2 * INTERACTIVE / (SHARE - 1)) { fprintf(stderr, "bulk ran %d before interactive finished\n", early); return 2; }
+    kc_sched_stats_t st;
+    kc_sched_get_stats(s, &st);
+    if (st.lane_submitted[KC_LANE_BULK] != BULK || st.lane_run[KC_LANE_BULK] < BULK ||
+        st.lane_run[KC_LANE_INTERACTIVE] < INTERACTIVE || st.bulk_forced == 0) {
+        fprintf(stderr, "stats sub=%lu/%lu run=%lu/%lu forced=%lu\n", st.lane_submitted[0], st.lane_submitted[1],
+                st.lane_run[0], st.lane_run[1], st.bulk_forced); return 3;
+    }
+
+    atomic_store(&g_bulk, 0);
+    assert(kc_spawn_co(s, spinner, NULL, 0, NULL) == 0);
+    for (int i = 0; i < BULK; i++) assert(kc_spawn_lane(s, bulk_task, NULL, KC_LANE_BULK) == 0);
+    for (int i = 0; i < 2000 && atomic_load(&g_spin_done) == 0; i++) kc_sleep_ms(5);
+    if (atomic_load(&g_spin_done) != 1) { fprintf(stderr, "bulk starved: %d/%d\n", atomic_load(&g_bulk), BULK); return 4; }
+
+    assert(kc_chan_make(&g_ch, KC_BUFFERED, sizeof(int), 4) == 0);
+    unsigned long d[KC_LANE_COUNT];
+    if (!chan_round(s, 1, d) || d[KC_LANE_BULK] != 2 || d[KC_LANE_INTERACTIVE] != 1) {
+        fprintf(stderr, "inherited wake: bulk=%lu interactive=%lu\n", d[KC_LANE_BULK], d[KC_LANE_INTERACTIVE]); return 5;
+    }
+    assert(kc_chan_set_wake_lane(g_ch, KC_LANE_INTERACTIVE) == 0);
+    assert(kc_chan_set_wake_lane(g_ch, 9) == -EINVAL);
+    if (!chan_round(s, 2, d) || d[KC_LANE_BULK] != 1 || d[KC_LANE_INTERACTIVE] != 2) {
+        fprintf(stderr, "interactive wake: bulk=%lu interactive=%lu\n", d[KC_LANE_BULK], d[KC_LANE_INTERACTIVE]); return 6;
+    }
+    kc_chan_destroy(g_ch);
+
+    kc_sched_shutdown(s);
+    printf("[test] sched_lanes ok bulk_before_interactive=%d\n", early);
+    return 0;
+}
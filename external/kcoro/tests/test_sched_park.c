@@ -0,0 +1,48 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Worker parking test
+// Idle workers must sleep without polling (negligible CPU while idle) and a
+// spawn must wake one of them promptly.
+#include <stdio.h>
+#include <stdatomic.h>
+#include <time.h>
+#include "../include/kcoro_sched.h"
+
+static _Atomic(int) g_ran;
+
+static void mark_fn(void *arg){ (void)arg; atomic_fetch_add(&g_ran, 1); }
+
+static double cpu_ms(void){
+    struct timespec ts; clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (double)ts.tv_sec * 1e3 + (double)ts.tv_nsec / 1e6;
+}
+
+int main(void){
+    printf("[test] sched_park start\n");
+    kc_sched_opts_t opts = {0};
+    opts.workers = 4;
+    opts.park_spin = -1; /* park as soon as a scan finds nothing */
+    kc_sched_t *s = kc_sched_init(&opts);
+    if (!s) { fprintf(stderr, "create failed\n"); return 1; }
+
+    kc_sleep_ms(20); /* let every worker go idle */
+    double c0 = cpu_ms();
+    kc_sleep_ms(200);
+    double idle_cpu = cpu_ms() - c0;
+
+    for (int round = 0; round < 50; round++) {
+        if (kc_spawn(s, mark_fn, NULL) != 0) { fprintf(stderr, "spawn failed\n"); kc_sched_shutdown(s); return 1; }
+        for (int i = 0; i < 1000 && atomic_load(&g_ran) <= round; i++) kc_sleep_ms(1);
+        if (atomic_load(&g_ran) <= round) { fprintf(stderr, "spawn %d never ran\n", round); kc_sched_shutdown(s); return 2; }
+    }
+    kc_sched_stats_t st; kc_sched_get_stats(s, &st);
+    kc_sched_shutdown(s);
+
+    if (st.park_events == 0 || st.unpark_events == 0) {
+        fprintf(stderr, "expected park/unpark activity (parks=%lu unparks=%lu)\n", st.park_events, st.unpark_events);
+        return 3;
+    }
+    /* 4 idle workers over 200 ms: polling would cost far more than this. */
+    if (idle_cpu > 40.0) { fprintf(stderr, "idle workers burned %.1f ms CPU\n", idle_cpu); return 4; }
+    printf("[test] sched_park ok idle_cpu=%.2fms parks=%lu unparks=%lu\n", idle_cpu, st.park_events, st.unpark_events);
+    return 0;
+}
@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Busy-poll workers: a coroutine homed on a poll worker ping-pongs with a
+// normal one over two buffered channels, sleeps on a timer and yields
+// alongside a second poll coroutine. The poll coroutines only ever run on
+// their poll worker (slot >= workers), the normal one never does, and the
+// duty-cycle stats count the time spent running them.
+#include <stdio.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <assert.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_port.h"
+#include "../core/src/kc_hist_internal.h" /* kc_sched_self_index */
+
+enum { WORKERS = 2, ROUNDS = 2000, YIELDS = 500 };
+
+static kc_chan_t *g_ping, *g_pong;
+static _Atomic(int) g_done, g_bad, g_yields;
+
+static void poller(void *arg){
+    (void)arg;
+    for (int i = 0; i < ROUNDS; i++) {
+        int v = -1;
+        if (kc_chan_recv(g_ping, &v, 5000) != 0 || v != i || kc_chan_send(g_pong, &v, 5000) != 0)
+            atomic_fetch_add(&g_bad, 1);
+        if (kc_sched_self_index() < WORKERS) atomic_fetch_add(&g_bad, 1);
+    }
+    kc_sleep_ms(2);
+    if (kc_sched_self_index() < WORKERS) atomic_fetch_add(&g_bad, 1);
+    atomic_fetch_add(&g_done, 1);
+}
+
+static void yielder(void *arg){
+    (void)arg;
+    for (int i = 0; i < YIELDS; i++) {
+        atomic_fetch_add(&g_yields, 1);
+        kc_yield();
+        if (kc_sched_self_index() < WORKERS) atomic_fetch_add(&g_bad, 1);
+    }
+    atomic_fetch_add(&g_done, 1);
+}
+
+static void pinger(void *arg){
+    (void)arg;
+    for (int i = 0; i < ROUNDS; i++) {
+        int v = -1;
+        if (kc_chan_send(g_ping, &i, 5000) != 0 || kc_chan_recv(g_pong, &v, 5000) != 0 || v != i)
+            atomic_fetch_add(&g_bad, 1);
+        if (kc_sched_self_index() >= WORKERS) atomic_fetch_add(&g_bad, 1);
+    }
+    atomic_fetch_add(&g_done, 1);
+}
+
+int main(void){
+    printf("[test] sched_poll start\n");
+    kc_sched_opts_t o = {0};
+    o.workers = WORKERS;
+    o.poll_workers = 1;
+    kc_sched_t *s = kc_sched_init(&o);
+    assert(s);
+    assert(kc_sched_poll_count(s) == 1);
+    assert(kc_spawn_co_poll(s, 1, poller, NULL, 0, NULL) == -EINVAL);
+    assert(kc_chan_make(&g_ping, KC_BUFFERED, sizeof(int), 1) == 0);
+    assert(kc_chan_make(&g_pong, KC_BUFFERED, sizeof(int), 1) == 0);
+    assert(kc_spawn_co_poll(s, 0, poller, NULL, 0, NULL) == 0);
+    assert(kc_spawn_co_poll(s, 0, yielder, NULL, 0, NULL) == 0);
+    assert(kc_spawn_co(s, pinger, NULL, 0, NULL) == 0);
+    for (int i = 0; i < 4000 && atomic_load(&g_done) < 3; i++) kc_sleep_ms(5);
+    if (atomic_load(&g_done) != 3 || atomic_load(&g_bad)) {
+        fprintf(stderr, "done=%d bad=%d yields=%d\n", atomic_load(&g_done), atomic_load(&g_bad),
+                atomic_load(&g_yields));
+        return 1;
+    }
+
+    kc_sched_poll_stats_t ps;
+    assert(kc_sched_get_poll_stats(s, 0, &ps) == 0);
+    assert(kc_sched_get_poll_stats(s, 1, &ps) == -EINVAL);
+    assert(kc_sched_get_poll_stats(s, 0, &ps) == 0);
+    if (ps.cpu != -1 || ps.run < YIELDS || ps.busy_ns == 0 || ps.busy_ns > ps.wall_ns) {
+        fprintf(stderr, "cpu=%d run=%lu busy=%llu wall=%llu\n", ps.cpu, ps.run, ps.busy_ns, ps.wall_ns);
+        return 2;
+    }
+    kc_sched_stats_t st;
+    kc_sched_get_stats(s, &st);
+    if (st.poll_workers != 1 || st.poll_busy_ns < ps.busy_ns) {
+        fprintf(stderr, "poll_workers=%lu busy=%llu\n", st.poll_workers, st.poll_busy_ns);
+        return 3;
+    }
+
+    kc_sched_shutdown(s);
+    kc_chan_destroy(g_ping);
+    kc_chan_destroy(g_pong);
+    printf("[test] sched_poll ok run=%lu duty=%.1f%% spins=%lu\n", ps.run,
+           100.0 * (double)ps.busy_ns / (double)ps.wall_ns, ps.spins);
+    return 0;
+}
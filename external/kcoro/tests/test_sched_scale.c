@@ -0,0 +1,108 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Elastic worker sizing
+// 1) a sustained inject backlog from an external thread adds workers up to
+//    max_workers; once idle for scale_down_ms they retire to min_workers.
+// 2) a shrunk scheduler still runs timers and spawned coroutines.
+// 3) "scheduler" keys of the JSON runtime config fill opts left at 0.
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include <stdatomic.h>
+#include <assert.h>
+#include <unistd.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_port.h"
+#include "../include/kcoro_config_runtime.h"
+
+enum { TASKS = 400, MAXW = 4, SLEEPERS = 50 };
+
+static _Atomic(int) g_done, g_slept;
+
+static void slow_task(void *arg){
+    (void)arg;
+    struct timespec ts = { 0, 2000000L }; /* blocks its worker for 2 ms */
+    nanosleep(&ts, NULL);
+    atomic_fetch_add(&g_done, 1);
+}
+
+static void sleeper(void *arg){
+    (void)arg;
+    kc_sleep_ms(20);
+    atomic_fetch_add(&g_slept, 1);
+}
+
+static int wait_for(_Atomic(int) *v, int want){
+    for (int i = 0; i < 2000 && atomic_load(v) < want; i++) kc_sleep_ms(5);
+    return atomic_load(v) >= want;
+}
+
+static unsigned long active(kc_sched_t *s){
+    kc_sched_stats_t st; kc_sched_get_stats(s, &st); return st.workers_active;
+}
+
+int main(void){
+    printf("[test] sched_scale start\n");
+    kc_sched_opts_t opts = {0};
+    opts.workers = 1;
+    opts.min_workers = 1;
+    opts.max_workers = MAXW;
+    opts.scale_up_backlog = 8;
+    opts.scale_up_ms = 5;
+    opts.scale_down_ms = 100;
+    kc_sched_t *s = kc_sched_init(&opts); assert(s);
+    if (active(s) != 1 || kc_sched_worker_node(s, MAXW - 1) != 0 || kc_sched_worker_node(s, MAXW) != -1) {
+        fprintf(stderr, "slots/active wrong at start: %lu\n", active(s)); return 1;
+    }
+
+    unsigned long peak = 1;
+    for (int i = 0; i < TASKS; i++) {
+        assert(kc_spawn(s, slow_task, NULL) == 0);
+        if (i % 20 == 0) { kc_sleep_ms(2); unsigned long a = active(s); if (a > peak) peak = a; }
+    }
+    while (atomic_load(&g_done) < TASKS) { unsigned long a = active(s); if (a > peak) peak = a; kc_sleep_ms(1); }
+    kc_sched_stats_t st;
+    kc_sched_get_stats(s, &st);
+    if (peak < 2 || peak > MAXW || st.scale_ups == 0) {
+        fprintf(stderr, "no growth: peak=%lu ups=%lu\n", peak, st.scale_ups); return 2;
+    }
+
+    for (int i = 0; i < 200 && active(s) > 1; i++) kc_sleep_ms(10);
+    kc_sched_get_stats(s, &st);
+    if (st.workers_active != 1 || st.scale_downs == 0) {
+        fprintf(stderr, "no shrink: active=%lu downs=%lu\n", st.workers_active, st.scale_downs); return 3;
+    }
+
+    for (int i = 0; i < SLEEPERS; i++) assert(kc_spawn_co(s, sleeper, NULL, 0, NULL) == 0);
+    if (!wait_for(&g_slept, SLEEPERS)) { fprintf(stderr, "sleepers after shrink: %d\n", atomic_load(&g_slept)); return 4; }
+    atomic_store(&g_done, 0);
+    for (int i = 0; i < 50; i++) assert(kc_spawn(s, slow_task, NULL) == 0);
+    if (!wait_for(&g_done, 50)) { fprintf(stderr, "tasks after shrink: %d\n", atomic_load(&g_done)); return 5; }
+    kc_sched_shutdown(s);
+
+    char path[64];
+    snprintf(path, sizeof path, "/tmp/kcoro_sched_scale_%d.json", (int)getpid());
+    FILE *f = fopen(path, "w"); assert(f);
+    fputs("{ \"channel\": {\"metrics\": {\"emit_min_ops\": 8}},\n"
+          "  \"scheduler\": {\"min_workers\": 1, \"max_workers\": 3, \"scale_down_ms\": 50, \"bogus\": 9} }\n", f);
+    fclose(f);
+    assert(kc_runtime_config_reload(path) == 0);
+    const struct kc_runtime_config *cfg = kc_runtime_config_get();
+    if (cfg->sched_min_workers != 1 || cfg->sched_max_workers != 3 || cfg->sched_scale_down_ms != 50 ||
+        cfg->sched_scale_up_ms != 0 || cfg->chan_metrics_emit_min_ops != 8) {
+        fprintf(stderr, "config parse min=%d max=%d down=%d\n", cfg->sched_min_workers,
+                cfg->sched_max_workers, cfg->sched_scale_down_ms); return 6;
+    }
+    kc_sched_opts_t co = {0};
+    co.workers = 2;
+    s = kc_sched_init(&co); assert(s);
+    if (kc_sched_worker_node(s, 2) != 0 || kc_sched_worker_node(s, 3) != -1) { fprintf(stderr, "config max ignored\n"); return 7; }
+    for (int i = 0; i < 200 && active(s) > 1; i++) kc_sleep_ms(10);
+    if (active(s) != 1) { fprintf(stderr, "config min ignored: %lu\n", active(s)); return 8; }
+    kc_sched_shutdown(s);
+    remove(path);
+    assert(kc_runtime_config_reload("/nonexistent/kcoro_config.json") == 0);
+
+    printf("[test] sched_scale ok peak=%lu ups=%lu downs=%lu\n", peak, st.scale_ups, st.scale_downs);
+    return 0;
+}
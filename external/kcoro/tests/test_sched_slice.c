@@ -0,0 +1,109 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Time-slice budget (kc_sched_opts_t.slice_us)
+// 1) on one worker, a coroutine spinning with kc_yield_if_needed() lets a
+//    ready coroutine run long before it finishes, and its overrun stats
+//    record the flagged runs.
+// 2) channel ops are safepoints too: a spin of non-blocking send/recv pairs
+//    gives way the same way.
+// 3) with the budget off kc_yield_if_needed() never yields.
+#include <stdio.h>
+#include <stdatomic.h>
+#include <assert.h>
+#include <time.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_port.h"
+#include "../include/kcoro_sched.h"
+
+enum { SLICE_US = 2000, SPIN_MS = 60 };
+
+static _Atomic(int) g_other_ran, g_spins_done;
+static _Atomic(int) g_ran_early;
+static kc_co_overrun_stats_t g_st[2];
+static int g_off_yields;
+
+static long now_ns(void){
+    struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+static void other(void *arg){ (void)arg; atomic_store(&g_other_ran, 1); }
+
+static void spin_safepoint(void *arg){
+    (void)arg;
+    long end = now_ns() + SPIN_MS * 1000000L;
+    while (now_ns() < end) {
+        (void)kc_yield_if_needed();
+        if (atomic_load(&g_other_ran) && !atomic_load(&g_ran_early)) atomic_store(&g_ran_early, 1);
+    }
+    assert(kc_co_overrun_stats(kcoro_current(), &g_st[0]) == 0);
+    atomic_fetch_add(&g_spins_done, 1);
+}
+
+static void spin_chan(void *arg){
+    (void)arg;
+    kc_chan_t *ch = NULL;
+    assert(kc_chan_make(&ch, KC_BUFFERED, sizeof(int), 4) == 0);
+    long end = now_ns() + SPIN_MS * 1000000L;
+    int v = 0;
+    while (now_ns() < end) {
+        assert(kc_chan_send(ch, &v, 0) == 0);
+        assert(kc_chan_recv(ch, &v, 0) == 0);
+        if (atomic_load(&g_other_ran) && !atomic_load(&g_ran_early)) atomic_store(&g_ran_early, 1);
+    }
+    kc_chan_destroy(ch);
+    assert(kc_co_overrun_stats(kcoro_current(), &g_st[1]) == 0);
+    atomic_fetch_add(&g_spins_done, 1);
+}
+
+static void spin_off(void *arg){
+    (void)arg;
+    long end = now_ns() + 20 * 1000000L;
+    while (now_ns() < end) g_off_yields += kc_yield_if_needed();
+    atomic_fetch_add(&g_spins_done, 1);
+}
+
+static void wait_done(int want){
+    for (int i = 0; i < 1000 && atomic_load(&g_spins_done) < want; i++) kc_sleep_ms(5);
+    assert(atomic_load(&g_spins_done) == want);
+}
+
+static void run_pair(kc_sched_t *s, kcoro_fn_t spin, int want){
+    atomic_store(&g_other_ran, 0);
+    atomic_store(&g_ran_early, 0);
+    assert(kc_spawn_co(s, spin, NULL, 0, NULL) == 0);
+    kc_sleep_ms(5);   /* the spinner owns the only worker by now */
+    assert(kc_spawn_co(s, other, NULL, 0, NULL) == 0);
+    wait_done(want);
+    if (!atomic_load(&g_ran_early)) { fprintf(stderr, "ready coroutine starved behind spinner %d\n", want); assert(0); }
+}
+
+int main(void){
+    printf("[test] sched_slice start\n");
+    kc_sched_opts_t opts = {0};
+    opts.workers = 1;
+    opts.slice_us = SLICE_US;
+    kc_sched_t *s = kc_sched_init(&opts); assert(s);
+    run_pair(s, spin_safepoint, 1);
+    run_pair(s, spin_chan, 2);
+    for (int i = 0; i < 2; i++) {
+        assert(g_st[i].overruns >= 1 && g_st[i].safepoint_yields >= 1);
+        assert(g_st[i].max_run_ns >= SLICE_US * 1000ull / 2);
+    }
+    kc_sched_stats_t st;
+    kc_sched_get_stats(s, &st);
+    assert(st.preempt_flags >= 2 && st.preempt_yields >= 2);
+    kc_sched_shutdown(s);
+
+    opts.slice_us = -1;
+    s = kc_sched_init(&opts); assert(s);
+    assert(kc_spawn_co(s, spin_off, NULL, 0, NULL) == 0);
+    wait_done(3);
+    kc_sched_get_stats(s, &st);
+    kc_sched_shutdown(s);
+    assert(g_off_yields == 0 && st.preempt_flags == 0);
+    assert(kc_yield_if_needed() == 0);   /* not in a coroutine */
+    printf("[test] sched_slice ok overruns=%lu/%lu yields=%lu/%lu max_run=%lluus\n",
+           g_st[0].overruns, g_st[1].overruns, g_st[0].safepoint_yields, g_st[1].safepoint_yields,
+           g_st[0].max_run_ns / 1000);
+    return 0;
+}
@@ -0,0 +1,84 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Scheduler startup modes (kc_sched_opts_t.startup)
+// 1) an unknown mode is rejected with EINVAL.
+// 2) LAZY: no worker runs after init; submits that find every started worker
+//    busy start the next one, up to `workers`, and every task runs.
+// 3) kcoro_stack_pool_prefill fills the calling thread's cache up to its
+//    limit, then adds nothing.
+// 4) WARM: each worker maps a full stack cache before init returns.
+#include <stdio.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <assert.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_core.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_port.h"
+
+enum { WORKERS = 4, TASKS = 2000 };
+
+static _Atomic(int) g_ran, g_gate;
+
+static void task(void *arg){
+    (void)arg;
+    atomic_fetch_add(&g_ran, 1);
+}
+
+/* Holds its worker until WORKERS of them run at once. */
+static void gate_task(void *arg){
+    (void)arg;
+    atomic_fetch_add(&g_gate, 1);
+    for (int i = 0; i < 5000 && atomic_load(&g_gate) < WORKERS; i++) kc_sleep_ms(1);
+    atomic_fetch_add(&g_ran, 1);
+}
+
+int main(void){
+    printf("[test] sched_startup start\n");
+    kc_sched_opts_t opts = {0};
+    opts.workers = WORKERS;
+    opts.startup = 7;
+    errno = 0;
+    if (kc_sched_init(&opts) != NULL || errno != EINVAL) { fprintf(stderr, "bad mode accepted\n"); return 1; }
+
+    opts.startup = KC_SCHED_START_LAZY;
+    kc_sched_t *s = kc_sched_init(&opts); assert(s);
+    kc_sched_stats_t st;
+    kc_sched_get_stats(s, &st);
+    if (st.workers_active != 0) { fprintf(stderr, "lazy init started %lu workers\n", st.workers_active); return 2; }
+    assert(kc_spawn(s, task, NULL) == 0);
+    if (kc_sched_drain(s, 5000) != 0 || atomic_load(&g_ran) != 1) { fprintf(stderr, "first task ran=%d\n", atomic_load(&g_ran)); return 3; }
+    kc_sched_get_stats(s, &st);
+    if (st.workers_active < 1) { fprintf(stderr, "no worker after first submit\n"); return 4; }
+    for (int i = 0; i < WORKERS; i++) assert(kc_spawn(s, gate_task, NULL) == 0);
+    int extra = 0;
+    for (int i = 0; i < 5000 && atomic_load(&g_gate) < WORKERS; i++, extra++) {
+        assert(kc_spawn(s, task, NULL) == 0);
+        kc_sleep_ms(1);
+    }
+    for (int i = 0; i < TASKS; i++) assert(kc_spawn(s, task, NULL) == 0);
+    int want = 1 + WORKERS + extra + TASKS;
+    if (kc_sched_drain(s, 20000) != 0 || atomic_load(&g_ran) != want) { fprintf(stderr, "burst ran=%d want=%d\n", atomic_load(&g_ran), want); return 5; }
+    kc_sched_get_stats(s, &st);
+    printf("[test] sched_startup lazy workers=%lu\n", st.workers_active);
+    if (atomic_load(&g_gate) != WORKERS || st.workers_active != WORKERS || st.scale_ups != 0) {
+        fprintf(stderr, "lazy workers=%lu scale_ups=%lu\n", st.workers_active, st.scale_ups); return 6;
+    }
+    kc_sched_shutdown(s);
+
+    unsigned filled = kcoro_stack_pool_prefill(0, ~0u);
+    struct kcoro_stack_pool_stats ps0, ps;
+    kcoro_stack_pool_get_stats(&ps0);
+    if (filled == 0 || kcoro_stack_pool_prefill(0, ~0u) != 0 || ps0.thread_stacks < filled) {
+        fprintf(stderr, "prefill filled=%u cached=%zu\n", filled, ps0.thread_stacks); return 7;
+    }
+
+    opts.startup = KC_SCHED_START_WARM;
+    opts.workers = 2;
+    s = kc_sched_init(&opts); assert(s);
+    kc_sched_shutdown(s);
+    kcoro_stack_pool_get_stats(&ps);
+    if (ps.mapped - ps0.mapped < 2ul * filled) { fprintf(stderr, "warm mapped=%lu\n", ps.mapped - ps0.mapped); return 8; }
+
+    printf("[test] sched_startup ok prefill=%u\n", filled);
+    return 0;
+}
@@ -0,0 +1,52 @@
+// Work-stealing scheduler test
+// Tasks spawned from worker threads land on the spawning worker's own deque,
+// so a fan-out tree forces owner push/pop to race with steals from the other
+// workers. Verifies every task runs exactly once and counters stay coherent.
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include "kcoro_sched.h"
+
+enum { FANOUT = 4, DEPTH = 7 }; /* 4^0 + ... + 4^7 = 21845 tasks */
+
+static kc_sched_t *g_sched;
+static _Atomic(long) g_done;
+
+// Each node spawns FANOUT children until DEPTH is reached
+static void node_fn(void *arg){
+    intptr_t depth = (intptr_t)arg;
+    // A little work per node so idle workers have time to steal
+    volatile unsigned spin = 0;
+    for(unsigned i=0;i<2000;i++) spin += i;
+    if(depth < DEPTH){
+        for(int i=0;i<FANOUT;i++){
+            if(kc_spawn(g_sched, node_fn, (void*)(depth+1))!=0){ fprintf(stderr, "nested spawn failed\n"); exit(2); }
+        }
+    }
+    atomic_fetch_add(&g_done, 1);
+}
+
+int main(void){
+    long expected = 0, level = 1;
+    for(int d=0; d<=DEPTH; d++){ expected += level; level *= FANOUT; }
+
+    kc_sched_opts_t opts = {0};
+    opts.workers = 4;
+    g_sched = kc_sched_init(&opts);
+    if(!g_sched){ fprintf(stderr, "[sched] create failed\n"); return 1; }
+    if(kc_spawn(g_sched, node_fn, (void*)(intptr_t)0)!=0){ fprintf(stderr, "root spawn failed\n"); kc_sched_shutdown(g_sched); return 1; }
+
+    // Wait (bounded) for the whole tree to finish
+    for(int i=0;i<2000 && atomic_load(&g_done) < expected; i++) kc_sleep_ms(5);
+    long done = atomic_load(&g_done);
+    kc_sched_stats_t st; kc_sched_get_stats(g_sched,&st);
+    kc_sched_shutdown(g_sched);
+
+    if(done != expected){ fprintf(stderr, "tasks done=%ld expected=%ld\n", done, expected); return 3; }
+    if(st.tasks_submitted != (unsigned long)expected){ fprintf(stderr, "submitted=%lu expected=%ld\n", st.tasks_submitted, expected); return 4; }
+    if(st.tasks_completed != st.tasks_submitted){ fprintf(stderr, "completed=%lu submitted=%lu\n", st.tasks_completed, st.tasks_submitted); return 5; }
+
+    printf("[sched] steal test passed: %ld tasks, probes=%lu succ=%lu empty=%lu cas_fail=%lu donations=%lu\n", done, st.steals_probes, st.steals_succeeded, st.steals_failures, st.steals_cas_failures, st.donations);
+    return 0;
+}
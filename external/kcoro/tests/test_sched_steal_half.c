@@ -0,0 +1,72 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Steal-half and adaptive steal depth
+// 1) one worker fans out every task onto its own deque; thieves move batches
+//    into their deques (steals_batched) and every task still runs once.
+// 2) once idle, every running worker's steal depth has decayed to one probe.
+#include <stdio.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include "../include/kcoro_sched.h"
+
+enum { TASKS = 20000, WORKERS = 4, BURST = 60 };
+
+static kc_sched_t *g_sched;
+static _Atomic(unsigned char) g_ran[TASKS];
+static _Atomic(int) g_done;
+
+static void leaf(void *arg){
+    volatile unsigned spin = 0;
+    for (unsigned i = 0; i < 3000; i++) spin += i;
+    atomic_fetch_add(&g_ran[(intptr_t)arg], 1);
+    atomic_fetch_add(&g_done, 1);
+}
+
+/* Rounds of BURST spawns stay under the donation threshold, so they all land
+ * on the root's deque; the root then keeps its worker busy until thieves
+ * have drained it. */
+static void root(void *arg){
+    (void)arg;
+    for (intptr_t i = 0; i < TASKS; ) {
+        for (int k = 0; k < BURST && i < TASKS; k++, i++)
+            if (kc_spawn(g_sched, leaf, (void*)i) != 0) { fprintf(stderr, "spawn %ld failed\n", (long)i); return; }
+        while (atomic_load(&g_done) < i) { }
+    }
+}
+
+int main(void){
+    kc_sched_opts_t opts = {0};
+    opts.workers = WORKERS;
+    g_sched = kc_sched_init(&opts);
+    if (!g_sched) { fprintf(stderr, "sched init failed\n"); return 1; }
+    if (kc_spawn(g_sched, root, NULL) != 0) { kc_sched_shutdown(g_sched); return 1; }
+    for (int i = 0; i < 4000 && atomic_load(&g_done) < TASKS; i++) kc_sleep_ms(5);
+    if (atomic_load(&g_done) != TASKS) { fprintf(stderr, "done=%d\n", atomic_load(&g_done)); return 2; }
+    for (int i = 0; i < TASKS; i++)
+        if (atomic_load(&g_ran[i]) != 1) { fprintf(stderr, "task %d ran %d times\n", i, atomic_load(&g_ran[i])); return 3; }
+    kc_sched_stats_t st;
+    kc_sched_get_stats(g_sched, &st);
+    if (st.steals_succeeded == 0 || st.steals_batched == 0) {
+        fprintf(stderr, "no batch steals: succ=%lu batched=%lu\n", st.steals_succeeded, st.steals_batched); return 4;
+    }
+    unsigned long stolen = 0;
+    int decayed = 0;
+    for (int t = 0; t < 200 && !decayed; t++) {
+        kc_sleep_ms(5);
+        decayed = 1;
+        stolen = 0;
+        for (int i = 0; i < kc_sched_worker_count(g_sched); i++) {
+            kc_sched_worker_stats_t ws;
+            if (kc_sched_get_worker_stats(g_sched, i, &ws) != 0) return 5;
+            stolen += ws.steals;
+            if (ws.steal_depth > KC_SCHED_STEAL_SCAN_MAX) { fprintf(stderr, "depth %u\n", ws.steal_depth); return 6; }
+            if (ws.on && ws.steal_depth != 1) decayed = 0;
+        }
+    }
+    kc_sched_shutdown(g_sched);
+    if (!decayed) { fprintf(stderr, "idle steal depth did not decay\n"); return 7; }
+    if (stolen != st.steals_succeeded + st.steals_batched) {
+        fprintf(stderr, "worker steals %lu != %lu + %lu\n", stolen, st.steals_succeeded, st.steals_batched); return 8;
+    }
+    printf("[sched] steal_half ok: succ=%lu batched=%lu probes=%lu\n", st.steals_succeeded, st.steals_batched, st.steals_probes);
+    return 0;
+}
@@ -0,0 +1,66 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Scheduler timer test
+// Many coroutines sleep for assorted delays: none may wake early and all must
+// wake. A far-future timer is cancelled (exactly once), then re-armed short.
+#include <stdio.h>
+#include <stdatomic.h>
+#include <assert.h>
+#include <time.h>
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_core.h"
+
+enum { SLEEPERS = 2000 };
+
+static _Atomic(int) g_done;
+static _Atomic(int) g_early;
+static _Atomic(int) g_parked_done;
+
+static unsigned long long now_ns(void){
+    struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ull + (unsigned long long)ts.tv_nsec;
+}
+
+static void sleeper(void *arg){
+    int ms = (int)(long)arg;
+    unsigned long long t0 = now_ns();
+    kc_sleep_ms(ms);
+    if (now_ns() - t0 < (unsigned long long)ms * 1000000ull) atomic_fetch_add(&g_early, 1);
+    atomic_fetch_add(&g_done, 1);
+}
+
+static void parked(void *arg){
+    (void)arg;
+    kcoro_park();
+    atomic_fetch_add(&g_parked_done, 1);
+}
+
+int main(void){
+    printf("[test] sched_timers start\n");
+    kc_sched_opts_t opts = {0};
+    opts.workers = 4;
+    kc_sched_t *s = kc_sched_init(&opts); assert(s);
+
+    for (long i = 0; i < SLEEPERS; i++)
+        assert(kc_spawn_co(s, sleeper, (void*)(1 + i % 97), 0, NULL) == 0);
+
+    kcoro_t *p = NULL;
+    assert(kc_spawn_co(s, parked, NULL, 0, &p) == 0);
+    kcoro_retain(p);
+    for (int i = 0; i < 1000 && !kcoro_is_parked(p); i++) kc_sleep_ms(1);
+    kc_timer_handle_t h = kc_sched_timer_wake_after(s, p, 60000);
+    int c1 = kc_sched_timer_cancel(s, h);
+    int c2 = kc_sched_timer_cancel(s, h);
+    (void)kc_sched_timer_wake_after(s, p, 5);
+
+    for (int i = 0; i < 4000 && (atomic_load(&g_done) < SLEEPERS || !atomic_load(&g_parked_done)); i++) kc_sleep_ms(5);
+    int done = atomic_load(&g_done);
+    kc_sched_shutdown(s);
+    kcoro_release(p);
+
+    if (c1 != 1 || c2 != 0) { fprintf(stderr, "cancel returned %d then %d (want 1, 0)\n", c1, c2); return 1; }
+    if (done != SLEEPERS) { fprintf(stderr, "only %d/%d sleepers woke\n", done, SLEEPERS); return 2; }
+    if (atomic_load(&g_early)) { fprintf(stderr, "%d sleepers woke early\n", atomic_load(&g_early)); return 3; }
+    if (!atomic_load(&g_parked_done)) { fprintf(stderr, "re-armed timer never fired\n"); return 4; }
+    printf("[test] sched_timers ok sleepers=%d\n", done);
+    return 0;
+}
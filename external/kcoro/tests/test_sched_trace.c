@@ -0,0 +1,143 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Test the event tracer: start/stop/-EBUSY, a ping-pong over a rendezvous
+// channel plus a sleeping coroutine recorded into per-thread rings, the
+// Chrome JSON dump, ring overwrite accounting, and that a restart discards
+// the previous trace
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <unistd.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_core.h"
+
+#define ROUNDS 50
+
+struct pp { kc_chan_t *ping, *pong; volatile int done; };
+
+static void pinger(void *arg)
+{
+    struct pp *p = (struct pp*)arg;
+    for (int i = 0; i < ROUNDS; i++) {
+        int v = i;
+        assert(kc_chan_send(p->ping, &v, -1) == 0);
+        assert(kc_chan_recv(p->pong, &v, -1) == 0 && v == i + 1);
+    }
+    p->done++;
+}
+
+static void ponger(void *arg)
+{
+    struct pp *p = (struct pp*)arg;
+    for (int i = 0; i < ROUNDS; i++) {
+        int v = 0;
+        assert(kc_chan_recv(p->ping, &v, -1) == 0 && v == i);
+        v++;
+        assert(kc_chan_send(p->pong, &v, -1) == 0);
+    }
+    p->done++;
+}
+
+static void sleeper(void *arg)
+{
+    kc_sleep_ms(5);
+    ((struct pp*)arg)->done++;
+}
+
+static char *slurp(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    assert(f);
+    fseek(f, 0, SEEK_END);
+    long n = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *buf = (char*)malloc((size_t)n + 1);
+    assert(buf && fread(buf, 1, (size_t)n, f) == (size_t)n);
+    buf[n] = '\0';
+    fclose(f);
+    return buf;
+}
+
+static int count(const char *hay, const char *needle)
+{
+    int n = 0;
+    for (const char *p = hay; (p = strstr(p, needle)) != NULL; p += strlen(needle)) n++;
+    return n;
+}
+
+static void run_pingpong(void)
+{
+    kc_sched_t *s = kc_sched_default();
+    struct pp p = {0};
+    assert(kc_chan_make(&p.ping, KC_RENDEZVOUS, sizeof(int), 0) == 0);
+    assert(kc_chan_make(&p.pong, KC_RENDEZVOUS, sizeof(int), 0) == 0);
+    assert(kc_spawn_co(s, ponger, &p, 0, NULL) == 0);
+    assert(kc_spawn_co(s, pinger, &p, 0, NULL) == 0);
+    assert(kc_spawn_co(s, sleeper, &p, 0, NULL) == 0);
+    for (int i = 0; i < 5000 && p.done < 3; i++) usleep(1000);
+    assert(p.done == 3);
+    kc_chan_destroy(p.ping);
+    kc_chan_destroy(p.pong);
+}
+
+int main(void)
+{
+    kc_trace_stats_t st;
+    assert(!kc_trace_active());
+    assert(kc_trace_start((size_t)1 << 30) == -EINVAL);
+    assert(kc_trace_start(0) == 0);
+    assert(kc_trace_active());
+    assert(kc_trace_start(0) == -EBUSY);
+    run_pingpong();
+    kc_trace_stop();
+    assert(!kc_trace_active());
+
+    kc_trace_get_stats(&st);
+    printf("[sched trace] events=%lu threads=%lu overwritten=%lu\n", st.events, st.threads, st.overwritten);
+    assert(st.threads >= 2 && st.overwritten == 0);
+    assert(st.events >= 4 * ROUNDS);
+
+    char path[] = "/tmp/kc_trace_XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    assert(kc_trace_dump_chrome(fd) == 0);
+    close(fd);
+    char *json = slurp(path);
+    assert(strncmp(json, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", 38) == 0);
+    assert(strstr(json, "\n]}\n"));
+    assert(strstr(json, "\"thread_name\"") && strstr(json, "kc worker "));
+    assert(count(json, "\"ph\":\"B\"") == count(json, "\"ph\":\"E\""));
+    assert(count(json, "\"ph\":\"B\"") >= 2 * ROUNDS);
+    assert(count(json, "\"name\":\"spawn\"") == 3);
+    assert(strstr(json, "\"name\":\"chan block\"") && strstr(json, "\"name\":\"chan wake\""));
+    assert(strstr(json, "\"name\":\"timer\""));
+    assert(strstr(json, "\"state\":\"finished\""));
+    assert(strstr(json, "\"ph\":\"s\"") && strstr(json, "\"ph\":\"f\""));
+    free(json);
+
+    /* A small ring keeps only its newest events; the dump still balances */
+    assert(kc_trace_start(16) == 0);
+    run_pingpong();
+    kc_trace_stop();
+    kc_trace_get_stats(&st);
+    assert(st.overwritten > 0 && st.events > st.overwritten);
+    assert(kc_trace_dump_chrome_file(path) == 0);
+    json = slurp(path);
+    assert(count(json, "\"ph\":\"B\"") == count(json, "\"ph\":\"E\""));
+    assert(count(json, "\"name\":\"spawn\"") <= 3);
+    free(json);
+
+    /* Restart: the previous trace is gone until threads record again */
+    assert(kc_trace_start(0) == 0);
+    kc_trace_stop();
+    kc_trace_get_stats(&st);
+    assert(st.events == 0 && st.threads == 0);
+
+    assert(kc_trace_dump_chrome(-1) == -EBADF);
+    assert(kc_trace_dump_chrome_file("/nonexistent-dir/trace.json") == -ENOENT);
+    unlink(path);
+    printf("[sched trace] ok\n");
+    return 0;
+}
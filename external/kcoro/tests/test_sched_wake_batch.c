@@ -0,0 +1,111 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Batched wakes
+// 1) kc_sched_enqueue_ready_batch from an external thread: NULL and repeated
+//    entries are skipped, every distinct coroutine runs exactly once, and
+//    the batch went to a worker's remote-wake inbox.
+// 2) the same from a worker coroutine (a prefix lands on its deque).
+// 3) kc_chan_close with thousands of parked receivers wakes all of them
+//    (KC_EPIPE) through batched wakes.
+#include <stdio.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <assert.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_core.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_port.h"
+
+enum { COROS = 500, PARKED = 4000 };
+
+static _Atomic(int) g_ran, g_parked, g_epipe, g_other, g_batched;
+static kcoro_t *g_cos[2 * COROS + 2];
+static size_t g_ncos;
+static kc_chan_t *g_ch;
+
+static void coro(void *arg){
+    (void)arg;
+    atomic_fetch_add(&g_ran, 1);
+}
+
+static void receiver(void *arg){
+    (void)arg;
+    int v;
+    atomic_fetch_add(&g_parked, 1);
+    int rc = kc_chan_recv(g_ch, &v, -1);
+    atomic_fetch_add(rc == KC_EPIPE ? &g_epipe : &g_other, 1);
+}
+
+/* COROS fresh coroutines, each listed twice, plus two NULLs. */
+static void build(void){
+    g_ncos = 0;
+    g_cos[g_ncos++] = NULL;
+    for (int i = 0; i < COROS; i++) {
+        kcoro_t *co = kcoro_create(coro, NULL, KCORO_STACK_SHARED);
+        assert(co);
+        g_cos[g_ncos++] = co;
+    }
+    for (int i = 1; i <= COROS; i++) g_cos[g_ncos++] = g_cos[i];
+    g_cos[g_ncos++] = NULL;
+}
+
+static int wait_for(_Atomic(int) *v, int want){
+    for (int i = 0; i < 2000 && atomic_load(v) < want; i++) kc_sleep_ms(5);
+    return atomic_load(v) >= want;
+}
+
+static int release_all(void){
+    for (int i = 1; i <= COROS; i++) {
+        for (int k = 0; k < 1000 && g_cos[i]->state != KCORO_FINISHED; k++) kc_sleep_ms(1);
+        if (g_cos[i]->state != KCORO_FINISHED) return -1;
+        kcoro_release(g_cos[i]);
+    }
+    return 0;
+}
+
+static void from_worker(void *arg){
+    kc_sched_t *s = (kc_sched_t*)arg;
+    atomic_store(&g_batched, (int)kc_sched_enqueue_ready_batch(s, g_cos, g_ncos));
+}
+
+int main(void){
+    printf("[test] sched_wake_batch start\n");
+    kc_sched_opts_t opts = {0};
+    opts.workers = 4;
+    kc_sched_t *s = kc_sched_init(&opts); assert(s);
+    kc_sched_stats_t st0, st;
+
+    build();
+    kc_sched_get_stats(s, &st0);
+    size_t q = kc_sched_enqueue_ready_batch(s, g_cos, g_ncos);
+    if (q != COROS || !wait_for(&g_ran, COROS)) { fprintf(stderr, "external batch q=%zu ran=%d\n", q, atomic_load(&g_ran)); return 1; }
+    kc_sleep_ms(20);
+    if (atomic_load(&g_ran) != COROS) { fprintf(stderr, "external batch ran=%d\n", atomic_load(&g_ran)); return 2; }
+    kc_sched_get_stats(s, &st);
+    if (st.remote_wakes - st0.remote_wakes < COROS) { fprintf(stderr, "remote_wakes=%lu\n", st.remote_wakes - st0.remote_wakes); return 3; }
+    if (release_all() != 0) { fprintf(stderr, "external batch not finished\n"); return 4; }
+
+    atomic_store(&g_ran, 0);
+    build();
+    kc_sched_get_stats(s, &st0);
+    assert(kc_spawn_co(s, from_worker, s, 0, NULL) == 0);
+    if (!wait_for(&g_ran, COROS) || atomic_load(&g_batched) != COROS) {
+        fprintf(stderr, "worker batch q=%d ran=%d\n", atomic_load(&g_batched), atomic_load(&g_ran)); return 5;
+    }
+    kc_sched_get_stats(s, &st);
+    if (st.ready_local == st0.ready_local) { fprintf(stderr, "worker batch stayed global\n"); return 6; }
+    if (release_all() != 0) { fprintf(stderr, "worker batch not finished\n"); return 7; }
+
+    assert(kc_chan_make(&g_ch, KC_BUFFERED, sizeof(int), 16) == 0);
+    for (int i = 0; i < PARKED; i++) assert(kc_spawn_co(s, receiver, NULL, KCORO_STACK_SHARED, NULL) == 0);
+    if (!wait_for(&g_parked, PARKED)) { fprintf(stderr, "parked=%d\n", atomic_load(&g_parked)); return 8; }
+    kc_sleep_ms(50);
+    kc_chan_close(g_ch);
+    if (!wait_for(&g_epipe, PARKED) || atomic_load(&g_other)) {
+        fprintf(stderr, "close epipe=%d other=%d\n", atomic_load(&g_epipe), atomic_load(&g_other)); return 9;
+    }
+    kc_chan_destroy(g_ch);
+
+    kc_sched_shutdown(s);
+    printf("[test] sched_wake_batch ok coros=%d parked=%d\n", COROS, PARKED);
+    return 0;
+}
@@ -0,0 +1,145 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Stall watchdog (kc_sched_set_watchdog)
+// 1) a spinning coroutine and one blocked in a syscall are each reported
+//    once, with their id, name and a stack sample, and counted.
+// 2) a plain task hogging the only worker is reported as a queue stall for
+//    the work it spawned onto its own deque, and for spawns from outside.
+// 3) with the watchdog off nothing is reported.
+#include <stdio.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <assert.h>
+#include <time.h>
+#include <unistd.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_port.h"
+#include "../include/kcoro_sched.h"
+
+enum { STALL_MS = 40, HOG_MS = 200 };
+
+static kc_sched_stall_t g_ev[16];
+static _Atomic(int) g_nev, g_done;
+static _Atomic(uint64_t) g_ids[2];
+
+static long now_ns(void){
+    struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+static void on_stall(const kc_sched_stall_t *st, void *arg){
+    (void)arg;
+    int i = atomic_fetch_add(&g_nev, 1);
+    if (i < 16) g_ev[i] = *st;
+}
+
+static void spin_co(void *arg){
+    (void)arg;
+    kcoro_set_name(kcoro_current(), "spinner");
+    atomic_store(&g_ids[0], kcoro_current()->id);
+    kc_yield();   /* the next run carries the name */
+    long end = now_ns() + HOG_MS * 1000000L;
+    while (now_ns() < end) { }
+    atomic_fetch_add(&g_done, 1);
+}
+
+static void sleep_co(void *arg){
+    (void)arg;
+    kcoro_set_name(kcoro_current(), "sleeper");
+    atomic_store(&g_ids[1], kcoro_current()->id);
+    kc_yield();
+    /* The stack sample's signal may cut a sleep short */
+    long end = now_ns() + HOG_MS * 1000000L;
+    while (now_ns() < end) usleep(10000);
+    atomic_fetch_add(&g_done, 1);
+}
+
+static void noop(void *arg){ (void)arg; atomic_fetch_add(&g_done, 1); }
+
+static void hog_task(void *arg){
+    kc_sched_t *s = arg;
+    for (int i = 0; i < 3; i++) assert(kc_spawn(s, noop, NULL) == 0);
+    long end = now_ns() + HOG_MS * 1000000L;
+    while (now_ns() < end) { }
+    atomic_fetch_add(&g_done, 1);
+}
+
+static void wait_done(int want){
+    for (int i = 0; i < 1000 && atomic_load(&g_done) < want; i++) usleep(5000);
+    assert(atomic_load(&g_done) == want);
+}
+
+static const kc_sched_stall_t *find(int kind, int worker, uint64_t id){
+    int n = atomic_load(&g_nev);
+    for (int i = 0; i < n && i < 16; i++)
+        if (g_ev[i].kind == kind && g_ev[i].worker == worker && (!id || g_ev[i].co_id == id)) return &g_ev[i];
+    return NULL;
+}
+
+static void test_runs(void){
+    kc_sched_opts_t o = { .workers = 2 };
+    kc_sched_t *s = kc_sched_init(&o);
+    assert(s);
+    assert(kc_sched_set_watchdog(s, STALL_MS, 0x80, NULL, NULL) == -EINVAL);
+    assert(kc_sched_set_watchdog(s, STALL_MS, KC_SCHED_WATCHDOG_STACK, on_stall, NULL) == 0);
+    atomic_store(&g_nev, 0);
+    atomic_store(&g_done, 0);
+    assert(kc_spawn_co(s, spin_co, NULL, 0, NULL) == 0);
+    assert(kc_spawn_co(s, sleep_co, NULL, 0, NULL) == 0);
+    wait_done(2);
+    usleep(2 * STALL_MS * 1000);
+    const kc_sched_stall_t *a = NULL, *b = NULL;
+    int n = atomic_load(&g_nev);
+    for (int i = 0; i < n && i < 16; i++) {
+        if (g_ev[i].kind != KC_STALL_RUN) continue;
+        if (g_ev[i].co_id == atomic_load(&g_ids[0])) { assert(!a); a = &g_ev[i]; }
+        if (g_ev[i].co_id == atomic_load(&g_ids[1])) { assert(!b); b = &g_ev[i]; }
+    }
+    assert(a && b);
+    assert(strcmp(a->co_name, "spinner") == 0 && strcmp(b->co_name, "sleeper") == 0);
+    assert(a->stalled_ns >= STALL_MS * 1000000ull && b->stalled_ns >= STALL_MS * 1000000ull);
+    assert(a->npc >= 1 && b->npc >= 1);
+    kc_sched_stats_t st;
+    kc_sched_get_stats(s, &st);
+    assert(st.stalls_run >= 2);
+    printf("[watchdog] runs: %lu run stalls, %d + %d frames sampled\n", st.stalls_run, a->npc, b->npc);
+    kc_sched_shutdown(s);
+}
+
+static void test_queues(void){
+    kc_sched_opts_t o = { .workers = 1 };
+    kc_sched_t *s = kc_sched_init(&o);
+    assert(s);
+    assert(kc_sched_set_watchdog(s, STALL_MS, 0, on_stall, NULL) == 0);
+    atomic_store(&g_nev, 0);
+    atomic_store(&g_done, 0);
+    /* Spawned from the worker: its own deque */
+    assert(kc_spawn(s, hog_task, s) == 0);
+    wait_done(4);
+    const kc_sched_stall_t *q = find(KC_STALL_QUEUE, 0, 0);
+    assert(q && q->queued >= 1 && q->stalled_ns >= STALL_MS * 1000000ull);
+    /* Spawned from outside behind a hog: the shared queues */
+    atomic_store(&g_done, 0);
+    assert(kc_spawn(s, hog_task, s) == 0);
+    usleep(10000);
+    for (int i = 0; i < 3; i++) assert(kc_spawn(s, noop, NULL) == 0);
+    wait_done(7);
+    assert(find(KC_STALL_QUEUE, -1, 0) != NULL);
+    kc_sched_stats_t st;
+    kc_sched_get_stats(s, &st);
+    assert(st.stalls_queue >= 2 && st.stalls_run == 0);
+    /* Off */
+    assert(kc_sched_set_watchdog(s, 0, 0, NULL, NULL) == 0);
+    atomic_store(&g_nev, 0);
+    atomic_store(&g_done, 0);
+    assert(kc_spawn(s, hog_task, s) == 0);
+    wait_done(4);
+    assert(atomic_load(&g_nev) == 0);
+    kc_sched_shutdown(s);
+}
+
+int main(void){
+    test_runs();
+    test_queues();
+    printf("[watchdog] ok\n");
+    return 0;
+}
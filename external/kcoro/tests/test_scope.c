@@ -0,0 +1,163 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Test kc_scope: many short children waited on from a thread and from a
+// parked coroutine (records recycled, so the arena stays small), a timed
+// wait that expires while a child is stuck until cancel, and an actor
+// child joined by kc_scope_cancel, and a shared-stack coroutine whose timed
+// wait is satisfied is not woken again when its deadline passes
+#include <stdio.h>
+#include <assert.h>
+#include <stdatomic.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_core.h"
+#include "../include/kcoro_port.h"
+#include "../include/kcoro_arena.h"
+
+#define CHILDREN 100000
+
+static atomic_int ran;
+static atomic_int co_done;
+static int co_rc[3];
+static kc_chan_t *idle_ch;
+static kc_scope_t *g_scope;
+static kcoro_t *g_shared;
+static atomic_int released, stray;
+
+static void leaf(void *arg)
+{
+    (void)arg;
+    atomic_fetch_add(&ran, 1);
+}
+
+static void stuck(void *arg)
+{
+    (void)arg;
+    int v;
+    if (kc_chan_recv_c(idle_ch, &v, -1, kc_scope_token(g_scope)) == KC_ECANCELED)
+        atomic_fetch_add(&ran, 1);
+}
+
+/* Waits on children it launched itself, so it must park, not block its worker. */
+static void spawner(void *arg)
+{
+    kc_scope_t *sc = (kc_scope_t*)arg;
+    for (int i = 0; i < CHILDREN / 10; i++) assert(kc_scope_launch(sc, leaf, NULL, 0, NULL) == 0);
+    co_rc[0] = kc_scope_wait_all(sc, 5000);
+    atomic_store(&co_done, 1);
+}
+
+static void timed_waiter(void *arg)
+{
+    co_rc[1] = kc_scope_wait_all((kc_scope_t*)arg, 20);
+    co_rc[2] = kc_scope_wait_all((kc_scope_t*)arg, -1);
+    atomic_store(&co_done, 1);
+}
+
+/* Parks after a satisfied timed wait: only the releaser may wake it now. */
+static void shared_waiter(void *arg)
+{
+    kc_scope_t *sc = (kc_scope_t*)arg;
+    for (int i = 0; i < 100; i++) assert(kc_scope_launch(sc, leaf, NULL, 0, NULL) == 0);
+    co_rc[0] = kc_scope_wait_all(sc, 40);
+    g_shared = kcoro_current();
+    kcoro_park();
+    while (!atomic_load(&released)) { atomic_fetch_add(&stray, 1); kcoro_park(); }
+    atomic_store(&co_done, 1);
+}
+
+static void releaser(void *arg)
+{
+    (void)arg;
+    while (!g_shared || !kcoro_is_parked(g_shared)) kc_sleep_ms(1);
+    kc_sleep_ms(120); /* past the waiter's deadline */
+    atomic_store(&released, 1);
+    kcoro_unpark(g_shared);
+}
+
+static int on_msg(const void *msg, void *user)
+{
+    (void)msg;
+    atomic_fetch_add((atomic_int*)user, 1);
+    return 0;
+}
+
+static void wait_done(void)
+{
+    for (int i = 0; i < 5000 && !atomic_load(&co_done); i++) kc_sleep_ms(1);
+    assert(atomic_load(&co_done));
+    atomic_store(&co_done, 0);
+}
+
+int main(void)
+{
+    printf("[test] scope start\n");
+    kc_sched_t *s = kc_sched_default();
+    assert(s);
+    assert(kc_chan_make(&idle_ch, KC_UNLIMITED, sizeof(int), 0) == 0);
+
+    /* Fan-out from a thread */
+    kc_scope_t *sc = NULL;
+    assert(kc_scope_init(&sc, NULL) == 0);
+    assert(kc_scope_wait_all(sc, 0) == 0);
+    for (int i = 0; i < CHILDREN; i++) assert(kc_scope_launch(sc, leaf, NULL, 0, NULL) == 0);
+    assert(kc_scope_wait_all(sc, -1) == 0);
+    assert(atomic_load(&ran) == CHILDREN);
+
+    /* From a coroutine; a second round reuses the first round's records */
+    size_t used = 0;
+    for (int round = 0; round < 2; round++) {
+        atomic_store(&ran, 0);
+        assert(kc_spawn_co(s, spawner, sc, 0, NULL) == 0);
+        wait_done();
+        assert(co_rc[0] == 0 && atomic_load(&ran) == CHILDREN / 10);
+        if (round == 0) used = kc_arena_used(kc_scope_arena(sc));
+    }
+    assert(kc_arena_used(kc_scope_arena(sc)) == used);
+    kc_scope_destroy(sc);
+
+    /* A stuck child: timed wait expires, cancel releases it */
+    atomic_store(&ran, 0);
+    assert(kc_scope_init(&g_scope, NULL) == 0);
+    assert(kc_scope_launch(g_scope, stuck, NULL, 0, NULL) == 0);
+    assert(kc_scope_wait_all(g_scope, 0) == KC_EAGAIN);
+    assert(kc_scope_wait_all(g_scope, 10) == KC_ETIME);
+    assert(kc_spawn_co(s, timed_waiter, g_scope, 0, NULL) == 0);
+    kc_sleep_ms(50);
+    kc_scope_cancel(g_scope);
+    wait_done();
+    assert(co_rc[1] == KC_ETIME && co_rc[2] == 0 && atomic_load(&ran) == 1);
+    assert(kc_scope_launch(g_scope, leaf, NULL, 0, NULL) == KC_ECANCELED);
+    kc_scope_destroy(g_scope);
+
+    /* An actor child is joined by cancel */
+    atomic_int msgs = 0;
+    kc_chan_t *mbox = NULL;
+    assert(kc_chan_make(&mbox, KC_BUFFERED, sizeof(int), 16) == 0);
+    assert(kc_scope_init(&sc, NULL) == 0);
+    kc_actor_ctx_t ctx = { .chan = mbox, .msg_size = sizeof(int), .timeout_ms = -1,
+                           .process = on_msg, .user = &msgs };
+    assert(kc_scope_actor(sc, &ctx) != NULL);
+    int v = 1;
+    assert(kc_chan_send(mbox, &v, 0) == 0);
+    for (int i = 0; i < 2000 && atomic_load(&msgs) == 0; i++) kc_sleep_ms(1);
+    assert(atomic_load(&msgs) == 1);
+    assert(kc_scope_wait_all(sc, 0) == KC_EAGAIN);
+    kc_scope_cancel(sc);
+    /* The actor's on_done may still be finishing on its own coroutine. */
+    assert(kc_scope_wait_all(sc, 2000) == 0);
+    kc_scope_destroy(sc);
+    kc_chan_destroy(mbox);
+
+    /* Shared stack: the park record must outlive the swap-out */
+    atomic_store(&ran, 0);
+    assert(kc_scope_init(&sc, NULL) == 0);
+    assert(kc_spawn_co(s, shared_waiter, sc, KCORO_STACK_SHARED, NULL) == 0);
+    assert(kc_spawn_co(s, releaser, NULL, 0, NULL) == 0);
+    wait_done();
+    assert(co_rc[0] == 0 && atomic_load(&ran) == 100 && atomic_load(&stray) == 0);
+    kc_scope_destroy(sc);
+
+    kc_chan_destroy(idle_ch);
+    printf("[test] scope ok\n");
+    return 0;
+}
@@ -0,0 +1,78 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Mass select cancellation: thousands of selects parked on one hot channel
+// (plus a second one a feeder trickles values into) time out or lose the
+// race together. Every fed value is received exactly once, and both wait
+// queues end up empty: timed-out registrations are unlinked and lost ones
+// reaped, so no stale waiter is left to pair with a later send.
+#include <stdio.h>
+#include <stdatomic.h>
+#include <assert.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_core.h"
+#include "../include/kcoro_port.h"
+#include "../core/src/kc_chan_internal.h"
+
+enum { SELECTORS = 2000, FED = 500 };
+
+static kc_chan_t *g_hot, *g_other;
+static _Atomic(int) g_done, g_won, g_timed, g_bad;
+
+static void selector(void *arg)
+{
+    (void)arg;
+    kc_select_t *sel = NULL;
+    if (kc_select_create(&sel, NULL) != 0) { atomic_fetch_add(&g_bad, 1); atomic_fetch_add(&g_done, 1); return; }
+    int vh = 0, vo = 0, idx = -2, res = 0;
+    kc_select_add_recv(sel, g_hot, &vh);
+    kc_select_add_recv(sel, g_other, &vo);
+    int rc = kc_select_wait(sel, 50, &idx, &res);
+    if (rc == 0 && idx == 1) atomic_fetch_add(&g_won, 1);
+    else if (rc == KC_ETIME && idx == -1) atomic_fetch_add(&g_timed, 1);
+    else atomic_fetch_add(&g_bad, 1);
+    kc_select_destroy(sel);
+    atomic_fetch_add(&g_done, 1);
+}
+
+static void feeder(void *arg)
+{
+    (void)arg;
+    for (int i = 0; i < FED; i++)
+        if (kc_chan_send(g_other, &i, -1) != 0) atomic_fetch_add(&g_bad, 1);
+}
+
+int main(void)
+{
+    printf("[test] select_cancel_many start\n");
+    assert(kc_chan_make(&g_hot, KC_RENDEZVOUS, sizeof(int), 0) == 0);
+    assert(kc_chan_make(&g_other, KC_BUFFERED, sizeof(int), 8) == 0);
+    kc_sched_t *s = kc_sched_default();
+    for (int i = 0; i < SELECTORS; i++) assert(kc_spawn_co(s, selector, NULL, 0, NULL) == 0);
+    kc_sleep_ms(5);
+    assert(kc_spawn_co(s, feeder, NULL, 0, NULL) == 0);
+    for (int i = 0; i < 2000 && atomic_load(&g_done) < SELECTORS; i++) kc_sleep_ms(5);
+    if (atomic_load(&g_done) != SELECTORS || atomic_load(&g_bad)) {
+        fprintf(stderr, "done=%d bad=%d\n", atomic_load(&g_done), atomic_load(&g_bad));
+        return 1;
+    }
+    if (atomic_load(&g_won) != FED || atomic_load(&g_timed) != SELECTORS - FED) {
+        fprintf(stderr, "won=%d timed=%d\n", atomic_load(&g_won), atomic_load(&g_timed));
+        return 2;
+    }
+
+    struct kc_chan *hot = (struct kc_chan*)g_hot, *other = (struct kc_chan*)g_other;
+    KC_MUTEX_LOCK(&hot->mu);
+    int left = hot->wq_recv_head != NULL || hot->wq_recv_tail != NULL;
+    KC_MUTEX_UNLOCK(&hot->mu);
+    KC_MUTEX_LOCK(&other->mu);
+    left |= other->wq_recv_head != NULL || other->wq_recv_tail != NULL;
+    KC_MUTEX_UNLOCK(&other->mu);
+    if (left) { fprintf(stderr, "waiters left queued\n"); return 3; }
+    int v = 7;
+    if (kc_chan_send(g_hot, &v, 0) != KC_EAGAIN) { fprintf(stderr, "stale receiver on hot\n"); return 4; }
+
+    kc_chan_destroy(g_hot);
+    kc_chan_destroy(g_other);
+    printf("[test] select_cancel_many ok won=%d timed=%d\n", atomic_load(&g_won), atomic_load(&g_timed));
+    return 0;
+}
@@ -0,0 +1,113 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Test parked selects: a timed select sleeps instead of polling and times out
+// on its deadline, a token wakes a parked select at once, and a reused select
+// keeps delivering after reset
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_core.h"
+#include "../include/kcoro_port.h"
+
+#define ROUNDS 2000
+
+struct ctx {
+    kc_chan_t *a, *b;
+    kc_cancel_t *tok;
+    volatile int stage, done;
+    int bad, got;
+    long timed_us, cancel_us;
+};
+
+static long now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000L + ts.tv_nsec / 1000;
+}
+
+static long cpu_us(void)
+{
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000000L + ru.ru_utime.tv_usec + ru.ru_stime.tv_usec;
+}
+
+static void selector(void *arg)
+{
+    struct ctx *c = (struct ctx*)arg;
+    kc_select_t *sel = NULL;
+    if (kc_select_create(&sel, c->tok) != 0) { c->bad++; c->done = 1; return; }
+    int va = 0, vb = 0, idx = -2, res = 0;
+
+    /* Nothing ready: times out on the deadline */
+    kc_select_add_recv(sel, c->a, &va);
+    kc_select_add_recv(sel, c->b, &vb);
+    long t0 = now_us();
+    if (kc_select_wait(sel, 200, &idx, &res) != KC_ETIME || idx != -1) c->bad++;
+    c->timed_us = now_us() - t0;
+
+    /* Reused: every round resets and re-adds, a feeder supplies b */
+    c->stage = 1;
+    for (int i = 0; i < ROUNDS; i++) {
+        kc_select_reset(sel);
+        kc_select_add_recv(sel, c->a, &va);
+        kc_select_add_recv(sel, c->b, &vb);
+        if (kc_select_wait(sel, -1, &idx, &res) != 0 || idx != 1 || vb != i) c->bad++;
+        else c->got++;
+    }
+
+    /* Parked with no deadline until the token fires */
+    c->stage = 2;
+    kc_select_reset(sel);
+    kc_select_add_recv(sel, c->a, &va);
+    if (kc_select_wait(sel, -1, &idx, &res) != KC_ECANCELED || res != KC_ECANCELED) c->bad++;
+    c->cancel_us = now_us();
+    kc_select_destroy(sel);
+    c->done = 1;
+}
+
+static void feeder(void *arg)
+{
+    struct ctx *c = (struct ctx*)arg;
+    while (c->stage < 1) kc_sleep_ms(1);
+    for (int i = 0; i < ROUNDS; i++)
+        if (kc_chan_send(c->b, &i, -1) != 0) c->bad++;
+}
+
+int main(void)
+{
+    struct ctx c = { 0 };
+    assert(kc_chan_make(&c.a, KC_BUFFERED, sizeof(int), 4) == 0);
+    assert(kc_chan_make(&c.b, KC_RENDEZVOUS, sizeof(int), 0) == 0);
+    assert(kc_cancel_init(&c.tok) == 0);
+
+    long cpu0 = cpu_us();
+    assert(kc_spawn_co(kc_sched_default(), selector, &c, 0, NULL) == 0);
+    while (c.stage < 1) usleep(1000);
+    long cpu = cpu_us() - cpu0;
+    assert(c.timed_us >= 195000 && c.timed_us < 1000000);
+    /* A polling select burns the whole 200 ms; a parked one next to none */
+    assert(cpu < 50000);
+
+    assert(kc_spawn_co(kc_sched_default(), feeder, &c, 0, NULL) == 0);
+    while (c.stage < 2) usleep(1000);
+    usleep(20000);
+    assert(!c.done);
+    long t0 = now_us();
+    kc_cancel_trigger(c.tok);
+    for (int i = 0; i < 2000 && !c.done; i++) usleep(500);
+    assert(c.done && c.bad == 0 && c.got == ROUNDS);
+    assert(c.cancel_us - t0 < 20000);
+
+    kc_cancel_destroy(c.tok);
+    kc_chan_destroy(c.b);
+    kc_chan_destroy(c.a);
+    printf("[select park] ok timeout=%ldus cpu=%ldus cancel=%ldus rounds=%d\n",
+           c.timed_us, cpu, c.cancel_us - t0, c.got);
+    return 0;
+}
@@ -0,0 +1,104 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Test select policies: with a busy channel always ready, registration order
+// starves a quiet one while random, round-robin and priority orders reach
+// it, and per-clause stats record wins, first probes and the policy
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <assert.h>
+#include <unistd.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_core.h"
+#include "../include/kcoro_port.h"
+
+#define WAITS 200
+
+struct ctx {
+    kc_chan_t *busy, *quiet;
+    volatile int done;
+    int bad;
+    int wins[4];
+};
+
+/* Keep busy full and quiet holding one element. */
+static void refill(struct ctx *c)
+{
+    int v = 1;
+    while (kc_chan_send(c->busy, &v, 0) == 0) {}
+    if (kc_chan_len(c->quiet) == 0) (void)kc_chan_send(c->quiet, &v, 0);
+}
+
+/* Quiet-channel wins over WAITS selects under policy p. */
+static int run(struct ctx *c, kc_select_t *sel, enum kc_select_policy p)
+{
+    int va = 0, vb = 0, idx = -1, res = 0, quiet = 0, last = -1;
+    if (kc_select_set_policy(sel, p) != 0) c->bad++;
+    for (int i = 0; i < WAITS; i++) {
+        refill(c);
+        kc_select_reset(sel);
+        kc_select_add_recv(sel, c->busy, &va);
+        kc_select_add_recv(sel, c->quiet, &vb);
+        if (p == KC_SELECT_POLICY_PRIORITY && kc_select_set_priority(sel, 1, 10) != 0) c->bad++;
+        if (kc_select_wait(sel, -1, &idx, &res) != 0 || (idx != 0 && idx != 1)) { c->bad++; continue; }
+        if (p == KC_SELECT_POLICY_ROUND_ROBIN && idx == last) c->bad++;
+        last = idx;
+        quiet += idx == 1;
+    }
+    return quiet;
+}
+
+static void body(void *arg)
+{
+    struct ctx *c = (struct ctx*)arg;
+    kc_select_t *sel = NULL;
+    if (kc_select_create(&sel, NULL) != 0) { c->bad++; c->done = 1; return; }
+    c->wins[KC_SELECT_POLICY_ORDERED] = run(c, sel, KC_SELECT_POLICY_ORDERED);
+    c->wins[KC_SELECT_POLICY_RANDOM] = run(c, sel, KC_SELECT_POLICY_RANDOM);
+
+    /* Stats accumulate by position across resets */
+    struct kc_select_clause_stats st0, st1;
+    if (kc_select_get_clause_stats(sel, 0, &st0) != 0 || kc_select_get_clause_stats(sel, 1, &st1) != 0) c->bad++;
+    if (st0.wins + st1.wins != 2 * WAITS || st1.wins != (unsigned long)c->wins[KC_SELECT_POLICY_RANDOM]) c->bad++;
+    if (st0.first + st1.first != 2 * WAITS || st1.first == 0) c->bad++;
+    if (st0.policy != KC_SELECT_POLICY_RANDOM) c->bad++;
+
+    c->wins[KC_SELECT_POLICY_ROUND_ROBIN] = run(c, sel, KC_SELECT_POLICY_ROUND_ROBIN);
+    c->wins[KC_SELECT_POLICY_PRIORITY] = run(c, sel, KC_SELECT_POLICY_PRIORITY);
+    if (kc_select_get_clause_stats(sel, 1, &st1) != 0 || st1.priority != 10 ||
+        st1.policy != KC_SELECT_POLICY_PRIORITY) c->bad++;
+
+    /* A parked wait books its winner too */
+    int v = 0, idx = -1, res = 0;
+    while (kc_chan_recv(c->busy, &v, 0) == 0) {}
+    while (kc_chan_recv(c->quiet, &v, 0) == 0) {}
+    if (kc_select_wait(sel, 0, &idx, &res) != KC_EAGAIN) c->bad++;
+    if (kc_select_get_clause_stats(sel, 1, &st0) != 0) c->bad++;
+    if (kc_select_wait(sel, 20, &idx, &res) != KC_ETIME || idx != -1) c->bad++;
+    if (kc_select_get_clause_stats(sel, 1, &st1) != 0 || st1.wins != st0.wins || st1.first != st0.first + 1) c->bad++;
+
+    if (kc_select_set_policy(sel, (enum kc_select_policy)9) != -EINVAL) c->bad++;
+    if (kc_select_set_priority(sel, 2, 1) != -EINVAL || kc_select_get_clause_stats(sel, -1, &st0) != -EINVAL) c->bad++;
+    kc_select_destroy(sel);
+    c->done = 1;
+}
+
+int main(void)
+{
+    static struct ctx c;
+    assert(kc_chan_make(&c.busy, KC_BUFFERED, sizeof(int), 64) == 0);
+    assert(kc_chan_make(&c.quiet, KC_BUFFERED, sizeof(int), 4) == 0);
+    assert(kc_spawn_co(kc_sched_default(), body, &c, 0, NULL) == 0);
+    for (int i = 0; i < 5000 && !c.done; i++) usleep(1000);
+    assert(c.done && c.bad == 0);
+    /* Ordered never reaches the quiet channel; the others do */
+    assert(c.wins[KC_SELECT_POLICY_ORDERED] == 0);
+    assert(c.wins[KC_SELECT_POLICY_RANDOM] > WAITS / 4 && c.wins[KC_SELECT_POLICY_RANDOM] < WAITS * 3 / 4);
+    assert(c.wins[KC_SELECT_POLICY_ROUND_ROBIN] == WAITS / 2);
+    assert(c.wins[KC_SELECT_POLICY_PRIORITY] == WAITS);
+    kc_chan_destroy(c.busy);
+    kc_chan_destroy(c.quiet);
+    printf("[select policy] ok quiet wins: ordered=%d random=%d rr=%d prio=%d of %d\n",
+           c.wins[0], c.wins[1], c.wins[2], c.wins[3], WAITS);
+    return 0;
+}
@@ -0,0 +1,85 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Fan-in harvest: one coroutine drains 16 buffered channels with
+// kc_select_wait_many, adding the clauses once. Every value arrives exactly
+// once and in order per channel; with all channels pre-filled each call
+// takes one element from each, so the drain takes far fewer calls than
+// elements. An empty select parks and wakes for a late send, and closed
+// channels are reported with KC_EPIPE.
+#include <stdio.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <assert.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_port.h"
+
+enum { CH = 16, PER = 32 };
+
+static kc_chan_t *g_ch[CH];
+static int g_buf[CH];
+static _Atomic(int) g_done, g_bad, g_calls, g_got, g_parked, g_closed;
+
+static void fan_in(void *arg){
+    (void)arg;
+    kc_select_t *sel = NULL;
+    if (kc_select_create(&sel, NULL) != 0) { atomic_fetch_add(&g_bad, 1); atomic_store(&g_done, 1); return; }
+    for (int c = 0; c < CH; c++) kc_select_add_recv(sel, g_ch[c], &g_buf[c]);
+    int idx[CH], res[CH], n = -1, next[CH] = {0};
+    if (kc_select_wait_many(sel, 0, idx, res, 0, &n) != -EINVAL || n != 0) atomic_fetch_add(&g_bad, 1);
+
+    /* Pre-filled: harvest until empty. */
+    while (atomic_load(&g_got) < CH * PER) {
+        int rc = kc_select_wait_many(sel, 0, idx, res, CH, &n);
+        if (rc != 0 || n <= 0) { atomic_fetch_add(&g_bad, 1); break; }
+        atomic_fetch_add(&g_calls, 1);
+        for (int k = 0; k < n; k++) {
+            int c = idx[k];
+            if (res[k] != 0 || g_buf[c] != next[c]) atomic_fetch_add(&g_bad, 1);
+            next[c]++;
+            atomic_fetch_add(&g_got, 1);
+        }
+    }
+    if (kc_select_wait_many(sel, 0, idx, res, CH, &n) != KC_EAGAIN || n != 0) atomic_fetch_add(&g_bad, 1);
+
+    /* Empty: park until main sends on channel 5. */
+    atomic_store(&g_parked, 1);
+    int rc = kc_select_wait_many(sel, 2000, idx, NULL, CH, &n);
+    if (rc != 0 || n != 1 || idx[0] != 5 || g_buf[5] != 99) atomic_fetch_add(&g_bad, 1);
+    if (kc_select_wait_many(sel, 5, idx, res, CH, &n) != KC_ETIME || n != 0) atomic_fetch_add(&g_bad, 1);
+
+    /* Closed: every clause completes with KC_EPIPE. */
+    while (!atomic_load(&g_closed)) kc_sleep_ms(1);
+    rc = kc_select_wait_many(sel, -1, idx, res, CH, &n);
+    if (rc != 0 || n != CH) atomic_fetch_add(&g_bad, 1);
+    for (int k = 0; k < n; k++) if (res[k] != KC_EPIPE) atomic_fetch_add(&g_bad, 1);
+
+    struct kc_select_clause_stats cs;
+    if (kc_select_get_clause_stats(sel, 3, &cs) != 0 || cs.wins < PER) atomic_fetch_add(&g_bad, 1);
+    kc_select_destroy(sel);
+    atomic_store(&g_done, 1);
+}
+
+int main(void){
+    printf("[test] select_wait_many start\n");
+    for (int c = 0; c < CH; c++) {
+        assert(kc_chan_make(&g_ch[c], KC_BUFFERED, sizeof(int), PER) == 0);
+        for (int i = 0; i < PER; i++) assert(kc_chan_send(g_ch[c], &i, 0) == 0);
+    }
+    assert(kc_spawn_co(kc_sched_default(), fan_in, NULL, 0, NULL) == 0);
+    for (int i = 0; i < 2000 && !atomic_load(&g_parked); i++) kc_sleep_ms(1);
+    kc_sleep_ms(10);
+    int v = 99;
+    assert(kc_chan_send(g_ch[5], &v, 0) == 0);
+    kc_sleep_ms(20);
+    for (int c = 0; c < CH; c++) kc_chan_close(g_ch[c]);
+    atomic_store(&g_closed, 1);
+    for (int i = 0; i < 2000 && !atomic_load(&g_done); i++) kc_sleep_ms(1);
+    if (!atomic_load(&g_done) || atomic_load(&g_bad) || atomic_load(&g_calls) > PER + 1) {
+        fprintf(stderr, "done=%d bad=%d calls=%d\n", atomic_load(&g_done), atomic_load(&g_bad),
+                atomic_load(&g_calls));
+        return 1;
+    }
+    for (int c = 0; c < CH; c++) kc_chan_destroy(g_ch[c]);
+    printf("[test] select_wait_many ok elements=%d calls=%d\n", CH * PER, atomic_load(&g_calls));
+    return 0;
+}
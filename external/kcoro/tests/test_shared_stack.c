@@ -0,0 +1,182 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Shared-stack (copy-on-switch) coroutines
+// 1) many KCORO_STACK_SHARED coroutines interleaved by hand keep their locals,
+//    pointers into their own frames and deep call chains across yields, and
+//    own no stack while suspended.
+// 2) a private-stack coroutine can drive a shared one.
+// 3) under the work-stealing scheduler, shared and private coroutines mixed
+//    together yield and sleep across workers and all finish with the right
+//    results.
+// 4) shared-stack coroutines whose timed channel recv and timed select are
+//    satisfied before the deadline are not woken again when it passes (the
+//    park records must not sit on the swapped-out stack).
+#include <stdio.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <assert.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_core.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_port.h"
+#include "../include/kcoro_config.h"
+
+enum { MANUAL = 1000, ROUNDS = 5, SPAWNS = 20000, TIMED = 32, TIMED_MS = 40 };
+
+static long g_sum[MANUAL];
+static _Atomic(long) g_sched_sum;
+static _Atomic(int) g_sched_done;
+
+static kc_chan_t *g_tch, *g_tsel;
+static kcoro_t *g_timed[TIMED];
+static _Atomic(int) g_timed_parked, g_timed_ok, g_timed_stray, g_timed_done;
+static _Atomic(int) g_released;
+
+static long deep_sum(int depth, volatile long *acc){
+    volatile char pad[256];
+    pad[0] = (char)depth;
+    if (depth == 0) return *acc;
+    *acc += depth;
+    return deep_sum(depth - 1, acc) + pad[0] - (char)depth;
+}
+
+static void manual_task(void *arg){
+    int idx = (int)(intptr_t)arg;
+    long local[8];
+    long *self = local; /* an absolute address inside this frame */
+    for (int i = 0; i < 8; i++) local[i] = idx * 8 + i;
+    for (int r = 0; r < ROUNDS; r++) {
+        volatile long acc = 0;
+        long d = deep_sum(20 + idx % 7, &acc);
+        kcoro_yield();
+        for (int i = 0; i < 8; i++) self[i] += d;
+    }
+    long sum = 0;
+    for (int i = 0; i < 8; i++) sum += local[i];
+    g_sum[idx] = sum;
+}
+
+static long expected_manual(int idx){
+    long base = 0, d = 0;
+    for (int i = 0; i < 8; i++) base += idx * 8 + i;
+    for (int k = 1; k <= 20 + idx % 7; k++) d += k;
+    return base + 8L * ROUNDS * d;
+}
+
+static void driver(void *arg){
+    kcoro_t *inner = (kcoro_t*)arg;
+    while (inner->state != KCORO_FINISHED) {
+        kcoro_resume(inner);
+        kcoro_yield();
+    }
+}
+
+static void sched_task(void *arg){
+    long v = (long)(intptr_t)arg;
+    long keep[4] = { v, v * 2, v * 3, v * 4 };
+    kc_yield();
+    if ((v & 63) == 0) kc_sleep_ms(1);
+    kc_yield();
+    atomic_fetch_add(&g_sched_sum, keep[0] + keep[1] + keep[2] + keep[3]);
+    atomic_fetch_add(&g_sched_done, 1);
+}
+
+static void timed_task(void *arg){
+    int idx = (int)(intptr_t)arg;
+    int v = 0, sel_idx = -1, sel_rc = -1;
+    if (kc_chan_recv(g_tch, &v, TIMED_MS) == 0) atomic_fetch_add(&g_timed_ok, 1);
+    kc_select_t *sel = NULL;
+    assert(kc_select_create(&sel, NULL) == 0);
+    assert(kc_select_add_recv(sel, g_tsel, &v) == 0);
+    if (kc_select_wait(sel, TIMED_MS, &sel_idx, &sel_rc) == 0 && sel_rc == 0)
+        atomic_fetch_add(&g_timed_ok, 1);
+    kc_select_destroy(sel);
+    g_timed[idx] = kcoro_current();
+    atomic_fetch_add(&g_timed_parked, 1);
+    /* Only the releaser may wake us; a stale deadline timer would too. */
+    kcoro_park();
+    while (!atomic_load(&g_released)) { atomic_fetch_add(&g_timed_stray, 1); kcoro_park(); }
+    atomic_fetch_add(&g_timed_done, 1);
+}
+
+static void timed_feeder(void *arg){
+    (void)arg;
+    kc_sleep_ms(2);
+    for (int i = 0; i < TIMED; i++) { int v = i; (void)kc_chan_send(g_tch, &v, -1); }
+    kc_sleep_ms(2);
+    for (int i = 0; i < TIMED; i++) { int v = i; (void)kc_chan_send(g_tsel, &v, -1); }
+    while (atomic_load(&g_timed_parked) < TIMED) kc_sleep_ms(1);
+    for (int i = 0; i < TIMED; i++) while (!kcoro_is_parked(g_timed[i])) kc_yield();
+    kc_sleep_ms(3 * TIMED_MS); /* past every deadline */
+    atomic_store(&g_released, 1);
+    for (int i = 0; i < TIMED; i++) kcoro_unpark(g_timed[i]);
+}
+
+int main(void){
+    printf("[test] shared_stack start\n");
+    kcoro_t *main_co = kcoro_create_main(); assert(main_co);
+
+    static kcoro_t *cos[MANUAL];
+    for (int i = 0; i < MANUAL; i++) {
+        cos[i] = kcoro_create(manual_task, (void*)(intptr_t)i, KCORO_STACK_SHARED); assert(cos[i]);
+        assert(!cos[i]->stack_ptr && cos[i]->share);
+    }
+    int live = MANUAL;
+    while (live) {
+        live = 0;
+        for (int i = 0; i < MANUAL; i++) {
+            if (cos[i]->state == KCORO_FINISHED) continue;
+            kcoro_resume(cos[i]);
+            if (cos[i]->state != KCORO_FINISHED) { live++; assert(!cos[i]->stack_ptr); }
+        }
+    }
+    for (int i = 0; i < MANUAL; i++) {
+        if (g_sum[i] != expected_manual(i)) {
+            fprintf(stderr, "co %d sum=%ld want=%ld\n", i, g_sum[i], expected_manual(i)); return 1;
+        }
+        kcoro_destroy(cos[i]);
+    }
+
+    g_sum[0] = 0;
+    kcoro_t *inner = kcoro_create(manual_task, (void*)(intptr_t)0, KCORO_STACK_SHARED); assert(inner);
+    kcoro_t *outer = kcoro_create(driver, inner, 0); assert(outer);
+    while (outer->state != KCORO_FINISHED) kcoro_resume(outer);
+    if (g_sum[0] != expected_manual(0)) { fprintf(stderr, "driven sum=%ld\n", g_sum[0]); return 2; }
+    kcoro_destroy(inner);
+    kcoro_destroy(outer);
+
+    kc_sched_opts_t opts = {0};
+    opts.workers = 4;
+    kc_sched_t *s = kc_sched_init(&opts); assert(s);
+    long want = 0;
+    for (int i = 0; i < SPAWNS; i++) {
+        size_t st = (i % 4 == 3) ? 0 : KCORO_STACK_SHARED;
+        assert(kc_spawn_co(s, sched_task, (void*)(intptr_t)i, st, NULL) == 0);
+        want += 10L * i;
+    }
+    for (int i = 0; i < 2000 && atomic_load(&g_sched_done) < SPAWNS; i++) kc_sleep_ms(5);
+    kc_sched_shutdown(s);
+    if (atomic_load(&g_sched_done) != SPAWNS || atomic_load(&g_sched_sum) != want) {
+        fprintf(stderr, "sched done=%d sum=%ld want=%ld\n", atomic_load(&g_sched_done),
+                atomic_load(&g_sched_sum), want); return 3;
+    }
+
+    opts.workers = 2;
+    s = kc_sched_init(&opts); assert(s);
+    assert(kc_chan_make(&g_tch, KC_BUFFERED, sizeof(int), 4) == 0);
+    assert(kc_chan_make(&g_tsel, KC_BUFFERED, sizeof(int), 4) == 0);
+    for (int i = 0; i < TIMED; i++)
+        assert(kc_spawn_co(s, timed_task, (void*)(intptr_t)i, KCORO_STACK_SHARED, NULL) == 0);
+    assert(kc_spawn_co(s, timed_feeder, NULL, 0, NULL) == 0);
+    for (int i = 0; i < 2000 && atomic_load(&g_timed_done) < TIMED; i++) kc_sleep_ms(5);
+    kc_sched_shutdown(s);
+    if (atomic_load(&g_timed_done) != TIMED || atomic_load(&g_timed_stray) != 0 ||
+        atomic_load(&g_timed_ok) == 0) {
+        fprintf(stderr, "timed done=%d stray=%d ok=%d\n", atomic_load(&g_timed_done),
+                atomic_load(&g_timed_stray), atomic_load(&g_timed_ok)); return 4;
+    }
+    kc_chan_destroy(g_tch);
+    kc_chan_destroy(g_tsel);
+    printf("[test] shared_stack ok manual=%d spawns=%d timed_ok=%d\n", MANUAL, SPAWNS,
+           atomic_load(&g_timed_ok));
+    return 0;
+}
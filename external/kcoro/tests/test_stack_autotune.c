@@ -0,0 +1,95 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Stack autotuning per spawn site
+// 1) under a 1 MiB default, a shallow entry function keeps the default for
+//    its first KCORO_STACK_TUNE_SAMPLES coroutines and then gets the
+//    smallest class; a deeper one gets a class with headroom above its
+//    peak; explicit sizes are left alone and lazy stacks follow the site.
+// 2) a coroutine deeper than its tuned stack's headroom is an anomaly: it
+//    is counted for its site and overall, and the site's size grows.
+// 3) with autotune off, default-size requests take the default again.
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_core.h"
+#include "../include/kcoro_config.h"
+
+#define KIB 1024u
+#define DEFAULT_SZ (1024u * KIB)
+
+/* Recurses through about n bytes of stack in small frames (one large frame
+ * would be probed page by page under -fstack-clash-protection). */
+static __attribute__((noinline)) size_t dig(size_t n){
+    volatile char buf[512];
+    memset((char*)buf, 0x5a, sizeof(buf));
+    return (n > sizeof(buf) ? dig(n - sizeof(buf)) : 0) + (size_t)buf[0];
+}
+
+static void shallow(void *arg){ (void)dig(*(size_t*)arg); }
+static void deep(void *arg){ (void)dig(*(size_t*)arg); }
+static void varied(void *arg){ (void)dig(*(size_t*)arg); }
+
+/* Create, run and destroy one coroutine; returns its stack size. */
+static size_t run(kcoro_fn_t fn, size_t depth, size_t stack){
+    kcoro_t *co = kcoro_create(fn, &depth, stack);
+    assert(co);
+    size_t sz = co->stack_size;
+    kcoro_resume(co);
+    kcoro_destroy(co);
+    return sz;
+}
+
+static const struct kcoro_stack_site *find(struct kcoro_stack_site *sites, size_t n, kcoro_fn_t fn){
+    for (size_t i = 0; i < n; i++) if (sites[i].fn == fn) return &sites[i];
+    return NULL;
+}
+
+int main(void){
+    printf("[test] stack_autotune start\n");
+    kcoro_t *main_co = kcoro_create_main(); assert(main_co);
+    kcoro_stack_set_default_size(DEFAULT_SZ);
+    kcoro_stack_autotune(1);
+
+    for (int i = 0; i < KCORO_STACK_TUNE_SAMPLES; i++) {
+        assert(run(shallow, 2 * KIB, 0) == DEFAULT_SZ);
+        run(deep, 20 * KIB, 0);
+        run(varied, 2 * KIB, 0);
+    }
+    size_t small = run(shallow, 2 * KIB, 0);
+    size_t big = run(deep, 20 * KIB, 0);
+    if (small != KCORO_STACK_CLASS_MIN || big < 32 * KIB || big >= DEFAULT_SZ) {
+        fprintf(stderr, "tuned shallow=%zu deep=%zu\n", small, big); return 1;
+    }
+    assert(run(shallow, 2 * KIB, 256 * KIB) == 256 * KIB);
+    kcoro_t *lazy = kcoro_create(shallow, NULL, KCORO_STACK_LAZY);
+    assert(lazy && lazy->stack_size == KCORO_STACK_CLASS_MIN);
+    kcoro_destroy(lazy);
+
+    /* 10 KiB fits a 16 KiB stack, but not with 50% headroom */
+    struct kcoro_stack_pool_stats st;
+    assert(run(varied, 2 * KIB, 0) == KCORO_STACK_CLASS_MIN);
+    assert(run(varied, 10 * KIB, 0) == KCORO_STACK_CLASS_MIN);
+    size_t grown = run(varied, 2 * KIB, 0);
+    kcoro_stack_pool_get_stats(&st);
+    struct kcoro_stack_site sites[16];
+    size_t nsites = kcoro_stack_sites(sites, 16);
+    const struct kcoro_stack_site *v = find(sites, nsites, varied);
+    const struct kcoro_stack_site *sh = find(sites, nsites, shallow);
+    if (grown <= KCORO_STACK_CLASS_MIN || !v || v->anomalies != 1 || v->size != grown ||
+        !sh || sh->anomalies || st.tune_anomalies != 1 || st.tuned_sites != 3) {
+        fprintf(stderr, "grown=%zu anomalies=%lu/%lu tuned_sites=%zu\n", grown,
+                v ? v->anomalies : 0ul, st.tune_anomalies, st.tuned_sites);
+        return 2;
+    }
+    if (nsites != 3 || sh->samples < KCORO_STACK_TUNE_SAMPLES || sh->peak > 8 * KIB) {
+        fprintf(stderr, "sites=%zu samples=%lu peak=%zu\n", nsites, sh ? sh->samples : 0ul, sh ? sh->peak : 0);
+        return 3;
+    }
+
+    kcoro_stack_autotune(0);
+    assert(run(shallow, 2 * KIB, 0) == DEFAULT_SZ);
+    kcoro_stack_set_default_size(0);
+    kcoro_stack_pool_trim();
+    printf("[test] stack_autotune ok shallow=%zu deep=%zu grown=%zu (default %u)\n", small, big, grown, DEFAULT_SZ);
+    return 0;
+}
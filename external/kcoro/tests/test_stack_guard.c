@@ -0,0 +1,103 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Guarded, lazily committed stacks and high-water reporting
+// 1) with a 1 MiB default, a thousand suspended coroutines cost only the
+//    pages they touched, not their reservation.
+// 2) kcoro_stack_high_water tells a shallow coroutine from a deep one, and
+//    with tracking on the pool stats carry the aggregate max/mean.
+// 3) the page below a stack is a guard: writing to it kills the process with
+//    SIGSEGV instead of landing in a neighbouring mapping.
+#include <stdio.h>
+#include <signal.h>
+#include <assert.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_core.h"
+#include "../include/kcoro_config.h"
+
+enum { MANY = 1000, DEEP = 256 * 1024 };
+
+static void shallow(void *arg){
+    (void)arg;
+    volatile char buf[512];
+    for (size_t i = 0; i < sizeof(buf); i += 64) buf[i] = 1;
+    kcoro_yield();
+}
+
+static void deep(void *arg){
+    (void)arg;
+    volatile char buf[DEEP];
+    for (size_t i = 0; i < sizeof(buf); i += 1024) buf[i] = 2;
+    kcoro_yield();
+}
+
+static long resident_kb(void){
+    long pages = 0, res = 0;
+    FILE *f = fopen("/proc/self/statm", "r");
+    if (!f) return -1;
+    if (fscanf(f, "%ld %ld", &pages, &res) != 2) res = -1;
+    fclose(f);
+    return res < 0 ? -1 : res * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+int main(void){
+    printf("[test] stack_guard start\n");
+    kcoro_t *main_co = kcoro_create_main(); assert(main_co);
+    kcoro_stack_set_default_size(1024 * 1024);
+
+    static kcoro_t *cos[MANY];
+    long rss0 = resident_kb();
+    for (int i = 0; i < MANY; i++) {
+        cos[i] = kcoro_create(shallow, NULL, 0); assert(cos[i]);
+        kcoro_resume(cos[i]);
+    }
+    assert(cos[0]->stack_size == 1024 * 1024);
+    long rss1 = resident_kb();
+    /* reservation is ~1 GiB; a few touched pages each must stay far below */
+    if (rss0 >= 0 && rss1 - rss0 > MANY * 64L) {
+        fprintf(stderr, "rss grew %ld KiB for %d coroutines\n", rss1 - rss0, MANY); return 1;
+    }
+
+    size_t low = kcoro_stack_high_water(cos[0]);
+    if (low == 0 || low > 64 * 1024) { fprintf(stderr, "shallow hwm=%zu\n", low); return 2; }
+    for (int i = 0; i < MANY; i++) kcoro_destroy(cos[i]);
+
+    kcoro_stack_track_high_water(1);
+    struct kcoro_stack_pool_stats st0, st;
+    kcoro_stack_pool_get_stats(&st0);
+    kcoro_t *d = kcoro_create(deep, NULL, 0); assert(d);
+    kcoro_resume(d);
+    size_t high = kcoro_stack_high_water(d);
+    if (high < DEEP || high >= d->stack_size) { fprintf(stderr, "deep hwm=%zu\n", high); return 3; }
+    kcoro_t *s = kcoro_create(shallow, NULL, 0); assert(s);
+    kcoro_resume(s);
+    kcoro_destroy(d);
+    kcoro_destroy(s);
+    kcoro_stack_pool_get_stats(&st);
+    if (st.high_water_samples - st0.high_water_samples != 2 || st.high_water_max < DEEP ||
+        st.high_water_sum - st0.high_water_sum < DEEP) {
+        fprintf(stderr, "stats samples=%lu max=%zu\n", st.high_water_samples, st.high_water_max); return 4;
+    }
+    kcoro_stack_track_high_water(0);
+
+#if KCORO_STACK_GUARD_PAGES
+    kcoro_t *g = kcoro_create(shallow, NULL, 16 * 1024); assert(g);
+    fflush(stdout);
+    pid_t pid = fork();
+    assert(pid >= 0);
+    if (pid == 0) {
+        ((volatile char*)g->stack_ptr)[-1] = 1;
+        _exit(0);
+    }
+    int status = 0;
+    assert(waitpid(pid, &status, 0) == pid);
+    if (!WIFSIGNALED(status) || (WTERMSIG(status) != SIGSEGV && WTERMSIG(status) != SIGBUS)) {
+        fprintf(stderr, "write below stack did not fault (status=%d)\n", status); return 5;
+    }
+    kcoro_destroy(g);
+#endif
+
+    kcoro_stack_set_default_size(0);
+    printf("[test] stack_guard ok rss=+%ldKiB shallow=%zu deep=%zu\n", rss1 - rss0, low, high);
+    return 0;
+}
@@ -0,0 +1,93 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Coroutine stack pool
+// 1) destroyed coroutines' stacks are reused by later kcoro_create calls of
+//    the same size class; the high-water marks bound what is kept and the
+//    rest is unmapped; trim empties the depot.
+// 2) a recycled stack is fully usable (the coroutine runs and writes deep).
+// 3) stacks freed on scheduler workers come back through the depot while
+//    many short coroutines are spawned and finish.
+#include <stdio.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <assert.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_core.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_port.h"
+#include "../include/kcoro_config.h"
+
+enum { N = 40, SPAWNS = 20000 };
+
+static _Atomic(int) g_done;
+static int g_touched;
+
+static void touch_stack(void *arg){
+    (void)arg;
+    volatile char deep[32 * 1024];
+    memset((char*)deep, 0x5a, sizeof(deep));
+    g_touched = deep[0] == 0x5a && deep[sizeof(deep) - 1] == 0x5a;
+    kcoro_yield();
+}
+
+static void short_task(void *arg){
+    (void)arg;
+    atomic_fetch_add(&g_done, 1);
+}
+
+int main(void){
+    printf("[test] stack_pool start\n");
+    kcoro_t *main_co = kcoro_create_main(); assert(main_co);
+    struct kcoro_stack_pool_stats st0, st;
+
+    kcoro_stack_pool_set_limits(8, 16);
+    kcoro_stack_pool_get_stats(&st0);
+    kcoro_t *cos[N];
+    for (int i = 0; i < N; i++) { cos[i] = kcoro_create(touch_stack, NULL, 48 * 1024); assert(cos[i]); }
+    assert(cos[0]->stack_size == 64 * 1024); /* rounded up to its class */
+    kcoro_stack_pool_get_stats(&st);
+    if (st.mapped - st0.mapped != N) { fprintf(stderr, "mapped=%lu\n", st.mapped - st0.mapped); return 1; }
+    for (int i = 0; i < N; i++) kcoro_destroy(cos[i]);
+    kcoro_stack_pool_get_stats(&st);
+    /* at most 8 stay per thread, 16 fill the depot, the rest is unmapped */
+    size_t kept = st.thread_stacks + st.depot_stacks;
+    if (st.thread_stacks > 8 || st.depot_stacks != 16 || kept + (st.unmapped - st0.unmapped) != N) {
+        fprintf(stderr, "kept thread=%zu depot=%zu unmapped=%lu\n",
+                st.thread_stacks, st.depot_stacks, st.unmapped - st0.unmapped); return 2;
+    }
+
+    st0 = st;
+    for (int i = 0; i < N; i++) { cos[i] = kcoro_create(touch_stack, NULL, 64 * 1024); assert(cos[i]); }
+    kcoro_stack_pool_get_stats(&st);
+    if (st.reused - st0.reused != kept || st.mapped - st0.mapped != N - kept) {
+        fprintf(stderr, "reused=%lu mapped=%lu\n", st.reused - st0.reused, st.mapped - st0.mapped); return 3;
+    }
+    kcoro_resume(cos[0]);
+    if (!g_touched) { fprintf(stderr, "recycled stack unusable\n"); return 4; }
+    for (int i = 0; i < N; i++) kcoro_destroy(cos[i]);
+
+    kcoro_stack_pool_trim();
+    kcoro_stack_pool_get_stats(&st);
+    if (st.thread_stacks || st.depot_stacks || st.depot_bytes) {
+        fprintf(stderr, "trim left thread=%zu depot=%zu\n", st.thread_stacks, st.depot_stacks); return 5;
+    }
+
+    kcoro_stack_pool_set_limits(KCORO_STACK_CACHE_PER_THREAD, KCORO_STACK_DEPOT_MAX);
+    kcoro_stack_pool_get_stats(&st0);
+    kc_sched_opts_t opts = {0};
+    opts.workers = 2;
+    kc_sched_t *s = kc_sched_init(&opts); assert(s);
+    for (int i = 0; i < SPAWNS; i++) {
+        assert(kc_spawn_co(s, short_task, NULL, 0, NULL) == 0);
+        if ((i & 31) == 31) while (atomic_load(&g_done) < i - 32) kc_sleep_ms(1);
+    }
+    for (int i = 0; i < 2000 && atomic_load(&g_done) < SPAWNS; i++) kc_sleep_ms(5);
+    kc_sched_shutdown(s);
+    kcoro_stack_pool_get_stats(&st);
+    if (atomic_load(&g_done) != SPAWNS) { fprintf(stderr, "done=%d\n", atomic_load(&g_done)); return 6; }
+    if (st.mapped - st0.mapped >= SPAWNS / 2) {
+        fprintf(stderr, "pool not reused: mapped=%lu reused=%lu\n", st.mapped - st0.mapped, st.reused - st0.reused); return 7;
+    }
+    printf("[test] stack_pool ok spawns=%d mapped=%lu reused=%lu\n",
+           SPAWNS, st.mapped - st0.mapped, st.reused - st0.reused);
+    return 0;
+}
@@ -0,0 +1,176 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Test the monitor data sources and the shared-memory stats segment:
+// per-worker stats and the steal matrix API, the blocked-waiter gauges in
+// channel snapshots, and a published segment read back through attach
+// (header, workers, a registered channel's counters and waiters, samples
+// advancing), its OpenMetrics rendering, plus -EEXIST on a taken name and
+// unlink on stop.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <unistd.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_metrics.h"
+#include "../include/kcoro_statseg.h"
+
+struct ctx { kc_chan_t *ch; int n; volatile int done; };
+
+static void producer(void *arg)
+{
+    struct ctx *c = (struct ctx*)arg;
+    for (int i = 0; i < c->n; i++) assert(kc_chan_send(c->ch, &i, -1) == 0);
+    c->done++;
+}
+
+static void consumer(void *arg)
+{
+    struct ctx *c = (struct ctx*)arg;
+    for (int i = 0; i < c->n; i++) { int v; assert(kc_chan_recv(c->ch, &v, -1) == 0 && v == i); }
+    c->done++;
+}
+
+static void blocked_recv(void *arg)
+{
+    struct ctx *c = (struct ctx*)arg;
+    int v;
+    assert(kc_chan_recv(c->ch, &v, -1) == 0 && v == 42);
+    c->done++;
+}
+
+static void send_one(void *arg)
+{
+    struct ctx *c = (struct ctx*)arg;
+    int v = 42;
+    assert(kc_chan_send(c->ch, &v, -1) == 0);
+    c->done++;
+}
+
+static void wait_done(struct ctx *c, int want)
+{
+    for (int i = 0; i < 5000 && c->done < want; i++) usleep(1000);
+    assert(c->done == want);
+}
+
+static int read_seg(const kc_statseg_data_t *seg, kc_statseg_data_t *d, uint64_t after)
+{
+    for (int i = 0; i < 2000; i++) {
+        assert(kc_statseg_read(seg, d) == 0);
+        assert((d->seq & 1) == 0);
+        if (d->samples > after) return 0;
+        usleep(1000);
+    }
+    return -1;
+}
+
+static const kc_statseg_chan_t *find_chan(const kc_statseg_data_t *d, const char *name)
+{
+    for (uint32_t i = 0; i < d->nchans; i++)
+        if (strcmp(d->ch[i].name, name) == 0) return &d->ch[i];
+    return NULL;
+}
+
+int main(void)
+{
+    kc_sched_t *s = kc_sched_default();
+    int nw = kc_sched_worker_count(s);
+    assert(nw > 0 && kc_sched_worker_count(NULL) == -EINVAL);
+    kc_sched_worker_stats_t ws;
+    assert(kc_sched_get_worker_stats(s, nw, &ws) == -EINVAL);
+    assert(kc_sched_get_worker_stats(s, 0, &ws) == 0);
+    unsigned long *mx = calloc((size_t)nw * (size_t)nw, sizeof(*mx));
+    assert(mx);
+    assert(kc_sched_get_steal_matrix(s, mx, (size_t)nw * (size_t)nw) == -ENOENT);
+    assert(kc_sched_set_steal_matrix(s, 1) == 0);
+    assert(kc_sched_get_steal_matrix(s, mx, 0) == -ENOSPC);
+    assert(kc_sched_get_steal_matrix(s, mx, (size_t)nw * (size_t)nw) == nw);
+    assert(kc_sched_set_steal_matrix(s, 0) == 0);
+
+    kc_chan_t *ch = NULL;
+    assert(kc_chan_make(&ch, KC_BUFFERED, sizeof(int), 64) == 0);
+    struct ctx c = { ch, 2000, 0 };
+
+    /* Blocked receiver appears in the snapshot gauges and leaves on wake. */
+    assert(kc_spawn_co(s, blocked_recv, &c, 0, NULL) == 0);
+    struct kc_chan_snapshot snap;
+    for (int i = 0; i < 2000; i++) {
+        assert(kc_chan_snapshot(ch, &snap) == 0);
+        if (snap.recv_waiters == 1) break;
+        usleep(1000);
+    }
+    assert(snap.recv_waiters == 1 && snap.send_waiters == 0);
+
+    char name[64];
+    snprintf(name, sizeof(name), "/kcoro-test-statseg-%d", (int)getpid());
+    kc_statseg_t *pub = NULL;
+    assert(kc_metrics_register_chan(ch, "work") == 0);
+    assert(kc_statseg_publish(s, name, 10, &pub) == 0);
+    assert(strcmp(kc_statseg_name(pub), name) == 0);
+    kc_statseg_t *dup = NULL;
+    assert(kc_statseg_publish(s, name, 10, &dup) == -EEXIST);
+
+    const kc_statseg_data_t *seg = NULL;
+    assert(kc_statseg_attach("/kcoro-test-statseg-none", &seg) == -ENOENT);
+    assert(kc_statseg_attach(name, &seg) == 0);
+    kc_statseg_data_t *d = malloc(sizeof(*d));
+    assert(d);
+    assert(read_seg(seg, d, 0) == 0);
+    assert(d->magic == KC_STATSEG_MAGIC && d->version == KC_STATSEG_VERSION);
+    assert(d->pid == (int32_t)getpid() && d->interval_ms == 10);
+    assert(d->workers_total == (uint32_t)nw && d->workers >= 1 && d->workers <= KC_STATSEG_WORKERS);
+    assert(d->steal_valid == 1);
+    const kc_statseg_chan_t *sc = find_chan(d, "work");
+    assert(sc && sc->capacity == 64);
+    /* the blocked receiver from above (the sampler may predate it by a tick) */
+    uint64_t seen = d->samples;
+    assert(read_seg(seg, d, seen) == 0);
+    sc = find_chan(d, "work");
+    assert(sc && sc->recv_waiters == 1);
+
+    c.done = 0;
+    assert(kc_spawn_co(s, send_one, &c, 0, NULL) == 0);
+    wait_done(&c, 2);
+    c.done = 0;
+    assert(kc_spawn_co(s, consumer, &c, 0, NULL) == 0);
+    assert(kc_spawn_co(s, producer, &c, 0, NULL) == 0);
+    wait_done(&c, 2);
+
+    seen = d->samples;
+    assert(read_seg(seg, d, seen + 1) == 0);
+    sc = find_chan(d, "work");
+    assert(sc && sc->sends == 2001 && sc->recvs == 2001);
+    assert(sc->bytes_sent == 2001 * sizeof(int) && sc->recv_waiters == 0 && sc->send_waiters == 0);
+    uint64_t run = 0;
+    for (uint32_t i = 0; i < d->workers; i++) run += d->w[i].run;
+    assert(run > 0 && d->tasks_submitted >= d->tasks_completed);
+
+    long need = kc_statseg_render(d, NULL, 0);
+    assert(need > 0 && kc_statseg_render(NULL, NULL, 0) == -EINVAL);
+    char *text = malloc((size_t)need + 1);
+    assert(text && kc_statseg_render(d, text, (size_t)need + 1) == need && (long)strlen(text) == need);
+    assert(strstr(text, "kcoro_chan_sends_total{chan=\"work\"} 2001\n"));
+    assert(strstr(text, "kcoro_chan_waiters{chan=\"work\",op=\"recv\"} 0\n"));
+    assert(strstr(text, "kcoro_worker_run_total{worker=\"0\"}"));
+    assert(strstr(text, "# TYPE kcoro_sched_inject_depth gauge\n"));
+    assert(strcmp(text + need - 6, "# EOF\n") == 0);
+    char small[16];
+    assert(kc_statseg_render(d, small, sizeof(small)) == need && strlen(small) == sizeof(small) - 1);
+    free(text);
+
+    assert(kc_statseg_stop(pub) == 0);
+    /* unlinked, but the mapping stays readable */
+    const kc_statseg_data_t *gone = NULL;
+    assert(kc_statseg_attach(name, &gone) == -ENOENT);
+    assert(kc_statseg_read(seg, d) == 0 && d->magic == KC_STATSEG_MAGIC);
+    kc_statseg_detach(seg);
+
+    assert(kc_metrics_unregister_chan(ch) == 0);
+    kc_chan_close(ch);
+    kc_chan_destroy(ch);
+    free(d);
+    free(mx);
+    printf("[statseg] ok\n");
+    return 0;
+}
@@ -0,0 +1,109 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// kc_task_group: spawn + helping wait
+// 1) a plain thread waits for many members, twice on the same group.
+// 2) recursive fork-join (fib) from a task: each level waits on its own
+//    group while the scheduler's other workers are busy doing the same.
+// 3) a worker coroutine parks on a group whose member is still sleeping,
+//    and members spawning members are waited for too.
+// 4) bad arguments.
+#include <stdio.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <assert.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_core.h"
+#include "../include/kcoro_sched.h"
+
+enum { MEMBERS = 20000, FIB_N = 22, FANOUT = 8 };
+
+static kc_sched_t *g_s;
+static _Atomic(long) g_count;
+static _Atomic(int) g_done;
+static long g_fib;
+static int g_rc = -1;
+
+static void bump(void *arg){ (void)arg; atomic_fetch_add(&g_count, 1); }
+
+struct fib { int n; long r; };
+
+static void fib_task(void *arg){
+    struct fib *f = arg;
+    if (f->n < 2) { f->r = f->n; return; }
+    struct fib a = { f->n - 1, 0 }, b = { f->n - 2, 0 };
+    kc_task_group_t *g = NULL;
+    assert(kc_task_group_create(&g, g_s) == 0);
+    assert(kc_task_group_spawn(g, fib_task, &a) == 0);
+    fib_task(&b);
+    assert(kc_task_group_wait(g) == 0);
+    kc_task_group_destroy(g);
+    f->r = a.r + b.r;
+}
+
+static void fib_root(void *arg){
+    (void)arg;
+    struct fib f = { FIB_N, 0 };
+    fib_task(&f);
+    g_fib = f.r;
+    atomic_store(&g_done, 1);
+}
+
+static kc_task_group_t *g_tree;
+
+/* Sleeps so the waiter runs out of help and parks, then fans out. */
+static void slow_parent(void *arg){
+    (void)arg;
+    kc_sleep_ms(30);
+    for (int i = 0; i < FANOUT; i++) assert(kc_task_group_spawn(g_tree, bump, NULL) == 0);
+    atomic_fetch_add(&g_count, 1);
+}
+
+static void co_waiter(void *arg){
+    (void)arg;
+    assert(kc_task_group_create(&g_tree, g_s) == 0);
+    assert(kc_task_group_spawn(g_tree, slow_parent, NULL) == 0);
+    g_rc = kc_task_group_wait(g_tree);
+    if (g_rc == 0 && atomic_load(&g_count) != 1 + FANOUT) g_rc = 100 + (int)atomic_load(&g_count);
+    kc_task_group_destroy(g_tree);
+    atomic_store(&g_done, 1);
+}
+
+static int wait_done(void){
+    for (int i = 0; i < 6000 && !atomic_load(&g_done); i++) kc_sleep_ms(5);
+    return atomic_load(&g_done);
+}
+
+static long fib_ref(int n){ long a = 0, b = 1; while (n--) { long t = a + b; a = b; b = t; } return a; }
+
+int main(void){
+    printf("[test] task_group start\n");
+    kc_sched_opts_t opts = {0};
+    opts.workers = 4;
+    g_s = kc_sched_init(&opts); assert(g_s);
+
+    kc_task_group_t *g = NULL;
+    assert(kc_task_group_create(&g, g_s) == 0);
+    for (int round = 1; round <= 2; round++) {
+        for (int i = 0; i < MEMBERS; i++) assert(kc_task_group_spawn(g, bump, NULL) == 0);
+        assert(kc_task_group_wait(g) == 0);
+        if (atomic_load(&g_count) != (long)round * MEMBERS) {
+            fprintf(stderr, "round %d count=%ld\n", round, atomic_load(&g_count)); return 1;
+        }
+    }
+    assert(kc_task_group_wait(g) == 0);   /* empty group: returns at once */
+    kc_task_group_destroy(g);
+
+    assert(kc_spawn(g_s, fib_root, NULL) == 0);
+    if (!wait_done() || g_fib != fib_ref(FIB_N)) { fprintf(stderr, "fib=%ld\n", g_fib); return 2; }
+
+    atomic_store(&g_done, 0);
+    atomic_store(&g_count, 0);
+    assert(kc_spawn_co(g_s, co_waiter, NULL, 0, NULL) == 0);
+    if (!wait_done() || g_rc != 0) { fprintf(stderr, "coroutine waiter rc=%d\n", g_rc); return 3; }
+
+    if (kc_task_group_create(NULL, g_s) != -EINVAL || kc_task_group_create(&g, NULL) != -EINVAL) return 4;
+    if (kc_task_group_spawn(NULL, bump, NULL) != -EINVAL || kc_task_group_wait(NULL) != -EINVAL) return 5;
+    kc_task_group_destroy(NULL);
+    kc_sched_shutdown(g_s);
+    printf("[test] task_group ok\n");
+    return 0;
+}
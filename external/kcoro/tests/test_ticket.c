@@ -0,0 +1,259 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Test correlation tickets: completion from a plain thread, stale and late
+// completions refused, timeout and cancel, and pointer channels parking on
+// tickets (rendezvous and buffered handoff, close, timed recv, a select
+// matching a parked send_ptr)
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <assert.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_core.h"
+#include "../include/kcoro_port.h"
+#include "../include/kcoro_ticket.h"
+
+#define MANY 4000
+#define MSGS 2000
+
+static void wait_for(atomic_int *v, int want)
+{
+    for (int i = 0; i < 20000 && atomic_load(v) < want; i++) usleep(500);
+    assert(atomic_load(v) >= want);
+}
+
+static kc_ticket_t wait_ticket(_Atomic kc_ticket_t *t)
+{
+    for (int i = 0; i < 20000 && atomic_load(t) == 0; i++) usleep(500);
+    kc_ticket_t v = atomic_load(t);
+    assert(v != 0);
+    return v;
+}
+
+/* ---- ticket core ---- */
+
+struct one {
+    _Atomic kc_ticket_t t;
+    long timeout_ms;
+    int rc;
+    kc_ticket_payload_t got;
+    atomic_int done;
+};
+
+static void owner(void *arg)
+{
+    struct one *o = (struct one*)arg;
+    kc_ticket_payload_t init = { .ptr = NULL, .len = 3, .status = 0, .data = 7 };
+    kc_ticket_t t = kc_ticket_publish(&init);
+    assert(t != 0);
+    atomic_store(&o->t, t);
+    o->rc = kc_ticket_wait(t, o->timeout_ms, &o->got);
+    atomic_store(&o->done, 1);
+}
+
+static void test_external_complete(void)
+{
+    static int target;
+    struct one o = { .timeout_ms = -1 };
+    assert(kc_spawn_co(kc_sched_default(), owner, &o, 0, NULL) == 0);
+    kc_ticket_t t = wait_ticket(&o.t);
+    usleep(2000);   /* let it park */
+    kc_ticket_payload_t io = { .ptr = &target, .len = 5, .status = 0, .data = 42 };
+    assert(kc_ticket_complete(t, &io) == 0);
+    assert(io.len == 3 && io.data == 7);    /* the publisher's payload */
+    assert(kc_ticket_complete(t, &io) == -ESTALE);
+    wait_for(&o.done, 1);
+    assert(o.rc == 0 && o.got.ptr == &target && o.got.len == 5 && o.got.data == 42);
+    assert(kc_ticket_complete(t, &io) == -ESTALE);   /* spent */
+    assert(kc_ticket_cancel(t, KC_ECANCELED) == -ESTALE);
+}
+
+static void test_timeout_and_cancel(void)
+{
+    struct one o = { .timeout_ms = 20 };
+    assert(kc_spawn_co(kc_sched_default(), owner, &o, 0, NULL) == 0);
+    kc_ticket_t t = wait_ticket(&o.t);
+    wait_for(&o.done, 1);
+    assert(o.rc == KC_ETIME);
+    kc_ticket_payload_t io = {0};
+    assert(kc_ticket_complete(t, &io) == -ESTALE);
+
+    struct one c = { .timeout_ms = 5000 };
+    assert(kc_spawn_co(kc_sched_default(), owner, &c, 0, NULL) == 0);
+    t = wait_ticket(&c.t);
+    usleep(2000);
+    assert(kc_ticket_cancel(t, KC_ECANCELED) == 0);
+    wait_for(&c.done, 1);
+    assert(c.rc == KC_ECANCELED && c.got.ptr == NULL);
+
+    assert(kc_ticket_publish(NULL) == 0);   /* not in a coroutine */
+    assert(kc_ticket_complete(0, &io) == -EINVAL);
+}
+
+/* Many owners, one completer thread racing their parks. */
+static _Atomic kc_ticket_t g_tickets[MANY];
+static atomic_int g_ready, g_ok, g_done;
+
+static void many_owner(void *arg)
+{
+    int i = (int)(intptr_t)arg;
+    kc_ticket_payload_t init = { .data = (uint64_t)i };
+    kc_ticket_t t = kc_ticket_publish(&init);
+    assert(t != 0);
+    atomic_store(&g_tickets[i], t);
+    atomic_fetch_add(&g_ready, 1);
+    kc_ticket_payload_t got;
+    if (kc_ticket_wait(t, -1, &got) == 0 && got.data == (uint64_t)i * 3) atomic_fetch_add(&g_ok, 1);
+    atomic_fetch_add(&g_done, 1);
+}
+
+static void *completer(void *arg)
+{
+    (void)arg;
+    for (int i = 0; i < MANY; i++) {
+        kc_ticket_t t;
+        while ((t = atomic_load(&g_tickets[i])) == 0) sched_yield();
+        kc_ticket_payload_t io = { .data = (uint64_t)i * 3 };
+        assert(kc_ticket_complete(t, &io) == 0);
+        assert(io.data == (uint64_t)i);
+    }
+    return NULL;
+}
+
+static void test_many(void)
+{
+    pthread_t th;
+    assert(pthread_create(&th, NULL, completer, NULL) == 0);
+    for (int i = 0; i < MANY; i++)
+        assert(kc_spawn_co(kc_sched_default(), many_owner, (void*)(intptr_t)i, 0, NULL) == 0);
+    pthread_join(th, NULL);
+    wait_for(&g_done, MANY);
+    assert(atomic_load(&g_ok) == MANY);
+}
+
+/* ---- pointer channels ---- */
+
+struct pc {
+    kc_chan_t *ch;
+    atomic_int done, bad;
+};
+
+static void ptr_producer(void *arg)
+{
+    struct pc *c = (struct pc*)arg;
+    for (int i = 0; i < MSGS; i++)
+        if (kc_chan_send_ptr(c->ch, (void*)(uintptr_t)(i + 1), (size_t)i + 1, -1) != 0) atomic_fetch_add(&c->bad, 1);
+    atomic_fetch_add(&c->done, 1);
+}
+
+static void ptr_consumer(void *arg)
+{
+    struct pc *c = (struct pc*)arg;
+    for (int i = 0; i < MSGS; i++) {
+        void *p = NULL; size_t l = 0;
+        int rc = kc_chan_recv_ptr(c->ch, &p, &l, -1);
+        if (rc != 0 || p != (void*)(uintptr_t)(i + 1) || l != (size_t)i + 1) atomic_fetch_add(&c->bad, 1);
+    }
+    atomic_fetch_add(&c->done, 1);
+}
+
+static void test_ptr_handoff(int kind, size_t cap)
+{
+    struct pc c = {0};
+    assert(kc_chan_make_ptr(&c.ch, kind, cap) == 0);
+    assert(kc_spawn_co(kc_sched_default(), ptr_consumer, &c, 0, NULL) == 0);
+    assert(kc_spawn_co(kc_sched_default(), ptr_producer, &c, 0, NULL) == 0);
+    wait_for(&c.done, 2);
+    assert(atomic_load(&c.bad) == 0);
+    struct kc_chan_snapshot snap;
+    assert(kc_chan_snapshot(c.ch, &snap) == 0);
+    assert(snap.total_sends == MSGS && snap.total_recvs == MSGS);
+    kc_chan_destroy(c.ch);
+}
+
+static void closed_recv(void *arg)
+{
+    struct pc *c = (struct pc*)arg;
+    void *p; size_t l;
+    if (kc_chan_recv_ptr(c->ch, &p, &l, -1) != KC_EPIPE) atomic_fetch_add(&c->bad, 1);
+    atomic_fetch_add(&c->done, 1);
+}
+
+static void timed_recv(void *arg)
+{
+    struct pc *c = (struct pc*)arg;
+    void *p; size_t l;
+    if (kc_chan_recv_ptr(c->ch, &p, &l, 20) != KC_ETIME) atomic_fetch_add(&c->bad, 1);
+    atomic_fetch_add(&c->done, 1);
+}
+
+static void test_ptr_close_and_timeout(void)
+{
+    struct pc c = {0};
+    assert(kc_chan_make_ptr(&c.ch, KC_RENDEZVOUS, 0) == 0);
+    assert(kc_spawn_co(kc_sched_default(), timed_recv, &c, 0, NULL) == 0);
+    wait_for(&c.done, 1);
+    struct kc_chan_snapshot snap;
+    assert(kc_chan_snapshot(c.ch, &snap) == 0);
+    assert(snap.recv_etime == 1);
+
+    assert(kc_spawn_co(kc_sched_default(), closed_recv, &c, 0, NULL) == 0);
+    assert(kc_spawn_co(kc_sched_default(), closed_recv, &c, 0, NULL) == 0);
+    usleep(5000);
+    assert(atomic_load(&c.done) == 1);
+    kc_chan_close(c.ch);
+    wait_for(&c.done, 3);
+    assert(atomic_load(&c.bad) == 0);
+    kc_chan_destroy(c.ch);
+}
+
+static void select_recv(void *arg)
+{
+    struct pc *c = (struct pc*)arg;
+    kc_select_t *sel = NULL;
+    struct kc_chan_ptrmsg m = {0};
+    int idx = -1, res = -1;
+    assert(kc_select_create(&sel, NULL) == 0);
+    assert(kc_select_add_recv(sel, c->ch, &m) == 0);
+    int rc = kc_select_wait(sel, 1000, &idx, &res);
+    if (rc != 0 || idx != 0 || res != 0 || m.ptr != (void*)c || m.len != 9) atomic_fetch_add(&c->bad, 1);
+    kc_select_destroy(sel);
+    atomic_fetch_add(&c->done, 1);
+}
+
+static void parked_send(void *arg)
+{
+    struct pc *c = (struct pc*)arg;
+    if (kc_chan_send_ptr(c->ch, c, 9, 1000) != 0) atomic_fetch_add(&c->bad, 1);
+    atomic_fetch_add(&c->done, 1);
+}
+
+static void test_ptr_select(void)
+{
+    struct pc c = {0};
+    assert(kc_chan_make_ptr(&c.ch, KC_RENDEZVOUS, 0) == 0);
+    assert(kc_spawn_co(kc_sched_default(), parked_send, &c, 0, NULL) == 0);
+    usleep(5000);   /* sender parks on its ticket */
+    assert(kc_spawn_co(kc_sched_default(), select_recv, &c, 0, NULL) == 0);
+    wait_for(&c.done, 2);
+    assert(atomic_load(&c.bad) == 0);
+    kc_chan_destroy(c.ch);
+}
+
+int main(void)
+{
+    test_external_complete();
+    test_timeout_and_cancel();
+    test_many();
+    test_ptr_handoff(KC_RENDEZVOUS, 0);
+    test_ptr_handoff(KC_BUFFERED, 2);
+    test_ptr_close_and_timeout();
+    test_ptr_select();
+    printf("[ticket] ok owners=%d msgs=%d\n", MANY, MSGS);
+    (void)kc_sched_drain(kc_sched_default(), 500);
+    return 0;
+}
@@ -0,0 +1,206 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Coroutine I/O (kcoro_io.h)
+// 1) outside a worker coroutine the calls run the plain syscall.
+// 2) on one worker, READERS coroutines block in kc_io_read on blocking
+//    socketpairs while a ticker keeps running; their SQEs share few
+//    io_uring_enter calls, and one write per pair wakes each.
+// 3) positioned file writes/reads and vectored I/O round-trip.
+// 4) a read into a kc_region_register region goes out as a fixed-buffer op.
+// 5) accept/connect/sendmsg/recvmsg over a Unix socket; a shared-stack
+//    coroutine takes the syscall path on a non-blocking fd.
+// Without io_uring (old kernel, seccomp) everything runs the syscall path and
+// only the results are checked.
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdatomic.h>
+#include <assert.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_core.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_io.h"
+#include "../include/kcoro_port.h"
+
+enum { READERS = 64, FILE_SZ = 8192 };
+
+static int g_sv[READERS][2];
+static int g_fd, g_lfd;
+static char g_path[64], g_sock[108];
+static char *g_region_buf;
+static _Atomic(int) g_parked, g_woke, g_bad, g_ticks, g_file_rc, g_fixed_rc, g_srv_rc, g_cli_rc, g_share_rc;
+
+static void reader(void *arg){
+    int i = (int)(intptr_t)arg;
+    char c = 0;
+    atomic_fetch_add(&g_parked, 1);
+    ssize_t n = kc_io_read(g_sv[i][0], &c, 1, -1);
+    if (n != 1 || c != (char)('a' + i % 26)) atomic_fetch_add(&g_bad, 1);
+    atomic_fetch_add(&g_woke, 1);
+}
+
+static void ticker(void *arg){
+    (void)arg;
+    while (atomic_load(&g_woke) < READERS && atomic_load(&g_ticks) < 100000) { atomic_fetch_add(&g_ticks, 1); kc_sleep_ms(2); }
+}
+
+static void file_io(void *arg){
+    (void)arg;
+    char out[FILE_SZ], in[FILE_SZ];
+    for (int i = 0; i < FILE_SZ; i++) out[i] = (char)(i * 7);
+    int ok = kc_io_write(g_fd, out, FILE_SZ / 2, FILE_SZ / 2) == FILE_SZ / 2 &&
+             kc_io_write(g_fd, out + FILE_SZ / 2, FILE_SZ / 2, 0) == FILE_SZ / 2;
+    struct iovec iov[2] = { { in, FILE_SZ / 2 }, { in + FILE_SZ / 2, FILE_SZ / 2 } };
+    ok = ok && kc_io_readv(g_fd, iov, 2, 0) == FILE_SZ &&
+         memcmp(in, out + FILE_SZ / 2, FILE_SZ / 2) == 0 && memcmp(in + FILE_SZ / 2, out, FILE_SZ / 2) == 0;
+    struct iovec wv[1] = { { out, 16 } };
+    ok = ok && kc_io_writev(g_fd, wv, 1, FILE_SZ) == 16 && kc_io_read(g_fd, in, 64, FILE_SZ) == 16;
+    ok = ok && kc_io_read(-1, in, 1, 0) == -EBADF;
+    atomic_store(&g_file_rc, ok ? 1 : -1);
+}
+
+static void fixed_read(void *arg){
+    (void)arg;
+    ssize_t n = kc_io_read(g_fd, g_region_buf + 100, 512, 0);
+    atomic_store(&g_fixed_rc, n == 512 && g_region_buf[100] == (char)((FILE_SZ / 2) * 7) ? 1 : -1);
+}
+
+static void server(void *arg){
+    (void)arg;
+    int c = kc_io_accept(g_lfd, NULL, NULL, SOCK_CLOEXEC);
+    if (c < 0) { atomic_store(&g_srv_rc, c); return; }
+    char buf[32] = {0};
+    struct iovec iov = { buf, sizeof buf };
+    struct msghdr m = { .msg_iov = &iov, .msg_iovlen = 1 };
+    ssize_t n = kc_io_recvmsg(c, &m, 0);
+    int ok = n == 5 && memcmp(buf, "hello", 5) == 0 && kc_io_write(c, "world", 5, -1) == 5;
+    close(c);
+    atomic_store(&g_srv_rc, ok ? 1 : -1);
+}
+
+static void client(void *arg){
+    (void)arg;
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    struct sockaddr_un sa = { .sun_family = AF_UNIX };
+    memcpy(sa.sun_path, g_sock, strlen(g_sock) + 1);
+    int rc = kc_io_connect(fd, (struct sockaddr*)&sa, sizeof sa);
+    struct iovec iov = { (void*)"hello", 5 };
+    struct msghdr m = { .msg_iov = &iov, .msg_iovlen = 1 };
+    char buf[8] = {0};
+    int ok = rc == 0 && kc_io_sendmsg(fd, &m, 0) == 5 && kc_io_read(fd, buf, sizeof buf, -1) == 5 &&
+             memcmp(buf, "world", 5) == 0;
+    close(fd);
+    atomic_store(&g_cli_rc, ok ? 1 : rc < 0 ? rc : -1);
+}
+
+static void share_reader(void *arg){
+    int fd = (int)(intptr_t)arg;
+    char buf[4] = {0};
+    ssize_t n = kc_io_read(fd, buf, sizeof buf, -1);
+    atomic_store(&g_share_rc, n == 3 && memcmp(buf, "abc", 3) == 0 ? 1 : -1);
+}
+
+static int wait_nonzero(_Atomic(int) *v){
+    for (int i = 0; i < 2000 && atomic_load(v) == 0; i++) kc_sleep_ms(5);
+    return atomic_load(v);
+}
+
+int main(void){
+    printf("[test] uring start\n");
+    kc_io_stats_t s0, s1, s2;
+    kc_io_get_stats(&s0);
+    int p[2];
+    assert(pipe(p) == 0);
+    assert(kc_io_write(p[1], "xy", 2, -1) == 2);
+    char tmp[4];
+    assert(kc_io_read(p[0], tmp, sizeof tmp, -1) == 2 && tmp[0] == 'x');
+    close(p[0]); close(p[1]);
+    kc_io_get_stats(&s1);
+    if (s1.fallbacks - s0.fallbacks != 2 || s1.submitted != s0.submitted) {
+        fprintf(stderr, "thread calls: fallbacks=%lu\n", s1.fallbacks - s0.fallbacks); return 1;
+    }
+
+    kc_sched_opts_t opts = {0};
+    opts.workers = 1;
+    kc_sched_t *s = kc_sched_init(&opts); assert(s);
+    for (int i = 0; i < READERS; i++) assert(socketpair(AF_UNIX, SOCK_STREAM, 0, g_sv[i]) == 0);
+    assert(kc_spawn_co(s, ticker, NULL, 0, NULL) == 0);
+    for (int i = 0; i < READERS; i++) assert(kc_spawn_co(s, reader, (void*)(intptr_t)i, 0, NULL) == 0);
+    for (int i = 0; i < 2000 && atomic_load(&g_parked) < READERS; i++) kc_sleep_ms(1);
+    kc_sleep_ms(20);
+    int ticks0 = atomic_load(&g_ticks);
+    kc_sleep_ms(50);
+    if (atomic_load(&g_woke) != 0 || atomic_load(&g_ticks) - ticks0 < 5) {
+        fprintf(stderr, "parked readers: woke=%d ticks=%d\n", atomic_load(&g_woke), atomic_load(&g_ticks) - ticks0); return 2;
+    }
+    for (int i = 0; i < READERS; i++) { char c = (char)('a' + i % 26); assert(write(g_sv[i][1], &c, 1) == 1); }
+    for (int i = 0; i < 2000 && atomic_load(&g_woke) < READERS; i++) kc_sleep_ms(5);
+    if (atomic_load(&g_woke) != READERS || atomic_load(&g_bad)) {
+        fprintf(stderr, "readers woke=%d bad=%d\n", atomic_load(&g_woke), atomic_load(&g_bad)); return 3;
+    }
+    for (int i = 0; i < READERS; i++) { close(g_sv[i][0]); close(g_sv[i][1]); }
+    kc_io_get_stats(&s2);
+    const int uring = s2.submitted > s1.submitted;
+    if (uring && (s2.submitted - s1.submitted < READERS || s2.enters - s1.enters >= READERS / 2 ||
+                  s2.completed - s1.completed < READERS)) {
+        fprintf(stderr, "batching: submitted=%lu enters=%lu completed=%lu\n", s2.submitted - s1.submitted,
+                s2.enters - s1.enters, s2.completed - s1.completed); return 4;
+    }
+
+    snprintf(g_path, sizeof g_path, "/tmp/kcoro_uring_%d", (int)getpid());
+    g_fd = open(g_path, O_CREAT | O_RDWR | O_TRUNC, 0600); assert(g_fd >= 0);
+    assert(kc_spawn_co(s, file_io, NULL, 0, NULL) == 0);
+    if (wait_nonzero(&g_file_rc) != 1) { fprintf(stderr, "file I/O failed\n"); return 5; }
+
+    kc_region_t *reg = NULL, *dup = NULL;
+    g_region_buf = (char*)malloc(64 * 1024); assert(g_region_buf);
+    assert(kc_region_register(&reg, g_region_buf, 64 * 1024, 0) == 0);
+    assert(kc_region_register(&dup, g_region_buf + 4096, 16, 0) == -EEXIST);
+    unsigned long id = 0;
+    assert(kc_region_export_id(reg, &id) == 0 && id != 0);
+    kc_io_get_stats(&s1);
+    assert(kc_spawn_co(s, fixed_read, NULL, 0, NULL) == 0);
+    if (wait_nonzero(&g_fixed_rc) != 1) { fprintf(stderr, "region read failed\n"); return 6; }
+    kc_io_get_stats(&s2);
+    if (uring && s2.fixed == s1.fixed) { fprintf(stderr, "region read not fixed\n"); return 7; }
+    assert(kc_region_deregister(reg) == 0);
+    assert(kc_region_deregister(reg) == -ENOENT);
+    free(g_region_buf);
+    close(g_fd); unlink(g_path);
+
+    snprintf(g_sock, sizeof g_sock, "/tmp/kcoro_uring_%d.sock", (int)getpid());
+    unlink(g_sock);
+    g_lfd = socket(AF_UNIX, SOCK_STREAM, 0); assert(g_lfd >= 0);
+    struct sockaddr_un sa = { .sun_family = AF_UNIX };
+    memcpy(sa.sun_path, g_sock, strlen(g_sock) + 1);
+    assert(bind(g_lfd, (struct sockaddr*)&sa, sizeof sa) == 0 && listen(g_lfd, 4) == 0);
+    assert(kc_spawn_co(s, server, NULL, 0, NULL) == 0);
+    kc_sleep_ms(10);
+    assert(kc_spawn_co(s, client, NULL, 0, NULL) == 0);
+    if (wait_nonzero(&g_srv_rc) != 1 || wait_nonzero(&g_cli_rc) != 1) {
+        fprintf(stderr, "socket ops srv=%d cli=%d\n", atomic_load(&g_srv_rc), atomic_load(&g_cli_rc)); return 8;
+    }
+    close(g_lfd); unlink(g_sock);
+
+    int sv[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv) == 0);
+    kc_io_get_stats(&s1);
+    assert(kc_spawn_co(s, share_reader, (void*)(intptr_t)sv[0], KCORO_STACK_SHARED, NULL) == 0);
+    kc_sleep_ms(20);
+    assert(write(sv[1], "abc", 3) == 3);
+    if (wait_nonzero(&g_share_rc) != 1) { fprintf(stderr, "shared-stack read failed\n"); return 9; }
+    kc_io_get_stats(&s2);
+    if (s2.fallbacks == s1.fallbacks) { fprintf(stderr, "shared stack used the ring\n"); return 10; }
+    close(sv[0]); close(sv[1]);
+
+    kc_sched_shutdown(s);
+    kc_io_get_stats(&s2);
+    printf("[test] uring ok%s submitted=%lu enters=%lu fixed=%lu fallbacks=%lu\n", uring ? "" : " (no io_uring)",
+           s2.submitted, s2.enters, s2.fixed, s2.fallbacks);
+    return 0;
+}
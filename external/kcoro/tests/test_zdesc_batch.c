@@ -0,0 +1,145 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Test descriptor batches on a buffered zref channel: a producer runs ahead
+// of its consumer without copying, region_id descriptors resolve, single and
+// batch ops interleave, and close wakes a parked batch receiver
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <unistd.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_zcopy.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_core.h"
+#include "../include/kcoro_port.h"
+
+#define ROUNDS 4096
+#define SLOT   16
+
+static char arena[ROUNDS * SLOT] __attribute__((aligned(64)));
+
+struct ctx {
+    kc_chan_t *ch;
+    unsigned long id;
+    volatile int prod_done, cons_done, ahead;
+    int bad;
+    size_t seen;
+};
+
+static void producer(void *arg)
+{
+    struct ctx *c = (struct ctx*)arg;
+    kc_zdesc_t d[24];
+    size_t i = 0;
+    while (i < ROUNDS) {
+        size_t k = ROUNDS - i < 24 ? ROUNDS - i : 24;
+        for (size_t j = 0; j < k; j++) {
+            memset(&d[j], 0, sizeof(d[j]));
+            /* Every other descriptor names (region_id, offset) */
+            if ((i + j) & 1) { d[j].region_id = c->id; d[j].offset = (i + j) * SLOT; }
+            else d[j].addr = arena + (i + j) * SLOT;
+            d[j].len = SLOT;
+        }
+        /* Mix in single sends */
+        if (k == 24 && (i / 24) % 4 == 3) {
+            if (kc_chan_send_desc(c->ch, &d[0], -1) != 0) c->bad++;
+            i++;
+            continue;
+        }
+        size_t sent = 0;
+        if (kc_chan_send_desc_many(c->ch, d, k, -1, &sent) != 0 || sent != k) c->bad++;
+        i += sent ? sent : 1;
+    }
+    c->prod_done = 1;
+}
+
+static void consumer(void *arg)
+{
+    struct ctx *c = (struct ctx*)arg;
+    /* Let the producer fill the ring before draining it */
+    while (!c->ahead) kc_sleep_ms(1);
+    kc_zdesc_t out[40];
+    while (c->seen < ROUNDS) {
+        size_t got = 0;
+        if (c->seen % 3 == 0) {
+            out[0].flags = KC_ZDESC_F_REGION;
+            if (kc_chan_recv_desc(c->ch, &out[0], -1) != 0) { c->bad++; break; }
+            got = 1;
+        } else {
+            out[0].flags = KC_ZDESC_F_REGION;
+            if (kc_chan_recv_desc_many(c->ch, out, 40, -1, &got) != 0 || got == 0) { c->bad++; break; }
+        }
+        for (size_t j = 0; j < got; j++, c->seen++) {
+            if (out[j].addr != arena + c->seen * SLOT || out[j].len != SLOT) c->bad++;
+            if (out[j].region_id != c->id || out[j].offset != c->seen * SLOT) c->bad++;
+        }
+    }
+    c->cons_done = 1;
+}
+
+struct closer { kc_chan_t *ch; volatile int done; int rc; size_t got; };
+
+static void parked_recv(void *arg)
+{
+    struct closer *k = (struct closer*)arg;
+    kc_zdesc_t out[4] = {{0}};
+    k->rc = kc_chan_recv_desc_many(k->ch, out, 4, -1, &k->got);
+    k->done = 1;
+}
+
+int main(void)
+{
+    kc_region_t *reg = NULL;
+    int rc = kc_region_register(&reg, arena, sizeof(arena), KC_REGION_F_NONE);
+    assert(rc == 0);
+    struct ctx c = { 0 };
+    (void)kc_region_export_id(reg, &c.id);
+    rc = kc_chan_make_ptr(&c.ch, KC_BUFFERED, 256);
+    assert(rc == 0);
+    rc = kc_chan_enable_zero_copy_backend(c.ch, kc_zcopy_resolve("zref"), NULL);
+    assert(rc == 0);
+
+    rc = kc_spawn_co(kc_sched_default(), consumer, &c, 0, NULL);
+    assert(rc == 0);
+    rc = kc_spawn_co(kc_sched_default(), producer, &c, 0, NULL);
+    assert(rc == 0);
+    /* The producer queues a full ring with no consumer running */
+    struct kc_chan_stats cs;
+    for (int i = 0; i < 2000; i++) {
+        assert(kc_chan_get_stats(c.ch, &cs) == 0);
+        if (cs.total_sends >= 256) break;
+        usleep(1000);
+    }
+    assert(cs.total_sends >= 256 && !c.seen);
+    c.ahead = 1;
+    for (int i = 0; i < 10000 && !(c.prod_done && c.cons_done); i++) usleep(1000);
+    assert(c.prod_done && c.cons_done && c.bad == 0 && c.seen == ROUNDS);
+
+    struct kc_chan_zstats zs;
+    assert(kc_chan_get_zstats(c.ch, &zs) == 0);
+    assert(zs.zref_sent == ROUNDS && zs.zref_received == ROUNDS);
+    assert(zs.zref_fallback_small == 0 && zs.zref_fallback_capacity == 0);
+
+    /* Bad descriptors fail the whole batch before anything is queued */
+    kc_zdesc_t bad[2] = { { .addr = arena, .len = SLOT }, { .addr = arena, .len = 0 } };
+    size_t sent = 7;
+    assert(kc_chan_send_desc_many(c.ch, bad, 2, 0, &sent) == -EINVAL && sent == 0);
+    bad[1].addr = NULL; bad[1].region_id = 0xdeadbeef; bad[1].len = SLOT;
+    assert(kc_chan_send_desc_many(c.ch, bad, 2, 0, &sent) == -ENOENT && sent == 0);
+
+    /* Close wakes a batch receiver parked on an empty channel */
+    struct closer k = { .ch = c.ch };
+    rc = kc_spawn_co(kc_sched_default(), parked_recv, &k, 0, NULL);
+    assert(rc == 0);
+    usleep(20000);
+    assert(!k.done);
+    kc_chan_close(c.ch);
+    for (int i = 0; i < 2000 && !k.done; i++) usleep(1000);
+    assert(k.done && k.rc == KC_EPIPE && k.got == 0);
+
+    kc_chan_destroy(c.ch);
+    assert(kc_region_deregister(reg) == 0);
+    printf("[zdesc batch] ok sent=%lu received=%lu\n", zs.zref_sent, zs.zref_received);
+    return 0;
+}
@@ -0,0 +1,174 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Test scatter-gather descriptors: a header and a body in separate buffers
+// pass through buffered and rendezvous zref channels as one kc_ziov_t, bytes
+// count the segments, and queued segments hold their regions
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "../include/kcoro.h"
+#include "../include/kcoro_zcopy.h"
+#include "../include/kcoro_sched.h"
+#include "../include/kcoro_core.h"
+#include "../include/kcoro_port.h"
+
+#define MSGS 200
+
+static char hdrs[MSGS][16];
+static char body[4096];
+static char tail[8][32];
+
+struct ctx {
+    kc_chan_t *ch, *rv;
+    kc_ziov_t v[MSGS], big;
+    kc_zseg_t big_more[8];
+    volatile int stage, prod_done, cons_done;
+    int bad;
+    size_t bytes;
+};
+
+static size_t fill(struct ctx *c, int i)
+{
+    kc_ziov_t *v = &c->v[i];
+    memset(v, 0, sizeof(*v));
+    snprintf(hdrs[i], sizeof(hdrs[i]), "H%03d", i);
+    v->nseg = 2;
+    v->seg[0] = (kc_zseg_t){ hdrs[i], 4 };
+    v->seg[1] = (kc_zseg_t){ body + i, (size_t)(100 + i) };
+    return 4 + 100 + (size_t)i;
+}
+
+static void producer(void *arg)
+{
+    struct ctx *c = (struct ctx*)arg;
+    /* Singles, then a batch mixing plain and scatter-gather descriptors */
+    for (int i = 0; i < MSGS / 2; i++) {
+        c->bytes += fill(c, i);
+        kc_zdesc_t d = { .addr = &c->v[i], .flags = KC_ZDESC_F_IOV };
+        if (kc_chan_send_desc(c->ch, &d, -1) != 0) c->bad++;
+    }
+    kc_zdesc_t d[MSGS / 2 + 1];
+    for (int i = MSGS / 2; i < MSGS; i++) {
+        c->bytes += fill(c, i);
+        d[i - MSGS / 2] = (kc_zdesc_t){ .addr = &c->v[i], .flags = KC_ZDESC_F_IOV };
+    }
+    d[MSGS / 2] = (kc_zdesc_t){ .addr = body, .len = 7 };
+    c->bytes += 7;
+    size_t sent = 0;
+    if (kc_chan_send_desc_many(c->ch, d, MSGS / 2 + 1, -1, &sent) != 0 || sent != MSGS / 2 + 1) c->bad++;
+
+    /* Rendezvous: more segments than fit inline */
+    memset(&c->big, 0, sizeof(c->big));
+    c->big.nseg = KC_ZIOV_INLINE + 8;
+    for (int i = 0; i < KC_ZIOV_INLINE; i++) c->big.seg[i] = (kc_zseg_t){ body + i * 10, 10 };
+    for (int i = 0; i < 8; i++) {
+        memset(tail[i], 'a' + i, sizeof(tail[i]));
+        c->big_more[i] = (kc_zseg_t){ tail[i], sizeof(tail[i]) };
+    }
+    c->big.more = c->big_more;
+    kc_zdesc_t b = { .addr = &c->big, .flags = KC_ZDESC_F_IOV };
+    if (kc_chan_send_desc(c->rv, &b, -1) != 0) c->bad++;
+    c->prod_done = 1;
+}
+
+static void consumer(void *arg)
+{
+    struct ctx *c = (struct ctx*)arg;
+    while (c->stage < 1) kc_sleep_ms(1);
+    char flat[512];
+    int i = 0;
+    while (i <= MSGS) {
+        kc_zdesc_t out[16];
+        size_t got = 0;
+        out[0].flags = KC_ZDESC_F_REGION;
+        if (kc_chan_recv_desc_many(c->ch, out, 16, -1, &got) != 0) { c->bad++; return; }
+        for (size_t j = 0; j < got; j++, i++) {
+            if (i == MSGS) {
+                /* The plain descriptor that closed the batch */
+                if ((out[j].flags & KC_ZDESC_F_IOV) || out[j].addr != body || out[j].len != 7) c->bad++;
+                continue;
+            }
+            kc_ziov_t *v = (kc_ziov_t*)out[j].addr;
+            if (!(out[j].flags & KC_ZDESC_F_IOV) || v != &c->v[i] || out[j].len != kc_ziov_len(v)) c->bad++;
+            if (out[j].region_id != 0) c->bad++;
+            size_t n = kc_ziov_copyout(v, flat, sizeof(flat));
+            if (n != out[j].len || memcmp(flat, hdrs[i], 4) || memcmp(flat + 4, body + i, n - 4)) c->bad++;
+        }
+    }
+
+    kc_zdesc_t r = { 0 };
+    if (kc_chan_recv_desc(c->rv, &r, -1) != 0 || r.addr != &c->big || !(r.flags & KC_ZDESC_F_IOV) ||
+        r.len != KC_ZIOV_INLINE * 10 + 8 * 32) c->bad++;
+    if (kc_ziov_copyout(&c->big, flat, sizeof(flat)) != r.len || flat[r.len - 1] != 'h') c->bad++;
+    c->cons_done = 1;
+}
+
+struct dereg { kc_region_t *reg; volatile int done; };
+
+static void *dereg_thread(void *arg)
+{
+    struct dereg *g = (struct dereg*)arg;
+    (void)kc_region_deregister(g->reg);
+    g->done = 1;
+    return NULL;
+}
+
+int main(void)
+{
+    static struct ctx c;
+    assert(kc_chan_make_ptr(&c.ch, KC_BUFFERED, 512) == 0);
+    assert(kc_chan_enable_zero_copy_backend(c.ch, kc_zcopy_resolve("zref"), NULL) == 0);
+    assert(kc_chan_make_ptr(&c.rv, KC_RENDEZVOUS, 0) == 0);
+    assert(kc_chan_enable_zero_copy_backend(c.rv, kc_zcopy_resolve("zref"), NULL) == 0);
+
+    /* Malformed scatter-gather descriptors */
+    kc_ziov_t bad = { .nseg = 0 };
+    kc_zdesc_t d = { .addr = &bad, .flags = KC_ZDESC_F_IOV };
+    assert(kc_chan_send_desc(c.ch, &d, 0) == -EINVAL);
+    bad.nseg = KC_ZIOV_INLINE + 1;
+    for (int i = 0; i < KC_ZIOV_INLINE; i++) bad.seg[i] = (kc_zseg_t){ body, 1 };
+    assert(kc_ziov_len(&bad) == 0 && kc_chan_send_desc(c.ch, &d, 0) == -EINVAL);
+    bad.nseg = 1;
+    d.region_id = 1;
+    assert(kc_chan_send_desc(c.ch, &d, 0) == -EINVAL);
+    d.region_id = 0;
+    bad.seg[0].len = 0;
+    assert(kc_chan_send_desc(c.ch, &d, 0) == -EINVAL);
+
+    /* Headers live in a registered region: queued messages hold it */
+    kc_region_t *reg = NULL;
+    assert(kc_region_register(&reg, hdrs, sizeof(hdrs), KC_REGION_F_NONE) == 0);
+
+    assert(kc_spawn_co(kc_sched_default(), consumer, &c, 0, NULL) == 0);
+    assert(kc_spawn_co(kc_sched_default(), producer, &c, 0, NULL) == 0);
+    struct kc_chan_stats cs;
+    for (int i = 0; i < 2000; i++) {
+        assert(kc_chan_get_stats(c.ch, &cs) == 0);
+        if (cs.total_sends >= MSGS + 1) break;
+        usleep(1000);
+    }
+    assert(cs.total_sends == MSGS + 1 && cs.total_bytes_sent == c.bytes);
+
+    struct dereg g = { .reg = reg };
+    pthread_t th;
+    assert(pthread_create(&th, NULL, dereg_thread, &g) == 0);
+    usleep(30000);
+    assert(!g.done);
+    c.stage = 1;
+    for (int i = 0; i < 5000 && !(c.prod_done && c.cons_done); i++) usleep(1000);
+    assert(c.prod_done && c.cons_done && c.bad == 0);
+    pthread_join(th, NULL);
+    assert(g.done);
+
+    assert(kc_chan_get_stats(c.ch, &cs) == 0);
+    assert(cs.total_recvs == MSGS + 1 && cs.total_bytes_recv == c.bytes);
+    assert(kc_chan_get_stats(c.rv, &cs) == 0);
+    assert(cs.total_bytes_sent == KC_ZIOV_INLINE * 10 + 8 * 32);
+    kc_chan_destroy(c.rv);
+    kc_chan_destroy(c.ch);
+    printf("[ziov] ok msgs=%d bytes=%zu\n", MSGS, c.bytes);
+    return 0;
+}
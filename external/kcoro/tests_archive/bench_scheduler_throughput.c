@@ -36,6 +36,10 @@ typedef struct {
     int *stop_flag;
 } consumer_task_t;
 
+static void count_task(void *arg) {
+    atomic_fetch_add((atomic_int*)arg, 1);
+}
+
 // Producer task function - runs as a coroutine
 static void producer_task(void *arg) {
     producer_task_t *pt = (producer_task_t*)arg;
@@ -193,6 +197,23 @@ int main(int argc, char **argv) {
            100.0 * final_received / total_expected);
     printf("Throughput: %.1f messages/second\n", throughput_mps);
     printf("Throughput: %.3f M msg/sec\n", throughput_mps / 1e6);
+
+    // kc_spawn from this (non-worker) thread: last_task slot, else inject
+    enum { SPAWNS = 200000 };
+    kc_sched_stats_t st0, st;
+    kc_sched_get_stats(sched, &st0);
+    atomic_int spawned_done;
+    atomic_init(&spawned_done, 0);
+    uint64_t spawn_start = nsec_now();
+    for (int i = 0; i < SPAWNS; i++) {
+        if (kc_spawn(sched, count_task, &spawned_done) != 0) break;
+    }
+    uint64_t spawn_ns = nsec_now() - spawn_start;
+    for (int i = 0; i < 1000 && atomic_load(&spawned_done) < SPAWNS; i++) kc_sleep_ms(5);
+    kc_sched_get_stats(sched, &st);
+    printf("Spawn: %.1f ns/kc_spawn, fast path hits=%lu misses=%lu, ran %d/%d\n",
+           (double)spawn_ns / SPAWNS, st.fastpath_hits - st0.fastpath_hits,
+           st.fastpath_misses - st0.fastpath_misses, atomic_load(&spawned_done), SPAWNS);
     
     if (final_received >= total_expected * 0.95) {  // Allow 5% tolerance
         printf("✅ Benchmark completed successfully\n");
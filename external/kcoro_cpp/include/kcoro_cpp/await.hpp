@@ -0,0 +1,234 @@
+#pragma once
+
+// Stackless C++20 coroutines on WorkStealingScheduler.
+//
+// An AsyncTask is a detached coroutine whose frame (a few hundred bytes) is
+// the only state it owns; it runs on the scheduler's workers as ordinary
+// tasks next to stackful Coroutine contexts and talks to them through the
+// same channels:
+//
+//   AsyncTask consumer(IChannel<int>& ch) {
+//     int v;
+//     while (co_await async_recv(ch, v) == 0) use(v);
+//   }
+//   spawn_async(sched, consumer(ch));
+//
+// A coroutine whose parameters start with (std::allocator_arg,
+// std::pmr::memory_resource*) -- after the object, for member functions --
+// gets its frame from that resource:
+//
+//   AsyncTask handler(std::allocator_arg_t, std::pmr::memory_resource*, Request&);
+//   spawn_async(sched, handler(std::allocator_arg, &arena, req));
+//
+// Channel awaiters ride on the select hooks every channel already has
+// (select_register_recv/send, select_cancel): the awaiter is the ISelect and
+// reports no waiter() coroutine, resuming its handle through
+// WorkStealingScheduler::resume_async instead. Blocking channel calls (send,
+// recv with a timeout other than 0) park the current stackful Coroutine and
+// must not be used from an AsyncTask body.
+
+#include "kcoro_cpp/core.hpp"
+#include "kcoro_cpp/scheduler.hpp"
+#include <array>
+#include <atomic>
+#include <coroutine>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <memory_resource>
+#include <utility>
+
+namespace kcoro_cpp {
+
+class AsyncTask {
+public:
+  struct promise_type {
+    WorkStealingScheduler* sched{};
+    Lane lane{Lane::Interactive};
+    AsyncTask get_return_object() { return AsyncTask{std::coroutine_handle<promise_type>::from_promise(*this)}; }
+    // Lazily started by spawn_async; the frame frees itself when the body returns
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() noexcept {}
+    void unhandled_exception() noexcept { std::terminate(); }
+
+    // The resource pointer is stored after the frame for operator delete.
+    static void* operator new(std::size_t n) { return alloc_frame(n, nullptr); }
+    template<typename... A>
+    static void* operator new(std::size_t n, std::allocator_arg_t, std::pmr::memory_resource* mr, A&&...) { return alloc_frame(n, mr); }
+    template<typename C, typename... A>
+    static void* operator new(std::size_t n, C&&, std::allocator_arg_t, std::pmr::memory_resource* mr, A&&...) { return alloc_frame(n, mr); }
+    static void operator delete(void* p, std::size_t n) noexcept {
+      std::pmr::memory_resource* mr;
+      std::memcpy(&mr, static_cast<char*>(p) + tag_offset(n), sizeof(mr));
+      mr->deallocate(p, tag_offset(n) + sizeof(mr), alignof(std::max_align_t));
+    }
+  private:
+    static std::size_t tag_offset(std::size_t n) { return (n + alignof(void*) - 1) & ~(alignof(void*) - 1); }
+    static void* alloc_frame(std::size_t n, std::pmr::memory_resource* mr) {
+      mr = detail::resource_or_heap(mr);
+      void* p = mr->allocate(tag_offset(n) + sizeof(mr), alignof(std::max_align_t));
+      std::memcpy(static_cast<char*>(p) + tag_offset(n), &mr, sizeof(mr));
+      return p;
+    }
+  };
+  using handle_type = std::coroutine_handle<promise_type>;
+
+  AsyncTask(AsyncTask&& o) noexcept : h_(std::exchange(o.h_, {})) {}
+  AsyncTask(const AsyncTask&) = delete;
+  AsyncTask& operator=(const AsyncTask&) = delete;
+  ~AsyncTask() { if (h_) h_.destroy(); } // never spawned
+
+private:
+  explicit AsyncTask(handle_type h) : h_(h) {}
+  friend void spawn_async(WorkStealingScheduler& sched, AsyncTask task, Lane lane);
+  handle_type h_;
+};
+
+// Start `task` on `sched`; later resumptions stay on `lane`.
+inline void spawn_async(WorkStealingScheduler& sched, AsyncTask task, Lane lane = Lane::Interactive) {
+  auto h = std::exchange(task.h_, {});
+  h.promise().sched = &sched;
+  h.promise().lane = (lane == Lane::Inherit) ? Lane::Interactive : lane;
+  sched.resume_async(h, h.promise().lane);
+}
+
+// One select clause, type-erased so a select can mix channel and value types.
+struct AwaitClause {
+  SelectOp kind;
+  void* ch;
+  void* ptr;
+  int (*reg)(void* ch, ISelect* sel, int idx, void* ptr);
+  void (*cancel)(void* ch, ISelect* sel, int idx, SelectOp kind);
+};
+
+// `ch` is any channel with the select hooks (IChannel<T>, static channels).
+template<typename C, typename T>
+AwaitClause on_recv(C& ch, T* out) {
+  return {SelectOp::Recv, &ch, out,
+    [](void* c, ISelect* s, int i, void* p) { return static_cast<C*>(c)->select_register_recv(s, i, static_cast<T*>(p)); },
+    [](void* c, ISelect* s, int i, SelectOp k) { static_cast<C*>(c)->select_cancel(s, i, k); }};
+}
+
+// `*val` must stay valid until the select completes.
+template<typename C, typename T>
+AwaitClause on_send(C& ch, const T* val) {
+  return {SelectOp::Send, &ch, const_cast<T*>(val),
+    [](void* c, ISelect* s, int i, void* p) { return static_cast<C*>(c)->select_register_send(s, i, static_cast<const T*>(p)); },
+    [](void* c, ISelect* s, int i, SelectOp k) { static_cast<C*>(c)->select_cancel(s, i, k); }};
+}
+
+struct SelectResult {
+  int rc;    // 0 or negative KC_* from the winning clause
+  int index; // winning clause
+};
+
+// Registers every clause, suspends until one completes, then cancels the
+// rest. Completion is two-step: the channel wins the clause through
+// try_complete, then calls waiter(), which is where the handle is resumed;
+// the channel does not touch the select after waiter() returns, so the
+// awaiter (which lives in the coroutine frame) may already be gone by then.
+template<size_t N>
+class SelectAwaiter final : public ISelect {
+  static_assert(N > 0, "select needs at least one clause");
+public:
+  explicit SelectAwaiter(const std::array<AwaitClause, N>& clauses) : clauses_(clauses) {}
+  SelectAwaiter(const SelectAwaiter&) = delete;
+  SelectAwaiter& operator=(const SelectAwaiter&) = delete;
+
+  bool await_ready() const noexcept { return false; }
+  bool await_suspend(AsyncTask::handle_type h) {
+    h_ = h; sched_ = h.promise().sched; lane_ = h.promise().lane;
+    for (size_t i = 0; i < N && !won_.load(std::memory_order_acquire); ++i) {
+      const AwaitClause& c = clauses_[i];
+      int rc = c.reg(c.ch, this, (int)i, c.ptr);
+      registered_ = i + 1;
+      if (rc == KC_EAGAIN) continue;
+      // rc == 0: the channel already completed a clause and called waiter()
+      if (rc != 0 && try_complete((int)i, rc)) phase_.store(kReady, std::memory_order_release);
+      break;
+    }
+    int expected = kRegistering;
+    if (phase_.compare_exchange_strong(expected, kArmed, std::memory_order_acq_rel)) return true;
+    cancel_losers();
+    return false;
+  }
+  SelectResult await_resume() {
+    if (phase_.load(std::memory_order_acquire) == kArmed) cancel_losers();
+    return {result_, winner_};
+  }
+
+  void reset() override {}
+  void add_clause(SelectClauseBase*) override {}
+  int wait(long, int*, int*) override { return KC_ENOTSUP; }
+  bool try_complete(int clause_index, int result) override {
+    int expected = 0;
+    if (!won_.compare_exchange_strong(expected, 1, std::memory_order_acq_rel)) return false;
+    winner_ = clause_index; result_ = result;
+    return true;
+  }
+  ICoroutineContext* waiter() override {
+    int expected = kRegistering;
+    if (!phase_.compare_exchange_strong(expected, kReady, std::memory_order_acq_rel)) {
+      // Suspended: hand the frame to a worker and stop touching *this
+      auto* s = sched_; auto h = h_; Lane lane = lane_;
+      s->resume_async(h, lane);
+    }
+    return nullptr;
+  }
+
+private:
+  enum : int { kRegistering, kArmed, kReady };
+  void cancel_losers() {
+    for (size_t i = 0; i < registered_; ++i)
+      if ((int)i != winner_) clauses_[i].cancel(clauses_[i].ch, this, (int)i, clauses_[i].kind);
+  }
+
+  std::array<AwaitClause, N> clauses_;
+  std::atomic<int> won_{0};
+  std::atomic<int> phase_{kRegistering};
+  int winner_{-1};
+  int result_{KC_EAGAIN};
+  size_t registered_{0};
+  AsyncTask::handle_type h_{};
+  WorkStealingScheduler* sched_{};
+  Lane lane_{Lane::Interactive};
+};
+
+// co_await select(on_recv(a, &x), on_send(b, &y)) -> SelectResult
+template<typename... Clauses>
+SelectAwaiter<sizeof...(Clauses)> select(Clauses... clauses) {
+  return SelectAwaiter<sizeof...(Clauses)>(std::array<AwaitClause, sizeof...(Clauses)>{clauses...});
+}
+
+// Single-clause forms: co_await yields 0 or a negative KC_* code.
+template<typename C, typename T>
+class RecvAwaiter {
+public:
+  RecvAwaiter(C& ch, T& out) : sel_(std::array<AwaitClause, 1>{on_recv(ch, &out)}) {}
+  bool await_ready() const noexcept { return false; }
+  bool await_suspend(AsyncTask::handle_type h) { return sel_.await_suspend(h); }
+  int await_resume() { return sel_.await_resume().rc; }
+private:
+  SelectAwaiter<1> sel_;
+};
+
+template<typename C, typename T>
+class SendAwaiter {
+public:
+  SendAwaiter(C& ch, T val) : val_(std::move(val)), sel_(std::array<AwaitClause, 1>{on_send(ch, &val_)}) {}
+  bool await_ready() const noexcept { return false; }
+  bool await_suspend(AsyncTask::handle_type h) { return sel_.await_suspend(h); }
+  int await_resume() { return sel_.await_resume().rc; }
+private:
+  T val_;
+  SelectAwaiter<1> sel_;
+};
+
+template<typename C, typename T>
+RecvAwaiter<C, T> async_recv(C& ch, T& out) { return RecvAwaiter<C, T>(ch, out); }
+
+template<typename C, typename T>
+SendAwaiter<C, T> async_send(C& ch, T val) { return SendAwaiter<C, T>(ch, std::move(val)); }
+
+} // namespace kcoro_cpp
@@ -6,8 +6,13 @@
 #include "kcoro_cpp/logger.hpp"
 #include <mutex>
 #include <deque>
+#include <memory_resource>
+#include <vector>
+#include <span>
+#include <algorithm>
 #include <optional>
 #include <atomic>
+#include <type_traits>
 #include "kcoro_cpp/platform.hpp"
 
 namespace kcoro_cpp {
@@ -61,47 +66,88 @@ inline size_t size_bytes_default(const T&) { return sizeof(T); }
 inline size_t size_bytes_default(const std::pair<void*,size_t>& p) { return p.second; }
 inline size_t size_bytes_default(const ZDesc& z) { return z.len; }
 
+namespace detail {
+// A channel of a move-only T (ZBuf, unique_ptr) still implements IChannel<T>,
+// but refuses with KC_EINVAL the paths that would copy: lvalue sends and
+// select send clauses.
+template<typename T>
+inline constexpr bool chan_copyable = std::is_copy_constructible_v<T> && std::is_copy_assignable_v<T>;
+
+// Intrusive FIFO of wait nodes (Node has next/prev/linked members). A
+// coroutine that parks links a node living on its own stack and whoever
+// wakes it unlinks it first; select registrations outlive the registering
+// call, so their nodes come from a NodePool. Neither allocates once the pool
+// has warmed up.
+template<typename Node>
+class WaitList {
+public:
+  bool empty() const { return head_ == nullptr; }
+  Node* front() const { return head_; }
+  void push_back(Node* n) { n->next = nullptr; n->prev = tail_; (tail_ ? tail_->next : head_) = n; tail_ = n; n->linked = true; }
+  Node* pop_front() { Node* n = head_; if (n) erase(n); return n; }
+  void erase(Node* n) {
+    (n->prev ? n->prev->next : head_) = n->next;
+    (n->next ? n->next->prev : tail_) = n->prev;
+    n->next = n->prev = nullptr; n->linked = false;
+  }
+  template<typename Pred> Node* find(Pred pred) const { for (Node* n = head_; n; n = n->next) if (pred(n)) return n; return nullptr; }
+private:
+  Node* head_{}; Node* tail_{};
+};
+
+// Free list of select wait nodes; grows to the peak number of registrations.
+// Nodes come from the owning channel's memory resource.
+template<typename Node>
+class NodePool {
+public:
+  explicit NodePool(std::pmr::memory_resource* mr = nullptr) : mr_(resource_or_heap(mr)) {}
+  NodePool(const NodePool&) = delete;
+  NodePool& operator=(const NodePool&) = delete;
+  ~NodePool() { while (Node* n = free_) { free_ = n->next; n->~Node(); mr_->deallocate(n, sizeof(Node), alignof(Node)); } }
+  Node* get() {
+    if (Node* n = free_) { free_ = n->next; n->next = nullptr; return n; }
+    return ::new (mr_->allocate(sizeof(Node), alignof(Node))) Node{};
+  }
+  void put(Node* n) { n->prev = nullptr; n->next = free_; free_ = n; }
+private:
+  std::pmr::memory_resource* mr_;
+  Node* free_{};
+};
+
+// Parked coroutine (stack node)
+struct CoWait { Coroutine* co{}; CoWait* next{}; CoWait* prev{}; bool linked{false}; };
+} // namespace detail
+
 // Rendezvous (0-buffer) channel
 template<typename T>
 class RendezvousChannel : public IChannel<T> {
 public:
   void set_metrics_pipe(IChannel<ChannelMetricsEvent>* pipe, ChannelMetricsConfig cfg={}) { std::lock_guard<std::mutex> lk(mu_); metrics_pipe_=pipe; metrics_cfg_=cfg; }
-  explicit RendezvousChannel(WorkStealingScheduler* sched) : sched_(sched) {}
-  ~RendezvousChannel() override = default;
+  // `mr` backs select wait nodes (nullptr: global heap).
+  explicit RendezvousChannel(WorkStealingScheduler* sched, std::pmr::memory_resource* mr = nullptr)
+  : sched_(sched), recv_pool_(mr), send_pool_(mr) {}
+  ~RendezvousChannel() override {
+    while (auto* w = recv_waiters_.pop_front()) if (w->is_select) recv_pool_.put(w);
+    while (auto* w = send_waiters_.pop_front()) if (w->is_select) send_pool_.put(w);
+  }
 
+  // Lvalues are copied; rvalues are moved into the receiver's slot (or this
+  // coroutine's wait record while parked).
   int send(const T& val, long timeout_ms) override {
-    static std::atomic<int> dbg_s{0}; if (dbg_s++ < 2) { std::printf("[rv.send] enter\n"); }
-    std::unique_lock<std::mutex> lk(mu_);
-    if (closed_) { ++snap_.total_epipe; log_warn("buffered send observed closed channel"); return KC_EPIPE; }
-    if (!recv_waiters_.empty()) {
-      auto rw = recv_waiters_.front(); recv_waiters_.pop_front();
-      *rw.slot = val; // transfer
-      bump_send(size_bytes_default(val));
-      if (rw.is_select) { if (rw.sel->try_complete(rw.idx, 0)) if (auto* w = rw.sel->waiter()) { lk.unlock(); sched_->enqueue_ready(static_cast<Coroutine*>(w)); return 0; } }
-      if (rw.co) { lk.unlock(); sched_->enqueue_ready(rw.co); return 0; }
-      return 0;
-    }
-    if (timeout_ms == 0) { ++snap_.total_eagain; return KC_EAGAIN; }
-    // park current coroutine until a receiver arrives
-    auto* cur = Coroutine::current();
-    if (!cur) { ++snap_.total_eagain; return KC_EAGAIN; } // not in coroutine: refuse block
-    SendWait sw{false, cur, nullptr, -1, val};
-    send_waiters_.push_back(sw);
-    lk.unlock(); cur->park();
-    // resumed by a receiver
-    bump_send(size_bytes_default(val));
-    return 0;
+    if constexpr (detail::chan_copyable<T>) return send_impl(val, timeout_ms);
+    else { (void)val; (void)timeout_ms; return KC_EINVAL; }
   }
+  int send(T&& val, long timeout_ms) override { return send_impl(std::move(val), timeout_ms); }
 
   int recv(T& out, long timeout_ms) override {
     static std::atomic<int> dbg_r{0}; if (dbg_r++ < 2) { std::printf("[rv.recv] enter\n"); }
     std::unique_lock<std::mutex> lk(mu_);
     if (!send_waiters_.empty()) {
-      auto sw = send_waiters_.front(); send_waiters_.pop_front();
-      out = sw.val; // take value
+      auto sw = take_send_locked();
+      out = std::move(sw.val); // take value
       bump_recv(size_bytes_default(out));
-      if (sw.is_select) { if (sw.sel->try_complete(sw.idx, 0)) if (auto* w = sw.sel->waiter()) { lk.unlock(); sched_->enqueue_ready(static_cast<Coroutine*>(w)); return 0; } }
-      if (sw.co) { lk.unlock(); sched_->enqueue_ready(sw.co); return 0; }
+      if (sw.is_select) { if (sw.sel->try_complete(sw.idx, 0)) if (auto* w = sw.sel->waiter()) { lk.unlock(); sched_->enqueue_ready(static_cast<Coroutine*>(w), this->wake_lane_); return 0; } }
+      if (sw.co) { lk.unlock(); sched_->enqueue_ready(sw.co, this->wake_lane_); return 0; }
       return 0;
     }
     if (closed_) { ++snap_.total_epipe; return KC_EPIPE; }
@@ -109,7 +155,7 @@ public:
     auto* cur = Coroutine::current();
     if (!cur) { ++snap_.total_eagain; return KC_EAGAIN; }
     RecvWait rw{false, cur, nullptr, -1, &out};
-    recv_waiters_.push_back(rw);
+    recv_waiters_.push_back(&rw);
     lk.unlock(); cur->park();
     bump_recv(size_bytes_default(out));
     return 0;
@@ -117,27 +163,22 @@ public:
 
   // Cancellable variants
   int send_c(const T& val, long timeout_ms, const ICancellationToken* cancel) override {
-    // Delegate to send with cooperative wait and cancel
-    std::unique_lock<std::mutex> lk(mu_);
-    if (closed_) return KC_EPIPE;
-    if (!recv_waiters_.empty()) {
-      auto* co = recv_waiters_.front().co; auto* slot = recv_waiters_.front().slot;
-      recv_waiters_.pop_front(); *slot = val; bump_send(size_bytes_default(val)); lk.unlock(); sched_->enqueue_ready(co); return 0;
-    }
-    if (timeout_ms == 0) { ++snap_.total_eagain; return KC_EAGAIN; }
-    auto* cur = Coroutine::current(); if (!cur) { ++snap_.total_eagain; return KC_EAGAIN; }
-    send_waiters_.push_back({false, cur, nullptr, -1, val});
-    auto deadline = (timeout_ms < 0) ? (uint64_t)(-1) : (platform::now_ns() + (uint64_t)timeout_ms * 1000000ULL);
-    for(;;){ lk.unlock(); cur->park(); if(cancel && cancel->is_set()) { ++snap_.total_ecanceled; return KC_ECANCELED; } if(timeout_ms>=0 && platform::now_ns()>=deadline) { ++snap_.total_etime; return KC_ETIME; } // resumed => success
-      bump_send(size_bytes_default(val)); return 0; }
+    if constexpr (detail::chan_copyable<T>) return send_c_impl(val, timeout_ms, cancel);
+    else { (void)val; (void)timeout_ms; (void)cancel; return KC_EINVAL; }
   }
+  int send_c(T&& val, long timeout_ms, const ICancellationToken* cancel) override { return send_c_impl(std::move(val), timeout_ms, cancel); }
   int recv_c(T& out, long timeout_ms, const ICancellationToken* cancel) override {
     std::unique_lock<std::mutex> lk(mu_);
-    if (!send_waiters_.empty()) { auto sw = send_waiters_.front(); send_waiters_.pop_front(); out = sw.val; bump_recv(size_bytes_default(out)); lk.unlock(); sched_->enqueue_ready(sw.co); return 0; }
+    if (!send_waiters_.empty()) {
+      auto sw = take_send_locked(); out = std::move(sw.val); bump_recv(size_bytes_default(out));
+      if (sw.is_select) { if (sw.sel->try_complete(sw.idx, 0)) if (auto* w = sw.sel->waiter()) { lk.unlock(); sched_->enqueue_ready(static_cast<Coroutine*>(w), this->wake_lane_); } return 0; }
+      lk.unlock(); sched_->enqueue_ready(sw.co, this->wake_lane_); return 0;
+    }
     if (closed_) { ++snap_.total_epipe; return KC_EPIPE; }
     if (timeout_ms == 0) { ++snap_.total_eagain; return KC_EAGAIN; }
     auto* cur = Coroutine::current(); if (!cur) { ++snap_.total_eagain; return KC_EAGAIN; }
-    recv_waiters_.push_back({false, cur, nullptr, -1, &out});
+    RecvWait rw{false, cur, nullptr, -1, &out};
+    recv_waiters_.push_back(&rw);
     auto deadline = (timeout_ms < 0) ? (uint64_t)(-1) : (platform::now_ns() + (uint64_t)timeout_ms * 1000000ULL);
     for(;;){ lk.unlock(); cur->park(); if(cancel && cancel->is_set()) return KC_ECANCELED; if(timeout_ms>=0 && platform::now_ns()>=deadline) return KC_ETIME; bump_recv(size_bytes_default(out)); return 0; }
   }
@@ -145,10 +186,10 @@ public:
   void close() override {
     std::lock_guard<std::mutex> lk(mu_);
     closed_ = true;
-    // Wake everyone with EPIPE semantics: for now, just schedule; callers will observe failure on next op
-    for (auto& w: recv_waiters_) sched_->enqueue_ready(w.co);
-    for (auto& w: send_waiters_) sched_->enqueue_ready(w.co);
-    recv_waiters_.clear(); send_waiters_.clear();
+    // Wake everyone with EPIPE semantics: for now, just schedule; callers will observe failure on next op.
+    // Pending select clauses complete with KC_EPIPE.
+    while (!recv_waiters_.empty()) { auto w = take_recv_locked(); if (!w.is_select) sched_->enqueue_ready(w.co, this->wake_lane_); else if (w.sel->try_complete(w.idx, KC_EPIPE)) if (auto* s = w.sel->waiter()) sched_->enqueue_ready(static_cast<Coroutine*>(s), this->wake_lane_); }
+    while (!send_waiters_.empty()) { auto w = take_send_locked(); if (!w.is_select) sched_->enqueue_ready(w.co, this->wake_lane_); else if (w.sel->try_complete(w.idx, KC_EPIPE)) if (auto* s = w.sel->waiter()) sched_->enqueue_ready(static_cast<Coroutine*>(s), this->wake_lane_); }
   }
 
   size_t size() const override { return 0; }
@@ -163,13 +204,62 @@ public:
   void select_cancel(ISelect* sel, int clause_index, SelectOp kind) override;
 
 private:
-  struct RecvWait { bool is_select{false}; Coroutine* co{}; ISelect* sel{}; int idx{-1}; T* slot{}; };
-  struct SendWait { bool is_select{false}; Coroutine* co{}; ISelect* sel{}; int idx{-1}; T val{}; };
+  template<typename V>
+  int send_impl(V&& val, long timeout_ms) {
+    static std::atomic<int> dbg_s{0}; if (dbg_s++ < 2) { std::printf("[rv.send] enter\n"); }
+    const size_t bytes = size_bytes_default(val);
+    std::unique_lock<std::mutex> lk(mu_);
+    if (closed_) { ++snap_.total_epipe; log_fmt(LogLevel::Warn, "buffered send observed closed channel"); return KC_EPIPE; }
+    if (!recv_waiters_.empty()) {
+      auto rw = take_recv_locked();
+      *rw.slot = std::forward<V>(val); // transfer
+      bump_send(bytes);
+      if (rw.is_select) { if (rw.sel->try_complete(rw.idx, 0)) if (auto* w = rw.sel->waiter()) { lk.unlock(); sched_->enqueue_ready(static_cast<Coroutine*>(w), this->wake_lane_); return 0; } }
+      if (rw.co) { lk.unlock(); sched_->enqueue_ready(rw.co, this->wake_lane_); return 0; }
+      return 0;
+    }
+    if (timeout_ms == 0) { ++snap_.total_eagain; return KC_EAGAIN; }
+    // park current coroutine until a receiver arrives
+    auto* cur = Coroutine::current();
+    if (!cur) { ++snap_.total_eagain; return KC_EAGAIN; } // not in coroutine: refuse block
+    SendWait sw{false, cur, nullptr, -1, std::forward<V>(val)};
+    send_waiters_.push_back(&sw);
+    lk.unlock(); cur->park();
+    // resumed by a receiver
+    bump_send(bytes);
+    return 0;
+  }
+  template<typename V>
+  int send_c_impl(V&& val, long timeout_ms, const ICancellationToken* cancel) {
+    const size_t bytes = size_bytes_default(val);
+    std::unique_lock<std::mutex> lk(mu_);
+    if (closed_) return KC_EPIPE;
+    if (!recv_waiters_.empty()) {
+      auto rw = take_recv_locked(); *rw.slot = std::forward<V>(val); bump_send(bytes);
+      if (rw.is_select) { if (rw.sel->try_complete(rw.idx, 0)) if (auto* w = rw.sel->waiter()) { lk.unlock(); sched_->enqueue_ready(static_cast<Coroutine*>(w), this->wake_lane_); } return 0; }
+      lk.unlock(); sched_->enqueue_ready(rw.co, this->wake_lane_); return 0;
+    }
+    if (timeout_ms == 0) { ++snap_.total_eagain; return KC_EAGAIN; }
+    auto* cur = Coroutine::current(); if (!cur) { ++snap_.total_eagain; return KC_EAGAIN; }
+    SendWait sw{false, cur, nullptr, -1, std::forward<V>(val)};
+    send_waiters_.push_back(&sw);
+    auto deadline = (timeout_ms < 0) ? (uint64_t)(-1) : (platform::now_ns() + (uint64_t)timeout_ms * 1000000ULL);
+    for(;;){ lk.unlock(); cur->park(); if(cancel && cancel->is_set()) { ++snap_.total_ecanceled; return KC_ECANCELED; } if(timeout_ms>=0 && platform::now_ns()>=deadline) { ++snap_.total_etime; return KC_ETIME; } // resumed => success
+      bump_send(bytes); return 0; }
+  }
+  // Stack nodes for parked coroutines, pool nodes for select clauses
+  struct RecvWait { bool is_select{false}; Coroutine* co{}; ISelect* sel{}; int idx{-1}; T* slot{}; RecvWait* next{}; RecvWait* prev{}; bool linked{false}; };
+  struct SendWait { bool is_select{false}; Coroutine* co{}; ISelect* sel{}; int idx{-1}; T val{}; SendWait* next{}; SendWait* prev{}; bool linked{false}; };
   WorkStealingScheduler* sched_{};
   mutable std::mutex mu_;
   bool closed_{false};
-  std::deque<RecvWait> recv_waiters_;
-  std::deque<SendWait> send_waiters_;
+  detail::WaitList<RecvWait> recv_waiters_;
+  detail::WaitList<SendWait> send_waiters_;
+  detail::NodePool<RecvWait> recv_pool_;
+  detail::NodePool<SendWait> send_pool_;
+  // Unlink the oldest waiter and return a copy (select nodes go back to the pool).
+  RecvWait take_recv_locked() { RecvWait* n = recv_waiters_.pop_front(); RecvWait w = *n; if (w.is_select) recv_pool_.put(n); return w; }
+  SendWait take_send_locked() { SendWait* n = send_waiters_.pop_front(); SendWait w = std::move(*n); if (w.is_select) send_pool_.put(n); return w; }
   ChannelSnapshot snap_{};
   IChannel<ChannelMetricsEvent>* metrics_pipe_{nullptr};
   ChannelMetricsConfig metrics_cfg_{};
@@ -185,72 +275,118 @@ template<typename T>
   class BufferedChannel : public IChannel<T> {
   public:
   void set_metrics_pipe(IChannel<ChannelMetricsEvent>* pipe, ChannelMetricsConfig cfg={}) { std::lock_guard<std::mutex> lk(mu_); metrics_pipe_=pipe; metrics_cfg_=cfg; }
-  BufferedChannel(WorkStealingScheduler* sched, size_t capacity)
-  : sched_(sched), cap_(capacity?capacity:64), buf_(cap_) {}
+  // `mr` backs the ring and select wait nodes (nullptr: global heap).
+  BufferedChannel(WorkStealingScheduler* sched, size_t capacity, std::pmr::memory_resource* mr = nullptr)
+  : sched_(sched), cap_(capacity?capacity:64), buf_(cap_, detail::resource_or_heap(mr)), sel_recv_pool_(mr), sel_send_pool_(mr) {}
+  ~BufferedChannel() override {
+    while (auto* w = select_recv_waiters_.pop_front()) sel_recv_pool_.put(w);
+    while (auto* w = select_send_waiters_.pop_front()) sel_send_pool_.put(w);
+  }
 
+  // Lvalues are copied into the ring, rvalues moved; recv moves out.
   int send(const T& val, long timeout_ms) override {
-    static std::atomic<int> dbg_s{0}; if (dbg_s++ < 2) { std::printf("[unlim.send] enter\n"); }
-    std::unique_lock<std::mutex> lk(mu_);
-    if (closed_) { ++snap_.total_epipe; return KC_EPIPE; }
-    if (count_ < cap_) {
-      // enqueue
-      buf_[(head_ + count_) % cap_] = val; ++count_;
-      // wake a receiver if any
-      bump_send(size_bytes_default(val));
-      if (!select_recv_waiters_.empty()) { auto [s,i,out] = select_recv_waiters_.front(); select_recv_waiters_.pop_front(); *out = buf_[head_]; head_=(head_+1)%cap_; --count_; bump_recv(size_bytes_default(*out)); if (s->try_complete(i,0)) if (auto* w=s->waiter()) { lk.unlock(); sched_->enqueue_ready(static_cast<Coroutine*>(w)); } }
-      else if (!recv_waiters_.empty()) { auto co = recv_waiters_.front(); recv_waiters_.pop_front(); lk.unlock(); sched_->enqueue_ready(co); }
-      return 0;
-    }
-    if (timeout_ms == 0) { ++snap_.total_eagain; return KC_EAGAIN; }
-    auto* cur = Coroutine::current(); if (!cur) { ++snap_.total_eagain; return KC_EAGAIN; }
-    send_waiters_.push_back(cur);
-    lk.unlock(); cur->park();
-    // resumed; try again once
-    return send(val, 0);
+    if constexpr (detail::chan_copyable<T>) return send_impl(val, timeout_ms);
+    else { (void)val; (void)timeout_ms; return KC_EINVAL; }
   }
+  int send(T&& val, long timeout_ms) override { return send_impl(std::move(val), timeout_ms); }
 
   int recv(T& out, long timeout_ms) override {
     static std::atomic<int> dbg_r{0}; if (dbg_r++ < 2) { std::printf("[unlim.recv] enter\n"); }
     std::unique_lock<std::mutex> lk(mu_);
     if (count_ > 0) {
-      out = buf_[head_]; head_ = (head_ + 1) % cap_; --count_;
+      out = std::move(buf_[head_]); head_ = (head_ + 1) % cap_; --count_;
       bump_recv(size_bytes_default(out));
-      if (!send_waiters_.empty()) { auto co = send_waiters_.front(); send_waiters_.pop_front(); lk.unlock(); sched_->enqueue_ready(co); }
+      if (!send_waiters_.empty()) { auto co = send_waiters_.pop_front()->co; lk.unlock(); sched_->enqueue_ready(co, this->wake_lane_); }
       return 0;
     }
-    if (closed_) { ++snap_.total_epipe; log_warn("buffered recv observed closed channel"); return KC_EPIPE; }
+    if (closed_) { ++snap_.total_epipe; log_fmt(LogLevel::Warn, "buffered recv observed closed channel"); return KC_EPIPE; }
     if (timeout_ms == 0) { ++snap_.total_eagain; return KC_EAGAIN; }
     auto* cur = Coroutine::current(); if (!cur) { ++snap_.total_eagain; return KC_EAGAIN; }
-    recv_waiters_.push_back(cur);
+    detail::CoWait w{cur};
+    recv_waiters_.push_back(&w);
     lk.unlock(); cur->park();
     return recv(out, 0);
   }
 
   int send_c(const T& val, long timeout_ms, const ICancellationToken* cancel) override {
+    if constexpr (detail::chan_copyable<T>) return send_c_impl(val, timeout_ms, cancel);
+    else { (void)val; (void)timeout_ms; (void)cancel; return KC_EINVAL; }
+  }
+  int send_c(T&& val, long timeout_ms, const ICancellationToken* cancel) override { return send_c_impl(std::move(val), timeout_ms, cancel); }
+  int recv_c(T& out, long timeout_ms, const ICancellationToken* cancel) override {
     std::unique_lock<std::mutex> lk(mu_);
-    if (closed_) { ++snap_.total_epipe; log_warn("buffered send_c observed closed channel"); return KC_EPIPE; }
-    if (count_ < cap_) { buf_[(head_ + count_) % cap_] = val; ++count_; bump_send(size_bytes_default(val)); if(!recv_waiters_.empty()){auto co=recv_waiters_.front(); recv_waiters_.pop_front(); lk.unlock(); sched_->enqueue_ready(co);} return 0; }
-    if (timeout_ms == 0) { ++snap_.total_eagain; return KC_EAGAIN; }
-    auto* cur = Coroutine::current(); if (!cur) { ++snap_.total_eagain; return KC_EAGAIN; }
-    send_waiters_.push_back(cur);
+    if (count_ > 0) { out=std::move(buf_[head_]); head_=(head_+1)%cap_; --count_; bump_recv(size_bytes_default(out)); if(!send_waiters_.empty()){ auto co=send_waiters_.pop_front()->co; lk.unlock(); sched_->enqueue_ready(co, this->wake_lane_);} return 0; }
+    if (closed_) { ++snap_.total_epipe; log_fmt(LogLevel::Warn, "buffered recv_c observed closed channel"); return KC_EPIPE; } if (timeout_ms==0) { ++snap_.total_eagain; return KC_EAGAIN; } auto* cur=Coroutine::current(); if(!cur) { ++snap_.total_eagain; return KC_EAGAIN; } detail::CoWait w{cur}; recv_waiters_.push_back(&w);
     auto deadline=(timeout_ms<0)?(uint64_t)(-1):(platform::now_ns()+(uint64_t)timeout_ms*1000000ULL);
-    for(;;){ lk.unlock(); cur->park(); if(cancel && cancel->is_set()) { auto count = ++snap_.total_ecanceled; if ((count % 1000)==1) log_debug("buffered send_c cancel observed (sampled)"); return KC_ECANCELED; } if(timeout_ms>=0 && platform::now_ns()>=deadline) { auto count = ++snap_.total_etime; if ((count % 1000)==1) log_debug("buffered send_c timeout (sampled)"); return KC_ETIME; } return send(val,0);}  
+    for(;;){ lk.unlock(); cur->park(); if(cancel && cancel->is_set()) { auto count = ++snap_.total_ecanceled; if ((count % 1000)==1) log_fmt(LogLevel::Debug, "buffered recv_c cancel observed (sampled)"); return KC_ECANCELED; } if(timeout_ms>=0 && platform::now_ns()>=deadline) { auto count = ++snap_.total_etime; if ((count % 1000)==1) log_fmt(LogLevel::Debug, "buffered recv_c timeout (sampled)"); return KC_ETIME; } return recv(out,0);}  
   }
-  int recv_c(T& out, long timeout_ms, const ICancellationToken* cancel) override {
+
+  // Batch variants: each contiguous run costs one lock, one stats update and
+  // one wake pass. send_many queues all of vals in order (waiting while full)
+  // and reports progress in *sent on failure; recv_many waits for at least one
+  // element, then takes up to out.size() without waiting again.
+  int send_many(std::span<const T> vals, long timeout_ms, size_t* sent = nullptr) {
+    size_t done = 0; int rc = 0;
+    auto deadline=(timeout_ms<0)?(uint64_t)(-1):(platform::now_ns()+(uint64_t)timeout_ms*1000000ULL);
     std::unique_lock<std::mutex> lk(mu_);
-    if (count_ > 0) { out=buf_[head_]; head_=(head_+1)%cap_; --count_; bump_recv(size_bytes_default(out)); if(!send_waiters_.empty()){ auto co=send_waiters_.front(); send_waiters_.pop_front(); lk.unlock(); sched_->enqueue_ready(co);} return 0; }
-    if (closed_) { ++snap_.total_epipe; log_warn("buffered recv_c observed closed channel"); return KC_EPIPE; } if (timeout_ms==0) { ++snap_.total_eagain; return KC_EAGAIN; } auto* cur=Coroutine::current(); if(!cur) { ++snap_.total_eagain; return KC_EAGAIN; } recv_waiters_.push_back(cur);
+    while (done < vals.size()) {
+      if (closed_) { ++snap_.total_epipe; rc = KC_EPIPE; break; }
+      size_t k = std::min(cap_ - count_, vals.size() - done);
+      if (k == 0) {
+        if (timeout_ms == 0) { ++snap_.total_eagain; rc = KC_EAGAIN; break; }
+        if (timeout_ms > 0 && platform::now_ns() >= deadline) { ++snap_.total_etime; rc = KC_ETIME; break; }
+        auto* cur = Coroutine::current(); if (!cur) { ++snap_.total_eagain; rc = KC_EAGAIN; break; }
+        detail::CoWait w{cur};
+        send_waiters_.push_back(&w);
+        lk.unlock(); cur->park(); lk.lock();
+        if (w.linked) send_waiters_.erase(&w);
+        continue;
+      }
+      size_t tail = (head_ + count_) % cap_, first = std::min(k, cap_ - tail), bytes = 0;
+      std::copy_n(vals.begin() + done, first, buf_.begin() + tail);
+      std::copy_n(vals.begin() + done + first, k - first, buf_.begin());
+      for (size_t i = 0; i < k; ++i) bytes += size_bytes_default(vals[done + i]);
+      count_ += k; done += k; bump_send_n(k, bytes);
+      wake_receivers_locked(lk, k);
+      lk.lock();
+    }
+    if (sent) *sent = done;
+    return rc;
+  }
+
+  int recv_many(std::span<T> out, long timeout_ms, size_t* got = nullptr) {
+    if (got) *got = 0;
+    if (out.empty()) return 0;
     auto deadline=(timeout_ms<0)?(uint64_t)(-1):(platform::now_ns()+(uint64_t)timeout_ms*1000000ULL);
-    for(;;){ lk.unlock(); cur->park(); if(cancel && cancel->is_set()) { auto count = ++snap_.total_ecanceled; if ((count % 1000)==1) log_debug("buffered recv_c cancel observed (sampled)"); return KC_ECANCELED; } if(timeout_ms>=0 && platform::now_ns()>=deadline) { auto count = ++snap_.total_etime; if ((count % 1000)==1) log_debug("buffered recv_c timeout (sampled)"); return KC_ETIME; } return recv(out,0);}  
+    std::unique_lock<std::mutex> lk(mu_);
+    for (;;) {
+      if (count_ > 0) {
+        size_t k = std::min(count_, out.size()), first = std::min(k, cap_ - head_), bytes = 0;
+        std::move(buf_.begin() + head_, buf_.begin() + head_ + first, out.begin());
+        std::move(buf_.begin(), buf_.begin() + (k - first), out.begin() + first);
+        for (size_t i = 0; i < k; ++i) bytes += size_bytes_default(out[i]);
+        head_ = (head_ + k) % cap_; count_ -= k; bump_recv_n(k, bytes);
+        wake_senders_locked(lk, k);
+        if (got) *got = k;
+        return 0;
+      }
+      if (closed_) { ++snap_.total_epipe; return KC_EPIPE; }
+      if (timeout_ms == 0) { ++snap_.total_eagain; return KC_EAGAIN; }
+      if (timeout_ms > 0 && platform::now_ns() >= deadline) { ++snap_.total_etime; return KC_ETIME; }
+      auto* cur = Coroutine::current(); if (!cur) { ++snap_.total_eagain; return KC_EAGAIN; }
+      detail::CoWait w{cur};
+      recv_waiters_.push_back(&w);
+      lk.unlock(); cur->park(); lk.lock();
+      if (w.linked) recv_waiters_.erase(&w);
+    }
   }
 
   void close() override {
     std::lock_guard<std::mutex> lk(mu_);
     closed_ = true;
-    log_info("buffered channel closed; waking waiters");
-    for (auto* co : recv_waiters_) sched_->enqueue_ready(co);
-    for (auto* co : send_waiters_) sched_->enqueue_ready(co);
-    recv_waiters_.clear(); send_waiters_.clear();
+    log_fmt(LogLevel::Info, "buffered channel closed; waking waiters");
+    while (auto* w = recv_waiters_.pop_front()) sched_->enqueue_ready(w->co, this->wake_lane_);
+    while (auto* w = send_waiters_.pop_front()) sched_->enqueue_ready(w->co, this->wake_lane_);
   }
 
   size_t size() const override { std::lock_guard<std::mutex> lk(mu_); return count_; }
@@ -262,15 +398,56 @@ template<typename T>
   void select_cancel(ISelect* sel, int clause_index, SelectOp kind) override;
 
   private:
+  template<typename V>
+  int send_impl(V&& val, long timeout_ms) {
+    static std::atomic<int> dbg_s{0}; if (dbg_s++ < 2) { std::printf("[unlim.send] enter\n"); }
+    std::unique_lock<std::mutex> lk(mu_);
+    if (closed_) { ++snap_.total_epipe; return KC_EPIPE; }
+    if (count_ < cap_) {
+      // enqueue
+      bump_send(size_bytes_default(val));
+      buf_[(head_ + count_) % cap_] = std::forward<V>(val); ++count_;
+      // wake a receiver if any
+      if (!select_recv_waiters_.empty()) { auto [s,i,out] = take_sel_recv_locked(); *out = std::move(buf_[head_]); head_=(head_+1)%cap_; --count_; bump_recv(size_bytes_default(*out)); if (s->try_complete(i,0)) if (auto* w=s->waiter()) { lk.unlock(); sched_->enqueue_ready(static_cast<Coroutine*>(w), this->wake_lane_); } }
+      else if (!recv_waiters_.empty()) { auto co = recv_waiters_.pop_front()->co; lk.unlock(); sched_->enqueue_ready(co, this->wake_lane_); }
+      return 0;
+    }
+    if (timeout_ms == 0) { ++snap_.total_eagain; return KC_EAGAIN; }
+    auto* cur = Coroutine::current(); if (!cur) { ++snap_.total_eagain; return KC_EAGAIN; }
+    detail::CoWait w{cur};
+    send_waiters_.push_back(&w);
+    lk.unlock(); cur->park();
+    // resumed; try again once
+    return send_impl(std::forward<V>(val), 0);
+  }
+  template<typename V>
+  int send_c_impl(V&& val, long timeout_ms, const ICancellationToken* cancel) {
+    std::unique_lock<std::mutex> lk(mu_);
+    if (closed_) { ++snap_.total_epipe; log_fmt(LogLevel::Warn, "buffered send_c observed closed channel"); return KC_EPIPE; }
+    if (count_ < cap_) { bump_send(size_bytes_default(val)); buf_[(head_ + count_) % cap_] = std::forward<V>(val); ++count_; if(!recv_waiters_.empty()){auto co=recv_waiters_.pop_front()->co; lk.unlock(); sched_->enqueue_ready(co, this->wake_lane_);} return 0; }
+    if (timeout_ms == 0) { ++snap_.total_eagain; return KC_EAGAIN; }
+    auto* cur = Coroutine::current(); if (!cur) { ++snap_.total_eagain; return KC_EAGAIN; }
+    detail::CoWait w{cur};
+    send_waiters_.push_back(&w);
+    auto deadline=(timeout_ms<0)?(uint64_t)(-1):(platform::now_ns()+(uint64_t)timeout_ms*1000000ULL);
+    for(;;){ lk.unlock(); cur->park(); if(cancel && cancel->is_set()) { auto count = ++snap_.total_ecanceled; if ((count % 1000)==1) log_fmt(LogLevel::Debug, "buffered send_c cancel observed (sampled)"); return KC_ECANCELED; } if(timeout_ms>=0 && platform::now_ns()>=deadline) { auto count = ++snap_.total_etime; if ((count % 1000)==1) log_fmt(LogLevel::Debug, "buffered send_c timeout (sampled)"); return KC_ETIME; } return send_impl(std::forward<V>(val),0);}  
+  }
   WorkStealingScheduler* sched_{};
   mutable std::mutex mu_;
   bool closed_{false};
   size_t cap_{}; size_t head_{0}; size_t count_{0};
-  std::vector<T> buf_;
-  std::deque<Coroutine*> recv_waiters_;
-  std::deque<Coroutine*> send_waiters_;
-  std::deque<std::tuple<ISelect*,int,T*>> select_recv_waiters_;
-  std::deque<std::tuple<ISelect*,int,T>> select_send_waiters_;
+  std::pmr::vector<T> buf_;
+  struct SelRecv { ISelect* sel{}; int idx{-1}; T* out{}; SelRecv* next{}; SelRecv* prev{}; bool linked{false}; };
+  struct SelSend { ISelect* sel{}; int idx{-1}; T val{}; SelSend* next{}; SelSend* prev{}; bool linked{false}; };
+  detail::WaitList<detail::CoWait> recv_waiters_;
+  detail::WaitList<detail::CoWait> send_waiters_;
+  detail::WaitList<SelRecv> select_recv_waiters_;
+  detail::WaitList<SelSend> select_send_waiters_;
+  detail::NodePool<SelRecv> sel_recv_pool_;
+  detail::NodePool<SelSend> sel_send_pool_;
+  // Unlink the oldest select clause and recycle its node.
+  std::tuple<ISelect*,int,T*> take_sel_recv_locked() { SelRecv* n = select_recv_waiters_.pop_front(); std::tuple<ISelect*,int,T*> t{n->sel, n->idx, n->out}; sel_recv_pool_.put(n); return t; }
+  std::tuple<ISelect*,int,T> take_sel_send_locked() { SelSend* n = select_send_waiters_.pop_front(); std::tuple<ISelect*,int,T> t{n->sel, n->idx, std::move(n->val)}; sel_send_pool_.put(n); return t; }
   ChannelSnapshot snap_{};
   IChannel<ChannelMetricsEvent>* metrics_pipe_{nullptr};
   ChannelMetricsConfig metrics_cfg_{};
@@ -278,7 +455,35 @@ template<typename T>
   long long last_emit_time_ns_{0};
   inline void bump_send(size_t bytes){ auto now=platform::now_ns(); if(snap_.first_op_time_ns==0) snap_.first_op_time_ns=now; snap_.last_op_time_ns=now; ++snap_.total_sends; snap_.total_bytes_sent += bytes; maybe_emit(now); }
   inline void bump_recv(size_t bytes){ auto now=platform::now_ns(); if(snap_.first_op_time_ns==0) snap_.first_op_time_ns=now; snap_.last_op_time_ns=now; ++snap_.total_recvs; snap_.total_bytes_recv += bytes; maybe_emit(now); }
+  inline void bump_send_n(size_t n, size_t bytes){ auto now=platform::now_ns(); if(snap_.first_op_time_ns==0) snap_.first_op_time_ns=now; snap_.last_op_time_ns=now; snap_.total_sends += n; snap_.total_bytes_sent += bytes; maybe_emit(now); }
+  inline void bump_recv_n(size_t n, size_t bytes){ auto now=platform::now_ns(); if(snap_.first_op_time_ns==0) snap_.first_op_time_ns=now; snap_.last_op_time_ns=now; snap_.total_recvs += n; snap_.total_bytes_recv += bytes; maybe_emit(now); }
   inline void maybe_emit(long long now){ if(!metrics_pipe_) return; unsigned long delta_ops=(snap_.total_sends-last_emit_sends_)+(snap_.total_recvs-last_emit_recvs_); long long since_ns=now-last_emit_time_ns_; if(delta_ops<metrics_cfg_.emit_min_ops && since_ns<metrics_cfg_.emit_min_ms*1000000LL) return; ChannelMetricsEvent ev{}; ev.chan=this; ev.total_sends=snap_.total_sends; ev.total_recvs=snap_.total_recvs; ev.total_bytes_sent=snap_.total_bytes_sent; ev.total_bytes_recv=snap_.total_bytes_recv; ev.delta_sends=snap_.total_sends-last_emit_sends_; ev.delta_recvs=snap_.total_recvs-last_emit_recvs_; ev.delta_bytes_sent=snap_.total_bytes_sent-last_emit_bytes_sent_; ev.delta_bytes_recv=snap_.total_bytes_recv-last_emit_bytes_recv_; ev.first_op_time_ns=snap_.first_op_time_ns; ev.last_op_time_ns=snap_.last_op_time_ns; ev.emit_time_ns=now; (void)metrics_pipe_->send(ev,0); last_emit_sends_=ev.total_sends; last_emit_recvs_=ev.total_recvs; last_emit_bytes_sent_=ev.total_bytes_sent; last_emit_bytes_recv_=ev.total_bytes_recv; last_emit_time_ns_=now; }
+  // Wake pass after a batch of n enqueues (releases lk): queued values go to
+  // select receivers first, then up to n parked receivers are woken.
+  void wake_receivers_locked(std::unique_lock<std::mutex>& lk, size_t n) {
+    while (count_ > 0 && !select_recv_waiters_.empty()) {
+      auto [s,i,out] = take_sel_recv_locked();
+      *out = std::move(buf_[head_]); head_=(head_+1)%cap_; --count_; bump_recv(size_bytes_default(*out));
+      if (s->try_complete(i,0)) if (auto* w=s->waiter()) sched_->enqueue_ready(static_cast<Coroutine*>(w), this->wake_lane_);
+    }
+    Coroutine* wake[8]; size_t nw = 0;
+    while (nw < n && nw < 8 && !recv_waiters_.empty()) { wake[nw++] = recv_waiters_.pop_front()->co; }
+    lk.unlock();
+    for (size_t i = 0; i < nw; ++i) sched_->enqueue_ready(wake[i], this->wake_lane_);
+  }
+  // Wake pass after a batch of n dequeues (releases lk): select senders fill
+  // the freed room first, then up to n parked senders are woken.
+  void wake_senders_locked(std::unique_lock<std::mutex>& lk, size_t n) {
+    while (count_ < cap_ && !select_send_waiters_.empty()) {
+      auto [s,i,v] = take_sel_send_locked();
+      bump_send(size_bytes_default(v)); buf_[(head_ + count_) % cap_] = std::move(v); ++count_;
+      if (s->try_complete(i,0)) if (auto* w=s->waiter()) sched_->enqueue_ready(static_cast<Coroutine*>(w), this->wake_lane_);
+    }
+    Coroutine* wake[8]; size_t nw = 0;
+    while (nw < n && nw < 8 && !send_waiters_.empty()) { wake[nw++] = send_waiters_.pop_front()->co; }
+    lk.unlock();
+    for (size_t i = 0; i < nw; ++i) sched_->enqueue_ready(wake[i], this->wake_lane_);
+  }
   };
 
 // Select registration for BufferedChannel
@@ -286,45 +491,46 @@ template<typename T>
 int BufferedChannel<T>::select_register_recv(ISelect* sel, int clause_index, T* out) {
   std::unique_lock<std::mutex> lk(mu_);
   if (count_ > 0) {
-    *out = buf_[head_]; head_ = (head_ + 1) % cap_; --count_; bump_recv(size_bytes_default(*out));
+    *out = std::move(buf_[head_]); head_ = (head_ + 1) % cap_; --count_; bump_recv(size_bytes_default(*out));
     // if any select send waiters exist and there is room, enqueue one
     if (!select_send_waiters_.empty() && count_ < cap_) {
-      auto [s,i,v] = select_send_waiters_.front(); select_send_waiters_.pop_front(); buf_[(head_ + count_) % cap_] = v; ++count_; bump_send(size_bytes_default(v)); if (s->try_complete(i,0)) if (auto* w=s->waiter()) sched_->enqueue_ready(static_cast<Coroutine*>(w));
+      auto [s,i,v] = take_sel_send_locked(); bump_send(size_bytes_default(v)); buf_[(head_ + count_) % cap_] = std::move(v); ++count_; if (s->try_complete(i,0)) if (auto* w=s->waiter()) sched_->enqueue_ready(static_cast<Coroutine*>(w), this->wake_lane_);
     }
-    if (sel->try_complete(clause_index, 0)) if (auto* w = sel->waiter()) sched_->enqueue_ready(static_cast<Coroutine*>(w));
+    if (sel->try_complete(clause_index, 0)) if (auto* w = sel->waiter()) sched_->enqueue_ready(static_cast<Coroutine*>(w), this->wake_lane_);
     return 0;
   }
-  select_recv_waiters_.push_back({sel, clause_index, out});
+  SelRecv* w = sel_recv_pool_.get(); *w = SelRecv{sel, clause_index, out};
+  select_recv_waiters_.push_back(w);
   return KC_EAGAIN;
 }
 
 template<typename T>
 int BufferedChannel<T>::select_register_send(ISelect* sel, int clause_index, const T* val) {
-  std::unique_lock<std::mutex> lk(mu_);
-  if (count_ < cap_) {
-    buf_[(head_ + count_) % cap_] = *val; ++count_; bump_send(size_bytes_default(*val));
-    // wake a pending select receiver if any
-    if (!select_recv_waiters_.empty()) {
-      auto [s,i,out] = select_recv_waiters_.front(); select_recv_waiters_.pop_front(); *out = buf_[head_]; head_=(head_+1)%cap_; --count_; bump_recv(size_bytes_default(*out)); if (s->try_complete(i,0)) if (auto* w=s->waiter()) sched_->enqueue_ready(static_cast<Coroutine*>(w));
-    } else if (!recv_waiters_.empty()) { auto* co = recv_waiters_.front(); recv_waiters_.pop_front(); lk.unlock(); sched_->enqueue_ready(co); }
-    if (sel->try_complete(clause_index, 0)) if (auto* w=sel->waiter()) sched_->enqueue_ready(static_cast<Coroutine*>(w));
-    return 0;
+  if constexpr (!detail::chan_copyable<T>) { (void)sel; (void)clause_index; (void)val; return KC_EINVAL; }
+  else {
+    std::unique_lock<std::mutex> lk(mu_);
+    if (count_ < cap_) {
+      buf_[(head_ + count_) % cap_] = *val; ++count_; bump_send(size_bytes_default(*val));
+      // wake a pending select receiver if any
+      if (!select_recv_waiters_.empty()) {
+        auto [s,i,out] = take_sel_recv_locked(); *out = std::move(buf_[head_]); head_=(head_+1)%cap_; --count_; bump_recv(size_bytes_default(*out)); if (s->try_complete(i,0)) if (auto* w=s->waiter()) sched_->enqueue_ready(static_cast<Coroutine*>(w), this->wake_lane_);
+      } else if (!recv_waiters_.empty()) { auto* co = recv_waiters_.pop_front()->co; lk.unlock(); sched_->enqueue_ready(co, this->wake_lane_); }
+      if (sel->try_complete(clause_index, 0)) if (auto* w=sel->waiter()) sched_->enqueue_ready(static_cast<Coroutine*>(w), this->wake_lane_);
+      return 0;
+    }
+    SelSend* w = sel_send_pool_.get(); *w = SelSend{sel, clause_index, *val};
+    select_send_waiters_.push_back(w);
+    return KC_EAGAIN;
   }
-  select_send_waiters_.push_back({sel, clause_index, *val});
-  return KC_EAGAIN;
 }
 
 template<typename T>
 void BufferedChannel<T>::select_cancel(ISelect* sel, int clause_index, SelectOp kind) {
   std::lock_guard<std::mutex> lk(mu_);
   if (kind == SelectOp::Recv) {
-    for (auto it = select_recv_waiters_.begin(); it != select_recv_waiters_.end(); ++it) {
-      if (std::get<0>(*it) == sel && std::get<1>(*it) == clause_index) { select_recv_waiters_.erase(it); break; }
-    }
+    if (auto* w = select_recv_waiters_.find([&](SelRecv* n){ return n->sel == sel && n->idx == clause_index; })) { select_recv_waiters_.erase(w); sel_recv_pool_.put(w); }
   } else {
-    for (auto it = select_send_waiters_.begin(); it != select_send_waiters_.end(); ++it) {
-      if (std::get<0>(*it) == sel && std::get<1>(*it) == clause_index) { select_send_waiters_.erase(it); break; }
-    }
+    if (auto* w = select_send_waiters_.find([&](SelSend* n){ return n->sel == sel && n->idx == clause_index; })) { select_send_waiters_.erase(w); sel_send_pool_.put(w); }
   }
 }
 
@@ -333,46 +539,47 @@ template<typename T>
 int RendezvousChannel<T>::select_register_recv(ISelect* sel, int clause_index, T* out) {
   std::unique_lock<std::mutex> lk(mu_);
   if (!send_waiters_.empty()) {
-    auto sw = send_waiters_.front(); send_waiters_.pop_front(); *out = sw.val; bump_recv(size_bytes_default(*out));
+    auto sw = take_send_locked(); *out = std::move(sw.val); bump_recv(size_bytes_default(*out));
     // wake sender
-    if (sw.is_select) { if (sw.sel->try_complete(sw.idx, 0)) if (auto* w = sw.sel->waiter()) sched_->enqueue_ready(static_cast<Coroutine*>(w)); }
-    else if (sw.co) { lk.unlock(); sched_->enqueue_ready(sw.co); }
+    if (sw.is_select) { if (sw.sel->try_complete(sw.idx, 0)) if (auto* w = sw.sel->waiter()) sched_->enqueue_ready(static_cast<Coroutine*>(w), this->wake_lane_); }
+    else if (sw.co) { lk.unlock(); sched_->enqueue_ready(sw.co, this->wake_lane_); }
     // complete this select
-    if (sel->try_complete(clause_index, 0)) if (auto* w = sel->waiter()) sched_->enqueue_ready(static_cast<Coroutine*>(w));
+    if (sel->try_complete(clause_index, 0)) if (auto* w = sel->waiter()) sched_->enqueue_ready(static_cast<Coroutine*>(w), this->wake_lane_);
     return 0;
   }
   // enqueue select recv waiter
-  recv_waiters_.push_back({true, nullptr, sel, clause_index, out});
+  RecvWait* w = recv_pool_.get(); *w = RecvWait{true, nullptr, sel, clause_index, out};
+  recv_waiters_.push_back(w);
   return KC_EAGAIN;
 }
 
 template<typename T>
 int RendezvousChannel<T>::select_register_send(ISelect* sel, int clause_index, const T* val) {
-  std::unique_lock<std::mutex> lk(mu_);
-  if (!recv_waiters_.empty()) {
-    auto rw = recv_waiters_.front(); recv_waiters_.pop_front(); *rw.slot = *val; bump_send(size_bytes_default(*val));
-    // wake receiver
-    if (rw.is_select) { if (rw.sel->try_complete(rw.idx, 0)) if (auto* w = rw.sel->waiter()) sched_->enqueue_ready(static_cast<Coroutine*>(w)); }
-    else if (rw.co) { lk.unlock(); sched_->enqueue_ready(rw.co); }
-    // complete this select
-    if (sel->try_complete(clause_index, 0)) if (auto* w = sel->waiter()) sched_->enqueue_ready(static_cast<Coroutine*>(w));
-    return 0;
+  if constexpr (!detail::chan_copyable<T>) { (void)sel; (void)clause_index; (void)val; return KC_EINVAL; }
+  else {
+    std::unique_lock<std::mutex> lk(mu_);
+    if (!recv_waiters_.empty()) {
+      auto rw = take_recv_locked(); *rw.slot = *val; bump_send(size_bytes_default(*val));
+      // wake receiver
+      if (rw.is_select) { if (rw.sel->try_complete(rw.idx, 0)) if (auto* w = rw.sel->waiter()) sched_->enqueue_ready(static_cast<Coroutine*>(w), this->wake_lane_); }
+      else if (rw.co) { lk.unlock(); sched_->enqueue_ready(rw.co, this->wake_lane_); }
+      // complete this select
+      if (sel->try_complete(clause_index, 0)) if (auto* w = sel->waiter()) sched_->enqueue_ready(static_cast<Coroutine*>(w), this->wake_lane_);
+      return 0;
+    }
+    SendWait* w = send_pool_.get(); *w = SendWait{true, nullptr, sel, clause_index, *val};
+    send_waiters_.push_back(w);
+    return KC_EAGAIN;
   }
-  send_waiters_.push_back({true, nullptr, sel, clause_index, *val});
-  return KC_EAGAIN;
 }
 
 template<typename T>
 void RendezvousChannel<T>::select_cancel(ISelect* sel, int clause_index, SelectOp kind) {
   std::lock_guard<std::mutex> lk(mu_);
   if (kind == SelectOp::Recv) {
-    for (auto it = recv_waiters_.begin(); it != recv_waiters_.end(); ++it) {
-      if (it->is_select && it->sel == sel && it->idx == clause_index) { recv_waiters_.erase(it); break; }
-    }
+    if (auto* w = recv_waiters_.find([&](RecvWait* n){ return n->is_select && n->sel == sel && n->idx == clause_index; })) { recv_waiters_.erase(w); recv_pool_.put(w); }
   } else {
-    for (auto it = send_waiters_.begin(); it != send_waiters_.end(); ++it) {
-      if (it->is_select && it->sel == sel && it->idx == clause_index) { send_waiters_.erase(it); break; }
-    }
+    if (auto* w = send_waiters_.find([&](SendWait* n){ return n->is_select && n->sel == sel && n->idx == clause_index; })) { send_waiters_.erase(w); send_pool_.put(w); }
   }
 }
 
@@ -380,12 +587,15 @@ void RendezvousChannel<T>::select_cancel(ISelect* sel, int clause_index, SelectO
 template<typename T>
   class ConflatedChannel : public IChannel<T> {
   public:
+  using IChannel<T>::send;
+  using IChannel<T>::send_c; // rvalue sends copy
   void set_metrics_pipe(IChannel<ChannelMetricsEvent>* pipe, ChannelMetricsConfig cfg={}) { std::lock_guard<std::mutex> lk(mu_); metrics_pipe_=pipe; metrics_cfg_=cfg; }
-  explicit ConflatedChannel(WorkStealingScheduler* sched) : sched_(sched) {}
+  explicit ConflatedChannel(WorkStealingScheduler* sched, std::pmr::memory_resource* mr = nullptr)
+  : sched_(sched), recv_waiters_(detail::resource_or_heap(mr)), select_recv_waiters_(detail::resource_or_heap(mr)) {}
   int send(const T& val, long) override {
     std::unique_lock<std::mutex> lk(mu_);
     slot_ = val; has_ = true; bump_send(size_bytes_default(val));
-    if (!recv_waiters_.empty()) { auto co = recv_waiters_.front(); recv_waiters_.pop_front(); lk.unlock(); sched_->enqueue_ready(co); }
+    if (!recv_waiters_.empty()) { auto co = recv_waiters_.front(); recv_waiters_.pop_front(); lk.unlock(); sched_->enqueue_ready(co, this->wake_lane_); }
     return 0;
   }
   int recv(T& out, long timeout_ms) override {
@@ -402,7 +612,7 @@ template<typename T>
     auto deadline=(timeout_ms<0)?(uint64_t)(-1):(platform::now_ns()+(uint64_t)timeout_ms*1000000ULL);
     for(;;){ lk.unlock(); cur->park(); if(cancel && cancel->is_set()) { ++snap_.total_ecanceled; return KC_ECANCELED; } if(timeout_ms>=0 && platform::now_ns()>=deadline) { ++snap_.total_etime; return KC_ETIME; } return recv(out,0);}  
   }
-  void close() override { std::lock_guard<std::mutex> lk(mu_); closed_=true; for(auto* co: recv_waiters_) sched_->enqueue_ready(co); recv_waiters_.clear(); }
+  void close() override { std::lock_guard<std::mutex> lk(mu_); closed_=true; for(auto* co: recv_waiters_) sched_->enqueue_ready(co, this->wake_lane_); recv_waiters_.clear(); }
   size_t size() const override { return has_?1:0; }
   ChannelSnapshot snapshot() const { std::lock_guard<std::mutex> lk(mu_); return snap_; }
 
@@ -412,7 +622,7 @@ template<typename T>
   void select_cancel(ISelect* sel, int clause_index, SelectOp kind) override;
 private:
   WorkStealingScheduler* sched_{}; mutable std::mutex mu_{}; bool closed_{false};
-  std::optional<T> slot_{}; bool has_{false}; std::deque<Coroutine*> recv_waiters_{}; std::deque<std::tuple<ISelect*,int,T*>> select_recv_waiters_{}; ChannelSnapshot snap_{};
+  std::optional<T> slot_{}; bool has_{false}; std::pmr::deque<Coroutine*> recv_waiters_; std::pmr::deque<std::tuple<ISelect*,int,T*>> select_recv_waiters_; ChannelSnapshot snap_{};
   IChannel<ChannelMetricsEvent>* metrics_pipe_{nullptr}; ChannelMetricsConfig metrics_cfg_{};
   unsigned long last_emit_sends_{0}, last_emit_recvs_{0}, last_emit_bytes_sent_{0}, last_emit_bytes_recv_{0}; long long last_emit_time_ns_{0};
   inline void bump_send(size_t bytes){ auto now=platform::now_ns(); if(snap_.first_op_time_ns==0) snap_.first_op_time_ns=now; snap_.last_op_time_ns=now; ++snap_.total_sends; snap_.total_bytes_sent += bytes; maybe_emit(now); }
@@ -423,16 +633,16 @@ private:
 template<typename T>
 int ConflatedChannel<T>::select_register_recv(ISelect* sel, int clause_index, T* out) {
   std::unique_lock<std::mutex> lk(mu_);
-  if (has_) { *out = *slot_; has_ = false; bump_recv(size_bytes_default(*out)); if (sel->try_complete(clause_index,0)) if (auto* w=sel->waiter()) sched_->enqueue_ready(static_cast<Coroutine*>(w)); return 0; }
+  if (has_) { *out = *slot_; has_ = false; bump_recv(size_bytes_default(*out)); if (sel->try_complete(clause_index,0)) if (auto* w=sel->waiter()) sched_->enqueue_ready(static_cast<Coroutine*>(w), this->wake_lane_); return 0; }
   select_recv_waiters_.push_back({sel, clause_index, out}); return KC_EAGAIN;
 }
 
 template<typename T>
 int ConflatedChannel<T>::select_register_send(ISelect* sel, int clause_index, const T* val) {
   std::unique_lock<std::mutex> lk(mu_); slot_ = *val; has_ = true; bump_send(size_bytes_default(*val));
-  if (!select_recv_waiters_.empty()) { auto [s,i,out] = select_recv_waiters_.front(); select_recv_waiters_.pop_front(); *out = *slot_; has_ = false; bump_recv(size_bytes_default(*out)); if (s->try_complete(i,0)) if (auto* w=s->waiter()) sched_->enqueue_ready(static_cast<Coroutine*>(w)); }
-  else if (!recv_waiters_.empty()) { auto* co = recv_waiters_.front(); recv_waiters_.pop_front(); lk.unlock(); sched_->enqueue_ready(co); }
-  if (sel->try_complete(clause_index,0)) if (auto* w=sel->waiter()) sched_->enqueue_ready(static_cast<Coroutine*>(w));
+  if (!select_recv_waiters_.empty()) { auto [s,i,out] = select_recv_waiters_.front(); select_recv_waiters_.pop_front(); *out = *slot_; has_ = false; bump_recv(size_bytes_default(*out)); if (s->try_complete(i,0)) if (auto* w=s->waiter()) sched_->enqueue_ready(static_cast<Coroutine*>(w), this->wake_lane_); }
+  else if (!recv_waiters_.empty()) { auto* co = recv_waiters_.front(); recv_waiters_.pop_front(); lk.unlock(); sched_->enqueue_ready(co, this->wake_lane_); }
+  if (sel->try_complete(clause_index,0)) if (auto* w=sel->waiter()) sched_->enqueue_ready(static_cast<Coroutine*>(w), this->wake_lane_);
   return 0;
 }
 
@@ -448,13 +658,17 @@ void ConflatedChannel<T>::select_cancel(ISelect* sel, int clause_index, SelectOp
 template<typename T>
   class UnlimitedChannel : public IChannel<T> {
   public:
+  using IChannel<T>::send;
+  using IChannel<T>::send_c; // rvalue sends copy
   void set_metrics_pipe(IChannel<ChannelMetricsEvent>* pipe, ChannelMetricsConfig cfg={}) { std::lock_guard<std::mutex> lk(mu_); metrics_pipe_=pipe; metrics_cfg_=cfg; }
-  explicit UnlimitedChannel(WorkStealingScheduler* sched) : sched_(sched) {}
-  int send(const T& val, long) override { std::unique_lock<std::mutex> lk(mu_); q_.push_back(val); bump_send(size_bytes_default(val)); if(!recv_waiters_.empty()){auto co=recv_waiters_.front(); recv_waiters_.pop_front(); lk.unlock(); sched_->enqueue_ready(co);} return 0; }
+  // `mr` backs the queue and wait lists (nullptr: global heap).
+  explicit UnlimitedChannel(WorkStealingScheduler* sched, std::pmr::memory_resource* mr = nullptr)
+  : sched_(sched), q_(detail::resource_or_heap(mr)), recv_waiters_(detail::resource_or_heap(mr)), select_recv_waiters_(detail::resource_or_heap(mr)) {}
+  int send(const T& val, long) override { std::unique_lock<std::mutex> lk(mu_); q_.push_back(val); bump_send(size_bytes_default(val)); if(!recv_waiters_.empty()){auto co=recv_waiters_.front(); recv_waiters_.pop_front(); lk.unlock(); sched_->enqueue_ready(co, this->wake_lane_);} return 0; }
   int recv(T& out, long timeout_ms) override { std::unique_lock<std::mutex> lk(mu_); if(!q_.empty()){ out=q_.front(); q_.pop_front(); bump_recv(size_bytes_default(out)); return 0;} if(closed_) { ++snap_.total_epipe; return KC_EPIPE; } if(timeout_ms==0) { ++snap_.total_eagain; return KC_EAGAIN; } auto* cur=Coroutine::current(); if(!cur) { ++snap_.total_eagain; return KC_EAGAIN; } recv_waiters_.push_back(cur); lk.unlock(); cur->park(); return recv(out,0);} 
   int send_c(const T& val, long, const ICancellationToken*) override { return send(val, -1); }
   int recv_c(T& out, long timeout_ms, const ICancellationToken* cancel) override { std::unique_lock<std::mutex> lk(mu_); if(!q_.empty()){ out=q_.front(); q_.pop_front(); bump_recv(size_bytes_default(out)); return 0;} if(closed_) { ++snap_.total_epipe; return KC_EPIPE; } if(timeout_ms==0) { ++snap_.total_eagain; return KC_EAGAIN; } auto* cur=Coroutine::current(); if(!cur) { ++snap_.total_eagain; return KC_EAGAIN; } recv_waiters_.push_back(cur); auto deadline=(timeout_ms<0)?(uint64_t)(-1):(platform::now_ns()+(uint64_t)timeout_ms*1000000ULL); for(;;){ lk.unlock(); cur->park(); if(cancel && cancel->is_set()) { ++snap_.total_ecanceled; return KC_ECANCELED; } if(timeout_ms>=0 && platform::now_ns()>=deadline) { ++snap_.total_etime; return KC_ETIME; } return recv(out,0);} }
-  void close() override { std::lock_guard<std::mutex> lk(mu_); closed_=true; for(auto* co: recv_waiters_) sched_->enqueue_ready(co); recv_waiters_.clear(); }
+  void close() override { std::lock_guard<std::mutex> lk(mu_); closed_=true; for(auto* co: recv_waiters_) sched_->enqueue_ready(co, this->wake_lane_); recv_waiters_.clear(); }
   size_t size() const override { std::lock_guard<std::mutex> lk(mu_); return q_.size(); }
   ChannelSnapshot snapshot() const { std::lock_guard<std::mutex> lk(mu_); return snap_; }
 
@@ -463,7 +677,7 @@ template<typename T>
   int select_register_send(ISelect* sel, int clause_index, const T* val) override;
   void select_cancel(ISelect* sel, int clause_index, SelectOp kind) override;
 private:
-  WorkStealingScheduler* sched_{}; mutable std::mutex mu_{}; bool closed_{false}; std::deque<T> q_{}; std::deque<Coroutine*> recv_waiters_{}; std::deque<std::tuple<ISelect*,int,T*>> select_recv_waiters_{}; ChannelSnapshot snap_{};
+  WorkStealingScheduler* sched_{}; mutable std::mutex mu_{}; bool closed_{false}; std::pmr::deque<T> q_; std::pmr::deque<Coroutine*> recv_waiters_; std::pmr::deque<std::tuple<ISelect*,int,T*>> select_recv_waiters_; ChannelSnapshot snap_{};
   IChannel<ChannelMetricsEvent>* metrics_pipe_{nullptr}; ChannelMetricsConfig metrics_cfg_{};
   unsigned long last_emit_sends_{0}, last_emit_recvs_{0}, last_emit_bytes_sent_{0}, last_emit_bytes_recv_{0}; long long last_emit_time_ns_{0};
   inline void bump_send(size_t bytes){ auto now=platform::now_ns(); if(snap_.first_op_time_ns==0) snap_.first_op_time_ns=now; snap_.last_op_time_ns=now; ++snap_.total_sends; snap_.total_bytes_sent += bytes; maybe_emit(now); }
@@ -473,12 +687,12 @@ private:
 
 template<typename T>
 int UnlimitedChannel<T>::select_register_recv(ISelect* sel, int clause_index, T* out) {
-  std::unique_lock<std::mutex> lk(mu_); if (!q_.empty()) { *out=q_.front(); q_.pop_front(); bump_recv(size_bytes_default(*out)); if (sel->try_complete(clause_index,0)) if (auto* w=sel->waiter()) sched_->enqueue_ready(static_cast<Coroutine*>(w)); return 0; } select_recv_waiters_.push_back({sel,clause_index,out}); return KC_EAGAIN;
+  std::unique_lock<std::mutex> lk(mu_); if (!q_.empty()) { *out=q_.front(); q_.pop_front(); bump_recv(size_bytes_default(*out)); if (sel->try_complete(clause_index,0)) if (auto* w=sel->waiter()) sched_->enqueue_ready(static_cast<Coroutine*>(w), this->wake_lane_); return 0; } select_recv_waiters_.push_back({sel,clause_index,out}); return KC_EAGAIN;
 }
 
 template<typename T>
 int UnlimitedChannel<T>::select_register_send(ISelect* sel, int clause_index, const T* val) {
-  std::unique_lock<std::mutex> lk(mu_); q_.push_back(*val); bump_send(size_bytes_default(*val)); if(!select_recv_waiters_.empty()){ auto [s,i,out]=select_recv_waiters_.front(); select_recv_waiters_.pop_front(); *out=q_.front(); q_.pop_front(); bump_recv(size_bytes_default(*out)); if(s->try_complete(i,0)) if(auto* w=s->waiter()) sched_->enqueue_ready(static_cast<Coroutine*>(w)); } else if(!recv_waiters_.empty()){ auto* co=recv_waiters_.front(); recv_waiters_.pop_front(); lk.unlock(); sched_->enqueue_ready(co);} if(sel->try_complete(clause_index,0)) if(auto* w=sel->waiter()) sched_->enqueue_ready(static_cast<Coroutine*>(w)); return 0;
+  std::unique_lock<std::mutex> lk(mu_); q_.push_back(*val); bump_send(size_bytes_default(*val)); if(!select_recv_waiters_.empty()){ auto [s,i,out]=select_recv_waiters_.front(); select_recv_waiters_.pop_front(); *out=q_.front(); q_.pop_front(); bump_recv(size_bytes_default(*out)); if(s->try_complete(i,0)) if(auto* w=s->waiter()) sched_->enqueue_ready(static_cast<Coroutine*>(w), this->wake_lane_); } else if(!recv_waiters_.empty()){ auto* co=recv_waiters_.front(); recv_waiters_.pop_front(); lk.unlock(); sched_->enqueue_ready(co, this->wake_lane_);} if(sel->try_complete(clause_index,0)) if(auto* w=sel->waiter()) sched_->enqueue_ready(static_cast<Coroutine*>(w), this->wake_lane_); return 0;
 }
 
 template<typename T>
@@ -486,4 +700,238 @@ void UnlimitedChannel<T>::select_cancel(ISelect* sel, int clause_index, SelectOp
   if (kind==SelectOp::Send) return; std::lock_guard<std::mutex> lk(mu_); for(auto it=select_recv_waiters_.begin(); it!=select_recv_waiters_.end(); ++it){ if(std::get<0>(*it)==sel && std::get<1>(*it)==clause_index){ select_recv_waiters_.erase(it); break; } }
 }
 
+// Single-producer/single-consumer bounded channel. At most one coroutine sends
+// (directly or via select) and one receives at a time. Each side owns one
+// index and keeps a cached copy of the other's, so the hot path is wait-free
+// and touches the peer's cache line only when the ring looks full/empty;
+// mu_ is taken only to park a waiter or wake a parked peer, which the
+// *_waiting_ hints advertise (set before the final re-check under mu_, so they
+// may be stale-high but never stale-low). While a select clause is registered
+// its side's ring ops go through mu_ too, because the peer may push/pop on the
+// select's behalf. Timed waits re-check their deadline on every wake.
+template<typename T>
+class SpscChannel : public IChannel<T> {
+public:
+  using IChannel<T>::send;
+  using IChannel<T>::send_c; // rvalue sends copy
+  // `mr` backs the ring and wait lists (nullptr: global heap).
+  SpscChannel(WorkStealingScheduler* sched, size_t capacity, std::pmr::memory_resource* mr = nullptr)
+  : sched_(sched), mask_(round_pow2(capacity?capacity:64)-1), buf_(mask_+1, detail::resource_or_heap(mr)),
+    recv_waiters_(detail::resource_or_heap(mr)), send_waiters_(detail::resource_or_heap(mr)),
+    select_recv_waiters_(detail::resource_or_heap(mr)), select_send_waiters_(detail::resource_or_heap(mr)) {}
+
+  int send(const T& val, long timeout_ms) override { return send_c(val, timeout_ms, nullptr); }
+  int recv(T& out, long timeout_ms) override { return recv_c(out, timeout_ms, nullptr); }
+
+  int send_c(const T& val, long timeout_ms, const ICancellationToken* cancel) override {
+    auto deadline=(timeout_ms<0)?(uint64_t)(-1):(platform::now_ns()+(uint64_t)timeout_ms*1000000ULL);
+    for (;;) {
+      if (closed_.load(std::memory_order_acquire)) { epipe_.fetch_add(1, std::memory_order_relaxed); return KC_EPIPE; }
+      if (!sel_send_.load(std::memory_order_acquire)) {
+        if (try_push(val)) { wake_peer(recv_waiting_, SelectOp::Recv); return 0; }
+        if (timeout_ms == 0) { eagain_.fetch_add(1, std::memory_order_relaxed); return KC_EAGAIN; }
+      }
+      std::unique_lock<std::mutex> lk(mu_);
+      if (closed_.load(std::memory_order_relaxed)) { epipe_.fetch_add(1, std::memory_order_relaxed); sync_hints_locked(); return KC_EPIPE; }
+      announce(send_waiting_);
+      if (try_push(val)) { wake_recv_locked(lk); return 0; }
+      int rc = park_checks(timeout_ms, deadline, cancel);
+      if (rc != 0) { sync_hints_locked(); return rc; }
+      auto* cur = Coroutine::current(); if (!cur) { eagain_.fetch_add(1, std::memory_order_relaxed); sync_hints_locked(); return KC_EAGAIN; }
+      send_waiters_.push_back(cur);
+      lk.unlock(); cur->park();
+    }
+  }
+
+  int recv_c(T& out, long timeout_ms, const ICancellationToken* cancel) override {
+    auto deadline=(timeout_ms<0)?(uint64_t)(-1):(platform::now_ns()+(uint64_t)timeout_ms*1000000ULL);
+    for (;;) {
+      if (!sel_recv_.load(std::memory_order_acquire)) {
+        if (try_pop(out)) { wake_peer(send_waiting_, SelectOp::Send); return 0; }
+        if (timeout_ms == 0 && !closed_.load(std::memory_order_acquire)) { eagain_.fetch_add(1, std::memory_order_relaxed); return KC_EAGAIN; }
+      }
+      std::unique_lock<std::mutex> lk(mu_);
+      announce(recv_waiting_);
+      if (try_pop(out)) { wake_send_locked(lk); return 0; }
+      if (closed_.load(std::memory_order_relaxed)) { epipe_.fetch_add(1, std::memory_order_relaxed); sync_hints_locked(); return KC_EPIPE; }
+      int rc = park_checks(timeout_ms, deadline, cancel);
+      if (rc != 0) { sync_hints_locked(); return rc; }
+      auto* cur = Coroutine::current(); if (!cur) { eagain_.fetch_add(1, std::memory_order_relaxed); sync_hints_locked(); return KC_EAGAIN; }
+      recv_waiters_.push_back(cur);
+      lk.unlock(); cur->park();
+    }
+  }
+
+  void close() override {
+    std::lock_guard<std::mutex> lk(mu_);
+    closed_.store(true, std::memory_order_release);
+    log_fmt(LogLevel::Info, "spsc channel closed; waking waiters");
+    for (auto* co : recv_waiters_) sched_->enqueue_ready(co, this->wake_lane_);
+    for (auto* co : send_waiters_) sched_->enqueue_ready(co, this->wake_lane_);
+    recv_waiters_.clear(); send_waiters_.clear();
+    // Selects are completed here: senders with EPIPE, a receiver with a queued value if any.
+    for (auto& [s,i,v] : select_send_waiters_) { (void)v; if (s->try_complete(i, KC_EPIPE)) if (auto* w=s->waiter()) sched_->enqueue_ready(static_cast<Coroutine*>(w), this->wake_lane_); }
+    for (auto& [s,i,out] : select_recv_waiters_) { int rc = try_pop(*out) ? 0 : KC_EPIPE; if (s->try_complete(i, rc)) if (auto* w=s->waiter()) sched_->enqueue_ready(static_cast<Coroutine*>(w), this->wake_lane_); }
+    select_send_waiters_.clear(); select_recv_waiters_.clear();
+    sync_hints_locked();
+  }
+
+  size_t size() const override {
+    size_t h = head_.load(std::memory_order_acquire); size_t t = tail_.load(std::memory_order_acquire);
+    return (t - h) > mask_ + 1 ? mask_ + 1 : (t - h);
+  }
+
+  ChannelSnapshot snapshot() const {
+    ChannelSnapshot s{};
+    s.total_recvs = head_.load(std::memory_order_acquire);
+    s.total_sends = tail_.load(std::memory_order_acquire);
+    s.total_bytes_sent = bytes_sent_.load(std::memory_order_relaxed);
+    s.total_bytes_recv = bytes_recv_.load(std::memory_order_relaxed);
+    s.total_eagain = eagain_.load(std::memory_order_relaxed);
+    s.total_etime = etime_.load(std::memory_order_relaxed);
+    s.total_ecanceled = ecanceled_.load(std::memory_order_relaxed);
+    s.total_epipe = epipe_.load(std::memory_order_relaxed);
+    s.first_op_time_ns = first_op_ns_.load(std::memory_order_relaxed);
+    if (s.total_sends) s.last_op_time_ns = platform::now_ns();
+    s.caps = ChannelCaps::Spsc;
+    return s;
+  }
+
+  // Select registration (overrides)
+  int select_register_recv(ISelect* sel, int clause_index, T* out) override;
+  int select_register_send(ISelect* sel, int clause_index, const T* val) override;
+  void select_cancel(ISelect* sel, int clause_index, SelectOp kind) override;
+
+private:
+  static size_t round_pow2(size_t n) { size_t p = 2; while (p < n) p <<= 1; return p; }
+
+  // Producer side (plain fields owned by whoever currently holds the send role)
+  bool try_push(const T& v) {
+    size_t t = tail_.load(std::memory_order_relaxed);
+    if (t - head_cache_ > mask_) { head_cache_ = head_.load(std::memory_order_acquire); if (t - head_cache_ > mask_) return false; }
+    buf_[t & mask_] = v;
+    bytes_sent_.store(bytes_sent_.load(std::memory_order_relaxed) + size_bytes_default(v), std::memory_order_relaxed);
+    tail_.store(t + 1, std::memory_order_release);
+    if (t == 0) first_op_ns_.store((long long)platform::now_ns(), std::memory_order_relaxed);
+    return true;
+  }
+  // Consumer side
+  bool try_pop(T& out) {
+    size_t h = head_.load(std::memory_order_relaxed);
+    if (h == tail_cache_) { tail_cache_ = tail_.load(std::memory_order_acquire); if (h == tail_cache_) return false; }
+    out = buf_[h & mask_];
+    bytes_recv_.store(bytes_recv_.load(std::memory_order_relaxed) + size_bytes_default(out), std::memory_order_relaxed);
+    head_.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Pairs with the fence in wake_peer(): a peer that misses our re-check sees the hint.
+  static void announce(std::atomic<int>& hint) { hint.store(1, std::memory_order_relaxed); std::atomic_thread_fence(std::memory_order_seq_cst); }
+  void wake_peer(std::atomic<int>& hint, SelectOp side) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!hint.load(std::memory_order_relaxed)) return;
+    std::unique_lock<std::mutex> lk(mu_);
+    if (side == SelectOp::Recv) wake_recv_locked(lk); else wake_send_locked(lk);
+  }
+  void sync_hints_locked() {
+    recv_waiting_.store(!recv_waiters_.empty() || !select_recv_waiters_.empty(), std::memory_order_relaxed);
+    send_waiting_.store(!send_waiters_.empty() || !select_send_waiters_.empty(), std::memory_order_relaxed);
+    sel_recv_.store(!select_recv_waiters_.empty(), std::memory_order_release);
+    sel_send_.store(!select_send_waiters_.empty(), std::memory_order_release);
+  }
+  int park_checks(long timeout_ms, uint64_t deadline, const ICancellationToken* cancel) {
+    if (timeout_ms == 0) { eagain_.fetch_add(1, std::memory_order_relaxed); return KC_EAGAIN; }
+    if (cancel && cancel->is_set()) { ecanceled_.fetch_add(1, std::memory_order_relaxed); return KC_ECANCELED; }
+    if (timeout_ms > 0 && platform::now_ns() >= deadline) { etime_.fetch_add(1, std::memory_order_relaxed); return KC_ETIME; }
+    return 0;
+  }
+  // After a push (mu_ held; releases it): complete a select receiver by popping
+  // on its behalf, else wake a parked receiver.
+  void wake_recv_locked(std::unique_lock<std::mutex>& lk) {
+    ICoroutineContext* co = nullptr;
+    if (!select_recv_waiters_.empty()) {
+      auto [s,i,out] = select_recv_waiters_.front();
+      if (try_pop(*out)) { select_recv_waiters_.pop_front(); if (s->try_complete(i,0)) co = s->waiter(); }
+    } else if (!recv_waiters_.empty()) { co = recv_waiters_.front(); recv_waiters_.pop_front(); }
+    sync_hints_locked(); lk.unlock();
+    if (co) sched_->enqueue_ready(static_cast<Coroutine*>(co), this->wake_lane_);
+  }
+  // After a pop (mu_ held; releases it): complete a select sender by pushing
+  // on its behalf, else wake a parked sender.
+  void wake_send_locked(std::unique_lock<std::mutex>& lk) {
+    ICoroutineContext* co = nullptr;
+    if (!select_send_waiters_.empty()) {
+      auto& [s,i,v] = select_send_waiters_.front();
+      if (try_push(v)) { auto* sel = s; int idx = i; select_send_waiters_.pop_front(); if (sel->try_complete(idx,0)) co = sel->waiter(); }
+    } else if (!send_waiters_.empty()) { co = send_waiters_.front(); send_waiters_.pop_front(); }
+    sync_hints_locked(); lk.unlock();
+    if (co) sched_->enqueue_ready(static_cast<Coroutine*>(co), this->wake_lane_);
+  }
+
+  WorkStealingScheduler* sched_{};
+  const size_t mask_;
+  std::pmr::vector<T> buf_;
+  alignas(64) std::atomic<size_t> tail_{0};
+  size_t head_cache_{0};
+  std::atomic<unsigned long> bytes_sent_{0};
+  alignas(64) std::atomic<size_t> head_{0};
+  size_t tail_cache_{0};
+  std::atomic<unsigned long> bytes_recv_{0};
+  alignas(64) std::atomic<bool> closed_{false};
+  std::atomic<int> recv_waiting_{0}, send_waiting_{0};
+  std::atomic<bool> sel_recv_{false}, sel_send_{false};
+  std::atomic<long long> first_op_ns_{0};
+  std::atomic<unsigned long> eagain_{0}, etime_{0}, ecanceled_{0}, epipe_{0};
+  mutable std::mutex mu_;
+  std::pmr::deque<Coroutine*> recv_waiters_;
+  std::pmr::deque<Coroutine*> send_waiters_;
+  std::pmr::deque<std::tuple<ISelect*,int,T*>> select_recv_waiters_;
+  std::pmr::deque<std::tuple<ISelect*,int,T>> select_send_waiters_;
+};
+
+template<typename T>
+int SpscChannel<T>::select_register_recv(ISelect* sel, int clause_index, T* out) {
+  std::unique_lock<std::mutex> lk(mu_);
+  announce(recv_waiting_);
+  if (try_pop(*out)) {
+    if (sel->try_complete(clause_index, 0)) if (auto* w = sel->waiter()) sched_->enqueue_ready(static_cast<Coroutine*>(w), this->wake_lane_);
+    wake_send_locked(lk);
+    return 0;
+  }
+  if (closed_.load(std::memory_order_relaxed)) { sync_hints_locked(); return KC_EPIPE; }
+  select_recv_waiters_.push_back({sel, clause_index, out});
+  sync_hints_locked();
+  return KC_EAGAIN;
+}
+
+template<typename T>
+int SpscChannel<T>::select_register_send(ISelect* sel, int clause_index, const T* val) {
+  std::unique_lock<std::mutex> lk(mu_);
+  if (closed_.load(std::memory_order_relaxed)) { sync_hints_locked(); return KC_EPIPE; }
+  announce(send_waiting_);
+  if (try_push(*val)) {
+    if (sel->try_complete(clause_index, 0)) if (auto* w = sel->waiter()) sched_->enqueue_ready(static_cast<Coroutine*>(w), this->wake_lane_);
+    wake_recv_locked(lk);
+    return 0;
+  }
+  select_send_waiters_.push_back({sel, clause_index, *val});
+  sync_hints_locked();
+  return KC_EAGAIN;
+}
+
+template<typename T>
+void SpscChannel<T>::select_cancel(ISelect* sel, int clause_index, SelectOp kind) {
+  std::lock_guard<std::mutex> lk(mu_);
+  if (kind == SelectOp::Recv) {
+    for (auto it = select_recv_waiters_.begin(); it != select_recv_waiters_.end(); ++it) {
+      if (std::get<0>(*it) == sel && std::get<1>(*it) == clause_index) { select_recv_waiters_.erase(it); break; }
+    }
+  } else {
+    for (auto it = select_send_waiters_.begin(); it != select_send_waiters_.end(); ++it) {
+      if (std::get<0>(*it) == sel && std::get<1>(*it) == clause_index) { select_send_waiters_.erase(it); break; }
+    }
+  }
+  sync_hints_locked();
+}
+
 } // namespace kcoro_cpp
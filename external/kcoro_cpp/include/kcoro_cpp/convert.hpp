@@ -0,0 +1,41 @@
+#pragma once
+
+#include "kcoro_cpp/core.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace kcoro_cpp {
+namespace convert {
+
+// Bulk element conversion for FormatMode::Adapt. Narrowing rounds to
+// nearest, ties to even, and saturates to infinity like IEEE-754 (and the
+// klang float16 reference tools); NaNs stay NaN, quieted. FP32<->FP16 uses
+// hardware conversion where the CPU has it (NEON on arm64, F16C on x86-64)
+// and a bit-exact scalar loop elsewhere; BF16 is integer math the compiler
+// vectorises.
+void fp32_to_fp16(const float* src, uint16_t* dst, size_t n);
+void fp16_to_fp32(const uint16_t* src, float* dst, size_t n);
+void fp32_to_bf16(const float* src, uint16_t* dst, size_t n);
+void bf16_to_fp32(const uint16_t* src, float* dst, size_t n);
+
+// Scalar references of the above, one element each
+uint16_t fp32_to_fp16(float f);
+float    fp16_to_fp32(uint16_t h);
+uint16_t fp32_to_bf16(float f);
+float    bf16_to_fp32(uint16_t h);
+
+// Bytes per element, 0 for dtypes convert() does not handle
+size_t elem_size(DType t);
+
+// from -> to is a pair convert() handles: the same dtype (a copy), or any
+// two of FP32, FP16 and BF16.
+bool supported(DType from, DType to);
+
+// rows rows of row_elems elements each, row pitches in bytes (0: packed).
+// false when the pair is not supported.
+bool convert_rows(DType from, const void* src, size_t src_pitch,
+                  DType to, void* dst, size_t dst_pitch,
+                  size_t rows, size_t row_elems);
+
+} // namespace convert
+} // namespace kcoro_cpp
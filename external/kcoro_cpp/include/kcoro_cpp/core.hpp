@@ -5,24 +5,35 @@
 #include <cstddef>
 #include <string>
 #include <memory>
+#include <memory_resource>
 #include <stdexcept>
 
 namespace kcoro_cpp {
 
 struct Error : std::runtime_error { using std::runtime_error::runtime_error; };
 
+namespace detail {
+// Channels, selects and scheduler-spawned coroutines take an optional
+// std::pmr::memory_resource for their own allocations; nullptr is the heap.
+inline std::pmr::memory_resource* resource_or_heap(std::pmr::memory_resource* mr) {
+  return mr ? mr : std::pmr::new_delete_resource();
+}
+} // namespace detail
+
 // Error codes (negative like -errno style)
 constexpr int KC_EAGAIN    = -11;   // try would block
 constexpr int KC_EPIPE     = -32;   // closed
 constexpr int KC_ETIME     = -62;   // timeout
 constexpr int KC_ECANCELED = -125;  // canceled
 constexpr int KC_ENOTSUP   = -95;   // not supported
+constexpr int KC_ENOBUFS   = -105;  // no buffer free
 
 // Capabilities
 enum class ChannelCaps : uint32_t {
   None      = 0,
   Ptr       = 1u << 0,  // pointer/len
   ZeroCopy  = 1u << 1,  // zref backend active
+  Spsc      = 1u << 2,  // wait-free single-producer/single-consumer ring
 };
 inline ChannelCaps operator|(ChannelCaps a, ChannelCaps b){ return ChannelCaps(uint32_t(a)|uint32_t(b)); }
 inline ChannelCaps& operator|=(ChannelCaps& a, ChannelCaps b){ a = a|b; return a; }
@@ -46,11 +57,19 @@ public:
 };
 
 // Scheduler ------------------------------------------------------------------
+// Priority lanes (mirrors kc_lane_t): interactive work runs first; bulk work
+// runs when a worker is otherwise idle, plus at least one item every
+// bulk_share worker turns so it cannot starve.
+enum class Lane : int { Inherit = -1, Interactive = 0, Bulk = 1 };
+inline constexpr int kLaneCount = 2;
+
 class IScheduler {
 public:
   virtual ~IScheduler() = default;
   virtual void spawn(void (*fn)(void*), void* arg, size_t stack_bytes = 64*1024) = 0;
   virtual void enqueue_ready(ICoroutineContext* co) = 0;
+  // Wake on a given lane; schedulers without lanes ignore it.
+  virtual void enqueue_ready(ICoroutineContext* co, Lane lane) { (void)lane; enqueue_ready(co); }
   virtual void drain(long timeout_ms) = 0;
 };
 
@@ -66,12 +85,22 @@ public:
   // Cancellable variants (optional token)
   virtual int send_c(const T& val, long timeout_ms, const ICancellationToken* cancel) = 0;
   virtual int recv_c(T& out, long timeout_ms, const ICancellationToken* cancel) = 0;
+  // Move-in variants. The defaults copy; channels that can take ownership of
+  // the value (Buffered, Rendezvous) override them.
+  virtual int send(T&& val, long timeout_ms = -1) { return send(static_cast<const T&>(val), timeout_ms); }
+  virtual int send_c(T&& val, long timeout_ms, const ICancellationToken* cancel) { return send_c(static_cast<const T&>(val), timeout_ms, cancel); }
   virtual void close() = 0;
   virtual size_t size() const = 0;
   // Select registration hooks
   virtual int select_register_recv(class ISelect* sel, int clause_index, T* out) = 0;
   virtual int select_register_send(class ISelect* sel, int clause_index, const T* val) = 0;
   virtual void select_cancel(class ISelect* sel, int clause_index, SelectOp kind) = 0;
+  // Lane for coroutines this channel wakes (Inherit: each coroutine's own).
+  // Set before the channel is shared.
+  void set_wake_lane(Lane lane) { wake_lane_ = lane; }
+  Lane wake_lane() const { return wake_lane_; }
+protected:
+  Lane wake_lane_ { Lane::Inherit };
 };
 
 // Select ---------------------------------------------------------------------
@@ -99,6 +128,8 @@ struct ZDesc {
   uint64_t offset{};
   uint32_t flags{};
 };
+// flags: payload was converted into a ConvertPool slot, release it there
+constexpr uint32_t ZDESC_F_CONVERTED = 1u<<0;
 
 // DType and RegionMeta (for SIMD/layout-aware zero-copy)
 enum class DType : uint32_t { Unspec=0, U8,S8, U16,S16, FP16,BF16, U32,S32, FP32, U64,S64, FP64, U128, Opaque128 };
@@ -122,7 +153,9 @@ constexpr FormatMask FMT_STRIDE   = 1ull<<3;
 constexpr FormatMask FMT_DIMS     = 1ull<<4;
 constexpr FormatMask FMT_LAYOUT   = 1ull<<5;
 
-enum class FormatMode : uint32_t { Advisory=0, Strict=1 };
+// Adapt converts convertible mismatches on receive (see ConvertPool) and
+// rejects the rest like Strict
+enum class FormatMode : uint32_t { Advisory=0, Strict=1, Adapt=2 };
 
 // Map to KC_* style error codes used in channels
 constexpr int KC_EINVAL = -22;
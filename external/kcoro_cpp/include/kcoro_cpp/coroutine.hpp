@@ -2,7 +2,10 @@
 
 #include "kcoro_cpp/core.hpp"
 #include "kcoro_cpp/platform.hpp"
+#include "kcoro_cpp/timer_wheel.hpp"
 #include <atomic>
+#include <memory>
+#include <memory_resource>
 
 extern "C" void* kcoro_switch(void* from_co, void* to_co);
 
@@ -10,6 +13,15 @@ namespace kcoro_cpp {
 
 enum class CoState { CREATED, READY, RUNNING, SUSPENDED, PARKED, FINISHED };
 
+// Coroutine-local storage keys (CoroutineLocal<T>): kClsInline slots live in
+// the Coroutine, the rest in a table allocated on first use.
+constexpr unsigned kClsKeys = 128;
+constexpr unsigned kClsInline = 4;
+namespace detail {
+  // New key whose values dtor frees at finish; throws Error past kClsKeys.
+  unsigned cls_key_create(void (*dtor)(void*));
+}
+
 struct CoContext {
   void* reg[32]{}; // layout must match kc_ctx_switch.S expectations
   // Debug instrumentation fields (appended so offsets in assembly remain valid)
@@ -33,6 +45,16 @@ public:
   bool is_parked() const override { return state_ == CoState::PARKED; }
   bool is_finished() const { return state_ == CoState::FINISHED; }
   void set_name(const char* n) override { name_ = n ? n : ""; }
+  // Scheduler lane for spawns, yields and Lane::Inherit wakes.
+  void set_lane(Lane lane) { lane_ = (lane == Lane::Bulk) ? Lane::Bulk : Lane::Interactive; }
+  Lane lane() const { return lane_; }
+  // Coroutine-local slot of key (detail::cls_key_create); nullptr if unset.
+  void* local(unsigned key) const {
+    if (key < kClsInline) return cls_[key];
+    return (cls_ext_ && key < kClsKeys) ? cls_ext_[key - kClsInline] : nullptr;
+  }
+  // nullptr clears without running the key's destructor.
+  void set_local(unsigned key, void* value);
 
   static Coroutine* current();
   static Coroutine* main();
@@ -44,6 +66,13 @@ private:
   static thread_local Coroutine* tls_current_;
   static thread_local Coroutine* tls_main_;
 
+  void prepare_context();
+  // Run the destructors of the values still set (on finish, reuse, delete).
+  void finish_locals();
+  // Restart a FINISHED coroutine in place, keeping its stack; false when the
+  // stack size differs (the scheduler then frees it and allocates afresh).
+  bool reuse(Fn fn, void* arg, std::size_t stack_bytes);
+
   CoContext ctx_{};
   platform::MMapStack stack_{};
   CoState state_ { CoState::CREATED };
@@ -51,9 +80,20 @@ private:
   void* arg_ { nullptr };
   Coroutine* main_co_ { nullptr };
   std::string name_;
-  // Intrusive ready-queue linkage (managed only under scheduler ready list mutex)
-  Coroutine* next_ready_ { nullptr };
-  bool ready_enqueued_ { false };
+  // Set by the waker that queued this coroutine, cleared by the worker that
+  // pops it: exactly one concurrent wake gets it onto a ready queue.
+  std::atomic<bool> ready_enqueued_ { false };
+  // Armed by WorkStealingScheduler::wake_after; one pending wake at a time
+  detail::TimerNode timer_;
+  Lane lane_ { Lane::Interactive };
+  std::size_t stack_req_ { 0 }; // requested size; stack_.size is rounded up
+  // Worker retire list / free pool link, and the epoch it was retired in
+  Coroutine* pool_next_ { nullptr };
+  uint64_t retire_epoch_ { 0 };
+  std::pmr::memory_resource* mr_ { nullptr }; // set when spawn_co placed it in a resource
+  void* cls_[kClsInline] {};
+  std::unique_ptr<void*[]> cls_ext_;
+  bool cls_used_ { false };
 public: // narrow debug accessors (keep at end to minimize surface)
   CoContext& debug_ctx() { return ctx_; }
   const CoContext& debug_ctx() const { return ctx_; }
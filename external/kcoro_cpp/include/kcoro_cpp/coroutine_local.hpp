@@ -0,0 +1,49 @@
+#pragma once
+
+#include "kcoro_cpp/coroutine.hpp"
+#include <utility>
+
+namespace kcoro_cpp {
+
+// thread_local for coroutines: each kcoro_cpp coroutine sees its own T,
+// default-constructed on first get() and destroyed when the coroutine
+// function returns (or the coroutine is deleted unfinished). Access is an
+// index into the current Coroutine, no lookup by id. Meant for statics such
+// as a request id or trace span; each instance takes one of kClsKeys keys
+// for the life of the process. Outside any coroutine the thread's main
+// context holds the value, which then lives as long as the thread.
+template <class T>
+class CoroutineLocal {
+public:
+  CoroutineLocal() : key_(detail::cls_key_create(&destroy)) {}
+  CoroutineLocal(const CoroutineLocal&) = delete;
+  CoroutineLocal& operator=(const CoroutineLocal&) = delete;
+
+  T& get() {
+    Coroutine* co = context();
+    void* p = co->local(key_);
+    if (!p) { p = new T(); co->set_local(key_, p); }
+    return *static_cast<T*>(p);
+  }
+  // Current value without creating one.
+  T* get_if() const {
+    Coroutine* co = Coroutine::current();
+    return co ? static_cast<T*>(co->local(key_)) : nullptr;
+  }
+  template <class U> void set(U&& v) { get() = std::forward<U>(v); }
+  // Destroy the current coroutine's value now; the next get() starts afresh.
+  void reset() {
+    Coroutine* co = Coroutine::current();
+    if (!co) return;
+    if (void* p = co->local(key_)) { co->set_local(key_, nullptr); destroy(p); }
+  }
+  T& operator*() { return get(); }
+  T* operator->() { return &get(); }
+
+private:
+  static void destroy(void* p) { delete static_cast<T*>(p); }
+  static Coroutine* context() { Coroutine::ensure_main(); return Coroutine::current(); }
+  unsigned key_;
+};
+
+} // namespace kcoro_cpp
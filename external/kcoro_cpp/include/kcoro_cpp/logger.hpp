@@ -1,15 +1,31 @@
 #pragma once
 
-#include "kcoro_cpp/scheduler.hpp"
-#include <string>
+// Binary logger. A call appends one record (level, raw steady-clock stamp,
+// format pointer, encoded arguments) to the calling thread's SPSC ring; a
+// background writer thread formats records and writes them in batches with
+// writev. Under LogOverflow::Drop (the default) a full ring drops the record
+// and counts it, so logging never blocks a coroutine.
+//
+//   log_fmt(LogLevel::Warn, "queue {} over limit ({} > {})", name, depth, limit);
+//
+// `{}` takes the next argument. The format is kept by pointer, so it must be
+// a string literal (LogFormat only accepts constant expressions); string
+// arguments are copied (up to 4 KiB each). The std::string forms copy the
+// finished text.
+
 #include <atomic>
-#include <memory>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
 
 namespace kcoro_cpp {
 
-template<typename T>
-class BufferedChannel;
-
 enum class LogLevel {
   Info,
   Warn,
@@ -17,28 +33,125 @@ enum class LogLevel {
   Debug
 };
 
+enum class LogOverflow {
+  Drop,  // full ring: drop the record and count it in stats().dropped
+  Block  // full ring: yield until the writer catches up (tools, tests)
+};
+
+struct LogFormat {
+  const char* str;
+  template<std::size_t N>
+  consteval LogFormat(const char (&s)[N]) : str(s) {}
+};
+
+namespace detail {
+
+struct LogRing;
+
+enum class LogArgTag : uint8_t { I64, U64, F64, Bool, Char, Ptr, Str };
+
+// One argument as the encoder sees it; `s`/`len` only for Str.
+struct LogArgView {
+  LogArgTag tag;
+  uint64_t bits;
+  const char* s;
+  std::size_t len;
+};
+
+template<typename> inline constexpr bool kLogUnsupported = false;
+
+template<typename T>
+LogArgView log_arg(const T& v) {
+  using D = std::decay_t<T>;
+  if constexpr (std::is_same_v<D, bool>) {
+    return {LogArgTag::Bool, v ? 1u : 0u, nullptr, 0};
+  } else if constexpr (std::is_same_v<D, char>) {
+    return {LogArgTag::Char, (uint64_t)(unsigned char)v, nullptr, 0};
+  } else if constexpr (std::is_enum_v<D>) {
+    return {LogArgTag::I64, (uint64_t)(int64_t)static_cast<std::underlying_type_t<D>>(v), nullptr, 0};
+  } else if constexpr (std::is_integral_v<D> && std::is_signed_v<D>) {
+    return {LogArgTag::I64, (uint64_t)(int64_t)v, nullptr, 0};
+  } else if constexpr (std::is_integral_v<D>) {
+    return {LogArgTag::U64, (uint64_t)v, nullptr, 0};
+  } else if constexpr (std::is_floating_point_v<D>) {
+    double d = (double)v; uint64_t b; std::memcpy(&b, &d, sizeof(b));
+    return {LogArgTag::F64, b, nullptr, 0};
+  } else if constexpr (std::is_array_v<T>) {
+    return {LogArgTag::Str, 0, v, std::strlen(v)};
+  } else if constexpr (std::is_same_v<D, const char*> || std::is_same_v<D, char*>) {
+    const char* s = v ? v : "(null)";
+    return {LogArgTag::Str, 0, s, std::strlen(s)};
+  } else if constexpr (std::is_convertible_v<const D&, std::string_view>) {
+    std::string_view sv = v;
+    return {LogArgTag::Str, 0, sv.data(), sv.size()};
+  } else if constexpr (std::is_pointer_v<D>) {
+    return {LogArgTag::Ptr, (uint64_t)(uintptr_t)(const void*)v, nullptr, 0};
+  } else {
+    static_assert(kLogUnsupported<D>, "unsupported log argument type");
+  }
+}
+
+} // namespace detail
+
 class Logger {
 public:
   static Logger& instance();
 
-  void submit(LogLevel level, std::string message);
+  template<typename... Args>
+  void log(LogLevel level, LogFormat fmt, const Args&... args) {
+    detail::LogArgView views[sizeof...(Args) ? sizeof...(Args) : 1] = {detail::log_arg(args)...};
+    write_record(level, fmt.str, views, sizeof...(Args));
+  }
+  void submit(LogLevel level, std::string_view message);
+  // Waits (up to 1 s) until everything logged before the call is written.
   void flush();
 
+  void set_overflow(LogOverflow mode) { overflow_.store(mode, std::memory_order_relaxed); }
+  void set_fd(int fd) { fd_.store(fd, std::memory_order_relaxed); } // default stderr
+
+  struct Stats {
+    uint64_t written{0}; // records formatted and written
+    uint64_t dropped{0}; // records lost to full rings, as of the writer's last pass
+  };
+  Stats stats() const;
+
   Logger(const Logger&) = delete;
   Logger& operator=(const Logger&) = delete;
 
 private:
   Logger();
-  void start_worker();
-  static void worker_trampoline(void* arg);
-  void worker_loop();
-
-  WorkStealingScheduler* sched_{};
-  std::unique_ptr<BufferedChannel<std::string>> chan_;
-  std::atomic<bool> worker_started_{false};
-  std::atomic<bool> draining_{false};
+  void write_record(LogLevel level, const char* fmt, const detail::LogArgView* args, std::size_t nargs);
+  detail::LogRing* thread_ring();
+  void start_writer();
+  void writer_loop();
+
+  std::atomic<LogOverflow> overflow_{LogOverflow::Drop};
+  std::atomic<int> fd_;
+  const uint64_t steady_base_ns_; // clocks sampled together, to stamp lines
+  const int64_t system_base_ns_;
+
+  // Rings of live and exited threads; the writer frees a drained ring once
+  // its thread is gone
+  std::mutex rings_mu_;
+  std::vector<detail::LogRing*> rings_;
+  std::atomic<uint64_t> rings_gen_{0};
+
+  std::once_flag writer_once_;
+  std::thread writer_;
+  std::atomic<bool> writer_sleeping_{false};
+  std::mutex mu_;
+  std::condition_variable wake_cv_, done_cv_;
+  std::atomic<uint64_t> flush_req_{0};
+  uint64_t flush_done_{0}; // under mu_
+
+  std::atomic<uint64_t> written_{0}, dropped_{0};
 };
 
+template<typename... Args>
+void log_fmt(LogLevel level, LogFormat fmt, const Args&... args) {
+  Logger::instance().log(level, fmt, args...);
+}
+
 void log_message(LogLevel level, const std::string& message);
 inline void log_info(const std::string& message) { log_message(LogLevel::Info, message); }
 inline void log_warn(const std::string& message) { log_message(LogLevel::Warn, message); }
@@ -1,5 +1,6 @@
 #pragma once
 #include <cstddef>
+#include <algorithm>
 #include <cstdint>
 #include <string>
 #include <stdexcept>
@@ -14,6 +15,12 @@ inline std::size_t page_size() {
   return p > 0 ? static_cast<std::size_t>(p) : 4096u;
 }
 
+// mincore's address/vector parameter types differ between Linux and Darwin.
+template <class A, class V>
+inline int mincore_compat(int (*fn)(A, std::size_t, V*), void* addr, std::size_t len, unsigned char* vec) {
+  return fn(static_cast<A>(addr), len, reinterpret_cast<V*>(vec));
+}
+
 struct MMapStack {
   // ptr/size describe the USABLE stack memory (excluding guard page)
   void* ptr{};
@@ -26,7 +33,12 @@ struct MMapStack {
     if (bytes == 0) bytes = ps; // ensure at least one page usable
     std::size_t usable = (bytes + ps - 1) & ~(ps - 1);
     std::size_t total = usable + ps; // one guard page at low address
-    void* mem = ::mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    // NORESERVE: pages are committed on first touch, so large stacks are cheap
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_NORESERVE
+    flags |= MAP_NORESERVE;
+#endif
+    void* mem = ::mmap(nullptr, total, PROT_READ | PROT_WRITE, flags, -1, 0);
     if (mem == MAP_FAILED) throw std::runtime_error("mmap stack failed");
     // Protect the first (lowest) page as guard (stack grows downward)
     if (::mprotect(mem, ps, PROT_NONE) != 0) {
@@ -36,12 +48,53 @@ struct MMapStack {
     void* usable_base = static_cast<char*>(mem) + ps;
     return {usable_base, usable, mem, total};
   }
+  // Bytes from the top of the stack down to its deepest resident page
+  // (pooled stacks are released to their top page on recycle); 0 if unknown.
+  std::size_t high_water() const {
+    std::size_t ps = page_size();
+    unsigned char vec[256];
+    for (std::size_t first = 0; first < size / ps; first += sizeof(vec)) {
+      std::size_t n = std::min(size / ps - first, sizeof(vec));
+      char* addr = static_cast<char*>(ptr) + first * ps;
+      if (mincore_compat(::mincore, addr, n * ps, vec) != 0) return 0;
+      for (std::size_t i = 0; i < n; ++i)
+        if (vec[i] & 1) return size - (first + i) * ps;
+    }
+    return 0;
+  }
   void release() {
     if (raw_ptr && raw_size) ::munmap(raw_ptr, raw_size);
     ptr = nullptr; size = 0; raw_ptr = nullptr; raw_size = 0;
   }
 };
 
+// Reuse pool for coroutine stacks (src/stack_pool.cpp). Usable sizes are
+// rounded up to power-of-two classes (16 KiB << n, ten classes; larger stacks
+// bypass the pool). Each thread caches up to `per_thread` free stacks per
+// class and spills half to a mutex-protected global depot (at most `depot`
+// per class, the rest is unmapped); an empty thread cache refills from the
+// depot. Returned stacks keep guard and top page, the rest is madvise'd away.
+struct StackPoolStats {
+  std::uint64_t reused{};      // stacks handed out from a cache or the depot
+  std::uint64_t mapped{};      // stacks newly mapped
+  std::uint64_t unmapped{};    // stacks given back to the OS
+  std::size_t depot_stacks{};  // free stacks in the global depot
+  std::size_t thread_stacks{}; // free stacks in the calling thread's cache
+};
+
+class StackPool {
+public:
+  static MMapStack acquire(std::size_t bytes);
+  // Takes ownership of `s` (left empty); stacks not from acquire() are released.
+  static void recycle(MMapStack& s);
+  // High-water marks in stacks per class; per_thread == 0 disables pooling.
+  static void set_limits(unsigned per_thread, unsigned depot);
+  // Unmap the depot and the calling thread's cache.
+  static void trim();
+  // Other threads' counters are folded in when they touch the depot or exit.
+  static StackPoolStats stats();
+};
+
 inline std::uint64_t now_ns() {
   using namespace std::chrono;
   return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
@@ -0,0 +1,260 @@
+#pragma once
+
+// Lock-free queues behind WorkStealingScheduler; same algorithms as the C
+// scheduler (kcoro/core/src/kc_sched.c).
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+namespace kcoro_cpp {
+
+struct Task {
+  void (*fn)(void*);
+  void* arg;
+#ifdef KCORO_CPP_INTERNAL_CTX_DEBUG
+  uint32_t magic{0xC0A1FACE};
+  uint32_t gen{0};
+#endif
+};
+
+namespace detail {
+
+// Chase-Lev work-stealing deque (Le, Pop, Cohen, Zappa Nardelli, PPoPP'13).
+// The owning worker pushes/pops at `bottom` and only races thieves (CAS on
+// `top`) for the last element. Growth swaps in a doubled array; retired
+// arrays live until destruction because a thief may still read an old slot.
+class TaskDeque {
+public:
+  enum StealResult { kEmpty = 0, kOk = 1, kAbort = -1 };
+
+  explicit TaskDeque(int64_t cap = 1024) {
+    int64_t c = 1; while (c < cap) c <<= 1;
+    arr_.store(new Array(c, nullptr), std::memory_order_relaxed);
+  }
+  ~TaskDeque() {
+    Array* a = arr_.load(std::memory_order_relaxed);
+    while (a) { Array* r = a->retired; delete a; a = r; }
+  }
+  TaskDeque(const TaskDeque&) = delete;
+  TaskDeque& operator=(const TaskDeque&) = delete;
+
+  // Owner only.
+  void push(const Task& t) {
+    int64_t b = bottom_.load(std::memory_order_relaxed);
+    int64_t tp = top_.load(std::memory_order_acquire);
+    Array* a = arr_.load(std::memory_order_relaxed);
+    if (b - tp > a->cap - 1) a = grow(a, b, tp);
+    Slot& s = a->slot[b & (a->cap - 1)];
+    s.fn.store(t.fn, std::memory_order_relaxed);
+    s.arg.store(t.arg, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom_.store(b + 1, std::memory_order_relaxed);
+  }
+
+  // Owner only. LIFO end.
+  bool pop(Task& out) {
+    int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+    Array* a = arr_.load(std::memory_order_relaxed);
+    bottom_.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top_.load(std::memory_order_relaxed);
+    if (t > b) { bottom_.store(b + 1, std::memory_order_relaxed); return false; }
+    Slot& s = a->slot[b & (a->cap - 1)];
+    out = Task{};
+    out.fn = s.fn.load(std::memory_order_relaxed);
+    out.arg = s.arg.load(std::memory_order_relaxed);
+    if (t == b) {
+      // Last element: race thieves for it
+      bool won = top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+      bottom_.store(b + 1, std::memory_order_relaxed);
+      return won;
+    }
+    return true;
+  }
+
+  // Any thread. FIFO end; kAbort when the CAS on top lost a race.
+  StealResult steal(Task& out) {
+    int64_t t = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = bottom_.load(std::memory_order_acquire);
+    if (t >= b) return kEmpty;
+    Array* a = arr_.load(std::memory_order_acquire);
+    Slot& s = a->slot[t & (a->cap - 1)];
+    Task v{};
+    v.fn = s.fn.load(std::memory_order_relaxed);
+    v.arg = s.arg.load(std::memory_order_relaxed);
+    if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) return kAbort;
+    out = v;
+    return kOk;
+  }
+
+  // Approximate; for donation and idle checks only.
+  size_t size_approx() const {
+    int64_t b = bottom_.load(std::memory_order_relaxed);
+    int64_t t = top_.load(std::memory_order_relaxed);
+    return b > t ? (size_t)(b - t) : 0;
+  }
+
+private:
+  struct Slot {
+    std::atomic<void (*)(void*)> fn{nullptr};
+    std::atomic<void*> arg{nullptr};
+  };
+  struct Array {
+    Array(int64_t c, Array* r) : cap(c), retired(r), slot(new Slot[(size_t)c]) {}
+    int64_t cap; // power of two
+    Array* retired;
+    std::unique_ptr<Slot[]> slot;
+  };
+
+  Array* grow(Array* a, int64_t b, int64_t t) {
+    Array* na = new Array(a->cap * 2, a);
+    for (int64_t i = t; i < b; i++) {
+      Slot& src = a->slot[i & (a->cap - 1)];
+      Slot& dst = na->slot[i & (na->cap - 1)];
+      dst.fn.store(src.fn.load(std::memory_order_relaxed), std::memory_order_relaxed);
+      dst.arg.store(src.arg.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    arr_.store(na, std::memory_order_release);
+    return na;
+  }
+
+  alignas(64) std::atomic<int64_t> top_{0};    // thieves steal here (CAS)
+  alignas(64) std::atomic<int64_t> bottom_{0}; // owner push/pop here
+  std::atomic<Array*> arr_{nullptr};
+};
+
+// Bounded MPMC ring (Vyukov): each cell carries a sequence number telling
+// producers and consumers whose turn it is, so both ends only CAS their
+// own index.
+template<typename T>
+class MpmcRing {
+public:
+  explicit MpmcRing(size_t cap) {
+    size_t c = 2; while (c < cap) c <<= 1;
+    mask_ = c - 1;
+    cells_.reset(new Cell[c]);
+    for (size_t i = 0; i < c; i++) cells_[i].seq.store(i, std::memory_order_relaxed);
+  }
+  MpmcRing(const MpmcRing&) = delete;
+  MpmcRing& operator=(const MpmcRing&) = delete;
+
+  bool try_push(const T& v) {
+    size_t pos = tail_.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell& c = cells_[pos & mask_];
+      size_t seq = c.seq.load(std::memory_order_acquire);
+      intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+      if (dif == 0) {
+        if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          c.val = v;
+          c.seq.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (dif < 0) {
+        return false; // full
+      } else {
+        pos = tail_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  bool try_pop(T& out) {
+    size_t pos = head_.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell& c = cells_[pos & mask_];
+      size_t seq = c.seq.load(std::memory_order_acquire);
+      intptr_t dif = (intptr_t)seq - (intptr_t)(pos + 1);
+      if (dif == 0) {
+        if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          out = c.val;
+          c.seq.store(pos + mask_ + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (dif < 0) {
+        return false; // empty
+      } else {
+        pos = head_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  size_t size_approx() const {
+    size_t t = tail_.load(std::memory_order_relaxed), h = head_.load(std::memory_order_relaxed);
+    return t > h ? t - h : 0;
+  }
+
+private:
+  struct Cell { std::atomic<size_t> seq; T val{}; };
+  alignas(64) std::atomic<size_t> head_{0};
+  alignas(64) std::atomic<size_t> tail_{0};
+  alignas(64) size_t mask_{0};
+  std::unique_ptr<Cell[]> cells_;
+};
+
+// MpmcRing that never refuses: a full ring spills into a locked deque, which
+// consumers only look at while `spilled_` says it holds something.
+template<typename T>
+class InjectQueue {
+public:
+  explicit InjectQueue(size_t cap = 2048) : ring_(cap) {}
+
+  void push(const T& v) {
+    if (ring_.try_push(v)) return;
+    std::lock_guard<std::mutex> lk(mu_);
+    spill_.push_back(v);
+    spilled_.fetch_add(1, std::memory_order_release);
+  }
+  bool try_pop(T& out) {
+    if (ring_.try_pop(out)) return true;
+    if (spilled_.load(std::memory_order_acquire) == 0) return false;
+    std::lock_guard<std::mutex> lk(mu_);
+    if (spill_.empty()) return false;
+    out = spill_.front(); spill_.pop_front();
+    spilled_.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+  }
+  bool empty_approx() const { return ring_.size_approx() == 0 && spilled_.load(std::memory_order_relaxed) == 0; }
+
+private:
+  MpmcRing<T> ring_;
+  std::mutex mu_;
+  std::deque<T> spill_;
+  std::atomic<size_t> spilled_{0};
+};
+
+// One-task handoff from non-worker threads into a worker, stored inline so
+// spawning never allocates. A producer claims EMPTY -> BUSY, writes the task
+// and publishes FULL; only the owning worker takes it (FULL -> EMPTY).
+class TaskSlot {
+public:
+  bool offer(const Task& t) {
+    uint32_t expected = kEmpty;
+    if (state_.load(std::memory_order_relaxed) != kEmpty ||
+        !state_.compare_exchange_strong(expected, kBusy, std::memory_order_acquire, std::memory_order_relaxed))
+      return false;
+    task_ = t;
+    state_.store(kFull, std::memory_order_release);
+    return true;
+  }
+  // Owner only.
+  bool take(Task& out) {
+    if (state_.load(std::memory_order_acquire) != kFull) return false;
+    out = task_;
+    state_.store(kEmpty, std::memory_order_release);
+    return true;
+  }
+  bool empty_approx() const { return state_.load(std::memory_order_relaxed) == kEmpty; }
+
+private:
+  enum : uint32_t { kEmpty = 0, kBusy = 1, kFull = 2 };
+  std::atomic<uint32_t> state_{kEmpty};
+  Task task_{};
+};
+
+} // namespace detail
+} // namespace kcoro_cpp
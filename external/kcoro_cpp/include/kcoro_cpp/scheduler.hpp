@@ -2,37 +2,47 @@
 
 #include "kcoro_cpp/core.hpp"
 #include "kcoro_cpp/coroutine.hpp"
+#include "kcoro_cpp/sched_queues.hpp"
 #include <thread>
 #include <mutex>
 #include <condition_variable>
 #include <deque>
 #include <vector>
 #include <atomic>
-#include <unordered_set>
 #include <functional>
-#include <queue>
-#include <unordered_map>
 #include <memory>
+#include <coroutine>
 
 namespace kcoro_cpp {
 
-struct Task {
-  void (*fn)(void*);
-  void* arg;
-#ifdef KCORO_CPP_INTERNAL_CTX_DEBUG
-  uint32_t magic{0xC0A1FACE};
-  uint32_t gen{0};
-#endif
-};
+  // Hosted mode: with a notify hook the scheduler starts no threads. Its
+  // `workers` slots are run by a host runtime's threads through poll(), and
+  // every wake, spawn or timer arm calls notify(ctx) instead of waking a
+  // parked worker (libkcoro: kc_sched_set_guest / kc_sched_guest_notify).
+  struct SchedulerHost {
+    void (*notify)(void* ctx){nullptr};
+    void* ctx{nullptr};
+  };
 
   class WorkStealingScheduler final : public IScheduler {
   public:
-    explicit WorkStealingScheduler(int workers = 0);
+    // bulk_share <= 0 => default 16 (one forced bulk turn per 16 worker turns).
+    explicit WorkStealingScheduler(int workers = 0, int bulk_share = 0, SchedulerHost host = {});
     ~WorkStealingScheduler() override;
 
   void spawn(void (*fn)(void*), void* arg, size_t stack_bytes = 64*1024) override;
-  void spawn_co(Coroutine::Fn fn, void* arg, size_t stack_bytes = 64*1024);
+  void spawn_lane(void (*fn)(void*), void* arg, Lane lane);
+  // Finished coroutines are recycled (see Worker::pool): the returned pointer
+  // is only valid until the coroutine finishes. With `mr` the Coroutine
+  // object is allocated from it and handed back (not pooled) once it has
+  // finished and its grace period has passed; drain() waits for that, so a
+  // request arena can be released after drain(). Stacks still come from
+  // StackPool (they need guard pages).
+  Coroutine* spawn_co(Coroutine::Fn fn, void* arg, size_t stack_bytes = 64*1024, Lane lane = Lane::Interactive,
+                      std::pmr::memory_resource* mr = nullptr);
+    // Lane::Inherit (and the one-argument form) queue on the coroutine's lane.
     void enqueue_ready(ICoroutineContext* co) override;
+    void enqueue_ready(ICoroutineContext* co, Lane lane) override;
     void drain(long timeout_ms) override;
 
     // Helpers: cooperative yield and sleep
@@ -41,107 +51,185 @@ struct Task {
     void sleep_ms(long delay_ms);
     void stop_and_join();
 
+    // Hosted mode: run up to `budget` items as a worker, on the first free
+    // slot from `hint` (mod slots); returns how many ran, 0 when every slot
+    // is busy, the scheduler is not hosted or the caller is already inside
+    // one of its slots. Call from the host thread's own context, not from
+    // inside a coroutine. The host stops polling before stop_and_join.
+    int poll(int hint, int budget);
+    // Hosted mode: CLOCK_MONOTONIC ns by which a poll is due for timers,
+    // 0 when none is armed. Wheels tick in 1 ms, the bound own workers park for.
+    uint64_t next_timer_ns() const;
+    bool hosted() const { return host_.notify != nullptr; }
+
+    // Stackless C++20 coroutines (await.hpp) run as plain tasks: resume_async
+    // queues h.resume() on a worker; `co_await sched.sleep(ms)` resumes it
+    // from a worker timer, and sleep(0) just yields.
+    void resume_async(std::coroutine_handle<> h, Lane lane = Lane::Interactive);
+    struct SleepAwaiter {
+      WorkStealingScheduler* sched; long delay_ms;
+      bool await_ready() const noexcept { return false; }
+      void await_suspend(std::coroutine_handle<> h) const;
+      void await_resume() const noexcept {}
+    };
+    SleepAwaiter sleep(long delay_ms) { return SleepAwaiter{this, delay_ms}; }
+
     struct TimerHandle {
       uint64_t id{0};
       bool valid() const { return id != 0; }
     };
     using TimerCallback = std::function<void()>;
 
-    TimerHandle schedule_timer_at(uint64_t deadline_ns, TimerCallback cb);
-    TimerHandle schedule_timer_after(long delay_ms, TimerCallback cb);
+    // Timers live on per-worker wheels (timer_wheel.hpp): armed on the
+    // calling worker's wheel, or a round-robin one from other threads, and
+    // fired by that worker between tasks. `cb` is stored inline when it fits
+    // (48 bytes) and must not block.
+    template<typename F>
+    TimerHandle schedule_timer_at(uint64_t deadline_ns, F&& cb) {
+      if constexpr (std::is_same_v<std::decay_t<F>, TimerCallback>) { if (!cb) return {}; }
+      if (stop_.load(std::memory_order_relaxed)) return {};
+      TimerHandle h{timer_wheel().add_callback(deadline_ns, std::forward<F>(cb))};
+      if (hosted()) wake_one(); // the host parks by next_timer_ns()
+      return h;
+    }
+    template<typename F>
+    TimerHandle schedule_timer_after(long delay_ms, F&& cb) {
+      return schedule_timer_at(deadline_after(delay_ms), std::forward<F>(cb));
+    }
     bool cancel_timer(TimerHandle handle);
 
+    struct LaneStats {
+      uint64_t submitted[kLaneCount]{};
+      uint64_t run[kLaneCount]{};
+      uint64_t bulk_forced{0}; // bulk items run ahead of waiting interactive work
+    };
+    LaneStats lane_stats() const;
+
+    struct Stats {
+      uint64_t tasks_submitted{0};
+      uint64_t tasks_completed{0};
+      uint64_t ready_enqueued{0};
+      uint64_t ready_local{0};     // wakes queued on the waking worker's ring
+      uint64_t ready_global{0};    // wakes from other threads or ring overflow
+      uint64_t fastpath_hits{0};   // external spawns through a last-task slot
+      uint64_t fastpath_misses{0};
+      uint64_t steals{0};
+      uint64_t steal_probes{0};
+      uint64_t steal_failures{0};
+      uint64_t inject_pulls{0};
+      uint64_t parks{0};
+      uint64_t coroutines_created{0}; // spawn_co that had to allocate
+      uint64_t coroutines_reused{0};  // spawn_co served from a worker pool
+    };
+    Stats stats() const;
+
 private:
-    struct Deque {
-      std::mutex mu; std::deque<Task> q;
-      Deque() = default;
-      Deque(const Deque&) = delete; Deque& operator=(const Deque&) = delete;
+    // Stats counters, one cache-line-aligned block per worker plus one for
+    // non-worker threads; stats()/lane_stats() sum them. A worker is the only
+    // writer of its block, so bumps there are a relaxed load+store.
+    struct alignas(64) Counters {
+      std::atomic<uint64_t> tasks_submitted{0}, ready_enq{0}, ready_local{0}, ready_global{0};
+      std::atomic<uint64_t> fastpath_hits{0}, fastpath_misses{0}, bulk_forced{0}, co_created{0};
+      std::atomic<uint64_t> lane_submitted[kLaneCount]{}, run[kLaneCount]{};
+      std::atomic<uint64_t> completed{0}, steals{0}, steal_probes{0}, steal_failures{0};
+      std::atomic<uint64_t> inject_pulls{0}, parks{0}, co_reused{0};
     };
-    struct ReadyList {
-      std::mutex mu; Coroutine* head{nullptr}; Coroutine* tail{nullptr}; size_t size{0};
+    static void bump(std::atomic<uint64_t>& c, bool owned, uint64_t n = 1) {
+      if (owned) c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+      else c.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    // Per-worker run state. The deque and last-task slot have a single
+    // consumer (the owner, plus thieves on the deque's top end); the ready
+    // ring takes wakes from this worker and is drained by it and by thieves.
+    struct alignas(64) Worker {
+      Worker(uint32_t id, uint64_t now_ns) : timers(id, now_ns) {}
+      detail::TaskDeque dq;
+      detail::TaskSlot last_task;
+      detail::MpmcRing<Coroutine*> ready{256};
+      detail::TimerWheel timers;
+      Counters ctr; // owner-written
+      // Epoch this worker last saw at the top of its loop; 0 while parked
+      alignas(64) std::atomic<uint64_t> epoch{0};
+      // Owner-only: finished coroutines waiting out their grace period
+      // (oldest first), and coroutines ready for reuse
+      Coroutine* retired_head{nullptr};
+      Coroutine* retired_tail{nullptr};
+      Coroutine* pool{nullptr};
+      unsigned pool_n{0};
+      unsigned tick{0};        // loop turns (bulk_share cadence)
+      std::atomic<bool> polling{false}; // hosted: a host thread runs this slot
     };
     std::vector<std::thread> threads_;
-    std::vector<std::unique_ptr<Deque>> deques_;
-    ReadyList ready_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    // Wakes from non-worker threads and full rings; bulk coroutines
+    detail::InjectQueue<Coroutine*> ready_global_{1024}, ready_bulk_{1024};
     std::mutex park_mu_; std::condition_variable park_cv_;
+    std::atomic<int> idle_{0}; // workers in (or entering) park_cv_ wait
     std::atomic<bool> stop_{false};
+    SchedulerHost host_{};
 
-    // Timer thread
-    struct TimerItem {
-      uint64_t id{0};
-      uint64_t when_ns{0};
-      TimerCallback cb;
-      std::atomic<bool> cancelled{false};
-    };
-    struct TimerCompare {
-      bool operator()(const std::shared_ptr<TimerItem>& a,
-                      const std::shared_ptr<TimerItem>& b) const {
-        return a->when_ns > b->when_ns;
-      }
-    };
-    std::thread timer_thread_;
-    std::atomic<bool> timer_started_{false};
-    std::mutex timer_mu_; std::condition_variable timer_cv_;
-    std::priority_queue<std::shared_ptr<TimerItem>,
-                        std::vector<std::shared_ptr<TimerItem>>,
-                        TimerCompare> timer_queue_;
-    std::unordered_map<uint64_t, std::shared_ptr<TimerItem>> timer_map_;
-    std::atomic<uint64_t> next_timer_id_{1};
-
-    // Stats (basic parity)
-    std::atomic<uint64_t> stat_tasks_submitted_{0};
-    std::atomic<uint64_t> stat_ready_enq_{0};
-    std::atomic<uint64_t> stat_steals_{0};
-    std::atomic<uint64_t> stat_fastpath_hits_{0};
-    std::atomic<uint64_t> stat_fastpath_misses_{0};
-    std::atomic<uint64_t> stat_steals_probes_{0};
-    std::atomic<uint64_t> stat_steals_failures_{0};
-    std::atomic<uint64_t> stat_tasks_completed_{0};
-
-    // Inject queue (bounded ring, grows as needed)
-    struct InjectRing {
-      std::mutex mu; std::vector<Task> buf; uint32_t cap{0}, head{0}, tail{0};
-    } inject_;
-
-    // Per-worker last_task fast-path (mutex-protected)
-    std::vector<Task*> last_task_;
-    std::vector<std::unique_ptr<std::mutex>> last_task_mu_;
-
-    // Retire list for finished coroutines (delete outside critical paths)
-    std::mutex retire_mu_;
-    std::vector<Coroutine*> retire_;
-    std::unordered_set<Coroutine*> retire_set_;
+    // Counters bumped from threads that are not workers of this scheduler
+    Counters ext_ctr_;
+    std::atomic<uint64_t> resource_retired_{0}; // finished, resource-backed, not yet freed
+
+    // Shared task queues (lock-free MPMC; spill to a locked deque when full)
+    detail::InjectQueue<Task> inject_{2048}, bulk_{2048};
+    int bulk_share_{16};
+
+    // Reclamation epoch for finished coroutines. A coroutine retired in
+    // epoch e is reused once the epoch reaches e + 2: by then every worker
+    // has started a new loop iteration, so no task that could still hold it
+    // (a timer fire or wake already under way) is running.
+    alignas(64) std::atomic<uint64_t> epoch_{1};
 
+    // The calling thread's counter block; owned is set on a worker
+    Counters& counters(bool& owned);
     void worker_loop(int id);
+    bool run_once(Worker& w, int id); // one loop turn; false when idle
     bool try_steal(int self, Task& out);
-    void timer_loop();
-    void ensure_timer_started();
-    bool inject_push(const Task& t);
-    bool inject_pop(Task& out);
-    void inject_grow_locked(uint32_t new_cap);
-
-    // Retire helpers
-    void retire_maybe(Coroutine* co);
+    bool steal_ready(int self, Coroutine*& out);
+    detail::TimerWheel& timer_wheel();
+    static uint64_t deadline_after(long delay_ms);
+    bool run_bulk(Worker& w);
+    void run_task(Worker& w, const Task& t, Lane lane);
+    void run_ready(Worker& w, Coroutine* co, Lane lane);
+    void wake_one();
+    bool has_work() const;
+    int self_worker() const; // worker index of the calling thread, -1 if none
+
+    // Coroutine recycling
+    void retire(Worker& w, Coroutine* co);
+    void reclaim(Worker& w);
+    bool try_advance_epoch();
+    void free_coroutines();
+    void free_coroutine(Coroutine* co);
     void drain_ready_list();
 
-  // Ready list helpers (intrusive FIFO)
-  void ready_push_tail(Coroutine* co);
-  void ready_push_front(Coroutine* co);
-  Coroutine* ready_pop_head();
-  bool ready_empty();
+    // Ready queue helpers
+    void ready_push(Coroutine* co, Lane lane);
+    bool ready_empty() const;
   };
 
 struct SchedulerOptions {
   int workers{0};
+  int bulk_share{0};
+  SchedulerHost host{}; // notify set => hosted (no threads of its own)
 };
 
 WorkStealingScheduler* sched_init(const SchedulerOptions& opts = {});
 void sched_shutdown(WorkStealingScheduler* sched);
 WorkStealingScheduler* sched_default();
+// Make `sched` what sched_default() (and dispatcher_default()) return, e.g. a
+// hosted scheduler, so nothing starts a second pool. False once a default
+// exists.
+bool sched_set_default(WorkStealingScheduler* sched);
 WorkStealingScheduler* sched_current();
 int sched_spawn(WorkStealingScheduler* sched, void (*fn)(void*), void* arg);
 int sched_spawn_co(WorkStealingScheduler* sched, Coroutine::Fn fn, void* arg,
-                   size_t stack_bytes = 64 * 1024, Coroutine** out_co = nullptr);
+                   size_t stack_bytes = 64 * 1024, Coroutine** out_co = nullptr,
+                   Lane lane = Lane::Interactive);
+int sched_spawn_lane(WorkStealingScheduler* sched, void (*fn)(void*), void* arg, Lane lane);
 void sched_enqueue_ready(WorkStealingScheduler* sched, ICoroutineContext* co);
 void sched_yield();
 void sched_sleep_ms(int ms);
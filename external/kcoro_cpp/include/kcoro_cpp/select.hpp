@@ -3,6 +3,7 @@
 #include "kcoro_cpp/core.hpp"
 #include "kcoro_cpp/coroutine.hpp"
 #include "kcoro_cpp/platform.hpp"
+#include <memory_resource>
 #include <vector>
 #include <variant>
 #include <atomic>
@@ -21,7 +22,9 @@ struct SendClause : public SelectClauseBase {
 
 class Select : public ISelect {
 public:
-  explicit Select(const ICancellationToken* ct=nullptr) : cancel_(ct) {}
+  // `mr` backs the clause list (nullptr: global heap).
+  explicit Select(const ICancellationToken* ct=nullptr, std::pmr::memory_resource* mr=nullptr)
+  : cancel_(ct), clauses_(detail::resource_or_heap(mr)) {}
   void reset() override { clauses_.clear(); state_.store(0); winner_index_ = -1; result_ = KC_EAGAIN; waiter_ = nullptr; }
   void add_clause(SelectClauseBase* c) override { clauses_.push_back(c); }
   int wait(long timeout_ms, int* index_out, int* op_result) override {
@@ -59,7 +62,7 @@ public:
   ICoroutineContext* waiter() override { return waiter_; }
 private:
   const ICancellationToken* cancel_{};
-  std::vector<SelectClauseBase*> clauses_;
+  std::pmr::vector<SelectClauseBase*> clauses_;
   std::atomic<int> state_{0};
   int winner_index_{-1};
   int result_{KC_EAGAIN};
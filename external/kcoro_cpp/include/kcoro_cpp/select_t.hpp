@@ -3,6 +3,7 @@
 #include "kcoro_cpp/select.hpp"
 #include "kcoro_cpp/channel.hpp"
 #include "kcoro_cpp/platform.hpp"
+#include <memory_resource>
 #include <vector>
 
 namespace kcoro_cpp {
@@ -13,8 +14,9 @@ enum class SelectPolicy { FirstWins, Randomized };
 template<typename T>
 class SelectT {
 public:
-  explicit SelectT(const ICancellationToken* ct=nullptr, SelectPolicy policy=SelectPolicy::FirstWins)
-  : sel_(ct), policy_(policy) {}
+  explicit SelectT(const ICancellationToken* ct=nullptr, SelectPolicy policy=SelectPolicy::FirstWins,
+                   std::pmr::memory_resource* mr=nullptr)
+  : sel_(ct, mr), clauses_(detail::resource_or_heap(mr)), policy_(policy) {}
 
   // Add a receive clause: channel and destination reference
   void add_recv(IChannel<T>* ch, T* out) { clauses_.push_back({SelectOp::Recv, ch, out, nullptr}); }
@@ -64,7 +66,7 @@ public:
 private:
   struct Entry { SelectOp kind; IChannel<T>* ch; T* out; const T* val; };
   Select sel_;
-  std::vector<Entry> clauses_;
+  std::pmr::vector<Entry> clauses_;
   SelectPolicy policy_;
 };
 
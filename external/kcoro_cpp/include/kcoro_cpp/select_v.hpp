@@ -0,0 +1,196 @@
+#pragma once
+
+// Variadic select: the clauses are built in place and kept in a std::tuple
+// on the caller's stack, and the winner's handler is reached through a fold
+// over the tuple, so a wait allocates nothing and makes no virtual call of
+// its own.
+//
+//   int rc = select(on_recv(jobs, [&](Job& j){ run(j); }),
+//                   on_send(acks, ack, [&]{ ++sent; }),
+//                   timeout(50, [&]{ idle(); }));
+//
+// Clauses are tried in argument order; the first one that can complete
+// without blocking wins. Otherwise each channel clause parks a registration
+// in its channel (the channels' pooled wait nodes, so nothing is allocated
+// once they have warmed up) and timeout() arms a slab timer on the calling
+// worker. Whichever completes first wins and is the only one that wakes the
+// caller; the rest are withdrawn before select() returns.
+//
+// Returns 0 when a channel clause completed (its handler has run), KC_ETIME
+// when a timeout won (its handler, if any, has run), KC_EPIPE when a clause's
+// channel is closed, or KC_EAGAIN when nothing was ready and the caller is
+// not a coroutine. timeout(0) turns the call into a poll. Channels are taken
+// by their concrete type: channel<> clauses go straight to its non-virtual
+// registration hooks, IChannel<T> ones through the usual overrides.
+
+#include "kcoro_cpp/core.hpp"
+#include "kcoro_cpp/coroutine.hpp"
+#include "kcoro_cpp/scheduler.hpp"
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace kcoro_cpp {
+
+namespace detail {
+
+// The ISelect the channels see. A completer claims the select (kClaimed),
+// records the clause and result and publishes kDone, or kDoneWake when the
+// caller is already parked; only that completer gets waiter() and wakes it.
+class StackSelect final : public ISelect {
+public:
+  void reset() override {}
+  void add_clause(SelectClauseBase*) override {}
+  int wait(long, int*, int*) override { return KC_ENOTSUP; }
+  bool try_complete(int clause_index, int result) override {
+    uint32_t s = state_.load(std::memory_order_acquire);
+    for (;;) {
+      if (s != kOpen && s != kParked) return false;
+      if (state_.compare_exchange_weak(s, kClaimed, std::memory_order_acq_rel, std::memory_order_acquire)) break;
+    }
+    index_ = clause_index; result_ = result; wake_ = (s == kParked);
+    state_.store(wake_ ? kDoneWake : kDone, std::memory_order_release);
+    return true;
+  }
+  ICoroutineContext* waiter() override { return wake_ ? co_ : nullptr; }
+
+  bool done() const { return state_.load(std::memory_order_acquire) >= kDone; }
+  // Park `co` until a completer wakes it; returns at once if one already won.
+  void park(Coroutine* co) {
+    co_ = co;
+    uint32_t s = kOpen;
+    if (state_.compare_exchange_strong(s, kParked, std::memory_order_acq_rel, std::memory_order_acquire)) {
+      while (state_.load(std::memory_order_acquire) != kDoneWake) co->park();
+    }
+    settle();
+  }
+  // Close to completers: nothing won, so the call reports `result`.
+  void withdraw(int result) { try_complete(-1, result); settle(); }
+  int index() const { return index_; }
+  int result() const { return result_; }
+
+private:
+  enum : uint32_t { kOpen = 0, kParked = 1, kClaimed = 2, kDone = 3, kDoneWake = 4 };
+  // A claim is a few stores long; wait it out
+  void settle() const { while (state_.load(std::memory_order_acquire) == kClaimed) std::this_thread::yield(); }
+
+  std::atomic<uint32_t> state_{kOpen};
+  int index_{-1};
+  int result_{KC_EAGAIN};
+  bool wake_{false};
+  Coroutine* co_{nullptr};
+};
+
+template<typename T> T ichannel_value(IChannel<T>*);
+
+template<typename C> struct channel_value { using type = decltype(ichannel_value(static_cast<C*>(nullptr))); };
+template<typename C> requires requires { typename C::value_type; }
+struct channel_value<C> { using type = typename C::value_type; };
+
+struct NoHandler { void operator()() const {} };
+
+// Clause protocol used by select(): arm() registers (a result other than
+// KC_EAGAIN means it completed at once), disarm() withdraws a registration
+// that did not win, fire() runs the handler of the one that did.
+template<typename C, typename F>
+struct RecvCase {
+  using T = typename channel_value<C>::type;
+  C* ch; F fn; T slot{};
+  int arm(StackSelect& s, int idx) { return ch->select_register_recv(&s, idx, &slot); }
+  void disarm(StackSelect& s, int idx) { ch->select_cancel(&s, idx, SelectOp::Recv); }
+  void fire(int rc) { if (rc == 0) fn(slot); }
+};
+
+template<typename C, typename F>
+struct SendCase {
+  using T = typename channel_value<C>::type;
+  C* ch; T val; F fn;
+  int arm(StackSelect& s, int idx) { return ch->select_register_send(&s, idx, &val); }
+  void disarm(StackSelect& s, int idx) { ch->select_cancel(&s, idx, SelectOp::Send); }
+  void fire(int rc) { if (rc == 0) fn(); }
+};
+
+template<typename F>
+struct TimeoutCase {
+  long ms; F fn;
+  WorkStealingScheduler* sched{nullptr};
+  WorkStealingScheduler::TimerHandle timer{};
+  StackSelect* sel{nullptr};
+  int idx{-1};
+  std::atomic<bool> fired{false}; // the timer callback is done with this clause
+
+  TimeoutCase(long m, F f) : ms(m), fn(std::move(f)) {}
+  // Moved only before arming, into select()'s tuple
+  TimeoutCase(TimeoutCase&& o) : ms(o.ms), fn(std::move(o.fn)) {}
+
+  int arm(StackSelect& s, int i) {
+    if (ms == 0) return KC_ETIME;
+    if (ms < 0 || !(sched = sched_current())) return KC_EAGAIN;
+    sel = &s; idx = i;
+    timer = sched->schedule_timer_after(ms, [this] {
+      if (sel->try_complete(idx, KC_ETIME)) if (auto* w = sel->waiter()) sched->enqueue_ready(w);
+      fired.store(true, std::memory_order_release);
+    });
+    return KC_EAGAIN;
+  }
+  void disarm(StackSelect&, int) {
+    // A timer that could not be cancelled is firing: the clause must outlive it
+    if (timer.valid() && !sched->cancel_timer(timer))
+      while (!fired.load(std::memory_order_acquire)) std::this_thread::yield();
+  }
+  void fire(int rc) { if (rc == KC_ETIME) fn(); }
+};
+
+template<typename... Cs, std::size_t... I>
+int run_select(std::tuple<Cs...>& cs, std::index_sequence<I...>) {
+  StackSelect sel;
+  int armed = 0;
+  // Register in order until one completes (or another clause already has);
+  // a result the channel did not report through try_complete is claimed here
+  auto arm_one = [&](auto& c, int idx) {
+    if (sel.done()) return false;
+    armed = idx + 1;
+    int rc = c.arm(sel, idx);
+    if (rc == KC_EAGAIN) return true;
+    sel.try_complete(idx, rc);
+    return false;
+  };
+  (void)(arm_one(std::get<I>(cs), (int)I) && ...);
+  if (!sel.done()) {
+    if (Coroutine* cur = Coroutine::current()) sel.park(cur);
+    else sel.withdraw(KC_EAGAIN);
+  }
+  // The winner's registration is already gone; disarming it is a no-op
+  (void)(((int)I < armed ? (std::get<I>(cs).disarm(sel, (int)I), 0) : 0), ...);
+  const int win = sel.index(), rc = sel.result();
+  (void)((win == (int)I ? (std::get<I>(cs).fire(rc), 0) : 0), ...);
+  return rc;
+}
+
+} // namespace detail
+
+// Receive into the clause's own slot, then call fn(T&) with it.
+template<typename C, typename F>
+auto on_recv(C& ch, F fn) { return detail::RecvCase<C, F>{&ch, std::move(fn)}; }
+
+// Send a copy of `val` held by the clause, then call fn().
+template<typename C, typename V, typename F = detail::NoHandler>
+auto on_send(C& ch, V&& val, F fn = {}) {
+  return detail::SendCase<C, F>{&ch, typename detail::channel_value<C>::type(std::forward<V>(val)), std::move(fn)};
+}
+
+// Win after `ms` milliseconds (0: poll, negative: never), then call fn().
+template<typename F = detail::NoHandler>
+auto timeout(long ms, F fn = {}) { return detail::TimeoutCase<F>(ms, std::move(fn)); }
+
+template<typename... Cs>
+int select(Cs&&... clauses) {
+  static_assert(sizeof...(Cs) > 0, "select needs at least one clause");
+  std::tuple<std::remove_cvref_t<Cs>...> cs{std::forward<Cs>(clauses)...};
+  return detail::run_select(cs, std::index_sequence_for<Cs...>{});
+}
+
+} // namespace kcoro_cpp
@@ -0,0 +1,508 @@
+#pragma once
+
+// Compile-time channel types. channel<T, Kind, Capacity> carries its kind and
+// capacity in the type: the ring is inline slot storage sized to the next
+// power of two, the index mask is a constant, and the class is final with no
+// virtual members, so send/recv in a tight loop inline down to lock, ring
+// store/load and unlock.
+//
+// T only has to be movable. Slots hold live elements only: send(T&&) and
+// emplace construct in place, recv moves out and destroys the slot, and
+// trivially copyable types go through memcpy. Copying overloads (and select
+// send clauses, which copy from SelectT's value) need a copyable T. Code written against IChannel<T> (SelectT, helpers taking an
+// IChannel<T>*) wraps one in ChannelAdapter, which restores the virtual
+// interface for that use only.
+//
+// Semantics follow the IChannel implementations: 0 or a negative KC_* code,
+// parking only inside a coroutine, parked waiters woken by the peer or close
+// and then re-checking cancel and deadline.
+
+#include "kcoro_cpp/core.hpp"
+#include "kcoro_cpp/coroutine.hpp"
+#include "kcoro_cpp/scheduler.hpp"
+#include "kcoro_cpp/channel.hpp"
+#include "kcoro_cpp/platform.hpp"
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+
+namespace kcoro_cpp {
+
+enum class ChannelKind { Rendezvous, Buffered };
+
+template<typename T>
+concept ChannelValue = std::movable<T>;
+
+// Rendezvous channels hold nothing; buffered ones at least one element.
+template<ChannelKind Kind, std::size_t Capacity>
+concept ChannelShape = (Kind == ChannelKind::Rendezvous && Capacity == 0) ||
+                       (Kind == ChannelKind::Buffered && Capacity > 0);
+
+template<ChannelValue T, ChannelKind Kind, std::size_t Capacity = 0>
+  requires ChannelShape<Kind, Capacity>
+class channel;
+
+// What ChannelAdapter forwards; every channel<> of a copyable T satisfies it.
+template<typename C>
+concept StaticChannel = requires(C& c, typename C::value_type& v, const typename C::value_type& cv,
+                                 long tmo, const ICancellationToken* tok, ISelect* sel, int idx) {
+  { c.send(cv, tmo) } -> std::same_as<int>;
+  { c.recv(v, tmo) } -> std::same_as<int>;
+  { c.send_c(cv, tmo, tok) } -> std::same_as<int>;
+  { c.recv_c(v, tmo, tok) } -> std::same_as<int>;
+  c.close();
+  { c.size() } -> std::convertible_to<std::size_t>;
+  { c.select_register_recv(sel, idx, &v) } -> std::same_as<int>;
+  { c.select_register_send(sel, idx, &cv) } -> std::same_as<int>;
+  c.select_cancel(sel, idx, SelectOp::Recv);
+};
+
+namespace detail {
+  inline uint64_t chan_deadline(long timeout_ms) {
+    return timeout_ms < 0 ? (uint64_t)(-1) : platform::now_ns() + (uint64_t)timeout_ms * 1000000ULL;
+  }
+  // Failure counters shared by the static channels (guarded by their mu_).
+  struct ChanFailures {
+    unsigned long eagain{}, etime{}, ecanceled{}, epipe{};
+    // Whether a blocked op may (re)park: 0, or the error ending it.
+    int park_checks(long timeout_ms, uint64_t deadline, const ICancellationToken* cancel) {
+      if (timeout_ms == 0) { ++eagain; return KC_EAGAIN; }
+      if (cancel && cancel->is_set()) { ++ecanceled; return KC_ECANCELED; }
+      if (timeout_ms > 0 && platform::now_ns() >= deadline) { ++etime; return KC_ETIME; }
+      return 0;
+    }
+    void fill(ChannelSnapshot& s) const { s.total_eagain = eagain; s.total_etime = etime; s.total_ecanceled = ecanceled; s.total_epipe = epipe; }
+  };
+  // Copy or move v into dst; trivially copyable types are a fixed-size memcpy.
+  template<typename T, typename V>
+  void chan_assign(T& dst, V&& v) {
+    if constexpr (std::is_trivially_copyable_v<T>) std::memcpy(static_cast<void*>(std::addressof(dst)), std::addressof(v), sizeof(T));
+    else dst = std::forward<V>(v);
+  }
+}
+
+// Bounded ring. head_/tail_ count every pop/push since creation, so they are
+// also the snapshot's op counters and the ring index is a constant mask.
+template<ChannelValue T, std::size_t Capacity>
+class channel<T, ChannelKind::Buffered, Capacity> final {
+public:
+  using value_type = T;
+  static constexpr ChannelKind kind = ChannelKind::Buffered;
+  static constexpr std::size_t capacity = Capacity;
+  static constexpr std::size_t slots = std::bit_ceil(Capacity);
+  static constexpr std::size_t mask = slots - 1;
+
+  // `mr` backs select wait nodes, the only allocation (nullptr: global heap).
+  explicit channel(WorkStealingScheduler* sched, std::pmr::memory_resource* mr = nullptr)
+  : sched_(sched), sel_recv_pool_(mr), sel_send_pool_(mr) {}
+  ~channel() {
+    while (auto* n = sel_recv_.pop_front()) sel_recv_pool_.put(n);
+    while (auto* n = sel_send_.pop_front()) sel_send_pool_.put(n);
+    if constexpr (!std::is_trivially_destructible_v<T>) for (; head_ != tail_; ++head_) elem(head_)->~T();
+  }
+  channel(const channel&) = delete;
+  channel& operator=(const channel&) = delete;
+
+  int send(const T& val, long timeout_ms = -1) requires std::copyable<T> { return send_c(val, timeout_ms, nullptr); }
+  int send(T&& val, long timeout_ms = -1) { return send_c(std::move(val), timeout_ms, nullptr); }
+  int recv(T& out, long timeout_ms = -1) { return recv_c(out, timeout_ms, nullptr); }
+  // Construct the element in its slot, waiting while the ring is full.
+  template<typename... Args> requires std::constructible_from<T, Args...>
+  int emplace(Args&&... args) {
+    std::unique_lock<std::mutex> lk(mu_);
+    if (!closed_ && tail_ - head_ < Capacity) [[likely]] { push_locked(std::forward<Args>(args)...); after_push(lk); return 0; }
+    return send_wait(lk, -1, nullptr, std::forward<Args>(args)...);
+  }
+
+  // A failed send leaves val untouched, moved-from only on success.
+  int send_c(const T& val, long timeout_ms, const ICancellationToken* cancel) requires std::copyable<T> {
+    std::unique_lock<std::mutex> lk(mu_);
+    if (!closed_ && tail_ - head_ < Capacity) [[likely]] { push_locked(val); after_push(lk); return 0; }
+    return send_wait(lk, timeout_ms, cancel, val);
+  }
+  int send_c(T&& val, long timeout_ms, const ICancellationToken* cancel) {
+    std::unique_lock<std::mutex> lk(mu_);
+    if (!closed_ && tail_ - head_ < Capacity) [[likely]] { push_locked(std::move(val)); after_push(lk); return 0; }
+    return send_wait(lk, timeout_ms, cancel, std::move(val));
+  }
+  int recv_c(T& out, long timeout_ms, const ICancellationToken* cancel) {
+    std::unique_lock<std::mutex> lk(mu_);
+    if (tail_ != head_) [[likely]] { pop_locked(out); after_pop(lk); return 0; }
+    return recv_wait(lk, out, timeout_ms, cancel);
+  }
+
+  void close() {
+    std::lock_guard<std::mutex> lk(mu_);
+    closed_ = true;
+    while (auto* w = recv_waiters_.pop_front()) sched_->enqueue_ready(w->co, lane_);
+    while (auto* w = send_waiters_.pop_front()) sched_->enqueue_ready(w->co, lane_);
+    while (auto* n = sel_send_.pop_front()) { complete(n->sel, n->idx, KC_EPIPE); sel_send_pool_.put(n); }
+    while (auto* n = sel_recv_.pop_front()) { complete(n->sel, n->idx, KC_EPIPE); sel_recv_pool_.put(n); }
+  }
+
+  std::size_t size() const { std::lock_guard<std::mutex> lk(mu_); return tail_ - head_; }
+  ChannelSnapshot snapshot() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    ChannelSnapshot s{};
+    s.total_sends = tail_; s.total_recvs = head_;
+    s.total_bytes_sent = bytes_sent_; s.total_bytes_recv = bytes_recv_;
+    fails_.fill(s);
+    s.first_op_time_ns = first_op_ns_;
+    if (tail_) s.last_op_time_ns = platform::now_ns();
+    return s;
+  }
+  // Lane for coroutines this channel wakes; set before the channel is shared.
+  void set_wake_lane(Lane lane) { lane_ = lane; }
+  Lane wake_lane() const { return lane_; }
+
+  int select_register_recv(ISelect* sel, int clause_index, T* out) {
+    std::unique_lock<std::mutex> lk(mu_);
+    if (tail_ != head_) {
+      pop_locked(*out);
+      complete(sel, clause_index, 0);
+      after_pop(lk);
+      return 0;
+    }
+    if (closed_) return KC_EPIPE;
+    SelRecv* n = sel_recv_pool_.get(); n->sel = sel; n->idx = clause_index; n->out = out;
+    sel_recv_.push_back(n);
+    return KC_EAGAIN;
+  }
+  // A parked clause keeps pointing at SelectT's value and copies it on match.
+  int select_register_send(ISelect* sel, int clause_index, const T* val) requires std::copyable<T> {
+    std::unique_lock<std::mutex> lk(mu_);
+    if (closed_) return KC_EPIPE;
+    if (tail_ - head_ < Capacity) {
+      push_locked(*val);
+      complete(sel, clause_index, 0);
+      after_push(lk);
+      return 0;
+    }
+    SelSend* n = sel_send_pool_.get(); n->sel = sel; n->idx = clause_index; n->val = val;
+    sel_send_.push_back(n);
+    return KC_EAGAIN;
+  }
+  void select_cancel(ISelect* sel, int clause_index, SelectOp kind) {
+    std::lock_guard<std::mutex> lk(mu_);
+    auto drop = [&](auto& q, auto& pool) { if (auto* n = q.find([&](auto* w){ return w->sel == sel && w->idx == clause_index; })) { q.erase(n); pool.put(n); } };
+    if (kind == SelectOp::Recv) drop(sel_recv_, sel_recv_pool_); else drop(sel_send_, sel_send_pool_);
+  }
+
+private:
+  void* raw(std::size_t i) { return storage_ + (i & mask) * sizeof(T); }
+  T* elem(std::size_t i) { return std::launder(static_cast<T*>(raw(i))); }
+  template<typename... Args>
+  void push_locked(Args&&... args) {
+    if (tail_ == 0) first_op_ns_ = (long long)platform::now_ns();
+    if constexpr (std::is_trivially_copyable_v<T> && sizeof...(Args) == 1 && (std::is_same_v<std::remove_cvref_t<Args>, T> && ...))
+      std::memcpy(raw(tail_), std::addressof(args...), sizeof(T));
+    else
+      ::new (raw(tail_)) T(std::forward<Args>(args)...);
+    bytes_sent_ += size_bytes_default(*elem(tail_));
+    ++tail_;
+  }
+  void pop_locked(T& out) {
+    T* p = elem(head_); ++head_;
+    if constexpr (std::is_trivially_copyable_v<T>) std::memcpy(static_cast<void*>(std::addressof(out)), p, sizeof(T));
+    else { out = std::move(*p); p->~T(); }
+    bytes_recv_ += size_bytes_default(out);
+  }
+  void complete(ISelect* s, int idx, int rc) {
+    if (s->try_complete(idx, rc)) if (auto* w = s->waiter()) sched_->enqueue_ready(static_cast<Coroutine*>(w), lane_);
+  }
+  // After a push (releases lk): a select receiver takes the element, else one
+  // parked receiver is woken.
+  void after_push(std::unique_lock<std::mutex>& lk) {
+    Coroutine* co = nullptr;
+    if (!sel_recv_.empty()) [[unlikely]] {
+      SelRecv* n = sel_recv_.pop_front();
+      pop_locked(*n->out); complete(n->sel, n->idx, 0); sel_recv_pool_.put(n);
+    } else if (!recv_waiters_.empty()) [[unlikely]] { co = recv_waiters_.pop_front()->co; }
+    lk.unlock();
+    if (co) sched_->enqueue_ready(co, lane_);
+  }
+  // After a pop (releases lk): a select sender fills the room, else one
+  // parked sender is woken.
+  void after_pop(std::unique_lock<std::mutex>& lk) {
+    Coroutine* co = nullptr;
+    if (!sel_send_.empty()) [[unlikely]] {
+      SelSend* n = sel_send_.pop_front();
+      // Only a copyable T can have registered one
+      if constexpr (std::copyable<T>) push_locked(*n->val);
+      complete(n->sel, n->idx, 0); sel_send_pool_.put(n);
+    } else if (!send_waiters_.empty()) [[unlikely]] { co = send_waiters_.pop_front()->co; }
+    lk.unlock();
+    if (co) sched_->enqueue_ready(co, lane_);
+  }
+  // args are forwarded once, when room appears.
+  template<typename... Args>
+  int send_wait(std::unique_lock<std::mutex>& lk, long timeout_ms, const ICancellationToken* cancel, Args&&... args) {
+    const uint64_t deadline = detail::chan_deadline(timeout_ms);
+    detail::CoWait w{};
+    for (;;) {
+      if (closed_) { ++fails_.epipe; return KC_EPIPE; }
+      if (tail_ - head_ < Capacity) { push_locked(std::forward<Args>(args)...); after_push(lk); return 0; }
+      if (int rc = fails_.park_checks(timeout_ms, deadline, cancel)) return rc;
+      auto* cur = Coroutine::current(); if (!cur) { ++fails_.eagain; return KC_EAGAIN; }
+      w.co = cur; send_waiters_.push_back(&w);
+      lk.unlock(); cur->park(); lk.lock();
+      if (w.linked) send_waiters_.erase(&w);
+    }
+  }
+  int recv_wait(std::unique_lock<std::mutex>& lk, T& out, long timeout_ms, const ICancellationToken* cancel) {
+    const uint64_t deadline = detail::chan_deadline(timeout_ms);
+    detail::CoWait w{};
+    for (;;) {
+      if (tail_ != head_) { pop_locked(out); after_pop(lk); return 0; }
+      if (closed_) { ++fails_.epipe; return KC_EPIPE; }
+      if (int rc = fails_.park_checks(timeout_ms, deadline, cancel)) return rc;
+      auto* cur = Coroutine::current(); if (!cur) { ++fails_.eagain; return KC_EAGAIN; }
+      w.co = cur; recv_waiters_.push_back(&w);
+      lk.unlock(); cur->park(); lk.lock();
+      if (w.linked) recv_waiters_.erase(&w);
+    }
+  }
+
+  WorkStealingScheduler* sched_{};
+  Lane lane_{Lane::Inherit};
+  mutable std::mutex mu_;
+  bool closed_{false};
+  std::size_t head_{0}, tail_{0};
+  alignas(T) std::byte storage_[slots * sizeof(T)];
+  unsigned long bytes_sent_{0}, bytes_recv_{0};
+  long long first_op_ns_{0};
+  detail::ChanFailures fails_{};
+  struct SelRecv { ISelect* sel{}; int idx{-1}; T* out{}; SelRecv* next{}; SelRecv* prev{}; bool linked{false}; };
+  struct SelSend { ISelect* sel{}; int idx{-1}; const T* val{}; SelSend* next{}; SelSend* prev{}; bool linked{false}; };
+  detail::WaitList<detail::CoWait> recv_waiters_;
+  detail::WaitList<detail::CoWait> send_waiters_;
+  detail::WaitList<SelRecv> sel_recv_;
+  detail::WaitList<SelSend> sel_send_;
+  detail::NodePool<SelRecv> sel_recv_pool_;
+  detail::NodePool<SelSend> sel_send_pool_;
+};
+
+// Unbuffered hand-off. A parked side queues a wait record pointing at its
+// slot (or value) and result; the peer that matches it fills both before
+// waking it, so a woken waiter knows whether it was matched or the channel
+// closed. A parked rvalue sender's value is moved straight into the
+// receiver's slot; nothing is staged in between.
+template<ChannelValue T>
+class channel<T, ChannelKind::Rendezvous, 0> final {
+public:
+  using value_type = T;
+  static constexpr ChannelKind kind = ChannelKind::Rendezvous;
+  static constexpr std::size_t capacity = 0;
+
+  explicit channel(WorkStealingScheduler* sched, std::pmr::memory_resource* mr = nullptr)
+  : sched_(sched), recv_pool_(mr), send_pool_(mr) {}
+  ~channel() {
+    while (auto* n = recv_waiters_.pop_front()) if (n->sel) recv_pool_.put(n);
+    while (auto* n = send_waiters_.pop_front()) if (n->sel) send_pool_.put(n);
+  }
+  channel(const channel&) = delete;
+  channel& operator=(const channel&) = delete;
+
+  int send(const T& val, long timeout_ms = -1) requires std::copyable<T> { return send_c(val, timeout_ms, nullptr); }
+  int send(T&& val, long timeout_ms = -1) { return send_c(std::move(val), timeout_ms, nullptr); }
+  int recv(T& out, long timeout_ms = -1) { return recv_c(out, timeout_ms, nullptr); }
+  // There is no slot to build into: the value is constructed on this
+  // coroutine's stack and moved once into the receiver.
+  template<typename... Args> requires std::constructible_from<T, Args...>
+  int emplace(Args&&... args) { T v(std::forward<Args>(args)...); return send_c(std::move(v), -1, nullptr); }
+
+  int send_c(const T& val, long timeout_ms, const ICancellationToken* cancel) requires std::copyable<T> { return send_impl(val, timeout_ms, cancel); }
+  int send_c(T&& val, long timeout_ms, const ICancellationToken* cancel) { return send_impl(std::move(val), timeout_ms, cancel); }
+  int recv_c(T& out, long timeout_ms, const ICancellationToken* cancel) {
+    std::unique_lock<std::mutex> lk(mu_);
+    if (!send_waiters_.empty()) {
+      SendWait sw = take(send_waiters_, send_pool_);
+      deliver(out, sw); matched(size_bytes_default(out));
+      return hand_off(lk, sw.co, sw.sel, sw.idx, sw.rc);
+    }
+    if (closed_) { ++fails_.epipe; return KC_EPIPE; }
+    const uint64_t deadline = detail::chan_deadline(timeout_ms);
+    if (int rc = fails_.park_checks(timeout_ms, deadline, cancel)) return rc;
+    auto* cur = Coroutine::current(); if (!cur) { ++fails_.eagain; return KC_EAGAIN; }
+    int rc = kPending;
+    RecvWait w{cur, nullptr, -1, &out, &rc};
+    recv_waiters_.push_back(&w);
+    return park_until_matched(lk, cur, rc, recv_waiters_, &w, timeout_ms, deadline, cancel);
+  }
+
+  void close() {
+    std::lock_guard<std::mutex> lk(mu_);
+    closed_ = true;
+    while (!recv_waiters_.empty()) { RecvWait w = take(recv_waiters_, recv_pool_); finish(w.co, w.sel, w.idx, w.rc, KC_EPIPE); }
+    while (!send_waiters_.empty()) { SendWait w = take(send_waiters_, send_pool_); finish(w.co, w.sel, w.idx, w.rc, KC_EPIPE); }
+  }
+
+  std::size_t size() const { return 0; }
+  ChannelSnapshot snapshot() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    ChannelSnapshot s{};
+    s.total_sends = s.total_recvs = matches_;
+    s.total_bytes_sent = s.total_bytes_recv = bytes_;
+    fails_.fill(s);
+    s.first_op_time_ns = first_op_ns_;
+    if (matches_) s.last_op_time_ns = platform::now_ns();
+    return s;
+  }
+  void set_wake_lane(Lane lane) { lane_ = lane; }
+  Lane wake_lane() const { return lane_; }
+
+  int select_register_recv(ISelect* sel, int clause_index, T* out) {
+    std::unique_lock<std::mutex> lk(mu_);
+    if (!send_waiters_.empty()) {
+      SendWait sw = take(send_waiters_, send_pool_);
+      deliver(*out, sw); matched(size_bytes_default(*out));
+      finish(nullptr, sel, clause_index, nullptr, 0);
+      return hand_off(lk, sw.co, sw.sel, sw.idx, sw.rc);
+    }
+    if (closed_) return KC_EPIPE;
+    RecvWait* n = recv_pool_.get(); *n = RecvWait{nullptr, sel, clause_index, out, nullptr};
+    recv_waiters_.push_back(n);
+    return KC_EAGAIN;
+  }
+  int select_register_send(ISelect* sel, int clause_index, const T* val) requires std::copyable<T> {
+    std::unique_lock<std::mutex> lk(mu_);
+    if (closed_) return KC_EPIPE;
+    if (!recv_waiters_.empty()) {
+      RecvWait rw = take(recv_waiters_, recv_pool_);
+      detail::chan_assign(*rw.slot, *val); matched(size_bytes_default(*val));
+      finish(nullptr, sel, clause_index, nullptr, 0);
+      return hand_off(lk, rw.co, rw.sel, rw.idx, rw.rc);
+    }
+    SendWait* n = send_pool_.get(); *n = SendWait{nullptr, sel, clause_index, val, false, nullptr};
+    send_waiters_.push_back(n);
+    return KC_EAGAIN;
+  }
+  void select_cancel(ISelect* sel, int clause_index, SelectOp kind) {
+    std::lock_guard<std::mutex> lk(mu_);
+    auto drop = [&](auto& q, auto& pool) { if (auto* n = q.find([&](auto* w){ return w->sel == sel && w->idx == clause_index; })) { q.erase(n); pool.put(n); } };
+    if (kind == SelectOp::Recv) drop(recv_waiters_, recv_pool_); else drop(send_waiters_, send_pool_);
+  }
+
+private:
+  static constexpr int kPending = 1;
+  // A parked coroutine's record lives on its stack, a select clause's in a pool.
+  struct RecvWait { Coroutine* co{}; ISelect* sel{}; int idx{-1}; T* slot{}; int* rc{}; RecvWait* next{}; RecvWait* prev{}; bool linked{false}; };
+  // src is the sender's value; move says whether it may be moved from.
+  struct SendWait { Coroutine* co{}; ISelect* sel{}; int idx{-1}; const T* src{}; bool move{false}; int* rc{}; SendWait* next{}; SendWait* prev{}; bool linked{false}; };
+
+  template<typename V>
+  int send_impl(V&& val, long timeout_ms, const ICancellationToken* cancel) {
+    std::unique_lock<std::mutex> lk(mu_);
+    if (closed_) { ++fails_.epipe; return KC_EPIPE; }
+    if (!recv_waiters_.empty()) {
+      RecvWait rw = take(recv_waiters_, recv_pool_);
+      detail::chan_assign(*rw.slot, std::forward<V>(val)); matched(size_bytes_default(*rw.slot));
+      return hand_off(lk, rw.co, rw.sel, rw.idx, rw.rc);
+    }
+    const uint64_t deadline = detail::chan_deadline(timeout_ms);
+    if (int rc = fails_.park_checks(timeout_ms, deadline, cancel)) return rc;
+    auto* cur = Coroutine::current(); if (!cur) { ++fails_.eagain; return KC_EAGAIN; }
+    int rc = kPending;
+    SendWait w{cur, nullptr, -1, std::addressof(val), !std::is_lvalue_reference_v<V>, &rc};
+    send_waiters_.push_back(&w);
+    return park_until_matched(lk, cur, rc, send_waiters_, &w, timeout_ms, deadline, cancel);
+  }
+  // Take a matched sender's value (mu_ held).
+  static void deliver(T& dst, const SendWait& sw) {
+    if (sw.move) detail::chan_assign(dst, std::move(*const_cast<T*>(sw.src)));
+    else if constexpr (std::copyable<T>) detail::chan_assign(dst, *sw.src);
+  }
+
+  // Unlink the oldest record and return a copy; select records are recycled.
+  template<typename W>
+  static W take(detail::WaitList<W>& q, detail::NodePool<W>& pool) {
+    W* n = q.pop_front(); W w = *n;
+    if (w.sel) pool.put(n);
+    return w;
+  }
+
+  void matched(std::size_t bytes) {
+    if (matches_ == 0) first_op_ns_ = (long long)platform::now_ns();
+    ++matches_; bytes_ += bytes;
+  }
+  // Complete a wait record (mu_ held): a parked coroutine gets rc, a select
+  // the clause result.
+  void finish(Coroutine* co, ISelect* sel, int idx, int* rcp, int rc) {
+    if (sel) { if (sel->try_complete(idx, rc)) if (auto* w = sel->waiter()) sched_->enqueue_ready(static_cast<Coroutine*>(w), lane_); return; }
+    *rcp = rc;
+    sched_->enqueue_ready(co, lane_);
+  }
+  int hand_off(std::unique_lock<std::mutex>& lk, Coroutine* co, ISelect* sel, int idx, int* rcp) {
+    if (sel) { finish(nullptr, sel, idx, nullptr, 0); return 0; }
+    *rcp = 0;
+    lk.unlock();
+    sched_->enqueue_ready(co, lane_);
+    return 0;
+  }
+  // Park until a peer or close fills rc; a wake that did neither re-checks
+  // cancel and deadline and withdraws the record if the wait is over.
+  template<typename W>
+  int park_until_matched(std::unique_lock<std::mutex>& lk, Coroutine* cur, int& rc, detail::WaitList<W>& q, W* self,
+                         long timeout_ms, uint64_t deadline, const ICancellationToken* cancel) {
+    for (;;) {
+      lk.unlock(); cur->park(); lk.lock();
+      if (rc != kPending) break;
+      if (int e = fails_.park_checks(timeout_ms, deadline, cancel)) {
+        if (self->linked) q.erase(self);
+        return e;
+      }
+    }
+    if (rc == KC_EPIPE) ++fails_.epipe;
+    return rc;
+  }
+
+  WorkStealingScheduler* sched_{};
+  Lane lane_{Lane::Inherit};
+  mutable std::mutex mu_;
+  bool closed_{false};
+  unsigned long matches_{0}, bytes_{0};
+  long long first_op_ns_{0};
+  detail::ChanFailures fails_{};
+  detail::WaitList<RecvWait> recv_waiters_;
+  detail::WaitList<SendWait> send_waiters_;
+  detail::NodePool<RecvWait> recv_pool_;
+  detail::NodePool<SendWait> send_pool_;
+};
+
+template<ChannelValue T, std::size_t Capacity>
+using buffered_channel = channel<T, ChannelKind::Buffered, Capacity>;
+template<ChannelValue T>
+using rendezvous_channel = channel<T, ChannelKind::Rendezvous>;
+
+// IChannel<T> over a static channel (not owned), for code that erases the
+// channel type. Only calls made through the adapter pay for dispatch. The
+// wake lane is the channel's: IChannel::set_wake_lane on the adapter has no
+// effect.
+template<StaticChannel C>
+class ChannelAdapter final : public IChannel<typename C::value_type> {
+  using T = typename C::value_type;
+public:
+  explicit ChannelAdapter(C& ch) : ch_(ch) {}
+  int send(const T& val, long timeout_ms) override { return ch_.send(val, timeout_ms); }
+  int recv(T& out, long timeout_ms) override { return ch_.recv(out, timeout_ms); }
+  int send_c(const T& val, long timeout_ms, const ICancellationToken* cancel) override { return ch_.send_c(val, timeout_ms, cancel); }
+  int send(T&& val, long timeout_ms) override { return ch_.send(std::move(val), timeout_ms); }
+  int send_c(T&& val, long timeout_ms, const ICancellationToken* cancel) override { return ch_.send_c(std::move(val), timeout_ms, cancel); }
+  int recv_c(T& out, long timeout_ms, const ICancellationToken* cancel) override { return ch_.recv_c(out, timeout_ms, cancel); }
+  void close() override { ch_.close(); }
+  std::size_t size() const override { return ch_.size(); }
+  int select_register_recv(ISelect* sel, int clause_index, T* out) override { return ch_.select_register_recv(sel, clause_index, out); }
+  int select_register_send(ISelect* sel, int clause_index, const T* val) override { return ch_.select_register_send(sel, clause_index, val); }
+  void select_cancel(ISelect* sel, int clause_index, SelectOp kind) override { ch_.select_cancel(sel, clause_index, kind); }
+  C& get() { return ch_; }
+private:
+  C& ch_;
+};
+
+} // namespace kcoro_cpp
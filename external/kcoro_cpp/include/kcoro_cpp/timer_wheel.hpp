@@ -0,0 +1,167 @@
+#pragma once
+
+// Hashed hierarchical timing wheel (Varghese & Lauck), one per scheduler
+// worker; same geometry as the C scheduler's (kcoro/core/src/kc_timer.c).
+//
+// - 1 ms ticks, kLevels levels of kSlots slots (64^4 ms ~ 4.6 h of direct
+//   range; longer deadlines park in the last level and cascade).
+// - Timers are intrusive TimerNodes, so arming never allocates: a Coroutine
+//   embeds the node wake_after uses, and callback timers come from a
+//   per-wheel slab of entries with inline callable storage.
+// - The mutex is normally uncontended: the owning worker arms and fires,
+//   other threads only take it to cancel or to arm from a foreign thread.
+// - Callbacks run on the owning worker after the lock is dropped.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace kcoro_cpp {
+namespace detail {
+
+class TimerWheel;
+
+// Move-free callable with inline storage; larger callables go to the heap.
+template<size_t Cap = 48>
+class InlineCallback {
+public:
+  InlineCallback() = default;
+  InlineCallback(const InlineCallback&) = delete;
+  InlineCallback& operator=(const InlineCallback&) = delete;
+  ~InlineCallback() { reset(); }
+
+  template<typename F>
+  void emplace(F&& f) {
+    using D = std::decay_t<F>;
+    reset();
+    if constexpr (sizeof(D) <= Cap && alignof(D) <= alignof(std::max_align_t)) {
+      ::new (static_cast<void*>(buf_)) D(std::forward<F>(f));
+      invoke_ = [](void* p) { (*static_cast<D*>(p))(); };
+      destroy_ = [](void* p) { static_cast<D*>(p)->~D(); };
+    } else {
+      D* h = new D(std::forward<F>(f));
+      std::memcpy(buf_, &h, sizeof(h));
+      invoke_ = [](void* p) { D* d; std::memcpy(&d, p, sizeof(d)); (*d)(); };
+      destroy_ = [](void* p) { D* d; std::memcpy(&d, p, sizeof(d)); delete d; };
+    }
+  }
+  void operator()() { invoke_(buf_); }
+  void reset() { if (destroy_) destroy_(buf_); invoke_ = nullptr; destroy_ = nullptr; }
+  explicit operator bool() const { return invoke_ != nullptr; }
+
+private:
+  alignas(std::max_align_t) unsigned char buf_[Cap];
+  void (*invoke_)(void*) = nullptr;
+  void (*destroy_)(void*) = nullptr;
+};
+
+// Intrusive timer. `fire(ctx)` runs on the wheel's worker once due; the pair
+// is copied out under the wheel lock, so the node may be re-armed or
+// destroyed as soon as it has fired.
+struct TimerNode {
+  void (*fire)(void* ctx){nullptr};
+  void* ctx{nullptr};
+
+  TimerNode() = default;
+  TimerNode(const TimerNode&) = delete;
+  TimerNode& operator=(const TimerNode&) = delete;
+  ~TimerNode();
+  bool armed() const { return wheel.load(std::memory_order_acquire) != nullptr; }
+  void disarm(); // withdraw from whichever wheel holds it, if any
+
+private:
+  friend class TimerWheel;
+  uint64_t expires{0}; // absolute tick
+  TimerNode* next{nullptr};
+  TimerNode* prev{nullptr};
+  uint8_t level{0}, slot{0};
+  std::atomic<TimerWheel*> wheel{nullptr}; // wheel holding it; null when idle
+};
+
+class TimerWheel {
+public:
+  static constexpr unsigned kBits = 6;
+  static constexpr unsigned kSlots = 1u << kBits;
+  static constexpr unsigned kMask = kSlots - 1;
+  static constexpr int kLevels = 4;
+  static constexpr uint64_t kTickNs = 1000000ull;
+
+  TimerWheel(uint32_t wheel_no, uint64_t now_ns);
+  ~TimerWheel(); // drops pending callbacks, unlinks embedded nodes
+  TimerWheel(const TimerWheel&) = delete;
+  TimerWheel& operator=(const TimerWheel&) = delete;
+
+  // Arm (or move) `n` to fire at CLOCK_MONOTONIC `deadline_ns`; a node armed
+  // on another wheel is withdrawn from it first.
+  void arm(TimerNode* n, uint64_t deadline_ns);
+  // True if `n` was armed here and is now withdrawn.
+  bool cancel(TimerNode* n);
+
+  // Callback timer from the slab: returns a handle id (never 0) that
+  // encodes (generation, wheel_no, index); a fired or cancelled timer's
+  // handle fails the generation check.
+  template<typename F>
+  uint64_t add_callback(uint64_t deadline_ns, F&& cb) {
+    Entry* e = acquire();
+    e->cb.emplace(std::forward<F>(cb));
+    return commit(e, deadline_ns);
+  }
+  bool cancel_id(uint64_t id);
+
+  // Advance to `now_ns` and run everything due. Returns how many fired.
+  size_t expire(uint64_t now_ns);
+  uint32_t pending() const { return pending_.load(std::memory_order_relaxed); }
+
+  static uint32_t id_wheel(uint64_t id) { return (uint32_t)((id >> kIndexBits) & 0xFFu); }
+
+private:
+  static constexpr unsigned kIndexBits = 24;
+  static constexpr uint32_t kIndexMask = (1u << kIndexBits) - 1u;
+  static constexpr uint8_t kDueLevel = kLevels; // node->level for the due list
+  static constexpr uint32_t kChunk = 64;        // slab entries per allocation
+
+  struct Entry {
+    TimerNode node;
+    InlineCallback<> cb;
+    uint32_t gen{1};
+    uint32_t index{0};
+    Entry* next_free{nullptr};
+    TimerWheel* owner{nullptr};
+  };
+
+  TimerNode*& list_for(const TimerNode* n) { return n->level == kDueLevel ? due_ : head_[n->level][n->slot]; }
+  void link(TimerNode* n);
+  void unlink(TimerNode* n);
+  void place(TimerNode* n);
+  void replace_slot(int level, unsigned slot);
+  uint64_t next_tick_locked() const;
+  Entry* acquire();
+  uint64_t commit(Entry* e, uint64_t deadline_ns);
+  void release(Entry* e);
+  static void fire_entry(void* ctx);
+
+  std::mutex mu_;
+  uint64_t now_tick_;                 // last processed tick
+  TimerNode* head_[kLevels][kSlots]{};
+  TimerNode* due_{nullptr};           // expired, not yet fired
+  std::vector<std::unique_ptr<Entry[]>> chunks_;
+  Entry* free_{nullptr};
+  std::atomic<uint32_t> pending_{0};  // armed nodes
+  uint32_t wheel_no_;                 // owner index, encoded in handles
+};
+
+inline void TimerNode::disarm() {
+  if (TimerWheel* w = wheel.load(std::memory_order_acquire)) w->cancel(this);
+}
+
+inline TimerNode::~TimerNode() { disarm(); }
+
+} // namespace detail
+} // namespace kcoro_cpp
@@ -3,8 +3,12 @@
 #include "kcoro_cpp/core.hpp"
 #include "kcoro_cpp/coroutine.hpp"
 #include "kcoro_cpp/channel.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include <deque>
 
 namespace kcoro_cpp {
@@ -15,56 +19,212 @@ namespace kcoro_cpp {
     static ZCopyRegistry& instance() { static ZCopyRegistry g; return g; }
     ZCopyRegistry() = default;
   int register_backend(const std::string& name, IZcopyBackend* b) {
+    std::lock_guard<std::mutex> lk(backends_mu_);
     int id = next_id_++; backends_[name] = {id, b}; return id;
   }
   IZcopyBackend* resolve(const std::string& name) const {
+    std::lock_guard<std::mutex> lk(backends_mu_);
     auto it = backends_.find(name); return (it==backends_.end()) ? nullptr : it->second.ops;
   }
-  // Region registry (stubbed parity surface)
+  // Region registry. Regions live in a fixed slot table and an id names its
+  // slot, so lookups (query, get_meta, incref) pin the slot with one CAS on
+  // its reference count and take no lock. Meta is published by pointer; the
+  // versions it replaces are freed once the region drains at deregister.
   using RegionId = uint64_t;
-  RegionId region_register(void* base, size_t len);
+  static constexpr unsigned kSlotBits = 8;
+  static constexpr size_t kMaxRegions = size_t(1) << kSlotBits;
+  RegionId region_register(void* base, size_t len);  // 0 when the table is full
   bool region_incref(RegionId id);
   bool region_decref(RegionId id);
   bool region_deregister(RegionId id);
   bool region_query(RegionId id, void*& base, size_t& len) const;
-  // Meta API
-  void set_meta(RegionId id, const RegionMeta& m);
+  // Meta API. set_meta refuses (false) a region that is gone, and meta whose
+  // align_bytes is not a power of two or is not honoured by the region's
+  // base and stride_bytes, so FMT_ALIGN checks can trust it.
+  bool set_meta(RegionId id, const RegionMeta& m);
   bool get_meta(RegionId id, RegionMeta& m) const;
   // Aligned allocation helper
   bool alloc_aligned(size_t size, size_t align, void*& base, RegionId& id);
+  // Slicing for data-parallel consumers. region_slice cuts the region's
+  // tensor (meta dims, last dim contiguous, rows stride_bytes apart; no
+  // dims: one row of elements) along axis into at most n contiguous
+  // descriptors, each starting a multiple of kSliceAlign bytes past the
+  // base. The axes outside axis must be 1, so that a slice is one span.
+  // Every descriptor holds a reference on the region, dropped with
+  // region_decref. Returns how many it made, or KC_EINVAL.
+  static constexpr size_t kSliceAlign = 64;
+  int region_slice(RegionId id, unsigned axis, size_t n, ZDesc* out);
+  // Waits until the owner's reference is the only one left, so every
+  // slice is back; false on timeout or once the region is gone.
+  bool region_wait_idle(RegionId id, long tmo_ms);
   private:
-    mutable std::mutex mu_;
+  mutable std::mutex backends_mu_;
   struct Entry { int id; IZcopyBackend* ops; };
   std::unordered_map<std::string, Entry> backends_;
   int next_id_{0};
-  struct Region {
-    void* base{}; size_t len{}; uint64_t refs{}; bool dereg{false};
-    mutable std::mutex mu; std::condition_variable cv;
-    RegionMeta meta{}; bool has_meta{false};
-    Region() = default;
-    Region(void* b, size_t l, uint64_t r, bool d) : base(b), len(l), refs(r), dereg(d) {}
-    Region(const Region&) = delete; Region& operator=(const Region&) = delete;
-    Region(Region&& other) noexcept {
-      base = other.base; len = other.len; refs = other.refs; dereg = other.dereg;
-    }
-    Region& operator=(Region&& other) noexcept {
-      if (this!=&other) { base=other.base; len=other.len; refs=other.refs; dereg=other.dereg; }
-      return *this;
-    }
+  // refs counts the owner's reference plus pins; kDead set while the
+  // slot is free or being deregistered, so no new pin can land.
+  static constexpr uint64_t kDead = uint64_t(1) << 63;
+  static constexpr RegionId kClaimed = ~RegionId(0);
+  struct Slot {
+    std::atomic<RegionId> id{0};
+    std::atomic<uint64_t> refs{kDead};
+    void* base{}; size_t len{};   // fixed while id is live
+    std::atomic<const RegionMeta*> meta{nullptr};
+    std::mutex mu;                // retired, and the drain wait
+    std::condition_variable cv;
+    std::vector<const RegionMeta*> retired;
+    std::atomic<uint32_t> idle_waiters{0};
   };
-  std::unordered_map<RegionId, Region> regions_;
-  RegionId next_region_id_{0};
+  Slot* pin(RegionId id) const;
+  static void unpin(Slot* s);
+  static void wake_idle(Slot* s);
+  mutable Slot slots_[kMaxRegions];
+  std::atomic<RegionId> next_gen_{0};
   };
 
+class ZBufPool;
+
+// Move-only owner of one zero-copy buffer: a span of a registered region
+// (region id, offset, len) plus the pool its slot goes back to, if any. It
+// holds one reference on the region, in the region's own count (no control
+// block), so the region cannot be deregistered under it. Dropping the last
+// owner gives the slot back to its pool and the reference back to the
+// region. Moves through IChannel<ZBuf> as is; over a zref channel, release()
+// hands the reference to the descriptor and the receiver adopts it.
+class ZBuf {
+public:
+  ZBuf() = default;
+  // Takes over the region reference d already holds (a region_slice part,
+  // a descriptor from zbuf_send); pool, when given, gets d.addr back too.
+  static ZBuf adopt(const ZDesc& d, ZBufPool* pool = nullptr) { ZBuf b; b.d_ = d; b.pool_ = pool; return b; }
+  ZBuf(ZBuf&& o) noexcept : d_(o.d_), pool_(o.pool_) { o.d_ = {}; o.pool_ = nullptr; }
+  ZBuf& operator=(ZBuf&& o) noexcept {
+    if (this != &o) { reset(); d_ = o.d_; pool_ = o.pool_; o.d_ = {}; o.pool_ = nullptr; }
+    return *this;
+  }
+  ZBuf(const ZBuf&) = delete;
+  ZBuf& operator=(const ZBuf&) = delete;
+  ~ZBuf() { reset(); }
+  void* data() const { return d_.addr; }
+  size_t size() const { return d_.len; }
+  ZCopyRegistry::RegionId region() const { return d_.region_id; }
+  uint64_t offset() const { return d_.offset; }
+  ZBufPool* pool() const { return pool_; }
+  explicit operator bool() const { return d_.region_id != 0; }
+  // Shrinks the payload to what was written; false past the current size
+  bool resize(size_t len) { if (len > d_.len) return false; d_.len = len; return true; }
+  // The descriptor, still owned by this handle
+  const ZDesc& desc() const { return d_; }
+  // Gives up ownership: the returned descriptor carries the reference
+  ZDesc release() { ZDesc d = d_; d_ = {}; pool_ = nullptr; return d; }
+  // Drops the buffer now
+  void reset();
+private:
+  ZDesc d_{};
+  ZBufPool* pool_{};
+};
+inline size_t size_bytes_default(const ZBuf& b) { return b.size(); }
+
+// Fixed-size slots carved from one registered region. acquire/release hand
+// out raw slots; get() wraps one in a ZBuf that returns it when dropped.
+// The pool must outlive its buffers: deregistering the region at
+// destruction waits for every ZBuf's reference. Throws Error when the
+// region cannot be made.
+class ZBufPool {
+public:
+  ZBufPool(size_t slot_bytes, size_t slots, size_t align = 64) : ZBufPool(nullptr, slot_bytes, slots, align) {}
+  ~ZBufPool();
+  ZBufPool(const ZBufPool&) = delete;
+  ZBufPool& operator=(const ZBufPool&) = delete;
+  void* acquire();                 // nullptr while every slot is out
+  void release(void* slot);
+  ZBuf get();                      // empty while every slot is out
+  ZCopyRegistry::RegionId region() const { return id_; }
+  uint64_t offset_of(const void* slot) const { return (uint64_t)((const char*)slot - base_); }
+  size_t slot_bytes() const { return slot_bytes_; }
+  size_t available() const { std::lock_guard<std::mutex> lk(mu_); return free_.size(); }
+protected:
+  // m, when given, is set as the region's meta and sets the slot alignment
+  ZBufPool(const RegionMeta* m, size_t slot_bytes, size_t slots, size_t align);
+private:
+  char* base_{};
+  ZCopyRegistry::RegionId id_{};
+  size_t slot_bytes_{};
+  mutable std::mutex mu_;
+  std::vector<uint32_t> free_;
+};
+
+// Destination buffers for FormatMode::Adapt: a ZBufPool whose region meta
+// (m) is the converted format, so give it the format the channel requires.
+class ConvertPool : public ZBufPool {
+public:
+  ConvertPool(const RegionMeta& m, size_t slot_bytes, size_t slots) : ZBufPool(&m, slot_bytes, slots, 0) {}
+  using ZBufPool::release;
+  // A received descriptor: gives its slot back if it was converted
+  void release(const ZDesc& d) { if (d.flags & ZDESC_F_CONVERTED) release(d.addr); }
+};
+
+// ZBuf over a descriptor channel (zref or IChannel<ZDesc>): a send that
+// goes through hands the buffer's reference to the receiver, who wraps it
+// again with pool (the sender's pool, or nullptr for a plain reference).
+// A failed send leaves b as it was. Channels that adapt formats deliver a
+// copy in their own pool and are not for ZBuf traffic.
+int zbuf_send(IChannel<ZDesc>& ch, ZBuf&& b, long tmo_ms);
+int zbuf_recv(IChannel<ZDesc>& ch, ZBuf& out, long tmo_ms, ZBufPool* pool = nullptr);
+
+// Required format of a zref channel. Sends are admitted by mode: Advisory
+// lets everything through, Strict refuses a mismatch, and Adapt refuses
+// only what it cannot convert. Convertible are dtype changes among FP32,
+// FP16 and BF16 and differences in stride or alignment, given a pool slot
+// big enough; layout, dims and elem_bits that disagree with the dtype are
+// not. Rows follow the meta: the last dim is contiguous, the others count
+// rows stride_bytes apart (0: packed); without dims the payload is one row
+// of len bytes. The converted copy is packed unless FMT_STRIDE is required.
+struct FormatPolicy {
+  RegionMeta req{};
+  FormatMask mask{0};
+  FormatMode mode{FormatMode::Advisory};
+  ConvertPool* pool{nullptr};
+  // 0, or KC_EINVAL when the mode refuses d
+  int admit(const ZDesc& d) const;
+  // Adapt only: converts d into slot and points d at it (region_id and
+  // offset name the slot, ZDESC_F_CONVERTED set); false, slot untouched,
+  // when d needs no conversion or can no longer get one
+  bool convert_into(ZDesc& d, void* slot) const;
+  // Pool slot and conversion for a receiver: 0, or KC_ENOBUFS with d as is
+  int adapt(ZDesc& d) const;
+  bool adapting() const { return mode == FormatMode::Adapt && pool; }
+private:
+  enum class Verdict { Match, Convert, Reject };
+  struct Plan { DType from, to; size_t src_pitch, dst_pitch, rows, row_elems, dst_bytes; };
+  Verdict plan(const ZDesc& d, Plan& p) const;
+};
+
+// Scatter/gather over a worker pool: one slice of id to each of the n
+// channels, in order. Workers region_decref their slice when done with it
+// and region_gather waits for the lot. Returns how many slices were sent,
+// or the error when none was; unsent slices give their reference back.
+int region_scatter(ZCopyRegistry::RegionId id, unsigned axis, IChannel<ZDesc>* const* chans, size_t n, long tmo_ms);
+inline bool region_gather(ZCopyRegistry::RegionId id, long tmo_ms) { return ZCopyRegistry::instance().region_wait_idle(id, tmo_ms); }
+
 // ZRef rendezvous backend for descriptor channels
 class ZRefRendezvous : public IZcopyBackend {
 public:
+  // One instance per channel: its state is inline, and the chan argument
+  // of the calls below only names the channel it serves.
   ZRefRendezvous(WorkStealingScheduler* sched) : sched_(sched) {}
   int send(void* chan, const ZDesc& d, long tmo_ms) override;
   int recv(void* chan, ZDesc& d, long tmo_ms) override;
   void on_close(void* chan);
-  // Optional format policy per channel
-  void set_required_format(const RegionMeta& m, FormatMask mask, FormatMode mode) { req_meta_=m; mask_=mask; mode_=mode; }
+  // Optional format policy per channel. Adapt converts on the receiving
+  // side into pool, which must outlive the channel; a receive then needs
+  // a free slot up front and fails KC_ENOBUFS, consuming nothing, without.
+  // Converted payloads are copies: the sent buffer is finished with once
+  // recv returns, and the receiver hands the slot back to the pool.
+  void set_required_format(const RegionMeta& m, FormatMask mask, FormatMode mode, ConvertPool* pool = nullptr) { policy_ = {m, mask, mode, pool}; }
+  // Select receivers get descriptors as sent; this converts one afterwards
+  int adapt(ZDesc& d) const { return policy_.adapt(d); }
   // Select integration
   int select_register_recv(void* chan, class ISelect* sel, int clause_index, ZDesc* out);
   int select_register_send(void* chan, class ISelect* sel, int clause_index, const ZDesc* val);
@@ -72,45 +232,45 @@ public:
 private:
   struct SelRecv { ISelect* sel; int idx; ZDesc* out; };
   struct SelSend { ISelect* sel; int idx; ZDesc val; };
-  struct State { bool ready=false; void* ptr=nullptr; size_t len=0; uint64_t rid=0; uint64_t off=0; Coroutine* parked_sender=nullptr; std::deque<Coroutine*> recv_waiters; std::deque<SelRecv> srecv; std::deque<SelSend> ssend; };
+  struct State { bool ready=false; bool closed=false; void* ptr=nullptr; size_t len=0; uint64_t rid=0; uint64_t off=0; Coroutine* parked_sender=nullptr; std::deque<Coroutine*> recv_waiters; std::deque<SelRecv> srecv; std::deque<SelSend> ssend; };
   mutable std::mutex mu_;
-  std::unordered_map<void*, State> st_;
+  State st_;
   WorkStealingScheduler* sched_{};
-  // format policy
-  RegionMeta req_meta_{}; FormatMask mask_{0}; FormatMode mode_{FormatMode::Advisory};
+  FormatPolicy policy_;
 };
 
 // ZRef buffered/unlimited via pointer-descriptor buffered channel
 class ZRefBuffered : public IZcopyBackend {
 public:
   ZRefBuffered(BufferedChannel<ZDesc>* chan) : ch_(chan) {}
-  void set_required_format(const RegionMeta& m, FormatMask mask, FormatMode mode) { req_meta_=m; mask_=mask; mode_=mode; }
+  // As ZRefRendezvous::set_required_format
+  void set_required_format(const RegionMeta& m, FormatMask mask, FormatMode mode, ConvertPool* pool = nullptr) { policy_ = {m, mask, mode, pool}; }
+  int adapt(ZDesc& d) const { return policy_.adapt(d); }
   int send(void* /*chan*/, const ZDesc& d, long tmo_ms) override {
-    if (d.region_id && mask_) {
-      RegionMeta m{}; if (ZCopyRegistry::instance().get_meta(d.region_id, m)) {
-        bool mismatch=false;
-        if ((mask_ & FMT_DTYPE)    && m.dtype != req_meta_.dtype) mismatch=true;
-        if ((mask_ & FMT_ELEMBITS) && m.elem_bits != req_meta_.elem_bits) mismatch=true;
-        if ((mask_ & FMT_ALIGN)    && m.align_bytes < req_meta_.align_bytes) mismatch=true;
-        if ((mask_ & FMT_STRIDE)   && m.stride_bytes != req_meta_.stride_bytes) mismatch=true;
-        if ((mask_ & FMT_DIMS)) { if (m.ndims != req_meta_.ndims) mismatch=true; else for (uint8_t i=0;i<m.ndims && !mismatch;i++) if (m.dims[i]!=req_meta_.dims[i]) mismatch=true; }
-        if ((mask_ & FMT_LAYOUT)   && m.layout != req_meta_.layout) mismatch=true;
-        if (mismatch && mode_==FormatMode::Strict) return KC_EINVAL;
-      }
-    }
+    if (int rc = policy_.admit(d)) return rc;
     return ch_->send(d, tmo_ms);
   }
-  int recv(void* /*chan*/, ZDesc& d, long tmo_ms) override { return ch_->recv(d, tmo_ms); }
+  int recv(void* /*chan*/, ZDesc& d, long tmo_ms) override {
+    if (!policy_.adapting()) return ch_->recv(d, tmo_ms);
+    void* slot = policy_.pool->acquire();
+    if (!slot) return KC_ENOBUFS;
+    int rc = ch_->recv(d, tmo_ms);
+    if (rc != 0 || !policy_.convert_into(d, slot)) policy_.pool->release(slot);
+    return rc;
+  }
 private:
   BufferedChannel<ZDesc>* ch_{};
-  RegionMeta req_meta_{}; FormatMask mask_{0}; FormatMode mode_{FormatMode::Advisory};
+  FormatPolicy policy_;
 };
 
 // Convenience channel types
 class ZRefRendezvousChannel : public IChannel<ZDesc> {
 public:
+  using IChannel<ZDesc>::send;
+  using IChannel<ZDesc>::send_c; // rvalue sends copy
   explicit ZRefRendezvousChannel(WorkStealingScheduler* sched) : backend_(sched) {}
-  void require_format(const RegionMeta& m, FormatMask mask, FormatMode mode) { backend_.set_required_format(m,mask,mode); }
+  void require_format(const RegionMeta& m, FormatMask mask, FormatMode mode, ConvertPool* pool = nullptr) { backend_.set_required_format(m,mask,mode,pool); }
+  int adapt(ZDesc& d) const { return backend_.adapt(d); }
   int send(const ZDesc& d, long tmo_ms) override { return backend_.send(this, d, tmo_ms); }
   int recv(ZDesc& d, long tmo_ms) override { return backend_.recv(this, d, tmo_ms); }
   int send_c(const ZDesc& d, long timeout_ms, const ICancellationToken* cancel) override {
@@ -119,7 +279,7 @@ public:
   }
   int recv_c(ZDesc& d, long timeout_ms, const ICancellationToken* cancel) override {
     auto deadline = (timeout_ms < 0) ? (uint64_t)(-1) : (platform::now_ns() + (uint64_t)timeout_ms * 1000000ULL);
-    for(;;){ int rc = backend_.recv(this, d, 0); if (rc==0 || rc==KC_EPIPE) return rc; if(cancel && cancel->is_set()) return KC_ECANCELED; if(timeout_ms>=0 && platform::now_ns()>=deadline) return KC_ETIME; auto* cur=Coroutine::current(); if(!cur) return KC_EAGAIN; cur->park(); }
+    for(;;){ int rc = backend_.recv(this, d, 0); if (rc==0 || rc==KC_EPIPE || rc==KC_ENOBUFS) return rc; if(cancel && cancel->is_set()) return KC_ECANCELED; if(timeout_ms>=0 && platform::now_ns()>=deadline) return KC_ETIME; auto* cur=Coroutine::current(); if(!cur) return KC_EAGAIN; cur->park(); }
   }
   void close() override { closed_=true; backend_.on_close(this); }
   size_t size() const override { return 0; }
@@ -136,9 +296,12 @@ private:
 
 class ZRefBufferedChannel : public IChannel<ZDesc> {
 public:
+  using IChannel<ZDesc>::send;
+  using IChannel<ZDesc>::send_c; // rvalue sends copy
   ZRefBufferedChannel(WorkStealingScheduler* sched, size_t cap)
   : buffered_(sched, cap), backend_(&buffered_) {}
-  void require_format(const RegionMeta& m, FormatMask mask, FormatMode mode) { backend_.set_required_format(m,mask,mode); }
+  void require_format(const RegionMeta& m, FormatMask mask, FormatMode mode, ConvertPool* pool = nullptr) { backend_.set_required_format(m,mask,mode,pool); }
+  int adapt(ZDesc& d) const { return backend_.adapt(d); }
   int send(const ZDesc& d, long tmo_ms) override { return backend_.send(this, d, tmo_ms); }
   int recv(ZDesc& d, long tmo_ms) override { return backend_.recv(this, d, tmo_ms); }
   void close() override { buffered_.close(); }
@@ -150,7 +313,7 @@ public:
   }
   int recv_c(ZDesc& d, long timeout_ms, const ICancellationToken* cancel) override {
     auto deadline = (timeout_ms < 0) ? (uint64_t)(-1) : (platform::now_ns() + (uint64_t)timeout_ms * 1000000ULL);
-    for(;;){ int rc = backend_.recv(this, d, 0); if (rc==0 || rc==KC_EPIPE) return rc; if(cancel && cancel->is_set()) return KC_ECANCELED; if(timeout_ms>=0 && platform::now_ns()>=deadline) return KC_ETIME; auto* cur=Coroutine::current(); if(!cur) return KC_EAGAIN; cur->park(); }
+    for(;;){ int rc = backend_.recv(this, d, 0); if (rc==0 || rc==KC_EPIPE || rc==KC_ENOBUFS) return rc; if(cancel && cancel->is_set()) return KC_ECANCELED; if(timeout_ms>=0 && platform::now_ns()>=deadline) return KC_ETIME; auto* cur=Coroutine::current(); if(!cur) return KC_EAGAIN; cur->park(); }
   }
   // Select hooks delegate directly (typed)
   int select_register_recv(ISelect* sel, int clause_index, ZDesc* out) override { return buffered_.select_register_recv(sel, clause_index, out); }
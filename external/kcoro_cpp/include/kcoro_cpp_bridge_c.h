@@ -16,6 +16,15 @@ int kcoro_cpp_sched_spawn_co(kcoro_scheduler_handle sched, kcoro_task_fn fn, voi
 void kcoro_cpp_sched_yield(void);
 void kcoro_cpp_sched_sleep_ms(int ms);
 
+/* Hosted scheduler: `slots` workers run by a host runtime's threads (for
+ * libkcoro, pass kcoro_cpp_sched_poll / kcoro_cpp_sched_next_timer_ns as a
+ * kc_sched_guest_t and ring it from notify). NULL without notify. */
+kcoro_scheduler_handle kcoro_cpp_sched_init_hosted(int slots, void (*notify)(void* ctx), void* ctx);
+int kcoro_cpp_sched_poll(void* sched, int worker, int budget);
+unsigned long long kcoro_cpp_sched_next_timer_ns(void* sched);
+/* Make sched the default scheduler before anything creates one: 0, or -1. */
+int kcoro_cpp_sched_set_default(kcoro_scheduler_handle sched);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,184 @@
+#include "kcoro_cpp/convert.hpp"
+#include <cstring>
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define KC_CONVERT_NEON 1
+#elif (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define KC_CONVERT_F16C 1
+#endif
+
+namespace kcoro_cpp {
+namespace convert {
+
+namespace {
+inline uint32_t bits_of(float f) { uint32_t u; std::memcpy(&u, &f, 4); return u; }
+inline float float_of(uint32_t u) { float f; std::memcpy(&f, &u, 4); return f; }
+
+#if KC_CONVERT_F16C
+// Compiled for F16C whatever the target flags; only called once the CPU says it has it
+__attribute__((target("avx,f16c")))
+void f16c_fp32_to_fp16(const float* src, uint16_t* dst, size_t n) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+    _mm_storeu_si128((__m128i*)(dst + i), h);
+  }
+  for (; i < n; i++) dst[i] = fp32_to_fp16(src[i]);
+}
+
+__attribute__((target("avx,f16c")))
+void f16c_fp16_to_fp32(const uint16_t* src, float* dst, size_t n) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8)
+    _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(src + i))));
+  for (; i < n; i++) dst[i] = fp16_to_fp32(src[i]);
+}
+
+bool have_f16c() {
+  static const bool yes = __builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c");
+  return yes;
+}
+#endif
+} // namespace
+
+// Scalar ------------------------------------------------------------------------
+
+uint16_t fp32_to_fp16(float f) {
+  uint32_t x = bits_of(f);
+  const uint16_t sign = (uint16_t)((x >> 16) & 0x8000u);
+  x &= 0x7fffffffu;
+  if (x >= 0x47800000u) {                       // >= 2^16: infinity, or NaN
+    if (x > 0x7f800000u) return (uint16_t)(sign | 0x7e00u | ((x >> 13) & 0x3ffu));
+    return (uint16_t)(sign | 0x7c00u);
+  }
+  if (x < 0x38800000u) {                        // below 2^-14: subnormal or zero
+    // Adding 0.5 lines the half ulp up with the float ulp, so the FPU rounds
+    const uint32_t magic = 0x3f000000u;
+    return (uint16_t)(sign | (bits_of(float_of(x) + float_of(magic)) - magic));
+  }
+  // Rebias the exponent and round to nearest even on the 13 dropped bits;
+  // a carry out of the mantissa bumps the exponent, up to infinity
+  x += 0xc8000fffu + ((x >> 13) & 1u);
+  return (uint16_t)(sign | (x >> 13));
+}
+
+float fp16_to_fp32(uint16_t h) {
+  const uint32_t sign = (uint32_t)(h & 0x8000u) << 16;
+  const uint32_t e = (h >> 10) & 0x1fu, m = h & 0x3ffu;
+  if (e == 0x1f) return float_of(sign | 0x7f800000u | (m << 13) | (m ? 0x400000u : 0));
+  if (e) return float_of(sign | ((e + 112) << 23) | (m << 13));
+  // Subnormal halves are exact floats: m * 2^-24
+  return float_of(sign | bits_of((float)m * 0x1p-24f));
+}
+
+uint16_t fp32_to_bf16(float f) {
+  const uint32_t x = bits_of(f);
+  if ((x & 0x7fffffffu) > 0x7f800000u) return (uint16_t)((x >> 16) | 0x40u);
+  return (uint16_t)((x + 0x7fffu + ((x >> 16) & 1u)) >> 16);
+}
+
+float bf16_to_fp32(uint16_t h) {
+  uint32_t x = (uint32_t)h << 16;
+  if ((x & 0x7fffffffu) > 0x7f800000u) x |= 0x400000u;
+  return float_of(x);
+}
+
+// Bulk --------------------------------------------------------------------------
+
+void fp32_to_fp16(const float* src, uint16_t* dst, size_t n) {
+#if KC_CONVERT_NEON
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4)
+    vst1_u16(dst + i, vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(src + i))));
+  for (; i < n; i++) dst[i] = fp32_to_fp16(src[i]);
+#else
+#if KC_CONVERT_F16C
+  if (have_f16c()) { f16c_fp32_to_fp16(src, dst, n); return; }
+#endif
+  for (size_t i = 0; i < n; i++) dst[i] = fp32_to_fp16(src[i]);
+#endif
+}
+
+void fp16_to_fp32(const uint16_t* src, float* dst, size_t n) {
+#if KC_CONVERT_NEON
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4)
+    vst1q_f32(dst + i, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(src + i))));
+  for (; i < n; i++) dst[i] = fp16_to_fp32(src[i]);
+#else
+#if KC_CONVERT_F16C
+  if (have_f16c()) { f16c_fp16_to_fp32(src, dst, n); return; }
+#endif
+  for (size_t i = 0; i < n; i++) dst[i] = fp16_to_fp32(src[i]);
+#endif
+}
+
+// Plain integer loops: the compiler turns the NaN tests into selects and
+// vectorises both
+void fp32_to_bf16(const float* src, uint16_t* dst, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    uint32_t x; std::memcpy(&x, src + i, 4);
+    const uint32_t rounded = (x + 0x7fffu + ((x >> 16) & 1u)) >> 16;
+    const uint32_t quiet = (x >> 16) | 0x40u;
+    dst[i] = (uint16_t)(((x & 0x7fffffffu) > 0x7f800000u) ? quiet : rounded);
+  }
+}
+
+void bf16_to_fp32(const uint16_t* src, float* dst, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    uint32_t x = (uint32_t)src[i] << 16;
+    x |= ((x & 0x7fffffffu) > 0x7f800000u) ? 0x400000u : 0u;
+    std::memcpy(dst + i, &x, 4);
+  }
+}
+
+// Dispatch ----------------------------------------------------------------------
+
+size_t elem_size(DType t) {
+  switch (t) {
+    case DType::FP16: case DType::BF16: return 2;
+    case DType::FP32: return 4;
+    default: return 0;
+  }
+}
+
+bool supported(DType from, DType to) {
+  return elem_size(from) && elem_size(to);
+}
+
+bool convert_rows(DType from, const void* src, size_t src_pitch,
+                  DType to, void* dst, size_t dst_pitch,
+                  size_t rows, size_t row_elems) {
+  using widen_fn = void (*)(const uint16_t*, float*, size_t);
+  using narrow_fn = void (*)(const float*, uint16_t*, size_t);
+  if (!supported(from, to)) return false;
+  const widen_fn widen = (from == DType::FP16) ? widen_fn(fp16_to_fp32) : widen_fn(bf16_to_fp32);
+  const narrow_fn narrow = (to == DType::FP16) ? narrow_fn(fp32_to_fp16) : narrow_fn(fp32_to_bf16);
+  const size_t sbytes = row_elems * elem_size(from), dbytes = row_elems * elem_size(to);
+  if (!src_pitch) src_pitch = sbytes;
+  if (!dst_pitch) dst_pitch = dbytes;
+  // Packed on both sides: one pass over the lot
+  if (src_pitch == sbytes && dst_pitch == dbytes) { row_elems *= rows; rows = 1; }
+  const char* s = (const char*)src;
+  char* o = (char*)dst;
+  for (size_t r = 0; r < rows; r++, s += src_pitch, o += dst_pitch) {
+    if (from == to) std::memcpy(o, s, row_elems * elem_size(from));
+    else if (from == DType::FP32) narrow((const float*)s, (uint16_t*)o, row_elems);
+    else if (to == DType::FP32) widen((const uint16_t*)s, (float*)o, row_elems);
+    else {
+      // FP16 <-> BF16 by way of FP32, a bounded chunk at a time
+      float tmp[256];
+      for (size_t i = 0; i < row_elems; i += 256) {
+        const size_t k = (row_elems - i < 256) ? row_elems - i : 256;
+        widen((const uint16_t*)s + i, tmp, k);
+        narrow(tmp, (uint16_t*)o + i, k);
+      }
+    }
+  }
+  return true;
+}
+
+} // namespace convert
+} // namespace kcoro_cpp
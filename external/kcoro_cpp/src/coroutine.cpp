@@ -19,6 +19,53 @@ thread_local Coroutine* Coroutine::tls_main_ = nullptr;
 Coroutine* Coroutine::current() { return tls_current_; }
 Coroutine* Coroutine::main() { return tls_main_; }
 
+namespace {
+std::atomic<unsigned> g_cls_next{0};
+std::atomic<void (*)(void*)> g_cls_dtor[kClsKeys];
+}
+
+unsigned kcoro_cpp::detail::cls_key_create(void (*dtor)(void*)) {
+  unsigned k = g_cls_next.load(std::memory_order_relaxed);
+  do {
+    if (k >= kClsKeys) throw Error("coroutine-local keys exhausted (kClsKeys)");
+  } while (!g_cls_next.compare_exchange_weak(k, k + 1, std::memory_order_relaxed));
+  g_cls_dtor[k].store(dtor, std::memory_order_relaxed);
+  return k;
+}
+
+void Coroutine::set_local(unsigned key, void* value) {
+  if (key >= g_cls_next.load(std::memory_order_relaxed)) throw Error("set_local: key not created");
+  if (key < kClsInline) {
+    cls_[key] = value;
+  } else {
+    if (!cls_ext_) {
+      if (!value) return;
+      cls_ext_.reset(new void*[kClsKeys - kClsInline]());
+    }
+    cls_ext_[key - kClsInline] = value;
+  }
+  if (value) cls_used_ = true;
+}
+
+void Coroutine::finish_locals() {
+  if (!cls_used_) return;
+  unsigned nkeys = g_cls_next.load(std::memory_order_relaxed);
+  // Destructors may set values again (CoroutineLocal::get in a destructor):
+  // a few rounds, as for thread-specific data.
+  for (int pass = 0; pass < 4; pass++) {
+    bool again = false;
+    for (unsigned k = 0; k < nkeys; k++) {
+      void* v = local(k);
+      if (!v) continue;
+      if (k < kClsInline) cls_[k] = nullptr; else cls_ext_[k - kClsInline] = nullptr;
+      if (auto dtor = g_cls_dtor[k].load(std::memory_order_relaxed)) { dtor(v); again = true; }
+    }
+    if (!again) break;
+  }
+  cls_ext_.reset();
+  cls_used_ = false;
+}
+
 namespace {
 // Environment flag checked once per process
 static bool ctx_check_enabled() {
@@ -120,13 +167,19 @@ Coroutine::Coroutine(Fn fn, void* arg, std::size_t stack_bytes) : fn_(fn), arg_(
   }
   if (!fn_) return; // internal main
 
-  stack_ = platform::MMapStack::allocate(stack_bytes ? stack_bytes : 64*1024);
+  stack_req_ = stack_bytes ? stack_bytes : 64*1024;
+  stack_ = platform::StackPool::acquire(stack_req_);
+  prepare_context();
+}
+
+void Coroutine::prepare_context() {
   // Prepare initial context: set SP/FP and LR to trampoline
   uintptr_t top = reinterpret_cast<uintptr_t>(stack_.ptr) + stack_.size;
   top = detail::align_down(top, 16);
   top -= 16; // space
 
   // SP at reg[14], FP at reg[15], LR/continuation at reg[13]
+  ctx_ = CoContext{};
   ctx_.reg[14] = reinterpret_cast<void*>(top);
   ctx_.reg[15] = reinterpret_cast<void*>(top);
   ctx_.reg[13] = reinterpret_cast<void*>(coroutine_trampoline_c);
@@ -135,9 +188,22 @@ Coroutine::Coroutine(Fn fn, void* arg, std::size_t stack_bytes) : fn_(fn), arg_(
   main_co_ = tls_current_ ? tls_current_ : tls_main_;
 }
 
+bool Coroutine::reuse(Fn fn, void* arg, std::size_t stack_bytes) {
+  if (!fn_ || !fn || state_ != CoState::FINISHED) return false;
+  if ((stack_bytes ? stack_bytes : 64*1024) != stack_req_) return false;
+  fn_ = fn; arg_ = arg;
+  name_.clear();
+  finish_locals();
+  lane_ = Lane::Interactive;
+  prepare_context();
+  ready_enqueued_.store(false, std::memory_order_relaxed);
+  return true;
+}
+
 Coroutine::~Coroutine() {
+  finish_locals();
   if (fn_) {
-    stack_.release();
+    platform::StackPool::recycle(stack_);
   } else {
     // internal main
   }
@@ -182,6 +248,8 @@ void kcoro_cpp::coroutine_trampoline_c() {
   assert(cur && cur->fn_);
   cur->state_ = CoState::RUNNING;
   cur->fn_(cur->arg_);
+  // CoroutineLocal destructors still run as this coroutine
+  cur->finish_locals();
   cur->state_ = CoState::FINISHED;
   // (Optional) could record LR histogram here if desired
   // yield back to main
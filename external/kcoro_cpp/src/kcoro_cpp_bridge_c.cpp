@@ -44,4 +44,27 @@ void kcoro_cpp_sched_sleep_ms(int ms) {
     kcoro_cpp::sched_sleep_ms(ms);
 }
 
+kcoro_scheduler_handle kcoro_cpp_sched_init_hosted(int slots, void (*notify)(void*), void* ctx) {
+    if (!notify) return nullptr;
+    kcoro_cpp::SchedulerOptions opts{};
+    opts.workers = slots;
+    opts.host.notify = notify;
+    opts.host.ctx = ctx;
+    return static_cast<kcoro_scheduler_handle>(kcoro_cpp::sched_init(opts));
+}
+
+int kcoro_cpp_sched_poll(void* sched, int worker, int budget) {
+    if (!sched) return 0;
+    return static_cast<kcoro_cpp::WorkStealingScheduler*>(sched)->poll(worker, budget);
+}
+
+unsigned long long kcoro_cpp_sched_next_timer_ns(void* sched) {
+    if (!sched) return 0;
+    return static_cast<kcoro_cpp::WorkStealingScheduler*>(sched)->next_timer_ns();
+}
+
+int kcoro_cpp_sched_set_default(kcoro_scheduler_handle sched) {
+    return kcoro_cpp::sched_set_default(static_cast<kcoro_cpp::WorkStealingScheduler*>(sched)) ? 0 : -1;
+}
+
 }
@@ -1,87 +1,330 @@
 #include "kcoro_cpp/logger.hpp"
+#include "kcoro_cpp/platform.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
 #include <chrono>
 #include <cstdio>
-#include "kcoro_cpp/channel.hpp"
+#include <cstdlib>
+#include <ctime>
+#include <memory>
+#include <sys/uio.h>
+#include <unistd.h>
 
 namespace kcoro_cpp {
 
 namespace {
-constexpr size_t kLogChannelCapacity = 1024;
+constexpr std::size_t kRingBytes = 64 * 1024; // per logging thread
+constexpr std::size_t kMaxRecord = kRingBytes / 4;
+constexpr std::size_t kMaxStr = 4096;
+constexpr std::size_t kChunkBytes = 64 * 1024; // writer batch: up to kMaxChunks
+constexpr int kMaxChunks = 16;                 // chunks per writev
+constexpr uint8_t kKindFmt = 0, kKindPad = 1;
+
+// Records are 8-aligned; a record that would straddle the ring end is
+// preceded by a pad record (only size/kind, so it fits any 8-byte gap).
+struct RecordHead {
+  uint32_t size; // whole record
+  uint8_t level;
+  uint8_t kind;
+  uint16_t nargs;
+  uint64_t ts_ns;
+  const char* fmt;
+};
+struct ArgHead {
+  detail::LogArgTag tag;
+  uint8_t pad[3];
+  uint32_t len; // Str: bytes that follow, padded to 8
+  uint64_t bits;
+};
+static_assert(sizeof(RecordHead) % 8 == 0 && sizeof(ArgHead) % 8 == 0);
+
+inline std::size_t pad8(std::size_t n) { return (n + 7) & ~std::size_t(7); }
+
+const char* level_name(uint8_t level) {
+  switch ((LogLevel)level) {
+    case LogLevel::Info: return "INFO";
+    case LogLevel::Warn: return "WARN";
+    case LogLevel::Error: return "ERROR";
+    case LogLevel::Debug: return "DEBUG";
+  }
+  return "INFO";
+}
+} // namespace
+
+namespace detail {
+// Written only by its thread (tail side) and read only by the writer thread.
+struct LogRing {
+  alignas(64) std::atomic<uint64_t> tail{0};
+  uint64_t head_cache{0}; // producer's last view of head
+  std::atomic<uint64_t> dropped{0};
+  alignas(64) std::atomic<uint64_t> head{0};
+  uint64_t dropped_seen{0}; // writer only
+  std::atomic<bool> orphaned{false};
+  std::unique_ptr<char[]> buf{new char[kRingBytes]};
+};
+} // namespace detail
+
+namespace {
+// Marks the ring orphaned at thread exit; the writer frees it once drained.
+struct RingHolder {
+  detail::LogRing* ring{nullptr};
+  ~RingHolder() { if (ring) ring->orphaned.store(true, std::memory_order_release); }
+};
+thread_local RingHolder t_ring;
+
+// Writer-side output: formatted lines accumulate in chunks, sent with writev.
+class Batch {
+public:
+  explicit Batch(int fd) : fd_(fd) { for (auto& c : chunks_) c.reserve(kChunkBytes); }
+  std::string& line() {
+    if (chunks_[used_].size() >= kChunkBytes) {
+      if (used_ + 1 == kMaxChunks) write_out();
+      else ++used_;
+    }
+    return chunks_[used_];
+  }
+  void write_out() {
+    struct iovec iov[kMaxChunks];
+    int n = 0;
+    for (int i = 0; i <= used_; i++)
+      if (!chunks_[i].empty()) iov[n++] = {chunks_[i].data(), chunks_[i].size()};
+    int first = 0;
+    while (first < n) {
+      ssize_t w = ::writev(fd_, iov + first, n - first);
+      if (w < 0) { if (errno == EINTR) continue; break; }
+      // Partial write: skip what went out
+      while (first < n && (size_t)w >= iov[first].iov_len) { w -= (ssize_t)iov[first].iov_len; first++; }
+      if (first < n) { iov[first].iov_base = (char*)iov[first].iov_base + w; iov[first].iov_len -= (size_t)w; }
+    }
+    for (int i = 0; i <= used_; i++) chunks_[i].clear();
+    used_ = 0;
+  }
+  void set_fd(int fd) { fd_ = fd; }
+
+private:
+  int fd_;
+  int used_{0};
+  std::string chunks_[kMaxChunks];
+};
+
+void append_arg(std::string& out, const ArgHead& a, const char* payload) {
+  char tmp[64];
+  int n = 0;
+  switch (a.tag) {
+    case detail::LogArgTag::I64: n = std::snprintf(tmp, sizeof(tmp), "%lld", (long long)(int64_t)a.bits); break;
+    case detail::LogArgTag::U64: n = std::snprintf(tmp, sizeof(tmp), "%llu", (unsigned long long)a.bits); break;
+    case detail::LogArgTag::F64: { double d; std::memcpy(&d, &a.bits, sizeof(d)); n = std::snprintf(tmp, sizeof(tmp), "%g", d); break; }
+    case detail::LogArgTag::Bool: out.append(a.bits ? "true" : "false"); return;
+    case detail::LogArgTag::Char: out.push_back((char)a.bits); return;
+    case detail::LogArgTag::Ptr: n = std::snprintf(tmp, sizeof(tmp), "%p", (void*)(uintptr_t)a.bits); break;
+    case detail::LogArgTag::Str: out.append(payload, a.len); return;
+  }
+  if (n > 0) out.append(tmp, (size_t)n);
 }
+} // namespace
 
 Logger& Logger::instance() {
-  static Logger g;
-  return g;
+  // Never destroyed: exiting threads may still touch their rings
+  static Logger* g = [] {
+    auto* l = new Logger();
+    std::atexit([] { Logger::instance().flush(); });
+    return l;
+  }();
+  return *g;
 }
 
 Logger::Logger()
-    : sched_(sched_default()),
-      chan_(std::make_unique<BufferedChannel<std::string>>(sched_, kLogChannelCapacity)) {}
+    : fd_(STDERR_FILENO),
+      steady_base_ns_(platform::now_ns()),
+      system_base_ns_(std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::system_clock::now().time_since_epoch()).count()) {}
 
-void Logger::start_worker() {
-  bool expected = false;
-  if (!worker_started_.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
-    return;
-  }
-  sched_spawn_co(sched_, worker_trampoline, this, 64 * 1024);
+void Logger::start_writer() {
+  std::call_once(writer_once_, [this] {
+    writer_ = std::thread([this] { writer_loop(); });
+    writer_.detach();
+  });
 }
 
-void Logger::submit(LogLevel level, std::string message) {
-  start_worker();
-  char stamp[64];
-  auto now = std::chrono::system_clock::now();
-  auto tt = std::chrono::system_clock::to_time_t(now);
-  std::tm tm{};
-#if defined(_WIN32)
-  localtime_s(&tm, &tt);
-#else
-  localtime_r(&tt, &tm);
-#endif
-  auto us = std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()) % 1000000;
-  std::snprintf(stamp, sizeof(stamp), "%02d:%02d:%02d.%06lld",
-                tm.tm_hour, tm.tm_min, tm.tm_sec, static_cast<long long>(us.count()));
-
-  const char* lvl = "INFO";
-  switch (level) {
-    case LogLevel::Info: lvl = "INFO"; break;
-    case LogLevel::Warn: lvl = "WARN"; break;
-    case LogLevel::Error: lvl = "ERROR"; break;
-    case LogLevel::Debug: lvl = "DEBUG"; break;
+detail::LogRing* Logger::thread_ring() {
+  if (!t_ring.ring) {
+    auto* r = new detail::LogRing;
+    {
+      std::lock_guard<std::mutex> lk(rings_mu_);
+      rings_.push_back(r);
+    }
+    rings_gen_.fetch_add(1, std::memory_order_release);
+    t_ring.ring = r;
+    start_writer();
   }
+  return t_ring.ring;
+}
 
-  std::string line;
-  line.reserve(message.size() + 64);
-  line.append(stamp).append(" [").append(lvl).append("] ").append(message);
+void Logger::write_record(LogLevel level, const char* fmt, const detail::LogArgView* args, std::size_t nargs) {
+  const uint64_t ts = platform::now_ns();
+  std::size_t bytes = sizeof(RecordHead);
+  for (std::size_t i = 0; i < nargs; i++)
+    bytes += sizeof(ArgHead) + (args[i].tag == detail::LogArgTag::Str ? pad8(std::min(args[i].len, kMaxStr)) : 0);
+  detail::LogRing& r = *thread_ring();
+  if (bytes > kMaxRecord || nargs > UINT16_MAX) { r.dropped.fetch_add(1, std::memory_order_relaxed); return; }
 
-  int rc = chan_->send(line, 0);
-  if (rc == KC_EAGAIN) {
-    // drop best-effort log when channel saturated
+  uint64_t t = r.tail.load(std::memory_order_relaxed);
+  std::size_t off = t & (kRingBytes - 1);
+  std::size_t gap = (bytes > kRingBytes - off) ? kRingBytes - off : 0;
+  while (t + gap + bytes - r.head_cache > kRingBytes) {
+    r.head_cache = r.head.load(std::memory_order_acquire);
+    if (t + gap + bytes - r.head_cache <= kRingBytes) break;
+    if (overflow_.load(std::memory_order_relaxed) == LogOverflow::Drop) {
+      r.dropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    wake_cv_.notify_one();
+    std::this_thread::yield();
+  }
+  if (gap) {
+    uint32_t sz = (uint32_t)gap;
+    std::memcpy(r.buf.get() + off, &sz, sizeof(sz));
+    r.buf[off + offsetof(RecordHead, kind)] = (char)kKindPad;
+    t += gap; off = 0;
   }
+
+  char* p = r.buf.get() + off;
+  RecordHead h{(uint32_t)bytes, (uint8_t)level, kKindFmt, (uint16_t)nargs, ts, fmt};
+  std::memcpy(p, &h, sizeof(h));
+  p += sizeof(h);
+  for (std::size_t i = 0; i < nargs; i++) {
+    const detail::LogArgView& a = args[i];
+    std::size_t len = (a.tag == detail::LogArgTag::Str) ? std::min(a.len, kMaxStr) : 0;
+    ArgHead ah{a.tag, {}, (uint32_t)len, a.bits};
+    std::memcpy(p, &ah, sizeof(ah));
+    p += sizeof(ah);
+    if (len) { std::memcpy(p, a.s, len); p += pad8(len); }
+  }
+  r.tail.store(t + bytes, std::memory_order_release);
+  if (writer_sleeping_.load(std::memory_order_relaxed)) wake_cv_.notify_one();
+}
+
+void Logger::submit(LogLevel level, std::string_view message) {
+  log(level, "{}", message);
 }
 
 void Logger::flush() {
-  draining_.store(true, std::memory_order_release);
-  chan_->send("", 0);
+  if (!t_ring.ring && rings_gen_.load(std::memory_order_acquire) == 0) return; // nothing ever logged
+  start_writer();
+  uint64_t target = flush_req_.fetch_add(1, std::memory_order_acq_rel) + 1;
+  wake_cv_.notify_one();
+  std::unique_lock<std::mutex> lk(mu_);
+  done_cv_.wait_for(lk, std::chrono::seconds(1), [&] { return flush_done_ >= target; });
 }
 
-void Logger::worker_trampoline(void* arg) {
-  static_cast<Logger*>(arg)->worker_loop();
+Logger::Stats Logger::stats() const {
+  return Stats{written_.load(std::memory_order_relaxed), dropped_.load(std::memory_order_relaxed)};
 }
 
-void Logger::worker_loop() {
-  std::string line;
-  while (true) {
-    int rc = chan_->recv(line, 100);
-    if (rc == 0) {
-      if (!line.empty()) {
-        std::fwrite(line.data(), 1, line.size(), stderr);
-        std::fwrite("\n", 1, 1, stderr);
-        std::fflush(stderr);
+// Drain every ring, format into the batch, write, then sleep until woken
+// (or 10 ms) when a pass found nothing. A pass that started after a flush
+// request completes it.
+void Logger::writer_loop() {
+  std::vector<detail::LogRing*> rings;
+  uint64_t gen = ~0ull;
+  Batch out(fd_.load(std::memory_order_relaxed));
+  int64_t tm_sec = -1;
+  std::tm tm{};
+
+  for (;;) {
+    const uint64_t req = flush_req_.load(std::memory_order_acquire);
+    if (rings_gen_.load(std::memory_order_acquire) != gen) {
+      std::lock_guard<std::mutex> lk(rings_mu_);
+      gen = rings_gen_.load(std::memory_order_relaxed);
+      rings = rings_;
+    }
+    out.set_fd(fd_.load(std::memory_order_relaxed));
+
+    uint64_t records = 0, dropped = 0;
+    bool reap = false;
+    for (detail::LogRing* r : rings) {
+      // Read orphaned before tail: a ring found orphaned and empty is done
+      bool orphaned = r->orphaned.load(std::memory_order_acquire);
+      uint64_t h = r->head.load(std::memory_order_relaxed);
+      const uint64_t t = r->tail.load(std::memory_order_acquire);
+      while (h < t) {
+        const char* p = r->buf.get() + (h & (kRingBytes - 1));
+        uint32_t size; std::memcpy(&size, p, sizeof(size));
+        if ((uint8_t)p[offsetof(RecordHead, kind)] == kKindPad) { h += size; continue; }
+        RecordHead rh; std::memcpy(&rh, p, sizeof(rh));
+
+        const int64_t wall = system_base_ns_ + (int64_t)(rh.ts_ns - steady_base_ns_);
+        const int64_t sec = wall / 1000000000;
+        if (sec != tm_sec) {
+          std::time_t tt = (std::time_t)sec;
+          localtime_r(&tt, &tm);
+          tm_sec = sec;
+        }
+        std::string& line = out.line();
+        char stamp[48];
+        int n = std::snprintf(stamp, sizeof(stamp), "%02d:%02d:%02d.%06lld [%s] ", tm.tm_hour, tm.tm_min, tm.tm_sec,
+                              (long long)((wall % 1000000000) / 1000), level_name(rh.level));
+        line.append(stamp, (size_t)n);
+
+        // Expand {} from the encoded arguments; extras go at the end
+        const char* ap = p + sizeof(RecordHead);
+        unsigned used = 0;
+        auto next_arg = [&] {
+          ArgHead ah; std::memcpy(&ah, ap, sizeof(ah));
+          append_arg(line, ah, ap + sizeof(ah));
+          ap += sizeof(ah) + pad8(ah.len);
+          used++;
+        };
+        for (const char* f = rh.fmt; *f; f++) {
+          if (f[0] == '{' && f[1] == '}' && used < rh.nargs) { next_arg(); f++; }
+          else line.push_back(*f);
+        }
+        while (used < rh.nargs) { line.push_back(' '); next_arg(); }
+        line.push_back('\n');
+        h += size;
+        records++;
+      }
+      r->head.store(h, std::memory_order_release);
+      uint64_t d = r->dropped.load(std::memory_order_relaxed);
+      dropped += d - r->dropped_seen;
+      r->dropped_seen = d;
+      if (orphaned && h == t) reap = true;
+    }
+    if (dropped) {
+      char msg[96];
+      int n = std::snprintf(msg, sizeof(msg), "[kcoro_cpp] logger dropped %llu records (ring full)\n", (unsigned long long)dropped);
+      out.line().append(msg, (size_t)n);
+      dropped_.fetch_add(dropped, std::memory_order_relaxed);
+    }
+    out.write_out();
+    written_.fetch_add(records, std::memory_order_relaxed);
+
+    if (reap) {
+      std::lock_guard<std::mutex> lk(rings_mu_);
+      for (auto it = rings_.begin(); it != rings_.end();) {
+        detail::LogRing* r = *it;
+        if (r->orphaned.load(std::memory_order_acquire) &&
+            r->head.load(std::memory_order_relaxed) == r->tail.load(std::memory_order_acquire) &&
+            r->dropped.load(std::memory_order_relaxed) == r->dropped_seen) {
+          it = rings_.erase(it);
+          delete r;
+        } else {
+          ++it;
+        }
+      }
+      rings_gen_.fetch_add(1, std::memory_order_release);
+    }
+
+    {
+      std::unique_lock<std::mutex> lk(mu_);
+      if (flush_done_ < req) { flush_done_ = req; done_cv_.notify_all(); }
+      if (records == 0 && flush_req_.load(std::memory_order_acquire) == req) {
+        writer_sleeping_.store(true, std::memory_order_relaxed);
+        wake_cv_.wait_for(lk, std::chrono::milliseconds(10));
+        writer_sleeping_.store(false, std::memory_order_relaxed);
       }
-      continue;
     }
-    if (rc == KC_EPIPE) break;
-    if (draining_.load(std::memory_order_acquire) && chan_->size() == 0) break;
   }
 }
 
@@ -11,26 +11,26 @@ inline uint64_t steady_now_ns() {
 }
 
 thread_local kcoro_cpp::WorkStealingScheduler* tls_current_sched = nullptr;
+thread_local int tls_worker_id = -1; // index into workers_ of tls_current_sched
+
+// Local deque depth past which worker spawns go to the inject queue instead.
+constexpr size_t kDonateThreshold = 64;
+// Finished coroutines (and their stacks) kept per worker for reuse.
+constexpr unsigned kCoPoolMax = 32;
 
 std::mutex g_default_sched_mu;
 kcoro_cpp::WorkStealingScheduler* g_default_sched = nullptr;
 }
 
 namespace kcoro_cpp {
-WorkStealingScheduler::WorkStealingScheduler(int workers) {
+WorkStealingScheduler::WorkStealingScheduler(int workers, int bulk_share, SchedulerHost host) : host_(host) {
+  bulk_share_ = (bulk_share > 0) ? bulk_share : 16;
   int hw = std::max(1, (int)std::thread::hardware_concurrency());
   int n = (workers <= 0) ? hw : workers;
-  deques_.reserve(n);
-  for (int i = 0; i < n; ++i) deques_.emplace_back(std::make_unique<Deque>());
-  // init per-worker last_task fast-path
-  last_task_.assign(n, nullptr);
-  last_task_mu_.clear(); last_task_mu_.reserve(n);
-  for (int i=0;i<n;++i) last_task_mu_.emplace_back(std::make_unique<std::mutex>());
-  // init inject ring
-  {
-    std::lock_guard<std::mutex> lk(inject_.mu);
-    inject_.cap = 2048; inject_.buf.resize(inject_.cap); inject_.head = inject_.tail = 0;
-  }
+  workers_.reserve(n);
+  const uint64_t now = steady_now_ns();
+  for (int i = 0; i < n; ++i) workers_.emplace_back(std::make_unique<Worker>((uint32_t)i, now));
+  if (hosted()) return; // the host's threads run the slots through poll()
   for (int i = 0; i < n; ++i) threads_.emplace_back([this, i]{ worker_loop(i); });
 }
 
@@ -38,132 +38,393 @@ WorkStealingScheduler::~WorkStealingScheduler() {
   stop_and_join();
 }
 
+int WorkStealingScheduler::self_worker() const {
+  return (tls_current_sched == this) ? tls_worker_id : -1;
+}
+
+// Workers park on park_cv_ only after bumping idle_ and re-checking for work
+// under park_mu_; taking park_mu_ here before notifying closes the window
+// between that check and the wait. Nobody idle => no lock, no syscall.
+void WorkStealingScheduler::wake_one() {
+  if (host_.notify) { host_.notify(host_.ctx); return; }
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (idle_.load(std::memory_order_relaxed) == 0) return;
+  { std::lock_guard<std::mutex> lk(park_mu_); }
+  park_cv_.notify_one();
+}
+
 void WorkStealingScheduler::spawn(void (*fn)(void*), void* arg, size_t) {
-  if (stop_.load()) return;
+  if (stop_.load(std::memory_order_relaxed)) return;
   Task t{fn, arg
 #ifdef KCORO_CPP_CTX_DIAGNOSTICS
     ,0xC0A1FACE, 0
 #endif
   };
-  static std::atomic<int> rr{0};
-  int idx = rr.fetch_add(1) % (int)deques_.size();
-  // Try last_task fast path; else inject queue; else fallback to deque
-  bool fast = false;
-  {
-    std::lock_guard<std::mutex> lk(*last_task_mu_[idx]);
-    if (last_task_[idx] == nullptr) { last_task_[idx] = new Task(t); fast = true; }
-  }
-  if (fast) {
-    ++stat_fastpath_hits_;
+  int self = self_worker();
+  if (self >= 0) {
+    // Own deque (owner end of Chase-Lev); donate to inject once it is deep
+    Worker& w = *workers_[self];
+    if (w.dq.size_approx() > kDonateThreshold) inject_.push(t); else w.dq.push(t);
+    bump(w.ctr.tasks_submitted, true);
+    bump(w.ctr.lane_submitted[(int)Lane::Interactive], true);
   } else {
-    ++stat_fastpath_misses_;
-    if (!inject_push(t)) {
-      std::lock_guard<std::mutex> lg(deques_[idx]->mu);
-      deques_[idx]->q.emplace_back(t);
+    // Other threads may not touch a deque's bottom: offer the task through a
+    // worker's last-task slot, else the inject queue. Hosted slots are only
+    // run while polled, so their tasks go to inject where any poll sees them.
+    static std::atomic<unsigned> rr{0};
+    unsigned idx = rr.fetch_add(1, std::memory_order_relaxed) % (unsigned)workers_.size();
+    if (!hosted() && workers_[idx]->last_task.offer(t)) {
+      bump(ext_ctr_.fastpath_hits, false);
+    } else {
+      bump(ext_ctr_.fastpath_misses, false);
+      inject_.push(t);
     }
+    bump(ext_ctr_.tasks_submitted, false);
+    bump(ext_ctr_.lane_submitted[(int)Lane::Interactive], false);
   }
-  park_cv_.notify_one();
-  ++stat_tasks_submitted_;
+  wake_one();
 }
 
-void WorkStealingScheduler::spawn_co(Coroutine::Fn fn, void* arg, size_t stack_bytes) {
-  // Encapsulate: create coroutine and schedule a small task that resumes it.
-  Coroutine* co = new Coroutine(fn, arg, stack_bytes);
+void WorkStealingScheduler::spawn_lane(void (*fn)(void*), void* arg, Lane lane) {
+  if (lane != Lane::Bulk) { spawn(fn, arg); return; }
+  if (stop_.load(std::memory_order_relaxed)) return;
+  Task t{fn, arg
+#ifdef KCORO_CPP_CTX_DIAGNOSTICS
+    ,0xC0A1FACE, 0
+#endif
+  };
+  // Bulk tasks bypass the fast path and deques: only the bulk queue feeds them.
+  bulk_.push(t);
+  bool own;
+  Counters& c = counters(own);
+  bump(c.tasks_submitted, own);
+  bump(c.lane_submitted[(int)Lane::Bulk], own);
+  wake_one();
+}
+
+Coroutine* WorkStealingScheduler::spawn_co(Coroutine::Fn fn, void* arg, size_t stack_bytes, Lane lane,
+                                           std::pmr::memory_resource* mr) {
+  if (mr) {
+    void* mem = mr->allocate(sizeof(Coroutine), alignof(Coroutine));
+    Coroutine* co;
+    try { co = ::new (mem) Coroutine(fn, arg, stack_bytes); }
+    catch (...) { mr->deallocate(mem, sizeof(Coroutine), alignof(Coroutine)); throw; }
+    co->mr_ = mr;
+    bool own;
+    Counters& c = counters(own);
+    bump(c.co_created, own);
+    co->set_lane(lane);
+    enqueue_ready(co);
+    return co;
+  }
+  // On a worker, restart a pooled coroutine in place (no allocation, stack
+  // kept); elsewhere, or with an empty pool, allocate.
+  Coroutine* co = nullptr;
+  int self = self_worker();
+  if (self >= 0) {
+    Worker& w = *workers_[self];
+    if (!w.pool && w.retired_head) reclaim(w);
+    if ((co = w.pool)) {
+      w.pool = co->pool_next_; --w.pool_n;
+      co->pool_next_ = nullptr;
+      if (co->reuse(fn, arg, stack_bytes)) bump(w.ctr.co_reused, true);
+      else { delete co; co = nullptr; }
+    }
+  }
+  if (!co) {
+    co = new Coroutine(fn, arg, stack_bytes);
+    bump(self >= 0 ? workers_[self]->ctr.co_created : ext_ctr_.co_created, self >= 0);
+  }
+  co->set_lane(lane);
   enqueue_ready(co);
+  return co;
 }
 
 void WorkStealingScheduler::enqueue_ready(ICoroutineContext* co) {
-  if (stop_.load()) return;
+  enqueue_ready(co, Lane::Inherit);
+}
+
+void WorkStealingScheduler::enqueue_ready(ICoroutineContext* co, Lane lane) {
+  if (stop_.load(std::memory_order_relaxed)) return;
   auto* c = dynamic_cast<Coroutine*>(co);
   if (!c) throw Error("enqueue_ready expects kcoro_cpp::Coroutine");
-  ready_push_tail(c);
-  park_cv_.notify_one();
-  ++stat_ready_enq_;
+  if (lane != Lane::Interactive && lane != Lane::Bulk) lane = c->lane();
+  // avoid double-enqueue: exactly one concurrent waker claims it
+  bool expected = false;
+  if (!c->ready_enqueued_.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) return;
+  ready_push(c, lane);
+  bool own;
+  Counters& ctr = counters(own);
+  bump(ctr.ready_enq, own);
+  bump(ctr.lane_submitted[(int)lane], own);
+  wake_one();
+}
+
+WorkStealingScheduler::Counters& WorkStealingScheduler::counters(bool& owned) {
+  int self = self_worker();
+  owned = self >= 0;
+  return owned ? workers_[self]->ctr : ext_ctr_;
+}
+
+WorkStealingScheduler::LaneStats WorkStealingScheduler::lane_stats() const {
+  LaneStats st;
+  auto add = [&](const Counters& c) {
+    for (int l = 0; l < kLaneCount; ++l) {
+      st.submitted[l] += c.lane_submitted[l].load(std::memory_order_relaxed);
+      st.run[l] += c.run[l].load(std::memory_order_relaxed);
+    }
+    st.bulk_forced += c.bulk_forced.load(std::memory_order_relaxed);
+  };
+  add(ext_ctr_);
+  for (auto& w : workers_) add(w->ctr);
+  return st;
+}
+
+WorkStealingScheduler::Stats WorkStealingScheduler::stats() const {
+  Stats st;
+  auto add = [&](const Counters& c) {
+    st.tasks_submitted += c.tasks_submitted.load(std::memory_order_relaxed);
+    st.ready_enqueued += c.ready_enq.load(std::memory_order_relaxed);
+    st.ready_local += c.ready_local.load(std::memory_order_relaxed);
+    st.ready_global += c.ready_global.load(std::memory_order_relaxed);
+    st.fastpath_hits += c.fastpath_hits.load(std::memory_order_relaxed);
+    st.fastpath_misses += c.fastpath_misses.load(std::memory_order_relaxed);
+    st.coroutines_created += c.co_created.load(std::memory_order_relaxed);
+    st.tasks_completed += c.completed.load(std::memory_order_relaxed);
+    st.steals += c.steals.load(std::memory_order_relaxed);
+    st.steal_probes += c.steal_probes.load(std::memory_order_relaxed);
+    st.steal_failures += c.steal_failures.load(std::memory_order_relaxed);
+    st.inject_pulls += c.inject_pulls.load(std::memory_order_relaxed);
+    st.parks += c.parks.load(std::memory_order_relaxed);
+    st.coroutines_reused += c.co_reused.load(std::memory_order_relaxed);
+  };
+  add(ext_ctr_);
+  for (auto& w : workers_) add(w->ctr);
+  return st;
+}
+
+void WorkStealingScheduler::run_task(Worker& w, const Task& t, Lane lane) {
+#ifdef KCORO_CPP_CTX_DIAGNOSTICS
+  if (t.magic != 0xC0A1FACE) { fprintf(stderr, "[kcoro_cpp][TASK][FATAL] bad magic t=%p magic=%x\n", (void*)&t, t.magic); abort(); }
+  if (!t.fn) { fprintf(stderr, "[kcoro_cpp][TASK][FATAL] null fn\n"); abort(); }
+#endif
+  bump(w.ctr.run[(int)lane], true);
+  t.fn(t.arg);
+  bump(w.ctr.completed, true);
 }
 
+void WorkStealingScheduler::run_ready(Worker& w, Coroutine* co, Lane lane) {
+  if (co->is_finished()) {
+    // Late wake of a coroutine that finished meanwhile; it sits on a retire
+    // list, which cannot reuse it until this entry's claim is dropped
+    co->ready_enqueued_.store(false, std::memory_order_release);
+    return;
+  }
+  co->ready_enqueued_.store(false, std::memory_order_release);
+  bump(w.ctr.run[(int)lane], true);
+  co->resume();
+  if (!co->is_parked() && co->is_finished()) retire(w, co);
+}
+
+// Queue a coroutine that just finished on this worker for reuse.
+void WorkStealingScheduler::retire(Worker& w, Coroutine* co) {
+  co->timer_.disarm();
+  if (co->mr_) resource_retired_.fetch_add(1, std::memory_order_relaxed);
+  co->retire_epoch_ = epoch_.load(std::memory_order_acquire);
+  co->pool_next_ = nullptr;
+  if (w.retired_tail) w.retired_tail->pool_next_ = co; else w.retired_head = co;
+  w.retired_tail = co;
+}
+
+// The epoch advances once every active worker has seen the current one.
+bool WorkStealingScheduler::try_advance_epoch() {
+  uint64_t e = epoch_.load(std::memory_order_acquire);
+  for (auto& w : workers_) {
+    uint64_t seen = w->epoch.load(std::memory_order_acquire);
+    if (seen != 0 && seen != e) return false;
+  }
+  return epoch_.compare_exchange_strong(e, e + 1, std::memory_order_acq_rel);
+}
+
+// Move retired coroutines past their grace period into the pool. Claiming
+// ready_enqueued_ keeps waker races out for good: enqueue_ready refuses a
+// pooled coroutine until reuse() clears the flag. A coroutine that still has
+// a late wake queued goes to the back of the list for another round.
+void WorkStealingScheduler::reclaim(Worker& w) {
+  try_advance_epoch();
+  const uint64_t e = epoch_.load(std::memory_order_acquire);
+  while (Coroutine* co = w.retired_head) {
+    if (co->retire_epoch_ + 2 > e) break;
+    w.retired_head = co->pool_next_;
+    if (!w.retired_head) w.retired_tail = nullptr;
+    co->pool_next_ = nullptr;
+    bool expected = false;
+    if (!co->ready_enqueued_.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+      co->retire_epoch_ = e;
+      if (w.retired_tail) w.retired_tail->pool_next_ = co; else w.retired_head = co;
+      w.retired_tail = co;
+      continue;
+    }
+    if (!co->mr_ && w.pool_n < kCoPoolMax) { co->pool_next_ = w.pool; w.pool = co; ++w.pool_n; }
+    else free_coroutine(co);
+  }
+}
+
+void WorkStealingScheduler::free_coroutine(Coroutine* co) {
+  if (std::pmr::memory_resource* mr = co->mr_) {
+    co->~Coroutine();
+    mr->deallocate(co, sizeof(Coroutine), alignof(Coroutine));
+    resource_retired_.fetch_sub(1, std::memory_order_release);
+  } else {
+    delete co;
+  }
+}
+
+// Run one bulk coroutine or task; false when the bulk lane is empty.
+bool WorkStealingScheduler::run_bulk(Worker& w) {
+  Coroutine* co = nullptr;
+  if (ready_bulk_.try_pop(co)) { run_ready(w, co, Lane::Bulk); return true; }
+  Task t{};
+  if (!bulk_.try_pop(t)) return false;
+  run_task(w, t, Lane::Bulk);
+  return true;
+}
+
+// Scan every other worker once, starting next to `self`; a lost CAS retries
+// the same victim.
 bool WorkStealingScheduler::try_steal(int self, Task& out) {
-  int n = (int)deques_.size();
-  for (int k = 1; k < std::min(n, 4); ++k) {
-    int victim = (self + k) % n;
-    std::lock_guard<std::mutex> lg(deques_[victim]->mu);
-    auto& dq = deques_[victim]->q;
-    if (!dq.empty()) { out = dq.front(); dq.pop_front(); return true; }
-    ++stat_steals_probes_;
+  Worker& me = *workers_[self];
+  int n = (int)workers_.size();
+  for (int k = 1; k < n; ++k) {
+    detail::TaskDeque& dq = workers_[(self + k) % n]->dq;
+    bump(me.ctr.steal_probes, true);
+    detail::TaskDeque::StealResult r;
+    while ((r = dq.steal(out)) == detail::TaskDeque::kAbort) {}
+    if (r == detail::TaskDeque::kOk) return true;
   }
-  ++stat_steals_failures_;
+  if (n > 1) bump(me.ctr.steal_failures, true);
+  return false;
+}
+
+bool WorkStealingScheduler::steal_ready(int self, Coroutine*& out) {
+  int n = (int)workers_.size();
+  for (int k = 1; k < n; ++k)
+    if (workers_[(self + k) % n]->ready.try_pop(out)) return true;
   return false;
 }
 
+// One turn of the worker loop: the first source that has something runs it.
+bool WorkStealingScheduler::run_once(Worker& w, int id) {
+  // Quiescent point: no task holds a coroutine pointer across it
+  const uint64_t e = epoch_.load(std::memory_order_acquire);
+  if (w.epoch.load(std::memory_order_relaxed) != e) w.epoch.store(e);
+  if (w.retired_head && (w.tick & 15) == 0) reclaim(w);
+
+  // 0) Bulk gets one turn in bulk_share even while interactive work waits
+  if (++w.tick % (unsigned)bulk_share_ == 0 && run_bulk(w)) { bump(w.ctr.bulk_forced, true); return true; }
+
+  // Due timers first: their wakes land on this worker's ring
+  if (w.timers.pending()) w.timers.expire(steady_now_ns());
+
+  // 1) Ready coroutines: own ring, then wakes from other threads
+  Coroutine* co = nullptr;
+  if (w.ready.try_pop(co) || ready_global_.try_pop(co)) { run_ready(w, co, Lane::Interactive); return true; }
+
+  // 2) Local tasks, then the last-task slot
+  Task t{};
+  if (w.dq.pop(t) || w.last_task.take(t)) { run_task(w, t, Lane::Interactive); return true; }
+
+  // 3) Steal: ready coroutines first, then tasks
+  if (steal_ready(id, co)) { bump(w.ctr.steals, true); run_ready(w, co, Lane::Interactive); return true; }
+  if (try_steal(id, t)) { bump(w.ctr.steals, true); run_task(w, t, Lane::Interactive); return true; }
+
+  // 4) Inject queue
+  if (inject_.try_pop(t)) { bump(w.ctr.inject_pulls, true); run_task(w, t, Lane::Interactive); return true; }
+
+  // 5) Nothing interactive left: bulk
+  return run_bulk(w);
+}
+
 void WorkStealingScheduler::worker_loop(int id) {
   tls_current_sched = this;
+  tls_worker_id = id;
   // Ensure this worker thread has a bootstrap main coroutine for parking/resume
   Coroutine::ensure_main();
-  while (!stop_.load()) {
-    // 1) Ready coroutines
-    Coroutine* co = ready_pop_head();
-    if (co) {
-      co->resume();
-      if (!co->is_parked() && co->is_finished()) { retire_maybe(co); }
-      continue;
-    }
-
-    // 2) Local tasks
-    Task t{}; bool have=false;
+  Worker& w = *workers_[id];
+  while (!stop_.load(std::memory_order_relaxed)) {
+    if (run_once(w, id)) continue;
+
+    // 6) Park: advertise, re-check, then sleep (see wake_one). The timeout
+    // only covers a worker's own last-task slot, which wake_one may not pick.
+    if (w.retired_head) reclaim(w);
+    w.epoch.store(0); // parked workers do not hold back reclamation
+    idle_.fetch_add(1, std::memory_order_seq_cst);
     {
-      std::lock_guard<std::mutex> lg(deques_[id]->mu);
-      auto& dq = deques_[id]->q; if (!dq.empty()) { t = dq.back(); dq.pop_back(); have=true; }
+      std::unique_lock<std::mutex> lk(park_mu_);
+      if (!has_work() && !stop_.load()) {
+        bump(w.ctr.parks, true);
+        park_cv_.wait_for(lk, std::chrono::milliseconds(1));
+      }
     }
-    if (have) {
-#ifdef KCORO_CPP_CTX_DIAGNOSTICS
-  if (t.magic != 0xC0A1FACE) { fprintf(stderr, "[kcoro_cpp][TASK][FATAL] bad magic local deque t=%p magic=%x\n", (void*)&t, t.magic); abort(); }
-  if (!t.fn) { fprintf(stderr, "[kcoro_cpp][TASK][FATAL] null fn local deque\n"); abort(); }
-#endif
-  t.fn(t.arg); ++stat_tasks_completed_; continue; }
-
-    // 2b) Per-worker fast-path
-    Task* lt = nullptr;
-    { std::lock_guard<std::mutex> lk(*last_task_mu_[id]); lt = last_task_[id]; last_task_[id] = nullptr; }
-    if (lt) { Task tmp = *lt; delete lt;
-#ifdef KCORO_CPP_CTX_DIAGNOSTICS
-  if (tmp.magic != 0xC0A1FACE) { fprintf(stderr, "[kcoro_cpp][TASK][FATAL] bad magic fastpath tmp=%p magic=%x\n", (void*)&tmp, tmp.magic); abort(); }
-  if (!tmp.fn) { fprintf(stderr, "[kcoro_cpp][TASK][FATAL] null fn fastpath\n"); abort(); }
-#endif
-  tmp.fn(tmp.arg); ++stat_tasks_completed_; continue; }
-
-    // 3) Steal
-    if (try_steal(id, t)) { ++stat_steals_;
-#ifdef KCORO_CPP_CTX_DIAGNOSTICS
-  if (t.magic != 0xC0A1FACE) { fprintf(stderr, "[kcoro_cpp][TASK][FATAL] bad magic stolen task=%p magic=%x\n", (void*)&t, t.magic); abort(); }
-  if (!t.fn) { fprintf(stderr, "[kcoro_cpp][TASK][FATAL] null fn stolen\n"); abort(); }
-#endif
-  t.fn(t.arg); ++stat_tasks_completed_; continue; }
-
-    // 4) Inject queue
-    if (inject_pop(t)) {
-#ifdef KCORO_CPP_CTX_DIAGNOSTICS
-  if (t.magic != 0xC0A1FACE) { fprintf(stderr, "[kcoro_cpp][TASK][FATAL] bad magic inject t=%p magic=%x\n", (void*)&t, t.magic); abort(); }
-  if (!t.fn) { fprintf(stderr, "[kcoro_cpp][TASK][FATAL] null fn inject\n"); abort(); }
-#endif
-  t.fn(t.arg); ++stat_tasks_completed_; continue; }
+    idle_.fetch_sub(1, std::memory_order_relaxed);
+  }
+  tls_worker_id = -1;
+  tls_current_sched = nullptr;
+}
 
-    // 5) Park briefly
-    std::unique_lock<std::mutex> lk(park_mu_);
-    park_cv_.wait_for(lk, std::chrono::milliseconds(1));
+// A host thread borrows one slot for up to `budget` turns. The slot's
+// deque, ring and wheel keep their single owner through the polling flag.
+int WorkStealingScheduler::poll(int hint, int budget) {
+  if (!hosted() || budget <= 0 || tls_current_sched || stop_.load(std::memory_order_relaxed)) return 0;
+  const int n = (int)workers_.size();
+  int id = -1;
+  for (int k = 0; k < n && id < 0; ++k) {
+    int i = (int)(((unsigned)std::max(hint, 0) + (unsigned)k) % (unsigned)n);
+    if (!workers_[i]->polling.exchange(true, std::memory_order_acquire)) id = i;
+  }
+  if (id < 0) return 0;
+  tls_current_sched = this;
+  // Timers armed on slots nobody polls now fire here, each under its slot
+  const uint64_t now = steady_now_ns();
+  for (int j = 0; j < n; ++j) {
+    Worker& o = *workers_[j];
+    if (j == id || !o.timers.pending() || o.polling.exchange(true, std::memory_order_acquire)) continue;
+    tls_worker_id = j;
+    o.timers.expire(now);
+    o.polling.store(false, std::memory_order_release);
   }
+  tls_worker_id = id;
+  Coroutine::ensure_main();
+  Worker& w = *workers_[id];
+  int ran = 0;
+  while (ran < budget && run_once(w, id)) ++ran;
+  if (w.retired_head) reclaim(w);
+  w.epoch.store(0); // an unpolled slot does not hold back reclamation
+  tls_worker_id = -1;
   tls_current_sched = nullptr;
+  w.polling.store(false, std::memory_order_release);
+  return ran;
+}
+
+uint64_t WorkStealingScheduler::next_timer_ns() const {
+  for (auto& w : workers_)
+    if (w->timers.pending()) return steady_now_ns() + 1000000ULL;
+  return 0;
+}
+
+// Cheap, racy check used right before parking and by drain().
+bool WorkStealingScheduler::has_work() const {
+  if (!ready_empty() || !inject_.empty_approx() || !bulk_.empty_approx()) return true;
+  for (auto& w : workers_) if (w->dq.size_approx() || !w->last_task.empty_approx()) return true;
+  return false;
 }
 
 void WorkStealingScheduler::drain(long timeout_ms) {
   using namespace std::chrono;
   auto deadline = (timeout_ms < 0) ? time_point<steady_clock>::max() : steady_clock::now() + milliseconds(timeout_ms);
   for (;;) {
-    bool empty_ready, empty_all=true;
-    { std::lock_guard<std::mutex> lg(ready_.mu); empty_ready = (ready_.head==nullptr); }
-    for (auto& d : deques_) {
-      std::lock_guard<std::mutex> lg(d->mu);
-      if (!d->q.empty()) { empty_all=false; break; }
-    }
-    if (empty_ready && empty_all) return;
+    // Also wait for resource-backed coroutines to hand their memory back
+    if (!has_work() && resource_retired_.load(std::memory_order_acquire) == 0) return;
     if (steady_clock::now() > deadline) return;
     std::this_thread::sleep_for(std::chrono::milliseconds(2));
   }
@@ -180,9 +441,12 @@ void WorkStealingScheduler::wake_after(ICoroutineContext* co, long delay_ms) {
   if (stop_.load()) return;
   auto* coroutine = dynamic_cast<Coroutine*>(co);
   if (!coroutine) throw Error("wake_after expects kcoro_cpp::Coroutine");
-  schedule_timer_after(delay_ms, [this, coroutine]() {
-    enqueue_ready(coroutine);
-  });
+  // The node is embedded in the coroutine: re-arming moves its one pending wake
+  detail::TimerNode& n = coroutine->timer_;
+  n.fire = [](void* c) { if (auto* s = sched_current()) s->enqueue_ready(static_cast<Coroutine*>(c)); };
+  n.ctx = coroutine;
+  timer_wheel().arm(&n, deadline_after(delay_ms));
+  if (hosted()) wake_one(); // the host parks by next_timer_ns()
 }
 
 void WorkStealingScheduler::sleep_ms(long delay_ms) {
@@ -192,188 +456,87 @@ void WorkStealingScheduler::sleep_ms(long delay_ms) {
   cur->park();
 }
 
-WorkStealingScheduler::TimerHandle
-WorkStealingScheduler::schedule_timer_at(uint64_t deadline_ns, TimerCallback cb) {
-  if (!cb || stop_.load()) return {};
-  ensure_timer_started();
-  auto item = std::make_shared<TimerItem>();
-  item->when_ns = deadline_ns;
-  item->cb = std::move(cb);
-  item->id = next_timer_id_.fetch_add(1, std::memory_order_relaxed);
-  {
-    std::lock_guard<std::mutex> lk(timer_mu_);
-    timer_map_[item->id] = item;
-    timer_queue_.push(item);
-    timer_cv_.notify_all();
-  }
-  return TimerHandle{item->id};
+void WorkStealingScheduler::resume_async(std::coroutine_handle<> h, Lane lane) {
+  spawn_lane([](void* a) { std::coroutine_handle<>::from_address(a).resume(); }, h.address(), lane);
+}
+
+void WorkStealingScheduler::SleepAwaiter::await_suspend(std::coroutine_handle<> h) const {
+  if (delay_ms <= 0) { sched->resume_async(h); return; }
+  auto* s = sched;
+  s->schedule_timer_after(delay_ms, [s, h]() { s->resume_async(h); });
 }
 
-WorkStealingScheduler::TimerHandle
-WorkStealingScheduler::schedule_timer_after(long delay_ms, TimerCallback cb) {
-  if (!cb || stop_.load()) return {};
+uint64_t WorkStealingScheduler::deadline_after(long delay_ms) {
   uint64_t when = steady_now_ns();
   if (delay_ms > 0) when += static_cast<uint64_t>(delay_ms) * 1000000ULL;
-  return schedule_timer_at(when, std::move(cb));
+  return when;
 }
 
-bool WorkStealingScheduler::cancel_timer(TimerHandle handle) {
-  if (!handle.valid()) return false;
-  std::lock_guard<std::mutex> lk(timer_mu_);
-  auto it = timer_map_.find(handle.id);
-  if (it == timer_map_.end()) return false;
-  it->second->cancelled.store(true, std::memory_order_release);
-  timer_cv_.notify_all();
-  return true;
+detail::TimerWheel& WorkStealingScheduler::timer_wheel() {
+  int self = self_worker();
+  if (self >= 0) return workers_[self]->timers;
+  static std::atomic<unsigned> rr{0};
+  return workers_[rr.fetch_add(1, std::memory_order_relaxed) % (unsigned)workers_.size()]->timers;
 }
 
-void WorkStealingScheduler::timer_loop() {
-  for (;;) {
-    std::shared_ptr<TimerItem> item;
-    {
-      std::unique_lock<std::mutex> lk(timer_mu_);
-      auto fetch_next = [&]() -> std::shared_ptr<TimerItem> {
-        for (;;) {
-          if (stop_.load()) return nullptr;
-          if (timer_queue_.empty()) {
-            timer_cv_.wait(lk);
-            continue;
-          }
-          auto top = timer_queue_.top();
-          if (top->cancelled.load(std::memory_order_acquire)) {
-            timer_queue_.pop();
-            timer_map_.erase(top->id);
-            continue;
-          }
-          uint64_t now = steady_now_ns();
-          if (top->when_ns > now) {
-            timer_cv_.wait_for(lk, std::chrono::nanoseconds(top->when_ns - now));
-            continue;
-          }
-          timer_queue_.pop();
-          timer_map_.erase(top->id);
-          return top;
-        }
-      };
-      item = fetch_next();
-      if (!item && stop_.load()) break;
-    }
-    if (!item) continue;
-    if (!item->cancelled.load(std::memory_order_acquire)) {
-      item->cb();
-    }
-  }
+bool WorkStealingScheduler::cancel_timer(TimerHandle handle) {
+  if (!handle.valid()) return false;
+  uint32_t w = detail::TimerWheel::id_wheel(handle.id);
+  if (w >= workers_.size()) return false;
+  return workers_[w]->timers.cancel_id(handle.id);
 }
 
 void WorkStealingScheduler::stop_and_join() {
   if (stop_.exchange(true)) return; // already stopped
   park_cv_.notify_all();
-  if (timer_started_.load()) {
-    std::lock_guard<std::mutex> lk(timer_mu_);
-    timer_cv_.notify_all();
-  }
   for (auto& t : threads_) if (t.joinable()) t.join();
-  if (timer_started_.load() && timer_thread_.joinable()) timer_thread_.join();
-  {
-    std::lock_guard<std::mutex> lk(timer_mu_);
-    timer_map_.clear();
-    timer_queue_ = decltype(timer_queue_)();
-  }
+  // Pending timers stay on the wheels and are dropped with the workers
   // Drain ready list nodes
   drain_ready_list();
-  // Delete retired coroutines
-  {
-    std::lock_guard<std::mutex> lk(retire_mu_);
-    for (auto* c : retire_) delete c; retire_.clear(); retire_set_.clear();
-  }
-}
-
-void WorkStealingScheduler::ensure_timer_started() {
-  bool expected = false;
-  if (timer_started_.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
-    timer_thread_ = std::thread([this]{ timer_loop(); });
-  }
+  free_coroutines();
 }
 
-bool WorkStealingScheduler::inject_push(const Task& t) {
-  std::lock_guard<std::mutex> lk(inject_.mu);
-  if (inject_.cap == 0) { inject_.cap = 2048; inject_.buf.resize(inject_.cap); inject_.head = inject_.tail = 0; }
-  uint32_t next = (inject_.tail + 1) % inject_.cap;
-  if (next == inject_.head) {
-    inject_grow_locked(inject_.cap * 2);
-    next = (inject_.tail + 1) % inject_.cap;
-  }
-  inject_.buf[inject_.tail] = t; inject_.tail = next; return true;
-}
-
-bool WorkStealingScheduler::inject_pop(Task& out) {
-  std::lock_guard<std::mutex> lk(inject_.mu);
-  if (inject_.cap == 0 || inject_.head == inject_.tail) return false;
-  out = inject_.buf[inject_.head];
-  inject_.head = (inject_.head + 1) % inject_.cap;
-  return true;
-}
-
-void WorkStealingScheduler::inject_grow_locked(uint32_t new_cap) {
-  if (new_cap <= inject_.cap) return;
-  std::vector<Task> nb(new_cap);
-  uint32_t i = 0, h = inject_.head;
-  while (h != inject_.tail) { nb[i++] = inject_.buf[h]; h = (h + 1) % inject_.cap; }
-  inject_.buf.swap(nb);
-  inject_.cap = new_cap; inject_.head = 0; inject_.tail = i;
-}
-
-void WorkStealingScheduler::retire_maybe(Coroutine* co) {
-  if (!co) return;
-  std::lock_guard<std::mutex> lk(retire_mu_);
-  if (retire_set_.insert(co).second) {
-    retire_.push_back(co);
+// After join: finished coroutines, retired or pooled, belong to nobody else.
+void WorkStealingScheduler::free_coroutines() {
+  for (auto& w : workers_) {
+    for (Coroutine* list : {w->retired_head, w->pool}) {
+      while (list) { Coroutine* next = list->pool_next_; free_coroutine(list); list = next; }
+    }
+    w->retired_head = w->retired_tail = w->pool = nullptr;
+    w->pool_n = 0;
   }
 }
 
 void WorkStealingScheduler::drain_ready_list() {
-  for (;;) {
-    Coroutine* c = nullptr;
-    {
-      std::lock_guard<std::mutex> lg(ready_.mu);
-      c = ready_.head; if (!c) break; ready_.head = c->next_ready_; if (!ready_.head) ready_.tail = nullptr; c->next_ready_ = nullptr; c->ready_enqueued_ = false; --ready_.size;
-    }
-    (void)c; // coroutine lifetime managed elsewhere
+  Coroutine* c = nullptr;
+  // coroutine lifetime managed elsewhere
+  for (auto& w : workers_) while (w->ready.try_pop(c)) c->ready_enqueued_.store(false);
+  while (ready_global_.try_pop(c)) c->ready_enqueued_.store(false);
+  while (ready_bulk_.try_pop(c)) c->ready_enqueued_.store(false);
+}
+
+// ---------------- Ready queue helpers --------------------
+// Interactive wakes from a worker stay on its ring (thieves drain it too);
+// other threads and full rings use the global queue.
+void WorkStealingScheduler::ready_push(Coroutine* co, Lane lane) {
+  if (lane == Lane::Bulk) { ready_bulk_.push(co); return; }
+  int self = self_worker();
+  if (self >= 0 && workers_[self]->ready.try_push(co)) {
+    bump(workers_[self]->ctr.ready_local, true);
+    return;
   }
+  ready_global_.push(co);
+  bump(self >= 0 ? workers_[self]->ctr.ready_global : ext_ctr_.ready_global, self >= 0);
 }
 
-// ---------------- Ready list helpers (intrusive linked-list FIFO) --------------------
-void WorkStealingScheduler::ready_push_tail(Coroutine* co) {
-  std::lock_guard<std::mutex> lg(ready_.mu);
-  if (co->ready_enqueued_) return; // avoid double-enqueue
-  co->next_ready_ = nullptr;
-  co->ready_enqueued_ = true;
-  if (!ready_.tail) { ready_.head = ready_.tail = co; }
-  else { ready_.tail->next_ready_ = co; ready_.tail = co; }
-  ++ready_.size;
-}
-
-void WorkStealingScheduler::ready_push_front(Coroutine* co) {
-  std::lock_guard<std::mutex> lg(ready_.mu);
-  if (co->ready_enqueued_) return;
-  co->next_ready_ = ready_.head;
-  co->ready_enqueued_ = true;
-  ready_.head = co; if (!ready_.tail) ready_.tail = co; ++ready_.size;
-}
-
-Coroutine* WorkStealingScheduler::ready_pop_head() {
-  std::lock_guard<std::mutex> lg(ready_.mu);
-  Coroutine* c = ready_.head; if (!c) return nullptr;
-  ready_.head = c->next_ready_; if (!ready_.head) ready_.tail = nullptr; c->next_ready_ = nullptr; c->ready_enqueued_ = false; --ready_.size; return c;
-}
-
-bool WorkStealingScheduler::ready_empty() {
-  std::lock_guard<std::mutex> lg(ready_.mu);
-  return ready_.head == nullptr;
+bool WorkStealingScheduler::ready_empty() const {
+  if (!ready_global_.empty_approx() || !ready_bulk_.empty_approx()) return false;
+  for (auto& w : workers_) if (w->ready.size_approx()) return false;
+  return true;
 }
 
 WorkStealingScheduler* sched_init(const SchedulerOptions& opts) {
-  return new WorkStealingScheduler(opts.workers);
+  return new WorkStealingScheduler(opts.workers, opts.bulk_share, opts.host);
 }
 
 void sched_shutdown(WorkStealingScheduler* sched) {
@@ -396,6 +559,13 @@ WorkStealingScheduler* sched_default() {
   return g_default_sched;
 }
 
+bool sched_set_default(WorkStealingScheduler* sched) {
+  std::lock_guard<std::mutex> lk(g_default_sched_mu);
+  if (!sched || g_default_sched) return false;
+  g_default_sched = sched;
+  return true;
+}
+
 WorkStealingScheduler* sched_current() {
   return tls_current_sched;
 }
@@ -412,12 +582,20 @@ int sched_spawn(WorkStealingScheduler* sched, void (*fn)(void*), void* arg) {
 }
 
 int sched_spawn_co(WorkStealingScheduler* sched, Coroutine::Fn fn, void* arg,
-                   size_t stack_bytes, Coroutine** out_co) {
+                   size_t stack_bytes, Coroutine** out_co, Lane lane) {
   auto* target = resolve_sched(sched);
   if (!target || !fn) return -1;
-  auto* co = new Coroutine(fn, arg, stack_bytes);
+  if (lane != Lane::Interactive && lane != Lane::Bulk) return -1;
+  Coroutine* co = target->spawn_co(fn, arg, stack_bytes, lane);
   if (out_co) *out_co = co;
-  target->enqueue_ready(co);
+  return 0;
+}
+
+int sched_spawn_lane(WorkStealingScheduler* sched, void (*fn)(void*), void* arg, Lane lane) {
+  auto* target = resolve_sched(sched);
+  if (!target || !fn) return -1;
+  if (lane != Lane::Interactive && lane != Lane::Bulk) return -1;
+  target->spawn_lane(fn, arg, lane);
   return 0;
 }
 
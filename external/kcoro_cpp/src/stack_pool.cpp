@@ -0,0 +1,177 @@
+#include "kcoro_cpp/platform.hpp"
+
+#include <array>
+#include <atomic>
+#include <mutex>
+
+using namespace kcoro_cpp::platform;
+
+namespace {
+
+constexpr int kClasses = 10;
+constexpr std::size_t kClassMin = 16 * 1024;
+
+// Free-list link kept in the (still resident) top page of a free stack.
+struct Node { Node* next; };
+
+std::size_t class_size(int cls) {
+  std::size_t ps = page_size();
+  return ((kClassMin << cls) + ps - 1) & ~(ps - 1);
+}
+
+// Smallest class holding `bytes`, or -1 when too large to pool.
+int class_of(std::size_t bytes) {
+  for (int c = 0; c < kClasses; ++c) if (bytes <= class_size(c)) return c;
+  return -1;
+}
+
+Node* node_of(void* usable, std::size_t size) {
+  return reinterpret_cast<Node*>(static_cast<char*>(usable) + size - sizeof(Node));
+}
+
+void* usable_of(Node* n, std::size_t size) {
+  return reinterpret_cast<char*>(n) + sizeof(Node) - size;
+}
+
+std::atomic<unsigned> g_limit_thread{16};
+std::atomic<unsigned> g_limit_depot{64};
+std::atomic<std::uint64_t> g_reused{0}, g_mapped{0}, g_unmapped{0};
+
+struct Depot {
+  std::mutex mu;
+  std::array<Node*, kClasses> head{};
+  std::array<unsigned, kClasses> count{};
+};
+Depot g_depot;
+
+void unmap_usable(void* usable, std::size_t size) {
+  std::size_t ps = page_size();
+  ::munmap(static_cast<char*>(usable) - ps, size + ps);
+}
+
+struct ThreadCache {
+  std::array<Node*, kClasses> head{};
+  std::array<unsigned, kClasses> count{};
+  std::uint64_t reused{}, mapped{}, unmapped{};
+
+  ~ThreadCache() { for (int c = 0; c < kClasses; ++c) spill(c, count[c]); }
+
+  void fold() {
+    if (reused) g_reused.fetch_add(reused, std::memory_order_relaxed);
+    if (mapped) g_mapped.fetch_add(mapped, std::memory_order_relaxed);
+    if (unmapped) g_unmapped.fetch_add(unmapped, std::memory_order_relaxed);
+    reused = mapped = unmapped = 0;
+  }
+
+  // Move n stacks to the depot; what it cannot hold is unmapped.
+  void spill(int cls, unsigned n) {
+    unsigned limit = g_limit_depot.load(std::memory_order_relaxed);
+    Node* drop = nullptr;
+    {
+      std::lock_guard<std::mutex> lk(g_depot.mu);
+      while (n-- && head[cls]) {
+        Node* s = head[cls];
+        head[cls] = s->next; --count[cls];
+        if (g_depot.count[cls] < limit) {
+          s->next = g_depot.head[cls]; g_depot.head[cls] = s; ++g_depot.count[cls];
+        } else {
+          s->next = drop; drop = s;
+        }
+      }
+    }
+    std::size_t size = class_size(cls);
+    while (drop) { Node* next = drop->next; unmap_usable(usable_of(drop, size), size); ++unmapped; drop = next; }
+    fold();
+  }
+
+  void refill(int cls, unsigned n) {
+    {
+      std::lock_guard<std::mutex> lk(g_depot.mu);
+      while (n-- && g_depot.head[cls]) {
+        Node* s = g_depot.head[cls];
+        g_depot.head[cls] = s->next; --g_depot.count[cls];
+        s->next = head[cls]; head[cls] = s; ++count[cls];
+      }
+    }
+    fold();
+  }
+};
+
+thread_local ThreadCache t_cache;
+
+MMapStack from_usable(void* usable, std::size_t size) {
+  std::size_t ps = page_size();
+  return {usable, size, static_cast<char*>(usable) - ps, size + ps};
+}
+
+} // namespace
+
+MMapStack StackPool::acquire(std::size_t bytes) {
+  std::size_t ps = page_size();
+  if (bytes == 0) bytes = ps;
+  unsigned limit = g_limit_thread.load(std::memory_order_relaxed);
+  int cls = limit ? class_of(bytes) : -1;
+  ThreadCache& c = t_cache;
+  if (cls < 0) { ++c.mapped; return MMapStack::allocate(bytes); }
+  std::size_t size = class_size(cls);
+  if (!c.head[cls]) c.refill(cls, limit > 1 ? limit / 2 : 1);
+  if (Node* s = c.head[cls]) {
+    c.head[cls] = s->next; --c.count[cls]; ++c.reused;
+    return from_usable(usable_of(s, size), size);
+  }
+  ++c.mapped;
+  return MMapStack::allocate(size);
+}
+
+void StackPool::recycle(MMapStack& s) {
+  if (!s.ptr) return;
+  ThreadCache& c = t_cache;
+  unsigned limit = g_limit_thread.load(std::memory_order_relaxed);
+  int cls = class_of(s.size);
+  std::size_t ps = page_size();
+  if (!limit || cls < 0 || class_size(cls) != s.size || s.raw_size != s.size + ps) {
+    s.release(); ++c.unmapped;
+    return;
+  }
+  if (s.size > ps) (void)::madvise(s.ptr, s.size - ps, MADV_DONTNEED);
+  Node* n = node_of(s.ptr, s.size);
+  n->next = c.head[cls]; c.head[cls] = n;
+  s = MMapStack{};
+  if (++c.count[cls] > limit) c.spill(cls, c.count[cls] - limit / 2);
+}
+
+void StackPool::set_limits(unsigned per_thread, unsigned depot) {
+  g_limit_thread.store(per_thread, std::memory_order_relaxed);
+  g_limit_depot.store(depot, std::memory_order_relaxed);
+}
+
+void StackPool::trim() {
+  ThreadCache& c = t_cache;
+  for (int cls = 0; cls < kClasses; ++cls) {
+    std::size_t size = class_size(cls);
+    Node* list = nullptr;
+    {
+      std::lock_guard<std::mutex> lk(g_depot.mu);
+      list = g_depot.head[cls]; g_depot.head[cls] = nullptr; g_depot.count[cls] = 0;
+    }
+    while (Node* s = c.head[cls]) { c.head[cls] = s->next; s->next = list; list = s; }
+    c.count[cls] = 0;
+    while (list) { Node* next = list->next; unmap_usable(usable_of(list, size), size); ++c.unmapped; list = next; }
+  }
+  c.fold();
+}
+
+StackPoolStats StackPool::stats() {
+  ThreadCache& c = t_cache;
+  c.fold();
+  StackPoolStats out;
+  out.reused = g_reused.load(std::memory_order_relaxed);
+  out.mapped = g_mapped.load(std::memory_order_relaxed);
+  out.unmapped = g_unmapped.load(std::memory_order_relaxed);
+  {
+    std::lock_guard<std::mutex> lk(g_depot.mu);
+    for (int cls = 0; cls < kClasses; ++cls) out.depot_stacks += g_depot.count[cls];
+  }
+  for (int cls = 0; cls < kClasses; ++cls) out.thread_stacks += c.count[cls];
+  return out;
+}
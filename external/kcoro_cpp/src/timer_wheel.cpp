@@ -0,0 +1,215 @@
+#include "kcoro_cpp/timer_wheel.hpp"
+
+// Level L slot s holds nodes whose expiry falls in the 64^L-tick block that
+// maps to s; when the current tick enters that block the slot is cascaded one
+// level down, and level-0 slots fire directly. Nodes that are due while
+// cascading go straight to the due list.
+
+namespace kcoro_cpp {
+namespace detail {
+
+namespace {
+inline uint64_t ns_to_tick_ceil(uint64_t ns) {
+  return ns / TimerWheel::kTickNs + (ns % TimerWheel::kTickNs ? 1 : 0);
+}
+// Fired callbacks per lock hold; the rest wait for the next round.
+constexpr size_t kFireBatch = 64;
+}
+
+TimerWheel::TimerWheel(uint32_t wheel_no, uint64_t now_ns)
+  : now_tick_(now_ns / kTickNs), wheel_no_(wheel_no) {}
+
+TimerWheel::~TimerWheel() {
+  std::lock_guard<std::mutex> lk(mu_);
+  auto drop = [](TimerNode* n) {
+    while (n) { TimerNode* next = n->next; n->next = n->prev = nullptr; n->wheel.store(nullptr, std::memory_order_release); n = next; }
+  };
+  for (int l = 0; l < kLevels; l++) for (unsigned s = 0; s < kSlots; s++) drop(head_[l][s]);
+  drop(due_);
+}
+
+void TimerWheel::link(TimerNode* n) {
+  TimerNode*& head = list_for(n);
+  n->prev = nullptr;
+  n->next = head;
+  if (head) head->prev = n;
+  head = n;
+}
+
+void TimerWheel::unlink(TimerNode* n) {
+  if (n->prev) n->prev->next = n->next;
+  else list_for(n) = n->next;
+  if (n->next) n->next->prev = n->prev;
+  n->next = n->prev = nullptr;
+}
+
+// File a node relative to now_tick_ (or on the due list if already due).
+void TimerWheel::place(TimerNode* n) {
+  const uint64_t now = now_tick_;
+  if (n->expires <= now) { n->level = kDueLevel; n->slot = 0; link(n); return; }
+  int level = kLevels - 1;
+  uint64_t block = (now >> (kBits * level)) + kMask; // clamp: re-cascade later
+  for (int l = 0; l < kLevels; l++) {
+    unsigned shift = kBits * (unsigned)l;
+    if ((n->expires >> shift) - (now >> shift) < kSlots) { level = l; block = n->expires >> shift; break; }
+  }
+  n->level = (uint8_t)level;
+  n->slot = (uint8_t)(block & kMask);
+  link(n);
+}
+
+void TimerWheel::arm(TimerNode* n, uint64_t deadline_ns) {
+  TimerWheel* cur = n->wheel.load(std::memory_order_acquire);
+  if (cur && cur != this) cur->cancel(n);
+  std::lock_guard<std::mutex> lk(mu_);
+  if (n->wheel.load(std::memory_order_relaxed) == this) unlink(n);
+  else pending_.fetch_add(1, std::memory_order_relaxed);
+  n->expires = ns_to_tick_ceil(deadline_ns);
+  place(n);
+  n->wheel.store(this, std::memory_order_release);
+}
+
+bool TimerWheel::cancel(TimerNode* n) {
+  std::lock_guard<std::mutex> lk(mu_);
+  if (n->wheel.load(std::memory_order_relaxed) != this) return false;
+  unlink(n);
+  n->wheel.store(nullptr, std::memory_order_release);
+  pending_.fetch_sub(1, std::memory_order_relaxed);
+  return true;
+}
+
+TimerWheel::Entry* TimerWheel::acquire() {
+  std::lock_guard<std::mutex> lk(mu_);
+  if (!free_) {
+    uint32_t base = (uint32_t)chunks_.size() * kChunk;
+    if (base + kChunk > kIndexMask + 1u) throw std::bad_alloc();
+    chunks_.emplace_back(new Entry[kChunk]);
+    Entry* c = chunks_.back().get();
+    for (uint32_t i = 0; i < kChunk; i++) {
+      c[i].index = base + i;
+      c[i].owner = this;
+      c[i].node.fire = &TimerWheel::fire_entry;
+      c[i].node.ctx = &c[i];
+      c[i].next_free = (i + 1 < kChunk) ? &c[i + 1] : nullptr;
+    }
+    free_ = c;
+  }
+  Entry* e = free_;
+  free_ = e->next_free;
+  e->next_free = nullptr;
+  return e;
+}
+
+uint64_t TimerWheel::commit(Entry* e, uint64_t deadline_ns) {
+  // Build the id first: once armed, the owning worker may fire and recycle e
+  uint64_t id = ((uint64_t)e->gen << 32) | ((uint64_t)(wheel_no_ & 0xFFu) << kIndexBits) | (uint64_t)e->index;
+  arm(&e->node, deadline_ns);
+  return id;
+}
+
+void TimerWheel::release(Entry* e) {
+  std::lock_guard<std::mutex> lk(mu_);
+  if (++e->gen == 0) e->gen = 1;
+  e->next_free = free_;
+  free_ = e;
+}
+
+void TimerWheel::fire_entry(void* ctx) {
+  auto* e = static_cast<Entry*>(ctx);
+  e->cb();
+  e->cb.reset();
+  e->owner->release(e);
+}
+
+bool TimerWheel::cancel_id(uint64_t id) {
+  uint32_t idx = (uint32_t)(id & kIndexMask);
+  uint32_t gen = (uint32_t)(id >> 32);
+  Entry* e = nullptr;
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    if (idx >= chunks_.size() * kChunk) return false;
+    e = &chunks_[idx / kChunk][idx % kChunk];
+    if (e->gen != gen || e->node.wheel.load(std::memory_order_relaxed) != this) return false;
+    unlink(&e->node);
+    e->node.wheel.store(nullptr, std::memory_order_release);
+    pending_.fetch_sub(1, std::memory_order_relaxed);
+  }
+  // Outside the lock: the callable's destructor may arm timers
+  e->cb.reset();
+  release(e);
+  return true;
+}
+
+// Move every node of one slot through place() (cascade or fire).
+void TimerWheel::replace_slot(int level, unsigned slot) {
+  TimerNode* n = head_[level][slot];
+  head_[level][slot] = nullptr;
+  while (n) {
+    TimerNode* next = n->next;
+    place(n);
+    n = next;
+  }
+}
+
+uint64_t TimerWheel::next_tick_locked() const {
+  if (due_) return now_tick_;
+  uint64_t best = UINT64_MAX;
+  for (int l = 0; l < kLevels; l++) {
+    unsigned shift = kBits * (unsigned)l;
+    uint64_t base = now_tick_ >> shift;
+    for (uint64_t k = 1; k <= kSlots; k++) {
+      if (head_[l][(base + k) & kMask]) {
+        uint64_t t = (base + k) << shift;
+        if (t < best) best = t;
+        break;
+      }
+    }
+  }
+  return best;
+}
+
+size_t TimerWheel::expire(uint64_t now_ns) {
+  struct Fired { void (*fire)(void*); void* ctx; };
+  Fired out[kFireBatch];
+  size_t total = 0;
+  const uint64_t target = now_ns / kTickNs;
+  for (;;) {
+    size_t n = 0;
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      if (pending_.load(std::memory_order_relaxed) == 0) {
+        if (target > now_tick_) now_tick_ = target;
+        return total;
+      }
+      // Skip idle stretches: nothing cascades or fires before the next tick
+      uint64_t next = next_tick_locked();
+      if (next != UINT64_MAX && next > now_tick_ + 1) {
+        uint64_t skip_to = next - 1 < target ? next - 1 : target;
+        if (skip_to > now_tick_) now_tick_ = skip_to;
+      }
+      for (;;) {
+        while (n < kFireBatch && due_) {
+          TimerNode* d = due_;
+          unlink(d);
+          d->wheel.store(nullptr, std::memory_order_release);
+          pending_.fetch_sub(1, std::memory_order_relaxed);
+          out[n++] = Fired{d->fire, d->ctx};
+        }
+        if (n == kFireBatch || now_tick_ >= target) break;
+        const uint64_t t = ++now_tick_;
+        // Highest levels first so cascaded nodes land in this tick's slot
+        for (int l = kLevels - 1; l >= 1; l--) {
+          unsigned shift = kBits * (unsigned)l;
+          if ((t & ((1ull << shift) - 1)) == 0) replace_slot(l, (unsigned)((t >> shift) & kMask));
+        }
+        replace_slot(0, (unsigned)(t & kMask));
+      }
+    }
+    for (size_t i = 0; i < n; i++) out[i].fire(out[i].ctx);
+    total += n;
+    if (n < kFireBatch) return total;
+  }
+}
+
+} // namespace detail
+} // namespace kcoro_cpp
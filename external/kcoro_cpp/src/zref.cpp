@@ -1,56 +1,121 @@
 #include "kcoro_cpp/zref.hpp"
+#include "kcoro_cpp/convert.hpp"
+#include <chrono>
 #include <mutex>
+#include <numeric>
 
 using namespace kcoro_cpp;
 
 // ZCopyRegistry region lifecycle -------------------------------------------------
 
+// The slot an id names, with a pin on it; nullptr once the region is gone.
+ZCopyRegistry::Slot* ZCopyRegistry::pin(RegionId id) const {
+  size_t i = (size_t)(id & (kMaxRegions - 1));
+  if (id == 0 || id == kClaimed || i == 0) return nullptr;
+  Slot* s = &slots_[i - 1];
+  if (s->id.load(std::memory_order_acquire) != id) return nullptr;
+  uint64_t r = s->refs.load(std::memory_order_relaxed);
+  do { if (r & kDead) return nullptr; }
+  while (!s->refs.compare_exchange_weak(r, r + 1, std::memory_order_acquire, std::memory_order_relaxed));
+  // The slot may have been freed and reused between the two loads
+  if (s->id.load(std::memory_order_acquire) != id) { unpin(s); return nullptr; }
+  return s;
+}
+
+void ZCopyRegistry::unpin(Slot* s) {
+  uint64_t r = s->refs.fetch_sub(1, std::memory_order_acq_rel) - 1;
+  if (r == kDead) { std::lock_guard<std::mutex> lk(s->mu); s->cv.notify_all(); }
+  else if (r == 1) wake_idle(s);
+}
+
+// Down to the owner's reference: tell region_wait_idle. The fence pairs
+// with the waiter's count so one of us sees the other.
+void ZCopyRegistry::wake_idle(Slot* s) {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (s->idle_waiters.load(std::memory_order_relaxed)) { std::lock_guard<std::mutex> lk(s->mu); s->cv.notify_all(); }
+}
+
 ZCopyRegistry::RegionId ZCopyRegistry::region_register(void* base, size_t len) {
-  std::lock_guard<std::mutex> lk(mu_);
-  RegionId id = ++next_region_id_;
-  regions_.emplace(id, Region(base, len, 1, false));
-  return id;
+  for (size_t i = 0; i < kMaxRegions; i++) {
+    Slot& s = slots_[i];
+    RegionId free_id = 0;
+    if (!s.id.compare_exchange_strong(free_id, kClaimed, std::memory_order_acquire)) continue;
+    // Claimed: every pin fails until refs loses kDead
+    s.base = base; s.len = len;
+    RegionId id = ((next_gen_.fetch_add(1, std::memory_order_relaxed) + 1) << kSlotBits) | (RegionId)(i + 1);
+    s.id.store(id, std::memory_order_release);
+    s.refs.store(1, std::memory_order_release);
+    return id;
+  }
+  return 0;
 }
 
 bool ZCopyRegistry::region_incref(RegionId id) {
-  std::lock_guard<std::mutex> lk(mu_);
-  auto it = regions_.find(id); if (it==regions_.end()) return false; if (it->second.dereg) return false; it->second.refs++; return true;
+  return pin(id) != nullptr;
 }
 
 bool ZCopyRegistry::region_decref(RegionId id) {
-  std::unique_lock<std::mutex> lk(mu_);
-  auto it = regions_.find(id); if (it==regions_.end()) return false; if (it->second.refs==0) return false; it->second.refs--; if (it->second.refs==0 && it->second.dereg) { it->second.cv.notify_all(); }
+  // No pin: the caller's reference keeps the slot, and a dying region must
+  // still drain
+  size_t i = (size_t)(id & (kMaxRegions - 1));
+  if (id == 0 || id == kClaimed || i == 0) return false;
+  Slot* s = &slots_[i - 1];
+  if (s->id.load(std::memory_order_acquire) != id) return false;
+  uint64_t r = s->refs.load(std::memory_order_relaxed);
+  do { if ((r & ~kDead) == 0) return false; }
+  while (!s->refs.compare_exchange_weak(r, r - 1, std::memory_order_acq_rel, std::memory_order_relaxed));
+  if (r - 1 == kDead) { std::lock_guard<std::mutex> lk(s->mu); s->cv.notify_all(); }
+  else if (r - 1 == 1) wake_idle(s);
   return true;
 }
 
 bool ZCopyRegistry::region_deregister(RegionId id) {
-  std::unique_lock<std::mutex> lk(mu_);
-  auto it = regions_.find(id); if (it==regions_.end()) return false;
-  auto& r = it->second;
-  r.dereg = true;
-  // Drop the owner's reference held since registration
-  if (r.refs > 0) r.refs--;
-  while (r.refs != 0) { r.cv.wait(lk); }
-  regions_.erase(it); return true;
+  Slot* s = pin(id);
+  if (!s) return false;
+  // One deregister wins; the owner's reference goes with it
+  uint64_t r = s->refs.fetch_or(kDead, std::memory_order_acq_rel);
+  if (r & kDead) { unpin(s); return false; }
+  s->refs.fetch_sub(1, std::memory_order_acq_rel);
+  unpin(s);
+  {
+    std::unique_lock<std::mutex> lk(s->mu);
+    s->cv.wait(lk, [s]{ return s->refs.load(std::memory_order_acquire) == kDead; });
+    for (auto* m : s->retired) delete m;
+    s->retired.clear();
+  }
+  delete s->meta.exchange(nullptr, std::memory_order_acq_rel);
+  s->id.store(0, std::memory_order_release);
+  return true;
 }
 
 bool ZCopyRegistry::region_query(RegionId id, void*& base, size_t& len) const {
-  std::lock_guard<std::mutex> lk(mu_);
-  auto it = regions_.find(id); if (it==regions_.end()) return false; base = it->second.base; len = it->second.len; return true;
+  Slot* s = pin(id);
+  if (!s) return false;
+  base = s->base; len = s->len;
+  unpin(s);
+  return true;
 }
 
-void ZCopyRegistry::set_meta(RegionId id, const RegionMeta& m) {
-  std::lock_guard<std::mutex> lk(mu_);
-  auto it = regions_.find(id); if (it==regions_.end()) return; 
-  std::lock_guard<std::mutex> lk2(it->second.mu);
-  it->second.meta = m; it->second.has_meta = true;
+bool ZCopyRegistry::set_meta(RegionId id, const RegionMeta& m) {
+  const uint64_t a = m.align_bytes;
+  if (a & (a - 1)) return false;
+  Slot* s = pin(id);
+  if (!s) return false;
+  if (a && (((uintptr_t)s->base | m.stride_bytes) & (a - 1))) { unpin(s); return false; }
+  const RegionMeta* old = s->meta.exchange(new RegionMeta(m), std::memory_order_acq_rel);
+  // A pinned reader may still be copying the old one
+  if (old) { std::lock_guard<std::mutex> lk(s->mu); s->retired.push_back(old); }
+  unpin(s);
+  return true;
 }
 
 bool ZCopyRegistry::get_meta(RegionId id, RegionMeta& m) const {
-  std::lock_guard<std::mutex> lk(mu_);
-  auto it = regions_.find(id); if (it==regions_.end()) return false; 
-  std::lock_guard<std::mutex> lk2(it->second.mu);
-  if (!it->second.has_meta) return false; m = it->second.meta; return true;
+  Slot* s = pin(id);
+  if (!s) return false;
+  const RegionMeta* p = s->meta.load(std::memory_order_acquire);
+  if (p) m = *p;
+  unpin(s);
+  return p != nullptr;
 }
 
 bool ZCopyRegistry::alloc_aligned(size_t size, size_t align, void*& base, RegionId& id) {
@@ -60,29 +125,233 @@ bool ZCopyRegistry::alloc_aligned(size_t size, size_t align, void*& base, Region
 #else
   if (posix_memalign(&p, align, size) != 0) return false;
 #endif
-  base = p; id = region_register(p, size); return id != 0;
+  id = region_register(p, size);
+  if (id == 0) { // table full
+#if defined(_MSC_VER)
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+    return false;
+  }
+  base = p; return true;
 }
 
-int ZRefRendezvous::send(void* ch, const ZDesc& d, long tmo_ms) {
-  if (d.region_id && mask_!=0) {
-    RegionMeta m{}; if (ZCopyRegistry::instance().get_meta(d.region_id, m)) {
-      bool mismatch=false;
-      if ((mask_ & FMT_DTYPE)    && m.dtype != req_meta_.dtype) mismatch=true;
-      if ((mask_ & FMT_ELEMBITS) && m.elem_bits != req_meta_.elem_bits) mismatch=true;
-      if ((mask_ & FMT_ALIGN)    && m.align_bytes < req_meta_.align_bytes) mismatch=true;
-      if ((mask_ & FMT_STRIDE)   && m.stride_bytes != req_meta_.stride_bytes) mismatch=true;
-      if ((mask_ & FMT_DIMS)) { if (m.ndims != req_meta_.ndims) mismatch=true; else for (uint8_t i=0;i<m.ndims && !mismatch;i++) if (m.dims[i]!=req_meta_.dims[i]) mismatch=true; }
-      if ((mask_ & FMT_LAYOUT)   && m.layout != req_meta_.layout) mismatch=true;
-      if (mismatch && mode_==FormatMode::Strict) return KC_EINVAL;
-    }
+// Region slicing --------------------------------------------------------------------
+
+int ZCopyRegistry::region_slice(RegionId id, unsigned axis, size_t n, ZDesc* out) {
+  if (!n || !out) return KC_EINVAL;
+  Slot* s = pin(id);
+  if (!s) return KC_EINVAL;
+  const RegionMeta* m = s->meta.load(std::memory_order_acquire);
+  const uint64_t esz = (m && m->elem_bits) ? (m->elem_bits + 7) / 8 : 1;
+  uint64_t dims[4] = { s->len / esz };
+  unsigned nd = 1;
+  if (m && m->ndims) { nd = m->ndims; for (unsigned i = 0; i < nd && i < 4; i++) dims[i] = m->dims[i]; }
+  bool ok = nd <= 4 && axis < nd;
+  for (unsigned i = 0; ok && i < axis; i++) ok = dims[i] == 1;
+  // Bytes between neighbours on each axis
+  uint64_t step[4] = {};
+  if (ok) {
+    step[nd - 1] = esz;
+    if (nd >= 2) step[nd - 2] = (m->stride_bytes) ? m->stride_bytes : dims[nd - 1] * esz;
+    for (int i = (int)nd - 3; i >= 0; i--) step[i] = dims[i + 1] * step[i + 1];
+    ok = step[axis] != 0 && dims[axis] != 0;
+  }
+  if (!ok) { unpin(s); return KC_EINVAL; }
+  // Cut on multiples of g indices so every slice starts on a cache line
+  const uint64_t g = kSliceAlign / std::gcd(step[axis], (uint64_t)kSliceAlign);
+  const uint64_t units = (dims[axis] + g - 1) / g;
+  const size_t k = (size_t)std::min<uint64_t>(n, units);
+  for (size_t i = 0; i < k; i++) {
+    const uint64_t lo = (i * units / k) * g;
+    const uint64_t hi = std::min<uint64_t>(dims[axis], ((i + 1) * units / k) * g);
+    const uint64_t off = lo * step[axis];
+    if (off >= s->len) { unpin(s); return KC_EINVAL; }   // meta overstates the region
+    out[i] = ZDesc{ (char*)s->base + off, (size_t)std::min<uint64_t>((hi - lo) * step[axis], s->len - off), id, off, 0 };
+  }
+  // One reference per slice, on top of our pin
+  uint64_t r = s->refs.load(std::memory_order_relaxed);
+  do { if (r & kDead) { unpin(s); return KC_EINVAL; } }
+  while (!s->refs.compare_exchange_weak(r, r + k, std::memory_order_acquire, std::memory_order_relaxed));
+  unpin(s);
+  return (int)k;
+}
+
+bool ZCopyRegistry::region_wait_idle(RegionId id, long tmo_ms) {
+  Slot* s = pin(id);
+  if (!s) return false;
+  unpin(s);
+  auto gone = [&]{ return s->id.load(std::memory_order_acquire) != id || (s->refs.load(std::memory_order_acquire) & kDead); };
+  auto done = [&]{ return gone() || s->refs.load(std::memory_order_seq_cst) <= 1; };
+  std::unique_lock<std::mutex> lk(s->mu);
+  s->idle_waiters.fetch_add(1, std::memory_order_seq_cst);
+  bool idle = true;
+  if (tmo_ms < 0) s->cv.wait(lk, done);
+  else idle = s->cv.wait_for(lk, std::chrono::milliseconds(tmo_ms), done);
+  s->idle_waiters.fetch_sub(1, std::memory_order_relaxed);
+  return idle && !gone();
+}
+
+int kcoro_cpp::region_scatter(ZCopyRegistry::RegionId id, unsigned axis, IChannel<ZDesc>* const* chans, size_t n, long tmo_ms) {
+  auto& reg = ZCopyRegistry::instance();
+  std::vector<ZDesc> parts(n);
+  int k = reg.region_slice(id, axis, n, parts.data());
+  if (k < 0) return k;
+  int sent = 0, rc = 0;
+  for (int i = 0; i < k; i++) {
+    if (rc == 0) rc = chans[i]->send(parts[i], tmo_ms);
+    if (rc == 0) sent++;
+    else reg.region_decref(id);
   }
+  return sent ? sent : rc;
+}
+
+// ZBuf / ZBufPool -----------------------------------------------------------------
+
+void ZBuf::reset() {
+  if (!d_.region_id) return;
+  // Slot first: the pool's region (and the pool) outlive our reference
+  if (pool_) pool_->release(d_.addr);
+  ZCopyRegistry::instance().region_decref(d_.region_id);
+  d_ = {}; pool_ = nullptr;
+}
+
+ZBufPool::ZBufPool(const RegionMeta* m, size_t slot_bytes, size_t slots, size_t align) {
+  // Every slot starts on the meta's alignment
+  if (m) align = m->align_bytes ? m->align_bytes : alignof(std::max_align_t);
+  if (!align || (align & (align - 1))) throw Error("ZBufPool: bad alignment");
+  slot_bytes_ = (slot_bytes + align - 1) & ~(align - 1);
+  if (!slots || !slot_bytes_ || slots > UINT32_MAX) throw Error("ZBufPool: bad geometry");
+  void* base = nullptr;
+  auto& reg = ZCopyRegistry::instance();
+  if (!reg.alloc_aligned(slot_bytes_ * slots, align > 64 ? align : 64, base, id_)) throw Error("ZBufPool: region allocation failed");
+  base_ = (char*)base;
+  if (m && !reg.set_meta(id_, *m)) { reg.region_deregister(id_); std::free(base_); throw Error("ZBufPool: meta refused"); }
+  free_.reserve(slots);
+  for (size_t i = slots; i-- > 0;) free_.push_back((uint32_t)i);
+}
+
+ZBufPool::~ZBufPool() {
+  ZCopyRegistry::instance().region_deregister(id_);
+  std::free(base_);
+}
+
+void* ZBufPool::acquire() {
+  std::lock_guard<std::mutex> lk(mu_);
+  if (free_.empty()) return nullptr;
+  uint32_t i = free_.back(); free_.pop_back();
+  return base_ + (size_t)i * slot_bytes_;
+}
+
+void ZBufPool::release(void* slot) {
+  std::lock_guard<std::mutex> lk(mu_);
+  free_.push_back((uint32_t)(((char*)slot - base_) / slot_bytes_));
+}
+
+ZBuf ZBufPool::get() {
+  void* slot = acquire();
+  if (!slot) return {};
+  if (!ZCopyRegistry::instance().region_incref(id_)) { release(slot); return {}; }
+  return ZBuf::adopt(ZDesc{slot, slot_bytes_, id_, offset_of(slot), 0}, this);
+}
+
+int kcoro_cpp::zbuf_send(IChannel<ZDesc>& ch, ZBuf&& b, long tmo_ms) {
+  if (!b) return KC_EINVAL;
+  int rc = ch.send(b.desc(), tmo_ms);
+  if (rc == 0) (void)b.release();
+  return rc;
+}
+
+int kcoro_cpp::zbuf_recv(IChannel<ZDesc>& ch, ZBuf& out, long tmo_ms, ZBufPool* pool) {
+  ZDesc d{};
+  int rc = ch.recv(d, tmo_ms);
+  if (rc == 0) out = ZBuf::adopt(d, pool);
+  return rc;
+}
+
+// FormatPolicy ----------------------------------------------------------------------
+
+FormatPolicy::Verdict FormatPolicy::plan(const ZDesc& d, Plan& p) const {
+  if (!d.region_id || !mask) return Verdict::Match;
+  RegionMeta m{};
+  if (!ZCopyRegistry::instance().get_meta(d.region_id, m)) return Verdict::Match;
+  bool mismatch=false, shape=false;
+  if ((mask & FMT_DTYPE)    && m.dtype != req.dtype) mismatch=true;
+  if ((mask & FMT_ELEMBITS) && m.elem_bits != req.elem_bits) mismatch=true;
+  if ((mask & FMT_ALIGN)    && m.align_bytes < req.align_bytes) mismatch=true;
+  // The meta vouches for the base; the descriptor may point past it
+  if ((mask & FMT_ALIGN)    && req.align_bytes && ((uintptr_t)d.addr % req.align_bytes)) mismatch=true;
+  if ((mask & FMT_STRIDE)   && m.stride_bytes != req.stride_bytes) mismatch=true;
+  if ((mask & FMT_DIMS)) { if (m.ndims != req.ndims) shape=true; else for (uint8_t i=0;i<m.ndims && !shape;i++) if (m.dims[i]!=req.dims[i]) shape=true; }
+  if ((mask & FMT_LAYOUT)   && m.layout != req.layout) shape=true;
+  if (!mismatch && !shape) return Verdict::Match;
+  if (shape || mode != FormatMode::Adapt) return Verdict::Reject;
+  // Adapt: can a pass into a pool slot produce the required format?
+  p.from = m.dtype;
+  p.to = (mask & FMT_DTYPE) ? req.dtype : m.dtype;
+  const size_t ssz = convert::elem_size(p.from), dsz = convert::elem_size(p.to);
+  if (!convert::supported(p.from, p.to)) return Verdict::Reject;
+  if (m.elem_bits && m.elem_bits != ssz * 8) return Verdict::Reject;
+  if ((mask & FMT_ELEMBITS) && req.elem_bits != dsz * 8) return Verdict::Reject;
+  if (m.ndims > 4) return Verdict::Reject;
+  if (m.ndims) {
+    p.row_elems = m.dims[m.ndims - 1];
+    p.rows = 1;
+    for (uint8_t i = 0; i + 1 < m.ndims; i++) p.rows *= m.dims[i];
+  } else {
+    if (d.len % ssz) return Verdict::Reject;
+    p.row_elems = d.len / ssz; p.rows = 1;
+  }
+  p.src_pitch = m.stride_bytes ? m.stride_bytes : p.row_elems * ssz;
+  p.dst_pitch = ((mask & FMT_STRIDE) && req.stride_bytes) ? req.stride_bytes : p.row_elems * dsz;
+  if (p.src_pitch < p.row_elems * ssz || p.dst_pitch < p.row_elems * dsz) return Verdict::Reject;
+  const size_t need = p.rows ? (p.rows - 1) * p.src_pitch + p.row_elems * ssz : 0;
+  p.dst_bytes = p.rows ? (p.rows - 1) * p.dst_pitch + p.row_elems * dsz : 0;
+  if (need > d.len || !pool || p.dst_bytes > pool->slot_bytes()) return Verdict::Reject;
+  return Verdict::Convert;
+}
+
+int FormatPolicy::admit(const ZDesc& d) const {
+  Plan p{};
+  Verdict v = plan(d, p);
+  if (v == Verdict::Match || mode == FormatMode::Advisory) return 0;
+  return v == Verdict::Convert ? 0 : KC_EINVAL;
+}
+
+bool FormatPolicy::convert_into(ZDesc& d, void* slot) const {
+  Plan p{};
+  if (mode != FormatMode::Adapt || plan(d, p) != Verdict::Convert) return false;
+  if (!convert::convert_rows(p.from, d.addr, p.src_pitch, p.to, slot, p.dst_pitch, p.rows, p.row_elems)) return false;
+  d.addr = slot; d.len = p.dst_bytes;
+  d.region_id = pool->region(); d.offset = pool->offset_of(slot);
+  d.flags |= ZDESC_F_CONVERTED;
+  return true;
+}
+
+int FormatPolicy::adapt(ZDesc& d) const {
+  if (!adapting()) return 0;
+  Plan p{};
+  if (plan(d, p) != Verdict::Convert) return 0;
+  void* slot = pool->acquire();
+  if (!slot) return KC_ENOBUFS;
+  if (!convert_into(d, slot)) pool->release(slot);
+  return 0;
+}
+
+// ZRefRendezvous --------------------------------------------------------------------
+
+int ZRefRendezvous::send(void* ch, const ZDesc& d, long tmo_ms) {
+  (void)ch;
+  if (int rc = policy_.admit(d)) return rc;
   auto deadline = (tmo_ms < 0) ? (uint64_t)(-1) : (platform::now_ns() + (uint64_t)tmo_ms * 1000000ULL);
   for (;;) {
     Coroutine* cur = Coroutine::current(); if (!cur) return KC_EAGAIN;
     bool park = false;
     {
       std::lock_guard<std::mutex> lk(mu_);
-      auto& s = st_[ch];
+      auto& s = st_;
+      if (s.closed) return KC_EPIPE;
       if (!s.ready) {
         // If a receiver is already waiting, deliver immediately
         if (!s.recv_waiters.empty()) {
@@ -105,30 +374,41 @@ int ZRefRendezvous::send(void* ch, const ZDesc& d, long tmo_ms) {
       if (tmo_ms >= 0 && platform::now_ns() >= deadline) return KC_ETIME;
       // if resumed by receiver, success
       std::lock_guard<std::mutex> lk(mu_);
-      auto it = st_.find(ch);
-      if (it==st_.end()) return KC_EPIPE;
-      if (!it->second.ready && it->second.parked_sender==nullptr) return 0;
+      if (st_.closed) return KC_EPIPE;
+      if (!st_.ready && st_.parked_sender==nullptr) return 0;
     }
   }
 }
 
 int ZRefRendezvous::recv(void* ch, ZDesc& d, long tmo_ms) {
+  (void)ch;
+  // Adapt: the slot is taken before anything is consumed
+  struct Held { ConvertPool* pool; void* p; ~Held() { if (p) pool->release(p); } } slot{policy_.pool, nullptr};
+  if (policy_.adapting() && !(slot.p = policy_.pool->acquire())) return KC_ENOBUFS;
   auto deadline = (tmo_ms < 0) ? (uint64_t)(-1) : (platform::now_ns() + (uint64_t)tmo_ms * 1000000ULL);
   for (;;) {
     Coroutine* cur = Coroutine::current(); if (!cur) return KC_EAGAIN;
     Coroutine* parked_sender = nullptr; bool wait=false; bool from_select_sender=false; SelSend sel_sender{};
     {
       std::lock_guard<std::mutex> lk(mu_);
-      auto& s = st_[ch];
+      auto& s = st_;
       if (s.ready) {
-        d.addr = s.ptr; d.len = s.len; d.region_id = s.rid; d.offset = s.off; s.ready = false; parked_sender = s.parked_sender; s.parked_sender = nullptr; 
+        d.addr = s.ptr; d.len = s.len; d.region_id = s.rid; d.offset = s.off; d.flags = 0; s.ready = false; parked_sender = s.parked_sender; s.parked_sender = nullptr; 
         if (!parked_sender && !s.ssend.empty()) { sel_sender = s.ssend.front(); s.ssend.pop_front(); from_select_sender = true; }
+      } else if (s.closed) {
+        return KC_EPIPE;
       } else {
         // no payload, queue receiver
         s.recv_waiters.push_back(cur); wait = true;
       }
     }
-    if (!wait) { if (parked_sender) sched_->enqueue_ready(parked_sender); if (from_select_sender) { if (sel_sender.sel->try_complete(sel_sender.idx, 0)) if (auto* w=sel_sender.sel->waiter()) sched_->enqueue_ready(static_cast<Coroutine*>(w)); } return 0; }
+    if (!wait) {
+      // Convert before the sender hears its buffer is done with
+      if (slot.p && policy_.convert_into(d, slot.p)) slot.p = nullptr;
+      if (parked_sender) sched_->enqueue_ready(parked_sender);
+      if (from_select_sender) { if (sel_sender.sel->try_complete(sel_sender.idx, 0)) if (auto* w=sel_sender.sel->waiter()) sched_->enqueue_ready(static_cast<Coroutine*>(w)); }
+      return 0;
+    }
     if (tmo_ms >= 0) {
       uint64_t now = platform::now_ns(); if (now >= deadline) return KC_ETIME;
       long remain_ms = (long)((deadline - now)/1000000ULL); if (remain_ms<1) remain_ms=1; sched_->wake_after(cur, remain_ms);
@@ -139,19 +419,23 @@ int ZRefRendezvous::recv(void* ch, ZDesc& d, long tmo_ms) {
 }
 
 void ZRefRendezvous::on_close(void* ch) {
+  (void)ch;
   std::lock_guard<std::mutex> lk(mu_);
-  auto it = st_.find(ch);
-  if (it == st_.end()) return;
-  if (it->second.parked_sender) sched_->enqueue_ready(it->second.parked_sender);
-  for (auto* r : it->second.recv_waiters) sched_->enqueue_ready(r);
-  for (auto& sr : it->second.srecv) { sr.sel->try_complete(sr.idx, KC_EPIPE); if (auto* w = sr.sel->waiter()) sched_->enqueue_ready(static_cast<Coroutine*>(w)); }
-  for (auto& ss : it->second.ssend) { ss.sel->try_complete(ss.idx, KC_EPIPE); if (auto* w = ss.sel->waiter()) sched_->enqueue_ready(static_cast<Coroutine*>(w)); }
-  st_.erase(it);
+  auto& s = st_;
+  if (s.closed) return;
+  if (s.parked_sender) sched_->enqueue_ready(s.parked_sender);
+  for (auto* r : s.recv_waiters) sched_->enqueue_ready(r);
+  for (auto& sr : s.srecv) { sr.sel->try_complete(sr.idx, KC_EPIPE); if (auto* w = sr.sel->waiter()) sched_->enqueue_ready(static_cast<Coroutine*>(w)); }
+  for (auto& ss : s.ssend) { ss.sel->try_complete(ss.idx, KC_EPIPE); if (auto* w = ss.sel->waiter()) sched_->enqueue_ready(static_cast<Coroutine*>(w)); }
+  // A payload still published is dropped with its sender
+  s = State{};
+  s.closed = true;
 }
 
 int ZRefRendezvous::select_register_recv(void* ch, ISelect* sel, int clause_index, ZDesc* out) {
+  (void)ch;
   std::lock_guard<std::mutex> lk(mu_);
-  auto& s = st_[ch];
+  auto& s = st_;
   // Prefer matching a pending select sender if present
   if (!s.ssend.empty()) {
     auto ss = s.ssend.front(); s.ssend.pop_front();
@@ -168,14 +452,17 @@ int ZRefRendezvous::select_register_recv(void* ch, ISelect* sel, int clause_inde
     if (to_wake) sched_->enqueue_ready(to_wake);
     return 0;
   }
+  if (s.closed) return KC_EPIPE;
   // No counterpart yet: register as select receiver
   s.srecv.push_back({sel, clause_index, out});
   return KC_EAGAIN;
 }
 
 int ZRefRendezvous::select_register_send(void* ch, ISelect* sel, int clause_index, const ZDesc* val) {
+  (void)ch;
   std::lock_guard<std::mutex> lk(mu_);
-  auto& s = st_[ch];
+  auto& s = st_;
+  if (s.closed) return KC_EPIPE;
   // Prefer matching a pending select receiver
   if (!s.srecv.empty()) {
     auto sr = s.srecv.front(); s.srecv.pop_front();
@@ -199,8 +486,9 @@ int ZRefRendezvous::select_register_send(void* ch, ISelect* sel, int clause_inde
 }
 
 void ZRefRendezvous::select_cancel(void* ch, ISelect* sel, int clause_index, SelectOp kind) {
+  (void)ch;
   std::lock_guard<std::mutex> lk(mu_);
-  auto& s = st_[ch];
+  auto& s = st_;
   if (kind == SelectOp::Recv) {
     for (auto it = s.srecv.begin(); it != s.srecv.end(); ++it) {
       if (it->sel == sel && it->idx == clause_index) { s.srecv.erase(it); break; }
@@ -0,0 +1,357 @@
+// kcoro_cpp_bench: the kcoro_cpp side of kcbench (kcoro/bench). Same case
+// names where the two runtimes overlap and the same "kcoro-bench-1" JSON, so
+//   kcbench -c base.json cur.json
+// compares either tool's results, or one runtime against the other.
+//
+//   kcoro_cpp_bench [-r reps] [-w warmup] [-s scale] [-f filter] [-o out.json] [-l]
+#include "kcoro_cpp/scheduler.hpp"
+#include "kcoro_cpp/static_channel.hpp"
+#include "kcoro_cpp/select_v.hpp"
+#include "kcoro_cpp/zref.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include <sys/utsname.h>
+
+using namespace kcoro_cpp;
+
+namespace {
+
+long now_ns() {
+  return (long)std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Workers count down `left`; the last one stamps t_end (as in kcbench).
+struct Run {
+  WorkStealingScheduler* sched{};
+  std::atomic<long> left{0};
+  std::atomic<long> t_end{0};
+  std::atomic<bool> bad{false};
+  void done() {
+    if (left.fetch_sub(1, std::memory_order_acq_rel) == 1) t_end.store(now_ns(), std::memory_order_release);
+  }
+  // Elapsed ns since t0, or -1 on a failed op or after 60 s.
+  long wait(long t0) {
+    while (left.load(std::memory_order_acquire) > 0) {
+      if (now_ns() - t0 > 60'000'000'000L) return -1;
+      usleep(50);
+    }
+    while (!t_end.load(std::memory_order_acquire)) {}
+    return bad.load() ? -1 : t_end.load() - t0;
+  }
+};
+
+struct Case {
+  const char* name;
+  const char* desc;
+  long (*fn)(WorkStealingScheduler&, const Case&, long ops);
+  long ops;
+  int p, c;
+};
+
+// ---- sched.yield / sched.spawn ----
+
+struct YieldCtx : Run { long ops{}; };
+
+long bench_yield(WorkStealingScheduler& s, const Case&, long ops) {
+  YieldCtx y; y.sched = &s; y.ops = ops; y.left = 1;
+  long t0 = now_ns();
+  s.spawn([](void* p) {
+    auto* y = static_cast<YieldCtx*>(p);
+    for (long i = 0; i < y->ops; i++) y->sched->yield();
+    y->done();
+  }, &y);
+  return y.wait(t0);
+}
+
+long bench_spawn(WorkStealingScheduler& s, const Case&, long ops) {
+  Run r; r.sched = &s; r.left = ops;
+  long t0 = now_ns();
+  for (long i = 0; i < ops; i++) s.spawn([](void* p) { static_cast<Run*>(p)->done(); }, &r);
+  return r.wait(t0);
+}
+
+// ---- chan.rv_pingpong ----
+
+struct PingPong : Run {
+  rendezvous_channel<long>* ping{}; rendezvous_channel<long>* pong{}; long ops{};
+};
+
+long bench_pingpong(WorkStealingScheduler& s, const Case&, long ops) {
+  rendezvous_channel<long> a(&s), b(&s);
+  PingPong pp; pp.sched = &s; pp.ping = &a; pp.pong = &b; pp.ops = ops; pp.left = 2;
+  long t0 = now_ns();
+  s.spawn([](void* p) {
+    auto* c = static_cast<PingPong*>(p);
+    for (long i = 0; i < c->ops; i++) {
+      long v = 0;
+      if (c->ping->recv(v, -1) != 0 || c->pong->send(v + 1, -1) != 0) c->bad = true;
+    }
+    c->done();
+  }, &pp);
+  s.spawn([](void* p) {
+    auto* c = static_cast<PingPong*>(p);
+    for (long i = 0; i < c->ops; i++) {
+      long v = i;
+      if (c->ping->send(v, -1) != 0 || c->pong->recv(v, -1) != 0 || v != i + 1) c->bad = true;
+    }
+    c->done();
+  }, &pp);
+  return pp.wait(t0);
+}
+
+// ---- chan.buffered.PxC / chan.copy.N / chan.zref.N ----
+
+template<typename Chan, typename T>
+struct Queue : Run { Chan* ch{}; long per_prod{}, per_cons{}; };
+
+template<typename T, std::size_t Cap>
+long run_queue(WorkStealingScheduler& s, int np, int nc, long ops) {
+  using Chan = buffered_channel<T, Cap>;
+  auto ch = std::make_unique<Chan>(&s);
+  Queue<Chan, T> q; q.sched = &s; q.ch = ch.get();
+  q.per_prod = ops / np; q.per_cons = ops / nc; q.left = np + nc;
+  long t0 = now_ns();
+  for (int i = 0; i < nc; i++) s.spawn([](void* p) {
+    auto* q = static_cast<Queue<Chan, T>*>(p);
+    auto v = std::make_unique<T>();
+    for (long k = 0; k < q->per_cons; k++) if (q->ch->recv(*v, -1) != 0) q->bad = true;
+    q->done();
+  }, &q);
+  for (int i = 0; i < np; i++) s.spawn([](void* p) {
+    auto* q = static_cast<Queue<Chan, T>*>(p);
+    auto v = std::make_unique<T>();
+    for (long k = 0; k < q->per_prod; k++) if (q->ch->send(*v, -1) != 0) q->bad = true;
+    q->done();
+  }, &q);
+  return q.wait(t0);
+}
+
+long bench_buffered(WorkStealingScheduler& s, const Case& c, long ops) {
+  return run_queue<int, 1024>(s, c.p, c.c, ops);
+}
+
+template<std::size_t N>
+long bench_copy(WorkStealingScheduler& s, const Case&, long ops) {
+  return run_queue<std::array<unsigned char, N>, 64>(s, 1, 1, ops);
+}
+
+struct ZQueue : Run { ZRefBufferedChannel* ch{}; std::vector<unsigned char>* slab{}; size_t size{}; long ops{}; };
+
+template<std::size_t N>
+long bench_zref(WorkStealingScheduler& s, const Case&, long ops) {
+  ZRefBufferedChannel ch(&s, 64);
+  std::vector<unsigned char> slab(N * 128, 0x5a);
+  ZQueue q; q.sched = &s; q.ch = &ch; q.slab = &slab; q.size = N; q.ops = ops; q.left = 2;
+  long t0 = now_ns();
+  s.spawn([](void* p) {
+    auto* q = static_cast<ZQueue*>(p);
+    unsigned sink = 0;
+    for (long k = 0; k < q->ops; k++) {
+      ZDesc d{};
+      if (q->ch->recv(d, -1) != 0 || d.len != q->size) { q->bad = true; continue; }
+      sink += static_cast<unsigned char*>(d.addr)[d.len - 1];
+    }
+    asm volatile("" :: "r"(sink));
+    q->done();
+  }, &q);
+  s.spawn([](void* p) {
+    auto* q = static_cast<ZQueue*>(p);
+    for (long k = 0; k < q->ops; k++) {
+      ZDesc d{q->slab->data() + (size_t)(k % 128) * q->size, q->size, 0, 0, 0};
+      if (q->ch->send(d, -1) != 0) q->bad = true;
+    }
+    q->done();
+  }, &q);
+  return q.wait(t0);
+}
+
+// ---- select.fan_in.4 ----
+
+struct FanIn : Run {
+  std::array<buffered_channel<int, 64>*, 4> ch{}; long per_prod{}; std::atomic<int> next{0};
+};
+
+long bench_fan_in(WorkStealingScheduler& s, const Case&, long ops) {
+  buffered_channel<int, 64> c0(&s), c1(&s), c2(&s), c3(&s);
+  FanIn f; f.sched = &s; f.ch = {&c0, &c1, &c2, &c3}; f.per_prod = ops / 4; f.left = 5;
+  long t0 = now_ns();
+  s.spawn([](void* p) {
+    auto* f = static_cast<FanIn*>(p);
+    int got = 0;
+    auto take = [&](int& v) { got = v; };
+    for (long k = 0; k < f->per_prod * 4; k++)
+      if (select(on_recv(*f->ch[0], take), on_recv(*f->ch[1], take),
+                 on_recv(*f->ch[2], take), on_recv(*f->ch[3], take)) != 0) f->bad = true;
+    f->done();
+  }, &f);
+  for (int i = 0; i < 4; i++) s.spawn([](void* p) {
+    auto* f = static_cast<FanIn*>(p);
+    auto* ch = f->ch[f->next.fetch_add(1)];
+    for (long k = 0; k < f->per_prod; k++) if (ch->send((int)k, -1) != 0) f->bad = true;
+    f->done();
+  }, &f);
+  return f.wait(t0);
+}
+
+// ---- timer.sleep_1ms: p sleepers, ops sleeps each; ns/op is per sleep ----
+
+struct Sleep : Run { long ops{}; };
+
+long bench_sleep(WorkStealingScheduler& s, const Case& c, long ops) {
+  Sleep sl; sl.sched = &s; sl.ops = ops; sl.left = c.p;
+  long t0 = now_ns();
+  for (int i = 0; i < c.p; i++) s.spawn([](void* p) {
+    auto* sl = static_cast<Sleep*>(p);
+    for (long k = 0; k < sl->ops; k++) sl->sched->sleep_ms(1);
+    sl->done();
+  }, &sl);
+  return sl.wait(t0);
+}
+
+const Case kCases[] = {
+  {"sched.yield", "yield() of a lone coroutine through its worker", bench_yield, 1000000, 0, 0},
+  {"sched.spawn", "spawn() of an empty coroutine, to completion", bench_spawn, 100000, 0, 0},
+  {"chan.rv_pingpong", "rendezvous_channel send/recv round trip", bench_pingpong, 200000, 1, 1},
+  {"chan.buffered.1x1", "buffered_channel<int,1024>, 1 producer x 1 consumer", bench_buffered, 1000000, 1, 1},
+  {"chan.buffered.4x4", "buffered_channel<int,1024>, 4 producers x 4 consumers", bench_buffered, 1000000, 4, 4},
+  {"chan.buffered.8x8", "buffered_channel<int,1024>, 8 producers x 8 consumers", bench_buffered, 1000000, 8, 8},
+  {"chan.copy.64", "buffered copy of a 64 B element", bench_copy<64>, 500000, 1, 1},
+  {"chan.zref.64", "ZRefBufferedChannel, 64 B payload", bench_zref<64>, 500000, 1, 1},
+  {"chan.copy.4096", "buffered copy of a 4 KiB element", bench_copy<4096>, 200000, 1, 1},
+  {"chan.zref.4096", "ZRefBufferedChannel, 4 KiB payload", bench_zref<4096>, 200000, 1, 1},
+  {"chan.copy.65536", "buffered copy of a 64 KiB element", bench_copy<65536>, 20000, 1, 1},
+  {"chan.zref.65536", "ZRefBufferedChannel, 64 KiB payload", bench_zref<65536>, 20000, 1, 1},
+  {"select.fan_in.4", "select() over 4 buffered channels, 1 producer each", bench_fan_in, 400000, 4, 1},
+  {"timer.sleep_1ms", "sleep_ms(1) latency, 16 concurrent sleepers", bench_sleep, 100, 16, 0},
+};
+
+struct Stats { double mean, median, stddev, ci_lo, ci_hi, min, max; };
+
+// Two-sided 95% Student t for df 1..30; 1.96 beyond
+double t95(int df) {
+  static const double t[] = {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042,
+  };
+  return df >= 1 && df <= 30 ? t[df - 1] : 1.96;
+}
+
+Stats compute_stats(std::vector<double> v) {
+  std::sort(v.begin(), v.end());
+  const int n = (int)v.size();
+  Stats st{};
+  for (double x : v) st.mean += x;
+  st.mean /= n;
+  double sq = 0;
+  for (double x : v) sq += (x - st.mean) * (x - st.mean);
+  st.stddev = n > 1 ? std::sqrt(sq / (n - 1)) : 0.0;
+  st.median = n % 2 ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2;
+  double half = n > 1 ? t95(n - 1) * st.stddev / std::sqrt((double)n) : 0.0;
+  st.ci_lo = st.mean - half; st.ci_hi = st.mean + half;
+  st.min = v.front(); st.max = v.back();
+  return st;
+}
+
+struct Result { const Case* c; long ops; std::vector<double> samples; Stats st; };
+
+void write_json(FILE* f, const std::vector<Result>& res, int reps, int warmup, double scale) {
+  struct utsname u;
+  if (uname(&u) != 0) std::strcpy(u.machine, "unknown");
+  char ts[32];
+  std::time_t t = std::time(nullptr);
+  std::strftime(ts, sizeof(ts), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&t));
+  std::fprintf(f, "{\n  \"schema\": \"kcoro-bench-1\",\n  \"tool\": \"kcoro_cpp_bench\",\n");
+  std::fprintf(f, "  \"machine\": \"%s\",\n  \"cpus\": %u,\n  \"timestamp\": \"%s\",\n", u.machine,
+               std::thread::hardware_concurrency(), ts);
+  std::fprintf(f, "  \"reps\": %d,\n  \"warmup\": %d,\n  \"scale\": %g,\n  \"results\": [\n", reps, warmup, scale);
+  for (size_t i = 0; i < res.size(); i++) {
+    const Result& r = res[i];
+    std::fprintf(f, "%s    {\"name\": \"%s\", \"unit\": \"ns/op\", \"ops\": %ld, \"reps\": %d, "
+                    "\"mean\": %.3f, \"median\": %.3f, \"stddev\": %.3f, \"ci95_lo\": %.3f, \"ci95_hi\": %.3f, "
+                    "\"min\": %.3f, \"max\": %.3f, \"samples\": [",
+                 i ? ",\n" : "", r.c->name, r.ops, (int)r.samples.size(), r.st.mean, r.st.median, r.st.stddev,
+                 r.st.ci_lo, r.st.ci_hi, r.st.min, r.st.max);
+    for (size_t k = 0; k < r.samples.size(); k++) std::fprintf(f, "%s%.3f", k ? ", " : "", r.samples[k]);
+    std::fprintf(f, "]}");
+  }
+  std::fprintf(f, "\n  ]\n}\n");
+}
+
+void usage(const char* prog) {
+  std::fprintf(stderr,
+               "Usage: %s [-r reps] [-w warmup] [-s scale] [-f filter] [-o out.json] [-l]\n"
+               "  Compare results with: kcbench -c baseline.json current.json\n", prog);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  int reps = 5, warmup = 1, opt;
+  double scale = 1.0;
+  bool list = false;
+  const char* out_path = nullptr;
+  std::vector<std::string> filters;
+  while ((opt = getopt(argc, argv, "r:w:s:f:o:lh")) != -1) {
+    switch (opt) {
+      case 'r': reps = std::atoi(optarg); break;
+      case 'w': warmup = std::atoi(optarg); break;
+      case 's': scale = std::atof(optarg); break;
+      case 'f': filters.emplace_back(optarg); break;
+      case 'o': out_path = optarg; break;
+      case 'l': list = true; break;
+      default: usage(argv[0]); return 2;
+    }
+  }
+  if (list) {
+    for (const Case& c : kCases) std::printf("%-22s %s\n", c.name, c.desc);
+    return 0;
+  }
+  if (reps < 1 || warmup < 0 || scale <= 0) { usage(argv[0]); return 2; }
+
+  WorkStealingScheduler sched;
+  std::vector<Result> res;
+  int failed = 0;
+  std::printf("%-22s %10s %12s %12s %12s %12s\n", "case", "ops", "median", "mean", "ci95 +/-", "Mops/s");
+  for (const Case& c : kCases) {
+    if (!filters.empty() && std::none_of(filters.begin(), filters.end(),
+                                         [&](const std::string& f) { return std::strstr(c.name, f.c_str()); }))
+      continue;
+    Result r{&c, std::max(1L, (long)(c.ops * scale)), {}, {}};
+    if (c.p && c.c) r.ops = std::max(1L, r.ops / (c.p * c.c)) * c.p * c.c;
+    bool ok = true;
+    for (int k = -warmup; k < reps && ok; k++) {
+      long ns = c.fn(sched, c, r.ops);
+      if (ns < 0) ok = false;
+      else if (k >= 0) r.samples.push_back((double)ns / (double)r.ops);
+    }
+    if (!ok) { std::printf("%-22s failed\n", c.name); failed++; continue; }
+    r.st = compute_stats(r.samples);
+    std::printf("%-22s %10ld %12.1f %12.1f %12.1f %12.3f\n", c.name, r.ops, r.st.median, r.st.mean,
+                (r.st.ci_hi - r.st.ci_lo) / 2, r.st.median > 0 ? 1e3 / r.st.median : 0.0);
+    std::fflush(stdout);
+    res.push_back(std::move(r));
+  }
+  sched.drain(1000);
+  sched.stop_and_join();
+  if (out_path) {
+    FILE* f = std::strcmp(out_path, "-") == 0 ? stdout : std::fopen(out_path, "w");
+    if (!f) { std::perror(out_path); return 2; }
+    write_json(f, res, reps, warmup, scale);
+    if (f != stdout) std::fclose(f);
+  }
+  return failed ? 2 : 0;
+}
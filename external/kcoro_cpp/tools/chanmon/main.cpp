@@ -84,6 +84,17 @@ static void chanmon_fn(void* arg) {
   }
 }
 
+// Scheduler counters, sampled from the main thread once per second
+static void print_sched(const char* tag, const WorkStealingScheduler& sched) {
+  auto st = sched.stats();
+  std::printf("[sched %s] tasks=%lu/%lu ready=%lu local=%lu global=%lu fast=%lu/%lu steals=%lu probes=%lu inject=%lu parks=%lu\n",
+              tag, (unsigned long)st.tasks_completed, (unsigned long)st.tasks_submitted,
+              (unsigned long)st.ready_enqueued, (unsigned long)st.ready_local, (unsigned long)st.ready_global,
+              (unsigned long)st.fastpath_hits, (unsigned long)(st.fastpath_hits + st.fastpath_misses),
+              (unsigned long)st.steals, (unsigned long)st.steal_probes, (unsigned long)st.inject_pulls,
+              (unsigned long)st.parks);
+}
+
 int main(int argc, char** argv) {
   Args a; if (!parse(argc, argv, a)) return 1;
   WorkStealingScheduler sched;
@@ -119,8 +130,12 @@ int main(int argc, char** argv) {
   for (int i=0;i<a.consumers;i++) sched.spawn_co([](void* p){ consumer_fn(p); }, data.get());
 
   // Run for duration
-  for (int i=0;i<a.seconds*10;i++) std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  for (int i=0;i<a.seconds*10;i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    if (i % 10 == 9) print_sched("run", sched);
+  }
   data->close(); metrics_pipe.close();
   sched.drain(1000);
+  print_sched("final", sched);
   return 0;
 }
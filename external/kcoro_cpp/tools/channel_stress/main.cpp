@@ -1,4 +1,4 @@
-#include "kcoro_cpp/channel.hpp"
+#include "kcoro_cpp/static_channel.hpp"
 #include "kcoro_cpp/logger.hpp"
 #include "kcoro_cpp/scheduler.hpp"
 #include <atomic>
@@ -15,6 +15,10 @@ using namespace kcoro_cpp;
 
 namespace {
 
+// Capacity is part of the channel type (ring mask folded at compile time)
+constexpr size_t kChannelCapacity = 256;
+using StressChannel = buffered_channel<int, kChannelCapacity>;
+
 void enable_core_dumps() {
 #if defined(__unix__) || defined(__APPLE__)
   rlimit rl;
@@ -25,7 +29,7 @@ void enable_core_dumps() {
 }
 
 struct ProducerCtx {
-  BufferedChannel<int>* chan;
+  StressChannel* chan;
   int messages;
   int timeout_ms;
   std::atomic<int>* produced;
@@ -33,7 +37,7 @@ struct ProducerCtx {
 };
 
 struct ConsumerCtx {
-  BufferedChannel<int>* chan;
+  StressChannel* chan;
   int timeout_ms;
   std::atomic<int>* consumed;
   std::atomic<int>* timeouts;
@@ -89,14 +93,13 @@ int main(int argc, char** argv) {
   int consumer_count = 8;
   int messages_per_producer = 200000;
   int timeout_ms = 5;
-  size_t channel_capacity = 256;
 
   if (argc > 1) producer_count = std::atoi(argv[1]);
   if (argc > 2) consumer_count = std::atoi(argv[2]);
   if (argc > 3) messages_per_producer = std::atoi(argv[3]);
 
   auto* sched = sched_default();
-  BufferedChannel<int> channel(sched, channel_capacity);
+  StressChannel channel(sched);
 
   std::atomic<int> produced{0};
   std::atomic<int> consumed{0};
@@ -131,17 +134,20 @@ int main(int argc, char** argv) {
   auto end = std::chrono::steady_clock::now();
   double seconds = std::chrono::duration_cast<std::chrono::duration<double>>(end - start).count();
 
-  log_info("kcoro_cpp buffered channel stress summary:");
-  log_info(" producers=" + std::to_string(producer_count) +
-           " consumers=" + std::to_string(consumer_count) +
-           " messages_per_producer=" + std::to_string(messages_per_producer));
-  log_info(" produced=" + std::to_string(produced.load()) +
-           " consumed=" + std::to_string(consumed.load()));
-  log_info(" producer_timeouts=" + std::to_string(prod_timeouts.load()) +
-           " consumer_timeouts=" + std::to_string(cons_timeouts.load()) +
-           " consumer_epipe=" + std::to_string(cons_epipe.load()));
-  log_info(" elapsed=" + std::to_string(seconds) +
-           "s throughput=" + std::to_string(seconds > 0 ? consumed.load() / (seconds * 1e6) : 0.0) + " M msg/s");
+  log_fmt(LogLevel::Info, "kcoro_cpp buffered channel stress summary:");
+  log_fmt(LogLevel::Info, " producers={} consumers={} messages_per_producer={}",
+          producer_count, consumer_count, messages_per_producer);
+  log_fmt(LogLevel::Info, " produced={} consumed={}", produced.load(), consumed.load());
+  log_fmt(LogLevel::Info, " producer_timeouts={} consumer_timeouts={} consumer_epipe={}",
+          prod_timeouts.load(), cons_timeouts.load(), cons_epipe.load());
+  log_fmt(LogLevel::Info, " elapsed={}s throughput={} M msg/s",
+          seconds, seconds > 0 ? consumed.load() / (seconds * 1e6) : 0.0);
+
+  auto st = sched->stats();
+  log_fmt(LogLevel::Info, " sched ready={} local={} global={} steals={} inject={} parks={}",
+          st.ready_enqueued, st.ready_local, st.ready_global, st.steals, st.inject_pulls, st.parks);
+  auto ls = Logger::instance().stats();
+  log_fmt(LogLevel::Info, " logger written={} dropped={}", ls.written, ls.dropped);
 
   Logger::instance().flush();
 
@@ -0,0 +1,39 @@
+// Allocation counting for the allocation-free tests: global operator new is
+// replaced to count every heap allocation, in total (g_news) and on the
+// calling thread (t_news). The aligned overloads are replaced too, so
+// over-aligned types (the alignas(64) scheduler blocks) are counted like any
+// other. Defines the replacement operators: include it from exactly one
+// translation unit of a test.
+#pragma once
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<long> g_news{0};
+static thread_local long t_news = 0;
+
+void* operator new(std::size_t n) {
+  g_news.fetch_add(1, std::memory_order_relaxed);
+  ++t_news;
+  if (void* p = std::malloc(n ? n : 1)) return p;
+  throw std::bad_alloc();
+}
+
+void* operator new(std::size_t n, std::align_val_t al) {
+  g_news.fetch_add(1, std::memory_order_relaxed);
+  ++t_news;
+  // aligned_alloc wants a size that is a non-zero multiple of the alignment
+  std::size_t a = static_cast<std::size_t>(al);
+  if (void* p = std::aligned_alloc(a, (n ? n + a - 1 : a) / a * a)) return p;
+  throw std::bad_alloc();
+}
+
+// GCC flags free() in a replaced operator delete as a mismatch
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+#pragma GCC diagnostic pop
@@ -0,0 +1,106 @@
+// Stackless coroutines: many AsyncTasks fed by a stackful producer, a
+// stackless/stackful ping-pong over rendezvous channels, co_await select
+// across dynamic and static channels (including EPIPE on close), and
+// co_await sched.sleep().
+#include "kcoro_cpp/scheduler.hpp"
+#include "kcoro_cpp/channel.hpp"
+#include "kcoro_cpp/static_channel.hpp"
+#include "kcoro_cpp/await.hpp"
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+using namespace kcoro_cpp;
+
+constexpr int kTasks = 2000;
+constexpr int kRounds = 500;
+
+static std::atomic<int> g_done{0};
+static std::atomic<long> g_sum{0};
+
+static void wait_for(const std::atomic<int>& n, int want) {
+  for (int i = 0; i < 5000 && n.load() < want; i++) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  assert(n.load() == want);
+}
+
+static AsyncTask consume_one(BufferedChannel<int>& ch) {
+  int v = 0;
+  if (co_await async_recv(ch, v) == 0) g_sum += v;
+  g_done++;
+}
+
+static AsyncTask pinger(RendezvousChannel<int>& ping, RendezvousChannel<int>& pong, int* bad) {
+  for (int i = 0; i < kRounds; i++) {
+    int back = -1;
+    if (co_await async_send(ping, i) != 0 || co_await async_recv(pong, back) != 0 || back != i + 1) (*bad)++;
+  }
+  ping.close();
+  g_done++;
+}
+
+static AsyncTask selector(BufferedChannel<int>& a, rendezvous_channel<int>& b, int* from_a, int* from_b, int* epipe) {
+  int x = 0, y = 0;
+  for (;;) {
+    SelectResult r = co_await select(on_recv(a, &x), on_recv(b, &y));
+    if (r.rc == KC_EPIPE) { (*epipe)++; break; }
+    if (r.rc != 0) break;
+    if (r.index == 0) *from_a += x; else *from_b += y;
+  }
+  g_done++;
+}
+
+static AsyncTask sleeper(WorkStealingScheduler& s, long* elapsed_ms) {
+  auto t0 = std::chrono::steady_clock::now();
+  co_await s.sleep(20);
+  co_await s.sleep(0);
+  *elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0).count();
+  g_done++;
+}
+
+int main(){
+  WorkStealingScheduler s(4);
+  {
+    // Thousands of frames parked on one channel; a stackful producer feeds them
+    static BufferedChannel<int> ch(&s, 8);
+    g_done = 0; g_sum = 0;
+    for (int i = 0; i < kTasks; i++) spawn_async(s, consume_one(ch));
+    s.spawn_co([](void*){ for (int i = 1; i <= kTasks; i++) ch.send(i, -1); }, nullptr);
+    wait_for(g_done, kTasks);
+    assert(g_sum == (long)kTasks * (kTasks + 1) / 2);
+  }
+  {
+    static RendezvousChannel<int> ping(&s), pong(&s);
+    static int bad = 0;
+    g_done = 0;
+    s.spawn_co([](void*){ int v; while (ping.recv(v, -1) == 0) pong.send(v + 1, -1); }, nullptr);
+    spawn_async(s, pinger(ping, pong, &bad));
+    wait_for(g_done, 1);
+    assert(bad == 0);
+  }
+  {
+    static BufferedChannel<int> a(&s, 4);
+    static rendezvous_channel<int> b(&s);
+    static int from_a = 0, from_b = 0, epipe = 0;
+    g_done = 0;
+    spawn_async(s, selector(a, b, &from_a, &from_b, &epipe), Lane::Bulk);
+    s.spawn_co([](void*){
+      for (int i = 1; i <= 100; i++) { a.send(i, -1); b.send(2 * i, -1); }
+      // Let the buffered side drain before closing the rendezvous one
+      while (a.snapshot().total_recvs < 100) kcoro_cpp::sched_yield();
+      b.close();
+    }, nullptr);
+    wait_for(g_done, 1);
+    std::printf("select: a=%d b=%d epipe=%d\n", from_a, from_b, epipe);
+    assert(from_a == 5050 && from_b == 10100 && epipe == 1);
+  }
+  {
+    static long elapsed = 0;
+    g_done = 0;
+    spawn_async(s, sleeper(s, &elapsed));
+    wait_for(g_done, 1);
+    assert(elapsed >= 20);
+  }
+  s.stop_and_join();
+  return 0;
+}
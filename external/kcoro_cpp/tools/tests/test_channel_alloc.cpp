@@ -0,0 +1,87 @@
+// Channel allocation budget: once warmed up, buffered and rendezvous
+// channels (dynamic and static) and a reused SelectT move values and park
+// coroutines without touching the heap. Global operator new is replaced to
+// count allocations inside each steady-state window.
+#include "kcoro_cpp/scheduler.hpp"
+#include "kcoro_cpp/channel.hpp"
+#include "kcoro_cpp/static_channel.hpp"
+#include "kcoro_cpp/select_t.hpp"
+#include "alloc_count.hpp"
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+using namespace kcoro_cpp;
+
+constexpr int kWarm = 64;
+constexpr int kSteady = 20000;
+
+// Producer side measures: the window covers its sends and every receive and
+// park interleaved with them on the single worker.
+template<typename Ch>
+struct Pair { Ch* ch; long mark{0}; long allocs{-1}; long sum{0}; int got{0}; };
+
+template<typename Ch>
+static void run_pair(WorkStealingScheduler& s, Ch& ch, const char* name) {
+  static Pair<Ch> p; p = Pair<Ch>{&ch};
+  s.spawn_co([](void*){
+    for (int i = 0; i < kWarm + kSteady; i++) {
+      if (i == kWarm) p.mark = g_news.load();
+      p.ch->send(i, -1);
+    }
+    p.allocs = g_news.load() - p.mark;
+    p.ch->close();
+  }, nullptr);
+  s.spawn_co([](void*){ int v = 0; while (p.ch->recv(v, -1) == 0) { p.sum += v; p.got++; } }, nullptr);
+  s.drain(5000);
+  const int n = kWarm + kSteady;
+  assert(p.got == n && p.sum == (long)n * (n - 1) / 2);
+  std::printf("%s: %ld allocations in steady state\n", name, p.allocs);
+  assert(p.allocs == 0);
+}
+
+struct SelEnv { BufferedChannel<int>* buf; RendezvousChannel<int>* rv; long mark{0}; long allocs{-1}; int got{0}; int bad{0}; };
+
+int main(){
+  WorkStealingScheduler s(1);
+  {
+    // Four slots force both sides to park every few elements
+    BufferedChannel<int> ch(&s, 4);
+    run_pair(s, ch, "buffered");
+  }
+  {
+    RendezvousChannel<int> ch(&s);
+    run_pair(s, ch, "rendezvous");
+  }
+  {
+    buffered_channel<int, 4> ch(&s);
+    run_pair(s, ch, "static buffered");
+  }
+  {
+    rendezvous_channel<int> ch(&s);
+    run_pair(s, ch, "static rendezvous");
+  }
+  {
+    // One SelectT reused across waits: clause nodes are recycled by the
+    // channels on match and cancel
+    BufferedChannel<int> buf(&s, 4); RendezvousChannel<int> rv(&s);
+    static SelEnv e; e = SelEnv{&buf, &rv};
+    s.spawn_co([](void*){
+      SelectT<int> sel; int out = -1, idx = -1;
+      sel.add_recv(e.buf, &out); sel.add_recv(e.rv, &out);
+      for (int i = 0; i < kWarm + kSteady; i++) {
+        if (i == kWarm) e.mark = g_news.load();
+        if (sel.wait(-1, &idx) != 0 || idx != (out & 1)) e.bad++;
+        e.got++;
+      }
+      e.allocs = g_news.load() - e.mark;
+    }, nullptr);
+    s.spawn_co([](void*){ for (int i = 0; i < kWarm + kSteady; i++) { if (i & 1) e.rv->send(i, -1); else e.buf->send(i, -1); } }, nullptr);
+    s.drain(5000);
+    std::printf("select: %ld allocations in steady state\n", e.allocs);
+    assert(e.got == kWarm + kSteady && e.bad == 0 && e.allocs == 0);
+  }
+  s.stop_and_join();
+  return 0;
+}
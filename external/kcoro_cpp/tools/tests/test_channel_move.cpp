@@ -0,0 +1,101 @@
+// Move-only and large values: unique_ptr through static rings and
+// rendezvous, emplace, no copies of a tracked type on rvalue paths, slot
+// destruction for elements left in a ring, a failed send leaving its value
+// intact, and vector buffers arriving with their original storage.
+#include "kcoro_cpp/scheduler.hpp"
+#include "kcoro_cpp/channel.hpp"
+#include "kcoro_cpp/static_channel.hpp"
+#include <cassert>
+#include <cstdio>
+#include <memory>
+#include <vector>
+using namespace kcoro_cpp;
+
+struct Tracked {
+  static inline int copies = 0, live = 0;
+  int v{0};
+  Tracked() { ++live; }
+  explicit Tracked(int x) : v(x) { ++live; }
+  Tracked(const Tracked& o) : v(o.v) { ++copies; ++live; }
+  Tracked(Tracked&& o) noexcept : v(o.v) { ++live; }
+  Tracked& operator=(const Tracked& o) { v = o.v; ++copies; return *this; }
+  Tracked& operator=(Tracked&&) noexcept = default;
+  ~Tracked() { --live; }
+};
+
+struct Big { int seq; char pad[4092]; };
+static_assert(std::is_trivially_copyable_v<Big>);
+
+using Ptr = std::unique_ptr<int>;
+using Vec = std::vector<int>;
+constexpr int N = 1000;
+
+struct Env {
+  rendezvous_channel<Vec>* rv; RendezvousChannel<Vec>* dyn; rendezvous_channel<Vec>* dead;
+  const int* sent[N]{}; int same{0}; int got{0}; int epipe{0};
+};
+
+int main(){
+  WorkStealingScheduler s(1);
+  {
+    buffered_channel<Ptr, 4> ch(&s);
+    for (int i = 0; i < 3; i++) assert(ch.send(std::make_unique<int>(i), 0) == 0);
+    assert(ch.emplace(new int(3)) == 0);
+    Ptr extra = std::make_unique<int>(4);
+    assert(ch.send(std::move(extra), 0) == KC_EAGAIN && extra && *extra == 4);
+    Ptr out;
+    for (int i = 0; i < 4; i++) assert(ch.recv(out, 0) == 0 && out && *out == i);
+    ch.close();
+    assert(ch.send(std::move(extra), 0) == KC_EPIPE && extra);
+  }
+  {
+    // rvalues are moved in and out; leftovers are destroyed with the ring
+    {
+      buffered_channel<Tracked, 4> ch(&s);
+      Tracked t(7), out;
+      assert(ch.send(std::move(t), 0) == 0 && ch.emplace(8) == 0 && ch.emplace(9) == 0);
+      assert(ch.recv(out, 0) == 0 && out.v == 7 && Tracked::copies == 0);
+      assert(Tracked::live == 4);
+      assert(ch.send(out, 0) == 0 && Tracked::copies == 1);
+      BufferedChannel<Tracked> dyn(&s, 4);
+      assert(dyn.send(Tracked(5), 0) == 0 && dyn.recv(out, 0) == 0 && out.v == 5 && Tracked::copies == 1);
+    }
+    assert(Tracked::live == 0);
+  }
+  {
+    buffered_channel<Big, 2> ch(&s);
+    Big b{}; b.seq = 11; b.pad[4091] = 'x';
+    assert(ch.send(b, 0) == 0 && ch.emplace() == 0);
+    Big out{};
+    assert(ch.recv(out, 0) == 0 && out.seq == 11 && out.pad[4091] == 'x');
+    assert(ch.recv(out, 0) == 0 && out.seq == 0);
+    assert(ch.snapshot().total_bytes_sent == 2 * sizeof(Big));
+  }
+  {
+    rendezvous_channel<Vec> rv(&s), dead(&s); RendezvousChannel<Vec> dyn(&s);
+    static Env e; e = Env{&rv, &dyn, &dead};
+    s.spawn_co([](void*){
+      for (int i = 0; i < N; i++) {
+        Vec v(64, i); e.sent[i] = v.data();
+        if (i & 1) e.dyn->send(std::move(v), -1); else e.rv->send(std::move(v), -1);
+      }
+      // Nobody receives: close hands the value back untouched
+      Vec keep(8, 1);
+      if (e.dead->send(std::move(keep), -1) == KC_EPIPE && keep.size() == 8) e.epipe++;
+    }, nullptr);
+    s.spawn_co([](void*){
+      Vec v;
+      for (int i = 0; i < N; i++) {
+        int rc = (i & 1) ? e.dyn->recv(v, -1) : e.rv->recv(v, -1);
+        if (rc == 0 && v.size() == 64 && v[0] == i) e.got++;
+        if (v.data() == e.sent[i]) e.same++;
+      }
+      e.dead->close();
+    }, nullptr);
+    s.drain(5000);
+    std::printf("moved vectors: %d/%d kept their buffer\n", e.same, N);
+    assert(e.got == N && e.same == N && e.epipe == 1);
+  }
+  s.stop_and_join();
+  return 0;
+}
@@ -1,4 +1,4 @@
-// Stress tests for Channel<T> implementations: Rendezvous, Buffered, Unlimited
+// Stress tests for Channel<T> implementations: Rendezvous, Buffered, Unlimited, Spsc
 #include "kcoro_cpp/scheduler.hpp"
 #include "kcoro_cpp/channel.hpp"
 #include "kcoro_cpp/select_t.hpp"
@@ -7,9 +7,17 @@
 #include <atomic>
 #include <random>
 #include <chrono>
+#include <thread>
 
 using namespace kcoro_cpp;
 
+static int g_failed = 0;
+
+static bool wait_for(const std::atomic<int>& v, int want){
+  for (int i=0;i<2000 && v.load() < want;i++) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  return v.load() >= want;
+}
+
 struct Msg {
   uint32_t pid;
   uint32_t seq;
@@ -117,11 +125,127 @@ static void test_rendezvous_pair_mpmc(){
   std::printf("[ok] rendezvous<pair> consumed=%ld\n", consumed.load());
 }
 
+struct BatchEnv {
+  BufferedChannel<int>* ch; std::atomic<long> consumed{0}; std::atomic<int> bad_sends{0}, bad_recvs{0};
+};
+
+static void test_buffered_int_batch(){
+  std::puts("[test] buffered<int> batch 1x1");
+  WorkStealingScheduler sched(2);
+  BufferedChannel<int> ch(&sched, 128);
+  constexpr int kRounds = 2000, kBatch = 48;
+  BatchEnv env{&ch};
+  sched.spawn_co([](void* p){
+    auto* e = static_cast<BatchEnv*>(p);
+    std::vector<int> batch(kBatch);
+    for (int round=0; round<kRounds; ++round) {
+      for (int i=0;i<kBatch;i++) batch[i] = round*kBatch + i;
+      size_t sent=0; int rc = e->ch->send_many(batch, -1, &sent);
+      if (rc != 0 || sent != (size_t)kBatch) { e->bad_sends.fetch_add(1); break; }
+    }
+  }, &env);
+  sched.spawn_co([](void* p){
+    auto* e = static_cast<BatchEnv*>(p);
+    std::vector<int> out(64);
+    int expect = 0;
+    for(;;){
+      size_t got=0; int rc = e->ch->recv_many(out, -1, &got);
+      if (rc == KC_EPIPE) { if (got != 0) e->bad_recvs.fetch_add(1); break; }
+      if (rc != 0 || got == 0 || got > out.size()) { e->bad_recvs.fetch_add(1); break; }
+      for (size_t i=0;i<got;i++) if (out[i] != expect++) e->bad_recvs.fetch_add(1);
+      e->consumed.fetch_add((long)got, std::memory_order_relaxed);
+    }
+  }, &env);
+  sched.drain(3000);
+  ch.close(); sched.drain(500); sched.stop_and_join();
+  if (env.consumed.load() != (long)kRounds*kBatch || env.bad_sends.load() || env.bad_recvs.load()) {
+    std::fprintf(stderr, "[fail] buffered<int> batch consumed=%ld (want %d) bad_sends=%d bad_recvs=%d\n",
+                 env.consumed.load(), kRounds*kBatch, env.bad_sends.load(), env.bad_recvs.load());
+    g_failed++; return;
+  }
+  std::printf("[ok] buffered<int> batch consumed=%ld\n", env.consumed.load());
+}
+
+static void test_spsc_int(){
+  std::puts("[test] spsc<int> 1x1");
+  WorkStealingScheduler sched(2);
+  SpscChannel<int> ch(&sched, 64);
+  std::atomic<long> consumed{0};
+  int rounds = 200000;
+  std::tuple<IChannel<int>*, int, int> p1{&ch, 1, rounds};
+  std::tuple<IChannel<int>*, std::atomic<long>*> c1{&ch, &consumed};
+  sched.spawn_co([](void* p){ prod_int(p); }, &p1);
+  sched.spawn_co([](void* p){ cons_int(p); }, &c1);
+  sched.drain(3000);
+  ch.close(); sched.drain(500); sched.stop_and_join();
+  auto snap = ch.snapshot();
+  if (consumed.load() != rounds || snap.total_sends != (unsigned long)rounds || snap.total_recvs != (unsigned long)rounds) {
+    std::fprintf(stderr, "[fail] spsc<int> consumed=%ld sends=%lu recvs=%lu (want %d)\n", consumed.load(), snap.total_sends, snap.total_recvs, rounds);
+    g_failed++; return;
+  }
+  std::printf("[ok] spsc<int> consumed=%ld sends=%lu recvs=%lu\n", consumed.load(), snap.total_sends, snap.total_recvs);
+}
+
+// A select recv parked on the empty ring is completed by a later send, and
+// a select send parked on the full ring by a later recv (as test_chan_spsc.c)
+struct SpscSelectEnv {
+  WorkStealingScheduler* sched; SpscChannel<int>* ch; std::atomic<int> stage{0};
+  int recv_rc{1}, recv_idx{-1}, recv_val{-1}; int send_rc{1}, send_idx{-1}; int late_got[3]{-1, -1, -1};
+};
+
+static void test_spsc_select(){
+  std::puts("[test] spsc<int> select");
+  WorkStealingScheduler sched(2);
+  SpscChannel<int> ch(&sched, 2);
+  SpscSelectEnv env{&sched, &ch};
+  sched.spawn_co([](void* p){
+    auto* e = static_cast<SpscSelectEnv*>(p);
+    SelectT<int> sel; sel.add_recv(e->ch, &e->recv_val);
+    e->recv_rc = sel.wait(5000, &e->recv_idx);
+    e->stage.fetch_add(1);
+  }, &env);
+  sched.spawn_co([](void* p){
+    auto* e = static_cast<SpscSelectEnv*>(p);
+    e->sched->sleep_ms(20);
+    e->ch->send(99, -1);
+  }, &env);
+  bool ok_recv = wait_for(env.stage, 1);
+  sched.spawn_co([](void* p){
+    auto* e = static_cast<SpscSelectEnv*>(p);
+    for (int i=0;i<2;i++) if (e->ch->send(i, 0) != 0) return;
+    int v = 7;
+    SelectT<int> sel; sel.add_send(e->ch, &v);
+    e->send_rc = sel.wait(-1, &e->send_idx);
+    e->stage.fetch_add(1);
+  }, &env);
+  sched.spawn_co([](void* p){
+    auto* e = static_cast<SpscSelectEnv*>(p);
+    e->sched->sleep_ms(20);
+    for (int& v : e->late_got) if (e->ch->recv(v, -1) != 0) break;
+    e->stage.fetch_add(1);
+  }, &env);
+  bool ok_send = wait_for(env.stage, 3);
+  ch.close(); sched.drain(500); sched.stop_and_join();
+  if (!ok_recv || env.recv_rc != 0 || env.recv_idx != 0 || env.recv_val != 99) {
+    std::fprintf(stderr, "[fail] spsc select recv rc=%d idx=%d val=%d\n", env.recv_rc, env.recv_idx, env.recv_val);
+    g_failed++; return;
+  }
+  if (!ok_send || env.send_rc != 0 || env.send_idx != 0 || env.late_got[0] != 0 || env.late_got[1] != 1 || env.late_got[2] != 7) {
+    std::fprintf(stderr, "[fail] spsc select send rc=%d idx=%d got=%d,%d,%d\n", env.send_rc, env.send_idx,
+                 env.late_got[0], env.late_got[1], env.late_got[2]);
+    g_failed++; return;
+  }
+  std::puts("[ok] spsc<int> select");
+}
+
 int main(){
   test_buffered_int_mpmc();
   test_buffered_pair_mpmc();
   test_unlimited_pair_mpmc();
   test_rendezvous_pair_mpmc();
-  return 0;
+  test_buffered_int_batch();
+  test_spsc_int();
+  test_spsc_select();
+  return g_failed ? 1 : 0;
 }
 
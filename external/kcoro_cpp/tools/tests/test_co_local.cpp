@@ -0,0 +1,60 @@
+// Coroutine-local storage: every coroutine sees its own CoroutineLocal value
+// across yields, values are destroyed when the coroutine returns (also for
+// recycled coroutines, which start empty), and keys past the inline slots
+// work the same way.
+#include "kcoro_cpp/scheduler.hpp"
+#include "kcoro_cpp/coroutine_local.hpp"
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <string>
+using namespace kcoro_cpp;
+
+constexpr int kCos = 64;
+
+struct Tracked {
+  static std::atomic<int> live;
+  int v = 0;
+  Tracked() { live.fetch_add(1); }
+  ~Tracked() { live.fetch_sub(1); }
+};
+std::atomic<int> Tracked::live{0};
+
+static CoroutineLocal<Tracked> g_req;
+static CoroutineLocal<std::string> g_span;
+static CoroutineLocal<int> g_pad[kClsInline];   // pushes g_far past the inline slots
+static CoroutineLocal<int> g_far;
+
+struct Env {
+  WorkStealingScheduler* s;
+  std::atomic<int> done{0}, fresh{0};
+};
+static Env e;
+
+int main(){
+  WorkStealingScheduler s(2);
+  e.s = &s;
+  for (int i = 0; i < kCos; i++) {
+    s.spawn_co([](void* arg){
+      int id = (int)(intptr_t)arg;
+      if (!g_req.get_if() && !g_span.get_if() && !g_far.get_if()) e.fresh.fetch_add(1);
+      g_req->v = id;
+      g_span.set("span-" + std::to_string(id));
+      *g_far = id * 3;
+      for (int k = 0; k < 5; k++) {
+        e.s->yield();
+        assert(g_req->v == id && *g_span == "span-" + std::to_string(id) && *g_far == id * 3);
+      }
+      if (id % 2) g_span.reset();
+      e.done.fetch_add(1);
+    }, (void*)(intptr_t)i);
+  }
+  for (int i = 0; i < 10000 && e.done.load() < kCos; i++) s.drain(10);
+  s.drain(200);
+  std::printf("co local: done=%d fresh=%d live=%d\n", e.done.load(), e.fresh.load(), Tracked::live.load());
+  assert(e.done.load() == kCos && e.fresh.load() == kCos);
+  assert(Tracked::live.load() == 0);
+  (void)g_pad;
+  s.stop_and_join();
+  return 0;
+}
@@ -0,0 +1,45 @@
+// Coroutine recycling: waves of short coroutines spawned from a coroutine are
+// served from the worker pool once the first wave has retired, a late
+// wake_after on a finished coroutine is dropped, and shutdown frees pooled
+// and retired coroutines.
+#include "kcoro_cpp/scheduler.hpp"
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+using namespace kcoro_cpp;
+
+constexpr int kWaves = 500, kWidth = 8;
+
+struct Env {
+  WorkStealingScheduler* s;
+  std::atomic<int> ran{0};
+  std::atomic<bool> done{false};
+};
+static Env e;
+
+int main(){
+  WorkStealingScheduler s(2);
+  e.s = &s;
+  s.spawn_co([](void*){
+    for (int wave = 0; wave < kWaves; wave++) {
+      int target = (wave + 1) * kWidth;
+      for (int i = 0; i < kWidth; i++) e.s->spawn_co([](void*){
+        // Arm a wake that outlives the coroutine: retire must disarm it
+        e.s->wake_after(Coroutine::current(), 50);
+        e.ran.fetch_add(1);
+      }, nullptr);
+      while (e.ran.load() < target) e.s->yield();
+    }
+    e.done.store(true);
+  }, nullptr);
+  for (int i = 0; i < 10000 && !e.done.load(); i++) s.drain(10);
+  s.drain(200);
+  auto st = s.stats();
+  std::printf("co recycle: ran=%d created=%llu reused=%llu\n", e.ran.load(),
+              (unsigned long long)st.coroutines_created, (unsigned long long)st.coroutines_reused);
+  assert(e.done.load() && e.ran.load() == kWaves * kWidth);
+  assert(st.coroutines_created + st.coroutines_reused == (uint64_t)kWaves * kWidth + 1);
+  assert(st.coroutines_reused > st.coroutines_created);
+  s.stop_and_join();
+  return 0;
+}
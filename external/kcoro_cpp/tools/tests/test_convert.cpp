@@ -0,0 +1,105 @@
+// Format conversion kernels: every half survives FP16 -> FP32 -> FP16, the
+// bulk (hardware) paths agree bit for bit with the scalar references,
+// narrowing rounds to nearest even and saturates, NaNs stay NaN, and
+// convert_rows honours both row pitches.
+#include "kcoro_cpp/convert.hpp"
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+using namespace kcoro_cpp;
+
+static uint32_t bits(float f) { uint32_t u; std::memcpy(&u, &f, 4); return u; }
+static float flt(uint32_t u) { float f; std::memcpy(&f, &u, 4); return f; }
+
+static void test_fp16_exhaustive() {
+  std::vector<uint16_t> h(65536), back(65536);
+  std::vector<float> f(65536);
+  for (uint32_t i = 0; i < 65536; i++) h[i] = (uint16_t)i;
+  convert::fp16_to_fp32(h.data(), f.data(), h.size());
+  convert::fp32_to_fp16(f.data(), back.data(), f.size());
+  for (uint32_t i = 0; i < 65536; i++) {
+    assert(bits(f[i]) == bits(convert::fp16_to_fp32(h[i])));
+    const bool nan = (i & 0x7c00) == 0x7c00 && (i & 0x3ff);
+    // NaNs come back quieted with their payload, everything else exactly
+    assert(back[i] == (nan ? (uint16_t)(i | 0x200) : (uint16_t)i));
+  }
+}
+
+static void test_fp16_rounding() {
+  using convert::fp32_to_fp16;
+  assert(fp32_to_fp16(1.0f) == 0x3c00 && fp32_to_fp16(-2.0f) == 0xc000);
+  assert(fp32_to_fp16(65504.0f) == 0x7bff);
+  assert(fp32_to_fp16(65519.0f) == 0x7bff && fp32_to_fp16(65520.0f) == 0x7c00);   // ties go to even: inf
+  assert(fp32_to_fp16(1e9f) == 0x7c00 && fp32_to_fp16(-INFINITY) == 0xfc00);
+  // 1 + 2^-11 is halfway between 1 and the next half: even wins; one more ulp tips it
+  assert(fp32_to_fp16(flt(0x3f801000)) == 0x3c00 && fp32_to_fp16(flt(0x3f801001)) == 0x3c01);
+  assert(fp32_to_fp16(flt(0x3f803000)) == 0x3c02);
+  // Subnormal halves, and underflow to signed zero
+  assert(fp32_to_fp16(0x1p-24f) == 0x0001 && fp32_to_fp16(0x1p-25f) == 0x0000 && fp32_to_fp16(0x1.8p-25f) == 0x0001);
+  assert(fp32_to_fp16(-0x1p-30f) == 0x8000 && fp32_to_fp16(0x1p-14f) == 0x0400);
+  assert((fp32_to_fp16(NAN) & 0x7e00) == 0x7e00);
+}
+
+static void test_bulk_matches_scalar() {
+  std::mt19937 rng(12345);
+  std::vector<float> f(100003);
+  for (auto& x : f) x = flt((uint32_t)rng());
+  // Edges the random draw would rarely hit
+  const float edges[] = { 0.0f, -0.0f, 65504.0f, 65520.0f, 0x1p-24f, 0x1p-25f, 0x1.8p-25f, 0x1p-14f, INFINITY, -INFINITY, NAN, flt(0x7f800001) };
+  std::memcpy(f.data(), edges, sizeof(edges));
+  std::vector<uint16_t> h(f.size()), b(f.size());
+  convert::fp32_to_fp16(f.data(), h.data(), f.size());
+  convert::fp32_to_bf16(f.data(), b.data(), f.size());
+  for (size_t i = 0; i < f.size(); i++) {
+    assert(h[i] == convert::fp32_to_fp16(f[i]));
+    assert(b[i] == convert::fp32_to_bf16(f[i]));
+  }
+  std::vector<float> w(f.size());
+  convert::bf16_to_fp32(b.data(), w.data(), b.size());
+  for (size_t i = 0; i < b.size(); i++) assert(bits(w[i]) == bits(convert::bf16_to_fp32(b[i])));
+}
+
+static void test_bf16() {
+  using convert::fp32_to_bf16;
+  assert(fp32_to_bf16(1.0f) == 0x3f80 && fp32_to_bf16(-1.0f) == 0xbf80);
+  assert(fp32_to_bf16(flt(0x3f808000)) == 0x3f80 && fp32_to_bf16(flt(0x3f818000)) == 0x3f82);   // ties to even
+  assert(fp32_to_bf16(flt(0x3f808001)) == 0x3f81);
+  assert(fp32_to_bf16(flt(0x7f7fffff)) == 0x7f80);                                               // rounds up to inf
+  assert(fp32_to_bf16(flt(0x7f800001)) == 0x7fc0);                                               // sNaN quieted, not inf
+  assert(convert::bf16_to_fp32(0x4049) == flt(0x40490000) && std::isnan(convert::bf16_to_fp32(0x7f81)));
+}
+
+static void test_rows() {
+  assert(convert::supported(DType::FP32, DType::BF16) && convert::supported(DType::FP16, DType::FP16));
+  assert(!convert::supported(DType::U8, DType::FP32) && !convert::supported(DType::FP32, DType::FP64));
+  // 3 rows of 5, source rows 8 floats apart, destination halves packed
+  float src[24];
+  for (int i = 0; i < 24; i++) src[i] = (i % 8 < 5) ? (float)i : NAN;
+  uint16_t dst[15];
+  assert(convert::convert_rows(DType::FP32, src, 32, DType::FP16, dst, 0, 3, 5));
+  for (int r = 0; r < 3; r++) for (int c = 0; c < 5; c++) assert(convert::fp16_to_fp32(dst[r * 5 + c]) == (float)(r * 8 + c));
+  // FP16 -> BF16 and back to a padded FP32 copy
+  uint16_t bf[15];
+  assert(convert::convert_rows(DType::FP16, dst, 0, DType::BF16, bf, 0, 3, 5));
+  float out[3 * 6];
+  for (float& x : out) x = -7.0f;
+  assert(convert::convert_rows(DType::BF16, bf, 10, DType::FP32, out, 24, 3, 5));
+  for (int r = 0; r < 3; r++) {
+    for (int c = 0; c < 5; c++) assert(out[r * 6 + c] == (float)(r * 8 + c));
+    assert(out[r * 6 + 5] == -7.0f);                                                             // padding untouched
+  }
+  assert(!convert::convert_rows(DType::U16, dst, 0, DType::FP32, out, 0, 1, 5));
+}
+
+int main() {
+  test_fp16_exhaustive();
+  test_fp16_rounding();
+  test_bulk_matches_scalar();
+  test_bf16();
+  test_rows();
+  std::printf("[convert] ok\n");
+  return 0;
+}
@@ -0,0 +1,90 @@
+// Binary logger: typed arguments expand into {} (extras appended), the text
+// forms pass braces through verbatim, lines from several threads all arrive
+// under LogOverflow::Block, the calling thread never allocates, oversized
+// records and (under Drop) full rings are counted, and flush waits for the
+// writer.
+#include "kcoro_cpp/logger.hpp"
+#include "alloc_count.hpp"
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+using namespace kcoro_cpp;
+
+enum class Color { Red = 3 };
+
+static std::string slurp(FILE* f) {
+  std::fflush(f);
+  std::string s;
+  char buf[65536];
+  off_t off = 0;
+  ssize_t n;
+  while ((n = ::pread(fileno(f), buf, sizeof(buf), off)) > 0) { s.append(buf, (size_t)n); off += n; }
+  return s;
+}
+
+static size_t count(const std::string& hay, const std::string& needle) {
+  size_t n = 0;
+  for (size_t at = hay.find(needle); at != std::string::npos; at = hay.find(needle, at + 1)) n++;
+  return n;
+}
+
+int main(){
+  FILE* f = std::tmpfile();
+  assert(f);
+  Logger& lg = Logger::instance();
+  lg.set_fd(fileno(f));
+  lg.set_overflow(LogOverflow::Block);
+
+  int x = 42; const char* s = "abc"; std::string str = "def";
+  log_fmt(LogLevel::Warn, "x={} s={} str={} d={} b={} c={} e={} u={}", x, s, str, 1.5, true, 'z', Color::Red, 7u);
+  log_fmt(LogLevel::Info, "extra", -1, "tail");
+  log_info("text {} stays");
+
+  // Steady state on this thread: no allocations per record
+  std::string big(300, 'q');
+  long before = t_news;
+  for (int i = 0; i < 1000; i++) log_fmt(LogLevel::Debug, "main {} {}", i, big);
+  assert(t_news == before);
+
+  const int kThreads = 4, kPer = 5000;
+  std::vector<std::thread> ts;
+  for (int t = 0; t < kThreads; t++) ts.emplace_back([t] {
+    for (int i = 0; i < kPer; i++) log_fmt(LogLevel::Info, "thread {} line {}", t, i);
+  });
+  for (auto& t : ts) t.join();
+
+  // Too big for any ring: dropped even under Block
+  std::string huge(4096, 'h');
+  log_fmt(LogLevel::Error, "{}{}{}{}{}", huge, huge, huge, huge, huge);
+  lg.flush();
+
+  std::string out = slurp(f);
+  assert(count(out, "[WARN] x=42 s=abc str=def d=1.5 b=true c=z e=3 u=7\n") == 1);
+  assert(count(out, "[INFO] extra -1 tail\n") == 1);
+  assert(count(out, "[INFO] text {} stays\n") == 1);
+  assert(count(out, "[DEBUG] main 999 " + big + "\n") == 1);
+  assert(count(out, "[INFO] thread ") == (size_t)(kThreads * kPer));
+  assert(count(out, "thread 3 line 4999\n") == 1);
+  auto st = lg.stats();
+  assert(st.written == (uint64_t)(3 + 1000 + kThreads * kPer) && st.dropped == 1);
+  assert(count(out, "logger dropped 1 records") == 1);
+
+  // Drop mode: a burst of large records outruns the writer; every record
+  // is either written or counted
+  lg.set_overflow(LogOverflow::Drop);
+  std::string chunk(4000, 'k');
+  const int kBurst = 2000;
+  for (int i = 0; i < kBurst; i++) log_fmt(LogLevel::Info, "burst {}", chunk);
+  lg.flush();
+  auto st2 = lg.stats();
+  uint64_t wrote = st2.written - st.written, lost = st2.dropped - st.dropped;
+  std::printf("logger: burst wrote=%llu dropped=%llu\n", (unsigned long long)wrote, (unsigned long long)lost);
+  assert(wrote + lost == (uint64_t)kBurst);
+  assert(count(slurp(f), "[INFO] burst ") == wrote);
+  return 0;
+}
@@ -0,0 +1,87 @@
+// Memory resources: every channel type, SelectT registrations and an
+// AsyncTask frame built on a counting arena make no global heap allocations
+// on the calling thread, and the frame goes back to the arena when the task
+// finishes.
+#include "kcoro_cpp/await.hpp"
+#include "kcoro_cpp/channel.hpp"
+#include "kcoro_cpp/select_t.hpp"
+#include "kcoro_cpp/static_channel.hpp"
+#include "alloc_count.hpp"
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory_resource>
+#include <new>
+#include <thread>
+using namespace kcoro_cpp;
+
+class CountingResource : public std::pmr::memory_resource {
+public:
+  std::atomic<long> allocs{0}, frees{0};
+private:
+  void* do_allocate(std::size_t n, std::size_t a) override {
+    std::lock_guard<std::mutex> lk(mu_); allocs++; return up_.allocate(n, a);
+  }
+  void do_deallocate(void* p, std::size_t n, std::size_t a) override {
+    std::lock_guard<std::mutex> lk(mu_); frees++; up_.deallocate(p, n, a);
+  }
+  bool do_is_equal(const std::pmr::memory_resource& o) const noexcept override { return this == &o; }
+  std::mutex mu_;
+  std::pmr::monotonic_buffer_resource up_{1 << 20};
+};
+
+static std::atomic<int> g_got{0};
+
+AsyncTask reader(std::allocator_arg_t, std::pmr::memory_resource*, BufferedChannel<int>& ch) {
+  int v = 0;
+  while (co_await async_recv(ch, v) == 0 && v >= 0) g_got.fetch_add(v);
+}
+
+int main(){
+  WorkStealingScheduler s(1);
+  CountingResource arena;
+  long before = t_news;
+  {
+    BufferedChannel<int> buf(&s, 64, &arena);
+    UnlimitedChannel<int> unl(&s, &arena);
+    ConflatedChannel<int> con(&s, &arena);
+    SpscChannel<int> spsc(&s, 64, &arena);
+    RendezvousChannel<int> rv(&s, &arena);
+    channel<int, ChannelKind::Buffered, 8> sbuf(&s, &arena);
+    channel<int, ChannelKind::Rendezvous, 0> srv(&s, &arena);
+    int out = 0;
+    for (int i = 0; i < 100; i++) {
+      assert(buf.send(i, 0) == 0 && buf.recv(out, 0) == 0 && out == i);
+      assert(unl.send(i, 0) == 0 && unl.recv(out, 0) == 0 && out == i);
+      assert(con.send(i, 0) == 0 && con.recv(out, 0) == 0 && out == i);
+      assert(spsc.send(i, 0) == 0 && spsc.recv(out, 0) == 0 && out == i);
+      assert(sbuf.send(i, 0) == 0 && sbuf.recv(out, 0) == 0 && out == i);
+      assert(rv.recv(out, 0) == KC_EAGAIN && srv.recv(out, 0) == KC_EAGAIN);
+    }
+    // Select clauses park nodes in the channels' pools, from the arena
+    SelectT<int> sel(nullptr, SelectPolicy::FirstWins, &arena);
+    int a = 0, b = 0;
+    sel.add_recv(&buf, &a);
+    sel.add_recv(&rv, &b);
+    assert(sel.wait(0) == KC_EAGAIN);
+    assert(arena.allocs.load() > 0);
+  }
+  std::printf("pmr: channels took %ld arena allocations, %ld heap\n", arena.allocs.load(), t_news - before);
+  assert(t_news == before);
+
+  // Coroutine frame from the arena, returned when the body finishes
+  BufferedChannel<int> ch(&s, 16, &arena);
+  long allocs = arena.allocs.load(), frees = arena.frees.load();
+  before = t_news;
+  spawn_async(s, reader(std::allocator_arg, &arena, ch));
+  // The frame, plus the select node once the reader waits on ch
+  assert(arena.allocs.load() >= allocs + 1 && t_news == before);
+  for (int i = 1; i <= 10; i++) while (ch.send(i, 0) != 0) std::this_thread::yield();
+  while (ch.send(-1, 0) != 0) std::this_thread::yield();
+  for (int i = 0; i < 2000 && arena.frees.load() == frees; i++) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  assert(g_got.load() == 55 && arena.frees.load() == frees + 1);
+  s.stop_and_join();
+  return 0;
+}
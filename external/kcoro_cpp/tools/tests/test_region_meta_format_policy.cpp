@@ -2,7 +2,9 @@
 #include <cassert>
 #include <cstdlib>
 #include <iostream>
+#include <thread>
 #include "kcoro_cpp/core.hpp"
+#include "kcoro_cpp/convert.hpp"
 #include "kcoro_cpp/zref.hpp"
 #include "kcoro_cpp/scheduler.hpp"
 
@@ -20,6 +22,48 @@ static void test_region_meta_basic() {
   reg.region_deregister(id); std::free(base);
 }
 
+static void test_region_meta_alignment() {
+  std::cout << "=== C++ Test: Region Meta Alignment ===\n";
+  auto& reg = ZCopyRegistry::instance();
+  void* base = nullptr; ZCopyRegistry::RegionId id=0;
+  assert(reg.alloc_aligned(4096, 64, base, id));
+  RegionMeta m{}; m.align_bytes=64; m.stride_bytes=256;
+  assert(reg.set_meta(id, m));
+  RegionMeta bad=m; bad.align_bytes=48; assert(!reg.set_meta(id, bad));     // not a power of two
+  bad=m; bad.stride_bytes=96; assert(!reg.set_meta(id, bad));               // rows would drift
+  RegionMeta got{}; assert(reg.get_meta(id, got) && got.stride_bytes==256); // refusals leave it
+  // A region whose base misses the claimed alignment
+  ZCopyRegistry::RegionId off = reg.region_register((char*)base + 8, 1024);
+  assert(off!=0 && !reg.set_meta(off, m));
+  RegionMeta m8=m; m8.align_bytes=8; m8.stride_bytes=0; assert(reg.set_meta(off, m8));
+  reg.region_deregister(off); reg.region_deregister(id);
+  assert(!reg.set_meta(id, m));                                             // gone
+  std::free(base);
+}
+
+static void test_region_meta_concurrent() {
+  std::cout << "=== C++ Test: Region Meta Concurrent ===\n";
+  auto& reg = ZCopyRegistry::instance();
+  void* base = nullptr; ZCopyRegistry::RegionId id=0;
+  bool ok = reg.alloc_aligned(4096, 64, base, id); assert(ok && id!=0);
+  RegionMeta a{}; a.dtype=DType::FP32; a.elem_bits=32; RegionMeta b{}; b.dtype=DType::U16; b.elem_bits=16;
+  reg.set_meta(id, a);
+  // Readers never see a torn meta while a writer swaps it
+  std::atomic<bool> stop{false}; std::atomic<int> bad{0};
+  std::thread rd([&]{ RegionMeta g{}; while(!stop.load()){ if(reg.get_meta(id,g) && !((g.dtype==DType::FP32 && g.elem_bits==32) || (g.dtype==DType::U16 && g.elem_bits==16))) bad++; } });
+  for (int i=0;i<20000;i++) reg.set_meta(id, (i&1)?a:b);
+  stop=true; rd.join(); assert(bad.load()==0);
+  // Deregister waits for an outstanding reference, then the id is dead
+  assert(reg.region_incref(id));
+  std::atomic<bool> gone{false};
+  std::thread dr([&]{ assert(reg.region_deregister(id)); gone=true; });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20)); assert(!gone.load());
+  void* qb=nullptr; size_t ql=0; assert(!reg.region_query(id, qb, ql));
+  assert(reg.region_decref(id)); dr.join(); assert(gone.load());
+  RegionMeta g{}; assert(!reg.get_meta(id, g) && !reg.region_incref(id));
+  std::free(base);
+}
+
 static void test_format_policy_strict() {
   std::cout << "=== C++ Test: Format Policy Strict ===\n";
   auto& reg = ZCopyRegistry::instance(); WorkStealingScheduler sched(1);
@@ -28,6 +72,8 @@ static void test_format_policy_strict() {
   void* b1=nullptr; ZCopyRegistry::RegionId id1=0; reg.alloc_aligned(1024, 32, b1, id1); reg.set_meta(id1, req); ZDesc d1{b1,1024,id1,0,0}; assert(ch.send(d1,0)==0);
   void* b2=nullptr; ZCopyRegistry::RegionId id2=0; reg.alloc_aligned(1024, 32, b2, id2); RegionMeta mm=req; mm.dtype=DType::FP16; reg.set_meta(id2, mm); ZDesc d2{b2,1024,id2,0,0}; assert(ch.send(d2,0)==KC_EINVAL);
   void* b3=nullptr; ZCopyRegistry::RegionId id3=0; reg.alloc_aligned(1024, 16, b3, id3); RegionMeta ua=req; ua.align_bytes=16; reg.set_meta(id3, ua); ZDesc d3{b3,1024,id3,0,0}; assert(ch.send(d3,0)==KC_EINVAL);
+  // Aligned meta, but the descriptor points off the required alignment
+  ZDesc d4{(char*)b1+4,512,id1,4,0}; assert(ch.send(d4,0)==KC_EINVAL);
   reg.region_deregister(id1); reg.region_deregister(id2); reg.region_deregister(id3); std::free(b1); std::free(b2); std::free(b3);
 }
 
@@ -41,10 +87,61 @@ static void test_format_policy_advisory() {
   reg.region_deregister(id); std::free(b);
 }
 
+static void test_format_policy_adapt() {
+  std::cout << "=== C++ Test: Format Policy Adapt ===\n";
+  auto& reg = ZCopyRegistry::instance(); WorkStealingScheduler sched(1);
+  ZRefBufferedChannel ch(&sched, 8);
+  // Consumer wants packed FP16 rows of 8, 64-byte aligned
+  RegionMeta req{}; req.dtype=DType::FP16; req.elem_bits=16; req.align_bytes=64; req.ndims=2; req.dims[0]=4; req.dims[1]=8;
+  const FormatMask mask = FMT_DTYPE|FMT_ELEMBITS|FMT_ALIGN|FMT_DIMS;
+  ch.require_format(req, mask, FormatMode::Adapt);
+  // Producer has FP32 rows 64 bytes apart
+  void* b=nullptr; ZCopyRegistry::RegionId id=0; assert(reg.alloc_aligned(256, 64, b, id));
+  RegionMeta pm=req; pm.dtype=DType::FP32; pm.elem_bits=32; pm.stride_bytes=64; assert(reg.set_meta(id, pm));
+  float* f=(float*)b; for (int r=0;r<4;r++) for (int c=0;c<16;c++) f[r*16+c] = (c<8) ? (float)(r*8+c)+0.25f : -1.0f;
+  ZDesc d{b,256,id,0,0};
+  assert(ch.send(d,0)==KC_EINVAL);                          // no pool to convert into
+  ConvertPool pool(req, 64, 1);
+  ch.require_format(req, mask, FormatMode::Adapt, &pool);
+  assert(ch.send(d,0)==0 && ch.send(d,0)==0);
+  ZDesc got{}; assert(ch.recv(got,0)==0);
+  assert((got.flags & ZDESC_F_CONVERTED) && got.region_id==pool.region() && got.len==64 && ((uintptr_t)got.addr % 64)==0);
+  const uint16_t* h=(const uint16_t*)got.addr;
+  for (int i=0;i<32;i++) assert(convert::fp16_to_fp32(h[i]) == (float)i+0.25f);
+  // The converted copy meets the format as it stands
+  RegionMeta cm{}; assert(reg.get_meta(got.region_id, cm) && cm.dtype==DType::FP16);
+  // Slots bound the receivers: none left, nothing consumed
+  ZDesc none{}; assert(pool.available()==0 && ch.recv(none,0)==KC_ENOBUFS && ch.size()==1);
+  pool.release(got); assert(pool.available()==1 && ch.recv(got,0)==0 && (got.flags & ZDESC_F_CONVERTED));
+  pool.release(got);
+  // Matching descriptors pass as sent
+  void* mb=nullptr; ZCopyRegistry::RegionId mid=0; assert(reg.alloc_aligned(64, 64, mb, mid)); assert(reg.set_meta(mid, req));
+  ZDesc md{mb,64,mid,0,0}; assert(ch.send(md,0)==0);
+  assert(ch.recv(got,0)==0 && got.addr==mb && pool.available()==1);
+  // What no pass can fix is refused, as Strict would
+  RegionMeta sh=pm; sh.dims[0]=2; assert(reg.set_meta(id, sh)); assert(ch.send(d,0)==KC_EINVAL);   // dims
+  RegionMeta u8=pm; u8.dtype=DType::U8; u8.elem_bits=8; assert(reg.set_meta(id, u8)); assert(ch.send(d,0)==KC_EINVAL);
+  RegionMeta q=req; q.align_bytes=0; ConvertPool small(q, 32, 1); ch.require_format(req, mask, FormatMode::Adapt, &small);
+  assert(reg.set_meta(id, pm)); assert(ch.send(d,0)==KC_EINVAL);                                   // slot too small
+  // Stride alone, FP32 kept: repacked after a select-style receive
+  RegionMeta r32=pm; r32.align_bytes=32; r32.stride_bytes=32; ConvertPool p32(r32, 128, 1);
+  ZRefBufferedChannel sc(&sched, 2);
+  sc.require_format(r32, FMT_DTYPE|FMT_STRIDE, FormatMode::Adapt, &p32);
+  ZDesc sd=d; assert(sc.adapt(sd)==0 && (sd.flags & ZDESC_F_CONVERTED) && sd.len==128);
+  for (int r=0;r<4;r++) for (int c=0;c<8;c++) assert(((float*)sd.addr)[r*8+c] == (float)(r*8+c)+0.25f);
+  ZDesc again=d; assert(sc.adapt(again)==KC_ENOBUFS && again.addr==b);
+  p32.release(sd);
+  reg.region_deregister(mid); std::free(mb);
+  reg.region_deregister(id); std::free(b);
+}
+
 int main(){
   test_region_meta_basic();
+  test_region_meta_alignment();
+  test_region_meta_concurrent();
   test_format_policy_strict();
   test_format_policy_advisory();
+  test_format_policy_adapt();
   std::cout << "All C++ region meta/format tests passed\n";
   return 0;
 }
@@ -0,0 +1,110 @@
+// Hosted scheduler: two host threads stand in for libkcoro workers. They
+// sleep until notify rings or next_timer_ns() is due and then poll. Tasks
+// spawned from outside all run, only on the host threads and with the
+// scheduler current; timers armed on both slots while the hosts sleep fire
+// on time; a nested or foreign poll runs nothing; sched_set_default hands
+// out the hosted scheduler and refuses a second default.
+#include "kcoro_cpp/scheduler.hpp"
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+using namespace kcoro_cpp;
+
+constexpr int kHosts = 2, kTasks = 1000, kBudget = 32;
+
+struct Host {
+  std::mutex mu;
+  std::condition_variable cv;
+  bool bell{false}, stop{false};
+  std::atomic<int> rings{0};
+};
+static Host g_host;
+static WorkStealingScheduler* g_sched;
+static std::thread::id g_ids[kHosts];
+static std::atomic<int> g_ran{0}, g_bad{0};
+
+static void ring(void* ctx) {
+  auto* h = static_cast<Host*>(ctx);
+  h->rings.fetch_add(1, std::memory_order_relaxed);
+  { std::lock_guard<std::mutex> lk(h->mu); h->bell = true; }
+  h->cv.notify_one();
+}
+
+static uint64_t now_ns() {
+  using namespace std::chrono;
+  return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+static void host_loop(int id) {
+  g_ids[id] = std::this_thread::get_id();
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lk(g_host.mu);
+      uint64_t due = g_sched->next_timer_ns();
+      auto ready = [] { return g_host.bell || g_host.stop; };
+      if (due) g_host.cv.wait_for(lk, std::chrono::nanoseconds(due > now_ns() ? due - now_ns() : 0), ready);
+      else g_host.cv.wait(lk, ready);
+      if (g_host.stop) return;
+      g_host.bell = false;
+    }
+    while (g_sched->poll(id, kBudget) == kBudget) {}
+  }
+}
+
+static void task(void*) {
+  auto self = std::this_thread::get_id();
+  if (sched_current() != g_sched || (self != g_ids[0] && self != g_ids[1])) g_bad++;
+  if (g_sched->poll(0, kBudget) != 0) g_bad++; // already inside a slot
+  g_ran++;
+}
+
+int main() {
+  SchedulerOptions opts;
+  opts.workers = kHosts;
+  opts.host.notify = ring;
+  opts.host.ctx = &g_host;
+  g_sched = sched_init(opts);
+  assert(g_sched->hosted());
+  WorkStealingScheduler plain(1);
+  assert(!plain.hosted() && plain.poll(0, kBudget) == 0);
+  assert(sched_set_default(g_sched) && sched_default() == g_sched && !sched_set_default(&plain));
+
+  std::thread hosts[kHosts];
+  for (int i = 0; i < kHosts; i++) hosts[i] = std::thread(host_loop, i);
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+  for (int i = 0; i < kTasks; i++) assert(sched_spawn(nullptr, task, nullptr) == 0);
+  for (int i = 0; i < 2000 && g_ran.load() < kTasks; i++) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  assert(g_ran.load() == kTasks && g_bad.load() == 0);
+  assert(g_sched->stats().tasks_completed == (uint64_t)kTasks);
+
+  // Nothing queued: the hosts sleep until the timer is due
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  assert(g_sched->next_timer_ns() == 0);
+  std::atomic<uint64_t> fired_at{0};
+  const uint64_t due = now_ns() + 20 * 1000000ULL;
+  std::atomic<int> fired{0};
+  // From a foreign thread the wheels take turns: one timer lands on each slot
+  for (int i = 0; i < kHosts; i++) {
+    auto th = g_sched->schedule_timer_at(due, [&] { fired_at = now_ns(); fired++; });
+    assert(th.valid() && g_sched->next_timer_ns() != 0);
+  }
+  for (int i = 0; i < 2000 && fired.load() < kHosts; i++) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  assert(fired.load() == kHosts && fired_at.load() >= due);
+
+  {
+    std::lock_guard<std::mutex> lk(g_host.mu);
+    g_host.stop = true;
+  }
+  g_host.cv.notify_all();
+  for (auto& h : hosts) h.join();
+  int rings = g_host.rings.load();
+  sched_shutdown(g_sched);
+  assert(sched_set_default(&plain) && sched_default() == &plain);
+  std::printf("[sched_hosted] ok rings=%d\n", rings);
+  return 0;
+}
@@ -0,0 +1,94 @@
+// Scheduler queues: a Chase-Lev deque with its owner popping against three
+// thieves hands out every task exactly once (including across growth), the
+// MPMC ring and a spilling inject queue lose nothing under concurrent
+// producers and consumers, and the scheduler runs nested task fan-out to
+// completion with its stats adding up.
+#include "kcoro_cpp/scheduler.hpp"
+#include "kcoro_cpp/sched_queues.hpp"
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+using namespace kcoro_cpp;
+
+constexpr long kItems = 200000;
+
+static std::atomic<long> g_sum{0}, g_count{0};
+static WorkStealingScheduler* g_sched = nullptr;
+
+static void leaf(void* a) { g_sum += (long)a; g_count++; }
+static void fan(void* a) { for (long i = 0; i < (long)a; i++) g_sched->spawn(leaf, (void*)i); g_count++; }
+
+int main(){
+  {
+    // Owner pushes and pops at the bottom while thieves take the top; the
+    // small initial array forces several grows
+    detail::TaskDeque dq(16);
+    std::atomic<bool> done{false};
+    std::atomic<long> stolen{0}, sum{0};
+    std::vector<std::thread> thieves;
+    for (int i = 0; i < 3; i++) thieves.emplace_back([&]{
+      Task t{};
+      while (!done.load() || dq.size_approx()) {
+        if (dq.steal(t) == detail::TaskDeque::kOk) { stolen++; sum += (long)t.arg; }
+      }
+    });
+    long popped = 0;
+    Task t{};
+    for (long i = 1; i <= kItems; i++) {
+      dq.push(Task{nullptr, (void*)i});
+      if (i % 3 == 0 && dq.pop(t)) { popped++; sum += (long)t.arg; }
+    }
+    while (dq.pop(t)) { popped++; sum += (long)t.arg; }
+    done = true;
+    for (auto& th : thieves) th.join();
+    assert(popped + stolen == kItems && sum == kItems * (kItems + 1) / 2);
+    std::printf("deque: popped=%ld stolen=%ld\n", popped, stolen.load());
+  }
+  {
+    detail::MpmcRing<long> ring(64);
+    long v = 0;
+    for (long i = 0; i < 64; i++) assert(ring.try_push(i));
+    assert(!ring.try_push(64) && ring.size_approx() == 64);
+    for (long i = 0; i < 64; i++) assert(ring.try_pop(v) && v == i);
+    assert(!ring.try_pop(v));
+
+    // A small ring spills; two producers and two consumers see every value
+    detail::InjectQueue<long> q(8);
+    std::atomic<long> got{0}, sum{0};
+    std::vector<std::thread> th;
+    for (int p = 0; p < 2; p++) th.emplace_back([&, p]{ for (long i = 1; i <= kItems / 2; i++) q.push(p ? -i : i); });
+    for (int c = 0; c < 2; c++) th.emplace_back([&]{
+      long x;
+      while (got.load() < kItems) if (q.try_pop(x)) { got++; sum += x; }
+    });
+    for (auto& t : th) t.join();
+    assert(got == kItems && sum == 0 && q.empty_approx());
+  }
+  {
+    WorkStealingScheduler s(4);
+    g_sched = &s;
+    const long fans = 100, per = 2000, bulk = 20000;
+    for (long i = 0; i < fans; i++) s.spawn(fan, (void*)per);
+    for (long i = 0; i < bulk; i++) s.spawn_lane(leaf, (void*)1, Lane::Bulk);
+    const long want = fans + fans * per + bulk;
+    for (int i = 0; i < 10000 && g_count.load() < want; i++) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    assert(g_count == want && g_sum == fans * (per * (per - 1) / 2) + bulk);
+    // tasks_completed is bumped just after each task returns
+    s.drain(1000);
+    for (int i = 0; i < 1000 && s.stats().tasks_completed < (uint64_t)want; i++) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    auto st = s.stats();
+    auto ls = s.lane_stats();
+    std::printf("sched: steals=%lu fast=%lu/%lu inject=%lu parks=%lu\n",
+                (unsigned long)st.steals, (unsigned long)st.fastpath_hits,
+                (unsigned long)(st.fastpath_hits + st.fastpath_misses),
+                (unsigned long)st.inject_pulls, (unsigned long)st.parks);
+    assert(st.tasks_submitted == (uint64_t)want && st.tasks_completed == (uint64_t)want);
+    assert(st.fastpath_hits + st.fastpath_misses == (uint64_t)fans);
+    assert(ls.run[(int)Lane::Bulk] == (uint64_t)bulk && ls.submitted[(int)Lane::Bulk] == (uint64_t)bulk);
+    s.stop_and_join();
+  }
+  return 0;
+}
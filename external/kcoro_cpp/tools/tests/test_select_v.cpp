@@ -0,0 +1,98 @@
+// Variadic select: immediate, poll and closed-channel outcomes over dynamic
+// and static channels, then a coroutine that parks on two channels plus a
+// timeout. Global operator new is replaced to count, per thread, that
+// steady-state selects never allocate (the single worker runs both
+// coroutines of the second part).
+#include "kcoro_cpp/scheduler.hpp"
+#include "kcoro_cpp/channel.hpp"
+#include "kcoro_cpp/static_channel.hpp"
+#include "kcoro_cpp/select_v.hpp"
+#include "alloc_count.hpp"
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+using namespace kcoro_cpp;
+
+constexpr int kWarm = 64;
+constexpr int kSteady = 20000;
+
+struct Env {
+  BufferedChannel<int>* buf; rendezvous_channel<int>* rv;
+  long mark{0}; long allocs{-1}; int got{0}; long sum{0}; int timeouts{0}; int bad{0};
+};
+
+int main() {
+  WorkStealingScheduler s(1);
+  {
+    // Outside a coroutine: only immediate outcomes
+    BufferedChannel<int> buf(&s, 2);
+    buffered_channel<int, 4> sbuf(&s);
+    int got = -1; bool timed_out = false;
+    assert(buf.send(7, 0) == 0);
+    int rc = select(on_recv(buf, [&](int& v) { got = v; }), timeout(0, [&] { timed_out = true; }));
+    assert(rc == 0 && got == 7 && !timed_out);
+
+    rc = select(on_recv(buf, [&](int& v) { got = v; }), on_recv(sbuf, [&](int& v) { got = v; }),
+                timeout(0, [&] { timed_out = true; }));
+    assert(rc == KC_ETIME && timed_out);
+    // The withdrawn registrations must not swallow later sends
+    assert(buf.send(8, 0) == 0 && buf.size() == 1);
+
+    rc = select(on_send(sbuf, 9), timeout(0));
+    assert(rc == 0 && sbuf.size() == 1);
+    rc = select(on_send(buf, 10), on_recv(sbuf, [&](int& v) { got = v; }));
+    assert(rc == 0 && buf.size() == 2 && got == 7);
+    rc = select(on_recv(sbuf, [&](int& v) { got = v; }), timeout(0));
+    assert(rc == 0 && got == 9);
+
+    sbuf.close();
+    rc = select(on_recv(sbuf, [&](int&) { assert(!"closed channel delivered"); }));
+    assert(rc == KC_EPIPE);
+    rc = select(on_recv(buf, [&](int& v) { got = v; }), timeout(-1));
+    assert(rc == 0 && got == 8);
+    buf.recv(got, 0);
+
+    // Nothing ready and no coroutine to park
+    rc = select(on_recv(buf, [](int&) {}));
+    assert(rc == KC_EAGAIN);
+
+    long mark = 0;
+    for (int i = 0; i < kWarm + kSteady; i++) {
+      if (i == kWarm) mark = t_news;
+      buf.send(i, 0);
+      if (select(on_recv(buf, [&](int& v) { got = v; }), timeout(0)) != 0 || got != i) assert(!"lost value");
+      if (select(on_recv(buf, [](int&) {}), on_send(buf, i), timeout(0)) != 0) assert(!"send refused");
+      buf.recv(got, 0);
+    }
+    long allocs = t_news - mark;
+    std::printf("immediate select: %ld allocations\n", allocs);
+    assert(allocs == 0);
+  }
+  {
+    // A coroutine parks on a buffered and a static rendezvous channel with a
+    // timeout; the producer feeds both, then goes quiet so the timeout wins
+    BufferedChannel<int> buf(&s, 4); rendezvous_channel<int> rv(&s);
+    static Env e; e = Env{&buf, &rv};
+    s.spawn_co([](void*) {
+      for (int i = 0; i < kWarm + kSteady; i++) {
+        if (i == kWarm) e.mark = t_news;
+        int rc = select(on_recv(*e.buf, [](int& v) { e.sum += v; if (v & 1) e.bad++; }),
+                        on_recv(*e.rv, [](int& v) { e.sum += v; if (!(v & 1)) e.bad++; }),
+                        timeout(1000, [] { e.timeouts++; }));
+        if (rc != 0) e.bad++;
+        e.got++;
+      }
+      e.allocs = t_news - e.mark;
+      int rc = select(on_recv(*e.buf, [](int&) { e.bad++; }), timeout(20, [] { e.timeouts++; }));
+      if (rc != KC_ETIME) e.bad++;
+    }, nullptr);
+    s.spawn_co([](void*) { for (int i = 0; i < kWarm + kSteady; i++) { if (i & 1) e.rv->send(i, -1); else e.buf->send(i, -1); } }, nullptr);
+    s.drain(10000);
+    const long n = kWarm + kSteady;
+    std::printf("parked select: got=%d timeouts=%d bad=%d allocations=%ld\n", e.got, e.timeouts, e.bad, e.allocs);
+    assert(e.got == n && e.sum == n * (n - 1) / 2 && e.bad == 0 && e.timeouts == 1 && e.allocs == 0);
+  }
+  s.stop_and_join();
+  return 0;
+}
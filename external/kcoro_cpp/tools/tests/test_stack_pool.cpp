@@ -0,0 +1,54 @@
+// Stack pool: reuse by size class, high-water marks, recycled stacks usable,
+// cross-thread return through the depot, lazily committed 1 MiB stacks and
+// their high-water marks.
+#include "kcoro_cpp/platform.hpp"
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+using namespace kcoro_cpp::platform;
+
+int main(){
+  StackPool::set_limits(8, 16);
+  auto s0 = StackPool::stats();
+  std::vector<MMapStack> v;
+  for (int i = 0; i < 40; i++) v.push_back(StackPool::acquire(48 * 1024));
+  assert(v[0].size == 64 * 1024);
+  for (auto& s : v) StackPool::recycle(s);
+  auto s1 = StackPool::stats();
+  std::size_t kept = s1.thread_stacks + s1.depot_stacks;
+  assert(s1.mapped - s0.mapped == 40);
+  assert(s1.thread_stacks <= 8 && s1.depot_stacks == 16 && kept + (s1.unmapped - s0.unmapped) == 40);
+
+  v.clear();
+  for (int i = 0; i < 40; i++) v.push_back(StackPool::acquire(64 * 1024));
+  auto s2 = StackPool::stats();
+  assert(s2.reused - s1.reused == kept && s2.mapped - s1.mapped == 40 - kept);
+  std::memset(v[0].ptr, 0x5a, v[0].size); // recycled stacks are writable end to end
+
+  // freed on another thread: comes back through the depot at thread exit
+  std::thread t([&]{ for (auto& s : v) StackPool::recycle(s); });
+  t.join();
+  auto s3 = StackPool::stats();
+  assert(s3.depot_stacks == 16);
+  MMapStack again = StackPool::acquire(64 * 1024);
+  assert(StackPool::stats().reused == s3.reused + 1);
+  StackPool::recycle(again);
+
+  StackPool::trim();
+  auto s4 = StackPool::stats();
+  assert(s4.depot_stacks == 0 && s4.thread_stacks == 0);
+  MMapStack big = StackPool::acquire(1024 * 1024);
+  assert(big.high_water() == 0); // reserved, nothing committed yet
+  char* top = static_cast<char*>(big.ptr) + big.size;
+  std::memset(top - 200 * 1024, 1, 200 * 1024);
+  assert(big.high_water() >= 200 * 1024 && big.high_water() < big.size);
+  StackPool::recycle(big);
+  big = StackPool::acquire(1024 * 1024);
+  assert(big.high_water() <= page_size()); // only the top page survives recycling
+  StackPool::recycle(big);
+
+  std::puts("stack pool ok");
+  return 0;
+}
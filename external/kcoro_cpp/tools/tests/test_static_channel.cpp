@@ -0,0 +1,70 @@
+// Static channels: compile-time shape and mask, in-order buffered transfer
+// across a full ring, rendezvous ping-pong, close semantics, and the
+// IChannel adapter driving SelectT.
+#include "kcoro_cpp/scheduler.hpp"
+#include "kcoro_cpp/static_channel.hpp"
+#include "kcoro_cpp/select_t.hpp"
+#include <cassert>
+#include <cstdio>
+#include <type_traits>
+using namespace kcoro_cpp;
+
+using Ring = buffered_channel<int, 100>;
+using Rv = rendezvous_channel<int>;
+static_assert(Ring::slots == 128 && Ring::mask == 127 && Ring::capacity == 100);
+static_assert(ChannelShape<ChannelKind::Buffered, 1> && !ChannelShape<ChannelKind::Buffered, 0>);
+static_assert(!ChannelShape<ChannelKind::Rendezvous, 4>);
+static_assert(StaticChannel<Ring> && StaticChannel<Rv>);
+static_assert(std::is_final_v<Ring> && !std::is_polymorphic_v<Ring> && !std::is_polymorphic_v<Rv>);
+
+constexpr int N = 10000;
+
+struct Env { Ring* ring; Rv* rv; long sum{0}; int order_bad{0}; int got{0}; int pongs{0}; };
+
+int main(){
+  {
+    // Outside a coroutine nothing parks
+    WorkStealingScheduler s(1);
+    Ring r(&s);
+    int v = 0;
+    assert(r.recv(v, -1) == KC_EAGAIN);
+    for (int i = 0; i < 100; i++) assert(r.send(i, 0) == 0);
+    assert(r.send(v, -1) == KC_EAGAIN && r.size() == 100);
+    for (int i = 0; i < 100; i++) assert(r.recv(v, 0) == 0 && v == i);
+    r.close();
+    assert(r.send(v, 0) == KC_EPIPE && r.recv(v, 0) == KC_EPIPE);
+    auto snap = r.snapshot();
+    assert(snap.total_sends == 100 && snap.total_recvs == 100 && snap.total_bytes_sent == 100 * sizeof(int));
+    s.stop_and_join();
+  }
+  {
+    WorkStealingScheduler s(2);
+    Ring r(&s); Rv rv(&s);
+    Env env{&r, &rv};
+    s.spawn_co([](void* p){ auto* e = static_cast<Env*>(p); for (int i = 0; i < N; i++) e->ring->send(i, -1); e->ring->close(); }, &env);
+    s.spawn_co([](void* p){
+      auto* e = static_cast<Env*>(p); int v = 0;
+      while (e->ring->recv(v, -1) == 0) { if (v != e->got++) e->order_bad++; e->sum += v; }
+    }, &env);
+    s.spawn_co([](void* p){ auto* e = static_cast<Env*>(p); int v = 0; for (int i = 0; i < 1000; i++) { e->rv->send(i, -1); e->rv->recv(v, -1); if (v != i + 1) e->order_bad++; } e->rv->close(); }, &env);
+    s.spawn_co([](void* p){ auto* e = static_cast<Env*>(p); int v = 0; while (e->rv->recv(v, -1) == 0) { e->rv->send(v + 1, -1); e->pongs++; } }, &env);
+    s.drain(5000); s.stop_and_join();
+    assert(env.got == N && env.order_bad == 0 && env.sum == (long)N * (N - 1) / 2);
+    assert(env.pongs == 1000 && rv.snapshot().total_sends == 2000);
+    std::puts("static ring/rendezvous ok");
+  }
+  {
+    // Type erasure on demand: SelectT over two adapted channels
+    WorkStealingScheduler s(1);
+    Ring a(&s); Rv b(&s);
+    ChannelAdapter<Ring> aa(a); ChannelAdapter<Rv> ab(b);
+    static int idx = -1, out = -1, rc = -1;
+    static IChannel<int>* chans[2] = {&aa, &ab};
+    s.spawn_co([](void*){ SelectT<int> sel; sel.add_recv(chans[0], &out); sel.add_recv(chans[1], &out); rc = sel.wait(-1, &idx); }, nullptr);
+    s.spawn_co([](void* p){ static_cast<Rv*>(p)->send(7, -1); }, &b);
+    s.drain(2000); s.stop_and_join();
+    assert(rc == 0 && idx == 1 && out == 7 && aa.size() == 0 && &aa.get() == &a);
+    std::puts("static adapter ok");
+  }
+  return 0;
+}
@@ -0,0 +1,115 @@
+// Timer wheel: nodes fire at their tick (including deadlines that cascade
+// down from the upper levels), re-arming moves a node, stale handles fail to
+// cancel, large callables spill to the heap while small ones and embedded
+// nodes never allocate, and scheduler timers armed from a foreign thread
+// fire on a worker and can be cancelled.
+#include "kcoro_cpp/scheduler.hpp"
+#include "kcoro_cpp/timer_wheel.hpp"
+#include "alloc_count.hpp"
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <vector>
+using namespace kcoro_cpp;
+
+constexpr uint64_t kMs = 1000000ull;
+
+struct Probe { detail::TimerNode node; uint64_t fired_at{0}; uint64_t* now; };
+
+static void on_fire(void* p) { auto* pr = static_cast<Probe*>(p); pr->fired_at = *pr->now; }
+
+int main(){
+  {
+    const uint64_t t0 = 1000 * kMs;
+    uint64_t now = t0;
+    detail::TimerWheel tw(0, t0);
+    // Level 0, level 1, level 2 and a multi-hour deadline in the last level
+    const uint64_t delays[] = {1, 5, 63, 64, 65, 4095, 4097, 300000, 20000000};
+    std::vector<Probe> probes(sizeof(delays) / sizeof(delays[0]));
+    for (size_t i = 0; i < probes.size(); i++) {
+      probes[i].node.fire = on_fire; probes[i].node.ctx = &probes[i]; probes[i].now = &now;
+      tw.arm(&probes[i].node, t0 + delays[i] * kMs);
+    }
+    assert(tw.pending() == probes.size());
+    // Step a millisecond at a time up to the 300 s deadline, then jump
+    for (uint64_t ms = 1; ms <= 300000; ms++) { now = t0 + ms * kMs; tw.expire(now); }
+    for (size_t i = 0; i + 1 < probes.size(); i++) assert(probes[i].fired_at == t0 + delays[i] * kMs);
+    assert(probes.back().fired_at == 0 && probes.back().node.armed());
+    now = t0 + 20000000 * kMs;
+    assert(tw.expire(now) == 1 && probes.back().fired_at == now && tw.pending() == 0);
+
+    // Re-arming moves the pending wake; cancel withdraws it
+    Probe p; p.node.fire = on_fire; p.node.ctx = &p; p.now = &now;
+    tw.arm(&p.node, now + 10 * kMs);
+    tw.arm(&p.node, now + 20 * kMs);
+    assert(tw.pending() == 1);
+    now += 15 * kMs; assert(tw.expire(now) == 0);
+    now += 5 * kMs; assert(tw.expire(now) == 1 && p.fired_at == now);
+    tw.arm(&p.node, now + kMs);
+    assert(tw.cancel(&p.node) && !tw.cancel(&p.node) && tw.pending() == 0);
+
+    // Moving a node between wheels
+    detail::TimerWheel other(1, now);
+    tw.arm(&p.node, now + kMs);
+    other.arm(&p.node, now + kMs);
+    assert(tw.pending() == 0 && other.pending() == 1);
+    now += kMs; assert(tw.expire(now) == 0 && other.expire(now) == 1);
+  }
+  {
+    uint64_t now = 0;
+    detail::TimerWheel tw(3, now);
+    int hits = 0;
+    uint64_t id = tw.add_callback(now + 2 * kMs, [&hits]{ hits++; });
+    assert(detail::TimerWheel::id_wheel(id) == 3);
+    uint64_t gone = tw.add_callback(now + 2 * kMs, [&hits]{ hits += 100; });
+    assert(tw.cancel_id(gone) && !tw.cancel_id(gone));
+    now += 2 * kMs; tw.expire(now);
+    assert(hits == 1 && !tw.cancel_id(id));
+    // The recycled entry gets a new generation: the old handle stays dead
+    uint64_t again = tw.add_callback(now + kMs, [&hits]{ hits++; });
+    assert(again != id && again != gone && !tw.cancel_id(id));
+
+    // Small callables and embedded nodes: no allocations once the slab is warm
+    Probe p; p.node.fire = on_fire; p.node.ctx = &p; p.now = &now;
+    long mark = g_news.load();
+    for (int i = 0; i < 10000; i++) {
+      tw.add_callback(now + kMs, [&hits, i]{ hits += i & 1; });
+      tw.arm(&p.node, now + 2 * kMs);
+      now += kMs; tw.expire(now);
+    }
+    std::printf("wheel: %ld allocations for 20000 arms\n", g_news.load() - mark);
+    assert(g_news.load() == mark);
+
+    // Larger captures move to the heap and are freed after firing
+    std::array<char, 256> big{}; big[255] = 7;
+    tw.add_callback(now + kMs, [big, &hits]{ hits += big[255]; });
+    assert(g_news.load() == mark + 1);
+    int before = hits; now += kMs; tw.expire(now);
+    assert(hits == before + 7);
+  }
+  {
+    WorkStealingScheduler s(2);
+    std::atomic<int> fired{0}, bad{0};
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < 100; i++) s.schedule_timer_after(5 + i % 10, [&fired, &bad, &s]{
+      if (sched_current() != &s) bad++;
+      fired++;
+    });
+    auto h = s.schedule_timer_after(20, [&bad]{ bad++; });
+    assert(s.cancel_timer(h) && !s.cancel_timer(h));
+    sched_timer_add_after(&s, 1, std::function<void()>([&fired]{ fired++; }));
+    assert(!sched_timer_add_after(&s, 1, std::function<void()>()).valid());
+    for (int i = 0; i < 2000 && fired.load() < 101; i++) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    long ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0).count();
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    std::printf("sched timers: fired=%d in %ldms\n", fired.load(), ms);
+    assert(fired == 101 && bad == 0 && ms >= 14);
+    s.stop_and_join();
+  }
+  return 0;
+}
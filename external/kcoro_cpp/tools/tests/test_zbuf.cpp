@@ -0,0 +1,122 @@
+// ZBuf handles: a pooled buffer goes back to its pool when its last owner
+// drops it, moves leave the source empty, the region stays referenced while
+// any buffer is out, and buffers travel by move through IChannel<ZBuf>
+// (lvalue sends refused) and, by descriptor, through zref channels.
+#include "kcoro_cpp/zref.hpp"
+#include "kcoro_cpp/scheduler.hpp"
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+using namespace kcoro_cpp;
+
+static void test_ownership() {
+  auto& reg = ZCopyRegistry::instance();
+  ZBufPool pool(100, 4);
+  assert(pool.slot_bytes() == 128 && pool.available() == 4);
+  {
+    ZBuf a = pool.get();
+    assert(a && a.size() == 128 && a.pool() == &pool && pool.available() == 3);
+    assert(a.resize(16) && !a.resize(17) && a.size() == 16);
+    // The region counts the buffer: not idle until it is dropped
+    assert(!reg.region_wait_idle(pool.region(), 0));
+    ZBuf b = std::move(a);
+    assert(!a && b && pool.available() == 3);
+    ZBuf c = pool.get();
+    c = std::move(b);                  // c's own slot goes back
+    assert(pool.available() == 3);
+    ZBuf d[3];
+    for (auto& x : d) x = pool.get();
+    assert(pool.available() == 0 && !pool.get());
+  }
+  assert(pool.available() == 4 && reg.region_wait_idle(pool.region(), 0));
+  // release hands the reference over; adopt takes it back
+  ZBuf e = pool.get();
+  ZDesc raw = e.release();
+  assert(!e && pool.available() == 3);
+  { ZBuf f = ZBuf::adopt(raw, &pool); assert(f.data() == raw.addr); }
+  assert(pool.available() == 4 && reg.region_wait_idle(pool.region(), 0));
+}
+
+// A region_slice part adopted without a pool: dropping it is region_decref
+static void test_adopt_slice() {
+  auto& reg = ZCopyRegistry::instance();
+  char buf[512];
+  auto id = reg.region_register(buf, sizeof(buf));
+  ZDesc parts[2];
+  assert(reg.region_slice(id, 0, 2, parts) == 2);
+  {
+    ZBuf a = ZBuf::adopt(parts[0]), b = ZBuf::adopt(parts[1]);
+    assert(!reg.region_wait_idle(id, 0));
+  }
+  assert(reg.region_wait_idle(id, 0));
+  reg.region_deregister(id);
+}
+
+constexpr int N = 200;
+struct Env { ZBufPool* pool; IChannel<ZBuf>* buffered; IChannel<ZBuf>* rv; int got{0}; int bad{0}; int refused{0}; };
+static Env e;
+
+static void test_typed_channels(WorkStealingScheduler& s) {
+  ZBufPool pool(64, 8);
+  {
+    BufferedChannel<ZBuf> buffered(&s, 4);
+    RendezvousChannel<ZBuf> rv(&s);
+    e = Env{&pool, &buffered, &rv};
+    s.spawn_co([](void*){
+      for (int i = 0; i < N; i++) {
+        ZBuf b;
+        while (!(b = e.pool->get())) kcoro_cpp::sched_yield();
+        std::memset(b.data(), i & 0xff, b.size());
+        if (i == 0 && e.buffered->send(static_cast<const ZBuf&>(b), 0) == KC_EINVAL && b) e.refused++;
+        IChannel<ZBuf>* ch = (i & 1) ? e.rv : e.buffered;
+        if (ch->send(std::move(b), -1) != 0 || b) e.bad++;
+      }
+    }, nullptr);
+    s.spawn_co([](void*){
+      for (int i = 0; i < N; i++) {
+        ZBuf b;
+        IChannel<ZBuf>* ch = (i & 1) ? e.rv : e.buffered;
+        if (ch->recv(b, -1) != 0 || b.pool() != e.pool || ((unsigned char*)b.data())[63] != (i & 0xff)) e.bad++;
+        else e.got++;
+      }
+    }, nullptr);
+    s.drain(5000);
+    assert(e.got == N && e.bad == 0 && e.refused == 1);
+    assert(pool.available() == 8);
+    // Buffers still queued when the channel goes are dropped with it
+    assert(buffered.send(pool.get(), 0) == 0 && buffered.send(pool.get(), 0) == 0);
+    assert(pool.available() == 6);
+  }
+  assert(pool.available() == 8 && ZCopyRegistry::instance().region_wait_idle(pool.region(), 0));
+}
+
+static void test_zref_channel(WorkStealingScheduler& s) {
+  ZBufPool pool(256, 2);
+  ZRefBufferedChannel ch(&s, 1);
+  ZBuf a = pool.get(), b = pool.get();
+  std::memcpy(a.data(), "zbuf", 5);
+  assert(zbuf_send(ch, std::move(a), 0) == 0 && !a);
+  // Full: b stays with us
+  assert(zbuf_send(ch, std::move(b), 0) == KC_EAGAIN && b);
+  assert(zbuf_send(ch, ZBuf{}, 0) == KC_EINVAL);
+  assert(pool.available() == 0);
+  {
+    ZBuf got;
+    assert(zbuf_recv(ch, got, 0, &pool) == 0 && std::strcmp((char*)got.data(), "zbuf") == 0);
+    assert(zbuf_recv(ch, got, 0, &pool) == KC_EAGAIN && got);
+  }
+  b.reset();
+  assert(pool.available() == 2 && ZCopyRegistry::instance().region_wait_idle(pool.region(), 0));
+}
+
+int main() {
+  test_ownership();
+  test_adopt_slice();
+  WorkStealingScheduler s(1);
+  test_typed_channels(s);
+  test_zref_channel(s);
+  s.stop_and_join();
+  std::printf("[zbuf] ok\n");
+  return 0;
+}
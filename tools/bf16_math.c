@@ -0,0 +1,624 @@
+/**
+ * bf16_math.c - BF16 <-> Float32 conversion and dot products, reference and bulk
+ *
+ * Shared library for cinterop:
+ *   gcc -std=c11 -O2 -shared -fPIC -o libbf16_math.so bf16_math.c -lm
+ *
+ * f32_to_bf16/bf16_to_f32 are the reference routines the Kotlin CBF16
+ * implementation matches bit for bit. The bulk entry points declared in
+ * bf16_math.h are chosen at load time by CPU feature:
+ *
+ * - avx512bf16: vcvtne2ps2bf16 narrows 32 floats per instruction. It
+ *   flushes f32 subnormals and quiets NaNs, which the reference does not,
+ *   so a block containing either goes through the portable code instead.
+ *   vdpbf16ps is the dot product; bf16_dot's definition in bf16_math.h is
+ *   that instruction's exact behavior, confirmed against it on hardware.
+ * - avx2+fma and neon: the dot product emulated with FMA. Neither has a
+ *   bf16 conversion instruction worth using: rounding is one integer add,
+ *   which the portable code vectorizes.
+ * - portable: integer conversions with no data-dependent branches, and a
+ *   scalar fmaf dot product.
+ *
+ * bf16_gemm packs pairs of k into dwords, so a register block is
+ * vdpbf16ps on avx512bf16 (8 rows by 32 columns) and the same FMA
+ * emulation as the dot product on avx2+fma and neon (8 by 8).
+ *
+ * Every set gives the same bits; bf16_spotcheck checks them against an
+ * independent reference.
+ *
+ * f32_to_bf16_sr/f32_to_bf16_sr_n round stochastically, with Philox bits
+ * (philox.h) keyed by a seed and the element index: portable integer code
+ * in every set, compiled for AVX2 or AVX-512 in the x86 ones.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bf16_math.h"
+#include "cpu_features.h"
+#include "philox.h"
+
+static inline uint32_t f32_bits(float f) { uint32_t u; memcpy(&u, &f, 4); return u; }
+static inline float bits_f32(uint32_t u) { float f; memcpy(&f, &u, 4); return f; }
+
+// ============================================================================
+// Reference conversions
+// ============================================================================
+
+// Convert bfloat16 to float32 (exact)
+float bf16_to_f32(bfloat16_t h) {
+    return bits_f32((uint32_t)h << 16);
+}
+
+// Convert float32 to bfloat16, round to nearest even
+bfloat16_t f32_to_bf16(float f) {
+    uint32_t bits = f32_bits(f);
+    uint32_t sign = bits & 0x80000000u;
+    uint32_t exp = (bits >> 23) & 0xFF;
+    uint32_t frac = bits & 0x7FFFFF;
+
+    if (exp == 0xFF) {
+        if (frac == 0) {
+            return (bfloat16_t)((sign >> 16) | 0x7F80);
+        }
+        // NaN: keep the top payload bits; never let it become infinity
+        uint32_t body = 0x7F80 | ((frac >> 16) & 0x7F);
+        if ((body & 0x7F) == 0) {
+            body = 0x7FC0;
+        }
+        return (bfloat16_t)((sign >> 16) | body);
+    }
+
+    uint32_t round_bias = 0x7FFF + ((bits >> 16) & 1);
+    return (bfloat16_t)((bits + round_bias) >> 16);
+}
+
+// Convert float32 to bfloat16, rounding stochastically with 32 random bits
+bfloat16_t f32_to_bf16_sr(float f, uint32_t rnd) {
+    uint32_t bits = f32_bits(f);
+    if ((bits & 0x7FFFFFFF) > 0x7F800000) {
+        return f32_to_bf16(f);
+    }
+    // Add 16 random bits below the kept ones and truncate. The grid is
+    // uniform through the subnormals, and a carry past the largest finite
+    // value gives infinity.
+    return (bfloat16_t)((bits + (rnd >> 16)) >> 16);
+}
+
+// ============================================================================
+// Portable kernels
+// ============================================================================
+
+static inline bfloat16_t f32_to_bf16_portable(float f) {
+    uint32_t x = f32_bits(f);
+    uint32_t a = x & 0x7FFFFFFF;
+    uint32_t r = (x + 0x7FFF + ((x >> 16) & 1)) >> 16;
+    uint32_t nan = (x >> 16 & 0x8000) | 0x7F80 | ((x >> 16) & 0x7F);
+    nan |= ((x >> 16) & 0x7F) ? 0 : 0x40;
+    return (bfloat16_t)(a > 0x7F800000 ? nan : r);
+}
+
+CPU_VECTORIZE static void bf16_to_f32_n_portable(size_t n, const bfloat16_t *src, float *dst) {
+    for (size_t i = 0; i < n; i++) dst[i] = bits_f32((uint32_t)src[i] << 16);
+}
+
+CPU_VECTORIZE static void f32_to_bf16_n_portable(size_t n, const float *src, bfloat16_t *dst) {
+    for (size_t i = 0; i < n; i++) dst[i] = f32_to_bf16_portable(src[i]);
+}
+
+static inline bfloat16_t f32_to_bf16_sr_portable(float f, uint32_t rnd) {
+    uint32_t x = f32_bits(f);
+    uint32_t r = (x + (rnd >> 16)) >> 16;
+    return (x & 0x7FFFFFFF) > 0x7F800000 ? f32_to_bf16_portable(f) : (bfloat16_t)r;
+}
+
+#define BF16_SR_BLOCK 256
+
+// Random bits a block at a time (philox_fill vectorizes over groups of
+// four), then the conversion; also compiled for AVX2 and AVX-512 below.
+static inline __attribute__((always_inline)) void f32_to_bf16_sr_blocks(size_t n, const float *src, bfloat16_t *dst,
+                                                                        uint64_t seed, uint64_t index) {
+    uint32_t rnd[BF16_SR_BLOCK];
+    for (; n && (index & 3); n--, index++) *dst++ = f32_to_bf16_sr_portable(*src++, philox_bits(seed, index));
+    for (size_t i = 0; i < n; i += BF16_SR_BLOCK) {
+        size_t m = n - i < BF16_SR_BLOCK ? n - i : BF16_SR_BLOCK;
+        philox_fill(seed, index + i, (m + 3) / 4, rnd);
+        for (size_t j = 0; j < m; j++) dst[i + j] = f32_to_bf16_sr_portable(src[i + j], rnd[j]);
+    }
+}
+
+CPU_VECTORIZE static void f32_to_bf16_sr_n_portable(size_t n, const float *src, bfloat16_t *dst,
+                                                    uint64_t seed, uint64_t index) {
+    f32_to_bf16_sr_blocks(n, src, dst, seed, index);
+}
+
+#define BF16_BLOCK 32       // elements per dot block
+#define BF16_LANES 16       // f32 accumulators
+
+static inline float bf16_daz(float f) {
+    uint32_t u = f32_bits(f);
+    return (u & 0x7F800000) ? f : bits_f32(u & 0x80000000u);
+}
+
+// One vdpbf16ps step: acc + a * b, DAZ inputs, one rounding with an
+// unbounded exponent, results below 2^-126 flushed to signed zero.
+static inline float bf16_dot_step(float acc, float a, float b) {
+    a = bf16_daz(a);
+    b = bf16_daz(b);
+    acc = bf16_daz(acc);
+    float r = fmaf(a, b, acc);
+    if (fabsf(r) < 0x1p-126f) return copysignf(0.0f, r);
+    if (fabsf(r) == 0x1p-126f) {
+        // fmaf rounded on the subnormal grid, which reaches 2^-126 from
+        // half an ulp further down. Redo it scaled into the normal range.
+        // Only tiny operands get here, so the scaling is exact.
+        float lo = fabsf(a) < fabsf(b) ? a : b, hi = fabsf(a) < fabsf(b) ? b : a;
+        float r2 = fmaf(lo * 0x1p64f, hi, acc * 0x1p64f);
+        return fabsf(r2) < 0x1p-62f ? copysignf(0.0f, r2) : r2 * 0x1p-64f;
+    }
+    return r;
+}
+
+static void bf16_block_portable(float acc[BF16_LANES], const bfloat16_t *a, const bfloat16_t *b) {
+    for (int i = 0; i < BF16_LANES; i++) {
+        acc[i] = bf16_dot_step(acc[i], bf16_to_f32(a[2 * i + 1]), bf16_to_f32(b[2 * i + 1]));
+        acc[i] = bf16_dot_step(acc[i], bf16_to_f32(a[2 * i]), bf16_to_f32(b[2 * i]));
+    }
+}
+
+static float bf16_lanes_combine(float lanes[BF16_LANES]) {
+    for (int s = BF16_LANES / 2; s > 0; s /= 2)
+        for (int i = 0; i < s; i++) lanes[i] += lanes[i + s];
+    return isnan(lanes[0]) ? bits_f32(0x7FC00000) : lanes[0];
+}
+
+// Zero-padded copy of a partial last block
+static void bf16_pad(size_t m, const bfloat16_t *a, const bfloat16_t *b,
+                     bfloat16_t ta[BF16_BLOCK], bfloat16_t tb[BF16_BLOCK]) {
+    memset(ta, 0, BF16_BLOCK * sizeof(*ta));
+    memset(tb, 0, BF16_BLOCK * sizeof(*tb));
+    memcpy(ta, a, m * sizeof(*a));
+    memcpy(tb, b, m * sizeof(*b));
+}
+
+static float bf16_dot_portable(size_t n, const bfloat16_t *a, const bfloat16_t *b) {
+    float acc[BF16_LANES] = {0};
+    size_t i = 0;
+    for (; i + BF16_BLOCK <= n; i += BF16_BLOCK) bf16_block_portable(acc, a + i, b + i);
+    if (i < n) {
+        bfloat16_t ta[BF16_BLOCK], tb[BF16_BLOCK];
+        bf16_pad(n - i, a + i, b + i, ta, tb);
+        bf16_block_portable(acc, ta, tb);
+    }
+    return bf16_lanes_combine(acc);
+}
+
+// GEMM: one accumulator per element of C, stepping through k in pairs the
+// way vdpbf16ps does with a column of C in each lane. Panels are packed as
+// dwords holding a pair (even element low, subnormals already flushed to
+// signed zero): A in BF16G_MR-row blocks, B in strips as wide as the kernel
+// set's register block.
+#define BF16G_MR 8          // rows per register block
+#define BF16G_MAXW 32       // widest register block, in columns
+#define BF16G_MC 64
+#define BF16G_NC 256
+#define BF16G_KQ 128        // k pairs per panel
+
+// kq pair steps on a BF16G_MR x w block of C (row stride ldc), starting
+// from C's values (load) or from zero
+typedef void (*bf16g_micro)(size_t kq, const uint32_t *ap, const uint32_t *bp, float *c, size_t ldc, int load);
+
+static void bf16g_micro_portable(size_t kq, const uint32_t *ap, const uint32_t *bp, float *c, size_t ldc, int load) {
+    float acc[BF16G_MR][8];
+    for (int r = 0; r < BF16G_MR; r++)
+        for (int j = 0; j < 8; j++) acc[r][j] = load ? c[r * ldc + j] : 0.0f;
+    for (size_t q = 0; q < kq; q++)
+        for (int r = 0; r < BF16G_MR; r++) {
+            uint32_t x = ap[q * BF16G_MR + r];
+            float ao = bits_f32(x & 0xFFFF0000u), ae = bits_f32(x << 16);
+            for (int j = 0; j < 8; j++) {
+                uint32_t y = bp[q * 8 + j];
+                acc[r][j] = bf16_dot_step(acc[r][j], ao, bits_f32(y & 0xFFFF0000u));
+                acc[r][j] = bf16_dot_step(acc[r][j], ae, bits_f32(y << 16));
+            }
+        }
+    for (int r = 0; r < BF16G_MR; r++)
+        for (int j = 0; j < 8; j++) c[r * ldc + j] = acc[r][j];
+}
+
+// ============================================================================
+// Hardware kernels
+// ============================================================================
+
+// -DBF16_HW=0 leaves only the portable kernels (to check them on any host)
+#ifndef BF16_HW
+#define BF16_HW 1
+#endif
+
+#if BF16_HW && defined(__GNUC__) && defined(__x86_64__)
+#define BF16_HAVE_X86 1
+#include <immintrin.h>
+
+#define BF16_AVX512_ATTR __attribute__((target("avx512f,avx512bw,avx512bf16")))
+#define BF16_AVX2_ATTR __attribute__((target("avx2,fma")))
+
+CPU_VECTORIZE BF16_AVX2_ATTR
+static void f32_to_bf16_sr_n_avx2(size_t n, const float *src, bfloat16_t *dst, uint64_t seed, uint64_t index) {
+    f32_to_bf16_sr_blocks(n, src, dst, seed, index);
+}
+
+CPU_VECTORIZE BF16_AVX512_ATTR
+static void f32_to_bf16_sr_n_avx512(size_t n, const float *src, bfloat16_t *dst, uint64_t seed, uint64_t index) {
+    f32_to_bf16_sr_blocks(n, src, dst, seed, index);
+}
+
+// Lanes with exponent 0 or 255 and a nonzero fraction: subnormals and NaNs
+BF16_AVX512_ATTR static inline __mmask16 bf16_special_avx512(__m512 v) {
+    __m512i x = _mm512_castps_si512(v);
+    __mmask16 edge = _mm512_testn_epi32_mask(_mm512_add_epi32(x, _mm512_set1_epi32(0x00800000)),
+                                             _mm512_set1_epi32(0x7F000000));
+    return edge & _mm512_test_epi32_mask(x, _mm512_set1_epi32(0x007FFFFF));
+}
+
+BF16_AVX512_ATTR static void f32_to_bf16_n_avx512bf16(size_t n, const float *src, bfloat16_t *dst) {
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m512 lo = _mm512_loadu_ps(src + i), hi = _mm512_loadu_ps(src + i + 16);
+        if (bf16_special_avx512(lo) | bf16_special_avx512(hi)) {
+            f32_to_bf16_n_portable(32, src + i, dst + i);
+            continue;
+        }
+        _mm512_storeu_si512((void *)(dst + i), (__m512i)_mm512_cvtne2ps_pbh(hi, lo));
+    }
+    f32_to_bf16_n_portable(n - i, src + i, dst + i);
+}
+
+BF16_AVX512_ATTR static float bf16_dot_avx512bf16(size_t n, const bfloat16_t *a, const bfloat16_t *b) {
+    __m512 acc = _mm512_setzero_ps();
+    size_t i = 0;
+    for (; i + BF16_BLOCK <= n; i += BF16_BLOCK)
+        acc = _mm512_dpbf16_ps(acc, (__m512bh)_mm512_loadu_si512((const void *)(a + i)),
+                               (__m512bh)_mm512_loadu_si512((const void *)(b + i)));
+    if (i < n) {
+        __mmask32 m = (__mmask32)((1ull << (n - i)) - 1);
+        acc = _mm512_dpbf16_ps(acc, (__m512bh)_mm512_maskz_loadu_epi16(m, a + i),
+                               (__m512bh)_mm512_maskz_loadu_epi16(m, b + i));
+    }
+    float lanes[BF16_LANES];
+    _mm512_storeu_ps(lanes, acc);
+    return bf16_lanes_combine(lanes);
+}
+
+BF16_AVX512_ATTR static void bf16g_micro_avx512bf16(size_t kq, const uint32_t *ap, const uint32_t *bp,
+                                                    float *c, size_t ldc, int load) {
+    __m512 acc[BF16G_MR][2];
+    for (int r = 0; r < BF16G_MR; r++)
+        for (int j = 0; j < 2; j++) acc[r][j] = load ? _mm512_loadu_ps(c + r * ldc + 16 * j) : _mm512_setzero_ps();
+    for (size_t q = 0; q < kq; q++) {
+        __m512bh b0 = (__m512bh)_mm512_loadu_si512((const void *)(bp + q * 32));
+        __m512bh b1 = (__m512bh)_mm512_loadu_si512((const void *)(bp + q * 32 + 16));
+        for (int r = 0; r < BF16G_MR; r++) {
+            __m512bh a = (__m512bh)_mm512_set1_epi32((int)ap[q * BF16G_MR + r]);
+            acc[r][0] = _mm512_dpbf16_ps(acc[r][0], a, b0);
+            acc[r][1] = _mm512_dpbf16_ps(acc[r][1], a, b1);
+        }
+    }
+    for (int r = 0; r < BF16G_MR; r++)
+        for (int j = 0; j < 2; j++) _mm512_storeu_ps(c + r * ldc + 16 * j, acc[r][j]);
+}
+
+// Widen bf16 pairs packed in dwords (even element low) with DAZ
+BF16_AVX2_ATTR static inline __m256 bf16_daz_avx2(__m256i x) {
+    __m256i zero_exp = _mm256_cmpeq_epi32(_mm256_and_si256(x, _mm256_set1_epi32(0x7F800000)),
+                                          _mm256_setzero_si256());
+    return _mm256_castsi256_ps(_mm256_andnot_si256(_mm256_andnot_si256(_mm256_set1_epi32((int)0x80000000u), zero_exp), x));
+}
+
+// Flush results below 2^-126; flag lanes at exactly 2^-126 for the scalar path
+BF16_AVX2_ATTR static inline __m256 bf16_ftz_avx2(__m256 r, int *rare) {
+    const __m256 sign = _mm256_castsi256_ps(_mm256_set1_epi32((int)0x80000000u));
+    const __m256 min_normal = _mm256_set1_ps(0x1p-126f);
+    __m256 mag = _mm256_andnot_ps(sign, r);
+    *rare |= _mm256_movemask_ps(_mm256_cmp_ps(mag, min_normal, _CMP_EQ_OQ));
+    return _mm256_blendv_ps(r, _mm256_and_ps(r, sign), _mm256_cmp_ps(mag, min_normal, _CMP_LT_OQ));
+}
+
+BF16_AVX2_ATTR static void bf16_block_avx2(__m256 acc[2], const bfloat16_t *a, const bfloat16_t *b) {
+    const __m256i odd = _mm256_set1_epi32((int)0xFFFF0000u);
+    __m256 r[2];
+    int rare = 0;
+    for (int j = 0; j < 2; j++) {
+        __m256i va = _mm256_loadu_si256((const __m256i *)(a + 16 * j));
+        __m256i vb = _mm256_loadu_si256((const __m256i *)(b + 16 * j));
+        r[j] = _mm256_fmadd_ps(bf16_daz_avx2(_mm256_and_si256(va, odd)), bf16_daz_avx2(_mm256_and_si256(vb, odd)), acc[j]);
+        r[j] = bf16_ftz_avx2(r[j], &rare);
+        r[j] = _mm256_fmadd_ps(bf16_daz_avx2(_mm256_slli_epi32(va, 16)), bf16_daz_avx2(_mm256_slli_epi32(vb, 16)), r[j]);
+        r[j] = bf16_ftz_avx2(r[j], &rare);
+    }
+    if (rare) {
+        float lanes[BF16_LANES];
+        _mm256_storeu_ps(lanes, acc[0]);
+        _mm256_storeu_ps(lanes + 8, acc[1]);
+        bf16_block_portable(lanes, a, b);
+        r[0] = _mm256_loadu_ps(lanes);
+        r[1] = _mm256_loadu_ps(lanes + 8);
+    }
+    acc[0] = r[0];
+    acc[1] = r[1];
+}
+
+// The packed pairs are already flushed, and so is every accumulator; a
+// lane landing on exactly 2^-126 sends the block to the portable kernel
+BF16_AVX2_ATTR static void bf16g_micro_avx2_fma(size_t kq, const uint32_t *ap, const uint32_t *bp,
+                                               float *c, size_t ldc, int load) {
+    const __m256i odd = _mm256_set1_epi32((int)0xFFFF0000u);
+    __m256 acc[BF16G_MR];
+    for (int r = 0; r < BF16G_MR; r++) acc[r] = load ? _mm256_loadu_ps(c + r * ldc) : _mm256_setzero_ps();
+    int rare = 0;
+    for (size_t q = 0; q < kq; q++) {
+        __m256i vb = _mm256_loadu_si256((const __m256i *)(bp + q * 8));
+        __m256 bo = _mm256_castsi256_ps(_mm256_and_si256(vb, odd));
+        __m256 be = _mm256_castsi256_ps(_mm256_slli_epi32(vb, 16));
+        for (int r = 0; r < BF16G_MR; r++) {
+            __m256i va = _mm256_set1_epi32((int)ap[q * BF16G_MR + r]);
+            acc[r] = bf16_ftz_avx2(_mm256_fmadd_ps(_mm256_castsi256_ps(_mm256_and_si256(va, odd)), bo, acc[r]), &rare);
+            acc[r] = bf16_ftz_avx2(_mm256_fmadd_ps(_mm256_castsi256_ps(_mm256_slli_epi32(va, 16)), be, acc[r]), &rare);
+        }
+    }
+    if (rare) {
+        bf16g_micro_portable(kq, ap, bp, c, ldc, load);
+        return;
+    }
+    for (int r = 0; r < BF16G_MR; r++) _mm256_storeu_ps(c + r * ldc, acc[r]);
+}
+
+BF16_AVX2_ATTR static float bf16_dot_avx2_fma(size_t n, const bfloat16_t *a, const bfloat16_t *b) {
+    __m256 acc[2] = { _mm256_setzero_ps(), _mm256_setzero_ps() };
+    size_t i = 0;
+    for (; i + BF16_BLOCK <= n; i += BF16_BLOCK) bf16_block_avx2(acc, a + i, b + i);
+    if (i < n) {
+        bfloat16_t ta[BF16_BLOCK], tb[BF16_BLOCK];
+        bf16_pad(n - i, a + i, b + i, ta, tb);
+        bf16_block_avx2(acc, ta, tb);
+    }
+    float lanes[BF16_LANES];
+    _mm256_storeu_ps(lanes, acc[0]);
+    _mm256_storeu_ps(lanes + 8, acc[1]);
+    return bf16_lanes_combine(lanes);
+}
+
+#elif BF16_HW && defined(__GNUC__) && defined(__aarch64__)
+#define BF16_HAVE_NEON 1
+#include <arm_neon.h>
+
+static inline float32x4_t bf16_daz_neon(uint32x4_t x) {
+    uint32x4_t zero_exp = vceqq_u32(vandq_u32(x, vdupq_n_u32(0x7F800000)), vdupq_n_u32(0));
+    return vreinterpretq_f32_u32(vbicq_u32(x, vbicq_u32(zero_exp, vdupq_n_u32(0x80000000u))));
+}
+
+static inline float32x4_t bf16_ftz_neon(float32x4_t r, uint32_t *rare) {
+    float32x4_t min_normal = vdupq_n_f32(0x1p-126f);
+    uint32x4_t u = vreinterpretq_u32_f32(r);
+    *rare |= vmaxvq_u32(vceqq_f32(vabsq_f32(r), min_normal));
+    uint32x4_t tiny = vcaltq_f32(r, min_normal);
+    return vreinterpretq_f32_u32(vbslq_u32(tiny, vandq_u32(u, vdupq_n_u32(0x80000000u)), u));
+}
+
+// vfmaq rounds per FPCR: round-to-nearest, no flush-to-zero (the defaults)
+static void bf16_block_neon(float32x4_t acc[4], const bfloat16_t *a, const bfloat16_t *b) {
+    const uint32x4_t odd = vdupq_n_u32(0xFFFF0000u);
+    float32x4_t r[4];
+    uint32_t rare = 0;
+    for (int j = 0; j < 4; j++) {
+        uint32x4_t va = vreinterpretq_u32_u16(vld1q_u16(a + 8 * j));
+        uint32x4_t vb = vreinterpretq_u32_u16(vld1q_u16(b + 8 * j));
+        r[j] = vfmaq_f32(acc[j], bf16_daz_neon(vandq_u32(va, odd)), bf16_daz_neon(vandq_u32(vb, odd)));
+        r[j] = bf16_ftz_neon(r[j], &rare);
+        r[j] = vfmaq_f32(r[j], bf16_daz_neon(vshlq_n_u32(va, 16)), bf16_daz_neon(vshlq_n_u32(vb, 16)));
+        r[j] = bf16_ftz_neon(r[j], &rare);
+    }
+    if (rare) {
+        float lanes[BF16_LANES];
+        for (int j = 0; j < 4; j++) vst1q_f32(lanes + 4 * j, acc[j]);
+        bf16_block_portable(lanes, a, b);
+        for (int j = 0; j < 4; j++) r[j] = vld1q_f32(lanes + 4 * j);
+    }
+    for (int j = 0; j < 4; j++) acc[j] = r[j];
+}
+
+static void bf16g_micro_neon(size_t kq, const uint32_t *ap, const uint32_t *bp, float *c, size_t ldc, int load) {
+    const uint32x4_t odd = vdupq_n_u32(0xFFFF0000u);
+    float32x4_t acc[BF16G_MR][2];
+    for (int r = 0; r < BF16G_MR; r++)
+        for (int j = 0; j < 2; j++) acc[r][j] = load ? vld1q_f32(c + r * ldc + 4 * j) : vdupq_n_f32(0.0f);
+    uint32_t rare = 0;
+    for (size_t q = 0; q < kq; q++) {
+        float32x4_t bo[2], be[2];
+        for (int j = 0; j < 2; j++) {
+            uint32x4_t vb = vld1q_u32(bp + q * 8 + 4 * j);
+            bo[j] = vreinterpretq_f32_u32(vandq_u32(vb, odd));
+            be[j] = vreinterpretq_f32_u32(vshlq_n_u32(vb, 16));
+        }
+        for (int r = 0; r < BF16G_MR; r++) {
+            uint32x4_t va = vdupq_n_u32(ap[q * BF16G_MR + r]);
+            float32x4_t ao = vreinterpretq_f32_u32(vandq_u32(va, odd));
+            float32x4_t ae = vreinterpretq_f32_u32(vshlq_n_u32(va, 16));
+            for (int j = 0; j < 2; j++) {
+                acc[r][j] = bf16_ftz_neon(vfmaq_f32(acc[r][j], ao, bo[j]), &rare);
+                acc[r][j] = bf16_ftz_neon(vfmaq_f32(acc[r][j], ae, be[j]), &rare);
+            }
+        }
+    }
+    if (rare) {
+        bf16g_micro_portable(kq, ap, bp, c, ldc, load);
+        return;
+    }
+    for (int r = 0; r < BF16G_MR; r++)
+        for (int j = 0; j < 2; j++) vst1q_f32(c + r * ldc + 4 * j, acc[r][j]);
+}
+
+static float bf16_dot_neon(size_t n, const bfloat16_t *a, const bfloat16_t *b) {
+    float32x4_t acc[4];
+    for (int j = 0; j < 4; j++) acc[j] = vdupq_n_f32(0.0f);
+    size_t i = 0;
+    for (; i + BF16_BLOCK <= n; i += BF16_BLOCK) bf16_block_neon(acc, a + i, b + i);
+    if (i < n) {
+        bfloat16_t ta[BF16_BLOCK], tb[BF16_BLOCK];
+        bf16_pad(n - i, a + i, b + i, ta, tb);
+        bf16_block_neon(acc, ta, tb);
+    }
+    float lanes[BF16_LANES];
+    for (int j = 0; j < 4; j++) vst1q_f32(lanes + 4 * j, acc[j]);
+    return bf16_lanes_combine(lanes);
+}
+#endif
+
+// ============================================================================
+// Dispatch
+// ============================================================================
+
+typedef struct {
+    const char *isa;
+    void (*to_f32)(size_t, const bfloat16_t*, float*);
+    void (*to_bf16)(size_t, const float*, bfloat16_t*);
+    float (*dot)(size_t, const bfloat16_t*, const bfloat16_t*);
+    void (*to_bf16_sr)(size_t, const float*, bfloat16_t*, uint64_t, uint64_t);
+    bf16g_micro gemm;
+    size_t gemm_w;                  // columns in the gemm register block
+} bf16_kernels;
+
+static const bf16_kernels bf16_kernels_portable =
+    { "portable", bf16_to_f32_n_portable, f32_to_bf16_n_portable, bf16_dot_portable, f32_to_bf16_sr_n_portable,
+      bf16g_micro_portable, 8 };
+#if BF16_HAVE_X86
+static const bf16_kernels bf16_kernels_avx2_fma =
+    { "avx2+fma", bf16_to_f32_n_portable, f32_to_bf16_n_portable, bf16_dot_avx2_fma, f32_to_bf16_sr_n_avx2,
+      bf16g_micro_avx2_fma, 8 };
+static const bf16_kernels bf16_kernels_avx512bf16 =
+    { "avx512bf16", bf16_to_f32_n_portable, f32_to_bf16_n_avx512bf16, bf16_dot_avx512bf16, f32_to_bf16_sr_n_avx512,
+      bf16g_micro_avx512bf16, 32 };
+#endif
+#if BF16_HAVE_NEON
+static const bf16_kernels bf16_kernels_neon =
+    { "neon", bf16_to_f32_n_portable, f32_to_bf16_n_portable, bf16_dot_neon, f32_to_bf16_sr_n_portable,
+      bf16g_micro_neon, 8 };
+#endif
+
+static const bf16_kernels *bf16_select(void) {
+    const bf16_kernels *k = &bf16_kernels_portable;
+#if BF16_HAVE_X86
+    if (cpu_has(CPU_AVX512BF16 | CPU_AVX512BW)) k = &bf16_kernels_avx512bf16;
+    else if (cpu_has(CPU_AVX2 | CPU_FMA)) k = &bf16_kernels_avx2_fma;
+#endif
+#if BF16_HAVE_NEON
+    if (cpu_has(CPU_NEON)) k = &bf16_kernels_neon;   // FMA is mandatory on aarch64
+#endif
+    return k;
+}
+
+CPU_DISPATCH(bf16_kernels, bf16, bf16_select)
+
+const char *bf16_math_isa(void) {
+    return bf16_k()->isa;
+}
+
+void bf16_to_f32_n(size_t n, const bfloat16_t *src, float *dst) {
+    bf16_k()->to_f32(n, src, dst);
+}
+
+void f32_to_bf16_n(size_t n, const float *src, bfloat16_t *dst) {
+    bf16_k()->to_bf16(n, src, dst);
+}
+
+float bf16_dot(size_t n, const bfloat16_t *a, const bfloat16_t *b) {
+    return bf16_k()->dot(n, a, b);
+}
+
+void f32_to_bf16_sr_n(size_t n, const float *src, bfloat16_t *dst, uint64_t seed, uint64_t index) {
+    bf16_k()->to_bf16_sr(n, src, dst, seed, index);
+}
+
+// ============================================================================
+// GEMM driver
+// ============================================================================
+
+// Elements p and p + 1 of a vector with the given stride as one dword,
+// zero past k, subnormals flushed to signed zero
+static inline uint32_t bf16g_pair(const bfloat16_t *x, size_t stride, size_t p, size_t k) {
+    uint32_t lo = p < k ? x[p * stride] : 0, hi = p + 1 < k ? x[(p + 1) * stride] : 0;
+    lo = lo & 0x7F80 ? lo : lo & 0x8000;
+    hi = hi & 0x7F80 ? hi : hi & 0x8000;
+    return lo | hi << 16;
+}
+
+// The definition element by element, for when the panels cannot be allocated
+static void bf16_gemm_unpacked(size_t m, size_t n, size_t k, const bfloat16_t *a, size_t lda,
+                               const bfloat16_t *b, size_t ldb, float *c, size_t ldc) {
+    for (size_t i = 0; i < m; i++)
+        for (size_t j = 0; j < n; j++) {
+            float acc = 0.0f;
+            for (size_t p = 0; p < k; p += 2) {
+                uint32_t x = bf16g_pair(a + i * lda, 1, p, k), y = bf16g_pair(b + j, ldb, p, k);
+                acc = bf16_dot_step(acc, bits_f32(x & 0xFFFF0000u), bits_f32(y & 0xFFFF0000u));
+                acc = bf16_dot_step(acc, bits_f32(x << 16), bits_f32(y << 16));
+            }
+            c[i * ldc + j] = acc;
+        }
+}
+
+static void bf16_gemm_k(const bf16_kernels *kn, size_t m, size_t n, size_t k, const bfloat16_t *a, size_t lda,
+                        const bfloat16_t *b, size_t ldb, float *c, size_t ldc) {
+    const size_t w = kn->gemm_w, kp = (k + 1) / 2;
+    uint32_t *ap = (uint32_t*)malloc(BF16G_MC * BF16G_KQ * sizeof(uint32_t));
+    uint32_t *bp = (uint32_t*)malloc(BF16G_NC * BF16G_KQ * sizeof(uint32_t));
+    if (!ap || !bp || kp == 0) {
+        bf16_gemm_unpacked(m, n, k, a, lda, b, ldb, c, ldc);
+    } else {
+        for (size_t jc = 0; jc < n; jc += BF16G_NC) {
+            size_t nc = n - jc < BF16G_NC ? n - jc : BF16G_NC, np = (nc + w - 1) / w * w;
+            for (size_t pc = 0; pc < kp; pc += BF16G_KQ) {
+                size_t kq = kp - pc < BF16G_KQ ? kp - pc : BF16G_KQ;
+                for (size_t jr = 0; jr < np; jr += w)
+                    for (size_t q = 0; q < kq; q++)
+                        for (size_t x = 0; x < w; x++) {
+                            size_t j = jc + jr + x;
+                            bp[jr * kq + q * w + x] = j < n ? bf16g_pair(b + j, ldb, 2 * (pc + q), k) : 0;
+                        }
+                for (size_t ic = 0; ic < m; ic += BF16G_MC) {
+                    size_t mc = m - ic < BF16G_MC ? m - ic : BF16G_MC;
+                    size_t mp = (mc + BF16G_MR - 1) / BF16G_MR * BF16G_MR;
+                    for (size_t ir = 0; ir < mp; ir += BF16G_MR)
+                        for (size_t q = 0; q < kq; q++)
+                            for (size_t r = 0; r < BF16G_MR; r++) {
+                                size_t i = ic + ir + r;
+                                ap[ir * kq + q * BF16G_MR + r] = i < m ? bf16g_pair(a + i * lda, 1, 2 * (pc + q), k) : 0;
+                            }
+                    for (size_t jr = 0; jr < np; jr += w)
+                        for (size_t ir = 0; ir < mp; ir += BF16G_MR) {
+                            size_t rows = mc - ir < BF16G_MR ? mc - ir : BF16G_MR, cols = nc - jr < w ? nc - jr : w;
+                            float *ct = c + (ic + ir) * ldc + jc + jr;
+                            if (rows == BF16G_MR && cols == w) {
+                                kn->gemm(kq, ap + ir * kq, bp + jr * kq, ct, ldc, pc > 0);
+                                continue;
+                            }
+                            // a ragged edge block runs on a full-size copy
+                            float t[BF16G_MR * BF16G_MAXW] = {0};
+                            for (size_t r = 0; r < rows && pc > 0; r++) memcpy(t + r * w, ct + r * ldc, cols * sizeof(float));
+                            kn->gemm(kq, ap + ir * kq, bp + jr * kq, t, w, pc > 0);
+                            for (size_t r = 0; r < rows; r++) memcpy(ct + r * ldc, t + r * w, cols * sizeof(float));
+                        }
+                }
+            }
+        }
+    }
+    free(ap);
+    free(bp);
+    for (size_t i = 0; i < m; i++)
+        for (size_t j = 0; j < n; j++)
+            if (isnan(c[i * ldc + j])) c[i * ldc + j] = bits_f32(0x7FC00000);
+}
+
+void bf16_gemm(size_t m, size_t n, size_t k, const bfloat16_t *a, size_t lda,
+               const bfloat16_t *b, size_t ldb, float *c, size_t ldc) {
+    bf16_gemm_k(bf16_k(), m, n, k, a, lda, b, ldb, c, ldc);
+}
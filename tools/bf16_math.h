@@ -0,0 +1,74 @@
+/**
+ * C interop header for BF16 (bfloat16) conversion and dot products
+ */
+
+#ifndef BF16_MATH_H
+#define BF16_MATH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef uint16_t bfloat16_t;
+
+// Reference conversions (the CBF16.kt semantics):
+// - bf16 -> f32 is exact: the bits shifted left by 16
+// - f32 -> bf16 rounds to nearest even, f32 subnormals included, and
+//   overflows to infinity. A NaN keeps its sign and the top 7 payload bits;
+//   if those are all zero it becomes the quiet NaN 0x7FC0 (with the sign).
+float bf16_to_f32(bfloat16_t h);
+bfloat16_t f32_to_bf16(float f);
+
+// Bulk conversions, bit-identical to the reference calls above for every
+// input. src and dst must not overlap.
+void bf16_to_f32_n(size_t n, const bfloat16_t *src, float *dst);
+void f32_to_bf16_n(size_t n, const float *src, bfloat16_t *dst);
+
+// Stochastic rounding: f32 -> bf16 rounded down or up at random, with
+// probability in proportion to the distance to each neighbour (subnormals
+// included; past the largest finite value the upper neighbour is
+// infinity), so the expected result is the input. NaN is handled as in
+// f32_to_bf16. rnd supplies the randomness: its top 16 bits.
+bfloat16_t f32_to_bf16_sr(float f, uint32_t rnd);
+
+// Bulk stochastic rounding: dst[i] = f32_to_bf16_sr(src[i],
+// philox_bits(seed, index + i)) (philox.h), so results depend only on the
+// seed and each element's index, however a buffer is split across calls
+// or threads. src and dst must not overlap.
+void f32_to_bf16_sr_n(size_t n, const float *src, bfloat16_t *dst, uint64_t seed, uint64_t index);
+
+// Dot product accumulated in f32, with the AVX-512 BF16 vdpbf16ps
+// semantics, so every kernel set gives the same bits:
+// - a and b are zero-padded to a multiple of 32 elements. Element j of
+//   each 32-element block goes to accumulator (j / 2) of 16; each
+//   accumulator adds its odd element's product, then its even one's.
+// - Each step is acc = a * b + acc, rounded once to a 24-bit significand
+//   (nearest even, unbounded exponent). Subnormal inputs and accumulators
+//   read as signed zero, and results below 2^-126 flush to signed zero.
+// - The 16 accumulators are summed pairwise (i + 8, i + 4, i + 2, i + 1)
+//   in ordinary f32 arithmetic. A NaN result is returned as 0x7FC00000.
+float bf16_dot(size_t n, const bfloat16_t *a, const bfloat16_t *b);
+
+// C = A B for row-major bf16 A (m x k) and B (k x n) into f32 C (m x n),
+// leading dimensions lda, ldb and ldc in elements. Each element of C has
+// one accumulator that runs through k in pairs with bf16_dot's step
+// rules: k is zero-padded to even, and pair (2q, 2q + 1) adds its odd
+// product, then its even one. That is vdpbf16ps with a column of C in each
+// lane, so every kernel set gives the same bits; they differ from
+// bf16_dot's, which spreads a vector over 16 accumulators. A NaN element
+// is 0x7FC00000. Cache-blocked and vectorized, on the calling thread. C
+// must not overlap A or B.
+void bf16_gemm(size_t m, size_t n, size_t k, const bfloat16_t *a, size_t lda,
+               const bfloat16_t *b, size_t ldb, float *c, size_t ldc);
+
+// Kernel set in use: "avx512bf16", "avx2+fma", "neon" or "portable"
+const char *bf16_math_isa(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BF16_MATH_H
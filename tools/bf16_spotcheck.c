@@ -0,0 +1,296 @@
+/**
+ * bf16_spotcheck.c - C reference implementation for BF16 validation
+ *
+ * Compile: gcc -std=c11 -O2 -pthread -o bf16_spotcheck bf16_spotcheck.c bf16_math.c -lm
+ * Run: ./bf16_spotcheck [--exhaustive] [--threads N] [--kotlin-bf16 FILE] [--kotlin-f32 FILE]
+ *
+ * This generates reference test vectors that the Kotlin CBF16
+ * implementation should match exactly (bit-for-bit), then checks the bulk
+ * conversions (stochastic rounding included), bf16_dot and bf16_gemm in
+ * bf16_math.c against the reference and exits 1 on any mismatch.
+ */
+
+#define _POSIX_C_SOURCE 200809L   // clock_gettime, pread
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <time.h>
+#include "bf16_math.h"
+#include "spotcheck_sweep.h"
+
+static uint32_t f32_bits(float f) { uint32_t u; memcpy(&u, &f, 4); return u; }
+static float bits_f32(uint32_t u) { float f; memcpy(&f, &u, 4); return f; }
+
+static uint64_t rng = 88172645463325252ull;
+static uint64_t next_rand(void) { rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17; return rng; }
+
+// ============================================================================
+// Dot product reference
+// ============================================================================
+
+static float daz(float f) {
+    uint32_t u = f32_bits(f);
+    return (u & 0x7F800000) ? f : bits_f32(u & 0x80000000u);
+}
+
+// acc + a * b from its exact value: the product is exact in double and the
+// sum exact as a two_sum pair, rounded here to 24 bits by hand
+static float ref_step(float acc, float a, float b) {
+    a = daz(a); b = daz(b); acc = daz(acc);
+    double p = (double)a * (double)b;
+    double hi = (double)acc + p;
+    if (!isfinite(hi) || hi == 0) return (float)hi;
+    double v = hi - (double)acc;
+    double lo = ((double)acc - (hi - v)) + (p - v);
+
+    double H = fabs(hi), L = hi < 0 ? -lo : lo;   // exact |sum| = H + L
+    int e;
+    frexp(H, &e);                                  // H in [2^(e-1), 2^e)
+    if (H == ldexp(1.0, e - 1) && L < 0) e--;      // sum just below a power of two
+    double q = ldexp(1.0, e - 24);                 // ulp of a 24-bit significand
+    double f = floor(H / q) * q, rem = H - f;
+    if (rem == 0 && L < 0) { f -= q; rem = q; }
+    double d = rem - q / 2;                        // round up iff d + L > 0
+    if (d > -L || (d == -L && fmod(f / q, 2.0) != 0)) f += q;
+    if (f < 0x1p-126) f = 0;
+    return (float)copysign(f, hi);
+}
+
+static float ref_dot(size_t n, const bfloat16_t *a, const bfloat16_t *b) {
+    float acc[16] = {0};
+    for (size_t blk = 0; blk < n; blk += 32) {
+        for (int i = 0; i < 16; i++) {
+            for (int k = 1; k >= 0; k--) {
+                size_t j = blk + 2 * (size_t)i + (size_t)k;
+                float x = j < n ? bf16_to_f32(a[j]) : 0.0f, y = j < n ? bf16_to_f32(b[j]) : 0.0f;
+                acc[i] = ref_step(acc[i], x, y);
+            }
+        }
+    }
+    for (int s = 8; s > 0; s /= 2)
+        for (int i = 0; i < s; i++) acc[i] += acc[i + s];
+    return isnan(acc[0]) ? bits_f32(0x7FC00000) : acc[0];
+}
+
+// ============================================================================
+// Bulk checks
+// ============================================================================
+
+// Random bf16: ordinary magnitudes, the full range, or near the f32
+// underflow threshold (where products and sums flush)
+static bfloat16_t rand_bf16(int mode) {
+    uint32_t e = mode == 0 ? 100 + next_rand() % 56 : mode == 1 ? next_rand() % 256 : 50 + next_rand() % 30;
+    return (bfloat16_t)((next_rand() & 0x8000) | e << 7 | (next_rand() & 0x7F));
+}
+
+// Conversions: every bf16 input, and f32 inputs covering every
+// sign/exponent with all 2^16 rounding tails (random upper fraction bits)
+// plus edges; the exhaustive mode checks all 2^32 f32 inputs on several
+// threads, and Kotlin-exported tables if given (see spotcheck_sweep.h).
+// bf16_dot: random vectors of every length up to 100 and some long ones.
+// Returns the number of mismatches.
+static size_t check_bulk(const sweep_opts *o) {
+    printf("\n=== Bulk Kernels (%s) ===\n", bf16_math_isa());
+    const size_t chunk = 1u << 20;
+    bfloat16_t *h = malloc(chunk * sizeof(*h)), *h2 = malloc(chunk * sizeof(*h2));
+    float *f = malloc(chunk * sizeof(*f));
+    if (!h || !h2 || !f) { printf("  (allocation failed)\n"); exit(1); }
+    size_t bad = sweep_widen("bf16 -> f32", bf16_to_f32, bf16_to_f32_n, o->kotlin_widen);
+
+    if (o->exhaustive) {
+        bad += sweep_narrow("f32 -> bf16", f32_to_bf16, f32_to_bf16_n, o->threads, o->kotlin_narrow);
+    } else {
+        size_t bad16 = 0, checked = 0;
+        static const uint32_t edge[16] = {
+            0x00000001, 0x007FFFFF, 0x007F8000, 0x00008000, 0x7F7F7FFF, 0x7F7F8000, 0x7F7FFFFF, 0x7F800000,
+            0x7F800001, 0x7F810000, 0x7FC00000, 0x7FFFFFFF, 0x7F80FFFF, 0x3F808000, 0x3F818000, 0x3F80FFFF };
+        uint64_t total = 512ull * 65536 + 32;
+        for (uint64_t base = 0; base < total; base += chunk) {
+            size_t m = (size_t)(total - base < chunk ? total - base : chunk);
+            for (size_t j = 0; j < m; j++) {
+                uint64_t k = base + j;
+                uint32_t u;
+                if (k < 512ull * 65536) u = (uint32_t)(k >> 16) << 23 | ((uint32_t)next_rand() & 0x7F0000) | (uint32_t)(k & 0xFFFF);
+                else u = edge[(k - 512ull * 65536) % 16] | (uint32_t)((k - 512ull * 65536) / 16) << 31;
+                f[j] = bits_f32(u);
+            }
+            f32_to_bf16_n(m, f, h);
+            for (size_t j = 0; j < m; j++) h2[j] = f32_to_bf16(f[j]);
+            for (size_t j = 0; j < m; j++)
+                if (h[j] != h2[j] && bad16++ < 8)
+                    printf("  f32 0x%08X -> 0x%04X, reference 0x%04X\n", f32_bits(f[j]), h[j], h2[j]);
+            checked += m;
+        }
+        printf("f32 -> bf16: %zu inputs, %zu mismatches\n", checked, bad16);
+        bad += bad16;
+    }
+
+    size_t bad_dot = 0, dots = 0;
+    bfloat16_t *a = h, *b = h2;
+    for (int rep = 0; rep < 3000; rep++) {
+        size_t n = rep < 3 * 101 ? (size_t)rep / 3 : 1 + next_rand() % 5000;
+        int mode = rep % 3;
+        for (size_t j = 0; j < n; j++) { a[j] = rand_bf16(mode); b[j] = rand_bf16(mode); }
+        if (rep % 7 == 6 && n > 0) a[next_rand() % n] = (next_rand() & 1) ? 0x7F80 : 0x0001;  // inf, subnormal
+        if (rep % 5 == 4 && n > 1) a[1] = b[1] = 0x2000;   // lane 0 reaches exactly 2^-126
+        float got = bf16_dot(n, a, b), want = ref_dot(n, a, b);
+        if (f32_bits(got) != f32_bits(want) && bad_dot++ < 8)
+            printf("  dot n=%zu mode %d: 0x%08X, reference 0x%08X\n", n, mode, f32_bits(got), f32_bits(want));
+        dots++;
+    }
+    printf("bf16_dot: %zu vectors, %zu mismatches\n", dots, bad_dot);
+    bad += bad_dot;
+
+    // Throughput on a buffer larger than L2
+    const size_t n = chunk;
+    for (size_t j = 0; j < n; j++) f[j] = bits_f32(0x3C000000 + (uint32_t)(j * 2654435761u % 0x08000000));
+    const int reps = 50;
+    double t0 = sweep_now_s();
+    for (int r = 0; r < reps; r++) f32_to_bf16_n(n, f, h);
+    double t_narrow = (sweep_now_s() - t0) / reps;
+    for (size_t j = 0; j < n; j++) h2[j] = h[(j * 7) % n];
+    t0 = sweep_now_s();
+    volatile float sink = 0;
+    for (int r = 0; r < reps; r++) sink += bf16_dot(n, h, h2);
+    double t_dot = (sweep_now_s() - t0) / reps;
+    t0 = sweep_now_s();
+    sink += ref_dot(n, h, h2);
+    double t_ref = sweep_now_s() - t0;
+    printf("f32 -> bf16: %.2f ns/elem (%.1f GB/s)\n", t_narrow / n * 1e9, 6.0 * n / t_narrow * 1e-9);
+    printf("bf16_dot:    %.3f ns/elem (%.1f GB/s), reference %.1f ns/elem\n",
+           t_dot / n * 1e9, 4.0 * n / t_dot * 1e-9, t_ref / n * 1e9);
+
+    free(h); free(h2); free(f);
+    return bad;
+}
+
+// One element of bf16_gemm: k in pairs, odd product first, zero-padded
+static float ref_gemm(size_t k, const bfloat16_t *a, const bfloat16_t *b, size_t ldb) {
+    float acc = 0.0f;
+    for (size_t p = 0; p < k; p += 2)
+        for (size_t q = p + 2; q-- > p;) {
+            float x = q < k ? bf16_to_f32(a[q]) : 0.0f, y = q < k ? bf16_to_f32(b[q * ldb]) : 0.0f;
+            acc = ref_step(acc, x, y);
+        }
+    return isnan(acc) ? bits_f32(0x7FC00000) : acc;
+}
+
+static size_t gemm_mismatches(size_t m, size_t n, size_t k, const bfloat16_t *a, size_t lda,
+                              const bfloat16_t *b, size_t ldb, const float *c, size_t ldc) {
+    size_t bad = 0;
+    for (size_t i = 0; i < m; i++)
+        for (size_t j = 0; j < n; j++) {
+            float want = ref_gemm(k, a + i * lda, b + j, ldb), got = c[i * ldc + j];
+            if (f32_bits(got) != f32_bits(want) && bad++ < 8)
+                printf("  gemm %zux%zux%zu C[%zu][%zu]: 0x%08X, reference 0x%08X\n",
+                       m, n, k, i, j, f32_bits(got), f32_bits(want));
+        }
+    return bad;
+}
+
+// bf16_gemm against ref_gemm: tiny and empty shapes, then 70 x 300 x 301
+// (ragged register blocks, two column panels, two k panels, odd k, leading
+// dimensions wider than the matrices) for each rand_bf16 range, where
+// products overflow or flush, with a few infinities and NaNs. Then the
+// throughput. Returns the number of mismatches.
+static size_t check_gemm(void) {
+    printf("\n=== GEMM (%s) ===\n", bf16_math_isa());
+    const size_t m = 70, n = 300, k = 301, lda = k + 3, ldb = n + 5, ldc = n + 1, big = 512;
+    bfloat16_t *a = malloc(big * big * sizeof(*a)), *b = malloc(big * big * sizeof(*b));
+    float *c = malloc(big * big * sizeof(*c));
+    if (!a || !b || !c) { printf("  (allocation failed)\n"); exit(1); }
+    size_t bad = 0, checked = 0;
+
+    static const size_t shapes[][3] = { {1, 1, 1}, {3, 17, 1}, {9, 33, 2}, {8, 32, 0}, {5, 7, 3}, {16, 64, 40} };
+    for (size_t s = 0; s < sizeof(shapes) / sizeof(shapes[0]); s++) {
+        size_t sm = shapes[s][0], sn = shapes[s][1], sk = shapes[s][2];
+        for (size_t i = 0; i < sm * sk; i++) a[i] = rand_bf16(0);
+        for (size_t i = 0; i < sk * sn; i++) b[i] = rand_bf16(0);
+        bf16_gemm(sm, sn, sk, a, sk, b, sn, c, sn);
+        bad += gemm_mismatches(sm, sn, sk, a, sk, b, sn, c, sn);
+        checked += sm * sn;
+    }
+    static const bfloat16_t special[] = { 0x7F80, 0xFF80, 0x7FC0, 0x0001, 0x8000 };
+    for (int mode = 0; mode < 3; mode++) {
+        for (size_t i = 0; i < m * lda; i++)
+            a[i] = next_rand() % 4096 ? rand_bf16(mode) : special[next_rand() % 5];
+        for (size_t i = 0; i < k * ldb; i++)
+            b[i] = next_rand() % 4096 ? rand_bf16(mode) : special[next_rand() % 5];
+        bf16_gemm(m, n, k, a, lda, b, ldb, c, ldc);
+        bad += gemm_mismatches(m, n, k, a, lda, b, ldb, c, ldc);
+        checked += m * n;
+    }
+    printf("bf16_gemm: %zu elements, %zu mismatches\n", checked, bad);
+
+    for (size_t i = 0; i < big * big; i++) { a[i] = rand_bf16(0); b[i] = rand_bf16(0); }
+    bf16_gemm(big, big, big, a, big, b, big, c, big);
+    const int reps = 5;
+    double t0 = sweep_now_s();
+    for (int r = 0; r < reps; r++) bf16_gemm(big, big, big, a, big, b, big, c, big);
+    double t = (sweep_now_s() - t0) / reps;
+    t0 = sweep_now_s();
+    volatile float sink = 0;
+    for (size_t j = 0; j < 64; j++) sink += ref_gemm(big, a, b + j, big);
+    double t_ref = (sweep_now_s() - t0) / (64.0 * big);
+    printf("bf16_gemm %zu x %zu x %zu: %.1f GFLOP/s, reference %.1f ns per multiply-add\n",
+           big, big, big, 2.0 * big * big * big / t * 1e-9, t_ref * 1e9);
+    free(a); free(b); free(c);
+    return bad;
+}
+
+int main(int argc, char **argv) {
+    sweep_opts o;
+    if (sweep_parse(argc, argv, "--kotlin-bf16", "--kotlin-f32", &o) != 0) return 2;
+
+    printf("=== BF16 C Reference Test Vectors ===\n\n");
+
+    // Arithmetic: compute in f32, round back to bf16 (CBF16 semantics)
+    struct { float a, b; } tests[] = {
+        {1.0f, 1.0f}, {2.5f, 3.5f}, {5.0f, 3.0f},
+        {2.0f, 3.0f}, {6.0f, 2.0f}, {-1.5f, 2.5f},
+        {3.14159265f, 2.71828183f}, {1e-38f, 1e-3f}, {3e38f, 3e38f}
+    };
+
+    for (size_t i = 0; i < sizeof(tests) / sizeof(tests[0]); i++) {
+        bfloat16_t h_a = f32_to_bf16(tests[i].a);
+        bfloat16_t h_b = f32_to_bf16(tests[i].b);
+        float a = bf16_to_f32(h_a);
+        float b = bf16_to_f32(h_b);
+
+        printf("Test %zu: a=%.6g (0x%04X) b=%.6g (0x%04X)\n",
+            i, tests[i].a, h_a, tests[i].b, h_b);
+        printf("  add=0x%04X sub=0x%04X mul=0x%04X div=0x%04X\n",
+            f32_to_bf16(a + b), f32_to_bf16(a - b),
+            f32_to_bf16(a * b), f32_to_bf16(a / b));
+    }
+
+    // Conversion edge cases: ties, subnormals, overflow, NaN payloads
+    static const uint32_t conv[] = {
+        0x3F808000, 0x3F818000, 0x3F80FFFF, 0x00000001, 0x007FFFFF, 0x7F7FFFFF,
+        0x7F800000, 0xFF800000, 0x7F800001, 0x7F810000, 0xFFC00000, 0x80000000 };
+    printf("\nf32 -> bf16:\n");
+    for (size_t i = 0; i < sizeof(conv) / sizeof(conv[0]); i++)
+        printf("  0x%08X -> 0x%04X\n", conv[i], f32_to_bf16(bits_f32(conv[i])));
+
+    // Dot products accumulated in f32
+    bfloat16_t da[40], db[40];
+    for (int i = 0; i < 40; i++) {
+        da[i] = f32_to_bf16((float)(i + 1) * 0.1f);
+        db[i] = f32_to_bf16(1.0f / (float)(i + 1));
+    }
+    printf("\nbf16_dot(0.1*(i+1), 1/(i+1)): n=3 0x%08X n=32 0x%08X n=40 0x%08X\n",
+        f32_bits(ref_dot(3, da, db)), f32_bits(ref_dot(32, da, db)), f32_bits(ref_dot(40, da, db)));
+
+    size_t bad = check_bulk(&o);
+    bad += check_gemm();
+
+    // Stochastic rounding: between normals, between subnormals, and below
+    // the largest finite value
+    printf("\n=== Stochastic Rounding (%s) ===\n", bf16_math_isa());
+    static const float sr_probe[] = { 1.0f + 0x1.333334p-9f, -3.1f, 0x1.4ccccp-130f, 3.3e38f };
+    bad += sweep_sr("f32 -> bf16 sr", f32_to_bf16_sr, f32_to_bf16_sr_n, bf16_to_f32,
+                    sr_probe, (int)(sizeof(sr_probe) / sizeof(sr_probe[0])));
+    return bad ? 1 : 0;
+}
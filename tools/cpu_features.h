@@ -0,0 +1,180 @@
+/**
+ * cpu_features.h - CPU feature detection shared by the kernel dispatchers
+ *
+ * Each library in tools/ binds its bulk entry points to one kernel set
+ * when it loads (float16_convert.c, float16_math.c, bf16_math.c,
+ * fp8_convert.c, vmath.c and the double-double batches in
+ * float128_benchmark.c). Each one's select function asks cpu_has() here
+ * which features the CPU has, and CPU_DISPATCH binds the set it returns.
+ * So one build runs the best set on every host of its architecture, and
+ * the EMBER_CPU_FEATURES override below applies to all of them.
+ *
+ * Header-only, so every tool and shared library builds from its own
+ * sources as before; each translation unit detects once and caches.
+ */
+
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__GNUC__) && defined(__aarch64__) && defined(__linux__)
+#include <sys/auxv.h>
+#elif defined(__GNUC__) && defined(__aarch64__) && defined(__APPLE__)
+#include <sys/sysctl.h>
+#endif
+
+// Optional extensions the kernel sets use. Baseline ISA (SSE2 on x86-64)
+// needs no bit; NEON has one although every aarch64 core has it, so the
+// hand-written NEON sets can be switched off like the others.
+enum {
+    CPU_AVX2 = 1u << 0,
+    CPU_FMA = 1u << 1,              // FMA3
+    CPU_F16C = 1u << 2,             // with AVX, so the OS saves YMM state
+    CPU_AVX512F = 1u << 3,
+    CPU_AVX512BW = 1u << 4,
+    CPU_AVX512DQ = 1u << 5,
+    CPU_AVX512FP16 = 1u << 6,
+    CPU_AVX512BF16 = 1u << 7,
+    CPU_NEON = 1u << 8,             // AdvSIMD
+    CPU_FP16 = 1u << 9,             // FEAT_FP16 half-precision arithmetic
+    CPU_BF16 = 1u << 10,            // FEAT_BF16
+    CPU_SVE = 1u << 11,             // detected; no kernel set uses it yet
+};
+
+// Names for EMBER_CPU_FEATURES, as in /proc/cpuinfo where one exists
+static const struct { const char *name; unsigned bit; } cpu_feature_names[] = {
+    { "avx2", CPU_AVX2 }, { "fma", CPU_FMA }, { "f16c", CPU_F16C }, { "avx512f", CPU_AVX512F },
+    { "avx512bw", CPU_AVX512BW }, { "avx512dq", CPU_AVX512DQ }, { "avx512fp16", CPU_AVX512FP16 },
+    { "avx512bf16", CPU_AVX512BF16 }, { "neon", CPU_NEON }, { "fp16", CPU_FP16 }, { "bf16", CPU_BF16 },
+    { "sve", CPU_SVE },
+};
+
+static inline unsigned cpu_features_detect(void) {
+    unsigned f = 0;
+#if defined(__GNUC__) && defined(__x86_64__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) f |= CPU_AVX2;
+    if (__builtin_cpu_supports("fma")) f |= CPU_FMA;
+    if (__builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c")) f |= CPU_F16C;
+    if (__builtin_cpu_supports("avx512f")) f |= CPU_AVX512F;
+    if (__builtin_cpu_supports("avx512bw")) f |= CPU_AVX512BW;
+    if (__builtin_cpu_supports("avx512dq")) f |= CPU_AVX512DQ;
+    if (__builtin_cpu_supports("avx512fp16")) f |= CPU_AVX512FP16;
+    if (__builtin_cpu_supports("avx512bf16")) f |= CPU_AVX512BF16;
+#elif defined(__GNUC__) && defined(__aarch64__)
+    f |= CPU_NEON;
+#if defined(__linux__)
+    unsigned long hw = getauxval(AT_HWCAP), hw2 = getauxval(AT_HWCAP2);
+#ifdef HWCAP_ASIMDHP
+    if (hw & HWCAP_ASIMDHP) f |= CPU_FP16;
+#endif
+#ifdef HWCAP_SVE
+    if (hw & HWCAP_SVE) f |= CPU_SVE;
+#endif
+#ifdef HWCAP2_BF16
+    if (hw2 & HWCAP2_BF16) f |= CPU_BF16;
+#endif
+    (void)hw; (void)hw2;
+#elif defined(__APPLE__)
+    f |= CPU_FP16;                  // every Apple arm64 core has FEAT_FP16
+    int v = 0;
+    size_t len = sizeof(v);
+    if (sysctlbyname("hw.optional.arm.FEAT_BF16", &v, &len, NULL, 0) == 0 && v) f |= CPU_BF16;
+#endif
+#endif
+    return f;
+}
+
+// EMBER_CPU_FEATURES, for testing every kernel set on one host: a list of
+// names separated by commas or spaces. Plain names keep only those
+// features, "-name" drops one, and "none" keeps nothing (the portable
+// sets). Without avx512f no AVX-512 extension is kept, nor fp16, bf16 or
+// sve without neon. Detection still applies: the override never adds a
+// feature the CPU lacks. Unknown names are ignored.
+static inline unsigned cpu_features_override(unsigned detected, const char *spec) {
+    unsigned keep = 0, drop = 0;
+    int any_keep = 0;
+    while (*spec) {
+        size_t len = strcspn(spec, ", ");
+        int minus = *spec == '-';
+        const char *name = spec + minus;
+        size_t nlen = len - (size_t)minus;
+        if (nlen == 4 && strncmp(name, "none", 4) == 0) {
+            any_keep = 1;
+        } else {
+            for (size_t i = 0; i < sizeof(cpu_feature_names) / sizeof(cpu_feature_names[0]); i++) {
+                if (strlen(cpu_feature_names[i].name) == nlen && strncmp(name, cpu_feature_names[i].name, nlen) == 0) {
+                    if (minus) drop |= cpu_feature_names[i].bit;
+                    else { keep |= cpu_feature_names[i].bit; any_keep = 1; }
+                }
+            }
+        }
+        spec += len;
+        spec += strspn(spec, ", ");
+    }
+    unsigned f = (any_keep ? detected & keep : detected) & ~drop;
+    // The extensions go with their base
+    if (!(f & CPU_AVX512F)) f &= ~(CPU_AVX512BW | CPU_AVX512DQ | CPU_AVX512FP16 | CPU_AVX512BF16);
+    if (!(f & CPU_NEON)) f &= ~(CPU_FP16 | CPU_BF16 | CPU_SVE);
+    return f;
+}
+
+// Marks cpu_features()'s cache as filled; no feature uses the bit
+#define CPU_FEATURES_DETECTED 0x80000000u
+
+// The features the kernel sets may use: detected once per translation
+// unit, then EMBER_CPU_FEATURES applied. The result and the filled mark
+// share one atomic word, so a concurrent first call sees either all of it
+// or nothing and detects again (the same answer).
+static inline unsigned cpu_features(void) {
+    static _Atomic unsigned cached;
+    unsigned f = atomic_load_explicit(&cached, memory_order_acquire);
+    if (!(f & CPU_FEATURES_DETECTED)) {
+        f = cpu_features_detect();
+        const char *spec = getenv("EMBER_CPU_FEATURES");
+        if (spec) f = cpu_features_override(f, spec);
+        f |= CPU_FEATURES_DETECTED;
+        atomic_store_explicit(&cached, f, memory_order_release);
+    }
+    return f & ~CPU_FEATURES_DETECTED;
+}
+
+// All of the given CPU_* bits
+static inline int cpu_has(unsigned want) {
+    return (cpu_features() & want) == want;
+}
+
+// GCC only auto-vectorizes at -O2 from version 12, and then only cheap
+// loops: CPU_VECTORIZE turns the vectorizer on for the bulk kernels that
+// rely on it, and CPU_VECTORIZE_WITH adds more optimize options to it
+#if defined(__GNUC__) && !defined(__clang__)
+#define CPU_VECTORIZE __attribute__((optimize("tree-vectorize")))
+#define CPU_VECTORIZE_WITH(...) __attribute__((optimize("tree-vectorize", __VA_ARGS__)))
+#else
+#define CPU_VECTORIZE
+#define CPU_VECTORIZE_WITH(...)
+#endif
+
+// CPU_DISPATCH(type, prefix, select) defines prefix_k(), the kernel set
+// (a const type *) that select() returns. It is bound when the program or
+// library loads; the lazy path covers callers that run before
+// constructors (other constructors). select() returns the same set every
+// time, so a concurrent first call stores the same pointer.
+#define CPU_DISPATCH(type, prefix, select)                                          \
+    static const type *_Atomic prefix##_active;                                     \
+    __attribute__((constructor)) static void prefix##_kernels_init(void) {          \
+        atomic_store_explicit(&prefix##_active, select(), memory_order_release);    \
+    }                                                                               \
+    static inline const type *prefix##_k(void) {                                    \
+        const type *k = atomic_load_explicit(&prefix##_active, memory_order_acquire); \
+        if (!k) {                                                                   \
+            k = select();                                                           \
+            atomic_store_explicit(&prefix##_active, k, memory_order_release);       \
+        }                                                                           \
+        return k;                                                                   \
+    }
+
+#endif // CPU_FEATURES_H
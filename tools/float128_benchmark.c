@@ -12,13 +12,60 @@
  * - Sum of many small numbers (catastrophic cancellation)
  * - Product of near-unity values
  * - Compensated summation (Kahan)
+ *
+ * It also provides the batched SoA kernels declared in float128_benchmark.h
+ * (dd_add_n, dd_mul_n, dd_fma_n, dd_dot, dd_sum), vectorized per ISA from
+ * float128_dd_kernels.inc and chosen at load time by CPU feature, and a
+ * quad-double tier (~212 bits: qd_add_n, qd_mul_n, qd_div_n, qd_sqrt_n,
+ * qd_dot, qd_sum) compared against double-double and __float128.
+ * dd_reduce_sum/dot/norm2 are multithreaded, bit-reproducible reductions
+ * of plain double arrays, and dd_gemm a tiled matrix multiply with the same
+ * accumulators (pthreads: link with -pthread).
+ *
+ * With --bench it runs timed microbenchmarks instead of the tests: ns/op
+ * and GFLOP/s for double, long double, __float128, double-double (scalar
+ * and batch) and quad-double, optionally written as JSON:
+ *   ./float128_benchmark --bench [--warmup N] [--reps N] [--n N] [--cpu N] [--json FILE]
+ * Build with -DDD_USE_QUADMATH=1 -lquadmath for a __float128 sqrt.
+ *
+ * The double-double elementary functions (compute_double_double_sqrt, exp,
+ * log, sin, cos and the dd_*_n batches) are in the same file; the batches
+ * return the same bits as the scalar calls on every ISA.
  */
 
+/* Dekker splitting and the error-free transformations are only exact when
+ * every multiply and add is rounded separately: never contract into FMA,
+ * whatever -ffp-contract the build uses. */
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+#define _POSIX_C_SOURCE 200809L   // clock_gettime, pthreads, sysconf
+#if defined(__linux__)
+#define _GNU_SOURCE               // sched_setaffinity (--cpu)
+#include <sched.h>
+#endif
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
 #include <math.h>
 #include <float.h>
 #include <time.h>
+#include <unistd.h>
+#include "cpu_features.h"
+#include "float128_benchmark.h"
+
+// libquadmath is only needed for the __float128 sqrt timing in --bench
+#ifndef DD_USE_QUADMATH
+#define DD_USE_QUADMATH 0
+#endif
+#if DD_USE_QUADMATH
+#include <quadmath.h>
+#endif
 
 // ============================================================================
 // Double-Double Arithmetic (QD library algorithms)
@@ -55,8 +102,8 @@ static inline dd_real quick_two_sum(double a, double b) {
     return result;
 }
 
-// Error-free transformation: two-product
-static inline dd_real two_prod(double a, double b) {
+// Error-free transformation: two-product (Dekker: split both factors)
+static inline dd_real two_prod_dekker(double a, double b) {
     double p = a * b;
     double a_hi, a_lo, b_hi, b_lo;
     split_double(a, &a_hi, &a_lo);
@@ -66,6 +113,38 @@ static inline dd_real two_prod(double a, double b) {
     return result;
 }
 
+// Error-free transformation: two-product with one fused multiply-subtract.
+// Same bits as Dekker wherever Dekker is exact (float128_bitcompare checks).
+static inline dd_real two_prod_fma(double a, double b) {
+    double p = a * b;
+    dd_real result = {p, fma(a, b, -p)};
+    return result;
+}
+
+// Scalar two_prod is picked at build time: fma() is only a single
+// instruction when the compiler targets FMA (-mfma, -march=haswell or
+// later, any aarch64); otherwise it is a slow libm routine. Override with
+// -DDD_USE_FMA=0/1. The batch kernels choose at run time instead, using
+// their FMA sets when the CPU has FMA unless built with -DDD_BATCH_FMA=0.
+#ifndef DD_BATCH_FMA
+#define DD_BATCH_FMA 1
+#endif
+#ifndef DD_USE_FMA
+#if defined(__FMA__) || defined(__aarch64__)
+#define DD_USE_FMA 1
+#else
+#define DD_USE_FMA 0
+#endif
+#endif
+
+static inline dd_real two_prod(double a, double b) {
+#if DD_USE_FMA
+    return two_prod_fma(a, b);
+#else
+    return two_prod_dekker(a, b);
+#endif
+}
+
 // Double-double addition
 static inline dd_real dd_add(dd_real a, dd_real b) {
     dd_real s = two_sum(a.hi, b.hi);
@@ -124,6 +203,988 @@ static void dd_print(const char* label, dd_real x) {
            label, x.hi, x.lo, x.hi + x.lo);
 }
 
+// Double-double division: the double quotient plus one correction from the
+// remainder (~104 bits)
+static inline dd_real dd_div(dd_real a, dd_real b) {
+    double q1 = a.hi / b.hi;
+    dd_real r = dd_add(a, dd_mul_d(b, -q1));
+    return quick_two_sum(q1, r.hi / b.hi);
+}
+
+// ============================================================================
+// Quad-Double Arithmetic (QD library algorithms)
+// ============================================================================
+
+// Four non-overlapping doubles, largest first; the value is their exact
+// sum (~212 bits). Add is QD's IEEE-style add, which stays accurate under
+// cancellation; mul is QD's sloppy mul (drops the O(eps^4) terms); div is
+// long division by the leading limb; sqrt is Newton on 1/sqrt.
+typedef struct {
+    double x[4];
+} qd_real;
+
+// The error-free transforms above in QD's form: return the rounded part,
+// store the error
+static inline double qd_two_sum(double a, double b, double *err) {
+    dd_real r = two_sum(a, b);
+    *err = r.lo;
+    return r.hi;
+}
+
+static inline double qd_quick_two_sum(double a, double b, double *err) {
+    dd_real r = quick_two_sum(a, b);
+    *err = r.lo;
+    return r.hi;
+}
+
+static inline double qd_two_prod(double a, double b, double *err) {
+    dd_real r = two_prod(a, b);
+    *err = r.lo;
+    return r.hi;
+}
+
+// (a, b, c) <- a + b + c as three non-overlapping terms
+static inline void three_sum(double *a, double *b, double *c) {
+    double t1, t2, t3;
+    t1 = qd_two_sum(*a, *b, &t2);
+    *a = qd_two_sum(*c, t1, &t3);
+    *b = qd_two_sum(t2, t3, c);
+}
+
+// (a, b) <- a + b + c, the last error dropped
+static inline void three_sum2(double *a, double *b, double c) {
+    double t1, t2, t3;
+    t1 = qd_two_sum(*a, *b, &t2);
+    *a = qd_two_sum(c, t1, &t3);
+    *b = t2 + t3;
+}
+
+// Renormalize c[0..n) (n = 4 or 5, roughly decreasing) into four
+// non-overlapping limbs in c[0..4)
+static inline void qd_renorm(double *c, int n) {
+    if (isinf(c[0])) return;
+    double s0 = c[n - 1], s1 = 0.0, s2 = 0.0, s3 = 0.0;
+    for (int i = n - 2; i >= 1; i--) s0 = qd_quick_two_sum(c[i], s0, &c[i + 1]);
+    c[0] = qd_quick_two_sum(c[0], s0, &c[1]);
+
+    // Sweep down, starting a new limb whenever the running one is exact
+    double *acc[4] = { &s0, &s1, &s2, &s3 };
+    int k = 0;
+    s0 = c[0];
+    for (int i = 1; i < n; i++) {
+        if (k == 3) { s3 += c[i]; continue; }
+        double e;
+        *acc[k] = qd_quick_two_sum(*acc[k], c[i], &e);
+        if (e != 0.0) *acc[++k] = e;
+    }
+    c[0] = s0; c[1] = s1; c[2] = s2; c[3] = s3;
+}
+
+static inline qd_real qd_from_double(double x) {
+    qd_real r = {{ x, 0.0, 0.0, 0.0 }};
+    return r;
+}
+
+static inline double qd_to_double(qd_real a) {
+    return a.x[0] + (a.x[1] + (a.x[2] + a.x[3]));
+}
+
+static inline qd_real qd_neg(qd_real a) {
+    qd_real r = {{ -a.x[0], -a.x[1], -a.x[2], -a.x[3] }};
+    return r;
+}
+
+// u + v + c accumulated into (u, v); returns a finished limb, or 0 when
+// the sum still fits in (u, v)
+static inline double quick_three_accum(double *u, double *v, double c) {
+    double s = qd_two_sum(*v, c, v);
+    s = qd_two_sum(*u, s, u);
+    int zu = *u != 0.0, zv = *v != 0.0;
+    if (zu && zv) return s;
+    if (!zv) { *v = *u; *u = s; }
+    else { *u = s; }
+    return 0.0;
+}
+
+// Quad-double addition: merge both limb lists by magnitude, accumulating
+// exactly (QD's ieee_add)
+static qd_real qd_add(qd_real a, qd_real b) {
+    int i = 0, j = 0, k = 0;
+    double u, v, t, x[4] = { 0.0, 0.0, 0.0, 0.0 };
+    if (fabs(a.x[i]) > fabs(b.x[j])) u = a.x[i++]; else u = b.x[j++];
+    if (fabs(a.x[i]) > fabs(b.x[j])) v = a.x[i++]; else v = b.x[j++];
+    u = qd_quick_two_sum(u, v, &v);
+    while (k < 4) {
+        if (i >= 4 && j >= 4) {
+            x[k] = u;
+            if (k < 3) x[++k] = v;
+            break;
+        }
+        if (i >= 4) t = b.x[j++];
+        else if (j >= 4) t = a.x[i++];
+        else if (fabs(a.x[i]) > fabs(b.x[j])) t = a.x[i++];
+        else t = b.x[j++];
+        double s = quick_three_accum(&u, &v, t);
+        if (s != 0.0) x[k++] = s;
+    }
+    for (; i < 4; i++) x[3] += a.x[i];
+    for (; j < 4; j++) x[3] += b.x[j];
+    qd_renorm(x, 4);
+    qd_real r = {{ x[0], x[1], x[2], x[3] }};
+    return r;
+}
+
+static inline qd_real qd_sub(qd_real a, qd_real b) {
+    return qd_add(a, qd_neg(b));
+}
+
+// Quad-double times double
+static qd_real qd_mul_d(qd_real a, double b) {
+    double q0, q1, q2, c[5];
+    c[0] = qd_two_prod(a.x[0], b, &q0);
+    double p1 = qd_two_prod(a.x[1], b, &q1);
+    double p2 = qd_two_prod(a.x[2], b, &q2);
+    double p3 = a.x[3] * b;
+    c[1] = qd_two_sum(q0, p1, &c[2]);
+    three_sum(&c[2], &q1, &p2);
+    three_sum2(&q1, &q2, p3);
+    c[3] = q1;
+    c[4] = q2 + p2;
+    qd_renorm(c, 5);
+    qd_real r = {{ c[0], c[1], c[2], c[3] }};
+    return r;
+}
+
+// Quad-double multiplication: exact products of the O(1), O(eps) and
+// O(eps^2) limb pairs, O(eps^3) in plain doubles
+static qd_real qd_mul(qd_real a, qd_real b) {
+    double p0, p1, p2, p3, p4, p5, q0, q1, q2, q3, q4, q5, t0, t1, s0, s1, s2;
+    p0 = qd_two_prod(a.x[0], b.x[0], &q0);
+    p1 = qd_two_prod(a.x[0], b.x[1], &q1);
+    p2 = qd_two_prod(a.x[1], b.x[0], &q2);
+    p3 = qd_two_prod(a.x[0], b.x[2], &q3);
+    p4 = qd_two_prod(a.x[1], b.x[1], &q4);
+    p5 = qd_two_prod(a.x[2], b.x[0], &q5);
+
+    three_sum(&p1, &p2, &q0);
+    // (s0, s1, s2) = (p2, q1, q2) + (p3, p4, p5)
+    three_sum(&p2, &q1, &q2);
+    three_sum(&p3, &p4, &p5);
+    s0 = qd_two_sum(p2, p3, &t0);
+    s1 = qd_two_sum(q1, p4, &t1);
+    s2 = q2 + p5;
+    s1 = qd_two_sum(s1, t0, &t0);
+    s2 += t0 + t1;
+
+    s1 += a.x[0] * b.x[3] + a.x[1] * b.x[2] + a.x[2] * b.x[1] + a.x[3] * b.x[0] + q0 + q3 + q4 + q5;
+    double c[5] = { p0, p1, s0, s1, s2 };
+    qd_renorm(c, 5);
+    qd_real r = {{ c[0], c[1], c[2], c[3] }};
+    return r;
+}
+
+// Quad-double division: five quotient digits by the leading limb of b
+static qd_real qd_div(qd_real a, qd_real b) {
+    double q[5];
+    qd_real r = a;
+    for (int i = 0; i < 4; i++) {
+        q[i] = r.x[0] / b.x[0];
+        r = qd_sub(r, qd_mul_d(b, q[i]));
+    }
+    q[4] = r.x[0] / b.x[0];
+    qd_renorm(q, 5);
+    qd_real res = {{ q[0], q[1], q[2], q[3] }};
+    return res;
+}
+
+// Quad-double square root: three Newton steps x += (1/2 - (a/2) x^2) x on
+// 1/sqrt(a) from the double estimate, then sqrt(a) = a * x
+static qd_real qd_sqrt(qd_real a) {
+    if (a.x[0] == 0.0) return a;
+    if (a.x[0] < 0.0) return qd_from_double(NAN);
+    qd_real x = qd_from_double(1.0 / sqrt(a.x[0]));
+    qd_real h = {{ a.x[0] * 0.5, a.x[1] * 0.5, a.x[2] * 0.5, a.x[3] * 0.5 }};
+    for (int i = 0; i < 3; i++)
+        x = qd_add(x, qd_mul(qd_sub(qd_from_double(0.5), qd_mul(h, qd_mul(x, x))), x));
+    return qd_mul(a, x);
+}
+
+static void qd_print(const char* label, qd_real x) {
+    printf("%s: %.17e %+.17e %+.17e %+.17e\n", label, x.x[0], x.x[1], x.x[2], x.x[3]);
+}
+
+// ============================================================================
+// Double-double elementary functions
+// ============================================================================
+
+// Each function has a core path over most of its domain, written as the
+// straight-line sequence that float128_dd_kernels.inc runs per lane (the
+// batch kernels call the scalar function only for inputs outside the core,
+// so batch and scalar results match bit for bit), and a scalar path for the
+// rest. Constants are correctly rounded double-double values.
+//   sqrt  Newton correction on the double root
+//   exp   x = m ln2 + r, |r| <= ln2/2 (Cody-Waite, three 42-bit pieces of
+//         ln2); Taylor series for expm1(r / 512),
+//         squared back 9 times, scaled by 2^m
+//   log   one Newton step y = x + a exp(-x) - 1 from x = log(a.hi) + a.lo/a.hi
+//   sin/cos  x = j pi/2 + r (Cody-Waite with five 30-bit pieces of pi/2 for
+//         |x| <= 2^20, quad-double pi/2 beyond: accurate to |x| ~ 2^100),
+//         then Taylor series for both on |r| <= pi/4
+// Series terms too small for their rounding to reach 2^-106 are summed in
+// plain double.
+
+static const dd_real DD_LN2 = { 0x1.62e42fefa39efp-1, 0x1.abc9e3b39803fp-56 };
+#define DD_INV_LN2 0x1.71547652b82fep+0
+#define DD_TWO_OVER_PI 0x1.45f306dc9c883p-1
+#define DD_EXP_CORE 708.0       // |x| bound: the result and 2^m are normal
+#define DD_LOG_CORE 1000        // a.hi in [2^-1000, 2^1000]
+#define DD_SQRT_CORE 0x1p-900   // a.hi in [this, 2^1000]: two_prod(s, s) is exact
+#define DD_TRIG_CORE 0x1p20     // |x|: j * each pi/2 piece is exact
+
+// ln2 in 42-bit pieces (m * piece is exact for |m| < 2^11)
+static const double dd_ln2_cw[3] = { 0x1.62e42fefa38p-1, 0x1.ef35793c76p-45, 0x1.cc01f97b578p-87 };
+
+// pi/2 in 30-bit pieces, and as quad-double
+static const double dd_pio2_cw[5] = {
+    0x1.921fb54p+0, 0x1.10b46118p-30, 0x1.313198ap-61, 0x1.701b8398p-92, 0x1.129024ep-123 };
+static const qd_real qd_pio2 = {{ 0x1.921fb54442d18p+0, 0x1.1a62633145c07p-54, -0x1.f1976b7ed8fbcp-110,
+                                  0x1.4cf98e804177dp-164 }};
+
+// exp: 1/k! for k = 2..5 as double-double, k = 6..10 (index k - 6) as double
+static const dd_real dd_exp_c[4] = {
+    { 0x1p-1, 0.0 }, { 0x1.5555555555555p-3, 0x1.5555555555555p-57 },
+    { 0x1.5555555555555p-5, 0x1.5555555555555p-59 }, { 0x1.1111111111111p-7, 0x1.1111111111111p-63 } };
+static const double dd_exp_t[5] = {
+    0x1.6c16c16c16c17p-10, 0x1.a01a01a01a01ap-13, 0x1.a01a01a01a01ap-16, 0x1.71de3a556c734p-19,
+    0x1.27e4fb7789f5cp-22 };
+
+// sin: (-1)^k / (2k+1)! for 2k+1 = 3..15 as double-double, 17..29 as double
+static const dd_real dd_sin_c[7] = {
+    { -0x1.5555555555555p-3, -0x1.5555555555555p-57 }, { 0x1.1111111111111p-7, 0x1.1111111111111p-63 },
+    { -0x1.a01a01a01a01ap-13, -0x1.a01a01a01a01ap-73 }, { 0x1.71de3a556c734p-19, -0x1.c154f8ddc6c00p-73 },
+    { -0x1.ae64567f544e4p-26, 0x1.c062e06d1f209p-80 }, { 0x1.6124613a86d09p-33, 0x1.f28e0cc748ebep-87 },
+    { -0x1.ae7f3e733b81fp-41, -0x1.1d8656b0ee8cbp-97 } };
+static const double dd_sin_t[7] = {
+    0x1.952c77030ad4ap-49, -0x1.2f49b46814157p-57, 0x1.71b8ef6dcf572p-66, -0x1.761b41316381ap-75,
+    0x1.3f3ccdd165fa9p-84, -0x1.d1ab1c2dccea3p-94, 0x1.259f98b4358adp-103 };
+
+// cos: (-1)^k / (2k)! for 2k = 2..16 as double-double, 18..28 as double
+static const dd_real dd_cos_c[8] = {
+    { -0x1p-1, 0.0 }, { 0x1.5555555555555p-5, 0x1.5555555555555p-59 },
+    { -0x1.6c16c16c16c17p-10, 0x1.f49f49f49f49fp-65 }, { 0x1.a01a01a01a01ap-16, 0x1.a01a01a01a01ap-76 },
+    { -0x1.27e4fb7789f5cp-22, -0x1.cbbc05b4fa99ap-76 }, { 0x1.1eed8eff8d898p-29, -0x1.2aec959e14c06p-83 },
+    { -0x1.93974a8c07c9dp-37, -0x1.05d6f8a2efd1fp-92 }, { 0x1.ae7f3e733b81fp-45, 0x1.1d8656b0ee8cbp-101 } };
+static const double dd_cos_t[6] = {
+    -0x1.6827863b97d97p-53, 0x1.e542ba4020225p-62, -0x1.0ce396db7f853p-70, 0x1.f2cf01972f578p-80,
+    -0x1.88e85fc6a4e5ap-89, 0x1.0a18a2635085dp-98 };
+
+// Round to the nearest integer for |x| < 2^51 (default rounding mode)
+static inline double dd_round(double x) { return (x + 0x1.8p52) - 0x1.8p52; }
+
+static inline double dd_pow2(int m) {     // 2^m for normal results
+    uint64_t u = (uint64_t)(m + 1023) << 52;
+    double d;
+    memcpy(&d, &u, 8);
+    return d;
+}
+
+static inline int dd_sqrt_core(double hi) { return hi >= DD_SQRT_CORE && hi <= 0x1p1000; }
+static inline int dd_exp_core(double hi) { return fabs(hi) <= DD_EXP_CORE; }
+static inline int dd_log_core(double hi) { return hi >= 0x1p-1000 && hi <= 0x1p1000; }
+static inline int dd_trig_core(double hi) { return fabs(hi) <= DD_TRIG_CORE; }
+
+static inline dd_real dd_sqrt_kernel(dd_real a) {
+    double s = sqrt(a.hi);
+    dd_real p = two_prod(s, s);
+    return quick_two_sum(s, (((a.hi - p.hi) - p.lo) + a.lo) / (2.0 * s));
+}
+
+// Double-double square root: the double root plus one Newton correction
+static dd_real dd_sqrt(dd_real a) {
+    if (dd_sqrt_core(a.hi)) return dd_sqrt_kernel(a);
+    if (!(a.hi > 0) || isinf(a.hi)) return dd_from_double(sqrt(a.hi));
+    int k = ilogb(a.hi) & ~1;                   // scale by an even power
+    dd_real b = { ldexp(a.hi, -k), ldexp(a.lo, -k) };
+    dd_real r = dd_sqrt_kernel(b);
+    return (dd_real){ ldexp(r.hi, k / 2), ldexp(r.lo, k / 2) };
+}
+
+// exp(a) = 2^m * (1 + s); returns s and sets *m
+static inline dd_real dd_exp_kernel(dd_real a, double *m) {
+    *m = dd_round(a.hi * DD_INV_LN2);
+    dd_real r = a;
+    for (int k = 0; k < 3; k++) r = dd_add_d(r, -*m * dd_ln2_cw[k]);
+    r.hi *= 0x1p-9;
+    r.lo *= 0x1p-9;
+    double t = dd_exp_t[4];
+    for (int k = 3; k >= 0; k--) t = t * r.hi + dd_exp_t[k];
+    dd_real p = { t, 0.0 };
+    for (int k = 3; k >= 0; k--) p = dd_add(dd_mul(p, r), dd_exp_c[k]);
+    dd_real s = dd_mul(dd_add_d(dd_mul(p, r), 1.0), r);        // expm1(r)
+    for (int k = 0; k < 9; k++) {                              // (1 + s)^2 - 1
+        dd_real s2 = { 2.0 * s.hi, 2.0 * s.lo };
+        s = dd_add(s2, dd_mul(s, s));
+    }
+    return s;
+}
+
+static dd_real dd_exp(dd_real a) {
+    double m;
+    if (dd_exp_core(a.hi)) {
+        dd_real s = dd_add_d(dd_exp_kernel(a, &m), 1.0);
+        double p = dd_pow2((int)m);
+        return (dd_real){ s.hi * p, s.lo * p };
+    }
+    if (isnan(a.hi)) return a;
+    if (a.hi > 709.79) return dd_from_double(INFINITY);
+    if (a.hi < -745.2) return dd_from_double(0.0);
+    dd_real s = dd_add_d(dd_exp_kernel(a, &m), 1.0);
+    return (dd_real){ ldexp(s.hi, (int)m), ldexp(s.lo, (int)m) };
+}
+
+// With exp(-x) = 2^m (1 + s) and b = a 2^m (near 1), the Newton term
+// a exp(-x) - 1 is (b - 1) + b s: both parts are exact or relative-error
+// products, so the result stays accurate relative to log(a) near a = 1
+static inline dd_real dd_log_kernel(dd_real a) {
+    double x = log(a.hi) + a.lo / a.hi, m;      // a.lo matters when a.hi is 1
+    dd_real s = dd_exp_kernel(dd_from_double(-x), &m);
+    double p = dd_pow2((int)m);
+    dd_real b = { a.hi * p, a.lo * p };
+    return dd_add_d(dd_add(dd_add_d(b, -1.0), dd_mul(b, s)), x);
+}
+
+static dd_real dd_log(dd_real a) {
+    if (dd_log_core(a.hi)) return dd_log_kernel(a);
+    if (isnan(a.hi) || a.hi < 0) return dd_from_double(NAN);
+    if (a.hi == 0) return dd_from_double(-INFINITY);
+    if (isinf(a.hi)) return a;
+    int k = ilogb(a.hi);
+    dd_real b = { ldexp(a.hi, -k), ldexp(a.lo, -k) };
+    return dd_add(dd_log_kernel(b), dd_mul_d(DD_LN2, (double)k));
+}
+
+// sin(r) and cos(r) for |r| <= pi/4 (a little beyond is harmless)
+static inline dd_real dd_sin_kernel(dd_real r, dd_real r2) {
+    double t = dd_sin_t[6];
+    for (int k = 5; k >= 0; k--) t = t * r2.hi + dd_sin_t[k];
+    dd_real p = { t, 0.0 };
+    for (int k = 6; k >= 0; k--) p = dd_add(dd_mul(p, r2), dd_sin_c[k]);
+    return dd_add(r, dd_mul(dd_mul(r, r2), p));
+}
+
+static inline dd_real dd_cos_kernel(dd_real r2) {
+    double t = dd_cos_t[5];
+    for (int k = 4; k >= 0; k--) t = t * r2.hi + dd_cos_t[k];
+    dd_real p = { t, 0.0 };
+    for (int k = 7; k >= 0; k--) p = dd_add(dd_mul(p, r2), dd_cos_c[k]);
+    return dd_add_d(dd_mul(r2, p), 1.0);
+}
+
+// a = j pi/2 + r; returns r and sets *q = j mod 4
+static dd_real dd_trig_reduce(dd_real a, int *q) {
+    if (dd_trig_core(a.hi)) {
+        double j = dd_round(a.hi * DD_TWO_OVER_PI);
+        dd_real r = a;
+        for (int k = 0; k < 5; k++) r = dd_add_d(r, -j * dd_pio2_cw[k]);
+        *q = (int)j & 3;
+        return r;
+    }
+    // two passes in quad-double: the first j may be off by |a| 2^-53
+    qd_real r = {{ a.hi, a.lo, 0.0, 0.0 }};
+    double qs = 0.0;
+    for (int pass = 0; pass < 2; pass++) {
+        double j = nearbyint(r.x[0] * DD_TWO_OVER_PI);
+        r = qd_sub(r, qd_mul_d(qd_pio2, j));
+        qs += fmod(j, 4.0);
+    }
+    *q = (int)fmod(qs + 8.0, 4.0);
+    return quick_two_sum(r.x[0], r.x[1] + r.x[2]);
+}
+
+static dd_real dd_sin(dd_real a) {
+    if (!isfinite(a.hi)) return dd_from_double(NAN);
+    int q;
+    dd_real r = dd_trig_reduce(a, &q), r2 = dd_mul(r, r);
+    dd_real v = q & 1 ? dd_cos_kernel(r2) : dd_sin_kernel(r, r2);
+    return q & 2 ? (dd_real){ -v.hi, -v.lo } : v;
+}
+
+static dd_real dd_cos(dd_real a) {
+    if (!isfinite(a.hi)) return dd_from_double(NAN);
+    int q;
+    dd_real r = dd_trig_reduce(a, &q), r2 = dd_mul(r, r);
+    dd_real v = q & 1 ? dd_sin_kernel(r, r2) : dd_cos_kernel(r2);
+    return (q + 1) & 2 ? (dd_real){ -v.hi, -v.lo } : v;
+}
+
+// ============================================================================
+// Batched SoA kernels (float128_benchmark.h)
+// ============================================================================
+
+#define DD_CAT_(a, b) a##b
+#define DD_CAT(a, b) DD_CAT_(a, b)
+#define DD_LANES 8      // reduction accumulators, independent of vector width
+
+// Fixed combine tree for the DD_LANES reduction lanes: (l[k] + l[k+4]),
+// then (+ k+2), then (+ k+1). Every ISA reduces in exactly this order.
+static dd_real dd_lanes_combine(dd_real l[DD_LANES]) {
+    for (int w = DD_LANES / 2; w >= 1; w /= 2)
+        for (int k = 0; k < w; k++) l[k] = dd_add(l[k], l[k + w]);
+    return l[0];
+}
+
+// GEMM blocking (dd_gemm): an output tile is DD_GEMM_MC x DD_GEMM_NC, its k
+// range is packed in panels of DD_GEMM_KC, and the register blocks are
+// DD_GEMM_MR rows by one vector of columns. A double-double add is a chain
+// of about nine dependent flops, so 8 independent rows keep the FP units
+// busy; that is faster than 4 even where AVX2's 16 registers spill.
+#define DD_GEMM_MC 64
+#define DD_GEMM_NC 128
+#define DD_GEMM_KC 256
+#define DD_GEMM_MR 8
+#define DD_GEMM_WORK (2 * DD_GEMM_MC * DD_GEMM_NC + 2 * DD_GEMM_MC * DD_GEMM_KC + 2 * DD_GEMM_KC * DD_GEMM_NC)
+
+// The public accumulators plus plain double, the baseline Test 9 times
+// them against
+typedef enum {
+    DD_GEMM_COMPENSATED = DD_ACC_COMPENSATED,
+    DD_GEMM_DOUBLE_DOUBLE = DD_ACC_DOUBLE_DOUBLE,
+    DD_GEMM_DOUBLE
+} dd_gemm_mode;
+
+typedef struct {
+    dd_gemm_mode mode;
+    size_t m, n, k;
+    const double *a, *a_lo, *b, *b_lo;      // lo NULL: plain doubles
+    size_t lda, ldb, ldc;
+    double *c, *c_lo;                       // c_lo may be NULL
+} dd_gemm_args;
+
+#define DD_V double
+#define DD_W 1
+#define DD_SFX scalar
+#define DD_ATTR
+#include "float128_dd_kernels.inc"
+#undef DD_SQRT
+#undef DD_V
+#undef DD_W
+#undef DD_SFX
+#undef DD_ATTR
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__GNUC__) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__aarch64__))
+#define DD_HAVE_V2 1
+typedef double dd_v2d __attribute__((vector_size(16)));
+#define DD_V dd_v2d
+#define DD_W 2
+#define DD_SFX v2       // SSE2 on x86-64, NEON on aarch64: both baseline
+#define DD_ATTR
+#if defined(__x86_64__)
+#define DD_SQRT(v) ((dd_v2d)_mm_sqrt_pd((__m128d)(v)))
+#else
+#define DD_SQRT(v) ((dd_v2d)vsqrtq_f64((float64x2_t)(v)))
+#endif
+#include "float128_dd_kernels.inc"
+#undef DD_SQRT
+#undef DD_V
+#undef DD_W
+#undef DD_SFX
+#undef DD_ATTR
+#endif
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define DD_HAVE_X86 1
+typedef double dd_v4d __attribute__((vector_size(32)));
+typedef double dd_v8d __attribute__((vector_size(64)));
+// "avx2"/"avx512f" without "fma": the compiler has no fused op to contract to.
+#define DD_V dd_v4d
+#define DD_W 4
+#define DD_SFX avx2
+#define DD_ATTR __attribute__((target("avx2")))
+#define DD_SQRT(v) ((dd_v4d)_mm256_sqrt_pd((__m256d)(v)))
+#include "float128_dd_kernels.inc"
+#undef DD_SQRT
+#undef DD_V
+#undef DD_W
+#undef DD_SFX
+#undef DD_ATTR
+#define DD_V dd_v8d
+#define DD_W 8
+#define DD_SFX avx512
+#define DD_ATTR __attribute__((target("avx512f")))
+#define DD_SQRT(v) ((dd_v8d)_mm512_sqrt_pd((__m512d)(v)))
+#include "float128_dd_kernels.inc"
+#undef DD_SQRT
+#undef DD_V
+#undef DD_W
+#undef DD_SFX
+#undef DD_ATTR
+#endif
+
+// FMA two_prod variants: the error term is one fused op instead of 17 flops.
+#if DD_BATCH_FMA
+#if defined(__GNUC__) && defined(__x86_64__)
+#define DD_HAVE_X86_FMA 1
+#define DD_V dd_v4d
+#define DD_W 4
+#define DD_SFX avx2_fma
+#define DD_ATTR __attribute__((target("avx2,fma")))
+#define DD_FMSUB(a, b, p) ((dd_v4d)_mm256_fmsub_pd((__m256d)(a), (__m256d)(b), (__m256d)(p)))
+#define DD_SQRT(v) ((dd_v4d)_mm256_sqrt_pd((__m256d)(v)))
+#include "float128_dd_kernels.inc"
+#undef DD_SQRT
+#undef DD_V
+#undef DD_W
+#undef DD_SFX
+#undef DD_ATTR
+#undef DD_FMSUB
+#define DD_V dd_v8d
+#define DD_W 8
+#define DD_SFX avx512_fma
+#define DD_ATTR __attribute__((target("avx512f")))
+#define DD_FMSUB(a, b, p) ((dd_v8d)_mm512_fmsub_pd((__m512d)(a), (__m512d)(b), (__m512d)(p)))
+#define DD_SQRT(v) ((dd_v8d)_mm512_sqrt_pd((__m512d)(v)))
+#include "float128_dd_kernels.inc"
+#undef DD_SQRT
+#undef DD_V
+#undef DD_W
+#undef DD_SFX
+#undef DD_ATTR
+#undef DD_FMSUB
+#elif defined(__GNUC__) && defined(__aarch64__)
+#define DD_HAVE_NEON_FMA 1
+#define DD_V dd_v2d
+#define DD_W 2
+#define DD_SFX neon_fma
+#define DD_ATTR
+#define DD_FMSUB(a, b, p) ((dd_v2d)vfmaq_f64(vnegq_f64((float64x2_t)(p)), (float64x2_t)(a), (float64x2_t)(b)))
+#define DD_SQRT(v) ((dd_v2d)vsqrtq_f64((float64x2_t)(v)))
+#include "float128_dd_kernels.inc"
+#undef DD_SQRT
+#undef DD_V
+#undef DD_W
+#undef DD_SFX
+#undef DD_ATTR
+#undef DD_FMSUB
+#endif
+#endif
+
+typedef struct {
+    const char *isa;
+    void (*add_n)(size_t, const double*, const double*, const double*, const double*, double*, double*);
+    void (*mul_n)(size_t, const double*, const double*, const double*, const double*, double*, double*);
+    void (*fma_n)(size_t, const double*, const double*, const double*, const double*,
+                  const double*, const double*, double*, double*);
+    dd_real (*dot)(size_t, const double*, const double*, const double*, const double*);
+    dd_real (*sum)(size_t, const double*, const double*);
+    dd_real (*csum)(size_t, const double*);
+    dd_real (*cdot)(size_t, const double*, const double*);
+    void (*sqrt_n)(size_t, const double*, const double*, double*, double*);
+    void (*exp_n)(size_t, const double*, const double*, double*, double*);
+    void (*log_n)(size_t, const double*, const double*, double*, double*);
+    void (*sin_n)(size_t, const double*, const double*, double*, double*);
+    void (*cos_n)(size_t, const double*, const double*, double*, double*);
+    void (*gemm_tile)(const dd_gemm_args*, size_t, size_t, size_t, size_t, double*);
+} dd_kernels;
+
+#define DD_KERNEL_SET(name, sfx) \
+    { name, dd_add_n_##sfx, dd_mul_n_##sfx, dd_fma_n_##sfx, dd_dot_##sfx, dd_sum_##sfx, \
+      dd_csum_##sfx, dd_cdot_##sfx, dd_sqrt_n_##sfx, dd_exp_n_##sfx, dd_log_n_##sfx, \
+      dd_sin_n_##sfx, dd_cos_n_##sfx, dd_gemm_tile_##sfx }
+
+static const dd_kernels dd_kernels_scalar = DD_KERNEL_SET("scalar", scalar);
+#if DD_HAVE_V2
+#if defined(__aarch64__)
+static const dd_kernels dd_kernels_v2 = DD_KERNEL_SET("neon", v2);
+#else
+static const dd_kernels dd_kernels_v2 = DD_KERNEL_SET("sse2", v2);
+#endif
+#endif
+#if DD_HAVE_X86
+static const dd_kernels dd_kernels_avx2 = DD_KERNEL_SET("avx2", avx2);
+static const dd_kernels dd_kernels_avx512 = DD_KERNEL_SET("avx512", avx512);
+#endif
+#if DD_HAVE_X86_FMA
+static const dd_kernels dd_kernels_avx2_fma = DD_KERNEL_SET("avx2+fma", avx2_fma);
+static const dd_kernels dd_kernels_avx512_fma = DD_KERNEL_SET("avx512+fma", avx512_fma);
+#endif
+#if DD_HAVE_NEON_FMA
+static const dd_kernels dd_kernels_neon_fma = DD_KERNEL_SET("neon+fma", neon_fma);
+#endif
+
+static const dd_kernels *dd_select(void) {
+    const dd_kernels *k = &dd_kernels_scalar;
+#if DD_HAVE_V2 && defined(__aarch64__)
+    if (cpu_has(CPU_NEON)) k = &dd_kernels_v2;
+#elif DD_HAVE_V2
+    k = &dd_kernels_v2;             // SSE2 is baseline on x86-64
+#endif
+#if DD_HAVE_X86
+    if (cpu_has(CPU_AVX512F)) k = &dd_kernels_avx512;
+    else if (cpu_has(CPU_AVX2)) k = &dd_kernels_avx2;
+#endif
+#if DD_HAVE_X86_FMA
+    // Every AVX-512F CPU has FMA3 too; asking for both lets
+    // EMBER_CPU_FEATURES=-fma pick the non-FMA sets
+    if (cpu_has(CPU_AVX512F | CPU_FMA)) k = &dd_kernels_avx512_fma;
+    else if (cpu_has(CPU_AVX2 | CPU_FMA)) k = &dd_kernels_avx2_fma;
+#endif
+#if DD_HAVE_NEON_FMA
+    if (cpu_has(CPU_NEON)) k = &dd_kernels_neon_fma;    // FMA is mandatory on aarch64
+#endif
+    return k;
+}
+
+CPU_DISPATCH(dd_kernels, dd, dd_select)
+
+const char *dd_kernel_isa(void) {
+    return dd_k()->isa;
+}
+
+void dd_add_n(size_t n, const double *a_hi, const double *a_lo, const double *b_hi, const double *b_lo,
+              double *out_hi, double *out_lo) {
+    dd_k()->add_n(n, a_hi, a_lo, b_hi, b_lo, out_hi, out_lo);
+}
+
+void dd_mul_n(size_t n, const double *a_hi, const double *a_lo, const double *b_hi, const double *b_lo,
+              double *out_hi, double *out_lo) {
+    dd_k()->mul_n(n, a_hi, a_lo, b_hi, b_lo, out_hi, out_lo);
+}
+
+void dd_fma_n(size_t n, const double *a_hi, const double *a_lo, const double *b_hi, const double *b_lo,
+              const double *c_hi, const double *c_lo, double *out_hi, double *out_lo) {
+    dd_k()->fma_n(n, a_hi, a_lo, b_hi, b_lo, c_hi, c_lo, out_hi, out_lo);
+}
+
+void dd_dot(size_t n, const double *a_hi, const double *a_lo, const double *b_hi, const double *b_lo,
+            double *result_hi, double *result_lo) {
+    dd_real r = dd_k()->dot(n, a_hi, a_lo, b_hi, b_lo);
+    *result_hi = r.hi;
+    *result_lo = r.lo;
+}
+
+void dd_sum(size_t n, const double *hi, const double *lo, double *result_hi, double *result_lo) {
+    dd_real r = dd_k()->sum(n, hi, lo);
+    *result_hi = r.hi;
+    *result_lo = r.lo;
+}
+
+void dd_sqrt_n(size_t n, const double *a_hi, const double *a_lo, double *out_hi, double *out_lo) {
+    dd_k()->sqrt_n(n, a_hi, a_lo, out_hi, out_lo);
+}
+
+void dd_exp_n(size_t n, const double *a_hi, const double *a_lo, double *out_hi, double *out_lo) {
+    dd_k()->exp_n(n, a_hi, a_lo, out_hi, out_lo);
+}
+
+void dd_log_n(size_t n, const double *a_hi, const double *a_lo, double *out_hi, double *out_lo) {
+    dd_k()->log_n(n, a_hi, a_lo, out_hi, out_lo);
+}
+
+void dd_sin_n(size_t n, const double *a_hi, const double *a_lo, double *out_hi, double *out_lo) {
+    dd_k()->sin_n(n, a_hi, a_lo, out_hi, out_lo);
+}
+
+void dd_cos_n(size_t n, const double *a_hi, const double *a_lo, double *out_hi, double *out_lo) {
+    dd_k()->cos_n(n, a_hi, a_lo, out_hi, out_lo);
+}
+
+// ============================================================================
+// Reproducible parallel reductions (float128_benchmark.h)
+// ============================================================================
+
+// The input is cut into fixed blocks, each reduced by the lane kernels, and
+// the block partials are combined pairwise by block index. Threads only
+// decide who computes which block, so the bits do not depend on how many
+// there are.
+#define DD_REDUCE_BLOCK 65536
+
+typedef struct {
+    const dd_kernels *k;
+    dd_accumulator acc;
+    const double *a, *b;        // b NULL: sum of a
+    double scale;               // norm2 rescaling (a power of two), else 1
+    size_t n, first, last;      // blocks [first, last)
+    dd_real *part;
+    int threaded, failed;
+} dd_reduce_job;
+
+static void *dd_reduce_worker(void *arg) {
+    dd_reduce_job *j = (dd_reduce_job*)arg;
+    double *tmp = NULL;
+    if (j->scale != 1.0 && !(tmp = (double*)malloc(DD_REDUCE_BLOCK * sizeof(double)))) {
+        j->failed = 1;
+        return NULL;
+    }
+    for (size_t blk = j->first; blk < j->last; blk++) {
+        size_t off = blk * DD_REDUCE_BLOCK, m = j->n - off < DD_REDUCE_BLOCK ? j->n - off : DD_REDUCE_BLOCK;
+        const double *a = j->a + off, *b = j->b ? j->b + off : NULL;
+        if (tmp) {              // only norm2 scales, and there b == a
+            for (size_t i = 0; i < m; i++) tmp[i] = a[i] * j->scale;
+            a = tmp;
+            b = b ? tmp : NULL;
+        }
+        if (j->acc == DD_ACC_DOUBLE_DOUBLE)
+            j->part[blk] = b ? j->k->dot(m, a, NULL, b, NULL) : j->k->sum(m, a, NULL);
+        else
+            j->part[blk] = b ? j->k->cdot(m, a, b) : j->k->csum(m, a);
+    }
+    free(tmp);
+    return NULL;
+}
+
+static dd_real dd_reduce(const dd_kernels *k, dd_accumulator acc, size_t n, const double *a, const double *b,
+                         double scale, int threads) {
+    const dd_real fail = { NAN, NAN };
+    size_t nb = (n + DD_REDUCE_BLOCK - 1) / DD_REDUCE_BLOCK;
+    if (nb == 0) return dd_from_double(0.0);
+    if (threads <= 0) {
+        long c = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = c > 0 ? (int)c : 1;
+    }
+    if ((size_t)threads > nb) threads = (int)nb;
+    dd_real *part = (dd_real*)malloc(nb * sizeof(dd_real));
+    dd_reduce_job *jobs = (dd_reduce_job*)calloc((size_t)threads, sizeof(dd_reduce_job));
+    pthread_t *tid = (pthread_t*)calloc((size_t)threads, sizeof(pthread_t));
+    if (!part || !jobs || !tid) { free(part); free(jobs); free(tid); return fail; }
+
+    for (int t = 0; t < threads; t++) {
+        dd_reduce_job *j = &jobs[t];
+        j->k = k; j->acc = acc; j->a = a; j->b = b; j->scale = scale; j->n = n; j->part = part;
+        j->first = nb * (size_t)t / (size_t)threads;
+        j->last = nb * (size_t)(t + 1) / (size_t)threads;
+        // the calling thread takes the last share; if a thread cannot start,
+        // its share runs here too
+        j->threaded = t + 1 < threads && pthread_create(&tid[t], NULL, dd_reduce_worker, j) == 0;
+        if (!j->threaded) dd_reduce_worker(j);
+    }
+    int failed = 0;
+    for (int t = 0; t < threads; t++) {
+        if (jobs[t].threaded) pthread_join(tid[t], NULL);
+        failed |= jobs[t].failed;
+    }
+
+    for (size_t w = 1; w < nb; w *= 2)
+        for (size_t i = 0; i + w < nb; i += 2 * w) part[i] = dd_add(part[i], part[i + w]);
+    dd_real r = failed ? fail : part[0];
+    free(part); free(jobs); free(tid);
+    return r;
+}
+
+// Sum of squares, recomputed on x scaled by a power of two when it overflows
+// or is small enough that the squares may have lost bits to underflow
+static dd_real dd_reduce_norm2_k(const dd_kernels *k, dd_accumulator acc, size_t n, const double *x, int threads) {
+    dd_real ss = dd_reduce(k, acc, n, x, x, 1.0, threads);
+    if (isfinite(ss.hi) && ss.hi >= 0x1p-900) return dd_sqrt(ss);
+    double m = 0.0;
+    for (size_t i = 0; i < n; i++) m = fmax(m, fabs(x[i]));
+    if (!isfinite(m) || m == 0.0) return dd_sqrt(ss);
+    int e = ilogb(m);
+    dd_real r = dd_sqrt(dd_reduce(k, acc, n, x, x, ldexp(1.0, -e), threads));
+    r.hi = ldexp(r.hi, e);
+    r.lo = ldexp(r.lo, e);
+    return r;
+}
+
+void dd_reduce_sum(size_t n, const double *x, dd_accumulator acc, int threads,
+                   double *result_hi, double *result_lo) {
+    dd_real r = dd_reduce(dd_k(), acc, n, x, NULL, 1.0, threads);
+    *result_hi = r.hi;
+    *result_lo = r.lo;
+}
+
+void dd_reduce_dot(size_t n, const double *a, const double *b, dd_accumulator acc, int threads,
+                   double *result_hi, double *result_lo) {
+    dd_real r = dd_reduce(dd_k(), acc, n, a, b, 1.0, threads);
+    *result_hi = r.hi;
+    *result_lo = r.lo;
+}
+
+void dd_reduce_norm2(size_t n, const double *x, dd_accumulator acc, int threads,
+                     double *result_hi, double *result_lo) {
+    dd_real r = dd_reduce_norm2_k(dd_k(), acc, n, x, threads);
+    *result_hi = r.hi;
+    *result_lo = r.lo;
+}
+
+// ============================================================================
+// GEMM (float128_benchmark.h)
+// ============================================================================
+
+// Output tiles, numbered row-major over the tile grid, are shared out in
+// contiguous ranges like dd_reduce's blocks. Each element is computed
+// whole by one tile, so the thread count cannot change any bits.
+typedef struct {
+    const dd_kernels *k;
+    const dd_gemm_args *g;
+    size_t first, last;         // tiles [first, last)
+    int threaded, failed;
+} dd_gemm_job;
+
+static void *dd_gemm_worker(void *arg) {
+    dd_gemm_job *j = (dd_gemm_job*)arg;
+    const dd_gemm_args *g = j->g;
+    double *work = (double*)malloc(DD_GEMM_WORK * sizeof(double));
+    if (!work) { j->failed = 1; return NULL; }
+    size_t tn = (g->n + DD_GEMM_NC - 1) / DD_GEMM_NC;
+    for (size_t t = j->first; t < j->last; t++) {
+        size_t i0 = t / tn * DD_GEMM_MC, j0 = t % tn * DD_GEMM_NC;
+        size_t mc = g->m - i0 < DD_GEMM_MC ? g->m - i0 : DD_GEMM_MC;
+        size_t nc = g->n - j0 < DD_GEMM_NC ? g->n - j0 : DD_GEMM_NC;
+        j->k->gemm_tile(g, i0, mc, j0, nc, work);
+    }
+    free(work);
+    return NULL;
+}
+
+// Allocation failure leaves NaN in every element of C
+static void dd_gemm_run(const dd_kernels *k, const dd_gemm_args *g, int threads) {
+    size_t nt = ((g->m + DD_GEMM_MC - 1) / DD_GEMM_MC) * ((g->n + DD_GEMM_NC - 1) / DD_GEMM_NC);
+    if (nt == 0) return;
+    if (threads <= 0) {
+        long c = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = c > 0 ? (int)c : 1;
+    }
+    if ((size_t)threads > nt) threads = (int)nt;
+    dd_gemm_job *jobs = (dd_gemm_job*)calloc((size_t)threads, sizeof(dd_gemm_job));
+    pthread_t *tid = (pthread_t*)calloc((size_t)threads, sizeof(pthread_t));
+    int failed = !jobs || !tid;
+    for (int t = 0; !failed && t < threads; t++) {
+        dd_gemm_job *j = &jobs[t];
+        j->k = k; j->g = g;
+        j->first = nt * (size_t)t / (size_t)threads;
+        j->last = nt * (size_t)(t + 1) / (size_t)threads;
+        j->threaded = t + 1 < threads && pthread_create(&tid[t], NULL, dd_gemm_worker, j) == 0;
+        if (!j->threaded) dd_gemm_worker(j);
+    }
+    for (int t = 0; jobs && tid && t < threads; t++) {
+        if (jobs[t].threaded) pthread_join(tid[t], NULL);
+        failed |= jobs[t].failed;
+    }
+    if (failed)
+        for (size_t i = 0; i < g->m; i++)
+            for (size_t j = 0; j < g->n; j++) {
+                g->c[i * g->ldc + j] = NAN;
+                if (g->c_lo) g->c_lo[i * g->ldc + j] = NAN;
+            }
+    free(jobs); free(tid);
+}
+
+// The naive triple loop on the scalar routines: the definition the tiled
+// kernels match bit for bit, and the baseline they are timed against
+static void dd_gemm_ref(const dd_gemm_args *g) {
+    for (size_t i = 0; i < g->m; i++)
+        for (size_t j = 0; j < g->n; j++) {
+            dd_real acc = dd_from_double(0.0);
+            double e_sum = 0.0;
+            for (size_t p = 0; p < g->k; p++) {
+                size_t ai = i * g->lda + p, bi = p * g->ldb + j;
+                double a = g->a[ai], al = g->a_lo ? g->a_lo[ai] : 0.0;
+                double b = g->b[bi], bl = g->b_lo ? g->b_lo[bi] : 0.0;
+                int lo = g->a_lo || g->b_lo;
+                if (g->mode == DD_GEMM_DOUBLE) {
+                    acc.hi = acc.hi + a * b;
+                } else if (g->mode == DD_GEMM_COMPENSATED) {
+                    dd_real pr = two_prod(a, b), s = two_sum(acc.hi, pr.hi);
+                    double e = s.lo + pr.lo;
+                    if (lo) e = e + (a * bl + al * b);
+                    acc.hi = s.hi;
+                    e_sum += e;
+                } else {
+                    acc = dd_add(acc, lo ? dd_mul((dd_real){ a, al }, (dd_real){ b, bl }) : two_prod(a, b));
+                }
+            }
+            if (g->mode == DD_GEMM_COMPENSATED) acc = two_sum(acc.hi, e_sum);
+            g->c[i * g->ldc + j] = acc.hi;
+            if (g->c_lo) g->c_lo[i * g->ldc + j] = acc.lo;
+        }
+}
+
+void dd_gemm(size_t m, size_t n, size_t k, const double *a, const double *a_lo, size_t lda,
+             const double *b, const double *b_lo, size_t ldb, dd_accumulator acc, int threads,
+             double *c_hi, double *c_lo, size_t ldc) {
+    dd_gemm_args g = { (dd_gemm_mode)acc, m, n, k, a, a_lo, b, b_lo, lda, ldb, ldc, c_hi, c_lo };
+    dd_gemm_run(dd_k(), &g, threads);
+}
+
+// ============================================================================
+// Batched quad-double (float128_benchmark.h)
+// ============================================================================
+
+static inline qd_real qd_load(const double *p) {
+    qd_real r;
+    memcpy(r.x, p, sizeof(r.x));
+    return r;
+}
+
+static inline void qd_store(double *p, qd_real v) {
+    memcpy(p, v.x, sizeof(v.x));
+}
+
+void qd_add_n(size_t n, const double *a, const double *b, double *out) {
+    for (size_t i = 0; i < n; i++) qd_store(out + 4 * i, qd_add(qd_load(a + 4 * i), qd_load(b + 4 * i)));
+}
+
+void qd_mul_n(size_t n, const double *a, const double *b, double *out) {
+    for (size_t i = 0; i < n; i++) qd_store(out + 4 * i, qd_mul(qd_load(a + 4 * i), qd_load(b + 4 * i)));
+}
+
+void qd_div_n(size_t n, const double *a, const double *b, double *out) {
+    for (size_t i = 0; i < n; i++) qd_store(out + 4 * i, qd_div(qd_load(a + 4 * i), qd_load(b + 4 * i)));
+}
+
+void qd_sqrt_n(size_t n, const double *a, double *out) {
+    for (size_t i = 0; i < n; i++) qd_store(out + 4 * i, qd_sqrt(qd_load(a + 4 * i)));
+}
+
+void qd_dot(size_t n, const double *a, const double *b, double *result) {
+    qd_real acc = qd_from_double(0.0);
+    for (size_t i = 0; i < n; i++) {
+        dd_real p = two_prod(a[i], b[i]);
+        qd_real t = {{ p.hi, p.lo, 0.0, 0.0 }};
+        acc = qd_add(acc, t);
+    }
+    qd_store(result, acc);
+}
+
+void qd_sum(size_t n, const double *x, double *result) {
+    qd_real acc = qd_from_double(0.0);
+    for (size_t i = 0; i < n; i++) acc = qd_add(acc, qd_from_double(x[i]));
+    qd_store(result, acc);
+}
+
+// __float128 (GCC/Clang on x86-64 and others; software arithmetic in
+// libgcc) as a comparison tier. Its 113 bits convert to quad-double
+// exactly, so errors can be measured against quad-double results.
+#if defined(__SIZEOF_FLOAT128__)
+#define DD_HAVE_FLOAT128 1
+static qd_real qd_from_f128(__float128 q) {
+    qd_real r;
+    for (int k = 0; k < 4; k++) {
+        r.x[k] = (double)q;
+        q -= r.x[k];
+    }
+    return r;
+}
+#else
+#define DD_HAVE_FLOAT128 0
+#endif
+
+static inline qd_real qd_from_dd(dd_real a) {
+    qd_real r = {{ a.hi, a.lo, 0.0, 0.0 }};
+    return r;
+}
+
+// x - ref as a double, relative to |ref|
+static double qd_rel_err(qd_real x, qd_real ref) {
+    return fabs(qd_to_double(qd_sub(x, ref)) / qd_to_double(ref));
+}
+
 // ============================================================================
 // Test Cases
 // ============================================================================
@@ -188,6 +1249,14 @@ void test_cancellation() {
     dd_real dd_result = dd_add_d(dd_sum, -1.0);
     printf("double-double:  %.20e\n", dd_to_double(dd_result));
     dd_print("  ", dd_result);
+
+#if DD_HAVE_FLOAT128
+    __float128 q_result = ((__float128)1.0 + (__float128)1e-16) - (__float128)1.0;
+    printf("__float128:     %.20e\n", (double)q_result);
+#endif
+    qd_real qd_result = qd_sub(qd_add(qd_from_double(1.0), qd_from_double(1e-16)), qd_from_double(1.0));
+    printf("quad-double:    %.20e\n", qd_to_double(qd_result));
+    qd_print("  ", qd_result);
 }
 
 // Test 3: Sum of many small numbers
@@ -230,6 +1299,29 @@ void test_summation() {
     }
     end = clock();
     double dd_time = (double)(end - start) / CLOCKS_PER_SEC;
+
+    // Quad-double summation
+    start = clock();
+    qd_real qd_sum = qd_from_double(0.0);
+    qd_real qd_small = qd_from_double(small);
+    for (int i = 0; i < n; i++) {
+        qd_sum = qd_add(qd_sum, qd_small);
+    }
+    end = clock();
+    double qd_time = (double)(end - start) / CLOCKS_PER_SEC;
+
+#if DD_HAVE_FLOAT128
+    start = clock();
+    __float128 q_sum = 0;
+    for (int i = 0; i < n; i++) {
+        q_sum += (__float128)small;
+    }
+    end = clock();
+    double q_time = (double)(end - start) / CLOCKS_PER_SEC;
+#endif
+
+    // The exact sum: n * fl(1e-8) needs only 80 bits
+    qd_real exact = qd_from_dd(two_prod((double)n, small));
     
     printf("\nResults:\n");
     printf("  double:            %.15f (error: %.2e, time: %.3fs)\n", 
@@ -238,10 +1330,29 @@ void test_summation() {
            k_sum, fabs(k_sum - 1.0), k_time);
     printf("  double-double:     %.15f (error: %.2e, time: %.3fs)\n", 
            dd_to_double(dd_sum), fabs(dd_to_double(dd_sum) - 1.0), dd_time);
+#if DD_HAVE_FLOAT128
+    printf("  __float128:        %.15f (error: %.2e, time: %.3fs)\n",
+           (double)q_sum, fabs((double)q_sum - 1.0), q_time);
+#endif
+    printf("  quad-double:       %.15f (error: %.2e, time: %.3fs)\n",
+           qd_to_double(qd_sum), fabs(qd_to_double(qd_sum) - 1.0), qd_time);
+
+    printf("\nRelative error vs the exact sum n * fl(1e-8) = 1 %+.3e:\n", qd_to_double(qd_sub(exact, qd_from_double(1.0))));
+    printf("  double %.2e, Kahan %.2e, double-double %.2e",
+           qd_rel_err(qd_from_double(d_sum), exact), qd_rel_err(qd_from_double(k_sum), exact),
+           qd_rel_err(qd_from_dd(dd_sum), exact));
+#if DD_HAVE_FLOAT128
+    printf(", __float128 %.2e", qd_rel_err(qd_from_f128(q_sum), exact));
+#endif
+    printf(", quad-double %.2e\n", qd_rel_err(qd_sum, exact));
     
     printf("\nPerformance:\n");
     printf("  Kahan overhead:         %.1fx slower than simple double\n", k_time / d_time);
     printf("  double-double overhead: %.1fx slower than simple double\n", dd_time / d_time);
+#if DD_HAVE_FLOAT128
+    printf("  __float128 overhead:    %.1fx slower than simple double\n", q_time / d_time);
+#endif
+    printf("  quad-double overhead:   %.1fx slower than simple double\n", qd_time / d_time);
 }
 
 // Test 4: Product of many near-unity values
@@ -265,6 +1376,25 @@ void test_product() {
         dd_prod = dd_mul(dd_prod, dd_near_one);
     }
     
+    // Quad-double, by repeated multiplication and by binary powering (a
+    // different rounding path, so their gap bounds quad-double's error)
+    qd_real qd_prod = qd_from_double(1.0), qd_pow = qd_from_double(1.0);
+    qd_real qd_near_one = qd_from_double(near_one);
+    for (int i = 0; i < n; i++) {
+        qd_prod = qd_mul(qd_prod, qd_near_one);
+    }
+    for (int e = n; e > 0; e >>= 1) {
+        if (e & 1) qd_pow = qd_mul(qd_pow, qd_near_one);
+        qd_near_one = qd_mul(qd_near_one, qd_near_one);
+    }
+
+#if DD_HAVE_FLOAT128
+    __float128 q_prod = 1;
+    for (int i = 0; i < n; i++) {
+        q_prod *= (__float128)near_one;
+    }
+#endif
+
     // Expected: (1 + 1e-8)^100000 ≈ e^(100000 * 1e-8) ≈ e^0.001 ≈ 1.001000500167
     double expected = exp(n * 1e-8);
     
@@ -273,6 +1403,891 @@ void test_product() {
     printf("  double:         %.15f (error: %.2e)\n", d_prod, fabs(d_prod - expected));
     printf("  double-double:  %.15f (error: %.2e)\n", 
            dd_to_double(dd_prod), fabs(dd_to_double(dd_prod) - expected));
+    printf("  quad-double:    %.15f (error: %.2e)\n",
+           qd_to_double(qd_prod), fabs(qd_to_double(qd_prod) - expected));
+
+    // exp() itself is only good to 53 bits; measure against quad-double
+    printf("\nRelative error vs quad-double (exact product of fl(1 + 1e-8)):\n");
+    printf("  double %.2e, double-double %.2e", qd_rel_err(qd_from_double(d_prod), qd_prod),
+           qd_rel_err(qd_from_dd(dd_prod), qd_prod));
+#if DD_HAVE_FLOAT128
+    printf(", __float128 %.2e", qd_rel_err(qd_from_f128(q_prod), qd_prod));
+#endif
+    printf(", quad-double (vs binary powering) %.2e\n", qd_rel_err(qd_pow, qd_prod));
+}
+
+// Test 5: Batched kernels: bit-exact against the scalar instantiation, and
+// per-element cost against the scalar interop calls
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static int same_bits(const double *x, const double *y, size_t n) {
+    return memcmp(x, y, n * sizeof(double)) == 0;
+}
+
+void test_batch() {
+    printf("\n=== Test 5: Batched SoA Kernels (%s) ===\n", dd_kernel_isa());
+    const size_t n = 1000003;   // odd: exercises every vector tail
+    double *buf = (double*)malloc(10 * n * sizeof(double));
+    if (!buf) { printf("  (allocation failed)\n"); return; }
+    double *ah = buf, *al = ah + n, *bh = al + n, *bl = bh + n, *ch = bl + n, *cl = ch + n;
+    double *rh = cl + n, *rl = rh + n, *sh = rl + n, *sl = sh + n;
+    uint64_t x = 88172645463325252ull;
+    for (size_t i = 0; i < n; i++) {
+        double v[3];
+        for (int k = 0; k < 3; k++) {
+            x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+            v[k] = ((double)(x >> 11) / 9007199254740992.0 - 0.5) * ldexp(1.0, (int)(x % 40) - 20);
+        }
+        dd_real a = two_sum(v[0], v[1] * 1e-17), b = two_sum(v[1], v[2] * 1e-17), c = two_sum(v[2], v[0] * 1e-17);
+        ah[i] = a.hi; al[i] = a.lo; bh[i] = b.hi; bl[i] = b.lo; ch[i] = c.hi; cl[i] = c.lo;
+    }
+
+    int ok = 1;
+    const dd_kernels *k = dd_k(), *s = &dd_kernels_scalar;
+    k->add_n(n, ah, al, bh, bl, rh, rl);
+    s->add_n(n, ah, al, bh, bl, sh, sl);
+    ok &= same_bits(rh, sh, n) && same_bits(rl, sl, n);
+    k->mul_n(n, ah, al, bh, bl, rh, rl);
+    s->mul_n(n, ah, al, bh, bl, sh, sl);
+    ok &= same_bits(rh, sh, n) && same_bits(rl, sl, n);
+    for (size_t i = 0; i < n; i++) {
+        double h, l;
+        compute_double_double_mul(ah[i], al[i], bh[i], bl[i], &h, &l);
+        ok &= h == rh[i] && l == rl[i];
+    }
+    k->fma_n(n, ah, al, bh, bl, ch, cl, rh, rl);
+    s->fma_n(n, ah, al, bh, bl, ch, cl, sh, sl);
+    ok &= same_bits(rh, sh, n) && same_bits(rl, sl, n);
+    for (size_t m = 0; m < 20; m++) {  // every tail length
+        dd_real d1 = k->dot(n - m, ah, al, bh, bl), d2 = s->dot(n - m, ah, al, bh, bl);
+        dd_real s1 = k->sum(n - m, ah, al), s2 = s->sum(n - m, ah, al);
+        ok &= same_bits(&d1.hi, &d2.hi, 1) && same_bits(&d1.lo, &d2.lo, 1);
+        ok &= same_bits(&s1.hi, &s2.hi, 1) && same_bits(&s1.lo, &s2.lo, 1);
+    }
+    printf("Bit-exact vs scalar reference: %s\n", ok ? "yes" : "NO");
+
+    const int reps = 5;
+    double t0 = now_s();
+    for (int r = 0; r < reps; r++)
+        for (size_t i = 0; i < n; i++) compute_double_double_mul(ah[i], al[i], bh[i], bl[i], &rh[i], &rl[i]);
+    double t_call = (now_s() - t0) / reps;
+    t0 = now_s();
+    for (int r = 0; r < reps; r++) s->mul_n(n, ah, al, bh, bl, rh, rl);
+    double t_scalar = (now_s() - t0) / reps;
+    t0 = now_s();
+    for (int r = 0; r < reps; r++) dd_mul_n(n, ah, al, bh, bl, rh, rl);
+    double t_batch = (now_s() - t0) / reps;
+    t0 = now_s();
+    double dh = 0, dl = 0;
+    for (int r = 0; r < reps; r++) dd_dot(n, ah, al, bh, bl, &dh, &dl);
+    double t_dot = (now_s() - t0) / reps;
+    printf("dd_mul per element:  interop call %.2f ns, scalar batch %.2f ns, %s batch %.2f ns (%.1fx)\n",
+           t_call / n * 1e9, t_scalar / n * 1e9, dd_kernel_isa(), t_batch / n * 1e9, t_call / t_batch);
+    printf("dd_dot per element:  %.2f ns (result %.17e + %.3e)\n", t_dot / n * 1e9, dh, dl);
+    free(buf);
+}
+
+// Test 6: Quad-double against __float128 (it must agree to within
+// __float128's own rounding) and against itself (div and sqrt inverted),
+// then the cost per element of each precision tier
+void test_quad_double() {
+    printf("\n=== Test 6: Quad-Double Tier ===\n");
+    const size_t n = 1 << 16;
+    double *buf = (double*)malloc(20 * n * sizeof(double));
+    if (!buf) { printf("  (allocation failed)\n"); return; }
+    double *a = buf, *b = a + 4 * n, *r = b + 4 * n, *ah = r + 4 * n, *al = ah + n, *bh = al + n, *bl = bh + n;
+    double *rh = bl + n, *rl = rh + n, *dr = rl + n;
+    uint64_t x = 0x2545F4914F6CDD1Dull;
+    for (size_t i = 0; i < n; i++) {
+        double v[4];
+        for (int k = 0; k < 4; k++) {
+            x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+            v[k] = (1.0 + (double)(x >> 12) / 4503599627370496.0) * ldexp(1.0, (int)(x % 64) - 32);
+        }
+        // hi + lo spans 113 bits: exact in __float128, and the dd copies
+        // are the same values
+        dd_real da = { v[0], ldexp(v[1], ilogb(v[0]) - ilogb(v[1]) - 60) };
+        dd_real db = { v[2], ldexp(v[3], ilogb(v[2]) - ilogb(v[3]) - 60) };
+        if (i % 2) da.hi = -da.hi, da.lo = -da.lo;
+        qd_store(a + 4 * i, qd_from_dd(da));
+        qd_store(b + 4 * i, qd_from_dd(db));
+        ah[i] = da.hi; al[i] = da.lo; bh[i] = db.hi; bl[i] = db.lo;
+    }
+
+    // Relative error bounds: __float128 rounds to 2^-113, quad-double's own
+    // error is below 2^-200 for these ops
+    double worst[4] = {0}, self_div = 0, self_sqrt = 0;
+    for (size_t i = 0; i < n; i++) {
+        qd_real qa = qd_load(a + 4 * i), qb = qd_load(b + 4 * i);
+        qd_real s = qd_add(qa, qb), p = qd_mul(qa, qb), q = qd_div(qa, qb), sq = qd_sqrt(qb);
+        double e;
+        e = qd_rel_err(qd_mul(q, qb), qa); if (e > self_div) self_div = e;
+        e = qd_rel_err(qd_mul(sq, sq), qb); if (e > self_sqrt) self_sqrt = e;
+#if DD_HAVE_FLOAT128
+        __float128 fa = (__float128)qa.x[0] + qa.x[1], fb = (__float128)qb.x[0] + qb.x[1];
+        qd_real ref[3] = { qd_from_f128(fa + fb), qd_from_f128(fa * fb), qd_from_f128(fa / fb) };
+        qd_real got[3] = { s, p, q };
+        for (int k = 0; k < 3; k++) {
+            e = qd_rel_err(ref[k], got[k]);
+            if (e > worst[k]) worst[k] = e;
+        }
+#else
+        (void)s; (void)p;
+#endif
+    }
+#if DD_HAVE_FLOAT128
+    int ok = worst[0] <= 0x1p-113 && worst[1] <= 0x1p-113 && worst[2] <= 0x1p-113;
+    printf("vs __float128, max relative gap (its rounding is 2^-113 = %.1e):\n", 0x1p-113);
+    printf("  add %.2e, mul %.2e, div %.2e: %s\n", worst[0], worst[1], worst[2],
+           ok ? "within __float128 rounding" : "NOT within __float128 rounding");
+#endif
+    printf("Self-consistency: |q * b - a| / |a| %.2e, |sqrt(b)^2 - b| / |b| %.2e: %s\n", self_div, self_sqrt,
+           self_div < 0x1p-200 && self_sqrt < 0x1p-200 ? "below 2^-200" : "NOT below 2^-200");
+
+    // Cost per element for each tier on the same operands
+    const int reps = 5;
+    double t[4][4];                 // [tier][add, mul, div, sqrt], ns; < 0 = n/a
+    for (int i = 0; i < 4; i++) for (int k = 0; k < 4; k++) t[i][k] = -1;
+    double t0;
+    #define DD_TIME(slot, body) do { \
+        t0 = now_s(); \
+        for (int rep = 0; rep < reps; rep++) { body; } \
+        slot = (now_s() - t0) / reps / n * 1e9; \
+    } while (0)
+    DD_TIME(t[0][0], for (size_t i = 0; i < n; i++) dr[i] = ah[i] + bh[i]);
+    DD_TIME(t[0][1], for (size_t i = 0; i < n; i++) dr[i] = ah[i] * bh[i]);
+    DD_TIME(t[0][2], for (size_t i = 0; i < n; i++) dr[i] = ah[i] / bh[i]);
+    DD_TIME(t[0][3], for (size_t i = 0; i < n; i++) dr[i] = sqrt(bh[i]));
+    DD_TIME(t[1][0], dd_add_n(n, ah, al, bh, bl, rh, rl));
+    DD_TIME(t[1][1], dd_mul_n(n, ah, al, bh, bl, rh, rl));
+#if DD_HAVE_FLOAT128
+    __float128 *fq = (__float128*)malloc(3 * n * sizeof(__float128));
+    if (fq) {
+        __float128 *fa = fq, *fb = fa + n, *fr = fb + n;
+        for (size_t i = 0; i < n; i++) { fa[i] = (__float128)ah[i] + al[i]; fb[i] = (__float128)bh[i] + bl[i]; }
+        DD_TIME(t[2][0], for (size_t i = 0; i < n; i++) fr[i] = fa[i] + fb[i]);
+        DD_TIME(t[2][1], for (size_t i = 0; i < n; i++) fr[i] = fa[i] * fb[i]);
+        DD_TIME(t[2][2], for (size_t i = 0; i < n; i++) fr[i] = fa[i] / fb[i]);
+        free(fq);
+    }
+#endif
+    DD_TIME(t[3][0], qd_add_n(n, a, b, r));
+    DD_TIME(t[3][1], qd_mul_n(n, a, b, r));
+    DD_TIME(t[3][2], qd_div_n(n, a, b, r));
+    DD_TIME(t[3][3], qd_sqrt_n(n, b, r));
+    #undef DD_TIME
+
+    static const char *tier[4] = { "double (53 bits)", "double-double (106)", "__float128 (113)", "quad-double (212)" };
+    printf("\nCost per element, ns      add      mul      div     sqrt\n");
+    for (int i = 0; i < 4; i++) {
+        printf("  %-20s", tier[i]);
+        for (int k = 0; k < 4; k++) {
+            if (t[i][k] < 0) printf("        -");
+            else printf(" %8.2f", t[i][k]);
+        }
+        printf("\n");
+    }
+    printf("  (double-double: %s batch kernels; __float128: libgcc software; sqrt needs libquadmath)\n",
+           dd_kernel_isa());
+    free(buf);
+}
+
+// Test 7: Parallel reductions: the same bits for every thread count and
+// kernel set, accuracy against quad-double on badly conditioned data, and
+// throughput against a naive loop
+static int same_dd(dd_real x, dd_real y) {
+    return same_bits(&x.hi, &y.hi, 1) && same_bits(&x.lo, &y.lo, 1);
+}
+
+static uint64_t t7_next(uint64_t *r) {
+    *r ^= *r << 13; *r ^= *r >> 7; *r ^= *r << 17;
+    return *r;
+}
+
+// Random sign, significand in [0.5, 1.5), exponent spread over `spread`
+static double t7_rand(uint64_t *r, int spread) {
+    double m = (double)(t7_next(r) >> 11) / 9007199254740992.0 + 0.5;
+    double v = ldexp(m, (int)(t7_next(r) % (uint64_t)spread) - spread / 2);
+    return t7_next(r) & 1 ? v : -v;
+}
+
+void test_reductions() {
+    printf("\n=== Test 7: Parallel Reductions (%s) ===\n", dd_kernel_isa());
+    const size_t n = (1 << 22) + 12345;     // a partial last block
+    double *buf = (double*)malloc(4 * n * sizeof(double));
+    if (!buf) { printf("  (allocation failed)\n"); return; }
+    double *x = buf, *a = x + n, *b = a + n, *t = b + n;
+    // Each value appears a second time negated and nudged by a few ulps, then
+    // everything is shuffled: the sums cancel down to the nudges (condition
+    // numbers around 1e17), which is where the accumulators differ
+    uint64_t r = 0x9E3779B97F4A7C15ull;
+    const size_t h = n / 2;
+    for (size_t i = 0; i < h; i++) {
+        x[i] = t7_rand(&r, 60);
+        a[i] = fabs(t7_rand(&r, 40));
+        b[i] = t7_rand(&r, 40);
+        x[h + i] = -x[i] * (1.0 + (double)(t7_next(&r) % 8) * DBL_EPSILON);
+        a[h + i] = a[i];
+        b[h + i] = -b[i] * (1.0 + (double)(t7_next(&r) % 8) * DBL_EPSILON);
+    }
+    for (size_t i = 2 * h; i < n; i++) x[i] = a[i] = b[i] = 0.0;
+    for (size_t i = n - 1; i > 0; i--) {     // same shuffle for all three
+        size_t j = t7_next(&r) % (i + 1);
+        double v;
+        v = x[i]; x[i] = x[j]; x[j] = v;
+        v = a[i]; a[i] = a[j]; a[j] = v;
+        v = b[i]; b[i] = b[j]; b[j] = v;
+    }
+
+    // Reproducibility
+    static const int threads[] = { 1, 2, 3, 4, 8 };
+    int ok = 1;
+    const dd_kernels *k = dd_k(), *sk = &dd_kernels_scalar;
+    for (int acc = 0; acc < 2; acc++) {
+        dd_real s1 = dd_reduce(k, (dd_accumulator)acc, n, x, NULL, 1.0, 1);
+        dd_real d1 = dd_reduce(k, (dd_accumulator)acc, n, a, b, 1.0, 1);
+        for (size_t i = 1; i < sizeof(threads) / sizeof(threads[0]); i++) {
+            ok &= same_dd(s1, dd_reduce(k, (dd_accumulator)acc, n, x, NULL, 1.0, threads[i]));
+            ok &= same_dd(d1, dd_reduce(k, (dd_accumulator)acc, n, a, b, 1.0, threads[i]));
+        }
+        ok &= same_dd(s1, dd_reduce(sk, (dd_accumulator)acc, n, x, NULL, 1.0, 3));
+        ok &= same_dd(d1, dd_reduce(sk, (dd_accumulator)acc, n, a, b, 1.0, 3));
+    }
+    printf("Same bits for 1, 2, 3, 4, 8 threads and the scalar kernels: %s\n", ok ? "yes" : "NO");
+
+    // Rescaling by a power of two is exact, so scaled inputs must give the
+    // scaled norm bit for bit, through overflow and underflow of the squares
+    int ok_norm = 1;
+    dd_real nrm = dd_reduce_norm2_k(k, DD_ACC_COMPENSATED, n, a, 0);
+    static const int shift[] = { 600, -600, 900, -900 };
+    for (size_t s = 0; s < sizeof(shift) / sizeof(shift[0]); s++) {
+        for (size_t i = 0; i < n; i++) t[i] = ldexp(a[i], shift[s]);
+        dd_real got = dd_reduce_norm2_k(k, DD_ACC_COMPENSATED, n, t, 0);
+        ok_norm &= got.hi == ldexp(nrm.hi, shift[s]) && got.lo == ldexp(nrm.lo, shift[s]);
+    }
+    printf("norm2(x * 2^e) == norm2(x) * 2^e for e = 600, -600, 900, -900: %s\n", ok_norm ? "yes" : "NO");
+
+    // Accuracy against quad-double
+    double q[4], sum_abs = 0.0, dot_abs = 0.0, naive_s = 0.0, naive_d = 0.0;
+    qd_sum(n, x, q);
+    qd_real exact_s = qd_load(q);
+    qd_dot(n, a, b, q);
+    qd_real exact_d = qd_load(q);
+    for (size_t i = 0; i < n; i++) {
+        naive_s += x[i];
+        naive_d += a[i] * b[i];
+        sum_abs += fabs(x[i]);
+        dot_abs += fabs(a[i] * b[i]);
+    }
+    dd_real cs = dd_reduce(k, DD_ACC_COMPENSATED, n, x, NULL, 1.0, 0);
+    dd_real ds = dd_reduce(k, DD_ACC_DOUBLE_DOUBLE, n, x, NULL, 1.0, 0);
+    dd_real cd = dd_reduce(k, DD_ACC_COMPENSATED, n, a, b, 1.0, 0);
+    dd_real dd = dd_reduce(k, DD_ACC_DOUBLE_DOUBLE, n, a, b, 1.0, 0);
+    printf("Relative error vs quad-double        naive  compensated  double-double\n");
+    printf("  sum, condition %.1e    %10.2e   %10.2e     %10.2e\n",
+           sum_abs / fabs(qd_to_double(exact_s)), qd_rel_err(qd_from_double(naive_s), exact_s),
+           qd_rel_err(qd_from_dd(cs), exact_s), qd_rel_err(qd_from_dd(ds), exact_s));
+    printf("  dot, condition %.1e    %10.2e   %10.2e     %10.2e\n",
+           2 * dot_abs / fabs(qd_to_double(exact_d)), qd_rel_err(qd_from_double(naive_d), exact_d),
+           qd_rel_err(qd_from_dd(cd), exact_d), qd_rel_err(qd_from_dd(dd), exact_d));
+
+    // Throughput with every online CPU
+    const int reps = 10;
+    volatile double sink = 0;
+    double t0 = now_s(), tn, tc, td;
+    for (int rep = 0; rep < reps; rep++) {
+        double acc = 0.0;
+        for (size_t i = 0; i < n; i++) acc += a[i] * b[i];
+        sink += acc;
+    }
+    tn = (now_s() - t0) / reps;
+    t0 = now_s();
+    for (int rep = 0; rep < reps; rep++) sink += dd_reduce(k, DD_ACC_COMPENSATED, n, a, b, 1.0, 0).hi;
+    tc = (now_s() - t0) / reps;
+    t0 = now_s();
+    for (int rep = 0; rep < reps; rep++) sink += dd_reduce(k, DD_ACC_DOUBLE_DOUBLE, n, a, b, 1.0, 0).hi;
+    td = (now_s() - t0) / reps;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    printf("dot per element (%ld CPUs): naive loop %.3f ns, compensated %.3f ns (%.1f GB/s), double-double %.3f ns\n",
+           cpus, tn / n * 1e9, tc / n * 1e9, 16.0 * n / tc * 1e-9, td / n * 1e9);
+    free(buf);
+}
+
+// Test 8: Elementary functions: batch kernels bit-identical to the scalar
+// functions (special values included), error in units of 2^-106 of the
+// result against __float128 (libquadmath builds) and identities in
+// quad-double, and the cost per element
+typedef dd_real (*dd_unary)(dd_real);
+typedef void (*dd_unary_n)(size_t, const double*, const double*, double*, double*);
+
+// Random double-double with hi in [lo_e, hi_e) binades (or uniform in
+// [-span, span] when span > 0) and 7 more bits in lo: 60 bits in all, so
+// the value is exact in __float128
+static dd_real t8_rand(uint64_t *r, int lo_e, int hi_e, double span) {
+    double u = (double)(t7_next(r) >> 11) / 9007199254740992.0, hi;
+    if (span > 0) hi = (2 * u - 1) * span;
+    else hi = ldexp(1.0 + u, lo_e + (int)(t7_next(r) % (uint64_t)(hi_e - lo_e)));
+    if (hi == 0) return dd_from_double(0.0);
+    double lo = ldexp((double)(int)(t7_next(r) % 127) - 63, ilogb(hi) - 59);
+    return quick_two_sum(hi, lo);
+}
+
+void test_elementary() {
+    printf("\n=== Test 8: Double-Double Elementary Functions (%s) ===\n", dd_kernel_isa());
+    static const struct {
+        const char *name;
+        dd_unary f;
+        int op;                             // dd_kernels slot (0 sqrt .. 4 cos)
+        int lo_e, hi_e;
+        double span;
+    } fn[] = {
+        { "sqrt", dd_sqrt, 0, -30, 30, 0 },
+        { "exp", dd_exp, 1, 0, 0, 600.0 },
+        { "log", dd_log, 2, -60, 60, 0 },
+        { "log near 1", dd_log, 2, 0, 0, -1.0 },
+        { "sin", dd_sin, 3, 0, 0, 100.0 },
+        { "cos", dd_cos, 4, 0, 0, 100.0 },
+        { "sin, |x| < 2^20", dd_sin, 3, 0, 0, 0x1p20 },
+        { "cos, |x| to 2^60", dd_cos, 4, 20, 60, 0 },
+    };
+    static const double special[] = {
+        0.0, -0.0, 1.0, -1.0, INFINITY, -INFINITY, NAN, DBL_MIN, 0x1p-1060, DBL_MAX, 0x1p-970,
+        708.0, 708.5, 709.7, 710.0, -708.5, -745.0, -746.0, 0x1p20, 0x1.0000001p20, 1e22, -1e300 };
+    const size_t ns = sizeof(special) / sizeof(special[0]), n = 1 << 14;
+    double *buf = (double*)malloc(6 * (n + ns) * sizeof(double));
+    if (!buf) { printf("  (allocation failed)\n"); return; }
+    double *ah = buf, *al = ah + n + ns, *rh = al + n + ns, *rl = rh + n + ns, *sh = rl + n + ns, *sl = sh + n + ns;
+    const dd_kernels *k = dd_k(), *sk = &dd_kernels_scalar;
+    uint64_t r = 0x2545F4914F6CDD1Dull;
+    int ok = 1;
+
+#if DD_USE_QUADMATH
+    printf("Error vs __float128 in units of 2^-106 |f(x)| (max, mean); identity check in quad-double\n");
+#else
+    printf("Error check by identity in quad-double (-DDD_USE_QUADMATH=1 -lquadmath adds __float128 references)\n");
+#endif
+    for (size_t t = 0; t < sizeof(fn) / sizeof(fn[0]); t++) {
+        for (size_t i = 0; i < n; i++) {
+            dd_real x = fn[t].span < 0 ? quick_two_sum(1.0, t8_rand(&r, 0, 0, 0x1p-20).hi)
+                                       : t8_rand(&r, fn[t].lo_e, fn[t].hi_e, fn[t].span);
+            ah[i] = x.hi; al[i] = x.lo;
+        }
+        for (size_t i = 0; i < ns; i++) { ah[n + i] = special[i]; al[n + i] = 0.0; }
+        dd_unary_n kf = (&k->sqrt_n)[fn[t].op], sf = (&sk->sqrt_n)[fn[t].op];
+        kf(n + ns, ah, al, rh, rl);
+        sf(n + ns, ah, al, sh, sl);
+        int same = same_bits(rh, sh, n + ns) && same_bits(rl, sl, n + ns);
+        for (size_t i = 0; i < n + ns; i++) {
+            dd_real v = fn[t].f((dd_real){ ah[i], al[i] });
+            same &= same_bits(&v.hi, &rh[i], 1) && same_bits(&v.lo, &rl[i], 1);
+        }
+        ok &= same;
+
+        // identities: sqrt(x)^2, log(exp(x)), exp(log(x)), sin^2 + cos^2,
+        // relative to the largest term (absolute for the trig pair)
+        double id = 0.0, worst = 0.0, mean = 0.0;
+        for (size_t i = 0; i < n; i++) {
+            dd_real x = { ah[i], al[i] }, y = { rh[i], rl[i] };
+            qd_real qx = qd_from_dd(x), e;
+            switch (fn[t].op) {
+            case 0: e = qd_sub(qd_mul(qd_from_dd(y), qd_from_dd(y)), qx); e.x[0] /= x.hi; break;
+            case 1: e = qd_sub(qd_from_dd(dd_log(y)), qx); e.x[0] /= fmax(1.0, fabs(x.hi)); break;
+            case 2: e = qd_sub(qd_from_dd(dd_exp(y)), qx); e.x[0] /= x.hi; break;
+            default: {
+                dd_real o = fn[t].op == 3 ? dd_cos(x) : dd_sin(x);
+                e = qd_sub(qd_add(qd_mul(qd_from_dd(y), qd_from_dd(y)), qd_mul(qd_from_dd(o), qd_from_dd(o))),
+                           qd_from_double(1.0));
+            }
+            }
+            if (fabs(e.x[0]) > id) id = fabs(e.x[0]);
+#if DD_USE_QUADMATH
+            __float128 q = (__float128)x.hi + x.lo, ref;
+            switch (fn[t].op) {
+            case 0: ref = sqrtq(q); break;
+            case 1: ref = expq(q); break;
+            case 2: ref = logq(q); break;
+            case 3: ref = sinq(q); break;
+            default: ref = cosq(q); break;
+            }
+            // (no finer than the smallest subnormal: lo runs out of bits there)
+            double d = (double)(((__float128)y.hi + y.lo) - ref);
+            double ulp = fmax(ldexp(1.0, ilogb((double)ref) - 105), 0x1p-1074);
+            double u = fabs(d) / ulp;
+            if (u > worst) worst = u;
+            mean += u / n;
+#endif
+        }
+#if DD_USE_QUADMATH
+        printf("  %-18s %10.2f %8.3f   identity %.1e%s\n", fn[t].name, worst, mean, id, same ? "" : "  BATCH MISMATCH");
+#else
+        (void)worst; (void)mean;
+        printf("  %-18s identity %.1e%s\n", fn[t].name, id, same ? "" : "  BATCH MISMATCH");
+#endif
+    }
+    printf("Batch (%s, scalar set) bit-identical to scalar calls, special values included: %s\n",
+           dd_kernel_isa(), ok ? "yes" : "NO");
+
+    // cost per element on ordinary arguments
+    for (size_t i = 0; i < n; i++) {
+        dd_real x = t8_rand(&r, -4, 4, 0);
+        ah[i] = x.hi; al[i] = x.lo;
+    }
+    printf("Cost per element, ns: scalar call, %s batch", dd_kernel_isa());
+#if DD_USE_QUADMATH
+    printf(", __float128 (libquadmath)");
+#endif
+    printf("\n");
+    static const char *names[5] = { "sqrt", "exp", "log", "sin", "cos" };
+    static const dd_unary f5[5] = { dd_sqrt, dd_exp, dd_log, dd_sin, dd_cos };
+    const int reps = 5;
+    for (int op = 0; op < 5; op++) {
+        double t0 = now_s();
+        for (int rep = 0; rep < reps; rep++)
+            for (size_t i = 0; i < n; i++) {
+                dd_real v = f5[op]((dd_real){ ah[i], al[i] });
+                rh[i] = v.hi; rl[i] = v.lo;
+            }
+        double ts = (now_s() - t0) / reps / n * 1e9;
+        t0 = now_s();
+        for (int rep = 0; rep < reps; rep++) (&k->sqrt_n)[op](n, ah, al, rh, rl);
+        double tb = (now_s() - t0) / reps / n * 1e9;
+        printf("  %-5s %8.1f %8.1f", names[op], ts, tb);
+#if DD_USE_QUADMATH
+        __float128 *fq = (__float128*)rh;       // n / 2 values fit in rh + rl
+        size_t nq = n / 2;
+        t0 = now_s();
+        for (int rep = 0; rep < reps; rep++)
+            for (size_t i = 0; i < nq; i++) {
+                __float128 q = (__float128)ah[i] + al[i];
+                fq[i] = op == 0 ? sqrtq(q) : op == 1 ? expq(q) : op == 2 ? logq(q) : op == 3 ? sinq(q) : cosq(q);
+            }
+        printf(" %8.1f", (now_s() - t0) / reps / nq * 1e9);
+#endif
+        printf("\n");
+    }
+    free(buf);
+}
+
+// Test 9: GEMM: the tiled kernels against the naive triple loop bit for
+// bit (partial tiles, several k panels, double-double inputs, 1 and 3
+// threads), accuracy against quad-double on cancelling products, and
+// throughput against plain double and the naive double-double loop
+static double t9_max_err(const double *c, const double *c_lo, const qd_real *exact, size_t n) {
+    double worst = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        qd_real x = c_lo ? qd_from_dd((dd_real){ c[i], c_lo[i] }) : qd_from_double(c[i]);
+        double e = qd_rel_err(x, exact[i]);
+        if (!(e <= worst)) worst = e;       // NaN sticks
+    }
+    return worst;
+}
+
+void test_gemm() {
+    printf("\n=== Test 9: GEMM (%s) ===\n", dd_kernel_isa());
+    const size_t m = 83, n = 141, k = 611;      // 2 x 2 tiles, 3 k panels, ragged blocks
+    const size_t lda = k + 3, ldb = n + 5, ldc = n + 1;
+    const size_t big = 512;
+    size_t need = 2 * m * lda + 2 * k * ldb + 4 * m * ldc;
+    if (need < 5 * big * big) need = 5 * big * big;
+    double *buf = (double*)malloc(need * sizeof(double));
+    qd_real *exact = (qd_real*)malloc(128 * 128 * sizeof(qd_real));
+    if (!buf || !exact) { printf("  (allocation failed)\n"); free(buf); free(exact); return; }
+
+    // Bit identity with the reference loop
+    double *a = buf, *al = a + m * lda, *b = al + m * lda, *bl = b + k * ldb;
+    double *c = bl + k * ldb, *cl = c + m * ldc, *rc = cl + m * ldc, *rcl = rc + m * ldc;
+    uint64_t r = 0x2545F4914F6CDD1Dull;
+    for (size_t i = 0; i < m * lda; i++) {
+        dd_real v = t8_rand(&r, -20, 20, 0);
+        a[i] = t7_next(&r) & 1 ? v.hi : -v.hi; al[i] = a[i] == v.hi ? v.lo : -v.lo;
+    }
+    for (size_t i = 0; i < k * ldb; i++) {
+        dd_real v = t8_rand(&r, -20, 20, 0);
+        b[i] = t7_next(&r) & 1 ? v.hi : -v.hi; bl[i] = b[i] == v.hi ? v.lo : -v.lo;
+    }
+    static const dd_gemm_mode modes[] = { DD_GEMM_COMPENSATED, DD_GEMM_DOUBLE_DOUBLE, DD_GEMM_DOUBLE };
+    const dd_kernels *sets[] = { dd_k(), &dd_kernels_scalar };
+    int ok = 1;
+    for (int md = 0; md < 3; md++)
+        for (int lo = 0; lo < 2; lo++) {
+            if (lo && modes[md] == DD_GEMM_DOUBLE) continue;
+            dd_gemm_args g = { modes[md], m, n, k, a, lo ? al : NULL, b, lo ? bl : NULL, lda, ldb, ldc, rc, rcl };
+            dd_gemm_ref(&g);
+            g.c = c; g.c_lo = cl;
+            for (int s = 0; s < 2; s++)
+                for (int t = 1; t <= 3; t += 2) {
+                    memset(c, 0, 2 * m * ldc * sizeof(double));
+                    dd_gemm_run(sets[s], &g, t);
+                    for (size_t i = 0; i < m; i++)
+                        ok &= same_bits(c + i * ldc, rc + i * ldc, n) && same_bits(cl + i * ldc, rcl + i * ldc, n);
+                }
+        }
+    printf("Same bits as the naive loop (%s and scalar kernels, 1 and 3 threads): %s\n",
+           dd_kernel_isa(), ok ? "yes" : "NO");
+
+    // Accuracy: rows of A repeat in their second half, and B's second half
+    // is its first negated and nudged by a few ulps, so every product
+    // cancels down to the nudges
+    const size_t q = 128, h = q / 2;
+    a = buf; b = a + q * q; c = b + q * q; cl = c + q * q;
+    double *col = cl + q * q;
+    for (size_t i = 0; i < q; i++)
+        for (size_t p = 0; p < h; p++) {
+            a[i * q + p] = t7_rand(&r, 40);
+            a[i * q + h + p] = a[i * q + p];
+        }
+    for (size_t p = 0; p < h; p++)
+        for (size_t j = 0; j < q; j++) {
+            b[p * q + j] = t7_rand(&r, 40);
+            b[(h + p) * q + j] = -b[p * q + j] * (1.0 + (double)(1 + t7_next(&r) % 8) * DBL_EPSILON);
+        }
+    double cond = 0.0;
+    for (size_t i = 0; i < q; i++)
+        for (size_t j = 0; j < q; j++) {
+            double qv[4], abs_sum = 0.0;
+            for (size_t p = 0; p < q; p++) {
+                col[p] = b[p * q + j];
+                abs_sum += fabs(a[i * q + p] * col[p]);
+            }
+            qd_dot(q, a + i * q, col, qv);
+            exact[i * q + j] = qd_load(qv);
+            double v = fabs(qd_to_double(exact[i * q + j]));
+            if (v > 0 && abs_sum / v > cond) cond = abs_sum / v;
+        }
+    printf("Max relative error vs quad-double, %zu x %zu x %zu, condition up to %.1e:\n", q, q, q, cond);
+    static const char *mode_name[] = { "compensated", "double-double", "double" };
+    for (int md = 2; md >= 0; md--) {
+        dd_gemm_args g = { modes[md], q, q, q, a, NULL, b, NULL, q, q, q, c, cl };
+        dd_gemm_run(dd_k(), &g, 0);
+        printf("  %-14s %10.2e\n", mode_name[md], t9_max_err(c, modes[md] == DD_GEMM_DOUBLE ? NULL : cl, exact, q * q));
+    }
+
+    // Throughput with every online CPU, 2 m n k flops at each tier's own
+    // precision
+    a = buf; b = a + big * big; c = b + big * big; cl = c + big * big;
+    for (size_t i = 0; i < 2 * big * big; i++) a[i] = t7_rand(&r, 20);
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    printf("GFLOP/s, %zu x %zu x %zu (%ld CPUs):\n", big, big, big, cpus);
+    double flops = 2.0 * (double)big * big * big, t_naive = 0.0;
+    {
+        dd_gemm_args g = { DD_GEMM_DOUBLE_DOUBLE, big, big, big, a, NULL, b, NULL, big, big, big, c, cl };
+        double t0 = now_s();
+        dd_gemm_ref(&g);
+        t_naive = now_s() - t0;
+        printf("  %-32s %8.3f\n", "double-double, naive loop", flops / t_naive * 1e-9);
+    }
+    for (int md = 2; md >= 0; md--) {
+        dd_gemm_args g = { modes[md], big, big, big, a, NULL, b, NULL, big, big, big, c, cl };
+        dd_gemm_run(dd_k(), &g, 0);         // warm
+        const int reps = 3;
+        double t0 = now_s();
+        for (int rep = 0; rep < reps; rep++) dd_gemm_run(dd_k(), &g, 0);
+        double t = (now_s() - t0) / reps;
+        char name[64];
+        snprintf(name, sizeof(name), "%s, tiled", mode_name[md]);
+        printf("  %-32s %8.3f  (%.1fx the naive loop)\n", name, flops / t * 1e-9, t_naive / t);
+    }
+    free(buf);
+    free(exact);
+}
+
+// ============================================================================
+// Timing harness (--bench)
+// ============================================================================
+
+// One timed cell per (tier, op). Each kernel runs over n elements that stay
+// in cache; a sample is one timed batch of repeated passes, sized in warmup
+// to last about BENCH_SAMPLE_S. GFLOP/s counts operations at the tier's own
+// precision (a double-double add is one flop), from the median sample.
+#define BENCH_SAMPLE_S 2e-3
+
+typedef enum { B_ADD, B_MUL, B_DIV, B_SQRT, B_MULADD, B_DOT, B_OPS } bench_op;
+static const char *bench_op_name[B_OPS] = { "add", "mul", "div", "sqrt", "muladd", "dot" };
+static const int bench_op_flops[B_OPS] = { 1, 1, 1, 1, 2, 2 };
+
+typedef struct {
+    size_t n;
+    double *a, *b, *c, *r;                  // double, and the dd hi words
+    double *al, *bl, *cl, *rl;              // dd lo words
+    double *qa, *qb, *qr;                   // quad-double, 4 per value
+    long double *la, *lb, *lc, *lr;
+#if DD_HAVE_FLOAT128
+    __float128 *fa, *fb, *fc, *fr;
+#endif
+    volatile double sink;
+} bench_data;
+
+typedef void (*bench_fn)(bench_data*);
+
+typedef struct {
+    const char *tier;
+    int bits;
+    bench_op op;
+    bench_fn fn;
+} bench_cell;
+
+#define BENCH_LOOP(name, stmt) \
+    static void name(bench_data *d) { \
+        const size_t n = d->n; \
+        for (size_t i = 0; i < n; i++) { stmt; } \
+    }
+#define BENCH_DOT(name, T, init, step, out) \
+    static void name(bench_data *d) { \
+        const size_t n = d->n; \
+        T acc = init; \
+        for (size_t i = 0; i < n; i++) { step; } \
+        d->sink += out; \
+    }
+#define DD_AT(h, l, i) ((dd_real){ d->h[i], d->l[i] })
+#define DD_PUT(i, v) do { dd_real v_ = (v); d->r[i] = v_.hi; d->rl[i] = v_.lo; } while (0)
+
+BENCH_LOOP(b_f64_add, d->r[i] = d->a[i] + d->b[i])
+BENCH_LOOP(b_f64_mul, d->r[i] = d->a[i] * d->b[i])
+BENCH_LOOP(b_f64_div, d->r[i] = d->a[i] / d->b[i])
+BENCH_LOOP(b_f64_sqrt, d->r[i] = sqrt(d->a[i]))
+BENCH_LOOP(b_f64_muladd, d->r[i] = d->a[i] * d->b[i] + d->c[i])
+BENCH_DOT(b_f64_dot, double, 0.0, acc += d->a[i] * d->b[i], acc)
+
+BENCH_LOOP(b_ld_add, d->lr[i] = d->la[i] + d->lb[i])
+BENCH_LOOP(b_ld_mul, d->lr[i] = d->la[i] * d->lb[i])
+BENCH_LOOP(b_ld_div, d->lr[i] = d->la[i] / d->lb[i])
+BENCH_LOOP(b_ld_sqrt, d->lr[i] = sqrtl(d->la[i]))
+BENCH_LOOP(b_ld_muladd, d->lr[i] = d->la[i] * d->lb[i] + d->lc[i])
+BENCH_DOT(b_ld_dot, long double, 0.0L, acc += d->la[i] * d->lb[i], (double)acc)
+
+#if DD_HAVE_FLOAT128
+BENCH_LOOP(b_f128_add, d->fr[i] = d->fa[i] + d->fb[i])
+BENCH_LOOP(b_f128_mul, d->fr[i] = d->fa[i] * d->fb[i])
+BENCH_LOOP(b_f128_div, d->fr[i] = d->fa[i] / d->fb[i])
+#if DD_USE_QUADMATH
+BENCH_LOOP(b_f128_sqrt, d->fr[i] = sqrtq(d->fa[i]))
+#endif
+BENCH_LOOP(b_f128_muladd, d->fr[i] = d->fa[i] * d->fb[i] + d->fc[i])
+BENCH_DOT(b_f128_dot, __float128, 0, acc += d->fa[i] * d->fb[i], (double)acc)
+#endif
+
+// Double-double scalar: the inline routines one element at a time, as a
+// straight port would call them
+BENCH_LOOP(b_dd_add, DD_PUT(i, dd_add(DD_AT(a, al, i), DD_AT(b, bl, i))))
+BENCH_LOOP(b_dd_mul, DD_PUT(i, dd_mul(DD_AT(a, al, i), DD_AT(b, bl, i))))
+BENCH_LOOP(b_dd_div, DD_PUT(i, dd_div(DD_AT(a, al, i), DD_AT(b, bl, i))))
+BENCH_LOOP(b_dd_sqrt, DD_PUT(i, dd_sqrt(DD_AT(a, al, i))))
+BENCH_LOOP(b_dd_muladd, DD_PUT(i, dd_add(dd_mul(DD_AT(a, al, i), DD_AT(b, bl, i)), DD_AT(c, cl, i))))
+BENCH_DOT(b_dd_dot, dd_real, dd_from_double(0.0),
+          acc = dd_add(acc, dd_mul(DD_AT(a, al, i), DD_AT(b, bl, i))), acc.hi)
+
+// Double-double batch: the kernel set chosen at load time
+static void b_ddv_add(bench_data *d) { dd_k()->add_n(d->n, d->a, d->al, d->b, d->bl, d->r, d->rl); }
+static void b_ddv_mul(bench_data *d) { dd_k()->mul_n(d->n, d->a, d->al, d->b, d->bl, d->r, d->rl); }
+static void b_ddv_sqrt(bench_data *d) { dd_k()->sqrt_n(d->n, d->a, d->al, d->r, d->rl); }
+static void b_ddv_muladd(bench_data *d) {
+    dd_k()->fma_n(d->n, d->a, d->al, d->b, d->bl, d->c, d->cl, d->r, d->rl);
+}
+static void b_ddv_dot(bench_data *d) { d->sink += dd_k()->dot(d->n, d->a, d->al, d->b, d->bl).hi; }
+
+static void b_qd_add(bench_data *d) { qd_add_n(d->n, d->qa, d->qb, d->qr); }
+static void b_qd_mul(bench_data *d) { qd_mul_n(d->n, d->qa, d->qb, d->qr); }
+static void b_qd_div(bench_data *d) { qd_div_n(d->n, d->qa, d->qb, d->qr); }
+static void b_qd_sqrt(bench_data *d) { qd_sqrt_n(d->n, d->qa, d->qr); }
+
+#undef DD_PUT
+#undef DD_AT
+#undef BENCH_DOT
+#undef BENCH_LOOP
+
+static const bench_cell bench_cells[] = {
+    { "double", DBL_MANT_DIG, B_ADD, b_f64_add },
+    { "double", DBL_MANT_DIG, B_MUL, b_f64_mul },
+    { "double", DBL_MANT_DIG, B_DIV, b_f64_div },
+    { "double", DBL_MANT_DIG, B_SQRT, b_f64_sqrt },
+    { "double", DBL_MANT_DIG, B_MULADD, b_f64_muladd },
+    { "double", DBL_MANT_DIG, B_DOT, b_f64_dot },
+    { "long double", LDBL_MANT_DIG, B_ADD, b_ld_add },
+    { "long double", LDBL_MANT_DIG, B_MUL, b_ld_mul },
+    { "long double", LDBL_MANT_DIG, B_DIV, b_ld_div },
+    { "long double", LDBL_MANT_DIG, B_SQRT, b_ld_sqrt },
+    { "long double", LDBL_MANT_DIG, B_MULADD, b_ld_muladd },
+    { "long double", LDBL_MANT_DIG, B_DOT, b_ld_dot },
+#if DD_HAVE_FLOAT128
+    { "__float128", 113, B_ADD, b_f128_add },
+    { "__float128", 113, B_MUL, b_f128_mul },
+    { "__float128", 113, B_DIV, b_f128_div },
+#if DD_USE_QUADMATH
+    { "__float128", 113, B_SQRT, b_f128_sqrt },
+#endif
+    { "__float128", 113, B_MULADD, b_f128_muladd },
+    { "__float128", 113, B_DOT, b_f128_dot },
+#endif
+    { "double-double", 106, B_ADD, b_dd_add },
+    { "double-double", 106, B_MUL, b_dd_mul },
+    { "double-double", 106, B_DIV, b_dd_div },
+    { "double-double", 106, B_SQRT, b_dd_sqrt },
+    { "double-double", 106, B_MULADD, b_dd_muladd },
+    { "double-double", 106, B_DOT, b_dd_dot },
+    { "double-double batch", 106, B_ADD, b_ddv_add },
+    { "double-double batch", 106, B_MUL, b_ddv_mul },
+    { "double-double batch", 106, B_SQRT, b_ddv_sqrt },
+    { "double-double batch", 106, B_MULADD, b_ddv_muladd },
+    { "double-double batch", 106, B_DOT, b_ddv_dot },
+    { "quad-double batch", 212, B_ADD, b_qd_add },
+    { "quad-double batch", 212, B_MUL, b_qd_mul },
+    { "quad-double batch", 212, B_DIV, b_qd_div },
+    { "quad-double batch", 212, B_SQRT, b_qd_sqrt },
+};
+#define BENCH_CELLS (sizeof(bench_cells) / sizeof(bench_cells[0]))
+
+typedef struct {
+    int warmup, reps, cpu;              // cpu < 0: not pinned
+    size_t n;
+    const char *json;
+} bench_opts;
+
+static int cmp_double(const void *x, const void *y) {
+    double a = *(const double*)x, b = *(const double*)y;
+    return (a > b) - (a < b);
+}
+
+// Pin the calling thread to one CPU; 0, or -1 where unsupported or refused
+static int bench_pin(int cpu) {
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set);
+#else
+    (void)cpu;
+    return -1;
+#endif
+}
+
+static int bench_alloc(bench_data *d, size_t n) {
+    memset(d, 0, sizeof(*d));
+    d->n = n;
+    double *p = (double*)malloc(20 * n * sizeof(double));
+    d->la = (long double*)malloc(4 * n * sizeof(long double));
+    if (!p || !d->la) { free(p); free(d->la); return -1; }
+    d->a = p; d->b = p + n; d->c = p + 2 * n; d->r = p + 3 * n;
+    d->al = p + 4 * n; d->bl = p + 5 * n; d->cl = p + 6 * n; d->rl = p + 7 * n;
+    d->qa = p + 8 * n; d->qb = p + 12 * n; d->qr = p + 16 * n;
+    d->lb = d->la + n; d->lc = d->la + 2 * n; d->lr = d->la + 3 * n;
+#if DD_HAVE_FLOAT128
+    d->fa = (__float128*)malloc(4 * n * sizeof(__float128));
+    if (!d->fa) { free(p); free(d->la); return -1; }
+    d->fb = d->fa + n; d->fc = d->fa + 2 * n; d->fr = d->fa + 3 * n;
+#endif
+    // positive operands in [1, 2) with full low words, so div and sqrt
+    // take their ordinary path and nothing overflows or goes subnormal
+    uint64_t x = 0x853C49E6748FEA9Bull;
+    for (size_t i = 0; i < n; i++) {
+        double v[6];
+        for (int k = 0; k < 6; k++) {
+            x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+            v[k] = 1.0 + (double)(x >> 12) / 4503599627370496.0;
+        }
+        dd_real a = { v[0], v[3] * 0x1p-54 }, b = { v[1], v[4] * 0x1p-54 }, c = { v[2], v[5] * 0x1p-54 };
+        d->a[i] = a.hi; d->al[i] = a.lo; d->b[i] = b.hi; d->bl[i] = b.lo; d->c[i] = c.hi; d->cl[i] = c.lo;
+        qd_store(d->qa + 4 * i, qd_from_dd(a));
+        qd_store(d->qb + 4 * i, qd_from_dd(b));
+        d->la[i] = (long double)a.hi + a.lo; d->lb[i] = (long double)b.hi + b.lo;
+        d->lc[i] = (long double)c.hi + c.lo;
+#if DD_HAVE_FLOAT128
+        d->fa[i] = (__float128)a.hi + a.lo; d->fb[i] = (__float128)b.hi + b.lo;
+        d->fc[i] = (__float128)c.hi + c.lo;
+#endif
+    }
+    return 0;
+}
+
+static void bench_free(bench_data *d) {
+    free(d->a);
+    free(d->la);
+#if DD_HAVE_FLOAT128
+    free(d->fa);
+#endif
+}
+
+typedef struct {
+    double min_ns, median_ns, max_ns;   // per element
+    long passes;                        // per sample
+} bench_result;
+
+static bench_result bench_run(const bench_cell *c, bench_data *d, const bench_opts *o, double *samples) {
+    bench_result r;
+    // warmup, growing the passes per sample until one lasts long enough
+    long passes = 1;
+    for (int w = 0;; w++) {
+        double t0 = now_s();
+        for (long p = 0; p < passes; p++) c->fn(d);
+        double dt = now_s() - t0;
+        if (w + 1 >= o->warmup && dt >= BENCH_SAMPLE_S) break;
+        if (dt < BENCH_SAMPLE_S) passes = dt > 0 ? (long)(passes * BENCH_SAMPLE_S / dt) + 1 : passes * 2;
+    }
+    for (int s = 0; s < o->reps; s++) {
+        double t0 = now_s();
+        for (long p = 0; p < passes; p++) c->fn(d);
+        samples[s] = (now_s() - t0) / ((double)passes * (double)d->n) * 1e9;
+    }
+    qsort(samples, (size_t)o->reps, sizeof(double), cmp_double);
+    r.min_ns = samples[0];
+    r.median_ns = o->reps % 2 ? samples[o->reps / 2] : (samples[o->reps / 2 - 1] + samples[o->reps / 2]) / 2;
+    r.max_ns = samples[o->reps - 1];
+    r.passes = passes;
+    return r;
+}
+
+static int bench(const bench_opts *o) {
+    bench_data d;
+    bench_result res[BENCH_CELLS];
+    double *samples = (double*)malloc((size_t)o->reps * sizeof(double));
+    if (!samples || bench_alloc(&d, o->n) != 0) { fprintf(stderr, "allocation failed\n"); free(samples); return 1; }
+    int pinned = o->cpu >= 0 && bench_pin(o->cpu) == 0;
+    if (o->cpu >= 0 && !pinned) fprintf(stderr, "warning: could not pin to CPU %d\n", o->cpu);
+
+    printf("=== Float128 backend timing (%s kernels, n = %zu, %d warmup, %d samples",
+           dd_kernel_isa(), o->n, o->warmup, o->reps);
+    if (pinned) printf(", CPU %d", o->cpu);
+    printf(") ===\n");
+    printf("%-20s %4s %-7s %10s %10s %10s %9s\n", "tier", "bits", "op", "min ns", "median ns", "max ns", "GFLOP/s");
+    for (size_t i = 0; i < BENCH_CELLS; i++) {
+        const bench_cell *c = &bench_cells[i];
+        res[i] = bench_run(c, &d, o, samples);
+        printf("%-20s %4d %-7s %10.3f %10.3f %10.3f %9.3f\n", c->tier, c->bits, bench_op_name[c->op],
+               res[i].min_ns, res[i].median_ns, res[i].max_ns, bench_op_flops[c->op] / res[i].median_ns);
+        fflush(stdout);
+    }
+
+    int rc = 0;
+    if (o->json) {
+        FILE *f = fopen(o->json, "w");
+        if (!f) { perror(o->json); rc = 1; }
+        else {
+            fprintf(f, "{\n  \"tool\": \"float128_benchmark\",\n  \"dd_kernels\": \"%s\",\n", dd_kernel_isa());
+            fprintf(f, "  \"dd_scalar_fma\": %s,\n  \"long_double_bits\": %d,\n  \"float128\": %s,\n",
+                    DD_USE_FMA ? "true" : "false", LDBL_MANT_DIG, DD_HAVE_FLOAT128 ? "true" : "false");
+            fprintf(f, "  \"n\": %zu,\n  \"warmup\": %d,\n  \"samples\": %d,\n  \"cpu\": %d,\n",
+                    o->n, o->warmup, o->reps, pinned ? o->cpu : -1);
+            fprintf(f, "  \"results\": [\n");
+            for (size_t i = 0; i < BENCH_CELLS; i++) {
+                const bench_cell *c = &bench_cells[i];
+                fprintf(f, "    {\"tier\": \"%s\", \"bits\": %d, \"op\": \"%s\", \"flops_per_element\": %d, "
+                        "\"ns_min\": %.4f, \"ns_median\": %.4f, \"ns_max\": %.4f, \"gflops\": %.4f, "
+                        "\"passes_per_sample\": %ld}%s\n",
+                        c->tier, c->bits, bench_op_name[c->op], bench_op_flops[c->op], res[i].min_ns,
+                        res[i].median_ns, res[i].max_ns, bench_op_flops[c->op] / res[i].median_ns,
+                        res[i].passes, i + 1 < BENCH_CELLS ? "," : "");
+            }
+            fprintf(f, "  ]\n}\n");
+            if (fclose(f) != 0) { perror(o->json); rc = 1; }
+            else printf("Wrote %s\n", o->json);
+        }
+    }
+    bench_free(&d);
+    free(samples);
+    return rc;
 }
 
 // ============================================================================
@@ -304,11 +2319,45 @@ double compute_double_double_to_double(double hi, double lo) {
     return dd_to_double(x);
 }
 
+#define DD_UNARY_CALL(name, fn) \
+    void name(double a_hi, double a_lo, double *result_hi, double *result_lo) { \
+        dd_real result = fn((dd_real){a_hi, a_lo}); \
+        *result_hi = result.hi; \
+        *result_lo = result.lo; \
+    }
+DD_UNARY_CALL(compute_double_double_sqrt, dd_sqrt)
+DD_UNARY_CALL(compute_double_double_exp, dd_exp)
+DD_UNARY_CALL(compute_double_double_log, dd_log)
+DD_UNARY_CALL(compute_double_double_sin, dd_sin)
+DD_UNARY_CALL(compute_double_double_cos, dd_cos)
+#undef DD_UNARY_CALL
+
 // ============================================================================
 // Main
 // ============================================================================
 
-int main() {
+int main(int argc, char **argv) {
+    bench_opts bo = { 3, 15, -1, 4096, NULL };
+    int run_bench = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--bench") == 0) run_bench = 1;
+        else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) bo.warmup = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) bo.reps = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--n") == 0 && i + 1 < argc) bo.n = (size_t)strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--cpu") == 0 && i + 1 < argc) bo.cpu = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) bo.json = argv[++i];
+        else {
+            fprintf(stderr, "usage: %s [--bench [--warmup N] [--reps N] [--n N] [--cpu N] [--json FILE]]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    if (bo.reps < 1 || bo.warmup < 0 || bo.n < 1) {
+        fprintf(stderr, "%s: --reps and --n must be positive, --warmup non-negative\n", argv[0]);
+        return 2;
+    }
+    if (run_bench || bo.json) return bench(&bo);
+
     printf("========================================\n");
     printf("Float128 Precision Benchmark\n");
     printf("========================================\n");
@@ -324,6 +2373,11 @@ int main() {
     test_cancellation();
     test_summation();
     test_product();
+    test_batch();
+    test_quad_double();
+    test_reductions();
+    test_elementary();
+    test_gemm();
     
     printf("\n========================================\n");
     printf("Conclusion:\n");
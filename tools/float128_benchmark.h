@@ -5,6 +5,8 @@
 #ifndef FLOAT128_BENCHMARK_H
 #define FLOAT128_BENCHMARK_H
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -20,6 +22,121 @@ void compute_double_double_mul(double a_hi, double a_lo, double b_hi, double b_l
 // Convert double-double to double
 double compute_double_double_to_double(double hi, double lo);
 
+// Elementary functions: result = f(a), within a few units of 2^-106
+// relative (sin/cos: for |a| up to ~2^100). Inputs outside the domain
+// give NaN, and overflow and underflow give inf and 0.
+void compute_double_double_sqrt(double a_hi, double a_lo, double *result_hi, double *result_lo);
+void compute_double_double_exp(double a_hi, double a_lo, double *result_hi, double *result_lo);
+void compute_double_double_log(double a_hi, double a_lo, double *result_hi, double *result_lo);
+void compute_double_double_sin(double a_hi, double a_lo, double *result_hi, double *result_lo);
+void compute_double_double_cos(double a_hi, double a_lo, double *result_hi, double *result_lo);
+
+// Batched double-double over split hi[]/lo[] arrays (SoA), one call per
+// array instead of per element. Vectorized (AVX-512, AVX2, SSE2/NEON)
+// and chosen at load time by CPU feature. Where the CPU has FMA, the
+// kernels compute two_prod's error with it. Each element is bit-identical
+// to the scalar calls above (Dekker and FMA agree bit for bit; see
+// float128_bitcompare).
+// Outputs may alias inputs exactly (in place), not partially.
+
+// out[i] = a[i] + b[i]
+void dd_add_n(size_t n, const double *a_hi, const double *a_lo, const double *b_hi, const double *b_lo,
+              double *out_hi, double *out_lo);
+
+// out[i] = a[i] * b[i]
+void dd_mul_n(size_t n, const double *a_hi, const double *a_lo, const double *b_hi, const double *b_lo,
+              double *out_hi, double *out_lo);
+
+// out[i] = a[i] * b[i] + c[i] (a double-double multiply, then add; not fused)
+void dd_fma_n(size_t n, const double *a_hi, const double *a_lo, const double *b_hi, const double *b_lo,
+              const double *c_hi, const double *c_lo, double *out_hi, double *out_lo);
+
+// Reductions: sum of a[i] * b[i], and sum of x[i]. A NULL lo array means
+// all-zero low parts, i.e. plain doubles accumulated in double-double.
+// Element i goes to accumulator i % 8; the 8 accumulators are combined in
+// a fixed order. The result bits therefore match on every ISA, though not
+// a strictly sequential sum.
+void dd_dot(size_t n, const double *a_hi, const double *a_lo, const double *b_hi, const double *b_lo,
+            double *result_hi, double *result_lo);
+void dd_sum(size_t n, const double *hi, const double *lo, double *result_hi, double *result_lo);
+
+// out[i] = f(a[i]) for the elementary functions above, bit-identical to
+// the compute_double_double_* calls
+void dd_sqrt_n(size_t n, const double *a_hi, const double *a_lo, double *out_hi, double *out_lo);
+void dd_exp_n(size_t n, const double *a_hi, const double *a_lo, double *out_hi, double *out_lo);
+void dd_log_n(size_t n, const double *a_hi, const double *a_lo, double *out_hi, double *out_lo);
+void dd_sin_n(size_t n, const double *a_hi, const double *a_lo, double *out_hi, double *out_lo);
+void dd_cos_n(size_t n, const double *a_hi, const double *a_lo, double *out_hi, double *out_lo);
+
+// Reductions of plain double arrays for production use, multithreaded and
+// bit-reproducible: the same bits for any thread count and kernel set. The
+// input is cut into fixed 65536-element blocks, each reduced over the 8
+// lanes above, and the block results are combined pairwise by block index.
+// threads <= 0 uses every online CPU.
+// - DD_ACC_COMPENSATED: Sum2/Dot2 (Ogita, Rump, Oishi), a running sum plus
+//   a sum of the exact errors per lane; about naive-loop throughput, and
+//   as accurate as summing in twice the precision then rounding, so the
+//   double result holds nearly all 53 bits up to condition numbers ~2^53.
+// - DD_ACC_DOUBLE_DOUBLE: the dd_sum/dd_dot accumulators; about twice the
+//   cost, and carries ~106 bits into far worse conditioned sums.
+// The result is a double-double; result_hi alone is the sum rounded to
+// double (nearly always correctly). norm2 is sqrt(sum of x[i]^2), rescaled
+// by a power of two when the squares would overflow or underflow.
+// Allocation failure returns NaN.
+typedef enum {
+    DD_ACC_COMPENSATED = 0,
+    DD_ACC_DOUBLE_DOUBLE = 1
+} dd_accumulator;
+
+void dd_reduce_sum(size_t n, const double *x, dd_accumulator acc, int threads,
+                   double *result_hi, double *result_lo);
+void dd_reduce_dot(size_t n, const double *a, const double *b, dd_accumulator acc, int threads,
+                   double *result_hi, double *result_lo);
+void dd_reduce_norm2(size_t n, const double *x, dd_accumulator acc, int threads,
+                     double *result_hi, double *result_lo);
+
+// C = A B, with A m x k, B k x n and C m x n, all row-major with leading
+// dimensions lda, ldb and ldc (in elements). A NULL a_lo/b_lo means plain
+// double inputs; c_lo may be NULL to keep only the rounded result. Each
+// element accumulates its k products in index order with the accumulator
+// above (for double-double inputs, DD_ACC_COMPENSATED adds the two cross
+// products a_hi b_lo + a_lo b_hi to the error sum; DD_ACC_DOUBLE_DOUBLE
+// takes full dd_mul products). Cache-blocked, vectorized over columns of C
+// and multithreaded over output tiles, with the same bits as a naive
+// triple loop for any thread count and kernel set. threads <= 0 uses every
+// online CPU. Allocation failure fills C with NaN.
+void dd_gemm(size_t m, size_t n, size_t k, const double *a, const double *a_lo, size_t lda,
+             const double *b, const double *b_lo, size_t ldb, dd_accumulator acc, int threads,
+             double *c_hi, double *c_lo, size_t ldc);
+
+// Kernel set in use: "avx512+fma", "avx2+fma", "neon+fma", "avx512", "avx2",
+// "sse2", "neon" or "scalar"
+const char *dd_kernel_isa(void);
+
+// Batched quad-double (~212 bits), for where 106 bits is not enough. A
+// value is 4 consecutive doubles, largest first, not overlapping; arrays
+// hold n values (4n doubles). Outputs may alias inputs exactly. These run
+// scalar: QD's limb merges branch on the data. float128_benchmark prints
+// the cost per op of each tier (double, double-double, __float128,
+// quad-double).
+
+// out[i] = a[i] + b[i], exact merge then rounding to 4 limbs
+void qd_add_n(size_t n, const double *a, const double *b, double *out);
+
+// out[i] = a[i] * b[i] (QD's sloppy mul: error below 2^-209 relative)
+void qd_mul_n(size_t n, const double *a, const double *b, double *out);
+
+// out[i] = a[i] / b[i]
+void qd_div_n(size_t n, const double *a, const double *b, double *out);
+
+// out[i] = sqrt(a[i]); NaN for a negative leading limb
+void qd_sqrt_n(size_t n, const double *a, double *out);
+
+// Reductions of plain doubles in quad-double, strictly in index order:
+// result[0..4) = sum of a[i] * b[i] (each product exact), and sum of x[i]
+void qd_dot(size_t n, const double *a, const double *b, double *result);
+void qd_sum(size_t n, const double *x, double *result);
+
 #ifdef __cplusplus
 }
 #endif
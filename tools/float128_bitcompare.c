@@ -4,15 +4,31 @@
  * This program compares the bit patterns of double-double arithmetic against
  * C's long double to validate IEEE-754 compliance and precision.
  * 
- * Compile: gcc -std=c11 -o float128_bitcompare float128_bitcompare.c -lm
- * Run: ./float128_bitcompare
+ * It also checks that the FMA two-product used here (and by the FMA kernels
+ * in float128_benchmark.c) is bit-identical to Dekker's split two-product,
+ * the portable C reference, and exits non-zero if any case differs.
+ *
+ * --golden also writes dd_add, dd_mul and two_prod vectors in the binary
+ * format of golden_vectors.h.
+ *
+ * Compile: gcc -std=c11 -o float128_bitcompare float128_bitcompare.c golden_vectors.c -lm
+ * Run: ./float128_bitcompare [--golden FILE]
  */
 
+/* Dekker's algorithm is exact only if every operation rounds separately. */
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+#define _DEFAULT_SOURCE 1   // M_PI and M_E under -std=c11 on glibc
 #include <stdio.h>
 #include <stdint.h>
 #include <string.h>
 #include <math.h>
 #include <float.h>
+#include "golden_vectors.h"
 
 // Double-double representation
 typedef struct {
@@ -66,6 +82,21 @@ dd_real two_prod(double a, double b) {
     return result;
 }
 
+// Two-product by Dekker splitting (no FMA): the C reference of
+// float128_benchmark.c. Exact while a and b split without overflow
+// (|x| < 2^996) and the error term does not underflow.
+#define SPLIT_CONST 134217729.0  // 2^27 + 1
+
+dd_real two_prod_dekker(double a, double b) {
+    double p = a * b;
+    double ta = SPLIT_CONST * a, tb = SPLIT_CONST * b;
+    double a_hi = ta - (ta - a), b_hi = tb - (tb - b);
+    double a_lo = a - a_hi, b_lo = b - b_hi;
+    double e = ((a_hi * b_hi - p) + a_hi * b_lo + a_lo * b_hi) + a_lo * b_lo;
+    dd_real result = {p, e};
+    return result;
+}
+
 // Double-double addition
 dd_real dd_add(dd_real a, dd_real b) {
     dd_real s = two_sum(a.hi, b.hi);
@@ -80,6 +111,104 @@ dd_real dd_mul(dd_real a, dd_real b) {
     return quick_two_sum(p.hi, p.lo);
 }
 
+// float128_benchmark.c's four-product dd_mul with a chosen two-product
+dd_real dd_mul_full(dd_real a, dd_real b, dd_real (*tp)(double, double)) {
+    dd_real r = tp(a.hi, b.hi);
+    r = dd_add(r, tp(a.hi, b.lo));
+    r = dd_add(r, tp(a.lo, b.hi));
+    return dd_add(r, tp(a.lo, b.lo));
+}
+
+static int same_dd(dd_real x, dd_real y) {
+    return memcmp(&x, &y, sizeof(x)) == 0;
+}
+
+// FMA vs Dekker two-product (and full dd_mul) over random operands in the
+// range where Dekker is exact, plus edge patterns. Returns mismatches.
+static long check_fma_vs_dekker(void) {
+    printf("\n\n=== FMA two_prod vs Dekker two_prod (bit-exact) ===\n");
+    uint64_t x = 0x9E3779B97F4A7C15ull;
+    long cases = 0, bad = 0;
+    for (long i = 0; i < 2000000; i++) {
+        double v[4];
+        for (int k = 0; k < 4; k++) {
+            x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+            // mantissa in [1, 2), exponent in [-480, 480], random sign
+            double m = 1.0 + (double)(x >> 12) / 4503599627370496.0;
+            v[k] = ldexp((x & 1) ? -m : m, (int)((x >> 1) % 961) - 480);
+        }
+        dd_real a = two_sum(v[0], ldexp(v[1], -60)), b = two_sum(v[2], ldexp(v[3], -60));
+        dd_real pf = two_prod(v[0], v[2]), pd = two_prod_dekker(v[0], v[2]);
+        dd_real mf = dd_mul_full(a, b, two_prod), md = dd_mul_full(a, b, two_prod_dekker);
+        cases += 2;
+        if (!same_dd(pf, pd)) {
+            if (bad < 5) printf("  two_prod(%a, %a): fma {%a, %a} dekker {%a, %a}\n", v[0], v[2], pf.hi, pf.lo, pd.hi, pd.lo);
+            bad++;
+        }
+        if (!same_dd(mf, md)) {
+            if (bad < 5) printf("  dd_mul({%a,%a}, {%a,%a}) differs\n", a.hi, a.lo, b.hi, b.lo);
+            bad++;
+        }
+    }
+    // Edge patterns: exact products, ulp neighbours of 1, 2^26 +- 1 factors
+    const double edge[] = { 1.0, -1.0, 0.5, 3.0, 1.0 + DBL_EPSILON, 1.0 - DBL_EPSILON / 2,
+                            67108865.0, 67108863.0, 134217729.0, 1.0 / 3.0, M_PI, 1e300, 1e-300 };
+    const int ne = (int)(sizeof(edge) / sizeof(edge[0]));
+    for (int i = 0; i < ne; i++)
+        for (int j = 0; j < ne; j++) {
+            double p = edge[i] * edge[j];
+            if (!isfinite(p) || fabs(p) < 1e-290) continue;   // outside Dekker's exact range
+            cases++;
+            if (!same_dd(two_prod(edge[i], edge[j]), two_prod_dekker(edge[i], edge[j]))) {
+                if (bad < 5) printf("  two_prod(%a, %a) differs\n", edge[i], edge[j]);
+                bad++;
+            }
+        }
+    printf("Cases: %ld, mismatches: %ld\n", cases, bad);
+    printf(bad ? "✗ FMA path is NOT bit-exact with the Dekker reference\n"
+               : "✓ FMA path is bit-exact with the Dekker reference\n");
+    return bad;
+}
+
+static uint64_t dbits(double d) { uint64_t u; memcpy(&u, &d, 8); return u; }
+
+// Binary vectors (golden_vectors.h) on the operands of check_fma_vs_dekker:
+// normalized double-doubles with exponents in [-480, 480]. Returns the
+// record count, or -1 on a write error.
+static long long write_golden(const char *path) {
+    gv_writer *w = gv_create(path, "float128_bitcompare");
+    if (!w) { perror(path); return -1; }
+    const long n = 1L << 18;
+    uint64_t v[6];
+    for (int op = GV_DD_ADD; op <= GV_DD_TWO_PROD; op++) {
+        uint64_t x = 0xD1B54A32D192ED03ull;
+        if (op == GV_DD_TWO_PROD) gv_begin(w, (gv_op)op, 2, 8, 2, 8);
+        else gv_begin(w, (gv_op)op, 4, 8, 2, 8);
+        for (long i = 0; i < n; i++) {
+            double d[4];
+            for (int k = 0; k < 4; k++) {
+                x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+                double m = 1.0 + (double)(x >> 12) / 4503599627370496.0;
+                d[k] = ldexp((x & 1) ? -m : m, (int)((x >> 1) % 961) - 480);
+            }
+            // the sum draws b near a's magnitude every other record, so
+            // cancellation shows up
+            if (op == GV_DD_ADD && i % 2) d[2] = -d[0] * (1.0 + copysign(ldexp(1.0, -40 - (int)(i % 20)), d[3]));
+            dd_real a = two_sum(d[0], ldexp(d[1], -60)), b = two_sum(d[2], ldexp(d[3], -60)), r;
+            if (op == GV_DD_TWO_PROD) {
+                r = two_prod(d[0], d[2]);
+                v[0] = dbits(d[0]); v[1] = dbits(d[2]); v[2] = dbits(r.hi); v[3] = dbits(r.lo);
+            } else {
+                r = op == GV_DD_ADD ? dd_add(a, b) : dd_mul_full(a, b, two_prod);
+                v[0] = dbits(a.hi); v[1] = dbits(a.lo); v[2] = dbits(b.hi); v[3] = dbits(b.lo);
+                v[4] = dbits(r.hi); v[5] = dbits(r.lo);
+            }
+            gv_put(w, v);
+        }
+    }
+    return gv_close(w);
+}
+
 // Create double-double from double
 dd_real dd_from_double(double d) {
     dd_real result = {d, 0.0};
@@ -92,7 +221,13 @@ typedef struct {
     double value;
 } test_case_t;
 
-int main(void) {
+int main(int argc, char **argv) {
+    const char *golden = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--golden") == 0 && i + 1 < argc) golden = argv[++i];
+        else { fprintf(stderr, "usage: %s [--golden FILE]\n", argv[0]); return 2; }
+    }
+
     printf("=== IEEE-754 Bit Pattern Validation ===\n\n");
     printf("System info:\n");
     printf("  sizeof(long double) = %zu bytes\n", sizeof(long double));
@@ -221,6 +356,12 @@ int main(void) {
         printf("  hi: 0x%016llX\n", (unsigned long long)hi_bits);
         printf("  lo: 0x%016llX\n", (unsigned long long)lo_bits);
     }
-    
-    return 0;
+
+    long bad = check_fma_vs_dekker();
+    if (golden) {
+        printf("\n=== Golden Vectors ===\n");
+        long long n = write_golden(golden);
+        if (n < 0 || gv_list(golden) != n) { printf("%s: write failed\n", golden); return 1; }
+    }
+    return bad ? 1 : 0;
 }
@@ -0,0 +1,398 @@
+/**
+ * float16_convert.c - Float16 <-> Float32 conversion, scalar reference and bulk
+ *
+ * Shared library for cinterop:
+ *   gcc -std=c11 -O2 -shared -fPIC -o libfloat16_convert.so float16_convert.c
+ *
+ * f16_to_f32/f32_to_f16 are the reference routines the Kotlin Float16Math
+ * implementation matches bit for bit (formerly private to
+ * float16_spotcheck.c). The bulk entry points declared in float16_convert.h
+ * run hardware conversions where available (F16C vcvtph2ps/vcvtps2ph,
+ * NEON fcvtl/fcvtn) and patch the few lanes where hardware and reference
+ * disagree. Those lanes are NaN payloads, which the reference drops, and
+ * f32 -> f16 results below 2^-14, which the reference flushes to signed
+ * zero instead of rounding to a subnormal. The portable kernel is the same
+ * mapping as integer selects, with no data-dependent branches, so
+ * compilers can vectorize it. float16_spotcheck checks every f16 input
+ * and an f32 sweep against the reference.
+ *
+ * f32_to_f16_sr/f32_to_f16_sr_n round stochastically, with Philox bits
+ * (philox.h) keyed by a seed and the element index. No f16 hardware
+ * rounds that way, so every set runs the portable integer code, compiled
+ * for AVX2 or AVX-512 where the CPU has them.
+ */
+
+#include <string.h>
+#include "cpu_features.h"
+#include "float16_convert.h"
+#include "philox.h"
+
+// ============================================================================
+// Reference conversions
+// ============================================================================
+
+// Convert float16 to float32
+float f16_to_f32(float16_t h) {
+    uint32_t sign = (h >> 15) & 0x1;
+    uint32_t exp = (h >> 10) & 0x1F;
+    uint32_t mant = h & 0x3FF;
+
+    if (exp == 0x1F) {
+        uint32_t f32_exp = 0xFF;
+        uint32_t f32_mant = (mant != 0) ? (1 << 22) : 0;
+        uint32_t bits = (sign << 31) | (f32_exp << 23) | f32_mant;
+        float result;
+        memcpy(&result, &bits, 4);
+        return result;
+    }
+
+    if (exp == 0) {
+        if (mant == 0) {
+            uint32_t bits = sign << 31;
+            float result;
+            memcpy(&result, &bits, 4);
+            return result;
+        }
+        uint32_t m = mant;
+        int e = -14;
+        while ((m & 0x400) == 0) {
+            m <<= 1;
+            e--;
+        }
+        m &= 0x3FF;
+        uint32_t f32_exp = e + 127;
+        uint32_t f32_mant = m << 13;
+        uint32_t bits = (sign << 31) | (f32_exp << 23) | f32_mant;
+        float result;
+        memcpy(&result, &bits, 4);
+        return result;
+    }
+
+    uint32_t f32_exp = exp - 15 + 127;
+    uint32_t f32_mant = mant << 13;
+    uint32_t bits = (sign << 31) | (f32_exp << 23) | f32_mant;
+    float result;
+    memcpy(&result, &bits, 4);
+    return result;
+}
+
+// Convert float32 to float16 with rounding
+float16_t f32_to_f16(float f) {
+    uint32_t bits;
+    memcpy(&bits, &f, 4);
+
+    uint32_t sign = (bits >> 31) & 0x1;
+    uint32_t exp = (bits >> 23) & 0xFF;
+    uint32_t mant = bits & 0x7FFFFF;
+
+    if (exp == 0xFF) {
+        return (sign << 15) | 0x7C00 | ((mant != 0) ? 0x200 : 0);
+    }
+
+    if (exp == 0 && mant == 0) {
+        return sign << 15;
+    }
+
+    int new_exp = (int)exp - 127 + 15;
+
+    if (new_exp >= 31) {
+        return (sign << 15) | 0x7C00;
+    }
+
+    if (new_exp <= 0) {
+        return sign << 15;
+    }
+
+    uint32_t new_mant = mant >> 13;
+    uint32_t round_bit = (mant >> 12) & 1;
+    uint32_t sticky = mant & 0xFFF;
+
+    if (round_bit && (sticky || (new_mant & 1))) {
+        new_mant++;
+        if (new_mant > 0x3FF) {
+            new_mant = 0;
+            new_exp++;
+            if (new_exp >= 31) {
+                return (sign << 15) | 0x7C00;
+            }
+        }
+    }
+
+    return (sign << 15) | (new_exp << 10) | new_mant;
+}
+
+// Convert float32 to float16, rounding stochastically with 32 random bits
+float16_t f32_to_f16_sr(float f, uint32_t rnd) {
+    uint32_t bits;
+    memcpy(&bits, &f, 4);
+
+    uint32_t sign = (bits >> 16) & 0x8000;
+    uint32_t mag = bits & 0x7FFFFFFF;
+
+    if (mag > 0x7F800000) {
+        return sign | 0x7E00;
+    }
+
+    if (mag < 0x38800000) {
+        // Below 2^-14 the neighbours are 0 and 2^-14. |f| / 2^-14 to 24
+        // bits plus 24 random bits: a carry rounds up.
+        float a;
+        memcpy(&a, &mag, 4);
+        uint32_t t = (uint32_t)(a * 0x1p38f);
+        return sign | (((rnd >> 8) + t) >> 24 ? 0x0400 : 0);
+    }
+
+    // Add 13 random bits below the kept mantissa and truncate: a carry
+    // moves into the exponent, and anything at or past 2^16 is infinity
+    uint32_t h = ((mag + (rnd >> 19)) >> 13) - ((127 - 15) << 10);
+    if (h >= 0x7C00) {
+        return sign | 0x7C00;
+    }
+    return sign | h;
+}
+
+// ============================================================================
+// Portable branch-free kernels
+// ============================================================================
+
+// All ones when c holds, else zero
+#define F16_MASK(c) (0u - (uint32_t)(c))
+#define F16_SELECT(c, a, b) (((a) & F16_MASK(c)) | ((b) & ~F16_MASK(c)))
+
+static inline float f16_to_f32_portable(float16_t h) {
+    uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+    uint32_t em = h & 0x7FFF;
+    // Normals: rebias the exponent in place. Subnormals: m * 2^-24 is an
+    // exact int -> float conversion and a power-of-two scale into the f32
+    // normal range, so no f32 denormal arithmetic is involved.
+    uint32_t normal = (em << 13) + ((127 - 15) << 23);
+    float sub_f = (float)(em & 0x3FF) * 0x1p-24f;
+    uint32_t sub;
+    memcpy(&sub, &sub_f, 4);
+    uint32_t special = 0x7F800000u | F16_SELECT(em > 0x7C00, 0x400000u, 0u);
+    uint32_t bits = F16_SELECT(em < 0x400, sub, normal);
+    bits = sign | F16_SELECT(em >= 0x7C00, special, bits);
+    float f;
+    memcpy(&f, &bits, 4);
+    return f;
+}
+
+static inline float16_t f32_to_f16_portable(float f) {
+    uint32_t x;
+    memcpy(&x, &f, 4);
+    uint32_t sign = (x >> 16) & 0x8000;
+    uint32_t a = x & 0x7FFFFFFF;
+    // Round to nearest even at bit 13: a mantissa carry moves into the
+    // exponent, and anything at or past 2^16 clamps to infinity.
+    uint32_t r = ((a + 0xFFF + ((a >> 13) & 1)) >> 13) - ((127 - 15) << 10);
+    uint32_t h = F16_SELECT(r < 0x7C00, r, 0x7C00u);
+    h = F16_SELECT(a < 0x38800000, 0u, h);          // below 2^-14: flush
+    h = F16_SELECT(a > 0x7F800000, 0x7E00u, h);     // NaN: canonical
+    return (float16_t)(sign | h);
+}
+
+CPU_VECTORIZE static void f16_to_f32_n_portable(size_t n, const float16_t *src, float *dst) {
+    for (size_t i = 0; i < n; i++) dst[i] = f16_to_f32_portable(src[i]);
+}
+
+CPU_VECTORIZE static void f32_to_f16_n_portable(size_t n, const float *src, float16_t *dst) {
+    for (size_t i = 0; i < n; i++) dst[i] = f32_to_f16_portable(src[i]);
+}
+
+static inline float16_t f32_to_f16_sr_portable(float f, uint32_t rnd) {
+    uint32_t x;
+    memcpy(&x, &f, 4);
+    uint32_t sign = (x >> 16) & 0x8000;
+    uint32_t a = x & 0x7FFFFFFF;
+    uint32_t r = ((a + (rnd >> 19)) >> 13) - ((127 - 15) << 10);
+    uint32_t h = F16_SELECT(r < 0x7C00, r, 0x7C00u);
+    uint32_t small = F16_SELECT(a < 0x38800000, a, 0u);
+    float af;
+    memcpy(&af, &small, 4);
+    uint32_t t = (uint32_t)(af * 0x1p38f);
+    h = F16_SELECT(a < 0x38800000, (((rnd >> 8) + t) >> 24) << 10, h);
+    h = F16_SELECT(a > 0x7F800000, 0x7E00u, h);
+    return (float16_t)(sign | h);
+}
+
+#define F16_SR_BLOCK 256
+
+// Random bits a block at a time (philox_fill vectorizes over groups of
+// four), then a conversion loop that vectorizes as plain integer code.
+// Also compiled for wider vectors below.
+static inline __attribute__((always_inline)) void f32_to_f16_sr_blocks(size_t n, const float *src, float16_t *dst,
+                                                                       uint64_t seed, uint64_t index) {
+    uint32_t rnd[F16_SR_BLOCK];
+    for (; n && (index & 3); n--, index++) *dst++ = f32_to_f16_sr_portable(*src++, philox_bits(seed, index));
+    for (size_t i = 0; i < n; i += F16_SR_BLOCK) {
+        size_t m = n - i < F16_SR_BLOCK ? n - i : F16_SR_BLOCK;
+        philox_fill(seed, index + i, (m + 3) / 4, rnd);
+        for (size_t j = 0; j < m; j++) dst[i + j] = f32_to_f16_sr_portable(src[i + j], rnd[j]);
+    }
+}
+
+CPU_VECTORIZE static void f32_to_f16_sr_n_portable(size_t n, const float *src, float16_t *dst,
+                                                   uint64_t seed, uint64_t index) {
+    f32_to_f16_sr_blocks(n, src, dst, seed, index);
+}
+
+// ============================================================================
+// Hardware kernels
+// ============================================================================
+
+// -DF16_HW=0 leaves only the portable kernel (to check it on any host)
+#ifndef F16_HW
+#define F16_HW 1
+#endif
+
+#if F16_HW && defined(__GNUC__) && defined(__x86_64__)
+#define F16_HAVE_F16C 1
+#include <immintrin.h>
+
+#define F16C_ATTR __attribute__((target("avx,f16c")))
+
+F16C_ATTR static void f16_to_f32_n_f16c(size_t n, const float16_t *src, float *dst) {
+    const __m256 sign = _mm256_castsi256_ps(_mm256_set1_epi32((int)0x80000000u));
+    const __m256 qnan = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FC00000));
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 v = _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *)(src + i)));
+        __m256 nan = _mm256_cmp_ps(v, v, _CMP_UNORD_Q);
+        v = _mm256_blendv_ps(v, _mm256_or_ps(_mm256_and_ps(v, sign), qnan), nan);
+        _mm256_storeu_ps(dst + i, v);
+    }
+    for (; i < n; i++) dst[i] = f16_to_f32_portable(src[i]);
+}
+
+F16C_ATTR static void f32_to_f16_n_f16c(size_t n, const float *src, float16_t *dst) {
+    const __m256 sign = _mm256_castsi256_ps(_mm256_set1_epi32((int)0x80000000u));
+    const __m256 qnan = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FC00000));
+    const __m256 min_normal = _mm256_set1_ps(0x1p-14f);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 v = _mm256_loadu_ps(src + i);
+        __m256 s = _mm256_and_ps(v, sign);
+        __m256 small = _mm256_cmp_ps(_mm256_andnot_ps(sign, v), min_normal, _CMP_LT_OQ);
+        __m256 nan = _mm256_cmp_ps(v, v, _CMP_UNORD_Q);
+        v = _mm256_blendv_ps(v, s, small);
+        v = _mm256_blendv_ps(v, _mm256_or_ps(s, qnan), nan);
+        // explicit round-to-nearest-even, independent of MXCSR
+        _mm_storeu_si128((__m128i *)(dst + i), _mm256_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT));
+    }
+    for (; i < n; i++) dst[i] = f32_to_f16_portable(src[i]);
+}
+
+// Stochastic rounding is integer work: the portable code on 8 and 16 lanes
+CPU_VECTORIZE __attribute__((target("avx2")))
+static void f32_to_f16_sr_n_avx2(size_t n, const float *src, float16_t *dst, uint64_t seed, uint64_t index) {
+    f32_to_f16_sr_blocks(n, src, dst, seed, index);
+}
+
+CPU_VECTORIZE __attribute__((target("avx512f,avx512bw")))
+static void f32_to_f16_sr_n_avx512(size_t n, const float *src, float16_t *dst, uint64_t seed, uint64_t index) {
+    f32_to_f16_sr_blocks(n, src, dst, seed, index);
+}
+
+#elif F16_HW && defined(__GNUC__) && defined(__aarch64__)
+#define F16_HAVE_NEON 1
+#include <arm_neon.h>
+
+// NaN lanes -> sign | canonical quiet NaN
+static inline uint32x4_t neon_fix_nan(float32x4_t v, uint32x4_t u) {
+    uint32x4_t nan = vmvnq_u32(vceqq_f32(v, v));
+    uint32x4_t q = vorrq_u32(vandq_u32(u, vdupq_n_u32(0x80000000u)), vdupq_n_u32(0x7FC00000));
+    return vbslq_u32(nan, q, u);
+}
+
+static inline float32x4_t neon_widen_fix(float32x4_t v) {
+    return vreinterpretq_f32_u32(neon_fix_nan(v, vreinterpretq_u32_f32(v)));
+}
+
+// Below 2^-14 -> signed zero, NaN -> canonical, before narrowing
+static inline float32x4_t neon_narrow_fix(float32x4_t v) {
+    uint32x4_t u = vreinterpretq_u32_f32(v);
+    uint32x4_t small = vcaltq_f32(v, vdupq_n_f32(0x1p-14f));
+    u = vbslq_u32(small, vandq_u32(u, vdupq_n_u32(0x80000000u)), u);
+    return vreinterpretq_f32_u32(neon_fix_nan(v, u));
+}
+
+static void f16_to_f32_n_neon(size_t n, const float16_t *src, float *dst) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        float16x8_t h = vreinterpretq_f16_u16(vld1q_u16(src + i));
+        vst1q_f32(dst + i, neon_widen_fix(vcvt_f32_f16(vget_low_f16(h))));
+        vst1q_f32(dst + i + 4, neon_widen_fix(vcvt_high_f32_f16(h)));
+    }
+    for (; i < n; i++) dst[i] = f16_to_f32_portable(src[i]);
+}
+
+// fcvtn rounds per FPCR, round-to-nearest-even unless the caller changed it
+static void f32_to_f16_n_neon(size_t n, const float *src, float16_t *dst) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        float16x4_t lo = vcvt_f16_f32(neon_narrow_fix(vld1q_f32(src + i)));
+        float16x8_t h = vcvt_high_f16_f32(lo, neon_narrow_fix(vld1q_f32(src + i + 4)));
+        vst1q_u16(dst + i, vreinterpretq_u16_f16(h));
+    }
+    for (; i < n; i++) dst[i] = f32_to_f16_portable(src[i]);
+}
+#endif
+
+// ============================================================================
+// Dispatch
+// ============================================================================
+
+typedef struct {
+    const char *isa;
+    void (*to_f32)(size_t, const float16_t*, float*);
+    void (*to_f16)(size_t, const float*, float16_t*);
+    void (*to_f16_sr)(size_t, const float*, float16_t*, uint64_t, uint64_t);
+} f16_kernels;
+
+static const f16_kernels f16_kernels_portable =
+    { "portable", f16_to_f32_n_portable, f32_to_f16_n_portable, f32_to_f16_sr_n_portable };
+#if F16_HAVE_F16C
+static const f16_kernels f16_kernels_f16c =
+    { "f16c", f16_to_f32_n_f16c, f32_to_f16_n_f16c, f32_to_f16_sr_n_portable };
+static const f16_kernels f16_kernels_f16c_avx2 =
+    { "f16c+avx2", f16_to_f32_n_f16c, f32_to_f16_n_f16c, f32_to_f16_sr_n_avx2 };
+static const f16_kernels f16_kernels_f16c_avx512 =
+    { "f16c+avx512", f16_to_f32_n_f16c, f32_to_f16_n_f16c, f32_to_f16_sr_n_avx512 };
+#endif
+#if F16_HAVE_NEON
+static const f16_kernels f16_kernels_neon =
+    { "neon", f16_to_f32_n_neon, f32_to_f16_n_neon, f32_to_f16_sr_n_portable };
+#endif
+
+static const f16_kernels *f16_select(void) {
+    const f16_kernels *k = &f16_kernels_portable;
+#if F16_HAVE_F16C
+    if (cpu_has(CPU_F16C)) {
+        k = &f16_kernels_f16c;
+        if (cpu_has(CPU_AVX512F | CPU_AVX512BW)) k = &f16_kernels_f16c_avx512;
+        else if (cpu_has(CPU_AVX2)) k = &f16_kernels_f16c_avx2;
+    }
+#endif
+#if F16_HAVE_NEON
+    if (cpu_has(CPU_NEON)) k = &f16_kernels_neon;    // half-precision fcvt is baseline on aarch64
+#endif
+    return k;
+}
+
+CPU_DISPATCH(f16_kernels, f16, f16_select)
+
+const char *f16_convert_isa(void) {
+    return f16_k()->isa;
+}
+
+void f16_to_f32_n(size_t n, const float16_t *src, float *dst) {
+    f16_k()->to_f32(n, src, dst);
+}
+
+void f32_to_f16_n(size_t n, const float *src, float16_t *dst) {
+    f16_k()->to_f16(n, src, dst);
+}
+
+void f32_to_f16_sr_n(size_t n, const float *src, float16_t *dst, uint64_t seed, uint64_t index) {
+    f16_k()->to_f16_sr(n, src, dst, seed, index);
+}
@@ -0,0 +1,56 @@
+/**
+ * C interop header for Float16 (IEEE-754 binary16) conversion
+ */
+
+#ifndef FLOAT16_CONVERT_H
+#define FLOAT16_CONVERT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef uint16_t float16_t;
+
+// Reference conversions (the Float16Math.kt semantics):
+// - NaN becomes the canonical quiet NaN of the target format, keeping the
+//   sign but not the payload
+// - f32 -> f16 rounds to nearest even, overflows to infinity and flushes
+//   results below the smallest f16 normal (2^-14) to signed zero
+// - f16 subnormals widen exactly
+float f16_to_f32(float16_t h);
+float16_t f32_to_f16(float f);
+
+// Bulk conversions over whole buffers, bit-identical to the reference
+// calls above for every input. Vectorized (F16C on x86-64, NEON on
+// aarch64, branch-free portable code otherwise) and chosen at load time by
+// CPU feature. src and dst must not overlap.
+void f16_to_f32_n(size_t n, const float16_t *src, float *dst);
+void f32_to_f16_n(size_t n, const float *src, float16_t *dst);
+
+// Stochastic rounding: f32 -> f16 rounded down or up at random, with
+// probability in proportion to the distance to each neighbour, so the
+// expected result is the input. The neighbours are those the reference
+// can produce: below 2^-14 they are zero and 2^-14 (no subnormals), and
+// past the largest finite value, infinity. NaN becomes the canonical
+// quiet NaN as in f32_to_f16. rnd supplies the randomness: its top 13
+// bits, or its top 24 below 2^-14.
+float16_t f32_to_f16_sr(float f, uint32_t rnd);
+
+// Bulk stochastic rounding: dst[i] = f32_to_f16_sr(src[i],
+// philox_bits(seed, index + i)) (philox.h), so results depend only on the
+// seed and each element's index, however a buffer is split across calls
+// or threads. src and dst must not overlap.
+void f32_to_f16_sr_n(size_t n, const float *src, float16_t *dst, uint64_t seed, uint64_t index);
+
+// Kernel set in use: "f16c", "neon" or "portable". On x86-64 "+avx2" or
+// "+avx512" after "f16c" names the vector width of stochastic rounding.
+const char *f16_convert_isa(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FLOAT16_CONVERT_H
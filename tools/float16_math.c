@@ -0,0 +1,399 @@
+/**
+ * float16_math.c - Float16 bulk arithmetic, correctly rounded
+ *
+ * Shared library for cinterop (links the conversions it widens and
+ * narrows with):
+ *   gcc -std=c11 -O2 -shared -fPIC -o libfloat16_math.so float16_math.c float16_convert.c
+ *
+ * The entry points declared in float16_math.h are chosen at load time by
+ * CPU feature:
+ *
+ * - avx512fp16: vaddph/vsubph/vmulph/vdivph/vfmadd*ph on 32 lanes, with
+ *   round-to-nearest-even in the instruction. They round once to f16,
+ *   subnormals included; a block with any result of magnitude 0x0001 to
+ *   0x0400 goes through the portable code instead, since the reference
+ *   flushes below 2^-14 and an exact result just under 2^-14 may have
+ *   rounded up to it.
+ * - neon-fp16 (ARMv8.2 FEAT_FP16, checked at run time): the same on 8
+ *   lanes, relying on FPCR's defaults (nearest even, FZ16 clear).
+ * - portable: widen 256-element blocks with f16_to_f32_n, do the f32 op,
+ *   narrow with f32_to_f16_n. An f32 sum, difference, product or quotient
+ *   of f16 values rounded again to f16 is the exact result rounded once
+ *   (24 >= 2 * 11 + 2 bits). fma cannot go that way: a * b is exact in f32
+ *   but the add is not, so the sum is rounded to odd (TwoSum's error
+ *   nudges an inexact sum off an even last bit), which f32_to_f16 then
+ *   rounds correctly.
+ *
+ * The avx512 (AVX-512F), avx2+fma and neon sets run the portable ops with
+ * a vector f16_gemm micro-kernel (8 rows by 32 or 8 columns of f32 FMA);
+ * avx512fp16 and neon-fp16 use the same kernels for f16_gemm.
+ *
+ * NaN results are patched to 0x7E00 in every set. float16_spotcheck checks
+ * each set against f32_to_f16 and an integer fma reference.
+ */
+
+/* TwoSum is only exact when every add is rounded separately, and a * b + c
+ * in the fma lane must not become an fmaf: never contract, whatever
+ * -ffp-contract the build uses. */
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include "cpu_features.h"
+#include "float16_math.h"
+
+enum { F16_ADD, F16_SUB, F16_MUL, F16_DIV, F16_FMA };
+
+// ============================================================================
+// Portable kernels
+// ============================================================================
+
+#define F16M_BLOCK 256
+
+// a * b + c for f16 inputs widened to f32, rounded to odd: every value
+// involved is a multiple of 2^-48 below 2^33, so the product, TwoSum and
+// the one-ulp step are all exact f32 arithmetic.
+static inline float f16m_fma_odd(float a, float b, float c) {
+    float p = a * b;
+    float s = p + c;
+    float v = s - p;
+    float e = (p - (s - v)) + (c - v);
+    uint32_t u, ue;
+    memcpy(&u, &s, 4);
+    memcpy(&ue, &e, 4);
+    // inexact with an even last bit: one ulp toward the exact value
+    // (inf and NaN sums are left alone; their e is NaN)
+    uint32_t step = ((u ^ ue) >> 31) ? 0xFFFFFFFFu : 1u;
+    int adjust = e != 0 && !(u & 1) && (u & 0x7F800000) != 0x7F800000;
+    u += adjust ? step : 0;
+    memcpy(&s, &u, 4);
+    return s;
+}
+
+CPU_VECTORIZE static void f32_op_n(int op, size_t m, const float *a, const float *b,
+                                   const float *c, float *r) {
+    switch (op) {
+    case F16_ADD: for (size_t i = 0; i < m; i++) r[i] = a[i] + b[i]; break;
+    case F16_SUB: for (size_t i = 0; i < m; i++) r[i] = a[i] - b[i]; break;
+    case F16_MUL: for (size_t i = 0; i < m; i++) r[i] = a[i] * b[i]; break;
+    case F16_DIV: for (size_t i = 0; i < m; i++) r[i] = a[i] / b[i]; break;
+    default:      for (size_t i = 0; i < m; i++) r[i] = f16m_fma_odd(a[i], b[i], c[i]); break;
+    }
+}
+
+// c is only read for F16_FMA. Each block is read in full before dst is
+// written, so dst may be one of the inputs.
+static void f16_op_portable(int op, size_t n, const float16_t *a, const float16_t *b,
+                            const float16_t *c, float16_t *dst) {
+    float fa[F16M_BLOCK], fb[F16M_BLOCK], fc[F16M_BLOCK], fr[F16M_BLOCK];
+    for (size_t i = 0; i < n; i += F16M_BLOCK) {
+        size_t m = n - i < F16M_BLOCK ? n - i : F16M_BLOCK;
+        f16_to_f32_n(m, a + i, fa);
+        f16_to_f32_n(m, b + i, fb);
+        if (op == F16_FMA) f16_to_f32_n(m, c + i, fc);
+        f32_op_n(op, m, fa, fb, fc, fr);
+        f32_to_f16_n(m, fr, dst + i);
+        for (size_t j = 0; j < m; j++)
+            if ((dst[i + j] & 0x7FFF) > 0x7C00) dst[i + j] = 0x7E00;
+    }
+}
+
+// GEMM: each element of C adds its k products in index order, one f32
+// rounding per step. A product of two f16 values is exact in f32 (22
+// significand bits, exponents 2^-48 .. 2^32), so a multiply then an add
+// and an FMA give the same bits. Panels are widened to f32 when packed: A
+// in F16G_MR-row blocks, B in strips as wide as the kernel set's register
+// block.
+#define F16G_MR 8           // rows per register block
+#define F16G_MAXW 32        // widest register block, in columns
+#define F16G_MC 64
+#define F16G_NC 256
+#define F16G_KC 256
+
+// kc steps on an F16G_MR x w block of C (row stride ldc), starting from
+// C's values (load) or from zero
+typedef void (*f16g_micro)(size_t kc, const float *ap, const float *bp, float *c, size_t ldc, int load);
+
+CPU_VECTORIZE static void f16g_micro_portable(size_t kc, const float *ap, const float *bp, float *c, size_t ldc,
+                                              int load) {
+    float acc[F16G_MR][8];
+    for (int r = 0; r < F16G_MR; r++)
+        for (int j = 0; j < 8; j++) acc[r][j] = load ? c[r * ldc + j] : 0.0f;
+    for (size_t p = 0; p < kc; p++)
+        for (int r = 0; r < F16G_MR; r++)
+            for (int j = 0; j < 8; j++) acc[r][j] = acc[r][j] + ap[p * F16G_MR + r] * bp[p * 8 + j];
+    for (int r = 0; r < F16G_MR; r++)
+        for (int j = 0; j < 8; j++) c[r * ldc + j] = acc[r][j];
+}
+
+// ============================================================================
+// Hardware kernels
+// ============================================================================
+
+// -DF16_HW=0 leaves only the portable kernels (to check them on any host)
+#ifndef F16_HW
+#define F16_HW 1
+#endif
+
+#if F16_HW && defined(__GNUC__) && defined(__x86_64__)
+#define F16_HAVE_AVX512FP16 1
+#include <immintrin.h>
+
+#define F16_AVX512FP16_ATTR __attribute__((target("avx512f,avx512bw,avx512fp16")))
+// explicit round-to-nearest-even, independent of MXCSR
+#define F16_RNE (_MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)
+
+F16_AVX512FP16_ATTR static void f16_op_avx512fp16(int op, size_t n, const float16_t *a, const float16_t *b,
+                                                  const float16_t *c, float16_t *dst) {
+    const __m512i abs = _mm512_set1_epi16(0x7FFF), inf = _mm512_set1_epi16(0x7C00);
+    const __m512i one = _mm512_set1_epi16(1), min_normal = _mm512_set1_epi16(0x0400);
+    const __m512i qnan = _mm512_set1_epi16(0x7E00);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m512h va = _mm512_castsi512_ph(_mm512_loadu_si512((const void *)(a + i)));
+        __m512h vb = _mm512_castsi512_ph(_mm512_loadu_si512((const void *)(b + i)));
+        __m512h r;
+        switch (op) {
+        case F16_ADD: r = _mm512_add_round_ph(va, vb, F16_RNE); break;
+        case F16_SUB: r = _mm512_sub_round_ph(va, vb, F16_RNE); break;
+        case F16_MUL: r = _mm512_mul_round_ph(va, vb, F16_RNE); break;
+        case F16_DIV: r = _mm512_div_round_ph(va, vb, F16_RNE); break;
+        default:
+            r = _mm512_fmadd_round_ph(va, vb, _mm512_castsi512_ph(_mm512_loadu_si512((const void *)(c + i))),
+                                      F16_RNE);
+            break;
+        }
+        __m512i x = _mm512_castph_si512(r);
+        __m512i mag = _mm512_and_si512(x, abs);
+        // magnitude 1 .. 0x0400: mag - 1 wraps zero out of range
+        if (_mm512_cmplt_epu16_mask(_mm512_sub_epi16(mag, one), min_normal)) {
+            f16_op_portable(op, 32, a + i, b + i, op == F16_FMA ? c + i : NULL, dst + i);
+            continue;
+        }
+        x = _mm512_mask_mov_epi16(x, _mm512_cmpgt_epu16_mask(mag, inf), qnan);
+        _mm512_storeu_si512((void *)(dst + i), x);
+    }
+    f16_op_portable(op, n - i, a + i, b + i, op == F16_FMA ? c + i : NULL, dst + i);
+}
+
+#define F16_AVX512_ATTR __attribute__((target("avx512f")))
+#define F16_AVX2_ATTR __attribute__((target("avx2,fma")))
+
+F16_AVX512_ATTR static void f16g_micro_avx512(size_t kc, const float *ap, const float *bp, float *c, size_t ldc,
+                                              int load) {
+    __m512 acc[F16G_MR][2];
+    for (int r = 0; r < F16G_MR; r++)
+        for (int j = 0; j < 2; j++) acc[r][j] = load ? _mm512_loadu_ps(c + r * ldc + 16 * j) : _mm512_setzero_ps();
+    for (size_t p = 0; p < kc; p++) {
+        __m512 b0 = _mm512_loadu_ps(bp + p * 32), b1 = _mm512_loadu_ps(bp + p * 32 + 16);
+        for (int r = 0; r < F16G_MR; r++) {
+            __m512 a = _mm512_set1_ps(ap[p * F16G_MR + r]);
+            acc[r][0] = _mm512_fmadd_ps(a, b0, acc[r][0]);
+            acc[r][1] = _mm512_fmadd_ps(a, b1, acc[r][1]);
+        }
+    }
+    for (int r = 0; r < F16G_MR; r++)
+        for (int j = 0; j < 2; j++) _mm512_storeu_ps(c + r * ldc + 16 * j, acc[r][j]);
+}
+
+F16_AVX2_ATTR static void f16g_micro_avx2_fma(size_t kc, const float *ap, const float *bp, float *c, size_t ldc,
+                                             int load) {
+    __m256 acc[F16G_MR];
+    for (int r = 0; r < F16G_MR; r++) acc[r] = load ? _mm256_loadu_ps(c + r * ldc) : _mm256_setzero_ps();
+    for (size_t p = 0; p < kc; p++) {
+        __m256 b = _mm256_loadu_ps(bp + p * 8);
+        for (int r = 0; r < F16G_MR; r++) acc[r] = _mm256_fmadd_ps(_mm256_set1_ps(ap[p * F16G_MR + r]), b, acc[r]);
+    }
+    for (int r = 0; r < F16G_MR; r++) _mm256_storeu_ps(c + r * ldc, acc[r]);
+}
+
+#elif F16_HW && defined(__GNUC__) && defined(__aarch64__)
+#define F16_HAVE_NEON_FP16 1
+#include <arm_neon.h>
+
+#define F16_NEON_FP16_ATTR __attribute__((target("arch=armv8.2-a+fp16")))
+
+F16_NEON_FP16_ATTR static void f16_op_neon_fp16(int op, size_t n, const float16_t *a, const float16_t *b,
+                                                const float16_t *c, float16_t *dst) {
+    const uint16x8_t abs = vdupq_n_u16(0x7FFF), inf = vdupq_n_u16(0x7C00);
+    const uint16x8_t one = vdupq_n_u16(1), min_normal = vdupq_n_u16(0x0400);
+    const uint16x8_t qnan = vdupq_n_u16(0x7E00);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        float16x8_t va = vreinterpretq_f16_u16(vld1q_u16(a + i));
+        float16x8_t vb = vreinterpretq_f16_u16(vld1q_u16(b + i));
+        float16x8_t r;
+        switch (op) {
+        case F16_ADD: r = vaddq_f16(va, vb); break;
+        case F16_SUB: r = vsubq_f16(va, vb); break;
+        case F16_MUL: r = vmulq_f16(va, vb); break;
+        case F16_DIV: r = vdivq_f16(va, vb); break;
+        default: r = vfmaq_f16(vreinterpretq_f16_u16(vld1q_u16(c + i)), va, vb); break;
+        }
+        uint16x8_t x = vreinterpretq_u16_f16(r);
+        uint16x8_t mag = vandq_u16(x, abs);
+        if (vmaxvq_u16(vcltq_u16(vsubq_u16(mag, one), min_normal))) {
+            f16_op_portable(op, 8, a + i, b + i, op == F16_FMA ? c + i : NULL, dst + i);
+            continue;
+        }
+        vst1q_u16(dst + i, vbslq_u16(vcgtq_u16(mag, inf), qnan, x));
+    }
+    f16_op_portable(op, n - i, a + i, b + i, op == F16_FMA ? c + i : NULL, dst + i);
+}
+
+static void f16g_micro_neon(size_t kc, const float *ap, const float *bp, float *c, size_t ldc, int load) {
+    float32x4_t acc[F16G_MR][2];
+    for (int r = 0; r < F16G_MR; r++)
+        for (int j = 0; j < 2; j++) acc[r][j] = load ? vld1q_f32(c + r * ldc + 4 * j) : vdupq_n_f32(0.0f);
+    for (size_t p = 0; p < kc; p++) {
+        float32x4_t b0 = vld1q_f32(bp + p * 8), b1 = vld1q_f32(bp + p * 8 + 4);
+        for (int r = 0; r < F16G_MR; r++) {
+            float a = ap[p * F16G_MR + r];
+            acc[r][0] = vfmaq_n_f32(acc[r][0], b0, a);
+            acc[r][1] = vfmaq_n_f32(acc[r][1], b1, a);
+        }
+    }
+    for (int r = 0; r < F16G_MR; r++)
+        for (int j = 0; j < 2; j++) vst1q_f32(c + r * ldc + 4 * j, acc[r][j]);
+}
+#endif
+
+// ============================================================================
+// Dispatch
+// ============================================================================
+
+// The element-wise ops need f16 arithmetic; the GEMM only f32 FMA, so the
+// avx512, avx2+fma and neon sets pair the portable ops with a vector GEMM
+typedef struct {
+    const char *isa;
+    void (*op)(int, size_t, const float16_t*, const float16_t*, const float16_t*, float16_t*);
+    f16g_micro gemm;
+    size_t gemm_w;                  // columns in the gemm register block
+} f16m_kernels;
+
+static const f16m_kernels f16m_kernels_portable = { "portable", f16_op_portable, f16g_micro_portable, 8 };
+#if F16_HAVE_AVX512FP16
+static const f16m_kernels f16m_kernels_avx512fp16 = { "avx512fp16", f16_op_avx512fp16, f16g_micro_avx512, 32 };
+static const f16m_kernels f16m_kernels_avx512 = { "avx512", f16_op_portable, f16g_micro_avx512, 32 };
+static const f16m_kernels f16m_kernels_avx2_fma = { "avx2+fma", f16_op_portable, f16g_micro_avx2_fma, 8 };
+#endif
+#if F16_HAVE_NEON_FP16
+static const f16m_kernels f16m_kernels_neon_fp16 = { "neon-fp16", f16_op_neon_fp16, f16g_micro_neon, 8 };
+static const f16m_kernels f16m_kernels_neon = { "neon", f16_op_portable, f16g_micro_neon, 8 };
+#endif
+
+static const f16m_kernels *f16m_select(void) {
+    const f16m_kernels *k = &f16m_kernels_portable;
+#if F16_HAVE_AVX512FP16
+    if (cpu_has(CPU_AVX512FP16 | CPU_AVX512BW)) k = &f16m_kernels_avx512fp16;
+    else if (cpu_has(CPU_AVX512F)) k = &f16m_kernels_avx512;
+    else if (cpu_has(CPU_AVX2 | CPU_FMA)) k = &f16m_kernels_avx2_fma;
+#endif
+#if F16_HAVE_NEON_FP16
+    if (cpu_has(CPU_NEON)) k = cpu_has(CPU_FP16) ? &f16m_kernels_neon_fp16 : &f16m_kernels_neon;
+#endif
+    return k;
+}
+
+CPU_DISPATCH(f16m_kernels, f16m, f16m_select)
+
+const char *f16_math_isa(void) {
+    return f16m_k()->isa;
+}
+
+void f16_add_n(size_t n, const float16_t *a, const float16_t *b, float16_t *dst) {
+    f16m_k()->op(F16_ADD, n, a, b, NULL, dst);
+}
+
+void f16_sub_n(size_t n, const float16_t *a, const float16_t *b, float16_t *dst) {
+    f16m_k()->op(F16_SUB, n, a, b, NULL, dst);
+}
+
+void f16_mul_n(size_t n, const float16_t *a, const float16_t *b, float16_t *dst) {
+    f16m_k()->op(F16_MUL, n, a, b, NULL, dst);
+}
+
+void f16_div_n(size_t n, const float16_t *a, const float16_t *b, float16_t *dst) {
+    f16m_k()->op(F16_DIV, n, a, b, NULL, dst);
+}
+
+void f16_fma_n(size_t n, const float16_t *a, const float16_t *b, const float16_t *c, float16_t *dst) {
+    f16m_k()->op(F16_FMA, n, a, b, c, dst);
+}
+
+// ============================================================================
+// GEMM driver
+// ============================================================================
+
+// The definition element by element, for when the panels cannot be allocated
+static void f16_gemm_unpacked(size_t m, size_t n, size_t k, const float16_t *a, size_t lda,
+                              const float16_t *b, size_t ldb, float *c, size_t ldc) {
+    for (size_t i = 0; i < m; i++)
+        for (size_t j = 0; j < n; j++) {
+            float acc = 0.0f;
+            for (size_t p = 0; p < k; p++) acc = acc + f16_to_f32(a[i * lda + p]) * f16_to_f32(b[p * ldb + j]);
+            c[i * ldc + j] = acc;
+        }
+}
+
+static void f16_gemm_k(const f16m_kernels *kn, size_t m, size_t n, size_t k, const float16_t *a, size_t lda,
+                       const float16_t *b, size_t ldb, float *c, size_t ldc) {
+    const size_t w = kn->gemm_w;
+    float *ap = (float*)malloc(F16G_MC * F16G_KC * sizeof(float));
+    float *bp = (float*)malloc(F16G_NC * F16G_KC * sizeof(float));
+    if (!ap || !bp || k == 0) {
+        f16_gemm_unpacked(m, n, k, a, lda, b, ldb, c, ldc);
+    } else {
+        float row[F16G_KC > F16G_NC ? F16G_KC : F16G_NC];
+        for (size_t jc = 0; jc < n; jc += F16G_NC) {
+            size_t nc = n - jc < F16G_NC ? n - jc : F16G_NC, np = (nc + w - 1) / w * w;
+            for (size_t pc = 0; pc < k; pc += F16G_KC) {
+                size_t kc = k - pc < F16G_KC ? k - pc : F16G_KC;
+                for (size_t p = 0; p < kc; p++) {
+                    f16_to_f32_n(nc, b + (pc + p) * ldb + jc, row);
+                    for (size_t j = 0; j < np; j++) bp[j / w * w * kc + p * w + j % w] = j < nc ? row[j] : 0.0f;
+                }
+                for (size_t ic = 0; ic < m; ic += F16G_MC) {
+                    size_t mc = m - ic < F16G_MC ? m - ic : F16G_MC, mp = (mc + F16G_MR - 1) / F16G_MR * F16G_MR;
+                    for (size_t i = 0; i < mp; i++) {
+                        if (i < mc) f16_to_f32_n(kc, a + (ic + i) * lda + pc, row);
+                        for (size_t p = 0; p < kc; p++)
+                            ap[i / F16G_MR * F16G_MR * kc + p * F16G_MR + i % F16G_MR] = i < mc ? row[p] : 0.0f;
+                    }
+                    for (size_t jr = 0; jr < np; jr += w)
+                        for (size_t ir = 0; ir < mp; ir += F16G_MR) {
+                            size_t rows = mc - ir < F16G_MR ? mc - ir : F16G_MR, cols = nc - jr < w ? nc - jr : w;
+                            float *ct = c + (ic + ir) * ldc + jc + jr;
+                            if (rows == F16G_MR && cols == w) {
+                                kn->gemm(kc, ap + ir * kc, bp + jr * kc, ct, ldc, pc > 0);
+                                continue;
+                            }
+                            // a ragged edge block runs on a full-size copy
+                            float t[F16G_MR * F16G_MAXW] = {0};
+                            for (size_t r = 0; r < rows && pc > 0; r++) memcpy(t + r * w, ct + r * ldc, cols * sizeof(float));
+                            kn->gemm(kc, ap + ir * kc, bp + jr * kc, t, w, pc > 0);
+                            for (size_t r = 0; r < rows; r++) memcpy(ct + r * ldc, t + r * w, cols * sizeof(float));
+                        }
+                }
+            }
+        }
+    }
+    free(ap);
+    free(bp);
+    for (size_t i = 0; i < m; i++)
+        for (size_t j = 0; j < n; j++) {
+            uint32_t u;
+            memcpy(&u, &c[i * ldc + j], 4);
+            if ((u & 0x7FFFFFFF) > 0x7F800000) u = 0x7FC00000;
+            memcpy(&c[i * ldc + j], &u, 4);
+        }
+}
+
+void f16_gemm(size_t m, size_t n, size_t k, const float16_t *a, size_t lda,
+              const float16_t *b, size_t ldb, float *c, size_t ldc) {
+    f16_gemm_k(f16m_k(), m, n, k, a, lda, b, ldb, c, ldc);
+}
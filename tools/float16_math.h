@@ -0,0 +1,54 @@
+/**
+ * C interop header for Float16 (IEEE-754 binary16) bulk arithmetic
+ */
+
+#ifndef FLOAT16_MATH_H
+#define FLOAT16_MATH_H
+
+#include <stddef.h>
+#include "float16_convert.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Element-wise arithmetic over whole buffers, dst[i] = a[i] op b[i]. Each
+// result is the exact one rounded once, with f32_to_f16's rules: nearest
+// even, overflow to infinity, and signed zero for anything below 2^-14.
+// For add/sub/mul/div that is bit-identical to widening both inputs,
+// doing the f32 op and narrowing with f32_to_f16 (the Float16Math.kt
+// semantics): an f32 result carries enough bits that rounding it again to
+// f16 never differs from rounding the exact result. A NaN result is the
+// positive quiet NaN 0x7E00, as in the golden vectors. dst may be a or b;
+// partial overlap is not allowed.
+void f16_add_n(size_t n, const float16_t *a, const float16_t *b, float16_t *dst);
+void f16_sub_n(size_t n, const float16_t *a, const float16_t *b, float16_t *dst);
+void f16_mul_n(size_t n, const float16_t *a, const float16_t *b, float16_t *dst);
+void f16_div_n(size_t n, const float16_t *a, const float16_t *b, float16_t *dst);
+
+// dst[i] = a[i] * b[i] + c[i] with a single rounding of the exact value,
+// same rules. Not the same as f16_mul_n then f16_add_n, nor as an f32 fmaf
+// narrowed to f16 (that rounds twice).
+void f16_fma_n(size_t n, const float16_t *a, const float16_t *b, const float16_t *c, float16_t *dst);
+
+// C = A B for row-major f16 A (m x k) and B (k x n) into f32 C (m x n),
+// leading dimensions lda, ldb and ldc in elements. Each element of C adds
+// its k products in index order starting from +0, rounding to f32 once
+// per step (each product is exact in f32, so this is fmaf and a multiply
+// then add alike), so every kernel set gives the same bits and a Kotlin
+// loop in the same order can match them. A NaN element is 0x7FC00000.
+// Cache-blocked and vectorized, on the calling thread. C must not overlap
+// A or B.
+void f16_gemm(size_t m, size_t n, size_t k, const float16_t *a, size_t lda,
+              const float16_t *b, size_t ldb, float *c, size_t ldc);
+
+// Kernel set in use: "avx512fp16", "avx512", "avx2+fma", "neon-fp16",
+// "neon" or "portable". The element-wise ops above only use f16 hardware
+// in the avx512fp16 and neon-fp16 sets.
+const char *f16_math_isa(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FLOAT16_MATH_H
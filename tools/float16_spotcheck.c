@@ -1,111 +1,496 @@
 /**
  * float16_spotcheck.c - C reference implementation for Float16 validation
  * 
- * Compile: gcc -std=c11 -o float16_spotcheck float16_spotcheck.c -lm
- * Run: ./float16_spotcheck
+ * Compile: gcc -std=c11 -O2 -pthread -o float16_spotcheck float16_spotcheck.c float16_convert.c float16_math.c \
+ *              golden_vectors.c -lm
+ * Run: ./float16_spotcheck [--exhaustive] [--threads N] [--kotlin-f16 FILE] [--kotlin-f32 FILE]
+ *                          [--golden FILE]
  * 
  * This generates reference test vectors that the Kotlin Float16Math
- * implementation should match exactly (bit-for-bit).
+ * implementation should match exactly (bit-for-bit), then checks the bulk
+ * conversions (stochastic rounding included) in float16_convert.c and
+ * the bulk arithmetic and f16_gemm in float16_math.c against the reference
+ * and exits 1 on any mismatch.
  */
 
+#define _POSIX_C_SOURCE 200809L   // clock_gettime, pread
 #include <stdio.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <math.h>
 #include <string.h>
+#include <time.h>
+#include "float16_convert.h"
+#include "float16_math.h"
+#include "golden_vectors.h"
+#include "spotcheck_sweep.h"
 
-typedef uint16_t float16_t;
+static uint32_t f32_bits(float f) { uint32_t u; memcpy(&u, &f, 4); return u; }
+static float bits_f32(uint32_t u) { float f; memcpy(&f, &u, 4); return f; }
 
-// Convert float16 to float32
-float f16_to_f32(float16_t h) {
-    uint32_t sign = (h >> 15) & 0x1;
-    uint32_t exp = (h >> 10) & 0x1F;
-    uint32_t mant = h & 0x3FF;
-    
-    if (exp == 0x1F) {
-        uint32_t f32_exp = 0xFF;
-        uint32_t f32_mant = (mant != 0) ? (1 << 22) : 0;
-        uint32_t bits = (sign << 31) | (f32_exp << 23) | f32_mant;
-        float result;
-        memcpy(&result, &bits, 4);
-        return result;
+// Bulk conversions vs the reference: every f16 input, and f32 inputs
+// covering every sign/exponent with all 2^13 rounding tails (random upper
+// mantissa bits), plus edges. The exhaustive mode checks all 2^32 f32
+// inputs across threads, and Kotlin-exported tables if given (see
+// spotcheck_sweep.h). Returns the number of mismatching inputs.
+static size_t check_bulk(const sweep_opts *o) {
+    printf("\n=== Bulk Conversion (%s) ===\n", f16_convert_isa());
+    const size_t chunk = 1u << 20;
+    float16_t *h = malloc(chunk * sizeof(*h)), *h2 = malloc(chunk * sizeof(*h2));
+    float *f = malloc(chunk * sizeof(*f));
+    if (!h || !h2 || !f) { printf("  (allocation failed)\n"); exit(1); }
+
+    size_t bad = sweep_widen("f16 -> f32", f16_to_f32, f16_to_f32_n, o->kotlin_widen);
+
+    if (o->exhaustive) {
+        bad += sweep_narrow("f32 -> f16", f32_to_f16, f32_to_f16_n, o->threads, o->kotlin_narrow);
+    } else {
+        size_t bad16 = 0, checked = 0;
+        uint64_t x = 88172645463325252ull;
+        uint64_t total = 512ull * 8192 + 64;
+        for (uint64_t base = 0; base < total; base += chunk) {
+            size_t m = (size_t)(total - base < chunk ? total - base : chunk);
+            for (size_t j = 0; j < m; j++) {
+                uint64_t k = base + j;
+                uint32_t u;
+                if (k < 512ull * 8192) {
+                    x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+                    u = (uint32_t)(k >> 13) << 23 | ((uint32_t)x & 0x7FE000) | (uint32_t)(k & 0x1FFF);
+                } else {
+                    // around the flush threshold, the overflow edge, inf and NaN
+                    static const uint32_t edge[16] = {
+                        0x387FFFFF, 0x38800000, 0x387FF000, 0x38801000,
+                        0x477FEFFF, 0x477FF000, 0x477FFFFF, 0x47800000,
+                        0x7F800000, 0x7F800001, 0x7FC00000, 0x7FFFFFFF,
+                        0x00000001, 0x007FFFFF, 0x33800000, 0x3F800000 };
+                    u = edge[(k - 512ull * 8192) % 16] | (uint32_t)((k - 512ull * 8192) / 16 % 2) << 31;
+                }
+                f[j] = bits_f32(u);
+            }
+            f32_to_f16_n(m, f, h);
+            for (size_t j = 0; j < m; j++) h2[j] = f32_to_f16(f[j]);
+            for (size_t j = 0; j < m; j++) {
+                if (h[j] != h2[j] && bad16++ < 8)
+                    printf("  f32 0x%08X -> 0x%04X, reference 0x%04X\n", f32_bits(f[j]), h[j], h2[j]);
+            }
+            checked += m;
+        }
+        printf("f32 -> f16: %zu inputs, %zu mismatches\n", checked, bad16);
+        bad += bad16;
     }
-    
-    if (exp == 0) {
-        if (mant == 0) {
-            uint32_t bits = sign << 31;
-            float result;
-            memcpy(&result, &bits, 4);
-            return result;
+
+    // Throughput on a buffer larger than L2
+    const size_t n = chunk;
+    for (size_t j = 0; j < n; j++) f[j] = bits_f32(0x38800000 + (uint32_t)(j * 2654435761u % 0x0F000000));
+    const int reps = 50;
+    double t0 = sweep_now_s();
+    for (int r = 0; r < reps; r++) f32_to_f16_n(n, f, h);
+    double t_narrow = (sweep_now_s() - t0) / reps;
+    t0 = sweep_now_s();
+    for (int r = 0; r < reps; r++) f16_to_f32_n(n, h, f);
+    double t_widen = (sweep_now_s() - t0) / reps;
+    t0 = sweep_now_s();
+    for (size_t j = 0; j < n; j++) h2[j] = f32_to_f16(f[j]);
+    double t_ref = sweep_now_s() - t0;
+    printf("f32 -> f16: %.2f ns/elem (%.1f GB/s), reference scalar %.2f ns/elem\n",
+           t_narrow / n * 1e9, 6.0 * n / t_narrow * 1e-9, t_ref / n * 1e9);
+    printf("f16 -> f32: %.2f ns/elem (%.1f GB/s)\n", t_widen / n * 1e9, 6.0 * n / t_widen * 1e-9);
+
+    free(h); free(h2); free(f);
+    return bad;
+}
+
+// ============================================================================
+// Bulk arithmetic
+// ============================================================================
+
+enum { OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_FMA, OP_COUNT };
+static const char *const op_name[OP_COUNT] = { "add", "sub", "mul", "div", "fma" };
+
+// Zeros, subnormals, the smallest normal, around 1, the largest finite,
+// infinities and NaNs
+static const float16_t edge16[] = {
+    0x0000, 0x8000, 0x0001, 0x8001, 0x03FF, 0x0400, 0x3BFF, 0x3C00, 0x3C01, 0xBC00,
+    0x4000, 0x3555, 0x7BFF, 0xFBFF, 0x7C00, 0xFC00, 0x7C01, 0x7E00, 0xFE00, 0x7FFF };
+#define EDGE16_N (sizeof(edge16) / sizeof(edge16[0]))
+
+// Widen, f32 op, narrow, NaN as 0x7E00: the Float16Math.kt semantics
+static float16_t ref_binary(int op, float a, float b) {
+    float r = op == OP_ADD ? a + b : op == OP_SUB ? a - b : op == OP_MUL ? a * b : a / b;
+    return isnan(r) ? 0x7E00 : f32_to_f16(r);
+}
+
+// |h| = significand * 2^e, e >= -24
+static uint32_t f16_sig(float16_t h, int *e) {
+    uint32_t exp = h >> 10 & 0x1F, m = h & 0x3FF;
+    *e = exp ? (int)exp - 25 : -24;
+    return exp ? m | 0x400 : m;
+}
+
+// a * b + c rounded once with f32_to_f16's rules, in integers: the exact
+// value is a multiple of 2^-48 below 2^33, which fits an __int128.
+static float16_t ref_fma(float16_t a, float16_t b, float16_t c) {
+    if ((a & 0x7C00) == 0x7C00 || (b & 0x7C00) == 0x7C00 || (c & 0x7C00) == 0x7C00) {
+        // an infinity or NaN decides the result; finite parts only matter
+        // for its sign, which the f32 ops get right
+        float r = f16_to_f32(a) * f16_to_f32(b) + f16_to_f32(c);
+        return isnan(r) ? 0x7E00 : f32_to_f16(r);
+    }
+    int ea, eb, ec;
+    uint32_t ma = f16_sig(a, &ea), mb = f16_sig(b, &eb), mc = f16_sig(c, &ec);
+    __int128 p = (__int128)(ma * mb) << (ea + eb + 48);
+    __int128 q = (__int128)mc << (ec + 48);
+    int sp = (a ^ b) >> 15, sc = c >> 15;
+    __int128 s = (sp ? -p : p) + (sc ? -q : q);
+    if (s == 0) return p == 0 && q == 0 && sp && sc ? 0x8000 : 0;
+    float16_t sign = s < 0 ? 0x8000 : 0;
+    unsigned __int128 mag = (unsigned __int128)(s < 0 ? -s : s);
+    if (mag < (unsigned __int128)1 << 34) return sign;     // below 2^-14: flush
+    int len = 35;
+    while (len < 128 && (mag >> len)) len++;
+    int e = len - 1 - 48, shift = len - 11;
+    uint32_t sig = (uint32_t)(mag >> shift);
+    unsigned __int128 rem = mag - ((unsigned __int128)sig << shift), half = (unsigned __int128)1 << (shift - 1);
+    if (rem > half || (rem == half && (sig & 1))) sig++;
+    if (sig == 2048) { sig = 1024; e++; }
+    if (e > 15) return sign | 0x7C00;
+    return (float16_t)(sign | (uint32_t)(e + 15) << 10 | (sig - 1024));
+}
+
+static float16_t ref_op(int op, float16_t a, float16_t b, float16_t c) {
+    return op == OP_FMA ? ref_fma(a, b, c) : ref_binary(op, f16_to_f32(a), f16_to_f32(b));
+}
+
+static void bulk_op(int op, size_t n, const float16_t *a, const float16_t *b, const float16_t *c, float16_t *dst) {
+    switch (op) {
+    case OP_ADD: f16_add_n(n, a, b, dst); break;
+    case OP_SUB: f16_sub_n(n, a, b, dst); break;
+    case OP_MUL: f16_mul_n(n, a, b, dst); break;
+    case OP_DIV: f16_div_n(n, a, b, dst); break;
+    default:     f16_fma_n(n, a, b, c, dst); break;
+    }
+}
+
+static uint64_t xorshift(uint64_t *x) {
+    *x ^= *x << 13; *x ^= *x >> 7; *x ^= *x << 17;
+    return *x;
+}
+
+// Input k of op's test set: random operands, then operands aimed at the
+// flush threshold (near-cancelling sums, products and quotients of
+// magnitude about 2^-14, a * b + c with c close to -a * b), then every
+// pair or triple of edge values.
+static void arith_input(int op, uint64_t k, uint64_t n_random, uint64_t *x, float16_t v[3]) {
+    if (k >= n_random) {
+        k -= n_random;
+        v[0] = edge16[k % EDGE16_N];
+        v[1] = edge16[k / EDGE16_N % EDGE16_N];
+        v[2] = edge16[k / EDGE16_N / EDGE16_N % EDGE16_N];
+        return;
+    }
+    uint64_t r = xorshift(x);
+    v[0] = (float16_t)r; v[1] = (float16_t)(r >> 16); v[2] = (float16_t)(r >> 32);
+    if (k % 2 == 0) return;
+    int d = (int)(r >> 48 & 7) - 3;
+    int ea = v[0] >> 10 & 0x1F, eb = -1;
+    switch (op) {
+    case OP_ADD: v[1] = (float16_t)((v[0] ^ 0x8000) + d); break;
+    case OP_SUB: v[1] = (float16_t)(v[0] + d); break;
+    case OP_MUL: eb = 16 - ea + d; break;
+    case OP_DIV: eb = ea + 14 + d; break;
+    default: {
+        float16_t p = f32_to_f16(-(f16_to_f32(v[0]) * f16_to_f32(v[1])));
+        if ((p & 0x7FFF) < 0x7C00) v[2] = (float16_t)(p + d);
+        break;
+    }
+    }
+    if (eb >= 0) v[1] = (float16_t)((v[1] & 0x83FF) | (uint32_t)(eb < 30 ? eb : 30) << 10);
+}
+
+typedef struct {
+    int op;
+    uint32_t lo, hi;            // first operands [lo, hi)
+    const float *widened;       // f16_to_f32 of every f16
+    size_t bad;
+    int nmiss;
+    uint32_t miss[SWEEP_SHOW][4];
+    int threaded;
+} arith_job;
+
+// Every b for each first operand a in [lo, hi)
+static void *arith_worker(void *arg) {
+    arith_job *j = (arith_job *)arg;
+    float16_t *a = malloc(65536 * sizeof(*a)), *b = malloc(65536 * sizeof(*b)), *r = malloc(65536 * sizeof(*r));
+    if (!a || !b || !r) { printf("  (allocation failed)\n"); exit(1); }
+    for (uint32_t i = 0; i < 65536; i++) b[i] = (float16_t)i;
+    for (uint32_t ha = j->lo; ha < j->hi; ha++) {
+        for (uint32_t i = 0; i < 65536; i++) a[i] = (float16_t)ha;
+        bulk_op(j->op, 65536, a, b, NULL, r);
+        float fa = j->widened[ha];
+        for (uint32_t i = 0; i < 65536; i++) {
+            float16_t want = ref_binary(j->op, fa, j->widened[i]);
+            if (r[i] != want) {
+                if (j->nmiss < SWEEP_SHOW) {
+                    uint32_t *m = j->miss[j->nmiss++];
+                    m[0] = ha; m[1] = i; m[2] = want; m[3] = r[i];
+                }
+                j->bad++;
+            }
+        }
+    }
+    free(a); free(b); free(r);
+    return NULL;
+}
+
+// All 2^32 pairs of one binary op on `threads` threads
+static size_t sweep_arith(int op, int threads, const float *widened) {
+    if (threads < 1) threads = 1;
+    arith_job *jobs = calloc((size_t)threads, sizeof(*jobs));
+    pthread_t *tid = calloc((size_t)threads, sizeof(*tid));
+    if (!jobs || !tid) { printf("  (allocation failed)\n"); exit(1); }
+    double t0 = sweep_now_s();
+    uint32_t slice = (65536 + (uint32_t)threads - 1) / (uint32_t)threads;
+    for (int t = 0; t < threads; t++) {
+        arith_job *j = &jobs[t];
+        j->op = op; j->widened = widened;
+        j->lo = (uint32_t)t * slice < 65536 ? (uint32_t)t * slice : 65536;
+        j->hi = j->lo + slice < 65536 ? j->lo + slice : 65536;
+        j->threaded = pthread_create(&tid[t], NULL, arith_worker, j) == 0;
+        if (!j->threaded) arith_worker(j);
+    }
+    for (int t = 0; t < threads; t++)
+        if (jobs[t].threaded) pthread_join(tid[t], NULL);
+    double dt = sweep_now_s() - t0;
+    size_t bad = 0;
+    int shown = 0;
+    for (int t = 0; t < threads; t++) {
+        for (int i = 0; i < jobs[t].nmiss && shown < SWEEP_SHOW; i++, shown++)
+            printf("  %s 0x%04X 0x%04X -> reference 0x%04X, bulk 0x%04X\n", op_name[op],
+                   jobs[t].miss[i][0], jobs[t].miss[i][1], jobs[t].miss[i][2], jobs[t].miss[i][3]);
+        bad += jobs[t].bad;
+    }
+    printf("%s: all 4294967296 pairs, %zu mismatches; %d threads, %.2f s\n", op_name[op], bad, threads, dt);
+    free(jobs); free(tid);
+    return bad;
+}
+
+// Bulk arithmetic vs the reference: add/sub/mul/div against widen, f32 op,
+// f32_to_f16; fma against the integer ref_fma. Each op runs on 2^20
+// generated inputs plus all edge combinations, once out of place in one
+// call and once in place in pieces of 1 to 67 elements (the kernels'
+// tails). The exhaustive mode adds every pair for the binary ops.
+// Returns the number of mismatching results.
+static size_t check_arith(const sweep_opts *o) {
+    printf("\n=== Bulk Arithmetic (%s) ===\n", f16_math_isa());
+    const uint64_t n_random = 1u << 20;
+    const size_t cap = n_random + EDGE16_N * EDGE16_N * EDGE16_N;
+    float16_t *a = malloc(cap * sizeof(*a)), *b = malloc(cap * sizeof(*b)), *c = malloc(cap * sizeof(*c));
+    float16_t *r = malloc(cap * sizeof(*r)), *r2 = malloc(cap * sizeof(*r2)), *want = malloc(cap * sizeof(*want));
+    if (!a || !b || !c || !r || !r2 || !want) { printf("  (allocation failed)\n"); exit(1); }
+
+    size_t bad = 0;
+    for (int op = 0; op < OP_COUNT; op++) {
+        size_t n = (size_t)n_random + (op == OP_FMA ? EDGE16_N * EDGE16_N * EDGE16_N : EDGE16_N * EDGE16_N);
+        uint64_t x = 0x9E3779B97F4A7C15ull + (uint64_t)op;
+        for (size_t k = 0; k < n; k++) {
+            float16_t v[3];
+            arith_input(op, k, n_random, &x, v);
+            a[k] = v[0]; b[k] = v[1]; c[k] = v[2];
+            want[k] = ref_op(op, v[0], v[1], v[2]);
+        }
+        bulk_op(op, n, a, b, c, r);
+        // in place: the result overwrites the first operand
+        memcpy(r2, a, n * sizeof(*r2));
+        for (size_t k = 0, piece = 1; k < n; k += piece, piece = piece % 67 + 1) {
+            size_t m = n - k < piece ? n - k : piece;
+            bulk_op(op, m, r2 + k, b + k, c + k, r2 + k);
         }
-        uint32_t m = mant;
-        int e = -14;
-        while ((m & 0x400) == 0) {
-            m <<= 1;
-            e--;
+        size_t bad_op = 0;
+        for (size_t k = 0; k < n; k++) {
+            if (r[k] == want[k] && r2[k] == want[k]) continue;
+            if (bad_op++ < SWEEP_SHOW) {
+                printf("  %s 0x%04X 0x%04X", op_name[op], a[k], b[k]);
+                if (op == OP_FMA) printf(" 0x%04X", c[k]);
+                printf(" -> reference 0x%04X, bulk 0x%04X, in place 0x%04X\n", want[k], r[k], r2[k]);
+            }
         }
-        m &= 0x3FF;
-        uint32_t f32_exp = e + 127;
-        uint32_t f32_mant = m << 13;
-        uint32_t bits = (sign << 31) | (f32_exp << 23) | f32_mant;
-        float result;
-        memcpy(&result, &bits, 4);
-        return result;
+        printf("%s: %zu inputs, %zu mismatches\n", op_name[op], n, bad_op);
+        bad += bad_op;
     }
-    
-    uint32_t f32_exp = exp - 15 + 127;
-    uint32_t f32_mant = mant << 13;
-    uint32_t bits = (sign << 31) | (f32_exp << 23) | f32_mant;
-    float result;
-    memcpy(&result, &bits, 4);
-    return result;
-}
-
-// Convert float32 to float16 with rounding
-float16_t f32_to_f16(float f) {
-    uint32_t bits;
-    memcpy(&bits, &f, 4);
-    
-    uint32_t sign = (bits >> 31) & 0x1;
-    uint32_t exp = (bits >> 23) & 0xFF;
-    uint32_t mant = bits & 0x7FFFFF;
-    
-    if (exp == 0xFF) {
-        return (sign << 15) | 0x7C00 | ((mant != 0) ? 0x200 : 0);
+
+    if (o->exhaustive) {
+        float *widened = malloc(65536 * sizeof(*widened));
+        if (!widened) { printf("  (allocation failed)\n"); exit(1); }
+        for (uint32_t i = 0; i < 65536; i++) widened[i] = f16_to_f32((float16_t)i);
+        for (int op = OP_ADD; op <= OP_DIV; op++) bad += sweep_arith(op, o->threads, widened);
+        free(widened);
     }
-    
-    if (exp == 0 && mant == 0) {
-        return sign << 15;
+
+    // Throughput on operands of magnitude 1/4 to 8 (no result near the
+    // flush threshold), against the scalar reference
+    const size_t n = 1u << 20;
+    uint64_t x = 0x2545F4914F6CDD1Dull;
+    for (size_t k = 0; k < n; k++) {
+        uint64_t v = xorshift(&x);
+        a[k] = (float16_t)((v & 0x83FF) | (13 + v % 5) << 10);
+        b[k] = (float16_t)((v >> 16 & 0x83FF) | (13 + (v >> 16) % 5) << 10);
+        c[k] = (float16_t)((v >> 32 & 0x83FF) | (13 + (v >> 32) % 5) << 10);
     }
-    
-    int new_exp = (int)exp - 127 + 15;
-    
-    if (new_exp >= 31) {
-        return (sign << 15) | 0x7C00;
+    const int reps = 20;
+    for (int op = 0; op < OP_COUNT; op++) {
+        double t0 = sweep_now_s();
+        for (int rep = 0; rep < reps; rep++) bulk_op(op, n, a, b, c, r);
+        double t_bulk = (sweep_now_s() - t0) / reps;
+        t0 = sweep_now_s();
+        for (size_t k = 0; k < n; k++) r2[k] = ref_op(op, a[k], b[k], c[k]);
+        double t_ref = sweep_now_s() - t0;
+        printf("%s: %.2f ns/elem, reference scalar %.2f ns/elem\n", op_name[op], t_bulk / n * 1e9, t_ref / n * 1e9);
     }
-    
-    if (new_exp <= 0) {
-        return sign << 15;
+
+    free(a); free(b); free(c); free(r); free(r2); free(want);
+    return bad;
+}
+
+// One element of f16_gemm: the k products in index order, fmaf per step
+static float ref_gemm(size_t k, const float16_t *a, const float16_t *b, size_t ldb) {
+    float acc = 0.0f;
+    for (size_t p = 0; p < k; p++) acc = fmaf(f16_to_f32(a[p]), f16_to_f32(b[p * ldb]), acc);
+    return isnan(acc) ? bits_f32(0x7FC00000) : acc;
+}
+
+static size_t gemm_mismatches(size_t m, size_t n, size_t k, const float16_t *a, size_t lda,
+                              const float16_t *b, size_t ldb, const float *c, size_t ldc) {
+    size_t bad = 0;
+    for (size_t i = 0; i < m; i++)
+        for (size_t j = 0; j < n; j++) {
+            float want = ref_gemm(k, a + i * lda, b + j, ldb), got = c[i * ldc + j];
+            if (f32_bits(got) != f32_bits(want) && bad++ < 8)
+                printf("  gemm %zux%zux%zu C[%zu][%zu]: 0x%08X, reference 0x%08X\n",
+                       m, n, k, i, j, f32_bits(got), f32_bits(want));
+        }
+    return bad;
+}
+
+// Random f16 of magnitude about 1/4 to 8 (mode 0), any finite value
+// (mode 1) or subnormal to 2^-10 (mode 2)
+static float16_t rand_f16(int mode, uint64_t *x) {
+    uint64_t v = xorshift(x);
+    switch (mode) {
+    case 0:  return (float16_t)((v & 0x83FF) | (13 + v % 5) << 10);
+    case 1:  return (float16_t)((v & 0x83FF) | (v >> 16) % 31 << 10);
+    default: return (float16_t)((v & 0x83FF) | (v >> 16) % 6 << 10);
     }
-    
-    uint32_t new_mant = mant >> 13;
-    uint32_t round_bit = (mant >> 12) & 1;
-    uint32_t sticky = mant & 0xFFF;
-    
-    if (round_bit && (sticky || (new_mant & 1))) {
-        new_mant++;
-        if (new_mant > 0x3FF) {
-            new_mant = 0;
-            new_exp++;
-            if (new_exp >= 31) {
-                return (sign << 15) | 0x7C00;
+}
+
+// f16_gemm against ref_gemm: tiny and empty shapes, then 70 x 300 x 301
+// (ragged register blocks, two column panels, two k panels, leading
+// dimensions wider than the matrices) for each rand_f16 range, with a few
+// infinities and NaNs. Then the throughput. Returns the number of
+// mismatches.
+static size_t check_gemm(void) {
+    printf("\n=== GEMM (%s) ===\n", f16_math_isa());
+    const size_t m = 70, n = 300, k = 301, lda = k + 3, ldb = n + 5, ldc = n + 1, big = 512;
+    float16_t *a = malloc(big * big * sizeof(*a)), *b = malloc(big * big * sizeof(*b));
+    float *c = malloc(big * big * sizeof(*c));
+    if (!a || !b || !c) { printf("  (allocation failed)\n"); exit(1); }
+    uint64_t x = 0x9E3779B97F4A7C15ull;
+    size_t bad = 0, checked = 0;
+
+    static const size_t shapes[][3] = { {1, 1, 1}, {3, 17, 1}, {9, 33, 2}, {8, 32, 0}, {5, 7, 3}, {16, 64, 40} };
+    for (size_t s = 0; s < sizeof(shapes) / sizeof(shapes[0]); s++) {
+        size_t sm = shapes[s][0], sn = shapes[s][1], sk = shapes[s][2];
+        for (size_t i = 0; i < sm * sk; i++) a[i] = rand_f16(0, &x);
+        for (size_t i = 0; i < sk * sn; i++) b[i] = rand_f16(0, &x);
+        f16_gemm(sm, sn, sk, a, sk, b, sn, c, sn);
+        bad += gemm_mismatches(sm, sn, sk, a, sk, b, sn, c, sn);
+        checked += sm * sn;
+    }
+    static const float16_t special[] = { 0x7C00, 0xFC00, 0x7E00, 0x0001, 0x8000 };
+    for (int mode = 0; mode < 3; mode++) {
+        for (size_t i = 0; i < m * lda; i++)
+            a[i] = xorshift(&x) % 4096 ? rand_f16(mode, &x) : special[xorshift(&x) % 5];
+        for (size_t i = 0; i < k * ldb; i++)
+            b[i] = xorshift(&x) % 4096 ? rand_f16(mode, &x) : special[xorshift(&x) % 5];
+        f16_gemm(m, n, k, a, lda, b, ldb, c, ldc);
+        bad += gemm_mismatches(m, n, k, a, lda, b, ldb, c, ldc);
+        checked += m * n;
+    }
+    printf("f16_gemm: %zu elements, %zu mismatches\n", checked, bad);
+
+    for (size_t i = 0; i < big * big; i++) { a[i] = rand_f16(0, &x); b[i] = rand_f16(0, &x); }
+    f16_gemm(big, big, big, a, big, b, big, c, big);
+    const int reps = 5;
+    double t0 = sweep_now_s();
+    for (int r = 0; r < reps; r++) f16_gemm(big, big, big, a, big, b, big, c, big);
+    double t = (sweep_now_s() - t0) / reps;
+    t0 = sweep_now_s();
+    volatile float sink = 0;
+    for (size_t j = 0; j < 64; j++) sink += ref_gemm(big, a, b + j, big);
+    double t_ref = (sweep_now_s() - t0) / (64.0 * big);
+    printf("f16_gemm %zu x %zu x %zu: %.1f GFLOP/s, reference %.1f ns per multiply-add\n",
+           big, big, big, 2.0 * big * big * big / t * 1e-9, t_ref * 1e9);
+    free(a); free(b); free(c);
+    return bad;
+}
+
+// Binary vectors (golden_vectors.h): every f16 input, every f32 rounding
+// tail at every sign/exponent, the four ops on random pairs plus all
+// pairs of edge values, and fma on check_arith's inputs (random and
+// near-cancelling triples, all edge triples). Returns the record count, or
+// -1 on a write error.
+static long long write_golden(const char *path) {
+    gv_writer *w = gv_create(path, "float16_spotcheck");
+    if (!w) { perror(path); return -1; }
+    uint64_t v[3];
+
+    gv_begin(w, GV_F16_TO_F32, 1, 2, 1, 4);
+    for (uint32_t i = 0; i < 65536; i++) {
+        v[0] = i; v[1] = f32_bits(f16_to_f32((float16_t)i));
+        gv_put(w, v);
+    }
+
+    gv_begin(w, GV_F32_TO_F16, 1, 4, 1, 2);
+    uint64_t x = 0x2545F4914F6CDD1Dull;
+    for (uint32_t k = 0; k < 512u * 8192; k++) {
+        x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+        v[0] = (k >> 13) << 23 | ((uint32_t)x & 0x7FE000) | (k & 0x1FFF);
+        v[1] = f32_to_f16(bits_f32((uint32_t)v[0]));
+        gv_put(w, v);
+    }
+
+    const size_t ne = EDGE16_N;
+    for (int op = GV_F16_ADD; op <= GV_F16_DIV; op++) {
+        gv_begin(w, (gv_op)op, 2, 2, 1, 2);
+        for (uint32_t k = 0; k < (1u << 18) + ne * ne; k++) {
+            if (k < (1u << 18)) {
+                x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+                v[0] = x & 0xFFFF; v[1] = x >> 16 & 0xFFFF;
+            } else {
+                v[0] = edge16[(k - (1u << 18)) / ne]; v[1] = edge16[(k - (1u << 18)) % ne];
             }
+            float a = f16_to_f32((float16_t)v[0]), b = f16_to_f32((float16_t)v[1]);
+            float r = op == GV_F16_ADD ? a + b : op == GV_F16_SUB ? a - b : op == GV_F16_MUL ? a * b : a / b;
+            v[2] = isnan(r) ? 0x7E00 : f32_to_f16(r);
+            gv_put(w, v);
         }
     }
-    
-    return (sign << 15) | (new_exp << 10) | new_mant;
+
+    gv_begin(w, GV_F16_FMA, 3, 2, 1, 2);
+    uint64_t fv[4];
+    for (uint64_t k = 0; k < (1u << 18) + ne * ne * ne; k++) {
+        float16_t in[3];
+        arith_input(OP_FMA, k, 1u << 18, &x, in);
+        fv[0] = in[0]; fv[1] = in[1]; fv[2] = in[2];
+        fv[3] = ref_fma(in[0], in[1], in[2]);
+        gv_put(w, fv);
+    }
+    return gv_close(w);
 }
 
-int main(void) {
+int main(int argc, char **argv) {
+    sweep_opts o;
+    if (sweep_parse(argc, argv, "--kotlin-f16", "--kotlin-f32", &o) != 0) return 2;
+
     printf("=== Float16 C Reference Test Vectors ===\n\n");
     
     // Test arithmetic operations
@@ -126,6 +511,21 @@ int main(void) {
             f32_to_f16(a + b), f32_to_f16(a - b),
             f32_to_f16(a * b), f32_to_f16(a / b));
     }
-    
-    return 0;
+
+    size_t bad = check_bulk(&o);
+    bad += check_arith(&o);
+    bad += check_gemm();
+
+    // Stochastic rounding: between normals, in the flush region (zero or
+    // 2^-14), and below the largest finite value
+    printf("\n=== Stochastic Rounding (%s) ===\n", f16_convert_isa());
+    static const float sr_probe[] = { 1.0f + 0x1.333334p-12f, -3.1f, 0x1.333334p-16f, -1e-6f, 65500.0f };
+    bad += sweep_sr("f32 -> f16 sr", f32_to_f16_sr, f32_to_f16_sr_n, f16_to_f32,
+                    sr_probe, (int)(sizeof(sr_probe) / sizeof(sr_probe[0])));
+    if (o.golden) {
+        printf("\n=== Golden Vectors ===\n");
+        long long n = write_golden(o.golden);
+        if (n < 0 || gv_list(o.golden) != n) { printf("%s: write failed\n", o.golden); return 1; }
+    }
+    return bad ? 1 : 0;
 }
@@ -1,18 +1,87 @@
 /**
  * float64_spotcheck.c - C reference implementation for Float64 validation
  * 
- * Compile: gcc -std=c11 -o float64_spotcheck float64_spotcheck.c -lm
- * Run: ./float64_spotcheck
+ * Compile: gcc -std=c11 -o float64_spotcheck float64_spotcheck.c golden_vectors.c -lm
+ * Run: ./float64_spotcheck [--golden FILE]
  * 
  * Generates reference test vectors for validating Kotlin Float64Math.
+ * --golden also writes them in the binary format of golden_vectors.h.
  */
 
 #include <stdio.h>
 #include <stdint.h>
 #include <math.h>
 #include <string.h>
+#include "golden_vectors.h"
+
+static uint64_t f64_bits(double d) { uint64_t u; memcpy(&u, &d, 8); return u; }
+static double bits_f64(uint64_t u) { double d; memcpy(&d, &u, 8); return d; }
+static uint32_t f32_bits(float f) { uint32_t u; memcpy(&u, &f, 4); return u; }
+static float bits_f32(uint32_t u) { float f; memcpy(&f, &u, 4); return f; }
+
+static uint64_t rng = 0x9E3779B97F4A7C15ull;
+static uint64_t next_rand(void) { rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17; return rng; }
+
+// Random f64: every third one uniform over all bit patterns, the rest
+// with exponents near 1 so that sums and quotients round non-trivially
+static uint64_t rand_f64(uint32_t k) {
+    uint64_t x = next_rand();
+    if (k % 3 == 0) return x;
+    return (x & 0x800FFFFFFFFFFFFFull) | (uint64_t)(1023 - 40 + (x >> 52) % 81) << 52;
+}
+
+// Binary vectors (golden_vectors.h): the four ops on random pairs plus all
+// pairs of edge values, and both conversions on random and edge inputs.
+// Returns the record count, or -1 on a write error.
+static long long write_golden(const char *path) {
+    gv_writer *w = gv_create(path, "float64_spotcheck");
+    if (!w) { perror(path); return -1; }
+    static const uint64_t edge[] = {
+        0x0000000000000000, 0x8000000000000000, 0x0000000000000001, 0x000FFFFFFFFFFFFF,
+        0x0010000000000000, 0x3FF0000000000000, 0x3FF0000000000001, 0x3FEFFFFFFFFFFFFF,
+        0xBFF0000000000000, 0x4000000000000000, 0x3FD5555555555555, 0x7FEFFFFFFFFFFFFF,
+        0xFFEFFFFFFFFFFFFF, 0x7FF0000000000000, 0xFFF0000000000000, 0x7FF8000000000000,
+        0x36A0000000000000, 0x47EFFFFFE0000000, 0x3810000000000000, 0x380FFFFFFFFFFFFF };
+    const uint32_t ne = sizeof(edge) / sizeof(edge[0]), nr = 1u << 18;
+    uint64_t v[3];
+
+    for (int op = GV_F64_ADD; op <= GV_F64_DIV; op++) {
+        gv_begin(w, (gv_op)op, 2, 8, 1, 8);
+        for (uint32_t k = 0; k < nr + ne * ne; k++) {
+            if (k < nr) { v[0] = rand_f64(k); v[1] = rand_f64(k); }
+            else { v[0] = edge[(k - nr) / ne]; v[1] = edge[(k - nr) % ne]; }
+            double a = bits_f64(v[0]), b = bits_f64(v[1]);
+            double r = op == GV_F64_ADD ? a + b : op == GV_F64_SUB ? a - b : op == GV_F64_MUL ? a * b : a / b;
+            v[2] = isnan(r) ? 0x7FF8000000000000 : f64_bits(r);
+            gv_put(w, v);
+        }
+    }
+
+    gv_begin(w, GV_F32_TO_F64, 1, 4, 1, 8);
+    for (uint32_t k = 0; k < nr + ne; k++) {
+        v[0] = k < nr ? (uint32_t)next_rand() : f32_bits((float)bits_f64(edge[k - nr]));
+        v[1] = f64_bits((double)bits_f32((uint32_t)v[0]));
+        gv_put(w, v);
+    }
+
+    gv_begin(w, GV_F64_TO_F32, 1, 8, 1, 4);
+    for (uint32_t k = 0; k < nr + ne; k++) {
+        // the upper half keeps f32 range, where the rounding happens
+        v[0] = k >= nr ? edge[k - nr] : k % 2 ? next_rand()
+             : (next_rand() & 0x800FFFFFFFFFFFFFull) | (uint64_t)(1023 - 150 + k / 2 % 280) << 52;
+        v[1] = f32_bits((float)bits_f64(v[0]));
+        gv_put(w, v);
+    }
+    return gv_close(w);
+}
+
+int main(int argc, char **argv) {
+    const char *golden = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--golden") == 0 && i + 1 < argc) golden = argv[++i];
+        else { fprintf(stderr, "usage: %s [--golden FILE]\n", argv[0]); return 2; }
+    }
 
-int main(void) {
     printf("=== Float64 C Reference Test Vectors ===\n\n");
     
     // Test arithmetic operations
@@ -67,6 +136,11 @@ int main(void) {
         printf("f32=0x%08X -> f64=0x%016llX -> f32=0x%08X\n",
             f_bits, (unsigned long long)d_bits, f2_bits);
     }
-    
+
+    if (golden) {
+        printf("\n=== Golden Vectors ===\n");
+        long long n = write_golden(golden);
+        if (n < 0 || gv_list(golden) != n) { printf("%s: write failed\n", golden); return 1; }
+    }
     return 0;
 }
@@ -0,0 +1,295 @@
+/**
+ * fp8_convert.c - FP8 (OCP E4M3/E5M2) <-> Float32 conversion, scalar reference and bulk
+ *
+ * Shared library for cinterop:
+ *   gcc -std=c11 -O2 -shared -fPIC -o libfp8_convert.so fp8_convert.c
+ *
+ * fp8_*_to_f32/f32_to_fp8_* are the reference routines, written from the
+ * OCP OFP8 spec with explicit branches; fp8_spotcheck checks them against
+ * a nearest-value search over all 256 codes. The bulk entry points
+ * declared in fp8_convert.h scale in f32 and convert with branch-free
+ * integer code (and one f32 add that rounds subnormals onto the grid), so
+ * compilers vectorize it. No CPU this targets converts to FP8 in hardware
+ * (AVX10.2 and Arm FP8 are not assumed), and going through f16 would round
+ * twice, so every set runs the same code, compiled again for AVX2 and
+ * AVX-512 on x86-64.
+ */
+
+#include <math.h>
+#include <string.h>
+#include "cpu_features.h"
+#include "fp8_convert.h"
+
+// Format parameters: fraction bits, exponent bias, largest finite code,
+// the FP8_NOSAT overflow code, and the canonical NaN code (magnitudes)
+#define E4M3_MANT 3
+#define E4M3_BIAS 7
+#define E4M3_MAX 0x7Eu
+#define E4M3_OVF 0x7Fu              // no infinity: NaN
+#define E4M3_NAN 0x7Fu
+#define E5M2_MANT 2
+#define E5M2_BIAS 15
+#define E5M2_MAX 0x7Bu
+#define E5M2_OVF 0x7Cu              // infinity
+#define E5M2_NAN 0x7Eu
+
+// ============================================================================
+// Reference conversions
+// ============================================================================
+
+// Magnitude codes at or past nan_min are NaN; inf is the infinity code, or
+// past every magnitude for a format without one
+static float fp8_to_f32(uint8_t x, int mant, int bias, uint32_t inf, uint32_t nan_min) {
+    uint32_t sign = (uint32_t)(x & 0x80) << 24;
+    uint32_t em = x & 0x7F;
+    uint32_t exp = em >> mant;
+    uint32_t m = em & ((1u << mant) - 1);
+    uint32_t bits;
+
+    if (em >= nan_min) {
+        bits = sign | 0x7FC00000;
+    } else if (em == inf) {
+        bits = sign | 0x7F800000;
+    } else if (exp == 0) {
+        // subnormal: m * 2^(1 - bias - mant), exact
+        float v = ldexpf((float)m, 1 - bias - mant);
+        memcpy(&bits, &v, 4);
+        bits |= sign;
+    } else {
+        bits = sign | ((exp - bias + 127) << 23) | (m << (23 - mant));
+    }
+    float result;
+    memcpy(&result, &bits, 4);
+    return result;
+}
+
+static uint8_t f32_to_fp8(float f, fp8_saturation sat, int mant, int bias, uint32_t max, uint32_t ovf,
+                          uint32_t nan) {
+    uint32_t bits;
+    memcpy(&bits, &f, 4);
+
+    uint32_t sign = (bits >> 24) & 0x80;
+    uint32_t exp = (bits >> 23) & 0xFF;
+    uint32_t mant32 = bits & 0x7FFFFF;
+    uint32_t big = sat == FP8_SATFINITE ? max : ovf;
+
+    if (exp == 0xFF) {
+        return (uint8_t)(sign | (mant32 ? nan : big));
+    }
+
+    // f32 zeros and subnormals are far below half the smallest fp8
+    // subnormal
+    if (exp == 0) {
+        return (uint8_t)sign;
+    }
+
+    // Keep mant fraction bits at the value's own exponent, or at the
+    // subnormal spacing 2^(emin - mant) below the smallest normal 2^emin
+    int e = (int)exp - 127;
+    int emin = 1 - bias;
+    int shift = 23 - mant + (e < emin ? emin - e : 0);
+    if (shift > 24) {
+        return (uint8_t)sign;
+    }
+
+    uint32_t sig = mant32 | 0x800000;
+    uint32_t q = sig >> shift;
+    uint32_t rem = sig & ((1u << shift) - 1);
+    uint32_t half = 1u << (shift - 1);
+    if (rem > half || (rem == half && (q & 1))) {
+        q++;
+    }
+
+    // Below 2^emin q is the subnormal code (2^mant when it rounds up to
+    // the smallest normal). Otherwise q is in [2^mant, 2^(mant + 1)], the
+    // top being a carry into the next exponent.
+    uint32_t code = e < emin ? q : ((uint32_t)(e + bias) << mant) + q - (1u << mant);
+    if (code > max) {
+        return (uint8_t)(sign | big);
+    }
+    return (uint8_t)(sign | code);
+}
+
+float fp8_e4m3_to_f32(fp8_e4m3_t x) {
+    return fp8_to_f32(x, E4M3_MANT, E4M3_BIAS, 0x80, E4M3_NAN);
+}
+
+float fp8_e5m2_to_f32(fp8_e5m2_t x) {
+    return fp8_to_f32(x, E5M2_MANT, E5M2_BIAS, E5M2_OVF, E5M2_OVF + 1);
+}
+
+fp8_e4m3_t f32_to_fp8_e4m3(float f, fp8_saturation sat) {
+    return f32_to_fp8(f, sat, E4M3_MANT, E4M3_BIAS, E4M3_MAX, E4M3_OVF, E4M3_NAN);
+}
+
+fp8_e5m2_t f32_to_fp8_e5m2(float f, fp8_saturation sat) {
+    return f32_to_fp8(f, sat, E5M2_MANT, E5M2_BIAS, E5M2_MAX, E5M2_OVF, E5M2_NAN);
+}
+
+// ============================================================================
+// Portable branch-free kernels
+// ============================================================================
+
+// All ones when c holds, else zero
+#define FP8_MASK(c) (0u - (uint32_t)(c))
+#define FP8_SELECT(c, a, b) (((a) & FP8_MASK(c)) | ((b) & ~FP8_MASK(c)))
+
+#define FP8_INLINE static inline __attribute__((always_inline))
+
+static inline float fp8_f32(uint32_t u) { float f; memcpy(&f, &u, 4); return f; }
+static inline uint32_t fp8_bits(float f) { uint32_t u; memcpy(&u, &f, 4); return u; }
+
+// x * scale with the header's NaN rule: a NaN input keeps its bits
+// (quieted), a NaN the multiply makes is 0x7FC00000
+FP8_INLINE uint32_t fp8_scale(uint32_t x, float scale) {
+    uint32_t p = fp8_bits(fp8_f32(x) * scale);
+    uint32_t xa = x & 0x7FFFFFFF, pa = p & 0x7FFFFFFF;
+    uint32_t nan = FP8_SELECT(xa > 0x7F800000, x | 0x400000, 0x7FC00000u);
+    return FP8_SELECT(pa > 0x7F800000, nan, p);
+}
+
+// Magnitude codes from special_min up are infinity or NaN, from nan_min NaN
+FP8_INLINE uint32_t fp8_decode(uint8_t x, int mant, int bias, uint32_t special_min, uint32_t nan_min) {
+    uint32_t sign = (uint32_t)(x & 0x80) << 24;
+    uint32_t em = x & 0x7F;
+    // Normals: rebias the exponent in place. Subnormals: an exact int ->
+    // float conversion and a power-of-two scale.
+    uint32_t normal = (em << (23 - mant)) + ((uint32_t)(127 - bias) << 23);
+    uint32_t sub = fp8_bits((float)em * fp8_f32((uint32_t)(127 + 1 - bias - mant) << 23));
+    uint32_t bits = FP8_SELECT(em < (1u << mant), sub, normal);
+    uint32_t special = 0x7F800000u | FP8_SELECT(em >= nan_min, 0x400000u, 0u);
+    bits = FP8_SELECT(em >= special_min, special, bits);
+    return sign | bits;
+}
+
+FP8_INLINE uint8_t fp8_encode(uint32_t x, int mant, int bias, uint32_t max, uint32_t big, uint32_t nan) {
+    uint32_t sign = (x >> 24) & 0x80;
+    uint32_t a = x & 0x7FFFFFFF;
+    const uint32_t min_normal = (uint32_t)(127 + 1 - bias) << 23;
+    // Round to nearest even at the format's last fraction bit: a carry
+    // moves into the exponent, and anything past the largest finite value
+    // (infinity too) lands above max.
+    const int shift = 23 - mant;
+    uint32_t r = ((a + (1u << (shift - 1)) - 1 + ((a >> shift) & 1)) >> shift) - ((uint32_t)(127 - bias) << mant);
+    // Below 2^emin: adding 2^(23 + emin - mant), whose ulp is the
+    // subnormal spacing, rounds |x| onto the grid; the low bits are the
+    // code, up to the smallest normal's
+    const uint32_t magic = (uint32_t)(127 + 24 - bias - mant) << 23;
+    uint32_t s = fp8_bits(fp8_f32(FP8_SELECT(a < min_normal, a, 0u)) + fp8_f32(magic)) - magic;
+    uint32_t h = FP8_SELECT(a < min_normal, s, r);
+    h = FP8_SELECT(h > max, big, h);
+    h = FP8_SELECT(a > 0x7F800000, nan, h);
+    return (uint8_t)(sign | h);
+}
+
+// The loops, compiled once per kernel set below
+#define FP8_DECODE_LOOP(fmt, special_min, nan_min)                                                         \
+    for (size_t i = 0; i < n; i++)                                                                \
+        dst[i] = fp8_f32(fp8_scale(fp8_decode(src[i], fmt##_MANT, fmt##_BIAS, special_min, nan_min), scale))
+
+#define FP8_ENCODE_LOOP(fmt, load)                                                                 \
+    uint32_t big = sat == FP8_SATFINITE ? fmt##_MAX : fmt##_OVF;                                  \
+    for (size_t i = 0; i < n; i++)                                                                \
+        dst[i] = fp8_encode(fp8_scale(load, scale), fmt##_MANT, fmt##_BIAS, fmt##_MAX, big, fmt##_NAN)
+
+#define FP8_KERNEL_SET(name, attr)                                                                 \
+    CPU_VECTORIZE attr static void fp8_e4m3_to_f32_n_##name(size_t n, const fp8_e4m3_t *src, float *dst, \
+                                                            float scale) {                        \
+        FP8_DECODE_LOOP(E4M3, E4M3_NAN, E4M3_NAN);                                                    \
+    }                                                                                             \
+    CPU_VECTORIZE attr static void fp8_e5m2_to_f32_n_##name(size_t n, const fp8_e5m2_t *src, float *dst, \
+                                                            float scale) {                        \
+        FP8_DECODE_LOOP(E5M2, E5M2_OVF, E5M2_OVF + 1);                                             \
+    }                                                                                             \
+    CPU_VECTORIZE attr static void f32_to_fp8_e4m3_n_##name(size_t n, const float *src, fp8_e4m3_t *dst, \
+                                                            float scale, fp8_saturation sat) {    \
+        FP8_ENCODE_LOOP(E4M3, fp8_bits(src[i]));                                                   \
+    }                                                                                             \
+    CPU_VECTORIZE attr static void f32_to_fp8_e5m2_n_##name(size_t n, const float *src, fp8_e5m2_t *dst, \
+                                                            float scale, fp8_saturation sat) {    \
+        FP8_ENCODE_LOOP(E5M2, fp8_bits(src[i]));                                                   \
+    }                                                                                             \
+    CPU_VECTORIZE attr static void bf16_to_fp8_e4m3_n_##name(size_t n, const uint16_t *src, fp8_e4m3_t *dst, \
+                                                             float scale, fp8_saturation sat) {   \
+        FP8_ENCODE_LOOP(E4M3, (uint32_t)src[i] << 16);                                             \
+    }                                                                                             \
+    CPU_VECTORIZE attr static void bf16_to_fp8_e5m2_n_##name(size_t n, const uint16_t *src, fp8_e5m2_t *dst, \
+                                                             float scale, fp8_saturation sat) {   \
+        FP8_ENCODE_LOOP(E5M2, (uint32_t)src[i] << 16);                                             \
+    }
+
+FP8_KERNEL_SET(portable, )
+
+// -DFP8_HW=0 leaves only the portable kernels (to check them on any host)
+#ifndef FP8_HW
+#define FP8_HW 1
+#endif
+
+#if FP8_HW && defined(__GNUC__) && defined(__x86_64__)
+#define FP8_HAVE_X86 1
+FP8_KERNEL_SET(avx2, __attribute__((target("avx2"))))
+FP8_KERNEL_SET(avx512, __attribute__((target("avx512f,avx512bw"))))
+#endif
+
+// ============================================================================
+// Dispatch
+// ============================================================================
+
+typedef struct {
+    const char *isa;
+    void (*e4m3_to_f32)(size_t, const fp8_e4m3_t*, float*, float);
+    void (*e5m2_to_f32)(size_t, const fp8_e5m2_t*, float*, float);
+    void (*f32_to_e4m3)(size_t, const float*, fp8_e4m3_t*, float, fp8_saturation);
+    void (*f32_to_e5m2)(size_t, const float*, fp8_e5m2_t*, float, fp8_saturation);
+    void (*bf16_to_e4m3)(size_t, const uint16_t*, fp8_e4m3_t*, float, fp8_saturation);
+    void (*bf16_to_e5m2)(size_t, const uint16_t*, fp8_e5m2_t*, float, fp8_saturation);
+} fp8_kernels;
+
+#define FP8_KERNELS(isa, name)                                                                     \
+    { isa, fp8_e4m3_to_f32_n_##name, fp8_e5m2_to_f32_n_##name, f32_to_fp8_e4m3_n_##name,        \
+      f32_to_fp8_e5m2_n_##name, bf16_to_fp8_e4m3_n_##name, bf16_to_fp8_e5m2_n_##name }
+
+static const fp8_kernels fp8_kernels_portable = FP8_KERNELS("portable", portable);
+#if FP8_HAVE_X86
+static const fp8_kernels fp8_kernels_avx2 = FP8_KERNELS("avx2", avx2);
+static const fp8_kernels fp8_kernels_avx512 = FP8_KERNELS("avx512", avx512);
+#endif
+
+static const fp8_kernels *fp8_select(void) {
+    const fp8_kernels *k = &fp8_kernels_portable;
+#if FP8_HAVE_X86
+    if (cpu_has(CPU_AVX512F | CPU_AVX512BW)) k = &fp8_kernels_avx512;
+    else if (cpu_has(CPU_AVX2)) k = &fp8_kernels_avx2;
+#endif
+    return k;
+}
+
+CPU_DISPATCH(fp8_kernels, fp8, fp8_select)
+
+const char *fp8_convert_isa(void) {
+    return fp8_k()->isa;
+}
+
+void fp8_e4m3_to_f32_n(size_t n, const fp8_e4m3_t *src, float *dst, float scale) {
+    fp8_k()->e4m3_to_f32(n, src, dst, scale);
+}
+
+void fp8_e5m2_to_f32_n(size_t n, const fp8_e5m2_t *src, float *dst, float scale) {
+    fp8_k()->e5m2_to_f32(n, src, dst, scale);
+}
+
+void f32_to_fp8_e4m3_n(size_t n, const float *src, fp8_e4m3_t *dst, float scale, fp8_saturation sat) {
+    fp8_k()->f32_to_e4m3(n, src, dst, scale, sat);
+}
+
+void f32_to_fp8_e5m2_n(size_t n, const float *src, fp8_e5m2_t *dst, float scale, fp8_saturation sat) {
+    fp8_k()->f32_to_e5m2(n, src, dst, scale, sat);
+}
+
+void bf16_to_fp8_e4m3_n(size_t n, const uint16_t *src, fp8_e4m3_t *dst, float scale, fp8_saturation sat) {
+    fp8_k()->bf16_to_e4m3(n, src, dst, scale, sat);
+}
+
+void bf16_to_fp8_e5m2_n(size_t n, const uint16_t *src, fp8_e5m2_t *dst, float scale, fp8_saturation sat) {
+    fp8_k()->bf16_to_e5m2(n, src, dst, scale, sat);
+}
@@ -0,0 +1,69 @@
+/**
+ * C interop header for FP8 (OCP E4M3 and E5M2) conversion
+ */
+
+#ifndef FP8_CONVERT_H
+#define FP8_CONVERT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The two formats of the OCP 8-bit floating point spec (OFP8, rev. 1.0):
+// - E4M3: bias 7, largest finite 448, smallest subnormal 2^-9. No
+//   infinities; S.1111.111 is NaN.
+// - E5M2: bias 15, largest finite 57344, smallest subnormal 2^-16. IEEE
+//   style: S.11111.00 is infinity, S.11111.xx otherwise NaN. It is the top
+//   byte of an f16.
+typedef uint8_t fp8_e4m3_t;
+typedef uint8_t fp8_e5m2_t;
+
+// What f32 -> fp8 does with a value past the largest finite one, after
+// rounding (and with infinities):
+// - FP8_NOSAT: E5M2 gives infinity; E4M3, having none, gives NaN
+// - FP8_SATFINITE: both clamp to the largest finite value, keeping the sign
+typedef enum {
+    FP8_NOSAT = 0,
+    FP8_SATFINITE = 1
+} fp8_saturation;
+
+// Reference conversions:
+// - fp8 -> f32 is exact; NaN becomes the f32 quiet NaN 0x7FC00000 with the
+//   code's sign
+// - f32 -> fp8 rounds to nearest even onto the format's grid, subnormals
+//   included (nothing is flushed), then applies the saturation mode. NaN
+//   becomes S.1111.111 (E4M3) or S.11111.10 (E5M2), keeping the sign.
+float fp8_e4m3_to_f32(fp8_e4m3_t x);
+float fp8_e5m2_to_f32(fp8_e5m2_t x);
+fp8_e4m3_t f32_to_fp8_e4m3(float f, fp8_saturation sat);
+fp8_e5m2_t f32_to_fp8_e5m2(float f, fp8_saturation sat);
+
+// Bulk conversions over whole buffers with a per-tensor scale, chosen at
+// load time by CPU feature (vectorized integer code: AVX-512, AVX2, or
+// the portable loop, which is NEON on aarch64). The scale multiplies in
+// f32, rounded once, on the f32 side of the conversion:
+//   decode: dst[i] = fp8_*_to_f32(src[i]) * scale
+//   encode: dst[i] = f32_to_fp8_*(src[i] * scale, sat)
+// bf16 sources (bf16 bit patterns, bfloat16_t in bf16_math.h) are widened
+// exactly first. A NaN input stays that NaN, sign included, whatever the
+// scale; a NaN the multiply makes (0 * infinity, a NaN scale) is positive.
+// So with scale 1 each element is bit-identical to the reference calls.
+// src and dst must not overlap.
+void fp8_e4m3_to_f32_n(size_t n, const fp8_e4m3_t *src, float *dst, float scale);
+void fp8_e5m2_to_f32_n(size_t n, const fp8_e5m2_t *src, float *dst, float scale);
+void f32_to_fp8_e4m3_n(size_t n, const float *src, fp8_e4m3_t *dst, float scale, fp8_saturation sat);
+void f32_to_fp8_e5m2_n(size_t n, const float *src, fp8_e5m2_t *dst, float scale, fp8_saturation sat);
+void bf16_to_fp8_e4m3_n(size_t n, const uint16_t *src, fp8_e4m3_t *dst, float scale, fp8_saturation sat);
+void bf16_to_fp8_e5m2_n(size_t n, const uint16_t *src, fp8_e5m2_t *dst, float scale, fp8_saturation sat);
+
+// Kernel set in use: "avx512", "avx2" or "portable"
+const char *fp8_convert_isa(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FP8_CONVERT_H
@@ -0,0 +1,405 @@
+/**
+ * fp8_spotcheck.c - C reference implementation for FP8 (OCP E4M3/E5M2) validation
+ *
+ * Compile: gcc -std=c11 -O2 -pthread -o fp8_spotcheck fp8_spotcheck.c fp8_convert.c golden_vectors.c -lm
+ * Run: ./fp8_spotcheck [--exhaustive] [--threads N] [--golden FILE]
+ *
+ * Prints every code of both formats with its value (all 256 are the whole
+ * decode test set), checks the reference conversions in fp8_convert.c
+ * against the OCP spec by brute force (the nearest of the 256 values),
+ * then checks the bulk kernels, with per-tensor scales, against the
+ * reference and exits 1 on any mismatch. --exhaustive also runs all 2^32
+ * f32 inputs through the bulk encoders; --golden writes the vectors as a
+ * binary file (golden_vectors.h).
+ */
+
+#define _POSIX_C_SOURCE 200809L   // clock_gettime
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "fp8_convert.h"
+#include "golden_vectors.h"
+
+#define SHOW 8                      // mismatches printed per check
+
+static uint32_t f32_bits(float f) { uint32_t u; memcpy(&u, &f, 4); return u; }
+static float bits_f32(uint32_t u) { float f; memcpy(&f, &u, 4); return f; }
+
+static uint64_t rng = 88172645463325252ull;
+static uint64_t next_rand(void) { rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17; return rng; }
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+typedef struct {
+    const char *name;
+    int mant, bias;
+    uint8_t max, ovf, nan;          // largest finite, FP8_NOSAT overflow and NaN codes (magnitudes)
+    float (*to_f32)(uint8_t);
+    uint8_t (*from_f32)(float, fp8_saturation);
+    void (*to_f32_n)(size_t, const uint8_t*, float*, float);
+    void (*from_f32_n)(size_t, const float*, uint8_t*, float, fp8_saturation);
+    void (*from_bf16_n)(size_t, const uint16_t*, uint8_t*, float, fp8_saturation);
+    gv_op gv_decode, gv_encode;
+} fp8_format;
+
+static const fp8_format formats[2] = {
+    { "e4m3", 3, 7, 0x7E, 0x7F, 0x7F, fp8_e4m3_to_f32, f32_to_fp8_e4m3,
+      fp8_e4m3_to_f32_n, f32_to_fp8_e4m3_n, bf16_to_fp8_e4m3_n, GV_E4M3_TO_F32, GV_F32_TO_E4M3 },
+    { "e5m2", 2, 15, 0x7B, 0x7C, 0x7E, fp8_e5m2_to_f32, f32_to_fp8_e5m2,
+      fp8_e5m2_to_f32_n, f32_to_fp8_e5m2_n, bf16_to_fp8_e5m2_n, GV_E5M2_TO_F32, GV_F32_TO_E5M2 },
+};
+
+static const char *const sat_name[2] = { "nosat", "satfinite" };
+
+// ============================================================================
+// Reference against the spec
+// ============================================================================
+
+// The value code max + 1 would have with an unbounded exponent (the first
+// step past the largest finite value)
+static double past_max(const fp8_format *fm) {
+    int e = fm->max >> fm->mant, m = (fm->max & ((1 << fm->mant) - 1)) + 1;
+    return ldexp((double)((1 << fm->mant) + m), e - fm->bias - fm->mant);
+}
+
+// The spec's rounding by search: the nearest finite value, ties to the
+// even code (the code's low bit is the significand's); past the midpoint
+// between the largest finite value and past_max, with the same tie rule,
+// the overflow result
+static uint8_t oracle_encode(const fp8_format *fm, float f, fp8_saturation sat) {
+    uint8_t sign = signbit(f) ? 0x80 : 0;
+    if (isnan(f)) return sign | fm->nan;
+    double a = fabs((double)f), top = fm->to_f32(fm->max), mid = (top + past_max(fm)) / 2;
+    if (a > mid || (a == mid && (fm->max + 1) % 2 == 0))
+        return sign | (sat == FP8_SATFINITE ? fm->max : fm->ovf);
+    unsigned best = 0;
+    double best_d = a;
+    for (unsigned c = 1; c <= fm->max; c++) {
+        double d = fabs(a - fm->to_f32((uint8_t)c));
+        if (d < best_d || (d == best_d && c % 2 == 0)) { best = c; best_d = d; }
+    }
+    return sign | (uint8_t)best;
+}
+
+// f32 inputs where rounding decides: each value of the format, each
+// midpoint between neighbours (and past the largest finite value), one
+// f32 ulp either side of both, with both signs; then f32 edges. Returns
+// the count (at most 128 * 12 + 32).
+static size_t edge_inputs(const fp8_format *fm, float *out) {
+    size_t n = 0;
+    for (unsigned c = 0; c <= fm->max; c++) {
+        double v = fm->to_f32((uint8_t)c), next = c < fm->max ? fm->to_f32((uint8_t)(c + 1)) : past_max(fm);
+        float pts[2] = { (float)v, (float)((v + next) / 2) };
+        for (int p = 0; p < 2; p++)
+            for (int s = 0; s < 2; s++) {
+                float x = s ? -pts[p] : pts[p];
+                out[n++] = x;
+                out[n++] = nextafterf(x, INFINITY);
+                out[n++] = nextafterf(x, -INFINITY);
+            }
+    }
+    static const uint32_t edge[16] = {
+        0x00000000, 0x00000001, 0x007FFFFF, 0x00800000, 0x3F800000, 0x7F7FFFFF, 0x7F800000, 0x7F800001,
+        0x7FC00000, 0x7FFFFFFF, 0x43E00000, 0x43E80000, 0x47700000, 0x47800000, 0x3A800000, 0x37800000 };
+    for (int i = 0; i < 32; i++) out[n++] = bits_f32(edge[i % 16] | (uint32_t)(i / 16) << 31);
+    return n;
+}
+
+// Random f32: half any bit pattern, half with an exponent near the
+// format's range, where every rounding path is exercised
+static float rand_input(const fp8_format *fm) {
+    uint64_t v = next_rand();
+    if (v & 1) return bits_f32((uint32_t)(v >> 32));
+    int lo = 127 - fm->bias - fm->mant - 3, span = 2 * fm->bias + fm->mant + 6;
+    uint32_t e = (uint32_t)(lo + (int)((v >> 1) % (uint64_t)span));
+    return bits_f32((uint32_t)(v >> 63) << 31 | e << 23 | ((uint32_t)(v >> 8) & 0x7FFFFF));
+}
+
+// Known values, decode then encode of every code, and the reference
+// encoder against oracle_encode. Returns the number of failures.
+static size_t check_reference(const fp8_format *fm) {
+    size_t bad = 0;
+    // one, the largest finite value, the smallest normal and subnormal
+    const uint8_t one = (uint8_t)(fm->bias << fm->mant);
+    const struct { uint8_t code; double value; } known[] = {
+        { one, 1.0 }, { fm->max, fm->mant == 3 ? 448.0 : 57344.0 },
+        { (uint8_t)(1 << fm->mant), ldexp(1.0, 1 - fm->bias) },
+        { 1, ldexp(1.0, 1 - fm->bias - fm->mant) }, { 0x80, -0.0 } };
+    for (size_t i = 0; i < sizeof(known) / sizeof(known[0]); i++) {
+        float v = fm->to_f32(known[i].code);
+        if (v != known[i].value || !signbit(v) != !signbit(known[i].value)) {
+            printf("  %s 0x%02X -> %g, want %g\n", fm->name, known[i].code, v, known[i].value);
+            bad++;
+        }
+    }
+    for (unsigned c = 0; c < 256; c++) {
+        float v = fm->to_f32((uint8_t)c);
+        uint8_t sign = c & 0x80, em = c & 0x7F;
+        int nan = em > fm->max && !(em == fm->ovf && fm->ovf != fm->nan);
+        if (nan != (int)isnan(v) || (nan && f32_bits(v) != ((uint32_t)sign << 24 | 0x7FC00000))) {
+            printf("  %s 0x%02X -> 0x%08X\n", fm->name, c, f32_bits(v));
+            bad++;
+        }
+        for (int sat = 0; sat < 2; sat++) {
+            uint8_t want = nan ? sign | fm->nan : em > fm->max ? sign | (sat ? fm->max : fm->ovf) : (uint8_t)c;
+            uint8_t got = fm->from_f32(v, (fp8_saturation)sat);
+            if (got != want) {
+                printf("  %s 0x%02X -> %g -> 0x%02X (%s), want 0x%02X\n", fm->name, c, v, got, sat_name[sat], want);
+                bad++;
+            }
+        }
+    }
+    float *in = malloc(4000 * sizeof(*in));
+    if (!in) { printf("  (allocation failed)\n"); exit(1); }
+    size_t ne = edge_inputs(fm, in), checked = 0, bad_oracle = 0;
+    for (size_t k = 0; k < ne + (1u << 16); k++) {
+        float f = k < ne ? in[k] : rand_input(fm);
+        for (int sat = 0; sat < 2; sat++) {
+            uint8_t want = oracle_encode(fm, f, (fp8_saturation)sat), got = fm->from_f32(f, (fp8_saturation)sat);
+            if (got != want && bad_oracle++ < SHOW)
+                printf("  f32 0x%08X -> %s 0x%02X (%s), nearest value 0x%02X\n",
+                       f32_bits(f), fm->name, got, sat_name[sat], want);
+            checked++;
+        }
+    }
+    printf("%s: 256 codes decoded and re-encoded, %zu encodings against nearest-value search, %zu mismatches\n",
+           fm->name, checked, bad + bad_oracle);
+    free(in);
+    return bad + bad_oracle;
+}
+
+// ============================================================================
+// Bulk kernels
+// ============================================================================
+
+// x * scale with fp8_convert.h's NaN rule
+static float scaled(float x, float scale) {
+    float p = x * scale;
+    if (!isnan(p)) return p;
+    return isnan(x) ? bits_f32(f32_bits(x) | 0x400000) : bits_f32(0x7FC00000);
+}
+
+static const float scales[] = { 1.0f, 0.25f, 3.3f, -0x1.8p-7f, 0x1p-20f, 0x1p100f, 0.0f, INFINITY, NAN };
+#define N_SCALES (sizeof(scales) / sizeof(scales[0]))
+
+// Every code through the bulk decoder at each scale; f32 edge and random
+// inputs through the bulk encoder at each scale and saturation mode, in
+// one call and again in pieces of 1 to 67 elements; every bf16 input the
+// same way. Then the throughput. Returns the number of mismatches.
+static size_t check_bulk(const fp8_format *fm) {
+    const size_t n = 1u << 20;
+    float *f = malloc(n * sizeof(*f)), *g = malloc(n * sizeof(*g));
+    uint8_t *h = malloc(n), *h2 = malloc(n);
+    uint16_t *b = malloc(65536 * sizeof(*b));
+    if (!f || !g || !h || !h2 || !b) { printf("  (allocation failed)\n"); exit(1); }
+    size_t bad = 0, checked = 0;
+
+    for (unsigned c = 0; c < 256; c++) h[c] = (uint8_t)c;
+    for (size_t s = 0; s < N_SCALES; s++) {
+        fm->to_f32_n(256, h, f, scales[s]);
+        for (unsigned c = 0; c < 256; c++) {
+            uint32_t want = f32_bits(scaled(fm->to_f32((uint8_t)c), scales[s]));
+            if (f32_bits(f[c]) != want && bad++ < SHOW)
+                printf("  %s 0x%02X * %g -> 0x%08X, reference 0x%08X\n", fm->name, c, scales[s], f32_bits(f[c]), want);
+        }
+        checked += 256;
+    }
+
+    size_t ne = edge_inputs(fm, f);
+    for (size_t i = ne; i < n; i++) f[i] = rand_input(fm);
+    for (size_t s = 0; s < N_SCALES; s++)
+        for (int sat = 0; sat < 2; sat++) {
+            fm->from_f32_n(n, f, h, scales[s], (fp8_saturation)sat);
+            for (size_t i = 0, piece = 1; i < n; i += piece, piece = piece % 67 + 1)
+                fm->from_f32_n(n - i < piece ? n - i : piece, f + i, h2 + i, scales[s], (fp8_saturation)sat);
+            for (size_t i = 0; i < n; i++) {
+                uint8_t want = fm->from_f32(scaled(f[i], scales[s]), (fp8_saturation)sat);
+                if ((h[i] != want || h2[i] != want) && bad++ < SHOW)
+                    printf("  f32 0x%08X * %g -> %s 0x%02X (%s), in pieces 0x%02X, reference 0x%02X\n",
+                           f32_bits(f[i]), scales[s], fm->name, h[i], sat_name[sat], h2[i], want);
+            }
+            checked += n;
+        }
+
+    for (uint32_t i = 0; i < 65536; i++) b[i] = (uint16_t)i;
+    for (size_t s = 0; s < N_SCALES; s++)
+        for (int sat = 0; sat < 2; sat++) {
+            fm->from_bf16_n(65536, b, h, scales[s], (fp8_saturation)sat);
+            for (uint32_t i = 0; i < 65536; i++) {
+                uint8_t want = fm->from_f32(scaled(bits_f32(i << 16), scales[s]), (fp8_saturation)sat);
+                if (h[i] != want && bad++ < SHOW)
+                    printf("  bf16 0x%04X * %g -> %s 0x%02X (%s), reference 0x%02X\n",
+                           i, scales[s], fm->name, h[i], sat_name[sat], want);
+            }
+            checked += 65536;
+        }
+    printf("%s bulk: %zu conversions (%zu scales, both saturation modes, every bf16), %zu mismatches\n",
+           fm->name, checked, N_SCALES, bad);
+
+    // Throughput on a buffer larger than L2, values spread over the range
+    for (size_t i = 0; i < n; i++) f[i] = rand_input(fm);
+    for (size_t i = 0; i < n; i++) b[i & 0xFFFF] = (uint16_t)(f32_bits(f[i]) >> 16);
+    const int reps = 20;
+    double t0 = now_s();
+    for (int r = 0; r < reps; r++) fm->from_f32_n(n, f, h, 0.5f, FP8_SATFINITE);
+    double t_enc = (now_s() - t0) / reps;
+    t0 = now_s();
+    for (int r = 0; r < reps; r++)
+        for (size_t i = 0; i < n; i += 65536) fm->from_bf16_n(65536, b, h + i, 0.5f, FP8_SATFINITE);
+    double t_bf16 = (now_s() - t0) / reps;
+    t0 = now_s();
+    for (int r = 0; r < reps; r++) fm->to_f32_n(n, h, g, 2.0f);
+    double t_dec = (now_s() - t0) / reps;
+    t0 = now_s();
+    for (size_t i = 0; i < n; i++) h2[i] = fm->from_f32(f[i] * 0.5f, FP8_SATFINITE);
+    double t_ref = now_s() - t0;
+    printf("f32 -> %s: %.2f ns/elem, reference scalar %.2f ns/elem\n", fm->name, t_enc / n * 1e9, t_ref / n * 1e9);
+    printf("bf16 -> %s: %.2f ns/elem\n", fm->name, t_bf16 / n * 1e9);
+    printf("%s -> f32: %.2f ns/elem\n", fm->name, t_dec / n * 1e9);
+
+    free(f); free(g); free(h); free(h2); free(b);
+    return bad;
+}
+
+// ============================================================================
+// Exhaustive f32 sweep
+// ============================================================================
+
+#define CHUNK (1u << 16)
+
+typedef struct {
+    const fp8_format *fm;
+    uint64_t lo, hi;                // f32 bit patterns [lo, hi)
+    size_t bad;
+    int failed, threaded;
+} sweep_job;
+
+static void *sweep_worker(void *arg) {
+    sweep_job *j = arg;
+    float *f = malloc(CHUNK * sizeof(*f));
+    uint8_t *h = malloc(CHUNK);
+    if (!f || !h) { j->failed = 1; goto out; }
+    for (uint64_t base = j->lo; base < j->hi; base += CHUNK) {
+        size_t m = (size_t)(j->hi - base < CHUNK ? j->hi - base : CHUNK);
+        for (size_t i = 0; i < m; i++) f[i] = bits_f32((uint32_t)(base + i));
+        for (int sat = 0; sat < 2; sat++) {
+            j->fm->from_f32_n(m, f, h, 1.0f, (fp8_saturation)sat);
+            for (size_t i = 0; i < m; i++)
+                if (h[i] != j->fm->from_f32(f[i], (fp8_saturation)sat)) j->bad++;
+        }
+    }
+out:
+    free(f); free(h);
+    return NULL;
+}
+
+// All 2^32 f32 inputs, both saturation modes, bulk against the reference
+// on `threads` threads. Returns the number of mismatches.
+static size_t sweep_f32(const fp8_format *fm, int threads) {
+    const uint64_t total = 1ull << 32;
+    if (threads < 1) threads = 1;
+    sweep_job *jobs = calloc((size_t)threads, sizeof(*jobs));
+    pthread_t *tid = calloc((size_t)threads, sizeof(*tid));
+    if (!jobs || !tid) { printf("  (allocation failed)\n"); exit(1); }
+    double t0 = now_s();
+    uint64_t slice = (total / (uint64_t)threads + CHUNK - 1) / CHUNK * CHUNK;
+    for (int t = 0; t < threads; t++) {
+        sweep_job *j = &jobs[t];
+        j->fm = fm;
+        j->lo = (uint64_t)t * slice < total ? (uint64_t)t * slice : total;
+        j->hi = j->lo + slice < total ? j->lo + slice : total;
+        j->threaded = pthread_create(&tid[t], NULL, sweep_worker, j) == 0;
+        if (!j->threaded) sweep_worker(j);   // couldn't start: run it here
+    }
+    size_t bad = 0;
+    for (int t = 0; t < threads; t++) {
+        if (jobs[t].threaded) pthread_join(tid[t], NULL);
+        if (jobs[t].failed) { printf("  worker %d: allocation failed\n", t); bad++; }
+        bad += jobs[t].bad;
+    }
+    printf("f32 -> %s: all %llu inputs, both saturation modes, %zu mismatches; %d threads, %.1f s\n",
+           fm->name, (unsigned long long)total, bad, threads, now_s() - t0);
+    free(jobs); free(tid);
+    return bad;
+}
+
+// ============================================================================
+// Vectors
+// ============================================================================
+
+// Every code with its value, eight to a line
+static void print_table(const fp8_format *fm) {
+    printf("\n%s (bias %d; NOSAT overflow 0x%02X, NaN 0x%02X):\n", fm->name, fm->bias, fm->ovf, fm->nan);
+    for (unsigned c = 0; c < 256; c++)
+        printf("%s%02X %-12.6g%s", c % 8 ? " " : "  ", c, fm->to_f32((uint8_t)c), c % 8 == 7 ? "\n" : "");
+}
+
+// Binary vectors (golden_vectors.h): every code decoded, and edge_inputs
+// encoded under both saturation modes (outputs: FP8_NOSAT, FP8_SATFINITE).
+// Returns the record count, or -1 on a write error.
+static long long write_golden(const char *path) {
+    gv_writer *w = gv_create(path, "fp8_spotcheck");
+    if (!w) { perror(path); return -1; }
+    float in[4000];
+    uint64_t v[3];
+    for (int k = 0; k < 2; k++) {
+        const fp8_format *fm = &formats[k];
+        gv_begin(w, fm->gv_decode, 1, 1, 1, 4);
+        for (unsigned c = 0; c < 256; c++) {
+            v[0] = c; v[1] = f32_bits(fm->to_f32((uint8_t)c));
+            gv_put(w, v);
+        }
+        gv_begin(w, fm->gv_encode, 1, 4, 2, 1);
+        size_t ne = edge_inputs(fm, in);
+        for (size_t i = 0; i < ne; i++) {
+            v[0] = f32_bits(in[i]);
+            v[1] = fm->from_f32(in[i], FP8_NOSAT);
+            v[2] = fm->from_f32(in[i], FP8_SATFINITE);
+            gv_put(w, v);
+        }
+    }
+    return gv_close(w);
+}
+
+int main(int argc, char **argv) {
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    int exhaustive = 0, threads = ncpu > 0 ? (int)ncpu : 1;
+    const char *golden = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--exhaustive") == 0) exhaustive = 1;
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--golden") == 0 && i + 1 < argc) golden = argv[++i];
+        else {
+            fprintf(stderr, "usage: %s [--exhaustive] [--threads N] [--golden FILE]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    printf("=== FP8 C Reference Test Vectors ===\n");
+    for (int k = 0; k < 2; k++) print_table(&formats[k]);
+
+    size_t bad = 0;
+    printf("\n=== Reference vs OCP spec ===\n");
+    for (int k = 0; k < 2; k++) bad += check_reference(&formats[k]);
+
+    printf("\n=== Bulk Conversion (%s) ===\n", fp8_convert_isa());
+    for (int k = 0; k < 2; k++) bad += check_bulk(&formats[k]);
+    if (exhaustive)
+        for (int k = 0; k < 2; k++) bad += sweep_f32(&formats[k], threads);
+
+    if (golden) {
+        printf("\n=== Golden Vectors ===\n");
+        long long n = write_golden(golden);
+        if (n < 0 || gv_list(golden) != n) { printf("%s: write failed\n", golden); return 1; }
+    }
+    return bad ? 1 : 0;
+}
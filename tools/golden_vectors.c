@@ -0,0 +1,238 @@
+/**
+ * golden_vectors.c - Binary golden-vector writer and mmap reader
+ *
+ * Compile with the tool that uses it, or as a library for cinterop:
+ *   gcc -std=c11 -O2 -shared -fPIC -o libgolden_vectors.so golden_vectors.c
+ *
+ * See golden_vectors.h for the format.
+ */
+
+#define _POSIX_C_SOURCE 200809L   // mmap, fstat
+#include "golden_vectors.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char gv_magic[8] = { 'G', 'O', 'L', 'D', 'V', 'E', 'C', 0 };
+
+const char *gv_op_name(unsigned op) {
+    switch (op) {
+    case GV_F16_TO_F32: return "f16_to_f32";
+    case GV_F32_TO_F16: return "f32_to_f16";
+    case GV_F16_ADD: return "f16_add";
+    case GV_F16_SUB: return "f16_sub";
+    case GV_F16_MUL: return "f16_mul";
+    case GV_F16_DIV: return "f16_div";
+    case GV_F16_FMA: return "f16_fma";
+    case GV_F64_ADD: return "f64_add";
+    case GV_F64_SUB: return "f64_sub";
+    case GV_F64_MUL: return "f64_mul";
+    case GV_F64_DIV: return "f64_div";
+    case GV_F32_TO_F64: return "f32_to_f64";
+    case GV_F64_TO_F32: return "f64_to_f32";
+    case GV_DD_ADD: return "dd_add";
+    case GV_DD_MUL: return "dd_mul";
+    case GV_DD_TWO_PROD: return "dd_two_prod";
+    case GV_E4M3_TO_F32: return "e4m3_to_f32";
+    case GV_E5M2_TO_F32: return "e5m2_to_f32";
+    case GV_F32_TO_E4M3: return "f32_to_e4m3";
+    case GV_F32_TO_E5M2: return "f32_to_e5m2";
+    case GV_VM_EXP: return "vm_exp";
+    case GV_VM_LOG: return "vm_log";
+    case GV_VM_TANH: return "vm_tanh";
+    case GV_VM_SIGMOID: return "vm_sigmoid";
+    case GV_VM_ERF: return "vm_erf";
+    case GV_VM_EXPF: return "vm_expf";
+    case GV_VM_LOGF: return "vm_logf";
+    case GV_VM_TANHF: return "vm_tanhf";
+    case GV_VM_SIGMOIDF: return "vm_sigmoidf";
+    case GV_VM_ERFF: return "vm_erff";
+    default: return "?";
+    }
+}
+
+static void put_le(uint8_t *p, uint64_t v, unsigned bytes) {
+    for (unsigned i = 0; i < bytes; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static uint64_t get_le(const uint8_t *p, unsigned bytes) {
+    uint64_t v = 0;
+    for (unsigned i = 0; i < bytes; i++) v |= (uint64_t)p[i] << (8 * i);
+    return v;
+}
+
+static int valid_width(unsigned b) { return b == 1 || b == 2 || b == 4 || b == 8; }
+
+// ============================================================================
+// Writer
+// ============================================================================
+
+struct gv_writer {
+    FILE *fp;
+    int failed;
+    long long total;
+    // current op
+    unsigned op, n_in, n_out, in_bytes, out_bytes;
+    size_t record_bytes;
+    uint8_t *buf;                // up to GV_CHUNK_RECORDS records
+    uint64_t pending;
+};
+
+static void gv_write(gv_writer *w, const void *p, size_t n) {
+    if (n && fwrite(p, 1, n, w->fp) != n) w->failed = 1;
+}
+
+static void gv_flush(gv_writer *w) {
+    if (w->pending == 0) return;
+    uint8_t h[GV_CHUNK_HEADER_BYTES] = {0};
+    put_le(h, w->op, 2);
+    h[2] = (uint8_t)w->n_in; h[3] = (uint8_t)w->n_out;
+    h[4] = (uint8_t)w->in_bytes; h[5] = (uint8_t)w->out_bytes;
+    put_le(h + 8, w->pending, 8);
+    gv_write(w, h, sizeof(h));
+    size_t body = (size_t)w->pending * w->record_bytes;
+    gv_write(w, w->buf, body);
+    static const uint8_t zero[8] = {0};
+    gv_write(w, zero, (8 - body % 8) % 8);
+    w->total += (long long)w->pending;
+    w->pending = 0;
+}
+
+gv_writer *gv_create(const char *path, const char *tool) {
+    gv_writer *w = calloc(1, sizeof(*w));
+    if (!w) return NULL;
+    w->fp = fopen(path, "wb");
+    if (!w->fp) { int e = errno; free(w); errno = e; return NULL; }
+    setvbuf(w->fp, NULL, _IOFBF, 1 << 20);
+    uint8_t h[GV_HEADER_BYTES] = {0};
+    memcpy(h, gv_magic, 8);
+    put_le(h + 8, GV_VERSION, 4);
+    put_le(h + 12, GV_HEADER_BYTES, 4);
+    if (tool) memcpy(h + 16, tool, strnlen(tool, 31));
+    gv_write(w, h, sizeof(h));
+    return w;
+}
+
+void gv_begin(gv_writer *w, gv_op op, unsigned n_in, unsigned in_bytes, unsigned n_out, unsigned out_bytes) {
+    gv_flush(w);
+    if (n_in + n_out == 0 || n_in + n_out > GV_MAX_VALUES
+        || (n_in && !valid_width(in_bytes)) || (n_out && !valid_width(out_bytes))) {
+        fprintf(stderr, "golden_vectors: bad record shape for %s\n", gv_op_name(op));
+        w->failed = 1;
+        n_in = n_out = 0;
+    }
+    size_t rb = (size_t)n_in * in_bytes + (size_t)n_out * out_bytes;
+    if (rb > w->record_bytes) {
+        uint8_t *nb = realloc(w->buf, rb * GV_CHUNK_RECORDS);
+        if (!nb) { w->failed = 1; n_in = n_out = 0; rb = 0; }
+        else w->buf = nb;
+    }
+    w->op = op; w->n_in = n_in; w->n_out = n_out;
+    w->in_bytes = in_bytes; w->out_bytes = out_bytes;
+    w->record_bytes = rb;
+}
+
+void gv_put(gv_writer *w, const uint64_t *vals) {
+    if (w->record_bytes == 0) { w->failed = 1; return; }
+    uint8_t *p = w->buf + (size_t)w->pending * w->record_bytes;
+    for (unsigned k = 0; k < w->n_in; k++, p += w->in_bytes) put_le(p, vals[k], w->in_bytes);
+    for (unsigned k = 0; k < w->n_out; k++, p += w->out_bytes) put_le(p, vals[w->n_in + k], w->out_bytes);
+    if (++w->pending == GV_CHUNK_RECORDS) gv_flush(w);
+}
+
+long long gv_close(gv_writer *w) {
+    gv_flush(w);
+    if (fclose(w->fp) != 0) w->failed = 1;
+    long long r = w->failed ? -1 : w->total;
+    free(w->buf);
+    free(w);
+    return r;
+}
+
+// ============================================================================
+// Reader
+// ============================================================================
+
+int gv_open(gv_file *f, const char *path) {
+    memset(f, 0, sizeof(*f));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (uint64_t)st.st_size < GV_HEADER_BYTES) { close(fd); errno = EINVAL; return -1; }
+    void *p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return -1;
+    f->base = p;
+    f->size = (size_t)st.st_size;
+    uint32_t hb = (uint32_t)get_le(f->base + 12, 4);
+    if (memcmp(f->base, gv_magic, 8) != 0 || get_le(f->base + 8, 4) != GV_VERSION
+        || hb < GV_HEADER_BYTES || hb % 8 != 0 || hb > f->size) {
+        gv_unmap(f);
+        errno = EINVAL;
+        return -1;
+    }
+    memcpy(f->tool, f->base + 16, 32);
+    f->next = hb;
+    return 0;
+}
+
+int gv_next(gv_file *f, gv_chunk *c) {
+    if (f->next == f->size) return 0;
+    if (f->size - f->next < GV_CHUNK_HEADER_BYTES) return -1;
+    const uint8_t *h = f->base + f->next;
+    c->op = (unsigned)get_le(h, 2);
+    c->n_in = h[2]; c->n_out = h[3];
+    c->in_bytes = h[4]; c->out_bytes = h[5];
+    c->count = get_le(h + 8, 8);
+    if (c->n_in + c->n_out == 0 || c->n_in + c->n_out > GV_MAX_VALUES
+        || (c->n_in && !valid_width(c->in_bytes)) || (c->n_out && !valid_width(c->out_bytes)))
+        return -1;
+    c->record_bytes = (size_t)c->n_in * c->in_bytes + (size_t)c->n_out * c->out_bytes;
+    size_t room = f->size - f->next - GV_CHUNK_HEADER_BYTES;
+    if (c->count > room / c->record_bytes) return -1;
+    size_t body = (size_t)c->count * c->record_bytes;
+    size_t padded = body + (8 - body % 8) % 8;
+    if (padded > room) return -1;
+    c->records = h + GV_CHUNK_HEADER_BYTES;
+    f->next += GV_CHUNK_HEADER_BYTES + padded;
+    return 1;
+}
+
+uint64_t gv_value(const gv_chunk *c, uint64_t i, unsigned k) {
+    const uint8_t *p = c->records + (size_t)i * c->record_bytes;
+    if (k < c->n_in) return get_le(p + (size_t)k * c->in_bytes, c->in_bytes);
+    return get_le(p + (size_t)c->n_in * c->in_bytes + (size_t)(k - c->n_in) * c->out_bytes, c->out_bytes);
+}
+
+void gv_unmap(gv_file *f) {
+    if (f->base) munmap((void *)f->base, f->size);
+    f->base = NULL;
+    f->size = f->next = 0;
+}
+
+long long gv_list(const char *path) {
+    gv_file f;
+    if (gv_open(&f, path) != 0) { printf("%s: not a golden-vector file\n", path); return -1; }
+    gv_chunk c;
+    long long total = 0;
+    unsigned op = 0;
+    uint64_t run = 0;
+    int r;
+    while ((r = gv_next(&f, &c)) == 1) {
+        if (run && c.op != op) { printf("  %-12s %llu\n", gv_op_name(op), (unsigned long long)run); run = 0; }
+        op = c.op;
+        run += c.count;
+        total += (long long)c.count;
+    }
+    if (run) printf("  %-12s %llu\n", gv_op_name(op), (unsigned long long)run);
+    if (r < 0) { printf("%s: malformed chunk at offset %zu\n", path, f.next); total = -1; }
+    else printf("%s: %lld records from %s, %zu bytes\n", path, total, f.tool, f.size);
+    gv_unmap(&f);
+    return total;
+}
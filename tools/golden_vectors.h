@@ -0,0 +1,151 @@
+/**
+ * golden_vectors.h - Binary golden-vector files for the C reference tools
+ *
+ * The spot checks write their vectors here as fixed-width bit patterns so
+ * the Kotlin tests can memory-map them instead of parsing text. All
+ * integers are little-endian.
+ *
+ * File layout:
+ *   header  48 bytes
+ *     0  char[8]  magic "GOLDVEC\0"
+ *     8  u32      version (GV_VERSION)
+ *     12 u32      header size (48; readers skip to this offset)
+ *     16 char[32] writing tool, NUL-padded
+ *   chunks, each 8-byte aligned, until end of file
+ *     0  u16      op (gv_op)
+ *     2  u8       inputs per record
+ *     3  u8       outputs per record
+ *     4  u8       bytes per input (1, 2, 4 or 8)
+ *     5  u8       bytes per output
+ *     6  u16      zero
+ *     8  u64      record count
+ *     16 records: the inputs, then the outputs, each value's raw bits;
+ *        then zero padding up to a multiple of 8 bytes
+ *
+ * Arithmetic ops store a NaN result as the positive quiet NaN with no
+ * payload. Which NaN operand propagates, and so its sign, depends on the
+ * ISA and on operand order in generated code; compare NaN results by class.
+ *
+ * An op may span several chunks (the writer streams at most
+ * GV_CHUNK_RECORDS per chunk); a reader concatenates them in file order.
+ * Records start 16 bytes into a chunk, so each value is naturally aligned
+ * when every value in a record has the same width.
+ */
+
+#ifndef GOLDEN_VECTORS_H
+#define GOLDEN_VECTORS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define GV_VERSION 1
+#define GV_HEADER_BYTES 48
+#define GV_CHUNK_HEADER_BYTES 16
+#define GV_CHUNK_RECORDS (1u << 16)
+#define GV_MAX_VALUES 8          // inputs + outputs per record
+
+// Op ids are part of the format: append, never renumber.
+typedef enum {
+    // float16_spotcheck: f16 bits as u16, f32 bits as u32
+    GV_F16_TO_F32 = 1,           // f16 -> f32
+    GV_F32_TO_F16 = 2,           // f32 -> f16
+    GV_F16_ADD = 3,              // f16 a, b -> f16: widen, f32 op, narrow
+    GV_F16_SUB = 4,
+    GV_F16_MUL = 5,
+    GV_F16_DIV = 6,
+    GV_F16_FMA = 7,              // f16 a, b, c -> f16: a * b + c rounded once
+    // float64_spotcheck: f32 bits as u32, f64 bits as u64
+    GV_F64_ADD = 16,             // f64 a, b -> f64
+    GV_F64_SUB = 17,
+    GV_F64_MUL = 18,
+    GV_F64_DIV = 19,
+    GV_F32_TO_F64 = 20,          // f32 -> f64
+    GV_F64_TO_F32 = 21,          // f64 -> f32
+    // float128_bitcompare: double-double values as (hi, lo) u64 pairs
+    GV_DD_ADD = 32,              // a.hi, a.lo, b.hi, b.lo -> hi, lo
+    GV_DD_MUL = 33,              // the four-product dd_mul of float128_benchmark.c
+    GV_DD_TWO_PROD = 34,         // f64 a, b -> exact product as (hi, lo)
+    // fp8_spotcheck: OCP FP8 codes as u8, f32 bits as u32
+    GV_E4M3_TO_F32 = 48,         // e4m3 -> f32
+    GV_E5M2_TO_F32 = 49,         // e5m2 -> f32
+    GV_F32_TO_E4M3 = 50,         // f32 -> e4m3 with FP8_NOSAT, then FP8_SATFINITE
+    GV_F32_TO_E5M2 = 51,
+    // vmath_spotcheck: f64 bits as u64, f32 bits as u32
+    GV_VM_EXP = 64,              // f64 x -> f64 vm_exp(x)
+    GV_VM_LOG = 65,
+    GV_VM_TANH = 66,
+    GV_VM_SIGMOID = 67,
+    GV_VM_ERF = 68,
+    GV_VM_EXPF = 69,             // f32 x -> f32 vm_expf(x)
+    GV_VM_LOGF = 70,
+    GV_VM_TANHF = 71,
+    GV_VM_SIGMOIDF = 72,
+    GV_VM_ERFF = 73,
+} gv_op;
+
+// Name of an op for listings, or "?" if unknown
+const char *gv_op_name(unsigned op);
+
+// ---------------------------------------------------------------------------
+// Writer
+// ---------------------------------------------------------------------------
+
+typedef struct gv_writer gv_writer;
+
+// Create path and write the header; NULL (with errno set) on failure
+gv_writer *gv_create(const char *path, const char *tool);
+
+// Start an op: later records have n_in inputs of in_bytes each and n_out
+// outputs of out_bytes each. Flushes the previous op's records.
+void gv_begin(gv_writer *w, gv_op op, unsigned n_in, unsigned in_bytes, unsigned n_out, unsigned out_bytes);
+
+// Append one record: vals holds the n_in inputs, then the n_out outputs
+void gv_put(gv_writer *w, const uint64_t *vals);
+
+// Flush and close; returns the number of records written, or -1 if any
+// write failed (the file is then incomplete)
+long long gv_close(gv_writer *w);
+
+// ---------------------------------------------------------------------------
+// Reader (mmap)
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    unsigned op;
+    unsigned n_in, n_out, in_bytes, out_bytes;
+    size_t record_bytes;
+    uint64_t count;
+    const uint8_t *records;      // count * record_bytes, inside the mapping
+} gv_chunk;
+
+typedef struct {
+    const uint8_t *base;
+    size_t size;
+    size_t next;                 // offset of the next chunk
+    char tool[33];
+} gv_file;
+
+// Map path read-only and check the header; 0, or -1 on error
+int gv_open(gv_file *f, const char *path);
+
+// Next chunk in file order: 1, 0 at the end, or -1 if the file is malformed
+int gv_next(gv_file *f, gv_chunk *c);
+
+// Value k of record i (inputs first, then outputs)
+uint64_t gv_value(const gv_chunk *c, uint64_t i, unsigned k);
+
+void gv_unmap(gv_file *f);
+
+// Map path and print one line per op (chunks merged); returns the total
+// record count, or -1 if the file cannot be read or is malformed
+long long gv_list(const char *path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GOLDEN_VECTORS_H
@@ -0,0 +1,74 @@
+/**
+ * philox.h - Counter-based random bits for the stochastic-rounding kernels
+ *
+ * Included by float16_convert.c and bf16_math.c (and their spot checks).
+ * Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2,
+ * 3", SC'11) is a keyed bijection of a 128-bit counter, so the bits for an
+ * element depend only on the seed and the element's index: a buffer
+ * converted in one call, in pieces, on several threads or by the Kotlin
+ * side gets the same bits. Element i under seed s takes word i % 4 of
+ *
+ *     philox4x32_10(counter = { i / 4 (low, high 32 bits), 0, 0 },
+ *                   key     = { s (low, high 32 bits) })
+ *
+ * which is the Random123 reference algorithm and matches its known-answer
+ * vectors.
+ */
+
+#ifndef PHILOX_H
+#define PHILOX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define PHILOX_M0 0xD2511F53u
+#define PHILOX_M1 0xCD9E8D57u
+#define PHILOX_W0 0x9E3779B9u
+#define PHILOX_W1 0xBB67AE85u
+
+static inline void philox4x32_10(const uint32_t ctr[4], const uint32_t key[2], uint32_t out[4]) {
+    uint32_t c0 = ctr[0], c1 = ctr[1], c2 = ctr[2], c3 = ctr[3];
+    uint32_t k0 = key[0], k1 = key[1];
+    for (int r = 0; r < 10; r++) {
+        uint64_t p0 = (uint64_t)PHILOX_M0 * c0, p1 = (uint64_t)PHILOX_M1 * c2;
+        uint32_t n0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0, n2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+        c1 = (uint32_t)p1; c3 = (uint32_t)p0;
+        c0 = n0; c2 = n2;
+        k0 += PHILOX_W0; k1 += PHILOX_W1;
+    }
+    out[0] = c0; out[1] = c1; out[2] = c2; out[3] = c3;
+}
+
+// The 32 random bits for element `index` under `seed`
+static inline uint32_t philox_bits(uint64_t seed, uint64_t index) {
+    uint32_t ctr[4] = { (uint32_t)(index >> 2), (uint32_t)(index >> 34), 0, 0 };
+    uint32_t key[2] = { (uint32_t)seed, (uint32_t)(seed >> 32) };
+    uint32_t out[4];
+    philox4x32_10(ctr, key, out);
+    return out[index & 3];
+}
+
+// Bits for elements index .. index + 4 * groups - 1, index a multiple of 4.
+// Written lane-parallel over groups so compilers can vectorize it (the
+// 32 x 32 -> 64 multiplies map to pmuludq / umull).
+static inline void philox_fill(uint64_t seed, uint64_t index, size_t groups, uint32_t *bits) {
+    uint32_t key0 = (uint32_t)seed, key1 = (uint32_t)(seed >> 32);
+    uint64_t g0 = index >> 2;
+    for (size_t g = 0; g < groups; g++) {
+        uint32_t c0 = (uint32_t)(g0 + g), c1 = (uint32_t)((g0 + g) >> 32), c2 = 0, c3 = 0;
+        uint32_t k0 = key0, k1 = key1;
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC unroll 10
+#endif
+        for (int r = 0; r < 10; r++) {
+            uint64_t p0 = (uint64_t)PHILOX_M0 * c0, p1 = (uint64_t)PHILOX_M1 * c2;
+            uint32_t n0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0, n2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+            c1 = (uint32_t)p1; c3 = (uint32_t)p0;
+            c0 = n0; c2 = n2;
+            k0 += PHILOX_W0; k1 += PHILOX_W1;
+        }
+        bits[4 * g] = c0; bits[4 * g + 1] = c1; bits[4 * g + 2] = c2; bits[4 * g + 3] = c3;
+    }
+}
+
+#endif // PHILOX_H
@@ -0,0 +1,307 @@
+/**
+ * spotcheck_sweep.h - Exhaustive conversion checks shared by the 16-bit spot checks
+ *
+ * Included by float16_spotcheck.c and bf16_spotcheck.c (link with -pthread).
+ * Every input of a 16-bit <-> f32 conversion goes through the bulk (SIMD)
+ * kernel and the scalar reference, and optionally through a table exported
+ * from the Kotlin implementation. All three must agree bit for bit.
+ *
+ * Kotlin table formats (little-endian, no header):
+ *   widen:  65536 x uint32, f32 bits for each 16-bit input 0..65535
+ *   narrow: uint16 per f32 input 0, 1, 2, ...; any prefix. The full space
+ *           is 8 GiB; inputs past the end are checked without Kotlin.
+ *
+ * The 2^32 f32 inputs are split into contiguous slices, one per thread.
+ *
+ * sweep_sr checks the stochastic-rounding kernels (philox.h bits).
+ */
+
+#ifndef SPOTCHECK_SWEEP_H
+#define SPOTCHECK_SWEEP_H
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "philox.h"
+
+#define SWEEP_SHOW 8            // mismatches printed per sweep
+#define SWEEP_CHUNK (1u << 16)  // inputs per bulk call
+
+typedef float (*sweep_widen_ref)(uint16_t);
+typedef void (*sweep_widen_bulk)(size_t, const uint16_t*, float*);
+typedef uint16_t (*sweep_narrow_ref)(float);
+typedef void (*sweep_narrow_bulk)(size_t, const float*, uint16_t*);
+
+typedef struct {
+    uint32_t in, ref, simd, kotlin;
+    int has_kotlin;
+} sweep_miss;
+
+static double sweep_now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static float sweep_f32(uint32_t u) { float f; memcpy(&f, &u, 4); return f; }
+static uint32_t sweep_bits(float f) { uint32_t u; memcpy(&u, &f, 4); return u; }
+
+static void sweep_print_miss(const sweep_miss *m, int in_digits, int out_digits) {
+    printf("  0x%0*X -> reference 0x%0*X, simd 0x%0*X", in_digits, m->in,
+           out_digits, m->ref, out_digits, m->simd);
+    if (m->has_kotlin) printf(", kotlin 0x%0*X", out_digits, m->kotlin);
+    printf("\n");
+}
+
+// Read exactly len bytes at off; -1 on error or end of file
+static int sweep_pread(int fd, void *buf, size_t len, uint64_t off) {
+    uint8_t *p = (uint8_t *)buf;
+    while (len > 0) {
+        ssize_t r = pread(fd, p, len, (off_t)off);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return -1;
+        p += r; len -= (size_t)r; off += (uint64_t)r;
+    }
+    return 0;
+}
+
+// All 65536 16-bit inputs -> f32. Returns the number of mismatching inputs.
+static size_t sweep_widen(const char *name, sweep_widen_ref ref, sweep_widen_bulk bulk, const char *kotlin_path) {
+    uint16_t *h = (uint16_t *)malloc(65536 * sizeof(*h));
+    float *f = (float *)malloc(65536 * sizeof(*f));
+    uint8_t *k = kotlin_path ? (uint8_t *)malloc(65536 * 4) : NULL;
+    if (!h || !f || (kotlin_path && !k)) { printf("  (allocation failed)\n"); exit(1); }
+    if (kotlin_path) {
+        int fd = open(kotlin_path, O_RDONLY);
+        if (fd < 0 || sweep_pread(fd, k, 65536 * 4, 0) != 0) {
+            printf("%s: cannot read 65536 entries from Kotlin table %s\n", name, kotlin_path);
+            exit(1);
+        }
+        close(fd);
+    }
+    for (uint32_t i = 0; i < 65536; i++) h[i] = (uint16_t)i;
+    bulk(65536, h, f);
+    size_t bad = 0;
+    for (uint32_t i = 0; i < 65536; i++) {
+        sweep_miss m = { i, sweep_bits(ref(h[i])), sweep_bits(f[i]), 0, k != NULL };
+        if (k) m.kotlin = (uint32_t)k[4 * i] | (uint32_t)k[4 * i + 1] << 8 | (uint32_t)k[4 * i + 2] << 16 | (uint32_t)k[4 * i + 3] << 24;
+        if (m.simd != m.ref || (k && m.kotlin != m.ref)) {
+            if (bad++ < SWEEP_SHOW) sweep_print_miss(&m, 4, 8);
+        }
+    }
+    printf("%s: all 65536 inputs%s, %zu mismatches\n", name, k ? " (with Kotlin table)" : "", bad);
+    free(h); free(f); free(k);
+    return bad;
+}
+
+typedef struct {
+    sweep_narrow_ref ref;
+    sweep_narrow_bulk bulk;
+    int kotlin_fd;              // -1 without a Kotlin table
+    uint64_t kotlin_n;          // inputs the table covers
+    uint64_t lo, hi;            // f32 bit patterns [lo, hi)
+    size_t bad;
+    int nmiss;
+    sweep_miss miss[SWEEP_SHOW];
+    int failed;
+    int threaded;
+} sweep_job;
+
+static void *sweep_narrow_worker(void *arg) {
+    sweep_job *j = (sweep_job *)arg;
+    float *f = (float *)malloc(SWEEP_CHUNK * sizeof(*f));
+    uint16_t *h = (uint16_t *)malloc(SWEEP_CHUNK * sizeof(*h));
+    uint8_t *k = (uint8_t *)malloc(SWEEP_CHUNK * 2);
+    if (!f || !h || !k) { j->failed = 1; goto out; }
+    for (uint64_t base = j->lo; base < j->hi; base += SWEEP_CHUNK) {
+        size_t m = (size_t)(j->hi - base < SWEEP_CHUNK ? j->hi - base : SWEEP_CHUNK);
+        for (size_t i = 0; i < m; i++) f[i] = sweep_f32((uint32_t)(base + i));
+        j->bulk(m, f, h);
+        size_t km = 0;
+        if (j->kotlin_fd >= 0 && base < j->kotlin_n) {
+            km = (size_t)(j->kotlin_n - base < m ? j->kotlin_n - base : m);
+            if (sweep_pread(j->kotlin_fd, k, km * 2, base * 2) != 0) { j->failed = 1; goto out; }
+        }
+        for (size_t i = 0; i < m; i++) {
+            sweep_miss ms = { (uint32_t)(base + i), j->ref(f[i]), h[i], 0, i < km };
+            if (ms.has_kotlin) ms.kotlin = (uint32_t)k[2 * i] | (uint32_t)k[2 * i + 1] << 8;
+            if (ms.simd != ms.ref || (ms.has_kotlin && ms.kotlin != ms.ref)) {
+                if (j->nmiss < SWEEP_SHOW) j->miss[j->nmiss++] = ms;
+                j->bad++;
+            }
+        }
+    }
+out:
+    free(f); free(h); free(k);
+    return NULL;
+}
+
+// All 2^32 f32 inputs -> 16 bits on `threads` threads. Returns the number
+// of mismatching inputs.
+static size_t sweep_narrow(const char *name, sweep_narrow_ref ref, sweep_narrow_bulk bulk,
+                           int threads, const char *kotlin_path) {
+    const uint64_t total = 1ull << 32;
+    int fd = -1;
+    uint64_t kotlin_n = 0;
+    if (kotlin_path) {
+        fd = open(kotlin_path, O_RDONLY);
+        off_t size = fd >= 0 ? lseek(fd, 0, SEEK_END) : -1;
+        if (size < 2) { printf("%s: cannot read Kotlin table %s\n", name, kotlin_path); exit(1); }
+        kotlin_n = (uint64_t)size / 2 < total ? (uint64_t)size / 2 : total;
+    }
+    if (threads < 1) threads = 1;
+    sweep_job *jobs = (sweep_job *)calloc((size_t)threads, sizeof(*jobs));
+    pthread_t *tid = (pthread_t *)calloc((size_t)threads, sizeof(*tid));
+    if (!jobs || !tid) { printf("  (allocation failed)\n"); exit(1); }
+
+    double t0 = sweep_now_s();
+    // slices rounded to whole chunks so the bulk kernels see full blocks
+    uint64_t slice = (total / (uint64_t)threads + SWEEP_CHUNK - 1) / SWEEP_CHUNK * SWEEP_CHUNK;
+    for (int t = 0; t < threads; t++) {
+        sweep_job *j = &jobs[t];
+        j->ref = ref; j->bulk = bulk; j->kotlin_fd = fd; j->kotlin_n = kotlin_n;
+        j->lo = (uint64_t)t * slice < total ? (uint64_t)t * slice : total;
+        j->hi = j->lo + slice < total ? j->lo + slice : total;
+        j->threaded = pthread_create(&tid[t], NULL, sweep_narrow_worker, j) == 0;
+        if (!j->threaded) sweep_narrow_worker(j);   // couldn't start: run it here
+    }
+    for (int t = 0; t < threads; t++)
+        if (jobs[t].threaded) pthread_join(tid[t], NULL);
+    double dt = sweep_now_s() - t0;
+
+    size_t bad = 0;
+    int shown = 0;
+    for (int t = 0; t < threads; t++) {
+        if (jobs[t].failed) { printf("%s: worker %d failed (allocation or Kotlin table read)\n", name, t); bad++; }
+        for (int i = 0; i < jobs[t].nmiss && shown < SWEEP_SHOW; i++, shown++)
+            sweep_print_miss(&jobs[t].miss[i], 8, 4);
+        bad += jobs[t].bad;
+    }
+    printf("%s: all %llu inputs", name, (unsigned long long)total);
+    if (fd >= 0) printf(" (Kotlin table covers %llu)", (unsigned long long)kotlin_n);
+    printf(", %zu mismatches; %d threads, %.2f s (%.0f M inputs/s)\n",
+           bad, threads, dt, (double)total / dt * 1e-6);
+    if (fd >= 0) close(fd);
+    free(jobs); free(tid);
+    return bad;
+}
+
+typedef uint16_t (*sweep_sr_ref)(float, uint32_t);
+typedef void (*sweep_sr_bulk)(size_t, const float*, uint16_t*, uint64_t, uint64_t);
+
+// Stochastic rounding. Philox's known-answer vectors (Random123); the bulk
+// kernel against the scalar reference on philox_bits, in one call from an
+// unaligned index and again in pieces of 1 to 67 elements; every result
+// one of the two neighbours of its input (the reference with all-zero and
+// all-one bits), which bracket it; and for each probe value, the mean of
+// 2^16 roundings within 6 standard deviations of the value. Returns the
+// number of failures.
+static size_t sweep_sr(const char *name, sweep_sr_ref ref, sweep_sr_bulk bulk, sweep_widen_ref widen,
+                       const float *probe, int nprobe) {
+    static const uint32_t kat[3][10] = {
+        { 0, 0, 0, 0, 0, 0, 0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 },
+        { ~0u, ~0u, ~0u, ~0u, ~0u, ~0u, 0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd },
+        { 0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344, 0xa4093822, 0x299f31d0,
+          0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1 } };
+    size_t bad = 0;
+    for (int k = 0; k < 3; k++) {
+        uint32_t out[4];
+        philox4x32_10(kat[k], kat[k] + 4, out);
+        if (memcmp(out, kat[k] + 6, sizeof(out)) != 0) {
+            printf("  philox4x32_10 known-answer vector %d: got %08X %08X %08X %08X\n", k, out[0], out[1], out[2], out[3]);
+            bad++;
+        }
+    }
+
+    const size_t n = 1u << 20;
+    const uint64_t seed = 0x5EED5EED12345678ull, index = 1000003;
+    float *f = (float *)malloc(n * sizeof(*f));
+    uint16_t *h = (uint16_t *)malloc(n * sizeof(*h)), *h2 = (uint16_t *)malloc(n * sizeof(*h2));
+    if (!f || !h || !h2) { printf("  (allocation failed)\n"); exit(1); }
+    uint64_t x = 0x9E3779B97F4A7C15ull;
+    for (size_t i = 0; i < n; i++) {
+        x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+        f[i] = i < (size_t)nprobe ? probe[i] : sweep_f32((uint32_t)x);
+    }
+    bulk(n, f, h, seed, index);
+    for (size_t i = 0, piece = 1; i < n; i += piece, piece = piece % 67 + 1)
+        bulk(n - i < piece ? n - i : piece, f + i, h2 + i, seed, index + i);
+    size_t bad_bulk = 0, bad_nb = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint16_t want = ref(f[i], philox_bits(seed, index + i));
+        if ((h[i] != want || h2[i] != want) && bad_bulk++ < SWEEP_SHOW)
+            printf("  0x%08X -> reference 0x%04X, bulk 0x%04X, in pieces 0x%04X\n", sweep_bits(f[i]), want, h[i], h2[i]);
+        // lo == hi: NaN, exact, overflowed, or too small to ever round up
+        uint16_t lo = ref(f[i], 0), hi = ref(f[i], ~0u);
+        int bracket = lo == hi || (fabsf(widen(lo)) <= fabsf(f[i]) && fabsf(f[i]) <= fabsf(widen(hi)));
+        if ((!bracket || (want != lo && want != hi)) && bad_nb++ < SWEEP_SHOW)
+            printf("  0x%08X -> 0x%04X, neighbours 0x%04X 0x%04X\n", sweep_bits(f[i]), want, lo, hi);
+    }
+    printf("%s: %zu inputs, %zu bulk mismatches, %zu outside their neighbours\n", name, n, bad_bulk, bad_nb);
+    bad += bad_bulk + bad_nb;
+
+    const int timing_reps = 20;
+    double t0 = sweep_now_s();
+    for (int r = 0; r < timing_reps; r++) bulk(n, f, h, seed, index);
+    double t_bulk = (sweep_now_s() - t0) / timing_reps;
+    t0 = sweep_now_s();
+    for (size_t i = 0; i < n; i++) h2[i] = ref(f[i], philox_bits(seed, index + i));
+    double t_ref = sweep_now_s() - t0;
+    printf("%s: %.2f ns/elem, reference scalar %.2f ns/elem\n", name, t_bulk / n * 1e9, t_ref / n * 1e9);
+
+    const size_t reps = 1u << 16;
+    for (int p = 0; p < nprobe; p++) {
+        for (size_t i = 0; i < reps; i++) f[i] = probe[p];
+        bulk(reps, f, h, seed + (uint64_t)p, 0);
+        double sum = 0;
+        for (size_t i = 0; i < reps; i++) sum += widen(h[i]);
+        double lo = widen(ref(probe[p], 0)), hi = widen(ref(probe[p], ~0u)), v = probe[p];
+        double gap = fabs(hi - lo), q = gap > 0 ? fabs(v - lo) / gap : 0, mean = sum / (double)reps;
+        double tol = 6 * gap * sqrt(q * (1 - q) / (double)reps) + gap * 0x1p-12;
+        int ok = fabs(mean - v) <= tol;
+        printf("  %-14.8g mean of %zu roundings %.8g (neighbours %.8g, %.8g)%s\n", v, reps, mean, lo, hi,
+               ok ? "" : "  BIASED");
+        bad += !ok;
+    }
+    free(f); free(h); free(h2);
+    return bad;
+}
+
+// Parse the shared options; returns 0, or -1 on an unknown option
+typedef struct {
+    int exhaustive;
+    int threads;
+    const char *kotlin_widen;
+    const char *kotlin_narrow;
+    const char *golden;         // --golden FILE: write binary vectors
+} sweep_opts;
+
+static int sweep_parse(int argc, char **argv, const char *widen_opt, const char *narrow_opt, sweep_opts *o) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    o->exhaustive = 0;
+    o->threads = n > 0 ? (int)n : 1;
+    o->kotlin_widen = o->kotlin_narrow = o->golden = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--exhaustive") == 0) o->exhaustive = 1;
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) o->threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], widen_opt) == 0 && i + 1 < argc) o->kotlin_widen = argv[++i];
+        else if (strcmp(argv[i], narrow_opt) == 0 && i + 1 < argc) o->kotlin_narrow = argv[++i];
+        else if (strcmp(argv[i], "--golden") == 0 && i + 1 < argc) o->golden = argv[++i];
+        else {
+            fprintf(stderr, "usage: %s [--exhaustive] [--threads N] [%s FILE] [%s FILE] [--golden FILE]\n",
+                    argv[0], widen_opt, narrow_opt);
+            return -1;
+        }
+    }
+    if (o->kotlin_narrow) o->exhaustive = 1;
+    return 0;
+}
+
+#endif // SPOTCHECK_SWEEP_H
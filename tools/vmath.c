@@ -0,0 +1,446 @@
+/**
+ * vmath.c - Bit-exact exp, log, tanh, sigmoid and erf in f32 and f64, scalar and bulk
+ *
+ * Shared library for cinterop:
+ *   gcc -std=c11 -O2 -shared -fPIC -o libvmath.so vmath.c
+ *
+ * Every function is one branch-free inline kernel, written with IEEE
+ * +, -, *, / in round-to-nearest and integer bit operations only, so each
+ * step rounds the same way on every IEEE host. The scalar entry points
+ * call the kernel directly; the bulk entry points declared in vmath.h run
+ * it in a loop compiled once per kernel set (portable, and AVX2 and
+ * AVX-512 on x86-64), which compilers vectorize. Special values come out
+ * of the same code through bit selects. Nothing calls libm.
+ *
+ * - exp: fdlibm's reduction x = k ln2 + r (ln2 split so k ln2_hi is
+ *   exact) and its rational form of e^r, then 2^k applied as two factors
+ *   so results that underflow round once.
+ * - log: fdlibm/musl's reduction to m in [sqrt(2)/2, sqrt(2)) and its
+ *   Lg1..Lg7 polynomial in s = (m - 1) / (m + 1); subnormals are scaled
+ *   by 2^54 first.
+ * - tanh: |x| < 0.625 uses x + x^3 T(x^2), T a degree 11 fit; above
+ *   that 1 - 2 / (e^2|x| + 1), with |x| capped at 22, past which the
+ *   result rounds to 1.
+ * - sigmoid: e = e^-|x|, then 1 / (1 + e) or e / (1 + e).
+ * - erf: |x| < 1 uses x + x P(x^2), P a degree 12 fit; 1 <= |x| <= 6
+ *   uses 1 - e^-x^2 erfcx(|x|), erfcx (e^x^2 erfc x) fitted by degree 14
+ *   polynomials on four pieces, selected per lane; past 6 erf rounds to 1.
+ * - f32: evaluated in f64 and rounded once. expf uses a degree 9 fit of
+ *   e^r on the same reduction, logf the series 2 atanh(s) to s^13, tanhf
+ *   and sigmoidf the expf core (tanhf an odd series below 2^-7), and erff
+ *   the f64 erf.
+ *
+ * The fits are Chebyshev interpolants computed in binary128, converted to
+ * monomials and rounded to double; their relative errors are 2^-53.8
+ * (T), 2^-55.5 (P), 2^-51.6 to 2^-54.3 (erfcx, where e^-x^2 is below
+ * 0.37) and 2^-45.6 (expf). vmath_spotcheck measures the ulp errors
+ * against a higher-precision reference and checks every kernel set
+ * against the scalar functions.
+ */
+
+/* An FMA rounds once where the code rounds twice, so contraction would
+ * change the bits from one host to the next: never contract, whatever
+ * -ffp-contract the build uses. */
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+#include <stdint.h>
+#include <string.h>
+#include "cpu_features.h"
+#include "vmath.h"
+
+// ============================================================================
+// Helpers
+// ============================================================================
+
+// All ones when c holds, else zero
+#define VM_MASK(c) (0 - (uint64_t)(c))
+#define VM_SELECT(c, a, b) (((a) & VM_MASK(c)) | ((b) & ~VM_MASK(c)))
+
+#define VM_VECTORIZE CPU_VECTORIZE_WITH("fp-contract=off")
+
+#define VM_INLINE static inline __attribute__((always_inline))
+
+#define VM_SIGN 0x8000000000000000ull
+#define VM_ABS 0x7FFFFFFFFFFFFFFFull
+#define VM_INF 0x7FF0000000000000ull
+#define VM_QUIET 0x0008000000000000ull
+#define VM_NAN 0x7FF8000000000000ull
+
+// Adding then subtracting 1.5 * 2^52 rounds a double below 2^51 in
+// magnitude to an integer (nearest even); its low bits are then that
+// integer plus 2^51
+#define VM_SHIFT 0x1.8p52
+
+VM_INLINE double vm_f64(uint64_t u) { double d; memcpy(&d, &u, 8); return d; }
+VM_INLINE uint64_t vm_bits(double d) { uint64_t u; memcpy(&u, &d, 8); return u; }
+VM_INLINE float vm_f32(uint32_t u) { float f; memcpy(&f, &u, 4); return f; }
+VM_INLINE uint32_t vm_bits32(float f) { uint32_t u; memcpy(&u, &f, 4); return u; }
+
+VM_INLINE double vm_sel(uint64_t c, double a, double b) {
+    return vm_f64(VM_SELECT(c, vm_bits(a), vm_bits(b)));
+}
+
+// 2^k for an integer-valued double k in [-1022, 1023]
+VM_INLINE double vm_pow2(double k) {
+    return vm_f64(vm_bits(k + (1023 + VM_SHIFT)) << 52);
+}
+
+// The f64 result for a NaN input: the input, quieted
+VM_INLINE double vm_nan_in(uint64_t b, double r) {
+    return vm_sel((b & VM_ABS) > VM_INF, vm_f64(b | VM_QUIET), r);
+}
+
+// The f32 result rounded from the f64 one, or for a NaN input the input,
+// quieted
+VM_INLINE float vm_nan_in32(uint32_t b, double r) {
+    uint32_t m = 0u - (uint32_t)((b & 0x7FFFFFFFu) > 0x7F800000u);
+    return vm_f32(((b | 0x400000u) & m) | (vm_bits32((float)r) & ~m));
+}
+
+// ============================================================================
+// Coefficients
+// ============================================================================
+
+// exp and log reduction: ln2 = LN2_HI + LN2_LO, LN2_HI with 32 low zero
+// bits (fdlibm)
+#define VM_LN2_HI 6.93147180369123816490e-01
+#define VM_LN2_LO 1.90821492927058770002e-10
+#define VM_INVLN2 1.44269504088896338700e+00
+#define VM_LN2 0x1.62e42fefa39efp-1
+
+// fdlibm e_exp.c: e^r = 1 + 2r / (2 - c), c = r - r^2 P(r^2)
+#define VM_EXP_P1 1.66666666666666019037e-01
+#define VM_EXP_P2 -2.77777777770155933842e-03
+#define VM_EXP_P3 6.61375632143793436117e-05
+#define VM_EXP_P4 -1.65339022054652515390e-06
+#define VM_EXP_P5 4.13813679705723846039e-08
+
+// fdlibm e_log.c: log(1 + f) = f - f^2/2 + s (f^2/2 + R(s^2))
+#define VM_LG1 6.666666666666735130e-01
+#define VM_LG2 3.999999999940941908e-01
+#define VM_LG3 2.857142874366239149e-01
+#define VM_LG4 2.222219843214978396e-01
+#define VM_LG5 1.818357216161805012e-01
+#define VM_LG6 1.531383769920937332e-01
+#define VM_LG7 1.479819860511658591e-01
+
+// tanh(a) = a + a z T(z), z = a^2 in [0, 0.390625]
+static const double vm_tanh_t[12] = {
+    -0x1.5555555555555p-2, 0x1.11111111110a8p-3, -0x1.ba1ba1ba0f126p-5, 0x1.664f487e0a749p-6,
+    -0x1.226e3473dce5cp-7, 0x1.d6d39ae3905e2p-9, -0x1.7d9f6f23e8682p-10, 0x1.3526e9ed54da1p-11,
+    -0x1.f243823c8c981p-13, 0x1.8445870f6fe41p-14, -0x1.05bbdae896297p-15, 0x1.b33642a122cddp-18,
+};
+
+// erf(a) = a + a P(z), z = a^2 in [0, 1]
+static const double vm_erf_p[13] = {
+    0x1.06eba8214db69p-3, -0x1.812746b0379e6p-2, 0x1.ce2f21a042b3p-4, -0x1.b82ce31284ep-6,
+    0x1.565bcd0dbaa38p-8, -0x1.c02db3dac435fp-11, 0x1.f9a321d5b8e1ep-14, -0x1.f4d1e3183f7aep-17,
+    0x1.b9df224ca4b97p-20, -0x1.5f1ecb6f0764cp-23, 0x1.f7b4bf3b13964p-27, -0x1.389d4f2641625p-30,
+    0x1.05ffd737fb32ep-34,
+};
+
+// erfcx(a) = e^(a^2) erfc(a) on [1, 1.75), [1.75, 2.75), [2.75, 4) and
+// [4, 6]: the piece's center c, then the coefficients in t = a - c
+static const double vm_erfcx[4][16] = {
+    { 1.375,
+      0x1.5f88f52f3c76bp-2, -0x1.797a639d812ap-3, 0x1.701342cbcea7cp-4, -0x1.4bcdb9d907789p-5,
+      0x1.17eba60d3191bp-6, -0x1.bdf24bce8165ap-8, 0x1.51ab9ffde7c5bp-9, -0x1.e8ae66c4678e7p-11,
+      0x1.535f56eedefa9p-12, -0x1.c5fb77c3ce696p-14, 0x1.254f64e4ed09bp-15, -0x1.6eb842eeb4a55p-17,
+      0x1.bd61ff6ee142cp-19, -0x1.129a2305a0655p-20, 0x1.3b2983a079b26p-22 },
+    { 2.25,
+      0x1.d94446d627932p-3, -0x1.6a70d2bb3741ap-4, 0x1.0615670e25a7fp-5, -0x1.6883f99197543p-7,
+      0x1.da595561f536bp-9, -0x1.2bd251bee91fdp-10, 0x1.6d7743d738356p-12, -0x1.aed7e75b97f38p-14,
+      0x1.ec7738995ac93p-16, -0x1.117bbff4b22dcp-17, 0x1.27b0892f01e53p-19, -0x1.37491a19e8b54p-21,
+      0x1.407d286254039p-23, -0x1.559037ce3cdeep-25, 0x1.4fc76a0514537p-27 },
+    { 3.375,
+      0x1.48f8f10299b71p-3, -0x1.696d353f008bep-5, 0x1.804cc1571418fp-7, -0x1.8c84c13af858p-9,
+      0x1.8de5f26a7bce3p-11, -0x1.85118473436a5p-13, 0x1.7350e3a47634ep-15, -0x1.5a613442105e3p-17,
+      0x1.3c3b6c40eeb4fp-19, -0x1.1ae1ed5765717p-21, 0x1.f05daaf4d17b4p-24, -0x1.aaccc799a5beep-26,
+      0x1.6931c989564fcp-28, -0x1.3fcbe226d243cp-30, 0x1.05512bbe6310bp-32 },
+    { 5.0,
+      0x1.c57239e943d1ap-4, -0x1.5d843497d4fbdp-6, 0x1.08cf82b79a16fp-8, -0x1.8abc1986e18d5p-11,
+      0x1.219f2c333b21ep-13, -0x1.a2a81d58516b8p-16, 0x1.2a41154ebc4ffp-18, -0x1.a3191e610f961p-21,
+      0x1.228a6553f0086p-23, -0x1.8db506f490dcap-26, 0x1.0ccd2c6bc386fp-28, -0x1.6575a22fb4da9p-31,
+      0x1.d7f25f1e45e74p-34, -0x1.54d44fc7a23fcp-36, 0x1.b712a9471cf9fp-39 },
+};
+
+// e^r for |r| <= ln2 / 2, the f32 functions' core
+static const double vm_expf_p[10] = {
+    0x1.000000000003dp+0, 0x1.0000000000006p+0, 0x1.ffffffffe74e2p-2, 0x1.5555555550d85p-3,
+    0x1.55555588b9b63p-5, 0x1.11111123bf9d3p-7, 0x1.6c162bb502de9p-10, 0x1.a01994c63932ap-13,
+    0x1.a17df439313c3p-16, 0x1.72e10a3c9d761p-19,
+};
+
+// 1/3, 1/5, ..., 1/13
+static const double vm_atanh_s[6] = {
+    0x1.5555555555555p-2, 0x1.999999999999ap-3, 0x1.2492492492492p-3,
+    0x1.c71c71c71c71cp-4, 0x1.745d1745d1746p-4, 0x1.3b13b13b13b14p-4,
+};
+
+// ============================================================================
+// Kernels
+// ============================================================================
+
+// Horner's rule, highest coefficient first; spelled out so the loops
+// below stay free of inner loops and vectorize
+#define VM_H4(c, x) ((((c)[3] * (x) + (c)[2]) * (x) + (c)[1]) * (x) + (c)[0])
+#define VM_H6(c, x) ((VM_H4((c) + 2, x) * (x) + (c)[1]) * (x) + (c)[0])
+#define VM_H10(c, x) (VM_H6((c) + 4, x) * (x) * (x) * (x) * (x) + VM_H4(c, x))
+
+// e^x for non-NaN x: e^r 2^k with k = round(x / ln2)
+VM_INLINE double vm_exp_core(double x) {
+    // e^-746 rounds to 0 and e^710 overflows
+    x = vm_sel(x > 710.0, 710.0, x);
+    x = vm_sel(x < -746.0, -746.0, x);
+    double kd = (x * VM_INVLN2 + VM_SHIFT) - VM_SHIFT;
+    double hi = x - kd * VM_LN2_HI;
+    double lo = kd * VM_LN2_LO;
+    double r = hi - lo;
+    double t = r * r;
+    double c = r - t * (VM_EXP_P1 + t * (VM_EXP_P2 + t * (VM_EXP_P3 + t * (VM_EXP_P4 + t * VM_EXP_P5))));
+    double y = 1.0 - ((lo - (r * c) / (2.0 - c)) - hi);
+    // k is in [-1076, 1024]: two halves keep each factor normal and round
+    // a subnormal result once
+    double k1 = (kd * 0.5 + VM_SHIFT) - VM_SHIFT;
+    return y * vm_pow2(k1) * vm_pow2(kd - k1);
+}
+
+VM_INLINE double vm_exp_k(double x) {
+    return vm_nan_in(vm_bits(x), vm_exp_core(x));
+}
+
+VM_INLINE double vm_log_k(double x) {
+    uint64_t b = vm_bits(x);
+    // Subnormals: scale into the normals by 2^54 and take 54 off k
+    uint64_t sub = (b & VM_ABS) < 0x0010000000000000ull;
+    uint64_t u = VM_SELECT(sub, vm_bits(x * 0x1p54), b);
+    // x = 2^k m with m in [sqrt(2)/2, sqrt(2)); f = m - 1 is exact
+    u += 0x3FF0000000000000ull - 0x3FE6A09E667F3BCDull;
+    double dk = (vm_f64(0x4330000000000000ull | (u >> 52)) - 0x1p52) - vm_sel(sub, 1077.0, 1023.0);
+    double m = vm_f64((u & 0x000FFFFFFFFFFFFFull) + 0x3FE6A09E667F3BCDull);
+    double f = m - 1.0;
+    double hfsq = 0.5 * f * f;
+    double s = f / (2.0 + f);
+    double z = s * s;
+    double w = z * z;
+    double t1 = w * (VM_LG2 + w * (VM_LG4 + w * VM_LG6));
+    double t2 = z * (VM_LG1 + w * (VM_LG3 + w * (VM_LG5 + w * VM_LG7)));
+    double r = s * (hfsq + t1 + t2) + dk * VM_LN2_LO - hfsq + f + dk * VM_LN2_HI;
+    r = vm_sel(b >= VM_SIGN, vm_f64(VM_NAN), r);
+    r = vm_sel((b & VM_ABS) == 0, vm_f64(VM_INF | VM_SIGN), r);
+    r = vm_sel(b == VM_INF, x, r);
+    return vm_nan_in(b, r);
+}
+
+VM_INLINE double vm_tanh_k(double x) {
+    uint64_t b = vm_bits(x);
+    double a = vm_f64(b & VM_ABS);
+    double z = a * a;
+    double t = VM_H6(vm_tanh_t + 6, z) * z * z * z * z * z * z + VM_H6(vm_tanh_t, z);
+    double small = a + a * (z * t);
+    double e = vm_exp_core(2.0 * vm_sel(a > 22.0, 22.0, a));
+    double big = 1.0 - 2.0 / (e + 1.0);
+    double r = vm_sel(a < 0.625, small, big);
+    return vm_nan_in(b, vm_f64(vm_bits(r) | (b & VM_SIGN)));
+}
+
+VM_INLINE double vm_sigmoid_k(double x) {
+    uint64_t b = vm_bits(x);
+    double e = vm_exp_core(vm_f64(b | VM_SIGN));
+    double d = 1.0 + e;
+    return vm_nan_in(b, vm_sel(b < VM_SIGN, 1.0 / d, e / d));
+}
+
+// One erfcx coefficient (j = 0 is the center) for the piece a is in
+#define VM_ERFCX(j) vm_sel(i3, vm_erfcx[3][j], vm_sel(i2, vm_erfcx[2][j], vm_sel(i1, vm_erfcx[1][j], vm_erfcx[0][j])))
+
+VM_INLINE double vm_erf_k(double x) {
+    uint64_t b = vm_bits(x);
+    double a = vm_f64(b & VM_ABS);
+    double z = a * a;
+    double p = (VM_H6(vm_erf_p + 7, z) * z + vm_erf_p[6]) * z * z * z * z * z * z + VM_H6(vm_erf_p, z);
+    double small = a + a * p;
+    // c stops at 6, where 1 - erfc already rounds to 1
+    double c = vm_sel(a < 1.0, 1.0, vm_sel(a > 6.0, 6.0, a));
+    uint64_t i1 = c >= 1.75, i2 = c >= 2.75, i3 = c >= 4.0;
+    double t = c - VM_ERFCX(0);
+    double g = VM_ERFCX(15);
+    g = g * t + VM_ERFCX(14);
+    g = g * t + VM_ERFCX(13);
+    g = g * t + VM_ERFCX(12);
+    g = g * t + VM_ERFCX(11);
+    g = g * t + VM_ERFCX(10);
+    g = g * t + VM_ERFCX(9);
+    g = g * t + VM_ERFCX(8);
+    g = g * t + VM_ERFCX(7);
+    g = g * t + VM_ERFCX(6);
+    g = g * t + VM_ERFCX(5);
+    g = g * t + VM_ERFCX(4);
+    g = g * t + VM_ERFCX(3);
+    g = g * t + VM_ERFCX(2);
+    g = g * t + VM_ERFCX(1);
+    double big = 1.0 - vm_exp_core(-(c * c)) * g;
+    double r = vm_sel(a < 1.0, small, big);
+    return vm_nan_in(b, vm_f64(vm_bits(r) | (b & VM_SIGN)));
+}
+
+// e^x for x in f64 with f32 accuracy; x non-NaN
+VM_INLINE double vm_expf_core(double x) {
+    // e^-104 rounds to 0 in f32 and e^89 overflows
+    x = vm_sel(x > 89.0, 89.0, x);
+    x = vm_sel(x < -104.0, -104.0, x);
+    double kd = (x * VM_INVLN2 + VM_SHIFT) - VM_SHIFT;
+    double r = (x - kd * VM_LN2_HI) - kd * VM_LN2_LO;
+    return VM_H10(vm_expf_p, r) * vm_pow2(kd);
+}
+
+VM_INLINE float vm_expf_k(float x) {
+    return vm_nan_in32(vm_bits32(x), vm_expf_core(x));
+}
+
+VM_INLINE float vm_logf_k(float x) {
+    uint32_t b = vm_bits32(x);
+    // Every positive f32 is a normal f64
+    uint64_t u = vm_bits((double)x) + (0x3FF0000000000000ull - 0x3FE6A09E667F3BCDull);
+    double dk = (vm_f64(0x4330000000000000ull | (u >> 52)) - 0x1p52) - 1023.0;
+    double f = vm_f64((u & 0x000FFFFFFFFFFFFFull) + 0x3FE6A09E667F3BCDull) - 1.0;
+    double s = f / (2.0 + f);
+    double z = s * s;
+    double r = dk * VM_LN2 + 2.0 * s * (1.0 + z * VM_H6(vm_atanh_s, z));
+    r = vm_sel(b >= 0x80000000u, vm_f64(VM_NAN), r);
+    r = vm_sel((b & 0x7FFFFFFFu) == 0, vm_f64(VM_INF | VM_SIGN), r);
+    r = vm_sel(b == 0x7F800000u, vm_f64(VM_INF), r);
+    return vm_nan_in32(b, r);
+}
+
+VM_INLINE float vm_tanhf_k(float x) {
+    uint32_t b = vm_bits32(x);
+    double a = vm_f32(b & 0x7FFFFFFFu);
+    double z = a * a;
+    // a - a^3/3 + 2a^5/15 is within 2^-46 below 2^-7
+    double small = a + a * (z * (-0x1.5555555555555p-2 + z * 0x1.1111111111111p-3));
+    double e = vm_expf_core(2.0 * vm_sel(a > 10.0, 10.0, a));
+    double big = 1.0 - 2.0 / (e + 1.0);
+    double r = vm_sel(a < 0x1p-7, small, big);
+    return vm_nan_in32(b, vm_f64(vm_bits(r) | ((uint64_t)(b & 0x80000000u) << 32)));
+}
+
+VM_INLINE float vm_sigmoidf_k(float x) {
+    uint32_t b = vm_bits32(x);
+    double e = vm_expf_core(vm_f32(b | 0x80000000u));
+    double d = 1.0 + e;
+    return vm_nan_in32(b, vm_sel(b < 0x80000000u, 1.0 / d, e / d));
+}
+
+VM_INLINE float vm_erff_k(float x) {
+    return vm_nan_in32(vm_bits32(x), vm_erf_k(x));
+}
+
+// ============================================================================
+// Scalar entry points
+// ============================================================================
+
+double vm_exp(double x) { return vm_exp_k(x); }
+double vm_log(double x) { return vm_log_k(x); }
+double vm_tanh(double x) { return vm_tanh_k(x); }
+double vm_sigmoid(double x) { return vm_sigmoid_k(x); }
+double vm_erf(double x) { return vm_erf_k(x); }
+float vm_expf(float x) { return vm_expf_k(x); }
+float vm_logf(float x) { return vm_logf_k(x); }
+float vm_tanhf(float x) { return vm_tanhf_k(x); }
+float vm_sigmoidf(float x) { return vm_sigmoidf_k(x); }
+float vm_erff(float x) { return vm_erff_k(x); }
+
+// ============================================================================
+// Bulk kernel sets
+// ============================================================================
+
+#define VM_LOOP(fn, T, name, attr)                                                                 \
+    VM_VECTORIZE attr static void vm_##fn##_n_##name(size_t n, const T *src, T *dst) {            \
+        for (size_t i = 0; i < n; i++)                                                            \
+            dst[i] = vm_##fn##_k(src[i]);                                                          \
+    }
+
+#define VM_KERNEL_SET(name, attr)                                                                  \
+    VM_LOOP(exp, double, name, attr)                                                              \
+    VM_LOOP(log, double, name, attr)                                                              \
+    VM_LOOP(tanh, double, name, attr)                                                             \
+    VM_LOOP(sigmoid, double, name, attr)                                                          \
+    VM_LOOP(erf, double, name, attr)                                                              \
+    VM_LOOP(expf, float, name, attr)                                                              \
+    VM_LOOP(logf, float, name, attr)                                                              \
+    VM_LOOP(tanhf, float, name, attr)                                                             \
+    VM_LOOP(sigmoidf, float, name, attr)                                                          \
+    VM_LOOP(erff, float, name, attr)
+
+VM_KERNEL_SET(portable, )
+
+// -DVM_HW=0 leaves only the portable kernels (to check them on any host)
+#ifndef VM_HW
+#define VM_HW 1
+#endif
+
+#if VM_HW && defined(__GNUC__) && defined(__x86_64__)
+#define VM_HAVE_X86 1
+VM_KERNEL_SET(avx2, __attribute__((target("avx2"))))
+VM_KERNEL_SET(avx512, __attribute__((target("avx512f,avx512dq"))))
+#endif
+
+// ============================================================================
+// Dispatch
+// ============================================================================
+
+typedef struct {
+    const char *isa;
+    void (*exp)(size_t, const double*, double*);
+    void (*log)(size_t, const double*, double*);
+    void (*tanh)(size_t, const double*, double*);
+    void (*sigmoid)(size_t, const double*, double*);
+    void (*erf)(size_t, const double*, double*);
+    void (*expf)(size_t, const float*, float*);
+    void (*logf)(size_t, const float*, float*);
+    void (*tanhf)(size_t, const float*, float*);
+    void (*sigmoidf)(size_t, const float*, float*);
+    void (*erff)(size_t, const float*, float*);
+} vm_kernels;
+
+#define VM_KERNELS(isa, name)                                                                      \
+    { isa, vm_exp_n_##name, vm_log_n_##name, vm_tanh_n_##name, vm_sigmoid_n_##name,             \
+      vm_erf_n_##name, vm_expf_n_##name, vm_logf_n_##name, vm_tanhf_n_##name,                    \
+      vm_sigmoidf_n_##name, vm_erff_n_##name }
+
+static const vm_kernels vm_kernels_portable = VM_KERNELS("portable", portable);
+#if VM_HAVE_X86
+static const vm_kernels vm_kernels_avx2 = VM_KERNELS("avx2", avx2);
+static const vm_kernels vm_kernels_avx512 = VM_KERNELS("avx512", avx512);
+#endif
+
+static const vm_kernels *vm_select(void) {
+    const vm_kernels *k = &vm_kernels_portable;
+#if VM_HAVE_X86
+    if (cpu_has(CPU_AVX512F | CPU_AVX512DQ)) k = &vm_kernels_avx512;
+    else if (cpu_has(CPU_AVX2)) k = &vm_kernels_avx2;
+#endif
+    return k;
+}
+
+CPU_DISPATCH(vm_kernels, vm, vm_select)
+
+const char *vm_math_isa(void) {
+    return vm_k()->isa;
+}
+
+void vm_exp_n(size_t n, const double *src, double *dst) { vm_k()->exp(n, src, dst); }
+void vm_log_n(size_t n, const double *src, double *dst) { vm_k()->log(n, src, dst); }
+void vm_tanh_n(size_t n, const double *src, double *dst) { vm_k()->tanh(n, src, dst); }
+void vm_sigmoid_n(size_t n, const double *src, double *dst) { vm_k()->sigmoid(n, src, dst); }
+void vm_erf_n(size_t n, const double *src, double *dst) { vm_k()->erf(n, src, dst); }
+void vm_expf_n(size_t n, const float *src, float *dst) { vm_k()->expf(n, src, dst); }
+void vm_logf_n(size_t n, const float *src, float *dst) { vm_k()->logf(n, src, dst); }
+void vm_tanhf_n(size_t n, const float *src, float *dst) { vm_k()->tanhf(n, src, dst); }
+void vm_sigmoidf_n(size_t n, const float *src, float *dst) { vm_k()->sigmoidf(n, src, dst); }
+void vm_erff_n(size_t n, const float *src, float *dst) { vm_k()->erff(n, src, dst); }
@@ -0,0 +1,61 @@
+/**
+ * C interop header for bit-exact elementary functions (ML activations)
+ */
+
+#ifndef VMATH_H
+#define VMATH_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// exp, log, tanh, sigmoid (1 / (1 + e^-x)) and erf with fixed polynomial
+// coefficients and a fixed evaluation order, using only IEEE +, -, *, /
+// in round-to-nearest and integer bit operations (never an FMA). The
+// results are the same bits on every host, compiler and kernel set,
+// unlike the platform libm's. Errors measured by vmath_spotcheck against
+// a higher-precision reference:
+// - f64: exp and log under 1 ulp, tanh, sigmoid and erf under 2.5 ulp
+// - f32: evaluated in f64 and rounded once to f32, so correctly rounded
+//   except very near a halfway case (under 0.51 ulp)
+// Special values follow C99 Annex F (exp(-inf) = +0, log(+-0) = -inf,
+// log(x < 0) = NaN, tanh(+-inf) = +-1, erf(+-inf) = +-1, ...), results
+// that overflow are infinity and those that underflow are rounded, not
+// flushed. A NaN input comes back quieted, sign and payload kept; a NaN
+// made from a non-NaN input (log of a negative) is the positive quiet NaN.
+double vm_exp(double x);
+double vm_log(double x);
+double vm_tanh(double x);
+double vm_sigmoid(double x);
+double vm_erf(double x);
+float vm_expf(float x);
+float vm_logf(float x);
+float vm_tanhf(float x);
+float vm_sigmoidf(float x);
+float vm_erff(float x);
+
+// dst[i] = f(src[i]) over whole buffers, bit-identical to the scalar
+// functions above. Vectorized, chosen at load time by CPU feature
+// (AVX-512, AVX2, or the portable loop, which is NEON on aarch64). dst
+// may be src; partial overlap is not allowed.
+void vm_exp_n(size_t n, const double *src, double *dst);
+void vm_log_n(size_t n, const double *src, double *dst);
+void vm_tanh_n(size_t n, const double *src, double *dst);
+void vm_sigmoid_n(size_t n, const double *src, double *dst);
+void vm_erf_n(size_t n, const double *src, double *dst);
+void vm_expf_n(size_t n, const float *src, float *dst);
+void vm_logf_n(size_t n, const float *src, float *dst);
+void vm_tanhf_n(size_t n, const float *src, float *dst);
+void vm_sigmoidf_n(size_t n, const float *src, float *dst);
+void vm_erff_n(size_t n, const float *src, float *dst);
+
+// Kernel set in use: "avx512", "avx2" or "portable"
+const char *vm_math_isa(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VMATH_H
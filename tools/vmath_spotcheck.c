@@ -0,0 +1,493 @@
+/**
+ * vmath_spotcheck.c - Accuracy and bit-exactness checks for vmath.c
+ *
+ * Compile: gcc -std=c11 -O2 -pthread -o vmath_spotcheck vmath_spotcheck.c vmath.c golden_vectors.c -lm
+ * Run: ./vmath_spotcheck [--exhaustive] [--threads N] [--golden FILE] [--compare FILE]
+ *
+ * Checks the special values of every function, measures ulp errors
+ * against the C library in long double (f64 functions) or double (f32
+ * functions), checks the bulk kernels against the scalar functions bit for
+ * bit, and times both against libm. Exits 1 if a special value or a bulk
+ * result differs, or an error passes the bound vmath.h states.
+ * --exhaustive runs all 2^32 f32 inputs of each f32 function (bulk against
+ * scalar, and the ulp error); --golden writes the results for a fixed
+ * input set as a binary file (golden_vectors.h), and --compare recomputes
+ * such a file, written on another host, and reports any bit that differs.
+ */
+
+#define _POSIX_C_SOURCE 200809L   // clock_gettime
+#include <float.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "golden_vectors.h"
+#include "vmath.h"
+
+#define SHOW 8                      // mismatches printed per check
+
+static uint64_t f64_bits(double d) { uint64_t u; memcpy(&u, &d, 8); return u; }
+static double bits_f64(uint64_t u) { double d; memcpy(&d, &u, 8); return d; }
+static uint32_t f32_bits(float f) { uint32_t u; memcpy(&u, &f, 4); return u; }
+static float bits_f32(uint32_t u) { float f; memcpy(&f, &u, 4); return f; }
+
+static uint64_t rng = 88172645463325252ull;
+static uint64_t next_rand(void) { rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17; return rng; }
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static long double sigmoidl_ref(long double x) { return 1.0L / (1.0L + expl(-x)); }
+static double sigmoid_ref(double x) { return 1.0 / (1.0 + exp(-x)); }
+static float sigmoidf_libm(float x) { return 1.0f / (1.0f + expf(-x)); }
+
+// Random test inputs: uniform over [lo, hi], or (every other one) a
+// random significand with an exponent uniform in [emin, emax), signed when
+// lo < 0, inside [lo, hi]
+typedef struct {
+    const char *name;
+    double (*f)(double);
+    void (*f_n)(size_t, const double*, double*);
+    long double (*ref)(long double);
+    double (*libm)(double);
+    double lo, hi;
+    int emin, emax;
+    double bound;                   // max ulp error vmath.h states
+    gv_op gv;
+} fn64;
+
+typedef struct {
+    const char *name;
+    float (*f)(float);
+    void (*f_n)(size_t, const float*, float*);
+    double (*ref)(double);
+    float (*libm)(float);
+    double bound;
+    gv_op gv;
+} fn32;
+
+static const fn64 fns64[] = {
+    { "exp", vm_exp, vm_exp_n, expl, exp, -745.2, 709.8, -60, 10, 1.0, GV_VM_EXP },
+    { "log", vm_log, vm_log_n, logl, log, 0x1p-1074, DBL_MAX, -1074, 1024, 1.0, GV_VM_LOG },
+    { "tanh", vm_tanh, vm_tanh_n, tanhl, tanh, -25.0, 25.0, -60, 5, 2.5, GV_VM_TANH },
+    { "sigmoid", vm_sigmoid, vm_sigmoid_n, sigmoidl_ref, sigmoid_ref, -745.0, 745.0, -60, 10, 2.5, GV_VM_SIGMOID },
+    { "erf", vm_erf, vm_erf_n, erfl, erf, -7.0, 7.0, -60, 3, 2.5, GV_VM_ERF },
+};
+#define N_FNS64 (sizeof(fns64) / sizeof(fns64[0]))
+
+static const fn32 fns32[] = {
+    { "expf", vm_expf, vm_expf_n, exp, expf, 0.51, GV_VM_EXPF },
+    { "logf", vm_logf, vm_logf_n, log, logf, 0.51, GV_VM_LOGF },
+    { "tanhf", vm_tanhf, vm_tanhf_n, tanh, tanhf, 0.51, GV_VM_TANHF },
+    { "sigmoidf", vm_sigmoidf, vm_sigmoidf_n, sigmoid_ref, sigmoidf_libm, 0.51, GV_VM_SIGMOIDF },
+    { "erff", vm_erff, vm_erff_n, erf, erff, 0.51, GV_VM_ERFF },
+};
+#define N_FNS32 (sizeof(fns32) / sizeof(fns32[0]))
+
+static double rand_input(const fn64 *fn) {
+    for (;;) {
+        double x;
+        if (next_rand() & 1) {
+            x = fn->lo + (fn->hi - fn->lo) * ((double)(next_rand() >> 11) * 0x1p-53);
+        } else {
+            uint64_t r = next_rand();
+            int e = fn->emin + (int)((r >> 12) % (uint64_t)(fn->emax - fn->emin));
+            x = ldexp(1.0 + (double)(next_rand() >> 12) * 0x1p-52, e);
+            if (fn->lo < 0 && (r & 1)) x = -x;
+        }
+        if (x >= fn->lo && x <= fn->hi) return x;
+    }
+}
+
+// ============================================================================
+// Errors
+// ============================================================================
+
+// |y - r| in units of the last place of r's format, 0 when both are the
+// same infinity or y is the infinity r rounds to, and infinite for a
+// NaN or infinity where r has none (and the reverse)
+static double ulp_err64(double y, long double r) {
+    if (isnan(r) || isnan(y)) return isnan(r) && isnan(y) ? 0 : INFINITY;
+    long double top = 0x1.fffffffffffff8p1023L;   // DBL_MAX + half an ulp
+    if (isinf(y)) return !signbit(y) == !signbit(r) && fabsl(r) >= top ? 0 : INFINITY;
+    if (isinf(r)) return INFINITY;
+    int e = r == 0 ? -1022 : ilogbl(r);
+    long double ulp = ldexpl(1.0L, (e < -1022 ? -1022 : e) - 52);
+    return (double)(fabsl((long double)y - r) / ulp);
+}
+
+static double ulp_err32(float y, double r) {
+    if (isnan(r) || isnan(y)) return isnan(r) && isnan(y) ? 0 : INFINITY;
+    if (isinf(y)) return !signbit(y) == !signbit(r) && fabs(r) >= 0x1.ffffffp127 ? 0 : INFINITY;
+    if (isinf(r)) return INFINITY;
+    int e = r == 0 ? -126 : ilogb(r);
+    double ulp = ldexp(1.0, (e < -126 ? -126 : e) - 23);
+    return fabs((double)y - r) / ulp;
+}
+
+// ============================================================================
+// Special values
+// ============================================================================
+
+// An input and its result, for f64 (the f32 table uses the same values)
+typedef struct { double x, want; } special;
+
+static const special specials_exp[] = {
+    { 0.0, 1.0 }, { -0.0, 1.0 }, { INFINITY, INFINITY }, { -INFINITY, 0.0 }, { DBL_MAX, INFINITY },
+    { -DBL_MAX, 0.0 }, { 0x1p-1074, 1.0 }, { 1000.0, INFINITY }, { -1000.0, 0.0 },
+};
+static const special specials_log[] = {
+    { 0.0, -INFINITY }, { -0.0, -INFINITY }, { INFINITY, INFINITY }, { -INFINITY, NAN }, { -1.0, NAN },
+    { -0x1p-1074, NAN }, { 1.0, 0.0 },
+};
+static const special specials_tanh[] = {
+    { 0.0, 0.0 }, { -0.0, -0.0 }, { INFINITY, 1.0 }, { -INFINITY, -1.0 }, { DBL_MAX, 1.0 },
+    { -DBL_MAX, -1.0 }, { 0x1p-1074, 0x1p-1074 }, { -0x1p-1074, -0x1p-1074 }, { 30.0, 1.0 },
+};
+static const special specials_sigmoid[] = {
+    { 0.0, 0.5 }, { -0.0, 0.5 }, { INFINITY, 1.0 }, { -INFINITY, 0.0 }, { DBL_MAX, 1.0 },
+    { -DBL_MAX, 0.0 }, { 0x1p-1074, 0.5 }, { 40.0, 1.0 },
+};
+static const special specials_erf[] = {
+    { 0.0, 0.0 }, { -0.0, -0.0 }, { INFINITY, 1.0 }, { -INFINITY, -1.0 }, { DBL_MAX, 1.0 },
+    { -DBL_MAX, -1.0 }, { 0x1p-1074, 0x1p-1074 }, { 6.0, 1.0 }, { -10.0, -1.0 },
+};
+
+static const struct { const special *s; size_t n; } specials[] = {
+    { specials_exp, sizeof(specials_exp) / sizeof(special) },
+    { specials_log, sizeof(specials_log) / sizeof(special) },
+    { specials_tanh, sizeof(specials_tanh) / sizeof(special) },
+    { specials_sigmoid, sizeof(specials_sigmoid) / sizeof(special) },
+    { specials_erf, sizeof(specials_erf) / sizeof(special) },
+};
+
+// NaN inputs, quiet and signaling, with both signs and a payload
+static const uint64_t nans64[] = { 0x7FF8000000000000ull, 0xFFF8000000000000ull, 0x7FF0000000000001ull,
+                                   0xFFF4000000001234ull };
+static const uint32_t nans32[] = { 0x7FC00000u, 0xFFC00000u, 0x7F800001u, 0xFFA01234u };
+
+// A NaN made from a non-NaN input is the positive quiet NaN
+static int same64(double got, double want) {
+    return isnan(want) ? f64_bits(got) == 0x7FF8000000000000ull : f64_bits(got) == f64_bits(want);
+}
+
+static int same32(float got, float want) {
+    return isnan(want) ? f32_bits(got) == 0x7FC00000u : f32_bits(got) == f32_bits(want);
+}
+
+// Every table entry through the f64 function and, where the input and
+// result are f32 values (or overflow f32 the same way), the f32 one; NaN
+// inputs must come back quieted. Returns the number of mismatches.
+static size_t check_specials(void) {
+    size_t bad = 0, checked = 0;
+    for (size_t k = 0; k < N_FNS64; k++) {
+        const fn64 *fn = &fns64[k];
+        const fn32 *gn = &fns32[k];
+        for (size_t i = 0; i < specials[k].n; i++) {
+            const special *s = &specials[k].s[i];
+            double y = fn->f(s->x);
+            if (!same64(y, s->want) && bad++ < SHOW)
+                printf("  %s(%a) = %a, expected %a\n", fn->name, s->x, y, s->want);
+            checked++;
+            // The f32 counterpart of the input: the f64 extremes become
+            // the f32 ones
+            float x32 = s->x == DBL_MAX ? FLT_MAX : s->x == -DBL_MAX ? -FLT_MAX
+                      : s->x == 0x1p-1074 ? 0x1p-149f : s->x == -0x1p-1074 ? -0x1p-149f : (float)s->x;
+            float want32 = s->want == 0x1p-1074 ? 0x1p-149f : s->want == -0x1p-1074 ? -0x1p-149f : (float)s->want;
+            float y32 = gn->f(x32);
+            if (!same32(y32, want32) && bad++ < SHOW)
+                printf("  %s(%a) = %a, expected %a\n", gn->name, x32, y32, want32);
+            checked++;
+        }
+        for (size_t i = 0; i < sizeof(nans64) / sizeof(nans64[0]); i++) {
+            uint64_t y = f64_bits(fn->f(bits_f64(nans64[i])));
+            uint64_t want = nans64[i] | 0x0008000000000000ull;
+            if (y != want && bad++ < SHOW)
+                printf("  %s(0x%016llX) = 0x%016llX, expected 0x%016llX\n", fn->name,
+                       (unsigned long long)nans64[i], (unsigned long long)y, (unsigned long long)want);
+            uint32_t y32 = f32_bits(gn->f(bits_f32(nans32[i])));
+            uint32_t want32 = nans32[i] | 0x400000u;
+            if (y32 != want32 && bad++ < SHOW)
+                printf("  %s(0x%08X) = 0x%08X, expected 0x%08X\n", gn->name, nans32[i], y32, want32);
+            checked += 2;
+        }
+    }
+    printf("special values: %zu checked, %zu mismatches\n", checked, bad);
+    return bad;
+}
+
+// ============================================================================
+// Accuracy, bulk against scalar, throughput
+// ============================================================================
+
+// Scalar ulp errors over random inputs, then the same inputs through the
+// bulk kernel in one call and in pieces of 1 to 67 elements (bit-identical
+// to the scalar results), then the throughput against libm. Returns the
+// number of failures.
+static size_t check_fn64(const fn64 *fn, int have_ref) {
+    const size_t n = 1u << 20;
+    double *x = malloc(n * sizeof(*x)), *y = malloc(n * sizeof(*y)), *y2 = malloc(n * sizeof(*y2));
+    if (!x || !y || !y2) { printf("  (allocation failed)\n"); exit(1); }
+    size_t bad = 0;
+    for (size_t i = 0; i < n; i++) x[i] = rand_input(fn);
+
+    double max_err = 0, at = 0;
+    for (size_t i = 0; have_ref && i < n; i++) {
+        double e = ulp_err64(fn->f(x[i]), fn->ref(x[i]));
+        if (e > max_err) { max_err = e; at = x[i]; }
+    }
+
+    fn->f_n(n, x, y);
+    for (size_t i = 0, piece = 1; i < n; i += piece, piece = piece % 67 + 1)
+        fn->f_n(n - i < piece ? n - i : piece, x + i, y2 + i);
+    size_t diff = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t want = f64_bits(fn->f(x[i]));
+        if ((f64_bits(y[i]) != want || f64_bits(y2[i]) != want) && diff++ < SHOW)
+            printf("  %s_n(%a) = 0x%016llX, in pieces 0x%016llX, scalar 0x%016llX\n", fn->name, x[i],
+                   (unsigned long long)f64_bits(y[i]), (unsigned long long)f64_bits(y2[i]),
+                   (unsigned long long)want);
+    }
+    bad += diff;
+
+    const int reps = 10;
+    double t0 = now_s();
+    for (int r = 0; r < reps; r++) fn->f_n(n, x, y);
+    double t_bulk = (now_s() - t0) / reps;
+    t0 = now_s();
+    for (size_t i = 0; i < n; i++) y2[i] = fn->libm(x[i]);
+    double t_libm = now_s() - t0;
+
+    if (have_ref) {
+        int over = max_err > fn->bound;
+        bad += over;
+        printf("%-8s max %.3f ulp at %a%s; bulk %zu mismatches; %.2f ns/elem, libm %.2f\n", fn->name, max_err, at,
+               over ? " (over the bound)" : "", diff, t_bulk / n * 1e9, t_libm / n * 1e9);
+    } else {
+        printf("%-8s bulk %zu mismatches; %.2f ns/elem, libm %.2f\n", fn->name, diff, t_bulk / n * 1e9,
+               t_libm / n * 1e9);
+    }
+    free(x); free(y); free(y2);
+    return bad;
+}
+
+#define CHUNK (1u << 16)
+
+typedef struct {
+    const fn32 *fn;
+    uint64_t lo, hi, step;          // f32 bit patterns lo, lo + step, ... below hi
+    size_t diff;
+    double max_err, at;
+    int failed, threaded;
+} sweep_job;
+
+static void *sweep_worker(void *arg) {
+    sweep_job *j = arg;
+    float *x = malloc(CHUNK * sizeof(*x)), *y = malloc(CHUNK * sizeof(*y));
+    if (!x || !y) { j->failed = 1; goto out; }
+    for (uint64_t base = j->lo; base < j->hi; base += CHUNK * j->step) {
+        size_t m = 0;
+        for (uint64_t b = base; m < CHUNK && b < j->hi; b += j->step) x[m++] = bits_f32((uint32_t)b);
+        j->fn->f_n(m, x, y);
+        for (size_t i = 0; i < m; i++) {
+            if (f32_bits(y[i]) != f32_bits(j->fn->f(x[i]))) j->diff++;
+            double e = ulp_err32(y[i], j->fn->ref(x[i]));
+            if (e > j->max_err) { j->max_err = e; j->at = x[i]; }
+        }
+    }
+out:
+    free(x); free(y);
+    return NULL;
+}
+
+// Every step-th f32 bit pattern (all of them for step 1) through the bulk
+// kernel, against the scalar function and the reference, on `threads`
+// threads; then the throughput against libm. Returns the number of
+// failures.
+static size_t check_fn32(const fn32 *fn, uint64_t step, int threads) {
+    const uint64_t total = 1ull << 32;
+    if (threads < 1) threads = 1;
+    sweep_job *jobs = calloc((size_t)threads, sizeof(*jobs));
+    pthread_t *tid = calloc((size_t)threads, sizeof(*tid));
+    if (!jobs || !tid) { printf("  (allocation failed)\n"); exit(1); }
+    double t0 = now_s();
+    uint64_t count = (total + step - 1) / step;
+    uint64_t slice = (count / (uint64_t)threads + CHUNK - 1) / CHUNK * CHUNK * step;
+    for (int t = 0; t < threads; t++) {
+        sweep_job *j = &jobs[t];
+        j->fn = fn;
+        j->step = step;
+        j->lo = (uint64_t)t * slice < total ? (uint64_t)t * slice : total;
+        j->hi = j->lo + slice < total ? j->lo + slice : total;
+        j->threaded = pthread_create(&tid[t], NULL, sweep_worker, j) == 0;
+        if (!j->threaded) sweep_worker(j);   // couldn't start: run it here
+    }
+    size_t diff = 0, failed = 0;
+    double max_err = 0, at = 0;
+    for (int t = 0; t < threads; t++) {
+        if (jobs[t].threaded) pthread_join(tid[t], NULL);
+        if (jobs[t].failed) { printf("  worker %d: allocation failed\n", t); failed++; }
+        diff += jobs[t].diff;
+        if (jobs[t].max_err > max_err) { max_err = jobs[t].max_err; at = jobs[t].at; }
+    }
+    double t_sweep = now_s() - t0;
+    free(jobs); free(tid);
+
+    const size_t n = 1u << 20;
+    float *x = malloc(n * sizeof(*x)), *y = malloc(n * sizeof(*y));
+    if (!x || !y) { printf("  (allocation failed)\n"); exit(1); }
+    for (size_t i = 0; i < n; i++) x[i] = (float)rand_input(&fns64[fn->gv - GV_VM_EXPF]);
+    const int reps = 10;
+    t0 = now_s();
+    for (int r = 0; r < reps; r++) fn->f_n(n, x, y);
+    double t_bulk = (now_s() - t0) / reps;
+    t0 = now_s();
+    for (size_t i = 0; i < n; i++) y[i] = fn->libm(x[i]);
+    double t_libm = now_s() - t0;
+    free(x); free(y);
+
+    int over = max_err > fn->bound;
+    printf("%-8s max %.4f ulp at %a%s; bulk %zu mismatches (%llu inputs, %.1f s); %.2f ns/elem, libm %.2f\n",
+           fn->name, max_err, at, over ? " (over the bound)" : "", diff, (unsigned long long)count, t_sweep,
+           t_bulk / n * 1e9, t_libm / n * 1e9);
+    return diff + failed + (size_t)over;
+}
+
+// ============================================================================
+// Vectors
+// ============================================================================
+
+#define GOLDEN_RANDOM 2000          // random inputs per function
+
+// Each function's golden inputs: its special values (f64, or their f32
+// counterparts), the NaNs, then random inputs from a fixed seed
+static size_t golden_inputs64(size_t k, double *out) {
+    size_t n = 0;
+    for (size_t i = 0; i < specials[k].n; i++) out[n++] = specials[k].s[i].x;
+    for (size_t i = 0; i < sizeof(nans64) / sizeof(nans64[0]); i++) out[n++] = bits_f64(nans64[i]);
+    for (size_t i = 0; i < GOLDEN_RANDOM; i++) out[n++] = rand_input(&fns64[k]);
+    return n;
+}
+
+static size_t golden_inputs32(size_t k, float *out) {
+    size_t n = 0;
+    for (size_t i = 0; i < specials[k].n; i++) out[n++] = (float)specials[k].s[i].x;
+    for (size_t i = 0; i < sizeof(nans32) / sizeof(nans32[0]); i++) out[n++] = bits_f32(nans32[i]);
+    for (size_t i = 0; i < GOLDEN_RANDOM; i++) out[n++] = (float)rand_input(&fns64[k]);
+    return n;
+}
+
+// Binary vectors (golden_vectors.h): every function on its golden inputs.
+// Returns the record count, or -1 on a write error.
+static long long write_golden(const char *path) {
+    gv_writer *w = gv_create(path, "vmath_spotcheck");
+    if (!w) { perror(path); return -1; }
+    double in[GOLDEN_RANDOM + 64];
+    float in32[GOLDEN_RANDOM + 64];
+    uint64_t v[2];
+    rng = 0x9E3779B97F4A7C15ull;
+    for (size_t k = 0; k < N_FNS64; k++) {
+        size_t n = golden_inputs64(k, in);
+        gv_begin(w, fns64[k].gv, 1, 8, 1, 8);
+        for (size_t i = 0; i < n; i++) {
+            v[0] = f64_bits(in[i]); v[1] = f64_bits(fns64[k].f(in[i]));
+            gv_put(w, v);
+        }
+    }
+    for (size_t k = 0; k < N_FNS32; k++) {
+        size_t n = golden_inputs32(k, in32);
+        gv_begin(w, fns32[k].gv, 1, 4, 1, 4);
+        for (size_t i = 0; i < n; i++) {
+            v[0] = f32_bits(in32[i]); v[1] = f32_bits(fns32[k].f(in32[i]));
+            gv_put(w, v);
+        }
+    }
+    return gv_close(w);
+}
+
+// Recompute every vmath record of a golden file through the scalar and
+// the bulk functions. Returns the number of differing records, or -1 if
+// the file cannot be read.
+static long long compare_golden(const char *path) {
+    gv_file f;
+    if (gv_open(&f, path) != 0) { perror(path); return -1; }
+    gv_chunk c;
+    long long bad = 0, checked = 0;
+    int r;
+    while ((r = gv_next(&f, &c)) == 1) {
+        if (c.op < GV_VM_EXP || c.op > GV_VM_ERFF || c.n_in != 1 || c.n_out != 1) continue;
+        int is64 = c.op < GV_VM_EXPF;
+        if (c.in_bytes != (is64 ? 8u : 4u) || c.out_bytes != c.in_bytes) { r = -1; break; }
+        for (uint64_t i = 0; i < c.count; i++) {
+            uint64_t x = gv_value(&c, i, 0), want = gv_value(&c, i, 1), got, got_n;
+            if (is64) {
+                const fn64 *fn = &fns64[c.op - GV_VM_EXP];
+                double xi = bits_f64(x), yi;
+                fn->f_n(1, &xi, &yi);
+                got = f64_bits(fn->f(xi)); got_n = f64_bits(yi);
+            } else {
+                const fn32 *fn = &fns32[c.op - GV_VM_EXPF];
+                float xi = bits_f32((uint32_t)x), yi;
+                fn->f_n(1, &xi, &yi);
+                got = f32_bits(fn->f(xi)); got_n = f32_bits(yi);
+            }
+            if ((got != want || got_n != want) && bad++ < SHOW)
+                printf("  %s(0x%llX) = 0x%llX, bulk 0x%llX, file 0x%llX\n", gv_op_name(c.op), (unsigned long long)x,
+                       (unsigned long long)got, (unsigned long long)got_n, (unsigned long long)want);
+            checked++;
+        }
+    }
+    gv_unmap(&f);
+    if (r < 0) { printf("%s: malformed file\n", path); return -1; }
+    printf("%s (written by %s): %lld records, %lld differ\n", path, f.tool, checked, bad);
+    return bad;
+}
+
+int main(int argc, char **argv) {
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    int exhaustive = 0, threads = ncpu > 0 ? (int)ncpu : 1;
+    const char *golden = NULL, *compare = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--exhaustive") == 0) exhaustive = 1;
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--golden") == 0 && i + 1 < argc) golden = argv[++i];
+        else if (strcmp(argv[i], "--compare") == 0 && i + 1 < argc) compare = argv[++i];
+        else {
+            fprintf(stderr, "usage: %s [--exhaustive] [--threads N] [--golden FILE] [--compare FILE]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    size_t bad = 0;
+    printf("=== Special Values ===\n");
+    bad += check_specials();
+
+    // The f64 errors need a long double with more precision than double
+    int have_ref = LDBL_MANT_DIG > DBL_MANT_DIG;
+    printf("\n=== f64 vs long double libm, bulk vs scalar (%s) ===\n", vm_math_isa());
+    if (!have_ref) printf("(long double is double here: no ulp errors)\n");
+    for (size_t k = 0; k < N_FNS64; k++) bad += check_fn64(&fns64[k], have_ref);
+
+    uint64_t step = exhaustive ? 1 : 101;
+    printf("\n=== f32 vs double libm, bulk vs scalar (%s) ===\n", vm_math_isa());
+    for (size_t k = 0; k < N_FNS32; k++) bad += check_fn32(&fns32[k], step, threads);
+
+    if (golden) {
+        printf("\n=== Golden Vectors ===\n");
+        long long n = write_golden(golden);
+        if (n < 0 || gv_list(golden) != n) { printf("%s: write failed\n", golden); return 1; }
+    }
+    if (compare) {
+        printf("\n=== Compare ===\n");
+        long long d = compare_golden(compare);
+        if (d != 0) bad++;
+    }
+    return bad ? 1 : 0;
+}